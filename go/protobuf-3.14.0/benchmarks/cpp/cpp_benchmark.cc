@@ -0,0 +1,631 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for the C++ runtime, run over the BenchmarkDataset files given on
+// the command line:
+//
+//   ./cpp-benchmark datasets/google_message1/proto3/dataset.google_message1_proto3.pb
+//
+// Every dataset gets parse, serialize, ByteSize, JSON, text format and
+// reflection benchmarks.  Throughput is reported as bytes_per_second of the
+// binary payloads and every benchmark reports heap allocations per iteration
+// as "allocs/op".  Map benchmarks do not depend on a dataset and always run.
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "benchmarks.pb.h"
+#include "datasets/google_message1/proto2/benchmark_message1_proto2.pb.h"
+#include "datasets/google_message1/proto3/benchmark_message1_proto3.pb.h"
+#include "datasets/google_message2/benchmark_message2.pb.h"
+#include "datasets/google_message3/benchmark_message3.pb.h"
+#include "datasets/google_message4/benchmark_message4.pb.h"
+#include <google/protobuf/arena.h>
+#include <google/protobuf/map.h>
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/util/json_util.h>
+
+using benchmarks::BenchmarkDataset;
+using google::protobuf::Arena;
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::MessageFactory;
+using google::protobuf::Reflection;
+using google::protobuf::TextFormat;
+
+// Counts every global operator new so benchmarks can report allocs/op.
+// Arena blocks are counted too, so arena benchmarks show how many blocks
+// a parse needed rather than zero.
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Records the allocation count at construction and reports the number of
+// allocations per iteration when Report() is called.
+class AllocationCounter {
+ public:
+  AllocationCounter() : start_(allocation_count.load()) {}
+
+  void Report(benchmark::State& state) {
+    state.counters["allocs/op"] =
+        benchmark::Counter(static_cast<double>(allocation_count.load() - start_),
+                           benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  size_t start_;
+};
+
+class WrappingCounter {
+ public:
+  WrappingCounter(size_t limit) : value_(0), limit_(limit) {}
+
+  size_t Next() {
+    size_t ret = value_;
+    if (++value_ == limit_) {
+      value_ = 0;
+    }
+    return ret;
+  }
+
+ private:
+  size_t value_;
+  size_t limit_;
+};
+
+class Fixture : public benchmark::Fixture {
+ public:
+  Fixture(const BenchmarkDataset& dataset, const std::string& suffix) {
+    for (int i = 0; i < dataset.payload_size(); i++) {
+      payloads_.push_back(dataset.payload(i));
+    }
+
+    const Descriptor* d =
+        DescriptorPool::generated_pool()->FindMessageTypeByName(
+            dataset.message_name());
+
+    if (!d) {
+      std::cerr << "Couldn't find message named '" << dataset.message_name()
+                << "\n";
+    }
+
+    prototype_ = MessageFactory::generated_factory()->GetPrototype(d);
+    SetName((dataset.name() + suffix).c_str());
+  }
+
+ protected:
+  // Parses every payload into its own heap-allocated message.
+  std::vector<std::unique_ptr<Message>> ParsePayloads() const {
+    std::vector<std::unique_ptr<Message>> messages;
+    for (const std::string& payload : payloads_) {
+      messages.emplace_back(prototype_->New());
+      messages.back()->ParseFromString(payload);
+    }
+    return messages;
+  }
+
+  std::vector<std::string> payloads_;
+  const Message* prototype_;
+};
+
+template <class T>
+class ParseNewFixture : public Fixture {
+ public:
+  ParseNewFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_parse_new") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    WrappingCounter i(payloads_.size());
+    size_t total = 0;
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      T m;
+      const std::string& payload = payloads_[i.Next()];
+      total += payload.size();
+      m.ParseFromString(payload);
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class ParseNewArenaFixture : public Fixture {
+ public:
+  ParseNewArenaFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_parse_newarena") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    WrappingCounter i(payloads_.size());
+    size_t total = 0;
+    Arena arena;
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      arena.Reset();
+      Message* m = Arena::CreateMessage<T>(&arena);
+      const std::string& payload = payloads_[i.Next()];
+      total += payload.size();
+      m->ParseFromString(payload);
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class ParseReuseFixture : public Fixture {
+ public:
+  ParseReuseFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_parse_reuse") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    T m;
+    WrappingCounter i(payloads_.size());
+    size_t total = 0;
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      const std::string& payload = payloads_[i.Next()];
+      total += payload.size();
+      m.ParseFromString(payload);
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class SerializeFixture : public Fixture {
+ public:
+  SerializeFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_serialize") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::unique_ptr<Message>> messages = ParsePayloads();
+    size_t total = 0;
+    std::string str;
+    WrappingCounter i(messages.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      str.clear();
+      messages[i.Next()]->SerializeToString(&str);
+      total += str.size();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class ByteSizeFixture : public Fixture {
+ public:
+  ByteSizeFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_bytesize") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::unique_ptr<Message>> messages = ParsePayloads();
+    size_t total = 0;
+    WrappingCounter i(messages.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      size_t size = messages[i.Next()]->ByteSizeLong();
+      benchmark::DoNotOptimize(size);
+      total += size;
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+// JSON and text format benchmarks count the binary payload size, so their
+// bytes_per_second is directly comparable with the binary ones.
+template <class T>
+class ToJsonFixture : public Fixture {
+ public:
+  ToJsonFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_to_json") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::unique_ptr<Message>> messages = ParsePayloads();
+    size_t total = 0;
+    std::string json;
+    WrappingCounter i(messages.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      const Message& m = *messages[i.Next()];
+      json.clear();
+      if (!google::protobuf::util::MessageToJsonString(m, &json).ok()) {
+        state.SkipWithError("MessageToJsonString failed");
+        break;
+      }
+      total += m.ByteSizeLong();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class FromJsonFixture : public Fixture {
+ public:
+  FromJsonFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_from_json") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::string> json(payloads_.size());
+    for (size_t j = 0; j < payloads_.size(); j++) {
+      T m;
+      m.ParseFromString(payloads_[j]);
+      if (!google::protobuf::util::MessageToJsonString(m, &json[j]).ok()) {
+        state.SkipWithError("MessageToJsonString failed");
+        return;
+      }
+    }
+    size_t total = 0;
+    WrappingCounter i(json.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      size_t index = i.Next();
+      T m;
+      if (!google::protobuf::util::JsonStringToMessage(json[index], &m).ok()) {
+        state.SkipWithError("JsonStringToMessage failed");
+        break;
+      }
+      total += payloads_[index].size();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class ToTextFixture : public Fixture {
+ public:
+  ToTextFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_to_text") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::unique_ptr<Message>> messages = ParsePayloads();
+    size_t total = 0;
+    std::string text;
+    WrappingCounter i(messages.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      const Message& m = *messages[i.Next()];
+      text.clear();
+      TextFormat::PrintToString(m, &text);
+      total += m.ByteSizeLong();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+template <class T>
+class FromTextFixture : public Fixture {
+ public:
+  FromTextFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_from_text") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::string> text(payloads_.size());
+    for (size_t j = 0; j < payloads_.size(); j++) {
+      T m;
+      m.ParseFromString(payloads_[j]);
+      TextFormat::PrintToString(m, &text[j]);
+    }
+    size_t total = 0;
+    WrappingCounter i(text.size());
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      size_t index = i.Next();
+      T m;
+      if (!TextFormat::ParseFromString(text[index], &m)) {
+        state.SkipWithError("TextFormat::ParseFromString failed");
+        break;
+      }
+      total += payloads_[index].size();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+};
+
+// Reads every set field through Reflection, recursing into sub-messages, the
+// way generic code such as a converter or a logger walks a message.
+template <class T>
+class ReflectionFixture : public Fixture {
+ public:
+  ReflectionFixture(const BenchmarkDataset& dataset)
+      : Fixture(dataset, "_reflection") {}
+
+  virtual void BenchmarkCase(benchmark::State& state) {
+    std::vector<std::unique_ptr<Message>> messages = ParsePayloads();
+    size_t total = 0;
+    WrappingCounter i(messages.size());
+    std::vector<const FieldDescriptor*> fields;
+    AllocationCounter allocs;
+
+    while (state.KeepRunning()) {
+      size_t index = i.Next();
+      benchmark::DoNotOptimize(Visit(*messages[index], &fields));
+      total += payloads_[index].size();
+    }
+
+    state.SetBytesProcessed(total);
+    allocs.Report(state);
+  }
+
+ private:
+  static uint64_t Visit(const Message& message,
+                        std::vector<const FieldDescriptor*>* fields) {
+    const Reflection* reflection = message.GetReflection();
+    fields->clear();
+    reflection->ListFields(message, fields);
+    // Recursion reuses the vector, so work on a copy of this level's fields.
+    std::vector<const FieldDescriptor*> level(*fields);
+    uint64_t sum = 0;
+    for (const FieldDescriptor* field : level) {
+      int count = field->is_repeated() ? reflection->FieldSize(message, field)
+                                       : 1;
+      for (int j = 0; j < count; j++) {
+        sum += VisitValue(message, reflection, field,
+                          field->is_repeated() ? j : -1, fields);
+      }
+    }
+    return sum;
+  }
+
+  static uint64_t VisitValue(const Message& message,
+                             const Reflection* reflection,
+                             const FieldDescriptor* field, int index,
+                             std::vector<const FieldDescriptor*>* fields) {
+#define VALUE(NAME)                                              \
+  (index < 0 ? reflection->Get##NAME(message, field)             \
+             : reflection->GetRepeated##NAME(message, field, index))
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        return VALUE(Int32);
+      case FieldDescriptor::CPPTYPE_INT64:
+        return VALUE(Int64);
+      case FieldDescriptor::CPPTYPE_UINT32:
+        return VALUE(UInt32);
+      case FieldDescriptor::CPPTYPE_UINT64:
+        return VALUE(UInt64);
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        return static_cast<uint64_t>(VALUE(Float));
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        return static_cast<uint64_t>(VALUE(Double));
+      case FieldDescriptor::CPPTYPE_BOOL:
+        return VALUE(Bool);
+      case FieldDescriptor::CPPTYPE_ENUM:
+        return VALUE(EnumValue);
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        return (index < 0 ? reflection->GetStringReference(message, field,
+                                                           &scratch)
+                          : reflection->GetRepeatedStringReference(
+                                message, field, index, &scratch))
+            .size();
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return Visit(VALUE(Message), fields);
+    }
+#undef VALUE
+    return 0;
+  }
+};
+
+template <class T>
+void RegisterBenchmarksForType(const BenchmarkDataset& dataset) {
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ParseNewFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ParseReuseFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ParseNewArenaFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new SerializeFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ByteSizeFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ToJsonFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new FromJsonFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ToTextFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new FromTextFixture<T>(dataset));
+  ::benchmark::internal::RegisterBenchmarkInternal(
+      new ReflectionFixture<T>(dataset));
+}
+
+void RegisterBenchmarks(const std::string& dataset_bytes) {
+  BenchmarkDataset dataset;
+  GOOGLE_CHECK(dataset.ParseFromString(dataset_bytes));
+
+  if (dataset.message_name() == "benchmarks.proto3.GoogleMessage1") {
+    RegisterBenchmarksForType<benchmarks::proto3::GoogleMessage1>(dataset);
+  } else if (dataset.message_name() == "benchmarks.proto2.GoogleMessage1") {
+    RegisterBenchmarksForType<benchmarks::proto2::GoogleMessage1>(dataset);
+  } else if (dataset.message_name() == "benchmarks.proto2.GoogleMessage2") {
+    RegisterBenchmarksForType<benchmarks::proto2::GoogleMessage2>(dataset);
+  } else if (dataset.message_name() ==
+      "benchmarks.google_message3.GoogleMessage3") {
+    RegisterBenchmarksForType
+    <benchmarks::google_message3::GoogleMessage3>(dataset);
+  } else if (dataset.message_name() ==
+      "benchmarks.google_message4.GoogleMessage4") {
+    RegisterBenchmarksForType
+    <benchmarks::google_message4::GoogleMessage4>(dataset);
+  } else {
+    std::cerr << "Unknown message type: " << dataset.message_name();
+    exit(1);
+  }
+}
+
+// Map benchmarks, parameterized by the number of entries.
+
+static void BM_MapInsert(benchmark::State& state) {
+  const int size = state.range(0);
+  AllocationCounter allocs;
+  while (state.KeepRunning()) {
+    google::protobuf::Map<int32_t, int32_t> map;
+    for (int i = 0; i < size; i++) {
+      map[i * 7919] = i;
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  allocs.Report(state);
+}
+BENCHMARK(BM_MapInsert)->Range(8, 8 << 10);
+
+static void BM_MapInsertArena(benchmark::State& state) {
+  const int size = state.range(0);
+  Arena arena;
+  AllocationCounter allocs;
+  while (state.KeepRunning()) {
+    arena.Reset();
+    google::protobuf::Map<int32_t, int32_t> map(&arena);
+    for (int i = 0; i < size; i++) {
+      map[i * 7919] = i;
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  allocs.Report(state);
+}
+BENCHMARK(BM_MapInsertArena)->Range(8, 8 << 10);
+
+static void BM_MapStringInsert(benchmark::State& state) {
+  const int size = state.range(0);
+  std::vector<std::string> keys;
+  for (int i = 0; i < size; i++) {
+    keys.push_back("key_" + std::to_string(i * 7919));
+  }
+  AllocationCounter allocs;
+  while (state.KeepRunning()) {
+    google::protobuf::Map<std::string, int32_t> map;
+    for (int i = 0; i < size; i++) {
+      map[keys[i]] = i;
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  allocs.Report(state);
+}
+BENCHMARK(BM_MapStringInsert)->Range(8, 8 << 10);
+
+static void BM_MapLookup(benchmark::State& state) {
+  const int size = state.range(0);
+  google::protobuf::Map<int32_t, int32_t> map;
+  for (int i = 0; i < size; i++) {
+    map[i * 7919] = i;
+  }
+  WrappingCounter i(size);
+  AllocationCounter allocs;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(map.find(static_cast<int32_t>(i.Next()) * 7919));
+  }
+  state.SetItemsProcessed(state.iterations());
+  allocs.Report(state);
+}
+BENCHMARK(BM_MapLookup)->Range(8, 8 << 10);
+
+static void BM_MapStringLookup(benchmark::State& state) {
+  const int size = state.range(0);
+  std::vector<std::string> keys;
+  google::protobuf::Map<std::string, int32_t> map;
+  for (int i = 0; i < size; i++) {
+    keys.push_back("key_" + std::to_string(i * 7919));
+    map[keys.back()] = i;
+  }
+  WrappingCounter i(size);
+  AllocationCounter allocs;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(map.find(keys[i.Next()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+  allocs.Report(state);
+}
+BENCHMARK(BM_MapStringLookup)->Range(8, 8 << 10);
+
+std::string ReadFile(const std::string& name) {
+  std::ifstream file(name.c_str());
+  GOOGLE_CHECK(file.is_open()) << "Couldn't find file '" << name <<
+                                  "', please make sure you are running "
+                                  "this command from the benchmarks/ "
+                                  "directory.\n";
+  return std::string((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char *argv[]) {
+  ::benchmark::Initialize(&argc, argv);
+  for (int i = 1; i < argc; i++) {
+    RegisterBenchmarks(ReadFile(argv[i]));
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -30,8 +30,113 @@
 
 #include <Zend/zend_API.h>
 
+#include "arena.h"
 #include "php-upb.h"
 
+// -----------------------------------------------------------------------------
+// Block pool
+// -----------------------------------------------------------------------------
+
+// Every top-level message gets its own upb_arena, and messages are typically
+// short-lived, so a request that handles many messages would otherwise call
+// malloc() and free() for every arena block. Instead arenas get their blocks
+// from a per-thread pool, sorted into power-of-two size classes, and return
+// them there when they are freed. The pool is emptied at the end of each
+// request, and holds at most ARENA_POOL_MAX_BYTES in the meantime.
+//
+// All arenas that can be fused together are created here, so a fused group
+// always returns its blocks to the pool it took them from.
+
+#define ARENA_POOL_MIN_LG2 9   // 512 bytes
+#define ARENA_POOL_MAX_LG2 16  // 64 KiB
+#define ARENA_POOL_CLASSES (ARENA_POOL_MAX_LG2 - ARENA_POOL_MIN_LG2 + 1)
+#define ARENA_POOL_MAX_BYTES (4 << 20)
+
+// Precedes the memory handed to upb. Padded so that memory stays aligned.
+typedef union PoolBlock {
+  struct {
+    union PoolBlock *next;  // While in the pool.
+    int size_class;         // -1 if the block is too large to pool.
+  } hdr;
+  char align[16];
+} PoolBlock;
+
+typedef struct {
+  PoolBlock *free[ARENA_POOL_CLASSES];
+  size_t bytes;
+} ArenaPool;
+
+ZEND_TLS ArenaPool arena_pool;
+
+static size_t ArenaPool_ClassSize(int size_class) {
+  return (size_t)1 << (size_class + ARENA_POOL_MIN_LG2);
+}
+
+static void *ArenaPool_Malloc(size_t size) {
+  PoolBlock *block;
+  int size_class = 0;
+
+  size += sizeof(PoolBlock);
+
+  if (size > ArenaPool_ClassSize(ARENA_POOL_CLASSES - 1)) {
+    block = malloc(size);
+    if (!block) return NULL;
+    block->hdr.size_class = -1;
+    return block + 1;
+  }
+
+  while (ArenaPool_ClassSize(size_class) < size) size_class++;
+
+  block = arena_pool.free[size_class];
+  if (block) {
+    arena_pool.free[size_class] = block->hdr.next;
+    arena_pool.bytes -= ArenaPool_ClassSize(size_class);
+  } else {
+    block = malloc(ArenaPool_ClassSize(size_class));
+    if (!block) return NULL;
+  }
+
+  block->hdr.size_class = size_class;
+  return block + 1;
+}
+
+static void ArenaPool_Free(void *ptr) {
+  PoolBlock *block = (PoolBlock*)ptr - 1;
+  int size_class = block->hdr.size_class;
+
+  if (size_class < 0 || arena_pool.bytes + ArenaPool_ClassSize(size_class) >
+                            ARENA_POOL_MAX_BYTES) {
+    free(block);
+    return;
+  }
+
+  block->hdr.next = arena_pool.free[size_class];
+  arena_pool.free[size_class] = block;
+  arena_pool.bytes += ArenaPool_ClassSize(size_class);
+}
+
+static void *ArenaPool_AllocFunc(upb_alloc *alloc, void *ptr, size_t oldsize,
+                                 size_t size) {
+  void *ret;
+
+  if (size == 0) {
+    if (ptr) ArenaPool_Free(ptr);
+    return NULL;
+  }
+
+  ret = ArenaPool_Malloc(size);
+
+  // upb arenas never resize their blocks, but handle it for completeness.
+  if (ret && ptr) {
+    memcpy(ret, ptr, oldsize < size ? oldsize : size);
+    ArenaPool_Free(ptr);
+  }
+
+  return ret;
+}
+
+static upb_alloc arena_pool_alloc = {&ArenaPool_AllocFunc};
+
 // -----------------------------------------------------------------------------
 // Arena
 // -----------------------------------------------------------------------------
@@ -50,7 +155,7 @@ static zend_object* Arena_Create(zend_class_entry *class_type) {
   Arena *intern = emalloc(sizeof(Arena));
   zend_object_std_init(&intern->std, class_type);
   intern->std.handlers = &Arena_object_handlers;
-  intern->arena = upb_arena_new();
+  intern->arena = upb_arena_init(NULL, 0, &arena_pool_alloc);
   // Skip object_properties_init(), we don't allow derived classes.
   return &intern->std;
 }
@@ -72,6 +177,22 @@ upb_arena *Arena_Get(zval *val) {
   return a->arena;
 }
 
+void Arena_ReleasePool() {
+  int i;
+
+  for (i = 0; i < ARENA_POOL_CLASSES; i++) {
+    PoolBlock *block = arena_pool.free[i];
+    while (block) {
+      PoolBlock *next = block->hdr.next;
+      free(block);
+      block = next;
+    }
+    arena_pool.free[i] = NULL;
+  }
+
+  arena_pool.bytes = 0;
+}
+
 // -----------------------------------------------------------------------------
 // Module init.
 // -----------------------------------------------------------------------------
@@ -44,4 +44,8 @@ void Arena_Init(zval *val);
 // Gets the underlying upb_arena from this arena object.
 upb_arena *Arena_Get(zval *arena);
 
+// Frees the blocks that arenas have returned to this thread's pool for reuse.
+// Called at the end of each request.
+void Arena_ReleasePool();
+
 #endif  // PHP_PROTOBUF_ARENA_H_
@@ -125,6 +125,40 @@ static zval *RepeatedField_GetPropertyPtrPtr(PROTO_VAL *object,
   return NULL;  // We don't offer direct references to our properties.
 }
 
+/**
+ * RepeatedField_ConvertPhpArray()
+ *
+ * Creates a new upb_array in |arena| holding the values of the PHP array
+ * |table|, in iteration order. Returns NULL if a value has the wrong type, in
+ * which case a PHP exception has been raised.
+ */
+static upb_array *RepeatedField_ConvertPhpArray(HashTable *table,
+                                                upb_fieldtype_t type,
+                                                const Descriptor *desc,
+                                                upb_arena *arena) {
+  upb_array *arr = upb_array_new(arena, type);
+  HashPosition pos;
+  size_t i = 0;
+
+  // Size the array once up front rather than growing it on every append.
+  upb_array_resize(arr, zend_hash_num_elements(table), arena);
+  zend_hash_internal_pointer_reset_ex(table, &pos);
+
+  while (true) {
+    zval *zv = zend_hash_get_current_data_ex(table, &pos);
+    upb_msgval val;
+
+    if (!zv) return arr;
+
+    if (!Convert_PhpToUpbAutoWrap(zv, &val, type, desc, arena)) {
+      return NULL;
+    }
+
+    upb_array_set(arr, i++, val);
+    zend_hash_move_forward_ex(table, &pos);
+  }
+}
+
 // C Functions from array.h ////////////////////////////////////////////////////
 
 // These are documented in the header file.
@@ -158,27 +192,8 @@ upb_array *RepeatedField_GetUpbArray(zval *val, const upb_fielddef *f,
 
   if (Z_TYPE_P(val) == IS_ARRAY) {
     // Auto-construct, eg. [1, 2, 3] -> upb_array([1, 2, 3]).
-    upb_array *arr = upb_array_new(arena, upb_fielddef_type(f));
-    HashTable *table = HASH_OF(val);
-    HashPosition pos;
-    upb_fieldtype_t type = upb_fielddef_type(f);
-    const Descriptor *desc = Descriptor_GetFromFieldDef(f);
-
-    zend_hash_internal_pointer_reset_ex(table, &pos);
-
-    while (true) {
-      zval *zv = zend_hash_get_current_data_ex(table, &pos);
-      upb_msgval val;
-
-      if (!zv) return arr;
-
-      if (!Convert_PhpToUpbAutoWrap(zv, &val, type, desc, arena)) {
-        return NULL;
-      }
-
-      upb_array_append(arr, val, arena);
-      zend_hash_move_forward_ex(table, &pos);
-    }
+    return RepeatedField_ConvertPhpArray(HASH_OF(val), upb_fielddef_type(f),
+                                         Descriptor_GetFromFieldDef(f), arena);
   } else if (Z_TYPE_P(val) == IS_OBJECT &&
              Z_OBJCE_P(val) == RepeatedField_class_entry) {
     // Unwrap existing RepeatedField object to get the upb_array* inside.
@@ -435,11 +450,78 @@ PHP_METHOD(RepeatedField, getIterator) {
   RETURN_ZVAL(&ret, 0, 1);
 }
 
+/**
+ * RepeatedField::toArray()
+ *
+ * Converts all of the elements to a PHP array in one call, which is much
+ * cheaper than iterating over the RepeatedField from PHP.
+ *
+ * @return array The stored elements, in order.
+ */
+PHP_METHOD(RepeatedField, toArray) {
+  RepeatedField *intern = (RepeatedField*)Z_OBJ_P(getThis());
+  size_t size = upb_array_size(intern->array);
+  size_t i;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+
+  array_init_size(return_value, size);
+  zend_hash_real_init(Z_ARRVAL_P(return_value), 1);
+  ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(return_value)) {
+    for (i = 0; i < size; i++) {
+      zval val;
+      Convert_UpbToPhp(upb_array_get(intern->array, i), &val, intern->type,
+                       intern->desc, &intern->arena);
+      ZEND_HASH_FILL_ADD(&val);
+    }
+  } ZEND_HASH_FILL_END();
+}
+
+/**
+ * RepeatedField::fromArray()
+ *
+ * Replaces all of the elements with the values of a PHP array in one call. If
+ * any value has the wrong type, the RepeatedField is left unchanged.
+ *
+ * @param array The new elements.
+ * @exception Incorrect type of an element.
+ */
+PHP_METHOD(RepeatedField, fromArray) {
+  RepeatedField *intern = (RepeatedField*)Z_OBJ_P(getThis());
+  upb_arena *arena = Arena_Get(&intern->arena);
+  HashTable *table;
+  upb_array *values;
+  size_t size;
+  size_t i;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "h", &table) == FAILURE) {
+    return;
+  }
+
+  values = RepeatedField_ConvertPhpArray(table, intern->type, intern->desc,
+                                         arena);
+  if (!values) {
+    return;
+  }
+
+  size = upb_array_size(values);
+  upb_array_resize(intern->array, size, arena);
+  for (i = 0; i < size; i++) {
+    upb_array_set(intern->array, i, upb_array_get(values, i));
+  }
+}
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_construct, 0, 0, 1)
   ZEND_ARG_INFO(0, type)
   ZEND_ARG_INFO(0, class)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_fromArray, 0, 0, 1)
+  ZEND_ARG_ARRAY_INFO(0, values, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_append, 0, 0, 1)
   ZEND_ARG_INFO(0, newval)
 ZEND_END_ARG_INFO()
@@ -465,6 +547,8 @@ static zend_function_entry repeated_field_methods[] = {
   PHP_ME(RepeatedField, offsetUnset,  arginfo_offsetGet, ZEND_ACC_PUBLIC)
   PHP_ME(RepeatedField, count,        arginfo_void,      ZEND_ACC_PUBLIC)
   PHP_ME(RepeatedField, getIterator,  arginfo_void,      ZEND_ACC_PUBLIC)
+  PHP_ME(RepeatedField, toArray,      arginfo_void,      ZEND_ACC_PUBLIC)
+  PHP_ME(RepeatedField, fromArray,    arginfo_fromArray, ZEND_ACC_PUBLIC)
   ZEND_FE_END
 };
 
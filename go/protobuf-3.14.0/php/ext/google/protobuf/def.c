@@ -995,9 +995,19 @@ PHP_METHOD(DescriptorPool, internalAddGeneratedFile) {
     return;
   }
 
+  if (intern->symtab == DescriptorPool_GetSymbolTable() &&
+      GeneratedFiles_Contains(data, data_len)) {
+    // Loaded by an earlier request.
+    return;
+  }
+
   arena = upb_arena_new();
   add_descriptor_set(intern, data, data_len, arena);
   upb_arena_free(arena);
+
+  if (intern->symtab == DescriptorPool_GetSymbolTable()) {
+    GeneratedFiles_Add(data, data_len);
+  }
 }
 
 static zend_function_entry DescriptorPool_methods[] = {
@@ -658,6 +658,79 @@ PHP_METHOD(Message, mergeFromString) {
   }
 }
 
+/**
+ * Message::parseFromStrings()
+ *
+ * Parses each of the given strings into a new message of the called class:
+ *
+ *   $msgs = Foo::parseFromStrings($datas);
+ *
+ * All of the messages share one arena instead of each getting its own, which
+ * makes parsing a batch of small messages much cheaper. The arena is freed once
+ * none of the messages, or anything taken from them, is referenced.
+ * @param array Serialized protobuf data, one string per message.
+ * @return array The parsed messages, under the same keys.
+ */
+PHP_METHOD(Message, parseFromStrings) {
+  zend_class_entry *ce = zend_get_called_scope(execute_data);
+  const Descriptor *desc;
+  HashTable *table;
+  zend_string *key;
+  zend_ulong index;
+  zval *data;
+  zval arena;
+  upb_arena *a;
+
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "h", &table) == FAILURE) {
+    return;
+  }
+
+  desc = ce && ce != message_ce ? Descriptor_GetFromClassEntry(ce) : NULL;
+  if (!desc) {
+    zend_throw_exception_ex(NULL, 0,
+                            "parseFromStrings() must be called on a generated "
+                            "message class");
+    return;
+  }
+
+  Arena_Init(&arena);
+  a = Arena_Get(&arena);
+  array_init_size(return_value, zend_hash_num_elements(table));
+
+  ZEND_HASH_FOREACH_KEY_VAL(table, index, key, data) {
+    const upb_msglayout *l = upb_msgdef_layout(desc->msgdef);
+    upb_msg *msg;
+    char *data_copy;
+    zval php_msg;
+
+    ZVAL_DEREF(data);
+    if (Z_TYPE_P(data) != IS_STRING) {
+      zend_throw_exception_ex(NULL, 0, "Expected an array of strings");
+      break;
+    }
+
+    // TODO(haberman): avoid this copy when we can make the decoder copy.
+    data_copy = upb_arena_malloc(a, Z_STRLEN_P(data));
+    memcpy(data_copy, Z_STRVAL_P(data), Z_STRLEN_P(data));
+
+    msg = upb_msg_new(desc->msgdef, a);
+    if (!upb_decode(data_copy, Z_STRLEN_P(data), msg, l, a)) {
+      zend_throw_exception_ex(NULL, 0, "Error occurred during parsing");
+      break;
+    }
+
+    Message_GetPhpWrapper(&php_msg, desc, msg, &arena);
+    if (key) {
+      zend_hash_update(Z_ARRVAL_P(return_value), key, &php_msg);
+    } else {
+      zend_hash_index_update(Z_ARRVAL_P(return_value), index, &php_msg);
+    }
+  } ZEND_HASH_FOREACH_END();
+
+  // Each message holds its own reference.
+  zval_ptr_dtor(&arena);
+}
+
 /**
  * Message::serializeToString()
  *
@@ -1028,6 +1101,10 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_mergeFrom, 0, 0, 1)
   ZEND_ARG_INFO(0, data)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_parseFromStrings, 0, 0, 1)
+  ZEND_ARG_ARRAY_INFO(0, data, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_read, 0, 0, 1)
   ZEND_ARG_INFO(0, field)
 ZEND_END_ARG_INFO()
@@ -1042,6 +1119,8 @@ static zend_function_entry Message_methods[] = {
   PHP_ME(Message, discardUnknownFields,  arginfo_void,      ZEND_ACC_PUBLIC)
   PHP_ME(Message, serializeToString,     arginfo_void,      ZEND_ACC_PUBLIC)
   PHP_ME(Message, mergeFromString,       arginfo_mergeFrom, ZEND_ACC_PUBLIC)
+  PHP_ME(Message, parseFromStrings,      arginfo_parseFromStrings,
+         ZEND_ACC_PUBLIC|ZEND_ACC_STATIC)
   PHP_ME(Message, serializeToJsonString, arginfo_void,      ZEND_ACC_PUBLIC)
   PHP_ME(Message, mergeFromJsonString,   arginfo_mergeFrom, ZEND_ACC_PUBLIC)
   PHP_ME(Message, mergeFrom,             arginfo_mergeFrom, ZEND_ACC_PUBLIC)
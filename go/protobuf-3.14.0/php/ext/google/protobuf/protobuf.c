@@ -71,9 +71,15 @@ ZEND_BEGIN_MODULE_GLOBALS(protobuf)
   // Object cache (see interface in protobuf.h).
   HashTable object_cache;
 
-  // Name cache (see interface in protobuf.h).
+  // Name cache (see interface in protobuf.h). The names refer to defs in the
+  // symtab, so these live exactly as long as it does: they are allocated
+  // persistently and kept along with saved_symtab.
   HashTable name_msg_cache;
   HashTable name_enum_cache;
+
+  // Generated file cache (see interface in protobuf.h). Also kept along with
+  // saved_symtab.
+  HashTable generated_files;
 ZEND_END_MODULE_GLOBALS(protobuf)
 
 ZEND_DECLARE_MODULE_GLOBALS(protobuf)
@@ -139,9 +145,22 @@ const zval *get_generated_pool() {
 //     Apache 2 mod_php with the "worker" MPM. But this is explicitly
 //     discouraged by the documentation: https://serverfault.com/a/231660
 
+static void InitPoolCaches(zend_protobuf_globals *protobuf_globals) {
+  zend_hash_init(&protobuf_globals->name_msg_cache, 64, NULL, NULL, 1);
+  zend_hash_init(&protobuf_globals->name_enum_cache, 64, NULL, NULL, 1);
+  zend_hash_init(&protobuf_globals->generated_files, 64, NULL, NULL, 1);
+}
+
+static void DestroyPoolCaches(zend_protobuf_globals *protobuf_globals) {
+  zend_hash_destroy(&protobuf_globals->name_msg_cache);
+  zend_hash_destroy(&protobuf_globals->name_enum_cache);
+  zend_hash_destroy(&protobuf_globals->generated_files);
+}
+
 static PHP_GSHUTDOWN_FUNCTION(protobuf) {
   if (protobuf_globals->saved_symtab) {
     upb_symtab_free(protobuf_globals->saved_symtab);
+    DestroyPoolCaches(protobuf_globals);
   }
 }
 
@@ -157,13 +176,17 @@ static PHP_GINIT_FUNCTION(protobuf) {
  */
 static PHP_RINIT_FUNCTION(protobuf) {
   // Create the global generated pool.
-  // Reuse the symtab (if any) left to us by the last request.
+  // Reuse the symtab (if any) left to us by the last request, together with
+  // the caches that were built along with it. The pool owns the symtab until
+  // the end of the request.
   upb_symtab *symtab = PROTOBUF_G(saved_symtab);
+  PROTOBUF_G(saved_symtab) = NULL;
+  if (!symtab) {
+    InitPoolCaches(ZEND_MODULE_GLOBALS_BULK(protobuf));
+  }
   DescriptorPool_CreateWithSymbolTable(&PROTOBUF_G(generated_pool), symtab);
 
   zend_hash_init(&PROTOBUF_G(object_cache), 64, NULL, NULL, 0);
-  zend_hash_init(&PROTOBUF_G(name_msg_cache), 64, NULL, NULL, 0);
-  zend_hash_init(&PROTOBUF_G(name_enum_cache), 64, NULL, NULL, 0);
 
   return SUCCESS;
 }
@@ -178,12 +201,13 @@ static PHP_RSHUTDOWN_FUNCTION(protobuf) {
   if (PROTOBUF_G(keep_descriptor_pool_after_request)) {
     zval *zv = &PROTOBUF_G(generated_pool);
     PROTOBUF_G(saved_symtab) = DescriptorPool_Steal(zv);
+  } else {
+    DestroyPoolCaches(ZEND_MODULE_GLOBALS_BULK(protobuf));
   }
 
   zval_dtor(&PROTOBUF_G(generated_pool));
   zend_hash_destroy(&PROTOBUF_G(object_cache));
-  zend_hash_destroy(&PROTOBUF_G(name_msg_cache));
-  zend_hash_destroy(&PROTOBUF_G(name_enum_cache));
+  Arena_ReleasePool();
 
   return SUCCESS;
 }
@@ -265,6 +289,21 @@ const upb_enumdef *NameMap_GetEnum(zend_class_entry *ce) {
   return ret;
 }
 
+// -----------------------------------------------------------------------------
+// Generated file cache.
+// -----------------------------------------------------------------------------
+
+bool GeneratedFiles_Contains(const char *data, size_t size) {
+  return zend_hash_str_exists(&PROTOBUF_G(generated_files), data, size);
+}
+
+void GeneratedFiles_Add(const char *data, size_t size) {
+  // Only worth remembering if the pool outlives the request.
+  if (PROTOBUF_G(keep_descriptor_pool_after_request)) {
+    zend_hash_str_add_empty_element(&PROTOBUF_G(generated_files), data, size);
+  }
+}
+
 // -----------------------------------------------------------------------------
 // Module init.
 // -----------------------------------------------------------------------------
@@ -98,6 +98,14 @@ void NameMap_AddEnum(const upb_enumdef *m);
 const upb_msgdef *NameMap_GetMessage(zend_class_entry *ce);
 const upb_enumdef *NameMap_GetEnum(zend_class_entry *ce);
 
+// Serialized descriptors already loaded into the generated pool. Generated code
+// calls internalAddGeneratedFile() again in every request, so when the pool is
+// kept between requests (protobuf.keep_descriptor_pool_after_request) this
+// lets it skip parsing descriptors it already has. Nothing is recorded when
+// the pool does not outlive the request.
+bool GeneratedFiles_Contains(const char *data, size_t size);
+void GeneratedFiles_Add(const char *data, size_t size);
+
 // We need our own assert() because PHP takes control of NDEBUG in its headers.
 #ifdef PBPHP_ENABLE_ASSERTS
 #define PBPHP_ASSERT(x)                                                    \
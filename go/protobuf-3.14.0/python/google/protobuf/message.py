@@ -359,6 +359,26 @@ class Message(object):
     """
     raise NotImplementedError
 
+  def BytesFieldView(self, field_name, index=None):
+    """Returns a read-only memoryview of a bytes field.
+
+    The C++ implementation returns a view of the field's own storage instead
+    of copying it into a new bytes object. That view keeps the message alive,
+    but is only valid until the field is next modified, cleared or parsed
+    into.
+
+    Args:
+      field_name (str): The name of a bytes field.
+      index (int): For a repeated field, the index of the element to view.
+
+    Returns:
+      memoryview: The bytes of the field.
+    """
+    value = getattr(self, field_name)
+    if index is not None:
+      value = value[index]
+    return memoryview(value)
+
   def _SetListener(self, message_listener):
     """Internal method used by the protocol message implementation.
     Clients should not call this directly.
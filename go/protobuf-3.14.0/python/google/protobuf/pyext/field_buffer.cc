@@ -0,0 +1,134 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/pyext/field_buffer.h>
+
+#include <Python.h>
+
+#include <google/protobuf/pyext/message.h>
+#include <google/protobuf/pyext/scoped_pyobject_ptr.h>
+
+namespace google {
+namespace protobuf {
+namespace python {
+
+namespace field_buffer {
+
+PyObject* NewMemoryView(PyObject* owner, const void* data, Py_ssize_t length,
+                        Py_ssize_t itemsize, const char* format) {
+  FieldBuffer* self = reinterpret_cast<FieldBuffer*>(
+      PyType_GenericAlloc(&FieldBuffer_Type, 0));
+  if (self == NULL) {
+    return NULL;
+  }
+  Py_INCREF(owner);
+  self->owner = owner;
+  self->data = data;
+  self->length = length;
+  self->itemsize = itemsize;
+  self->format = format;
+
+  ScopedPyObjectPtr buffer(reinterpret_cast<PyObject*>(self));
+  return PyMemoryView_FromObject(buffer.get());
+}
+
+static void Dealloc(PyObject* pself) {
+  FieldBuffer* self = reinterpret_cast<FieldBuffer*>(pself);
+  Py_CLEAR(self->owner);
+  Py_TYPE(pself)->tp_free(pself);
+}
+
+static int GetBuffer(PyObject* pself, Py_buffer* view, int flags) {
+  FieldBuffer* self = reinterpret_cast<FieldBuffer*>(pself);
+  if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "Field buffers are read-only.");
+    return -1;
+  }
+  view->obj = pself;
+  Py_INCREF(pself);
+  view->buf = const_cast<void*>(self->data);
+  view->len = self->length * self->itemsize;
+  view->readonly = 1;
+  view->itemsize = self->itemsize;
+  view->format =
+      (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : NULL;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND ? &self->length : NULL;
+  view->strides =
+      (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->itemsize : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+  return 0;
+}
+
+static PyBufferProcs BufferProcs = {
+#if PY_MAJOR_VERSION < 3
+    0,  // bf_getreadbuffer
+    0,  // bf_getwritebuffer
+    0,  // bf_getsegcount
+    0,  // bf_getcharbuffer
+#endif
+    GetBuffer,  // bf_getbuffer
+    0,          // bf_releasebuffer
+};
+
+}  // namespace field_buffer
+
+PyTypeObject FieldBuffer_Type = {
+  PyVarObject_HEAD_INIT(&PyType_Type, 0)
+  FULL_MODULE_NAME ".FieldBuffer",     // tp_name
+  sizeof(FieldBuffer),                 //  tp_basicsize
+  0,                                   //  tp_itemsize
+  field_buffer::Dealloc,               //  tp_dealloc
+  0,                                   //  tp_print
+  0,                                   //  tp_getattr
+  0,                                   //  tp_setattr
+  0,                                   //  tp_compare
+  0,                                   //  tp_repr
+  0,                                   //  tp_as_number
+  0,                                   //  tp_as_sequence
+  0,                                   //  tp_as_mapping
+  PyObject_HashNotImplemented,         //  tp_hash
+  0,                                   //  tp_call
+  0,                                   //  tp_str
+  0,                                   //  tp_getattro
+  0,                                   //  tp_setattro
+  &field_buffer::BufferProcs,          //  tp_as_buffer
+#if PY_MAJOR_VERSION < 3
+  Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER,  //  tp_flags
+#else
+  Py_TPFLAGS_DEFAULT,                  //  tp_flags
+#endif
+  "Read-only buffer over the memory of a message field",  //  tp_doc
+};
+
+}  // namespace python
+}  // namespace protobuf
+}  // namespace google
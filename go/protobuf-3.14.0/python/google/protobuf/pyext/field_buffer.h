@@ -0,0 +1,79 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef GOOGLE_PROTOBUF_PYTHON_CPP_FIELD_BUFFER_H__
+#define GOOGLE_PROTOBUF_PYTHON_CPP_FIELD_BUFFER_H__
+
+#include <Python.h>
+
+namespace google {
+namespace protobuf {
+namespace python {
+
+// Exports memory owned by a message field through the buffer protocol, so
+// that a memoryview (or NumPy, or anything else reading buffers) can see it
+// without a copy.
+//
+// The buffer holds a reference to its owner, which keeps the C++ message
+// alive, but the memory itself belongs to the field: changing, clearing or
+// re-parsing the field while a view exists leaves the view pointing at freed
+// or reused memory.  Views are read-only.
+typedef struct FieldBuffer {
+  PyObject_HEAD;
+
+  // Strong reference to the object that keeps the memory alive.
+  PyObject* owner;
+
+  const void* data;
+  // Number of items, and size of each.  shape and strides of the exported
+  // buffer point at these.
+  Py_ssize_t length;
+  Py_ssize_t itemsize;
+  // struct module format of one item, e.g. "B" or "q".
+  const char* format;
+} FieldBuffer;
+
+extern PyTypeObject FieldBuffer_Type;
+
+namespace field_buffer {
+
+// Returns a new read-only memoryview of length items of itemsize bytes at
+// data, described by the struct format string format (which must be a string
+// literal).  owner is kept alive as long as the view is.
+PyObject* NewMemoryView(PyObject* owner, const void* data, Py_ssize_t length,
+                        Py_ssize_t itemsize, const char* format);
+
+}  // namespace field_buffer
+
+}  // namespace python
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_PYTHON_CPP_FIELD_BUFFER_H__
@@ -61,6 +61,7 @@
 #include <google/protobuf/pyext/descriptor_pool.h>
 #include <google/protobuf/pyext/extension_dict.h>
 #include <google/protobuf/pyext/field.h>
+#include <google/protobuf/pyext/field_buffer.h>
 #include <google/protobuf/pyext/map_container.h>
 #include <google/protobuf/pyext/message_factory.h>
 #include <google/protobuf/pyext/repeated_composite_container.h>
@@ -1688,6 +1689,31 @@ static std::string GetMessageName(CMessage* self) {
   }
 }
 
+// Inputs and messages of at least this many bytes are parsed and serialized
+// with the GIL released, so that other Python threads run meanwhile. The
+// message must then not be used by another thread during the call, which is
+// why this is off (0) unless SetGilReleaseThreshold() is called.
+static Py_ssize_t gil_release_threshold = 0;
+
+// Sets gil_release_threshold and returns it.
+PyObject* SetGilReleaseThreshold(PyObject* m, PyObject* arg) {
+  Py_ssize_t threshold = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+  if (threshold == -1 && PyErr_Occurred()) {
+    return NULL;
+  }
+  if (threshold < 0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "Argument to SetGilReleaseThreshold must not be negative");
+    return NULL;
+  }
+  gil_release_threshold = threshold;
+  return PyInt_FromSize_t(threshold);
+}
+
+static bool ReleaseGilFor(Py_ssize_t size) {
+  return gil_release_threshold > 0 && size >= gil_release_threshold;
+}
+
 static PyObject* InternalSerializeToString(
     CMessage* self, PyObject* args, PyObject* kwargs,
     bool require_initialized) {
@@ -1768,7 +1794,14 @@ static PyObject* InternalSerializeToString(
   if (deterministic_obj != Py_None) {
     coded_out.SetSerializationDeterministic(deterministic);
   }
-  self->message->SerializeWithCachedSizes(&coded_out);
+  if (ReleaseGilFor(size)) {
+    // The result is not visible to other threads yet.
+    Py_BEGIN_ALLOW_THREADS
+    self->message->SerializeWithCachedSizes(&coded_out);
+    Py_END_ALLOW_THREADS
+  } else {
+    self->message->SerializeWithCachedSizes(&coded_out);
+  }
   GOOGLE_CHECK(!coded_out.HadError());
   return result;
 }
@@ -1939,27 +1972,72 @@ PyObject* SetAllowOversizeProtos(PyObject* m, PyObject* arg) {
   }
 }
 
+namespace {
+
+// Holds a contiguous buffer exported by a Python object (bytes, bytearray,
+// memoryview, mmap, ...) until the end of the scope.  The exporter cannot
+// resize or free the memory while it is held, so it can be parsed in place.
+class ScopedPyBuffer {
+ public:
+  ScopedPyBuffer() : acquired_(false) {}
+  ~ScopedPyBuffer() {
+    if (acquired_) PyBuffer_Release(&view_);
+  }
+
+  bool Acquire(PyObject* obj) {
+    acquired_ = PyObject_GetBuffer(obj, &view_, PyBUF_SIMPLE) == 0;
+    return acquired_;
+  }
+
+  const char* data() const { return static_cast<const char*>(view_.buf); }
+  Py_ssize_t size() const { return view_.len; }
+  // Other threads may write to a mutable buffer (bytearray, ...).
+  bool readonly() const { return view_.readonly; }
+
+ private:
+  Py_buffer view_;
+  bool acquired_;
+};
+
+}  // namespace
+
 static PyObject* MergeFromString(CMessage* self, PyObject* arg) {
-  const void* data;
-  Py_ssize_t data_length;
-  if (PyObject_AsReadBuffer(arg, &data, &data_length) < 0) {
+  ScopedPyBuffer buffer;
+  if (!buffer.Acquire(arg)) {
     return NULL;
   }
+  const char* data = buffer.data();
+  Py_ssize_t data_length = buffer.size();
 
   AssureWritable(self);
 
   PyMessageFactory* factory = GetFactoryForMessage(self);
+  // A pool backed by a Python database calls into Python to find extensions.
+  bool release_gil =
+      ReleaseGilFor(data_length) && factory->pool->database == NULL;
+  std::string copy;
+  if (release_gil && !buffer.readonly()) {
+    copy.assign(data, data_length);
+    data = copy.data();
+  }
+
   int depth = allow_oversize_protos
                   ? INT_MAX
                   : io::CodedInputStream::GetDefaultRecursionLimit();
   const char* ptr;
   internal::ParseContext ctx(
       depth, false, &ptr,
-      StringPiece(static_cast<const char*>(data), data_length));
+      StringPiece(data, data_length));
   ctx.data().pool = factory->pool->pool;
   ctx.data().factory = factory->message_factory;
 
-  ptr = self->message->_InternalParse(ptr, &ctx);
+  if (release_gil) {
+    Py_BEGIN_ALLOW_THREADS
+    ptr = self->message->_InternalParse(ptr, &ctx);
+    Py_END_ALLOW_THREADS
+  } else {
+    ptr = self->message->_InternalParse(ptr, &ctx);
+  }
 
   // Child message might be lazily created before MergeFrom. Make sure they
   // are mutable at this point if child messages are really created.
@@ -1993,6 +2071,79 @@ static PyObject* ParseFromString(CMessage* self, PyObject* arg) {
   return MergeFromString(self, arg);
 }
 
+static PyObject* BytesFieldView(CMessage* self, PyObject* args) {
+  PyObject* py_name;
+  PyObject* py_index = Py_None;
+  if (!PyArg_ParseTuple(args, "O|O", &py_name, &py_index)) {
+    return NULL;
+  }
+  bool has_index = py_index != Py_None;
+  Py_ssize_t index = 0;
+  if (has_index) {
+    index = PyNumber_AsSsize_t(py_index, PyExc_IndexError);
+    if (index == -1 && PyErr_Occurred()) {
+      return NULL;
+    }
+  }
+  char* field_name;
+  Py_ssize_t size;
+  if (PyString_AsStringAndSize(py_name, &field_name, &size) < 0) {
+    return NULL;
+  }
+
+  Message* message = self->message;
+  const FieldDescriptor* field_descriptor =
+      message->GetDescriptor()->FindFieldByName(StringParam(field_name, size));
+  if (field_descriptor == NULL) {
+    PyErr_Format(PyExc_ValueError, "Protocol message %s has no field %s.",
+                 message->GetDescriptor()->name().c_str(), field_name);
+    return NULL;
+  }
+  if (field_descriptor->type() != FieldDescriptor::TYPE_BYTES) {
+    PyErr_Format(PyExc_TypeError, "Field %s is not a bytes field.",
+                 field_descriptor->full_name().c_str());
+    return NULL;
+  }
+
+  const Reflection* reflection = message->GetReflection();
+  std::string scratch;
+  const std::string* value;
+  if (field_descriptor->is_repeated()) {
+    Py_ssize_t length = reflection->FieldSize(*message, field_descriptor);
+    if (!has_index) {
+      PyErr_Format(PyExc_TypeError, "Field %s is repeated; an index is needed.",
+                   field_descriptor->full_name().c_str());
+      return NULL;
+    }
+    if (index < 0) index += length;
+    if (index < 0 || index >= length) {
+      PyErr_Format(PyExc_IndexError, "list index (%zd) out of range", index);
+      return NULL;
+    }
+    value = &reflection->GetRepeatedStringReference(*message, field_descriptor,
+                                                    index, &scratch);
+  } else {
+    if (has_index) {
+      PyErr_Format(PyExc_TypeError, "Field %s is not repeated.",
+                   field_descriptor->full_name().c_str());
+      return NULL;
+    }
+    value = &reflection->GetStringReference(*message, field_descriptor,
+                                            &scratch);
+  }
+  if (value == &scratch) {
+    // The field is not stored as a std::string; view a copy instead.
+    ScopedPyObjectPtr copy(PyBytes_FromStringAndSize(
+        scratch.data(), scratch.size()));
+    if (copy == NULL) {
+      return NULL;
+    }
+    return PyMemoryView_FromObject(copy.get());
+  }
+  return field_buffer::NewMemoryView(self->AsPyObject(), value->data(),
+                                     value->size(), 1, "B");
+}
+
 static PyObject* ByteSize(CMessage* self, PyObject* args) {
   return PyLong_FromLong(self->message->ByteSizeLong());
 }
@@ -2512,6 +2663,8 @@ static PyMethodDef Methods[] = {
     "Outputs a unicode representation of the message." },
   { "ByteSize", (PyCFunction)ByteSize, METH_NOARGS,
     "Returns the size of the message in bytes." },
+  { "BytesFieldView", (PyCFunction)BytesFieldView, METH_VARARGS,
+    "Returns a read-only memoryview of a bytes field without copying it." },
   { "Clear", (PyCFunction)Clear, METH_NOARGS,
     "Clears the message." },
   { "ClearExtension", (PyCFunction)ClearExtension, METH_O,
@@ -2993,6 +3146,10 @@ bool InitProto2MessageModule(PyObject *m) {
     }
   }
 
+  if (PyType_Ready(&FieldBuffer_Type) < 0) {
+    return false;
+  }
+
   if (PyType_Ready(&PyUnknownFields_Type) < 0) {
     return false;
   }
@@ -276,6 +276,8 @@ PyMessageFactory* GetFactoryForMessage(CMessage* message);
 
 PyObject* SetAllowOversizeProtos(PyObject* m, PyObject* arg);
 
+PyObject* SetGilReleaseThreshold(PyObject* m, PyObject* arg);
+
 }  // namespace cmessage
 
 
@@ -70,6 +70,11 @@ static PyMethodDef ModuleMethods[] = {
     {"SetAllowOversizeProtos",
      (PyCFunction)google::protobuf::python::cmessage::SetAllowOversizeProtos, METH_O,
      "Enable/disable oversize proto parsing."},
+    {"SetGilReleaseThreshold",
+     (PyCFunction)google::protobuf::python::cmessage::SetGilReleaseThreshold,
+     METH_O,
+     "Release the GIL while parsing or serializing at least this many bytes "
+     "(0 never does). The message must not be used by other threads then."},
     // DO NOT USE: For migration and testing only.
     {NULL, NULL}};
 
@@ -33,6 +33,8 @@
 
 #include <google/protobuf/pyext/repeated_scalar_container.h>
 
+#include <cstring>
+#include <limits>
 #include <memory>
 
 #include <google/protobuf/stubs/common.h>
@@ -42,6 +44,7 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/pyext/descriptor.h>
 #include <google/protobuf/pyext/descriptor_pool.h>
+#include <google/protobuf/pyext/field_buffer.h>
 #include <google/protobuf/pyext/message.h>
 #include <google/protobuf/pyext/scoped_pyobject_ptr.h>
 
@@ -666,6 +669,186 @@ static PyObject* MergeFrom(PyObject* pself, PyObject* arg) {
   return Extend(reinterpret_cast<RepeatedScalarContainer*>(pself), arg);
 }
 
+// Bulk access through the buffer protocol.  Numeric and bool fields are kept
+// in a RepeatedField<T>, which is one contiguous array, so a whole field can be
+// exported or appended to with a single memcpy instead of one Python object per
+// element.  Enum fields are excluded: reflection does not hand out their
+// RepeatedField, and appending would skip the check for unknown values.
+
+// Kinds of buffer items, as given by the struct module format character.
+enum ItemKind {
+  ITEM_UNSUPPORTED,
+  ITEM_SIGNED,
+  ITEM_UNSIGNED,
+  ITEM_FLOAT,
+  ITEM_BOOL,
+};
+
+// Returns the kind of items described by the struct format 'format', or
+// ITEM_UNSUPPORTED if they are not native-order scalars.
+static ItemKind GetItemKind(const char* format) {
+  if (format == NULL) {
+    // No format means unsigned bytes.
+    return ITEM_UNSIGNED;
+  }
+  switch (*format) {
+    case '@':
+    case '=':
+      ++format;
+      break;
+    case '<':
+#if PY_LITTLE_ENDIAN
+      ++format;
+      break;
+#else
+      return ITEM_UNSUPPORTED;
+#endif
+    case '>':
+    case '!':
+#if PY_LITTLE_ENDIAN
+      return ITEM_UNSUPPORTED;
+#else
+      ++format;
+      break;
+#endif
+  }
+  if (format[0] == '\0' || format[1] != '\0') {
+    return ITEM_UNSUPPORTED;
+  }
+  switch (format[0]) {
+    case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+      return ITEM_SIGNED;
+    case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N':
+      return ITEM_UNSIGNED;
+    case 'f': case 'd':
+      return ITEM_FLOAT;
+    case '?':
+      return ITEM_BOOL;
+    default:
+      return ITEM_UNSUPPORTED;
+  }
+}
+
+template <typename T>
+static PyObject* ExportField(RepeatedScalarContainer* self,
+                             const char* format) {
+  Message* message = self->parent->message;
+  const Reflection* reflection = message->GetReflection();
+  const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
+  PyObject* owner = reinterpret_cast<PyObject*>(self->parent);
+  // An absent extension would be created by GetRepeatedField(), which must not
+  // happen to a read-only (e.g. default instance) message.
+  if (reflection->FieldSize(*message, field_descriptor) == 0) {
+    static const T kEmpty = T();
+    return field_buffer::NewMemoryView(owner, &kEmpty, 0, sizeof(T), format);
+  }
+  const RepeatedField<T>& field =
+      reflection->GetRepeatedField<T>(*message, field_descriptor);
+  return field_buffer::NewMemoryView(owner, field.data(), field.size(),
+                                     sizeof(T), format);
+}
+
+template <typename T>
+static PyObject* AppendItems(RepeatedScalarContainer* self,
+                             const Py_buffer& buffer, ItemKind kind) {
+  if (GetItemKind(buffer.format) != kind || buffer.itemsize != sizeof(T)) {
+    PyErr_Format(PyExc_TypeError,
+                 "Buffer of format '%s' and item size %zd does not match "
+                 "field %s",
+                 buffer.format != NULL ? buffer.format : "B", buffer.itemsize,
+                 self->parent_field_descriptor->full_name().c_str());
+    return NULL;
+  }
+  Py_ssize_t count = buffer.len / buffer.itemsize;
+  if (count == 0) {
+    Py_RETURN_NONE;
+  }
+
+  cmessage::AssureWritable(self->parent);
+  Message* message = self->parent->message;
+  RepeatedField<T>* field =
+      message->GetReflection()->MutableRepeatedField<T>(
+          message, self->parent_field_descriptor);
+  if (count > std::numeric_limits<int>::max() - field->size()) {
+    PyErr_SetString(PyExc_OverflowError, "Too many elements for a field");
+    return NULL;
+  }
+  field->Reserve(field->size() + static_cast<int>(count));
+  memcpy(field->AddNAlreadyReserved(static_cast<int>(count)), buffer.buf,
+         count * sizeof(T));
+  Py_RETURN_NONE;
+}
+
+static PyObject* AsBuffer(PyObject* pself, PyObject* unused) {
+  RepeatedScalarContainer* self =
+      reinterpret_cast<RepeatedScalarContainer*>(pself);
+  const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return ExportField<int32>(self, "i");
+    case FieldDescriptor::CPPTYPE_INT64:
+      return ExportField<int64>(self, "q");
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return ExportField<uint32>(self, "I");
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return ExportField<uint64>(self, "Q");
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return ExportField<float>(self, "f");
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return ExportField<double>(self, "d");
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return ExportField<bool>(self, "?");
+    default:
+      PyErr_Format(PyExc_TypeError,
+                   "Field %s cannot be viewed as a buffer",
+                   field_descriptor->full_name().c_str());
+      return NULL;
+  }
+}
+
+static PyObject* ExtendFromBuffer(PyObject* pself, PyObject* arg) {
+  RepeatedScalarContainer* self =
+      reinterpret_cast<RepeatedScalarContainer*>(pself);
+  Py_buffer buffer;
+  if (PyObject_GetBuffer(arg, &buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) <
+      0) {
+    return NULL;
+  }
+  PyObject* result;
+  const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      result = AppendItems<int32>(self, buffer, ITEM_SIGNED);
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      result = AppendItems<int64>(self, buffer, ITEM_SIGNED);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      result = AppendItems<uint32>(self, buffer, ITEM_UNSIGNED);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      result = AppendItems<uint64>(self, buffer, ITEM_UNSIGNED);
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      result = AppendItems<float>(self, buffer, ITEM_FLOAT);
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      result = AppendItems<double>(self, buffer, ITEM_FLOAT);
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      result = AppendItems<bool>(self, buffer, ITEM_BOOL);
+      break;
+    default:
+      PyErr_Format(PyExc_TypeError,
+                   "Field %s cannot be extended from a buffer",
+                   field_descriptor->full_name().c_str());
+      result = NULL;
+      break;
+  }
+  PyBuffer_Release(&buffer);
+  return result;
+}
+
 // The private constructor of RepeatedScalarContainer objects.
 RepeatedScalarContainer* NewContainer(
     CMessage* parent, const FieldDescriptor* parent_field_descriptor) {
@@ -729,6 +912,10 @@ static PyMethodDef Methods[] = {
     "Sorts the repeated container."},
   { "MergeFrom", (PyCFunction)MergeFrom, METH_O,
     "Merges a repeated container into the current container." },
+  { "AsBuffer", AsBuffer, METH_NOARGS,
+    "Returns a read-only memoryview of a numeric field without copying it." },
+  { "ExtendFromBuffer", ExtendFromBuffer, METH_O,
+    "Appends the items of a buffer of matching type, e.g. a NumPy array." },
   { NULL, NULL }
 };
 
@@ -47,12 +47,8 @@ void AnyMetadata::PackFrom(const Message& message) {
 
 void AnyMetadata::PackFrom(const Message& message,
                            StringPiece type_url_prefix) {
-  type_url_->Set(
-      &::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString(),
-      GetTypeUrl(message.GetDescriptor()->full_name(), type_url_prefix),
-      nullptr);
-  message.SerializeToString(
-      value_->Mutable(ArenaStringPtr::EmptyDefault{}, nullptr));
+  InternalSetTypeUrl(type_url_prefix, message.GetDescriptor()->full_name());
+  SerializeToArenaString(message, value_, nullptr);
 }
 
 bool AnyMetadata::UnpackTo(Message* message) const {
@@ -67,7 +67,7 @@ class PROTOBUF_EXPORT AnyMetadata {
   // The resulted type URL will be "type.googleapis.com/<message_full_name>".
   template <typename T>
   void PackFrom(const T& message) {
-    InternalPackFrom(message, kTypeGoogleApisComPrefix, T::FullMessageName());
+    InternalPackFrom(message, DefaultTypeUrl<T>());
   }
 
   void PackFrom(const Message& message);
@@ -105,9 +105,23 @@ class PROTOBUF_EXPORT AnyMetadata {
   }
 
  private:
+  // Returns "type.googleapis.com/<message_full_name>" for T.  The URL is built
+  // on first use and shared by every later PackFrom() of the same type.
+  template <typename T>
+  static const std::string& DefaultTypeUrl() {
+    static const std::string* type_url = OnShutdownDelete(new std::string(
+        GetTypeUrl(T::FullMessageName(), kTypeGoogleApisComPrefix)));
+    return *type_url;
+  }
+
   void InternalPackFrom(const MessageLite& message,
                         StringPiece type_url_prefix,
                         StringPiece type_name);
+  void InternalPackFrom(const MessageLite& message,
+                        const std::string& type_url);
+  // Sets the type URL in place, without building a temporary string.
+  void InternalSetTypeUrl(StringPiece type_url_prefix,
+                          StringPiece type_name);
   bool InternalUnpackTo(StringPiece type_name,
                         MessageLite* message) const;
   bool InternalIs(StringPiece type_name) const;
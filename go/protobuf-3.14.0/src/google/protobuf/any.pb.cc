@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -177,8 +178,13 @@ const char* Any::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::intern
       // string type_url = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_type_url();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &type_url_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(type_url_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &type_url_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Any.type_url"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -186,8 +192,13 @@ const char* Any::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::intern
       // bytes value = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_value();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &value_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(value_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &value_.Get(); (void)str;
           CHK_(ptr);
         } else goto handle_unusual;
         continue;
@@ -243,6 +254,30 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Any::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // bytes value = 2;
+  if (this->value().size() > 0) {
+    ptr = encoder->WriteBytes(2, this->_internal_value(), ptr);
+  }
+
+  // string type_url = 1;
+  if (this->type_url().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_type_url().data(), static_cast<int>(this->_internal_type_url().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Any.type_url");
+    ptr = encoder->WriteString(1, this->_internal_type_url(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Any::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Any)
   size_t total_size = 0;
@@ -53,13 +53,31 @@ const char kAnyFullTypeName[] = "google.protobuf.Any";
 const char kTypeGoogleApisComPrefix[] = "type.googleapis.com/";
 const char kTypeGoogleProdComPrefix[] = "type.googleprod.com/";
 
+void AnyMetadata::InternalSetTypeUrl(StringPiece type_url_prefix,
+                                     StringPiece type_name) {
+  std::string* type_url =
+      type_url_->Mutable(ArenaStringPtr::EmptyDefault{}, nullptr);
+  type_url->reserve(type_url_prefix.size() + 1 + type_name.size());
+  type_url->assign(type_url_prefix.data(), type_url_prefix.size());
+  if (type_url_prefix.empty() ||
+      type_url_prefix[type_url_prefix.size() - 1] != '/') {
+    type_url->push_back('/');
+  }
+  type_url->append(type_name.data(), type_name.size());
+}
+
 void AnyMetadata::InternalPackFrom(const MessageLite& message,
                                    StringPiece type_url_prefix,
                                    StringPiece type_name) {
-  type_url_->Set(&::google::protobuf::internal::GetEmptyString(),
-                 GetTypeUrl(type_name, type_url_prefix), nullptr);
-  message.SerializeToString(
-      value_->Mutable(ArenaStringPtr::EmptyDefault{}, nullptr));
+  InternalSetTypeUrl(type_url_prefix, type_name);
+  SerializeToArenaString(message, value_, nullptr);
+}
+
+void AnyMetadata::InternalPackFrom(const MessageLite& message,
+                                   const std::string& type_url) {
+  type_url_->Set(&::google::protobuf::internal::GetEmptyString(), type_url,
+                 nullptr);
+  SerializeToArenaString(message, value_, nullptr);
 }
 
 bool AnyMetadata::InternalUnpackTo(StringPiece type_name,
@@ -111,6 +111,19 @@ TEST(AnyTest, TestPackWithCustomTypeUrl) {
   EXPECT_EQ(12345, submessage.int32_value());
 }
 
+TEST(AnyTest, TestRepackReplacesTypeUrl) {
+  protobuf_unittest::TestAny submessage;
+  google::protobuf::Any any;
+  any.PackFrom(submessage, "type.myservice.com/with/a/long/path");
+  any.PackFrom(submessage);
+  EXPECT_EQ("type.googleapis.com/protobuf_unittest.TestAny", any.type_url());
+  // The reflection-based overload must agree with the generated one.
+  any.PackFrom(static_cast<const Message&>(submessage));
+  EXPECT_EQ("type.googleapis.com/protobuf_unittest.TestAny", any.type_url());
+  any.PackFrom(static_cast<const Message&>(submessage), "x");
+  EXPECT_EQ("x/protobuf_unittest.TestAny", any.type_url());
+}
+
 TEST(AnyTest, TestIs) {
   protobuf_unittest::TestAny submessage;
   submessage.set_int32_value(12345);
@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -288,8 +289,13 @@ const char* Api::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::intern
       // string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Api.name"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -321,8 +327,13 @@ const char* Api::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::intern
       // string version = 4;
       case 4:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 34)) {
-          auto str = _internal_mutable_version();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &version_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(version_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &version_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Api.version"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -449,6 +460,59 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Api::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // .google.protobuf.Syntax syntax = 7;
+  if (this->syntax() != 0) {
+    ptr = encoder->WriteEnum(7, this->_internal_syntax(), ptr);
+  }
+
+  // repeated .google.protobuf.Mixin mixins = 6;
+  for (int i = this->_internal_mixins_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(6, this->_internal_mixins(i), ptr);
+  }
+
+  // .google.protobuf.SourceContext source_context = 5;
+  if (this->has_source_context()) {
+    ptr = encoder->WriteMessage(5, this->_internal_source_context(), ptr);
+  }
+
+  // string version = 4;
+  if (this->version().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_version().data(), static_cast<int>(this->_internal_version().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Api.version");
+    ptr = encoder->WriteString(4, this->_internal_version(), ptr);
+  }
+
+  // repeated .google.protobuf.Option options = 3;
+  for (int i = this->_internal_options_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(3, this->_internal_options(i), ptr);
+  }
+
+  // repeated .google.protobuf.Method methods = 2;
+  for (int i = this->_internal_methods_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(2, this->_internal_methods(i), ptr);
+  }
+
+  // string name = 1;
+  if (this->name().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Api.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Api::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Api)
   size_t total_size = 0;
@@ -698,8 +762,13 @@ const char* Method::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::int
       // string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Method.name"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -707,8 +776,13 @@ const char* Method::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::int
       // string request_type_url = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_request_type_url();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &request_type_url_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(request_type_url_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &request_type_url_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Method.request_type_url"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -723,8 +797,13 @@ const char* Method::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::int
       // string response_type_url = 4;
       case 4:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 34)) {
-          auto str = _internal_mutable_response_type_url();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &response_type_url_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(response_type_url_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &response_type_url_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Method.response_type_url"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -849,6 +928,63 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Method::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // .google.protobuf.Syntax syntax = 7;
+  if (this->syntax() != 0) {
+    ptr = encoder->WriteEnum(7, this->_internal_syntax(), ptr);
+  }
+
+  // repeated .google.protobuf.Option options = 6;
+  for (int i = this->_internal_options_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(6, this->_internal_options(i), ptr);
+  }
+
+  // bool response_streaming = 5;
+  if (this->response_streaming() != 0) {
+    ptr = encoder->WriteBool(5, this->_internal_response_streaming(), ptr);
+  }
+
+  // string response_type_url = 4;
+  if (this->response_type_url().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_response_type_url().data(), static_cast<int>(this->_internal_response_type_url().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Method.response_type_url");
+    ptr = encoder->WriteString(4, this->_internal_response_type_url(), ptr);
+  }
+
+  // bool request_streaming = 3;
+  if (this->request_streaming() != 0) {
+    ptr = encoder->WriteBool(3, this->_internal_request_streaming(), ptr);
+  }
+
+  // string request_type_url = 2;
+  if (this->request_type_url().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_request_type_url().data(), static_cast<int>(this->_internal_request_type_url().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Method.request_type_url");
+    ptr = encoder->WriteString(2, this->_internal_request_type_url(), ptr);
+  }
+
+  // string name = 1;
+  if (this->name().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Method.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Method::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Method)
   size_t total_size = 0;
@@ -1073,8 +1209,13 @@ const char* Mixin::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::inte
       // string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Mixin.name"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -1082,8 +1223,13 @@ const char* Mixin::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::inte
       // string root = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_root();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &root_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(root_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &root_.Get(); (void)str;
           CHK_(::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.Mixin.root"));
           CHK_(ptr);
         } else goto handle_unusual;
@@ -1144,6 +1290,34 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Mixin::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // string root = 2;
+  if (this->root().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_root().data(), static_cast<int>(this->_internal_root().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Mixin.root");
+    ptr = encoder->WriteString(2, this->_internal_root(), ptr);
+  }
+
+  // string name = 1;
+  if (this->name().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Mixin.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Mixin::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Mixin)
   size_t total_size = 0;
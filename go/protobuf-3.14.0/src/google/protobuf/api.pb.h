@@ -155,6 +155,8 @@ class PROTOBUF_EXPORT Api PROTOBUF_FINAL :
   const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
   ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerialize(
       ::PROTOBUF_NAMESPACE_ID::uint8* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerializeReverse(
+      ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const final;
   int GetCachedSize() const final { return _cached_size_.Get(); }
 
   private:
@@ -407,6 +409,8 @@ class PROTOBUF_EXPORT Method PROTOBUF_FINAL :
   const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
   ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerialize(
       ::PROTOBUF_NAMESPACE_ID::uint8* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerializeReverse(
+      ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const final;
   int GetCachedSize() const final { return _cached_size_.Get(); }
 
   private:
@@ -639,6 +643,8 @@ class PROTOBUF_EXPORT Mixin PROTOBUF_FINAL :
   const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
   ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerialize(
       ::PROTOBUF_NAMESPACE_ID::uint8* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  ::PROTOBUF_NAMESPACE_ID::uint8* _InternalSerializeReverse(
+      ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const final;
   int GetCachedSize() const final { return _cached_size_.Get(); }
 
   private:
@@ -34,6 +34,7 @@
 #include <atomic>
 #include <limits>
 
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/stubs/mutex.h>
 
 #ifdef ADDRESS_SANITIZER
@@ -72,6 +73,35 @@ PROTOBUF_THREAD_LOCAL ArenaImpl::ThreadCache ArenaImpl::thread_cache_ = {
     0, static_cast<LifecycleIdAtomic>(-1), nullptr};
 #endif
 
+namespace {
+
+// Backing store of arena_metrics::GetGlobalArenaStats(). These are only
+// updated when blocks are allocated or freed, never per allocation.
+struct alignas(64) GlobalArenaCounters {
+  std::atomic<uint64> arena_cycles;
+  std::atomic<uint64> blocks_allocated;
+  std::atomic<uint64> bytes_allocated;
+  std::atomic<uint64> bytes_freed;
+  std::atomic<uint64> fallback_allocations;
+};
+GlobalArenaCounters global_arena_counters;
+
+inline void CountBlockAllocated(size_t size) {
+  global_arena_counters.blocks_allocated.fetch_add(1,
+                                                   std::memory_order_relaxed);
+  global_arena_counters.bytes_allocated.fetch_add(size,
+                                                  std::memory_order_relaxed);
+}
+
+inline void CountBytesFreed(uint64 size) {
+  if (size != 0) {
+    global_arena_counters.bytes_freed.fetch_add(size,
+                                                std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+
 void ArenaFree(void* object, size_t size) {
 #if defined(__GXX_DELETE_WITH_SIZE__) || defined(__cpp_sized_deallocation)
   ::operator delete(object, size);
@@ -99,6 +129,7 @@ ArenaImpl::ArenaImpl(const ArenaOptions& options) {
     // Supplied initial block is not big enough.
     mem_size = std::max(min_block_size, options.start_block_size);
     mem = reinterpret_cast<char*>((*options.block_alloc)(mem_size));
+    CountBlockAllocated(mem_size);
   }
 
   // Create the special block.
@@ -147,6 +178,7 @@ void ArenaImpl::Init(bool record_allocs) {
   hint_.store(nullptr, std::memory_order_relaxed);
   threads_.store(nullptr, std::memory_order_relaxed);
   space_allocated_.store(0, std::memory_order_relaxed);
+  global_arena_counters.arena_cycles.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ArenaImpl::SetInitialBlock(SerialArena::Block* block) {
@@ -171,55 +203,99 @@ ArenaImpl::~ArenaImpl() {
     deallocator = options_->block_dealloc;
   }
 
-  PerBlock([deallocator](SerialArena::Block* b) {
+  uint64 space_freed = 0;
+  PerBlock([deallocator, &space_freed](SerialArena::Block* b) {
 #ifdef ADDRESS_SANITIZER
     // This memory was provided by the underlying allocator as unpoisoned, so
     // return it in an unpoisoned state.
     ASAN_UNPOISON_MEMORY_REGION(b->Pointer(0), b->size());
 #endif  // ADDRESS_SANITIZER
     if (!b->user_owned()) {
+      space_freed += b->size();
       (*deallocator)(b, b->size());
     }
   });
+  CountBytesFreed(space_freed);
 
   if (collector) {
     collector->OnDestroy(SpaceAllocated());
   }
 }
 
-uint64 ArenaImpl::Reset() {
-  if (options_ && options_->metrics_collector) {
-    options_->metrics_collector->OnReset(SpaceAllocated());
+uint64 ArenaImpl::Reset() { return ResetAndRetainBlocks(0, 0); }
+
+uint64 ArenaImpl::ResetAndRetainBlocks(size_t max_blocks, size_t max_bytes) {
+  ArenaMetricsCollector* collector =
+      options_ ? options_->metrics_collector : nullptr;
+  if (collector) {
+    collector->OnReset(SpaceAllocated());
   }
 
   // Have to do this in a first pass, because some of the destructors might
   // refer to memory in other blocks.
   CleanupList();
 
-  // Discard all blocks except the special block (if present).
+  // Discard all blocks except the special block (if present) and the largest
+  // max_blocks blocks that fit in max_bytes. Candidates are kept sorted by
+  // decreasing size.
+  if (max_blocks > kMaxRetainedBlocks) max_blocks = kMaxRetainedBlocks;
+  SerialArena::Block* retained[kMaxRetainedBlocks];
+  size_t num_retained = 0;
   uint64 space_allocated = 0;
+  uint64 space_freed = 0;
   SerialArena::Block* special_block = nullptr;
   auto deallocator = (options_ ? options_->block_dealloc : &ArenaFree);
-  PerBlock(
-      [&space_allocated, &special_block, deallocator](SerialArena::Block* b) {
-        space_allocated += b->size();
+  auto free_block = [deallocator, &space_freed](SerialArena::Block* b) {
+    space_freed += b->size();
+    (*deallocator)(b, b->size());
+  };
+  PerBlock([&](SerialArena::Block* b) {
+    space_allocated += b->size();
 #ifdef ADDRESS_SANITIZER
-        // This memory was provided by the underlying allocator as unpoisoned,
-        // so return it in an unpoisoned state.
-        ASAN_UNPOISON_MEMORY_REGION(b->Pointer(0), b->size());
+    // This memory was provided by the underlying allocator as unpoisoned,
+    // so return it in an unpoisoned state.
+    ASAN_UNPOISON_MEMORY_REGION(b->Pointer(0), b->size());
 #endif  // ADDRESS_SANITIZER
-        if (!b->special()) {
-          (*deallocator)(b, b->size());
-        } else {
-          // Prepare special block for reuse.
-          // Note: if options_ is present, it occupies the beginning of the
-          // block and therefore pos is advanced past it.
-          GOOGLE_DCHECK(special_block == nullptr);
-          special_block = b;
-        }
-      });
+    if (b->special()) {
+      // Prepare special block for reuse.
+      // Note: if options_ is present, it occupies the beginning of the
+      // block and therefore pos is advanced past it.
+      GOOGLE_DCHECK(special_block == nullptr);
+      special_block = b;
+      return;
+    }
+    if (max_blocks == 0 || b->size() > max_bytes ||
+        (num_retained == max_blocks &&
+         retained[num_retained - 1]->size() >= b->size())) {
+      free_block(b);
+      return;
+    }
+    if (num_retained == max_blocks) {
+      free_block(retained[--num_retained]);
+    }
+    size_t i = num_retained++;
+    for (; i > 0 && retained[i - 1]->size() < b->size(); i--) {
+      retained[i] = retained[i - 1];
+    }
+    retained[i] = b;
+  });
+
+  // Apply the byte budget, largest blocks first.
+  size_t retained_bytes = 0;
+  size_t num_kept = 0;
+  for (size_t i = 0; i < num_retained; i++) {
+    SerialArena::Block* b = retained[i];
+    if (retained_bytes + b->size() <= max_bytes) {
+      retained_bytes += b->size();
+      retained[num_kept++] = b;
+    } else {
+      free_block(b);
+    }
+  }
+  CountBytesFreed(space_freed);
 
   Init(record_allocs());
+  size_t first_spare = 0;
   if (special_block != nullptr) {
     // next() should still be nullptr since we are using a stack discipline, but
     // clear it anyway to reduce fragility.
@@ -227,6 +303,30 @@ uint64 ArenaImpl::Reset() {
     special_block->clear_next();
     special_block->set_pos(kBlockHeaderSize + (options_ ? kOptionsSize : 0));
     SetInitialBlock(special_block);
+  } else if (num_kept > 0) {
+    // Without a special block the largest retained block takes its place.
+    first_spare = 1;
+    SetInitialBlock(new (retained[0])
+                        SerialArena::Block(retained[0]->size(), nullptr,
+                                           /*special=*/false,
+                                           /*user_owned=*/false));
+  }
+  if (num_kept > first_spare) {
+    // Chain the remaining blocks, largest first, as spares of the calling
+    // thread's SerialArena.
+    SerialArena::Block* spare = nullptr;
+    uint64 spare_bytes = 0;
+    for (size_t i = num_kept; i > first_spare; i--) {
+      SerialArena::Block* b = retained[i - 1];
+      spare_bytes += b->size();
+      spare = new (b) SerialArena::Block(b->size(), spare, /*special=*/false,
+                                         /*user_owned=*/false);
+    }
+    threads_.load(std::memory_order_relaxed)->set_spare(spare);
+    space_allocated_.fetch_add(spare_bytes, std::memory_order_relaxed);
+  }
+  if (collector && max_blocks > 0) {
+    collector->OnRetain(SpaceAllocated());
   }
   return space_allocated;
 }
@@ -247,6 +347,8 @@ std::pair<void*, size_t> ArenaImpl::NewBuffer(size_t last_size,
 
   void* mem = options_ ? (*options_->block_alloc)(size) : ::operator new(size);
   space_allocated_.fetch_add(size, std::memory_order_relaxed);
+  ParseBudgetCharge(size);
+  CountBlockAllocated(size);
   return {mem, size};
 }
 
@@ -317,7 +419,21 @@ void* SerialArena::AllocateAlignedFallback(size_t n) {
   // Sync back to current's pos.
   head_->set_pos(head_->size() - (limit_ - ptr_));
 
-  head_ = NewBlock(head_, n, arena_);
+  fallback_allocations_.store(
+      fallback_allocations_.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  blocks_.store(blocks_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  global_arena_counters.fallback_allocations.fetch_add(
+      1, std::memory_order_relaxed);
+  if (spare_ != nullptr && n <= spare_->size() - kBlockHeaderSize) {
+    // Continue in the next block kept by ResetAndRetainBlocks().
+    Block* b = spare_;
+    spare_ = b->next();
+    head_ = new (b) Block(b->size(), head_, false, false);
+  } else {
+    head_ = NewBlock(head_, n, arena_);
+  }
   ptr_ = head_->Pointer(head_->pos());
   limit_ = head_->Pointer(head_->size());
 
@@ -345,6 +461,35 @@ uint64 ArenaImpl::SpaceUsed() const {
   return space_used;
 }
 
+ArenaStats ArenaImpl::GetStats() const {
+  ArenaStats stats;
+  SerialArena* serial = threads_.load(std::memory_order_acquire);
+  for (; serial; serial = serial->next()) {
+    serial->AddStats(&stats);
+  }
+  // Remove the overhead of Options structure, if any.
+  if (options_) {
+    stats.space_used -= kOptionsSize;
+  }
+  stats.space_allocated = SpaceAllocated();
+  return stats;
+}
+
+void SerialArena::AddStats(ArenaStats* stats) const {
+  stats->space_used += SpaceUsed();
+  stats->blocks += blocks_.load(std::memory_order_relaxed);
+  stats->fallback_allocations +=
+      fallback_allocations_.load(std::memory_order_relaxed);
+  stats->serial_arenas++;
+  if (cleanup_ != nullptr) {
+    // Same walk as CleanupListFallback(): only the first chunk can be partial.
+    stats->cleanup_nodes += cleanup_ptr_ - &cleanup_->nodes[0];
+    for (CleanupChunk* list = cleanup_->next; list; list = list->next) {
+      stats->cleanup_nodes += list->size;
+    }
+  }
+}
+
 uint64 SerialArena::SpaceUsed() const {
   // Get current block's size from ptr_ (since we can't trust head_->pos().
   uint64 space_used = ptr_ - head_->Pointer(kBlockHeaderSize);
@@ -401,6 +546,9 @@ SerialArena* SerialArena::New(Block* b, void* owner, ArenaImpl* arena) {
   serial->arena_ = arena;
   serial->owner_ = owner;
   serial->head_ = b;
+  serial->spare_ = NULL;
+  serial->blocks_.store(1, std::memory_order_relaxed);
+  serial->fallback_allocations_.store(0, std::memory_order_relaxed);
   serial->ptr_ = b->Pointer(b->pos());
   serial->limit_ = b->Pointer(b->size());
   serial->cleanup_ = NULL;
@@ -438,8 +586,148 @@ SerialArena* ArenaImpl::GetSerialArenaFallback(void* me) {
 
 ArenaMetricsCollector::~ArenaMetricsCollector() {}
 
+namespace {
+
+// Per-thread storage behind ArenaBlockCache. Free blocks are linked through
+// their first word, so an empty cache costs nothing but the table itself.
+class BlockFreeList {
+ public:
+  // Size classes 2^kMinSizeClass .. ArenaBlockCache::kMaxCachedBlockSize.
+  static constexpr int kMinSizeClass = 4;
+  static constexpr int kNumSizeClasses = 17;
+  static_assert((size_t{1} << (kMinSizeClass + kNumSizeClasses - 1)) ==
+                    ArenaBlockCache::kMaxCachedBlockSize,
+                "Size classes must cover the cacheable block sizes.");
+
+  BlockFreeList() : cached_bytes_(0) {
+    for (int i = 0; i < kNumSizeClasses; i++) {
+      heads_[i] = nullptr;
+      counts_[i] = 0;
+    }
+  }
+  ~BlockFreeList() { Flush(); }
+
+  // Returns the size class of `size`, or -1 if blocks of that size are never
+  // cached.
+  static int SizeClass(size_t size) {
+    if (size < (size_t{1} << kMinSizeClass) ||
+        size > ArenaBlockCache::kMaxCachedBlockSize ||
+        (size & (size - 1)) != 0) {
+      return -1;
+    }
+    return Bits::Log2FloorNonZero64(size) - kMinSizeClass;
+  }
+
+  void* Pop(int size_class) {
+    FreeBlock* b = heads_[size_class];
+    if (b == nullptr) return nullptr;
+    heads_[size_class] = b->next;
+    counts_[size_class]--;
+    cached_bytes_ -= SizeOfClass(size_class);
+    return b;
+  }
+
+  bool Push(int size_class, void* block) {
+    size_t size = SizeOfClass(size_class);
+    if (counts_[size_class] >= ArenaBlockCache::kMaxBlocksPerSizeClass ||
+        cached_bytes_ + size > ArenaBlockCache::kMaxCachedBytes) {
+      return false;
+    }
+    FreeBlock* b = static_cast<FreeBlock*>(block);
+    b->next = heads_[size_class];
+    heads_[size_class] = b;
+    counts_[size_class]++;
+    cached_bytes_ += size;
+    return true;
+  }
+
+  void Flush() {
+    for (int i = 0; i < kNumSizeClasses; i++) {
+      while (heads_[i] != nullptr) {
+        FreeBlock* b = heads_[i];
+        heads_[i] = b->next;
+        ArenaFree(b, SizeOfClass(i));
+      }
+      counts_[i] = 0;
+    }
+    cached_bytes_ = 0;
+  }
+
+  size_t cached_bytes() const { return cached_bytes_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static size_t SizeOfClass(int size_class) {
+    return size_t{1} << (size_class + kMinSizeClass);
+  }
+
+  FreeBlock* heads_[kNumSizeClasses];
+  size_t counts_[kNumSizeClasses];
+  size_t cached_bytes_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(BlockFreeList);
+};
+
+BlockFreeList* ThreadBlockFreeList() {
+#if defined(GOOGLE_PROTOBUF_NO_THREADLOCAL)
+  static internal::ThreadLocalStorage<BlockFreeList>* free_list =
+      new internal::ThreadLocalStorage<BlockFreeList>();
+  return free_list->Get();
+#else
+  // The cache owns memory, so it needs a destructor at thread exit; that
+  // rules out PROTOBUF_THREAD_LOCAL, which must hold trivial types.
+  static thread_local BlockFreeList free_list;
+  return &free_list;
+#endif
+}
+
+}  // namespace
+
 }  // namespace internal
 
+void* ArenaBlockCache::Allocate(size_t size) {
+  int size_class = internal::BlockFreeList::SizeClass(size);
+  if (size_class >= 0) {
+    void* mem = internal::ThreadBlockFreeList()->Pop(size_class);
+    if (mem != nullptr) return mem;
+  }
+  return ::operator new(size);
+}
+
+void ArenaBlockCache::Deallocate(void* block, size_t size) {
+  int size_class = internal::BlockFreeList::SizeClass(size);
+  if (size_class >= 0 &&
+      internal::ThreadBlockFreeList()->Push(size_class, block)) {
+    return;
+  }
+  internal::ArenaFree(block, size);
+}
+
+void ArenaBlockCache::Flush() { internal::ThreadBlockFreeList()->Flush(); }
+
+size_t ArenaBlockCache::CachedBytes() {
+  return internal::ThreadBlockFreeList()->cached_bytes();
+}
+
+namespace arena_metrics {
+
+GlobalArenaStats GetGlobalArenaStats() {
+  const internal::GlobalArenaCounters& c = internal::global_arena_counters;
+  GlobalArenaStats stats;
+  stats.arena_cycles = c.arena_cycles.load(std::memory_order_relaxed);
+  stats.blocks_allocated = c.blocks_allocated.load(std::memory_order_relaxed);
+  stats.bytes_allocated = c.bytes_allocated.load(std::memory_order_relaxed);
+  stats.bytes_freed = c.bytes_freed.load(std::memory_order_relaxed);
+  stats.fallback_allocations =
+      c.fallback_allocations.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace arena_metrics
+
 PROTOBUF_FUNC_ALIGN(32)
 void* Arena::AllocateAlignedNoHook(size_t n) {
   return impl_.AllocateAligned(n);
@@ -82,6 +82,10 @@ namespace arena_metrics {
 
 void EnableArenaMetrics(ArenaOptions* options);
 
+// Returns a snapshot of the counters shared by all arenas in the process.
+// Cheap enough to be scraped periodically by a metrics exporter.
+PROTOBUF_EXPORT GlobalArenaStats GetGlobalArenaStats();
+
 }  // namespace arena_metrics
 
 namespace internal {
@@ -168,6 +172,44 @@ struct ArenaOptions {
   friend class internal::ArenaImpl;
 };
 
+// ArenaBlockCache keeps a per-thread free list of arena blocks so that arenas
+// with short, repeated lifetimes (e.g. one arena per RPC) stop going to the
+// system allocator for every block. It is opt-in: install it as the block
+// allocator of the arenas that should share it.
+//
+//   ArenaOptions options;
+//   options.block_alloc = &ArenaBlockCache::Allocate;
+//   options.block_dealloc = &ArenaBlockCache::Deallocate;
+//   Arena arena(options);
+//
+// Blocks are grouped in size classes following the doubling sequence used by
+// the arena (powers of two up to kMaxCachedBlockSize); blocks of any other
+// size are passed straight through to ::operator new / delete. A block
+// released on one thread is cached on that thread, and each thread frees its
+// cached blocks when it exits.
+class PROTOBUF_EXPORT ArenaBlockCache {
+ public:
+  // Largest block size that is retained in the cache.
+  static const size_t kMaxCachedBlockSize = 1 << 20;
+  // Maximum number of blocks kept per size class, per thread.
+  static const size_t kMaxBlocksPerSizeClass = 16;
+  // Maximum total bytes kept per thread.
+  static const size_t kMaxCachedBytes = 4 << 20;
+
+  // block_alloc / block_dealloc compatible entry points.
+  static void* Allocate(size_t size);
+  static void Deallocate(void* block, size_t size);
+
+  // Frees every block cached by the calling thread.
+  static void Flush();
+
+  // Returns the number of bytes currently cached by the calling thread.
+  static size_t CachedBytes();
+
+ private:
+  ArenaBlockCache() = delete;
+};
+
 // Support for non-RTTI environments. (The metrics hooks API uses type
 // information.)
 #if PROTOBUF_RTTI
@@ -326,6 +368,12 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // the call to this method.
   uint64 SpaceUsed() const { return impl_.SpaceUsed(); }
 
+  // Returns allocation counters for this arena, summed over the per-thread
+  // SerialArenas. space_used and cleanup_nodes are computed like SpaceUsed()
+  // rather than counted, and may not include allocations made concurrently
+  // by other threads.
+  ArenaStats GetStats() const { return impl_.GetStats(); }
+
   // Frees all storage allocated by this arena after calling destructors
   // registered with OwnDestructor() and freeing objects registered with Own().
   // Any objects allocated on this arena are unusable after this call. It also
@@ -333,6 +381,15 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // of the allocated blocks. This method is not thread-safe.
   uint64 Reset() { return impl_.Reset(); }
 
+  // Like Reset(), but instead of freeing every block it keeps up to
+  // |max_blocks| (at most 16) of the largest ones, totalling at most
+  // |max_bytes|, and starts the next allocation cycle in them. A long-lived
+  // arena that is reset between requests this way reaches a steady state in
+  // which it no longer allocates blocks. Returns the same value as Reset().
+  uint64 ResetAndRetainBlocks(size_t max_blocks, size_t max_bytes) {
+    return impl_.ResetAndRetainBlocks(max_blocks, max_bytes);
+  }
+
   // Adds |object| to a list of heap-allocated objects to be freed with |delete|
   // when the arena is destroyed or reset.
   template <typename T>
@@ -565,6 +622,18 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
     return static_cast<T*>(AllocateAlignedTo<alignof(T)>(n));
   }
 
+  // Constructs |num_elements| arena messages of type T back to back in a
+  // single allocation. Used by RepeatedPtrField to lay out its elements
+  // contiguously.
+  template <typename T>
+  T* CreateMessageArrayInternal(size_t num_elements) {
+    T* elements = CreateInternalRawArray<T>(num_elements);
+    for (size_t i = 0; i < num_elements; i++) {
+      CreateInArenaStorage(elements + i, this);
+    }
+    return elements;
+  }
+
   template <typename T, typename... Args>
   PROTOBUF_ALWAYS_INLINE T* DoCreate(bool skip_explicit_ownership,
                                      Args&&... args) {
@@ -51,6 +51,31 @@ namespace protobuf {
 
 struct ArenaOptions;
 
+// Allocation counters of a single arena, see Arena::GetStats().
+struct ArenaStats {
+  uint64 space_allocated = 0;  // Total size of the blocks.
+  // Bytes handed out, excluding overhead. Unlike the counters below this is
+  // not tracked as allocations happen but computed like SpaceUsed(), from the
+  // allocation pointer and block list of each SerialArena.
+  uint64 space_used = 0;
+  uint64 blocks = 0;           // Number of blocks.
+  uint64 cleanup_nodes = 0;    // Registered destructors and Own()ed objects.
+  // Allocations that did not fit in the current block and had to take the
+  // slow path to switch to a new one.
+  uint64 fallback_allocations = 0;
+  uint64 serial_arenas = 0;    // Number of threads that allocated.
+};
+
+// Process-wide counters shared by all arenas, see
+// arena_metrics::GetGlobalArenaStats().
+struct GlobalArenaStats {
+  uint64 arena_cycles = 0;          // Arena constructions plus resets.
+  uint64 blocks_allocated = 0;      // Blocks requested from block_alloc.
+  uint64 bytes_allocated = 0;       // Bytes requested from block_alloc.
+  uint64 bytes_freed = 0;           // Bytes returned through block_dealloc.
+  uint64 fallback_allocations = 0;  // Sum of ArenaStats::fallback_allocations.
+};
+
 namespace internal {
 
 inline size_t AlignUpTo8(size_t n) {
@@ -76,6 +101,11 @@ class PROTOBUF_EXPORT ArenaMetricsCollector {
   // space_allocated is the space used by the arena just before the reset.
   virtual void OnReset(uint64 space_allocated) = 0;
 
+  // OnRetain() is called after a reset that kept blocks for reuse
+  // (Arena::ResetAndRetainBlocks()). retained_bytes is the total size of the
+  // blocks carried over into the next cycle, including the initial block.
+  virtual void OnRetain(uint64 retained_bytes) {}
+
   // Does OnAlloc() need to be called?  If false, metric collection overhead
   // will be reduced since we will not do extra work per allocation.
   virtual bool RecordAllocs() = 0;
@@ -153,6 +183,12 @@ class PROTOBUF_EXPORT SerialArena {
   void CleanupList();
   uint64 SpaceUsed() const;
 
+  // Adds the counters of this SerialArena to *stats. Only blocks and
+  // fallback_allocations are atomic counters; space_used and cleanup_nodes
+  // are computed from the owning thread's unsynchronized state, like
+  // SpaceUsed(), and may lag behind allocations it makes concurrently.
+  void AddStats(ArenaStats* stats) const;
+
   bool HasSpace(size_t n) { return n <= static_cast<size_t>(limit_ - ptr_); }
 
   void* AllocateAligned(size_t n) {
@@ -200,6 +236,10 @@ class PROTOBUF_EXPORT SerialArena {
   }
 
   Block* head() const { return head_; }
+  // Blocks kept by a retaining reset that this arena has not started using
+  // yet, largest first.
+  Block* spare() const { return spare_; }
+  void set_spare(Block* spare) { spare_ = spare; }
   void* owner() const { return owner_; }
   SerialArena* next() const { return next_; }
   void set_next(SerialArena* next) { next_ = next; }
@@ -226,6 +266,7 @@ class PROTOBUF_EXPORT SerialArena {
   ArenaImpl* arena_;       // Containing arena.
   void* owner_;            // &ThreadCache of this thread;
   Block* head_;            // Head of linked list of blocks.
+  Block* spare_;           // Retained blocks to use before allocating more.
   CleanupChunk* cleanup_;  // Head of cleanup list.
   SerialArena* next_;      // Next SerialArena in this linked list.
 
@@ -239,6 +280,11 @@ class PROTOBUF_EXPORT SerialArena {
   CleanupNode* cleanup_ptr_;
   CleanupNode* cleanup_limit_;
 
+  // Only written by the owning thread, and only on slow paths, so they cost a
+  // plain store; atomics let other threads sample them.
+  std::atomic<uint64> blocks_;
+  std::atomic<uint64> fallback_allocations_;
+
   void* AllocateAlignedFallback(size_t n);
   void AddCleanupFallback(void* elem, void (*cleanup)(void*));
   void CleanupListFallback();
@@ -281,8 +327,17 @@ class PROTOBUF_EXPORT ArenaImpl {
 
   uint64 Reset();
 
+  // Like Reset(), but keeps up to max_blocks of the largest blocks, with a
+  // total size of at most max_bytes, and makes the calling thread allocate
+  // from them before asking block_alloc for more.
+  uint64 ResetAndRetainBlocks(size_t max_blocks, size_t max_bytes);
+
+  // Upper bound on the max_blocks argument of ResetAndRetainBlocks().
+  static const size_t kMaxRetainedBlocks = 16;
+
   uint64 SpaceAllocated() const;
   uint64 SpaceUsed() const;
+  ArenaStats GetStats() const;
 
   void* AllocateAligned(size_t n) {
     SerialArena* arena;
@@ -361,11 +416,18 @@ class PROTOBUF_EXPORT ArenaImpl {
       // fn() may delete blocks and arenas, so fetch next pointers before fn();
       SerialArena* cur = serial;
       serial = serial->next();
+      // cur lives in one of its own blocks, so read spare() up front too.
+      auto* spare = cur->spare();
       for (auto* block = cur->head(); block != nullptr;) {
         auto* b = block;
         block = b->next();
         fn(b);
       }
+      for (auto* block = spare; block != nullptr;) {
+        auto* b = block;
+        block = b->next();
+        fn(b);
+      }
     }
   }
 
@@ -42,6 +42,7 @@
 #include <google/protobuf/stubs/logging.h>
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/arena_test_util.h>
+#include <google/protobuf/arenastring.h>
 #include <google/protobuf/test_util.h>
 #include <google/protobuf/unittest.pb.h>
 #include <google/protobuf/unittest_arena.pb.h>
@@ -1141,6 +1142,24 @@ TEST(ArenaTest, ParseCorruptedString) {
   TestParseCorruptedString<TestAllTypes, false>(message);
 }
 
+TEST(ArenaTest, SerializeToArenaString) {
+  Arena arena;
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  internal::ArenaStringPtr field;
+  field.UnsafeSetDefault(&internal::GetEmptyString());
+  ASSERT_TRUE(internal::SerializeToArenaString(message, &field, &arena));
+  EXPECT_EQ(message.SerializeAsString(), field.Get());
+
+  // Serializing again reuses the string the arena already owns.
+  const std::string* output = &field.Get();
+  message.clear_repeated_string();
+  ASSERT_TRUE(internal::SerializeToArenaString(message, &field, &arena));
+  EXPECT_EQ(output, &field.Get());
+  EXPECT_EQ(message.SerializeAsString(), field.Get());
+}
+
 #if PROTOBUF_RTTI
 // Test construction on an arena via generic MessageLite interface. We should be
 // able to successfully deserialize on the arena without incurring heap
@@ -1241,6 +1260,36 @@ TEST(ArenaTest, BlockSizeDoubling) {
   EXPECT_EQ(second_block_size, 2*first_block_size);
 }
 
+TEST(ArenaTest, GetStats) {
+  GlobalArenaStats global_before = arena_metrics::GetGlobalArenaStats();
+  {
+    Arena arena;
+    ArenaStats stats = arena.GetStats();
+    EXPECT_EQ(0, stats.serial_arenas);
+    EXPECT_EQ(0, stats.blocks);
+
+    for (int i = 0; i < 200; i++) {
+      Arena::CreateArray<char>(&arena, 64);
+    }
+    for (int i = 0; i < 10; i++) {
+      arena.Own(new int);
+    }
+    stats = arena.GetStats();
+    EXPECT_EQ(1, stats.serial_arenas);
+    EXPECT_EQ(arena.SpaceAllocated(), stats.space_allocated);
+    EXPECT_EQ(arena.SpaceUsed(), stats.space_used);
+    EXPECT_EQ(10, stats.cleanup_nodes);
+    EXPECT_GT(stats.blocks, 1);
+    // Every block but the first one was reached through the fallback path.
+    EXPECT_EQ(stats.blocks - 1, stats.fallback_allocations);
+  }
+  GlobalArenaStats global_after = arena_metrics::GetGlobalArenaStats();
+  EXPECT_GT(global_after.arena_cycles, global_before.arena_cycles);
+  EXPECT_GT(global_after.blocks_allocated, global_before.blocks_allocated);
+  EXPECT_EQ(global_after.bytes_allocated - global_before.bytes_allocated,
+            global_after.bytes_freed - global_before.bytes_freed);
+}
+
 TEST(ArenaTest, Alignment) {
   Arena arena;
   for (int i = 0; i < 200; i++) {
@@ -1265,6 +1314,59 @@ TEST(ArenaTest, BlockSizeSmallerThanAllocation) {
   }
 }
 
+TEST(ArenaTest, BlockCacheRecyclesBlocks) {
+  ArenaBlockCache::Flush();
+  ArenaOptions options;
+  options.block_alloc = &ArenaBlockCache::Allocate;
+  options.block_dealloc = &ArenaBlockCache::Deallocate;
+
+  uint64 space_allocated;
+  {
+    Arena arena(options);
+    for (int i = 0; i < 100; i++) {
+      Arena::CreateArray<char>(&arena, 64);
+    }
+    space_allocated = arena.SpaceAllocated();
+  }
+  // Every block of the default doubling sequence is cacheable.
+  EXPECT_EQ(space_allocated, ArenaBlockCache::CachedBytes());
+
+  {
+    // The same allocation pattern is served entirely from the cache.
+    Arena arena(options);
+    for (int i = 0; i < 100; i++) {
+      Arena::CreateArray<char>(&arena, 64);
+    }
+    EXPECT_EQ(space_allocated, arena.SpaceAllocated());
+    EXPECT_EQ(0, ArenaBlockCache::CachedBytes());
+  }
+  EXPECT_EQ(space_allocated, ArenaBlockCache::CachedBytes());
+
+  ArenaBlockCache::Flush();
+  EXPECT_EQ(0, ArenaBlockCache::CachedBytes());
+}
+
+TEST(ArenaTest, BlockCacheBypassesUncacheableSizes) {
+  ArenaBlockCache::Flush();
+  void* odd = ArenaBlockCache::Allocate(1000);
+  ArenaBlockCache::Deallocate(odd, 1000);
+  EXPECT_EQ(0, ArenaBlockCache::CachedBytes());
+
+  size_t huge = ArenaBlockCache::kMaxCachedBlockSize * 2;
+  void* big = ArenaBlockCache::Allocate(huge);
+  ArenaBlockCache::Deallocate(big, huge);
+  EXPECT_EQ(0, ArenaBlockCache::CachedBytes());
+
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < ArenaBlockCache::kMaxBlocksPerSizeClass + 4; i++) {
+    blocks.push_back(ArenaBlockCache::Allocate(256));
+  }
+  for (void* b : blocks) ArenaBlockCache::Deallocate(b, 256);
+  EXPECT_EQ(ArenaBlockCache::kMaxBlocksPerSizeClass * 256,
+            ArenaBlockCache::CachedBytes());
+  ArenaBlockCache::Flush();
+}
+
 TEST(ArenaTest, GetArenaShouldReturnTheArenaForArenaAllocatedMessages) {
   Arena arena;
   ArenaMessage* message = Arena::CreateMessage<ArenaMessage>(&arena);
@@ -1321,12 +1423,14 @@ uint32 hooks_num_init = 0;
 uint32 hooks_num_allocations = 0;
 uint32 hooks_num_reset = 0;
 uint32 hooks_num_destruct = 0;
+uint64 hooks_retained_bytes = 0;
 
 void ClearHookCounts() {
   hooks_num_init = 0;
   hooks_num_allocations = 0;
   hooks_num_reset = 0;
   hooks_num_destruct = 0;
+  hooks_retained_bytes = 0;
 }
 }  // namespace
 
@@ -1360,6 +1464,9 @@ class ArenaOptionsTestFriend : public internal::ArenaMetricsCollector {
     delete this;
   }
   void OnReset(uint64 space_allocated) override { ++hooks_num_reset; }
+  void OnRetain(uint64 retained_bytes) override {
+    hooks_retained_bytes = retained_bytes;
+  }
   bool RecordAllocs() override { return record_allocs_; }
   void OnAlloc(const std::type_info* allocated_type,
                uint64 alloc_size) override {
@@ -1405,6 +1512,46 @@ TEST(ArenaTest, ArenaHooksWhenAllocationsNotNeeded) {
   EXPECT_EQ(0, hooks_num_allocations);
 }
 
+TEST(ArenaTest, ResetAndRetainBlocks) {
+  Arena arena;
+  for (int i = 0; i < 200; i++) {
+    Arena::CreateArray<char>(&arena, 64);
+  }
+  uint64 space_allocated = arena.SpaceAllocated();
+  EXPECT_EQ(space_allocated, arena.ResetAndRetainBlocks(16, 1 << 20));
+  // Every block fits in the limits, so all of them are carried over.
+  EXPECT_EQ(space_allocated, arena.SpaceAllocated());
+  EXPECT_EQ(0, arena.SpaceUsed());
+
+  // A smaller cycle runs entirely in the retained blocks.
+  for (int i = 0; i < 100; i++) {
+    Arena::CreateArray<char>(&arena, 64);
+  }
+  EXPECT_EQ(space_allocated, arena.SpaceAllocated());
+  EXPECT_EQ(6400, arena.SpaceUsed());
+
+  // Only the two largest blocks survive, then nothing.
+  arena.ResetAndRetainBlocks(2, 1 << 20);
+  EXPECT_EQ(8192 + 4096, arena.SpaceAllocated());
+  arena.Reset();
+  EXPECT_EQ(0, arena.SpaceAllocated());
+}
+
+TEST(ArenaTest, ResetAndRetainBlocksRespectsByteBudget) {
+  ArenaOptions options;
+  ArenaOptionsTestFriend::EnableWithoutAllocs(&options);
+  Arena arena(options);
+  for (int i = 0; i < 200; i++) {
+    Arena::CreateArray<char>(&arena, 64);
+  }
+  arena.ResetAndRetainBlocks(16, options.max_block_size);
+  // The special block holding the options is always kept.
+  EXPECT_EQ(options.start_block_size + options.max_block_size,
+            arena.SpaceAllocated());
+  EXPECT_EQ(arena.SpaceAllocated(), hooks_retained_bytes);
+  EXPECT_EQ(1, hooks_num_reset);
+}
+
 
 }  // namespace protobuf
 }  // namespace google
@@ -47,6 +47,26 @@ namespace google {
 namespace protobuf {
 namespace internal {
 
+namespace {
+
+// Returns true if a std::string holding `size` bytes keeps them in its inline
+// (SSO) buffer. Such a string owns no heap memory, so skipping its destructor
+// leaks nothing. Only enabled for standard libraries where that is known to
+// hold.
+inline bool FitsInInlineBuffer(size_t size) {
+#if defined(_LIBCPP_VERSION)
+  return size <= sizeof(std::string) - 2;
+#elif defined(_GLIBCXX_USE_CXX11_ABI) && _GLIBCXX_USE_CXX11_ABI && \
+    !defined(_GLIBCXX_DEBUG)
+  return size <= 15;
+#else
+  (void)size;
+  return false;
+#endif
+}
+
+}  // namespace
+
 const std::string& LazyString::Init() const {
   static WrappedMutex mu{GOOGLE_PROTOBUF_LINKER_INITIALIZED};
   mu.Lock();
@@ -62,18 +82,42 @@ const std::string& LazyString::Init() const {
 }
 
 
+std::string* ArenaStringPtr::NewDonatedString(::google::protobuf::Arena* arena) {
+  GOOGLE_DCHECK(arena != nullptr);
+  void* mem = arena->AllocateAlignedTo<alignof(std::string)>(sizeof(std::string));
+  std::string* s = new (mem) std::string();
+  tagged_ptr_.SetTagged(s);
+  return s;
+}
+
+std::string* ArenaStringPtr::OwnDonatedString(::google::protobuf::Arena* arena) {
+  GOOGLE_DCHECK(IsDonatedString());
+  GOOGLE_DCHECK(arena != nullptr);
+  std::string* s = tagged_ptr_.Get();
+  arena->OwnDestructor(s);
+  tagged_ptr_.Set(s);
+  return s;
+}
+
 void ArenaStringPtr::Set(const std::string* default_value,
                          ConstStringParam value, ::google::protobuf::Arena* arena) {
-  if (IsDefault(default_value)) {
+  if (IsDefault(default_value) &&
+      (arena == nullptr || !FitsInInlineBuffer(value.length()))) {
     tagged_ptr_.Set(Arena::Create<std::string>(arena, value));
   } else {
-    UnsafeMutablePointer()->assign(value.data(), value.length());
+    MutableNoCopy(default_value, value.length(), arena)
+        ->assign(value.data(), value.length());
   }
 }
 
 void ArenaStringPtr::Set(const std::string* default_value, std::string&& value,
                          ::google::protobuf::Arena* arena) {
-  if (IsDefault(default_value)) {
+  if (arena != nullptr && FitsInInlineBuffer(value.length()) &&
+      (IsDefault(default_value) || IsDonatedString())) {
+    // Moving a short string copies it anyway; keep it off the cleanup list.
+    MutableNoCopy(default_value, value.length(), arena)
+        ->assign(value.data(), value.length());
+  } else if (IsDefault(default_value)) {
     if (arena == nullptr) {
       tagged_ptr_.Set(new std::string(std::move(value)));
     } else {
@@ -130,6 +174,8 @@ std::string* ArenaStringPtr::MutableNoCopy(const std::string* default_value,
                                            ::google::protobuf::Arena* arena) {
   if (!IsDonatedString() && !IsDefault(default_value)) {
     return UnsafeMutablePointer();
+  } else if (IsDonatedString()) {
+    return OwnDonatedString(arena);
   } else {
     GOOGLE_DCHECK(IsDefault(default_value));
     // Allocate empty. The contents are not relevant.
@@ -139,9 +185,24 @@ std::string* ArenaStringPtr::MutableNoCopy(const std::string* default_value,
   }
 }
 
+std::string* ArenaStringPtr::MutableNoCopy(const std::string* default_value,
+                                           size_t size,
+                                           ::google::protobuf::Arena* arena) {
+  if (arena == nullptr || !FitsInInlineBuffer(size)) {
+    return MutableNoCopy(default_value, arena);
+  } else if (IsDonatedString()) {
+    return tagged_ptr_.Get();
+  } else if (IsDefault(default_value)) {
+    return NewDonatedString(arena);
+  } else {
+    return UnsafeMutablePointer();
+  }
+}
+
 template <typename... Lazy>
 std::string* ArenaStringPtr::MutableSlow(::google::protobuf::Arena* arena,
                                          const Lazy&... lazy_default) {
+  if (IsDonatedString()) return OwnDonatedString(arena);
   const std::string* const default_value =
       sizeof...(Lazy) == 0 ? &GetEmptyStringAlreadyInited() : nullptr;
   GOOGLE_DCHECK(IsDefault(default_value));
@@ -240,11 +301,11 @@ void ArenaStringPtr::ClearToEmpty() {
 
 void ArenaStringPtr::ClearToDefault(const LazyString& default_value,
                                     ::google::protobuf::Arena* arena) {
-  (void)arena;
   if (IsDefault(nullptr)) {
     // Already set to default -- do nothing.
-  } else if (!IsDonatedString()) {
-    UnsafeMutablePointer()->assign(default_value.get());
+  } else {
+    const std::string& value = default_value.get();
+    MutableNoCopy(nullptr, value.size(), arena)->assign(value);
   }
 }
 
@@ -137,7 +137,11 @@ static_assert(std::is_trivial<TaggedPtr<std::string>>::value,
 //   free()/destructor-call list) as appropriate.
 //
 // - Pointer set to 'DonatedString' tag (LSB is 1): points to a std::string
-//   instance with a buffer on the arena (arena != NULL, always, in this case).
+//   instance on the arena (arena != NULL, always, in this case) whose value
+//   fits in the std::string's inline buffer. No destructor is registered for
+//   it, since such a string owns no heap memory. Before anything can make the
+//   value outgrow the inline buffer, the destructor is registered and the tag
+//   is cleared.
 //
 // For fields with a non-empty string default value, there are three distinct
 // states:
@@ -152,8 +156,7 @@ static_assert(std::is_trivial<TaggedPtr<std::string>>::value,
 //   either on the heap or on the arena (i.e. registered on
 //   free()/destructor-call list) as appropriate.
 //
-// - Pointer set to 'DonatedString' tag (LSB is 1): points to a std::string
-//   instance with a buffer on the arena (arena != NULL, always, in this case).
+// - Pointer set to 'DonatedString' tag (LSB is 1): as above.
 //
 // Generated code and reflection code both ensure that ptr_ is never null for
 // fields with an empty default.
@@ -263,6 +266,13 @@ struct PROTOBUF_EXPORT ArenaStringPtr {
   std::string* MutableNoCopy(const std::string* default_value,
                              ::google::protobuf::Arena* arena);
 
+  // Like `MutableNoCopy`, but the caller promises to store at most `size`
+  // bytes in the returned string. Used by the parser, which knows the length
+  // of the value up front; on an arena, short values then need no destructor
+  // registration.
+  std::string* MutableNoCopy(const std::string* default_value, size_t size,
+                             ::google::protobuf::Arena* arena);
+
   // Destroy the string. Assumes `arena == nullptr`.
   void DestroyNoArena(const std::string* default_value);
 
@@ -287,7 +297,15 @@ struct PROTOBUF_EXPORT ArenaStringPtr {
  private:
   TaggedPtr<std::string> tagged_ptr_;
 
-  bool IsDonatedString() const { return false; }
+  bool IsDonatedString() const { return tagged_ptr_.IsTagged(); }
+
+  // Allocates an empty std::string on `arena` without registering its
+  // destructor and stores it as a donated string.
+  std::string* NewDonatedString(::google::protobuf::Arena* arena);
+
+  // Registers the destructor of the donated string and clears the tag, so the
+  // string may grow freely afterwards.
+  std::string* OwnDonatedString(::google::protobuf::Arena* arena);
 
   // Slow paths.
 
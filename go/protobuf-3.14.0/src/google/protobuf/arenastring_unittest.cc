@@ -170,6 +170,54 @@ TEST(ArenaStringPtrTest, ArenaStringPtrOnArenaNoSSO) {
   field3.Destroy(nullptr, &arena);
 }
 
+TEST(ArenaStringPtrTest, ArenaStringPtrOnArenaShortValues) {
+  Arena arena;
+  const std::string* empty_default = &internal::GetEmptyString();
+  const uint64 cleanup_nodes = arena.GetStats().cleanup_nodes;
+
+  ArenaStringPtr field;
+  field.UnsafeSetDefault(empty_default);
+  field.Set(empty_default, WrapString("short"), &arena);
+  EXPECT_EQ(std::string("short"), field.Get());
+  field.Set(empty_default, std::string("tiny"), &arena);
+  EXPECT_EQ(std::string("tiny"), field.Get());
+
+  ArenaStringPtr field2;
+  field2.UnsafeSetDefault(empty_default);
+  std::string* mut = field2.MutableNoCopy(empty_default, 3, &arena);
+  mut->assign("abc");
+  EXPECT_EQ(mut, &field2.Get());
+  EXPECT_EQ(std::string("abc"), field2.Get());
+
+  ArenaStringPtr field3;
+  field3.UnsafeSetDefault(nullptr);
+  field3.Set(nullptr, WrapString("short"), &arena);
+  field3.ClearToDefault(nonempty_default, &arena);
+  EXPECT_EQ(std::string("default"), field3.Get());
+
+#if defined(_LIBCPP_VERSION) || \
+    (defined(_GLIBCXX_USE_CXX11_ABI) && _GLIBCXX_USE_CXX11_ABI)
+  // Values that fit in the inline buffer need no destructor.
+  EXPECT_EQ(cleanup_nodes, arena.GetStats().cleanup_nodes);
+#endif
+
+  // Handing out a mutable pointer lets the value grow past the inline buffer,
+  // so the destructor must be registered first.
+  mut = field.Mutable(EmptyDefault{}, &arena);
+  EXPECT_EQ(mut, &field.Get());
+  EXPECT_EQ(std::string("tiny"), *mut);
+  *mut = "Test long long long long value";  // ensure string allocates storage
+  EXPECT_EQ(std::string("Test long long long long value"), field.Get());
+  field2.Set(empty_default, WrapString("Test long long long long value"),
+             &arena);
+  EXPECT_EQ(std::string("Test long long long long value"), field2.Get());
+  EXPECT_LT(cleanup_nodes, arena.GetStats().cleanup_nodes);
+
+  std::string* released = field3.Release(nullptr, &arena);
+  EXPECT_EQ(std::string("default"), *released);
+  delete released;
+}
+
 
 }  // namespace protobuf
 }  // namespace google
@@ -0,0 +1,146 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/compiler/access_info_map.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+
+AccessInfoMap::AccessInfoMap() {}
+AccessInfoMap::~AccessInfoMap() {}
+
+bool AccessInfoMap::Parse(StringPiece text, std::string* error) {
+  struct Entry {
+    std::string name;
+    Counts counts;
+  };
+  std::vector<Entry> entries;
+
+  std::vector<std::string> lines = Split(text, "\n", false);
+  for (int i = 0; i < lines.size(); i++) {
+    StringPiece line = lines[i];
+    StringPiece::size_type comment = line.find('#');
+    if (comment != StringPiece::npos) line = line.substr(0, comment);
+    std::vector<std::string> parts = Split(line, " \t\r", true);
+    if (parts.empty()) continue;
+
+    Entry entry;
+    entry.name = parts[0];
+    bool ok = parts.size() >= 2 && parts.size() <= 3 &&
+              entry.name.find('.') != std::string::npos &&
+              safe_strtou64(parts[1], &entry.counts.hot) &&
+              (parts.size() == 2 ||
+               safe_strtou64(parts[2], &entry.counts.cold));
+    if (!ok) {
+      *error = StrCat("line ", i + 1,
+                      ": expected \"<field name> <hot count> [<cold count>]\", "
+                      "got \"",
+                      lines[i], "\".");
+      return false;
+    }
+    entries.push_back(std::move(entry));
+  }
+
+  for (const Entry& entry : entries) {
+    Counts& counts = fields_[entry.name];
+    counts.hot += entry.counts.hot;
+    counts.cold += entry.counts.cold;
+    uint64& max_total = max_total_[entry.name.substr(0, entry.name.rfind('.'))];
+    max_total = std::max(max_total, counts.hot + counts.cold);
+  }
+  return true;
+}
+
+bool AccessInfoMap::Load(const std::string& filename, std::string* error) {
+  std::ifstream input(filename.c_str());
+  if (!input) {
+    *error = filename + ": Could not open access profile.";
+    return false;
+  }
+  std::stringstream contents;
+  contents << input.rdbuf();
+  if (!Parse(contents.str(), error)) {
+    *error = filename + ": " + *error;
+    return false;
+  }
+  return true;
+}
+
+bool AccessInfoMap::HasProfile(const Descriptor* message) const {
+  return max_total_.count(message->full_name()) != 0;
+}
+
+const AccessInfoMap::Counts* AccessInfoMap::Find(
+    const FieldDescriptor* field) const {
+  auto it = fields_.find(field->full_name());
+  return it == fields_.end() ? nullptr : &it->second;
+}
+
+uint64 AccessInfoMap::GetHotCount(const FieldDescriptor* field) const {
+  const Counts* counts = Find(field);
+  return counts == nullptr ? 0 : counts->hot;
+}
+
+uint64 AccessInfoMap::GetColdCount(const FieldDescriptor* field) const {
+  const Counts* counts = Find(field);
+  return counts == nullptr ? 0 : counts->cold;
+}
+
+bool AccessInfoMap::IsHot(const FieldDescriptor* field) const {
+  return GetHotCount(field) > 0;
+}
+
+bool AccessInfoMap::IsHot(const Descriptor* message) const {
+  for (int i = 0; i < message->field_count(); i++) {
+    if (IsHot(message->field(i))) return true;
+  }
+  return false;
+}
+
+bool AccessInfoMap::IsCold(const FieldDescriptor* field,
+                           double threshold) const {
+  if (field->containing_type() == nullptr ||
+      !HasProfile(field->containing_type())) {
+    return false;
+  }
+  uint64 max_total = max_total_.at(field->containing_type()->full_name());
+  return GetHotCount(field) + GetColdCount(field) <= threshold * max_total;
+}
+
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,119 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A field access profile for code generators.  The profile records, for each
+// field, how often it was accessed on the hot path of a production binary and
+// how often elsewhere.  The C++ generator uses it to lay out hot fields
+// together at the front of the message and push rarely used fields to the
+// back, where they share cache lines only with each other.
+//
+// The text format is one field per line:
+//
+//   # Comments and blank lines are ignored.
+//   <fully-qualified field name> <hot count> [<cold count>]
+//
+// e.g.
+//
+//   foo.Request.id 1200000 30
+//   foo.Request.debug_info 0 4
+//
+// Counts for the same field are summed, so profiles from several binaries can
+// simply be concatenated.
+
+#ifndef GOOGLE_PROTOBUF_COMPILER_ACCESS_INFO_MAP_H__
+#define GOOGLE_PROTOBUF_COMPILER_ACCESS_INFO_MAP_H__
+
+#include <string>
+#include <unordered_map>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/descriptor.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+
+class PROTOC_EXPORT AccessInfoMap {
+ public:
+  AccessInfoMap();
+  ~AccessInfoMap();
+
+  // Parses a profile in the format above and adds its counts to this map.
+  // On failure, returns false, sets *error and leaves the map unchanged.
+  bool Parse(StringPiece text, std::string* error);
+
+  // Like Parse(), but reads the profile from a file.
+  bool Load(const std::string& filename, std::string* error);
+
+  // Returns true if any field of "message" appears in the profile.  Fields of
+  // messages without a profile are neither hot nor cold, and generators
+  // should keep their default layout.
+  bool HasProfile(const Descriptor* message) const;
+
+  uint64 GetHotCount(const FieldDescriptor* field) const;
+  uint64 GetColdCount(const FieldDescriptor* field) const;
+
+  // Returns true if "field" was accessed on the hot path at all.
+  bool IsHot(const FieldDescriptor* field) const;
+
+  // Returns true if any field of "message" was accessed on the hot path.
+  bool IsHot(const Descriptor* message) const;
+
+  // Returns true if "field" was accessed at most "threshold" times as often as
+  // the most accessed field of the same message, counting both hot and cold
+  // accesses.  Fields missing from a profiled message are cold.
+  bool IsCold(const FieldDescriptor* field, double threshold) const;
+
+ private:
+  struct Counts {
+    uint64 hot = 0;
+    uint64 cold = 0;
+  };
+
+  const Counts* Find(const FieldDescriptor* field) const;
+
+  // Keyed by the field's full name.
+  std::unordered_map<std::string, Counts> fields_;
+  // Largest hot + cold count of any field, keyed by the message's full name.
+  std::unordered_map<std::string, uint64> max_total_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(AccessInfoMap);
+};
+
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_COMPILER_ACCESS_INFO_MAP_H__
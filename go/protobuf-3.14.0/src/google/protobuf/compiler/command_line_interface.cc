@@ -56,7 +56,11 @@
 
 #include <limits.h>  //For PATH_MAX
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <memory>
+#include <thread>
 
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
@@ -108,6 +112,7 @@ using google::protobuf::io::win32::close;
 using google::protobuf::io::win32::mkdir;
 using google::protobuf::io::win32::open;
 using google::protobuf::io::win32::setmode;
+using google::protobuf::io::win32::stat;
 using google::protobuf::io::win32::write;
 #endif
 
@@ -916,6 +921,10 @@ void CommandLineInterface::AllowPlugins(const std::string& exe_name_prefix) {
   plugin_prefix_ = exe_name_prefix;
 }
 
+void CommandLineInterface::SetPerFileGenerator(const std::string& flag_name) {
+  per_file_generators_.insert(flag_name);
+}
+
 namespace {
 
 bool ContainsProto3Optional(const Descriptor* desc) {
@@ -1052,7 +1061,11 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
   GeneratorContextMap output_directories;
 
   // Generate output.
-  if (mode_ == MODE_COMPILE) {
+  if (mode_ == MODE_COMPILE && (jobs_ > 1 || !cache_dir_.empty())) {
+    if (!GenerateOutputInParallel(parsed_files, &output_directories)) {
+      return 1;
+    }
+  } else if (mode_ == MODE_COMPILE) {
     for (int i = 0; i < output_directives_.size(); i++) {
       std::string output_location = output_directives_[i].output_location;
       if (!HasSuffixString(output_location, ".zip") &&
@@ -1351,6 +1364,8 @@ void CommandLineInterface::Clear() {
   direct_dependencies_explicitly_set_ = false;
   allow_proto3_optional_ = false;
   deterministic_output_ = false;
+  jobs_ = 1;
+  cache_dir_.clear();
 }
 
 bool CommandLineInterface::MakeProtoProtoPathRelative(
@@ -1904,6 +1919,27 @@ CommandLineInterface::InterpretArgument(const std::string& name,
   } else if (name == "--deterministic_output") {
     deterministic_output_ = true;
 
+  } else if (name == "--jobs") {
+    if (!safe_strto32(value, &jobs_) || jobs_ < 1) {
+      std::cerr << "--jobs must be a positive number: " << value << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
+  } else if (name == "--cache_dir") {
+    if (!cache_dir_.empty()) {
+      std::cerr << name << " may only be passed once." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << name << " requires a non-empty value." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (!VerifyDirectoryExists(value)) {
+      return PARSE_ARGUMENT_FAIL;
+    }
+    cache_dir_ = value;
+    AddTrailingSlash(&cache_dir_);
+
   } else if (name == "--error_format") {
     if (value == "gcc") {
       error_format_ = ERROR_FORMAT_GCC;
@@ -2109,6 +2145,15 @@ void CommandLineInterface::PrintHelpText() {
          "                              expected by make. This writes the "
          "transitive\n"
          "                              set of input file paths to FILE\n"
+         "  --jobs=N                    Run up to N code generators at once. "
+         "The\n"
+         "                              output is the same as with the "
+         "default, 1.\n"
+         "  --cache_dir=DIR             Keep generated code in DIR and reuse "
+         "it when\n"
+         "                              a generator is run again on the same "
+         "inputs\n"
+         "                              and parameters.\n"
          "  --error_format=FORMAT       Set the format in which to print "
          "errors.\n"
          "                              FORMAT may be 'gcc' (the default) or "
@@ -2202,6 +2247,253 @@ bool CommandLineInterface::EnforceProto3OptionalSupport(
   return true;
 }
 
+namespace {
+
+// A GeneratorContext that keeps everything written to it in memory, so that
+// it can be written to another GeneratorContext later.  --jobs gives each
+// generator run its own RecordingGeneratorContext, then replays them in
+// command-line order so that the output does not depend on thread timing.
+class RecordingGeneratorContext : public GeneratorContext {
+ public:
+  explicit RecordingGeneratorContext(
+      const std::vector<const FileDescriptor*>& parsed_files)
+      : parsed_files_(parsed_files) {}
+
+  // Makes the same calls on target that the generator made on this context,
+  // in the order the generator closed its streams.
+  void Replay(GeneratorContext* target) const;
+
+  // Converts the recording to and from the form plugins reply in, which is
+  // how --cache_dir stores it.  Save() returns false if the generator did
+  // something that form can't express, such as calling OpenForAppend().
+  bool Save(CodeGeneratorResponse* response) const;
+  void Load(const CodeGeneratorResponse& response);
+
+  // implements GeneratorContext --------------------------------------
+  io::ZeroCopyOutputStream* Open(const std::string& filename) override {
+    return Record(Write::OPEN, filename, "", nullptr);
+  }
+  io::ZeroCopyOutputStream* OpenForAppend(
+      const std::string& filename) override {
+    return Record(Write::APPEND, filename, "", nullptr);
+  }
+  io::ZeroCopyOutputStream* OpenForInsert(
+      const std::string& filename,
+      const std::string& insertion_point) override {
+    return Record(Write::INSERT, filename, insertion_point, nullptr);
+  }
+  io::ZeroCopyOutputStream* OpenForInsertWithGeneratedCodeInfo(
+      const std::string& filename, const std::string& insertion_point,
+      const google::protobuf::GeneratedCodeInfo& info) override {
+    return Record(Write::INSERT, filename, insertion_point, &info);
+  }
+  void ListParsedFiles(std::vector<const FileDescriptor*>* output) override {
+    *output = parsed_files_;
+  }
+
+ private:
+  struct Write {
+    enum Kind { OPEN, APPEND, INSERT };
+    Kind kind;
+    std::string filename;
+    std::string insertion_point;
+    std::unique_ptr<GeneratedCodeInfo> info;  // NULL for OpenForInsert().
+    std::string data;
+  };
+
+  // Collects one stream's data, and hands it to the context when closed.
+  class RecordingStream : public io::ZeroCopyOutputStream {
+   public:
+    RecordingStream(RecordingGeneratorContext* context,
+                    std::unique_ptr<Write> write)
+        : context_(context),
+          write_(std::move(write)),
+          inner_(&write_->data) {}
+    ~RecordingStream() override {
+      context_->writes_.push_back(std::move(write_));
+    }
+
+    // implements ZeroCopyOutputStream ---------------------------------
+    bool Next(void** data, int* size) override {
+      return inner_.Next(data, size);
+    }
+    void BackUp(int count) override { inner_.BackUp(count); }
+    int64_t ByteCount() const override { return inner_.ByteCount(); }
+
+   private:
+    RecordingGeneratorContext* context_;
+    std::unique_ptr<Write> write_;
+    io::StringOutputStream inner_;
+  };
+
+  io::ZeroCopyOutputStream* Record(Write::Kind kind,
+                                   const std::string& filename,
+                                   const std::string& insertion_point,
+                                   const GeneratedCodeInfo* info) {
+    std::unique_ptr<Write> write(new Write);
+    write->kind = kind;
+    write->filename = filename;
+    write->insertion_point = insertion_point;
+    if (info != nullptr) write->info.reset(new GeneratedCodeInfo(*info));
+    return new RecordingStream(this, std::move(write));
+  }
+
+  const std::vector<const FileDescriptor*>& parsed_files_;
+  std::vector<std::unique_ptr<Write>> writes_;
+};
+
+void RecordingGeneratorContext::Replay(GeneratorContext* target) const {
+  for (const auto& write : writes_) {
+    std::unique_ptr<io::ZeroCopyOutputStream> output;
+    switch (write->kind) {
+      case Write::OPEN:
+        output.reset(target->Open(write->filename));
+        break;
+      case Write::APPEND:
+        output.reset(target->OpenForAppend(write->filename));
+        break;
+      case Write::INSERT:
+        if (write->info != nullptr) {
+          output.reset(target->OpenForInsertWithGeneratedCodeInfo(
+              write->filename, write->insertion_point, *write->info));
+        } else {
+          output.reset(
+              target->OpenForInsert(write->filename, write->insertion_point));
+        }
+        break;
+    }
+    io::CodedOutputStream coded_output(output.get());
+    coded_output.WriteString(write->data);
+  }
+}
+
+bool RecordingGeneratorContext::Save(CodeGeneratorResponse* response) const {
+  for (const auto& write : writes_) {
+    if (write->kind == Write::APPEND ||
+        (write->kind == Write::INSERT && write->insertion_point.empty())) {
+      return false;
+    }
+    CodeGeneratorResponse::File* file = response->add_file();
+    file->set_name(write->filename);
+    file->set_insertion_point(write->insertion_point);
+    file->set_content(write->data);
+    if (write->info != nullptr) {
+      *file->mutable_generated_code_info() = *write->info;
+    }
+  }
+  return true;
+}
+
+void RecordingGeneratorContext::Load(const CodeGeneratorResponse& response) {
+  for (const CodeGeneratorResponse::File& file : response.file()) {
+    std::unique_ptr<Write> write(new Write);
+    write->kind = file.insertion_point().empty() ? Write::OPEN : Write::INSERT;
+    write->filename = file.name();
+    write->insertion_point = file.insertion_point();
+    if (file.has_generated_code_info()) {
+      write->info.reset(new GeneratedCodeInfo(file.generated_code_info()));
+    }
+    write->data = file.content();
+    writes_.push_back(std::move(write));
+  }
+}
+
+// Describes the file at path well enough to notice when it is replaced,
+// which is how --cache_dir tells generator binaries apart.
+bool GetFileIdentity(const std::string& path, std::string* identity) {
+#ifdef _WIN32
+  struct _stat info;
+#else
+  struct stat info;
+#endif
+  if (stat(path.c_str(), &info) != 0) {
+    return false;
+  }
+  *identity = StrCat(path, ":", static_cast<int64>(info.st_size), ":",
+                     static_cast<int64>(info.st_mtime));
+  return true;
+}
+
+// Returns the name of the --cache_dir entry for key: its 64-bit FNV-1a hash.
+// Entries also hold the whole key, so a collision is only a cache miss.
+std::string CacheEntryName(const std::string& key) {
+  uint64 hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash ^= static_cast<uint8>(c);
+    hash *= 1099511628211ULL;
+  }
+  return StrCat(strings::Hex(hash, strings::ZERO_PAD_16), ".cache");
+}
+
+// Appends the contents of every file named by a parameter value to *key, so
+// that e.g. editing the profile of --cpp_out=access_info_map=foo.profile:out
+// invalidates the entries generated with it.  Values that do not name a
+// regular file are already part of the key as text.
+void AppendParameterFiles(const std::string& parameters, std::string* key) {
+  std::vector<std::pair<std::string, std::string> > options;
+  ParseGeneratorParameter(parameters, &options);
+  for (const auto& option : options) {
+    const std::string& path =
+        option.second.empty() ? option.first : option.second;
+#ifdef _WIN32
+    struct _stat info;
+#else
+    struct stat info;
+#endif
+    if (stat(path.c_str(), &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG) {
+      continue;
+    }
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    StrAppend(key, "\n", path, ":", contents.size());
+    StrAppend(key, ":", contents);
+  }
+}
+
+// A cache entry is the varint-prefixed key followed by the response.
+bool ReadCacheEntry(const std::string& path, const std::string& key,
+                    CodeGeneratorResponse* response) {
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string contents((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(contents.data()),
+                             contents.size());
+  uint32 key_size;
+  std::string stored_key;
+  return input.ReadVarint32(&key_size) &&
+         input.ReadString(&stored_key, key_size) && stored_key == key &&
+         response->ParseFromCodedStream(&input);
+}
+
+// Writes the entry under a temporary name first, so that another protoc
+// sharing the cache never sees half of it.  Failing to write is not an
+// error; the next run just generates the code again.
+void WriteCacheEntry(const std::string& path, const std::string& key,
+                     const CodeGeneratorResponse& response) {
+  std::string entry;
+  {
+    io::StringOutputStream output(&entry);
+    io::CodedOutputStream coded_output(&output);
+    coded_output.WriteVarint32(key.size());
+    coded_output.WriteString(key);
+    response.SerializeToCodedStream(&coded_output);
+  }
+  std::string temp_path = StrCat(
+      path, ".", std::chrono::steady_clock::now().time_since_epoch().count());
+  std::ofstream file(temp_path.c_str(), std::ios::out | std::ios::binary);
+  file.write(entry.data(), entry.size());
+  file.close();
+  if (file.fail() || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+  }
+}
+
+}  // namespace
+
 bool CommandLineInterface::GenerateOutput(
     const std::vector<const FileDescriptor*>& parsed_files,
     const OutputDirective& output_directive,
@@ -2253,6 +2545,203 @@ bool CommandLineInterface::GenerateOutput(
   return true;
 }
 
+bool CommandLineInterface::GetCacheKey(
+    const OutputDirective& directive, const std::string& parameters,
+    const std::vector<const FileDescriptor*>& files,
+    const std::vector<const FileDescriptor*>& parsed_files, std::string* key) {
+  std::string generator;
+  if (directive.generator == NULL) {
+    std::string plugin_name = PluginName(plugin_prefix_, directive.name);
+    if (plugins_.count(plugin_name) == 0 ||
+        !GetFileIdentity(plugins_.at(plugin_name), &generator)) {
+      // Found by searching PATH when run; we can't tell which one it is.
+      return false;
+    }
+  } else {
+    std::string protoc_path;
+    if (!GetProtocAbsolutePath(&protoc_path) ||
+        !GetFileIdentity(protoc_path, &generator)) {
+      return false;
+    }
+  }
+
+  // The request a plugin would get covers the files, their dependencies and
+  // the parameters.  Generators can also list the other files being parsed.
+  CodeGeneratorRequest request;
+  if (!parameters.empty()) {
+    request.set_parameter(parameters);
+  }
+  std::set<const FileDescriptor*> already_seen;
+  for (const FileDescriptor* file : files) {
+    request.add_file_to_generate(file->name());
+    GetTransitiveDependencies(file,
+                              true,  // Include json_name.
+                              true,  // Include source code info.
+                              &already_seen, request.mutable_proto_file());
+  }
+  std::vector<std::string> parsed_file_names;
+  for (const FileDescriptor* file : parsed_files) {
+    parsed_file_names.push_back(file->name());
+  }
+
+  *key = StrCat(PROTOBUF_VERSION, "\n", directive.name, "\n", generator, "\n",
+                Join(parsed_file_names, ","), "\n",
+                request.SerializeAsString());
+  AppendParameterFiles(parameters, key);
+  return true;
+}
+
+bool CommandLineInterface::GenerateOutputInParallel(
+    const std::vector<const FileDescriptor*>& parsed_files,
+    GeneratorContextMap* output_directories) {
+  // One generator run: a directive applied to all of the parsed files, or to
+  // just one of them for a per-file generator.
+  struct Job {
+    const OutputDirective* directive;
+    std::string parameters;
+    std::vector<const FileDescriptor*> files;
+    GeneratorContextImpl* directory;
+    std::unique_ptr<RecordingGeneratorContext> output;
+    bool succeeded;
+    std::string error;
+    // For --cache_dir: the entry's key and path if the run can be cached, and
+    // whether the output was found there.
+    std::string cache_key;
+    std::string cache_path;
+    bool cached;
+  };
+  std::vector<Job> jobs;
+
+  // Everything that reads or updates our own state happens here, up front, so
+  // that the jobs only ever touch their own Job.
+  for (const OutputDirective& directive : output_directives_) {
+    std::string output_location = directive.output_location;
+    if (!HasSuffixString(output_location, ".zip") &&
+        !HasSuffixString(output_location, ".jar") &&
+        !HasSuffixString(output_location, ".srcjar")) {
+      AddTrailingSlash(&output_location);
+    }
+
+    auto& directory = (*output_directories)[output_location];
+    if (!directory) {
+      // First time we've seen this output location.
+      directory.reset(new GeneratorContextImpl(parsed_files));
+    }
+
+    std::string parameters = directive.parameter;
+    std::string extra_parameters;
+    if (directive.generator == NULL) {
+      GOOGLE_CHECK(HasPrefixString(directive.name, "--") &&
+            HasSuffixString(directive.name, "_out"))
+          << "Bad name for plugin generator: " << directive.name;
+      extra_parameters =
+          plugin_parameters_[PluginName(plugin_prefix_, directive.name)];
+    } else {
+      extra_parameters = generator_parameters_[directive.name];
+      if (!EnforceProto3OptionalSupport(
+              directive.name, directive.generator->GetSupportedFeatures(),
+              parsed_files)) {
+        return false;
+      }
+    }
+    if (!extra_parameters.empty()) {
+      if (!parameters.empty()) {
+        parameters.append(",");
+      }
+      parameters.append(extra_parameters);
+    }
+
+    bool per_file = directive.generator != NULL &&
+                    per_file_generators_.count(directive.name) > 0;
+    int job_count = per_file ? parsed_files.size() : 1;
+    for (int i = 0; i < job_count; i++) {
+      Job job;
+      job.directive = &directive;
+      job.parameters = parameters;
+      if (per_file) {
+        job.files.push_back(parsed_files[i]);
+      } else {
+        job.files = parsed_files;
+      }
+      job.directory = directory.get();
+      job.output.reset(new RecordingGeneratorContext(parsed_files));
+      job.succeeded = false;
+      job.cached = false;
+      if (!cache_dir_.empty() &&
+          GetCacheKey(directive, parameters, job.files, parsed_files,
+                      &job.cache_key)) {
+        job.cache_path = cache_dir_ + CacheEntryName(job.cache_key);
+        CodeGeneratorResponse response;
+        if (ReadCacheEntry(job.cache_path, job.cache_key, &response)) {
+          job.output->Load(response);
+          job.succeeded = true;
+          job.cached = true;
+        }
+      }
+      jobs.push_back(std::move(job));
+    }
+  }
+
+  // Plugins run one at a time on this thread: Subprocess is not safe to use
+  // from several threads at once.  Built-in generators are spread over
+  // the worker threads.
+  std::vector<Job*> plugin_jobs;
+  std::vector<Job*> generator_jobs;
+  for (Job& job : jobs) {
+    if (job.cached) {
+      continue;
+    } else if (job.directive->generator == NULL) {
+      plugin_jobs.push_back(&job);
+    } else {
+      generator_jobs.push_back(&job);
+    }
+  }
+
+  std::atomic<int> next_job(0);
+  auto run_generator_jobs = [&generator_jobs, &next_job]() {
+    for (int i = next_job++; i < generator_jobs.size(); i = next_job++) {
+      Job* job = generator_jobs[i];
+      job->succeeded = job->directive->generator->GenerateAll(
+          job->files, job->parameters, job->output.get(), &job->error);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  int thread_count = std::min<int>(jobs_, generator_jobs.size());
+  if (plugin_jobs.empty()) {
+    // This thread would otherwise sit idle; let it take one worker's place.
+    thread_count--;
+  }
+  for (int i = 0; i < thread_count; i++) {
+    threads.emplace_back(run_generator_jobs);
+  }
+  for (Job* job : plugin_jobs) {
+    job->succeeded = GeneratePluginOutput(
+        job->files, PluginName(plugin_prefix_, job->directive->name),
+        job->parameters, job->output.get(), &job->error);
+  }
+  run_generator_jobs();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Report the first failure, or write the output in command-line order.
+  for (Job& job : jobs) {
+    if (!job.succeeded) {
+      std::cerr << job.directive->name << ": " << job.error << std::endl;
+      return false;
+    }
+    job.output->Replay(job.directory);
+
+    CodeGeneratorResponse response;
+    if (!job.cached && !job.cache_path.empty() && job.output->Save(&response)) {
+      WriteCacheEntry(job.cache_path, job.cache_key, response);
+    }
+  }
+
+  return true;
+}
+
 bool CommandLineInterface::GenerateDependencyManifestFile(
     const std::vector<const FileDescriptor*>& parsed_files,
     const GeneratorContextMap& output_directories,
@@ -2356,7 +2845,7 @@ bool CommandLineInterface::GeneratePluginOutput(
   Subprocess subprocess;
 
   if (plugins_.count(plugin_name) > 0) {
-    subprocess.Start(plugins_[plugin_name], Subprocess::EXACT_NAME);
+    subprocess.Start(plugins_.at(plugin_name), Subprocess::EXACT_NAME);
   } else {
     subprocess.Start(plugin_name, Subprocess::SEARCH_PATH);
   }
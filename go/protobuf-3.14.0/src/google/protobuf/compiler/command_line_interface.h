@@ -184,6 +184,14 @@ class PROTOC_EXPORT CommandLineInterface {
   //
   void AllowPlugins(const std::string& exe_name_prefix);
 
+  // Tells the compiler that the generator registered under flag_name writes
+  // the output for each .proto file independently of the other files it is
+  // given, so that with --jobs it can be run on several files at once.  Only
+  // mark generators whose GenerateAll() just calls Generate() on each file;
+  // the others still run in parallel with other generators, but each on all
+  // files at once.
+  void SetPerFileGenerator(const std::string& flag_name);
+
   // Run the Protocol Compiler with the given command-line parameters.
   // Returns the error code which should be returned by main().
   //
@@ -295,6 +303,24 @@ class PROTOC_EXPORT CommandLineInterface {
       const std::string& plugin_name, const std::string& parameter,
       GeneratorContext* generator_context, std::string* error);
 
+  // Implements --jobs and --cache_dir: runs all output directives, split by
+  // file where the generator allows it, on jobs_ threads.  Each run writes to
+  // a private buffer, and the buffers are copied to output_directories in
+  // command-line and file order, so the result is the same as running them one
+  // by one.  Runs whose inputs are found in cache_dir_ are not run at all.
+  bool GenerateOutputInParallel(
+      const std::vector<const FileDescriptor*>& parsed_files,
+      GeneratorContextMap* output_directories);
+
+  // Sets *key to everything --cache_dir needs to match for a run of directive
+  // on files to be reused.  Returns false if the generator binary can't be
+  // identified, in which case the run is not cached.
+  bool GetCacheKey(const OutputDirective& directive,
+                   const std::string& parameters,
+                   const std::vector<const FileDescriptor*>& files,
+                   const std::vector<const FileDescriptor*>& parsed_files,
+                   std::string* key);
+
   // Implements --encode and --decode.
   bool EncodeOrDecode(const DescriptorPool* pool);
 
@@ -373,6 +399,9 @@ class PROTOC_EXPORT CommandLineInterface {
   // PATH (or other OS-specific search strategy) is searched.
   std::map<std::string, std::string> plugins_;
 
+  // Flag names of the generators marked with SetPerFileGenerator().
+  std::set<std::string> per_file_generators_;
+
   // Stuff parsed from command line.
   enum Mode {
     MODE_COMPILE,  // Normal mode:  parse .proto files and compile them.
@@ -454,6 +483,12 @@ class PROTOC_EXPORT CommandLineInterface {
   // When using --encode, this will be passed to SetSerializationDeterministic.
   bool deterministic_output_ = false;
 
+  // Number of threads to generate code on (--jobs).
+  int jobs_ = 1;
+
+  // Directory of earlier generator outputs to reuse (--cache_dir), or empty.
+  std::string cache_dir_;
+
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(CommandLineInterface);
 };
 
@@ -112,6 +112,11 @@ class CommandLineInterfaceTest : public testing::Test {
   // disable them.
   void DisallowPlugins() { disallow_plugins_ = true; }
 
+  // Lets --jobs run the given generator on each input file separately.
+  void SetPerFileGenerator(const std::string& name) {
+    cli_.SetPerFileGenerator(name);
+  }
+
   // Create a temp file within temp_directory_ with the given name.
   // The containing directory is also created if necessary.
   void CreateTempFile(const std::string& name, const std::string& contents);
@@ -197,6 +202,9 @@ class CommandLineInterfaceTest : public testing::Test {
   void ExpectNullCodeGeneratorCalled(const std::string& parameter);
 #endif  // _WIN32
 
+  // Returns whether --null_out ran its generator since the last call.
+  bool TakeNullCodeGeneratorCalled();
+
 
   void ReadDescriptorSet(const std::string& filename,
                          FileDescriptorSet* descriptor_set);
@@ -484,6 +492,12 @@ void CommandLineInterfaceTest::ExpectNullCodeGeneratorCalled(
 }
 #endif  // _WIN32
 
+bool CommandLineInterfaceTest::TakeNullCodeGeneratorCalled() {
+  bool called = null_generator_->called_;
+  null_generator_->called_ = false;
+  return called;
+}
+
 
 void CommandLineInterfaceTest::ReadDescriptorSet(
     const std::string& filename, FileDescriptorSet* descriptor_set) {
@@ -1206,6 +1220,144 @@ TEST_F(CommandLineInterfaceTest, InsertWithAnnotationFixup) {
   CheckGeneratedAnnotations("test_plugin", "foo.proto");
 }
 
+TEST_F(CommandLineInterfaceTest, ParallelOutput) {
+  // Test that --jobs produces the same output as running the generators one
+  // after another.
+  SetPerFileGenerator("--test_out");
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Bar {}\n");
+
+  Run("protocol_compiler --jobs=4 --test_out=$tmpdir --plug_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto bar.proto");
+
+  ExpectNoErrors();
+  ExpectGeneratedWithMultipleInputs("test_generator", "foo.proto,bar.proto",
+                                    "foo.proto", "Foo");
+  ExpectGeneratedWithMultipleInputs("test_generator", "foo.proto,bar.proto",
+                                    "bar.proto", "Bar");
+  ExpectGeneratedWithMultipleInputs("test_plugin", "foo.proto,bar.proto",
+                                    "foo.proto", "Foo");
+  ExpectGeneratedWithMultipleInputs("test_plugin", "foo.proto,bar.proto",
+                                    "bar.proto", "Bar");
+}
+
+TEST_F(CommandLineInterfaceTest, ParallelInsert) {
+  // Test that insertions into another generator's output still happen in
+  // command-line order with --jobs.
+  SetPerFileGenerator("--test_out");
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --jobs=4 "
+      "--test_out=TestParameter:$tmpdir "
+      "--plug_out=TestPluginParameter:$tmpdir "
+      "--test_out=insert=test_generator,test_plugin:$tmpdir "
+      "--plug_out=insert=test_generator,test_plugin:$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGeneratedWithInsertions("test_generator", "TestParameter",
+                                "test_generator,test_plugin", "foo.proto",
+                                "Foo");
+  ExpectGeneratedWithInsertions("test_plugin", "TestPluginParameter",
+                                "test_generator,test_plugin", "foo.proto",
+                                "Foo");
+}
+
+TEST_F(CommandLineInterfaceTest, CacheDir) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempDir("cache");
+
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--test_out=$tmpdir --plug_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo");
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo");
+
+  // The second run gets the same output from the cache.
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--test_out=$tmpdir --plug_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo");
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo");
+
+  // Different parameters must not reuse it.
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--test_out=TestParameter:$tmpdir --plug_out=TestPluginParameter:$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "TestParameter", "foo.proto", "Foo");
+  ExpectGenerated("test_plugin", "TestPluginParameter", "foo.proto", "Foo");
+}
+
+#ifndef _WIN32
+TEST_F(CommandLineInterfaceTest, CacheDirParameterFile) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempFile("foo.profile", "Foo.bar 1\n");
+  CreateTempDir("cache");
+
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--null_out=$tmpdir/foo.profile:$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  EXPECT_TRUE(TakeNullCodeGeneratorCalled());
+
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--null_out=$tmpdir/foo.profile:$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  EXPECT_FALSE(TakeNullCodeGeneratorCalled());
+
+  // Editing the file named by the parameter must not reuse the entry, even
+  // when its size stays the same.
+  CreateTempFile("foo.profile", "Foo.bar 2\n");
+
+  Run("protocol_compiler --cache_dir=$tmpdir/cache "
+      "--null_out=$tmpdir/foo.profile:$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  EXPECT_TRUE(TakeNullCodeGeneratorCalled());
+}
+#endif  // !_WIN32
+
+TEST_F(CommandLineInterfaceTest, CacheDirMissing) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --cache_dir=$tmpdir/nosuchdir "
+      "--test_out=$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectErrorSubstring("nosuchdir: ");
+}
+
+TEST_F(CommandLineInterfaceTest, BadJobs) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --jobs=0 --test_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectErrorText("--jobs must be a positive number: 0\n");
+}
+
 #if defined(_WIN32)
 
 TEST_F(CommandLineInterfaceTest, WindowsOutputPath) {
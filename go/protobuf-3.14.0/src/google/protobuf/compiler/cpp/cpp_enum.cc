@@ -267,11 +267,11 @@ void EnumGenerator::GenerateMethods(int idx, io::Printer* printer) {
   Formatter format(printer, variables_);
   if (HasDescriptorMethods(descriptor_->file(), options_)) {
     format(
-        "const ::$proto_ns$::EnumDescriptor* $classname$_descriptor() {\n"
+        "$1$const ::$proto_ns$::EnumDescriptor* $classname$_descriptor() {\n"
         "  ::$proto_ns$::internal::AssignDescriptors(&$desc_table$);\n"
-        "  return $file_level_enum_descriptors$[$1$];\n"
+        "  return $file_level_enum_descriptors$[$2$];\n"
         "}\n",
-        idx);
+        DescriptorCodeSection(options_), idx);
   }
 
   format(
@@ -170,6 +170,9 @@ FieldGenerator* FieldGeneratorMap::MakeGenerator(
   } else {
     switch (field->cpp_type()) {
       case FieldDescriptor::CPPTYPE_MESSAGE:
+        if (IsLazy(field, options)) {
+          return new LazyMessageFieldGenerator(field, options, scc_analyzer);
+        }
         return new MessageFieldGenerator(field, options, scc_analyzer);
       case FieldDescriptor::CPPTYPE_STRING:
         return new StringFieldGenerator(field, options);
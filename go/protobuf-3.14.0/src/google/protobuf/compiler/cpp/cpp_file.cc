@@ -400,6 +400,9 @@ void FileGenerator::GenerateSourceIncludes(io::Printer* printer) {
   // TODO(gerbens) This is to include parse_context.h, we need a better way
   IncludeFile("net/proto2/public/extension_set.h", printer);
   IncludeFile("net/proto2/public/wire_format_lite.h", printer);
+  if (HasGeneratedMethods(file_, options_) && !message_generators_.empty()) {
+    IncludeFile("net/proto2/public/reverse_encoder.h", printer);
+  }
 
   // Unknown fields implementation in lite mode uses StringOutputStream
   if (!UseUnknownFieldSet(file_, options_) && !message_generators_.empty()) {
@@ -928,7 +931,8 @@ void FileGenerator::GenerateInitForSCC(const SCC* scc,
   Formatter format(printer, variables_);
   // We use static and not anonymous namespace because symbol names are
   // substantially shorter.
-  format("static void InitDefaults$1$() {\n", SccInfoSymbol(scc, options_));
+  format("$1$static void InitDefaults$2$() {\n", DescriptorCodeSection(options_),
+         SccInfoSymbol(scc, options_));
 
   if (options_.opensource_runtime) {
     format("  GOOGLE_PROTOBUF_VERIFY_VERSION;\n\n");
@@ -1005,12 +1009,9 @@ void FileGenerator::GenerateInitForSCC(const SCC* scc,
 void FileGenerator::GenerateTables(io::Printer* printer) {
   Formatter format(printer, variables_);
   if (options_.table_driven_parsing) {
-    // TODO(ckennelly): Gate this with the same options flag to enable
-    // table-driven parsing.
     format(
         "PROTOBUF_CONSTEXPR_VAR ::$proto_ns$::internal::ParseTableField\n"
-        "    const $tablename$::entries[] "
-        "PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {\n");
+        "    const $tablename$::entries[] = {\n");
     format.Indent();
 
     std::vector<size_t> entries;
@@ -1032,8 +1033,7 @@ void FileGenerator::GenerateTables(io::Printer* printer) {
         "\n"
         "PROTOBUF_CONSTEXPR_VAR "
         "::$proto_ns$::internal::AuxiliaryParseTableField\n"
-        "    const $tablename$::aux[] "
-        "PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {\n");
+        "    const $tablename$::aux[] = {\n");
     format.Indent();
 
     std::vector<size_t> aux_entries;
@@ -1052,8 +1052,7 @@ void FileGenerator::GenerateTables(io::Printer* printer) {
     format(
         "};\n"
         "PROTOBUF_CONSTEXPR_VAR ::$proto_ns$::internal::ParseTable const\n"
-        "    $tablename$::schema[] "
-        "PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {\n");
+        "    $tablename$::schema[] = {\n");
     format.Indent();
 
     size_t offset = 0;
@@ -1247,7 +1246,6 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* printer) {
     IncludeFile("net/proto2/public/weak_field_map.h", printer);
   }
   if (HasLazyFields(file_, options_)) {
-    GOOGLE_CHECK(!options_.opensource_runtime);
     IncludeFile("net/proto2/public/lazy_field.h", printer);
   }
 
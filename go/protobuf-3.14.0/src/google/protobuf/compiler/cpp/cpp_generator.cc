@@ -39,6 +39,7 @@
 #include <vector>
 
 #include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/compiler/access_info_map.h>
 #include <google/protobuf/compiler/cpp/cpp_file.h>
 #include <google/protobuf/compiler/cpp/cpp_helpers.h>
 #include <google/protobuf/descriptor.pb.h>
@@ -75,7 +76,27 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   // FOO_EXPORT is a macro which should expand to __declspec(dllexport) or
   // __declspec(dllimport) depending on what is being compiled.
   //
+  // The table_driven_parsing and table_driven_serialization options replace
+  // the generated _InternalParse and _InternalSerialize bodies with compact
+  // per-file tables interpreted by the runtime, trading some speed for much
+  // less generated code.  table_driven enables both:
+  //   protoc --cpp_out=table_driven:outdir foo.proto
+  // Messages the tables cannot describe (weak or lazy fields, very sparse
+  // field numbers, MessageSets) keep their generated parser.
+  //
+  // The access_info_map option names a field access profile (see
+  // compiler/access_info_map.h) used to lay out hot fields first and cold
+  // fields last:
+  //   protoc --cpp_out=access_info_map=foo.profile:outdir foo.proto
+  //
+  // The code_sections option marks generated functions as hot or cold so that
+  // the linker can keep busy code together: descriptor and reflection setup
+  // is always cold, and with an access_info_map the parse, serialize and
+  // ByteSizeLong functions of each profiled message are hot or cold too.
+  //   protoc --cpp_out=code_sections,access_info_map=foo.profile:outdir ...
+  //
   Options file_options;
+  std::unique_ptr<AccessInfoMap> access_info_map;
 
   file_options.opensource_runtime = opensource_runtime_;
   file_options.runtime_include_base = runtime_include_base_;
@@ -108,6 +129,17 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       file_options.table_driven_parsing = true;
     } else if (options[i].first == "table_driven_serialization") {
       file_options.table_driven_serialization = true;
+    } else if (options[i].first == "table_driven") {
+      file_options.table_driven_parsing = true;
+      file_options.table_driven_serialization = true;
+    } else if (options[i].first == "code_sections") {
+      file_options.code_sections = true;
+    } else if (options[i].first == "access_info_map") {
+      access_info_map.reset(new AccessInfoMap);
+      if (!access_info_map->Load(options[i].second, error)) {
+        return false;
+      }
+      file_options.access_info_map = access_info_map.get();
     } else {
       *error = "Unknown generator option: " + options[i].first;
       return false;
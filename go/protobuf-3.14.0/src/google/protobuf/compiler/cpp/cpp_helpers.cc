@@ -43,6 +43,7 @@
 
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/stubs/logging.h>
+#include <google/protobuf/compiler/access_info_map.h>
 #include <google/protobuf/compiler/cpp/cpp_options.h>
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/descriptor.h>
@@ -1142,6 +1143,21 @@ bool IsImplicitWeakField(const FieldDescriptor* field, const Options& options,
              scc_analyzer->GetSCC(field->message_type());
 }
 
+std::string MessageCodeSection(const Descriptor* descriptor,
+                               const Options& options) {
+  const AccessInfoMap* access_info_map = options.access_info_map;
+  if (!options.code_sections || access_info_map == nullptr ||
+      !access_info_map->HasProfile(descriptor)) {
+    return "";
+  }
+  return access_info_map->IsHot(descriptor) ? "PROTOBUF_SECTION_HOT "
+                                            : "PROTOBUF_SECTION_COLD ";
+}
+
+std::string DescriptorCodeSection(const Options& options) {
+  return options.code_sections ? "PROTOBUF_SECTION_COLD " : "";
+}
+
 MessageAnalysis MessageSCCAnalyzer::GetSCCAnalysis(const SCC* scc) {
   if (analysis_cache_.count(scc)) return analysis_cache_[scc];
   MessageAnalysis result{};
@@ -1362,6 +1378,7 @@ class ParseLoopGenerator {
     format_.Set("pi_ns",
                 StrCat("::", ProtobufNamespace(options_), "::internal"));
     format_.Set("GOOGLE_PROTOBUF", MacroPrefix(options_));
+    format_.Set("code_section", MessageCodeSection(descriptor, options_));
     std::map<std::string, std::string> vars;
     SetCommonVars(options_, &vars);
     SetUnknkownFieldsVariable(descriptor, options_, &vars);
@@ -1379,8 +1396,8 @@ class ParseLoopGenerator {
               });
 
     format_(
-        "const char* $classname$::_InternalParse(const char* ptr, "
-        "$pi_ns$::ParseContext* ctx) {\n"
+        "$code_section$const char* $classname$::_InternalParse("
+        "const char* ptr, $pi_ns$::ParseContext* ctx) {\n"
         "#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure\n");
     format_.Indent();
     int hasbits_size = 0;
@@ -1430,6 +1447,7 @@ class ParseLoopGenerator {
             : QualifiedClassName(field->containing_type(), options_) +
                   "::" + MakeDefaultName(field) + ".get()";
     format_(
+        "auto* arena = GetArena();\n"
         "if (arena != nullptr) {\n"
         "  ptr = ctx->ReadArenaString(ptr, &$1$_, arena);\n"
         "} else {\n"
@@ -1447,7 +1465,7 @@ class ParseLoopGenerator {
       // Open source doesn't support other ctypes;
       ctype = field->options().ctype();
     }
-    if (!field->is_repeated() && !options_.opensource_runtime &&
+    if (!field->is_repeated() &&
         GetOptimizeFor(field->file(), options_) != FileOptions::LITE_RUNTIME &&
         // For now only use arena string for strings with empty defaults.
         field->default_value_string().empty() &&
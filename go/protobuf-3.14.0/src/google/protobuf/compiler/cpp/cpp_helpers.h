@@ -339,10 +339,21 @@ bool HasLazyFields(const FileDescriptor* file, const Options& options);
 
 // Is the given field a supported lazy field?
 inline bool IsLazy(const FieldDescriptor* field, const Options& options) {
-  return field->options().lazy() && !field->is_repeated() &&
-         field->type() == FieldDescriptor::TYPE_MESSAGE &&
-         GetOptimizeFor(field->file(), options) != FileOptions::LITE_RUNTIME &&
-         !options.opensource_runtime;
+  if (!field->options().lazy() || field->is_repeated() ||
+      field->type() != FieldDescriptor::TYPE_MESSAGE) {
+    return false;
+  }
+  if (options.opensource_runtime) {
+    // The open-source runtime only supports lazy fields in lite messages,
+    // since LazyField has no reflection support.  Oneof members, extensions
+    // and weak fields keep the eager representation.
+    return GetOptimizeFor(field->file(), options) ==
+               FileOptions::LITE_RUNTIME &&
+           !field->is_extension() && !field->real_containing_oneof() &&
+           !field->options().weak() && !options.lite_implicit_weak_fields &&
+           !options.table_driven_serialization;
+  }
+  return GetOptimizeFor(field->file(), options) != FileOptions::LITE_RUNTIME;
 }
 
 inline bool IsFieldUsed(const FieldDescriptor* field, const Options& options) {
@@ -625,6 +636,18 @@ bool UsingImplicitWeakFields(const FileDescriptor* file,
 bool IsImplicitWeakField(const FieldDescriptor* field, const Options& options,
                          MessageSCCAnalyzer* scc_analyzer);
 
+// Returns the attribute, followed by a space, that the code_sections option
+// puts in front of the definitions of the parse, serialize and size functions
+// of "descriptor": PROTOBUF_SECTION_HOT if the access profile shows it on the
+// hot path, PROTOBUF_SECTION_COLD if the profile has it but never on the hot
+// path, and an empty string otherwise.
+std::string MessageCodeSection(const Descriptor* descriptor,
+                               const Options& options);
+
+// Like MessageCodeSection(), for code that only sets up descriptors and
+// reflection.  This is cold whether or not there is a profile.
+std::string DescriptorCodeSection(const Options& options);
+
 // Formatter is a functor class which acts as a closure around printer and
 // the variable map. It's much like printer->Print except it supports both named
 // variables that are substituted using a key value map and direct arguments. In
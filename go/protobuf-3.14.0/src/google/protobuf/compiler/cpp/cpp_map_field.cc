@@ -166,14 +166,24 @@ void MapFieldGenerator::GenerateCopyConstructorCode(
   GenerateMergingCode(printer);
 }
 
+// The order in which a serialization loop visits the map entries.
+enum MapSerializationOrder {
+  kIterationOrder,
+  kSortedItems,  // the locally sorted items array
+  kSortedCache,  // the map's sorted key cache
+};
+
 static void GenerateSerializationLoop(const Formatter& format, bool string_key,
                                       bool string_value,
-                                      bool is_deterministic) {
+                                      MapSerializationOrder order) {
   std::string ptr;
-  if (is_deterministic) {
+  if (order == kSortedItems) {
     format("for (size_type i = 0; i < n; i++) {\n");
     ptr = string_key ? "items[static_cast<ptrdiff_t>(i)]"
                      : "items[static_cast<ptrdiff_t>(i)].second";
+  } else if (order == kSortedCache) {
+    format("for (ConstPtr p : *sorted) {\n");
+    ptr = "p";
   } else {
     format(
         "for (::$proto_ns$::Map< $key_cpp$, $val_cpp$ >::const_iterator\n"
@@ -253,6 +263,15 @@ void MapFieldGenerator::GenerateSerializeWithCachedSizesToArray(
       "\n"
       "if (stream->IsSerializationDeterministic() &&\n"
       "    this->_internal_$name$().size() > 1) {\n"
+      "  const ::std::vector<ConstPtr>* sorted =\n"
+      "      this->_internal_$name$().InternalGetSortedElements();\n"
+      "  if (sorted != nullptr) {\n");
+  format.Indent();
+  format.Indent();
+  GenerateSerializationLoop(format, string_key, string_value, kSortedCache);
+  format.Outdent();
+  format(
+      "} else {\n"
       "  ::std::unique_ptr<SortItem[]> items(\n"
       "      new SortItem[this->_internal_$name$().size()]);\n"
       "  typedef ::$proto_ns$::Map< $key_cpp$, $val_cpp$ >::size_type "
@@ -265,11 +284,14 @@ void MapFieldGenerator::GenerateSerializeWithCachedSizesToArray(
       "  }\n"
       "  ::std::sort(&items[0], &items[static_cast<ptrdiff_t>(n)], Less());\n");
   format.Indent();
-  GenerateSerializationLoop(format, string_key, string_value, true);
+  GenerateSerializationLoop(format, string_key, string_value, kSortedItems);
+  format.Outdent();
+  format("}\n");
   format.Outdent();
   format("} else {\n");
   format.Indent();
-  GenerateSerializationLoop(format, string_key, string_value, false);
+  GenerateSerializationLoop(format, string_key, string_value,
+                            kIterationOrder);
   format.Outdent();
   format("}\n");
   format.Outdent();
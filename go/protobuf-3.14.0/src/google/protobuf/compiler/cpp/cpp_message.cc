@@ -42,6 +42,7 @@
 #include <utility>
 #include <vector>
 
+#include <google/protobuf/compiler/access_info_map.h>
 #include <google/protobuf/compiler/cpp/cpp_enum.h>
 #include <google/protobuf/compiler/cpp/cpp_extension.h>
 #include <google/protobuf/compiler/cpp/cpp_field.h>
@@ -334,18 +335,6 @@ bool TableDrivenParsingEnabled(const Descriptor* descriptor,
   }
 
   // Consider table-driven parsing.  We only do this if:
-  // - We have has_bits for fields.  This avoids a check on every field we set
-  //   when are present (the common case).
-  bool has_hasbit = false;
-  for (int i = 0; i < descriptor->field_count(); i++) {
-    if (HasHasbit(descriptor->field(i))) {
-      has_hasbit = true;
-      break;
-    }
-  }
-
-  if (!has_hasbit) return false;
-
   const double table_sparseness = 0.5;
   int max_field_number = 0;
   for (auto field : FieldRange(descriptor)) {
@@ -488,12 +477,17 @@ class ColdChunkSkipper {
 };
 
 // Tuning parameters for ColdChunkSkipper.
-const double kColdRatio = 0.005;
+const double kColdRatio = PaddingOptimizer::kColdRatio;
 
 bool ColdChunkSkipper::IsColdChunk(int chunk) {
-  // Mark this variable as used until it is actually used
-  (void)cold_threshold_;
-  return false;
+  for (auto field : chunks_[chunk]) {
+    // Only fields with hasbits can be skipped by the external check.
+    if (has_bit_indices_.empty() || has_bit_indices_[field->index()] < 0 ||
+        !access_info_map_->IsCold(field, cold_threshold_)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 
@@ -563,6 +557,28 @@ bool ColdChunkSkipper::OnEndChunk(int chunk, io::Printer* printer) {
   return true;
 }
 
+// Returns true if the message gets a generated _InternalSerializeReverse().
+// Messages with fields that don't serialize themselves, such as extensions,
+// maps and lazy or weak fields, use the default implementation in
+// MessageLite, which serializes forward.
+bool HasSerializeReverse(const Descriptor* descriptor, const Options& options,
+                         MessageSCCAnalyzer* scc_analyzer) {
+  if (!HasGeneratedMethods(descriptor->file(), options) ||
+      options.table_driven_serialization ||
+      descriptor->options().message_set_wire_format() ||
+      descriptor->extension_range_count() > 0) {
+    return false;
+  }
+  for (auto field : FieldRange(descriptor)) {
+    if (IsFieldStripped(field, options)) continue;
+    if (field->is_map() || IsWeak(field, options) || IsLazy(field, options) ||
+        IsImplicitWeakField(field, options, scc_analyzer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // anonymous namespace
 
 // ===================================================================
@@ -591,6 +607,8 @@ MessageGenerator::MessageGenerator(
       SccInfoSymbol(scc_analyzer_->GetSCC(descriptor_), options_);
   variables_["full_name"] = descriptor_->full_name();
   variables_["superclass"] = SuperClassName(descriptor_, options_);
+  variables_["code_section"] = MessageCodeSection(descriptor_, options_);
+  variables_["descriptor_section"] = DescriptorCodeSection(options_);
 
   // Compute optimized field order to be used for layout and initialization
   // purposes.
@@ -1361,6 +1379,12 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* printer) {
         "$uint8$* _InternalSerialize(\n"
         "    $uint8$* target, ::$proto_ns$::io::EpsCopyOutputStream* stream) "
         "const final;\n");
+    if (HasSerializeReverse(descriptor_, options_, scc_analyzer_)) {
+      format(
+          "$uint8$* _InternalSerializeReverse(\n"
+          "    $uint8$* ptr, ::$proto_ns$::internal::ReverseEncoder* encoder) "
+          "const final;\n");
+    }
 
     // DiscardUnknownFields() is implemented in message.cc using reflections. We
     // need to implement this function in generated code for messages.
@@ -1756,7 +1780,8 @@ int MessageGenerator::GenerateFieldMetadata(io::Printer* printer) {
       vars["hasbit"] = StrCat(i);
       vars["type"] = StrCat(CalcFieldNum(generator, field, options_));
       vars["ptr"] = "nullptr";
-      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          field->message_type()->file() == descriptor_->file()) {
         GOOGLE_CHECK(!IsMapEntryMessage(field->message_type()));
         vars["ptr"] =
             "::" + UniqueName("TableStruct", field->message_type(), options_) +
@@ -1830,9 +1855,12 @@ int MessageGenerator::GenerateFieldMetadata(io::Printer* printer) {
             tag, FindMessageIndexInFile(field->message_type()),
             QualifiedClassName(field->message_type(), options_));
         continue;
-      } else if (!field->message_type()->options().message_set_wire_format()) {
+      } else if (!field->message_type()->options().message_set_wire_format() &&
+                 field->message_type()->file() == descriptor_->file()) {
         // message_set doesn't have the usual table and we need to
-        // dispatch to generated serializer, hence ptr stays zero.
+        // dispatch to generated serializer, hence ptr stays zero.  Neither
+        // do messages from other files, which may have been generated
+        // without table_driven_serialization.
         ptr =
             "::" + UniqueName("TableStruct", field->message_type(), options_) +
             "::serialization_table + " +
@@ -1840,6 +1868,13 @@ int MessageGenerator::GenerateFieldMetadata(io::Printer* printer) {
       }
     }
 
+    if (field->type() == FieldDescriptor::TYPE_STRING &&
+        GetUtf8CheckMode(field, options_) != NONE) {
+      // String fields carry their name so the serializer can report invalid
+      // UTF-8 the way generated serializers do.
+      ptr = "\"" + field->full_name() + "\"";
+    }
+
     const FieldGenerator& generator = field_generators_.get(field);
     int type = CalcFieldNum(generator, field, options_);
 
@@ -1911,7 +1946,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* printer) {
         "}\n");
     if (HasDescriptorMethods(descriptor_->file(), options_)) {
       format(
-          "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+          "$descriptor_section$::$proto_ns$::Metadata "
+          "$classname$::GetMetadata() const {\n"
           "  return GetMetadataStatic();\n"
           "}\n");
       format(
@@ -2022,6 +2058,11 @@ void MessageGenerator::GenerateClassMethods(io::Printer* printer) {
     GenerateSerializeWithCachedSizesToArray(printer);
     format("\n");
 
+    if (HasSerializeReverse(descriptor_, options_, scc_analyzer_)) {
+      GenerateSerializeReverse(printer);
+      format("\n");
+    }
+
     GenerateByteSize(printer);
     format("\n");
 
@@ -2051,7 +2092,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* printer) {
   }
   if (HasDescriptorMethods(descriptor_->file(), options_)) {
     format(
-        "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+        "$descriptor_section$::$proto_ns$::Metadata "
+        "$classname$::GetMetadata() const {\n"
         "  return GetMetadataStatic();\n"
         "}\n"
         "\n");
@@ -2143,7 +2185,7 @@ size_t MessageGenerator::GenerateParseOffsets(io::Printer* printer) {
       vars["presence"] = StrCat(field->containing_oneof()->index());
     } else {
       vars["name"] = FieldName(field);
-      vars["presence"] = StrCat(has_bit_indices_[field->index()]);
+      vars["presence"] = StrCat(HasBitIndex(field));
     }
     vars["nwtype"] = StrCat(normal_wiretype);
     vars["pwtype"] = StrCat(packed_wiretype);
@@ -2205,8 +2247,11 @@ size_t MessageGenerator::GenerateParseAuxTable(io::Printer* printer) {
         if (field->is_map()) {
           format(
               "{::$proto_ns$::internal::AuxiliaryParseTableField::map_"
-              "aux{&::$proto_ns$::internal::ParseMap<$1$>}},\n",
-              QualifiedClassName(field->message_type(), options_));
+              "aux{&::$proto_ns$::internal::ParseMap<$1$>,\n"
+              "  &::$proto_ns$::internal::ParseMapField<\n"
+              "      decltype($classtype$::$2$_)>}},\n",
+              QualifiedClassName(field->message_type(), options_),
+              FieldName(field));
           last_field_number++;
           break;
         }
@@ -2222,9 +2267,11 @@ size_t MessageGenerator::GenerateParseAuxTable(io::Printer* printer) {
       }
       case FieldDescriptor::CPPTYPE_STRING: {
         std::string default_val;
+        bool lazy_default = false;
         switch (EffectiveStringCType(field, options_)) {
           case FieldOptions::STRING:
-            default_val = field->default_value_string().empty()
+            lazy_default = !field->default_value_string().empty();
+            default_val = !lazy_default
                               ? "&::" + variables_["proto_ns"] +
                                     "::internal::fixed_address_empty_string"
                               : "&" +
@@ -2237,12 +2284,28 @@ size_t MessageGenerator::GenerateParseAuxTable(io::Printer* printer) {
                 "\"" + CEscape(field->default_value_string()) + "\"";
             break;
         }
+        std::string utf8_check = "kUtf8CheckNone";
+        if (field->type() == FieldDescriptor::TYPE_STRING) {
+          switch (GetUtf8CheckMode(field, options_)) {
+            case STRICT:
+              utf8_check = "kUtf8CheckStrict";
+              break;
+            case VERIFY:
+              utf8_check = "kUtf8CheckVerify";
+              break;
+            case NONE:
+              break;
+          }
+        }
         format(
             "{::$proto_ns$::internal::AuxiliaryParseTableField::string_aux{\n"
             "  $1$,\n"
-            "  \"$2$\"\n"
+            "  \"$2$\",\n"
+            "  ::$proto_ns$::internal::$3$,\n"
+            "  $4$\n"
             "}},\n",
-            default_val, field->full_name());
+            default_val, field->full_name(), utf8_check,
+            lazy_default ? "true" : "false");
         last_field_number++;
         break;
       }
@@ -3095,7 +3158,7 @@ void MessageGenerator::GenerateClassSpecificMergeFrom(io::Printer* printer) {
 
     // Go back and emit merging code for each of the fields we processed.
     bool deferred_has_bit_changes = false;
-    for (const auto field : chunk) {
+    auto emit_field = [&](const FieldDescriptor* field) {
       const FieldGenerator& generator = field_generators_.get(field);
 
       if (field->is_repeated()) {
@@ -3140,6 +3203,40 @@ void MessageGenerator::GenerateClassSpecificMergeFrom(io::Printer* printer) {
         format.Outdent();
         format("}\n");
       }
+    };
+
+    for (int i = 0; i < chunk.size(); i++) {
+      // Inside the outer if, a run of adjacent POD fields is copied with a
+      // single memcpy when all of their has bits are set, which is the
+      // common case when copying fully populated messages.
+      int run_length = 0;
+      while (have_outer_if && i + run_length < chunk.size() &&
+             IsPOD(chunk[i + run_length]) &&
+             HasHasbit(chunk[i + run_length])) {
+        run_length++;
+      }
+      if (run_length < 2) {
+        emit_field(chunk[i]);
+        continue;
+      }
+
+      std::vector<const FieldDescriptor*> run(chunk.begin() + i,
+                                              chunk.begin() + i + run_length);
+      deferred_has_bit_changes = true;
+      format(
+          "if ((cached_has_bits & 0x$1$u) == 0x$1$u) {\n"
+          "  ::memcpy(&$2$_, &from.$2$_,\n"
+          "    static_cast<size_t>(reinterpret_cast<char*>(&$3$_) -\n"
+          "    reinterpret_cast<char*>(&$2$_)) + sizeof($3$_));\n"
+          "} else {\n",
+          StrCat(strings::Hex(GenChunkMask(run, has_bit_indices_),
+                              strings::ZERO_PAD_8)),
+          FieldName(run.front()), FieldName(run.back()));
+      format.Indent();
+      for (auto field : run) emit_field(field);
+      format.Outdent();
+      format("}\n");
+      i += run_length - 1;
     }
 
     if (have_outer_if) {
@@ -3265,13 +3362,27 @@ void MessageGenerator::GenerateMergeFromCodedStream(io::Printer* printer) {
   if (descriptor_->options().message_set_wire_format()) {
     // Special-case MessageSet.
     format(
-        "const char* $classname$::_InternalParse(const char* ptr,\n"
+        "$code_section$const char* $classname$::_InternalParse("
+        "const char* ptr,\n"
         "                  ::$proto_ns$::internal::ParseContext* ctx) {\n"
         "  return _extensions_.ParseMessageSet(ptr, \n"
         "      internal_default_instance(), &_internal_metadata_, ctx);\n"
         "}\n");
     return;
   }
+  if (table_driven_) {
+    format(
+        "$code_section$const char* $classname$::_InternalParse("
+        "const char* ptr,\n"
+        "                  ::$proto_ns$::internal::ParseContext* ctx) {\n"
+        "  return ::$proto_ns$::internal::$1$(\n"
+        "      this, ::$tablename$::schema[$2$], ptr, ctx);\n"
+        "}\n",
+        UseUnknownFieldSet(descriptor_->file(), options_) ? "TableParse"
+                                                          : "TableParseLite",
+        index_in_file_messages_);
+    return;
+  }
   GenerateParserLoop(descriptor_, max_has_bit_index_, options_, scc_analyzer_,
                      printer);
 }
@@ -3360,7 +3471,7 @@ void MessageGenerator::GenerateSerializeWithCachedSizesToArray(
   if (descriptor_->options().message_set_wire_format()) {
     // Special-case MessageSet.
     format(
-        "$uint8$* $classname$::_InternalSerialize(\n"
+        "$code_section$$uint8$* $classname$::_InternalSerialize(\n"
         "    $uint8$* target, ::$proto_ns$::io::EpsCopyOutputStream* stream) "
         "const {\n"
         "  target = _extensions_."
@@ -3379,13 +3490,26 @@ void MessageGenerator::GenerateSerializeWithCachedSizesToArray(
   }
 
   format(
-      "$uint8$* $classname$::_InternalSerialize(\n"
+      "$code_section$$uint8$* $classname$::_InternalSerialize(\n"
       "    $uint8$* target, ::$proto_ns$::io::EpsCopyOutputStream* stream) "
       "const {\n");
   format.Indent();
 
   format("// @@protoc_insertion_point(serialize_to_array_start:$full_name$)\n");
 
+  if (options_.table_driven_serialization) {
+    format(
+        "target = ::$proto_ns$::internal::TableSerialize(\n"
+        "    *this, ::$tablename$::serialization_table + $1$, target, stream);\n"
+        "// @@protoc_insertion_point(serialize_to_array_end:$full_name$)\n",
+        index_in_file_messages_);
+    format.Outdent();
+    format(
+        "  return target;\n"
+        "}\n");
+    return;
+  }
+
   if (!ShouldSerializeInOrder(descriptor_, options_)) {
     format.Outdent();
     format("#ifdef NDEBUG\n");
@@ -3414,6 +3538,132 @@ void MessageGenerator::GenerateSerializeWithCachedSizesToArray(
       "}\n");
 }
 
+void MessageGenerator::GenerateSerializeReverse(io::Printer* printer) {
+  Formatter format(printer, variables_);
+  format(
+      "$uint8$* $classname$::_InternalSerializeReverse(\n"
+      "    $uint8$* ptr, ::$proto_ns$::internal::ReverseEncoder* encoder) "
+      "const {\n");
+  format.Indent();
+
+  // Everything is written back to front: the unknown fields first, then the
+  // fields in decreasing order of field number.
+  std::map<std::string, std::string> vars;
+  SetUnknkownFieldsVariable(descriptor_, options_, &vars);
+  format.AddMap(vars);
+  format("if (PROTOBUF_PREDICT_FALSE($have_unknown_fields$)) {\n");
+  format.Indent();
+  if (UseUnknownFieldSet(descriptor_->file(), options_)) {
+    format(
+        "ptr = ::$proto_ns$::internal::WireFormat::"
+        "InternalSerializeUnknownFieldsReverse(\n"
+        "    $unknown_fields$, ptr, encoder);\n");
+  } else {
+    format(
+        "ptr = encoder->WriteRaw($unknown_fields$.data(),\n"
+        "    $unknown_fields$.size(), ptr);\n");
+  }
+  format.Outdent();
+  format("}\n\n");
+
+  std::vector<const FieldDescriptor*> ordered_fields =
+      SortFieldsByNumber(descriptor_);
+  for (auto it = ordered_fields.rbegin(); it != ordered_fields.rend(); ++it) {
+    if (IsFieldStripped(*it, options_)) continue;
+    GenerateSerializeReverseOneField(printer, *it);
+  }
+
+  format.Outdent();
+  format(
+      "  return ptr;\n"
+      "}\n");
+}
+
+void MessageGenerator::GenerateSerializeReverseOneField(
+    io::Printer* printer, const FieldDescriptor* field) {
+  Formatter format(printer, variables_);
+  format.Set("name", FieldName(field));
+  format.Set("number", field->number());
+  format.Set("declared_type", DeclaredTypeMethodName(field->type()));
+  PrintFieldComment(format, field);
+
+  const char* utf8_parameters = nullptr;
+  if (field->type() == FieldDescriptor::TYPE_STRING) {
+    utf8_parameters =
+        field->is_repeated()
+            ? "this->_internal_$name$(i).data(), "
+              "static_cast<int>(this->_internal_$name$(i).length()),\n"
+            : "this->_internal_$name$().data(), "
+              "static_cast<int>(this->_internal_$name$().length()),\n";
+  }
+
+  if (field->is_packed()) {
+    format(
+        "if (this->_internal_$name$_size() > 0) {\n"
+        "  size_t start = encoder->ByteCount(ptr);\n");
+    format.Indent();
+    switch (field->type()) {
+      case FieldDescriptor::TYPE_FIXED32:
+      case FieldDescriptor::TYPE_FIXED64:
+      case FieldDescriptor::TYPE_SFIXED32:
+      case FieldDescriptor::TYPE_SFIXED64:
+      case FieldDescriptor::TYPE_FLOAT:
+      case FieldDescriptor::TYPE_DOUBLE:
+        format(
+            "ptr = encoder->WriteFixedPackedNoTag(this->_internal_$name$(), "
+            "ptr);\n");
+        break;
+      default:
+        format(
+            "for (int i = this->_internal_$name$_size() - 1; i >= 0; i--) {\n"
+            "  ptr = encoder->Write$declared_type$NoTag("
+            "this->_internal_$name$(i), ptr);\n"
+            "}\n");
+        break;
+    }
+    format.Outdent();
+    format(
+        "  ptr = encoder->WriteLengthDelimitedPrefix($number$, start, ptr);\n"
+        "}\n\n");
+    return;
+  }
+
+  if (field->is_repeated()) {
+    format("for (int i = this->_internal_$name$_size() - 1; i >= 0; i--) {\n");
+    format.Indent();
+    if (utf8_parameters != nullptr) {
+      GenerateUtf8CheckCodeForString(field, options_, false, utf8_parameters,
+                                     format);
+    }
+    format(
+        "ptr = encoder->Write$declared_type$($number$, "
+        "this->_internal_$name$(i), ptr);\n");
+    format.Outdent();
+    format("}\n\n");
+    return;
+  }
+
+  bool have_enclosing_if = true;
+  if (HasHasbit(field)) {
+    format("if (_internal_has_$name$()) {\n");
+    format.Indent();
+  } else {
+    have_enclosing_if = EmitFieldNonDefaultCondition(printer, "this->", field);
+  }
+  if (utf8_parameters != nullptr) {
+    GenerateUtf8CheckCodeForString(field, options_, false, utf8_parameters,
+                                   format);
+  }
+  format(
+      "ptr = encoder->Write$declared_type$($number$, "
+      "this->_internal_$name$(), ptr);\n");
+  if (have_enclosing_if) {
+    format.Outdent();
+    format("}\n");
+  }
+  format("\n");
+}
+
 void MessageGenerator::GenerateSerializeWithCachedSizesBody(
     io::Printer* printer) {
   Formatter format(printer, variables_);
@@ -3703,7 +3953,7 @@ void MessageGenerator::GenerateByteSize(io::Printer* printer) {
     SetUnknkownFieldsVariable(descriptor_, options_, &vars);
     format.AddMap(vars);
     format(
-        "size_t $classname$::ByteSizeLong() const {\n"
+        "$code_section$size_t $classname$::ByteSizeLong() const {\n"
         "// @@protoc_insertion_point(message_set_byte_size_start:$full_name$)\n"
         "  size_t total_size = _extensions_.MessageSetByteSize();\n"
         "  if ($have_unknown_fields$) {\n"
@@ -3748,7 +3998,7 @@ void MessageGenerator::GenerateByteSize(io::Printer* printer) {
   }
 
   format(
-      "size_t $classname$::ByteSizeLong() const {\n"
+      "$code_section$size_t $classname$::ByteSizeLong() const {\n"
       "// @@protoc_insertion_point(message_byte_size_start:$full_name$)\n");
   format.Indent();
   format(
@@ -3993,11 +4243,19 @@ void MessageGenerator::GenerateIsInitialized(io::Printer* printer) {
         continue;
       } else {
         GOOGLE_CHECK(!field->real_containing_oneof());
-        format(
-            "if (_internal_has_$1$()) {\n"
-            "  if (!$1$_->IsInitialized()) return false;\n"
-            "}\n",
-            FieldName(field));
+        if (IsLazy(field, options_)) {
+          format(
+              "if (_internal_has_$1$()) {\n"
+              "  if (!_internal_$1$().IsInitialized()) return false;\n"
+              "}\n",
+              FieldName(field));
+        } else {
+          format(
+              "if (_internal_has_$1$()) {\n"
+              "  if (!$1$_->IsInitialized()) return false;\n"
+              "}\n",
+              FieldName(field));
+        }
       }
     }
   }
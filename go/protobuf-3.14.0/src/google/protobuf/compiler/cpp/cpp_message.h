@@ -132,6 +132,9 @@ class MessageGenerator {
   void GenerateSerializeWithCachedSizesToArray(io::Printer* printer);
   void GenerateSerializeWithCachedSizesBody(io::Printer* printer);
   void GenerateSerializeWithCachedSizesBodyShuffled(io::Printer* printer);
+  void GenerateSerializeReverse(io::Printer* printer);
+  void GenerateSerializeReverseOneField(io::Printer* printer,
+                                        const FieldDescriptor* field);
   void GenerateByteSize(io::Printer* printer);
   void GenerateMergeFrom(io::Printer* printer);
   void GenerateClassSpecificMergeFrom(io::Printer* printer);
@@ -468,6 +468,168 @@ void MessageFieldGenerator::GenerateByteSize(io::Printer* printer) const {
 
 // ===================================================================
 
+LazyMessageFieldGenerator::LazyMessageFieldGenerator(
+    const FieldDescriptor* descriptor, const Options& options,
+    MessageSCCAnalyzer* scc_analyzer)
+    : MessageFieldGenerator(descriptor, options, scc_analyzer) {
+  GOOGLE_CHECK(!implicit_weak_field_);
+  variables_["prototype"] = "reinterpret_cast<const " + variables_["type"] +
+                            "&>(" + variables_["type_default_instance"] + ")";
+}
+
+LazyMessageFieldGenerator::~LazyMessageFieldGenerator() {}
+
+void LazyMessageFieldGenerator::GeneratePrivateMembers(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format("::$proto_ns$::internal::LazyField $name$_;\n");
+}
+
+void LazyMessageFieldGenerator::GenerateInlineAccessorDefinitions(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format(
+      "inline const $type$& $classname$::_internal_$name$() const {\n"
+      "  return static_cast<const $type$&>(\n"
+      "      $name$_.GetMessage($prototype$));\n"
+      "}\n"
+      "inline const $type$& $classname$::$name$() const {\n"
+      "$annotate_accessor$"
+      "  // @@protoc_insertion_point(field_get:$full_name$)\n"
+      "  return _internal_$name$();\n"
+      "}\n"
+      "inline void $classname$::unsafe_arena_set_allocated_$name$(\n"
+      "    $type$* $name$) {\n"
+      "$annotate_accessor$"
+      "  $name$_.UnsafeArenaSetAllocatedMessage($name$);\n"
+      "  if ($name$) {\n"
+      "    $set_hasbit$\n"
+      "  } else {\n"
+      "    $clear_hasbit$\n"
+      "  }\n"
+      "  // @@protoc_insertion_point(field_unsafe_arena_set_allocated"
+      ":$full_name$)\n"
+      "}\n"
+      "inline $type$* $classname$::$release_name$() {\n"
+      "  $clear_hasbit$\n"
+      "  return static_cast<$type$*>($name$_.ReleaseMessage($prototype$));\n"
+      "}\n"
+      "inline $type$* $classname$::unsafe_arena_release_$name$() {\n"
+      "$annotate_accessor$"
+      "  // @@protoc_insertion_point(field_release:$full_name$)\n"
+      "  $clear_hasbit$\n"
+      "  return static_cast<$type$*>(\n"
+      "      $name$_.UnsafeArenaReleaseMessage($prototype$));\n"
+      "}\n"
+      "inline $type$* $classname$::_internal_mutable_$name$() {\n"
+      "  $set_hasbit$\n"
+      "  return static_cast<$type$*>($name$_.MutableMessage($prototype$));\n"
+      "}\n"
+      "inline $type$* $classname$::mutable_$name$() {\n"
+      "$annotate_accessor$"
+      "  // @@protoc_insertion_point(field_mutable:$full_name$)\n"
+      "  return _internal_mutable_$name$();\n"
+      "}\n"
+      "inline void $classname$::set_allocated_$name$($type$* $name$) {\n"
+      "$annotate_accessor$"
+      "  if ($name$) {\n"
+      "    ::$proto_ns$::Arena* message_arena = GetArena();\n");
+  if (IsCrossFileMessage(descriptor_)) {
+    format(
+        "    ::$proto_ns$::Arena* submessage_arena =\n"
+        "      "
+        "reinterpret_cast<::$proto_ns$::MessageLite*>($name$)->GetArena();\n");
+  } else {
+    format(
+        "    ::$proto_ns$::Arena* submessage_arena =\n"
+        "      ::$proto_ns$::Arena::GetArena($name$);\n");
+  }
+  format(
+      "    if (message_arena != submessage_arena) {\n"
+      "      $name$ = ::$proto_ns$::internal::GetOwnedMessage(\n"
+      "          message_arena, $name$, submessage_arena);\n"
+      "    }\n"
+      "    $set_hasbit$\n"
+      "  } else {\n"
+      "    $clear_hasbit$\n"
+      "  }\n"
+      "  $name$_.SetAllocatedMessage($name$);\n"
+      "  // @@protoc_insertion_point(field_set_allocated:$full_name$)\n"
+      "}\n");
+}
+
+void LazyMessageFieldGenerator::GenerateInternalAccessorDefinitions(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format(
+      "const $type$&\n"
+      "$classname$::_Internal::$name$(const $classname$* msg) {\n"
+      "  return msg->_internal_$name$();\n"
+      "}\n");
+}
+
+void LazyMessageFieldGenerator::GenerateClearingCode(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format("$name$_.Clear();\n");
+}
+
+void LazyMessageFieldGenerator::GenerateMessageClearingCode(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format("$name$_.Clear();\n");
+}
+
+void LazyMessageFieldGenerator::GenerateMergingCode(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  // Merging keeps the source bytes unparsed where possible.
+  format(
+      "$set_hasbit$\n"
+      "$name$_.MergeFrom($prototype$, from.$name$_);\n");
+}
+
+void LazyMessageFieldGenerator::GenerateSwappingCode(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format("$name$_.Swap(&other->$name$_);\n");
+}
+
+void LazyMessageFieldGenerator::GenerateDestructorCode(
+    io::Printer* printer) const {
+  // LazyField frees its contents in its own destructor.
+}
+
+void LazyMessageFieldGenerator::GenerateConstructorCode(
+    io::Printer* printer) const {
+  // LazyField is initialized by its own constructor.
+}
+
+void LazyMessageFieldGenerator::GenerateCopyConstructorCode(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format(
+      "if (from._internal_has_$name$()) {\n"
+      "  $name$_.MergeFrom($prototype$, from.$name$_);\n"
+      "}\n");
+}
+
+void LazyMessageFieldGenerator::GenerateSerializeWithCachedSizesToArray(
+    io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format("target = $name$_.InternalSerialize($number$, target, stream);\n");
+}
+
+void LazyMessageFieldGenerator::GenerateByteSize(io::Printer* printer) const {
+  Formatter format(printer, variables_);
+  format(
+      "total_size += $tag_size$ +\n"
+      "  ::$proto_ns$::internal::WireFormatLite::LengthDelimitedSize(\n"
+      "    $name$_.ByteSizeLong());\n");
+}
+
+// ===================================================================
+
 MessageOneofFieldGenerator::MessageOneofFieldGenerator(
     const FieldDescriptor* descriptor, const Options& options,
     MessageSCCAnalyzer* scc_analyzer)
@@ -99,6 +99,33 @@ class MessageOneofFieldGenerator : public MessageFieldGenerator {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessageOneofFieldGenerator);
 };
 
+// Generates a singular message field stored in an internal::LazyField, which
+// keeps the serialized bytes of the sub-message until it is accessed.
+class LazyMessageFieldGenerator : public MessageFieldGenerator {
+ public:
+  LazyMessageFieldGenerator(const FieldDescriptor* descriptor,
+                            const Options& options,
+                            MessageSCCAnalyzer* scc_analyzer);
+  ~LazyMessageFieldGenerator();
+
+  // implements FieldGenerator ---------------------------------------
+  void GeneratePrivateMembers(io::Printer* printer) const;
+  void GenerateInlineAccessorDefinitions(io::Printer* printer) const;
+  void GenerateInternalAccessorDefinitions(io::Printer* printer) const;
+  void GenerateClearingCode(io::Printer* printer) const;
+  void GenerateMessageClearingCode(io::Printer* printer) const;
+  void GenerateMergingCode(io::Printer* printer) const;
+  void GenerateSwappingCode(io::Printer* printer) const;
+  void GenerateDestructorCode(io::Printer* printer) const;
+  void GenerateConstructorCode(io::Printer* printer) const;
+  void GenerateCopyConstructorCode(io::Printer* printer) const;
+  void GenerateSerializeWithCachedSizesToArray(io::Printer* printer) const;
+  void GenerateByteSize(io::Printer* printer) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(LazyMessageFieldGenerator);
+};
+
 class RepeatedMessageFieldGenerator : public FieldGenerator {
  public:
   RepeatedMessageFieldGenerator(const FieldDescriptor* descriptor,
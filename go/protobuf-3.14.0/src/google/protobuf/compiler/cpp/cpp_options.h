@@ -69,6 +69,7 @@ struct Options {
   std::string annotation_pragma_name;
   std::string annotation_guard_name;
   const AccessInfoMap* access_info_map = nullptr;
+  bool code_sections = false;
 };
 
 }  // namespace cpp
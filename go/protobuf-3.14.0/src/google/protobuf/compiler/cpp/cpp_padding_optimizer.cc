@@ -30,6 +30,9 @@
 
 #include <google/protobuf/compiler/cpp/cpp_padding_optimizer.h>
 
+#include <algorithm>
+
+#include <google/protobuf/compiler/access_info_map.h>
 #include <google/protobuf/compiler/cpp/cpp_helpers.h>
 
 namespace google {
@@ -83,8 +86,6 @@ class FieldGroup {
   // used in a vector.
 };
 
-}  // namespace
-
 // Reorder 'fields' so that if the fields are output into a c++ class in the new
 // order, fields of similar family (see below) are together and within each
 // family, alignment padding is minimized.
@@ -117,8 +118,8 @@ class FieldGroup {
 // ZERO_INITIALIZABLE is memset in Clear/SharedCtor
 //
 // OTHER these fields are initialized one-by-one.
-void PaddingOptimizer::OptimizeLayout(
-    std::vector<const FieldDescriptor*>* fields, const Options& options) {
+void OptimizePadding(std::vector<const FieldDescriptor*>* fields,
+                     const Options& options) {
   // The sorted numeric order of Family determines the declaration order in the
   // memory layout.
   enum Family {
@@ -221,6 +222,79 @@ void PaddingOptimizer::OptimizeLayout(
   }
 }
 
+// Estimated size of the member holding "field" in the generated class.
+int EstimateFieldSize(const FieldDescriptor* field) {
+  if (field->is_map()) {
+    return 64;
+  } else if (field->is_repeated()) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING:
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return 24;  // RepeatedPtrField
+      default:
+        return 16;  // RepeatedField
+    }
+  }
+  return EstimateAlignmentSize(field);
+}
+
+}  // namespace
+
+// Bytes of the first cache line left for fields once the vtable pointer,
+// _internal_metadata_, _has_bits_ and _cached_size_ are accounted for.
+static const int kHotFieldBytes = 32;
+
+void PaddingOptimizer::OptimizeLayout(
+    std::vector<const FieldDescriptor*>* fields, const Options& options) {
+  const AccessInfoMap* access_info_map = options.access_info_map;
+  if (access_info_map == nullptr || fields->empty() ||
+      !access_info_map->HasProfile((*fields)[0]->containing_type())) {
+    OptimizePadding(fields, options);
+    return;
+  }
+
+  // With a profile, split the fields into three tiers laid out one after the
+  // other: the hottest fields that fit in the first cache line, the cold
+  // fields at the very end, and everything else in between.  Each tier is
+  // then ordered to minimize padding as usual.
+  std::vector<const FieldDescriptor*> hot_candidates;
+  std::vector<const FieldDescriptor*> hot;
+  std::vector<const FieldDescriptor*> warm;
+  std::vector<const FieldDescriptor*> cold;
+  for (auto field : *fields) {
+    if (access_info_map->IsHot(field)) {
+      hot_candidates.push_back(field);
+    } else if (access_info_map->IsCold(field, kColdRatio)) {
+      cold.push_back(field);
+    } else {
+      warm.push_back(field);
+    }
+  }
+
+  std::stable_sort(hot_candidates.begin(), hot_candidates.end(),
+                   [access_info_map](const FieldDescriptor* a,
+                                     const FieldDescriptor* b) {
+                     return access_info_map->GetHotCount(a) >
+                            access_info_map->GetHotCount(b);
+                   });
+  int hot_bytes = 0;
+  for (auto field : hot_candidates) {
+    int size = EstimateFieldSize(field);
+    if (hot_bytes + size <= kHotFieldBytes) {
+      hot.push_back(field);
+      hot_bytes += size;
+    } else {
+      warm.push_back(field);
+    }
+  }
+
+  fields->clear();
+  for (auto tier : {&hot, &warm, &cold}) {
+    OptimizePadding(tier, options);
+    fields->insert(fields->end(), tier->begin(), tier->end());
+  }
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
@@ -47,11 +47,21 @@ namespace cpp {
 // For example, grouping four boolean fields and one int32
 // field results in zero padding overhead. See OptimizeLayout's
 // comment for details.
+//
+// If Options::access_info_map has a profile for the message, the hottest
+// fields are moved to the first cache line of the object and the cold ones to
+// the end, and padding is minimized within each of those groups.
 class PaddingOptimizer : public MessageLayoutHelper {
  public:
   PaddingOptimizer() {}
   ~PaddingOptimizer() override {}
 
+  // Fields accessed at most this fraction as often as the most accessed field
+  // of their message are cold.  ColdChunkSkipper uses the same threshold, so
+  // the fields laid out at the end are also the ones whose Clear() and
+  // MergeFrom() code is skipped as a block.
+  static constexpr double kColdRatio = 0.005;
+
   void OptimizeLayout(std::vector<const FieldDescriptor*>* fields,
                       const Options& options) override;
 };
@@ -0,0 +1,207 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/compiler/cpp/cpp_padding_optimizer.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/compiler/access_info_map.h>
+#include <google/protobuf/compiler/cpp/cpp_helpers.h>
+#include <google/protobuf/compiler/cpp/cpp_options.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/descriptor.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+namespace {
+
+// The fields the message generator hands to the layout helper.
+std::vector<const FieldDescriptor*> LayoutFields(const Descriptor* descriptor) {
+  std::vector<const FieldDescriptor*> fields;
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->real_containing_oneof() == nullptr) fields.push_back(field);
+  }
+  return fields;
+}
+
+std::vector<const FieldDescriptor*> Layout(const AccessInfoMap* map) {
+  std::vector<const FieldDescriptor*> fields =
+      LayoutFields(protobuf_unittest::TestAllTypes::descriptor());
+  Options options;
+  options.access_info_map = map;
+  PaddingOptimizer().OptimizeLayout(&fields, options);
+  return fields;
+}
+
+std::set<std::string> Names(std::vector<const FieldDescriptor*>::iterator begin,
+                            std::vector<const FieldDescriptor*>::iterator end) {
+  std::set<std::string> names;
+  for (auto it = begin; it != end; ++it) names.insert((*it)->name());
+  return names;
+}
+
+const FieldDescriptor* Field(const std::string& name) {
+  return protobuf_unittest::TestAllTypes::descriptor()->FindFieldByName(name);
+}
+
+TEST(AccessInfoMapTest, Parse) {
+  AccessInfoMap map;
+  std::string error;
+  ASSERT_TRUE(map.Parse(
+      "# comment\n"
+      "\n"
+      "protobuf_unittest.TestAllTypes.optional_int32 100 3  # trailing\n"
+      "protobuf_unittest.TestAllTypes.optional_int64\t7\n"
+      "protobuf_unittest.TestAllTypes.optional_int32 1 2\n",
+      &error))
+      << error;
+
+  EXPECT_TRUE(map.HasProfile(protobuf_unittest::TestAllTypes::descriptor()));
+  EXPECT_FALSE(map.HasProfile(protobuf_unittest::TestPackedTypes::descriptor()));
+  EXPECT_EQ(101, map.GetHotCount(Field("optional_int32")));
+  EXPECT_EQ(5, map.GetColdCount(Field("optional_int32")));
+  EXPECT_EQ(7, map.GetHotCount(Field("optional_int64")));
+  EXPECT_EQ(0, map.GetColdCount(Field("optional_int64")));
+  EXPECT_TRUE(map.IsHot(Field("optional_int64")));
+  EXPECT_FALSE(map.IsHot(Field("optional_uint32")));
+  EXPECT_FALSE(map.IsCold(Field("optional_int64"), 0.05));
+  EXPECT_TRUE(map.IsCold(Field("optional_int64"), 0.1));
+  EXPECT_TRUE(map.IsCold(Field("optional_uint32"), 0));
+}
+
+TEST(AccessInfoMapTest, ParseError) {
+  AccessInfoMap map;
+  std::string error;
+  EXPECT_FALSE(map.Parse(
+      "protobuf_unittest.TestAllTypes.optional_int32 1\n"
+      "protobuf_unittest.TestAllTypes.optional_int64 many\n",
+      &error));
+  EXPECT_EQ(0, error.find("line 2:")) << error;
+  // A failed parse leaves the map untouched.
+  EXPECT_FALSE(map.HasProfile(protobuf_unittest::TestAllTypes::descriptor()));
+
+  EXPECT_FALSE(map.Parse("optional_int32 1\n", &error));
+  EXPECT_FALSE(map.Parse("protobuf_unittest.TestAllTypes.optional_int32\n",
+                         &error));
+  EXPECT_FALSE(map.Parse("protobuf_unittest.TestAllTypes.optional_int32 1 2 3\n",
+                         &error));
+}
+
+TEST(CodeSectionTest, FollowsProfile) {
+  AccessInfoMap map;
+  std::string error;
+  ASSERT_TRUE(
+      map.Parse("protobuf_unittest.TestAllTypes.optional_int32 10\n"
+                "protobuf_unittest.TestPackedTypes.packed_int32 0 10\n",
+                &error))
+      << error;
+  Options options;
+  options.access_info_map = &map;
+
+  // Nothing is marked unless the option is set.
+  EXPECT_EQ("", MessageCodeSection(
+                    protobuf_unittest::TestAllTypes::descriptor(), options));
+  EXPECT_EQ("", DescriptorCodeSection(options));
+
+  options.code_sections = true;
+  EXPECT_EQ("PROTOBUF_SECTION_HOT ",
+            MessageCodeSection(protobuf_unittest::TestAllTypes::descriptor(),
+                               options));
+  EXPECT_EQ("PROTOBUF_SECTION_COLD ",
+            MessageCodeSection(
+                protobuf_unittest::TestPackedTypes::descriptor(), options));
+  EXPECT_EQ("", MessageCodeSection(
+                    protobuf_unittest::TestUnpackedTypes::descriptor(),
+                    options));
+  EXPECT_EQ("PROTOBUF_SECTION_COLD ", DescriptorCodeSection(options));
+}
+
+TEST(PaddingOptimizerTest, UnprofiledMessageKeepsLayout) {
+  AccessInfoMap map;
+  std::string error;
+  ASSERT_TRUE(
+      map.Parse("protobuf_unittest.TestPackedTypes.packed_int32 10\n", &error));
+  EXPECT_EQ(Layout(nullptr), Layout(&map));
+}
+
+TEST(PaddingOptimizerTest, HotFieldsFirstColdFieldsLast) {
+  AccessInfoMap map;
+  std::string error;
+  ASSERT_TRUE(map.Parse(
+      "protobuf_unittest.TestAllTypes.optional_string 500 10\n"
+      "protobuf_unittest.TestAllTypes.optional_int32 1000\n"
+      "protobuf_unittest.TestAllTypes.optional_bool 800\n"
+      "protobuf_unittest.TestAllTypes.repeated_int64 0 100000\n",
+      &error));
+
+  std::vector<const FieldDescriptor*> fields = Layout(&map);
+  ASSERT_EQ(Layout(nullptr).size(), fields.size());
+  EXPECT_EQ((std::set<std::string>{"optional_string", "optional_int32",
+                                   "optional_bool"}),
+            Names(fields.begin(), fields.begin() + 3));
+  // Not hot, but accessed too often to be cold.
+  EXPECT_EQ("repeated_int64", fields[3]->name());
+  for (int i = 4; i < fields.size(); i++) {
+    EXPECT_TRUE(map.IsCold(fields[i], PaddingOptimizer::kColdRatio))
+        << fields[i]->name();
+  }
+}
+
+TEST(PaddingOptimizerTest, HotFieldsLimitedToFirstCacheLine) {
+  AccessInfoMap map;
+  std::string error;
+  ASSERT_TRUE(map.Parse(
+      "protobuf_unittest.TestAllTypes.optional_int64 5\n"
+      "protobuf_unittest.TestAllTypes.optional_uint64 4\n"
+      "protobuf_unittest.TestAllTypes.optional_double 3\n"
+      "protobuf_unittest.TestAllTypes.optional_string 2\n"
+      "protobuf_unittest.TestAllTypes.optional_bytes 1\n",
+      &error));
+
+  std::vector<const FieldDescriptor*> fields = Layout(&map);
+  EXPECT_EQ((std::set<std::string>{"optional_int64", "optional_uint64",
+                                   "optional_double", "optional_string"}),
+            Names(fields.begin(), fields.begin() + 4));
+  // The least hot field no longer fits and goes in front of the cold ones.
+  EXPECT_EQ("optional_bytes", fields[4]->name());
+}
+
+}  // namespace
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -96,6 +96,14 @@ int ProtobufMain(int argc, char* argv[]) {
   cli.RegisterGenerator("--js_out", "--js_opt", &js_generator,
                         "Generate JavaScript source.");
 
+  // These generators only implement Generate(), so --jobs can run them on
+  // each file separately.
+  cli.SetPerFileGenerator("--cpp_out");
+  cli.SetPerFileGenerator("--java_out");
+  cli.SetPerFileGenerator("--python_out");
+  cli.SetPerFileGenerator("--ruby_out");
+  cli.SetPerFileGenerator("--csharp_out");
+
   return cli.Run(argc, argv);
 }
 
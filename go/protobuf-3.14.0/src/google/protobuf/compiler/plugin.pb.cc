@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -358,8 +359,14 @@ const char* Version::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::in
       // optional string suffix = 4;
       case 4:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 34)) {
-          auto str = _internal_mutable_suffix();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_suffix(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &suffix_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(suffix_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &suffix_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.Version.suffix");
           #endif  // !NDEBUG
@@ -432,6 +439,40 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Version::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional string suffix = 4;
+  if (_internal_has_suffix()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_suffix().data(), static_cast<int>(this->_internal_suffix().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.Version.suffix");
+    ptr = encoder->WriteString(4, this->_internal_suffix(), ptr);
+  }
+
+  // optional int32 patch = 3;
+  if (_internal_has_patch()) {
+    ptr = encoder->WriteInt32(3, this->_internal_patch(), ptr);
+  }
+
+  // optional int32 minor = 2;
+  if (_internal_has_minor()) {
+    ptr = encoder->WriteInt32(2, this->_internal_minor(), ptr);
+  }
+
+  // optional int32 major = 1;
+  if (_internal_has_major()) {
+    ptr = encoder->WriteInt32(1, this->_internal_major(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Version::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.compiler.Version)
   size_t total_size = 0;
@@ -507,14 +548,20 @@ void Version::MergeFrom(const Version& from) {
     if (cached_has_bits & 0x00000001u) {
       _internal_set_suffix(from._internal_suffix());
     }
-    if (cached_has_bits & 0x00000002u) {
-      major_ = from.major_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      minor_ = from.minor_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      patch_ = from.patch_;
+    if ((cached_has_bits & 0x0000000eu) == 0x0000000eu) {
+      ::memcpy(&major_, &from.major_,
+        static_cast<size_t>(reinterpret_cast<char*>(&patch_) -
+        reinterpret_cast<char*>(&major_)) + sizeof(patch_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        major_ = from.major_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        minor_ = from.minor_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        patch_ = from.patch_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -686,8 +733,14 @@ const char* CodeGeneratorRequest::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string parameter = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_parameter();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_parameter(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &parameter_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(parameter_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &parameter_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.CodeGeneratorRequest.parameter");
           #endif  // !NDEBUG
@@ -787,6 +840,44 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* CodeGeneratorRequest::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.FileDescriptorProto proto_file = 15;
+  for (int i = this->_internal_proto_file_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(15, this->_internal_proto_file(i), ptr);
+  }
+
+  // optional .google.protobuf.compiler.Version compiler_version = 3;
+  if (_internal_has_compiler_version()) {
+    ptr = encoder->WriteMessage(3, this->_internal_compiler_version(), ptr);
+  }
+
+  // optional string parameter = 2;
+  if (_internal_has_parameter()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_parameter().data(), static_cast<int>(this->_internal_parameter().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorRequest.parameter");
+    ptr = encoder->WriteString(2, this->_internal_parameter(), ptr);
+  }
+
+  // repeated string file_to_generate = 1;
+  for (int i = this->_internal_file_to_generate_size() - 1; i >= 0; i--) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_file_to_generate(i).data(), static_cast<int>(this->_internal_file_to_generate(i).length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorRequest.file_to_generate");
+    ptr = encoder->WriteString(1, this->_internal_file_to_generate(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t CodeGeneratorRequest::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.compiler.CodeGeneratorRequest)
   size_t total_size = 0;
@@ -1040,8 +1131,14 @@ const char* CodeGeneratorResponse_File::_InternalParse(const char* ptr, ::PROTOB
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.CodeGeneratorResponse.File.name");
           #endif  // !NDEBUG
@@ -1051,8 +1148,14 @@ const char* CodeGeneratorResponse_File::_InternalParse(const char* ptr, ::PROTOB
       // optional string insertion_point = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_insertion_point();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_insertion_point(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &insertion_point_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(insertion_point_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &insertion_point_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.CodeGeneratorResponse.File.insertion_point");
           #endif  // !NDEBUG
@@ -1062,8 +1165,14 @@ const char* CodeGeneratorResponse_File::_InternalParse(const char* ptr, ::PROTOB
       // optional string content = 15;
       case 15:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 122)) {
-          auto str = _internal_mutable_content();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_content(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &content_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(content_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &content_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.CodeGeneratorResponse.File.content");
           #endif  // !NDEBUG
@@ -1153,6 +1262,48 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* CodeGeneratorResponse_File::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional .google.protobuf.GeneratedCodeInfo generated_code_info = 16;
+  if (_internal_has_generated_code_info()) {
+    ptr = encoder->WriteMessage(16, this->_internal_generated_code_info(), ptr);
+  }
+
+  // optional string content = 15;
+  if (_internal_has_content()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_content().data(), static_cast<int>(this->_internal_content().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorResponse.File.content");
+    ptr = encoder->WriteString(15, this->_internal_content(), ptr);
+  }
+
+  // optional string insertion_point = 2;
+  if (_internal_has_insertion_point()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_insertion_point().data(), static_cast<int>(this->_internal_insertion_point().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorResponse.File.insertion_point");
+    ptr = encoder->WriteString(2, this->_internal_insertion_point(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorResponse.File.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t CodeGeneratorResponse_File::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.compiler.CodeGeneratorResponse.File)
   size_t total_size = 0;
@@ -1366,8 +1517,14 @@ const char* CodeGeneratorResponse::_InternalParse(const char* ptr, ::PROTOBUF_NA
       // optional string error = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_error();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_error(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &error_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(error_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &error_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.compiler.CodeGeneratorResponse.error");
           #endif  // !NDEBUG
@@ -1456,6 +1613,35 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* CodeGeneratorResponse::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.compiler.CodeGeneratorResponse.File file = 15;
+  for (int i = this->_internal_file_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(15, this->_internal_file(i), ptr);
+  }
+
+  // optional uint64 supported_features = 2;
+  if (_internal_has_supported_features()) {
+    ptr = encoder->WriteUInt64(2, this->_internal_supported_features(), ptr);
+  }
+
+  // optional string error = 1;
+  if (_internal_has_error()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_error().data(), static_cast<int>(this->_internal_error().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.compiler.CodeGeneratorResponse.error");
+    ptr = encoder->WriteString(1, this->_internal_error(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t CodeGeneratorResponse::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.compiler.CodeGeneratorResponse)
   size_t total_size = 0;
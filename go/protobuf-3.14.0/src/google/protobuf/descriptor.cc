@@ -35,6 +35,7 @@
 #include <google/protobuf/descriptor.h>
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <map>
@@ -467,6 +468,93 @@ typedef std::map<DescriptorIntPair, const FieldDescriptor*>
 typedef HASH_MAP<std::string, const SourceCodeInfo_Location*>
     LocationsByPathMap;
 
+// An insert-only open-addressing hash table of the symbols a pool has
+// committed, readable without any lock.  Committed symbols are never removed
+// or changed, so a reader that finds a name here gets the same answer the
+// locked tables would give.  Writers must be serialized by the caller (the
+// pool's mutex_).  When the table grows, the old arrays are kept until the
+// table is destroyed, because readers may still be probing them; since the
+// capacity doubles each time, this at most doubles the memory used.
+class PublishedSymbolTable {
+ public:
+  PublishedSymbolTable() : slots_(nullptr), size_(0) {}
+
+  Symbol Find(StringPiece name) const {
+    const Slots* slots = slots_.load(std::memory_order_acquire);
+    if (slots == nullptr) return kNullSymbol;
+    size_t name_hash = HASH_FXN<StringPiece>()(name);
+    size_t mask = slots->capacity - 1;
+    for (size_t i = name_hash & mask;; i = (i + 1) & mask) {
+      const Slot& slot = slots->slots[i];
+      const char* key = slot.name.load(std::memory_order_acquire);
+      if (key == nullptr) return kNullSymbol;
+      if (slot.hash == name_hash && name == key) return slot.symbol;
+    }
+  }
+
+  // The name must outlive the table.
+  void Insert(const char* name, Symbol symbol) {
+    const Slots* slots = slots_.load(std::memory_order_relaxed);
+    if (slots == nullptr || (size_ + 1) * 2 > slots->capacity) {
+      slots = Grow(slots == nullptr ? 64 : slots->capacity * 2);
+    }
+    InsertInto(const_cast<Slots*>(slots), name,
+               HASH_FXN<StringPiece>()(name), symbol);
+    ++size_;
+  }
+
+ private:
+  struct Slot {
+    Slot() : name(nullptr), hash(0) {}
+    // Written last, with release semantics, so that a reader which sees a
+    // non-null name also sees hash and symbol.
+    std::atomic<const char*> name;
+    size_t hash;
+    Symbol symbol;
+  };
+  struct Slots {
+    explicit Slots(size_t n) : capacity(n), slots(new Slot[n]) {}
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  static void InsertInto(Slots* slots, const char* name, size_t hash,
+                         Symbol symbol) {
+    size_t mask = slots->capacity - 1;
+    size_t i = hash & mask;
+    while (slots->slots[i].name.load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & mask;
+    }
+    Slot& slot = slots->slots[i];
+    slot.hash = hash;
+    slot.symbol = symbol;
+    slot.name.store(name, std::memory_order_release);
+  }
+
+  const Slots* Grow(size_t capacity) {
+    std::unique_ptr<Slots> grown(new Slots(capacity));
+    if (!all_slots_.empty()) {
+      const Slots& old = *all_slots_.back();
+      for (size_t i = 0; i < old.capacity; i++) {
+        const Slot& slot = old.slots[i];
+        const char* name = slot.name.load(std::memory_order_relaxed);
+        if (name != nullptr) {
+          InsertInto(grown.get(), name, slot.hash, slot.symbol);
+        }
+      }
+    }
+    slots_.store(grown.get(), std::memory_order_release);
+    all_slots_.push_back(std::move(grown));
+    return all_slots_.back().get();
+  }
+
+  std::atomic<const Slots*> slots_;
+  size_t size_;
+  std::vector<std::unique_ptr<Slots>> all_slots_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(PublishedSymbolTable);
+};
+
 std::set<std::string>* NewAllowedProto3Extendee() {
   auto allowed_proto3_extendees = new std::set<std::string>;
   const char* kOptionNames[] = {
@@ -571,6 +659,11 @@ class DescriptorPool::Tables {
   // so the overhead is small.
   HASH_MAP<std::string, Descriptor::WellKnownType> well_known_types_;
 
+  // Whether committed symbols are copied to published_symbols_ so that
+  // FindPublishedSymbol() can find them without taking the pool's mutex_.
+  // Only set for pools that have a mutex_.
+  bool publish_symbols_;
+
   // -----------------------------------------------------------------
   // Finding items.
 
@@ -578,6 +671,11 @@ class DescriptorPool::Tables {
   // if not found.
   inline Symbol FindSymbol(StringPiece key) const;
 
+  // Like FindSymbol(), but only finds committed symbols, and may be called
+  // without holding the pool's mutex_.  Always returns a null Symbol unless
+  // publish_symbols_ is set.
+  inline Symbol FindPublishedSymbol(StringPiece key) const;
+
   // This implements the body of DescriptorPool::Find*ByName().  It should
   // really be a private method of DescriptorPool, but that would require
   // declaring Symbol in descriptor.h, which would drag all kinds of other
@@ -648,6 +746,7 @@ class DescriptorPool::Tables {
   std::vector<std::unique_ptr<FileDescriptorTables>> file_tables_;
 
   SymbolsByNameMap symbols_by_name_;
+  PublishedSymbolTable published_symbols_;
   FilesByNameMap files_by_name_;
   ExtensionsGroupedByDescriptorMap extensions_;
 
@@ -791,6 +890,7 @@ DescriptorPool::Tables::Tables()
     : known_bad_files_(3),
       known_bad_symbols_(3),
       extensions_loaded_from_db_(3),
+      publish_symbols_(false),
       symbols_by_name_(3),
       files_by_name_(3) {
   well_known_types_.insert({
@@ -845,6 +945,11 @@ void DescriptorPool::Tables::ClearLastCheckpoint() {
   if (checkpoints_.empty()) {
     // All checkpoints have been cleared: we can now commit all of the pending
     // data.
+    if (publish_symbols_) {
+      for (const char* name : symbols_after_checkpoint_) {
+        published_symbols_.Insert(name, FindSymbol(name));
+      }
+    }
     symbols_after_checkpoint_.clear();
     files_after_checkpoint_.clear();
     extensions_after_checkpoint_.clear();
@@ -893,6 +998,11 @@ inline Symbol DescriptorPool::Tables::FindSymbol(StringPiece key) const {
   }
 }
 
+inline Symbol DescriptorPool::Tables::FindPublishedSymbol(
+    StringPiece key) const {
+  return published_symbols_.Find(key);
+}
+
 inline Symbol FileDescriptorTables::FindNestedSymbol(
     const void* parent, StringPiece name) const {
   const Symbol* result =
@@ -914,12 +1024,11 @@ inline Symbol FileDescriptorTables::FindNestedSymbolOfType(
 Symbol DescriptorPool::Tables::FindByNameHelper(const DescriptorPool* pool,
                                                 StringPiece name) {
   if (pool->mutex_ != nullptr) {
-    // Fast path: the Symbol is already cached.  This is just a hash lookup.
-    ReaderMutexLock lock(pool->mutex_);
-    if (known_bad_symbols_.empty() && known_bad_files_.empty()) {
-      Symbol result = FindSymbol(name);
-      if (!result.IsNull()) return result;
-    }
+    // Fast path: the Symbol is already built and committed.  This is just a
+    // hash lookup, and takes no lock, so that many threads can look up
+    // symbols at once.
+    Symbol result = FindPublishedSymbol(name);
+    if (!result.IsNull()) return result;
   }
   MutexLockMaybe lock(pool->mutex_);
   if (pool->fallback_database_ != nullptr) {
@@ -1268,7 +1377,9 @@ DescriptorPool::DescriptorPool(DescriptorDatabase* fallback_database,
       lazily_build_dependencies_(false),
       allow_unknown_(false),
       enforce_weak_(false),
-      disallow_enforce_utf8_(false) {}
+      disallow_enforce_utf8_(false) {
+  tables_->publish_symbols_ = true;
+}
 
 DescriptorPool::DescriptorPool(const DescriptorPool* underlay)
     : mutex_(nullptr),
@@ -1364,11 +1475,20 @@ void DescriptorPool::InternalAddGeneratedFile(
   // FileDescriptorProto and generates a FileDescriptor (and all its children)
   // based on it.
   //
+  // We don't even parse the bytes here.  A binary may link thousands of
+  // generated files, so the database only reads a file's name when the pool
+  // asks for some file by name, and only indexes the files' symbols when the
+  // pool asks for a symbol or extension it hasn't built.  Together with
+  // lazily_build_dependencies_, this means that GetDescriptor() parses and
+  // builds its own file and just the dependencies that are actually used.
+  // The price is that a corrupt or conflicting file is logged when it is
+  // indexed instead of failing a CHECK here.
+  //
   // Note that FileDescriptorProto is itself a generated protocol message.
   // Therefore, when we parse one, we have to be very careful to avoid using
   // any descriptor-based operations, since this might cause infinite recursion
   // or deadlock.
-  GOOGLE_CHECK(GeneratedDatabase()->Add(encoded_file_descriptor, size));
+  GeneratedDatabase()->AddLazily(encoded_file_descriptor, size);
 }
 
 
@@ -1400,12 +1520,14 @@ const FileDescriptor* DescriptorPool::FindFileByName(
 
 const FileDescriptor* DescriptorPool::FindFileContainingSymbol(
     ConstStringParam symbol_name) const {
+  Symbol result = tables_->FindPublishedSymbol(symbol_name);
+  if (!result.IsNull()) return result.GetFile();
   MutexLockMaybe lock(mutex_);
   if (fallback_database_ != nullptr) {
     tables_->known_bad_symbols_.clear();
     tables_->known_bad_files_.clear();
   }
-  Symbol result = tables_->FindSymbol(symbol_name);
+  result = tables_->FindSymbol(symbol_name);
   if (!result.IsNull()) return result.GetFile();
   if (underlay_ != nullptr) {
     const FileDescriptor* file_result =
@@ -3584,6 +3706,70 @@ const FileDescriptor* DescriptorPool::BuildFileCollectingErrors(
       .BuildFile(proto);
 }
 
+namespace {
+
+// Appends protos[index] to |order| after the files of the set it imports.
+// |state| is 0 for files not visited yet, 1 while their imports are being
+// visited and 2 once they are in |order|.  An import cycle is cut where it is
+// found; building the file then reports the missing import.
+void AddFileInDependencyOrder(
+    const std::vector<const FileDescriptorProto*>& protos,
+    const std::unordered_map<std::string, int>& index_by_name, int index,
+    std::vector<int>* state, std::vector<int>* order) {
+  if ((*state)[index] != 0) return;
+  (*state)[index] = 1;
+  const FileDescriptorProto& proto = *protos[index];
+  for (int i = 0; i < proto.dependency_size(); i++) {
+    auto it = index_by_name.find(proto.dependency(i));
+    if (it != index_by_name.end()) {
+      AddFileInDependencyOrder(protos, index_by_name, it->second, state,
+                               order);
+    }
+  }
+  (*state)[index] = 2;
+  order->push_back(index);
+}
+
+}  // namespace
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFiles(
+    const std::vector<const FileDescriptorProto*>& protos,
+    ErrorCollector* error_collector) {
+  GOOGLE_CHECK(fallback_database_ == nullptr)
+      << "Cannot call BuildFiles on a DescriptorPool that uses a "
+         "DescriptorDatabase.  You must instead find a way to get your files "
+         "into the underlying database.";
+  GOOGLE_CHECK(mutex_ == nullptr);  // Implied by the above GOOGLE_CHECK.
+  tables_->known_bad_symbols_.clear();
+  tables_->known_bad_files_.clear();
+
+  std::unordered_map<std::string, int> index_by_name;
+  for (int i = 0; i < protos.size(); i++) {
+    index_by_name.insert(std::make_pair(protos[i]->name(), i));
+  }
+  std::vector<int> state(protos.size(), 0);
+  std::vector<int> order;
+  order.reserve(protos.size());
+  for (int i = 0; i < protos.size(); i++) {
+    AddFileInDependencyOrder(protos, index_by_name, i, &state, &order);
+  }
+
+  // The files built below only become permanent when this outer checkpoint
+  // is cleared, so a failure in any of them rolls back the whole set.
+  std::vector<const FileDescriptor*> result(protos.size(), nullptr);
+  tables_->AddCheckpoint();
+  for (int index : order) {
+    result[index] = DescriptorBuilder(this, tables_.get(), error_collector)
+                        .BuildFile(*protos[index]);
+    if (result[index] == nullptr) {
+      tables_->RollbackToLastCheckpoint();
+      return std::vector<const FileDescriptor*>();
+    }
+  }
+  tables_->ClearLastCheckpoint();
+  return result;
+}
+
 const FileDescriptor* DescriptorPool::BuildFileFromDatabase(
     const FileDescriptorProto& proto) const {
   mutex_->AssertHeld();
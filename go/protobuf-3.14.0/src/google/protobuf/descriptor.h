@@ -1781,6 +1781,17 @@ class PROTOBUF_EXPORT DescriptorPool {
   const FileDescriptor* BuildFileCollectingErrors(
       const FileDescriptorProto& proto, ErrorCollector* error_collector);
 
+  // Builds a set of files at once.  The files may be given in any order:
+  // each one is built after the files in the set that it imports.  Imports
+  // that are not part of the set must already be in the pool.  If every file
+  // builds, returns their FileDescriptors in the same order as |protos|.
+  // Otherwise none of the files is added to the pool and an empty vector is
+  // returned.  Errors are sent to |error_collector|, or to GOOGLE_LOG(ERROR)
+  // if it is nullptr.
+  std::vector<const FileDescriptor*> BuildFiles(
+      const std::vector<const FileDescriptorProto*>& protos,
+      ErrorCollector* error_collector = nullptr);
+
   // By default, it is an error if a FileDescriptorProto contains references
   // to types or other files that are not found in the DescriptorPool (or its
   // backing DescriptorDatabase, if any).  If you call
@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -1467,6 +1468,21 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* FileDescriptorSet::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.FileDescriptorProto file = 1;
+  for (int i = this->_internal_file_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(1, this->_internal_file(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t FileDescriptorSet::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.FileDescriptorSet)
   size_t total_size = 0;
@@ -1719,8 +1735,14 @@ const char* FileDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileDescriptorProto.name");
           #endif  // !NDEBUG
@@ -1730,8 +1752,14 @@ const char* FileDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional string package = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_package();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_package(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &package_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(package_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &package_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileDescriptorProto.package");
           #endif  // !NDEBUG
@@ -1849,8 +1877,14 @@ const char* FileDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional string syntax = 12;
       case 12:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 98)) {
-          auto str = _internal_mutable_syntax();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_syntax(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &syntax_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(syntax_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &syntax_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileDescriptorProto.syntax");
           #endif  // !NDEBUG
@@ -1995,6 +2029,92 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* FileDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional string syntax = 12;
+  if (_internal_has_syntax()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_syntax().data(), static_cast<int>(this->_internal_syntax().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FileDescriptorProto.syntax");
+    ptr = encoder->WriteString(12, this->_internal_syntax(), ptr);
+  }
+
+  // repeated int32 weak_dependency = 11;
+  for (int i = this->_internal_weak_dependency_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteInt32(11, this->_internal_weak_dependency(i), ptr);
+  }
+
+  // repeated int32 public_dependency = 10;
+  for (int i = this->_internal_public_dependency_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteInt32(10, this->_internal_public_dependency(i), ptr);
+  }
+
+  // optional .google.protobuf.SourceCodeInfo source_code_info = 9;
+  if (_internal_has_source_code_info()) {
+    ptr = encoder->WriteMessage(9, this->_internal_source_code_info(), ptr);
+  }
+
+  // optional .google.protobuf.FileOptions options = 8;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(8, this->_internal_options(), ptr);
+  }
+
+  // repeated .google.protobuf.FieldDescriptorProto extension = 7;
+  for (int i = this->_internal_extension_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(7, this->_internal_extension(i), ptr);
+  }
+
+  // repeated .google.protobuf.ServiceDescriptorProto service = 6;
+  for (int i = this->_internal_service_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(6, this->_internal_service(i), ptr);
+  }
+
+  // repeated .google.protobuf.EnumDescriptorProto enum_type = 5;
+  for (int i = this->_internal_enum_type_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(5, this->_internal_enum_type(i), ptr);
+  }
+
+  // repeated .google.protobuf.DescriptorProto message_type = 4;
+  for (int i = this->_internal_message_type_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(4, this->_internal_message_type(i), ptr);
+  }
+
+  // repeated string dependency = 3;
+  for (int i = this->_internal_dependency_size() - 1; i >= 0; i--) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_dependency(i).data(), static_cast<int>(this->_internal_dependency(i).length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FileDescriptorProto.dependency");
+    ptr = encoder->WriteString(3, this->_internal_dependency(i), ptr);
+  }
+
+  // optional string package = 2;
+  if (_internal_has_package()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_package().data(), static_cast<int>(this->_internal_package().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FileDescriptorProto.package");
+    ptr = encoder->WriteString(2, this->_internal_package(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FileDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t FileDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.FileDescriptorProto)
   size_t total_size = 0;
@@ -2390,6 +2510,31 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* DescriptorProto_ExtensionRange::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional .google.protobuf.ExtensionRangeOptions options = 3;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(3, this->_internal_options(), ptr);
+  }
+
+  // optional int32 end = 2;
+  if (_internal_has_end()) {
+    ptr = encoder->WriteInt32(2, this->_internal_end(), ptr);
+  }
+
+  // optional int32 start = 1;
+  if (_internal_has_start()) {
+    ptr = encoder->WriteInt32(1, this->_internal_start(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t DescriptorProto_ExtensionRange::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.DescriptorProto.ExtensionRange)
   size_t total_size = 0;
@@ -2458,11 +2603,17 @@ void DescriptorProto_ExtensionRange::MergeFrom(const DescriptorProto_ExtensionRa
     if (cached_has_bits & 0x00000001u) {
       _internal_mutable_options()->PROTOBUF_NAMESPACE_ID::ExtensionRangeOptions::MergeFrom(from._internal_options());
     }
-    if (cached_has_bits & 0x00000002u) {
-      start_ = from.start_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      end_ = from.end_;
+    if ((cached_has_bits & 0x00000006u) == 0x00000006u) {
+      ::memcpy(&start_, &from.start_,
+        static_cast<size_t>(reinterpret_cast<char*>(&end_) -
+        reinterpret_cast<char*>(&start_)) + sizeof(end_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        start_ = from.start_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        end_ = from.end_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -2657,6 +2808,26 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* DescriptorProto_ReservedRange::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional int32 end = 2;
+  if (_internal_has_end()) {
+    ptr = encoder->WriteInt32(2, this->_internal_end(), ptr);
+  }
+
+  // optional int32 start = 1;
+  if (_internal_has_start()) {
+    ptr = encoder->WriteInt32(1, this->_internal_start(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t DescriptorProto_ReservedRange::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.DescriptorProto.ReservedRange)
   size_t total_size = 0;
@@ -2715,11 +2886,17 @@ void DescriptorProto_ReservedRange::MergeFrom(const DescriptorProto_ReservedRang
 
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      start_ = from.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      end_ = from.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&start_, &from.start_,
+        static_cast<size_t>(reinterpret_cast<char*>(&end_) -
+        reinterpret_cast<char*>(&start_)) + sizeof(end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        start_ = from.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        end_ = from.end_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -2889,8 +3066,14 @@ const char* DescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPAC
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.DescriptorProto.name");
           #endif  // !NDEBUG
@@ -3126,6 +3309,74 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* DescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated string reserved_name = 10;
+  for (int i = this->_internal_reserved_name_size() - 1; i >= 0; i--) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_reserved_name(i).data(), static_cast<int>(this->_internal_reserved_name(i).length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.DescriptorProto.reserved_name");
+    ptr = encoder->WriteString(10, this->_internal_reserved_name(i), ptr);
+  }
+
+  // repeated .google.protobuf.DescriptorProto.ReservedRange reserved_range = 9;
+  for (int i = this->_internal_reserved_range_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(9, this->_internal_reserved_range(i), ptr);
+  }
+
+  // repeated .google.protobuf.OneofDescriptorProto oneof_decl = 8;
+  for (int i = this->_internal_oneof_decl_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(8, this->_internal_oneof_decl(i), ptr);
+  }
+
+  // optional .google.protobuf.MessageOptions options = 7;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(7, this->_internal_options(), ptr);
+  }
+
+  // repeated .google.protobuf.FieldDescriptorProto extension = 6;
+  for (int i = this->_internal_extension_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(6, this->_internal_extension(i), ptr);
+  }
+
+  // repeated .google.protobuf.DescriptorProto.ExtensionRange extension_range = 5;
+  for (int i = this->_internal_extension_range_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(5, this->_internal_extension_range(i), ptr);
+  }
+
+  // repeated .google.protobuf.EnumDescriptorProto enum_type = 4;
+  for (int i = this->_internal_enum_type_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(4, this->_internal_enum_type(i), ptr);
+  }
+
+  // repeated .google.protobuf.DescriptorProto nested_type = 3;
+  for (int i = this->_internal_nested_type_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(3, this->_internal_nested_type(i), ptr);
+  }
+
+  // repeated .google.protobuf.FieldDescriptorProto field = 2;
+  for (int i = this->_internal_field_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(2, this->_internal_field(i), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.DescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t DescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.DescriptorProto)
   size_t total_size = 0;
@@ -3718,8 +3969,14 @@ const char* FieldDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FieldDescriptorProto.name");
           #endif  // !NDEBUG
@@ -3729,8 +3986,14 @@ const char* FieldDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string extendee = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_extendee();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_extendee(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &extendee_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(extendee_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &extendee_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FieldDescriptorProto.extendee");
           #endif  // !NDEBUG
@@ -3772,8 +4035,14 @@ const char* FieldDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string type_name = 6;
       case 6:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 50)) {
-          auto str = _internal_mutable_type_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_type_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &type_name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(type_name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &type_name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FieldDescriptorProto.type_name");
           #endif  // !NDEBUG
@@ -3783,8 +4052,14 @@ const char* FieldDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string default_value = 7;
       case 7:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 58)) {
-          auto str = _internal_mutable_default_value();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_default_value(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &default_value_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(default_value_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &default_value_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FieldDescriptorProto.default_value");
           #endif  // !NDEBUG
@@ -3809,8 +4084,14 @@ const char* FieldDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string json_name = 10;
       case 10:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 82)) {
-          auto str = _internal_mutable_json_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_json_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &json_name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(json_name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &json_name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FieldDescriptorProto.json_name");
           #endif  // !NDEBUG
@@ -3953,6 +4234,91 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* FieldDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional bool proto3_optional = 17;
+  if (_internal_has_proto3_optional()) {
+    ptr = encoder->WriteBool(17, this->_internal_proto3_optional(), ptr);
+  }
+
+  // optional string json_name = 10;
+  if (_internal_has_json_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_json_name().data(), static_cast<int>(this->_internal_json_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FieldDescriptorProto.json_name");
+    ptr = encoder->WriteString(10, this->_internal_json_name(), ptr);
+  }
+
+  // optional int32 oneof_index = 9;
+  if (_internal_has_oneof_index()) {
+    ptr = encoder->WriteInt32(9, this->_internal_oneof_index(), ptr);
+  }
+
+  // optional .google.protobuf.FieldOptions options = 8;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(8, this->_internal_options(), ptr);
+  }
+
+  // optional string default_value = 7;
+  if (_internal_has_default_value()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_default_value().data(), static_cast<int>(this->_internal_default_value().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FieldDescriptorProto.default_value");
+    ptr = encoder->WriteString(7, this->_internal_default_value(), ptr);
+  }
+
+  // optional string type_name = 6;
+  if (_internal_has_type_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_type_name().data(), static_cast<int>(this->_internal_type_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FieldDescriptorProto.type_name");
+    ptr = encoder->WriteString(6, this->_internal_type_name(), ptr);
+  }
+
+  // optional .google.protobuf.FieldDescriptorProto.Type type = 5;
+  if (_internal_has_type()) {
+    ptr = encoder->WriteEnum(5, this->_internal_type(), ptr);
+  }
+
+  // optional .google.protobuf.FieldDescriptorProto.Label label = 4;
+  if (_internal_has_label()) {
+    ptr = encoder->WriteEnum(4, this->_internal_label(), ptr);
+  }
+
+  // optional int32 number = 3;
+  if (_internal_has_number()) {
+    ptr = encoder->WriteInt32(3, this->_internal_number(), ptr);
+  }
+
+  // optional string extendee = 2;
+  if (_internal_has_extendee()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_extendee().data(), static_cast<int>(this->_internal_extendee().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FieldDescriptorProto.extendee");
+    ptr = encoder->WriteString(2, this->_internal_extendee(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.FieldDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t FieldDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.FieldDescriptorProto)
   size_t total_size = 0;
@@ -4090,23 +4456,35 @@ void FieldDescriptorProto::MergeFrom(const FieldDescriptorProto& from) {
     if (cached_has_bits & 0x00000020u) {
       _internal_mutable_options()->PROTOBUF_NAMESPACE_ID::FieldOptions::MergeFrom(from._internal_options());
     }
-    if (cached_has_bits & 0x00000040u) {
-      number_ = from.number_;
-    }
-    if (cached_has_bits & 0x00000080u) {
-      oneof_index_ = from.oneof_index_;
+    if ((cached_has_bits & 0x000000c0u) == 0x000000c0u) {
+      ::memcpy(&number_, &from.number_,
+        static_cast<size_t>(reinterpret_cast<char*>(&oneof_index_) -
+        reinterpret_cast<char*>(&number_)) + sizeof(oneof_index_));
+    } else {
+      if (cached_has_bits & 0x00000040u) {
+        number_ = from.number_;
+      }
+      if (cached_has_bits & 0x00000080u) {
+        oneof_index_ = from.oneof_index_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x00000700u) {
-    if (cached_has_bits & 0x00000100u) {
-      proto3_optional_ = from.proto3_optional_;
-    }
-    if (cached_has_bits & 0x00000200u) {
-      label_ = from.label_;
-    }
-    if (cached_has_bits & 0x00000400u) {
-      type_ = from.type_;
+    if ((cached_has_bits & 0x00000700u) == 0x00000700u) {
+      ::memcpy(&proto3_optional_, &from.proto3_optional_,
+        static_cast<size_t>(reinterpret_cast<char*>(&type_) -
+        reinterpret_cast<char*>(&proto3_optional_)) + sizeof(type_));
+    } else {
+      if (cached_has_bits & 0x00000100u) {
+        proto3_optional_ = from.proto3_optional_;
+      }
+      if (cached_has_bits & 0x00000200u) {
+        label_ = from.label_;
+      }
+      if (cached_has_bits & 0x00000400u) {
+        type_ = from.type_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -4262,8 +4640,14 @@ const char* OneofDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAM
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.OneofDescriptorProto.name");
           #endif  // !NDEBUG
@@ -4333,6 +4717,30 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* OneofDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional .google.protobuf.OneofOptions options = 2;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(2, this->_internal_options(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.OneofDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t OneofDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.OneofDescriptorProto)
   size_t total_size = 0;
@@ -4585,6 +4993,26 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* EnumDescriptorProto_EnumReservedRange::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional int32 end = 2;
+  if (_internal_has_end()) {
+    ptr = encoder->WriteInt32(2, this->_internal_end(), ptr);
+  }
+
+  // optional int32 start = 1;
+  if (_internal_has_start()) {
+    ptr = encoder->WriteInt32(1, this->_internal_start(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t EnumDescriptorProto_EnumReservedRange::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.EnumDescriptorProto.EnumReservedRange)
   size_t total_size = 0;
@@ -4643,11 +5071,17 @@ void EnumDescriptorProto_EnumReservedRange::MergeFrom(const EnumDescriptorProto_
 
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      start_ = from.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      end_ = from.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&start_, &from.start_,
+        static_cast<size_t>(reinterpret_cast<char*>(&end_) -
+        reinterpret_cast<char*>(&start_)) + sizeof(end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        start_ = from.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        end_ = from.end_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -4802,8 +5236,14 @@ const char* EnumDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.EnumDescriptorProto.name");
           #endif  // !NDEBUG
@@ -4939,6 +5379,49 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* EnumDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated string reserved_name = 5;
+  for (int i = this->_internal_reserved_name_size() - 1; i >= 0; i--) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_reserved_name(i).data(), static_cast<int>(this->_internal_reserved_name(i).length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.EnumDescriptorProto.reserved_name");
+    ptr = encoder->WriteString(5, this->_internal_reserved_name(i), ptr);
+  }
+
+  // repeated .google.protobuf.EnumDescriptorProto.EnumReservedRange reserved_range = 4;
+  for (int i = this->_internal_reserved_range_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(4, this->_internal_reserved_range(i), ptr);
+  }
+
+  // optional .google.protobuf.EnumOptions options = 3;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(3, this->_internal_options(), ptr);
+  }
+
+  // repeated .google.protobuf.EnumValueDescriptorProto value = 2;
+  for (int i = this->_internal_value_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(2, this->_internal_value(i), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.EnumDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t EnumDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.EnumDescriptorProto)
   size_t total_size = 0;
@@ -5182,8 +5665,14 @@ const char* EnumValueDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.EnumValueDescriptorProto.name");
           #endif  // !NDEBUG
@@ -5267,6 +5756,35 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* EnumValueDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional .google.protobuf.EnumValueOptions options = 3;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(3, this->_internal_options(), ptr);
+  }
+
+  // optional int32 number = 2;
+  if (_internal_has_number()) {
+    ptr = encoder->WriteInt32(2, this->_internal_number(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.EnumValueDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t EnumValueDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.EnumValueDescriptorProto)
   size_t total_size = 0;
@@ -5492,8 +6010,14 @@ const char* ServiceDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_N
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.ServiceDescriptorProto.name");
           #endif  // !NDEBUG
@@ -5583,6 +6107,35 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* ServiceDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional .google.protobuf.ServiceOptions options = 3;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(3, this->_internal_options(), ptr);
+  }
+
+  // repeated .google.protobuf.MethodDescriptorProto method = 2;
+  for (int i = this->_internal_method_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(2, this->_internal_method(i), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.ServiceDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t ServiceDescriptorProto::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.ServiceDescriptorProto)
   size_t total_size = 0;
@@ -5840,8 +6393,14 @@ const char* MethodDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NA
       // optional string name = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.MethodDescriptorProto.name");
           #endif  // !NDEBUG
@@ -5851,8 +6410,14 @@ const char* MethodDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NA
       // optional string input_type = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_input_type();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_input_type(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &input_type_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(input_type_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &input_type_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.MethodDescriptorProto.input_type");
           #endif  // !NDEBUG
@@ -5862,8 +6427,14 @@ const char* MethodDescriptorProto::_InternalParse(const char* ptr, ::PROTOBUF_NA
       // optional string output_type = 3;
       case 3:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 26)) {
-          auto str = _internal_mutable_output_type();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_output_type(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &output_type_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(output_type_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &output_type_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.MethodDescriptorProto.output_type");
           #endif  // !NDEBUG
@@ -5977,8 +6548,60 @@ failure:
     target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
   }
-  // @@protoc_insertion_point(serialize_to_array_end:google.protobuf.MethodDescriptorProto)
-  return target;
+  // @@protoc_insertion_point(serialize_to_array_end:google.protobuf.MethodDescriptorProto)
+  return target;
+}
+
+::PROTOBUF_NAMESPACE_ID::uint8* MethodDescriptorProto::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional bool server_streaming = 6 [default = false];
+  if (_internal_has_server_streaming()) {
+    ptr = encoder->WriteBool(6, this->_internal_server_streaming(), ptr);
+  }
+
+  // optional bool client_streaming = 5 [default = false];
+  if (_internal_has_client_streaming()) {
+    ptr = encoder->WriteBool(5, this->_internal_client_streaming(), ptr);
+  }
+
+  // optional .google.protobuf.MethodOptions options = 4;
+  if (_internal_has_options()) {
+    ptr = encoder->WriteMessage(4, this->_internal_options(), ptr);
+  }
+
+  // optional string output_type = 3;
+  if (_internal_has_output_type()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_output_type().data(), static_cast<int>(this->_internal_output_type().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.MethodDescriptorProto.output_type");
+    ptr = encoder->WriteString(3, this->_internal_output_type(), ptr);
+  }
+
+  // optional string input_type = 2;
+  if (_internal_has_input_type()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_input_type().data(), static_cast<int>(this->_internal_input_type().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.MethodDescriptorProto.input_type");
+    ptr = encoder->WriteString(2, this->_internal_input_type(), ptr);
+  }
+
+  // optional string name = 1;
+  if (_internal_has_name()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.MethodDescriptorProto.name");
+    ptr = encoder->WriteString(1, this->_internal_name(), ptr);
+  }
+
+  return ptr;
 }
 
 size_t MethodDescriptorProto::ByteSizeLong() const {
@@ -6075,11 +6698,17 @@ void MethodDescriptorProto::MergeFrom(const MethodDescriptorProto& from) {
     if (cached_has_bits & 0x00000008u) {
       _internal_mutable_options()->PROTOBUF_NAMESPACE_ID::MethodOptions::MergeFrom(from._internal_options());
     }
-    if (cached_has_bits & 0x00000010u) {
-      client_streaming_ = from.client_streaming_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      server_streaming_ = from.server_streaming_;
+    if ((cached_has_bits & 0x00000030u) == 0x00000030u) {
+      ::memcpy(&client_streaming_, &from.client_streaming_,
+        static_cast<size_t>(reinterpret_cast<char*>(&server_streaming_) -
+        reinterpret_cast<char*>(&client_streaming_)) + sizeof(server_streaming_));
+    } else {
+      if (cached_has_bits & 0x00000010u) {
+        client_streaming_ = from.client_streaming_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        server_streaming_ = from.server_streaming_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -6388,8 +7017,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string java_package = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_java_package();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_java_package(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &java_package_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(java_package_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &java_package_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.java_package");
           #endif  // !NDEBUG
@@ -6399,8 +7034,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string java_outer_classname = 8;
       case 8:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 66)) {
-          auto str = _internal_mutable_java_outer_classname();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_java_outer_classname(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &java_outer_classname_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(java_outer_classname_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &java_outer_classname_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.java_outer_classname");
           #endif  // !NDEBUG
@@ -6430,8 +7071,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string go_package = 11;
       case 11:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 90)) {
-          auto str = _internal_mutable_go_package();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_go_package(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &go_package_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(go_package_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &go_package_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.go_package");
           #endif  // !NDEBUG
@@ -6497,8 +7144,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string objc_class_prefix = 36;
       case 36:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 34)) {
-          auto str = _internal_mutable_objc_class_prefix();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_objc_class_prefix(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &objc_class_prefix_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(objc_class_prefix_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &objc_class_prefix_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.objc_class_prefix");
           #endif  // !NDEBUG
@@ -6508,8 +7161,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string csharp_namespace = 37;
       case 37:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 42)) {
-          auto str = _internal_mutable_csharp_namespace();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_csharp_namespace(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &csharp_namespace_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(csharp_namespace_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &csharp_namespace_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.csharp_namespace");
           #endif  // !NDEBUG
@@ -6519,8 +7178,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string swift_prefix = 39;
       case 39:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 58)) {
-          auto str = _internal_mutable_swift_prefix();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_swift_prefix(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &swift_prefix_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(swift_prefix_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &swift_prefix_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.swift_prefix");
           #endif  // !NDEBUG
@@ -6530,8 +7195,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string php_class_prefix = 40;
       case 40:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 66)) {
-          auto str = _internal_mutable_php_class_prefix();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_php_class_prefix(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &php_class_prefix_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(php_class_prefix_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &php_class_prefix_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.php_class_prefix");
           #endif  // !NDEBUG
@@ -6541,8 +7212,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string php_namespace = 41;
       case 41:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 74)) {
-          auto str = _internal_mutable_php_namespace();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_php_namespace(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &php_namespace_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(php_namespace_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &php_namespace_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.php_namespace");
           #endif  // !NDEBUG
@@ -6560,8 +7237,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string php_metadata_namespace = 44;
       case 44:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 98)) {
-          auto str = _internal_mutable_php_metadata_namespace();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_php_metadata_namespace(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &php_metadata_namespace_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(php_metadata_namespace_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &php_metadata_namespace_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.php_metadata_namespace");
           #endif  // !NDEBUG
@@ -6571,8 +7254,14 @@ const char* FileOptions::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID
       // optional string ruby_package = 45;
       case 45:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 106)) {
-          auto str = _internal_mutable_ruby_package();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_ruby_package(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &ruby_package_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(ruby_package_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &ruby_package_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.FileOptions.ruby_package");
           #endif  // !NDEBUG
@@ -7020,38 +7709,50 @@ void FileOptions::MergeFrom(const FileOptions& from) {
     if (cached_has_bits & 0x00000200u) {
       _internal_set_ruby_package(from._internal_ruby_package());
     }
-    if (cached_has_bits & 0x00000400u) {
-      java_multiple_files_ = from.java_multiple_files_;
-    }
-    if (cached_has_bits & 0x00000800u) {
-      java_generate_equals_and_hash_ = from.java_generate_equals_and_hash_;
-    }
-    if (cached_has_bits & 0x00001000u) {
-      java_string_check_utf8_ = from.java_string_check_utf8_;
-    }
-    if (cached_has_bits & 0x00002000u) {
-      cc_generic_services_ = from.cc_generic_services_;
-    }
-    if (cached_has_bits & 0x00004000u) {
-      java_generic_services_ = from.java_generic_services_;
-    }
-    if (cached_has_bits & 0x00008000u) {
-      py_generic_services_ = from.py_generic_services_;
+    if ((cached_has_bits & 0x0000fc00u) == 0x0000fc00u) {
+      ::memcpy(&java_multiple_files_, &from.java_multiple_files_,
+        static_cast<size_t>(reinterpret_cast<char*>(&py_generic_services_) -
+        reinterpret_cast<char*>(&java_multiple_files_)) + sizeof(py_generic_services_));
+    } else {
+      if (cached_has_bits & 0x00000400u) {
+        java_multiple_files_ = from.java_multiple_files_;
+      }
+      if (cached_has_bits & 0x00000800u) {
+        java_generate_equals_and_hash_ = from.java_generate_equals_and_hash_;
+      }
+      if (cached_has_bits & 0x00001000u) {
+        java_string_check_utf8_ = from.java_string_check_utf8_;
+      }
+      if (cached_has_bits & 0x00002000u) {
+        cc_generic_services_ = from.cc_generic_services_;
+      }
+      if (cached_has_bits & 0x00004000u) {
+        java_generic_services_ = from.java_generic_services_;
+      }
+      if (cached_has_bits & 0x00008000u) {
+        py_generic_services_ = from.py_generic_services_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x000f0000u) {
-    if (cached_has_bits & 0x00010000u) {
-      php_generic_services_ = from.php_generic_services_;
-    }
-    if (cached_has_bits & 0x00020000u) {
-      deprecated_ = from.deprecated_;
-    }
-    if (cached_has_bits & 0x00040000u) {
-      optimize_for_ = from.optimize_for_;
-    }
-    if (cached_has_bits & 0x00080000u) {
-      cc_enable_arenas_ = from.cc_enable_arenas_;
+    if ((cached_has_bits & 0x000f0000u) == 0x000f0000u) {
+      ::memcpy(&php_generic_services_, &from.php_generic_services_,
+        static_cast<size_t>(reinterpret_cast<char*>(&cc_enable_arenas_) -
+        reinterpret_cast<char*>(&php_generic_services_)) + sizeof(cc_enable_arenas_));
+    } else {
+      if (cached_has_bits & 0x00010000u) {
+        php_generic_services_ = from.php_generic_services_;
+      }
+      if (cached_has_bits & 0x00020000u) {
+        deprecated_ = from.deprecated_;
+      }
+      if (cached_has_bits & 0x00040000u) {
+        optimize_for_ = from.optimize_for_;
+      }
+      if (cached_has_bits & 0x00080000u) {
+        cc_enable_arenas_ = from.cc_enable_arenas_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -7405,17 +8106,23 @@ void MessageOptions::MergeFrom(const MessageOptions& from) {
   uninterpreted_option_.MergeFrom(from.uninterpreted_option_);
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x0000000fu) {
-    if (cached_has_bits & 0x00000001u) {
-      message_set_wire_format_ = from.message_set_wire_format_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      no_standard_descriptor_accessor_ = from.no_standard_descriptor_accessor_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      deprecated_ = from.deprecated_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      map_entry_ = from.map_entry_;
+    if ((cached_has_bits & 0x0000000fu) == 0x0000000fu) {
+      ::memcpy(&message_set_wire_format_, &from.message_set_wire_format_,
+        static_cast<size_t>(reinterpret_cast<char*>(&map_entry_) -
+        reinterpret_cast<char*>(&message_set_wire_format_)) + sizeof(map_entry_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        message_set_wire_format_ = from.message_set_wire_format_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        no_standard_descriptor_accessor_ = from.no_standard_descriptor_accessor_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        deprecated_ = from.deprecated_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        map_entry_ = from.map_entry_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -7816,23 +8523,29 @@ void FieldOptions::MergeFrom(const FieldOptions& from) {
   uninterpreted_option_.MergeFrom(from.uninterpreted_option_);
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x0000003fu) {
-    if (cached_has_bits & 0x00000001u) {
-      ctype_ = from.ctype_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      packed_ = from.packed_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      lazy_ = from.lazy_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      deprecated_ = from.deprecated_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      weak_ = from.weak_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      jstype_ = from.jstype_;
+    if ((cached_has_bits & 0x0000003fu) == 0x0000003fu) {
+      ::memcpy(&ctype_, &from.ctype_,
+        static_cast<size_t>(reinterpret_cast<char*>(&jstype_) -
+        reinterpret_cast<char*>(&ctype_)) + sizeof(jstype_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        ctype_ = from.ctype_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        packed_ = from.packed_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        lazy_ = from.lazy_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        deprecated_ = from.deprecated_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        weak_ = from.weak_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        jstype_ = from.jstype_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -8352,11 +9065,17 @@ void EnumOptions::MergeFrom(const EnumOptions& from) {
   uninterpreted_option_.MergeFrom(from.uninterpreted_option_);
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      allow_alias_ = from.allow_alias_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      deprecated_ = from.deprecated_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&allow_alias_, &from.allow_alias_,
+        static_cast<size_t>(reinterpret_cast<char*>(&deprecated_) -
+        reinterpret_cast<char*>(&allow_alias_)) + sizeof(deprecated_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        allow_alias_ = from.allow_alias_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        deprecated_ = from.deprecated_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -9181,11 +9900,17 @@ void MethodOptions::MergeFrom(const MethodOptions& from) {
   uninterpreted_option_.MergeFrom(from.uninterpreted_option_);
   cached_has_bits = from._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      deprecated_ = from.deprecated_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      idempotency_level_ = from.idempotency_level_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&deprecated_, &from.deprecated_,
+        static_cast<size_t>(reinterpret_cast<char*>(&idempotency_level_) -
+        reinterpret_cast<char*>(&deprecated_)) + sizeof(idempotency_level_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        deprecated_ = from.deprecated_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        idempotency_level_ = from.idempotency_level_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -9326,8 +10051,14 @@ const char* UninterpretedOption_NamePart::_InternalParse(const char* ptr, ::PROT
       // required string name_part = 1;
       case 1:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
-          auto str = _internal_mutable_name_part();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_name_part(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &name_part_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(name_part_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &name_part_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.UninterpretedOption.NamePart.name_part");
           #endif  // !NDEBUG
@@ -9396,6 +10127,30 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* UninterpretedOption_NamePart::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // required bool is_extension = 2;
+  if (_internal_has_is_extension()) {
+    ptr = encoder->WriteBool(2, this->_internal_is_extension(), ptr);
+  }
+
+  // required string name_part = 1;
+  if (_internal_has_name_part()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name_part().data(), static_cast<int>(this->_internal_name_part().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.UninterpretedOption.NamePart.name_part");
+    ptr = encoder->WriteString(1, this->_internal_name_part(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t UninterpretedOption_NamePart::RequiredFieldsByteSizeFallback() const {
 // @@protoc_insertion_point(required_fields_byte_size_fallback_start:google.protobuf.UninterpretedOption.NamePart)
   size_t total_size = 0;
@@ -9657,8 +10412,14 @@ const char* UninterpretedOption::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional string identifier_value = 3;
       case 3:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 26)) {
-          auto str = _internal_mutable_identifier_value();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_identifier_value(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &identifier_value_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(identifier_value_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &identifier_value_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.UninterpretedOption.identifier_value");
           #endif  // !NDEBUG
@@ -9692,16 +10453,28 @@ const char* UninterpretedOption::_InternalParse(const char* ptr, ::PROTOBUF_NAME
       // optional bytes string_value = 7;
       case 7:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 58)) {
-          auto str = _internal_mutable_string_value();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_string_value(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &string_value_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(string_value_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &string_value_.Get(); (void)str;
           CHK_(ptr);
         } else goto handle_unusual;
         continue;
       // optional string aggregate_value = 8;
       case 8:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 66)) {
-          auto str = _internal_mutable_aggregate_value();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_aggregate_value(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &aggregate_value_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(aggregate_value_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &aggregate_value_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.UninterpretedOption.aggregate_value");
           #endif  // !NDEBUG
@@ -9798,6 +10571,59 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* UninterpretedOption::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional string aggregate_value = 8;
+  if (_internal_has_aggregate_value()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_aggregate_value().data(), static_cast<int>(this->_internal_aggregate_value().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.UninterpretedOption.aggregate_value");
+    ptr = encoder->WriteString(8, this->_internal_aggregate_value(), ptr);
+  }
+
+  // optional bytes string_value = 7;
+  if (_internal_has_string_value()) {
+    ptr = encoder->WriteBytes(7, this->_internal_string_value(), ptr);
+  }
+
+  // optional double double_value = 6;
+  if (_internal_has_double_value()) {
+    ptr = encoder->WriteDouble(6, this->_internal_double_value(), ptr);
+  }
+
+  // optional int64 negative_int_value = 5;
+  if (_internal_has_negative_int_value()) {
+    ptr = encoder->WriteInt64(5, this->_internal_negative_int_value(), ptr);
+  }
+
+  // optional uint64 positive_int_value = 4;
+  if (_internal_has_positive_int_value()) {
+    ptr = encoder->WriteUInt64(4, this->_internal_positive_int_value(), ptr);
+  }
+
+  // optional string identifier_value = 3;
+  if (_internal_has_identifier_value()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_identifier_value().data(), static_cast<int>(this->_internal_identifier_value().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.UninterpretedOption.identifier_value");
+    ptr = encoder->WriteString(3, this->_internal_identifier_value(), ptr);
+  }
+
+  // repeated .google.protobuf.UninterpretedOption.NamePart name = 2;
+  for (int i = this->_internal_name_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(2, this->_internal_name(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t UninterpretedOption::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.UninterpretedOption)
   size_t total_size = 0;
@@ -9899,14 +10725,20 @@ void UninterpretedOption::MergeFrom(const UninterpretedOption& from) {
     if (cached_has_bits & 0x00000004u) {
       _internal_set_aggregate_value(from._internal_aggregate_value());
     }
-    if (cached_has_bits & 0x00000008u) {
-      positive_int_value_ = from.positive_int_value_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      negative_int_value_ = from.negative_int_value_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      double_value_ = from.double_value_;
+    if ((cached_has_bits & 0x00000038u) == 0x00000038u) {
+      ::memcpy(&positive_int_value_, &from.positive_int_value_,
+        static_cast<size_t>(reinterpret_cast<char*>(&double_value_) -
+        reinterpret_cast<char*>(&positive_int_value_)) + sizeof(double_value_));
+    } else {
+      if (cached_has_bits & 0x00000008u) {
+        positive_int_value_ = from.positive_int_value_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        negative_int_value_ = from.negative_int_value_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        double_value_ = from.double_value_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -10080,8 +10912,14 @@ const char* SourceCodeInfo_Location::_InternalParse(const char* ptr, ::PROTOBUF_
       // optional string leading_comments = 3;
       case 3:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 26)) {
-          auto str = _internal_mutable_leading_comments();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_leading_comments(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &leading_comments_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(leading_comments_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &leading_comments_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.SourceCodeInfo.Location.leading_comments");
           #endif  // !NDEBUG
@@ -10091,8 +10929,14 @@ const char* SourceCodeInfo_Location::_InternalParse(const char* ptr, ::PROTOBUF_
       // optional string trailing_comments = 4;
       case 4:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 34)) {
-          auto str = _internal_mutable_trailing_comments();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_trailing_comments(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &trailing_comments_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(trailing_comments_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &trailing_comments_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.SourceCodeInfo.Location.trailing_comments");
           #endif  // !NDEBUG
@@ -10201,6 +11045,61 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* SourceCodeInfo_Location::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated string leading_detached_comments = 6;
+  for (int i = this->_internal_leading_detached_comments_size() - 1; i >= 0; i--) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_leading_detached_comments(i).data(), static_cast<int>(this->_internal_leading_detached_comments(i).length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.SourceCodeInfo.Location.leading_detached_comments");
+    ptr = encoder->WriteString(6, this->_internal_leading_detached_comments(i), ptr);
+  }
+
+  // optional string trailing_comments = 4;
+  if (_internal_has_trailing_comments()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_trailing_comments().data(), static_cast<int>(this->_internal_trailing_comments().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.SourceCodeInfo.Location.trailing_comments");
+    ptr = encoder->WriteString(4, this->_internal_trailing_comments(), ptr);
+  }
+
+  // optional string leading_comments = 3;
+  if (_internal_has_leading_comments()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_leading_comments().data(), static_cast<int>(this->_internal_leading_comments().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.SourceCodeInfo.Location.leading_comments");
+    ptr = encoder->WriteString(3, this->_internal_leading_comments(), ptr);
+  }
+
+  // repeated int32 span = 2 [packed = true];
+  if (this->_internal_span_size() > 0) {
+    size_t start = encoder->ByteCount(ptr);
+    for (int i = this->_internal_span_size() - 1; i >= 0; i--) {
+      ptr = encoder->WriteInt32NoTag(this->_internal_span(i), ptr);
+    }
+    ptr = encoder->WriteLengthDelimitedPrefix(2, start, ptr);
+  }
+
+  // repeated int32 path = 1 [packed = true];
+  if (this->_internal_path_size() > 0) {
+    size_t start = encoder->ByteCount(ptr);
+    for (int i = this->_internal_path_size() - 1; i >= 0; i--) {
+      ptr = encoder->WriteInt32NoTag(this->_internal_path(i), ptr);
+    }
+    ptr = encoder->WriteLengthDelimitedPrefix(1, start, ptr);
+  }
+
+  return ptr;
+}
+
 size_t SourceCodeInfo_Location::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.SourceCodeInfo.Location)
   size_t total_size = 0;
@@ -10465,6 +11364,21 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* SourceCodeInfo::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.SourceCodeInfo.Location location = 1;
+  for (int i = this->_internal_location_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(1, this->_internal_location(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t SourceCodeInfo::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.SourceCodeInfo)
   size_t total_size = 0;
@@ -10658,8 +11572,14 @@ const char* GeneratedCodeInfo_Annotation::_InternalParse(const char* ptr, ::PROT
       // optional string source_file = 2;
       case 2:
         if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 18)) {
-          auto str = _internal_mutable_source_file();
-          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(str, ptr, ctx);
+          _Internal::set_has_source_file(&has_bits);
+          auto* arena = GetArena();
+          if (arena != nullptr) {
+            ptr = ctx->ReadArenaString(ptr, &source_file_, arena);
+          } else {
+            ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(source_file_.MutableNoArenaNoDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited()), ptr, ctx);
+          }
+          const std::string* str = &source_file_.Get(); (void)str;
           #ifndef NDEBUG
           ::PROTOBUF_NAMESPACE_ID::internal::VerifyUTF8(str, "google.protobuf.GeneratedCodeInfo.Annotation.source_file");
           #endif  // !NDEBUG
@@ -10751,6 +11671,44 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* GeneratedCodeInfo_Annotation::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // optional int32 end = 4;
+  if (_internal_has_end()) {
+    ptr = encoder->WriteInt32(4, this->_internal_end(), ptr);
+  }
+
+  // optional int32 begin = 3;
+  if (_internal_has_begin()) {
+    ptr = encoder->WriteInt32(3, this->_internal_begin(), ptr);
+  }
+
+  // optional string source_file = 2;
+  if (_internal_has_source_file()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_source_file().data(), static_cast<int>(this->_internal_source_file().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "google.protobuf.GeneratedCodeInfo.Annotation.source_file");
+    ptr = encoder->WriteString(2, this->_internal_source_file(), ptr);
+  }
+
+  // repeated int32 path = 1 [packed = true];
+  if (this->_internal_path_size() > 0) {
+    size_t start = encoder->ByteCount(ptr);
+    for (int i = this->_internal_path_size() - 1; i >= 0; i--) {
+      ptr = encoder->WriteInt32NoTag(this->_internal_path(i), ptr);
+    }
+    ptr = encoder->WriteLengthDelimitedPrefix(1, start, ptr);
+  }
+
+  return ptr;
+}
+
 size_t GeneratedCodeInfo_Annotation::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.GeneratedCodeInfo.Annotation)
   size_t total_size = 0;
@@ -10835,11 +11793,17 @@ void GeneratedCodeInfo_Annotation::MergeFrom(const GeneratedCodeInfo_Annotation&
     if (cached_has_bits & 0x00000001u) {
       _internal_set_source_file(from._internal_source_file());
     }
-    if (cached_has_bits & 0x00000002u) {
-      begin_ = from.begin_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      end_ = from.end_;
+    if ((cached_has_bits & 0x00000006u) == 0x00000006u) {
+      ::memcpy(&begin_, &from.begin_,
+        static_cast<size_t>(reinterpret_cast<char*>(&end_) -
+        reinterpret_cast<char*>(&begin_)) + sizeof(end_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        begin_ = from.begin_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        end_ = from.end_;
+      }
     }
     _has_bits_[0] |= cached_has_bits;
   }
@@ -11004,6 +11968,21 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* GeneratedCodeInfo::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.GeneratedCodeInfo.Annotation annotation = 1;
+  for (int i = this->_internal_annotation_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(1, this->_internal_annotation(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t GeneratedCodeInfo::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.GeneratedCodeInfo)
   size_t total_size = 0;
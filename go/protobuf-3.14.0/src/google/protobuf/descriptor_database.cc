@@ -34,6 +34,21 @@
 
 #include <google/protobuf/descriptor_database.h>
 
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#include <errno.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <set>
 
 #include <google/protobuf/descriptor.pb.h>
@@ -395,6 +410,11 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   // to the index.
   template <typename FileProto>
   bool AddFile(const FileProto& file, Value value);
+  // Like AddFile(), but the entries of the file are only sorted into the
+  // index, and checked for conflicts, by the next EnsureFlat().  Conflicts
+  // are logged and the conflicting entries dropped then.
+  template <typename FileProto>
+  bool AddFileDeferred(const FileProto& file, Value value);
 
   Value FindFile(StringPiece filename);
   Value FindSymbol(StringPiece name);
@@ -415,19 +435,40 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   template <typename FieldProto>
   bool AddExtension(StringPiece filename, const FieldProto& field);
 
-  // All the maps below have two representations:
-  //  - a std::set<> where we insert initially.
-  //  - a std::vector<> where we flatten the structure on demand.
+  // All the maps below have three representations:
+  //  - a std::set<> where AddFile() inserts.
+  //  - an unsorted std::vector<> where AddFileDeferred() appends.
+  //  - a sorted std::vector<> where we flatten the structure on demand.
   // The initial tree helps avoid O(N) behavior of inserting into a sorted
-  // vector, while the vector reduces the heap requirements of the data
-  // structure.
+  // vector while still reporting conflicts to the caller right away.  Files
+  // added in bulk skip the tree: their entries are sorted once, which avoids
+  // a heap node per entry.  The flat vector reduces the heap requirements of
+  // the data structure.
 
   void EnsureFlat();
 
-  using String = std::string;
+  // Strings are not copied: they are kept as a position in the encoded file
+  // they were read from, which outlives the index.
+  struct String {
+    int offset;
+    int size;
+  };
+
+  // `str` must point into the file added last.
+  String EncodeString(StringPiece str) const {
+    if (str.empty()) return {0, 0};
+    const char* data = static_cast<const char*>(all_values_.back().data);
+    GOOGLE_DCHECK(str.data() >= data &&
+           str.data() + str.size() <= data + all_values_.back().size);
+    return {static_cast<int>(str.data() - data), static_cast<int>(str.size())};
+  }
+  StringPiece DecodeString(const String& str, int data_offset) const {
+    return StringPiece(
+        static_cast<const char*>(all_values_[data_offset].data) + str.offset,
+        str.size);
+  }
 
-  String EncodeString(StringPiece str) const { return String(str); }
-  StringPiece DecodeString(const String& str, int) const { return str; }
+  bool deferred_ = false;
 
   struct EncodedEntry {
     // Do not use `Value` here to avoid the padding of that object.
@@ -462,6 +503,7 @@ class EncodedDescriptorDatabase::DescriptorIndex {
     }
   };
   std::set<FileEntry, FileCompare> by_name_{FileCompare{*this}};
+  std::vector<FileEntry> by_name_deferred_;
   std::vector<FileEntry> by_name_flat_;
 
   struct SymbolEntry {
@@ -519,6 +561,7 @@ class EncodedDescriptorDatabase::DescriptorIndex {
     }
   };
   std::set<SymbolEntry, SymbolCompare> by_symbol_{SymbolCompare{*this}};
+  std::vector<SymbolEntry> by_symbol_deferred_;
   std::vector<SymbolEntry> by_symbol_flat_;
 
   struct ExtensionEntry {
@@ -547,13 +590,205 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   };
   std::set<ExtensionEntry, ExtensionCompare> by_extension_{
       ExtensionCompare{*this}};
+  std::vector<ExtensionEntry> by_extension_deferred_;
   std::vector<ExtensionEntry> by_extension_flat_;
+
+  void FlattenDeferredNames();
+  void FlattenDeferredSymbols();
+  void FlattenDeferredExtensions();
 };
 
+namespace {
+
+// The parts of an encoded FileDescriptorProto that DescriptorIndex reads,
+// with the same accessors.  The strings point into the encoded bytes, so
+// reading a file for the index copies none of them.
+struct EncodedFieldView {
+  StringPiece name_;
+  StringPiece extendee_;
+  int number_ = 0;
+
+  StringPiece name() const { return name_; }
+  StringPiece extendee() const { return extendee_; }
+  int number() const { return number_; }
+};
+
+struct EncodedNamedView {
+  StringPiece name_;
+
+  StringPiece name() const { return name_; }
+};
+
+struct EncodedMessageView {
+  StringPiece name_;
+  std::vector<EncodedMessageView> nested_type_;
+  std::vector<EncodedFieldView> extension_;
+
+  StringPiece name() const { return name_; }
+  const std::vector<EncodedMessageView>& nested_type() const {
+    return nested_type_;
+  }
+  const std::vector<EncodedFieldView>& extension() const { return extension_; }
+};
+
+struct EncodedFileView {
+  StringPiece name_;
+  StringPiece package_;
+  std::vector<EncodedMessageView> message_type_;
+  std::vector<EncodedNamedView> enum_type_;
+  std::vector<EncodedFieldView> extension_;
+  std::vector<EncodedNamedView> service_;
+
+  StringPiece name() const { return name_; }
+  StringPiece package() const { return package_; }
+  const std::vector<EncodedMessageView>& message_type() const {
+    return message_type_;
+  }
+  const std::vector<EncodedNamedView>& enum_type() const { return enum_type_; }
+  const std::vector<EncodedFieldView>& extension() const { return extension_; }
+  const std::vector<EncodedNamedView>& service() const { return service_; }
+};
+
+uint32 LengthDelimitedTag(int field_number) {
+  return internal::WireFormatLite::MakeTag(
+      field_number, internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+// Reads a length-delimited field without copying it.
+bool ReadLengthDelimited(io::CodedInputStream* input, StringPiece* output) {
+  uint32 length;
+  const void* data;
+  int size;
+  if (!input->ReadVarint32(&length)) return false;
+  if (length == 0) {
+    *output = StringPiece();
+    return true;
+  }
+  if (!input->GetDirectBufferPointer(&data, &size) ||
+      static_cast<uint32>(size) < length) {
+    return false;
+  }
+  *output = StringPiece(static_cast<const char*>(data), length);
+  return input->Skip(length);
+}
+
+// Reads an embedded message: calls read_field(tag, input) for each field, which
+// returns false if it does not know the field.
+template <typename ReadField>
+bool ReadEmbedded(StringPiece bytes, ReadField read_field) {
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(bytes.data()),
+                             bytes.size());
+  while (uint32 tag = input.ReadTag()) {
+    bool known;
+    if (!read_field(tag, &input, &known)) return false;
+    if (!known && !internal::WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+  return input.ConsumedEntireMessage();
+}
+
+bool ReadEncodedField(StringPiece bytes, EncodedFieldView* field) {
+  return ReadEmbedded(bytes, [field](uint32 tag, io::CodedInputStream* input,
+                                     bool* known) {
+    *known = true;
+    if (tag == LengthDelimitedTag(FieldDescriptorProto::kNameFieldNumber)) {
+      return ReadLengthDelimited(input, &field->name_);
+    } else if (tag == LengthDelimitedTag(
+                          FieldDescriptorProto::kExtendeeFieldNumber)) {
+      return ReadLengthDelimited(input, &field->extendee_);
+    } else if (tag == internal::WireFormatLite::MakeTag(
+                          FieldDescriptorProto::kNumberFieldNumber,
+                          internal::WireFormatLite::WIRETYPE_VARINT)) {
+      uint32 number;
+      if (!input->ReadVarint32(&number)) return false;
+      field->number_ = static_cast<int32>(number);
+      return true;
+    }
+    *known = false;
+    return true;
+  });
+}
+
+// Enums and services: only the name is read.
+bool ReadEncodedNamed(StringPiece bytes, EncodedNamedView* named) {
+  // kNameFieldNumber is 1 in both EnumDescriptorProto and
+  // ServiceDescriptorProto.
+  return ReadEmbedded(bytes, [named](uint32 tag, io::CodedInputStream* input,
+                                     bool* known) {
+    *known = tag == LengthDelimitedTag(EnumDescriptorProto::kNameFieldNumber);
+    return !*known || ReadLengthDelimited(input, &named->name_);
+  });
+}
+
+bool ReadEncodedMessage(StringPiece bytes, EncodedMessageView* message) {
+  return ReadEmbedded(bytes, [message](uint32 tag, io::CodedInputStream* input,
+                                       bool* known) {
+    StringPiece value;
+    *known = true;
+    if (tag == LengthDelimitedTag(DescriptorProto::kNameFieldNumber)) {
+      return ReadLengthDelimited(input, &message->name_);
+    } else if (tag ==
+               LengthDelimitedTag(DescriptorProto::kNestedTypeFieldNumber)) {
+      message->nested_type_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedMessage(value, &message->nested_type_.back());
+    } else if (tag ==
+               LengthDelimitedTag(DescriptorProto::kExtensionFieldNumber)) {
+      message->extension_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedField(value, &message->extension_.back());
+    }
+    *known = false;
+    return true;
+  });
+}
+
+bool ReadEncodedFile(std::pair<const void*, int> encoded_file,
+                     EncodedFileView* file) {
+  StringPiece bytes(static_cast<const char*>(encoded_file.first),
+                    encoded_file.second);
+  return ReadEmbedded(bytes, [file](uint32 tag, io::CodedInputStream* input,
+                                    bool* known) {
+    StringPiece value;
+    *known = true;
+    if (tag == LengthDelimitedTag(FileDescriptorProto::kNameFieldNumber)) {
+      return ReadLengthDelimited(input, &file->name_);
+    } else if (tag == LengthDelimitedTag(
+                          FileDescriptorProto::kPackageFieldNumber)) {
+      return ReadLengthDelimited(input, &file->package_);
+    } else if (tag == LengthDelimitedTag(
+                          FileDescriptorProto::kMessageTypeFieldNumber)) {
+      file->message_type_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedMessage(value, &file->message_type_.back());
+    } else if (tag == LengthDelimitedTag(
+                          FileDescriptorProto::kEnumTypeFieldNumber)) {
+      file->enum_type_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedNamed(value, &file->enum_type_.back());
+    } else if (tag == LengthDelimitedTag(
+                          FileDescriptorProto::kExtensionFieldNumber)) {
+      file->extension_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedField(value, &file->extension_.back());
+    } else if (tag == LengthDelimitedTag(
+                          FileDescriptorProto::kServiceFieldNumber)) {
+      file->service_.emplace_back();
+      return ReadLengthDelimited(input, &value) &&
+             ReadEncodedNamed(value, &file->service_.back());
+    }
+    *known = false;
+    return true;
+  });
+}
+
+}  // namespace
+
 bool EncodedDescriptorDatabase::Add(const void* encoded_file_descriptor,
                                     int size) {
-  FileDescriptorProto file;
-  if (file.ParseFromArray(encoded_file_descriptor, size)) {
+  EncodedFileView file;
+  if (ReadEncodedFile(std::make_pair(encoded_file_descriptor, size), &file)) {
     return index_->AddFile(file, std::make_pair(encoded_file_descriptor, size));
   } else {
     GOOGLE_LOG(ERROR) << "Invalid file descriptor data passed to "
@@ -570,33 +805,133 @@ bool EncodedDescriptorDatabase::AddCopy(const void* encoded_file_descriptor,
   return Add(copy, size);
 }
 
+void EncodedDescriptorDatabase::AddLazily(const void* encoded_file_descriptor,
+                                          int size) {
+  unnamed_lazy_files_.emplace_back(encoded_file_descriptor, size);
+}
+
+namespace {
+
+// Optimization:  The name should be the first field in the encoded message.
+//   Try to just read it directly.  Returns false if it is not first.
+bool ReadFileName(std::pair<const void*, int> encoded_file,
+                  StringPiece* output) {
+  io::CodedInputStream input(static_cast<const uint8*>(encoded_file.first),
+                             encoded_file.second);
+
+  return input.ReadTagNoLastTag() ==
+             LengthDelimitedTag(FileDescriptorProto::kNameFieldNumber) &&
+         ReadLengthDelimited(&input, output);
+}
+
+bool ReadFileName(std::pair<const void*, int> encoded_file,
+                  std::string* output) {
+  StringPiece name;
+  if (!ReadFileName(encoded_file, &name)) return false;
+  output->assign(name.data(), name.size());
+  return true;
+}
+
+}  // namespace
+
+std::pair<const void*, int> EncodedDescriptorDatabase::FindLazyFile(
+    const std::string& filename) {
+  using Entry = std::pair<StringPiece, std::pair<const void*, int>>;
+  auto less = [](const Entry& a, const Entry& b) { return a.first < b.first; };
+
+  if (!unnamed_lazy_files_.empty()) {
+    for (const auto& encoded_file : unnamed_lazy_files_) {
+      StringPiece name;
+      if (!ReadFileName(encoded_file, &name)) {
+        // Slow path.  Index it now; FindFileByName() looks there first.
+        IndexFile(encoded_file);
+      } else {
+        lazy_files_by_name_.emplace_back(name, encoded_file);
+      }
+    }
+    unnamed_lazy_files_.clear();
+    unnamed_lazy_files_.shrink_to_fit();
+
+    // Sorted stably, so that the first file added with a name is kept.
+    std::stable_sort(lazy_files_by_name_.begin(), lazy_files_by_name_.end(),
+                     less);
+    auto last = std::unique(lazy_files_by_name_.begin(),
+                            lazy_files_by_name_.end(),
+                            [](const Entry& a, const Entry& b) {
+                              if (a.first != b.first) return false;
+                              GOOGLE_LOG(ERROR) << "File already exists in database: "
+                                         << b.first;
+                              return true;
+                            });
+    lazy_files_by_name_.erase(last, lazy_files_by_name_.end());
+  }
+
+  auto it = std::lower_bound(
+      lazy_files_by_name_.begin(), lazy_files_by_name_.end(),
+      Entry(filename, std::make_pair(nullptr, 0)), less);
+  return it == lazy_files_by_name_.end() || it->first != filename
+             ? std::make_pair(nullptr, 0)
+             : it->second;
+}
+
+void EncodedDescriptorDatabase::IndexLazyFiles() {
+  if (unnamed_lazy_files_.empty() && lazy_files_by_name_.empty()) return;
+
+  // The files are sorted into the index all at once.
+  for (const auto& encoded_file : unnamed_lazy_files_) {
+    IndexFile(encoded_file, true);
+  }
+  unnamed_lazy_files_.clear();
+  unnamed_lazy_files_.shrink_to_fit();
+  for (const auto& entry : lazy_files_by_name_) {
+    IndexFile(entry.second, true);
+  }
+  lazy_files_by_name_.clear();
+  lazy_files_by_name_.shrink_to_fit();
+  index_->EnsureFlat();
+}
+
+bool EncodedDescriptorDatabase::IndexFile(
+    std::pair<const void*, int> encoded_file, bool deferred) {
+  EncodedFileView file;
+  if (!ReadEncodedFile(encoded_file, &file)) {
+    GOOGLE_LOG(ERROR) << "Invalid file descriptor data passed to "
+                  "EncodedDescriptorDatabase::AddLazily().";
+    return false;
+  }
+  return deferred ? index_->AddFileDeferred(file, encoded_file)
+                  : index_->AddFile(file, encoded_file);
+}
+
 bool EncodedDescriptorDatabase::FindFileByName(const std::string& filename,
                                                FileDescriptorProto* output) {
-  return MaybeParse(index_->FindFile(filename), output);
+  auto encoded_file = index_->FindFile(filename);
+  if (encoded_file.first == NULL &&
+      (!unnamed_lazy_files_.empty() || !lazy_files_by_name_.empty())) {
+    // Lazy files are left out of index_ until a symbol lookup needs them:
+    // adding a few files at a time would re-flatten the whole index each
+    // time.
+    encoded_file = FindLazyFile(filename);
+    if (encoded_file.first == NULL) encoded_file = index_->FindFile(filename);
+  }
+  return MaybeParse(encoded_file, output);
 }
 
 bool EncodedDescriptorDatabase::FindFileContainingSymbol(
     const std::string& symbol_name, FileDescriptorProto* output) {
+  IndexLazyFiles();
   return MaybeParse(index_->FindSymbol(symbol_name), output);
 }
 
 bool EncodedDescriptorDatabase::FindNameOfFileContainingSymbol(
     const std::string& symbol_name, std::string* output) {
+  IndexLazyFiles();
   auto encoded_file = index_->FindSymbol(symbol_name);
   if (encoded_file.first == NULL) return false;
 
-  // Optimization:  The name should be the first field in the encoded message.
-  //   Try to just read it directly.
-  io::CodedInputStream input(static_cast<const uint8*>(encoded_file.first),
-                             encoded_file.second);
-
-  const uint32 kNameTag = internal::WireFormatLite::MakeTag(
-      FileDescriptorProto::kNameFieldNumber,
-      internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
-
-  if (input.ReadTagNoLastTag() == kNameTag) {
+  if (ReadFileName(encoded_file, output)) {
     // Success!
-    return internal::WireFormatLite::ReadString(&input, output);
+    return true;
   } else {
     // Slow path.  Parse whole message.
     FileDescriptorProto file_proto;
@@ -611,12 +946,14 @@ bool EncodedDescriptorDatabase::FindNameOfFileContainingSymbol(
 bool EncodedDescriptorDatabase::FindFileContainingExtension(
     const std::string& containing_type, int field_number,
     FileDescriptorProto* output) {
+  IndexLazyFiles();
   return MaybeParse(index_->FindExtension(containing_type, field_number),
                     output);
 }
 
 bool EncodedDescriptorDatabase::FindAllExtensionNumbers(
     const std::string& extendee_type, std::vector<int>* output) {
+  IndexLazyFiles();
   return index_->FindAllExtensionNumbers(extendee_type, output);
 }
 
@@ -633,7 +970,10 @@ bool EncodedDescriptorDatabase::DescriptorIndex::AddFile(const FileProto& file,
   }
   all_values_.back().encoded_package = EncodeString(file.package());
 
-  if (!InsertIfNotPresent(
+  if (deferred_) {
+    by_name_deferred_.push_back(FileEntry{
+        static_cast<int>(all_values_.size() - 1), EncodeString(file.name())});
+  } else if (!InsertIfNotPresent(
           &by_name_, FileEntry{static_cast<int>(all_values_.size() - 1),
                                EncodeString(file.name())}) ||
       std::binary_search(by_name_flat_.begin(), by_name_flat_.end(),
@@ -660,6 +1000,15 @@ bool EncodedDescriptorDatabase::DescriptorIndex::AddFile(const FileProto& file,
   return true;
 }
 
+template <typename FileProto>
+bool EncodedDescriptorDatabase::DescriptorIndex::AddFileDeferred(
+    const FileProto& file, Value value) {
+  deferred_ = true;
+  bool result = AddFile(file, value);
+  deferred_ = false;
+  return result;
+}
+
 template <typename Iter, typename Iter2, typename Index>
 static bool CheckForMutualSubsymbols(StringPiece symbol_name, Iter* iter,
                                      Iter2 end, const Index& index) {
@@ -704,6 +1053,11 @@ bool EncodedDescriptorDatabase::DescriptorIndex::AddSymbol(
     return false;
   }
 
+  if (deferred_) {
+    by_symbol_deferred_.push_back(entry);
+    return true;
+  }
+
   auto iter = FindLastLessOrEqual(&by_symbol_, entry);
   if (!CheckForMutualSubsymbols(entry_as_string, &iter, by_symbol_.end(),
                                 *this)) {
@@ -745,7 +1099,11 @@ bool EncodedDescriptorDatabase::DescriptorIndex::AddExtension(
   if (!field.extendee().empty() && field.extendee()[0] == '.') {
     // The extension is fully-qualified.  We can use it as a lookup key in
     // the by_symbol_ table.
-    if (!InsertIfNotPresent(
+    if (deferred_) {
+      by_extension_deferred_.push_back(
+          ExtensionEntry{static_cast<int>(all_values_.size() - 1),
+                         EncodeString(field.extendee()), field.number()});
+    } else if (!InsertIfNotPresent(
             &by_extension_,
             ExtensionEntry{static_cast<int>(all_values_.size() - 1),
                            EncodeString(field.extendee()), field.number()}) ||
@@ -810,12 +1168,106 @@ static void MergeIntoFlat(std::set<T, Less>* s, std::vector<T>* flat) {
   s->clear();
 }
 
+template <typename T, typename Less>
+static void MergeIntoFlat(std::vector<T>* sorted, std::vector<T>* flat,
+                          const Less& less) {
+  if (sorted->empty()) return;
+  std::vector<T> new_flat(sorted->size() + flat->size());
+  std::merge(sorted->begin(), sorted->end(), flat->begin(), flat->end(),
+             &new_flat[0], less);
+  *flat = std::move(new_flat);
+  sorted->clear();
+  sorted->shrink_to_fit();
+}
+
+// The deferred entries are sorted stably, so that among conflicting entries
+// the one added first is kept, as when inserting into the sets.
+
+void EncodedDescriptorDatabase::DescriptorIndex::FlattenDeferredNames() {
+  if (by_name_deferred_.empty()) return;
+  auto less = by_name_.key_comp();
+  std::stable_sort(by_name_deferred_.begin(), by_name_deferred_.end(), less);
+
+  std::vector<FileEntry> kept;
+  kept.reserve(by_name_deferred_.size());
+  for (const auto& entry : by_name_deferred_) {
+    if ((!kept.empty() && !less(kept.back(), entry)) ||
+        std::binary_search(by_name_flat_.begin(), by_name_flat_.end(), entry,
+                           less)) {
+      GOOGLE_LOG(ERROR) << "File already exists in database: "
+                 << entry.name(*this);
+      continue;
+    }
+    kept.push_back(entry);
+  }
+  by_name_deferred_.clear();
+  MergeIntoFlat(&kept, &by_name_flat_, less);
+}
+
+void EncodedDescriptorDatabase::DescriptorIndex::FlattenDeferredSymbols() {
+  if (by_symbol_deferred_.empty()) return;
+  auto less = by_symbol_.key_comp();
+  std::stable_sort(by_symbol_deferred_.begin(), by_symbol_deferred_.end(),
+                   less);
+
+  // '.' sorts before the other characters valid in symbol names, so a kept
+  // symbol that is a parent of the next one is always the last kept.
+  std::vector<SymbolEntry> kept;
+  kept.reserve(by_symbol_deferred_.size());
+  for (const auto& entry : by_symbol_deferred_) {
+    std::string entry_as_string = entry.AsString(*this);
+    if (!kept.empty() &&
+        IsSubSymbol(kept.back().AsString(*this), entry_as_string)) {
+      GOOGLE_LOG(ERROR) << "Symbol name \"" << entry_as_string
+                 << "\" conflicts with the existing symbol \""
+                 << kept.back().AsString(*this) << "\".";
+      continue;
+    }
+    auto flat_iter = FindLastLessOrEqual(&by_symbol_flat_, entry, less);
+    if (!CheckForMutualSubsymbols(entry_as_string, &flat_iter,
+                                  by_symbol_flat_.end(), *this)) {
+      continue;
+    }
+    kept.push_back(entry);
+  }
+  by_symbol_deferred_.clear();
+  MergeIntoFlat(&kept, &by_symbol_flat_, less);
+}
+
+void EncodedDescriptorDatabase::DescriptorIndex::FlattenDeferredExtensions() {
+  if (by_extension_deferred_.empty()) return;
+  auto less = by_extension_.key_comp();
+  std::stable_sort(by_extension_deferred_.begin(),
+                   by_extension_deferred_.end(), less);
+
+  std::vector<ExtensionEntry> kept;
+  kept.reserve(by_extension_deferred_.size());
+  for (const auto& entry : by_extension_deferred_) {
+    if ((!kept.empty() && !less(kept.back(), entry)) ||
+        std::binary_search(by_extension_flat_.begin(),
+                           by_extension_flat_.end(), entry, less)) {
+      GOOGLE_LOG(ERROR) << "Extension conflicts with extension already in database: "
+                    "extend ."
+                 << entry.extendee(*this) << " { " << entry.extension_number
+                 << " }";
+      continue;
+    }
+    kept.push_back(entry);
+  }
+  by_extension_deferred_.clear();
+  MergeIntoFlat(&kept, &by_extension_flat_, less);
+}
+
 void EncodedDescriptorDatabase::DescriptorIndex::EnsureFlat() {
   all_values_.shrink_to_fit();
   // Merge each of the sets into their flat counterpart.
   MergeIntoFlat(&by_name_, &by_name_flat_);
   MergeIntoFlat(&by_symbol_, &by_symbol_flat_);
   MergeIntoFlat(&by_extension_, &by_extension_flat_);
+  // Then the entries added in bulk.
+  FlattenDeferredNames();
+  FlattenDeferredSymbols();
+  FlattenDeferredExtensions();
 }
 
 bool EncodedDescriptorDatabase::DescriptorIndex::FindAllExtensionNumbers(
@@ -865,6 +1317,7 @@ EncodedDescriptorDatabase::DescriptorIndex::FindFile(
 
 bool EncodedDescriptorDatabase::FindAllFileNames(
     std::vector<std::string>* output) {
+  IndexLazyFiles();
   index_->FindAllFileNames(output);
   return true;
 }
@@ -886,6 +1339,443 @@ EncodedDescriptorDatabase::~EncodedDescriptorDatabase() {
 
 // ===================================================================
 
+namespace {
+
+// "PBDS" when read by a machine with the byte order of the writer.
+const uint32 kSnapshotMagic = 0x53444250;
+const uint32 kSnapshotVersion = 1;
+
+void AddFileAndDependencies(const FileDescriptor* file,
+                            std::set<const FileDescriptor*>* seen,
+                            std::vector<const FileDescriptor*>* output) {
+  if (!seen->insert(file).second) return;
+  for (int i = 0; i < file->dependency_count(); i++) {
+    AddFileAndDependencies(file->dependency(i), seen, output);
+  }
+  output->push_back(file);
+}
+
+void AddEnumSymbols(const EnumDescriptor* enum_type,
+                    std::vector<std::string>* symbols) {
+  symbols->push_back(enum_type->full_name());
+  for (int i = 0; i < enum_type->value_count(); i++) {
+    symbols->push_back(enum_type->value(i)->full_name());
+  }
+}
+
+void AddMessageSymbols(const Descriptor* message,
+                       std::vector<std::string>* symbols,
+                       std::vector<const FieldDescriptor*>* extensions) {
+  symbols->push_back(message->full_name());
+  for (int i = 0; i < message->field_count(); i++) {
+    symbols->push_back(message->field(i)->full_name());
+  }
+  for (int i = 0; i < message->oneof_decl_count(); i++) {
+    symbols->push_back(message->oneof_decl(i)->full_name());
+  }
+  for (int i = 0; i < message->extension_count(); i++) {
+    symbols->push_back(message->extension(i)->full_name());
+    extensions->push_back(message->extension(i));
+  }
+  for (int i = 0; i < message->nested_type_count(); i++) {
+    AddMessageSymbols(message->nested_type(i), symbols, extensions);
+  }
+  for (int i = 0; i < message->enum_type_count(); i++) {
+    AddEnumSymbols(message->enum_type(i), symbols);
+  }
+}
+
+void AddFileSymbols(const FileDescriptor* file,
+                    std::vector<std::string>* symbols,
+                    std::vector<const FieldDescriptor*>* extensions) {
+  for (int i = 0; i < file->message_type_count(); i++) {
+    AddMessageSymbols(file->message_type(i), symbols, extensions);
+  }
+  for (int i = 0; i < file->enum_type_count(); i++) {
+    AddEnumSymbols(file->enum_type(i), symbols);
+  }
+  for (int i = 0; i < file->extension_count(); i++) {
+    symbols->push_back(file->extension(i)->full_name());
+    extensions->push_back(file->extension(i));
+  }
+  for (int i = 0; i < file->service_count(); i++) {
+    const ServiceDescriptor* service = file->service(i);
+    symbols->push_back(service->full_name());
+    for (int j = 0; j < service->method_count(); j++) {
+      symbols->push_back(service->method(j)->full_name());
+    }
+  }
+}
+
+}  // namespace
+
+// All offsets are relative to the start of the snapshot.  The header is
+// followed by the file, symbol and extension tables, each sorted by name,
+// and then by the names and the encoded FileDescriptorProtos.
+struct SnapshotDescriptorDatabase::Header {
+  uint32 magic;
+  uint32 version;
+  uint32 size;
+  uint32 file_count;
+  uint32 file_table;
+  uint32 symbol_count;
+  uint32 symbol_table;
+  uint32 extension_count;
+  uint32 extension_table;
+};
+
+struct SnapshotDescriptorDatabase::FileEntry {
+  uint32 name_offset;
+  uint32 name_size;
+  uint32 data_offset;
+  uint32 data_size;
+};
+
+struct SnapshotDescriptorDatabase::SymbolEntry {
+  uint32 name_offset;
+  uint32 name_size;
+  uint32 file_index;
+};
+
+struct SnapshotDescriptorDatabase::ExtensionEntry {
+  uint32 extendee_offset;
+  uint32 extendee_size;
+  uint32 number;
+  uint32 file_index;
+};
+
+void SnapshotDescriptorDatabase::WriteSnapshot(
+    const std::vector<const FileDescriptor*>& files, std::string* output) {
+  std::set<const FileDescriptor*> seen;
+  std::vector<const FileDescriptor*> all_files;
+  for (const FileDescriptor* file : files) {
+    AddFileAndDependencies(file, &seen, &all_files);
+  }
+  std::sort(all_files.begin(), all_files.end(),
+            [](const FileDescriptor* a, const FileDescriptor* b) {
+              return a->name() < b->name();
+            });
+
+  std::vector<std::pair<std::string, uint32>> symbols;
+  std::vector<std::pair<const FieldDescriptor*, uint32>> extensions;
+  for (uint32 i = 0; i < all_files.size(); i++) {
+    std::vector<std::string> file_symbols;
+    std::vector<const FieldDescriptor*> file_extensions;
+    AddFileSymbols(all_files[i], &file_symbols, &file_extensions);
+    for (std::string& symbol : file_symbols) {
+      symbols.emplace_back(std::move(symbol), i);
+    }
+    for (const FieldDescriptor* extension : file_extensions) {
+      extensions.emplace_back(extension, i);
+    }
+  }
+  std::sort(symbols.begin(), symbols.end());
+  std::sort(extensions.begin(), extensions.end(),
+            [](const std::pair<const FieldDescriptor*, uint32>& a,
+               const std::pair<const FieldDescriptor*, uint32>& b) {
+              const std::string& a_extendee =
+                  a.first->containing_type()->full_name();
+              const std::string& b_extendee =
+                  b.first->containing_type()->full_name();
+              if (a_extendee != b_extendee) return a_extendee < b_extendee;
+              return a.first->number() < b.first->number();
+            });
+
+  Header header;
+  header.magic = kSnapshotMagic;
+  header.version = kSnapshotVersion;
+  header.file_count = all_files.size();
+  header.file_table = sizeof(Header);
+  header.symbol_count = symbols.size();
+  header.symbol_table =
+      header.file_table + header.file_count * sizeof(FileEntry);
+  header.extension_count = extensions.size();
+  header.extension_table =
+      header.symbol_table + header.symbol_count * sizeof(SymbolEntry);
+  const size_t blob_start =
+      header.extension_table + header.extension_count * sizeof(ExtensionEntry);
+
+  // Names and file contents follow the tables.  Extendee names are shared
+  // by all the extensions of a type.
+  std::string blobs;
+  std::map<std::string, uint32> extendee_offsets;
+  auto add_blob = [&](const std::string& blob) {
+    uint32 offset = blob_start + blobs.size();
+    blobs.append(blob);
+    return offset;
+  };
+
+  std::vector<FileEntry> file_table(all_files.size());
+  for (uint32 i = 0; i < all_files.size(); i++) {
+    FileDescriptorProto proto;
+    all_files[i]->CopyTo(&proto);
+    file_table[i].name_offset = add_blob(all_files[i]->name());
+    file_table[i].name_size = all_files[i]->name().size();
+    std::string data = proto.SerializeAsString();
+    file_table[i].data_offset = add_blob(data);
+    file_table[i].data_size = data.size();
+  }
+  std::vector<SymbolEntry> symbol_table(symbols.size());
+  for (uint32 i = 0; i < symbols.size(); i++) {
+    symbol_table[i].name_offset = add_blob(symbols[i].first);
+    symbol_table[i].name_size = symbols[i].first.size();
+    symbol_table[i].file_index = symbols[i].second;
+  }
+  std::vector<ExtensionEntry> extension_table(extensions.size());
+  for (uint32 i = 0; i < extensions.size(); i++) {
+    const std::string& extendee =
+        extensions[i].first->containing_type()->full_name();
+    auto it = extendee_offsets.find(extendee);
+    if (it == extendee_offsets.end()) {
+      it = extendee_offsets.insert(std::make_pair(extendee, add_blob(extendee)))
+               .first;
+    }
+    extension_table[i].extendee_offset = it->second;
+    extension_table[i].extendee_size = extendee.size();
+    extension_table[i].number = extensions[i].first->number();
+    extension_table[i].file_index = extensions[i].second;
+  }
+
+  GOOGLE_CHECK_LE(blob_start + blobs.size(), kuint32max)
+      << "Descriptor snapshot is too large.";
+  header.size = blob_start + blobs.size();
+
+  output->clear();
+  output->reserve(header.size);
+  output->append(reinterpret_cast<const char*>(&header), sizeof(header));
+  output->append(reinterpret_cast<const char*>(file_table.data()),
+                 file_table.size() * sizeof(FileEntry));
+  output->append(reinterpret_cast<const char*>(symbol_table.data()),
+                 symbol_table.size() * sizeof(SymbolEntry));
+  output->append(reinterpret_cast<const char*>(extension_table.data()),
+                 extension_table.size() * sizeof(ExtensionEntry));
+  output->append(blobs);
+}
+
+SnapshotDescriptorDatabase::SnapshotDescriptorDatabase()
+    : data_(nullptr),
+      size_(0),
+      files_(nullptr),
+      symbols_(nullptr),
+      extensions_(nullptr),
+      file_count_(0),
+      symbol_count_(0),
+      extension_count_(0),
+      mapping_(nullptr),
+      mapping_size_(0) {}
+
+SnapshotDescriptorDatabase::~SnapshotDescriptorDatabase() {
+#ifndef _WIN32
+  if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+#endif
+}
+
+bool SnapshotDescriptorDatabase::Open(const void* data, size_t size) {
+  GOOGLE_CHECK(data_ == nullptr) << "Snapshot is already open.";
+  const char* bytes = static_cast<const char*>(data);
+  if (reinterpret_cast<uintptr_t>(bytes) % alignof(Header) != 0) {
+    GOOGLE_LOG(ERROR) << "Descriptor snapshot is not aligned.";
+    return false;
+  }
+  if (size < sizeof(Header)) {
+    GOOGLE_LOG(ERROR) << "Descriptor snapshot is truncated.";
+    return false;
+  }
+  const Header* header = reinterpret_cast<const Header*>(bytes);
+  if (header->magic != kSnapshotMagic) {
+    GOOGLE_LOG(ERROR) << "Not a descriptor snapshot, or a snapshot written with "
+                  "another byte order.";
+    return false;
+  }
+  if (header->version != kSnapshotVersion) {
+    GOOGLE_LOG(ERROR) << "Unsupported descriptor snapshot version "
+               << header->version << ".";
+    return false;
+  }
+  if (header->size != size) {
+    GOOGLE_LOG(ERROR) << "Descriptor snapshot is " << size
+               << " bytes but its header says " << header->size << ".";
+    return false;
+  }
+
+  auto table_fits = [size](uint32 offset, uint32 count, size_t entry_size) {
+    return offset % alignof(uint32) == 0 &&
+           static_cast<uint64>(offset) + uint64{count} * entry_size <= size;
+  };
+  auto range_fits = [size](uint32 offset, uint32 length) {
+    return static_cast<uint64>(offset) + length <= size;
+  };
+  bool valid =
+      table_fits(header->file_table, header->file_count, sizeof(FileEntry)) &&
+      table_fits(header->symbol_table, header->symbol_count,
+                 sizeof(SymbolEntry)) &&
+      table_fits(header->extension_table, header->extension_count,
+                 sizeof(ExtensionEntry));
+  const FileEntry* files =
+      reinterpret_cast<const FileEntry*>(bytes + header->file_table);
+  const SymbolEntry* symbols =
+      reinterpret_cast<const SymbolEntry*>(bytes + header->symbol_table);
+  const ExtensionEntry* extensions =
+      reinterpret_cast<const ExtensionEntry*>(bytes + header->extension_table);
+  for (uint32 i = 0; valid && i < header->file_count; i++) {
+    valid = range_fits(files[i].name_offset, files[i].name_size) &&
+            range_fits(files[i].data_offset, files[i].data_size) &&
+            files[i].data_size <= kint32max;
+  }
+  for (uint32 i = 0; valid && i < header->symbol_count; i++) {
+    valid = range_fits(symbols[i].name_offset, symbols[i].name_size) &&
+            symbols[i].file_index < header->file_count;
+  }
+  for (uint32 i = 0; valid && i < header->extension_count; i++) {
+    valid = range_fits(extensions[i].extendee_offset,
+                       extensions[i].extendee_size) &&
+            extensions[i].file_index < header->file_count;
+  }
+  if (!valid) {
+    GOOGLE_LOG(ERROR) << "Descriptor snapshot is corrupt.";
+    return false;
+  }
+
+  data_ = bytes;
+  size_ = size;
+  files_ = files;
+  symbols_ = symbols;
+  extensions_ = extensions;
+  file_count_ = header->file_count;
+  symbol_count_ = header->symbol_count;
+  extension_count_ = header->extension_count;
+  return true;
+}
+
+bool SnapshotDescriptorDatabase::OpenFile(const std::string& filename) {
+  GOOGLE_CHECK(data_ == nullptr) << "Snapshot is already open.";
+#ifndef _WIN32
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    GOOGLE_LOG(ERROR) << "Could not open " << filename << ": "
+               << strerror(errno);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      close(fd);
+      mapping_ = mapping;
+      mapping_size_ = st.st_size;
+      return Open(mapping, mapping_size_);
+    }
+  }
+  close(fd);
+#endif
+  // The file could not be mapped; read it into memory instead.
+  std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!input) {
+    GOOGLE_LOG(ERROR) << "Could not open " << filename << ".";
+    return false;
+  }
+  contents_.assign(std::istreambuf_iterator<char>(input),
+                   std::istreambuf_iterator<char>());
+  if (input.bad()) {
+    GOOGLE_LOG(ERROR) << "Could not read " << filename << ".";
+    return false;
+  }
+  return Open(contents_.data(), contents_.size());
+}
+
+StringPiece SnapshotDescriptorDatabase::GetString(uint32 offset,
+                                                  uint32 size) const {
+  return StringPiece(data_ + offset, size);
+}
+
+bool SnapshotDescriptorDatabase::ParseFile(uint32 file_index,
+                                           FileDescriptorProto* output) const {
+  const FileEntry& file = files_[file_index];
+  return output->ParseFromArray(data_ + file.data_offset, file.data_size);
+}
+
+bool SnapshotDescriptorDatabase::FindFileByName(const std::string& filename,
+                                                FileDescriptorProto* output) {
+  const FileEntry* end = files_ + file_count_;
+  const FileEntry* it = std::lower_bound(
+      files_, end, StringPiece(filename),
+      [this](const FileEntry& entry, StringPiece name) {
+        return GetString(entry.name_offset, entry.name_size) < name;
+      });
+  if (it == end || GetString(it->name_offset, it->name_size) != filename) {
+    return false;
+  }
+  return ParseFile(it - files_, output);
+}
+
+bool SnapshotDescriptorDatabase::FindFileContainingSymbol(
+    const std::string& symbol_name, FileDescriptorProto* output) {
+  const SymbolEntry* end = symbols_ + symbol_count_;
+  const SymbolEntry* it = std::lower_bound(
+      symbols_, end, StringPiece(symbol_name),
+      [this](const SymbolEntry& entry, StringPiece name) {
+        return GetString(entry.name_offset, entry.name_size) < name;
+      });
+  if (it == end || GetString(it->name_offset, it->name_size) != symbol_name) {
+    return false;
+  }
+  return ParseFile(it->file_index, output);
+}
+
+bool SnapshotDescriptorDatabase::FindFileContainingExtension(
+    const std::string& containing_type, int field_number,
+    FileDescriptorProto* output) {
+  const ExtensionEntry* end = extensions_ + extension_count_;
+  const ExtensionEntry* it = std::lower_bound(
+      extensions_, end,
+      std::make_pair(StringPiece(containing_type), field_number),
+      [this](const ExtensionEntry& entry,
+             const std::pair<StringPiece, int>& key) {
+        StringPiece extendee =
+            GetString(entry.extendee_offset, entry.extendee_size);
+        return extendee < key.first ||
+               (extendee == key.first &&
+                static_cast<int>(entry.number) < key.second);
+      });
+  if (it == end ||
+      GetString(it->extendee_offset, it->extendee_size) != containing_type ||
+      static_cast<int>(it->number) != field_number) {
+    return false;
+  }
+  return ParseFile(it->file_index, output);
+}
+
+bool SnapshotDescriptorDatabase::FindAllExtensionNumbers(
+    const std::string& extendee_type, std::vector<int>* output) {
+  const ExtensionEntry* end = extensions_ + extension_count_;
+  const ExtensionEntry* it = std::lower_bound(
+      extensions_, end, StringPiece(extendee_type),
+      [this](const ExtensionEntry& entry, StringPiece extendee) {
+        return GetString(entry.extendee_offset, entry.extendee_size) <
+               extendee;
+      });
+  bool success = false;
+  for (; it != end &&
+         GetString(it->extendee_offset, it->extendee_size) == extendee_type;
+       ++it) {
+    output->push_back(it->number);
+    success = true;
+  }
+  return success;
+}
+
+bool SnapshotDescriptorDatabase::FindAllFileNames(
+    std::vector<std::string>* output) {
+  output->reserve(output->size() + file_count_);
+  for (uint32 i = 0; i < file_count_; i++) {
+    output->push_back(
+        std::string(GetString(files_[i].name_offset, files_[i].name_size)));
+  }
+  return true;
+}
+
+// ===================================================================
+
 DescriptorPoolDatabase::DescriptorPoolDatabase(const DescriptorPool& pool)
     : pool_(pool) {}
 DescriptorPoolDatabase::~DescriptorPoolDatabase() {}
@@ -57,6 +57,7 @@ namespace protobuf {
 class DescriptorDatabase;
 class SimpleDescriptorDatabase;
 class EncodedDescriptorDatabase;
+class SnapshotDescriptorDatabase;
 class DescriptorPoolDatabase;
 class MergedDescriptorDatabase;
 
@@ -297,6 +298,14 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   // need to keep it around.
   bool AddCopy(const void* encoded_file_descriptor, int size);
 
+  // Like Add(), but defers looking at the file until it is needed, so that
+  // adding is cheap.  The file's name is read the first time any file is
+  // looked up by name, and the file is only parsed to be returned from
+  // FindFileByName() until a lookup by symbol or extension indexes all such
+  // files at once.  Since nothing is checked here, invalid or conflicting
+  // files are logged when they are indexed rather than reported to the caller.
+  void AddLazily(const void* encoded_file_descriptor, int size);
+
   // Like FindFileContainingSymbol but returns only the name of the file.
   bool FindNameOfFileContainingSymbol(const std::string& symbol_name,
                                       std::string* output);
@@ -325,9 +334,98 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   bool MaybeParse(std::pair<const void*, int> encoded_file,
                   FileDescriptorProto* output);
 
+  // Files from AddLazily() that are not in index_: those whose names have not
+  // been read yet, and the rest sorted by name.  The names point into the
+  // encoded files.
+  std::vector<std::pair<const void*, int>> unnamed_lazy_files_;
+  std::vector<std::pair<StringPiece, std::pair<const void*, int>>>
+      lazy_files_by_name_;
+
+  // Returns the lazily added file with the given name, or {nullptr, 0}.
+  std::pair<const void*, int> FindLazyFile(const std::string& filename);
+  // Moves every lazily added file into index_.
+  void IndexLazyFiles();
+  // With `deferred`, the file is only sorted into index_ by its next lookup.
+  bool IndexFile(std::pair<const void*, int> encoded_file,
+                 bool deferred = false);
+
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(EncodedDescriptorDatabase);
 };
 
+// A read-only database over a descriptor snapshot: a single block of memory,
+// usually a mapped file, that holds a set of already-built files together
+// with sorted tables of their file names, symbols and extensions.  Opening a
+// snapshot only checks its tables; no file is parsed until it is looked up,
+// and lookups are binary searches over the snapshot itself.  This makes it
+// cheap for short-lived processes to back a DescriptorPool with a large set
+// of schemas.
+//
+// Snapshots are written by WriteSnapshot() from files that are already in a
+// DescriptorPool, so every symbol of every file is indexed exactly and
+// extensions are indexed by the full name of the type they extend.  The
+// caveats of SimpleDescriptorDatabase about relative extendee names don't
+// apply.  Snapshots use the byte order of the machine that wrote them and are
+// rejected on a machine with the other byte order.
+class PROTOBUF_EXPORT SnapshotDescriptorDatabase : public DescriptorDatabase {
+ public:
+  SnapshotDescriptorDatabase();
+  ~SnapshotDescriptorDatabase() override;
+
+  // Writes a snapshot of |files| and of all the files they import, directly
+  // or indirectly, to *output.
+  static void WriteSnapshot(const std::vector<const FileDescriptor*>& files,
+                            std::string* output);
+
+  // Uses the snapshot in the given bytes.  The database does not make a copy
+  // of the bytes, nor does it take ownership; they must remain valid for the
+  // life of the database.  Returns false and logs an error if the bytes are
+  // not a valid snapshot.  May only be called once.
+  bool Open(const void* data, size_t size);
+
+  // Maps the snapshot file with the given name into memory and uses it.  The
+  // mapping is released when the database is destroyed.  Returns false and
+  // logs an error if the file can't be read or is not a valid snapshot.
+  bool OpenFile(const std::string& filename);
+
+  // implements DescriptorDatabase -----------------------------------
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override;
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override;
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override;
+  bool FindAllExtensionNumbers(const std::string& extendee_type,
+                               std::vector<int>* output) override;
+  bool FindAllFileNames(std::vector<std::string>* output) override;
+
+ private:
+  struct Header;
+  struct FileEntry;
+  struct SymbolEntry;
+  struct ExtensionEntry;
+
+  StringPiece GetString(uint32 offset, uint32 size) const;
+  bool ParseFile(uint32 file_index, FileDescriptorProto* output) const;
+
+  const char* data_;
+  size_t size_;
+  const FileEntry* files_;
+  const SymbolEntry* symbols_;
+  const ExtensionEntry* extensions_;
+  uint32 file_count_;
+  uint32 symbol_count_;
+  uint32 extension_count_;
+
+  // Set when the snapshot was mapped by OpenFile().
+  void* mapping_;
+  size_t mapping_size_;
+  // Holds the snapshot when OpenFile() could not map it.
+  std::string contents_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(SnapshotDescriptorDatabase);
+};
+
 // A DescriptorDatabase that fetches files from a given pool.
 class PROTOBUF_EXPORT DescriptorPoolDatabase : public DescriptorDatabase {
  public:
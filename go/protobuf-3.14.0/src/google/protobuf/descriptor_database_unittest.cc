@@ -517,6 +517,150 @@ TEST(EncodedDescriptorDatabaseExtraTest, FindNameOfFileContainingSymbol) {
   EXPECT_FALSE(db.FindNameOfFileContainingSymbol("baz.Baz", &filename));
 }
 
+TEST(EncodedDescriptorDatabaseExtraTest, AddLazily) {
+  FileDescriptorProto file1, file2a, file2b, file3;
+  file1.set_name("foo.proto");
+  file1.set_package("foo");
+  file1.add_message_type()->set_name("Foo");
+  file2a.set_name("bar.proto");
+  file2b.set_package("bar");
+  file2b.add_message_type()->set_name("Bar");
+  file3.set_name("foo.proto");
+  file3.add_message_type()->set_name("Conflict");
+
+  std::string data1 = file1.SerializeAsString();
+  // Force out-of-order serialization to test slow path.
+  std::string data2 = file2b.SerializeAsString() + file2a.SerializeAsString();
+  std::string data3 = file3.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddLazily(data1.data(), data1.size());
+  db.AddLazily(data2.data(), data2.size());
+
+  FileDescriptorProto output;
+  EXPECT_TRUE(db.FindFileByName("foo.proto", &output));
+  EXPECT_EQ("foo.proto", output.name());
+  EXPECT_TRUE(db.FindFileByName("bar.proto", &output));
+  EXPECT_EQ("bar.proto", output.name());
+  EXPECT_FALSE(db.FindFileByName("baz.proto", &output));
+
+  // Files added after the names were read are found too, and the first file
+  // with a name wins.
+  db.AddLazily(data3.data(), data3.size());
+  EXPECT_FALSE(db.FindFileByName("baz.proto", &output));
+  EXPECT_TRUE(db.FindFileByName("foo.proto", &output));
+  EXPECT_EQ("Foo", output.message_type(0).name());
+
+  std::string filename;
+  EXPECT_TRUE(db.FindNameOfFileContainingSymbol("foo.Foo", &filename));
+  EXPECT_EQ("foo.proto", filename);
+  EXPECT_TRUE(db.FindFileContainingSymbol("bar.Bar", &output));
+  EXPECT_EQ("bar.proto", output.name());
+  EXPECT_FALSE(db.FindNameOfFileContainingSymbol("Conflict", &filename));
+
+  std::vector<std::string> names;
+  EXPECT_TRUE(db.FindAllFileNames(&names));
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(std::vector<std::string>({"bar.proto", "foo.proto"}), names);
+
+  // Everything still works once the files are indexed.
+  EXPECT_TRUE(db.FindFileByName("foo.proto", &output));
+  EXPECT_EQ("Foo", output.message_type(0).name());
+}
+
+TEST(SnapshotDescriptorDatabaseTest, FindsFilesSymbolsAndExtensions) {
+  FileDescriptorProto foo_file;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: \"foo.proto\" "
+      "package: \"foo\" "
+      "message_type { "
+      "  name: \"Foo\" "
+      "  field { name: \"qux\" number: 1 type: TYPE_INT32 "
+      "          label: LABEL_OPTIONAL } "
+      "  extension_range { start: 100 end: 200 } "
+      "  enum_type { name: \"Grault\" value { name: \"GARPLY\" number: 1 } } "
+      "}",
+      &foo_file));
+  FileDescriptorProto bar_file;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: \"bar.proto\" "
+      "package: \"bar\" "
+      "dependency: \"foo.proto\" "
+      "message_type { name: \"Bar\" } "
+      "extension { name: \"corge\" number: 123 type: TYPE_INT32 "
+      "            label: LABEL_OPTIONAL extendee: \"foo.Foo\" } "
+      "service { name: \"Baz\" }",
+      &bar_file));
+
+  DescriptorPool pool;
+  ASSERT_TRUE(pool.BuildFile(foo_file) != nullptr);
+  const FileDescriptor* bar = pool.BuildFile(bar_file);
+  ASSERT_TRUE(bar != nullptr);
+
+  // foo.proto is written because bar.proto imports it.
+  std::string snapshot;
+  SnapshotDescriptorDatabase::WriteSnapshot({bar}, &snapshot);
+  SnapshotDescriptorDatabase db;
+  ASSERT_TRUE(db.Open(snapshot.data(), snapshot.size()));
+
+  FileDescriptorProto file;
+  ASSERT_TRUE(db.FindFileByName("foo.proto", &file));
+  EXPECT_EQ(foo_file.DebugString(), file.DebugString());
+  EXPECT_FALSE(db.FindFileByName("baz.proto", &file));
+
+  ASSERT_TRUE(db.FindFileContainingSymbol("foo.Foo.qux", &file));
+  EXPECT_EQ("foo.proto", file.name());
+  ASSERT_TRUE(db.FindFileContainingSymbol("foo.Foo.GARPLY", &file));
+  EXPECT_EQ("foo.proto", file.name());
+  ASSERT_TRUE(db.FindFileContainingSymbol("bar.corge", &file));
+  EXPECT_EQ("bar.proto", file.name());
+  ASSERT_TRUE(db.FindFileContainingSymbol("bar.Baz", &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_FALSE(db.FindFileContainingSymbol("foo", &file));
+  EXPECT_FALSE(db.FindFileContainingSymbol("foo.Foo.Blah", &file));
+
+  ASSERT_TRUE(db.FindFileContainingExtension("foo.Foo", 123, &file));
+  EXPECT_EQ("bar.proto", file.name());
+  EXPECT_FALSE(db.FindFileContainingExtension("foo.Foo", 124, &file));
+
+  std::vector<int> numbers;
+  EXPECT_TRUE(db.FindAllExtensionNumbers("foo.Foo", &numbers));
+  EXPECT_THAT(numbers, testing::ElementsAre(123));
+  std::vector<std::string> names;
+  EXPECT_TRUE(db.FindAllFileNames(&names));
+  EXPECT_THAT(names, testing::ElementsAre("bar.proto", "foo.proto"));
+
+  // A pool backed by the snapshot builds files on demand.
+  DescriptorPool snapshot_pool(&db);
+  const Descriptor* foo = snapshot_pool.FindMessageTypeByName("foo.Foo");
+  ASSERT_TRUE(foo != nullptr);
+  const FieldDescriptor* corge =
+      snapshot_pool.FindExtensionByNumber(foo, 123);
+  ASSERT_TRUE(corge != nullptr);
+  EXPECT_EQ("bar.corge", corge->full_name());
+}
+
+TEST(SnapshotDescriptorDatabaseTest, RejectsCorruptSnapshots) {
+  FileDescriptorProto foo_file;
+  foo_file.set_name("foo.proto");
+  foo_file.add_message_type()->set_name("Foo");
+  DescriptorPool pool;
+  const FileDescriptor* foo = pool.BuildFile(foo_file);
+  ASSERT_TRUE(foo != nullptr);
+
+  std::string snapshot;
+  SnapshotDescriptorDatabase::WriteSnapshot({foo}, &snapshot);
+
+  std::string truncated = snapshot.substr(0, snapshot.size() - 1);
+  SnapshotDescriptorDatabase truncated_db;
+  EXPECT_FALSE(truncated_db.Open(truncated.data(), truncated.size()));
+
+  std::string bad_magic = snapshot;
+  bad_magic[0] ^= 1;
+  SnapshotDescriptorDatabase bad_magic_db;
+  EXPECT_FALSE(bad_magic_db.Open(bad_magic.data(), bad_magic.size()));
+}
+
 TEST(SimpleDescriptorDatabaseExtraTest, FindAllFileNames) {
   FileDescriptorProto f;
   f.set_name("foo.proto");
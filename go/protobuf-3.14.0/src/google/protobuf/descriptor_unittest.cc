@@ -36,6 +36,7 @@
 
 #include <limits>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <google/protobuf/any.pb.h>
@@ -2663,6 +2664,63 @@ TEST_F(MiscTest, FieldOptions) {
   EXPECT_EQ(FieldOptions::CORD, bar->options().ctype());
 }
 
+TEST_F(MiscTest, BuildFilesInAnyOrder) {
+  FileDescriptorProto foo_file;
+  foo_file.set_name("foo.proto");
+  AddMessage(&foo_file, "Foo");
+
+  FileDescriptorProto bar_file;
+  bar_file.set_name("bar.proto");
+  bar_file.add_dependency("foo.proto");
+  DescriptorProto* bar = AddMessage(&bar_file, "Bar");
+  AddField(bar, "foo", 1, FieldDescriptorProto::LABEL_OPTIONAL,
+           FieldDescriptorProto::TYPE_MESSAGE)
+      ->set_type_name("Foo");
+
+  // bar.proto comes before the file it imports.
+  std::vector<const FileDescriptorProto*> protos;
+  protos.push_back(&bar_file);
+  protos.push_back(&foo_file);
+
+  DescriptorPool pool;
+  std::vector<const FileDescriptor*> files = pool.BuildFiles(protos);
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ("bar.proto", files[0]->name());
+  EXPECT_EQ("foo.proto", files[1]->name());
+  EXPECT_EQ(files[1], files[0]->dependency(0));
+  EXPECT_EQ(files[1]->message_type(0),
+            files[0]->message_type(0)->field(0)->message_type());
+}
+
+TEST_F(MiscTest, BuildFilesRollsBackAllFilesOnError) {
+  FileDescriptorProto foo_file;
+  foo_file.set_name("foo.proto");
+  AddMessage(&foo_file, "Foo");
+
+  FileDescriptorProto bar_file;
+  bar_file.set_name("bar.proto");
+  bar_file.add_dependency("foo.proto");
+  DescriptorProto* bar = AddMessage(&bar_file, "Bar");
+  AddField(bar, "baz", 1, FieldDescriptorProto::LABEL_OPTIONAL,
+           FieldDescriptorProto::TYPE_MESSAGE)
+      ->set_type_name("Baz");
+
+  std::vector<const FileDescriptorProto*> protos;
+  protos.push_back(&foo_file);
+  protos.push_back(&bar_file);
+
+  DescriptorPool pool;
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool.BuildFiles(protos, &error_collector).empty());
+  EXPECT_EQ("bar.proto: Bar.baz: TYPE: \"Baz\" is not defined.\n",
+            error_collector.text_);
+
+  // foo.proto built fine, but it is not left behind in the pool.
+  EXPECT_TRUE(pool.FindFileByName("foo.proto") == nullptr);
+  EXPECT_TRUE(pool.FindMessageTypeByName("Foo") == nullptr);
+  EXPECT_TRUE(pool.BuildFile(foo_file) != nullptr);
+}
+
 // ===================================================================
 enum DescriptorPoolMode { NO_DATABASE, FALLBACK_DATABASE };
 
@@ -6897,6 +6955,44 @@ TEST_F(DatabaseBackedPoolTest, UnittestProto) {
   EXPECT_EQ(original_file->DebugString(), file_from_database->DebugString());
 }
 
+TEST_F(DatabaseBackedPoolTest, ConcurrentLookups) {
+  // Look up every message in unittest.proto from several threads at once,
+  // while the pool is still loading files from the database, so that the
+  // lock-free lookups race with the symbols being committed.
+  const FileDescriptor* original_file =
+      protobuf_unittest::TestAllTypes::descriptor()->file();
+  std::vector<std::string> names;
+  for (int i = 0; i < original_file->message_type_count(); i++) {
+    names.push_back(original_file->message_type(i)->full_name());
+  }
+
+  DescriptorPoolDatabase database(*DescriptorPool::generated_pool());
+  DescriptorPool pool(&database);
+  std::vector<std::vector<const Descriptor*>> found(8);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < found.size(); t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < names.size(); i++) {
+        // Start each thread at a different name.
+        const std::string& name = names[(i + t * 7) % names.size()];
+        found[t].push_back(pool.FindMessageTypeByName(name));
+        EXPECT_TRUE(pool.FindFileContainingSymbol(name) != nullptr);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int t = 0; t < found.size(); t++) {
+    ASSERT_EQ(names.size(), found[t].size());
+    for (int i = 0; i < names.size(); i++) {
+      const std::string& name = names[(i + t * 7) % names.size()];
+      ASSERT_TRUE(found[t][i] != nullptr) << name;
+      EXPECT_EQ(name, found[t][i]->full_name());
+      EXPECT_EQ(found[t][i], pool.FindMessageTypeByName(name));
+    }
+  }
+}
+
 TEST_F(DatabaseBackedPoolTest, DoesntRetryDbUnnecessarily) {
   // Searching for a child of an existing descriptor should never fall back
   // to the DescriptorDatabase even if it isn't found, because we know all
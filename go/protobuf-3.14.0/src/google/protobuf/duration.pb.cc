@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -213,6 +214,26 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Duration::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // int32 nanos = 2;
+  if (this->nanos() != 0) {
+    ptr = encoder->WriteInt32(2, this->_internal_nanos(), ptr);
+  }
+
+  // int64 seconds = 1;
+  if (this->seconds() != 0) {
+    ptr = encoder->WriteInt64(1, this->_internal_seconds(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Duration::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Duration)
   size_t total_size = 0;
@@ -68,6 +68,8 @@
 #include <cstddef>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/descriptor.h>
@@ -80,9 +82,11 @@
 #include <google/protobuf/map_field.h>
 #include <google/protobuf/map_field_inl.h>
 #include <google/protobuf/map_type_handler.h>
+#include <google/protobuf/parse_context.h>
 #include <google/protobuf/reflection_ops.h>
 #include <google/protobuf/repeated_field.h>
 #include <google/protobuf/wire_format.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <google/protobuf/port_def.inc>  // NOLINT
 
@@ -92,6 +96,8 @@ namespace protobuf {
 using internal::DynamicMapField;
 using internal::ExtensionSet;
 using internal::MapField;
+using internal::WireFormat;
+using internal::WireFormatLite;
 
 
 using internal::ArenaStringPtr;
@@ -256,6 +262,35 @@ inline int AlignOffset(int offset) { return AlignTo(offset, kSafeAlignment); }
 
 class DynamicMessage : public Message {
  public:
+  // How _InternalParse(), ByteSizeLong() and _InternalSerialize() treat a
+  // field.  Fields we don't handle inline are passed on to WireFormat.
+  enum FieldMode {
+    kReflection,  // Oneofs, maps, groups and weak fields.
+    kSingular,
+    kRepeated,
+    kPacked,
+  };
+
+  // One entry of the per-type parse and serialization table.
+  struct FieldEntry {
+    const FieldDescriptor* field;
+    // For message fields, the prototype of the field's type.
+    const Message* prototype;
+    // For singular string fields, the default passed to ArenaStringPtr.
+    const std::string* default_string;
+    uint32 offset;
+    uint32 has_bit;  // -1 if the field has no hasbit.
+    int number;
+    uint8 type;       // FieldDescriptor::Type
+    uint8 wire_type;  // WireFormatLite::WireType of a non-packed value.
+    uint8 tag_size;
+    uint8 mode;  // FieldMode
+    // False for closed enums, whose unknown values end up in the unknown
+    // field set; WireFormat takes care of those.
+    bool parse_inline;
+    bool strict_utf8;
+  };
+
   struct TypeInfo {
     int size;
     int has_bits_offset;
@@ -279,7 +314,18 @@ class DynamicMessage : public Message {
     const DynamicMessage* prototype;
     int weak_field_map_offset;  // The offset for the weak_field_map;
 
-    TypeInfo() : prototype(NULL) {}
+    // Built by BuildFieldTable() once the prototype has been cross-linked.
+    // If use_field_table is false (map entries and MessageSets) the message
+    // is parsed and serialized by WireFormat alone.
+    bool use_field_table;
+    std::vector<FieldEntry> field_table;  // Sorted by field number.
+    // Index into field_table by field number, -1 if there is no such field.
+    // Only covers small field numbers; larger ones are binary searched.
+    std::vector<int> field_index;
+    // Extension ranges as [start, end), sorted.
+    std::vector<std::pair<int, int> > extension_ranges;
+
+    TypeInfo() : prototype(NULL), use_field_table(false) {}
 
     ~TypeInfo() { delete prototype; }
   };
@@ -311,6 +357,16 @@ class DynamicMessage : public Message {
 
   Metadata GetMetadata() const override;
 
+  const char* _InternalParse(const char* ptr,
+                             internal::ParseContext* ctx) override;
+  size_t ByteSizeLong() const override;
+  uint8* _InternalSerialize(uint8* target,
+                            io::EpsCopyOutputStream* stream) const override;
+
+  // Fills in the field table of type_info.  Called by GetPrototypeNoLock()
+  // after the prototype is cross-linked.
+  static void BuildFieldTable(TypeInfo* type_info);
+
   // We actually allocate more memory than sizeof(*this) when this
   // class's memory is allocated via the global operator new. Thus, we need to
   // manually call the global operator delete. Calling the destructor is taken
@@ -342,6 +398,42 @@ class DynamicMessage : public Message {
     return reinterpret_cast<const uint8*>(this) + offset;
   }
 
+  template <typename T>
+  inline T* MutableRaw(const FieldEntry& entry) {
+    return reinterpret_cast<T*>(OffsetToPointer(entry.offset));
+  }
+  template <typename T>
+  inline const T& GetRaw(const FieldEntry& entry) const {
+    return *reinterpret_cast<const T*>(OffsetToPointer(entry.offset));
+  }
+
+  inline void SetHasBit(const FieldEntry& entry) {
+    if (entry.has_bit != static_cast<uint32>(-1)) {
+      reinterpret_cast<uint32*>(OffsetToPointer(
+          type_info_->has_bits_offset))[entry.has_bit / 32] |=
+          static_cast<uint32>(1) << (entry.has_bit % 32);
+    }
+  }
+
+  const FieldEntry* FindFieldEntry(int number) const;
+
+  // Same notion of presence as Reflection::HasField() for a kSingular field.
+  bool HasSingularField(const FieldEntry& entry) const;
+  const std::string& GetStringField(const FieldEntry& entry) const;
+  const Message& GetMessageField(const FieldEntry& entry) const;
+
+  template <typename T>
+  void StoreScalar(const FieldEntry& entry, T value);
+
+  const char* ParseField(const FieldEntry& entry, uint32 tag, const char* ptr,
+                         internal::ParseContext* ctx);
+  const char* ParsePacked(const FieldEntry& entry, const char* ptr,
+                          internal::ParseContext* ctx);
+  size_t PackedDataSize(const FieldEntry& entry) const;
+  size_t FieldByteSize(const FieldEntry& entry) const;
+  uint8* SerializeField(const FieldEntry& entry, uint8* target,
+                        io::EpsCopyOutputStream* stream) const;
+
   const TypeInfo* type_info_;
   mutable std::atomic<int> cached_byte_size_;
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(DynamicMessage);
@@ -650,6 +742,755 @@ Metadata DynamicMessage::GetMetadata() const {
   return metadata;
 }
 
+// -------------------------------------------------------------------
+// Parsing and serialization.
+//
+// WireFormat handles any message through reflection, which costs a field
+// lookup, a few virtual calls and a copy of every string.  Since we know the
+// layout of our own fields we can instead walk a table built once per type,
+// in the spirit of the table-driven parser of generated code, and only hand
+// the unusual cases (oneofs, maps, groups, closed enums, extensions and
+// unknown fields) to WireFormat.
+
+namespace {
+
+// Field numbers below this are looked up through TypeInfo::field_index.
+const int kMaxDenseFieldNumber = 512;
+
+bool CompareFieldEntryNumber(const DynamicMessage::FieldEntry& entry,
+                             int number) {
+  return entry.number < number;
+}
+
+bool CompareFieldEntries(const DynamicMessage::FieldEntry& a,
+                         const DynamicMessage::FieldEntry& b) {
+  return a.number < b.number;
+}
+
+}  // namespace
+
+void DynamicMessage::BuildFieldTable(TypeInfo* type_info) {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  const Descriptor* type = type_info->type;
+  if (type->options().map_entry() ||
+      type->options().message_set_wire_format()) {
+    return;
+  }
+  type_info->use_field_table = true;
+
+  bool open_enums = type->file()->syntax() == FileDescriptor::SYNTAX_PROTO3;
+  int max_number = 0;
+  type_info->field_table.reserve(type->field_count());
+  for (int i = 0; i < type->field_count(); i++) {
+    const FieldDescriptor* field = type->field(i);
+    FieldEntry entry;
+    entry.field = field;
+    entry.prototype = NULL;
+    entry.default_string = NULL;
+    entry.offset = type_info->offsets[i];
+    entry.has_bit = type_info->has_bits_indices != NULL
+                        ? type_info->has_bits_indices[i]
+                        : static_cast<uint32>(-1);
+    entry.number = field->number();
+    entry.type = field->type();
+    entry.wire_type = WireFormat::WireTypeForFieldType(field->type());
+    entry.tag_size = WireFormat::TagSize(field->number(), field->type());
+    entry.strict_utf8 =
+        field->file()->syntax() == FileDescriptor::SYNTAX_PROTO3;
+
+    if (InRealOneof(field) || field->is_map() ||
+        field->type() == FD::TYPE_GROUP || field->options().weak()) {
+      entry.mode = kReflection;
+    } else if (field->is_repeated()) {
+      entry.mode = field->is_packed() ? kPacked : kRepeated;
+    } else {
+      entry.mode = kSingular;
+    }
+    entry.parse_inline = entry.mode != kReflection &&
+                         (field->type() != FD::TYPE_ENUM || open_enums);
+
+    if (field->cpp_type() == FD::CPPTYPE_MESSAGE) {
+      entry.prototype =
+          type_info->factory->GetPrototypeNoLock(field->message_type());
+    } else if (field->cpp_type() == FD::CPPTYPE_STRING &&
+               entry.mode == kSingular) {
+      const ArenaStringPtr& default_value =
+          type_info->prototype->GetRaw<ArenaStringPtr>(entry);
+      entry.default_string = default_value.GetPointer();
+    }
+
+    max_number = std::max(max_number, field->number());
+    type_info->field_table.push_back(entry);
+  }
+  std::sort(type_info->field_table.begin(), type_info->field_table.end(),
+            CompareFieldEntries);
+
+  type_info->field_index.assign(std::min(max_number, kMaxDenseFieldNumber) + 1,
+                                -1);
+  for (int i = 0; i < static_cast<int>(type_info->field_table.size()); i++) {
+    int number = type_info->field_table[i].number;
+    if (number < static_cast<int>(type_info->field_index.size())) {
+      type_info->field_index[number] = i;
+    }
+  }
+
+  for (int i = 0; i < type->extension_range_count(); i++) {
+    const Descriptor::ExtensionRange* range = type->extension_range(i);
+    type_info->extension_ranges.push_back(
+        std::make_pair(range->start, range->end));
+  }
+  std::sort(type_info->extension_ranges.begin(),
+            type_info->extension_ranges.end());
+}
+
+const DynamicMessage::FieldEntry* DynamicMessage::FindFieldEntry(
+    int number) const {
+  const TypeInfo* info = type_info_;
+  if (number < static_cast<int>(info->field_index.size())) {
+    int index = info->field_index[number];
+    return index < 0 ? NULL : &info->field_table[index];
+  }
+  std::vector<FieldEntry>::const_iterator it =
+      std::lower_bound(info->field_table.begin(), info->field_table.end(),
+                       number, CompareFieldEntryNumber);
+  if (it == info->field_table.end() || it->number != number) return NULL;
+  return &*it;
+}
+
+bool DynamicMessage::HasSingularField(const FieldEntry& entry) const {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  if (entry.has_bit != static_cast<uint32>(-1)) {
+    const uint32* has_bits = reinterpret_cast<const uint32*>(
+        OffsetToPointer(type_info_->has_bits_offset));
+    return (has_bits[entry.has_bit / 32] &
+            (static_cast<uint32>(1) << (entry.has_bit % 32))) != 0;
+  }
+  // proto3 fields without "optional" are present when they are non-zero.
+  switch (entry.type) {
+    case FD::TYPE_INT32:
+    case FD::TYPE_SINT32:
+    case FD::TYPE_SFIXED32:
+    case FD::TYPE_ENUM:
+      return GetRaw<int32>(entry) != 0;
+    case FD::TYPE_INT64:
+    case FD::TYPE_SINT64:
+    case FD::TYPE_SFIXED64:
+      return GetRaw<int64>(entry) != 0;
+    case FD::TYPE_UINT32:
+    case FD::TYPE_FIXED32:
+      return GetRaw<uint32>(entry) != 0;
+    case FD::TYPE_UINT64:
+    case FD::TYPE_FIXED64:
+      return GetRaw<uint64>(entry) != 0;
+    case FD::TYPE_FLOAT:
+      return GetRaw<float>(entry) != 0.0;
+    case FD::TYPE_DOUBLE:
+      return GetRaw<double>(entry) != 0.0;
+    case FD::TYPE_BOOL:
+      return GetRaw<bool>(entry);
+    case FD::TYPE_STRING:
+    case FD::TYPE_BYTES:
+      return !GetStringField(entry).empty();
+    case FD::TYPE_MESSAGE:
+      return GetRaw<const Message*>(entry) != NULL;
+    case FD::TYPE_GROUP:
+      break;
+  }
+  GOOGLE_LOG(DFATAL) << "Can't get here.";
+  return false;
+}
+
+const std::string& DynamicMessage::GetStringField(
+    const FieldEntry& entry) const {
+  const std::string* value = GetRaw<ArenaStringPtr>(entry).GetPointer();
+  return value != NULL ? *value : entry.field->default_value_string();
+}
+
+const Message& DynamicMessage::GetMessageField(const FieldEntry& entry) const {
+  const Message* value = GetRaw<const Message*>(entry);
+  return value != NULL ? *value : *entry.prototype;
+}
+
+template <typename T>
+void DynamicMessage::StoreScalar(const FieldEntry& entry, T value) {
+  if (entry.mode == kSingular) {
+    *MutableRaw<T>(entry) = value;
+    SetHasBit(entry);
+  } else {
+    MutableRaw<RepeatedField<T> >(entry)->Add(value);
+  }
+}
+
+const char* DynamicMessage::_InternalParse(const char* ptr,
+                                           internal::ParseContext* ctx) {
+  if (!type_info_->use_field_table) {
+    return Message::_InternalParse(ptr, ctx);
+  }
+  while (!ctx->Done(&ptr)) {
+    uint32 tag;
+    ptr = internal::ReadTag(ptr, &tag);
+    if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) return nullptr;
+    if (tag == 0 || (tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+      ctx->SetLastTag(tag);
+      break;
+    }
+    int number = WireFormatLite::GetTagFieldNumber(tag);
+    const FieldEntry* entry = FindFieldEntry(number);
+    if (PROTOBUF_PREDICT_TRUE(entry != NULL)) {
+      ptr = ParseField(*entry, tag, ptr, ctx);
+    } else {
+      // Extension or unknown field; look it up the way WireFormat does.
+      const FieldDescriptor* field = NULL;
+      if (type_info_->type->IsExtensionNumber(number)) {
+        if (ctx->data().pool == nullptr) {
+          field = type_info_->reflection->FindKnownExtensionByNumber(number);
+        } else {
+          field = ctx->data().pool->FindExtensionByNumber(type_info_->type,
+                                                          number);
+        }
+      }
+      ptr = WireFormat::_InternalParseAndMergeField(
+          this, ptr, ctx, tag, type_info_->reflection.get(), field);
+    }
+    if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) return nullptr;
+  }
+  return ptr;
+}
+
+const char* DynamicMessage::ParseField(const FieldEntry& entry, uint32 tag,
+                                       const char* ptr,
+                                       internal::ParseContext* ctx) {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  int wire_type = WireFormatLite::GetTagWireType(tag);
+  if (!entry.parse_inline) {
+    // Handled by WireFormat below.
+  } else if (wire_type == entry.wire_type) {
+    switch (entry.type) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, WIRETYPE) \
+  case FD::TYPE_##TYPE: {                           \
+    WIRETYPE value;                                 \
+    ptr = internal::VarintParse(ptr, &value);       \
+    if (ptr == nullptr) return nullptr;             \
+    StoreScalar<CPPTYPE>(entry, value);             \
+    return ptr;                                     \
+  }
+
+      HANDLE_VARINT_TYPE(INT32, int32, uint32)
+      HANDLE_VARINT_TYPE(INT64, int64, uint64)
+      HANDLE_VARINT_TYPE(UINT32, uint32, uint32)
+      HANDLE_VARINT_TYPE(UINT64, uint64, uint64)
+      HANDLE_VARINT_TYPE(ENUM, int, uint32)
+#undef HANDLE_VARINT_TYPE
+
+      case FD::TYPE_BOOL: {
+        uint64 value;
+        ptr = internal::VarintParse(ptr, &value);
+        if (ptr == nullptr) return nullptr;
+        StoreScalar<bool>(entry, value != 0);
+        return ptr;
+      }
+      case FD::TYPE_SINT32: {
+        int32 value = internal::ReadVarintZigZag32(&ptr);
+        if (ptr == nullptr) return nullptr;
+        StoreScalar<int32>(entry, value);
+        return ptr;
+      }
+      case FD::TYPE_SINT64: {
+        int64 value = internal::ReadVarintZigZag64(&ptr);
+        if (ptr == nullptr) return nullptr;
+        StoreScalar<int64>(entry, value);
+        return ptr;
+      }
+
+#define HANDLE_FIXED_TYPE(TYPE, CPPTYPE)                               \
+  case FD::TYPE_##TYPE:                                                \
+    StoreScalar<CPPTYPE>(entry, internal::UnalignedLoad<CPPTYPE>(ptr)); \
+    return ptr + sizeof(CPPTYPE);
+
+      HANDLE_FIXED_TYPE(FIXED32, uint32)
+      HANDLE_FIXED_TYPE(FIXED64, uint64)
+      HANDLE_FIXED_TYPE(SFIXED32, int32)
+      HANDLE_FIXED_TYPE(SFIXED64, int64)
+      HANDLE_FIXED_TYPE(FLOAT, float)
+      HANDLE_FIXED_TYPE(DOUBLE, double)
+#undef HANDLE_FIXED_TYPE
+
+      case FD::TYPE_STRING:
+      case FD::TYPE_BYTES: {
+        std::string* value;
+        if (entry.mode == kSingular) {
+          value = MutableRaw<ArenaStringPtr>(entry)->MutableNoCopy(
+              entry.default_string, GetArena());
+          SetHasBit(entry);
+        } else {
+          value = MutableRaw<RepeatedPtrField<std::string> >(entry)->Add();
+        }
+        ptr = internal::InlineGreedyStringParser(value, ptr, ctx);
+        if (ptr == nullptr) return nullptr;
+        if (entry.type == FD::TYPE_STRING) {
+          if (entry.strict_utf8) {
+            if (!WireFormatLite::VerifyUtf8String(
+                    value->data(), value->length(), WireFormatLite::PARSE,
+                    entry.field->full_name().c_str())) {
+              return nullptr;
+            }
+          } else {
+            WireFormat::VerifyUTF8StringNamedField(
+                value->data(), value->length(), WireFormat::PARSE,
+                entry.field->full_name().c_str());
+          }
+        }
+        return ptr;
+      }
+
+      case FD::TYPE_MESSAGE: {
+        Message* value;
+        if (entry.mode == kSingular) {
+          Message** holder = MutableRaw<Message*>(entry);
+          if (*holder == NULL) *holder = entry.prototype->New(GetArena());
+          SetHasBit(entry);
+          value = *holder;
+        } else {
+          // Both the repeated field and the new message live on our arena,
+          // so the unsafe version of AddAllocated() is fine.
+          value = entry.prototype->New(GetArena());
+          MutableRaw<RepeatedPtrField<Message> >(entry)
+              ->UnsafeArenaAddAllocated(value);
+        }
+        return ctx->ParseMessage(value, ptr);
+      }
+
+      case FD::TYPE_GROUP:
+        break;
+    }
+  } else if (entry.mode != kSingular &&
+             wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+    // Packed and non-packed encodings are both accepted for repeated scalars.
+    return ParsePacked(entry, ptr, ctx);
+  }
+  return WireFormat::_InternalParseAndMergeField(
+      this, ptr, ctx, tag, type_info_->reflection.get(), entry.field);
+}
+
+const char* DynamicMessage::ParsePacked(const FieldEntry& entry,
+                                        const char* ptr,
+                                        internal::ParseContext* ctx) {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  void* field = OffsetToPointer(entry.offset);
+  switch (entry.type) {
+#define HANDLE_PACKED_TYPE(TYPE, PARSER) \
+  case FD::TYPE_##TYPE:                  \
+    return internal::Packed##PARSER##Parser(field, ptr, ctx);
+
+    HANDLE_PACKED_TYPE(INT32, Int32)
+    HANDLE_PACKED_TYPE(INT64, Int64)
+    HANDLE_PACKED_TYPE(SINT32, SInt32)
+    HANDLE_PACKED_TYPE(SINT64, SInt64)
+    HANDLE_PACKED_TYPE(UINT32, UInt32)
+    HANDLE_PACKED_TYPE(UINT64, UInt64)
+    HANDLE_PACKED_TYPE(FIXED32, Fixed32)
+    HANDLE_PACKED_TYPE(FIXED64, Fixed64)
+    HANDLE_PACKED_TYPE(SFIXED32, SFixed32)
+    HANDLE_PACKED_TYPE(SFIXED64, SFixed64)
+    HANDLE_PACKED_TYPE(FLOAT, Float)
+    HANDLE_PACKED_TYPE(DOUBLE, Double)
+    HANDLE_PACKED_TYPE(BOOL, Bool)
+    HANDLE_PACKED_TYPE(ENUM, Enum)
+#undef HANDLE_PACKED_TYPE
+
+    default:
+      GOOGLE_LOG(DFATAL) << "Can't get here.";
+      return nullptr;
+  }
+}
+
+size_t DynamicMessage::PackedDataSize(const FieldEntry& entry) const {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  switch (entry.type) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, METHOD) \
+  case FD::TYPE_##TYPE:                           \
+    return WireFormatLite::METHOD##Size(GetRaw<RepeatedField<CPPTYPE> >(entry));
+
+    HANDLE_VARINT_TYPE(INT32, int32, Int32)
+    HANDLE_VARINT_TYPE(INT64, int64, Int64)
+    HANDLE_VARINT_TYPE(SINT32, int32, SInt32)
+    HANDLE_VARINT_TYPE(SINT64, int64, SInt64)
+    HANDLE_VARINT_TYPE(UINT32, uint32, UInt32)
+    HANDLE_VARINT_TYPE(UINT64, uint64, UInt64)
+    HANDLE_VARINT_TYPE(ENUM, int, Enum)
+#undef HANDLE_VARINT_TYPE
+
+#define HANDLE_FIXED_TYPE(TYPE, CPPTYPE, METHOD)             \
+  case FD::TYPE_##TYPE:                                      \
+    return GetRaw<RepeatedField<CPPTYPE> >(entry).size() *   \
+           WireFormatLite::k##METHOD##Size;
+
+    HANDLE_FIXED_TYPE(FIXED32, uint32, Fixed32)
+    HANDLE_FIXED_TYPE(FIXED64, uint64, Fixed64)
+    HANDLE_FIXED_TYPE(SFIXED32, int32, SFixed32)
+    HANDLE_FIXED_TYPE(SFIXED64, int64, SFixed64)
+    HANDLE_FIXED_TYPE(FLOAT, float, Float)
+    HANDLE_FIXED_TYPE(DOUBLE, double, Double)
+    HANDLE_FIXED_TYPE(BOOL, bool, Bool)
+#undef HANDLE_FIXED_TYPE
+
+    default:
+      GOOGLE_LOG(DFATAL) << "Can't get here.";
+      return 0;
+  }
+}
+
+size_t DynamicMessage::ByteSizeLong() const {
+  const TypeInfo* info = type_info_;
+  if (!info->use_field_table || is_prototype()) {
+    // Message fields of the prototype point at other prototypes rather than
+    // being NULL, so leave presence to Reflection.
+    return Message::ByteSizeLong();
+  }
+  size_t total_size = 0;
+  for (const FieldEntry& entry : info->field_table) {
+    total_size += FieldByteSize(entry);
+  }
+  if (info->extensions_offset != -1) {
+    total_size += reinterpret_cast<const ExtensionSet*>(
+                      OffsetToPointer(info->extensions_offset))
+                      ->ByteSize();
+  }
+  total_size += WireFormat::ComputeUnknownFieldsSize(
+      info->reflection->GetUnknownFields(*this));
+  SetCachedSize(internal::ToCachedSize(total_size));
+  return total_size;
+}
+
+size_t DynamicMessage::FieldByteSize(const FieldEntry& entry) const {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  switch (entry.mode) {
+    case kReflection:
+      // WireFormat::FieldByteSize() expects to be called for present fields
+      // only.
+      if (!entry.field->is_repeated() &&
+          !type_info_->reflection->HasField(*this, entry.field)) {
+        return 0;
+      }
+      return WireFormat::FieldByteSize(entry.field, *this);
+
+    case kSingular:
+      if (!HasSingularField(entry)) return 0;
+      switch (entry.type) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, METHOD) \
+  case FD::TYPE_##TYPE:                           \
+    return entry.tag_size +                       \
+           WireFormatLite::METHOD##Size(GetRaw<CPPTYPE>(entry));
+
+        HANDLE_VARINT_TYPE(INT32, int32, Int32)
+        HANDLE_VARINT_TYPE(INT64, int64, Int64)
+        HANDLE_VARINT_TYPE(SINT32, int32, SInt32)
+        HANDLE_VARINT_TYPE(SINT64, int64, SInt64)
+        HANDLE_VARINT_TYPE(UINT32, uint32, UInt32)
+        HANDLE_VARINT_TYPE(UINT64, uint64, UInt64)
+        HANDLE_VARINT_TYPE(ENUM, int, Enum)
+#undef HANDLE_VARINT_TYPE
+
+#define HANDLE_FIXED_TYPE(TYPE, METHOD) \
+  case FD::TYPE_##TYPE:                 \
+    return entry.tag_size + WireFormatLite::k##METHOD##Size;
+
+        HANDLE_FIXED_TYPE(FIXED32, Fixed32)
+        HANDLE_FIXED_TYPE(FIXED64, Fixed64)
+        HANDLE_FIXED_TYPE(SFIXED32, SFixed32)
+        HANDLE_FIXED_TYPE(SFIXED64, SFixed64)
+        HANDLE_FIXED_TYPE(FLOAT, Float)
+        HANDLE_FIXED_TYPE(DOUBLE, Double)
+        HANDLE_FIXED_TYPE(BOOL, Bool)
+#undef HANDLE_FIXED_TYPE
+
+        case FD::TYPE_STRING:
+        case FD::TYPE_BYTES:
+          return entry.tag_size +
+                 WireFormatLite::LengthDelimitedSize(
+                     GetStringField(entry).size());
+        case FD::TYPE_MESSAGE:
+          return entry.tag_size +
+                 WireFormatLite::LengthDelimitedSize(
+                     GetMessageField(entry).ByteSizeLong());
+        case FD::TYPE_GROUP:
+          break;
+      }
+      break;
+
+    case kRepeated:
+      switch (entry.type) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, METHOD)                      \
+  case FD::TYPE_##TYPE: {                                              \
+    const RepeatedField<CPPTYPE>& values =                             \
+        GetRaw<RepeatedField<CPPTYPE> >(entry);                        \
+    return entry.tag_size * values.size() +                            \
+           WireFormatLite::METHOD##Size(values);                       \
+  }
+
+        HANDLE_VARINT_TYPE(INT32, int32, Int32)
+        HANDLE_VARINT_TYPE(INT64, int64, Int64)
+        HANDLE_VARINT_TYPE(SINT32, int32, SInt32)
+        HANDLE_VARINT_TYPE(SINT64, int64, SInt64)
+        HANDLE_VARINT_TYPE(UINT32, uint32, UInt32)
+        HANDLE_VARINT_TYPE(UINT64, uint64, UInt64)
+        HANDLE_VARINT_TYPE(ENUM, int, Enum)
+#undef HANDLE_VARINT_TYPE
+
+#define HANDLE_FIXED_TYPE(TYPE, CPPTYPE, METHOD)             \
+  case FD::TYPE_##TYPE:                                      \
+    return GetRaw<RepeatedField<CPPTYPE> >(entry).size() *   \
+           (entry.tag_size + WireFormatLite::k##METHOD##Size);
+
+        HANDLE_FIXED_TYPE(FIXED32, uint32, Fixed32)
+        HANDLE_FIXED_TYPE(FIXED64, uint64, Fixed64)
+        HANDLE_FIXED_TYPE(SFIXED32, int32, SFixed32)
+        HANDLE_FIXED_TYPE(SFIXED64, int64, SFixed64)
+        HANDLE_FIXED_TYPE(FLOAT, float, Float)
+        HANDLE_FIXED_TYPE(DOUBLE, double, Double)
+        HANDLE_FIXED_TYPE(BOOL, bool, Bool)
+#undef HANDLE_FIXED_TYPE
+
+        case FD::TYPE_STRING:
+        case FD::TYPE_BYTES: {
+          const RepeatedPtrField<std::string>& values =
+              GetRaw<RepeatedPtrField<std::string> >(entry);
+          size_t size = entry.tag_size * values.size();
+          for (int i = 0; i < values.size(); i++) {
+            size += WireFormatLite::LengthDelimitedSize(values.Get(i).size());
+          }
+          return size;
+        }
+        case FD::TYPE_MESSAGE: {
+          const RepeatedPtrField<Message>& values =
+              GetRaw<RepeatedPtrField<Message> >(entry);
+          size_t size = entry.tag_size * values.size();
+          for (int i = 0; i < values.size(); i++) {
+            size += WireFormatLite::LengthDelimitedSize(
+                values.Get(i).ByteSizeLong());
+          }
+          return size;
+        }
+        case FD::TYPE_GROUP:
+          break;
+      }
+      break;
+
+    case kPacked: {
+      size_t data_size = PackedDataSize(entry);
+      if (data_size == 0) return 0;
+      return entry.tag_size + WireFormatLite::LengthDelimitedSize(data_size);
+    }
+  }
+  GOOGLE_LOG(DFATAL) << "Can't get here.";
+  return 0;
+}
+
+uint8* DynamicMessage::_InternalSerialize(
+    uint8* target, io::EpsCopyOutputStream* stream) const {
+  const TypeInfo* info = type_info_;
+  if (!info->use_field_table || is_prototype()) {
+    return Message::_InternalSerialize(target, stream);
+  }
+  const ExtensionSet* extensions =
+      info->extensions_offset != -1
+          ? reinterpret_cast<const ExtensionSet*>(
+                OffsetToPointer(info->extensions_offset))
+          : NULL;
+  // Extension ranges never overlap field numbers, so each range is written
+  // in one piece, between the fields on either side of it.
+  std::vector<std::pair<int, int> >::const_iterator range =
+      info->extension_ranges.begin();
+  for (const FieldEntry& entry : info->field_table) {
+    for (; range != info->extension_ranges.end() &&
+           range->first < entry.number;
+         ++range) {
+      target = extensions->_InternalSerialize(range->first, range->second,
+                                              target, stream);
+    }
+    target = SerializeField(entry, target, stream);
+  }
+  for (; range != info->extension_ranges.end(); ++range) {
+    target = extensions->_InternalSerialize(range->first, range->second,
+                                            target, stream);
+  }
+  return WireFormat::InternalSerializeUnknownFieldsToArray(
+      info->reflection->GetUnknownFields(*this), target, stream);
+}
+
+uint8* DynamicMessage::SerializeField(const FieldEntry& entry, uint8* target,
+                                      io::EpsCopyOutputStream* stream) const {
+  typedef FieldDescriptor FD;  // avoid line wrapping
+  switch (entry.mode) {
+    case kReflection:
+      return WireFormat::InternalSerializeField(entry.field, *this, target,
+                                                stream);
+
+    case kSingular:
+      if (!HasSingularField(entry)) return target;
+      switch (entry.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                                  \
+  case FD::TYPE_##TYPE:                                                     \
+    target = stream->EnsureSpace(target);                                   \
+    return WireFormatLite::Write##METHOD##ToArray(entry.number,             \
+                                                  GetRaw<CPPTYPE>(entry),   \
+                                                  target);
+
+        HANDLE_TYPE(INT32, int32, Int32)
+        HANDLE_TYPE(INT64, int64, Int64)
+        HANDLE_TYPE(SINT32, int32, SInt32)
+        HANDLE_TYPE(SINT64, int64, SInt64)
+        HANDLE_TYPE(UINT32, uint32, UInt32)
+        HANDLE_TYPE(UINT64, uint64, UInt64)
+        HANDLE_TYPE(FIXED32, uint32, Fixed32)
+        HANDLE_TYPE(FIXED64, uint64, Fixed64)
+        HANDLE_TYPE(SFIXED32, int32, SFixed32)
+        HANDLE_TYPE(SFIXED64, int64, SFixed64)
+        HANDLE_TYPE(FLOAT, float, Float)
+        HANDLE_TYPE(DOUBLE, double, Double)
+        HANDLE_TYPE(BOOL, bool, Bool)
+        HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+        case FD::TYPE_STRING:
+        case FD::TYPE_BYTES: {
+          const std::string& value = GetStringField(entry);
+          if (entry.type == FD::TYPE_STRING) {
+            if (entry.strict_utf8) {
+              WireFormatLite::VerifyUtf8String(
+                  value.data(), value.length(), WireFormatLite::SERIALIZE,
+                  entry.field->full_name().c_str());
+            } else {
+              WireFormat::VerifyUTF8StringNamedField(
+                  value.data(), value.length(), WireFormat::SERIALIZE,
+                  entry.field->full_name().c_str());
+            }
+          }
+          return stream->WriteString(entry.number, value, target);
+        }
+        case FD::TYPE_MESSAGE:
+          target = stream->EnsureSpace(target);
+          return WireFormatLite::InternalWriteMessage(
+              entry.number, GetMessageField(entry), target, stream);
+        case FD::TYPE_GROUP:
+          break;
+      }
+      break;
+
+    case kRepeated:
+      switch (entry.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                                \
+  case FD::TYPE_##TYPE: {                                                 \
+    const RepeatedField<CPPTYPE>& values =                                \
+        GetRaw<RepeatedField<CPPTYPE> >(entry);                           \
+    for (int i = 0; i < values.size(); i++) {                             \
+      target = stream->EnsureSpace(target);                               \
+      target = WireFormatLite::Write##METHOD##ToArray(                    \
+          entry.number, values.Get(i), target);                           \
+    }                                                                     \
+    return target;                                                        \
+  }
+
+        HANDLE_TYPE(INT32, int32, Int32)
+        HANDLE_TYPE(INT64, int64, Int64)
+        HANDLE_TYPE(SINT32, int32, SInt32)
+        HANDLE_TYPE(SINT64, int64, SInt64)
+        HANDLE_TYPE(UINT32, uint32, UInt32)
+        HANDLE_TYPE(UINT64, uint64, UInt64)
+        HANDLE_TYPE(FIXED32, uint32, Fixed32)
+        HANDLE_TYPE(FIXED64, uint64, Fixed64)
+        HANDLE_TYPE(SFIXED32, int32, SFixed32)
+        HANDLE_TYPE(SFIXED64, int64, SFixed64)
+        HANDLE_TYPE(FLOAT, float, Float)
+        HANDLE_TYPE(DOUBLE, double, Double)
+        HANDLE_TYPE(BOOL, bool, Bool)
+        HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+        case FD::TYPE_STRING:
+        case FD::TYPE_BYTES: {
+          const RepeatedPtrField<std::string>& values =
+              GetRaw<RepeatedPtrField<std::string> >(entry);
+          for (int i = 0; i < values.size(); i++) {
+            const std::string& value = values.Get(i);
+            if (entry.type == FD::TYPE_STRING) {
+              if (entry.strict_utf8) {
+                WireFormatLite::VerifyUtf8String(
+                    value.data(), value.length(), WireFormatLite::SERIALIZE,
+                    entry.field->full_name().c_str());
+              } else {
+                WireFormat::VerifyUTF8StringNamedField(
+                    value.data(), value.length(), WireFormat::SERIALIZE,
+                    entry.field->full_name().c_str());
+              }
+            }
+            target = stream->WriteString(entry.number, value, target);
+          }
+          return target;
+        }
+        case FD::TYPE_MESSAGE: {
+          const RepeatedPtrField<Message>& values =
+              GetRaw<RepeatedPtrField<Message> >(entry);
+          for (int i = 0; i < values.size(); i++) {
+            target = stream->EnsureSpace(target);
+            target = WireFormatLite::InternalWriteMessage(
+                entry.number, values.Get(i), target, stream);
+          }
+          return target;
+        }
+        case FD::TYPE_GROUP:
+          break;
+      }
+      break;
+
+    case kPacked:
+      switch (entry.type) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, METHOD)                            \
+  case FD::TYPE_##TYPE: {                                                    \
+    const RepeatedField<CPPTYPE>& values =                                   \
+        GetRaw<RepeatedField<CPPTYPE> >(entry);                              \
+    if (values.empty()) return target;                                       \
+    target = stream->EnsureSpace(target);                                    \
+    return stream->Write##METHOD##Packed(                                    \
+        entry.number, values, static_cast<int>(PackedDataSize(entry)),       \
+        target);                                                             \
+  }
+
+        HANDLE_VARINT_TYPE(INT32, int32, Int32)
+        HANDLE_VARINT_TYPE(INT64, int64, Int64)
+        HANDLE_VARINT_TYPE(SINT32, int32, SInt32)
+        HANDLE_VARINT_TYPE(SINT64, int64, SInt64)
+        HANDLE_VARINT_TYPE(UINT32, uint32, UInt32)
+        HANDLE_VARINT_TYPE(UINT64, uint64, UInt64)
+        HANDLE_VARINT_TYPE(ENUM, int, Enum)
+#undef HANDLE_VARINT_TYPE
+
+#define HANDLE_FIXED_TYPE(TYPE, CPPTYPE)                             \
+  case FD::TYPE_##TYPE: {                                            \
+    const RepeatedField<CPPTYPE>& values =                           \
+        GetRaw<RepeatedField<CPPTYPE> >(entry);                      \
+    if (values.empty()) return target;                               \
+    return stream->WriteFixedPacked(entry.number, values, target);   \
+  }
+
+        HANDLE_FIXED_TYPE(FIXED32, uint32)
+        HANDLE_FIXED_TYPE(FIXED64, uint64)
+        HANDLE_FIXED_TYPE(SFIXED32, int32)
+        HANDLE_FIXED_TYPE(SFIXED64, int64)
+        HANDLE_FIXED_TYPE(FLOAT, float)
+        HANDLE_FIXED_TYPE(DOUBLE, double)
+        HANDLE_FIXED_TYPE(BOOL, bool)
+#undef HANDLE_FIXED_TYPE
+
+        default:
+          break;
+      }
+      break;
+  }
+  GOOGLE_LOG(DFATAL) << "Can't get here.";
+  return target;
+}
+
 // ===================================================================
 
 struct DynamicMessageFactory::PrototypeMap {
@@ -844,6 +1685,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
 
   // Cross link prototypes.
   prototype->CrossLinkPrototypes();
+  DynamicMessage::BuildFieldTable(type_info);
 
   return prototype;
 }
@@ -286,6 +286,69 @@ TEST_F(DynamicMessageTest, Arena) {
   // Return without freeing: should not leak.
 }
 
+TEST_P(DynamicMessageTest, ParseAndSerialize) {
+  // DynamicMessage parses and serializes most fields without going through
+  // reflection; the result must match the generated code byte for byte.
+  Arena arena;
+  std::vector<std::string> inputs;
+  unittest::TestAllTypes all_types;
+  TestUtil::SetAllFields(&all_types);
+  inputs.push_back(all_types.SerializeAsString());
+  unittest::TestAllExtensions all_extensions;
+  TestUtil::SetAllExtensions(&all_extensions);
+  inputs.push_back(all_extensions.SerializeAsString());
+  unittest::TestPackedTypes packed_types;
+  TestUtil::SetPackedFields(&packed_types);
+  inputs.push_back(packed_types.SerializeAsString());
+  unittest::TestOneof2 oneof;
+  TestUtil::SetOneof1(&oneof);
+  inputs.push_back(oneof.SerializeAsString());
+  proto2_nofieldpresence_unittest::TestAllTypes proto3;
+  proto3.set_optional_int32(-5);
+  proto3.set_optional_string("abc");
+  proto3.mutable_optional_nested_message()->set_bb(7);
+  proto3.add_repeated_int32(1);
+  proto3.add_repeated_int32(-1);
+  proto3.add_repeated_string("def");
+  inputs.push_back(proto3.SerializeAsString());
+
+  const Message* prototypes[] = {prototype_, extensions_prototype_,
+                                 packed_prototype_, oneof_prototype_,
+                                 proto3_prototype_};
+  for (int i = 0; i < inputs.size(); i++) {
+    SCOPED_TRACE(prototypes[i]->GetDescriptor()->full_name());
+    Message* message = prototypes[i]->New(GetParam() ? &arena : NULL);
+    ASSERT_TRUE(message->ParseFromString(inputs[i]));
+    EXPECT_EQ(inputs[i].size(), message->ByteSizeLong());
+    EXPECT_EQ(inputs[i], message->SerializeAsString());
+
+    // Merging the same data again appends to repeated fields.
+    ASSERT_TRUE(message->MergeFromString(inputs[i]));
+    std::string twice = message->SerializeAsString();
+    EXPECT_EQ(message->ByteSizeLong(), twice.size());
+    if (!GetParam()) {
+      delete message;
+    }
+  }
+}
+
+TEST_F(DynamicMessageTest, ParsePackedIntoUnpacked) {
+  // Repeated scalars accept both the packed and the non-packed encoding.
+  const Descriptor* unpacked_descriptor =
+      pool_.FindMessageTypeByName("protobuf_unittest.TestUnpackedTypes");
+  ASSERT_TRUE(unpacked_descriptor != NULL);
+  std::unique_ptr<Message> message(
+      factory_.GetPrototype(unpacked_descriptor)->New());
+
+  unittest::TestPackedTypes packed_types;
+  TestUtil::SetPackedFields(&packed_types);
+  ASSERT_TRUE(message->ParseFromString(packed_types.SerializeAsString()));
+
+  unittest::TestUnpackedTypes unpacked_types;
+  TestUtil::SetUnpackedFields(&unpacked_types);
+  EXPECT_EQ(unpacked_types.SerializeAsString(), message->SerializeAsString());
+}
+
 TEST_F(DynamicMessageTest, Proto3) {
   Message* message = proto3_prototype_->New();
   const Reflection* refl = message->GetReflection();
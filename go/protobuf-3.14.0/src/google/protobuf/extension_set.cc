@@ -34,6 +34,7 @@
 
 #include <google/protobuf/extension_set.h>
 
+#include <limits>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -188,24 +189,18 @@ ExtensionSet::ExtensionSet(Arena* arena)
     : arena_(arena),
       flat_capacity_(0),
       flat_size_(0),
-      map_{flat_capacity_ == 0
-               ? NULL
-               : Arena::CreateArray<KeyValue>(arena_, flat_capacity_)} {}
+      flat_(nullptr) {}
 
 ExtensionSet::~ExtensionSet() {
   // Deletes all allocated extensions.
   if (arena_ == NULL) {
     ForEach([](int /* number */, Extension& ext) { ext.Free(); });
-    if (PROTOBUF_PREDICT_FALSE(is_large())) {
-      delete map_.large;
-    } else {
-      DeleteFlatMap(map_.flat, flat_capacity_);
-    }
+    DeleteFlatMap(flat_, flat_capacity_);
   }
 }
 
 void ExtensionSet::DeleteFlatMap(const ExtensionSet::KeyValue* flat,
-                                 uint16 flat_capacity) {
+                                 uint32 flat_capacity) {
 #ifdef __cpp_sized_deallocation
   // Arena::CreateArray already requires a trivially destructible type, but
   // ensure this constraint is not violated in the future.
@@ -901,16 +896,8 @@ size_t SizeOfUnion(ItX it_xs, ItX end_xs, ItY it_ys, ItY end_ys) {
 }  // namespace
 
 void ExtensionSet::MergeFrom(const ExtensionSet& other) {
-  if (PROTOBUF_PREDICT_TRUE(!is_large())) {
-    if (PROTOBUF_PREDICT_TRUE(!other.is_large())) {
-      GrowCapacity(SizeOfUnion(flat_begin(), flat_end(), other.flat_begin(),
-                               other.flat_end()));
-    } else {
-      GrowCapacity(SizeOfUnion(flat_begin(), flat_end(),
-                               other.map_.large->begin(),
-                               other.map_.large->end()));
-    }
-  }
+  GrowCapacity(SizeOfUnion(flat_begin(), flat_end(), other.flat_begin(),
+                           other.flat_end()));
   other.ForEach([this](int number, const Extension& ext) {
     this->InternalExtensionMergeFrom(number, ext);
   });
@@ -1059,7 +1046,7 @@ void ExtensionSet::Swap(ExtensionSet* x) {
     using std::swap;
     swap(flat_capacity_, x->flat_capacity_);
     swap(flat_size_, x->flat_size_);
-    swap(map_, x->map_);
+    swap(flat_, x->flat_);
   } else {
     // TODO(cfallin, rohananil): We maybe able to optimize a case where we are
     // swapping from heap to arena-allocated extension set, by just Own()'ing
@@ -1127,12 +1114,6 @@ void ExtensionSet::SwapExtension(ExtensionSet* other, int number) {
 bool ExtensionSet::IsInitialized() const {
   // Extensions are never required.  However, we need to check that all
   // embedded messages are initialized.
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    for (const auto& kv : *map_.large) {
-      if (!kv.second.IsInitialized()) return false;
-    }
-    return true;
-  }
   for (const KeyValue* it = flat_begin(); it != flat_end(); ++it) {
     if (!it->second.IsInitialized()) return false;
   }
@@ -1458,18 +1439,8 @@ bool ExtensionSet::ParseMessageSet(io::CodedInputStream* input,
 uint8* ExtensionSet::_InternalSerialize(int start_field_number,
                                         int end_field_number, uint8* target,
                                         io::EpsCopyOutputStream* stream) const {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    const auto& end = map_.large->end();
-    for (auto it = map_.large->lower_bound(start_field_number);
-         it != end && it->first < end_field_number; ++it) {
-      target = it->second.InternalSerializeFieldWithCachedSizesToArray(
-          it->first, target, stream);
-    }
-    return target;
-  }
   const KeyValue* end = flat_end();
-  for (const KeyValue* it = std::lower_bound(
-           flat_begin(), end, start_field_number, KeyValue::FirstComparator());
+  for (const KeyValue* it = LowerBound(flat_begin(), end, start_field_number);
        it != end && it->first < end_field_number; ++it) {
     target = it->second.InternalSerializeFieldWithCachedSizesToArray(
         it->first, target, stream);
@@ -1787,61 +1758,50 @@ bool ExtensionSet::Extension::IsInitialized() const {
 // Dummy key method to avoid weak vtable.
 void ExtensionSet::LazyMessageExtension::UnusedKeyMethod() {}
 
-const ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) const {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    return FindOrNullInLargeMap(key);
+const ExtensionSet::KeyValue* ExtensionSet::LowerBound(const KeyValue* begin,
+                                                       const KeyValue* end,
+                                                       int key) {
+  size_t n = end - begin;
+  if (n <= kLinearSearchSize) {
+    while (begin != end && begin->first < key) ++begin;
+    return begin;
   }
-  const KeyValue* end = flat_end();
-  const KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
-  if (it != end && it->first == key) {
-    return &it->second;
+  // Halve the range without branching on the comparison; the compiler turns
+  // the conditional add into a cmov.
+  while (n > 1) {
+    size_t half = n / 2;
+    begin += begin[half - 1].first < key ? half : 0;
+    n -= half;
   }
-  return NULL;
+  return begin + (begin->first < key);
 }
 
-const ExtensionSet::Extension* ExtensionSet::FindOrNullInLargeMap(
-    int key) const {
-  assert(is_large());
-  LargeMap::const_iterator it = map_.large->find(key);
-  if (it != map_.large->end()) {
+const ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) const {
+  const KeyValue* end = flat_end();
+  const KeyValue* it = LowerBound(flat_begin(), end, key);
+  if (it != end && it->first == key) {
     return &it->second;
   }
   return NULL;
 }
 
 ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    return FindOrNullInLargeMap(key);
-  }
   KeyValue* end = flat_end();
-  KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
+  KeyValue* it = LowerBound(flat_begin(), end, key);
   if (it != end && it->first == key) {
     return &it->second;
   }
   return NULL;
 }
 
-ExtensionSet::Extension* ExtensionSet::FindOrNullInLargeMap(int key) {
-  assert(is_large());
-  LargeMap::iterator it = map_.large->find(key);
-  if (it != map_.large->end()) {
-    return &it->second;
-  }
-  return NULL;
-}
-
 std::pair<ExtensionSet::Extension*, bool> ExtensionSet::Insert(int key) {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    auto maybe = map_.large->insert({key, Extension()});
-    return {&maybe.first->second, maybe.second};
-  }
   KeyValue* end = flat_end();
-  KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
-  if (it != end && it->first == key) {
-    return {&it->second, false};
+  KeyValue* it = end;
+  if (flat_size_ != 0 && end[-1].first >= key) {
+    it = LowerBound(flat_begin(), end, key);
+    if (it->first == key) {
+      return {&it->second, false};
+    }
   }
   if (flat_size_ < flat_capacity_) {
     std::copy_backward(it, end, end + 1);
@@ -1855,53 +1815,35 @@ std::pair<ExtensionSet::Extension*, bool> ExtensionSet::Insert(int key) {
 }
 
 void ExtensionSet::GrowCapacity(size_t minimum_new_capacity) {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    return;  // LargeMap does not have a "reserve" method.
-  }
   if (flat_capacity_ >= minimum_new_capacity) {
     return;
   }
 
-  auto new_flat_capacity = flat_capacity_;
+  size_t new_flat_capacity = flat_capacity_;
   do {
-    new_flat_capacity = new_flat_capacity == 0 ? 1 : new_flat_capacity * 4;
+    // Grow quickly while small, then double to bound the wasted space.
+    new_flat_capacity = new_flat_capacity == 0   ? 1
+                        : new_flat_capacity < 64 ? new_flat_capacity * 4
+                                                 : new_flat_capacity * 2;
   } while (new_flat_capacity < minimum_new_capacity);
+  GOOGLE_CHECK_LE(new_flat_capacity, std::numeric_limits<uint32>::max());
 
-  const KeyValue* begin = flat_begin();
-  const KeyValue* end = flat_end();
-  AllocatedData new_map;
-  if (new_flat_capacity > kMaximumFlatCapacity) {
-    new_map.large = Arena::Create<LargeMap>(arena_);
-    LargeMap::iterator hint = new_map.large->begin();
-    for (const KeyValue* it = begin; it != end; ++it) {
-      hint = new_map.large->insert(hint, {it->first, it->second});
-    }
-  } else {
-    new_map.flat = Arena::CreateArray<KeyValue>(arena_, new_flat_capacity);
-    std::copy(begin, end, new_map.flat);
-  }
+  KeyValue* new_flat = Arena::CreateArray<KeyValue>(arena_, new_flat_capacity);
+  std::copy(flat_begin(), flat_end(), new_flat);
 
   if (arena_ == nullptr) {
-    DeleteFlatMap(begin, flat_capacity_);
-  }
-  flat_capacity_ = new_flat_capacity;
-  map_ = new_map;
-  if (is_large()) {
-    flat_size_ = 0;
+    DeleteFlatMap(flat_, flat_capacity_);
   }
+  flat_capacity_ = static_cast<uint32>(new_flat_capacity);
+  flat_ = new_flat;
 }
 
 // static
-constexpr uint16 ExtensionSet::kMaximumFlatCapacity;
+constexpr int ExtensionSet::kLinearSearchSize;
 
 void ExtensionSet::Erase(int key) {
-  if (PROTOBUF_PREDICT_FALSE(is_large())) {
-    map_.large->erase(key);
-    return;
-  }
   KeyValue* end = flat_end();
-  KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
+  KeyValue* it = LowerBound(flat_begin(), end, key);
   if (it != end && it->first == key) {
     std::copy(it + 1, end, it);
     --flat_size_;
@@ -643,35 +643,36 @@ class PROTOBUF_EXPORT ExtensionSet {
     };
   };
 
-  typedef std::map<int, Extension> LargeMap;
-
-  // Wrapper API that switches between flat-map and LargeMap.
-
   // Finds a key (if present) in the ExtensionSet.
   const Extension* FindOrNull(int key) const;
   Extension* FindOrNull(int key);
 
-  // Helper-functions that only inspect the LargeMap.
-  const Extension* FindOrNullInLargeMap(int key) const;
-  Extension* FindOrNullInLargeMap(int key);
+  // Returns the first element in [begin, end) whose key is not less than key.
+  // Small sets are scanned linearly, which beats a binary search over the few
+  // cache lines involved; larger ones use a branch-free binary search.
+  static const KeyValue* LowerBound(const KeyValue* begin, const KeyValue* end,
+                                    int key);
+  static KeyValue* LowerBound(KeyValue* begin, KeyValue* end, int key) {
+    return const_cast<KeyValue*>(
+        LowerBound(static_cast<const KeyValue*>(begin),
+                   static_cast<const KeyValue*>(end), key));
+  }
 
   // Inserts a new (key, Extension) into the ExtensionSet (and returns true), or
   // finds the already-existing Extension for that key (returns false).
   // The Extension* will point to the new-or-found Extension.
+  // Keys above every existing key are appended without searching, so parsing
+  // extensions in field number order builds the array front to back.
   std::pair<Extension*, bool> Insert(int key);
 
   // Grows the flat_capacity_.
-  // If flat_capacity_ > kMaximumFlatCapacity, converts to LargeMap.
   void GrowCapacity(size_t minimum_new_capacity);
-  static constexpr uint16 kMaximumFlatCapacity = 256;
-  bool is_large() const { return flat_capacity_ > kMaximumFlatCapacity; }
+  static constexpr int kLinearSearchSize = 16;
 
   // Removes a key from the ExtensionSet.
   void Erase(int key);
 
-  size_t Size() const {
-    return PROTOBUF_PREDICT_FALSE(is_large()) ? map_.large->size() : flat_size_;
-  }
+  size_t Size() const { return flat_size_; }
 
   // Similar to std::for_each.
   // Each Iterator is decomposed into ->first and ->second fields, so
@@ -686,18 +687,12 @@ class PROTOBUF_EXPORT ExtensionSet {
   // Applies a functor to the <int, Extension&> pairs in sorted order.
   template <typename KeyValueFunctor>
   KeyValueFunctor ForEach(KeyValueFunctor func) {
-    if (PROTOBUF_PREDICT_FALSE(is_large())) {
-      return ForEach(map_.large->begin(), map_.large->end(), std::move(func));
-    }
     return ForEach(flat_begin(), flat_end(), std::move(func));
   }
 
   // Applies a functor to the <int, const Extension&> pairs in sorted order.
   template <typename KeyValueFunctor>
   KeyValueFunctor ForEach(KeyValueFunctor func) const {
-    if (PROTOBUF_PREDICT_FALSE(is_large())) {
-      return ForEach(map_.large->begin(), map_.large->end(), std::move(func));
-    }
     return ForEach(flat_begin(), flat_end(), std::move(func));
   }
 
@@ -813,45 +808,28 @@ class PROTOBUF_EXPORT ExtensionSet {
   static inline size_t RepeatedMessage_SpaceUsedExcludingSelfLong(
       RepeatedPtrFieldBase* field);
 
-  KeyValue* flat_begin() {
-    assert(!is_large());
-    return map_.flat;
-  }
-  const KeyValue* flat_begin() const {
-    assert(!is_large());
-    return map_.flat;
-  }
-  KeyValue* flat_end() {
-    assert(!is_large());
-    return map_.flat + flat_size_;
-  }
-  const KeyValue* flat_end() const {
-    assert(!is_large());
-    return map_.flat + flat_size_;
-  }
+  KeyValue* flat_begin() { return flat_; }
+  const KeyValue* flat_begin() const { return flat_; }
+  KeyValue* flat_end() { return flat_ + flat_size_; }
+  const KeyValue* flat_end() const { return flat_ + flat_size_; }
 
   Arena* arena_;
 
   // Manual memory-management:
-  // map_.flat is an allocated array of flat_capacity_ elements.
-  // [map_.flat, map_.flat + flat_size_) is the currently-in-use prefix.
-  uint16 flat_capacity_;
-  uint16 flat_size_;
-  union AllocatedData {
-    KeyValue* flat;
-
-    // If flat_capacity_ > kMaximumFlatCapacity, switch to LargeMap,
-    // which guarantees O(n lg n) CPU but larger constant factors.
-    LargeMap* large;
-  } map_;
+  // flat_ is an array of flat_capacity_ elements, sorted by field number and
+  // allocated on arena_ when there is one.
+  // [flat_, flat_ + flat_size_) is the currently-in-use prefix.
+  uint32 flat_capacity_;
+  uint32 flat_size_;
+  KeyValue* flat_;
 
-  static void DeleteFlatMap(const KeyValue* flat, uint16 flat_capacity);
+  static void DeleteFlatMap(const KeyValue* flat, uint32 flat_capacity);
 
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ExtensionSet);
 };
 
 constexpr ExtensionSet::ExtensionSet()
-    : arena_(nullptr), flat_capacity_(0), flat_size_(0), map_{nullptr} {}
+    : arena_(nullptr), flat_capacity_(0), flat_size_(0), flat_(nullptr) {}
 
 // These are just for convenience...
 inline void ExtensionSet::SetString(int number, FieldType type,
@@ -1326,6 +1326,37 @@ TEST(ExtensionSetTest, BoolExtension) {
   EXPECT_TRUE(msg.GetExtension(protobuf_unittest::optional_bool_extension));
 }
 
+TEST(ExtensionSetTest, ManyExtensions) {
+  // Enough extensions to need a binary search, inserted both at the end and
+  // in the middle of the set.
+  const int kCount = 1000;
+  Arena arena;
+  for (Arena* set_arena : {static_cast<Arena*>(nullptr), &arena}) {
+    ExtensionSet set(set_arena);
+    for (int i = 1; i <= kCount; i += 2) {
+      set.SetInt32(i, WireFormatLite::TYPE_INT32, i * 3, nullptr);
+    }
+    for (int i = kCount; i > 0; i -= 2) {
+      set.SetInt32(i, WireFormatLite::TYPE_INT32, i * 3, nullptr);
+    }
+    EXPECT_EQ(kCount, set.NumExtensions());
+    EXPECT_FALSE(set.Has(0));
+    EXPECT_FALSE(set.Has(kCount + 1));
+    for (int i = 1; i <= kCount; i++) {
+      ASSERT_TRUE(set.Has(i));
+      EXPECT_EQ(i * 3, set.GetInt32(i, 0));
+    }
+
+    ExtensionSet copy;
+    copy.SetInt32(kCount / 2, WireFormatLite::TYPE_INT32, 0, nullptr);
+    copy.MergeFrom(set);
+    EXPECT_EQ(kCount, copy.NumExtensions());
+    for (int i = 1; i <= kCount; i++) {
+      EXPECT_EQ(i * 3, copy.GetInt32(i, 0));
+    }
+  }
+}
+
 TEST(ExtensionSetTest, ConstInit) {
   PROTOBUF_CONSTINIT static ExtensionSet set{};
   EXPECT_EQ(set.NumExtensions(), 0);
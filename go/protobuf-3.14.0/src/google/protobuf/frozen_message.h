@@ -0,0 +1,117 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// FrozenMessage<T> holds a read-only copy of a message laid out in one
+// contiguous block.
+//
+// Large messages that many threads read, like configuration, end up spread
+// over the heap or over the blocks of an arena, mixed with unrelated data.
+// Freezing copies such a message into an arena whose single block is sized
+// to fit the copy exactly, so the whole message is compact and its hot
+// sub-messages and repeated fields sit close together:
+//
+//   FrozenMessage<MyConfig> config(LoadConfig());
+//   ...                                   // From any number of threads:
+//   if (config->feature().enabled()) ...
+//
+// The copy is an ordinary message on an arena, so all generated accessors
+// and reflection work on it.  Only const access is given out; like any
+// message that is not modified, it may be read from many threads at once
+// without locks.  The contents of strings too long for the std::string
+// inline buffer stay on the heap.
+
+#ifndef GOOGLE_PROTOBUF_FROZEN_MESSAGE_H__
+#define GOOGLE_PROTOBUF_FROZEN_MESSAGE_H__
+
+#include <memory>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/arena.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+
+template <typename T>
+class FrozenMessage {
+ public:
+  explicit FrozenMessage(const T& message) {
+    // Copy once onto a scratch arena to learn how much space the copy takes,
+    // then again into a block of that size plus the arena's own overhead,
+    // which is not part of SpaceUsed().  Retry with more room if the copy
+    // spilled into a second block.
+    size_t space_used;
+    {
+      Arena scratch;
+      message.New(&scratch)->CopyFrom(message);
+      space_used = static_cast<size_t>(scratch.SpaceUsed());
+    }
+    for (size_t overhead = kArenaOverhead;; overhead *= 2) {
+      block_size_ = space_used + overhead;
+      block_.reset(new char[block_size_]);
+      ArenaOptions options;
+      options.initial_block = block_.get();
+      options.initial_block_size = block_size_;
+      arena_.reset(new Arena(options));
+      T* copy = message.New(arena_.get());
+      copy->CopyFrom(message);
+      message_ = copy;
+      if (arena_->SpaceAllocated() == block_size_) break;
+      arena_.reset();
+    }
+  }
+
+  const T& get() const { return *message_; }
+  const T& operator*() const { return *message_; }
+  const T* operator->() const { return message_; }
+
+  // Size of the block holding the message.
+  size_t block_size() const { return block_size_; }
+
+ private:
+  // Room for the block header and the arena's bookkeeping.
+  static const size_t kArenaOverhead = 512;
+
+  // Declared before arena_ so that it is freed after the arena.
+  std::unique_ptr<char[]> block_;
+  size_t block_size_;
+  std::unique_ptr<Arena> arena_;
+  const T* message_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(FrozenMessage);
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_FROZEN_MESSAGE_H__
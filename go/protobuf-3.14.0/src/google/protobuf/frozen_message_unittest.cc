@@ -0,0 +1,95 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/frozen_message.h>
+
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/arena.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+typedef FrozenMessage<protobuf_unittest::TestAllTypes> FrozenTestAllTypes;
+
+TEST(FrozenMessageTest, CopiesIntoOneBlock) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  FrozenTestAllTypes frozen(message);
+
+  TestUtil::ExpectAllFieldsSet(*frozen);
+  Arena* arena = frozen->GetArena();
+  ASSERT_TRUE(arena != nullptr);
+  EXPECT_EQ(frozen.block_size(), arena->SpaceAllocated());
+  EXPECT_EQ(message.SerializeAsString(), frozen.get().SerializeAsString());
+}
+
+TEST(FrozenMessageTest, CompactsFragmentedArena) {
+  // Interleave the elements of two messages on one arena.
+  Arena arena;
+  auto* message = Arena::CreateMessage<protobuf_unittest::TestAllTypes>(&arena);
+  auto* other = Arena::CreateMessage<protobuf_unittest::TestAllTypes>(&arena);
+  for (int i = 0; i < 1000; i++) {
+    message->add_repeated_nested_message()->set_bb(i);
+    other->add_repeated_string("padding padding padding padding");
+  }
+  FrozenTestAllTypes frozen(*message);
+
+  EXPECT_EQ(1000, frozen->repeated_nested_message_size());
+  EXPECT_EQ(999, frozen->repeated_nested_message(999).bb());
+  EXPECT_LT(frozen.block_size(), arena.SpaceAllocated() / 2);
+}
+
+TEST(FrozenMessageTest, ConcurrentReads) {
+  protobuf_unittest::TestAllTypes message;
+  for (int i = 0; i < 1000; i++) message.add_repeated_int32(i);
+  const FrozenTestAllTypes frozen(message);
+
+  std::vector<std::thread> threads;
+  std::vector<int64> sums(8);
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&frozen, &sums, t] {
+      for (int i = 0; i < 100; i++) {
+        for (int32 value : frozen->repeated_int32()) sums[t] += value;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int64 sum : sums) EXPECT_EQ(100 * 999 * 1000 / 2, sum);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -45,6 +45,7 @@
 #include <google/protobuf/generated_message_util.h>
 #include <google/protobuf/map_field.h>
 #include <google/protobuf/map_field_inl.h>
+#include <google/protobuf/reflection.h>
 #include <google/protobuf/stubs/mutex.h>
 #include <google/protobuf/repeated_field.h>
 #include <google/protobuf/unknown_field_set.h>
@@ -1918,6 +1919,69 @@ bool Reflection::SupportsUnknownEnumValues() const {
   return CreateUnknownEnumValues(descriptor_->file());
 }
 
+FieldAccessor Reflection::GetFieldAccessor(const FieldDescriptor* field) const {
+  USAGE_CHECK_MESSAGE_TYPE(GetFieldAccessor);
+  USAGE_CHECK_SINGULAR(GetFieldAccessor);
+  USAGE_CHECK_NE(field->cpp_type(), FieldDescriptor::CPPTYPE_MESSAGE,
+                 GetFieldAccessor, "Field is a message.");
+  return FieldAccessor(this, field);
+}
+
+// ===================================================================
+// FieldAccessor
+
+FieldAccessor::FieldAccessor(const Reflection* reflection,
+                             const FieldDescriptor* field)
+    : reflection_(reflection),
+      field_(field),
+      number_(field->number()),
+      offset_(-1),
+      has_bit_offset_(-1),
+      has_bit_mask_(0),
+      oneof_case_offset_(-1),
+      default_string_(nullptr),
+      closed_enum_(field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+                   !CreateUnknownEnumValues(field)) {
+  if (field->is_extension() || field->options().weak()) return;
+  const internal::ReflectionSchema& schema = reflection->schema_;
+  offset_ = schema.GetFieldOffset(field);
+  if (schema.InRealOneof(field)) {
+    oneof_case_offset_ = schema.GetOneofCaseOffset(field->containing_oneof());
+  } else {
+    if (schema.HasBitIndex(field) != static_cast<uint32>(-1)) {
+      const uint32 index = schema.HasBitIndex(field);
+      has_bit_offset_ = schema.HasBitsOffset() + index / 32 * sizeof(uint32);
+      has_bit_mask_ = static_cast<uint32>(1) << (index % 32);
+    }
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      // Oneof string fields have no default instance; see
+      // Reflection::SetString().
+      default_string_ =
+          reflection->DefaultRaw<internal::ArenaStringPtr>(field).GetPointer();
+    }
+  }
+}
+
+void FieldAccessor::SetEnumValue(Message* message, int value) const {
+  CheckType(FieldDescriptor::CPPTYPE_ENUM);
+  if (!InPlace(*message) ||
+      (closed_enum_ && field_->enum_type()->FindValueByNumber(value) == NULL)) {
+    return reflection_->SetEnumValue(message, field_, value);
+  }
+  *MutableRaw<int>(message, offset_) = value;
+  SetHasBit(message);
+}
+
+void FieldAccessor::SetString(Message* message, std::string value) const {
+  CheckType(FieldDescriptor::CPPTYPE_STRING);
+  if (!InPlace(*message)) {
+    return reflection_->SetString(message, field_, std::move(value));
+  }
+  MutableRaw<internal::ArenaStringPtr>(message, offset_)
+      ->Set(default_string_, std::move(value), reflection_->GetArena(message));
+  SetHasBit(message);
+}
+
 // ===================================================================
 // Some private helpers.
 
@@ -50,8 +50,11 @@
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/test_util.h>
 #include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/unittest_proto3.pb.h>
+#include <google/protobuf/unittest_proto3_optional.pb.h>
 #include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.h>
+#include <google/protobuf/reflection.h>
 #include <google/protobuf/testing/googletest.h>
 #include <gtest/gtest.h>
 
@@ -996,6 +999,182 @@ TEST(GeneratedMessageReflectionTest, ArenaReleaseOneofMessageTest) {
   EXPECT_TRUE(released == NULL);
 }
 
+// Expects "accessor" to read the same value from "message" as Reflection.
+void ExpectSameAsReflection(const FieldAccessor& accessor,
+                            const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  const FieldDescriptor* field = accessor.field();
+  EXPECT_EQ(reflection->HasField(message, field), accessor.Has(message))
+      << field->name();
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, TYPENAME)                   \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:               \
+    EXPECT_EQ(reflection->Get##TYPENAME(message, field), \
+              accessor.Get##TYPENAME(message))           \
+        << field->name();                                \
+    break;
+    HANDLE_TYPE(INT32, Int32)
+    HANDLE_TYPE(INT64, Int64)
+    HANDLE_TYPE(UINT32, UInt32)
+    HANDLE_TYPE(UINT64, UInt64)
+    HANDLE_TYPE(FLOAT, Float)
+    HANDLE_TYPE(DOUBLE, Double)
+    HANDLE_TYPE(BOOL, Bool)
+    HANDLE_TYPE(ENUM, EnumValue)
+    HANDLE_TYPE(STRING, String)
+#undef HANDLE_TYPE
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+// Copies the field of "accessor" from "from" to "to".
+void CopyWithAccessor(const FieldAccessor& accessor, const Message& from,
+                      Message* to) {
+  switch (accessor.field()->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, TYPENAME)                        \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                    \
+    accessor.Set##TYPENAME(to, accessor.Get##TYPENAME(from)); \
+    break;
+    HANDLE_TYPE(INT32, Int32)
+    HANDLE_TYPE(INT64, Int64)
+    HANDLE_TYPE(UINT32, UInt32)
+    HANDLE_TYPE(UINT64, UInt64)
+    HANDLE_TYPE(FLOAT, Float)
+    HANDLE_TYPE(DOUBLE, Double)
+    HANDLE_TYPE(BOOL, Bool)
+    HANDLE_TYPE(ENUM, EnumValue)
+    HANDLE_TYPE(STRING, String)
+#undef HANDLE_TYPE
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessor) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  unittest::TestAllTypes empty;
+  unittest::TestAllTypes copy;
+  unittest::TestAllTypes expected = message;
+
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  const Reflection* reflection = message.GetReflection();
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated() ||
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      reflection->ClearField(&expected, field);
+      continue;
+    }
+    FieldAccessor accessor = reflection->GetFieldAccessor(field);
+    EXPECT_EQ(field, accessor.field());
+    ExpectSameAsReflection(accessor, message);
+    ExpectSameAsReflection(accessor, empty);
+    CopyWithAccessor(accessor, message, &copy);
+    ExpectSameAsReflection(accessor, copy);
+  }
+  EXPECT_EQ(expected.DebugString(), copy.DebugString());
+
+  FieldAccessor accessor = reflection->GetFieldAccessor(F("optional_int32"));
+  accessor.Clear(&copy);
+  EXPECT_FALSE(accessor.Has(copy));
+  EXPECT_EQ(0, copy.optional_int32());
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorOneof) {
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  FieldAccessor oneof_uint32 = reflection->GetFieldAccessor(F("oneof_uint32"));
+  FieldAccessor oneof_string = reflection->GetFieldAccessor(F("oneof_string"));
+
+  oneof_uint32.SetUInt32(&message, 5);
+  EXPECT_TRUE(oneof_uint32.Has(message));
+  EXPECT_FALSE(oneof_string.Has(message));
+  EXPECT_EQ("", oneof_string.GetString(message));
+
+  oneof_string.SetString(&message, "foo");
+  EXPECT_TRUE(message.has_oneof_string());
+  EXPECT_EQ("foo", message.oneof_string());
+  EXPECT_FALSE(oneof_uint32.Has(message));
+  EXPECT_EQ(0, oneof_uint32.GetUInt32(message));
+
+  oneof_string.SetString(&message, "bar");
+  EXPECT_EQ("bar", oneof_string.GetString(message));
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorPresence) {
+  // Proto3 fields without has-bits are present when not zero.
+  proto3_unittest::TestAllTypes proto3;
+  FieldAccessor implicit = proto3.GetReflection()->GetFieldAccessor(
+      proto3.GetDescriptor()->FindFieldByName("optional_int32"));
+  implicit.SetInt32(&proto3, 0);
+  EXPECT_FALSE(implicit.Has(proto3));
+  implicit.SetInt32(&proto3, 3);
+  EXPECT_TRUE(implicit.Has(proto3));
+  EXPECT_EQ(3, proto3.optional_int32());
+
+  // Proto3 optional fields have has-bits.
+  unittest::TestProto3Optional optional;
+  FieldAccessor explicit_presence = optional.GetReflection()->GetFieldAccessor(
+      optional.GetDescriptor()->FindFieldByName("optional_int32"));
+  EXPECT_FALSE(explicit_presence.Has(optional));
+  explicit_presence.SetInt32(&optional, 0);
+  EXPECT_TRUE(explicit_presence.Has(optional));
+  EXPECT_TRUE(optional.has_optional_int32());
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorEnum) {
+  // Values outside of a proto2 enum go to the unknown fields.
+  unittest::TestAllTypes message;
+  FieldAccessor closed =
+      message.GetReflection()->GetFieldAccessor(F("optional_nested_enum"));
+  closed.SetEnumValue(&message, unittest::TestAllTypes::BAZ);
+  EXPECT_EQ(unittest::TestAllTypes::BAZ, message.optional_nested_enum());
+  closed.SetEnumValue(&message, 12345);
+  EXPECT_EQ(unittest::TestAllTypes::BAZ, message.optional_nested_enum());
+  EXPECT_EQ(1,
+            message.GetReflection()->GetUnknownFields(message).field_count());
+
+  proto3_unittest::TestAllTypes proto3;
+  FieldAccessor open = proto3.GetReflection()->GetFieldAccessor(
+      proto3.GetDescriptor()->FindFieldByName("optional_nested_enum"));
+  open.SetEnumValue(&proto3, 12345);
+  EXPECT_EQ(12345, open.GetEnumValue(proto3));
+  EXPECT_EQ(12345, proto3.optional_nested_enum());
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorExtension) {
+  unittest::TestAllExtensions message;
+  const FieldDescriptor* extension =
+      unittest::TestAllExtensions::descriptor()->file()->FindExtensionByName(
+          "optional_string_extension");
+  FieldAccessor accessor = message.GetReflection()->GetFieldAccessor(extension);
+  EXPECT_FALSE(accessor.Has(message));
+  accessor.SetString(&message, "foo");
+  EXPECT_TRUE(accessor.Has(message));
+  EXPECT_EQ("foo", accessor.GetString(message));
+  EXPECT_EQ("foo", message.GetExtension(unittest::optional_string_extension));
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorArena) {
+  Arena arena;
+  unittest::TestAllTypes* message =
+      Arena::CreateMessage<unittest::TestAllTypes>(&arena);
+  FieldAccessor accessor =
+      message->GetReflection()->GetFieldAccessor(F("optional_string"));
+  EXPECT_EQ("", accessor.GetString(*message));
+  accessor.SetString(message, std::string(100, 'x'));
+  EXPECT_EQ(std::string(100, 'x'), message->optional_string());
+  FieldAccessor default_string =
+      message->GetReflection()->GetFieldAccessor(F("default_string"));
+  EXPECT_EQ("hello", default_string.GetString(*message));
+  default_string.SetString(message, "bye");
+  EXPECT_EQ("bye", message->default_string());
+  EXPECT_EQ("hello",
+            unittest::TestAllTypes::default_instance().default_string());
+}
+
 #ifdef PROTOBUF_HAS_DEATH_TEST
 
 TEST(GeneratedMessageReflectionTest, UsageErrors) {
@@ -55,6 +55,8 @@ struct UnknownFieldHandler {
   // and conflating InternalMetaData into it, simplifying the template.
   static constexpr bool IsLite() { return false; }
 
+  typedef UnknownFieldSet UnknownFieldsType;
+
   static bool Skip(MessageLite* msg, const ParseTable& table,
                    io::CodedInputStream* input, int tag) {
     GOOGLE_DCHECK(table.unknown_field_set);
@@ -88,6 +90,20 @@ struct UnknownFieldHandler {
 
     return extensions->ParseField(tag, input, prototype, unknown_fields);
   }
+
+  static const char* ParseUnknown(MessageLite* msg, const ParseTable& table,
+                                  uint32 tag, const char* ptr,
+                                  ParseContext* ctx) {
+    GOOGLE_DCHECK(table.unknown_field_set);
+    ExtensionSet* extensions = GetExtensionSet(msg, table.extension_offset);
+    if (extensions != NULL) {
+      return extensions->ParseField(
+          tag, ptr, down_cast<const Message*>(table.default_instance()),
+          Raw<InternalMetadata>(msg, table.arena_offset), ctx);
+    }
+    return UnknownFieldParse(tag, MutableUnknownFields(msg, table.arena_offset),
+                             ptr, ctx);
+  }
 };
 
 }  // namespace
@@ -98,6 +114,11 @@ bool MergePartialFromCodedStream(MessageLite* msg, const ParseTable& table,
                                                               input);
 }
 
+const char* TableParse(MessageLite* msg, const ParseTable& table,
+                       const char* ptr, ParseContext* ctx) {
+  return TableParseImpl<UnknownFieldHandler>(msg, table, ptr, ctx);
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -35,6 +35,7 @@
 #include <google/protobuf/map_entry_lite.h>
 #include <google/protobuf/map_field_lite.h>
 #include <google/protobuf/message_lite.h>
+#include <google/protobuf/parse_context.h>
 #include <google/protobuf/wire_format_lite.h>
 
 // We require C++11 and Clang to use constexpr for variables, as GCC 4.8
@@ -78,6 +79,14 @@ enum ProcessingTypes {
 
 static_assert(TYPE_MAP < kRepeatedMask, "Invalid enum");
 
+// How a string field is checked for valid UTF-8 after parsing.  Mirrors the
+// checks the code generator emits for non-table-driven parsers.
+enum Utf8CheckMode : unsigned char {
+  kUtf8CheckNone = 0,
+  kUtf8CheckVerify = 1,  // Log invalid UTF-8 in debug builds only.
+  kUtf8CheckStrict = 2,  // Invalid UTF-8 fails the parse.
+};
+
 struct PROTOBUF_EXPORT FieldMetadata {
   uint32 offset;  // offset of this field in the struct
   uint32 tag;     // field * 8 + wire_type
@@ -156,13 +165,17 @@ union AuxiliaryParseTableField {
   message_aux messages;
   // Strings
   struct string_aux {
+    // Points at the empty string, or at a LazyString if lazy_default.
     const void* default_ptr;
     const char* field_name;
+    unsigned char utf8_check;  // Utf8CheckMode
+    bool lazy_default;
   };
   string_aux strings;
 
   struct map_aux {
     bool (*parse_map)(io::CodedInputStream*, void*);
+    const char* (*parse_map_field)(void*, const char*, ParseContext*);
   };
   map_aux maps;
 
@@ -217,6 +230,17 @@ bool MergePartialFromCodedStream(MessageLite* msg, const ParseTable& table,
 bool MergePartialFromCodedStreamLite(MessageLite* msg, const ParseTable& table,
                                      io::CodedInputStream* input);
 
+// Table-driven implementations of _InternalParse.  Messages generated with the
+// table_driven_parsing option forward to these instead of carrying their own
+// parse loop; TableParse is for messages with an UnknownFieldSet and
+// TableParseLite for messages that keep unknown fields as a string.
+PROTOBUF_EXPORT const char* TableParse(MessageLite* msg,
+                                       const ParseTable& table,
+                                       const char* ptr, ParseContext* ctx);
+PROTOBUF_EXPORT const char* TableParseLite(MessageLite* msg,
+                                           const ParseTable& table,
+                                           const char* ptr, ParseContext* ctx);
+
 template <typename Entry>
 bool ParseMap(io::CodedInputStream* input, void* map_field) {
   typedef typename MapEntryToMapField<Entry>::MapFieldType MapFieldType;
@@ -228,6 +252,13 @@ bool ParseMap(io::CodedInputStream* input, void* map_field) {
   return WireFormatLite::ReadMessageNoVirtual(input, &parser);
 }
 
+// ParseContext counterpart of ParseMap.  MapFieldType is the type of the
+// message member, which already knows how to parse one map entry.
+template <typename MapFieldType>
+const char* ParseMapField(void* map_field, const char* ptr, ParseContext* ctx) {
+  return ctx->ParseMessage(static_cast<MapFieldType*>(map_field), ptr);
+}
+
 struct SerializationTable {
   int num_fields;
   const FieldMetadata* field_table;
@@ -257,6 +288,14 @@ uint8* SerializeInternalToArray(const uint8* base, const FieldMetadata* table,
                                 int32 num_fields, bool is_deterministic,
                                 uint8* buffer);
 
+// Table-driven implementation of _InternalSerialize, used by messages
+// generated with the table_driven_serialization option.  Requires the cached
+// sizes to be up to date, like every _InternalSerialize.
+PROTOBUF_EXPORT uint8* TableSerialize(const MessageLite& msg,
+                                      const SerializationTable* table,
+                                      uint8* target,
+                                      io::EpsCopyOutputStream* stream);
+
 inline uint8* TableSerializeToArray(const MessageLite& msg,
                                     const SerializationTable* table,
                                     bool is_deterministic, uint8* buffer) {
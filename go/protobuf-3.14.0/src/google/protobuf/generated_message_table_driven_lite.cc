@@ -53,6 +53,8 @@ struct UnknownFieldHandlerLite {
   // and conflating InternalMetaData into it, simplifying the template.
   static constexpr bool IsLite() { return true; }
 
+  typedef std::string UnknownFieldsType;
+
   static bool Skip(MessageLite* msg, const ParseTable& table,
                    io::CodedInputStream* input, int tag) {
     GOOGLE_DCHECK(!table.unknown_field_set);
@@ -91,6 +93,20 @@ struct UnknownFieldHandlerLite {
     return extensions->ParseField(tag, input, prototype,
                                   &unknown_fields_stream);
   }
+
+  static const char* ParseUnknown(MessageLite* msg, const ParseTable& table,
+                                  uint32 tag, const char* ptr,
+                                  ParseContext* ctx) {
+    GOOGLE_DCHECK(!table.unknown_field_set);
+    ExtensionSet* extensions = GetExtensionSet(msg, table.extension_offset);
+    if (extensions != NULL) {
+      return extensions->ParseField(
+          tag, ptr, table.default_instance(),
+          Raw<InternalMetadata>(msg, table.arena_offset), ctx);
+    }
+    return UnknownFieldParse(tag, MutableUnknownFields(msg, table.arena_offset),
+                             ptr, ctx);
+  }
 };
 
 }  // namespace
@@ -101,6 +117,11 @@ bool MergePartialFromCodedStreamLite(MessageLite* msg, const ParseTable& table,
                                                                   input);
 }
 
+const char* TableParseLite(MessageLite* msg, const ParseTable& table,
+                           const char* ptr, ParseContext* ctx) {
+  return TableParseImpl<UnknownFieldHandlerLite>(msg, table, ptr, ctx);
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
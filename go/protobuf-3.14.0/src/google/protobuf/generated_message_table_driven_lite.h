@@ -35,6 +35,7 @@
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/generated_message_table_driven.h>
 #include <google/protobuf/implicit_weak_message.h>
+#include <google/protobuf/parse_context.h>
 #include <google/protobuf/repeated_field.h>
 #include <google/protobuf/wire_format_lite.h>
 #include <type_traits>
@@ -145,6 +146,7 @@ inline void ClearOneofField(const ParseTableField& field, Arena* arena,
                             MessageLite* msg) {
   switch (field.processing_type & kTypeMask) {
     case WireFormatLite::TYPE_MESSAGE:
+    case WireFormatLite::TYPE_GROUP:
       if (arena == NULL) {
         delete *Raw<MessageLite*>(msg, field.offset);
       }
@@ -793,6 +795,289 @@ bool MergePartialFromCodedStreamImpl(MessageLite* msg, const ParseTable& table,
   }
 }
 
+template <typename T>
+inline T ReadFixed(const char** ptr) {
+  T value = UnalignedLoad<T>(*ptr);
+  *ptr += sizeof(T);
+  return value;
+}
+
+// Parses the value of one field whose wire type matched the table's
+// normal_wiretype.  Returns nullptr on failure, like all ParseContext parsers.
+template <typename UnknownFieldHandler>
+const char* TableParseField(MessageLite* msg, const ParseTable& table,
+                            uint32* has_bits, uint32 tag, const char* ptr,
+                            ParseContext* ctx) {
+  const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+  const ParseTableField* data = table.fields + field_number;
+  const uint32 presence_index = data->presence_index;
+  const int64 offset = data->offset;
+
+  switch (data->processing_type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, READ)                                      \
+  case WireFormatLite::TYPE_##TYPE: {                                          \
+    CPPTYPE value = READ;                                                      \
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);                                        \
+    if (has_bits != nullptr && presence_index != ~0u) {                        \
+      SetBit(has_bits, presence_index);                                        \
+    }                                                                          \
+    *Raw<CPPTYPE>(msg, offset) = value;                                        \
+    return ptr;                                                                \
+  }                                                                            \
+  case WireFormatLite::TYPE_##TYPE | kRepeatedMask: {                          \
+    CPPTYPE value = READ;                                                      \
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);                                        \
+    Raw<RepeatedField<CPPTYPE>>(msg, offset)->Add(value);                      \
+    return ptr;                                                                \
+  }                                                                            \
+  case WireFormatLite::TYPE_##TYPE | kOneofMask: {                             \
+    uint32* oneof_case = Raw<uint32>(msg, table.oneof_case_offset);            \
+    CPPTYPE value = READ;                                                      \
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);                                        \
+    ClearOneofField(table.fields[oneof_case[presence_index]], msg->GetArena(), \
+                    msg);                                                      \
+    SetOneofField(msg, oneof_case, presence_index, offset, field_number,       \
+                  value);                                                      \
+    return ptr;                                                                \
+  }
+
+    HANDLE_TYPE(INT32, int32, static_cast<int32>(ReadVarint64(&ptr)))
+    HANDLE_TYPE(INT64, int64, static_cast<int64>(ReadVarint64(&ptr)))
+    HANDLE_TYPE(SINT32, int32, ReadVarintZigZag32(&ptr))
+    HANDLE_TYPE(SINT64, int64, ReadVarintZigZag64(&ptr))
+    HANDLE_TYPE(UINT32, uint32, ReadVarint32(&ptr))
+    HANDLE_TYPE(UINT64, uint64, ReadVarint64(&ptr))
+    HANDLE_TYPE(BOOL, bool, ReadVarint64(&ptr) != 0)
+
+    HANDLE_TYPE(FIXED32, uint32, ReadFixed<uint32>(&ptr))
+    HANDLE_TYPE(FIXED64, uint64, ReadFixed<uint64>(&ptr))
+    HANDLE_TYPE(SFIXED32, int32, ReadFixed<int32>(&ptr))
+    HANDLE_TYPE(SFIXED64, int64, ReadFixed<int64>(&ptr))
+    HANDLE_TYPE(FLOAT, float, ReadFixed<float>(&ptr))
+    HANDLE_TYPE(DOUBLE, double, ReadFixed<double>(&ptr))
+#undef HANDLE_TYPE
+
+    case WireFormatLite::TYPE_ENUM:
+    case WireFormatLite::TYPE_ENUM | kRepeatedMask:
+    case WireFormatLite::TYPE_ENUM | kOneofMask: {
+      int value = static_cast<int>(ReadVarint64(&ptr));
+      GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+      AuxiliaryParseTableField::EnumValidator validator =
+          table.aux[field_number].enums.validator;
+      if (validator != nullptr && !validator(value)) {
+        UnknownFieldHandler::Varint(msg, table, tag, value);
+      } else if (data->processing_type & kRepeatedMask) {
+        AddField(msg, offset, value);
+      } else if (data->processing_type & kOneofMask) {
+        uint32* oneof_case = Raw<uint32>(msg, table.oneof_case_offset);
+        ClearOneofField(table.fields[oneof_case[presence_index]],
+                        msg->GetArena(), msg);
+        SetOneofField(msg, oneof_case, presence_index, offset, field_number,
+                      value);
+      } else {
+        if (has_bits != nullptr && presence_index != ~0u) {
+          SetBit(has_bits, presence_index);
+        }
+        *Raw<int>(msg, offset) = value;
+      }
+      return ptr;
+    }
+
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES:
+    case WireFormatLite::TYPE_STRING | kRepeatedMask:
+    case WireFormatLite::TYPE_BYTES | kRepeatedMask:
+    case WireFormatLite::TYPE_STRING | kOneofMask:
+    case WireFormatLite::TYPE_BYTES | kOneofMask: {
+      Arena* const arena = msg->GetArena();
+      const AuxiliaryParseTableField::string_aux& aux =
+          table.aux[field_number].strings;
+      const std::string* value;
+      if (data->processing_type & kRepeatedMask) {
+        std::string* str = AddField<std::string>(msg, offset);
+        ptr = InlineGreedyStringParser(str, ptr, ctx);
+        value = str;
+      } else {
+        ArenaStringPtr* field = Raw<ArenaStringPtr>(msg, offset);
+        if (data->processing_type & kOneofMask) {
+          const std::string* default_value =
+              aux.lazy_default ? nullptr : &GetEmptyStringAlreadyInited();
+          ResetOneofField<ProcessingType_STRING>(
+              table, field_number, arena, msg,
+              Raw<uint32>(msg, table.oneof_case_offset) + presence_index,
+              offset, default_value);
+        } else if (has_bits != nullptr && presence_index != ~0u) {
+          SetBit(has_bits, presence_index);
+        }
+        if (aux.lazy_default) {
+          ptr = InlineGreedyStringParser(
+              field->Mutable(*static_cast<const LazyString*>(aux.default_ptr),
+                             arena),
+              ptr, ctx);
+        } else {
+          ptr = ctx->ReadArenaString(ptr, field, arena);
+        }
+        value = &field->Get();
+      }
+      GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+      if (aux.utf8_check == kUtf8CheckStrict) {
+        GOOGLE_PROTOBUF_PARSER_ASSERT(VerifyUTF8(value, aux.field_name));
+      } else if (aux.utf8_check == kUtf8CheckVerify) {
+#ifndef NDEBUG
+        VerifyUTF8(value, aux.field_name);
+#endif  // !NDEBUG
+      }
+      return ptr;
+    }
+
+    case WireFormatLite::TYPE_MESSAGE:
+    case WireFormatLite::TYPE_GROUP: {
+      if (has_bits != nullptr && presence_index != ~0u) {
+        SetBit(has_bits, presence_index);
+      }
+      MessageLite** submsg_holder = Raw<MessageLite*>(msg, offset);
+      if (*submsg_holder == nullptr) {
+        const MessageLite* prototype =
+            table.aux[field_number].messages.default_message();
+        if (prototype == nullptr) {
+          prototype = ImplicitWeakMessage::default_instance();
+        }
+        *submsg_holder = prototype->New(msg->GetArena());
+      }
+      if (data->processing_type == WireFormatLite::TYPE_GROUP) {
+        return ctx->ParseGroup(*submsg_holder, ptr, tag);
+      }
+      return ctx->ParseMessage(*submsg_holder, ptr);
+    }
+    case WireFormatLite::TYPE_MESSAGE | kRepeatedMask:
+    case WireFormatLite::TYPE_GROUP | kRepeatedMask: {
+      const MessageLite* prototype =
+          table.aux[field_number].messages.default_message();
+      if (prototype == nullptr) {
+        prototype = ImplicitWeakMessage::default_instance();
+      }
+      MessageLite* submsg = MergePartialFromCodedStreamHelper::Add(
+          Raw<RepeatedPtrFieldBase>(msg, offset), prototype);
+      if ((data->processing_type ^ kRepeatedMask) ==
+          WireFormatLite::TYPE_GROUP) {
+        return ctx->ParseGroup(submsg, ptr, tag);
+      }
+      return ctx->ParseMessage(submsg, ptr);
+    }
+    case WireFormatLite::TYPE_MESSAGE | kOneofMask:
+    case WireFormatLite::TYPE_GROUP | kOneofMask: {
+      ResetOneofField<ProcessingType_MESSAGE>(
+          table, field_number, msg->GetArena(), msg,
+          Raw<uint32>(msg, table.oneof_case_offset) + presence_index, offset,
+          nullptr);
+      MessageLite* submsg = *Raw<MessageLite*>(msg, offset);
+      if ((data->processing_type ^ kOneofMask) == WireFormatLite::TYPE_GROUP) {
+        return ctx->ParseGroup(submsg, ptr, tag);
+      }
+      return ctx->ParseMessage(submsg, ptr);
+    }
+    case TYPE_MAP:
+      return (*table.aux[field_number].maps.parse_map_field)(
+          Raw<void>(msg, offset), ptr, ctx);
+    default:
+      // Cord and StringPiece fields, and anything the generator never emits.
+      return nullptr;
+  }
+}  // NOLINT(readability/fn_size)
+
+// Parses a packed run of a repeated primitive field.
+template <typename UnknownFieldHandler>
+const char* TableParsePacked(MessageLite* msg, const ParseTable& table,
+                             uint32 tag, const char* ptr, ParseContext* ctx) {
+  const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+  const ParseTableField* data = table.fields + field_number;
+  void* object = Raw<void>(msg, data->offset);
+
+  switch (static_cast<WireFormatLite::FieldType>(data->processing_type ^
+                                                 kRepeatedMask)) {
+    case WireFormatLite::TYPE_INT32:
+      return PackedInt32Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_INT64:
+      return PackedInt64Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_SINT32:
+      return PackedSInt32Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_SINT64:
+      return PackedSInt64Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_UINT32:
+      return PackedUInt32Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_UINT64:
+      return PackedUInt64Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_FIXED32:
+      return PackedFixed32Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_FIXED64:
+      return PackedFixed64Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_SFIXED32:
+      return PackedSFixed32Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_SFIXED64:
+      return PackedSFixed64Parser(object, ptr, ctx);
+    case WireFormatLite::TYPE_FLOAT:
+      return PackedFloatParser(object, ptr, ctx);
+    case WireFormatLite::TYPE_DOUBLE:
+      return PackedDoubleParser(object, ptr, ctx);
+    case WireFormatLite::TYPE_BOOL:
+      return PackedBoolParser(object, ptr, ctx);
+    case WireFormatLite::TYPE_ENUM: {
+      AuxiliaryParseTableField::EnumValidator validator =
+          table.aux[field_number].enums.validator;
+      if (validator == nullptr) return PackedEnumParser(object, ptr, ctx);
+      return PackedEnumParser<typename UnknownFieldHandler::UnknownFieldsType>(
+          object, ptr, ctx, validator,
+          Raw<InternalMetadata>(msg, table.arena_offset), field_number);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// ParseContext counterpart of MergePartialFromCodedStreamImpl.  The handler
+// additionally provides ParseUnknown(), which consumes a field that is not in
+// the table (an extension or an unknown field), and UnknownFieldsType.
+template <typename UnknownFieldHandler>
+const char* TableParseImpl(MessageLite* msg, const ParseTable& table,
+                           const char* ptr, ParseContext* ctx) {
+  uint32* has_bits = table.has_bits_offset >= 0
+                         ? Raw<uint32>(msg, table.has_bits_offset)
+                         : nullptr;
+  while (!ctx->Done(&ptr)) {
+    uint32 tag;
+    ptr = ReadTag(ptr, &tag);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+    const uint32 field_number = WireFormatLite::GetTagFieldNumber(tag);
+    const unsigned char wire_type = WireFormatLite::GetTagWireType(tag);
+
+    // Entries that do not correspond to a field have both wire types set to
+    // kInvalidMask, which never matches.  Field 0 is never looked up, so an
+    // end-of-message zero tag falls through to the check below.
+    if (field_number - 1 < static_cast<uint32>(table.max_field_number)) {
+      const ParseTableField* data = table.fields + field_number;
+      if (data->normal_wiretype == wire_type) {
+        ptr = TableParseField<UnknownFieldHandler>(msg, table, has_bits, tag,
+                                                   ptr, ctx);
+        GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+        continue;
+      }
+      if (data->packed_wiretype == wire_type) {
+        ptr = TableParsePacked<UnknownFieldHandler>(msg, table, tag, ptr, ctx);
+        GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+        continue;
+      }
+    }
+
+    if (tag == 0 || wire_type == WireFormatLite::WIRETYPE_END_GROUP) {
+      ctx->SetLastTag(tag);
+      return ptr;
+    }
+    ptr = UnknownFieldHandler::ParseUnknown(msg, table, tag, ptr, ctx);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+  }
+  return ptr;
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
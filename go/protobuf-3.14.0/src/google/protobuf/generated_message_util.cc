@@ -35,6 +35,7 @@
 #include <google/protobuf/generated_message_util.h>
 
 #include <limits>
+#include <memory>
 
 #ifndef GOOGLE_PROTOBUF_SUPPORT_WINDOWS_XP
 // We're only using this as a standard way for getting the thread id.
@@ -378,13 +379,27 @@ struct SingularFieldHelper {
   }
 };
 
+// String fields that need UTF-8 checking carry their full name in md.ptr.
+// Like the generated serializers, invalid data is only logged.
+inline void VerifyUtf8ForSerialize(const std::string& value,
+                                   const FieldMetadata& md) {
+#ifndef NDEBUG
+  if (md.ptr != nullptr) {
+    WireFormatLite::VerifyUtf8String(value.data(), value.size(),
+                                     WireFormatLite::SERIALIZE,
+                                     static_cast<const char*>(md.ptr));
+  }
+#endif  // !NDEBUG
+}
+
 template <>
 struct SingularFieldHelper<WireFormatLite::TYPE_STRING> {
   template <typename O>
   static void Serialize(const void* field, const FieldMetadata& md, O* output) {
+    const std::string& value = Get<ArenaStringPtr>(field).Get();
+    VerifyUtf8ForSerialize(value, md);
     WriteTagTo(md.tag, output);
-    SerializeTo<WireFormatLite::TYPE_STRING>(&Get<ArenaStringPtr>(field).Get(),
-                                             output);
+    SerializeTo<WireFormatLite::TYPE_STRING>(&value, output);
   }
 };
 
@@ -442,6 +457,8 @@ struct RepeatedFieldHelper<WireFormatLite::TYPE_STRING> {
     const internal::RepeatedPtrFieldBase& array =
         Get<internal::RepeatedPtrFieldBase>(field);
     for (int i = 0; i < AccessorHelper::Size(array); i++) {
+      VerifyUtf8ForSerialize(
+          *static_cast<const std::string*>(AccessorHelper::Get(array, i)), md);
       WriteTagTo(md.tag, output);
       SerializeTo<WireFormatLite::TYPE_STRING>(AccessorHelper::Get(array, i),
                                                output);
@@ -681,6 +698,41 @@ uint8* SerializeInternalToArray(const uint8* base,
 }
 #undef SERIALIZERS_FOR_TYPE
 
+uint8* TableSerialize(const MessageLite& msg, const SerializationTable* table,
+                      uint8* target, io::EpsCopyOutputStream* stream) {
+  const uint8* base = reinterpret_cast<const uint8*>(&msg);
+  const FieldMetadata* field_table = table->field_table;
+  int num_fields = table->num_fields - 1;
+  int cached_size = *reinterpret_cast<const int32*>(base + field_table->offset);
+  bool is_deterministic = stream->IsSerializationDeterministic();
+
+  // Check before EnsureSpace(): a flat array stream has no room to advance
+  // into once its end is reached, even for an empty message.
+  if (PROTOBUF_PREDICT_TRUE(cached_size <=
+                            stream->ContiguousBytesAvailable(target))) {
+    return SerializeInternalToArray(base, field_table + 1, num_fields,
+                                    is_deterministic, target);
+  }
+  target = stream->EnsureSpace(target);
+  if (cached_size <= stream->ContiguousBytesAvailable(target)) {
+    return SerializeInternalToArray(base, field_table + 1, num_fields,
+                                    is_deterministic, target);
+  }
+
+  // The message straddles a buffer boundary of the underlying stream, so
+  // serialize it on the side and copy it in.
+  uint8 stack_buffer[512];
+  std::unique_ptr<uint8[]> heap_buffer;
+  uint8* buffer = stack_buffer;
+  if (cached_size > static_cast<int>(sizeof(stack_buffer))) {
+    heap_buffer.reset(new uint8[cached_size]);
+    buffer = heap_buffer.get();
+  }
+  SerializeInternalToArray(base, field_table + 1, num_fields, is_deterministic,
+                           buffer);
+  return stream->WriteRaw(buffer, cached_size, target);
+}
+
 void ExtensionSerializer(const uint8* ptr, uint32 offset, uint32 tag,
                          uint32 has_offset, io::CodedOutputStream* output) {
   reinterpret_cast<const ExtensionSet*>(ptr + offset)
@@ -106,6 +106,12 @@ class ImplicitWeakTypeHandler {
                                               Arena* arena = NULL) {
     return prototype->New(arena);
   }
+  static inline void NewContiguous(const MessageLite* prototype, Arena* arena,
+                                   int n, void** elements) {
+    for (int i = 0; i < n; i++) {
+      elements[i] = prototype->New(arena);
+    }
+  }
 
   static inline void Delete(MessageLite* value, Arena* arena) {
     if (arena == NULL) {
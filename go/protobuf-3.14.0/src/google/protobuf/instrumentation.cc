@@ -0,0 +1,91 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/instrumentation.h>
+
+#include <atomic>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+
+namespace {
+
+std::atomic<InstrumentationSink*> instrumentation_sink{nullptr};
+
+#ifdef PROTOBUF_INSTRUMENTATION
+// Set while a scope on this thread is reporting, so nested calls are counted
+// as part of the outermost one.
+PROTOBUF_THREAD_LOCAL bool instrumentation_active = false;
+#endif
+
+}  // namespace
+
+InstrumentationSink::~InstrumentationSink() {}
+
+void SetInstrumentationSink(InstrumentationSink* sink) {
+  instrumentation_sink.store(sink, std::memory_order_release);
+}
+
+namespace internal {
+
+#ifdef PROTOBUF_INSTRUMENTATION
+
+InstrumentationSink* GetInstrumentationSink() {
+  if (instrumentation_active) return nullptr;
+  return instrumentation_sink.load(std::memory_order_acquire);
+}
+
+void InstrumentationScope::Start(InstrumentationSink::Operation operation,
+                                 const MessageLite* message) {
+  instrumentation_active = true;
+  event_.operation = operation;
+  event_.message = message;
+  event_.bytes = 0;
+  event_.ok = false;
+  event_.allocations = sink_->AllocationCount();
+  start_ = std::chrono::steady_clock::now();
+}
+
+void InstrumentationScope::Finish() {
+  event_.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+  event_.allocations = sink_->AllocationCount() - event_.allocations;
+  sink_->Record(event_);
+  instrumentation_active = false;
+}
+
+#endif  // PROTOBUF_INSTRUMENTATION
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,156 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Optional instrumentation of parsing and serialization.
+//
+// When the library is built with PROTOBUF_INSTRUMENTATION defined (configure
+// --enable-instrumentation, or -Dprotobuf_WITH_INSTRUMENTATION=ON with CMake),
+// every top-level parse and serialize call made through MessageLite -- the
+// ParseFrom*(), MergeFrom*(), SerializeTo*() and AppendTo*() families -- is
+// reported to the sink installed with SetInstrumentationSink(), with the
+// message, the number of bytes, the time taken and the allocations made.
+// Calls made while another one is being reported on the same thread, such as
+// packing an Any inside a parse, are counted as part of the outer call.
+//
+// Without PROTOBUF_INSTRUMENTATION the hooks compile to nothing, and
+// SetInstrumentationSink() accepts a sink that is never called.
+
+#ifndef GOOGLE_PROTOBUF_INSTRUMENTATION_H__
+#define GOOGLE_PROTOBUF_INSTRUMENTATION_H__
+
+#include <google/protobuf/stubs/common.h>
+
+#ifdef PROTOBUF_INSTRUMENTATION
+#include <chrono>
+#endif
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+// Receives parse and serialize events.  Record() is called on the thread that
+// did the work, possibly from many threads at once.
+class PROTOBUF_EXPORT InstrumentationSink {
+ public:
+  enum Operation {
+    PARSE,
+    SERIALIZE,
+  };
+
+  struct Event {
+    Operation operation;
+    // The message that was parsed into or serialized.  GetTypeName() gives the
+    // breakdown by type.
+    const MessageLite* message;
+    // Bytes read or written.
+    int64 bytes;
+    // Wall time spent in the call.
+    int64 nanoseconds;
+    // Difference of AllocationCount() across the call.
+    int64 allocations;
+    // Whether the call succeeded.
+    bool ok;
+  };
+
+  InstrumentationSink() {}
+  virtual ~InstrumentationSink();
+
+  virtual void Record(const Event& event) = 0;
+
+  // Returns the number of allocations made so far by the calling thread.  The
+  // library cannot see the allocator, so by default no allocations are
+  // reported; override this with a counter kept by a malloc hook or by a
+  // replacement operator new.
+  virtual int64 AllocationCount() { return 0; }
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(InstrumentationSink);
+};
+
+// Installs the sink that receives events, or removes it if sink is NULL.  The
+// sink must outlive all parse and serialize calls made while it is installed.
+PROTOBUF_EXPORT void SetInstrumentationSink(InstrumentationSink* sink);
+
+namespace internal {
+
+#ifdef PROTOBUF_INSTRUMENTATION
+
+PROTOBUF_EXPORT InstrumentationSink* GetInstrumentationSink();
+
+// Reports one call to the installed sink when it goes out of scope, unless
+// there is no sink or another scope is already active on this thread.
+class PROTOBUF_EXPORT InstrumentationScope {
+ public:
+  InstrumentationScope(InstrumentationSink::Operation operation,
+                       const MessageLite* message)
+      : sink_(GetInstrumentationSink()) {
+    if (PROTOBUF_PREDICT_FALSE(sink_ != nullptr)) Start(operation, message);
+  }
+  ~InstrumentationScope() {
+    if (PROTOBUF_PREDICT_FALSE(sink_ != nullptr)) Finish();
+  }
+
+  void set_bytes(int64 bytes) { event_.bytes = bytes; }
+  bool set_ok(bool ok) { return event_.ok = ok; }
+
+ private:
+  void Start(InstrumentationSink::Operation operation,
+             const MessageLite* message);
+  void Finish();
+
+  InstrumentationSink* sink_;
+  InstrumentationSink::Event event_;
+  std::chrono::steady_clock::time_point start_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(InstrumentationScope);
+};
+
+#else  // PROTOBUF_INSTRUMENTATION
+
+class InstrumentationScope {
+ public:
+  InstrumentationScope(InstrumentationSink::Operation, const MessageLite*) {}
+
+  void set_bytes(int64) {}
+  bool set_ok(bool ok) { return ok; }
+};
+
+#endif  // !PROTOBUF_INSTRUMENTATION
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_INSTRUMENTATION_H__
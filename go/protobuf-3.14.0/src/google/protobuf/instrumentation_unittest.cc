@@ -0,0 +1,161 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/instrumentation.h>
+
+#include <string>
+#include <vector>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+class RecordingSink : public InstrumentationSink {
+ public:
+  RecordingSink() : allocations_(0) { SetInstrumentationSink(this); }
+  ~RecordingSink() override { SetInstrumentationSink(nullptr); }
+
+  void Record(const Event& event) override { events_.push_back(event); }
+  int64 AllocationCount() override { return allocations_ += 3; }
+
+  std::vector<Event> events_;
+
+ private:
+  int64 allocations_;
+};
+
+#ifdef PROTOBUF_INSTRUMENTATION
+
+TEST(InstrumentationTest, ParseAndSerialize) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data;
+
+  RecordingSink sink;
+  ASSERT_TRUE(message.SerializeToString(&data));
+  ASSERT_EQ(1, sink.events_.size());
+  EXPECT_EQ(InstrumentationSink::SERIALIZE, sink.events_[0].operation);
+  EXPECT_EQ(&message, sink.events_[0].message);
+  EXPECT_EQ(data.size(), sink.events_[0].bytes);
+  EXPECT_GE(sink.events_[0].nanoseconds, 0);
+  EXPECT_EQ(3, sink.events_[0].allocations);
+  EXPECT_TRUE(sink.events_[0].ok);
+
+  unittest::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(data));
+  ASSERT_EQ(2, sink.events_.size());
+  EXPECT_EQ(InstrumentationSink::PARSE, sink.events_[1].operation);
+  EXPECT_EQ(&parsed, sink.events_[1].message);
+  EXPECT_EQ("protobuf_unittest.TestAllTypes",
+            sink.events_[1].message->GetTypeName());
+  EXPECT_EQ(data.size(), sink.events_[1].bytes);
+  EXPECT_TRUE(sink.events_[1].ok);
+}
+
+TEST(InstrumentationTest, Streams) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data;
+
+  RecordingSink sink;
+  {
+    io::StringOutputStream output(&data);
+    io::CodedOutputStream coded_output(&output);
+    ASSERT_TRUE(message.SerializeToCodedStream(&coded_output));
+  }
+  {
+    io::ArrayInputStream input(data.data(), data.size());
+    ASSERT_TRUE(message.ParseFromZeroCopyStream(&input));
+  }
+  {
+    io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                               data.size());
+    ASSERT_TRUE(message.ParseFromCodedStream(&input));
+  }
+  ASSERT_EQ(3, sink.events_.size());
+  for (const InstrumentationSink::Event& event : sink.events_) {
+    EXPECT_EQ(data.size(), event.bytes);
+    EXPECT_TRUE(event.ok);
+  }
+}
+
+TEST(InstrumentationTest, Failure) {
+  RecordingSink sink;
+  unittest::TestAllTypes message;
+  EXPECT_FALSE(message.ParseFromString("\xff"));
+  ASSERT_EQ(1, sink.events_.size());
+  EXPECT_FALSE(sink.events_[0].ok);
+
+  unittest::TestRequired required;
+  EXPECT_FALSE(required.ParseFromString(""));
+  ASSERT_EQ(2, sink.events_.size());
+  EXPECT_FALSE(sink.events_[1].ok);
+}
+
+TEST(InstrumentationTest, OnlyOutermostCallIsReported) {
+  class NestingSink : public RecordingSink {
+   public:
+    void Record(const Event& event) override {
+      // Work done by the sink itself is not reported either.
+      unittest::TestAllTypes message;
+      message.ParseFromString("");
+      RecordingSink::Record(event);
+    }
+  };
+
+  NestingSink sink;
+  unittest::TestAllTypes message;
+  message.ParseFromString("");
+  EXPECT_EQ(1, sink.events_.size());
+}
+
+#else  // PROTOBUF_INSTRUMENTATION
+
+TEST(InstrumentationTest, Disabled) {
+  RecordingSink sink;
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data;
+  ASSERT_TRUE(message.SerializeToString(&data));
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_TRUE(sink.events_.empty());
+}
+
+#endif  // !PROTOBUF_INSTRUMENTATION
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,429 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/io/async_file_stream.h>
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#endif
+#include <errno.h>
+
+#include <algorithm>
+
+#include <google/protobuf/stubs/logging.h>
+#include <google/protobuf/io/io_win32.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+#ifdef _WIN32
+// DO NOT include <io.h>, instead create functions in io_win32.{h,cc} and import
+// them like we do below.
+using google::protobuf::io::win32::close;
+using google::protobuf::io::win32::read;
+using google::protobuf::io::win32::write;
+#endif
+
+namespace {
+
+static const int kDefaultBlockSize = 256 << 10;
+static const int kDefaultQueueDepth = 4;
+
+// EINTR sucks.
+int close_no_eintr(int fd) {
+  int result;
+  do {
+    result = close(fd);
+  } while (result < 0 && errno == EINTR);
+  return result;
+}
+
+}  // namespace
+
+// ===================================================================
+
+AsyncFileInputStream::AsyncFileInputStream(int file_descriptor,
+                                           int block_size, int queue_depth)
+    : file_(file_descriptor),
+      block_size_(block_size > 0 ? block_size : kDefaultBlockSize),
+      close_on_delete_(false),
+      is_closed_(false),
+      stop_(false),
+      done_(false),
+      errno_(0),
+      backup_bytes_(0),
+      position_(0) {
+  if (queue_depth <= 0) queue_depth = kDefaultQueueDepth;
+  // One more buffer than the queue depth, for the block held by the caller.
+  for (int i = 0; i <= queue_depth; i++) {
+    buffers_.emplace_back(new char[block_size_]);
+    free_buffers_.push_back(i);
+  }
+  current_.index = -1;
+  current_.size = 0;
+  wake_[0] = wake_[1] = -1;
+#ifndef _WIN32
+  if (pipe(wake_) != 0) {
+    // Without the pipe, reads just block as they do on Windows.
+    wake_[0] = wake_[1] = -1;
+  }
+#endif
+  reader_ = std::thread(&AsyncFileInputStream::ReadLoop, this);
+}
+
+AsyncFileInputStream::~AsyncFileInputStream() {
+  if (close_on_delete_ && !is_closed_) {
+    if (!Close()) {
+      GOOGLE_LOG(ERROR) << "close() failed: " << strerror(GetErrno());
+    }
+  }
+  StopReading();
+  if (wake_[0] >= 0) {
+    close_no_eintr(wake_[0]);
+    close_no_eintr(wake_[1]);
+  }
+}
+
+bool AsyncFileInputStream::WaitReadable() {
+#ifndef _WIN32
+  if (wake_[0] < 0) return true;
+  struct pollfd fds[2];
+  fds[0].fd = file_;
+  fds[0].events = POLLIN;
+  fds[1].fd = wake_[0];
+  fds[1].events = POLLIN;
+  int result;
+  do {
+    fds[0].revents = fds[1].revents = 0;
+    result = poll(fds, 2, -1);
+  } while (result < 0 && errno == EINTR);
+  // On a poll() error, let read() report the problem.
+  return fds[1].revents == 0;
+#else
+  return true;
+#endif
+}
+
+void AsyncFileInputStream::ReadLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stop_ || !free_buffers_.empty(); });
+    if (stop_) break;
+    Block block;
+    block.index = free_buffers_.back();
+    free_buffers_.pop_back();
+    lock.unlock();
+
+    if (!WaitReadable()) {
+      lock.lock();
+      free_buffers_.push_back(block.index);
+      break;
+    }
+    int result;
+    do {
+      result = read(file_, buffers_[block.index].get(), block_size_);
+    } while (result < 0 && errno == EINTR);
+    int error = result < 0 ? errno : 0;
+
+    lock.lock();
+    if (result > 0) {
+      block.size = result;
+      filled_blocks_.push_back(block);
+    } else {
+      free_buffers_.push_back(block.index);
+      errno_ = error;
+      break;
+    }
+    cond_.notify_all();
+  }
+  done_ = true;
+  cond_.notify_all();
+}
+
+void AsyncFileInputStream::StopReading() {
+  if (!reader_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (wake_[1] >= 0) {
+    char c = 0;
+    int result;
+    do {
+      result = write(wake_[1], &c, 1);
+    } while (result < 0 && errno == EINTR);
+  }
+  reader_.join();
+}
+
+bool AsyncFileInputStream::Close() {
+  GOOGLE_CHECK(!is_closed_);
+
+  StopReading();
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    errno_ = errno;
+    return false;
+  }
+  return true;
+}
+
+int AsyncFileInputStream::GetErrno() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return errno_;
+}
+
+bool AsyncFileInputStream::Next(const void** data, int* size) {
+  if (backup_bytes_ > 0) {
+    // We have data left over from a previous BackUp(), so just return that.
+    *data = buffers_[current_.index].get() + current_.size - backup_bytes_;
+    *size = backup_bytes_;
+    position_ += backup_bytes_;
+    backup_bytes_ = 0;
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_.index >= 0) {
+    free_buffers_.push_back(current_.index);
+    current_.index = -1;
+    cond_.notify_all();
+  }
+  cond_.wait(lock, [this] { return done_ || !filled_blocks_.empty(); });
+  if (filled_blocks_.empty()) return false;
+  current_ = filled_blocks_.front();
+  filled_blocks_.pop_front();
+  lock.unlock();
+
+  *data = buffers_[current_.index].get();
+  *size = current_.size;
+  position_ += current_.size;
+  return true;
+}
+
+void AsyncFileInputStream::BackUp(int count) {
+  GOOGLE_CHECK_EQ(backup_bytes_, 0)
+      << "BackUp() can only be called after Next().";
+  GOOGLE_CHECK_GE(current_.index, 0)
+      << "BackUp() can only be called after Next().";
+  GOOGLE_CHECK_LE(count, current_.size)
+      << "Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  GOOGLE_CHECK_GE(count, 0) << "Parameter to BackUp() can't be negative.";
+
+  backup_bytes_ = count;
+  position_ -= count;
+}
+
+bool AsyncFileInputStream::Skip(int count) {
+  GOOGLE_CHECK_GE(count, 0);
+  while (count > 0) {
+    const void* data;
+    int size;
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+// ===================================================================
+
+AsyncFileOutputStream::AsyncFileOutputStream(int file_descriptor,
+                                             int block_size, int queue_depth)
+    : file_(file_descriptor),
+      block_size_(block_size > 0 ? block_size : kDefaultBlockSize),
+      close_on_delete_(false),
+      is_closed_(false),
+      writing_(0),
+      stop_(false),
+      errno_(0),
+      last_returned_size_(0),
+      position_(0) {
+  if (queue_depth <= 0) queue_depth = kDefaultQueueDepth;
+  // One more buffer than the queue depth, for the block being filled.
+  for (int i = 0; i <= queue_depth; i++) {
+    buffers_.emplace_back(new char[block_size_]);
+    free_buffers_.push_back(i);
+  }
+  current_.index = -1;
+  current_.size = 0;
+  writer_ = std::thread(&AsyncFileOutputStream::WriteLoop, this);
+}
+
+AsyncFileOutputStream::~AsyncFileOutputStream() {
+  if (!is_closed_) {
+    if (close_on_delete_) {
+      if (!Close()) {
+        GOOGLE_LOG(ERROR) << "close() failed: " << strerror(GetErrno());
+      }
+    } else {
+      Flush();
+    }
+  }
+  StopWriting();
+}
+
+void AsyncFileOutputStream::WriteLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stop_ || !pending_blocks_.empty(); });
+    if (pending_blocks_.empty()) break;
+    Block block = pending_blocks_.front();
+    pending_blocks_.pop_front();
+    writing_++;
+    lock.unlock();
+
+    const char* data = buffers_[block.index].get();
+    int error = 0;
+    while (block.size > 0) {
+      int result;
+      do {
+        result = write(file_, data, block.size);
+      } while (result < 0 && errno == EINTR);
+      if (result <= 0) {
+        // Write error.  As in FileOutputStream, zero counts as an error.
+        error = result < 0 ? errno : EIO;
+        break;
+      }
+      data += result;
+      block.size -= result;
+    }
+
+    lock.lock();
+    writing_--;
+    free_buffers_.push_back(block.index);
+    if (error != 0) {
+      errno_ = error;
+      // The stream is broken; drop everything still queued.
+      for (const Block& dropped : pending_blocks_) {
+        free_buffers_.push_back(dropped.index);
+      }
+      pending_blocks_.clear();
+    }
+    cond_.notify_all();
+  }
+}
+
+void AsyncFileOutputStream::SubmitCurrent() {
+  if (current_.index < 0) return;
+  if (current_.size > 0 && errno_ == 0) {
+    pending_blocks_.push_back(current_);
+  } else {
+    free_buffers_.push_back(current_.index);
+  }
+  current_.index = -1;
+  last_returned_size_ = 0;
+  cond_.notify_all();
+}
+
+void AsyncFileOutputStream::StopWriting() {
+  if (!writer_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  writer_.join();
+}
+
+bool AsyncFileOutputStream::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  SubmitCurrent();
+  cond_.wait(lock,
+             [this] { return pending_blocks_.empty() && writing_ == 0; });
+  return errno_ == 0;
+}
+
+bool AsyncFileOutputStream::Close() {
+  GOOGLE_CHECK(!is_closed_);
+
+  bool flush_succeeded = Flush();
+  StopWriting();
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    errno_ = errno;
+    return false;
+  }
+  return flush_succeeded;
+}
+
+int AsyncFileOutputStream::GetErrno() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return errno_;
+}
+
+bool AsyncFileOutputStream::Next(void** data, int* size) {
+  if (current_.index >= 0 && current_.size < block_size_) {
+    // Hand out the rest of a block that was backed up into.
+    *data = buffers_[current_.index].get() + current_.size;
+    *size = block_size_ - current_.size;
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    SubmitCurrent();
+    cond_.wait(lock, [this] { return errno_ != 0 || !free_buffers_.empty(); });
+    if (errno_ != 0) return false;
+    current_.index = free_buffers_.back();
+    current_.size = 0;
+    free_buffers_.pop_back();
+    lock.unlock();
+
+    *data = buffers_[current_.index].get();
+    *size = block_size_;
+  }
+  last_returned_size_ = *size;
+  current_.size = block_size_;
+  position_ += *size;
+  return true;
+}
+
+void AsyncFileOutputStream::BackUp(int count) {
+  GOOGLE_CHECK_GE(count, 0);
+  GOOGLE_CHECK_LE(count, last_returned_size_)
+      << "BackUp() can only be called after Next() and can't back up more "
+         "bytes than were returned by the last call to Next().";
+  current_.size -= count;
+  position_ -= count;
+  last_returned_size_ = 0;
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,228 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains AsyncFileInputStream and AsyncFileOutputStream, which
+// move reads from and writes to a file descriptor onto a background thread
+// so that I/O overlaps with parsing and serialization.
+
+#ifndef GOOGLE_PROTOBUF_IO_ASYNC_FILE_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_ASYNC_FILE_STREAM_H__
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream which reads from a file descriptor ahead of the
+// caller.
+//
+// A background thread keeps up to queue_depth blocks of block_size bytes
+// filled, so that while the caller parses one block the next ones are
+// already being read. Next() only blocks if the reader has fallen behind.
+// This helps most when parsing and reading take comparable time, e.g. on
+// fast disks; for data that is already in memory, FileInputStream is just
+// as fast.
+//
+// The descriptor is read from the background thread, which keeps running
+// until the end of the file, an error, or the destruction of the stream.
+// On POSIX systems the thread waits for the descriptor to become readable
+// before each read, and Close() or destruction wake it up, so pipes and
+// sockets that have no data can be abandoned too.  On Windows destruction
+// waits for the read in progress, so there only regular files are supported.
+// Reads that have already been issued are not undone, so the descriptor's
+// offset after use is unspecified.
+class PROTOBUF_EXPORT AsyncFileInputStream : public ZeroCopyInputStream {
+ public:
+  // Creates a stream that reads from the given Unix file descriptor.
+  // Reasonable defaults are used for block_size and queue_depth <= 0.
+  explicit AsyncFileInputStream(int file_descriptor, int block_size = -1,
+                                int queue_depth = -1);
+  ~AsyncFileInputStream() override;
+
+  // Stops reading and closes the underlying file.  Returns false if an error
+  // occurs during the process; use GetErrno() to examine the error.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Blocks read before
+  // the error are still returned by Next().
+  int GetErrno() const;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override { return position_; }
+
+ private:
+  struct Block {
+    int index;
+    int size;
+  };
+
+  // Body of the background thread.
+  void ReadLoop();
+  // Waits until file_ is readable.  Returns false if woken by StopReading().
+  bool WaitReadable();
+  void StopReading();
+
+  const int file_;
+  // A pipe whose read end becomes readable when reading stops.  Both ends
+  // are -1 if there is none.
+  int wake_[2];
+  const int block_size_;
+  bool close_on_delete_;
+  bool is_closed_;
+
+  std::vector<std::unique_ptr<char[]>> buffers_;
+
+  // Shared with the background thread and guarded by mutex_.
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<int> free_buffers_;
+  std::deque<Block> filled_blocks_;
+  bool stop_;
+  bool done_;
+  int errno_;
+
+  // Only used by the caller's thread.
+  Block current_;  // The block last returned by Next(), or index -1.
+  int backup_bytes_;
+  int64 position_;
+
+  std::thread reader_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(AsyncFileInputStream);
+};
+
+// ===================================================================
+
+// A ZeroCopyOutputStream which writes to a file descriptor behind the
+// caller.
+//
+// Each block filled by the caller is queued and written out by a background
+// thread, while Next() hands out the next free block. Up to queue_depth
+// blocks can be in flight; Next() blocks once all of them are.
+//
+// Write errors are reported asynchronously: once the background thread fails
+// to write, further data is dropped, and Next(), Flush() and Close() return
+// false.
+class PROTOBUF_EXPORT AsyncFileOutputStream : public ZeroCopyOutputStream {
+ public:
+  // Creates a stream that writes to the given Unix file descriptor.
+  // Reasonable defaults are used for block_size and queue_depth <= 0.
+  explicit AsyncFileOutputStream(int file_descriptor, int block_size = -1,
+                                 int queue_depth = -1);
+  ~AsyncFileOutputStream() override;
+
+  // Waits until all data written so far has reached the file descriptor.
+  // Returns false if an error occurs; use GetErrno() to examine the error.
+  bool Flush();
+
+  // Flushes and closes the underlying file.  Returns false if an error occurs
+  // during the process.  Even if an error occurs, the file descriptor is
+  // closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const;
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override { return position_; }
+
+ private:
+  struct Block {
+    int index;
+    int size;
+  };
+
+  // Body of the background thread.
+  void WriteLoop();
+  // Queues the current block, if it holds any data.  Requires mutex_.
+  void SubmitCurrent();
+  void StopWriting();
+
+  const int file_;
+  const int block_size_;
+  bool close_on_delete_;
+  bool is_closed_;
+
+  std::vector<std::unique_ptr<char[]>> buffers_;
+
+  // Shared with the background thread and guarded by mutex_.
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<int> free_buffers_;
+  std::deque<Block> pending_blocks_;
+  int writing_;  // Number of blocks the background thread is writing.
+  bool stop_;
+  int errno_;
+
+  // Only used by the caller's thread.
+  Block current_;  // The block being filled, or index -1.
+  int last_returned_size_;
+  int64 position_;
+
+  std::thread writer_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(AsyncFileOutputStream);
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_IO_ASYNC_FILE_STREAM_H__
@@ -157,6 +157,43 @@ class ZeroCopyCodedInputStream;
 namespace internal {
 void MapTestForceDeterministic();
 class EpsCopyByteStream;
+class ParseBudgetScope;
+
+// Charge storage growth to the ParseBudget of the parse running on this
+// thread.  They do nothing when that parse has no budget.  Only while some
+// thread parses with a budget do they look up the parse on this thread; the
+// fallbacks doing so are defined in parse_context.cc.
+
+// The number of parses with a ParseBudget running in the process.
+PROTOBUF_EXPORT extern std::atomic<int> parse_budget_users;
+
+PROTOBUF_EXPORT int ParseBudgetRepeatedCapacityFallback(int new_size,
+                                                        int capacity,
+                                                        size_t element_size,
+                                                        bool on_arena);
+PROTOBUF_EXPORT void ParseBudgetChargeFallback(size_t bytes);
+
+// Called by a repeated field that grows to hold new_size elements and would
+// allocate room for capacity of them.  Returns the capacity to allocate,
+// which is lowered to the budget's element limit when that still fits.
+inline int ParseBudgetRepeatedCapacity(int new_size, int capacity,
+                                       size_t element_size, bool on_arena) {
+  if (PROTOBUF_PREDICT_TRUE(
+          parse_budget_users.load(std::memory_order_relaxed) == 0)) {
+    return capacity;
+  }
+  return ParseBudgetRepeatedCapacityFallback(new_size, capacity, element_size,
+                                             on_arena);
+}
+// Called when an arena allocates a new block and when a map on the heap
+// allocates a new table.
+inline void ParseBudgetCharge(size_t bytes) {
+  if (PROTOBUF_PREDICT_TRUE(
+          parse_budget_users.load(std::memory_order_relaxed) == 0)) {
+    return;
+  }
+  ParseBudgetChargeFallback(bytes);
+}
 }  // namespace internal
 
 namespace io {
@@ -169,6 +206,71 @@ class CodedOutputStream;
 class ZeroCopyInputStream;   // zero_copy_stream.h
 class ZeroCopyOutputStream;  // zero_copy_stream.h
 
+// Limits on the memory a parse may allocate, for parsing untrusted input.
+// The total bytes and recursion limits of CodedInputStream bound how much
+// input is read, but a small input can still make the parser allocate much
+// more than its size: each element of a repeated message field costs a few
+// bytes of input and a whole message of memory.  A ParseBudget bounds that:
+//
+//   ParseBudget budget;
+//   budget.set_max_allocated_bytes(64 << 20);
+//   budget.set_max_repeated_elements(1 << 20);
+//   CodedInputStream input(data, size);
+//   input.SetParseBudget(&budget);
+//   if (!message.ParseFromCodedStream(&input)) {
+//     if (budget.exceeded()) ...
+//   }
+//
+// The limits are only checked where storage grows: when a repeated field or
+// map grows its array or table, when an arena allocates a new block and when
+// a map gets a new entry, so parsing within them costs nothing.
+// allocated_bytes() counts those allocations only; messages and strings the
+// parser allocates one by one on the heap are not counted, so parse onto an
+// arena to bound the total.  A parse that exceeds its budget stops at the
+// next sub-message and fails.
+//
+// A budget may be used by one parse at a time.  Its counters accumulate
+// across parses until Reset().
+class PROTOBUF_EXPORT ParseBudget {
+ public:
+  ParseBudget() {}
+
+  // Maximum bytes allocated by growing repeated fields, maps and arenas.
+  void set_max_allocated_bytes(int64 max) { max_allocated_bytes_ = max; }
+  int64 max_allocated_bytes() const { return max_allocated_bytes_; }
+
+  // Maximum number of elements in any one repeated field.
+  void set_max_repeated_elements(int max) { max_repeated_elements_ = max; }
+  int max_repeated_elements() const { return max_repeated_elements_; }
+
+  // Maximum number of entries in any one map field.
+  void set_max_map_entries(int max) { max_map_entries_ = max; }
+  int max_map_entries() const { return max_map_entries_; }
+
+  // Bytes charged so far.
+  int64 allocated_bytes() const { return allocated_bytes_; }
+
+  // Whether a parse went over one of the limits.
+  bool exceeded() const { return exceeded_; }
+
+  // Clears allocated_bytes() and exceeded(), keeping the limits.
+  void Reset() {
+    allocated_bytes_ = 0;
+    exceeded_ = false;
+  }
+
+ private:
+  friend class internal::ParseBudgetScope;
+
+  int64 max_allocated_bytes_ = kint64max;
+  int max_repeated_elements_ = kint32max;
+  int max_map_entries_ = kint32max;
+  int64 allocated_bytes_ = 0;
+  bool exceeded_ = false;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ParseBudget);
+};
+
 // Class which reads and decodes binary data which is composed of varint-
 // encoded integers and fixed-width pieces.  Wraps a ZeroCopyInputStream.
 // Most users will not need to deal with CodedInputStream.
@@ -426,6 +528,13 @@ class PROTOBUF_EXPORT CodedInputStream {
   // increments to recursion depth were successful.
   void UnsafeDecrementRecursionDepth();
 
+  // Parse Budget ----------------------------------------------------
+  // Bounds the memory allocated by messages parsed from this stream with
+  // MessageLite::ParseFromCodedStream() and friends; see ParseBudget.  The
+  // budget must outlive those parses.  NULL, the default, means no budget.
+  void SetParseBudget(ParseBudget* budget) { parse_budget_ = budget; }
+  ParseBudget* GetParseBudget() const { return parse_budget_; }
+
   // Shorthand for make_pair(PushLimit(byte_limit), --recursion_budget_).
   // Using this can reduce code size and complexity in some cases.  The caller
   // is expected to check that the second part of the result is non-negative (to
@@ -583,6 +692,9 @@ class PROTOBUF_EXPORT CodedInputStream {
   const DescriptorPool* extension_pool_;
   MessageFactory* extension_factory_;
 
+  // See SetParseBudget().
+  ParseBudget* parse_budget_;
+
   // Private member functions.
 
   // Fallback when Skip() goes past the end of the current buffer.
@@ -821,6 +933,12 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   // stream's overall position.
   int64 ByteCount(uint8* ptr) const;
 
+  // The number of bytes that may be written contiguously at ptr before the
+  // stream has to be advanced with EnsureSpace().
+  int ContiguousBytesAvailable(uint8* ptr) const {
+    return static_cast<int>(GetSize(ptr));
+  }
+
 
  private:
   uint8* end_;
@@ -1544,7 +1662,8 @@ inline CodedInputStream::CodedInputStream(ZeroCopyInputStream* input)
       recursion_budget_(default_recursion_limit_),
       recursion_limit_(default_recursion_limit_),
       extension_pool_(nullptr),
-      extension_factory_(nullptr) {
+      extension_factory_(nullptr),
+      parse_budget_(nullptr) {
   // Eagerly Refresh() so buffer space is immediately available.
   Refresh();
 }
@@ -1564,7 +1683,8 @@ inline CodedInputStream::CodedInputStream(const uint8* buffer, int size)
       recursion_budget_(default_recursion_limit_),
       recursion_limit_(default_recursion_limit_),
       extension_pool_(nullptr),
-      extension_factory_(nullptr) {
+      extension_factory_(nullptr),
+      parse_budget_(nullptr) {
   // Note that setting current_limit_ == size is important to prevent some
   // code paths from trying to access input_ and segfaulting.
 }
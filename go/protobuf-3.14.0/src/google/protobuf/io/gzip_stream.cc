@@ -117,6 +117,12 @@ int GzipInputStream::Inflate(int flush) {
   zcontext_.avail_out = output_buffer_length_;
   output_position_ = output_buffer_;
   int error = inflate(&zcontext_, flush);
+  if (error == Z_NEED_DICT && !dictionary_.empty()) {
+    error = inflateSetDictionary(
+        &zcontext_, reinterpret_cast<const Bytef*>(dictionary_.data()),
+        dictionary_.size());
+    if (error == Z_OK) error = inflate(&zcontext_, flush);
+  }
   return error;
 }
 
@@ -240,6 +246,11 @@ void GzipOutputStream::Init(ZeroCopyOutputStream* sub_stream,
       deflateInit2(&zcontext_, options.compression_level, Z_DEFLATED,
                    /* windowBits */ 15 | windowBitsFormat,
                    /* memLevel (default) */ 8, options.compression_strategy);
+  if (zerror_ == Z_OK && !options.dictionary.empty()) {
+    zerror_ = deflateSetDictionary(
+        &zcontext_, reinterpret_cast<const Bytef*>(options.dictionary.data()),
+        options.dictionary.size());
+  }
 }
 
 GzipOutputStream::~GzipOutputStream() {
@@ -44,6 +44,8 @@
 #define GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 
 
+#include <string>
+
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/port.h>
@@ -79,6 +81,13 @@ class PROTOBUF_EXPORT GzipInputStream : public ZeroCopyInputStream {
   inline const char* ZlibErrorMessage() const { return zcontext_.msg; }
   inline int ZlibErrorCode() const { return zerror_; }
 
+  // Sets the preset dictionary for ZLIB streams compressed with one; see
+  // GzipOutputStream::Options::dictionary.  Must be called before the first
+  // call to Next().
+  void SetDictionary(const std::string& dictionary) {
+    dictionary_ = dictionary;
+  }
+
   // implements ZeroCopyInputStream ----------------------------------
   bool Next(const void** data, int* size);
   void BackUp(int count);
@@ -87,6 +96,7 @@ class PROTOBUF_EXPORT GzipInputStream : public ZeroCopyInputStream {
 
  private:
   Format format_;
+  std::string dictionary_;
 
   ZeroCopyInputStream* sub_stream_;
 
@@ -131,6 +141,14 @@ class PROTOBUF_EXPORT GzipOutputStream : public ZeroCopyOutputStream {
     // zlib.h for definitions of these constants.
     int compression_strategy;
 
+    // A preset dictionary, empty by default.  Data resembling the dictionary
+    // compresses much better, which matters most for small inputs such as
+    // single serialized messages; a few typical messages concatenated, the
+    // most common ones last, make a good dictionary.  Only the ZLIB format
+    // supports dictionaries, and the reader has to use the same one; see
+    // GzipInputStream::SetDictionary().  At most 32kB of it are used.
+    std::string dictionary;
+
     Options();  // Initializes with default values.
   };
 
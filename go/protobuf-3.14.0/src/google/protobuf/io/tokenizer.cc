@@ -248,6 +248,16 @@ void Tokenizer::NextChar() {
   }
 }
 
+inline void Tokenizer::AdvanceTo(int position) {
+  column_ += position - buffer_pos_;
+  buffer_pos_ = position;
+  if (buffer_pos_ < buffer_size_) {
+    current_char_ = buffer_[buffer_pos_];
+  } else {
+    Refresh();
+  }
+}
+
 void Tokenizer::Refresh() {
   if (read_error_) {
     current_char_ = '\0';
@@ -340,7 +350,17 @@ inline bool Tokenizer::TryConsume(char c) {
 template <typename CharacterClass>
 inline void Tokenizer::ConsumeZeroOrMore() {
   while (CharacterClass::InClass(current_char_)) {
-    NextChar();
+    if (current_char_ == '\n' || current_char_ == '\t') {
+      NextChar();
+      continue;
+    }
+    // Skip the rest of the run within the current buffer in one step.
+    int end = buffer_pos_ + 1;
+    while (end < buffer_size_ && CharacterClass::InClass(buffer_[end]) &&
+           buffer_[end] != '\n' && buffer_[end] != '\t') {
+      ++end;
+    }
+    AdvanceTo(end);
   }
 }
 
@@ -349,9 +369,7 @@ inline void Tokenizer::ConsumeOneOrMore(const char* error) {
   if (!CharacterClass::InClass(current_char_)) {
     AddError(error);
   } else {
-    do {
-      NextChar();
-    } while (CharacterClass::InClass(current_char_));
+    ConsumeZeroOrMore<CharacterClass>();
   }
 }
 
@@ -417,7 +435,21 @@ void Tokenizer::ConsumeString(char delimiter) {
           NextChar();
           return;
         }
-        NextChar();
+        if (current_char_ == '\t') {
+          NextChar();
+          break;
+        }
+        // Skip ahead to the next character that needs a closer look.
+        int end = buffer_pos_ + 1;
+        while (end < buffer_size_) {
+          char c = buffer_[end];
+          if (c == delimiter || c == '\\' || c == '\n' || c == '\t' ||
+              c == '\0') {
+            break;
+          }
+          ++end;
+        }
+        AdvanceTo(end);
         break;
       }
     }
@@ -483,7 +515,16 @@ void Tokenizer::ConsumeLineComment(std::string* content) {
   if (content != NULL) RecordTo(content);
 
   while (current_char_ != '\0' && current_char_ != '\n') {
-    NextChar();
+    if (current_char_ == '\t') {
+      NextChar();
+      continue;
+    }
+    int end = buffer_pos_ + 1;
+    while (end < buffer_size_ && buffer_[end] != '\0' &&
+           buffer_[end] != '\n' && buffer_[end] != '\t') {
+      ++end;
+    }
+    AdvanceTo(end);
   }
   TryConsume('\n');
 
@@ -563,7 +604,13 @@ Tokenizer::NextCommentStatus Tokenizer::TryConsumeCommentStart() {
 // -------------------------------------------------------------------
 
 bool Tokenizer::Next() {
-  previous_ = current_;
+  // The text is swapped rather than copied, so that the new token reuses the
+  // buffer of the one before the previous token.
+  previous_.type = current_.type;
+  previous_.text.swap(current_.text);
+  previous_.line = current_.line;
+  previous_.column = current_.column;
+  previous_.end_column = current_.end_column;
 
   while (!read_error_) {
     ConsumeZeroOrMore<Whitespace>();
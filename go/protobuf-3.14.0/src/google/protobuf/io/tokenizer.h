@@ -299,6 +299,11 @@ class PROTOBUF_EXPORT Tokenizer {
   // Consume this character and advance to the next one.
   void NextChar();
 
+  // Consume the characters from buffer_pos_ up to position, which must be at
+  // most buffer_size_, at once. None of them may be '\n' or '\t', the only
+  // characters for which NextChar() does more than advance the column.
+  inline void AdvanceTo(int position);
+
   // Read a new buffer from the input.
   void Refresh();
 
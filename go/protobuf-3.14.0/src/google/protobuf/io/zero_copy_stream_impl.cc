@@ -38,6 +38,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
 #include <errno.h>
 
 #include <algorithm>
@@ -164,6 +168,171 @@ int FileInputStream::CopyingFileInputStream::Skip(int count) {
 
 // ===================================================================
 
+namespace {
+// Default number of bytes returned by MappedFileInputStream::Next().
+static const int kDefaultMappedBlockSize = 1 << 20;
+// How far ahead of the current position MappedFileInputStream keeps pages
+// requested from the kernel, and how much consumed data it lets accumulate
+// before telling the kernel it can drop it.
+static const int64 kMappedReadaheadBytes = 8 << 20;
+static const int64 kMappedReleaseBytes = 8 << 20;
+}  // namespace
+
+MappedFileInputStream::MappedFileInputStream(int file_descriptor,
+                                             int block_size)
+    : file_(file_descriptor),
+      block_size_(block_size > 0 ? block_size : kDefaultMappedBlockSize),
+      close_on_delete_(false),
+      is_closed_(false),
+      errno_(0),
+      data_(nullptr),
+      size_(0),
+      start_(0),
+      position_(0),
+      last_returned_size_(0),
+      page_size_(4096),
+      advised_end_(0),
+      released_end_(0) {
+#ifndef _WIN32
+  struct stat st;
+  off_t offset = lseek(file_, 0, SEEK_CUR);
+  if (offset != (off_t)-1 && fstat(file_, &st) == 0 && S_ISREG(st.st_mode) &&
+      st.st_size > 0) {
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, file_, 0);
+    if (mapping != MAP_FAILED) {
+      data_ = static_cast<const char*>(mapping);
+      size_ = st.st_size;
+      start_ = position_ = std::min<int64>(offset, size_);
+      long page_size = sysconf(_SC_PAGESIZE);
+      if (page_size > 0) page_size_ = page_size;
+      released_end_ = advised_end_ = position_ - position_ % page_size_;
+      madvise(mapping, size_, MADV_SEQUENTIAL);
+      Advise();
+      return;
+    }
+  }
+#endif
+  fallback_.reset(new FileInputStream(file_descriptor, block_size));
+}
+
+MappedFileInputStream::~MappedFileInputStream() {
+  if (fallback_ != nullptr) {
+    fallback_.reset();
+    if (close_on_delete_ && !is_closed_ && close_no_eintr(file_) != 0) {
+      GOOGLE_LOG(ERROR) << "close() failed: " << strerror(errno);
+    }
+    return;
+  }
+  if (is_closed_) return;
+  Unmap();
+  if (close_on_delete_ && !Close()) {
+    GOOGLE_LOG(ERROR) << "close() failed: " << strerror(errno_);
+  }
+}
+
+void MappedFileInputStream::SetCloseOnDelete(bool value) {
+  close_on_delete_ = value;
+}
+
+int MappedFileInputStream::GetErrno() const {
+  return fallback_ != nullptr ? fallback_->GetErrno() : errno_;
+}
+
+void MappedFileInputStream::Unmap() {
+#ifndef _WIN32
+  if (data_ == nullptr) return;
+  munmap(const_cast<char*>(data_), size_);
+  lseek(file_, position_, SEEK_SET);
+  data_ = nullptr;
+  size_ = 0;
+#endif
+}
+
+bool MappedFileInputStream::Close() {
+  GOOGLE_CHECK(!is_closed_);
+  if (fallback_ != nullptr) {
+    is_closed_ = true;
+    return fallback_->Close();
+  }
+
+  Unmap();
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+  return true;
+}
+
+void MappedFileInputStream::Advise() {
+#ifndef _WIN32
+  // Keep a window of pages ahead of the position requested from the kernel,
+  // topping it up a whole window at a time.
+  if (advised_end_ < size_ &&
+      advised_end_ < position_ + kMappedReadaheadBytes) {
+    int64 begin = std::max(advised_end_, position_ - position_ % page_size_);
+    int64 end = std::min(size_, position_ + 2 * kMappedReadaheadBytes);
+    madvise(const_cast<char*>(data_) + begin, end - begin, MADV_WILLNEED);
+    advised_end_ = end;
+  }
+  // Pages before the last returned block can't be backed up into anymore.
+  // Dropping them only discards this mapping's view of the page cache; the
+  // data is read back from the file should anyone still touch it.
+  int64 consumed = position_ - last_returned_size_;
+  consumed -= consumed % page_size_;
+  if (consumed - released_end_ >= kMappedReleaseBytes) {
+    madvise(const_cast<char*>(data_) + released_end_, consumed - released_end_,
+            MADV_DONTNEED);
+    released_end_ = consumed;
+  }
+#endif
+}
+
+bool MappedFileInputStream::Next(const void** data, int* size) {
+  if (fallback_ != nullptr) return fallback_->Next(data, size);
+  GOOGLE_CHECK(!is_closed_);
+  if (position_ >= size_) {
+    last_returned_size_ = 0;
+    return false;
+  }
+  last_returned_size_ = std::min<int64>(block_size_, size_ - position_);
+  *data = data_ + position_;
+  *size = static_cast<int>(last_returned_size_);
+  position_ += last_returned_size_;
+  Advise();
+  return true;
+}
+
+void MappedFileInputStream::BackUp(int count) {
+  if (fallback_ != nullptr) return fallback_->BackUp(count);
+  GOOGLE_CHECK_GE(count, 0);
+  GOOGLE_CHECK_LE(count, last_returned_size_)
+      << "BackUp() can only be called after Next() and can't back up more "
+         "bytes than were returned by the last call to Next().";
+  position_ -= count;
+  last_returned_size_ = 0;
+}
+
+bool MappedFileInputStream::Skip(int count) {
+  if (fallback_ != nullptr) return fallback_->Skip(count);
+  GOOGLE_CHECK_GE(count, 0);
+  last_returned_size_ = 0;
+  if (count > size_ - position_) {
+    position_ = size_;
+    return false;
+  }
+  position_ += count;
+  Advise();
+  return true;
+}
+
+int64_t MappedFileInputStream::ByteCount() const {
+  if (fallback_ != nullptr) return fallback_->ByteCount();
+  return position_ - start_;
+}
+
+// ===================================================================
+
 FileOutputStream::FileOutputStream(int file_descriptor, int block_size)
     : CopyingOutputStreamAdaptor(&copying_output_),
       copying_output_(file_descriptor) {}
@@ -242,6 +411,166 @@ bool FileOutputStream::CopyingFileOutputStream::Write(const void* buffer,
 
 // ===================================================================
 
+namespace {
+static const int kDefaultGatheringBlockSize = 64 << 10;
+static const int kDefaultGatheringFlushThreshold = 1 << 20;
+// POSIX only guarantees IOV_MAX >= 16; Linux and the BSDs allow 1024.
+static const int kMaxGatheringIovecs = 64;
+}  // namespace
+
+GatheringFileOutputStream::GatheringFileOutputStream(int file_descriptor,
+                                                     int block_size,
+                                                     int flush_threshold)
+    : file_(file_descriptor),
+      block_size_(block_size > 0 ? block_size : kDefaultGatheringBlockSize),
+      flush_threshold_(flush_threshold > 0 ? flush_threshold
+                                           : kDefaultGatheringFlushThreshold),
+      close_on_delete_(false),
+      is_closed_(false),
+      errno_(0),
+      queued_bytes_(0),
+      position_(0),
+      block_used_(0),
+      last_returned_size_(0) {}
+
+GatheringFileOutputStream::~GatheringFileOutputStream() {
+  if (is_closed_) return;
+  if (close_on_delete_) {
+    if (!Close()) {
+      GOOGLE_LOG(ERROR) << "close() failed: " << strerror(errno_);
+    }
+  } else {
+    Flush();
+  }
+}
+
+void GatheringFileOutputStream::AppendSlice(const char* data, int size) {
+  if (!slices_.empty() &&
+      slices_.back().data + slices_.back().size == data) {
+    slices_.back().size += size;
+  } else {
+    Slice slice = {data, size};
+    slices_.push_back(slice);
+  }
+  queued_bytes_ += size;
+  position_ += size;
+}
+
+bool GatheringFileOutputStream::Next(void** data, int* size) {
+  if (errno_ != 0) return false;
+  if (queued_bytes_ >= flush_threshold_ && !WriteSlices()) return false;
+
+  if (used_blocks_.empty() || block_used_ == block_size_) {
+    if (free_blocks_.empty()) {
+      used_blocks_.emplace_back(new char[block_size_]);
+    } else {
+      used_blocks_.push_back(std::move(free_blocks_.back()));
+      free_blocks_.pop_back();
+    }
+    block_used_ = 0;
+  }
+  char* block = used_blocks_.back().get();
+  *data = block + block_used_;
+  *size = block_size_ - block_used_;
+  AppendSlice(block + block_used_, *size);
+  last_returned_size_ = *size;
+  block_used_ = block_size_;
+  return true;
+}
+
+void GatheringFileOutputStream::BackUp(int count) {
+  GOOGLE_CHECK_GE(count, 0);
+  GOOGLE_CHECK_LE(count, last_returned_size_)
+      << "BackUp() can only be called after Next() and can't back up more "
+         "bytes than were returned by the last call to Next().";
+  if (count == 0) return;
+  slices_.back().size -= count;
+  if (slices_.back().size == 0) slices_.pop_back();
+  block_used_ -= count;
+  queued_bytes_ -= count;
+  position_ -= count;
+  last_returned_size_ = 0;
+}
+
+bool GatheringFileOutputStream::WriteAliasedRaw(const void* data, int size) {
+  if (errno_ != 0) return false;
+  if (queued_bytes_ >= flush_threshold_ && !WriteSlices()) return false;
+  // The tail of the current block can't be handed out anymore, as it would
+  // be written after this slice. Start a new block on the next Next().
+  block_used_ = block_size_;
+  last_returned_size_ = 0;
+  AppendSlice(static_cast<const char*>(data), size);
+  return true;
+}
+
+bool GatheringFileOutputStream::WriteSlices() {
+  size_t next = 0;
+  while (next < slices_.size()) {
+    int result;
+#ifndef _WIN32
+    iovec iov[kMaxGatheringIovecs];
+    size_t count = std::min<size_t>(slices_.size() - next, kMaxGatheringIovecs);
+    for (size_t i = 0; i < count; i++) {
+      iov[i].iov_base = const_cast<char*>(slices_[next + i].data);
+      iov[i].iov_len = slices_[next + i].size;
+    }
+    do {
+      result = writev(file_, iov, count);
+    } while (result < 0 && errno == EINTR);
+#else
+    do {
+      result = write(file_, slices_[next].data, slices_[next].size);
+    } while (result < 0 && errno == EINTR);
+#endif
+    if (result <= 0) {
+      // Write error.
+      errno_ = result < 0 ? errno : EIO;
+      return false;
+    }
+    // Skip the slices that were written completely, and trim a partially
+    // written one.
+    while (result > 0) {
+      Slice& slice = slices_[next];
+      if (result >= slice.size) {
+        result -= slice.size;
+        next++;
+      } else {
+        slice.data += result;
+        slice.size -= result;
+        result = 0;
+      }
+    }
+  }
+
+  slices_.clear();
+  queued_bytes_ = 0;
+  // Everything but the block Next() is filling can be reused. Starting over
+  // in it would reorder data, so it is recycled too and Next() starts anew.
+  for (auto& block : used_blocks_) free_blocks_.push_back(std::move(block));
+  used_blocks_.clear();
+  last_returned_size_ = 0;
+  return true;
+}
+
+bool GatheringFileOutputStream::Flush() {
+  if (errno_ != 0) return false;
+  return WriteSlices();
+}
+
+bool GatheringFileOutputStream::Close() {
+  GOOGLE_CHECK(!is_closed_);
+
+  bool flush_succeeded = Flush();
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+  return flush_succeeded;
+}
+
+// ===================================================================
+
 IstreamInputStream::IstreamInputStream(std::istream* input, int block_size)
     : copying_input_(input), impl_(&copying_input_, block_size) {}
 
@@ -42,7 +42,9 @@
 
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/io/zero_copy_stream.h>
@@ -132,6 +134,79 @@ class PROTOBUF_EXPORT FileInputStream : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream which reads a file by mapping it into memory.
+//
+// Next() returns pointers straight into the mapping, so no data is copied
+// out of the page cache. This suits large files read front to back: the
+// stream asks the kernel to read ahead of the current position and lets it
+// drop pages that have already been consumed. Parsing with aliasing enabled
+// may keep pointers into the mapping, which stays valid until the stream is
+// destroyed.
+//
+// Reading starts at the file descriptor's current offset. When the stream is
+// destroyed the offset is moved to the end of the data that was consumed.
+// If the file can't be mapped (for example a pipe, or on Windows), the
+// stream falls back to reading it like FileInputStream.
+class PROTOBUF_EXPORT MappedFileInputStream : public ZeroCopyInputStream {
+ public:
+  // If a block_size is given, it specifies the maximum number of bytes that
+  // should be returned with each call to Next().  Otherwise, a reasonable
+  // default is used.
+  explicit MappedFileInputStream(int file_descriptor, int block_size = -1);
+  ~MappedFileInputStream() override;
+
+  // Unmaps and closes the underlying file.  Returns false if an error occurs
+  // during the process; use GetErrno() to examine the error.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.
+  void SetCloseOnDelete(bool value);
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.
+  int GetErrno() const;
+
+  // True if the file is read through a memory mapping rather than read(2).
+  bool is_mapped() const { return data_ != nullptr; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Issues readahead and release hints around the current position.
+  void Advise();
+  // Unmaps the file and moves the file offset to the current position.
+  void Unmap();
+
+  const int file_;
+  const int block_size_;
+  bool close_on_delete_;
+  bool is_closed_;
+  int errno_;
+
+  // The mapping covers the whole file; position_ and the advice bounds are
+  // offsets into it.
+  const char* data_;
+  int64 size_;
+  int64 start_;
+  int64 position_;
+  int64 last_returned_size_;
+  int64 page_size_;
+  int64 advised_end_;
+  int64 released_end_;
+
+  // Used when the file could not be mapped.
+  std::unique_ptr<FileInputStream> fallback_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MappedFileInputStream);
+};
+
+// ===================================================================
+
 // A ZeroCopyOutputStream which writes to a file descriptor.
 //
 // FileOutputStream is preferred over using an ofstream with
@@ -199,6 +274,90 @@ class PROTOBUF_EXPORT FileOutputStream : public CopyingOutputStreamAdaptor {
 
 // ===================================================================
 
+// A ZeroCopyOutputStream which writes to a file descriptor, gathering many
+// buffers into each writev() call.
+//
+// FileOutputStream writes each buffer as soon as it is full, so a large
+// message costs one write() per block. This stream keeps the buffers it
+// hands out until flush_threshold bytes have accumulated, or until Flush()
+// is called, and then writes all of them with as few writev() calls as
+// possible. The buffers are pooled and reused after each flush.
+//
+// The stream supports aliasing: with EnableAliasing() on the
+// CodedOutputStream, large bytes and string fields are not copied but
+// queued as slices pointing at the caller's data. Such data must stay alive
+// and unchanged until the next Flush() call, Close() or the destruction of
+// the stream; note that Next() may flush on its own.
+class PROTOBUF_EXPORT GatheringFileOutputStream : public ZeroCopyOutputStream {
+ public:
+  // Creates a stream that writes to the given Unix file descriptor.
+  // block_size is the size of the buffers returned by Next(), and
+  // flush_threshold the number of bytes queued before they are written out.
+  // Reasonable defaults are used for values <= 0.
+  explicit GatheringFileOutputStream(int file_descriptor, int block_size = -1,
+                                     int flush_threshold = -1);
+  ~GatheringFileOutputStream() override;
+
+  // Writes out all queued data.  Returns false if an error occurs; use
+  // GetErrno() to examine the error.
+  bool Flush();
+
+  // Flushes and closes the underlying file.  Returns false if an error occurs
+  // during the process.  Even if an error occurs, the file descriptor is
+  // closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const { return errno_; }
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override { return position_; }
+  bool WriteAliasedRaw(const void* data, int size) override;
+  bool AllowsAliasing() const override { return true; }
+
+ private:
+  struct Slice {
+    const char* data;
+    int size;
+  };
+
+  // Queues size bytes at data, extending the last slice if they follow it.
+  void AppendSlice(const char* data, int size);
+  // Writes out slices_ and recycles the buffers.
+  bool WriteSlices();
+
+  const int file_;
+  const int block_size_;
+  const int flush_threshold_;
+  bool close_on_delete_;
+  bool is_closed_;
+  int errno_;
+
+  // Data queued for the next flush, in order.
+  std::vector<Slice> slices_;
+  int64 queued_bytes_;
+  int64 position_;
+  // Buffers referenced by slices_, and buffers free for reuse. The last
+  // element of used_blocks_ is the one Next() is filling.
+  std::vector<std::unique_ptr<char[]>> used_blocks_;
+  std::vector<std::unique_ptr<char[]>> free_blocks_;
+  int block_used_;
+  int last_returned_size_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(GatheringFileOutputStream);
+};
+
+// ===================================================================
+
 // A ZeroCopyInputStream which reads from a C++ istream.
 //
 // Note that for reading files (or anything represented by a file descriptor),
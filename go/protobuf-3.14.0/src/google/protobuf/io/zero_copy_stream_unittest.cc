@@ -61,6 +61,7 @@
 
 #include <google/protobuf/testing/file.h>
 #include <google/protobuf/test_util2.h>
+#include <google/protobuf/io/async_file_stream.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/io_win32.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
@@ -596,6 +597,38 @@ TEST_F(IoTest, CompressionOptions) {
   EXPECT_TRUE(Uncompress(zlib_compressed) == golden);
 }
 
+TEST_F(IoTest, CompressionDictionary) {
+  std::string data = "{name: \"sample\", id: 12345, tags: [\"a\", \"b\"]}";
+  std::string dictionary = "{name: \"example\", id: 0, tags: [\"\"]}";
+
+  GzipOutputStream::Options options;
+  options.format = GzipOutputStream::ZLIB;
+  std::string plain = Compress(data, options);
+  options.dictionary = dictionary;
+  std::string with_dictionary = Compress(data, options);
+  EXPECT_LT(with_dictionary.size(), plain.size());
+
+  {
+    ArrayInputStream input(with_dictionary.data(), with_dictionary.size());
+    GzipInputStream gzin(&input, GzipInputStream::ZLIB);
+    gzin.SetDictionary(dictionary);
+    ReadString(&gzin, data);
+    const void* buffer;
+    int size;
+    EXPECT_FALSE(gzin.Next(&buffer, &size));
+  }
+
+  // Without the dictionary, the data can't be decompressed.
+  {
+    ArrayInputStream input(with_dictionary.data(), with_dictionary.size());
+    GzipInputStream gzin(&input, GzipInputStream::ZLIB);
+    const void* buffer;
+    int size;
+    EXPECT_FALSE(gzin.Next(&buffer, &size));
+    EXPECT_EQ(Z_NEED_DICT, gzin.ZlibErrorCode());
+  }
+}
+
 TEST_F(IoTest, TwoSessionWriteGzip) {
   // Test that two concatenated gzip streams can be read correctly
 
@@ -759,6 +792,218 @@ TEST_F(IoTest, FileIo) {
   }
 }
 
+TEST_F(IoTest, MappedFileIo) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        FileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        MappedFileInputStream input(file, kBlockSizes[j]);
+#ifndef _WIN32
+        EXPECT_TRUE(input.is_mapped());
+#endif
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+#ifndef _WIN32
+TEST_F(IoTest, MappedFileStartsAtFileOffset) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+  int file =
+      open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+  std::string contents(100000, 'x');
+  contents.replace(0, 5, "hello");
+  {
+    FileOutputStream output(file);
+    WriteString(&output, contents);
+  }
+
+  ASSERT_NE(lseek(file, 5, SEEK_SET), (off_t)-1);
+  {
+    MappedFileInputStream input(file, 4096);
+    const void* data;
+    int size;
+    ASSERT_TRUE(input.Next(&data, &size));
+    EXPECT_EQ(4096, size);
+    EXPECT_EQ(contents.substr(5, 4096),
+              std::string(static_cast<const char*>(data), size));
+    input.BackUp(96);
+    EXPECT_TRUE(input.Skip(50000));
+    EXPECT_EQ(54000, input.ByteCount());
+  }
+  // The file offset now points just past the consumed data.
+  EXPECT_EQ(54005, lseek(file, 0, SEEK_CUR));
+  {
+    MappedFileInputStream input(file);
+    EXPECT_FALSE(input.Skip(100000));
+    EXPECT_EQ(100000 - 54005, input.ByteCount());
+  }
+  close(file);
+}
+#endif  // !_WIN32
+
+TEST_F(IoTest, GatheringFileIo) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+  const int kFlushThresholds[] = {-1, 1, 100};
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int t = 0; t < GOOGLE_ARRAYSIZE(kFlushThresholds); t++) {
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        GatheringFileOutputStream output(file, kBlockSizes[i],
+                                         kFlushThresholds[t]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        FileInputStream input(file);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, GatheringFileAliasedWrites) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+  int file =
+      open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+
+  std::string big(100000, 'b');
+  std::string expected;
+  {
+    GatheringFileOutputStream output(file, 256);
+    EXPECT_TRUE(output.AllowsAliasing());
+    for (int i = 0; i < 1000; i++) {
+      WriteString(&output, "head");
+      ASSERT_TRUE(output.WriteAliasedRaw(big.data(), i % 7 == 0 ? 1000 : 3));
+      expected += "head" + big.substr(0, i % 7 == 0 ? 1000 : 3);
+    }
+    WriteString(&output, "tail");
+    expected += "tail";
+    EXPECT_EQ(static_cast<int64>(expected.size()), output.ByteCount());
+    EXPECT_TRUE(output.Flush());
+  }
+
+  ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+  {
+    FileInputStream input(file);
+    ReadString(&input, expected);
+  }
+  close(file);
+}
+
+TEST_F(IoTest, AsyncFileIo) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+  const int kQueueDepths[] = {1, 3};
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      for (int d = 0; d < GOOGLE_ARRAYSIZE(kQueueDepths); d++) {
+        int file = open(filename.c_str(),
+                        O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+        ASSERT_GE(file, 0);
+
+        {
+          AsyncFileOutputStream output(file, kBlockSizes[i], kQueueDepths[d]);
+          WriteStuff(&output);
+          EXPECT_TRUE(output.Flush());
+          EXPECT_EQ(0, output.GetErrno());
+        }
+
+        ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+        {
+          AsyncFileInputStream input(file, kBlockSizes[j], kQueueDepths[d]);
+          ReadStuff(&input);
+          EXPECT_EQ(0, input.GetErrno());
+        }
+
+        close(file);
+      }
+    }
+  }
+}
+
+#ifndef _WIN32
+TEST_F(IoTest, AsyncFileReadError) {
+  // Reading from a directory fails.
+  int file = open(TestTempDir().c_str(), O_RDONLY);
+  ASSERT_GE(file, 0);
+  AsyncFileInputStream input(file);
+  const void* data;
+  int size;
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_NE(0, input.GetErrno());
+  close(file);
+}
+
+TEST_F(IoTest, AsyncFilePipeClose) {
+  // Nothing is ever written to the pipe, so the reader is blocked until the
+  // stream wakes it up.
+  int files[2];
+  ASSERT_EQ(pipe(files), 0);
+  {
+    AsyncFileInputStream input(files[0]);
+    EXPECT_TRUE(input.Close());
+  }
+  close(files[1]);
+
+  ASSERT_EQ(pipe(files), 0);
+  {
+    AsyncFileInputStream input(files[0]);
+  }
+  close(files[0]);
+  close(files[1]);
+}
+#endif  // !_WIN32
+
+TEST_F(IoTest, AsyncFileWriteError) {
+  std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
+  int file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY,
+                  0777);
+  ASSERT_GE(file, 0);
+  close(file);
+  file = open(filename.c_str(), O_RDONLY | O_BINARY);
+  ASSERT_GE(file, 0);
+
+  AsyncFileOutputStream output(file, 16);
+  WriteString(&output, "Hello world!\n");
+  EXPECT_FALSE(output.Flush());
+  EXPECT_EQ(EBADF, output.GetErrno());
+  void* data;
+  int size;
+  EXPECT_FALSE(output.Next(&data, &size));
+  close(file);
+}
+
 #if HAVE_ZLIB
 TEST_F(IoTest, GzipFileIo) {
   std::string filename = TestTempDir() + "/zero_copy_stream_test_file";
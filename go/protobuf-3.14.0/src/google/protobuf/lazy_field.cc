@@ -0,0 +1,231 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <google/protobuf/lazy_field.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/parse_context.h>
+#include <google/protobuf/stubs/logging.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+LazyField::~LazyField() {
+  if (arena_ == nullptr) {
+    delete unparsed_;
+    delete message_.load(std::memory_order_relaxed);
+  }
+}
+
+MessageLite* LazyField::Materialize(const MessageLite& prototype) const {
+  GOOGLE_DCHECK_EQ(state_, kUnparsed);
+  MessageLite* message = message_.load(std::memory_order_acquire);
+  if (message != nullptr) return message;
+  message = prototype.New(arena_);
+  if (!message->ParsePartialFromString(*unparsed_)) {
+    // The enclosing parse did not look at these bytes, so this is the only
+    // place the error can be reported.
+    GOOGLE_LOG(ERROR) << "Can't parse lazy field of type \""
+                      << prototype.GetTypeName()
+                      << "\": the recorded bytes are malformed.";
+  }
+  MessageLite* expected = nullptr;
+  if (!message_.compare_exchange_strong(expected, message,
+                                        std::memory_order_acq_rel)) {
+    // Another reader got there first.
+    if (arena_ == nullptr) delete message;
+    message = expected;
+  }
+  return message;
+}
+
+void LazyField::DiscardMessage() {
+  MessageLite* message = message_.load(std::memory_order_relaxed);
+  if (message == nullptr) return;
+  if (arena_ == nullptr) delete message;
+  message_.store(nullptr, std::memory_order_relaxed);
+}
+
+std::string* LazyField::MutableUnparsed() {
+  // Any parsed copy is out of date once more bytes are recorded.
+  DiscardMessage();
+  if (unparsed_ == nullptr) {
+    unparsed_ = Arena::Create<std::string>(arena_);
+  } else if (state_ != kUnparsed) {
+    unparsed_->clear();
+  }
+  state_ = kUnparsed;
+  return unparsed_;
+}
+
+const MessageLite& LazyField::GetMessage(const MessageLite& prototype) const {
+  switch (state_) {
+    case kCleared:
+      return prototype;
+    case kUnparsed:
+      return *Materialize(prototype);
+    case kParsed:
+      break;
+  }
+  return *message_.load(std::memory_order_relaxed);
+}
+
+MessageLite* LazyField::MutableMessage(const MessageLite& prototype) {
+  MessageLite* message;
+  if (state_ == kUnparsed) {
+    message = Materialize(prototype);
+  } else {
+    // A cleared field may still hold an empty message for reuse.
+    message = message_.load(std::memory_order_relaxed);
+    if (message == nullptr) {
+      message = prototype.New(arena_);
+      message_.store(message, std::memory_order_relaxed);
+    }
+  }
+  state_ = kParsed;
+  return message;
+}
+
+void LazyField::SetAllocatedMessage(MessageLite* message) {
+  UnsafeArenaSetAllocatedMessage(message);
+}
+
+void LazyField::UnsafeArenaSetAllocatedMessage(MessageLite* message) {
+  DiscardMessage();
+  message_.store(message, std::memory_order_relaxed);
+  state_ = message != nullptr ? kParsed : kCleared;
+}
+
+MessageLite* LazyField::ReleaseMessage(const MessageLite& prototype) {
+  MessageLite* message = UnsafeArenaReleaseMessage(prototype);
+  if (arena_ != nullptr && message != nullptr) {
+    MessageLite* copy = message->New();
+    copy->CheckTypeAndMergeFrom(*message);
+    message = copy;
+  }
+  return message;
+}
+
+MessageLite* LazyField::UnsafeArenaReleaseMessage(
+    const MessageLite& prototype) {
+  if (state_ == kCleared) return nullptr;
+  MessageLite* message = state_ == kUnparsed
+                             ? Materialize(prototype)
+                             : message_.load(std::memory_order_relaxed);
+  message_.store(nullptr, std::memory_order_relaxed);
+  state_ = kCleared;
+  return message;
+}
+
+void LazyField::Clear() {
+  MessageLite* message = message_.load(std::memory_order_relaxed);
+  if (message != nullptr) message->Clear();
+  state_ = kCleared;
+}
+
+void LazyField::MergeFrom(const MessageLite& prototype,
+                          const LazyField& other) {
+  GOOGLE_DCHECK_NE(&other, this);
+  switch (other.state_) {
+    case kCleared:
+      MutableMessage(prototype);
+      break;
+    case kUnparsed:
+      if (state_ != kParsed) {
+        // Concatenating serialized messages merges them.
+        MutableUnparsed()->append(*other.unparsed_);
+      } else {
+        MutableMessage(prototype)->CheckTypeAndMergeFrom(
+            other.GetMessage(prototype));
+      }
+      break;
+    case kParsed:
+      MutableMessage(prototype)->CheckTypeAndMergeFrom(
+          *other.message_.load(std::memory_order_relaxed));
+      break;
+  }
+}
+
+void LazyField::Swap(LazyField* other) {
+  GOOGLE_DCHECK_EQ(arena_, other->arena_);
+  std::swap(unparsed_, other->unparsed_);
+  MessageLite* message = message_.load(std::memory_order_relaxed);
+  message_.store(other->message_.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  other->message_.store(message, std::memory_order_relaxed);
+  std::swap(state_, other->state_);
+}
+
+size_t LazyField::ByteSizeLong() const {
+  switch (state_) {
+    case kCleared:
+      return 0;
+    case kUnparsed:
+      return unparsed_->size();
+    case kParsed:
+      break;
+  }
+  return message_.load(std::memory_order_relaxed)->ByteSizeLong();
+}
+
+uint8* LazyField::InternalSerialize(int number, uint8* target,
+                                    io::EpsCopyOutputStream* stream) const {
+  target = stream->EnsureSpace(target);
+  switch (state_) {
+    case kCleared:
+      target = WireFormatLite::WriteTagToArray(
+          number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+      *target++ = 0;
+      return target;
+    case kUnparsed:
+      return stream->WriteString(number, *unparsed_, target);
+    case kParsed:
+      break;
+  }
+  return WireFormatLite::InternalWriteMessage(
+      number, *message_.load(std::memory_order_relaxed), target, stream);
+}
+
+const char* LazyField::_InternalParse(const char* ptr, ParseContext* ctx) {
+  if (state_ == kParsed) {
+    // Already materialized and possibly modified; merge into it directly.
+    return message_.load(std::memory_order_relaxed)->_InternalParse(ptr, ctx);
+  }
+  return ctx->AppendString(ptr, MutableUnparsed());
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
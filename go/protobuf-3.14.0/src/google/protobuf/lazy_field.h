@@ -0,0 +1,144 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef GOOGLE_PROTOBUF_LAZY_FIELD_H__
+#define GOOGLE_PROTOBUF_LAZY_FIELD_H__
+
+#include <atomic>
+#include <string>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/message_lite.h>
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+#include <google/protobuf/port_def.inc>
+
+// This file is logically internal-only and should only be used by protobuf
+// generated code.
+
+namespace google {
+namespace protobuf {
+namespace io {
+class EpsCopyOutputStream;
+}  // namespace io
+namespace internal {
+
+class ParseContext;
+
+// Storage for a singular message field marked [lazy = true].
+//
+// At parse time the field only records the serialized bytes of the
+// sub-message. The message is parsed on first access through GetMessage() or
+// MutableMessage(). Until the field is mutated, serialization writes the
+// recorded bytes back out unchanged, so a message that is parsed and
+// re-serialized without touching the field never parses it at all.
+//
+// Errors in the recorded bytes are not reported by the enclosing parse; they
+// are logged on first access, and the sub-message holds whatever could be
+// parsed.
+//
+// Const accessors are safe to call concurrently: concurrent first accesses
+// may each parse the bytes, and all but one of the results are discarded.
+//
+// Only used by lite messages; full messages would also need reflection
+// support.
+class PROTOBUF_EXPORT LazyField {
+ public:
+  LazyField() : LazyField(nullptr) {}
+  explicit LazyField(Arena* arena)
+      : arena_(arena),
+        unparsed_(nullptr),
+        message_(nullptr),
+        state_(kCleared) {}
+  ~LazyField();
+
+  // True if the field holds neither recorded bytes nor a message.
+  bool IsCleared() const { return state_ == kCleared; }
+
+  // Returns the message, parsing the recorded bytes if needed. Returns
+  // `prototype` if the field is cleared.
+  const MessageLite& GetMessage(const MessageLite& prototype) const;
+  // Returns the message, parsing the recorded bytes or creating an empty
+  // message if needed. The recorded bytes are discarded.
+  MessageLite* MutableMessage(const MessageLite& prototype);
+
+  // Takes ownership of `message`, which must be on the same arena as the
+  // field. Passing nullptr clears the field.
+  void SetAllocatedMessage(MessageLite* message);
+  void UnsafeArenaSetAllocatedMessage(MessageLite* message);
+  // Returns the message and clears the field. Returns nullptr if the field
+  // was cleared. ReleaseMessage() always returns a heap-allocated message.
+  MessageLite* ReleaseMessage(const MessageLite& prototype);
+  MessageLite* UnsafeArenaReleaseMessage(const MessageLite& prototype);
+
+  void Clear();
+  void MergeFrom(const MessageLite& prototype, const LazyField& other);
+  // Both fields must be on the same arena.
+  void Swap(LazyField* other);
+
+  // Size of the sub-message payload, excluding tag and length prefix.
+  size_t ByteSizeLong() const;
+  uint8* InternalSerialize(int number, uint8* target,
+                           io::EpsCopyOutputStream* stream) const;
+
+  // Called by ParseContext::ParseMessage() with a limit pushed for the
+  // sub-message.
+  const char* _InternalParse(const char* ptr, ParseContext* ctx);
+
+ private:
+  enum State : uint8 {
+    kCleared,  // Nothing is set.
+    kUnparsed,  // unparsed_ holds the value; message_, if set, is a copy.
+    kParsed,  // message_ holds the value.
+  };
+
+  MessageLite* Materialize(const MessageLite& prototype) const;
+  void DiscardMessage();
+  std::string* MutableUnparsed();
+
+  Arena* const arena_;
+  std::string* unparsed_;
+  mutable std::atomic<MessageLite*> message_;
+  State state_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(LazyField);
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_LAZY_FIELD_H__
@@ -1268,5 +1268,92 @@ TEST(Lite, CodedInputStreamRollback) {
   }
 }
 
+TEST(Lite, SerializeSinglePass) {
+  protobuf_unittest::TestPackedTypesLite packed;
+  TestUtilLite::SetPackedFields(&packed);
+  std::string output;
+  EXPECT_TRUE(packed.SerializeSinglePassToString(&output));
+  EXPECT_EQ(packed.SerializeAsString(), output);
+
+  protobuf_unittest::TestAllTypesLite message;
+  TestUtilLite::SetAllFields(&message);
+  EXPECT_TRUE(message.SerializeSinglePassToString(&output));
+  EXPECT_EQ(message.SerializeAsString(), output);
+
+  // Unknown fields are kept as bytes in lite messages.
+  protobuf_unittest::TestEmptyMessageLite empty;
+  ASSERT_TRUE(empty.ParseFromString(message.SerializeAsString()));
+  EXPECT_TRUE(empty.SerializeSinglePassToString(&output));
+  EXPECT_EQ(message.SerializeAsString(), output);
+}
+
+TEST(Lite, PackedVarintReservesOnce) {
+  protobuf_unittest::TestPackedTypesLite message;
+  for (int i = 0; i < 100; i++) {
+    message.add_packed_int32(i * 1000 - 5000);
+    message.add_packed_enum(i % 2 ? protobuf_unittest::FOREIGN_LITE_BAR
+                                  : protobuf_unittest::FOREIGN_LITE_BAZ);
+  }
+  protobuf_unittest::TestPackedTypesLite parsed;
+  ASSERT_TRUE(parsed.ParseFromString(message.SerializeAsString()));
+  EXPECT_EQ(100, parsed.packed_int32_size());
+  EXPECT_EQ(100, parsed.packed_int32().Capacity());
+  EXPECT_EQ(100, parsed.packed_enum().Capacity());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(i * 1000 - 5000, parsed.packed_int32(i));
+  }
+}
+
+TEST(Lite, LazyMessageKeepsSerializedBytes) {
+  // optional_lazy_message { bb: 1 }, with bb encoded as a non-minimal varint
+  // that a parse and re-serialize cycle would normalize.
+  const std::string serialized("\xda\x01\x03\x08\x81\x00", 6);
+  const std::string normalized("\xda\x01\x02\x08\x02", 5);
+
+  for (bool use_arena : {false, true}) {
+    Arena arena;
+    auto* message = Arena::CreateMessage<protobuf_unittest::TestAllTypesLite>(
+        use_arena ? &arena : nullptr);
+    ASSERT_TRUE(message->ParseFromString(serialized));
+    EXPECT_TRUE(message->has_optional_lazy_message());
+    EXPECT_EQ(serialized, message->SerializeAsString());
+
+    // Reading the field parses it but keeps the recorded bytes.
+    EXPECT_EQ(1, message->optional_lazy_message().bb());
+    EXPECT_EQ(serialized, message->SerializeAsString());
+
+    protobuf_unittest::TestAllTypesLite copy(*message);
+    EXPECT_EQ(serialized, copy.SerializeAsString());
+
+    message->mutable_optional_lazy_message()->set_bb(2);
+    EXPECT_EQ(normalized, message->SerializeAsString());
+
+    message->clear_optional_lazy_message();
+    EXPECT_FALSE(message->has_optional_lazy_message());
+    EXPECT_EQ(0, message->optional_lazy_message().bb());
+    if (!use_arena) delete message;
+  }
+}
+
+TEST(Lite, LazyMessageMerge) {
+  protobuf_unittest::TestAllTypesLite message1, message2;
+  message1.mutable_optional_lazy_message()->set_bb(1);
+  message2.mutable_optional_lazy_message()->set_bb(2);
+
+  protobuf_unittest::TestAllTypesLite lazy1, lazy2;
+  ASSERT_TRUE(lazy1.ParseFromString(message1.SerializeAsString()));
+  ASSERT_TRUE(lazy2.ParseFromString(message2.SerializeAsString()));
+  lazy1.MergeFrom(lazy2);
+  EXPECT_EQ(2, lazy1.optional_lazy_message().bb());
+
+  message1.MergeFrom(lazy2);
+  EXPECT_EQ(2, message1.optional_lazy_message().bb());
+
+  protobuf_unittest::TestAllTypesLite empty;
+  empty.MergeFrom(lazy2);
+  EXPECT_TRUE(empty.has_optional_lazy_message());
+  EXPECT_EQ(2, empty.optional_lazy_message().bb());
+}
+
 }  // namespace protobuf
 }  // namespace google
@@ -37,6 +37,8 @@
 #ifndef GOOGLE_PROTOBUF_MAP_H__
 #define GOOGLE_PROTOBUF_MAP_H__
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
@@ -45,6 +47,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #if defined(__cpp_lib_string_view)
 #include <string_view>
@@ -55,6 +58,7 @@
 #include <google/protobuf/generated_enum_util.h>
 #include <google/protobuf/map_type_handler.h>
 #include <google/protobuf/stubs/hash.h>
+#include <google/protobuf/stubs/mutex.h>
 
 #ifdef SWIG
 #error "You cannot SWIG proto headers"
@@ -324,6 +328,60 @@ size_t SpaceUsedInValues(const Map* map) {
 
 inline size_t SpaceUsedInValues(const void*) { return 0; }
 
+// The elements of a Map in key order, kept by Map::EnableSortedKeyCache().
+// Mutations clear valid; the first deterministic serialization afterwards
+// rebuilds items under mu.
+template <typename ConstPtr>
+struct MapSortedKeyCache {
+  MapSortedKeyCache() : valid(false) {}
+
+  WrappedMutex mu;
+  std::atomic<bool> valid;
+  std::vector<ConstPtr> items;
+};
+
+#if defined(GOOGLE_PROTOBUF_FLAT_HASH_MAP)
+// Control bytes of the open-addressing table. A full slot holds seven bits of
+// its key's hash; empty and deleted slots have the high bit set.
+constexpr uint8 kFlatMapEmpty = 0x80;
+constexpr uint8 kFlatMapDeleted = 0xFE;
+constexpr size_t kFlatMapGroupWidth = 8;
+
+inline bool FlatMapIsFull(uint8 ctrl) { return ctrl < 0x80; }
+
+// A group of kFlatMapGroupWidth control bytes, matched all at once.  Each
+// Match function returns a mask with the high bit of every matching byte set.
+class FlatMapGroup {
+ public:
+  // Loads the bytes in little-endian order, which compilers turn into a
+  // single load where possible.
+  explicit FlatMapGroup(const uint8* ctrl) : ctrl_(0) {
+    for (size_t i = 0; i < kFlatMapGroupWidth; i++) {
+      ctrl_ |= static_cast<uint64>(ctrl[i]) << (i * 8);
+    }
+  }
+
+  // May report a false positive for a full byte just above a real match, but
+  // never for an empty or deleted byte.  Callers compare the keys anyway.
+  uint64 Match(uint8 tag) const {
+    constexpr uint64 kLsbs = uint64{0x0101010101010101};
+    const uint64 x = ctrl_ ^ (kLsbs * tag);
+    return (x - kLsbs) & ~x & kMsbs;
+  }
+  uint64 MatchEmpty() const { return ctrl_ & (~ctrl_ << 6) & kMsbs; }
+  uint64 MatchEmptyOrDeleted() const { return ctrl_ & (~ctrl_ << 7) & kMsbs; }
+
+  // Returns the index of the lowest matching byte in a non-zero mask.
+  static size_t LowestMatch(uint64 mask) {
+    return Bits::Log2FloorNonZero64(mask & (~mask + 1)) >> 3;
+  }
+
+ private:
+  static constexpr uint64 kMsbs = uint64{0x8080808080808080};
+  uint64 ctrl_;
+};
+#endif  // GOOGLE_PROTOBUF_FLAT_HASH_MAP
+
 }  // namespace internal
 
 // This is the class for Map's internal value_type. Instead of using
@@ -367,6 +425,13 @@ struct MapPair {
 //
 // Map's interface is similar to std::unordered_map, except that Map is not
 // designed to play well with exceptions.
+//
+// Defining GOOGLE_PROTOBUF_FLAT_HASH_MAP switches Map to an open-addressing
+// table that stores elements inline (see the first InnerMap below).  Inserting
+// into such a map may invalidate iterators, pointers and references to its
+// elements.  The macro changes the layout of Map, so it must be defined for
+// the protobuf library and all code using it alike; configure
+// --enable-flat-hash-map and -Dprotobuf_WITH_FLAT_HASH_MAP=ON do that.
 template <typename Key, typename T>
 class Map {
  public:
@@ -382,10 +447,13 @@ class Map {
   using size_type = size_t;
   using hasher = typename internal::TransparentSupport<Key>::hash;
 
-  constexpr Map() : elements_(nullptr) {}
-  explicit Map(Arena* arena) : elements_(arena) {}
+  constexpr Map() : elements_(nullptr), sorted_cache_(nullptr) {}
+  explicit Map(Arena* arena) : elements_(arena), sorted_cache_(nullptr) {}
 
-  Map(const Map& other) : Map() { insert(other.begin(), other.end()); }
+  Map(const Map& other) : Map() {
+    Presize(other.size());
+    insert(other.begin(), other.end());
+  }
 
   Map(Map&& other) noexcept : Map() {
     if (other.arena() != nullptr) {
@@ -411,11 +479,396 @@ class Map {
     insert(first, last);
   }
 
-  ~Map() {}
+  ~Map() {
+    if (arena() == nullptr) delete sorted_cache_;
+  }
 
  private:
   using Allocator = internal::MapAllocator<void*>;
 
+#if defined(GOOGLE_PROTOBUF_FLAT_HASH_MAP)
+  // InnerMap is a generic hash-based map.  This variant is an open-addressing
+  // table in the style of Swiss tables: key-value pairs live inline in a slot
+  // array, next to an array of one-byte control words that hold seven bits of
+  // each slot's hash.  A lookup compares a group of eight control bytes at a
+  // time and only touches the slots whose tag matches, so it usually costs one
+  // or two cache misses, and inserts don't allocate a node per element.
+  // Some implementation details:
+  // 1. The number of slots is a power of two and a multiple of the group
+  //    width.  Groups are probed triangularly, which visits every group.
+  // 2. The table grows when full and deleted slots together reach 7/8 of the
+  //    capacity; it is rebuilt at the same size instead when most of those
+  //    are deleted.  It never shrinks.
+  // 3. Erasing marks the slot as deleted and moves nothing, so iterators to
+  //    other elements stay valid.  Inserting may rebuild the table, which
+  //    moves every element and invalidates all iterators, pointers and
+  //    references into the map.
+  // 4. Moving an element constructs it afresh in the new slot and swaps the
+  //    value into it, so arena-allocated values keep their arena.
+  class InnerMap : private hasher {
+   public:
+    explicit constexpr InnerMap(Arena* arena)
+        : hasher(),
+          num_elements_(0),
+          num_deleted_(0),
+          capacity_(0),
+          seed_(0),
+          ctrl_(nullptr),
+          slots_(nullptr),
+          alloc_(arena) {}
+
+    ~InnerMap() {
+      if (alloc_.arena() == nullptr && capacity_ != 0) {
+        clear();
+        Dealloc<uint8>(ctrl_, capacity_);
+        Dealloc<value_type>(slots_, capacity_);
+      }
+    }
+
+   private:
+    enum { kMinTableSize = internal::kFlatMapGroupWidth };
+
+    // iterator and const_iterator are instantiations of iterator_base.  An
+    // iterator is the index of a full slot, or has a null m_ at the end.
+    template <typename KeyValueType>
+    class iterator_base {
+     public:
+      using reference = KeyValueType&;
+      using pointer = KeyValueType*;
+
+      iterator_base() : m_(nullptr), index_(0) {}
+
+      explicit iterator_base(const InnerMap* m) : m_(m) { SearchFrom(0); }
+
+      // Any iterator_base can convert to any other.  This is overkill, and we
+      // rely on the enclosing class to use it wisely.
+      template <typename U>
+      explicit iterator_base(const iterator_base<U>& it)
+          : m_(it.m_), index_(it.index_) {}
+
+      iterator_base(const InnerMap* m, size_type index)
+          : m_(m), index_(index) {}
+
+      // Advance to the first full slot at or after start.  If there is none
+      // then become end().
+      void SearchFrom(size_type start) {
+        for (index_ = start; index_ < m_->capacity_; index_++) {
+          if (internal::FlatMapIsFull(m_->ctrl_[index_])) return;
+        }
+        m_ = nullptr;
+        index_ = 0;
+      }
+
+      reference operator*() const { return *m_->SlotAt(index_); }
+      pointer operator->() const { return &(operator*()); }
+
+      friend bool operator==(const iterator_base& a, const iterator_base& b) {
+        return a.m_ == b.m_ && a.index_ == b.index_;
+      }
+      friend bool operator!=(const iterator_base& a, const iterator_base& b) {
+        return !(a == b);
+      }
+
+      iterator_base& operator++() {
+        SearchFrom(index_ + 1);
+        return *this;
+      }
+
+      iterator_base operator++(int /* unused */) {
+        iterator_base tmp = *this;
+        ++*this;
+        return tmp;
+      }
+
+      const InnerMap* m_;
+      size_type index_;
+    };
+
+   public:
+    using iterator = iterator_base<value_type>;
+    using const_iterator = iterator_base<const value_type>;
+
+    Arena* arena() const { return alloc_.arena(); }
+
+    void Swap(InnerMap* other) {
+      std::swap(num_elements_, other->num_elements_);
+      std::swap(num_deleted_, other->num_deleted_);
+      std::swap(capacity_, other->capacity_);
+      std::swap(seed_, other->seed_);
+      std::swap(ctrl_, other->ctrl_);
+      std::swap(slots_, other->slots_);
+      std::swap(alloc_, other->alloc_);
+    }
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(this); }
+    const_iterator end() const { return const_iterator(); }
+
+    void clear() {
+      for (size_type i = 0; i < capacity_; i++) {
+        if (internal::FlatMapIsFull(ctrl_[i])) DestroySlot(i);
+      }
+      if (capacity_ != 0) memset(ctrl_, internal::kFlatMapEmpty, capacity_);
+      num_elements_ = 0;
+      num_deleted_ = 0;
+    }
+
+    const hasher& hash_function() const { return *this; }
+
+    static size_type max_size() {
+      return static_cast<size_type>(1) << (sizeof(void**) >= 8 ? 60 : 28);
+    }
+    size_type size() const { return num_elements_; }
+    bool empty() const { return size() == 0; }
+
+    template <typename K>
+    iterator find(const K& k) {
+      return iterator(FindHelper(k).first);
+    }
+
+    template <typename K>
+    const_iterator find(const K& k) const {
+      return FindHelper(k).first;
+    }
+
+    // Insert the key into the map, if not present. In that case, the value will
+    // be value initialized.
+    template <typename K>
+    std::pair<iterator, bool> insert(K&& k) {
+      std::pair<const_iterator, size_type> p = FindHelper(k);
+      // Case 1: key was already present.
+      if (p.first.m_ != nullptr) {
+        return std::make_pair(iterator(p.first), false);
+      }
+      // Case 2: insert.  Reusing a deleted slot keeps the load unchanged.
+      uint64 h = Hash(k);
+      size_type i = p.second;
+      if (capacity_ == 0 || ctrl_[i] != internal::kFlatMapDeleted) {
+        if (PROTOBUF_PREDICT_FALSE(num_elements_ + num_deleted_ + 1 >
+                                   GrowthLimit())) {
+          // The first table picks the seed, which changes the hash.
+          Resize(NextCapacity());
+          h = Hash(k);
+          i = FindFirstNonFull(h);
+        }
+      }
+      if (ctrl_[i] == internal::kFlatMapDeleted) --num_deleted_;
+      ctrl_[i] = H2(h);
+      value_type* kv = SlotAt(i);
+      // If K is not key_type, make the conversion to key_type explicit.
+      using TypeToInit = typename std::conditional<
+          std::is_same<typename std::decay<K>::type, key_type>::value, K&&,
+          key_type>::type;
+      if (alloc_.arena() == nullptr) {
+        new (kv) value_type(static_cast<TypeToInit>(std::forward<K>(k)));
+      } else {
+        Arena::CreateInArenaStorage(
+            const_cast<Key*>(&kv->first), alloc_.arena(),
+            static_cast<TypeToInit>(std::forward<K>(k)));
+        Arena::CreateInArenaStorage(&kv->second, alloc_.arena());
+      }
+      ++num_elements_;
+      return std::make_pair(iterator(this, i), true);
+    }
+
+    template <typename K>
+    value_type& operator[](K&& k) {
+      return *insert(std::forward<K>(k)).first;
+    }
+
+    // Grows the table so that n elements fit without another rehash.
+    void reserve(size_type n) {
+      if (n == 0) return;
+      size_type new_capacity = kMinTableSize;
+      while (new_capacity - new_capacity / 8 < n) new_capacity *= 2;
+      if (new_capacity > capacity_) Resize(new_capacity);
+    }
+
+    // This table never shrinks, so this is just reserve().
+    void Presize(size_type n) { reserve(n); }
+
+    void erase(iterator it) {
+      GOOGLE_DCHECK_EQ(it.m_, this);
+      GOOGLE_DCHECK(internal::FlatMapIsFull(ctrl_[it.index_]));
+      DestroySlot(it.index_);
+      ctrl_[it.index_] = internal::kFlatMapDeleted;
+      --num_elements_;
+      ++num_deleted_;
+    }
+
+    size_t SpaceUsedInternal() const {
+      return capacity_ * (sizeof(value_type) + sizeof(ctrl_[0]));
+    }
+
+   private:
+    // Returns the slot holding k, or end(), together with the first slot in
+    // k's probe sequence that a new element could take.
+    template <typename K>
+    std::pair<const_iterator, size_type> FindHelper(const K& k) const {
+      if (capacity_ == 0) return std::make_pair(end(), size_type{0});
+      const uint64 h = Hash(k);
+      const uint8 tag = H2(h);
+      size_type group = H1(h);
+      size_type insert_at = capacity_;
+      for (size_type step = 1;; step++) {
+        const size_type base = group * kMinTableSize;
+        internal::FlatMapGroup g(ctrl_ + base);
+        for (uint64 match = g.Match(tag); match != 0; match &= match - 1) {
+          const size_type i = base + internal::FlatMapGroup::LowestMatch(match);
+          if (internal::TransparentSupport<Key>::Equals(SlotAt(i)->first, k)) {
+            return std::make_pair(const_iterator(this, i), i);
+          }
+        }
+        if (insert_at == capacity_) {
+          const uint64 free = g.MatchEmptyOrDeleted();
+          if (free != 0) insert_at = base + PickFreeSlot(free, h);
+        }
+        // Load is kept below 7/8, so some group has an empty slot and
+        // triangular probing reaches it.
+        if (g.MatchEmpty() != 0) return std::make_pair(end(), insert_at);
+        group = (group + step) & (NumGroups() - 1);
+      }
+    }
+
+    size_type FindFirstNonFull(uint64 h) const {
+      size_type group = H1(h);
+      for (size_type step = 1;; step++) {
+        const uint64 free =
+            internal::FlatMapGroup(ctrl_ + group * kMinTableSize)
+                .MatchEmptyOrDeleted();
+        if (free != 0) return group * kMinTableSize + PickFreeSlot(free, h);
+        group = (group + step) & (NumGroups() - 1);
+      }
+    }
+
+    // Picks a free slot in a group, starting at a hash-dependent offset so
+    // that the iteration order of small maps stays random.
+    static size_type PickFreeSlot(uint64 free, uint64 h) {
+      const uint64 rotated = free & (~uint64{0} << ((h >> 61) * 8));
+      return internal::FlatMapGroup::LowestMatch(rotated != 0 ? rotated
+                                                              : free);
+    }
+
+    size_type GrowthLimit() const { return capacity_ - capacity_ / 8; }
+
+    // Doubles the table, unless rebuilding it at the same size frees enough
+    // deleted slots.
+    size_type NextCapacity() const {
+      if (capacity_ == 0) return kMinTableSize;
+      if (num_elements_ + 1 <= GrowthLimit() / 2) return capacity_;
+      GOOGLE_DCHECK_LE(capacity_, max_size() / 2);
+      return capacity_ * 2;
+    }
+
+    void Resize(size_type new_capacity) {
+      uint8* const old_ctrl = ctrl_;
+      value_type* const old_slots = slots_;
+      const size_type old_capacity = capacity_;
+      capacity_ = new_capacity;
+      ctrl_ = Alloc<uint8>(capacity_);
+      memset(ctrl_, internal::kFlatMapEmpty, capacity_);
+      slots_ = Alloc<value_type>(capacity_);
+      if (alloc_.arena() == nullptr) {
+        internal::ParseBudgetCharge(capacity_ * (1 + sizeof(value_type)));
+      }
+      num_deleted_ = 0;
+      if (old_capacity == 0) {
+        seed_ = Seed();
+        return;
+      }
+      for (size_type i = 0; i < old_capacity; i++) {
+        if (!internal::FlatMapIsFull(old_ctrl[i])) continue;
+        value_type* from = &old_slots[i];
+        const uint64 h = Hash(from->first);
+        const size_type j = FindFirstNonFull(h);
+        ctrl_[j] = H2(h);
+        TransferSlot(from, SlotAt(j));
+      }
+      Dealloc<uint8>(old_ctrl, old_capacity);
+      Dealloc<value_type>(old_slots, old_capacity);
+    }
+
+    // Moves *from into the unconstructed slot to.  Arena-allocated messages
+    // can't be moved out of their object, so the value is swapped into a
+    // freshly constructed one instead.
+    void TransferSlot(value_type* from, value_type* to) {
+      Key& key = const_cast<Key&>(from->first);
+      if (alloc_.arena() == nullptr) {
+        new (to) value_type(std::move(key));
+      } else {
+        Arena::CreateInArenaStorage(const_cast<Key*>(&to->first),
+                                    alloc_.arena(), std::move(key));
+        Arena::CreateInArenaStorage(&to->second, alloc_.arena());
+      }
+      using std::swap;
+      swap(to->second, from->second);
+      if (alloc_.arena() == nullptr) from->~value_type();
+    }
+
+    void DestroySlot(size_type i) {
+      if (alloc_.arena() == nullptr) SlotAt(i)->~value_type();
+    }
+
+    value_type* SlotAt(size_type i) const { return &slots_[i]; }
+
+    size_type NumGroups() const { return capacity_ / kMinTableSize; }
+
+    // We xor the hash value against the random seed so that we effectively
+    // have a random hash function, and mix it with the multiplication method;
+    // see BucketNumber() in the chaining InnerMap.  The well-mixed high half
+    // picks the group and the seven bits below it form the tag.
+    template <typename K>
+    uint64 Hash(const K& k) const {
+      constexpr uint64 kPhi = uint64{0x9e3779b97f4a7c15};
+      return kPhi * (hash_function()(k) ^ seed_);
+    }
+    size_type H1(uint64 h) const {
+      return static_cast<size_type>(h >> 32) & (NumGroups() - 1);
+    }
+    static uint8 H2(uint64 h) { return static_cast<uint8>((h >> 25) & 0x7F); }
+
+    // Use alloc_ to allocate an array of n objects of type U.
+    template <typename U>
+    U* Alloc(size_type n) {
+      using alloc_type = typename Allocator::template rebind<U>::other;
+      return alloc_type(alloc_).allocate(n);
+    }
+
+    // Use alloc_ to deallocate an array of n objects of type U.
+    template <typename U>
+    void Dealloc(U* t, size_type n) {
+      using alloc_type = typename Allocator::template rebind<U>::other;
+      alloc_type(alloc_).deallocate(t, n);
+    }
+
+    // Return a randomish value.
+    size_type Seed() const {
+      size_type s = reinterpret_cast<uintptr_t>(this) >> 12;
+#if defined(__x86_64__) && defined(__GNUC__) && \
+    !defined(GOOGLE_PROTOBUF_NO_RDTSC)
+      uint32 hi, lo;
+      asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+      s += ((static_cast<uint64>(hi) << 32) | lo);
+#endif
+      return s;
+    }
+
+    friend class Arena;
+    using InternalArenaConstructable_ = void;
+    using DestructorSkippable_ = void;
+
+    size_type num_elements_;
+    size_type num_deleted_;
+    size_type capacity_;  // number of slots, a multiple of kMinTableSize
+    size_type seed_;
+    uint8* ctrl_;  // an array with capacity_ control bytes
+    // An array with capacity_ slots; only the full ones are constructed.
+    value_type* slots_;
+    Allocator alloc_;
+    GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(InnerMap);
+  };  // end of class InnerMap
+#else   // GOOGLE_PROTOBUF_FLAT_HASH_MAP
   // InnerMap is a generic hash-based map.  It doesn't contain any
   // protocol-buffer-specific logic.  It is a chaining hash map with the
   // additional feature that some buckets can be converted to use an ordered
@@ -454,6 +907,7 @@ class Map {
         : hasher(),
           num_elements_(0),
           num_buckets_(internal::kGlobalEmptyTableSize),
+          min_num_buckets_(kMinTableSize),
           seed_(0),
           index_of_first_non_null_(internal::kGlobalEmptyTableSize),
           table_(const_cast<void**>(internal::kGlobalEmptyTable)),
@@ -468,7 +922,10 @@ class Map {
     }
 
    private:
-    enum { kMinTableSize = 8 };
+    enum {
+      kMinTableSize = 8,
+      kMaxMapLoadTimes16 = 12  // controls RAM vs CPU tradeoff
+    };
 
     // Linked-list nodes, as one would expect for a chaining hash table.
     struct Node {
@@ -625,6 +1082,7 @@ class Map {
     void Swap(InnerMap* other) {
       std::swap(num_elements_, other->num_elements_);
       std::swap(num_buckets_, other->num_buckets_);
+      std::swap(min_num_buckets_, other->min_num_buckets_);
       std::swap(seed_, other->seed_);
       std::swap(index_of_first_non_null_, other->index_of_first_non_null_);
       std::swap(table_, other->table_);
@@ -724,6 +1182,25 @@ class Map {
       return *insert(std::forward<K>(k)).first;
     }
 
+    // Grows the table so that n elements fit without another resize.  The
+    // table won't shrink below that size afterwards.
+    void reserve(size_type n) {
+      if (n == 0) return;
+      min_num_buckets_ = (std::max)(min_num_buckets_, BucketsFor(n));
+      Presize(n);
+    }
+
+    // Like reserve(), but erasing elements may shrink the table again.  For
+    // copies, where n is only the size of the source.
+    void Presize(size_type n) {
+      if (n == 0) return;
+      size_type new_num_buckets = BucketsFor(n);
+      if (new_num_buckets > num_buckets_ ||
+          num_buckets_ == internal::kGlobalEmptyTableSize) {
+        Resize(new_num_buckets);
+      }
+    }
+
     void erase(iterator it) {
       GOOGLE_DCHECK_EQ(it.m_, this);
       typename Tree::iterator tree_it;
@@ -881,7 +1358,6 @@ class Map {
     // policy that sometimes we resize down as well as up, clients can easily
     // keep O(size()) = O(number of buckets) if they want that.
     bool ResizeIfLoadIsOutOfRange(size_type new_size) {
-      const size_type kMaxMapLoadTimes16 = 12;  // controls RAM vs CPU tradeoff
       const size_type hi_cutoff = num_buckets_ * kMaxMapLoadTimes16 / 16;
       const size_type lo_cutoff = hi_cutoff / 4;
       // We don't care how many elements are in trees.  If a lot are,
@@ -893,7 +1369,7 @@ class Map {
           return true;
         }
       } else if (PROTOBUF_PREDICT_FALSE(new_size <= lo_cutoff &&
-                                        num_buckets_ > kMinTableSize)) {
+                                        num_buckets_ > min_num_buckets_)) {
         size_type lg2_of_size_reduction_factor = 1;
         // It's possible we want to shrink a lot here... size() could even be 0.
         // So, estimate how much to shrink by making sure we don't shrink so
@@ -904,7 +1380,7 @@ class Map {
           ++lg2_of_size_reduction_factor;
         }
         size_type new_num_buckets = std::max<size_type>(
-            kMinTableSize, num_buckets_ >> lg2_of_size_reduction_factor);
+            min_num_buckets_, num_buckets_ >> lg2_of_size_reduction_factor);
         if (new_num_buckets != num_buckets_) {
           Resize(new_num_buckets);
           return true;
@@ -913,12 +1389,22 @@ class Map {
       return false;
     }
 
+    // Returns the number of buckets that holds n elements without a resize.
+    static size_type BucketsFor(size_type n) {
+      size_type num_buckets = kMinTableSize;
+      while (num_buckets * kMaxMapLoadTimes16 / 16 <= n &&
+             num_buckets <= max_size() / 2) {
+        num_buckets *= 2;
+      }
+      return num_buckets;
+    }
+
     // Resize to the given number of buckets.
     void Resize(size_t new_num_buckets) {
       if (num_buckets_ == internal::kGlobalEmptyTableSize) {
         // This is the global empty array.
         // Just overwrite with a new one. No need to transfer or free anything.
-        num_buckets_ = index_of_first_non_null_ = kMinTableSize;
+        num_buckets_ = index_of_first_non_null_ = TableSize(new_num_buckets);
         table_ = CreateEmptyTable(num_buckets_);
         seed_ = Seed();
         return;
@@ -1074,6 +1560,9 @@ class Map {
       GOOGLE_DCHECK_EQ(n & (n - 1), 0);
       void** result = Alloc<void*>(n);
       memset(result, 0, n * sizeof(result[0]));
+      if (alloc_.arena() == nullptr) {
+        internal::ParseBudgetCharge(n * sizeof(result[0]));
+      }
       return result;
     }
 
@@ -1098,12 +1587,14 @@ class Map {
 
     size_type num_elements_;
     size_type num_buckets_;
+    size_type min_num_buckets_;  // set by reserve()
     size_type seed_;
     size_type index_of_first_non_null_;
     void** table_;  // an array with num_buckets_ entries
     Allocator alloc_;
     GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(InnerMap);
   };  // end of class InnerMap
+#endif  // GOOGLE_PROTOBUF_FLAT_HASH_MAP
 
   template <typename LookupKey>
   using key_arg = typename internal::TransparentSupport<
@@ -1195,17 +1686,28 @@ class Map {
   size_type size() const { return elements_.size(); }
   bool empty() const { return size() == 0; }
 
+  // Presizes the table so that n elements can be inserted without rehashing.
+  void reserve(size_type n) {
+    InvalidateSortedKeyCache();
+    elements_.reserve(n);
+  }
+
   // Element access
   template <typename K = key_type>
   T& operator[](const key_arg<K>& key) {
-    return elements_[key].second;
+    std::pair<typename InnerMap::iterator, bool> p = elements_.insert(key);
+    if (p.second) InvalidateSortedKeyCache();
+    return p.first->second;
   }
   template <
       typename K = key_type,
       // Disable for integral types to reduce code bloat.
       typename = typename std::enable_if<!std::is_integral<K>::value>::type>
   T& operator[](key_arg<K>&& key) {
-    return elements_[std::forward<K>(key)].second;
+    std::pair<typename InnerMap::iterator, bool> p =
+        elements_.insert(std::forward<K>(key));
+    if (p.second) InvalidateSortedKeyCache();
+    return p.first->second;
   }
 
   template <typename K = key_type>
@@ -1270,6 +1772,7 @@ class Map {
     std::pair<typename InnerMap::iterator, bool> p =
         elements_.insert(value.first);
     if (p.second) {
+      InvalidateSortedKeyCache();
       p.first->second = value.second;
     }
     return std::pair<iterator, bool>(iterator(p.first), p.second);
@@ -1299,6 +1802,7 @@ class Map {
     }
   }
   iterator erase(iterator pos) {
+    InvalidateSortedKeyCache();
     iterator i = pos++;
     elements_.erase(i.it_);
     return pos;
@@ -1308,12 +1812,16 @@ class Map {
       first = erase(first);
     }
   }
-  void clear() { elements_.clear(); }
+  void clear() {
+    InvalidateSortedKeyCache();
+    elements_.clear();
+  }
 
   // Assign
   Map& operator=(const Map& other) {
     if (this != &other) {
       clear();
+      Presize(other.size());
       insert(other.begin(), other.end());
     }
     return *this;
@@ -1322,6 +1830,7 @@ class Map {
   void swap(Map& other) {
     if (arena() == other.arena()) {
       elements_.Swap(&other.elements_);
+      std::swap(sorted_cache_, other.sorted_cache_);
     } else {
       // TODO(zuguang): optimize this. The temporary copy can be allocated
       // in the same arena as the other message, and the "other = copy" can
@@ -1341,9 +1850,60 @@ class Map {
     return elements_.SpaceUsedInternal() + internal::SpaceUsedInValues(this);
   }
 
+  // Deterministic serialization sorts the keys of a map every time.  For maps
+  // that are serialized far more often than they change, this keeps the
+  // sorted order until the next insertion or erasure instead.  The cache
+  // costs one pointer per element and is not copied with the map.  Building
+  // it is thread-safe, so const maps can still be serialized concurrently.
+  void EnableSortedKeyCache() {
+    if (sorted_cache_ == nullptr) {
+      sorted_cache_ = Arena::Create<SortedKeyCache>(arena());
+    }
+  }
+
+  // Used by generated code.  Returns the elements in key order if the sorted
+  // key cache is enabled, or nullptr if it is not.
+  const std::vector<const_pointer>* InternalGetSortedElements() const {
+    if (sorted_cache_ == nullptr) return nullptr;
+    if (!sorted_cache_->valid.load(std::memory_order_acquire)) {
+      internal::MutexLock lock(&sorted_cache_->mu);
+      if (!sorted_cache_->valid.load(std::memory_order_relaxed)) {
+        std::vector<const_pointer>& items = sorted_cache_->items;
+        items.clear();
+        items.reserve(size());
+        for (const_iterator it = begin(); it != end(); ++it) {
+          items.push_back(&*it);
+        }
+        std::sort(items.begin(), items.end(),
+                  [](const_pointer a, const_pointer b) {
+                    return a->first < b->first;
+                  });
+        sorted_cache_->valid.store(true, std::memory_order_release);
+      }
+    }
+    return &sorted_cache_->items;
+  }
+
  private:
+  using SortedKeyCache = internal::MapSortedKeyCache<const_pointer>;
+
   Arena* arena() const { return elements_.arena(); }
+
+  // Sizes the table for a copy of n elements.  Unlike reserve(), the table
+  // may still shrink afterwards.
+  void Presize(size_type n) {
+    InvalidateSortedKeyCache();
+    elements_.Presize(n);
+  }
+
+  void InvalidateSortedKeyCache() {
+    if (sorted_cache_ != nullptr) {
+      sorted_cache_->valid.store(false, std::memory_order_relaxed);
+    }
+  }
+
   InnerMap elements_;
+  SortedKeyCache* sorted_cache_;
 
   friend class Arena;
   using InternalArenaConstructable_ = void;
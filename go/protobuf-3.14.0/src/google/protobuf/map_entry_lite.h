@@ -386,6 +386,7 @@ class MapEntryImpl : public Base {
           typename Map::size_type map_size = map_->size();
           value_ptr_ = &(*map_)[key_];
           if (PROTOBUF_PREDICT_TRUE(map_size != map_->size())) {
+            if (!ctx->CheckMapSize(map_->size())) return nullptr;
             using T =
                 typename MapIf<ValueTypeHandler::kIsEnum, int*, Value*>::type;
             ptr = ValueTypeHandler::Read(ptr + 1, ctx,
@@ -413,7 +414,9 @@ class MapEntryImpl : public Base {
         NewEntry();
       }
       ptr = entry_->_InternalParse(ptr, ctx);
-      if (ptr) UseKeyAndValueFromEntry();
+      if (!ptr) return nullptr;
+      UseKeyAndValueFromEntry();
+      if (!ctx->CheckMapSize(map_->size())) return nullptr;
       return ptr;
     }
 
@@ -426,6 +429,7 @@ class MapEntryImpl : public Base {
       if (!ptr) return nullptr;
       if (is_valid(entry->value())) {
         UseKeyAndValueFromEntry();
+        if (!ctx->CheckMapSize(map_->size())) return nullptr;
       } else {
         WriteLengthDelimited(field_num, entry->SerializeAsString(),
                              metadata->mutable_unknown_fields<UnknownType>());
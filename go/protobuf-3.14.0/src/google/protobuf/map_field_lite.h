@@ -75,6 +75,7 @@ class MapFieldLite {
   int size() const { return static_cast<int>(map_.size()); }
   void Clear() { return map_.clear(); }
   void MergeFrom(const MapFieldLite& other) {
+    if (map_.empty()) map_.Presize(other.map_.size());
     for (typename Map<Key, T>::const_iterator it = other.map_.begin();
          it != other.map_.end(); ++it) {
       map_[it->first] = it->second;
@@ -474,6 +474,9 @@ TEST_F(MapImplTest, HashFlood) {
   EXPECT_LE(x1, x0 * 20);
 }
 
+// The flat hash table invalidates iterators and pointers on insert, so it
+// doesn't provide the guarantees tested here.
+#if !defined(GOOGLE_PROTOBUF_FLAT_HASH_MAP)
 TEST_F(MapImplTest, CopyIteratorStressTest) {
   std::vector<Map<int32, int32>::iterator> v;
   const int kIters = 1e5;
@@ -665,6 +668,7 @@ TEST_F(MapImplTest, EraseRevalidates) {
   }
   EXPECT_EQ(larger_size - v.size(), map_.size());
 }
+#endif  // !GOOGLE_PROTOBUF_FLAT_HASH_MAP
 
 template <typename T>
 bool IsConstHelper(T& /*t*/) {  // NOLINT. We want to catch non-const refs here.
@@ -958,6 +962,80 @@ TEST_F(MapImplTest, Rehash) {
   EXPECT_TRUE(map_.empty());
 }
 
+TEST_F(MapImplTest, Reserve) {
+  map_.reserve(1000);
+  map_[0] = 0;
+  // The reserved table survives the first insert.
+  EXPECT_GE(map_.SpaceUsedExcludingSelfLong(), 1000 * sizeof(void*));
+  const Map<int32, int32>::value_type* first = &*map_.find(0);
+  for (int i = 1; i < 1000; i++) {
+    map_[i] = i;
+  }
+  // Nothing was rehashed.
+  EXPECT_EQ(first, &*map_.find(0));
+  EXPECT_EQ(1000, map_.size());
+  EXPECT_EQ(999, map_.at(999));
+
+  Map<int32, int32> copy(map_);
+  EXPECT_EQ(1000, copy.size());
+  EXPECT_EQ(500, copy.at(500));
+
+#if !defined(GOOGLE_PROTOBUF_FLAT_HASH_MAP)
+  // A copy is sized for the source, but unlike a reserved map it shrinks
+  // again: the table is resized on the next insert after erasing.
+  for (int i = 1; i < 1000; i++) {
+    map_.erase(i);
+    copy.erase(i);
+  }
+  map_[1] = 1;
+  copy[1] = 1;
+  EXPECT_GE(map_.SpaceUsedExcludingSelfLong(), 1000 * sizeof(void*));
+  EXPECT_LT(copy.SpaceUsedExcludingSelfLong(), 1000 * sizeof(void*));
+#endif  // !GOOGLE_PROTOBUF_FLAT_HASH_MAP
+}
+
+TEST_F(MapImplTest, InsertEraseChurn) {
+  std::map<int32, int32> reference_map;
+  uint32 frog = k0;
+  for (int i = 0; i < 20000; i++) {
+    frog *= k2;
+    frog ^= frog >> 17;
+    const int32 key = static_cast<int32>(frog % 512);
+    if (frog & 0x100) {
+      map_[key] = i;
+      reference_map[key] = i;
+    } else {
+      EXPECT_EQ(reference_map.erase(key), map_.erase(key));
+    }
+  }
+  ASSERT_EQ(reference_map.size(), map_.size());
+  for (const auto& entry : reference_map) {
+    EXPECT_EQ(entry.second, map_.at(entry.first));
+  }
+  size_t visited = 0;
+  for (const auto& entry : map_) {
+    EXPECT_EQ(reference_map[entry.first], entry.second);
+    ++visited;
+  }
+  EXPECT_EQ(reference_map.size(), visited);
+}
+
+TEST_F(MapImplTest, RehashKeepsArenaValues) {
+  Arena arena;
+  Map<std::string, TestAllTypes> map(&arena);
+  for (int i = 0; i < 1000; i++) {
+    TestAllTypes& value = map[StrCat("key", i)];
+    value.set_optional_int32(i);
+    value.add_repeated_string(StrCat("value", i));
+  }
+  for (int i = 0; i < 1000; i++) {
+    const TestAllTypes& value = map.at(StrCat("key", i));
+    EXPECT_EQ(i, value.optional_int32());
+    EXPECT_EQ(StrCat("value", i), value.repeated_string(0));
+    EXPECT_EQ(&arena, value.GetArena());
+  }
+}
+
 TEST_F(MapImplTest, EqualRange) {
   int key = 100, key_missing = 101;
   map_[key] = 100;
@@ -1038,6 +1116,7 @@ TEST_F(MapImplTest, CopyAssignMapIterator) {
   EXPECT_EQ(it1.GetKey().GetInt32Value(), it2.GetKey().GetInt32Value());
 }
 
+#if !defined(GOOGLE_PROTOBUF_FLAT_HASH_MAP)
 TEST_F(MapImplTest, SpaceUsed) {
   constexpr size_t kMinCap = 8;
 
@@ -1074,6 +1153,34 @@ TEST_F(MapImplTest, SpaceUsed) {
                 sizeof(std::pair<std::pair<int32, TestAllTypes>, void*>) +
                 m3[0].SpaceUsedLong() - sizeof(m3[0]));
 }
+#else   // !GOOGLE_PROTOBUF_FLAT_HASH_MAP
+TEST_F(MapImplTest, FlatTableReusesDeletedSlots) {
+  // Erasing leaves a deleted marker in the slot.  Inserting and erasing at a
+  // constant size must rebuild the table in place rather than keep growing.
+  Map<int32, int32> m;
+  for (int i = 0; i < 10; i++) m[i] = i;
+  for (int i = 10; i < 100; i++) {
+    m.erase(i - 10);
+    m[i] = i;
+  }
+  const size_t space_used = m.SpaceUsedExcludingSelfLong();
+  for (int i = 100; i < 10000; i++) {
+    m.erase(i - 10);
+    m[i] = i;
+  }
+  EXPECT_EQ(space_used, m.SpaceUsedExcludingSelfLong());
+  EXPECT_EQ(10, m.size());
+  for (int i = 9990; i < 10000; i++) EXPECT_EQ(i, m.at(i));
+
+  // Erasing doesn't move the other elements.
+  std::vector<std::pair<Map<int32, int32>::iterator, int32>> its;
+  for (auto it = m.begin(); it != m.end(); ++it) {
+    if (it->first % 2 == 0) its.emplace_back(it, it->first);
+  }
+  for (int i = 9991; i < 10000; i += 2) m.erase(i);
+  for (const auto& entry : its) EXPECT_EQ(entry.second, entry.first->first);
+}
+#endif  // !GOOGLE_PROTOBUF_FLAT_HASH_MAP
 
 // Attempts to verify that a map with keys a and b has a random ordering. This
 // function returns true if it succeeds in observing both possible orderings.
@@ -2631,6 +2738,36 @@ TEST(GeneratedMapFieldTest, CorruptedWireFormat) {
   EXPECT_FALSE(message.ParseFromString(data));
 }
 
+TEST(GeneratedMapFieldTest, ParseBudgetLimitsEntries) {
+  unittest::TestMap message;
+  for (int i = 0; i < 10; i++) {
+    (*message.mutable_map_int32_int32())[i] = i;
+  }
+  const std::string data = message.SerializeAsString();
+
+  io::ParseBudget budget;
+  budget.set_max_map_entries(9);
+  {
+    io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                               data.size());
+    input.SetParseBudget(&budget);
+    unittest::TestMap parsed;
+    EXPECT_FALSE(parsed.ParseFromCodedStream(&input));
+    EXPECT_TRUE(budget.exceeded());
+  }
+
+  budget.Reset();
+  budget.set_max_map_entries(10);
+  {
+    io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                               data.size());
+    input.SetParseBudget(&budget);
+    unittest::TestMap parsed;
+    EXPECT_TRUE(parsed.ParseFromCodedStream(&input));
+    EXPECT_EQ(10, parsed.map_int32_int32().size());
+  }
+}
+
 TEST(GeneratedMapFieldTest, IsInitialized) {
   unittest::TestRequiredMessageMap map_message;
 
@@ -3477,6 +3614,61 @@ TEST(MapSerializationTest, Deterministic) {
   EXPECT_TRUE(util::MessageDifferencer::Equals(u, t));
 }
 
+TEST(MapSerializationTest, SortedKeyCache) {
+  unittest::TestMap expected;
+  MapTestUtil::SetMapFields(&expected);
+  unittest::TestMap cached(expected);
+  cached.mutable_map_int32_int32()->EnableSortedKeyCache();
+  cached.mutable_map_string_string()->EnableSortedKeyCache();
+  cached.mutable_map_int32_foreign_message()->EnableSortedKeyCache();
+  for (int i = 0; i < 50; i++) {
+    (*expected.mutable_map_int32_int32())[i * 7919 % 101] = i;
+    (*expected.mutable_map_string_string())[StrCat(i * 31 % 17)] = "x";
+  }
+  *cached.mutable_map_int32_int32() = expected.map_int32_int32();
+  *cached.mutable_map_string_string() = expected.map_string_string();
+  EXPECT_EQ(DeterministicSerialization(expected),
+            DeterministicSerialization(cached));
+  // Served from the cache.
+  EXPECT_EQ(DeterministicSerialization(expected),
+            DeterministicSerialization(cached));
+
+  // Values can change without invalidating the cache.
+  (*expected.mutable_map_int32_int32())[3] = 33;
+  (*cached.mutable_map_int32_int32())[3] = 33;
+  EXPECT_EQ(DeterministicSerialization(expected),
+            DeterministicSerialization(cached));
+
+  // Inserting and erasing keys does.
+  (*expected.mutable_map_int32_int32())[-5] = 5;
+  (*cached.mutable_map_int32_int32())[-5] = 5;
+  expected.mutable_map_string_string()->erase("3");
+  cached.mutable_map_string_string()->erase("3");
+  expected.mutable_map_int32_foreign_message()->clear();
+  cached.mutable_map_int32_foreign_message()->clear();
+  (*expected.mutable_map_int32_foreign_message())[9].set_c(9);
+  (*cached.mutable_map_int32_foreign_message())[9].set_c(9);
+  (*expected.mutable_map_int32_foreign_message())[1].set_c(1);
+  (*cached.mutable_map_int32_foreign_message())[1].set_c(1);
+  EXPECT_EQ(DeterministicSerialization(expected),
+            DeterministicSerialization(cached));
+
+  Arena arena;
+  auto* on_arena = Arena::CreateMessage<unittest::TestMap>(&arena);
+  *on_arena = expected;
+  on_arena->mutable_map_int32_int32()->EnableSortedKeyCache();
+  EXPECT_EQ(DeterministicSerialization(expected),
+            DeterministicSerialization(*on_arena));
+
+  const std::vector<Map<int32, int32>::const_pointer>* sorted =
+      cached.map_int32_int32().InternalGetSortedElements();
+  ASSERT_TRUE(sorted != nullptr);
+  ASSERT_EQ(cached.map_int32_int32().size(), sorted->size());
+  EXPECT_EQ(-5, sorted->front()->first);
+  EXPECT_TRUE(expected.map_int32_int32().InternalGetSortedElements() ==
+              nullptr);
+}
+
 TEST(MapSerializationTest, DeterministicSubmessage) {
   protobuf_unittest::TestSubmessageMaps p;
   protobuf_unittest::TestMaps t;
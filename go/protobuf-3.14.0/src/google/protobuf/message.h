@@ -173,6 +173,10 @@ class MapFieldPrinterHelper;  // text_format.cc
 }
 namespace util {
 class MessageDifferencer;
+namespace converter {
+class MessageObjectSource;  // message_objectsource.cc
+class MessageObjectWriter;  // message_objectwriter.cc
+}  // namespace converter
 }
 
 
@@ -387,6 +391,8 @@ class RepeatedFieldRef;
 template <typename T, typename Enable = void>
 class MutableRepeatedFieldRef;
 
+class FieldAccessor;
+
 // This interface contains methods that can be used to dynamically access
 // and modify the fields of a protocol message.  Their semantics are
 // similar to the accessors the protocol compiler generates.
@@ -758,6 +764,15 @@ class PROTOBUF_EXPORT Reflection final {
   MutableRepeatedFieldRef<T> GetMutableRepeatedFieldRef(
       Message* message, const FieldDescriptor* field) const;
 
+  // Returns an object that gets and sets the singular, non-message field
+  // "field" of messages of this type like the methods above do, but with the
+  // field's offset, has-bit and oneof case looked up once rather than on
+  // every call. Worth it when the same field is accessed many times.
+  //
+  // Note that to use this method users need to include the header file
+  // "reflection.h" (which defines the FieldAccessor class).
+  FieldAccessor GetFieldAccessor(const FieldDescriptor* field) const;
+
   // DEPRECATED. Please use Get(Mutable)RepeatedFieldRef() for repeated field
   // access. The following repeated field accessors will be removed in the
   // future.
@@ -948,11 +963,14 @@ class PROTOBUF_EXPORT Reflection final {
   friend class RepeatedFieldRef;
   template <typename T, typename Enable>
   friend class MutableRepeatedFieldRef;
+  friend class FieldAccessor;
   friend class ::PROTOBUF_NAMESPACE_ID::MessageLayoutInspector;
   friend class ::PROTOBUF_NAMESPACE_ID::AssignDescriptorsHelper;
   friend class DynamicMessageFactory;
   friend class python::MapReflectionFriend;
   friend class util::MessageDifferencer;
+  friend class util::converter::MessageObjectSource;
+  friend class util::converter::MessageObjectWriter;
 #define GOOGLE_PROTOBUF_HAS_CEL_MAP_REFLECTION_FRIEND
   friend class expr::CelMapReflectionFriend;
   friend class internal::MapFieldReflectionTest;
@@ -48,9 +48,12 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/arena.h>
+#include <google/protobuf/arenastring.h>
 #include <google/protobuf/generated_message_table_driven.h>
 #include <google/protobuf/generated_message_util.h>
+#include <google/protobuf/instrumentation.h>
 #include <google/protobuf/repeated_field.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/stubs/strutil.h>
 #include <google/protobuf/stubs/stl_util.h>
 #include <google/protobuf/stubs/mutex.h>
@@ -138,13 +141,15 @@ namespace internal {
 template <bool aliasing>
 bool MergeFromImpl(StringPiece input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  InstrumentationScope scope(InstrumentationSink::PARSE, msg);
+  scope.set_bytes(input.size());
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
   ptr = msg->_InternalParse(ptr, &ctx);
   // ctx has an explicit limit set (length of string_view).
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return scope.set_ok(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -152,13 +157,16 @@ bool MergeFromImpl(StringPiece input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  InstrumentationScope scope(InstrumentationSink::PARSE, msg);
+  int64 start = input->ByteCount();
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
   ptr = msg->_InternalParse(ptr, &ctx);
+  scope.set_bytes(input->ByteCount() - start);
   // ctx has no explicit limit (hence we end on end of stream)
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtEndOfStream())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return scope.set_ok(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -166,6 +174,8 @@ bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  InstrumentationScope scope(InstrumentationSink::PARSE, msg);
+  scope.set_bytes(input.limit);
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input.zcis, input.limit);
@@ -173,7 +183,7 @@ bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
   if (PROTOBUF_PREDICT_TRUE(ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return scope.set_ok(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -223,6 +233,8 @@ class ZeroCopyCodedInputStream : public io::ZeroCopyInputStream {
 
 bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
                                 MessageLite::ParseFlags parse_flags) {
+  internal::InstrumentationScope scope(InstrumentationSink::PARSE, this);
+  int start = input->CurrentPosition();
   ZeroCopyCodedInputStream zcis(input);
   const char* ptr;
   internal::ParseContext ctx(input->RecursionBudget(), zcis.aliasing_enabled(),
@@ -233,9 +245,15 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   ctx.TrackCorrectEnding();
   ctx.data().pool = input->GetExtensionPool();
   ctx.data().factory = input->GetExtensionFactory();
+  internal::ParseBudgetScope budget_scope(input->GetParseBudget(), &ctx);
   ptr = _InternalParse(ptr, &ctx);
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
+  if (input->GetParseBudget() != nullptr &&
+      input->GetParseBudget()->exceeded()) {
+    return false;
+  }
   ctx.BackUp(ptr);
+  scope.set_bytes(input->CurrentPosition() - start);
   if (!ctx.EndedAtEndOfStream()) {
     GOOGLE_DCHECK(ctx.LastTag() != 1);  // We can't end on a pushed limit.
     if (ctx.IsExceedingLimit(ptr)) return false;
@@ -243,7 +261,7 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   } else {
     input->SetConsumed();
   }
-  return CheckFieldPresence(ctx, *this, parse_flags);
+  return scope.set_ok(CheckFieldPresence(ctx, *this, parse_flags));
 }
 
 bool MessageLite::MergePartialFromCodedStream(io::CodedInputStream* input) {
@@ -375,6 +393,7 @@ bool MessageLite::SerializeToCodedStream(io::CodedOutputStream* output) const {
 
 bool MessageLite::SerializePartialToCodedStream(
     io::CodedOutputStream* output) const {
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, this);
   const size_t size = ByteSizeLong();  // Force size to be cached.
   if (size > INT_MAX) {
     GOOGLE_LOG(ERROR) << GetTypeName()
@@ -388,13 +407,14 @@ bool MessageLite::SerializePartialToCodedStream(
     return false;
   }
   int final_byte_count = output->ByteCount();
+  scope.set_bytes(final_byte_count - original_byte_count);
 
   if (final_byte_count - original_byte_count != size) {
     ByteSizeConsistencyError(size, ByteSizeLong(),
                              final_byte_count - original_byte_count, *this);
   }
 
-  return true;
+  return scope.set_ok(true);
 }
 
 bool MessageLite::SerializeToZeroCopyStream(
@@ -405,6 +425,7 @@ bool MessageLite::SerializeToZeroCopyStream(
 
 bool MessageLite::SerializePartialToZeroCopyStream(
     io::ZeroCopyOutputStream* output) const {
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, this);
   const size_t size = ByteSizeLong();  // Force size to be cached.
   if (size > INT_MAX) {
     GOOGLE_LOG(ERROR) << GetTypeName()
@@ -419,7 +440,8 @@ bool MessageLite::SerializePartialToZeroCopyStream(
   target = _InternalSerialize(target, &stream);
   stream.Trim(target);
   if (stream.HadError()) return false;
-  return true;
+  scope.set_bytes(size);
+  return scope.set_ok(true);
 }
 
 bool MessageLite::SerializeToFileDescriptor(int file_descriptor) const {
@@ -451,6 +473,7 @@ bool MessageLite::AppendToString(std::string* output) const {
 }
 
 bool MessageLite::AppendPartialToString(std::string* output) const {
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, this);
   size_t old_size = output->size();
   size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
@@ -463,7 +486,8 @@ bool MessageLite::AppendPartialToString(std::string* output) const {
   uint8* start =
       reinterpret_cast<uint8*>(io::mutable_string_data(output) + old_size);
   SerializeToArrayImpl(*this, start, byte_size);
-  return true;
+  scope.set_bytes(byte_size);
+  return scope.set_ok(true);
 }
 
 bool MessageLite::SerializeToString(std::string* output) const {
@@ -476,12 +500,44 @@ bool MessageLite::SerializePartialToString(std::string* output) const {
   return AppendPartialToString(output);
 }
 
+bool MessageLite::SerializeSinglePassToString(std::string* output) const {
+  GOOGLE_DCHECK(IsInitialized()) << InitializationErrorMessage("serialize", *this);
+  return SerializePartialSinglePassToString(output);
+}
+
+bool MessageLite::SerializePartialSinglePassToString(
+    std::string* output) const {
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, this);
+  internal::ReverseEncoder encoder(output);
+  uint8* ptr = _InternalSerializeReverse(encoder.Start(), &encoder);
+  if (!encoder.Finish(ptr)) {
+    GOOGLE_LOG(ERROR) << GetTypeName()
+               << " exceeded maximum protobuf size of 2GB";
+    return false;
+  }
+  scope.set_bytes(output->size());
+  return scope.set_ok(true);
+}
+
+uint8* MessageLite::_InternalSerializeReverse(
+    uint8* ptr, internal::ReverseEncoder* encoder) const {
+  size_t size = ByteSizeLong();
+  if (size > INT_MAX) {
+    encoder->SetHadError();
+    return ptr;
+  }
+  ptr = encoder->EnsureSpace(ptr, size) - size;
+  SerializeToArrayImpl(*this, ptr, size);
+  return ptr;
+}
+
 bool MessageLite::SerializeToArray(void* data, int size) const {
   GOOGLE_DCHECK(IsInitialized()) << InitializationErrorMessage("serialize", *this);
   return SerializePartialToArray(data, size);
 }
 
 bool MessageLite::SerializePartialToArray(void* data, int size) const {
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, this);
   const size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
     GOOGLE_LOG(ERROR) << GetTypeName()
@@ -491,9 +547,35 @@ bool MessageLite::SerializePartialToArray(void* data, int size) const {
   if (size < byte_size) return false;
   uint8* start = reinterpret_cast<uint8*>(data);
   SerializeToArrayImpl(*this, start, byte_size);
-  return true;
+  scope.set_bytes(byte_size);
+  return scope.set_ok(true);
+}
+
+namespace internal {
+
+bool SerializeToArenaString(const MessageLite& msg, ArenaStringPtr* field,
+                            Arena* arena) {
+  GOOGLE_DCHECK(msg.IsInitialized())
+      << InitializationErrorMessage("serialize", msg);
+  internal::InstrumentationScope scope(InstrumentationSink::SERIALIZE, &msg);
+  size_t byte_size = msg.ByteSizeLong();
+  if (byte_size > INT_MAX) {
+    GOOGLE_LOG(ERROR) << msg.GetTypeName()
+               << " exceeded maximum protobuf size of 2GB: " << byte_size;
+    return false;
+  }
+
+  std::string* output = field->Mutable(ArenaStringPtr::EmptyDefault{}, arena);
+  STLStringResizeUninitialized(output, byte_size);
+  SerializeToArrayImpl(
+      msg, reinterpret_cast<uint8*>(io::mutable_string_data(output)),
+      byte_size);
+  scope.set_bytes(byte_size);
+  return scope.set_ok(true);
 }
 
+}  // namespace internal
+
 std::string MessageLite::SerializeAsString() const {
   // If the compiler implements the (Named) Return Value Optimization,
   // the local variable 'output' will not actually reside on the stack
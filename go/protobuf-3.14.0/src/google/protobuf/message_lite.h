@@ -83,7 +83,9 @@ struct ConstantInitialized {
 // See parse_context.h for explanation
 class ParseContext;
 
+struct ArenaStringPtr;
 class RepeatedPtrFieldBase;
+class ReverseEncoder;
 class WireFormatLite;
 class WeakFieldMap;
 
@@ -392,6 +394,13 @@ class PROTOBUF_EXPORT MessageLite {
   bool SerializeToString(std::string* output) const;
   // Like SerializeToString(), but allows missing required fields.
   bool SerializePartialToString(std::string* output) const;
+  // Like SerializeToString(), but serializes the message in a single pass,
+  // writing it back to front, instead of computing the sizes of all
+  // sub-messages first.  This is faster for deeply nested messages.  The
+  // output is the same, and the cached sizes are not updated.
+  bool SerializeSinglePassToString(std::string* output) const;
+  // Like SerializeSinglePassToString(), but allows missing required fields.
+  bool SerializePartialSinglePassToString(std::string* output) const;
   // Serialize the message and store it in the given byte array.  All required
   // fields must be set.
   bool SerializeToArray(void* data, int size) const;
@@ -504,6 +513,13 @@ class PROTOBUF_EXPORT MessageLite {
   virtual uint8* _InternalSerialize(uint8* ptr,
                                     io::EpsCopyOutputStream* stream) const = 0;
 
+  // Writes the message in front of |ptr| for single-pass serialization and
+  // returns the start of the written data; see ReverseEncoder.  Generated
+  // messages override this.  The default implementation falls back to
+  // ByteSizeLong() and _InternalSerialize().
+  virtual uint8* _InternalSerializeReverse(
+      uint8* ptr, internal::ReverseEncoder* encoder) const;
+
   // Identical to IsInitialized() except that it logs an error message.
   bool IsInitializedWithErrors() const {
     if (IsInitialized()) return true;
@@ -570,6 +586,14 @@ bool MergeFromImpl(const SourceWrapper<T>& input, MessageLite* msg,
   return input.template MergeInto<alias>(msg, parse_flags);
 }
 
+// Serializes msg into a string or bytes field of a message on arena (which
+// may be NULL), like msg.SerializeToString(field->Mutable(...)).  The field's
+// string is created on the arena if it has none yet and is otherwise reused
+// along with its capacity, so no temporary string is built or copied.
+PROTOBUF_EXPORT bool SerializeToArenaString(const MessageLite& msg,
+                                            ArenaStringPtr* field,
+                                            Arena* arena);
+
 }  // namespace internal
 
 template <MessageLite::ParseFlags flags, typename T>
@@ -0,0 +1,177 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// MessagePool<T> keeps released heap-allocated messages for reuse.
+//
+// Clear() on a generated message keeps the capacity of its strings, repeated
+// fields and sub-messages, so a message that is cleared and filled again with
+// similar data allocates nothing.  MessagePool hands out such cleared
+// messages, letting request-processing code reuse whole top-level messages
+// across threads without an arena:
+//
+//   MessagePool<MyRequest> pool;
+//   ...
+//   MessagePool<MyRequest>::Ptr request = pool.Get();
+//   request->ParseFromString(data);
+//   ...                    // request goes back to the pool when it dies.
+//
+// The pool is split into shards, each with its own lock, and a thread always
+// uses the same shard, so threads rarely contend.  Each shard keeps at most
+// max_per_shard messages; messages released to a full shard are deleted.
+
+#ifndef GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+#define GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/logging.h>
+#include <google/protobuf/stubs/mutex.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+
+template <typename T>
+class MessagePool {
+ public:
+  // Returns a message to the pool it came from when deleted.
+  class Releaser {
+   public:
+    Releaser() : pool_(nullptr) {}
+    explicit Releaser(MessagePool* pool) : pool_(pool) {}
+    void operator()(T* message) const {
+      if (pool_ != nullptr) {
+        pool_->Release(message);
+      } else {
+        delete message;
+      }
+    }
+
+   private:
+    MessagePool* pool_;
+  };
+  typedef std::unique_ptr<T, Releaser> Ptr;
+
+  static const int kDefaultMaxPerShard = 16;
+
+  // num_shards defaults to the number of hardware threads.
+  explicit MessagePool(int max_per_shard = kDefaultMaxPerShard,
+                       int num_shards = 0)
+      : max_per_shard_(max_per_shard) {
+    if (num_shards <= 0) {
+      num_shards = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (num_shards <= 0) num_shards = 1;
+    shards_.reset(new Shard[num_shards]);
+    num_shards_ = num_shards;
+  }
+
+  // All messages handed out must have been released before the pool is
+  // destroyed.
+  ~MessagePool() {
+    for (int i = 0; i < num_shards_; i++) {
+      for (T* message : shards_[i].free) delete message;
+    }
+  }
+
+  // Returns a cleared message, reusing a released one when the calling
+  // thread's shard has one.
+  Ptr Get() { return Ptr(GetRaw(), Releaser(this)); }
+
+  // Like Get(), but the caller must pass the message to Release().
+  T* GetRaw() {
+    Shard& shard = CurrentShard();
+    {
+      internal::MutexLock lock(&shard.mutex);
+      if (!shard.free.empty()) {
+        T* message = shard.free.back();
+        shard.free.pop_back();
+        return message;
+      }
+    }
+    return new T;
+  }
+
+  // Clears the message and keeps it for reuse, or deletes it if the calling
+  // thread's shard is full.  The message must not be on an arena.
+  void Release(T* message) {
+    GOOGLE_DCHECK(message->GetArena() == nullptr);
+    message->Clear();
+    Shard& shard = CurrentShard();
+    {
+      internal::MutexLock lock(&shard.mutex);
+      if (shard.free.size() < max_per_shard_) {
+        shard.free.push_back(message);
+        return;
+      }
+    }
+    delete message;
+  }
+
+  // Returns the number of messages currently kept for reuse.
+  size_t Retained() {
+    size_t total = 0;
+    for (int i = 0; i < num_shards_; i++) {
+      internal::MutexLock lock(&shards_[i].mutex);
+      total += shards_[i].free.size();
+    }
+    return total;
+  }
+
+ private:
+  // Aligned so that the locks of different shards do not share a cache line.
+  struct alignas(64) Shard {
+    internal::WrappedMutex mutex;
+    std::vector<T*> free;
+  };
+
+  Shard& CurrentShard() {
+    size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return shards_[hash % num_shards_];
+  }
+
+  const size_t max_per_shard_;
+  int num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessagePool);
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_MESSAGE_POOL_H__
@@ -0,0 +1,93 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/message_pool.h>
+
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+typedef MessagePool<protobuf_unittest::TestAllTypes> TestPool;
+
+TEST(MessagePoolTest, ReusesClearedMessages) {
+  TestPool pool(4, 1);
+  protobuf_unittest::TestAllTypes* first = pool.GetRaw();
+  TestUtil::SetAllFields(first);
+  const std::string* string_storage = &first->optional_string();
+  pool.Release(first);
+  EXPECT_EQ(1, pool.Retained());
+
+  TestPool::Ptr second = pool.Get();
+  EXPECT_EQ(first, second.get());
+  EXPECT_EQ(0, pool.Retained());
+  // The message is cleared but keeps the memory it had allocated.
+  EXPECT_EQ(0, second->ByteSizeLong());
+  EXPECT_EQ(string_storage, &second->optional_string());
+  EXPECT_LE(2, second->repeated_int32().Capacity());
+
+  second.reset();
+  EXPECT_EQ(1, pool.Retained());
+}
+
+TEST(MessagePoolTest, BoundsRetention) {
+  TestPool pool(2, 1);
+  std::vector<TestPool::Ptr> messages;
+  for (int i = 0; i < 5; i++) messages.push_back(pool.Get());
+  messages.clear();
+  EXPECT_EQ(2, pool.Retained());
+}
+
+TEST(MessagePoolTest, ManyThreads) {
+  TestPool pool;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&pool, t] {
+      for (int i = 0; i < 1000; i++) {
+        TestPool::Ptr message = pool.Get();
+        EXPECT_FALSE(message->has_optional_int32());
+        message->set_optional_int32(t);
+        message->add_repeated_string("x");
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_LE(1, pool.Retained());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
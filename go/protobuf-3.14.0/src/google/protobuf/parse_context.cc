@@ -30,6 +30,8 @@
 
 #include <google/protobuf/parse_context.h>
 
+#include <algorithm>
+
 #include <google/protobuf/stubs/stringprintf.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream.h>
@@ -37,6 +39,7 @@
 #include <google/protobuf/message_lite.h>
 #include <google/protobuf/repeated_field.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/stubs/mutex.h>
 #include <google/protobuf/stubs/strutil.h>
 
 #include <google/protobuf/port_def.inc>
@@ -259,22 +262,33 @@ void byteswap<8>(void* p) {
   *static_cast<uint64*>(p) = bswap_64(*static_cast<uint64*>(p));
 }
 
+// Copies `num` packed little-endian values from `ptr` into `dst`.
+template <typename T>
+void CopyPackedFixed(const char* ptr, int num, T* dst) {
+  std::memcpy(dst, ptr, num * sizeof(T));
+#ifndef PROTOBUF_LITTLE_ENDIAN
+  for (int i = 0; i < num; i++) byteswap<sizeof(T)>(dst + i);
+#endif
+}
+
 template <typename T>
 const char* EpsCopyInputStream::ReadPackedFixed(const char* ptr, int size,
                                                 RepeatedField<T>* out) {
   int nbytes = buffer_end_ + kSlopBytes - ptr;
+  if (size > nbytes) {
+    // The field spans several buffers. Reserve room for all of it up front
+    // instead of growing the field once per buffer, but don't trust a large
+    // size until the data has actually been read.
+    constexpr int kMaxReserveBytes = 1 << 20;
+    int reserve = std::min(size, kMaxReserveBytes) / sizeof(T);
+    out->Reserve(out->size() + reserve);
+  }
   while (size > nbytes) {
     int num = nbytes / sizeof(T);
     int old_entries = out->size();
     out->Reserve(old_entries + num);
     int block_size = num * sizeof(T);
-    auto dst = out->AddNAlreadyReserved(num);
-#ifdef PROTOBUF_LITTLE_ENDIAN
-    std::memcpy(dst, ptr, block_size);
-#else
-    for (int i = 0; i < num; i++)
-      dst[i] = UnalignedLoad<T>(ptr + i * sizeof(T));
-#endif
+    CopyPackedFixed(ptr, num, out->AddNAlreadyReserved(num));
     size -= block_size;
     if (limit_ <= kSlopBytes) return nullptr;
     ptr = Next();
@@ -286,12 +300,7 @@ const char* EpsCopyInputStream::ReadPackedFixed(const char* ptr, int size,
   int old_entries = out->size();
   out->Reserve(old_entries + num);
   int block_size = num * sizeof(T);
-  auto dst = out->AddNAlreadyReserved(num);
-#ifdef PROTOBUF_LITTLE_ENDIAN
-  std::memcpy(dst, ptr, block_size);
-#else
-  for (int i = 0; i < num; i++) dst[i] = UnalignedLoad<T>(ptr + i * sizeof(T));
-#endif
+  CopyPackedFixed(ptr, num, out->AddNAlreadyReserved(num));
   ptr += block_size;
   if (size != block_size) return nullptr;
   return ptr;
@@ -334,6 +343,86 @@ const char* ParseContext::ParseMessage(Message* msg, const char* ptr) {
   return ParseMessage(reinterpret_cast<MessageLite*>(msg), ptr);
 }
 
+const char* ParseContext::ReadArenaString(const char* ptr, ArenaStringPtr* s,
+                                          Arena* arena) {
+  int size = ReadSize(&ptr);
+  if (!ptr) return nullptr;
+  std::string* str =
+      s->MutableNoCopy(&GetEmptyStringAlreadyInited(), size, arena);
+  return ReadString(ptr, size, str);
+}
+
+bool ParseContext::MapEntryLimitExceeded() {
+  ParseBudgetScope* scope = ParseBudgetScope::Current();
+  if (scope != nullptr && scope->budget_ != nullptr) scope->Exceed();
+  return false;
+}
+
+ParseBudgetScope*& ParseBudgetScope::Current() {
+#if defined(GOOGLE_PROTOBUF_NO_THREADLOCAL)
+  static ThreadLocalStorage<ParseBudgetScope*>* current =
+      new ThreadLocalStorage<ParseBudgetScope*>();
+  return *current->Get();
+#else
+  static PROTOBUF_THREAD_LOCAL ParseBudgetScope* current = nullptr;
+  return current;
+#endif
+}
+
+std::atomic<int> parse_budget_users{0};
+
+ParseBudgetScope::ParseBudgetScope(io::ParseBudget* budget, ParseContext* ctx)
+    : budget_(budget), context_(ctx), previous_(nullptr), installed_(false) {
+  if (budget != nullptr) {
+    ctx->map_entry_limit_ = std::max(budget->max_map_entries(), 0);
+    parse_budget_users.fetch_add(1, std::memory_order_relaxed);
+  } else if (parse_budget_users.load(std::memory_order_relaxed) == 0) {
+    // No parse on this thread has a budget that would need lifting.
+    return;
+  }
+  previous_ = Current();
+  Current() = this;
+  installed_ = true;
+}
+
+ParseBudgetScope::~ParseBudgetScope() {
+  if (!installed_) return;
+  Current() = previous_;
+  if (budget_ != nullptr) {
+    parse_budget_users.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ParseBudgetScope::Charge(size_t bytes) {
+  budget_->allocated_bytes_ += bytes;
+  if (budget_->allocated_bytes_ > budget_->max_allocated_bytes_) Exceed();
+}
+
+void ParseBudgetScope::Exceed() {
+  budget_->exceeded_ = true;
+  context_->Abort();
+}
+
+int ParseBudgetRepeatedCapacityFallback(int new_size, int capacity,
+                                        size_t element_size, bool on_arena) {
+  ParseBudgetScope* scope = ParseBudgetScope::Current();
+  if (scope == nullptr || scope->budget_ == nullptr) return capacity;
+  int max_elements = scope->budget_->max_repeated_elements();
+  if (new_size > max_elements) {
+    scope->Exceed();
+    return capacity;
+  }
+  capacity = std::min(capacity, max_elements);
+  // Storage on an arena is charged when the arena allocates a block.
+  if (!on_arena) scope->Charge(element_size * capacity);
+  return capacity;
+}
+
+void ParseBudgetChargeFallback(size_t bytes) {
+  ParseBudgetScope* scope = ParseBudgetScope::Current();
+  if (scope != nullptr && scope->budget_ != nullptr) scope->Charge(bytes);
+}
+
 inline void WriteVarint(uint64 val, std::string* s) {
   while (val >= 128) {
     uint8 c = val | 0x80;
@@ -444,7 +533,8 @@ const char* InlineGreedyStringParser(std::string* s, const char* ptr,
 
 template <typename T, bool sign>
 const char* VarintParser(void* object, const char* ptr, ParseContext* ctx) {
-  return ctx->ReadPackedVarint(ptr, [object](uint64 varint) {
+  auto* field = static_cast<RepeatedField<T>*>(object);
+  return ctx->ReadPackedVarint(ptr, field, [field](uint64 varint) {
     T val;
     if (sign) {
       if (sizeof(T) == 8) {
@@ -455,7 +545,7 @@ const char* VarintParser(void* object, const char* ptr, ParseContext* ctx) {
     } else {
       val = varint;
     }
-    static_cast<RepeatedField<T>*>(object)->Add(val);
+    field->Add(val);
   });
 }
 
@@ -33,6 +33,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <string>
 
 #include <google/protobuf/io/coded_stream.h>
@@ -158,6 +159,32 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
     }
     return ReadStringFallback(ptr, size, s);
   }
+  // Reads `size` bytes without copying them when possible. If the stream was
+  // created with aliasing enabled and the bytes are contiguous in the caller's
+  // buffer, `*s` points into that buffer; the caller must keep the buffer alive
+  // for as long as `*s` is used. Otherwise the bytes are copied into `*scratch`
+  // and `*s` refers to it.
+  PROTOBUF_MUST_USE_RESULT const char* ReadStringPiece(const char* ptr,
+                                                       int size, StringPiece* s,
+                                                       std::string* scratch) {
+    // Once the patch buffer maps back to the caller's buffer (next_chunk_ is
+    // null) the input ends at buffer_end_; the slop bytes after it are not
+    // part of the caller's buffer.
+    const char* end =
+        next_chunk_ == nullptr ? buffer_end_ : buffer_end_ + kSlopBytes;
+    if (aliasing_ >= kNoDelta && size <= end - ptr) {
+      *s = StringPiece(aliasing_ == kNoDelta
+                           ? ptr
+                           : reinterpret_cast<const char*>(
+                                 reinterpret_cast<std::uintptr_t>(ptr) +
+                                 aliasing_),
+                       size);
+      return ptr + size;
+    }
+    ptr = ReadString(ptr, size, scratch);
+    if (ptr != nullptr) *s = *scratch;
+    return ptr;
+  }
   PROTOBUF_MUST_USE_RESULT const char* AppendString(const char* ptr, int size,
                                                     std::string* s) {
     if (size <= buffer_end_ + kSlopBytes - ptr) {
@@ -179,6 +206,13 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   template <typename Add>
   PROTOBUF_MUST_USE_RESULT const char* ReadPackedVarint(const char* ptr,
                                                         Add add);
+  // Like ReadPackedVarint() above, but if the whole field is in the current
+  // buffer its values are counted first and |out| is reserved once for all
+  // of them.
+  template <typename T, typename Add>
+  PROTOBUF_MUST_USE_RESULT const char* ReadPackedVarint(const char* ptr,
+                                                        RepeatedField<T>* out,
+                                                        Add add);
 
   uint32 LastTag() const { return last_tag_minus_1_ + 1; }
   bool ConsumeEndGroup(uint32 start_tag) {
@@ -366,6 +400,7 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
         ptr, [str](const char* p, ptrdiff_t s) { str->append(p, s); });
   }
   friend class ImplicitWeakMessage;
+  friend class LazyField;
 };
 
 // ParseContext holds all data that is global to the entire parse. Most
@@ -412,7 +447,28 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
     return ptr;
   }
 
+  // Returns false, failing the parse, if a map field that now holds size
+  // entries has more than the ParseBudget allows.
+  bool CheckMapSize(size_t size) {
+    return PROTOBUF_PREDICT_TRUE(size <= map_entry_limit_) ||
+           MapEntryLimitExceeded();
+  }
+
+  // Parses a length-delimited string into a singular string field with an
+  // empty default. On an arena, values short enough for the std::string inline
+  // buffer are stored without a destructor registration.
+  PROTOBUF_MUST_USE_RESULT const char* ReadArenaString(const char* ptr,
+                                                       ArenaStringPtr* s,
+                                                       Arena* arena);
+
  private:
+  friend class ParseBudgetScope;
+
+  bool MapEntryLimitExceeded();
+
+  // Makes every parse of a sub-message or group fail from now on.
+  void Abort() { depth_ = INT_MIN / 2; }
+
   // The context keeps an internal stack to keep track of the recursive
   // part of the parse state.
   // Current depth of the active parser, depth counts down.
@@ -422,9 +478,42 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   // Unfortunately necessary for the fringe case of ending on 0 or end-group tag
   // in the last kSlopBytes of a ZeroCopyInputStream chunk.
   int group_depth_ = INT_MIN;
+  // From the ParseBudget; see CheckMapSize().
+  size_t map_entry_limit_ = std::numeric_limits<size_t>::max();
   Data data_;
 };
 
+// Makes a ParseBudget apply to the parse on this thread using the given
+// context, until destroyed.  The budget may be NULL, which lifts any budget of
+// an enclosing parse.
+class PROTOBUF_EXPORT ParseBudgetScope {
+ public:
+  ParseBudgetScope(io::ParseBudget* budget, ParseContext* ctx);
+  ~ParseBudgetScope();
+
+ private:
+  friend class ParseContext;
+  friend int ParseBudgetRepeatedCapacityFallback(int, int, size_t, bool);
+  friend void ParseBudgetChargeFallback(size_t);
+
+  // The innermost scope on this thread, or NULL.
+  static ParseBudgetScope*& Current();
+
+  // Adds to the bytes allocated, exceeding the budget if that is too many.
+  void Charge(size_t bytes);
+  // Marks the budget exceeded and aborts the parse.
+  void Exceed();
+
+  io::ParseBudget* budget_;
+  ParseContext* context_;
+  ParseBudgetScope* previous_;
+  // Whether this is Current(); scopes without a budget are skipped while no
+  // parse has one.
+  bool installed_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ParseBudgetScope);
+};
+
 template <uint32 tag>
 bool ExpectTag(const char* ptr) {
   if (tag < 128) {
@@ -651,8 +740,61 @@ PROTOBUF_MUST_USE_RESULT const char* ParseContext::ParseMessage(
   return ptr;
 }
 
+// Decodes the varint at the start of `word`, which holds eight input bytes
+// as loaded by UnalignedLoad<uint64>. Returns the number of bytes the varint
+// occupies, or 0 if it does not end within the word.
+inline int DecodeVarintWord(uint64 word, uint64* out) {
+  uint64 stops = ~word & 0x8080808080808080ULL;
+  if (stops == 0) return 0;
+  // Keep the bytes up to and including the first one without a continuation
+  // bit, then squeeze out the continuation bits in three steps.
+  int bits = Bits::Log2FloorNonZero64(stops & (0 - stops)) + 1;
+  uint64 x = bits == 64 ? word : word & ((uint64{1} << bits) - 1);
+  x &= 0x7f7f7f7f7f7f7f7fULL;
+  x = (x & 0x007f007f007f007fULL) | ((x & 0x7f007f007f007f00ULL) >> 1);
+  x = (x & 0x00003fff00003fffULL) | ((x & 0x3fff00003fff0000ULL) >> 2);
+  x = (x & 0x000000000fffffffULL) | ((x & 0x0fffffff00000000ULL) >> 4);
+  *out = x;
+  return bits / 8;
+}
+
+// Returns the number of varints that end in [ptr, end), i.e. the number of
+// bytes without a continuation bit.
+inline int CountVarints(const char* ptr, const char* end) {
+  int count = 0;
+  for (; end - ptr >= 8; ptr += 8) {
+    uint64 stops = (~UnalignedLoad<uint64>(ptr) & 0x8080808080808080ULL) >> 7;
+    count += static_cast<int>((stops * 0x0101010101010101ULL) >> 56);
+  }
+  for (; ptr < end; ptr++) {
+    count += static_cast<uint8>(*ptr) < 0x80;
+  }
+  return count;
+}
+
 template <typename Add>
 const char* ReadPackedVarintArray(const char* ptr, const char* end, Add add) {
+  // Packed fields are decoded eight bytes at a time while that many bytes are
+  // left. A word of single-byte varints, the common case for small values,
+  // is emitted directly; otherwise the leading varint is decoded from the
+  // word without a byte-by-byte loop.
+  while (end - ptr >= 8) {
+    uint64 word = UnalignedLoad<uint64>(ptr);
+    if ((word & 0x8080808080808080ULL) == 0) {
+      for (int i = 0; i < 8; i++) add((word >> (8 * i)) & 0xff);
+      ptr += 8;
+      continue;
+    }
+    uint64 varint;
+    int len = DecodeVarintWord(word, &varint);
+    if (len != 0) {
+      ptr += len;
+    } else {
+      ptr = VarintParse(ptr, &varint);
+      if (ptr == nullptr) return nullptr;
+    }
+    add(varint);
+  }
   while (ptr < end) {
     uint64 varint;
     ptr = VarintParse(ptr, &varint);
@@ -698,6 +840,18 @@ const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add) {
   return end == ptr ? ptr : nullptr;
 }
 
+template <typename T, typename Add>
+const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr,
+                                                 RepeatedField<T>* out,
+                                                 Add add) {
+  const char* p = ptr;
+  int size = ReadSize(&p);
+  if (p != nullptr && size <= buffer_end_ + kSlopBytes - p) {
+    out->Reserve(out->size() + CountVarints(p, p + size));
+  }
+  return ReadPackedVarint(ptr, add);
+}
+
 // Helper for verification of utf8
 PROTOBUF_EXPORT
 bool VerifyUTF8(StringPiece s, const char* field_name);
@@ -812,7 +966,8 @@ PROTOBUF_MUST_USE_RESULT const char* PackedEnumParser(
     void* object, const char* ptr, ParseContext* ctx, bool (*is_valid)(int),
     InternalMetadata* metadata, int field_num) {
   return ctx->ReadPackedVarint(
-      ptr, [object, is_valid, metadata, field_num](uint64 val) {
+      ptr, static_cast<RepeatedField<int>*>(object),
+      [object, is_valid, metadata, field_num](uint64 val) {
         if (is_valid(val)) {
           static_cast<RepeatedField<int>*>(object)->Add(val);
         } else {
@@ -827,7 +982,8 @@ PROTOBUF_MUST_USE_RESULT const char* PackedEnumParserArg(
     bool (*is_valid)(const void*, int), const void* data,
     InternalMetadata* metadata, int field_num) {
   return ctx->ReadPackedVarint(
-      ptr, [object, is_valid, data, metadata, field_num](uint64 val) {
+      ptr, static_cast<RepeatedField<int>*>(object),
+      [object, is_valid, data, metadata, field_num](uint64 val) {
         if (is_valid(data, val)) {
           static_cast<RepeatedField<int>*>(object)->Add(val);
         } else {
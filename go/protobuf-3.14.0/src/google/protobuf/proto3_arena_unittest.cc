@@ -143,6 +143,18 @@ TEST(Proto3ArenaTest, UnknownFields) {
       arena_message->GetReflection()->GetUnknownFields(*arena_message).empty());
 }
 
+TEST(Proto3ArenaTest, SerializeSinglePass) {
+  TestAllTypes message;
+  std::string output;
+  EXPECT_TRUE(message.SerializeSinglePassToString(&output));
+  EXPECT_EQ("", output);
+
+  SetAllFields(&message);
+  message.set_optional_float(-0.0);
+  EXPECT_TRUE(message.SerializeSinglePassToString(&output));
+  EXPECT_EQ(message.SerializeAsString(), output);
+}
+
 TEST(Proto3ArenaTest, Swap) {
   Arena arena1;
   Arena arena2;
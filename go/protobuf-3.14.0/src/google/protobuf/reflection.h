@@ -29,7 +29,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // This header defines the RepeatedFieldRef class template used to access
-// repeated fields with protobuf reflection API.
+// repeated fields with protobuf reflection API, and the FieldAccessor class
+// used to access singular fields faster than through Reflection.
 #ifndef GOOGLE_PROTOBUF_REFLECTION_H__
 #define GOOGLE_PROTOBUF_REFLECTION_H__
 
@@ -272,6 +273,205 @@ class MutableRepeatedFieldRef<
   const Message* default_instance_;
 };
 
+// FieldAccessor gets and sets one singular, non-message field of messages of
+// one type, with the same semantics as the Reflection getters and setters.
+// Where those look up the field's offset, has-bit and oneof case on every
+// call, a FieldAccessor looks them up once, so that most calls are a load or
+// a store. Obtain one with Reflection::GetFieldAccessor() and keep it:
+//
+//   FieldAccessor id = reflection->GetFieldAccessor(id_field);
+//   for (Message* row : rows) id.SetInt64(row, NextId());
+//
+// As with Reflection, messages must be of the type the accessor was obtained
+// for and the typed methods must match the field's cpp_type(); unlike
+// Reflection, this is only checked in debug builds. Fields that are not
+// stored in place, such as extensions, go through Reflection.
+//
+// A FieldAccessor is a small value which may be copied and used from several
+// threads at once.
+class PROTOBUF_EXPORT FieldAccessor {
+ public:
+  const FieldDescriptor* field() const { return field_; }
+
+  bool Has(const Message& message) const {
+    if (has_bit_offset_ >= 0) {
+      return (GetRaw<uint32>(message, has_bit_offset_) & has_bit_mask_) != 0;
+    }
+    if (oneof_case_offset_ >= 0) {
+      return GetRaw<uint32>(message, oneof_case_offset_) == number_;
+    }
+    return reflection_->HasField(message, field_);
+  }
+  void Clear(Message* message) const {
+    reflection_->ClearField(message, field_);
+  }
+
+  int32 GetInt32(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_INT32);
+    return InPlace(message) ? GetRaw<int32>(message, offset_)
+                            : reflection_->GetInt32(message, field_);
+  }
+  int64 GetInt64(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_INT64);
+    return InPlace(message) ? GetRaw<int64>(message, offset_)
+                            : reflection_->GetInt64(message, field_);
+  }
+  uint32 GetUInt32(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_UINT32);
+    return InPlace(message) ? GetRaw<uint32>(message, offset_)
+                            : reflection_->GetUInt32(message, field_);
+  }
+  uint64 GetUInt64(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_UINT64);
+    return InPlace(message) ? GetRaw<uint64>(message, offset_)
+                            : reflection_->GetUInt64(message, field_);
+  }
+  float GetFloat(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_FLOAT);
+    return InPlace(message) ? GetRaw<float>(message, offset_)
+                            : reflection_->GetFloat(message, field_);
+  }
+  double GetDouble(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_DOUBLE);
+    return InPlace(message) ? GetRaw<double>(message, offset_)
+                            : reflection_->GetDouble(message, field_);
+  }
+  bool GetBool(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_BOOL);
+    return InPlace(message) ? GetRaw<bool>(message, offset_)
+                            : reflection_->GetBool(message, field_);
+  }
+  int GetEnumValue(const Message& message) const {
+    CheckType(FieldDescriptor::CPPTYPE_ENUM);
+    return InPlace(message) ? GetRaw<int>(message, offset_)
+                            : reflection_->GetEnumValue(message, field_);
+  }
+  std::string GetString(const Message& message) const {
+    std::string scratch;
+    return GetStringReference(message, &scratch);
+  }
+  // See Reflection::GetStringReference().
+  const std::string& GetStringReference(const Message& message,
+                                        std::string* scratch) const {
+    CheckType(FieldDescriptor::CPPTYPE_STRING);
+    if (InPlace(message)) {
+      const std::string* value =
+          GetRaw<internal::ArenaStringPtr>(message, offset_).GetPointer();
+      if (value != nullptr) return *value;
+      return field_->default_value_string();
+    }
+    return reflection_->GetStringReference(message, field_, scratch);
+  }
+
+  void SetInt32(Message* message, int32 value) const {
+    CheckType(FieldDescriptor::CPPTYPE_INT32);
+    if (!InPlace(*message)) {
+      return reflection_->SetInt32(message, field_, value);
+    }
+    *MutableRaw<int32>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetInt64(Message* message, int64 value) const {
+    CheckType(FieldDescriptor::CPPTYPE_INT64);
+    if (!InPlace(*message)) {
+      return reflection_->SetInt64(message, field_, value);
+    }
+    *MutableRaw<int64>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetUInt32(Message* message, uint32 value) const {
+    CheckType(FieldDescriptor::CPPTYPE_UINT32);
+    if (!InPlace(*message)) {
+      return reflection_->SetUInt32(message, field_, value);
+    }
+    *MutableRaw<uint32>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetUInt64(Message* message, uint64 value) const {
+    CheckType(FieldDescriptor::CPPTYPE_UINT64);
+    if (!InPlace(*message)) {
+      return reflection_->SetUInt64(message, field_, value);
+    }
+    *MutableRaw<uint64>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetFloat(Message* message, float value) const {
+    CheckType(FieldDescriptor::CPPTYPE_FLOAT);
+    if (!InPlace(*message)) {
+      return reflection_->SetFloat(message, field_, value);
+    }
+    *MutableRaw<float>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetDouble(Message* message, double value) const {
+    CheckType(FieldDescriptor::CPPTYPE_DOUBLE);
+    if (!InPlace(*message)) {
+      return reflection_->SetDouble(message, field_, value);
+    }
+    *MutableRaw<double>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  void SetBool(Message* message, bool value) const {
+    CheckType(FieldDescriptor::CPPTYPE_BOOL);
+    if (!InPlace(*message)) {
+      return reflection_->SetBool(message, field_, value);
+    }
+    *MutableRaw<bool>(message, offset_) = value;
+    SetHasBit(message);
+  }
+  // Like Reflection::SetEnumValue(), values that are not in a proto2 enum go
+  // to the unknown fields.
+  void SetEnumValue(Message* message, int value) const;
+  void SetString(Message* message, std::string value) const;
+
+ private:
+  friend class Reflection;
+
+  FieldAccessor(const Reflection* reflection, const FieldDescriptor* field);
+
+  // Whether the field can be accessed at offset_, which requires a oneof
+  // member to be the one set.
+  bool InPlace(const Message& message) const {
+    GOOGLE_DCHECK_EQ(message.GetReflection(), reflection_);
+    return offset_ >= 0 && (oneof_case_offset_ < 0 ||
+                            GetRaw<uint32>(message, oneof_case_offset_) ==
+                                number_);
+  }
+  void CheckType(FieldDescriptor::CppType type) const {
+    GOOGLE_DCHECK_EQ(field_->cpp_type(), type) << field_->full_name();
+  }
+  void SetHasBit(Message* message) const {
+    if (has_bit_offset_ >= 0) {
+      *MutableRaw<uint32>(message, has_bit_offset_) |= has_bit_mask_;
+    }
+  }
+
+  template <typename T>
+  static const T& GetRaw(const Message& message, int offset) {
+    return *reinterpret_cast<const T*>(
+        reinterpret_cast<const char*>(&message) + offset);
+  }
+  template <typename T>
+  static T* MutableRaw(Message* message, int offset) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(message) + offset);
+  }
+
+  const Reflection* reflection_;
+  const FieldDescriptor* field_;
+  uint32 number_;
+  // Offset of the field in the message, or -1 if it is not stored in place.
+  int offset_;
+  // Offset of the uint32 holding the field's has-bit, and the bit, or -1.
+  int has_bit_offset_;
+  uint32 has_bit_mask_;
+  // Offset of the case of the field's oneof, or -1 if it is not in a oneof.
+  int oneof_case_offset_;
+  // The default passed to ArenaStringPtr::Set() for string fields.
+  const std::string* default_string_;
+  // Whether values outside of the enum go to the unknown fields.
+  bool closed_enum_;
+};
+
 namespace internal {
 // Interfaces used to implement reflection RepeatedFieldRef API.
 // Reflection::GetRepeatedAccessor() should return a pointer to an singleton
@@ -56,8 +56,11 @@ void** RepeatedPtrFieldBase::InternalExtend(int extend_amount) {
   }
   Rep* old_rep = rep_;
   Arena* arena = GetArena();
-  new_size = std::max(internal::kRepeatedFieldLowerClampLimit,
-                      std::max(total_size_ * 2, new_size));
+  new_size = internal::ParseBudgetRepeatedCapacity(
+      new_size,
+      std::max(internal::kRepeatedFieldLowerClampLimit,
+               std::max(total_size_ * 2, new_size)),
+      sizeof(old_rep->elements[0]), arena != NULL);
   GOOGLE_CHECK_LE(new_size, (std::numeric_limits<size_t>::max() - kRepHeaderSize) /
                          sizeof(old_rep->elements[0]))
       << "Requested size is too large to fit into size_t.";
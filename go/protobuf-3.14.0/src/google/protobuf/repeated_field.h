@@ -568,6 +568,8 @@ struct IsMovable
 //     static Type* New();
 //     static Type* NewFromPrototype(const Type* prototype,
 //                                       Arena* arena);
+//     static void NewContiguous(const Type* prototype, Arena* arena, int n,
+//                               void** elements);
 //     static void Delete(Type*);
 //     static void Clear(Type*);
 //     static void Merge(const Type& from, Type* to);
@@ -644,6 +646,8 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
   void CloseGap(int start, int num);
 
   void Reserve(int new_size);
+  template <typename TypeHandler>
+  void ReserveElements(int new_size);
 
   int Capacity() const;
 
@@ -811,6 +815,14 @@ class GenericTypeHandler {
   }
   static inline GenericType* NewFromPrototype(const GenericType* prototype,
                                               Arena* arena = NULL);
+  // Creates |n| new elements and stores them in |elements|. On an arena,
+  // arena-constructable messages are carved out of one allocation in order,
+  // so that iterating over the field walks memory sequentially.
+  static inline void NewContiguous(const GenericType* prototype, Arena* arena,
+                                   int n, void** elements) {
+    NewContiguous(prototype, arena, n, elements,
+                  Arena::is_arena_constructable<Type>());
+  }
   static inline void Delete(GenericType* value, Arena* arena) {
     if (arena == NULL) {
       delete value;
@@ -829,6 +841,12 @@ class GenericTypeHandler {
   static inline size_t SpaceUsedLong(const GenericType& value) {
     return value.SpaceUsedLong();
   }
+
+ private:
+  static void NewContiguous(const GenericType* prototype, Arena* arena, int n,
+                            void** elements, std::true_type);
+  static void NewContiguous(const GenericType* prototype, Arena* arena, int n,
+                            void** elements, std::false_type);
 };
 
 template <typename GenericType>
@@ -841,6 +859,27 @@ void GenericTypeHandler<GenericType>::Merge(const GenericType& from,
                                             GenericType* to) {
   to->MergeFrom(from);
 }
+template <typename GenericType>
+void GenericTypeHandler<GenericType>::NewContiguous(
+    const GenericType* prototype, Arena* arena, int n, void** elements,
+    std::true_type) {
+  if (arena == NULL || n < 2) {
+    NewContiguous(prototype, arena, n, elements, std::false_type());
+    return;
+  }
+  GenericType* block = arena->CreateMessageArrayInternal<GenericType>(n);
+  for (int i = 0; i < n; i++) {
+    elements[i] = block + i;
+  }
+}
+template <typename GenericType>
+void GenericTypeHandler<GenericType>::NewContiguous(
+    const GenericType* prototype, Arena* arena, int n, void** elements,
+    std::false_type) {
+  for (int i = 0; i < n; i++) {
+    elements[i] = NewFromPrototype(prototype, arena);
+  }
+}
 
 // NewFromPrototype() and Merge() are not defined inline here, as we will need
 // to do a virtual function dispatch anyways to go from Message* to call
@@ -895,6 +934,12 @@ class StringTypeHandler {
                                               Arena* arena) {
     return New(arena);
   }
+  static inline void NewContiguous(const std::string*, Arena* arena, int n,
+                                   void** elements) {
+    for (int i = 0; i < n; i++) {
+      elements[i] = New(arena);
+    }
+  }
   static inline Arena* GetArena(std::string*) { return NULL; }
   static inline void* GetMaybeArenaPointer(std::string* /* value */) {
     return NULL;
@@ -965,6 +1010,14 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
   // array is grown, it will always be at least doubled in size.
   void Reserve(int new_size);
 
+  // Like Reserve(), but also creates the objects that the following calls to
+  // Add() will return, so that at least |new_size| objects are allocated in
+  // total.  On an arena, message objects are allocated in one contiguous
+  // block, in the order Add() hands them out, which keeps loops over large
+  // fields cache friendly.  Off an arena each object is allocated separately.
+  // Element must be a concrete type, e.g. not Message.
+  void ReserveElements(int new_size);
+
   int Capacity() const;
 
   // Gets the underlying array.  This pointer is possibly invalidated by
@@ -1561,7 +1614,9 @@ void RepeatedField<Element>::Reserve(int new_size) {
   Rep* old_rep = total_size_ > 0 ? rep() : NULL;
   Rep* new_rep;
   Arena* arena = GetArena();
-  new_size = internal::CalculateReserveSize(total_size_, new_size);
+  new_size = internal::ParseBudgetRepeatedCapacity(
+      new_size, internal::CalculateReserveSize(total_size_, new_size),
+      sizeof(Element), arena != NULL);
   GOOGLE_DCHECK_LE(
       static_cast<size_t>(new_size),
       (std::numeric_limits<size_t>::max() - kRepHeaderSize) / sizeof(Element))
@@ -1833,15 +1888,15 @@ void RepeatedPtrFieldBase::MergeFromInnerLoop(void** our_elems,
         reinterpret_cast<typename TypeHandler::Type*>(our_elems[i]);
     TypeHandler::Merge(*other_elem, new_elem);
   }
-  Arena* arena = GetArena();
+  if (already_allocated >= length) return;
+  // Not allocated: alloc all new elements first, so that they end up next to
+  // each other on an arena, then merge them.
+  TypeHandler::NewContiguous(cast<TypeHandler>(other_elems[already_allocated]),
+                             GetArena(), length - already_allocated,
+                             our_elems + already_allocated);
   for (int i = already_allocated; i < length; i++) {
-    // Not allocated: alloc a new element first, then merge it.
-    typename TypeHandler::Type* other_elem =
-        reinterpret_cast<typename TypeHandler::Type*>(other_elems[i]);
-    typename TypeHandler::Type* new_elem =
-        TypeHandler::NewFromPrototype(other_elem, arena);
-    TypeHandler::Merge(*other_elem, new_elem);
-    our_elems[i] = new_elem;
+    TypeHandler::Merge(*cast<TypeHandler>(other_elems[i]),
+                       cast<TypeHandler>(our_elems[i]));
   }
 }
 
@@ -1852,6 +1907,20 @@ inline void RepeatedPtrFieldBase::CopyFrom(const RepeatedPtrFieldBase& other) {
   RepeatedPtrFieldBase::MergeFrom<TypeHandler>(other);
 }
 
+template <typename TypeHandler>
+void RepeatedPtrFieldBase::ReserveElements(int new_size) {
+  // Without a prototype, only concrete types can be created; the handlers
+  // for Message, MessageLite and weak fields need one.
+  static_assert(!std::is_abstract<typename TypeHandler::Type>::value,
+                "ReserveElements() needs a concrete element type");
+  int allocated = rep_ != NULL ? rep_->allocated_size : 0;
+  if (new_size <= allocated) return;
+  Reserve(new_size);
+  TypeHandler::NewContiguous(NULL, arena_, new_size - allocated,
+                             rep_->elements + allocated);
+  rep_->allocated_size = new_size;
+}
+
 inline int RepeatedPtrFieldBase::Capacity() const { return total_size_; }
 
 inline void* const* RepeatedPtrFieldBase::raw_data() const {
@@ -2398,6 +2467,11 @@ inline void RepeatedPtrField<Element>::Reserve(int new_size) {
   return RepeatedPtrFieldBase::Reserve(new_size);
 }
 
+template <typename Element>
+inline void RepeatedPtrField<Element>::ReserveElements(int new_size) {
+  RepeatedPtrFieldBase::ReserveElements<TypeHandler>(new_size);
+}
+
 template <typename Element>
 inline int RepeatedPtrField<Element>::Capacity() const {
   return RepeatedPtrFieldBase::Capacity();
@@ -2828,6 +2902,25 @@ UnsafeArenaAllocatedRepeatedPtrFieldBackInserter(
       mutable_field);
 }
 
+// Copies one primitive field out of every element of a repeated message
+// field, giving a structure-of-arrays view of it.  Loops that only read that
+// field can then run over contiguous memory instead of chasing one pointer
+// per element.  Example:
+//   RepeatedField<float> scores;
+//   ExtractRepeatedColumn(batch.items(), &Item::score, &scores);
+// |column| is overwritten; it is a snapshot and does not track later changes
+// to |field|.
+template <typename Element, typename T>
+void ExtractRepeatedColumn(const RepeatedPtrField<Element>& field,
+                           T (Element::*getter)() const,
+                           RepeatedField<T>* column) {
+  column->Clear();
+  column->Reserve(field.size());
+  for (const Element& element : field) {
+    column->AddAlreadyReserved((element.*getter)());
+  }
+}
+
 // Extern declarations of common instantiations to reduce library bloat.
 extern template class PROTOBUF_EXPORT_TEMPLATE_DECLARE RepeatedField<bool>;
 extern template class PROTOBUF_EXPORT_TEMPLATE_DECLARE RepeatedField<int32>;
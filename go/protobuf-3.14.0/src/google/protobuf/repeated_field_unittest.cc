@@ -1483,6 +1483,64 @@ TEST(RepeatedPtrField, DeleteSubrange) {
   // DeleteSubrange is a trivial extension of ExtendSubrange.
 }
 
+TEST(RepeatedPtrField, ReserveElements) {
+  typedef TestAllTypes::NestedMessage Nested;
+  Arena arena;
+  RepeatedPtrField<Nested>* field =
+      Arena::CreateMessage<RepeatedPtrField<Nested>>(&arena);
+  field->Add()->set_bb(-1);
+  field->ReserveElements(100);
+  EXPECT_GE(field->Capacity(), 100);
+  EXPECT_EQ(1, field->size());
+  for (int i = 1; i < 100; i++) {
+    field->Add()->set_bb(i);
+  }
+  // Elements added after the first one come from a single block, in order.
+  for (int i = 2; i < 100; i++) {
+    EXPECT_EQ(&field->Get(i - 1) + 1, &field->Get(i));
+    EXPECT_EQ(&arena, field->Get(i).GetArena());
+    EXPECT_EQ(i, field->Get(i).bb());
+  }
+  // Already allocated: nothing to do.
+  field->ReserveElements(50);
+  EXPECT_EQ(100, field->size());
+
+  RepeatedPtrField<Nested> heap_field;
+  heap_field.ReserveElements(10);
+  EXPECT_EQ(0, heap_field.size());
+  heap_field.Add()->set_bb(1);
+  EXPECT_EQ(1, heap_field.Get(0).bb());
+}
+
+TEST(RepeatedPtrField, MergeFromArenaIsContiguous) {
+  typedef TestAllTypes::NestedMessage Nested;
+  RepeatedPtrField<Nested> source;
+  for (int i = 0; i < 20; i++) {
+    source.Add()->set_bb(i);
+  }
+  Arena arena;
+  RepeatedPtrField<Nested>* field =
+      Arena::CreateMessage<RepeatedPtrField<Nested>>(&arena);
+  field->MergeFrom(source);
+  ASSERT_EQ(20, field->size());
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(&field->Get(0) + i, &field->Get(i));
+    EXPECT_EQ(i, field->Get(i).bb());
+  }
+}
+
+TEST(RepeatedPtrField, ExtractRepeatedColumn) {
+  typedef TestAllTypes::NestedMessage Nested;
+  RepeatedPtrField<Nested> field;
+  for (int i = 0; i < 5; i++) {
+    field.Add()->set_bb(i * i);
+  }
+  RepeatedField<int32> column;
+  column.Add(-1);
+  ExtractRepeatedColumn(field, &Nested::bb, &column);
+  EXPECT_THAT(column, testing::ElementsAre(0, 1, 4, 9, 16));
+}
+
 // ===================================================================
 
 // Iterator tests stolen from net/proto/proto-array_unittest.
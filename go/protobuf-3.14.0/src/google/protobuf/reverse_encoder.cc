@@ -0,0 +1,85 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/reverse_encoder.h>
+
+#include <algorithm>
+#include <climits>
+
+#include <google/protobuf/stubs/stl_util.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+namespace {
+static const size_t kMinBufferSize = 256;
+}  // namespace
+
+ReverseEncoder::ReverseEncoder(std::string* buffer)
+    : buffer_(buffer), had_error_(false) {
+  // Use all of the storage the string already has.
+  size_t size = std::max(buffer_->capacity(), kMinBufferSize);
+  STLStringResizeUninitialized(buffer_, size);
+  begin_ = reinterpret_cast<uint8*>(string_as_array(buffer_));
+  end_ = begin_ + size;
+}
+
+uint8* ReverseEncoder::Start() { return end_; }
+
+uint8* ReverseEncoder::Grow(uint8* ptr, size_t size) {
+  size_t used = ByteCount(ptr);
+  size_t new_size = std::max(2 * buffer_->size(), used + size);
+  std::string new_buffer;
+  STLStringResizeUninitialized(&new_buffer, new_size);
+  uint8* new_begin = reinterpret_cast<uint8*>(string_as_array(&new_buffer));
+  memcpy(new_begin + new_size - used, ptr, used);
+  buffer_->swap(new_buffer);
+  begin_ = new_begin;
+  end_ = new_begin + new_size;
+  return end_ - used;
+}
+
+bool ReverseEncoder::Finish(uint8* ptr) {
+  size_t size = ByteCount(ptr);
+  if (had_error_ || size > INT_MAX) {
+    buffer_->clear();
+    return false;
+  }
+  memmove(begin_, ptr, size);
+  buffer_->resize(size);
+  return true;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
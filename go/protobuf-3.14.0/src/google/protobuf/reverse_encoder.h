@@ -0,0 +1,255 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains ReverseEncoder, the output buffer of single-pass
+// serialization (MessageLite::SerializeSinglePassToString()).  It is included
+// by generated code and is not meant to be used directly.
+
+#ifndef GOOGLE_PROTOBUF_REVERSE_ENCODER_H__
+#define GOOGLE_PROTOBUF_REVERSE_ENCODER_H__
+
+#include <string.h>
+
+#include <string>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/repeated_field.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Writes a message back to front.
+//
+// Forward serialization needs the size of every sub-message before it can
+// write the sub-message's length prefix, so it first walks the whole tree in
+// ByteSizeLong() to cache the sizes.  Writing the last field first, a
+// sub-message's contents are written before its prefix, at which point their
+// size is known.  Serializing a message this way takes a single traversal.
+//
+// All writers take a pointer to the first byte written so far, and return
+// the pointer to the first byte written once they are done.  The buffer grows
+// at the front as needed, which moves the data, so positions must be kept as
+// ByteCount() instead of as pointers.
+class PROTOBUF_EXPORT ReverseEncoder {
+ public:
+  // Encodes into |buffer|, reusing its storage.
+  explicit ReverseEncoder(std::string* buffer);
+
+  // Returns the pointer to pass to the first writer.
+  uint8* Start();
+  // Moves the bytes starting at |ptr| to the front of the buffer and trims
+  // it.  Returns false if the output is larger than 2GB.
+  bool Finish(uint8* ptr);
+
+  // Makes room for |size| more bytes in front of |ptr|.
+  uint8* EnsureSpace(uint8* ptr, size_t size) {
+    if (PROTOBUF_PREDICT_FALSE(static_cast<size_t>(ptr - begin_) < size)) {
+      return Grow(ptr, size);
+    }
+    return ptr;
+  }
+
+  // Number of bytes written so far.
+  size_t ByteCount(const uint8* ptr) const { return end_ - ptr; }
+
+  // Writes the length prefix of a length-delimited field whose contents have
+  // been written since ByteCount() returned |start|, and the field's tag.
+  uint8* WriteLengthDelimitedPrefix(int field_number, size_t start,
+                                    uint8* ptr) {
+    size_t size = ByteCount(ptr) - start;
+    ptr = EnsureSpace(ptr, 2 * kMaxVarint32Bytes);
+    ptr = WriteVarint32NoCheck(static_cast<uint32>(size), ptr);
+    return WriteTagNoCheck(field_number,
+                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED, ptr);
+  }
+
+  // Field writers, as in WireFormatLite::Write*ToArray().
+#define PROTOBUF_REVERSE_VARINT_WRITER(Name, Type, wire_value)            \
+  uint8* Write##Name##NoTag(Type value, uint8* ptr) {                      \
+    ptr = EnsureSpace(ptr, kMaxVarintBytes);                               \
+    return WriteVarint64NoCheck(wire_value, ptr);                          \
+  }                                                                        \
+  uint8* Write##Name(int field_number, Type value, uint8* ptr) {           \
+    ptr = EnsureSpace(ptr, kMaxVarintBytes + kMaxVarint32Bytes);           \
+    ptr = WriteVarint64NoCheck(wire_value, ptr);                           \
+    return WriteTagNoCheck(field_number, WireFormatLite::WIRETYPE_VARINT,  \
+                           ptr);                                           \
+  }
+
+  PROTOBUF_REVERSE_VARINT_WRITER(Int32, int32, static_cast<uint64>(value))
+  PROTOBUF_REVERSE_VARINT_WRITER(Int64, int64, static_cast<uint64>(value))
+  PROTOBUF_REVERSE_VARINT_WRITER(UInt32, uint32, value)
+  PROTOBUF_REVERSE_VARINT_WRITER(UInt64, uint64, value)
+  PROTOBUF_REVERSE_VARINT_WRITER(SInt32, int32,
+                                 WireFormatLite::ZigZagEncode32(value))
+  PROTOBUF_REVERSE_VARINT_WRITER(SInt64, int64,
+                                 WireFormatLite::ZigZagEncode64(value))
+  PROTOBUF_REVERSE_VARINT_WRITER(Bool, bool, value ? 1 : 0)
+  PROTOBUF_REVERSE_VARINT_WRITER(Enum, int, static_cast<uint64>(value))
+#undef PROTOBUF_REVERSE_VARINT_WRITER
+
+#define PROTOBUF_REVERSE_FIXED_WRITER(Name, Type, Bits, wire_value, WireType) \
+  uint8* Write##Name##NoTag(Type value, uint8* ptr) {                        \
+    ptr = EnsureSpace(ptr, Bits / 8);                                        \
+    return WriteFixed##Bits##NoCheck(wire_value, ptr);                       \
+  }                                                                          \
+  uint8* Write##Name(int field_number, Type value, uint8* ptr) {             \
+    ptr = EnsureSpace(ptr, Bits / 8 + kMaxVarint32Bytes);                    \
+    ptr = WriteFixed##Bits##NoCheck(wire_value, ptr);                        \
+    return WriteTagNoCheck(field_number, WireFormatLite::WireType, ptr);     \
+  }
+
+  PROTOBUF_REVERSE_FIXED_WRITER(Fixed32, uint32, 32, value, WIRETYPE_FIXED32)
+  PROTOBUF_REVERSE_FIXED_WRITER(Fixed64, uint64, 64, value, WIRETYPE_FIXED64)
+  PROTOBUF_REVERSE_FIXED_WRITER(SFixed32, int32, 32,
+                                static_cast<uint32>(value), WIRETYPE_FIXED32)
+  PROTOBUF_REVERSE_FIXED_WRITER(SFixed64, int64, 64,
+                                static_cast<uint64>(value), WIRETYPE_FIXED64)
+  PROTOBUF_REVERSE_FIXED_WRITER(Float, float, 32,
+                                WireFormatLite::EncodeFloat(value),
+                                WIRETYPE_FIXED32)
+  PROTOBUF_REVERSE_FIXED_WRITER(Double, double, 64,
+                                WireFormatLite::EncodeDouble(value),
+                                WIRETYPE_FIXED64)
+#undef PROTOBUF_REVERSE_FIXED_WRITER
+
+  uint8* WriteRaw(const void* data, size_t size, uint8* ptr) {
+    ptr = EnsureSpace(ptr, size) - size;
+    memcpy(ptr, data, size);
+    return ptr;
+  }
+
+  uint8* WriteString(int field_number, const std::string& value, uint8* ptr) {
+    size_t start = ByteCount(ptr);
+    ptr = WriteRaw(value.data(), value.size(), ptr);
+    return WriteLengthDelimitedPrefix(field_number, start, ptr);
+  }
+  uint8* WriteBytes(int field_number, const std::string& value, uint8* ptr) {
+    return WriteString(field_number, value, ptr);
+  }
+
+  // Writes the contents of a packed fixed-width field, without the prefix.
+  template <typename T>
+  uint8* WriteFixedPackedNoTag(const RepeatedField<T>& values, uint8* ptr) {
+    size_t size = values.size() * sizeof(T);
+    ptr = EnsureSpace(ptr, size) - size;
+#if defined(PROTOBUF_LITTLE_ENDIAN)
+    memcpy(ptr, values.data(), size);
+#else
+    uint8* out = ptr;
+    for (int i = 0; i < values.size(); i++) {
+      uint8 bytes[sizeof(T)];
+      memcpy(bytes, &values.Get(i), sizeof(T));
+      for (size_t j = 0; j < sizeof(T); j++) *out++ = bytes[sizeof(T) - 1 - j];
+    }
+#endif
+    return ptr;
+  }
+
+  template <typename MessageType>
+  uint8* WriteMessage(int field_number, const MessageType& value, uint8* ptr) {
+    size_t start = ByteCount(ptr);
+    ptr = value._InternalSerializeReverse(ptr, this);
+    return WriteLengthDelimitedPrefix(field_number, start, ptr);
+  }
+
+  template <typename MessageType>
+  uint8* WriteGroup(int field_number, const MessageType& value, uint8* ptr) {
+    ptr = WriteTag(field_number, WireFormatLite::WIRETYPE_END_GROUP, ptr);
+    ptr = value._InternalSerializeReverse(ptr, this);
+    return WriteTag(field_number, WireFormatLite::WIRETYPE_START_GROUP, ptr);
+  }
+
+  uint8* WriteTag(int field_number, WireFormatLite::WireType type,
+                  uint8* ptr) {
+    ptr = EnsureSpace(ptr, kMaxVarint32Bytes);
+    return WriteTagNoCheck(field_number, type, ptr);
+  }
+
+  // Makes the whole serialization fail, e.g. because a message is too large.
+  void SetHadError() { had_error_ = true; }
+
+ private:
+  static const int kMaxVarint32Bytes = 5;
+  static const int kMaxVarintBytes = 10;
+
+  uint8* Grow(uint8* ptr, size_t size);
+
+  static uint8* WriteVarint32NoCheck(uint32 value, uint8* ptr) {
+    ptr -= io::CodedOutputStream::VarintSize32(value);
+    io::CodedOutputStream::WriteVarint32ToArray(value, ptr);
+    return ptr;
+  }
+  static uint8* WriteVarint64NoCheck(uint64 value, uint8* ptr) {
+    ptr -= io::CodedOutputStream::VarintSize64(value);
+    io::CodedOutputStream::WriteVarint64ToArray(value, ptr);
+    return ptr;
+  }
+  static uint8* WriteTagNoCheck(int field_number,
+                                WireFormatLite::WireType type, uint8* ptr) {
+    return WriteVarint32NoCheck(WireFormatLite::MakeTag(field_number, type),
+                                ptr);
+  }
+  static uint8* WriteFixed32NoCheck(uint32 value, uint8* ptr) {
+    ptr -= sizeof(value);
+    io::CodedOutputStream::WriteLittleEndian32ToArray(value, ptr);
+    return ptr;
+  }
+  static uint8* WriteFixed64NoCheck(uint64 value, uint8* ptr) {
+    ptr -= sizeof(value);
+    io::CodedOutputStream::WriteLittleEndian64ToArray(value, ptr);
+    return ptr;
+  }
+
+  std::string* buffer_;
+  uint8* begin_;
+  uint8* end_;
+  bool had_error_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ReverseEncoder);
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_REVERSE_ENCODER_H__
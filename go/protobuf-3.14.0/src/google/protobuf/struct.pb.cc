@@ -8,6 +8,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/extension_set.h>
 #include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
@@ -301,19 +302,28 @@ failure:
 
     if (stream->IsSerializationDeterministic() &&
         this->_internal_fields().size() > 1) {
-      ::std::unique_ptr<SortItem[]> items(
-          new SortItem[this->_internal_fields().size()]);
-      typedef ::PROTOBUF_NAMESPACE_ID::Map< std::string, PROTOBUF_NAMESPACE_ID::Value >::size_type size_type;
-      size_type n = 0;
-      for (::PROTOBUF_NAMESPACE_ID::Map< std::string, PROTOBUF_NAMESPACE_ID::Value >::const_iterator
-          it = this->_internal_fields().begin();
-          it != this->_internal_fields().end(); ++it, ++n) {
-        items[static_cast<ptrdiff_t>(n)] = SortItem(&*it);
-      }
-      ::std::sort(&items[0], &items[static_cast<ptrdiff_t>(n)], Less());
-      for (size_type i = 0; i < n; i++) {
-        target = Struct_FieldsEntry_DoNotUse::Funcs::InternalSerialize(1, items[static_cast<ptrdiff_t>(i)]->first, items[static_cast<ptrdiff_t>(i)]->second, target, stream);
-        Utf8Check::Check(&(*items[static_cast<ptrdiff_t>(i)]));
+      const ::std::vector<ConstPtr>* sorted =
+          this->_internal_fields().InternalGetSortedElements();
+      if (sorted != nullptr) {
+        for (ConstPtr p : *sorted) {
+          target = Struct_FieldsEntry_DoNotUse::Funcs::InternalSerialize(1, p->first, p->second, target, stream);
+          Utf8Check::Check(&(*p));
+        }
+      } else {
+        ::std::unique_ptr<SortItem[]> items(
+            new SortItem[this->_internal_fields().size()]);
+        typedef ::PROTOBUF_NAMESPACE_ID::Map< std::string, PROTOBUF_NAMESPACE_ID::Value >::size_type size_type;
+        size_type n = 0;
+        for (::PROTOBUF_NAMESPACE_ID::Map< std::string, PROTOBUF_NAMESPACE_ID::Value >::const_iterator
+            it = this->_internal_fields().begin();
+            it != this->_internal_fields().end(); ++it, ++n) {
+          items[static_cast<ptrdiff_t>(n)] = SortItem(&*it);
+        }
+        ::std::sort(&items[0], &items[static_cast<ptrdiff_t>(n)], Less());
+        for (size_type i = 0; i < n; i++) {
+          target = Struct_FieldsEntry_DoNotUse::Funcs::InternalSerialize(1, items[static_cast<ptrdiff_t>(i)]->first, items[static_cast<ptrdiff_t>(i)]->second, target, stream);
+          Utf8Check::Check(&(*items[static_cast<ptrdiff_t>(i)]));
+        }
       }
     } else {
       for (::PROTOBUF_NAMESPACE_ID::Map< std::string, PROTOBUF_NAMESPACE_ID::Value >::const_iterator
@@ -716,6 +726,50 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* Value::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // .google.protobuf.ListValue list_value = 6;
+  if (_internal_has_list_value()) {
+    ptr = encoder->WriteMessage(6, this->_internal_list_value(), ptr);
+  }
+
+  // .google.protobuf.Struct struct_value = 5;
+  if (_internal_has_struct_value()) {
+    ptr = encoder->WriteMessage(5, this->_internal_struct_value(), ptr);
+  }
+
+  // bool bool_value = 4;
+  if (_internal_has_bool_value()) {
+    ptr = encoder->WriteBool(4, this->_internal_bool_value(), ptr);
+  }
+
+  // string string_value = 3;
+  if (_internal_has_string_value()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::VerifyUtf8String(
+      this->_internal_string_value().data(), static_cast<int>(this->_internal_string_value().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::SERIALIZE,
+      "google.protobuf.Value.string_value");
+    ptr = encoder->WriteString(3, this->_internal_string_value(), ptr);
+  }
+
+  // double number_value = 2;
+  if (_internal_has_number_value()) {
+    ptr = encoder->WriteDouble(2, this->_internal_number_value(), ptr);
+  }
+
+  // .google.protobuf.NullValue null_value = 1;
+  if (_internal_has_null_value()) {
+    ptr = encoder->WriteEnum(1, this->_internal_null_value(), ptr);
+  }
+
+  return ptr;
+}
+
 size_t Value::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.Value)
   size_t total_size = 0;
@@ -980,6 +1034,21 @@ failure:
   return target;
 }
 
+::PROTOBUF_NAMESPACE_ID::uint8* ListValue::_InternalSerializeReverse(
+    ::PROTOBUF_NAMESPACE_ID::uint8* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ReverseEncoder* encoder) const {
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::InternalSerializeUnknownFieldsReverse(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), ptr, encoder);
+  }
+
+  // repeated .google.protobuf.Value values = 1;
+  for (int i = this->_internal_values_size() - 1; i >= 0; i--) {
+    ptr = encoder->WriteMessage(1, this->_internal_values(i), ptr);
+  }
+
+  return ptr;
+}
+
 size_t ListValue::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:google.protobuf.ListValue)
   size_t total_size = 0;
@@ -32,6 +32,7 @@
 // Author: xpeng@google.com (Peter Peng)
 
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stringpiece.h>
 #include <gtest/gtest.h>
 
 namespace google {
@@ -65,6 +66,33 @@ TEST(StructurallyValidTest, InvalidUTF8String) {
   }
 }
 
+TEST(StructurallyValidTest, ValidPrefixOfLongMixedString) {
+  // Long ASCII runs around multi-byte characters, so that both the word and
+  // the byte paths are exercised.
+  std::string str;
+  for (int i = 0; i < 8; ++i) {
+    str += "abcdefghijklmnopqrstu \303\251 \342\202\254 \360\237\230\200 ";
+  }
+  const int valid_size = str.size();
+  EXPECT_EQ(valid_size, UTF8SpnStructurallyValid(str));
+
+  const char* kInvalid[] = {
+      "\200",              // Continuation byte.
+      "\300\257",          // Overlong '/'.
+      "\340\200\257",      // Overlong '/'.
+      "\355\240\200",      // Surrogate U+D800.
+      "\364\220\200\200",  // U+110000.
+      "\370\210\200\200",  // 5-byte lead.
+      "\342\202",          // Truncated.
+      "\342\202a",         // Missing continuation byte.
+  };
+  for (const char* invalid : kInvalid) {
+    std::string s = str + invalid + "xyz";
+    EXPECT_EQ(valid_size, UTF8SpnStructurallyValid(s)) << invalid;
+    EXPECT_FALSE(IsStructurallyValidUTF8(s.data(), s.size())) << invalid;
+  }
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace protobuf
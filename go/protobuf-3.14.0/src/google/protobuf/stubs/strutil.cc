@@ -1194,6 +1194,11 @@ std::string SimpleItoa(unsigned long long i) {
 //    and it is embedded in a larger library.  If speed turns out to be
 //    an issue, we could re-implement this in terms of their
 //    implementation.
+//
+//    Speed did turn out to be an issue, so both functions now first try
+//    Grisu3 (see below), which generates the same digits without snprintf()
+//    or strtod() for all but a small fraction of values, and only fall back
+//    to the strategy above when it fails.  The output is unchanged.
 // ----------------------------------------------------------------------
 
 std::string SimpleDtoa(double value) {
@@ -1239,6 +1244,411 @@ void DelocalizeRadix(char* buffer) {
   }
 }
 
+// ----------------------------------------------------------------------
+// Grisu3 digit generation for DoubleToBuffer() and FloatToBuffer().
+//
+// This is the algorithm from "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers" by Florian Loitsch, as implemented in the
+// double-conversion library.  It finds either the shortest digits that
+// round-trip, or a given number of correctly rounded digits, using only
+// 64-bit integer arithmetic.  In a small fraction of cases it cannot prove
+// that its answer is right, and reports failure; the callers then fall back
+// to snprintf().
+// ----------------------------------------------------------------------
+
+namespace {
+
+// A floating-point number f * 2^e with a 64-bit significand.
+struct DiyFp {
+  uint64 f;
+  int e;
+};
+
+DiyFp Normalize(DiyFp x) {
+  while ((x.f & (uint64{1} << 63)) == 0) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+// Returns the upper 64 bits of the 128-bit product, rounded.
+DiyFp Multiply(DiyFp x, DiyFp y) {
+  const uint64 kM32 = 0xFFFFFFFFu;
+  uint64 a = x.f >> 32, b = x.f & kM32;
+  uint64 c = y.f >> 32, d = y.f & kM32;
+  uint64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64 tmp = (bd >> 32) + (ad & kM32) + (bc & kM32) + (uint64{1} << 31);
+  DiyFp result = {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64};
+  return result;
+}
+
+struct CachedPower {
+  uint64 significand;
+  int16 binary_exponent;
+  int16 decimal_exponent;
+};
+
+// 10^k for k = -348, -340, ..., 340, rounded to 64 bits.
+const CachedPower kCachedPowers[] = {
+    {0xfa8fd5a0081c0288, -1220, -348},
+    {0xbaaee17fa23ebf76, -1193, -340},
+    {0x8b16fb203055ac76, -1166, -332},
+    {0xcf42894a5dce35ea, -1140, -324},
+    {0x9a6bb0aa55653b2d, -1113, -316},
+    {0xe61acf033d1a45df, -1087, -308},
+    {0xab70fe17c79ac6ca, -1060, -300},
+    {0xff77b1fcbebcdc4f, -1034, -292},
+    {0xbe5691ef416bd60c, -1007, -284},
+    {0x8dd01fad907ffc3c, -980, -276},
+    {0xd3515c2831559a83, -954, -268},
+    {0x9d71ac8fada6c9b5, -927, -260},
+    {0xea9c227723ee8bcb, -901, -252},
+    {0xaecc49914078536d, -874, -244},
+    {0x823c12795db6ce57, -847, -236},
+    {0xc21094364dfb5637, -821, -228},
+    {0x9096ea6f3848984f, -794, -220},
+    {0xd77485cb25823ac7, -768, -212},
+    {0xa086cfcd97bf97f4, -741, -204},
+    {0xef340a98172aace5, -715, -196},
+    {0xb23867fb2a35b28e, -688, -188},
+    {0x84c8d4dfd2c63f3b, -661, -180},
+    {0xc5dd44271ad3cdba, -635, -172},
+    {0x936b9fcebb25c996, -608, -164},
+    {0xdbac6c247d62a584, -582, -156},
+    {0xa3ab66580d5fdaf6, -555, -148},
+    {0xf3e2f893dec3f126, -529, -140},
+    {0xb5b5ada8aaff80b8, -502, -132},
+    {0x87625f056c7c4a8b, -475, -124},
+    {0xc9bcff6034c13053, -449, -116},
+    {0x964e858c91ba2655, -422, -108},
+    {0xdff9772470297ebd, -396, -100},
+    {0xa6dfbd9fb8e5b88f, -369, -92},
+    {0xf8a95fcf88747d94, -343, -84},
+    {0xb94470938fa89bcf, -316, -76},
+    {0x8a08f0f8bf0f156b, -289, -68},
+    {0xcdb02555653131b6, -263, -60},
+    {0x993fe2c6d07b7fac, -236, -52},
+    {0xe45c10c42a2b3b06, -210, -44},
+    {0xaa242499697392d3, -183, -36},
+    {0xfd87b5f28300ca0e, -157, -28},
+    {0xbce5086492111aeb, -130, -20},
+    {0x8cbccc096f5088cc, -103, -12},
+    {0xd1b71758e219652c, -77, -4},
+    {0x9c40000000000000, -50, 4},
+    {0xe8d4a51000000000, -24, 12},
+    {0xad78ebc5ac620000, 3, 20},
+    {0x813f3978f8940984, 30, 28},
+    {0xc097ce7bc90715b3, 56, 36},
+    {0x8f7e32ce7bea5c70, 83, 44},
+    {0xd5d238a4abe98068, 109, 52},
+    {0x9f4f2726179a2245, 136, 60},
+    {0xed63a231d4c4fb27, 162, 68},
+    {0xb0de65388cc8ada8, 189, 76},
+    {0x83c7088e1aab65db, 216, 84},
+    {0xc45d1df942711d9a, 242, 92},
+    {0x924d692ca61be758, 269, 100},
+    {0xda01ee641a708dea, 295, 108},
+    {0xa26da3999aef774a, 322, 116},
+    {0xf209787bb47d6b85, 348, 124},
+    {0xb454e4a179dd1877, 375, 132},
+    {0x865b86925b9bc5c2, 402, 140},
+    {0xc83553c5c8965d3d, 428, 148},
+    {0x952ab45cfa97a0b3, 455, 156},
+    {0xde469fbd99a05fe3, 481, 164},
+    {0xa59bc234db398c25, 508, 172},
+    {0xf6c69a72a3989f5c, 534, 180},
+    {0xb7dcbf5354e9bece, 561, 188},
+    {0x88fcf317f22241e2, 588, 196},
+    {0xcc20ce9bd35c78a5, 614, 204},
+    {0x98165af37b2153df, 641, 212},
+    {0xe2a0b5dc971f303a, 667, 220},
+    {0xa8d9d1535ce3b396, 694, 228},
+    {0xfb9b7cd9a4a7443c, 720, 236},
+    {0xbb764c4ca7a44410, 747, 244},
+    {0x8bab8eefb6409c1a, 774, 252},
+    {0xd01fef10a657842c, 800, 260},
+    {0x9b10a4e5e9913129, 827, 268},
+    {0xe7109bfba19c0c9d, 853, 276},
+    {0xac2820d9623bf429, 880, 284},
+    {0x80444b5e7aa7cf85, 907, 292},
+    {0xbf21e44003acdd2d, 933, 300},
+    {0x8e679c2f5e44ff8f, 960, 308},
+    {0xd433179d9c8cb841, 986, 316},
+    {0x9e19db92b4e31ba9, 1013, 324},
+    {0xeb96bf6ebadf77d9, 1039, 332},
+    {0xaf87023b9bf0ee6b, 1066, 340},
+};
+const int kCachedPowersOffset = 348;
+const int kDecimalExponentDistance = 8;
+
+// The digit generation works on scaled values whose binary exponent is in
+// [kMinimalTargetExponent, kMaximalTargetExponent].
+const int kMinimalTargetExponent = -60;
+const int kMaximalTargetExponent = -32;
+
+// Returns a cached power of ten 10^mk such that w * 10^mk, for a normalized
+// w with exponent e, has an exponent in the target range.
+DiyFp CachedPowerFor(int e, int* mk) {
+  int min_exponent = kMinimalTargetExponent - (e + 64);
+  // 0.30102999566398114 is 1 / log2(10).
+  int k = static_cast<int>(
+      std::ceil((min_exponent + 63) * 0.30102999566398114));
+  int index =
+      (kCachedPowersOffset + k - 1) / kDecimalExponentDistance + 1;
+  const CachedPower& power = kCachedPowers[index];
+  GOOGLE_DCHECK_LE(kMinimalTargetExponent,
+                   e + power.binary_exponent + 64);
+  GOOGLE_DCHECK_GE(kMaximalTargetExponent,
+                   e + power.binary_exponent + 64);
+  *mk = power.decimal_exponent;
+  DiyFp result = {power.significand, power.binary_exponent};
+  return result;
+}
+
+const uint32 kSmallPowersOfTen[] = {
+    0, 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000};
+
+// Returns the biggest power of ten that is <= number, which has at most
+// number_bits bits, and its exponent plus one.  For number == 0 both are 0.
+void BiggestPowerTen(uint32 number, int number_bits, uint32* power,
+                     int* exponent_plus_one) {
+  // 1233 / 4096 is approximately 1 / log2(10).
+  int guess = ((number_bits + 1) * 1233 >> 12) + 1;
+  if (number < kSmallPowersOfTen[guess]) guess--;
+  *power = kSmallPowersOfTen[guess];
+  *exponent_plus_one = guess;
+}
+
+// Adjusts the last digit of the shortest representation towards w, and checks
+// that the result is provably the closest one.  See double-conversion's
+// fast-dtoa.cc for the derivation.
+bool RoundWeed(char* buffer, int length, uint64 distance_too_high_w,
+               uint64 unsafe_interval, uint64 rest, uint64 ten_kappa,
+               uint64 unit) {
+  uint64 small_distance = distance_too_high_w - unit;
+  uint64 big_distance = distance_too_high_w + unit;
+  while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+         (rest + ten_kappa < small_distance ||
+          small_distance - rest >= rest + ten_kappa - small_distance)) {
+    buffer[length - 1]--;
+    rest += ten_kappa;
+  }
+  if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+      (rest + ten_kappa < big_distance ||
+       big_distance - rest > rest + ten_kappa - big_distance)) {
+    return false;
+  }
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Generates the shortest digits of w that lie strictly between low and high.
+bool DigitGen(DiyFp low, DiyFp w, DiyFp high, char* buffer, int* length,
+              int* kappa) {
+  uint64 unit = 1;
+  uint64 too_low = low.f - unit;
+  uint64 too_high = high.f + unit;
+  uint64 unsafe_interval = too_high - too_low;
+  int shift = -w.e;
+  uint64 one = uint64{1} << shift;
+  uint32 integrals = static_cast<uint32>(too_high >> shift);
+  uint64 fractionals = too_high & (one - 1);
+  uint32 divisor;
+  int divisor_exponent_plus_one;
+  BiggestPowerTen(integrals, 64 - shift, &divisor,
+                  &divisor_exponent_plus_one);
+  *kappa = divisor_exponent_plus_one;
+  *length = 0;
+  while (*kappa > 0) {
+    buffer[(*length)++] = static_cast<char>('0' + integrals / divisor);
+    integrals %= divisor;
+    (*kappa)--;
+    uint64 rest = (static_cast<uint64>(integrals) << shift) + fractionals;
+    if (rest < unsafe_interval) {
+      return RoundWeed(buffer, *length, too_high - w.f, unsafe_interval, rest,
+                       static_cast<uint64>(divisor) << shift, unit);
+    }
+    divisor /= 10;
+  }
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    buffer[(*length)++] = static_cast<char>('0' + (fractionals >> shift));
+    fractionals &= one - 1;
+    (*kappa)--;
+    if (fractionals < unsafe_interval) {
+      return RoundWeed(buffer, *length, (too_high - w.f) * unit,
+                       unsafe_interval, fractionals, one, unit);
+    }
+  }
+}
+
+// Rounds the counted digits using rest, and checks that the rounding is
+// not affected by the error of unit.
+bool RoundWeedCounted(char* buffer, int length, uint64 rest,
+                      uint64 ten_kappa, uint64 unit, int* kappa) {
+  if (unit >= ten_kappa || ten_kappa - unit <= unit) return false;
+  if (ten_kappa - rest > rest && ten_kappa - 2 * rest >= 2 * unit) {
+    return true;
+  }
+  if (rest > unit && ten_kappa - (rest - unit) <= rest - unit) {
+    buffer[length - 1]++;
+    for (int i = length - 1; i > 0 && buffer[i] == '0' + 10; i--) {
+      buffer[i] = '0';
+      buffer[i - 1]++;
+    }
+    if (buffer[0] == '0' + 10) {
+      buffer[0] = '1';
+      (*kappa)++;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Generates exactly requested_digits correctly rounded digits of w.
+bool DigitGenCounted(DiyFp w, int requested_digits, char* buffer,
+                     int* length, int* kappa) {
+  uint64 w_error = 1;
+  int shift = -w.e;
+  uint64 one = uint64{1} << shift;
+  uint32 integrals = static_cast<uint32>(w.f >> shift);
+  uint64 fractionals = w.f & (one - 1);
+  uint32 divisor;
+  int divisor_exponent_plus_one;
+  BiggestPowerTen(integrals, 64 - shift, &divisor,
+                  &divisor_exponent_plus_one);
+  *kappa = divisor_exponent_plus_one;
+  *length = 0;
+  while (*kappa > 0) {
+    buffer[(*length)++] = static_cast<char>('0' + integrals / divisor);
+    requested_digits--;
+    integrals %= divisor;
+    (*kappa)--;
+    if (requested_digits == 0) break;
+    divisor /= 10;
+  }
+  if (requested_digits == 0) {
+    uint64 rest = (static_cast<uint64>(integrals) << shift) + fractionals;
+    return RoundWeedCounted(buffer, *length, rest,
+                            static_cast<uint64>(divisor) << shift, w_error,
+                            kappa);
+  }
+  while (requested_digits > 0 && fractionals > w_error) {
+    fractionals *= 10;
+    w_error *= 10;
+    buffer[(*length)++] = static_cast<char>('0' + (fractionals >> shift));
+    requested_digits--;
+    fractionals &= one - 1;
+    (*kappa)--;
+  }
+  if (requested_digits != 0) return false;
+  return RoundWeedCounted(buffer, *length, fractionals, one, w_error, kappa);
+}
+
+// Writes digits * 10^decimal_exponent the way printf("%.*g", precision)
+// would, given that there are at most precision digits.
+void FormatLikePrintfG(bool negative, const char* digits, int length,
+                       int decimal_exponent, int precision, char* buffer) {
+  while (length > 1 && digits[length - 1] == '0') {
+    length--;
+    decimal_exponent++;
+  }
+  if (negative) *buffer++ = '-';
+  int exponent = length + decimal_exponent - 1;
+  if (exponent < -4 || exponent >= precision) {
+    *buffer++ = digits[0];
+    if (length > 1) {
+      *buffer++ = '.';
+      memcpy(buffer, digits + 1, length - 1);
+      buffer += length - 1;
+    }
+    *buffer++ = 'e';
+    *buffer++ = exponent < 0 ? '-' : '+';
+    if (exponent < 0) exponent = -exponent;
+    if (exponent >= 100) {
+      *buffer++ = static_cast<char>('0' + exponent / 100);
+      exponent %= 100;
+    }
+    *buffer++ = static_cast<char>('0' + exponent / 10);
+    *buffer++ = static_cast<char>('0' + exponent % 10);
+  } else if (exponent >= 0) {
+    int integer_digits = exponent + 1;
+    for (int i = 0; i < integer_digits; i++) {
+      *buffer++ = i < length ? digits[i] : '0';
+    }
+    if (length > integer_digits) {
+      *buffer++ = '.';
+      memcpy(buffer, digits + integer_digits, length - integer_digits);
+      buffer += length - integer_digits;
+    }
+  } else {
+    *buffer++ = '0';
+    *buffer++ = '.';
+    for (int i = -1; i > exponent; i--) *buffer++ = '0';
+    memcpy(buffer, digits, length);
+    buffer += length;
+  }
+  *buffer = '\0';
+}
+
+// Formats a finite IEEE-754 value, given as its fields, exactly as the
+// snprintf() code in DoubleToBuffer() and FloatToBuffer() does: with
+// short_precision digits if those round-trip, and with long_precision
+// correctly rounded digits otherwise.  Returns false if Grisu3 fails, or for
+// denormals, where short_precision digits do not always round-trip.
+bool FastFloatToBuffer(bool negative, uint64 significand, int biased_exponent,
+                       int significand_bits, int exponent_bias,
+                       int short_precision, int long_precision,
+                       char* buffer) {
+  if (biased_exponent == 0) {
+    if (significand != 0) return false;
+    strcpy(buffer, negative ? "-0" : "0");
+    return true;
+  }
+  uint64 hidden_bit = uint64{1} << significand_bits;
+  int e = biased_exponent - exponent_bias - significand_bits;
+  DiyFp v = {significand | hidden_bit, e};
+
+  // The boundaries are halfway to the neighboring values.  The lower one is
+  // closer when v is a power of two.
+  DiyFp plus = Normalize(DiyFp{(v.f << 1) + 1, v.e - 1});
+  DiyFp minus = significand == 0 && biased_exponent > 1
+                    ? DiyFp{(v.f << 2) - 1, v.e - 2}
+                    : DiyFp{(v.f << 1) - 1, v.e - 1};
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  DiyFp w = Normalize(v);
+  GOOGLE_DCHECK_EQ(w.e, plus.e);
+
+  int mk;
+  DiyFp ten_mk = CachedPowerFor(w.e, &mk);
+  DiyFp scaled_w = Multiply(w, ten_mk);
+
+  char digits[20];
+  int length;
+  int kappa;
+  if (!DigitGen(Multiply(minus, ten_mk), scaled_w, Multiply(plus, ten_mk),
+                digits, &length, &kappa)) {
+    return false;
+  }
+  if (length <= short_precision) {
+    FormatLikePrintfG(negative, digits, length, kappa - mk, short_precision,
+                      buffer);
+    return true;
+  }
+  if (!DigitGenCounted(scaled_w, long_precision, digits, &length, &kappa)) {
+    return false;
+  }
+  FormatLikePrintfG(negative, digits, length, kappa - mk, long_precision,
+                    buffer);
+  return true;
+}
+
+}  // namespace
+
 char* DoubleToBuffer(double value, char* buffer) {
   // DBL_DIG is 15 for IEEE-754 doubles, which are used on almost all
   // platforms these days.  Just in case some system exists where DBL_DIG
@@ -1257,6 +1667,14 @@ char* DoubleToBuffer(double value, char* buffer) {
     return buffer;
   }
 
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if (FastFloatToBuffer(bits >> 63, bits & ((uint64{1} << 52) - 1),
+                        static_cast<int>(bits >> 52) & 0x7FF, 52, 1023,
+                        DBL_DIG, DBL_DIG + 2, buffer)) {
+    return buffer;
+  }
+
   int snprintf_result =
     snprintf(buffer, kDoubleToBufferSize, "%.*g", DBL_DIG, value);
 
@@ -1375,6 +1793,14 @@ char* FloatToBuffer(float value, char* buffer) {
     return buffer;
   }
 
+  uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if (FastFloatToBuffer(bits >> 31, bits & ((uint32{1} << 23) - 1),
+                        static_cast<int>(bits >> 23) & 0xFF, 23, 127,
+                        FLT_DIG, FLT_DIG + 3, buffer)) {
+    return buffer;
+  }
+
   int snprintf_result =
     snprintf(buffer, kFloatToBufferSize, "%.*g", FLT_DIG, value);
 
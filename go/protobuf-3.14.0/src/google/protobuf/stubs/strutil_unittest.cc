@@ -34,6 +34,10 @@
 
 #include <locale.h>
 
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 #include <google/protobuf/stubs/stl_util.h>
 #include <google/protobuf/testing/googletest.h>
 #include <gtest/gtest.h>
@@ -74,6 +78,61 @@ TEST(StringUtilityTest, ImmuneToLocales) {
   setlocale(LC_NUMERIC, old_locale.c_str());
 }
 
+TEST(StringUtilityTest, SimpleDtoa) {
+  EXPECT_EQ("0", SimpleDtoa(0.0));
+  EXPECT_EQ("-0", SimpleDtoa(-0.0));
+  EXPECT_EQ("0.1", SimpleDtoa(0.1));
+  EXPECT_EQ("0.30000000000000004", SimpleDtoa(0.1 + 0.2));
+  EXPECT_EQ("1e+22", SimpleDtoa(1e22));
+  EXPECT_EQ("123456789012345", SimpleDtoa(123456789012345.0));
+  EXPECT_EQ("1.2345678901234568e+17", SimpleDtoa(123456789012345678.0));
+  EXPECT_EQ("0.0001", SimpleDtoa(0.0001));
+  EXPECT_EQ("1e-05", SimpleDtoa(0.00001));
+  EXPECT_EQ("1.7976931348623157e+308",
+            SimpleDtoa(std::numeric_limits<double>::max()));
+  EXPECT_EQ("4.94065645841247e-324",
+            SimpleDtoa(std::numeric_limits<double>::denorm_min()));
+  EXPECT_EQ("0.1", SimpleFtoa(0.1f));
+  EXPECT_EQ("3.40282347e+38", SimpleFtoa(std::numeric_limits<float>::max()));
+  EXPECT_EQ("16777216", SimpleFtoa(16777216.0f));
+}
+
+TEST(StringUtilityTest, SimpleDtoaMatchesPrintf) {
+  // The digits are generated without snprintf() when possible; check that
+  // the result is what the snprintf() strategy gives.
+  uint64 state = 1;
+  for (int i = 0; i < 100000; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double d;
+    memcpy(&d, &state, sizeof(d));
+    float f;
+    uint32 float_bits = static_cast<uint32>(state >> 32);
+    memcpy(&f, &float_bits, sizeof(f));
+    if (i % 2 == 0) {
+      d = static_cast<double>(state % 1000000007) / 1000;
+      f = static_cast<float>(d);
+    }
+
+    char expected[64];
+    if (std::isfinite(d)) {
+      double parsed;
+      snprintf(expected, sizeof(expected), "%.15g", d);
+      if (!safe_strtod(expected, &parsed) || parsed != d) {
+        snprintf(expected, sizeof(expected), "%.17g", d);
+      }
+      EXPECT_EQ(expected, SimpleDtoa(d));
+    }
+    if (std::isfinite(f)) {
+      float parsed;
+      snprintf(expected, sizeof(expected), "%.6g", f);
+      if (!safe_strtof(expected, &parsed) || parsed != f) {
+        snprintf(expected, sizeof(expected), "%.9g", f);
+      }
+      EXPECT_EQ(expected, SimpleFtoa(f));
+    }
+  }
+}
+
 #define EXPECT_EQ_ARRAY(len, x, y, msg)                     \
   for (int j = 0; j < len; ++j) {                           \
     EXPECT_EQ(x[j], y[j]) << "" # x << " != " # y           \
@@ -363,7 +363,7 @@ class TextFormat::Parser::ParserImpl {
   // Consumes the specified message with the given starting delimiter.
   // This method checks to see that the end delimiter at the conclusion of
   // the consumption matches the starting delimiter passed in here.
-  bool ConsumeMessage(Message* message, const std::string delimiter) {
+  bool ConsumeMessage(Message* message, const char* delimiter) {
     while (!LookingAt(">") && !LookingAt("}")) {
       DO(ConsumeField(message));
     }
@@ -374,7 +374,7 @@ class TextFormat::Parser::ParserImpl {
   }
 
   // Consume either "<" or "{".
-  bool ConsumeMessageDelimiter(std::string* delimiter) {
+  bool ConsumeMessageDelimiter(const char** delimiter) {
     if (TryConsume("<")) {
       *delimiter = ">";
     } else {
@@ -468,7 +468,7 @@ class TextFormat::Parser::ParserImpl {
           field = descriptor->FindFieldByNumber(field_number);
         }
       } else {
-        field = descriptor->FindFieldByName(field_name);
+        field = FindFieldByName(descriptor, field_name);
         // Group names are expected to be capitalized as they appear in the
         // .proto file, which actually matches their type names, not their
         // field names.
@@ -658,7 +658,7 @@ class TextFormat::Parser::ParserImpl {
       parse_info_tree_ = CreateNested(parent, field);
     }
 
-    std::string delimiter;
+    const char* delimiter;
     DO(ConsumeMessageDelimiter(&delimiter));
     MessageFactory* factory =
         finder_ ? finder_->FindExtensionFactory(field) : nullptr;
@@ -688,7 +688,7 @@ class TextFormat::Parser::ParserImpl {
       return false;
     }
 
-    std::string delimiter;
+    const char* delimiter;
     DO(ConsumeMessageDelimiter(&delimiter));
     while (!LookingAt(">") && !LookingAt("}")) {
       DO(SkipField());
@@ -757,7 +757,7 @@ class TextFormat::Parser::ParserImpl {
       case FieldDescriptor::CPPTYPE_STRING: {
         std::string value;
         DO(ConsumeString(&value));
-        SET_FIELD(String, value);
+        SET_FIELD(String, std::move(value));
         break;
       }
 
@@ -921,9 +921,31 @@ class TextFormat::Parser::ParserImpl {
     return true;
   }
 
+  // Returns descriptor->FindFieldByName(name), remembering recent lookups.
+  // Text input names the same few fields of a type over and over, and a hit
+  // costs a string comparison rather than a hash table lookup.
+  const FieldDescriptor* FindFieldByName(const Descriptor* descriptor,
+                                         const std::string& name) {
+    size_t hash = reinterpret_cast<uintptr_t>(descriptor) / sizeof(void*);
+    if (!name.empty()) {
+      hash += name.size() * 31 + static_cast<uint8>(name[0]) * 7 +
+              static_cast<uint8>(name[name.size() - 1]);
+    }
+    FieldCacheEntry& entry = field_cache_[hash % kFieldCacheSize];
+    if (entry.descriptor != descriptor || entry.name != name) {
+      entry.descriptor = descriptor;
+      entry.name = name;
+      entry.field = descriptor->FindFieldByName(name);
+    }
+    return entry.field;
+  }
+
   // Returns true if the current token's text is equal to that specified.
-  bool LookingAt(const std::string& text) {
-    return tokenizer_.current().text == text;
+  bool LookingAt(const char* text) {
+    const std::string& current = tokenizer_.current().text;
+    // The length is a constant for the literals this is called with.
+    const size_t size = strlen(text);
+    return current.size() == size && memcmp(current.data(), text, size) == 0;
   }
 
   // Returns true if the current token's type is equal to that specified.
@@ -1146,7 +1168,7 @@ class TextFormat::Parser::ParserImpl {
       return false;
     }
     std::unique_ptr<Message> value(value_prototype->New());
-    std::string sub_delimiter;
+    const char* sub_delimiter;
     DO(ConsumeMessageDelimiter(&sub_delimiter));
     DO(ConsumeMessage(value.get(), sub_delimiter));
 
@@ -1167,12 +1189,12 @@ class TextFormat::Parser::ParserImpl {
   // Consumes a token and confirms that it matches that specified in the
   // value parameter. Returns false if the token found does not match that
   // which was specified.
-  bool Consume(const std::string& value) {
+  bool Consume(const char* value) {
     const std::string& current_value = tokenizer_.current().text;
 
-    if (current_value != value) {
-      ReportError("Expected \"" + value + "\", found \"" + current_value +
-                  "\".");
+    if (!LookingAt(value)) {
+      ReportError(StrCat("Expected \"", value, "\", found \"",
+                         current_value, "\"."));
       return false;
     }
 
@@ -1183,8 +1205,8 @@ class TextFormat::Parser::ParserImpl {
 
   // Attempts to consume the supplied value. Returns false if a the
   // token found does not match the value specified.
-  bool TryConsume(const std::string& value) {
-    if (tokenizer_.current().text == value) {
+  bool TryConsume(const char* value) {
+    if (LookingAt(value)) {
       tokenizer_.Next();
       return true;
     } else {
@@ -1214,6 +1236,14 @@ class TextFormat::Parser::ParserImpl {
     TextFormat::Parser::ParserImpl* parser_;
   };
 
+  struct FieldCacheEntry {
+    FieldCacheEntry() : descriptor(nullptr), field(nullptr) {}
+    const Descriptor* descriptor;
+    std::string name;
+    const FieldDescriptor* field;
+  };
+  static constexpr int kFieldCacheSize = 64;
+
   io::ErrorCollector* error_collector_;
   const TextFormat::Finder* finder_;
   ParseInfoTree* parse_info_tree_;
@@ -1230,6 +1260,8 @@ class TextFormat::Parser::ParserImpl {
   const int initial_recursion_limit_;
   int recursion_limit_;
   bool had_errors_;
+  // Direct-mapped cache of FindFieldByName().
+  FieldCacheEntry field_cache_[kFieldCacheSize];
 };
 
 // ===========================================================================
@@ -1280,17 +1312,18 @@ class TextFormat::Printer::TextGenerator
   void Print(const char* text, size_t size) override {
     if (indent_level_ > 0) {
       size_t pos = 0;  // The number of bytes we've written so far.
-      for (size_t i = 0; i < size; i++) {
-        if (text[i] == '\n') {
-          // Saw newline.  If there is more text, we may need to insert an
-          // indent here.  So, write what we have so far, including the '\n'.
-          Write(text + pos, i - pos + 1);
-          pos = i + 1;
-
-          // Setting this true will cause the next Write() to insert an indent
-          // first.
-          at_start_of_line_ = true;
-        }
+      const char* newline;
+      while ((newline = static_cast<const char*>(
+                  memchr(text + pos, '\n', size - pos))) != nullptr) {
+        // Saw newline.  If there is more text, we may need to insert an
+        // indent here.  So, write what we have so far, including the '\n'.
+        size_t i = newline - text;
+        Write(text + pos, i - pos + 1);
+        pos = i + 1;
+
+        // Setting this true will cause the next Write() to insert an indent
+        // first.
+        at_start_of_line_ = true;
       }
       // Write the rest.
       Write(text + pos, size - pos);
@@ -1638,29 +1671,45 @@ void TextFormat::FastFieldValuePrinter::PrintBool(
     generator->PrintLiteral("false");
   }
 }
+// The scalar printers format into a stack buffer and print from there rather
+// than going through a temporary std::string.
 void TextFormat::FastFieldValuePrinter::PrintInt32(
     int32 val, BaseTextGenerator* generator) const {
-  generator->PrintString(StrCat(val));
+  strings::AlphaNum digits(val);
+  generator->Print(digits.data(), digits.size());
 }
 void TextFormat::FastFieldValuePrinter::PrintUInt32(
     uint32 val, BaseTextGenerator* generator) const {
-  generator->PrintString(StrCat(val));
+  strings::AlphaNum digits(val);
+  generator->Print(digits.data(), digits.size());
 }
 void TextFormat::FastFieldValuePrinter::PrintInt64(
     int64 val, BaseTextGenerator* generator) const {
-  generator->PrintString(StrCat(val));
+  strings::AlphaNum digits(val);
+  generator->Print(digits.data(), digits.size());
 }
 void TextFormat::FastFieldValuePrinter::PrintUInt64(
     uint64 val, BaseTextGenerator* generator) const {
-  generator->PrintString(StrCat(val));
+  strings::AlphaNum digits(val);
+  generator->Print(digits.data(), digits.size());
 }
 void TextFormat::FastFieldValuePrinter::PrintFloat(
     float val, BaseTextGenerator* generator) const {
-  generator->PrintString(!std::isnan(val) ? SimpleFtoa(val) : "nan");
+  if (std::isnan(val)) {
+    generator->PrintLiteral("nan");
+    return;
+  }
+  char buffer[kFloatToBufferSize];
+  generator->Print(buffer, strlen(FloatToBuffer(val, buffer)));
 }
 void TextFormat::FastFieldValuePrinter::PrintDouble(
     double val, BaseTextGenerator* generator) const {
-  generator->PrintString(!std::isnan(val) ? SimpleDtoa(val) : "nan");
+  if (std::isnan(val)) {
+    generator->PrintLiteral("nan");
+    return;
+  }
+  char buffer[kDoubleToBufferSize];
+  generator->Print(buffer, strlen(DoubleToBuffer(val, buffer)));
 }
 void TextFormat::FastFieldValuePrinter::PrintEnum(
     int32 val, const std::string& name, BaseTextGenerator* generator) const {
@@ -1670,7 +1719,34 @@ void TextFormat::FastFieldValuePrinter::PrintEnum(
 void TextFormat::FastFieldValuePrinter::PrintString(
     const std::string& val, BaseTextGenerator* generator) const {
   generator->PrintLiteral("\"");
-  generator->PrintString(CEscape(val));
+  // Same escaping as CEscape(), printed run by run.
+  const char* p = val.data();
+  const char* end = p + val.size();
+  while (p < end) {
+    const char* run = p;
+    while (p < end && *p >= 0x20 && *p < 0x7f && *p != '"' && *p != '\'' &&
+           *p != '\\') {
+      ++p;
+    }
+    if (p > run) generator->Print(run, p - run);
+    if (p == end) break;
+    char escaped[4] = {'\\'};
+    unsigned char c = static_cast<unsigned char>(*p++);
+    switch (c) {
+      case '\n': escaped[1] = 'n'; generator->Print(escaped, 2); break;
+      case '\r': escaped[1] = 'r'; generator->Print(escaped, 2); break;
+      case '\t': escaped[1] = 't'; generator->Print(escaped, 2); break;
+      case '\"':
+      case '\'':
+      case '\\': escaped[1] = c; generator->Print(escaped, 2); break;
+      default:
+        escaped[1] = '0' + c / 64;
+        escaped[2] = '0' + (c % 64) / 8;
+        escaped[3] = '0' + c % 8;
+        generator->Print(escaped, 4);
+        break;
+    }
+  }
   generator->PrintLiteral("\"");
 }
 void TextFormat::FastFieldValuePrinter::PrintBytes(
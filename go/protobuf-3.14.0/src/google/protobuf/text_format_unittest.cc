@@ -1669,6 +1669,21 @@ TEST_F(TextFormatParserTest, InvalidFieldName) {
       1, 14);
 }
 
+TEST_F(TextFormatParserTest, FieldNamesResolvedPerType) {
+  // "c" is a field of ForeignMessage but not of TestAllTypes; looking it up
+  // in one must not affect the other.
+  unittest::TestAllTypes proto;
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      "repeated_foreign_message { c: 1 } repeated_foreign_message { c: 2 }",
+      &proto));
+  ASSERT_EQ(2, proto.repeated_foreign_message_size());
+  EXPECT_EQ(2, proto.repeated_foreign_message(1).c());
+  ExpectFailure("optional_foreign_message { c: 1 } c: 2",
+                "Message type \"protobuf_unittest.TestAllTypes\" has no field "
+                "named \"c\".",
+                1, 36);
+}
+
 TEST_F(TextFormatParserTest, InvalidCapitalization) {
   // We require that group names be exactly as they appear in the .proto.
   ExpectFailure(
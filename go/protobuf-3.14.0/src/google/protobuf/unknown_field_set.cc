@@ -36,6 +36,7 @@
 
 #include <google/protobuf/stubs/logging.h>
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/mutex.h>
 #include <google/protobuf/parse_context.h>
 #include <google/protobuf/wire_format_lite.h>
 #include <google/protobuf/io/coded_stream.h>
@@ -49,32 +50,89 @@
 namespace google {
 namespace protobuf {
 
+namespace {
+
+std::atomic<bool> lazy_parsing_enabled(false);
+
+// Guards the decoding of raw unknown fields, which happens at most once per
+// set.
+internal::WrappedMutex* DecodeMutex() {
+  static internal::WrappedMutex* mutex = new internal::WrappedMutex;
+  return mutex;
+}
+
+}  // namespace
+
 const UnknownFieldSet& UnknownFieldSet::default_instance() {
   static auto instance = internal::OnShutdownDelete(new UnknownFieldSet());
   return *instance;
 }
 
+void UnknownFieldSet::SetLazyParsing(bool enabled) {
+  lazy_parsing_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool UnknownFieldSet::lazy_parsing() {
+  return lazy_parsing_enabled.load(std::memory_order_relaxed);
+}
+
 void UnknownFieldSet::ClearFallback() {
-  GOOGLE_DCHECK(!fields_.empty());
+  GOOGLE_DCHECK(!fields_.empty() || raw_ != nullptr);
   int n = fields_.size();
-  do {
+  while (n > 0) {
     (fields_)[--n].Delete();
-  } while (n > 0);
+  }
   fields_.clear();
+  delete raw_;
+  raw_ = nullptr;
+  decoded_.store(false, std::memory_order_relaxed);
 }
 
-void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
-  int other_field_count = other.field_count();
-  if (other_field_count > 0) {
-    fields_.reserve(fields_.size() + other_field_count);
-    for (int i = 0; i < other_field_count; i++) {
-      fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
-    }
+void UnknownFieldSet::DecodeRaw() const {
+  MutexLock lock(DecodeMutex());
+  if (decoded_.load(std::memory_order_relaxed)) return;
+  GOOGLE_DCHECK(fields_.empty());
+  // raw_ holds fields our own parser already accepted and re-encoded, so this
+  // can't fail.
+  UnknownFieldSet decoded;
+  bool ok =
+      decoded.ParseFromArray(raw_->data(), static_cast<int>(raw_->size()));
+  GOOGLE_DCHECK(ok) << "Raw unknown fields failed to parse.";
+  (void)ok;
+  fields_.swap(decoded.fields_);
+  decoded_.store(true, std::memory_order_release);
+}
+
+void UnknownFieldSet::DropRawFallback() {
+  if (NeedsDecoding()) DecodeRaw();
+  delete raw_;
+  raw_ = nullptr;
+  decoded_.store(false, std::memory_order_relaxed);
+}
+
+std::string* UnknownFieldSet::MutableRawForAppend() {
+  if (raw_ != nullptr) {
+    // Appending to raw_ would leave the decoded fields behind.
+    if (decoded_.load(std::memory_order_relaxed)) return nullptr;
+    return raw_;
   }
+  if (!fields_.empty()) return nullptr;
+  raw_ = new std::string;
+  return raw_;
+}
+
+void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
+  MergeFrom(other);
 }
 
 void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
+  if (other.raw_ != nullptr) {
+    if (std::string* raw = MutableRawForAppend()) {
+      raw->append(*other.raw_);
+      return;
+    }
+  }
+  DropRaw();
   int other_field_count = other.field_count();
   if (other_field_count > 0) {
     fields_.reserve(fields_.size() + other_field_count);
@@ -88,6 +146,12 @@ void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
 // A specialized MergeFrom for performance when we are merging from an UFS that
 // is temporary and can be destroyed in the process.
 void UnknownFieldSet::MergeFromAndDestroy(UnknownFieldSet* other) {
+  if (other->raw_ != nullptr && empty()) {
+    Swap(other);
+    return;
+  }
+  other->DropRaw();
+  DropRaw();
   if (fields_.empty()) {
     fields_ = std::move(other->fields_);
   } else {
@@ -104,9 +168,15 @@ void UnknownFieldSet::MergeToInternalMetadata(
 }
 
 size_t UnknownFieldSet::SpaceUsedExcludingSelfLong() const {
-  if (fields_.empty()) return 0;
+  size_t total_size = 0;
+  if (raw_ != nullptr) {
+    total_size +=
+        sizeof(*raw_) + internal::StringSpaceUsedExcludingSelfLong(*raw_);
+    if (!decoded_.load(std::memory_order_acquire)) return total_size;
+  }
+  if (fields_.empty()) return total_size;
 
-  size_t total_size = sizeof(fields_) + sizeof(UnknownField) * fields_.size();
+  total_size += sizeof(fields_) + sizeof(UnknownField) * fields_.size();
 
   for (const UnknownField& field : fields_) {
     switch (field.type()) {
@@ -130,6 +200,7 @@ size_t UnknownFieldSet::SpaceUsedLong() const {
 }
 
 void UnknownFieldSet::AddVarint(int number, uint64 value) {
+  DropRaw();
   UnknownField field;
   field.number_ = number;
   field.SetType(UnknownField::TYPE_VARINT);
@@ -138,6 +209,7 @@ void UnknownFieldSet::AddVarint(int number, uint64 value) {
 }
 
 void UnknownFieldSet::AddFixed32(int number, uint32 value) {
+  DropRaw();
   UnknownField field;
   field.number_ = number;
   field.SetType(UnknownField::TYPE_FIXED32);
@@ -146,6 +218,7 @@ void UnknownFieldSet::AddFixed32(int number, uint32 value) {
 }
 
 void UnknownFieldSet::AddFixed64(int number, uint64 value) {
+  DropRaw();
   UnknownField field;
   field.number_ = number;
   field.SetType(UnknownField::TYPE_FIXED64);
@@ -154,6 +227,7 @@ void UnknownFieldSet::AddFixed64(int number, uint64 value) {
 }
 
 std::string* UnknownFieldSet::AddLengthDelimited(int number) {
+  DropRaw();
   UnknownField field;
   field.number_ = number;
   field.SetType(UnknownField::TYPE_LENGTH_DELIMITED);
@@ -164,6 +238,7 @@ std::string* UnknownFieldSet::AddLengthDelimited(int number) {
 
 
 UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
+  DropRaw();
   UnknownField field;
   field.number_ = number;
   field.SetType(UnknownField::TYPE_GROUP);
@@ -173,11 +248,13 @@ UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
 }
 
 void UnknownFieldSet::AddField(const UnknownField& field) {
+  DropRaw();
   fields_.push_back(field);
   fields_.back().DeepCopy(field);
 }
 
 void UnknownFieldSet::DeleteSubrange(int start, int num) {
+  DropRaw();
   // Delete the specified fields.
   for (int i = 0; i < num; ++i) {
     (fields_)[i + start].Delete();
@@ -193,6 +270,7 @@ void UnknownFieldSet::DeleteSubrange(int start, int num) {
 }
 
 void UnknownFieldSet::DeleteByNumber(int number) {
+  DropRaw();
   int left = 0;  // The number of fields left after deletion.
   for (int i = 0; i < fields_.size(); ++i) {
     UnknownField* field = &(fields_)[i];
@@ -305,6 +383,16 @@ class UnknownFieldParserHelper {
     return WireFormatParser(*this, ptr, ctx);
   }
 
+  // With lazy parsing, re-encodes the field into the set's raw bytes rather
+  // than decoding it. Returns false if the set can't take raw bytes.
+  bool ParseRaw(uint64 tag, const char** ptr, ParseContext* ctx) {
+    if (!UnknownFieldSet::lazy_parsing()) return false;
+    std::string* raw = unknown_->MutableRawForAppend();
+    if (raw == nullptr) return false;
+    *ptr = UnknownFieldParse(static_cast<uint32>(tag), raw, *ptr, ctx);
+    return true;
+  }
+
  private:
   UnknownFieldSet* unknown_;
 };
@@ -318,6 +406,7 @@ const char* UnknownGroupParse(UnknownFieldSet* unknown, const char* ptr,
 const char* UnknownFieldParse(uint64 tag, UnknownFieldSet* unknown,
                               const char* ptr, ParseContext* ctx) {
   UnknownFieldParserHelper field_parser(unknown);
+  if (field_parser.ParseRaw(tag, &ptr, ctx)) return ptr;
   return FieldParser(tag, field_parser, ptr, ctx);
 }
 
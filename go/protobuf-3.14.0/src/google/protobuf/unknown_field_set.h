@@ -40,7 +40,9 @@
 
 #include <assert.h>
 
+#include <atomic>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <google/protobuf/stubs/common.h>
@@ -64,6 +66,7 @@ class InternalMetadata;           // metadata_lite.h
 class WireFormat;                 // wire_format.h
 class MessageSetFieldSkipperUsingCord;
 // extension_set_heavy.cc
+class UnknownFieldParserHelper;   // unknown_field_set.cc
 }  // namespace internal
 
 class Message;       // message.h
@@ -174,14 +177,50 @@ class PROTOBUF_EXPORT UnknownFieldSet {
 
   static const UnknownFieldSet& default_instance();
 
+  // Lazy parsing ----------------------------------------------------
+  // When lazy parsing is enabled, parsing a message keeps its unknown fields
+  // as the bytes they were read from, in one buffer per set, rather than
+  // decoding each of them into an UnknownField. Serializing the message
+  // copies the bytes back out, and merging appends them. They are decoded the
+  // first time the fields are looked at one by one (field_count(), field(),
+  // or any method that modifies the set); until then they take no more than
+  // their size in memory. This suits servers that forward messages built
+  // with newer schemas without looking at the fields they don't know.
+  //
+  // The setting is process-wide, is off by default, and applies to the
+  // parses that start after it is changed.
+  static void SetLazyParsing(bool enabled);
+  static bool lazy_parsing();
+
  private:
   // For InternalMergeFrom
   friend class UnknownField;
+  // For the undecoded bytes.
+  friend class internal::UnknownFieldParserHelper;
+  friend class internal::WireFormat;
+
   // Merges from other UnknownFieldSet. This method assumes, that this object
   // is newly created and has no fields.
   void InternalMergeFrom(const UnknownFieldSet& other);
   void ClearFallback();
 
+  // Whether fields_ is not up to date with raw_, which only happens until
+  // the first call to DecodeRaw().
+  bool NeedsDecoding() const {
+    return raw_ != nullptr && !decoded_.load(std::memory_order_acquire);
+  }
+  // Decodes raw_ into fields_. Safe to call concurrently; raw_ is kept, as
+  // serializers may be reading it.
+  void DecodeRaw() const;
+  // Makes fields_ the only representation of the set, before it is modified.
+  void DropRaw() {
+    if (raw_ != nullptr) DropRawFallback();
+  }
+  void DropRawFallback();
+  // Returns the buffer new serialized fields can be appended to, or NULL if
+  // the set already has decoded fields.
+  std::string* MutableRawForAppend();
+
   template <typename MessageType,
             typename std::enable_if<
                 std::is_base_of<Message, MessageType>::value, int>::type = 0>
@@ -203,7 +242,12 @@ class PROTOBUF_EXPORT UnknownFieldSet {
     return MergeFromCodedStream(&coded_stream);
   }
 
-  std::vector<UnknownField> fields_;
+  // When raw_ is set, it holds the serialized fields of the set and fields_
+  // is either empty or, once decoded_ is true, their decoded form.
+  // Otherwise fields_ holds the fields.
+  mutable std::vector<UnknownField> fields_;
+  std::string* raw_;
+  mutable std::atomic<bool> decoded_;
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(UnknownFieldSet);
 };
 
@@ -301,31 +345,41 @@ class PROTOBUF_EXPORT UnknownField {
 // ===================================================================
 // inline implementations
 
-inline UnknownFieldSet::UnknownFieldSet() {}
+inline UnknownFieldSet::UnknownFieldSet() : raw_(nullptr), decoded_(false) {}
 
 inline UnknownFieldSet::~UnknownFieldSet() { Clear(); }
 
 inline void UnknownFieldSet::ClearAndFreeMemory() { Clear(); }
 
 inline void UnknownFieldSet::Clear() {
-  if (!fields_.empty()) {
+  if (!fields_.empty() || raw_ != nullptr) {
     ClearFallback();
   }
 }
 
-inline bool UnknownFieldSet::empty() const { return fields_.empty(); }
+inline bool UnknownFieldSet::empty() const {
+  return fields_.empty() && raw_ == nullptr;
+}
 
 inline void UnknownFieldSet::Swap(UnknownFieldSet* x) {
   fields_.swap(x->fields_);
+  std::swap(raw_, x->raw_);
+  bool decoded = decoded_.load(std::memory_order_relaxed);
+  decoded_.store(x->decoded_.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  x->decoded_.store(decoded, std::memory_order_relaxed);
 }
 
 inline int UnknownFieldSet::field_count() const {
+  if (PROTOBUF_PREDICT_FALSE(NeedsDecoding())) DecodeRaw();
   return static_cast<int>(fields_.size());
 }
 inline const UnknownField& UnknownFieldSet::field(int index) const {
+  if (PROTOBUF_PREDICT_FALSE(NeedsDecoding())) DecodeRaw();
   return (fields_)[static_cast<size_t>(index)];
 }
 inline UnknownField* UnknownFieldSet::mutable_field(int index) {
+  DropRaw();
   return &(fields_)[static_cast<size_t>(index)];
 }
 
@@ -646,6 +646,89 @@ TEST_F(UnknownFieldSetTest, DeleteByNumber) {
                       MAKE_VECTOR(kExpectedFieldNumbers5));
 }
 #undef MAKE_VECTOR
+
+// Parses "data" into "message" with lazy unknown field parsing.
+bool ParseLazily(const std::string& data, Message* message) {
+  UnknownFieldSet::SetLazyParsing(true);
+  bool ok = message->ParseFromString(data);
+  UnknownFieldSet::SetLazyParsing(false);
+  return ok;
+}
+
+TEST_F(UnknownFieldSetTest, LazyParsing) {
+  unittest::TestEmptyMessage lazy;
+  ASSERT_TRUE(ParseLazily(all_fields_data_, &lazy));
+
+  // The fields are written back out as they were read.
+  EXPECT_FALSE(lazy.unknown_fields().empty());
+  EXPECT_EQ(all_fields_data_.size(), lazy.ByteSizeLong());
+  EXPECT_EQ(all_fields_data_, lazy.SerializeAsString());
+
+  // Looking at them decodes them.
+  const UnknownFieldSet& fields = lazy.unknown_fields();
+  ASSERT_EQ(unknown_fields_->field_count(), fields.field_count());
+  for (int i = 0; i < fields.field_count(); i++) {
+    EXPECT_EQ(unknown_fields_->field(i).number(), fields.field(i).number());
+    EXPECT_EQ(unknown_fields_->field(i).type(), fields.field(i).type());
+  }
+  EXPECT_EQ(all_fields_data_, lazy.SerializeAsString());
+
+  // Modifying them makes the decoded fields the only copy.
+  lazy.mutable_unknown_fields()->AddVarint(123456, 654321);
+  unknown_fields_->AddVarint(123456, 654321);
+  EXPECT_EQ(empty_message_.SerializeAsString(), lazy.SerializeAsString());
+  EXPECT_EQ(empty_message_.ByteSizeLong(), lazy.ByteSizeLong());
+}
+
+TEST_F(UnknownFieldSetTest, LazyParsingMerge) {
+  unittest::TestEmptyMessage lazy;
+  ASSERT_TRUE(ParseLazily(all_fields_data_, &lazy));
+  unittest::TestEmptyMessage other;
+  ASSERT_TRUE(ParseLazily(all_fields_data_, &other));
+
+  // Undecoded fields are appended as bytes.
+  lazy.MergeFrom(other);
+  EXPECT_EQ(all_fields_data_ + all_fields_data_, lazy.SerializeAsString());
+  EXPECT_EQ(2 * unknown_fields_->field_count(),
+            lazy.unknown_fields().field_count());
+
+  // Merging into decoded fields decodes the merged ones.
+  int field_count = unknown_fields_->field_count();
+  empty_message_.MergeFrom(other);
+  EXPECT_EQ(all_fields_data_ + all_fields_data_,
+            empty_message_.SerializeAsString());
+
+  // Parsing more fields into a decoded set decodes them too.
+  ASSERT_TRUE(ParseLazily(all_fields_data_, &other));
+  ASSERT_EQ(field_count, other.unknown_fields().field_count());
+  UnknownFieldSet::SetLazyParsing(true);
+  bool ok = other.MergeFromString(all_fields_data_);
+  UnknownFieldSet::SetLazyParsing(false);
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(all_fields_data_ + all_fields_data_, other.SerializeAsString());
+
+  unittest::TestEmptyMessage copy(lazy);
+  EXPECT_EQ(lazy.SerializeAsString(), copy.SerializeAsString());
+  copy.Clear();
+  EXPECT_TRUE(copy.unknown_fields().empty());
+  copy.Swap(&lazy);
+  EXPECT_TRUE(lazy.unknown_fields().empty());
+  EXPECT_EQ(all_fields_data_ + all_fields_data_, copy.SerializeAsString());
+}
+
+TEST_F(UnknownFieldSetTest, LazyParsingWithKnownFields) {
+  // ForeignMessage knows fields 1 and 2; everything else is unknown.
+  unittest::ForeignMessage eager;
+  ASSERT_TRUE(eager.ParseFromString(all_fields_data_));
+  unittest::ForeignMessage lazy;
+  ASSERT_TRUE(ParseLazily(all_fields_data_, &lazy));
+
+  EXPECT_EQ(eager.c(), lazy.c());
+  EXPECT_EQ(eager.SerializeAsString(), lazy.SerializeAsString());
+  EXPECT_EQ(eager.ByteSizeLong(), lazy.ByteSizeLong());
+  EXPECT_GT(lazy.unknown_fields().SpaceUsedExcludingSelfLong(), 0);
+  EXPECT_EQ(eager.DebugString(), lazy.DebugString());
+}
 }  // namespace
 
 }  // namespace protobuf
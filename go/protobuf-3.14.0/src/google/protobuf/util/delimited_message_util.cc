@@ -32,8 +32,16 @@
 // See https://github.com/protocolbuffers/protobuf/pull/710 for details.
 
 #include <google/protobuf/util/delimited_message_util.h>
+
+#include <climits>
+
 #include <google/protobuf/io/coded_stream.h>
 
+#if HAVE_ZLIB
+#include <string.h>
+#include <zlib.h>
+#endif  // HAVE_ZLIB
+
 namespace google {
 namespace protobuf {
 namespace util {
@@ -87,6 +95,47 @@ bool ParseDelimitedFromCodedStream(MessageLite* message,
   return true;
 }
 
+namespace {
+// DelimitedMessageReader starts over with a new CodedInputStream once it has
+// read this many bytes, well below the stream's INT_MAX position limit.
+static const int kMaxBytesPerCodedStream = 1 << 30;
+}  // namespace
+
+DelimitedMessageReader::DelimitedMessageReader(io::ZeroCopyInputStream* input)
+    : raw_input_(input),
+      input_(new io::CodedInputStream(input)),
+      clean_eof_(false) {}
+
+DelimitedMessageReader::~DelimitedMessageReader() {}
+
+void DelimitedMessageReader::MaybeResetInput() {
+  if (input_->CurrentPosition() < kMaxBytesPerCodedStream) return;
+  // Destroying the old stream backs up its unread buffer into raw_input_.
+  input_.reset();
+  input_.reset(new io::CodedInputStream(raw_input_));
+}
+
+bool DelimitedMessageReader::Read(MessageLite* message) {
+  MaybeResetInput();
+  return ParseDelimitedFromCodedStream(message, input_.get(), &clean_eof_);
+}
+
+int DelimitedMessageReader::ReadBatch(const MessageLite& prototype,
+                                      Arena* arena, int max_messages,
+                                      std::vector<MessageLite*>* messages) {
+  int count = 0;
+  while (count < max_messages) {
+    MessageLite* message = prototype.New(arena);
+    if (!Read(message)) {
+      if (arena == NULL) delete message;
+      break;
+    }
+    messages->push_back(message);
+    count++;
+  }
+  return count;
+}
+
 bool SerializeDelimitedToZeroCopyStream(const MessageLite& message,
                                         io::ZeroCopyOutputStream* output) {
   io::CodedOutputStream coded_output(output);
@@ -116,6 +165,82 @@ bool SerializeDelimitedToCodedStream(const MessageLite& message,
   return true;
 }
 
+#if HAVE_ZLIB
+namespace {
+
+// Inflates a complete zlib or gzip stream. Unlike GzipInputStream, this
+// fails if the stream is truncated or followed by other data.
+bool UncompressRecord(const std::string& compressed,
+                      const std::string& dictionary, std::string* output) {
+  z_stream zcontext;
+  memset(&zcontext, 0, sizeof(zcontext));
+  // Detect the zlib or gzip header automatically.
+  if (inflateInit2(&zcontext, /* windowBits */ 15 | 32) != Z_OK) return false;
+  zcontext.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  zcontext.avail_in = compressed.size();
+
+  Bytef buffer[8192];
+  int error = Z_OK;
+  while (error == Z_OK) {
+    zcontext.next_out = buffer;
+    zcontext.avail_out = sizeof(buffer);
+    error = inflate(&zcontext, Z_NO_FLUSH);
+    if (error == Z_NEED_DICT && !dictionary.empty()) {
+      error = inflateSetDictionary(
+          &zcontext, reinterpret_cast<const Bytef*>(dictionary.data()),
+          dictionary.size());
+    }
+    output->append(reinterpret_cast<char*>(buffer),
+                   sizeof(buffer) - zcontext.avail_out);
+    if (output->size() > INT_MAX) error = Z_DATA_ERROR;
+  }
+  inflateEnd(&zcontext);
+  return error == Z_STREAM_END && zcontext.avail_in == 0;
+}
+
+}  // namespace
+
+bool SerializeCompressedDelimitedToZeroCopyStream(
+    const MessageLite& message, const io::GzipOutputStream::Options& options,
+    io::ZeroCopyOutputStream* output) {
+  std::string compressed;
+  {
+    io::StringOutputStream string_output(&compressed);
+    io::GzipOutputStream gzip_output(&string_output, options);
+    if (!message.SerializeToZeroCopyStream(&gzip_output)) return false;
+    if (!gzip_output.Close()) return false;
+  }
+  if (compressed.size() > INT_MAX) return false;
+
+  io::CodedOutputStream coded_output(output);
+  coded_output.WriteVarint32(compressed.size());
+  coded_output.WriteString(compressed);
+  return !coded_output.HadError();
+}
+
+bool ParseCompressedDelimitedFromZeroCopyStream(MessageLite* message,
+                                                const std::string& dictionary,
+                                                io::ZeroCopyInputStream* input,
+                                                bool* clean_eof) {
+  if (clean_eof != NULL) *clean_eof = false;
+  io::CodedInputStream coded_input(input);
+
+  // Read the size.
+  uint32 size;
+  if (!coded_input.ReadVarint32(&size)) {
+    if (clean_eof != NULL) *clean_eof = coded_input.CurrentPosition() == 0;
+    return false;
+  }
+
+  std::string compressed;
+  if (!coded_input.ReadString(&compressed, size)) return false;
+  std::string serialized;
+  if (!UncompressRecord(compressed, dictionary, &serialized)) return false;
+  return message->MergeFromString(serialized);
+}
+#endif  // HAVE_ZLIB
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -35,10 +35,15 @@
 #define GOOGLE_PROTOBUF_UTIL_DELIMITED_MESSAGE_UTIL_H__
 
 
+#include <memory>
 #include <ostream>
+#include <string>
+#include <vector>
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/message_lite.h>
 #include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/gzip_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
 #include <google/protobuf/port_def.inc>
@@ -88,6 +93,48 @@ bool PROTOBUF_EXPORT ParseDelimitedFromCodedStream(MessageLite* message,
                                                    io::CodedInputStream* input,
                                                    bool* clean_eof);
 
+// Reads a sequence of size-delimited messages from a stream, as written by
+// SerializeDelimitedToZeroCopyStream(). Calling
+// ParseDelimitedFromZeroCopyStream() in a loop sets up a new CodedInputStream
+// for every message; this reader keeps one for as long as it can, and can
+// parse many messages in one call.
+//
+// The reader must be the only user of |input| while it exists. Destroying the
+// reader backs up any buffered data that was not consumed, so |input| can be
+// used again afterwards.
+class PROTOBUF_EXPORT DelimitedMessageReader {
+ public:
+  explicit DelimitedMessageReader(io::ZeroCopyInputStream* input);
+  ~DelimitedMessageReader();
+
+  // Reads the next message and merges it into |message|. Returns false at the
+  // end of the stream or on error; clean_eof() tells the two apart.
+  bool Read(MessageLite* message);
+
+  // Reads up to |max_messages| messages, each into a new object created with
+  // prototype.New(arena), and appends them to |messages|. If |arena| is NULL
+  // the caller owns the new messages. Returns the number of messages read,
+  // which is less than |max_messages| only at the end of the stream or on
+  // error. A message that failed to parse is not returned.
+  int ReadBatch(const MessageLite& prototype, Arena* arena, int max_messages,
+                std::vector<MessageLite*>* messages);
+
+  // True if the last read stopped because the stream ended, rather than
+  // because of an error or a truncated message.
+  bool clean_eof() const { return clean_eof_; }
+
+ private:
+  // Recreates input_ before its byte count reaches CodedInputStream's 2 GB
+  // limit.
+  void MaybeResetInput();
+
+  io::ZeroCopyInputStream* const raw_input_;
+  std::unique_ptr<io::CodedInputStream> input_;
+  bool clean_eof_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(DelimitedMessageReader);
+};
+
 // Write a single size-delimited message from the given stream. Delimited
 // format allows a single file or stream to contain multiple messages,
 // whereas normally writing multiple non-delimited messages to the same
@@ -99,6 +146,27 @@ bool PROTOBUF_EXPORT SerializeDelimitedToZeroCopyStream(
 bool PROTOBUF_EXPORT SerializeDelimitedToCodedStream(
     const MessageLite& message, io::CodedOutputStream* output);
 
+// Like SerializeDelimitedToZeroCopyStream(), but compresses each message on
+// its own: the varint prefix holds the size of the compressed data, which is
+// followed by the message compressed with a GzipOutputStream using |options|.
+// Records stay independent, so they can be read or skipped one at a time.
+// For small messages, the ZLIB format with a preset dictionary (see
+// GzipOutputStream::Options::dictionary) gives much better ratios. To
+// compress a whole block of messages instead, wrap the stream in a
+// GzipOutputStream and use SerializeDelimitedToZeroCopyStream(). Like
+// GzipOutputStream, this is only defined when protobuf is built with zlib.
+bool PROTOBUF_EXPORT SerializeCompressedDelimitedToZeroCopyStream(
+    const MessageLite& message, const io::GzipOutputStream::Options& options,
+    io::ZeroCopyOutputStream* output);
+
+// Reads a message written by SerializeCompressedDelimitedToZeroCopyStream()
+// and merges it into |message|. |dictionary| must be the dictionary the
+// message was compressed with, or empty. |clean_eof| behaves as in
+// ParseDelimitedFromZeroCopyStream().
+bool PROTOBUF_EXPORT ParseCompressedDelimitedFromZeroCopyStream(
+    MessageLite* message, const std::string& dictionary,
+    io::ZeroCopyInputStream* input, bool* clean_eof);
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -82,6 +82,150 @@ TEST(DelimitedMessageUtilTest, DelimitedMessages) {
   }
 }
 
+TEST(DelimitedMessageUtilTest, DelimitedMessageReader) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    for (int i = 0; i < 10; i++) {
+      protobuf_unittest::TestAllTypes message;
+      message.set_optional_int32(i);
+      message.add_repeated_string(std::string(i * 1000, 'x'));
+      EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+    }
+  }
+
+  // Small blocks make messages straddle buffer boundaries.
+  io::ArrayInputStream input(data.data(), data.size(), 100);
+  DelimitedMessageReader reader(&input);
+
+  protobuf_unittest::TestAllTypes first;
+  ASSERT_TRUE(reader.Read(&first));
+  EXPECT_EQ(0, first.optional_int32());
+
+  Arena arena;
+  std::vector<MessageLite*> messages;
+  const auto& prototype = protobuf_unittest::TestAllTypes::default_instance();
+  EXPECT_EQ(4, reader.ReadBatch(prototype, &arena, 4, &messages));
+  EXPECT_EQ(5, reader.ReadBatch(prototype, &arena, 100, &messages));
+  EXPECT_TRUE(reader.clean_eof());
+  ASSERT_EQ(9, messages.size());
+  for (int i = 0; i < 9; i++) {
+    const auto* message =
+        static_cast<protobuf_unittest::TestAllTypes*>(messages[i]);
+    EXPECT_EQ(&arena, message->GetArena());
+    EXPECT_EQ(i + 1, message->optional_int32());
+    EXPECT_EQ((i + 1) * 1000, message->repeated_string(0).size());
+  }
+}
+
+TEST(DelimitedMessageUtilTest, DelimitedMessageReaderTruncated) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    protobuf_unittest::TestAllTypes message;
+    TestUtil::SetAllFields(&message);
+    EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+    EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+  }
+  data.resize(data.size() - 10);
+
+  io::ArrayInputStream input(data.data(), data.size());
+  DelimitedMessageReader reader(&input);
+  std::vector<MessageLite*> messages;
+  EXPECT_EQ(1, reader.ReadBatch(
+                   protobuf_unittest::TestAllTypes::default_instance(),
+                   nullptr, 2, &messages));
+  EXPECT_FALSE(reader.clean_eof());
+  ASSERT_EQ(1, messages.size());
+  TestUtil::ExpectAllFieldsSet(
+      *static_cast<protobuf_unittest::TestAllTypes*>(messages[0]));
+  delete messages[0];
+}
+
+#if HAVE_ZLIB
+TEST(DelimitedMessageUtilTest, CompressedDelimitedMessages) {
+  protobuf_unittest::TestAllTypes all_fields;
+  TestUtil::SetAllFields(&all_fields);
+  io::GzipOutputStream::Options options;
+  options.format = io::GzipOutputStream::ZLIB;
+  options.dictionary = all_fields.SerializeAsString();
+
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    for (int i = 0; i < 10; i++) {
+      protobuf_unittest::TestAllTypes message;
+      TestUtil::SetAllFields(&message);
+      message.set_optional_int32(i);
+      EXPECT_TRUE(
+          SerializeCompressedDelimitedToZeroCopyStream(message, options,
+                                                       &output));
+    }
+  }
+  // The dictionary holds nearly all of each message.
+  EXPECT_LT(data.size(), options.dictionary.size());
+
+  io::ArrayInputStream input(data.data(), data.size(), 100);
+  bool clean_eof;
+  for (int i = 0; i < 10; i++) {
+    protobuf_unittest::TestAllTypes message;
+    ASSERT_TRUE(ParseCompressedDelimitedFromZeroCopyStream(
+        &message, options.dictionary, &input, &clean_eof));
+    EXPECT_EQ(i, message.optional_int32());
+    EXPECT_EQ(all_fields.optional_string(), message.optional_string());
+  }
+  protobuf_unittest::TestAllTypes message;
+  EXPECT_FALSE(ParseCompressedDelimitedFromZeroCopyStream(
+      &message, options.dictionary, &input, &clean_eof));
+  EXPECT_TRUE(clean_eof);
+}
+
+TEST(DelimitedMessageUtilTest, CompressedDelimitedMessageErrors) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  io::GzipOutputStream::Options options;
+  options.format = io::GzipOutputStream::ZLIB;
+  options.dictionary = "optional_string";
+
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    EXPECT_TRUE(
+        SerializeCompressedDelimitedToZeroCopyStream(message, options,
+                                                     &output));
+  }
+
+  bool clean_eof;
+  protobuf_unittest::TestAllTypes parsed;
+  {
+    // Wrong dictionary.
+    io::ArrayInputStream input(data.data(), data.size());
+    EXPECT_FALSE(ParseCompressedDelimitedFromZeroCopyStream(
+        &parsed, "", &input, &clean_eof));
+    EXPECT_FALSE(clean_eof);
+  }
+  {
+    // Compressed data cut short, with a matching size prefix.
+    io::CodedInputStream coded_input(
+        reinterpret_cast<const uint8*>(data.data()), data.size());
+    uint32 size;
+    std::string truncated;
+    ASSERT_TRUE(coded_input.ReadVarint32(&size));
+    ASSERT_TRUE(coded_input.ReadString(&truncated, size - 10));
+    std::string record;
+    {
+      io::StringOutputStream output(&record);
+      io::CodedOutputStream coded_output(&output);
+      coded_output.WriteVarint32(truncated.size());
+      coded_output.WriteString(truncated);
+    }
+    io::ArrayInputStream input(record.data(), record.size());
+    EXPECT_FALSE(ParseCompressedDelimitedFromZeroCopyStream(
+        &parsed, options.dictionary, &input, &clean_eof));
+  }
+}
+#endif  // HAVE_ZLIB
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -0,0 +1,348 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <google/protobuf/util/field_extractor.h>
+
+#include <algorithm>
+
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/parse_context.h>
+#include <google/protobuf/wire_format_lite.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::ParseContext;
+using internal::WireFormatLite;
+
+int32 FieldExtractor::Value::GetInt32() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_INT32);
+  if (field_->type() == FieldDescriptor::TYPE_SINT32) {
+    return WireFormatLite::ZigZagDecode32(static_cast<uint32>(bits_));
+  }
+  return static_cast<int32>(bits_);
+}
+
+int64 FieldExtractor::Value::GetInt64() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_INT64);
+  if (field_->type() == FieldDescriptor::TYPE_SINT64) {
+    return WireFormatLite::ZigZagDecode64(bits_);
+  }
+  return static_cast<int64>(bits_);
+}
+
+uint32 FieldExtractor::Value::GetUInt32() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_UINT32);
+  return static_cast<uint32>(bits_);
+}
+
+uint64 FieldExtractor::Value::GetUInt64() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_UINT64);
+  return bits_;
+}
+
+float FieldExtractor::Value::GetFloat() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_FLOAT);
+  return WireFormatLite::DecodeFloat(static_cast<uint32>(bits_));
+}
+
+double FieldExtractor::Value::GetDouble() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_DOUBLE);
+  return WireFormatLite::DecodeDouble(bits_);
+}
+
+bool FieldExtractor::Value::GetBool() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_BOOL);
+  return bits_ != 0;
+}
+
+int FieldExtractor::Value::GetEnumValue() const {
+  GOOGLE_DCHECK_EQ(field_->cpp_type(), FieldDescriptor::CPPTYPE_ENUM);
+  return static_cast<int>(bits_);
+}
+
+FieldExtractor::FieldExtractor() : descriptor_(NULL) {}
+
+FieldExtractor::~FieldExtractor() {}
+
+bool FieldExtractor::Init(const Descriptor* descriptor,
+                          const std::vector<std::string>& paths) {
+  descriptor_ = NULL;
+  nodes_.clear();
+  last_value_only_.clear();
+
+  std::vector<Node> nodes(1);
+  std::vector<bool> last_value_only;
+  for (int i = 0; i < paths.size(); i++) {
+    std::vector<std::string> names = Split(paths[i], ".", false);
+    int node = 0;
+    const Descriptor* type = descriptor;
+    bool repeated = false;
+    for (int j = 0; j < names.size(); j++) {
+      const FieldDescriptor* field =
+          type == NULL ? NULL : type->FindFieldByName(names[j]);
+      if (field == NULL) return false;
+      repeated = repeated || field->is_repeated();
+
+      std::vector<Entry>& entries = nodes[node].entries;
+      std::vector<Entry>::iterator it = std::lower_bound(
+          entries.begin(), entries.end(), field->number(),
+          [](const Entry& entry, int number) {
+            return entry.field->number() < number;
+          });
+      if (it == entries.end() || it->field != field) {
+        Entry entry;
+        entry.field = field;
+        entry.child = -1;
+        it = entries.insert(it, entry);
+      }
+
+      if (j + 1 == names.size()) {
+        if (field->type() == FieldDescriptor::TYPE_GROUP) return false;
+        it->paths.push_back(i);
+        last_value_only.push_back(
+            !repeated && field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE);
+      } else {
+        if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+          return false;
+        }
+        if (it->child < 0) {
+          it->child = nodes.size();
+          node = it->child;
+          // Invalidates "it" and "entries".
+          nodes.push_back(Node());
+        } else {
+          node = it->child;
+        }
+        type = field->message_type();
+      }
+    }
+  }
+
+  descriptor_ = descriptor;
+  nodes_.swap(nodes);
+  last_value_only_.swap(last_value_only);
+  return true;
+}
+
+const FieldExtractor::Entry* FieldExtractor::Find(int node,
+                                                  int number) const {
+  const std::vector<Entry>& entries = nodes_[node].entries;
+  std::vector<Entry>::const_iterator it = std::lower_bound(
+      entries.begin(), entries.end(), number,
+      [](const Entry& entry, int number) {
+        return entry.field->number() < number;
+      });
+  if (it == entries.end() || it->field->number() != number) return NULL;
+  return &*it;
+}
+
+bool FieldExtractor::Extract(StringPiece data,
+                             std::vector<std::vector<Value> >* values) const {
+  GOOGLE_DCHECK(descriptor_ != NULL) << "Extract() called before Init().";
+  if (descriptor_ == NULL) return false;
+  values->resize(last_value_only_.size());
+  for (int i = 0; i < values->size(); i++) {
+    (*values)[i].clear();
+  }
+  return ScanMessage(0, data, io::CodedInputStream::GetDefaultRecursionLimit(),
+                     values);
+}
+
+bool FieldExtractor::ScanMessage(
+    int node, StringPiece data, int depth,
+    std::vector<std::vector<Value> >* values) const {
+  // With aliasing on, length-delimited values are views of "data" rather than
+  // of the context's patch buffer.
+  const char* ptr;
+  ParseContext ctx(depth, true, &ptr, data);
+  ptr = Scan(node, ptr, &ctx, depth, values);
+  return ptr != NULL && ctx.EndedAtLimit();
+}
+
+const char* FieldExtractor::Scan(
+    int node, const char* ptr, ParseContext* ctx, int depth,
+    std::vector<std::vector<Value> >* values) const {
+  while (!ctx->Done(&ptr)) {
+    uint32 tag;
+    ptr = internal::ReadTag(ptr, &tag);
+    if (ptr == NULL) return NULL;
+    if (tag == 0 || WireFormatLite::GetTagWireType(tag) ==
+                        WireFormatLite::WIRETYPE_END_GROUP) {
+      ctx->SetLastTag(tag);
+      return ptr;
+    }
+    const Entry* entry =
+        node < 0 ? NULL : Find(node, WireFormatLite::GetTagFieldNumber(tag));
+    if (entry == NULL) {
+      ptr = SkipField(tag, ptr, ctx, depth);
+    } else {
+      ptr = ScanField(*entry, tag, ptr, ctx, depth, values);
+    }
+    if (ptr == NULL) return NULL;
+  }
+  return ptr;
+}
+
+const char* FieldExtractor::ScanField(
+    const Entry& entry, uint32 tag, const char* ptr, ParseContext* ctx,
+    int depth, std::vector<std::vector<Value> >* values) const {
+  const WireFormatLite::WireType wire_type =
+      WireFormatLite::GetTagWireType(tag);
+  const WireFormatLite::WireType expected_wire_type =
+      WireFormatLite::WireTypeForFieldType(
+          static_cast<WireFormatLite::FieldType>(entry.field->type()));
+  // Bytes read through ReadStringPiece() only land here when the input is
+  // truncated, in which case the read fails anyway.
+  std::string scratch;
+
+  if (wire_type == expected_wire_type) {
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        uint64 bits = internal::ReadVarint64(&ptr);
+        if (ptr == NULL) return NULL;
+        AddValue(entry, bits, StringPiece(), values);
+        return ptr;
+      }
+      case WireFormatLite::WIRETYPE_FIXED64:
+        AddValue(entry, internal::UnalignedLoad<uint64>(ptr), StringPiece(),
+                 values);
+        return ptr + sizeof(uint64);
+      case WireFormatLite::WIRETYPE_FIXED32:
+        AddValue(entry, internal::UnalignedLoad<uint32>(ptr), StringPiece(),
+                 values);
+        return ptr + sizeof(uint32);
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        int size = internal::ReadSize(&ptr);
+        if (ptr == NULL) return NULL;
+        StringPiece bytes;
+        ptr = ctx->ReadStringPiece(ptr, size, &bytes, &scratch);
+        if (ptr == NULL) return NULL;
+        if (!entry.paths.empty()) AddValue(entry, 0, bytes, values);
+        if (entry.child >= 0 &&
+            (depth <= 0 ||
+             !ScanMessage(entry.child, bytes, depth - 1, values))) {
+          return NULL;
+        }
+        return ptr;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        if (depth <= 0) return NULL;
+        ptr = Scan(entry.child, ptr, ctx, depth - 1, values);
+        if (ptr == NULL || !ctx->ConsumeEndGroup(tag)) return NULL;
+        return ptr;
+      default:
+        return NULL;
+    }
+  }
+
+  // Packed repeated field; parsers accept these whether or not the field is
+  // declared packed.
+  if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+      entry.field->is_packable()) {
+    if (expected_wire_type == WireFormatLite::WIRETYPE_VARINT) {
+      return ctx->ReadPackedVarint(ptr, [&](uint64 bits) {
+        AddValue(entry, bits, StringPiece(), values);
+      });
+    }
+    int size = internal::ReadSize(&ptr);
+    if (ptr == NULL) return NULL;
+    StringPiece bytes;
+    ptr = ctx->ReadStringPiece(ptr, size, &bytes, &scratch);
+    if (ptr == NULL) return NULL;
+    if (expected_wire_type == WireFormatLite::WIRETYPE_FIXED64) {
+      if (bytes.size() % sizeof(uint64) != 0) return NULL;
+      for (const char* p = bytes.data(); p < bytes.data() + bytes.size();
+           p += sizeof(uint64)) {
+        AddValue(entry, internal::UnalignedLoad<uint64>(p), StringPiece(),
+                 values);
+      }
+    } else {
+      if (bytes.size() % sizeof(uint32) != 0) return NULL;
+      for (const char* p = bytes.data(); p < bytes.data() + bytes.size();
+           p += sizeof(uint32)) {
+        AddValue(entry, internal::UnalignedLoad<uint32>(p), StringPiece(),
+                 values);
+      }
+    }
+    return ptr;
+  }
+
+  // A wire type the field can't have; a parser keeps it as an unknown field.
+  return SkipField(tag, ptr, ctx, depth);
+}
+
+const char* FieldExtractor::SkipField(uint32 tag, const char* ptr,
+                                      ParseContext* ctx, int depth) const {
+  switch (WireFormatLite::GetTagWireType(tag)) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      internal::ReadVarint64(&ptr);
+      return ptr;
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return ptr + sizeof(uint64);
+    case WireFormatLite::WIRETYPE_FIXED32:
+      return ptr + sizeof(uint32);
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      int size = internal::ReadSize(&ptr);
+      if (ptr == NULL) return NULL;
+      return ctx->Skip(ptr, size);
+    }
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      if (depth <= 0) return NULL;
+      ptr = Scan(-1, ptr, ctx, depth - 1, NULL);
+      if (ptr == NULL || !ctx->ConsumeEndGroup(tag)) return NULL;
+      return ptr;
+    default:
+      return NULL;
+  }
+}
+
+void FieldExtractor::AddValue(const Entry& entry, uint64 bits,
+                              StringPiece bytes,
+                              std::vector<std::vector<Value> >* values) const {
+  for (int i = 0; i < entry.paths.size(); i++) {
+    const int path = entry.paths[i];
+    std::vector<Value>& path_values = (*values)[path];
+    if (path_values.empty() || !last_value_only_[path]) {
+      path_values.push_back(Value());
+    }
+    Value& value = path_values.back();
+    value.field_ = entry.field;
+    value.bits_ = bits;
+    value.bytes_ = bytes;
+  }
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,183 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Reads a few fields out of a serialized message without parsing it.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_FIELD_EXTRACTOR_H__
+#define GOOGLE_PROTOBUF_UTIL_FIELD_EXTRACTOR_H__
+
+#include <string>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stringpiece.h>
+#include <google/protobuf/descriptor.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+class ParseContext;
+}  // namespace internal
+
+namespace util {
+
+// Extracts the values of a fixed set of fields from serialized messages of
+// one type. Fields that are not asked for are skipped by their length, and
+// no message is ever created, so extracting an ID from a large message costs
+// little more than reading its tags. Example:
+//
+//   FieldExtractor extractor;
+//   GOOGLE_CHECK(extractor.Init(Request::descriptor(),
+//                        {"header.request_id", "routing_key"}));
+//   std::vector<std::vector<FieldExtractor::Value> > values;
+//   if (extractor.Extract(serialized, &values) && !values[1].empty()) {
+//     Route(values[1].back().GetString());
+//   }
+//
+// A FieldExtractor is immutable after Init() and may be used from several
+// threads at once.
+class PROTOBUF_EXPORT FieldExtractor {
+ public:
+  // A value of a field read off the wire.
+  class PROTOBUF_EXPORT Value {
+   public:
+    Value() : field_(NULL), bits_(0) {}
+
+    // The field this is a value of.
+    const FieldDescriptor* field() const { return field_; }
+
+    // Typed accessors. Each one must be called on a value of the matching
+    // cpp_type(), like the corresponding Reflection getter.
+    int32 GetInt32() const;
+    int64 GetInt64() const;
+    uint32 GetUInt32() const;
+    uint64 GetUInt64() const;
+    float GetFloat() const;
+    double GetDouble() const;
+    bool GetBool() const;
+    int GetEnumValue() const;
+    // For string and bytes fields, and for message fields, whose value is the
+    // serialized sub-message. The bytes point into the data passed to
+    // Extract(), which must outlive them.
+    StringPiece GetString() const { return bytes_; }
+
+   private:
+    friend class FieldExtractor;
+
+    const FieldDescriptor* field_;
+    // The varint or fixed-width value as it was encoded.
+    uint64 bits_;
+    StringPiece bytes_;
+  };
+
+  FieldExtractor();
+  ~FieldExtractor();
+
+  // Resolves "paths" against "descriptor". A path is a dot-separated list of
+  // field names, as in a FieldMask; every field on it but the last must be a
+  // message (or group) field, and the last one must not be a group. Returns
+  // false and leaves the extractor empty if a path is invalid.
+  bool Init(const Descriptor* descriptor,
+            const std::vector<std::string>& paths);
+
+  // The type the extractor was initialized for, or NULL.
+  const Descriptor* descriptor() const { return descriptor_; }
+
+  // The number of paths given to Init().
+  int path_count() const { return static_cast<int>(last_value_only_.size()); }
+
+  // Scans the serialized message "data" and sets (*values)[i] to the values
+  // of path i, in the order they appear on the wire. A path whose fields are
+  // all singular, and which does not end at a message field, gets at most one
+  // value: the last one, which is the one a parser would keep. Any other path
+  // gets every value it finds, including each element of a packed field; in
+  // particular each occurrence of a sub-message is reported on its own rather
+  // than merged. Members of a oneof are reported independently of each other.
+  //
+  // The vectors in "values" are cleared but keep their capacity, so reusing
+  // "values" across calls avoids allocating. Returns false if "data" is not a
+  // valid serialized message; "values" is then unspecified.
+  bool Extract(StringPiece data,
+               std::vector<std::vector<Value> >* values) const;
+
+ private:
+  // A field of a Node that is on at least one path.
+  struct Entry {
+    const FieldDescriptor* field;
+    // The paths that end at this field.
+    std::vector<int> paths;
+    // The index in nodes_ of the fields below this one, or -1.
+    int child;
+  };
+
+  // The fields of one message type that are on a path, sorted by number.
+  struct Node {
+    std::vector<Entry> entries;
+  };
+
+  // Returns the entry of the field with the given number in nodes_[node], or
+  // NULL if that field is not on a path.
+  const Entry* Find(int node, int number) const;
+
+  // Scans the serialized message "data" for the fields of nodes_[node].
+  bool ScanMessage(int node, StringPiece data, int depth,
+                   std::vector<std::vector<Value> >* values) const;
+  // Scans fields for nodes_[node], or skips them if "node" is -1, until the
+  // end of the current limit or an END_GROUP or zero tag. Returns NULL on
+  // malformed input.
+  const char* Scan(int node, const char* ptr, internal::ParseContext* ctx,
+                   int depth, std::vector<std::vector<Value> >* values) const;
+  const char* ScanField(const Entry& entry, uint32 tag, const char* ptr,
+                        internal::ParseContext* ctx, int depth,
+                        std::vector<std::vector<Value> >* values) const;
+  const char* SkipField(uint32 tag, const char* ptr,
+                        internal::ParseContext* ctx, int depth) const;
+  void AddValue(const Entry& entry, uint64 bits, StringPiece bytes,
+                std::vector<std::vector<Value> >* values) const;
+
+  const Descriptor* descriptor_;
+  // nodes_[0] is the root.
+  std::vector<Node> nodes_;
+  // For each path, whether it keeps only its last value.
+  std::vector<bool> last_value_only_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(FieldExtractor);
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_UTIL_FIELD_EXTRACTOR_H__
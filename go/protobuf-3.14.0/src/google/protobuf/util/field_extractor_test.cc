@@ -0,0 +1,259 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <google/protobuf/util/field_extractor.h>
+
+#include <string>
+#include <vector>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::NestedTestAllTypes;
+using protobuf_unittest::TestAllTypes;
+using protobuf_unittest::TestPackedTypes;
+
+typedef std::vector<std::vector<FieldExtractor::Value> > Values;
+
+TEST(FieldExtractorTest, ScalarFields) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(
+      TestAllTypes::descriptor(),
+      {"optional_int32", "optional_sint64", "optional_uint32",
+       "optional_fixed64", "optional_sfixed32", "optional_float",
+       "optional_double", "optional_bool", "optional_string", "optional_bytes",
+       "optional_nested_enum", "optional_nested_message.bb",
+       "optionalgroup.a"}));
+  EXPECT_EQ(13, extractor.path_count());
+
+  Values values;
+  ASSERT_TRUE(extractor.Extract(data, &values));
+  ASSERT_EQ(13, values.size());
+  for (int i = 0; i < values.size(); i++) {
+    ASSERT_EQ(1, values[i].size()) << i;
+  }
+  EXPECT_EQ(message.optional_int32(), values[0][0].GetInt32());
+  EXPECT_EQ(message.optional_sint64(), values[1][0].GetInt64());
+  EXPECT_EQ(message.optional_uint32(), values[2][0].GetUInt32());
+  EXPECT_EQ(message.optional_fixed64(), values[3][0].GetUInt64());
+  EXPECT_EQ(message.optional_sfixed32(), values[4][0].GetInt32());
+  EXPECT_EQ(message.optional_float(), values[5][0].GetFloat());
+  EXPECT_EQ(message.optional_double(), values[6][0].GetDouble());
+  EXPECT_EQ(message.optional_bool(), values[7][0].GetBool());
+  EXPECT_EQ(message.optional_string(), values[8][0].GetString());
+  EXPECT_EQ(message.optional_bytes(), values[9][0].GetString());
+  EXPECT_EQ(message.optional_nested_enum(), values[10][0].GetEnumValue());
+  EXPECT_EQ(message.optional_nested_message().bb(), values[11][0].GetInt32());
+  EXPECT_EQ(message.optionalgroup().a(), values[12][0].GetInt32());
+  EXPECT_EQ(TestAllTypes::descriptor()->FindFieldByName("optional_int32"),
+            values[0][0].field());
+}
+
+TEST(FieldExtractorTest, RepeatedFields) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(
+      TestAllTypes::descriptor(),
+      {"repeated_int64", "repeated_string", "repeated_nested_message.bb",
+       "repeated_nested_message"}));
+  Values values;
+  ASSERT_TRUE(extractor.Extract(data, &values));
+
+  ASSERT_EQ(message.repeated_int64_size(), values[0].size());
+  for (int i = 0; i < values[0].size(); i++) {
+    EXPECT_EQ(message.repeated_int64(i), values[0][i].GetInt64());
+  }
+  ASSERT_EQ(message.repeated_string_size(), values[1].size());
+  for (int i = 0; i < values[1].size(); i++) {
+    EXPECT_EQ(message.repeated_string(i), values[1][i].GetString());
+  }
+  ASSERT_EQ(message.repeated_nested_message_size(), values[2].size());
+  ASSERT_EQ(message.repeated_nested_message_size(), values[3].size());
+  for (int i = 0; i < values[2].size(); i++) {
+    EXPECT_EQ(message.repeated_nested_message(i).bb(),
+              values[2][i].GetInt32());
+    TestAllTypes::NestedMessage nested;
+    ASSERT_TRUE(nested.ParseFromString(std::string(values[3][i].GetString())));
+    EXPECT_EQ(message.repeated_nested_message(i).DebugString(),
+              nested.DebugString());
+  }
+}
+
+TEST(FieldExtractorTest, PackedFields) {
+  TestPackedTypes message;
+  TestUtil::SetPackedFields(&message);
+  std::string data = message.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(TestPackedTypes::descriptor(),
+                             {"packed_sint32", "packed_fixed64", "packed_float",
+                              "packed_enum"}));
+  Values values;
+  ASSERT_TRUE(extractor.Extract(data, &values));
+
+  ASSERT_EQ(message.packed_sint32_size(), values[0].size());
+  ASSERT_EQ(message.packed_fixed64_size(), values[1].size());
+  ASSERT_EQ(message.packed_float_size(), values[2].size());
+  ASSERT_EQ(message.packed_enum_size(), values[3].size());
+  for (int i = 0; i < message.packed_sint32_size(); i++) {
+    EXPECT_EQ(message.packed_sint32(i), values[0][i].GetInt32());
+    EXPECT_EQ(message.packed_fixed64(i), values[1][i].GetUInt64());
+    EXPECT_EQ(message.packed_float(i), values[2][i].GetFloat());
+    EXPECT_EQ(message.packed_enum(i), values[3][i].GetEnumValue());
+  }
+}
+
+TEST(FieldExtractorTest, LastValueWins) {
+  TestAllTypes first;
+  first.set_optional_int32(1);
+  first.mutable_optional_nested_message()->set_bb(10);
+  first.add_repeated_int32(100);
+  TestAllTypes second;
+  second.set_optional_int32(2);
+  second.mutable_optional_nested_message()->set_bb(20);
+  second.add_repeated_int32(200);
+  // Concatenated messages parse as their merge.
+  std::string data = first.SerializeAsString() + second.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(
+      TestAllTypes::descriptor(),
+      {"optional_int32", "optional_nested_message.bb", "repeated_int32",
+       "optional_nested_message"}));
+  Values values;
+  ASSERT_TRUE(extractor.Extract(data, &values));
+  ASSERT_EQ(1, values[0].size());
+  EXPECT_EQ(2, values[0][0].GetInt32());
+  ASSERT_EQ(1, values[1].size());
+  EXPECT_EQ(20, values[1][0].GetInt32());
+  ASSERT_EQ(2, values[2].size());
+  EXPECT_EQ(100, values[2][0].GetInt32());
+  EXPECT_EQ(200, values[2][1].GetInt32());
+  // Each occurrence of a sub-message is reported.
+  EXPECT_EQ(2, values[3].size());
+
+  // Reusing the vectors starts from scratch.
+  ASSERT_TRUE(extractor.Extract(first.SerializeAsString(), &values));
+  ASSERT_EQ(1, values[2].size());
+  EXPECT_EQ(100, values[2][0].GetInt32());
+}
+
+TEST(FieldExtractorTest, BytesPointIntoInput) {
+  NestedTestAllTypes message;
+  message.mutable_child()->mutable_payload()->set_optional_string(
+      std::string(1000, 'x'));
+  message.mutable_payload()->set_optional_string("short");
+  message.mutable_payload()->add_repeated_int32(7);
+  std::string data = message.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(
+      NestedTestAllTypes::descriptor(),
+      {"child.payload.optional_string", "payload.optional_string"}));
+  Values values;
+  ASSERT_TRUE(extractor.Extract(data, &values));
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(1, values[i].size());
+    StringPiece bytes = values[i][0].GetString();
+    EXPECT_GE(bytes.data(), data.data());
+    EXPECT_LE(bytes.data() + bytes.size(), data.data() + data.size());
+  }
+  EXPECT_EQ(std::string(1000, 'x'), values[0][0].GetString());
+  EXPECT_EQ("short", values[1][0].GetString());
+}
+
+TEST(FieldExtractorTest, MissingFields) {
+  TestAllTypes message;
+  message.set_optional_int64(5);
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(TestAllTypes::descriptor(),
+                             {"optional_int32", "optional_int64"}));
+  Values values;
+  ASSERT_TRUE(extractor.Extract(message.SerializeAsString(), &values));
+  EXPECT_TRUE(values[0].empty());
+  ASSERT_EQ(1, values[1].size());
+  EXPECT_EQ(5, values[1][0].GetInt64());
+  ASSERT_TRUE(extractor.Extract("", &values));
+  EXPECT_TRUE(values[1].empty());
+}
+
+TEST(FieldExtractorTest, InvalidPaths) {
+  FieldExtractor extractor;
+  EXPECT_FALSE(extractor.Init(TestAllTypes::descriptor(), {"no_such_field"}));
+  EXPECT_FALSE(
+      extractor.Init(TestAllTypes::descriptor(), {"optional_int32.foo"}));
+  EXPECT_FALSE(extractor.Init(TestAllTypes::descriptor(), {"optionalgroup"}));
+  EXPECT_FALSE(extractor.Init(TestAllTypes::descriptor(),
+                              {"optional_nested_message..bb"}));
+  EXPECT_TRUE(extractor.descriptor() == NULL);
+}
+
+TEST(FieldExtractorTest, MalformedInput) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  FieldExtractor extractor;
+  ASSERT_TRUE(extractor.Init(TestAllTypes::descriptor(),
+                             {"optional_nested_message.bb"}));
+  Values values;
+  // Every truncation of a message ends in the middle of a field except for
+  // those at field boundaries, so only check that nothing crashes and that
+  // the full input succeeds.
+  for (int i = 0; i < data.size(); i++) {
+    extractor.Extract(StringPiece(data.data(), i), &values);
+  }
+  EXPECT_TRUE(extractor.Extract(data, &values));
+  // A length that runs past the end.
+  EXPECT_FALSE(extractor.Extract(std::string("\x92\x01\x05\x08", 4), &values));
+  // An end-group tag without a start-group tag.
+  EXPECT_FALSE(extractor.Extract(std::string("\x0c", 1), &values));
+  // A zero tag.
+  EXPECT_FALSE(extractor.Extract(std::string("\x00", 1), &values));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -30,7 +30,11 @@
 
 #include <google/protobuf/util/field_mask_util.h>
 
+#include <algorithm>
+
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/message.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <google/protobuf/stubs/strutil.h>
 #include <google/protobuf/stubs/map_util.h>
 
@@ -170,6 +174,84 @@ void FieldMaskUtil::GetFieldMaskForAllFields(const Descriptor* descriptor,
 }
 
 namespace {
+
+// Merges the whole of "field" from one message to another.
+void MergeField(const Message& source, const FieldDescriptor* field,
+                const FieldMaskUtil::MergeOptions& options,
+                Message* destination) {
+  const Reflection* source_reflection = source.GetReflection();
+  const Reflection* destination_reflection = destination->GetReflection();
+  if (!field->is_repeated()) {
+    switch (field->cpp_type()) {
+#define COPY_VALUE(TYPE, Name)                                              \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
+    if (source_reflection->HasField(source, field)) {                       \
+      destination_reflection->Set##Name(                                    \
+          destination, field, source_reflection->Get##Name(source, field)); \
+    } else {                                                                \
+      destination_reflection->ClearField(destination, field);               \
+    }                                                                       \
+    break;                                                                  \
+  }
+      COPY_VALUE(BOOL, Bool)
+      COPY_VALUE(INT32, Int32)
+      COPY_VALUE(INT64, Int64)
+      COPY_VALUE(UINT32, UInt32)
+      COPY_VALUE(UINT64, UInt64)
+      COPY_VALUE(FLOAT, Float)
+      COPY_VALUE(DOUBLE, Double)
+      COPY_VALUE(ENUM, Enum)
+      COPY_VALUE(STRING, String)
+#undef COPY_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        if (options.replace_message_fields()) {
+          destination_reflection->ClearField(destination, field);
+        }
+        if (source_reflection->HasField(source, field)) {
+          destination_reflection->MutableMessage(destination, field)
+              ->MergeFrom(source_reflection->GetMessage(source, field));
+        }
+        break;
+      }
+    }
+  } else {
+    if (options.replace_repeated_fields()) {
+      destination_reflection->ClearField(destination, field);
+    }
+    switch (field->cpp_type()) {
+#define COPY_REPEATED_VALUE(TYPE, Name)                            \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
+    int size = source_reflection->FieldSize(source, field);        \
+    for (int i = 0; i < size; ++i) {                               \
+      destination_reflection->Add##Name(                           \
+          destination, field,                                      \
+          source_reflection->GetRepeated##Name(source, field, i)); \
+    }                                                              \
+    break;                                                         \
+  }
+      COPY_REPEATED_VALUE(BOOL, Bool)
+      COPY_REPEATED_VALUE(INT32, Int32)
+      COPY_REPEATED_VALUE(INT64, Int64)
+      COPY_REPEATED_VALUE(UINT32, UInt32)
+      COPY_REPEATED_VALUE(UINT64, UInt64)
+      COPY_REPEATED_VALUE(FLOAT, Float)
+      COPY_REPEATED_VALUE(DOUBLE, Double)
+      COPY_REPEATED_VALUE(ENUM, Enum)
+      COPY_REPEATED_VALUE(STRING, String)
+#undef COPY_REPEATED_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        int size = source_reflection->FieldSize(source, field);
+        for (int i = 0; i < size; ++i) {
+          destination_reflection->AddMessage(destination, field)
+              ->MergeFrom(
+                  source_reflection->GetRepeatedMessage(source, field, i));
+        }
+        break;
+      }
+    }
+  }
+}
+
 // A FieldMaskTree represents a FieldMask in a tree structure. For example,
 // given a FieldMask "foo.bar,foo.baz,bar.baz", the FieldMaskTree will be:
 //
@@ -478,75 +560,7 @@ void FieldMaskTree::MergeMessage(const Node* node, const Message& source,
                    destination_reflection->MutableMessage(destination, field));
       continue;
     }
-    if (!field->is_repeated()) {
-      switch (field->cpp_type()) {
-#define COPY_VALUE(TYPE, Name)                                              \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
-    if (source_reflection->HasField(source, field)) {                       \
-      destination_reflection->Set##Name(                                    \
-          destination, field, source_reflection->Get##Name(source, field)); \
-    } else {                                                                \
-      destination_reflection->ClearField(destination, field);               \
-    }                                                                       \
-    break;                                                                  \
-  }
-        COPY_VALUE(BOOL, Bool)
-        COPY_VALUE(INT32, Int32)
-        COPY_VALUE(INT64, Int64)
-        COPY_VALUE(UINT32, UInt32)
-        COPY_VALUE(UINT64, UInt64)
-        COPY_VALUE(FLOAT, Float)
-        COPY_VALUE(DOUBLE, Double)
-        COPY_VALUE(ENUM, Enum)
-        COPY_VALUE(STRING, String)
-#undef COPY_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          if (options.replace_message_fields()) {
-            destination_reflection->ClearField(destination, field);
-          }
-          if (source_reflection->HasField(source, field)) {
-            destination_reflection->MutableMessage(destination, field)
-                ->MergeFrom(source_reflection->GetMessage(source, field));
-          }
-          break;
-        }
-      }
-    } else {
-      if (options.replace_repeated_fields()) {
-        destination_reflection->ClearField(destination, field);
-      }
-      switch (field->cpp_type()) {
-#define COPY_REPEATED_VALUE(TYPE, Name)                            \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
-    int size = source_reflection->FieldSize(source, field);        \
-    for (int i = 0; i < size; ++i) {                               \
-      destination_reflection->Add##Name(                           \
-          destination, field,                                      \
-          source_reflection->GetRepeated##Name(source, field, i)); \
-    }                                                              \
-    break;                                                         \
-  }
-        COPY_REPEATED_VALUE(BOOL, Bool)
-        COPY_REPEATED_VALUE(INT32, Int32)
-        COPY_REPEATED_VALUE(INT64, Int64)
-        COPY_REPEATED_VALUE(UINT32, UInt32)
-        COPY_REPEATED_VALUE(UINT64, UInt64)
-        COPY_REPEATED_VALUE(FLOAT, Float)
-        COPY_REPEATED_VALUE(DOUBLE, Double)
-        COPY_REPEATED_VALUE(ENUM, Enum)
-        COPY_REPEATED_VALUE(STRING, String)
-#undef COPY_REPEATED_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          int size = source_reflection->FieldSize(source, field);
-          for (int i = 0; i < size; ++i) {
-            destination_reflection->AddMessage(destination, field)
-                ->MergeFrom(
-                    source_reflection->GetRepeatedMessage(source, field, i));
-          }
-          break;
-        }
-      }
-    }
+    MergeField(source, field, options, destination);
   }
 }
 
@@ -715,6 +729,258 @@ bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message,
   return tree.TrimMessage(GOOGLE_CHECK_NOTNULL(message));
 }
 
+// ===================================================================
+
+constexpr int FieldMaskUtil::CompiledFieldMask::kNotInMask;
+constexpr int FieldMaskUtil::CompiledFieldMask::kWholeField;
+
+FieldMaskUtil::CompiledFieldMask::Node::Node(const Descriptor* descriptor)
+    : descriptor(descriptor), by_index(descriptor->field_count(), kNotInMask) {}
+
+FieldMaskUtil::CompiledFieldMask::CompiledFieldMask()
+    : descriptor_(nullptr), root_(kNotInMask), required_root_(kNotInMask) {}
+
+FieldMaskUtil::CompiledFieldMask::~CompiledFieldMask() {}
+
+bool FieldMaskUtil::CompiledFieldMask::Compile(const Descriptor* descriptor,
+                                               const FieldMask& mask) {
+  descriptor_ = nullptr;
+  nodes_.clear();
+  root_ = kNotInMask;
+  required_root_ = kNotInMask;
+
+  // In canonical form no path is covered by another one, so every path ends
+  // in a field that is not in the mask yet.
+  FieldMask canonical_mask;
+  ToCanonicalForm(mask, &canonical_mask);
+  nodes_.emplace_back(descriptor);
+  std::vector<const FieldDescriptor*> fields;
+  for (const std::string& path : canonical_mask.paths()) {
+    if (!GetFieldDescriptors(descriptor, path, &fields)) {
+      nodes_.clear();
+      return false;
+    }
+    if (fields.empty()) continue;
+    int node = 0;
+    for (int i = 0; i < fields.size() - 1; ++i) {
+      int entry = nodes_[node].by_index[fields[i]->index()];
+      if (entry == kNotInMask) {
+        entry = nodes_.size();
+        nodes_.emplace_back(fields[i]->message_type());
+        nodes_[node].by_index[fields[i]->index()] = entry;
+      }
+      node = entry;
+    }
+    nodes_[node].by_index[fields.back()->index()] = kWholeField;
+  }
+  root_ = 0;
+  required_root_ = AddRequiredFields(root_, descriptor);
+
+  for (Node& node : nodes_) {
+    for (int i = 0; i < node.by_index.size(); ++i) {
+      if (node.by_index[i] != kNotInMask) {
+        node.fields.emplace_back(node.descriptor->field(i), node.by_index[i]);
+      }
+    }
+    std::sort(node.fields.begin(), node.fields.end(),
+              [](const std::pair<const FieldDescriptor*, int>& a,
+                 const std::pair<const FieldDescriptor*, int>& b) {
+                return a.first->number() < b.first->number();
+              });
+  }
+  descriptor_ = descriptor;
+  return true;
+}
+
+bool FieldMaskUtil::CompiledFieldMask::empty() const {
+  return root_ == kNotInMask || nodes_[root_].fields.empty();
+}
+
+int FieldMaskUtil::CompiledFieldMask::AddRequiredFields(
+    int node, const Descriptor* descriptor) {
+  const int result = nodes_.size();
+  nodes_.emplace_back(descriptor);
+  bool has_fields = false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    int entry = node == kNotInMask ? kNotInMask : nodes_[node].by_index[i];
+    if (entry >= 0) {
+      entry = AddRequiredFields(entry, field->message_type());
+    } else if (entry == kNotInMask && field->is_required()) {
+      entry = field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE
+                  ? AddRequiredFields(kNotInMask, field->message_type())
+                  : kWholeField;
+    }
+    nodes_[result].by_index[i] = entry;
+    has_fields |= entry != kNotInMask;
+  }
+  if (node == kNotInMask && !has_fields) {
+    // A message without required fields is kept as a whole, as
+    // FieldMaskTree::AddRequiredFieldPath() does. Nothing was added after it.
+    nodes_.pop_back();
+    return kWholeField;
+  }
+  return result;
+}
+
+int FieldMaskUtil::CompiledFieldMask::FindByNumber(int node, int number) const {
+  const std::vector<std::pair<const FieldDescriptor*, int> >& fields =
+      nodes_[node].fields;
+  auto it = std::lower_bound(
+      fields.begin(), fields.end(), number,
+      [](const std::pair<const FieldDescriptor*, int>& entry, int number) {
+        return entry.first->number() < number;
+      });
+  if (it == fields.end() || it->first->number() != number) return kNotInMask;
+  return it->second;
+}
+
+void FieldMaskUtil::CompiledFieldMask::MergeMessageTo(
+    const Message& source, const MergeOptions& options,
+    Message* destination) const {
+  GOOGLE_CHECK(source.GetDescriptor() == descriptor_);
+  GOOGLE_CHECK(destination->GetDescriptor() == descriptor_);
+  if (empty()) return;
+  MergeMessageTo(root_, source, options, destination);
+}
+
+void FieldMaskUtil::CompiledFieldMask::MergeMessageTo(
+    int node, const Message& source, const MergeOptions& options,
+    Message* destination) const {
+  const Reflection* source_reflection = source.GetReflection();
+  const Reflection* destination_reflection = destination->GetReflection();
+  for (const auto& entry : nodes_[node].fields) {
+    const FieldDescriptor* field = entry.first;
+    if (entry.second == kWholeField) {
+      MergeField(source, field, options, destination);
+    } else {
+      MergeMessageTo(entry.second, source_reflection->GetMessage(source, field),
+                     options,
+                     destination_reflection->MutableMessage(destination, field));
+    }
+  }
+}
+
+bool FieldMaskUtil::CompiledFieldMask::TrimMessage(Message* message) const {
+  GOOGLE_CHECK(message->GetDescriptor() == descriptor_);
+  if (empty()) return false;
+  return TrimMessage(root_, message);
+}
+
+bool FieldMaskUtil::CompiledFieldMask::TrimMessage(
+    Message* message, const TrimOptions& options) const {
+  GOOGLE_CHECK(message->GetDescriptor() == descriptor_);
+  if (empty()) return false;
+  return TrimMessage(options.keep_required_fields() ? required_root_ : root_,
+                     message);
+}
+
+bool FieldMaskUtil::CompiledFieldMask::TrimMessage(int node,
+                                                   Message* message) const {
+  const Reflection* reflection = message->GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*message, &fields);
+  bool modified = false;
+  for (const FieldDescriptor* field : fields) {
+    // Like FieldMaskUtil::TrimMessage(), leave extensions alone.
+    if (field->is_extension()) continue;
+    const int entry = nodes_[node].by_index[field->index()];
+    if (entry == kNotInMask) {
+      reflection->ClearField(message, field);
+      modified = true;
+    } else if (entry >= 0) {
+      modified |= TrimMessage(entry, reflection->MutableMessage(message, field));
+    }
+  }
+  return modified;
+}
+
+bool FieldMaskUtil::CompiledFieldMask::ProjectSerialized(
+    StringPiece input, std::string* output) const {
+  GOOGLE_CHECK(descriptor_ != nullptr) << "The mask has not been compiled.";
+  output->clear();
+  if (empty()) {
+    output->assign(input.data(), input.size());
+    return true;
+  }
+  output->reserve(input.size());
+  io::CodedInputStream stream(reinterpret_cast<const uint8*>(input.data()),
+                              input.size());
+  return ProjectSerialized(root_, input.data(), 0, &stream, output);
+}
+
+bool FieldMaskUtil::CompiledFieldMask::ProjectSerialized(
+    int node, const char* data, uint32 end_group_tag,
+    io::CodedInputStream* input, std::string* output) const {
+  typedef internal::WireFormatLite WireFormatLite;
+  while (true) {
+    const int tag_start = input->CurrentPosition();
+    const uint32 tag = input->ReadTagNoLastTag();
+    if (tag == 0) {
+      return end_group_tag == 0 && input->ConsumedEntireMessage();
+    }
+    const int tag_end = input->CurrentPosition();
+    if (tag == end_group_tag) {
+      output->append(data + tag_start, tag_end - tag_start);
+      return true;
+    }
+
+    const int entry =
+        FindByNumber(node, WireFormatLite::GetTagFieldNumber(tag));
+    if (entry == kWholeField) {
+      if (!WireFormatLite::SkipField(input, tag)) return false;
+      output->append(data + tag_start, input->CurrentPosition() - tag_start);
+      continue;
+    }
+    if (entry == kNotInMask) {
+      if (!WireFormatLite::SkipField(input, tag)) return false;
+      continue;
+    }
+
+    // A sub-message the mask descends into.
+    switch (WireFormatLite::GetTagWireType(tag)) {
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        int length;
+        if (!input->ReadVarintSizeAsInt(&length)) return false;
+        std::pair<io::CodedInputStream::Limit, int> limit =
+            input->IncrementRecursionDepthAndPushLimit(length);
+        if (limit.second < 0) return false;
+        std::string projected;
+        if (!ProjectSerialized(entry, data, 0, input, &projected) ||
+            !input->DecrementRecursionDepthAndPopLimit(limit.first)) {
+          return false;
+        }
+        uint8 length_bytes[5];
+        const uint8* length_end = io::CodedOutputStream::WriteVarint32ToArray(
+            projected.size(), length_bytes);
+        output->append(data + tag_start, tag_end - tag_start);
+        output->append(reinterpret_cast<const char*>(length_bytes),
+                       length_end - length_bytes);
+        output->append(projected);
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP: {
+        if (!input->IncrementRecursionDepth()) return false;
+        output->append(data + tag_start, tag_end - tag_start);
+        if (!ProjectSerialized(
+                entry, data,
+                WireFormatLite::MakeTag(WireFormatLite::GetTagFieldNumber(tag),
+                                        WireFormatLite::WIRETYPE_END_GROUP),
+                input, output)) {
+          return false;
+        }
+        input->DecrementRecursionDepth();
+        break;
+      }
+      default:
+        // Parsing would make a value of the wrong wire type an unknown
+        // field, which is dropped.
+        if (!WireFormatLite::SkipField(input, tag)) return false;
+        break;
+    }
+  }
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -34,6 +34,8 @@
 #define GOOGLE_PROTOBUF_UTIL_FIELD_MASK_UTIL_H__
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <google/protobuf/field_mask.pb.h>
 #include <google/protobuf/descriptor.h>
@@ -44,6 +46,10 @@
 
 namespace google {
 namespace protobuf {
+namespace io {
+class CodedInputStream;
+}  // namespace io
+
 namespace util {
 
 class PROTOBUF_EXPORT FieldMaskUtil {
@@ -177,6 +183,10 @@ class PROTOBUF_EXPORT FieldMaskUtil {
   static bool TrimMessage(const FieldMask& mask, Message* message,
                           const TrimOptions& options);
 
+  // A FieldMask resolved against a message type, to apply it to many
+  // messages without resolving its paths each time. See below.
+  class CompiledFieldMask;
+
  private:
   friend class SnakeCaseCamelCaseTest;
   // Converts a field name from snake_case to camelCase:
@@ -252,6 +262,95 @@ class PROTOBUF_EXPORT FieldMaskUtil::TrimOptions {
   bool keep_required_fields_;
 };
 
+// A FieldMask whose paths have been resolved once against a message type into
+// field numbers, so that applying it to a message does not split paths or
+// look fields up by name. A compiled mask is not modified by using it and can
+// be shared between threads.
+//
+//   FieldMaskUtil::CompiledFieldMask compiled;
+//   GOOGLE_CHECK(compiled.Compile(Foo::descriptor(), mask));
+//   for (Foo& foo : foos) {
+//     compiled.TrimMessage(&foo);
+//   }
+class PROTOBUF_EXPORT FieldMaskUtil::CompiledFieldMask {
+ public:
+  CompiledFieldMask();
+  ~CompiledFieldMask();
+
+  // Resolves the paths of "mask" against "descriptor". Returns false and
+  // leaves this mask empty if a path does not name a field, or if it goes
+  // through a field that is not a singular message.
+  bool Compile(const Descriptor* descriptor, const FieldMask& mask);
+
+  // The type the mask was compiled for, or NULL if it was not compiled.
+  const Descriptor* descriptor() const { return descriptor_; }
+
+  // Returns true if the mask has no paths. Like an empty FieldMask, an empty
+  // compiled mask leaves messages unchanged.
+  bool empty() const;
+
+  // Same as FieldMaskUtil::MergeMessageTo() with the compiled mask.
+  void MergeMessageTo(const Message& source, const MergeOptions& options,
+                      Message* destination) const;
+
+  // Same as FieldMaskUtil::TrimMessage() with the compiled mask.
+  bool TrimMessage(Message* message) const;
+  bool TrimMessage(Message* message, const TrimOptions& options) const;
+
+  // Sets "output" to the serialized message "input", of the compiled type,
+  // with only the fields in the mask. This works on the wire format without
+  // parsing "input": the fields in the mask are copied as they are, the
+  // others are skipped, and only the sub-messages the mask descends into are
+  // rewritten. Parsing the output gives the same message as parsing "input"
+  // and trimming it, except that the extensions and unknown fields of those
+  // rewritten messages are dropped as well. An empty mask copies "input" as
+  // it is. Returns false if "input" is not a valid serialized message.
+  bool ProjectSerialized(StringPiece input, std::string* output) const;
+
+ private:
+  // The sub-mask of a message type. Each field is either not in the mask
+  // (kNotInMask), in it with all of its sub-fields (kWholeField), or in it
+  // with the sub-fields of the sub-mask at that index in nodes_.
+  struct Node {
+    explicit Node(const Descriptor* descriptor);
+
+    const Descriptor* descriptor;
+    // Indexed by FieldDescriptor::index().
+    std::vector<int> by_index;
+    // The fields in the mask with their entries, sorted by number.
+    std::vector<std::pair<const FieldDescriptor*, int> > fields;
+  };
+
+  static constexpr int kNotInMask = -2;
+  static constexpr int kWholeField = -1;
+
+  // Returns the entry of the field with the given number in nodes_[node].
+  int FindByNumber(int node, int number) const;
+
+  // Adds a sub-mask that is "node" (or nothing, if kNotInMask) plus the
+  // required fields of the messages it keeps, as TrimOptions'
+  // keep_required_fields asks for. Returns its index or kWholeField.
+  int AddRequiredFields(int node, const Descriptor* descriptor);
+
+  void MergeMessageTo(int node, const Message& source,
+                      const MergeOptions& options, Message* destination) const;
+  bool TrimMessage(int node, Message* message) const;
+
+  // Projects fields from "input" onto "output" until the end of the input,
+  // or until the END_GROUP tag "end_group_tag" if it is not zero.
+  bool ProjectSerialized(int node, const char* data, uint32 end_group_tag,
+                         io::CodedInputStream* input,
+                         std::string* output) const;
+
+  const Descriptor* descriptor_;
+  std::vector<Node> nodes_;
+  // The root of the mask, and the root of the mask with required fields.
+  int root_;
+  int required_root_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(CompiledFieldMask);
+};
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -828,6 +828,184 @@ TEST(FieldMaskUtilTest, TrimMessageReturnValue) {
   // supported.
 }
 
+TEST(CompiledFieldMaskTest, Compile) {
+  FieldMaskUtil::CompiledFieldMask compiled;
+  EXPECT_EQ(nullptr, compiled.descriptor());
+  EXPECT_TRUE(compiled.empty());
+
+  FieldMask mask;
+  EXPECT_TRUE(compiled.Compile(TestAllTypes::descriptor(), mask));
+  EXPECT_EQ(TestAllTypes::descriptor(), compiled.descriptor());
+  EXPECT_TRUE(compiled.empty());
+
+  FieldMaskUtil::FromString("optional_int32,optional_nested_message.bb", &mask);
+  EXPECT_TRUE(compiled.Compile(TestAllTypes::descriptor(), mask));
+  EXPECT_FALSE(compiled.empty());
+
+  FieldMaskUtil::FromString("optional_int32,no_such_field", &mask);
+  EXPECT_FALSE(compiled.Compile(TestAllTypes::descriptor(), mask));
+  EXPECT_EQ(nullptr, compiled.descriptor());
+  FieldMaskUtil::FromString("repeated_nested_message.bb", &mask);
+  EXPECT_FALSE(compiled.Compile(TestAllTypes::descriptor(), mask));
+  FieldMaskUtil::FromString("optional_int32.bb", &mask);
+  EXPECT_FALSE(compiled.Compile(TestAllTypes::descriptor(), mask));
+}
+
+TEST(CompiledFieldMaskTest, SameAsFieldMaskUtil) {
+  TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+  TestAllTypes destination;
+  destination.set_optional_int32(1);
+  destination.mutable_optional_nested_message()->set_bb(2);
+  destination.add_repeated_string("x");
+
+  const char* const kMasks[] = {
+      "",
+      "optional_int32",
+      "optional_int32,repeated_string,optional_bytes",
+      "optional_nested_message.bb,optional_foreign_message",
+      "optional_nested_message,repeated_nested_message",
+      "optionalgroup.a,repeatedgroup",
+      "optional_nested_message.bb,optional_nested_message",
+      "oneof_uint32,oneof_nested_message.bb",
+  };
+  for (const char* path : kMasks) {
+    SCOPED_TRACE(path);
+    FieldMask mask;
+    FieldMaskUtil::FromString(path, &mask);
+    FieldMaskUtil::CompiledFieldMask compiled;
+    ASSERT_TRUE(compiled.Compile(TestAllTypes::descriptor(), mask));
+
+    TestAllTypes expected(source), actual(source);
+    EXPECT_EQ(FieldMaskUtil::TrimMessage(mask, &expected),
+              compiled.TrimMessage(&actual));
+    EXPECT_EQ(expected.DebugString(), actual.DebugString());
+
+    std::string projected;
+    ASSERT_TRUE(
+        compiled.ProjectSerialized(source.SerializeAsString(), &projected));
+    actual.Clear();
+    ASSERT_TRUE(actual.ParseFromString(projected));
+    EXPECT_EQ(expected.DebugString(), actual.DebugString());
+
+    for (int replace = 0; replace < 4; ++replace) {
+      FieldMaskUtil::MergeOptions options;
+      options.set_replace_message_fields(replace & 1);
+      options.set_replace_repeated_fields(replace & 2);
+      expected = destination;
+      actual = destination;
+      FieldMaskUtil::MergeMessageTo(source, mask, options, &expected);
+      compiled.MergeMessageTo(source, options, &actual);
+      EXPECT_EQ(expected.DebugString(), actual.DebugString());
+    }
+  }
+}
+
+TEST(CompiledFieldMaskTest, KeepRequiredFields) {
+  TestRequiredMessage source;
+  source.mutable_optional_message()->set_a(1234);
+  source.mutable_optional_message()->set_b(3456);
+  source.mutable_optional_message()->set_c(5678);
+  source.mutable_optional_message()->set_dummy2(1);
+  source.mutable_required_message()->set_a(1234);
+  source.mutable_required_message()->set_b(3456);
+  source.mutable_required_message()->set_c(5678);
+  source.mutable_required_message()->set_dummy2(7890);
+  source.add_repeated_message()->set_a(1234);
+
+  FieldMaskUtil::TrimOptions options;
+  options.set_keep_required_fields(true);
+  const char* const kMasks[] = {
+      "optional_message.dummy2",
+      "required_message",
+      "required_message.dummy2",
+      "repeated_message",
+  };
+  for (const char* path : kMasks) {
+    SCOPED_TRACE(path);
+    FieldMask mask;
+    FieldMaskUtil::FromString(path, &mask);
+    FieldMaskUtil::CompiledFieldMask compiled;
+    ASSERT_TRUE(compiled.Compile(TestRequiredMessage::descriptor(), mask));
+
+    TestRequiredMessage expected(source), actual(source);
+    EXPECT_EQ(FieldMaskUtil::TrimMessage(mask, &expected, options),
+              compiled.TrimMessage(&actual, options));
+    EXPECT_EQ(expected.DebugString(), actual.DebugString());
+
+    // Without the option, the compiled mask is used as it is.
+    expected = source;
+    actual = source;
+    FieldMaskUtil::TrimMessage(mask, &expected);
+    compiled.TrimMessage(&actual);
+    EXPECT_EQ(expected.DebugString(), actual.DebugString());
+  }
+}
+
+TEST(CompiledFieldMaskTest, ProjectSerialized) {
+  NestedTestAllTypes message;
+  message.mutable_child()->mutable_payload()->set_optional_int32(1234);
+  message.mutable_child()
+      ->mutable_child()
+      ->mutable_payload()
+      ->set_optional_int32(5678);
+  message.mutable_payload()->add_repeated_int32(1);
+  message.mutable_payload()->add_repeated_int32(2);
+
+  FieldMask mask;
+  FieldMaskUtil::FromString("child.child.payload,payload.repeated_int32",
+                            &mask);
+  FieldMaskUtil::CompiledFieldMask compiled;
+  ASSERT_TRUE(compiled.Compile(NestedTestAllTypes::descriptor(), mask));
+
+  std::string serialized = message.SerializeAsString();
+  std::string projected;
+  ASSERT_TRUE(compiled.ProjectSerialized(serialized, &projected));
+  NestedTestAllTypes actual;
+  ASSERT_TRUE(actual.ParseFromString(projected));
+  EXPECT_EQ(
+      "child {\n"
+      "  child {\n"
+      "    payload {\n"
+      "      optional_int32: 5678\n"
+      "    }\n"
+      "  }\n"
+      "}\n"
+      "payload {\n"
+      "  repeated_int32: 1\n"
+      "  repeated_int32: 2\n"
+      "}\n",
+      actual.DebugString());
+
+  // Concatenated messages are merged, before or after projecting.
+  ASSERT_TRUE(compiled.ProjectSerialized(serialized + serialized, &projected));
+  NestedTestAllTypes expected;
+  ASSERT_TRUE(expected.ParseFromString(serialized + serialized));
+  FieldMaskUtil::TrimMessage(mask, &expected);
+  ASSERT_TRUE(actual.ParseFromString(projected));
+  EXPECT_EQ(expected.DebugString(), actual.DebugString());
+
+  // Unknown fields of the messages the mask descends into are dropped; those
+  // of fields kept as a whole are not.
+  message.mutable_child()->mutable_unknown_fields()->AddVarint(12345, 1);
+  message.mutable_child()
+      ->mutable_child()
+      ->mutable_payload()
+      ->mutable_unknown_fields()
+      ->AddVarint(12345, 1);
+  ASSERT_TRUE(
+      compiled.ProjectSerialized(message.SerializeAsString(), &projected));
+  ASSERT_TRUE(actual.ParseFromString(projected));
+  EXPECT_EQ(0, actual.child().unknown_fields().field_count());
+  EXPECT_EQ(1, actual.child().child().payload().unknown_fields().field_count());
+
+  // Malformed input.
+  EXPECT_FALSE(compiled.ProjectSerialized(
+      serialized.substr(0, serialized.size() - 1), &projected));
+  EXPECT_FALSE(compiled.ProjectSerialized("\x0a\x05\x0a", &projected));
+  EXPECT_FALSE(compiled.ProjectSerialized("\x08", &projected));
+}
+
 
 }  // namespace
 }  // namespace util
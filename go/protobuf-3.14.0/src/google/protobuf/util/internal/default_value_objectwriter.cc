@@ -69,6 +69,19 @@ DefaultValueObjectWriter::DefaultValueObjectWriter(
       use_ints_for_enums_(false),
       ow_(ow) {}
 
+DefaultValueObjectWriter::DefaultValueObjectWriter(
+    const TypeInfo* typeinfo, const google::protobuf::Type& type,
+    ObjectWriter* ow)
+    : typeinfo_(typeinfo),
+      own_typeinfo_(false),
+      type_(type),
+      current_(nullptr),
+      root_(nullptr),
+      suppress_empty_list_(false),
+      preserve_proto_field_names_(false),
+      use_ints_for_enums_(false),
+      ow_(ow) {}
+
 DefaultValueObjectWriter::~DefaultValueObjectWriter() {
   if (own_typeinfo_) {
     delete typeinfo_;
@@ -80,6 +80,12 @@ class PROTOBUF_EXPORT DefaultValueObjectWriter : public ObjectWriter {
                            const google::protobuf::Type& type,
                            ObjectWriter* ow);
 
+  // Like above, but looks types up in |typeinfo|, which must outlive the
+  // writer.
+  DefaultValueObjectWriter(const TypeInfo* typeinfo,
+                           const google::protobuf::Type& type,
+                           ObjectWriter* ow);
+
   virtual ~DefaultValueObjectWriter();
 
   // ObjectWriter methods.
@@ -30,6 +30,8 @@
 
 #include <google/protobuf/util/internal/json_escaping.h>
 
+#include <cstring>
+
 #include <google/protobuf/stubs/logging.h>
 #include <google/protobuf/stubs/common.h>
 
@@ -296,6 +298,39 @@ StringPiece EscapeCodePoint(uint32 cp, char* buffer, bool force_output) {
   return sp;
 }
 
+// Returns true if the ASCII character c is escaped; see kCommonEscapes.
+inline bool NeedsEscaping(uint8 c) {
+  return c < 0x20 || c >= 0x7f || c == '"' || c == '<' || c == '>' ||
+         c == '\\';
+}
+
+// Returns the length of the longest prefix of data that is ASCII needing no
+// escaping, testing 8 bytes at a time.
+inline int UnescapedRunLength(const char* data, int size) {
+  static const uint64 kOnes = 0x0101010101010101ULL;
+  static const uint64 kHighBits = 0x8080808080808080ULL;
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64 word;
+    memcpy(&word, data + i, sizeof(word));
+    // Non-ASCII bytes are handled by the byte loop below; from here on all
+    // bytes are below 0x80, so none of the sums or differences carry.
+    if (word & kHighBits) break;
+    uint64 quote = word ^ (kOnes * '"');
+    uint64 lt = word ^ (kOnes * '<');
+    uint64 gt = word ^ (kOnes * '>');
+    uint64 backslash = word ^ (kOnes * '\\');
+    // The high bit of a byte is set where it is a control character, DEL, or
+    // one of the four bytes searched for (where the xor above is zero).
+    uint64 hits = (word - kOnes * 0x20) | (word + kOnes) |
+                  (quote - kOnes) | (lt - kOnes) | (gt - kOnes) |
+                  (backslash - kOnes);
+    if (hits & ~word & kHighBits) break;
+  }
+  while (i < size && !NeedsEscaping(data[i])) ++i;
+  return i;
+}
+
 }  // namespace
 
 void JsonEscaping::Escape(strings::ByteSource* input,
@@ -310,6 +345,14 @@ void JsonEscaping::Escape(strings::ByteSource* input,
     int num_read;
     bool ok;
     bool cp_was_split = num_left > 0;
+    if (!cp_was_split) {
+      // Copy a leading run that needs no escaping without decoding it.
+      i = UnescapedRunLength(str.data(), str.size());
+      if (i == str.size()) {
+        input->CopyTo(output, i);
+        continue;
+      }
+    }
     // Loop until we encounter either
     //   i) a code point that needs to be escaped; or
     //  ii) a split code point is completely read; or
@@ -342,24 +385,32 @@ void JsonEscaping::Escape(strings::ByteSource* input,
 }
 
 void JsonEscaping::Escape(StringPiece input, strings::ByteSink* output) {
-  const size_t len = input.length();
   const char* p = input.data();
+  const int len = input.size();
+  char buffer[12] = "\\udead\\ubee";
+  int i = 0;
+  while (i < len) {
+    // Runs that need no escaping are appended as they are, so the common
+    // case of plain ASCII is a single Append().
+    int run = UnescapedRunLength(p + i, len - i);
+    if (run > 0) output->Append(p + i, run);
+    i += run;
+    if (i == len) break;
 
-  bool can_skip_escaping = true;
-  for (int i = 0; i < len; i++) {
-    char c = p[i];
-    if (c < 0x20 || c >= 0x7F || c == '"' || c == '<' || c == '>' ||
-        c == '\\') {
-      can_skip_escaping = false;
-      break;
+    uint32 cp;
+    int num_left = 0;
+    int num_read;
+    if (ReadCodePoint(input, i, &cp, &num_left, &num_read) && num_left == 0) {
+      StringPiece escaped = EscapeCodePoint(cp, buffer);
+      if (escaped.empty()) {
+        output->Append(p + i, num_read);
+      } else {
+        output->Append(escaped.data(), escaped.size());
+      }
     }
-  }
-
-  if (can_skip_escaping) {
-    output->Append(input.data(), input.length());
-  } else {
-    strings::ArrayByteSource source(input);
-    Escape(&source, output);
+    // Like above, invalid and truncated characters are dropped.
+    // TODO(wpoon): Add error reporting.
+    i += num_read;
   }
 }
 
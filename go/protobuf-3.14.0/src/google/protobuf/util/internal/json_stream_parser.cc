@@ -86,6 +86,28 @@ inline bool IsKeySeparator(char c) {
           c == '}' || c == '[' || c == ']' || c == ':' || c == ',');
 }
 
+// Returns the length of the prefix of |data| that holds neither a backslash
+// nor |quote|. Whole 8-byte words are checked at once; the bytes of multi-byte
+// UTF-8 characters are all >= 0x80, so skipping them byte-wise is the same as
+// advancing one character at a time.
+inline int StringRunLength(const char* data, int size, char quote) {
+  static const uint64 kOnes = 0x0101010101010101ULL;
+  static const uint64 kHighBits = 0x8080808080808080ULL;
+  const uint64 backslashes = kOnes * '\\';
+  const uint64 quotes = kOnes * static_cast<uint8>(quote);
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64 word;
+    memcpy(&word, data + i, sizeof(word));
+    // A byte of x is zero exactly where word has the byte searched for.
+    uint64 x = word ^ backslashes;
+    uint64 y = word ^ quotes;
+    if ((((x - kOnes) & ~x) | ((y - kOnes) & ~y)) & kHighBits) break;
+  }
+  while (i < size && data[i] != '\\' && data[i] != quote) ++i;
+  return i;
+}
+
 inline void ReplaceInvalidCodePoints(StringPiece str,
                                      const std::string& replacement,
                                      std::string* dst) {
@@ -439,8 +461,8 @@ util::Status JsonStreamParser::ParseStringHelper() {
       Advance();
       return util::Status();
     }
-    // Normal character, just advance past it.
-    Advance();
+    // Normal characters, advance past the whole run of them.
+    p_.remove_prefix(StringRunLength(data, p_.size(), string_open_));
   }
   // If we ran out of characters, copy over what we have so far.
   if (last < p_.data()) {
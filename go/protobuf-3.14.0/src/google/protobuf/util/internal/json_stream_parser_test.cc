@@ -307,6 +307,22 @@ TEST_F(JsonStreamParserTest, SimpleSingleQuotedString) {
   }
 }
 
+// Strings longer than a word, with the other quote, escapes and multi-byte
+// characters at different offsets.
+TEST_F(JsonStreamParserTest, LongStringsWithEscapes) {
+  StringPiece str =
+      "[\"abcdefghij'klmnop\\\"qrstuvwxyz\xC3\xA9 0123456789\\nend\","
+      "'\xE2\x82\xAC\xE2\x82\xAC\"abcdefgh\\'ijklmnopq\\\\']";
+  for (int i = 0; i <= str.length(); ++i) {
+    ow_.StartList("")
+        ->RenderString("",
+                       "abcdefghij'klmnop\"qrstuvwxyz\xC3\xA9 0123456789\nend")
+        ->RenderString("", "\xE2\x82\xAC\xE2\x82\xAC\"abcdefgh'ijklmnopq\\")
+        ->EndList();
+    DoTest(str, i);
+  }
+}
+
 // - string key, unquoted key, numeric key
 TEST_F(JsonStreamParserTest, ObjectKeyTypes) {
   StringPiece str =
@@ -0,0 +1,631 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/internal/message_objectsource.h>
+
+#include <algorithm>
+
+#include <google/protobuf/stubs/logging.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stringprintf.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/map_field.h>
+#include <google/protobuf/stubs/mutex.h>
+#include <google/protobuf/util/internal/constants.h>
+#include <google/protobuf/util/internal/field_mask_utility.h>
+#include <google/protobuf/util/internal/utility.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/stubs/status.h>
+#include <google/protobuf/stubs/time.h>
+#include <google/protobuf/stubs/map_util.h>
+#include <google/protobuf/stubs/status_macros.h>
+
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace converter {
+
+namespace {
+
+static int kDefaultMaxRecursionDepth = 64;
+
+enum WellKnownType {
+  WKT_NONE,
+  WKT_TIMESTAMP,
+  WKT_DURATION,
+  WKT_WRAPPER,
+  WKT_ANY,
+  WKT_STRUCT,
+  WKT_VALUE,
+  WKT_LIST_VALUE,
+  WKT_FIELD_MASK,
+};
+
+WellKnownType GetWellKnownType(const Descriptor* descriptor) {
+  const std::string& name = descriptor->full_name();
+  if (!HasPrefixString(name, "google.protobuf.")) return WKT_NONE;
+  if (name == "google.protobuf.Timestamp") return WKT_TIMESTAMP;
+  if (name == "google.protobuf.Duration") return WKT_DURATION;
+  if (name == "google.protobuf.DoubleValue" ||
+      name == "google.protobuf.FloatValue" ||
+      name == "google.protobuf.Int64Value" ||
+      name == "google.protobuf.UInt64Value" ||
+      name == "google.protobuf.Int32Value" ||
+      name == "google.protobuf.UInt32Value" ||
+      name == "google.protobuf.BoolValue" ||
+      name == "google.protobuf.StringValue" ||
+      name == "google.protobuf.BytesValue") {
+    return WKT_WRAPPER;
+  }
+  if (name == "google.protobuf.Any") return WKT_ANY;
+  if (name == "google.protobuf.Struct") return WKT_STRUCT;
+  if (name == "google.protobuf.Value") return WKT_VALUE;
+  if (name == "google.protobuf.ListValue") return WKT_LIST_VALUE;
+  if (name == "google.protobuf.FieldMask") return WKT_FIELD_MASK;
+  return WKT_NONE;
+}
+
+// Renders a map key the way ProtoStreamObjectSource::ReadFieldValueAsString()
+// does for the key types allowed in maps.
+std::string MapKeyAsString(const MapKey& key) {
+  switch (key.type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return key.GetBoolValue() ? "true" : "false";
+    case FieldDescriptor::CPPTYPE_INT32:
+      return StrCat(key.GetInt32Value());
+    case FieldDescriptor::CPPTYPE_INT64:
+      return StrCat(key.GetInt64Value());
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return StrCat(key.GetUInt32Value());
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return StrCat(key.GetUInt64Value());
+    case FieldDescriptor::CPPTYPE_STRING:
+      return key.GetStringValue();
+    default:
+      return std::string();
+  }
+}
+}  // namespace
+
+// Per-type information needed for rendering, computed once per Descriptor.
+struct MessageObjectSource::TypeTable {
+  WellKnownType well_known_type;
+  // Non-extension fields ordered by field number, which is the order the
+  // binary serializer emits them in.
+  std::vector<const FieldDescriptor*> fields;
+
+  explicit TypeTable(const Descriptor* descriptor)
+      : well_known_type(GetWellKnownType(descriptor)) {
+    fields.reserve(descriptor->field_count());
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      fields.push_back(descriptor->field(i));
+    }
+    std::sort(fields.begin(), fields.end(),
+              [](const FieldDescriptor* a, const FieldDescriptor* b) {
+                return a->number() < b->number();
+              });
+  }
+};
+
+// Reads a singular field (index < 0) or one element of a repeated field
+// through reflection, with the accessor names of MapValueConstRef.
+class MessageObjectSource::FieldValue {
+ public:
+  FieldValue(const Message& message, const FieldDescriptor* field, int index)
+      : message_(message),
+        reflection_(message.GetReflection()),
+        field_(field),
+        index_(index) {}
+
+  int32 GetInt32Value() const {
+    return index_ < 0 ? reflection_->GetInt32(message_, field_)
+                      : reflection_->GetRepeatedInt32(message_, field_, index_);
+  }
+  int64 GetInt64Value() const {
+    return index_ < 0 ? reflection_->GetInt64(message_, field_)
+                      : reflection_->GetRepeatedInt64(message_, field_, index_);
+  }
+  uint32 GetUInt32Value() const {
+    return index_ < 0
+               ? reflection_->GetUInt32(message_, field_)
+               : reflection_->GetRepeatedUInt32(message_, field_, index_);
+  }
+  uint64 GetUInt64Value() const {
+    return index_ < 0
+               ? reflection_->GetUInt64(message_, field_)
+               : reflection_->GetRepeatedUInt64(message_, field_, index_);
+  }
+  float GetFloatValue() const {
+    return index_ < 0 ? reflection_->GetFloat(message_, field_)
+                      : reflection_->GetRepeatedFloat(message_, field_, index_);
+  }
+  double GetDoubleValue() const {
+    return index_ < 0
+               ? reflection_->GetDouble(message_, field_)
+               : reflection_->GetRepeatedDouble(message_, field_, index_);
+  }
+  bool GetBoolValue() const {
+    return index_ < 0 ? reflection_->GetBool(message_, field_)
+                      : reflection_->GetRepeatedBool(message_, field_, index_);
+  }
+  int GetEnumValue() const {
+    return index_ < 0
+               ? reflection_->GetEnumValue(message_, field_)
+               : reflection_->GetRepeatedEnumValue(message_, field_, index_);
+  }
+  const std::string& GetStringValue() const {
+    return index_ < 0 ? reflection_->GetStringReference(message_, field_,
+                                                        &scratch_)
+                      : reflection_->GetRepeatedStringReference(
+                            message_, field_, index_, &scratch_);
+  }
+  const Message& GetMessageValue() const {
+    return index_ < 0
+               ? reflection_->GetMessage(message_, field_)
+               : reflection_->GetRepeatedMessage(message_, field_, index_);
+  }
+
+ private:
+  const Message& message_;
+  const Reflection* reflection_;
+  const FieldDescriptor* field_;
+  int index_;
+  mutable std::string scratch_;
+};
+
+MessageObjectSource::MessageObjectSource(const Message& message)
+    : message_(message),
+      use_ints_for_enums_(false),
+      preserve_proto_field_names_(false),
+      recursion_depth_(0),
+      max_recursion_depth_(kDefaultMaxRecursionDepth) {}
+
+MessageObjectSource::~MessageObjectSource() {}
+
+util::Status MessageObjectSource::NamedWriteTo(StringPiece name,
+                                               ObjectWriter* ow) const {
+  return WriteMessage(message_, name, true, ow);
+}
+
+const MessageObjectSource::TypeTable& MessageObjectSource::GetTable(
+    const Descriptor* descriptor) const {
+  const TypeTable* table = FindPtrOrNull(tables_, descriptor);
+  if (table != nullptr) return *table;
+
+  if (descriptor->file()->pool() == DescriptorPool::generated_pool()) {
+    // Generated descriptors live for the whole process, so their tables are
+    // shared between sources.
+    static ::google::protobuf::internal::WrappedMutex mu;
+    static auto* shared =
+        ::google::protobuf::internal::OnShutdownDelete(
+            new std::unordered_map<const Descriptor*,
+                                   std::unique_ptr<const TypeTable>>());
+    ::google::protobuf::internal::MutexLock lock(&mu);
+    std::unique_ptr<const TypeTable>& entry = (*shared)[descriptor];
+    if (entry == nullptr) entry.reset(new TypeTable(descriptor));
+    table = entry.get();
+  } else {
+    owned_tables_.emplace_back(new TypeTable(descriptor));
+    table = owned_tables_.back().get();
+  }
+  tables_[descriptor] = table;
+  return *table;
+}
+
+util::Status MessageObjectSource::WriteMessage(const Message& message,
+                                               StringPiece name,
+                                               bool include_start_and_end,
+                                               ObjectWriter* ow) const {
+  const TypeTable& table = GetTable(message.GetDescriptor());
+  if (table.well_known_type != WKT_NONE) {
+    return RenderWellKnownType(message, table, name, ow);
+  }
+
+  const Reflection* reflection = message.GetReflection();
+  if (include_start_and_end) {
+    ow->StartObject(name);
+  }
+  for (const FieldDescriptor* field : table.fields) {
+    StringPiece field_name = preserve_proto_field_names_
+                                 ? field->name()
+                                 : field->json_name();
+    if (field->is_repeated()) {
+      int size = reflection->FieldSize(message, field);
+      if (size == 0) continue;
+      if (field->is_map()) {
+        ow->StartObject(field_name);
+        RETURN_IF_ERROR(RenderMap(message, field, ow));
+        ow->EndObject();
+      } else {
+        ow->StartList(field_name);
+        for (int i = 0; i < size; ++i) {
+          RETURN_IF_ERROR(
+              RenderValue(field, FieldValue(message, field, i), "", ow));
+        }
+        ow->EndList();
+      }
+    } else if (reflection->HasField(message, field)) {
+      RETURN_IF_ERROR(
+          RenderValue(field, FieldValue(message, field, -1), field_name, ow));
+    }
+  }
+  if (include_start_and_end) {
+    ow->EndObject();
+  }
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderMap(const Message& message,
+                                            const FieldDescriptor* field,
+                                            ObjectWriter* ow) const {
+  // Iterate the map itself rather than the repeated entries, as the generated
+  // serializers do, so entries come out in the same order.
+  const Reflection* reflection = message.GetReflection();
+  Message* mutable_message = const_cast<Message*>(&message);
+  const FieldDescriptor* value_field = field->message_type()->map_value();
+  MapIterator end = reflection->MapEnd(mutable_message, field);
+  for (MapIterator it = reflection->MapBegin(mutable_message, field);
+       it != end; ++it) {
+    RETURN_IF_ERROR(RenderValue(value_field, it.GetValueRef(),
+                                MapKeyAsString(it.GetKey()), ow));
+  }
+  return util::Status();
+}
+
+template <typename Value>
+util::Status MessageObjectSource::RenderValue(const FieldDescriptor* field,
+                                              const Value& value,
+                                              StringPiece name,
+                                              ObjectWriter* ow) const {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_MESSAGE:
+      return RenderNestedMessage(value.GetMessageValue(), name, ow);
+    case FieldDescriptor::TYPE_GROUP:
+      return util::Status(
+          util::error::UNIMPLEMENTED,
+          StrCat("Group fields are not supported in JSON: ",
+                       field->full_name()));
+    case FieldDescriptor::TYPE_BOOL:
+      ow->RenderBool(name, value.GetBoolValue());
+      break;
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_SINT32:
+    case FieldDescriptor::TYPE_SFIXED32:
+      ow->RenderInt32(name, value.GetInt32Value());
+      break;
+    case FieldDescriptor::TYPE_INT64:
+    case FieldDescriptor::TYPE_SINT64:
+    case FieldDescriptor::TYPE_SFIXED64:
+      ow->RenderInt64(name, value.GetInt64Value());
+      break;
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_FIXED32:
+      ow->RenderUint32(name, value.GetUInt32Value());
+      break;
+    case FieldDescriptor::TYPE_UINT64:
+    case FieldDescriptor::TYPE_FIXED64:
+      ow->RenderUint64(name, value.GetUInt64Value());
+      break;
+    case FieldDescriptor::TYPE_FLOAT:
+      ow->RenderFloat(name, value.GetFloatValue());
+      break;
+    case FieldDescriptor::TYPE_DOUBLE:
+      ow->RenderDouble(name, value.GetDoubleValue());
+      break;
+    case FieldDescriptor::TYPE_ENUM: {
+      int number = value.GetEnumValue();
+      const EnumDescriptor* enum_type = field->enum_type();
+      // If the field represents an explicit NULL value, render null.
+      if (enum_type->full_name() == "google.protobuf.NullValue") {
+        ow->RenderNull(name);
+        break;
+      }
+      // Unknown enum values are printed as integers.
+      const EnumValueDescriptor* enum_value =
+          enum_type->FindValueByNumber(number);
+      if (enum_value != nullptr && !use_ints_for_enums_) {
+        ow->RenderString(name, enum_value->name());
+      } else {
+        ow->RenderInt32(name, number);
+      }
+      break;
+    }
+    case FieldDescriptor::TYPE_STRING:
+      ow->RenderString(name, value.GetStringValue());
+      break;
+    case FieldDescriptor::TYPE_BYTES:
+      ow->RenderBytes(name, value.GetStringValue());
+      break;
+  }
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderNestedMessage(const Message& message,
+                                                      StringPiece name,
+                                                      ObjectWriter* ow) const {
+  RETURN_IF_ERROR(
+      IncrementRecursionDepth(message.GetDescriptor()->full_name(), name));
+  RETURN_IF_ERROR(WriteMessage(message, name, true, ow));
+  --recursion_depth_;
+  return util::Status();
+}
+
+util::Status MessageObjectSource::IncrementRecursionDepth(
+    StringPiece type_name, StringPiece field_name) const {
+  if (++recursion_depth_ > max_recursion_depth_) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        StrCat("Message too deep. Max recursion depth reached for type '",
+                     type_name, "', field '", field_name, "'"));
+  }
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderWellKnownType(
+    const Message& message, const TypeTable& table, StringPiece name,
+    ObjectWriter* ow) const {
+  switch (table.well_known_type) {
+    case WKT_TIMESTAMP:
+      return RenderTimestamp(message, name, ow);
+    case WKT_DURATION:
+      return RenderDuration(message, name, ow);
+    case WKT_WRAPPER: {
+      // Wrappers have a single "value" field with number 1.
+      const FieldDescriptor* field =
+          message.GetDescriptor()->FindFieldByNumber(1);
+      return RenderValue(field, FieldValue(message, field, -1), name, ow);
+    }
+    case WKT_ANY:
+      return RenderAny(message, name, ow);
+    case WKT_STRUCT:
+      return RenderStruct(message, name, ow);
+    case WKT_VALUE:
+      return RenderStructValue(message, name, ow);
+    case WKT_LIST_VALUE:
+      return RenderStructListValue(message, name, ow);
+    case WKT_FIELD_MASK:
+      return RenderFieldMask(message, name, ow);
+    case WKT_NONE:
+      break;
+  }
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderTimestamp(const Message& message,
+                                                  StringPiece field_name,
+                                                  ObjectWriter* ow) const {
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  int64 seconds =
+      reflection->GetInt64(message, descriptor->FindFieldByNumber(1));
+  int32 nanos = reflection->GetInt32(message, descriptor->FindFieldByNumber(2));
+  if (seconds > kTimestampMaxSeconds || seconds < kTimestampMinSeconds) {
+    return util::Status(
+        util::error::INTERNAL,
+        StrCat("Timestamp seconds exceeds limit for field: ",
+                     field_name));
+  }
+
+  if (nanos < 0 || nanos >= kNanosPerSecond) {
+    return util::Status(
+        util::error::INTERNAL,
+        StrCat("Timestamp nanos exceeds limit for field: ", field_name));
+  }
+
+  ow->RenderString(field_name,
+                   ::google::protobuf::internal::FormatTime(seconds, nanos));
+
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderDuration(const Message& message,
+                                                 StringPiece field_name,
+                                                 ObjectWriter* ow) const {
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  int64 seconds =
+      reflection->GetInt64(message, descriptor->FindFieldByNumber(1));
+  int32 nanos = reflection->GetInt32(message, descriptor->FindFieldByNumber(2));
+  if (seconds > kDurationMaxSeconds || seconds < kDurationMinSeconds) {
+    return util::Status(
+        util::error::INTERNAL,
+        StrCat("Duration seconds exceeds limit for field: ", field_name));
+  }
+
+  if (nanos <= -kNanosPerSecond || nanos >= kNanosPerSecond) {
+    return util::Status(
+        util::error::INTERNAL,
+        StrCat("Duration nanos exceeds limit for field: ", field_name));
+  }
+
+  std::string sign = "";
+  if (seconds < 0) {
+    if (nanos > 0) {
+      return util::Status(
+          util::error::INTERNAL,
+          StrCat("Duration nanos is non-negative, but seconds is "
+                       "negative for field: ",
+                       field_name));
+    }
+    sign = "-";
+    seconds = -seconds;
+    nanos = -nanos;
+  } else if (seconds == 0 && nanos < 0) {
+    sign = "-";
+    nanos = -nanos;
+  }
+  std::string formatted_duration = StringPrintf(
+      "%s%lld%ss", sign.c_str(), static_cast<long long>(seconds),  // NOLINT
+      FormatNanos(nanos, false).c_str());
+  ow->RenderString(field_name, formatted_duration);
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderAny(const Message& message,
+                                            StringPiece field_name,
+                                            ObjectWriter* ow) const {
+  // An Any is of the form { string type_url = 1; bytes value = 2; }
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  std::string type_url =
+      reflection->GetString(message, descriptor->FindFieldByNumber(1));
+  std::string value =
+      reflection->GetString(message, descriptor->FindFieldByNumber(2));
+
+  // If there is no value, we don't lookup the type, we just output it (if
+  // present). If both type and value are empty we output an empty object.
+  if (value.empty()) {
+    ow->StartObject(field_name);
+    if (!type_url.empty()) {
+      ow->RenderString("@type", type_url);
+    }
+    ow->EndObject();
+    return util::Status();
+  }
+
+  // If there is a value but no type, we cannot render it, so report an error.
+  if (type_url.empty()) {
+    return util::Status(util::error::INTERNAL,
+                        "Invalid Any, the type_url is missing.");
+  }
+
+  // Resolve the type the same way the TypeResolver for the message's pool
+  // would, reporting failures as internal errors.
+  const std::string prefix = StrCat(kTypeServiceBaseUrl, "/");
+  if (!HasPrefixString(type_url, prefix)) {
+    return util::Status(
+        util::error::INTERNAL,
+        StrCat("Invalid type URL, type URLs must be of the form '",
+                     kTypeServiceBaseUrl, "/<typename>', got: ", type_url));
+  }
+  const std::string type_name = type_url.substr(prefix.size());
+  const DescriptorPool* pool = message_.GetDescriptor()->file()->pool();
+  const Descriptor* nested_descriptor = pool->FindMessageTypeByName(type_name);
+  if (nested_descriptor == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "Invalid type URL, unknown type: " + type_name);
+  }
+
+  const Message* prototype;
+  if (pool == DescriptorPool::generated_pool()) {
+    prototype =
+        MessageFactory::generated_factory()->GetPrototype(nested_descriptor);
+  } else {
+    if (dynamic_factory_ == nullptr) {
+      dynamic_factory_.reset(new DynamicMessageFactory(pool));
+    }
+    prototype = dynamic_factory_->GetPrototype(nested_descriptor);
+  }
+  std::unique_ptr<Message> nested(prototype->New());
+  if (!nested->ParsePartialFromString(value)) {
+    return util::Status(util::error::INTERNAL,
+                        "Invalid Any, the value could not be parsed.");
+  }
+
+  // We manually call start and end object here so we can inject the @type.
+  // The payload is rendered with a fresh recursion depth, as a nested
+  // ProtoStreamObjectSource would.
+  int recursion_depth = recursion_depth_;
+  recursion_depth_ = 0;
+  ow->StartObject(field_name);
+  ow->RenderString("@type", type_url);
+  util::Status result = WriteMessage(*nested, "value", false, ow);
+  ow->EndObject();
+  recursion_depth_ = recursion_depth;
+  return result;
+}
+
+util::Status MessageObjectSource::RenderStruct(const Message& message,
+                                               StringPiece field_name,
+                                               ObjectWriter* ow) const {
+  // google.protobuf.Struct has only one field that is a map.
+  ow->StartObject(field_name);
+  RETURN_IF_ERROR(
+      RenderMap(message, message.GetDescriptor()->FindFieldByNumber(1), ow));
+  ow->EndObject();
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderStructValue(const Message& message,
+                                                    StringPiece field_name,
+                                                    ObjectWriter* ow) const {
+  // The fields of google.protobuf.Value all belong to the "kind" oneof, so at
+  // most one of them is rendered.
+  const Reflection* reflection = message.GetReflection();
+  for (const FieldDescriptor* field :
+       GetTable(message.GetDescriptor()).fields) {
+    if (reflection->HasField(message, field)) {
+      RETURN_IF_ERROR(RenderValue(field, FieldValue(message, field, -1),
+                                  field_name, ow));
+    }
+  }
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderStructListValue(
+    const Message& message, StringPiece field_name, ObjectWriter* ow) const {
+  const Reflection* reflection = message.GetReflection();
+  const FieldDescriptor* field = message.GetDescriptor()->FindFieldByNumber(1);
+  int size = reflection->FieldSize(message, field);
+  ow->StartList(field_name);
+  for (int i = 0; i < size; ++i) {
+    RETURN_IF_ERROR(RenderValue(field, FieldValue(message, field, i), "", ow));
+  }
+  ow->EndList();
+  return util::Status();
+}
+
+util::Status MessageObjectSource::RenderFieldMask(const Message& message,
+                                                  StringPiece field_name,
+                                                  ObjectWriter* ow) const {
+  const Reflection* reflection = message.GetReflection();
+  const FieldDescriptor* field = message.GetDescriptor()->FindFieldByNumber(1);
+  std::string combined;
+  std::string scratch;
+  int size = reflection->FieldSize(message, field);
+  for (int i = 0; i < size; ++i) {
+    const std::string& path =
+        reflection->GetRepeatedStringReference(message, field, i, &scratch);
+    if (!combined.empty()) {
+      combined.append(",");
+    }
+    combined.append(ConvertFieldMaskPath(path, &ToCamelCase));
+  }
+  ow->RenderString(field_name, combined);
+  return util::Status();
+}
+
+}  // namespace converter
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
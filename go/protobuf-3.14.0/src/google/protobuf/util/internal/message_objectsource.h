@@ -0,0 +1,176 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTSOURCE_H__
+#define GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTSOURCE_H__
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/util/internal/object_source.h>
+#include <google/protobuf/util/internal/object_writer.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/stubs/status.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+class DynamicMessageFactory;
+namespace util {
+namespace converter {
+
+// An ObjectSource that reads an in-memory Message through reflection.
+//
+// It produces the same sequence of ObjectWriter calls as serializing the
+// message and reading the bytes back with ProtoStreamObjectSource, including
+// the special rendering of well-known types, but skips the binary round trip
+// and the google.protobuf.Type lookups. Per-type information (fields in
+// number order, well-known type kind) is computed once per Descriptor.
+//
+// Any payloads are resolved against the DescriptorPool of the message being
+// rendered, under the "type.googleapis.com/" prefix. Group fields have no JSON
+// mapping; rendering a message with a group field set fails with
+// UNIMPLEMENTED.
+//
+// Sample usage:
+//   MessageObjectSource os(message);
+//   Status status = os.WriteTo(<some ObjectWriter>);
+class PROTOBUF_EXPORT MessageObjectSource : public ObjectSource {
+ public:
+  explicit MessageObjectSource(const Message& message);
+  ~MessageObjectSource() override;
+
+  util::Status NamedWriteTo(StringPiece name,
+                              ObjectWriter* ow) const override;
+
+  // Sets whether to always output enums as ints, by default this is off, and
+  // enums are rendered as strings.
+  void set_use_ints_for_enums(bool value) { use_ints_for_enums_ = value; }
+
+  // Sets whether to use original proto field names
+  void set_preserve_proto_field_names(bool value) {
+    preserve_proto_field_names_ = value;
+  }
+
+  // Sets the max recursion depth of proto message to be rendered. Proto
+  // messages over this depth will fail to be rendered.
+  // Default value is 64.
+  void set_max_recursion_depth(int max_depth) {
+    max_recursion_depth_ = max_depth;
+  }
+
+ private:
+  struct TypeTable;
+  class FieldValue;
+
+  // Returns the table for the given type, building it on first use.
+  const TypeTable& GetTable(const Descriptor* descriptor) const;
+
+  util::Status WriteMessage(const Message& message, StringPiece name,
+                              bool include_start_and_end,
+                              ObjectWriter* ow) const;
+
+  util::Status RenderMap(const Message& message,
+                           const FieldDescriptor* field,
+                           ObjectWriter* ow) const;
+
+  // Renders a single value of |field|. |value| is a FieldValue or a map's
+  // MapValueConstRef; both expose the same Get*Value() accessors.
+  template <typename Value>
+  util::Status RenderValue(const FieldDescriptor* field, const Value& value,
+                             StringPiece name, ObjectWriter* ow) const;
+
+  // Renders a message-typed value nested under the current message.
+  util::Status RenderNestedMessage(const Message& message, StringPiece name,
+                                     ObjectWriter* ow) const;
+
+  util::Status IncrementRecursionDepth(StringPiece type_name,
+                                         StringPiece field_name) const;
+
+  // Renderers for the well-known types, matching the ones in
+  // ProtoStreamObjectSource.
+  util::Status RenderWellKnownType(const Message& message,
+                                     const TypeTable& table, StringPiece name,
+                                     ObjectWriter* ow) const;
+  util::Status RenderTimestamp(const Message& message, StringPiece name,
+                                 ObjectWriter* ow) const;
+  util::Status RenderDuration(const Message& message, StringPiece name,
+                                ObjectWriter* ow) const;
+  util::Status RenderAny(const Message& message, StringPiece name,
+                           ObjectWriter* ow) const;
+  util::Status RenderStruct(const Message& message, StringPiece name,
+                              ObjectWriter* ow) const;
+  util::Status RenderStructValue(const Message& message, StringPiece name,
+                                   ObjectWriter* ow) const;
+  util::Status RenderStructListValue(const Message& message,
+                                       StringPiece name,
+                                       ObjectWriter* ow) const;
+  util::Status RenderFieldMask(const Message& message, StringPiece name,
+                                 ObjectWriter* ow) const;
+
+  // Root message to render.
+  const Message& message_;
+
+  // Whether to render enums as ints always. Defaults to false.
+  bool use_ints_for_enums_;
+
+  // Whether to preserve proto field names
+  bool preserve_proto_field_names_;
+
+  // Tracks current recursion depth.
+  mutable int recursion_depth_;
+
+  // Maximum allowed recursion depth.
+  int max_recursion_depth_;
+
+  // Tables already looked up by this source. Tables for generated types are
+  // shared process-wide; the others are owned by |owned_tables_|.
+  mutable std::unordered_map<const Descriptor*, const TypeTable*> tables_;
+  mutable std::vector<std::unique_ptr<TypeTable>> owned_tables_;
+
+  // Creates Any payloads of types outside the generated pool.
+  mutable std::unique_ptr<DynamicMessageFactory> dynamic_factory_;
+
+  GOOGLE_DISALLOW_IMPLICIT_CONSTRUCTORS(MessageObjectSource);
+};
+
+}  // namespace converter
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTSOURCE_H__
@@ -0,0 +1,690 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/internal/message_objectwriter.h>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/map_field.h>
+#include <google/protobuf/stubs/mutex.h>
+#include <google/protobuf/util/internal/utility.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/stubs/status.h>
+#include <google/protobuf/stubs/statusor.h>
+#include <google/protobuf/stubs/map_util.h>
+
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace converter {
+
+namespace {
+
+// Returns true for message types ProtoStreamObjectWriter renders in a special
+// way. Those are always left to it.
+bool IsSpecialType(const Descriptor* descriptor) {
+  if (descriptor->options().message_set_wire_format()) return true;
+  const std::string& name = descriptor->full_name();
+  if (!HasPrefixString(name, "google.protobuf.")) return false;
+  return IsWellKnownType(name) || name == "google.protobuf.Any" ||
+         name == "google.protobuf.Struct" || name == "google.protobuf.Value" ||
+         name == "google.protobuf.ListValue";
+}
+
+// Returns true for fields whose JSON null is a value rather than absence.
+bool AcceptsNull(const FieldDescriptor* field) {
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM) {
+    return field->enum_type()->full_name() == "google.protobuf.NullValue";
+  }
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    return field->message_type()->full_name() == "google.protobuf.Value";
+  }
+  return false;
+}
+
+// Returns true if the binary parser would reject |value| for |field|.
+bool IsInvalidString(const FieldDescriptor* field, const std::string& value) {
+  return field->type() == FieldDescriptor::TYPE_STRING &&
+         field->file()->syntax() == FileDescriptor::SYNTAX_PROTO3 &&
+         !::google::protobuf::internal::IsStructurallyValidUTF8(value);
+}
+
+// Returns true for enum fields that keep unknown numbers in the field itself
+// rather than in the unknown field set.
+bool IsOpenEnum(const FieldDescriptor* field) {
+  return field->file()->syntax() == FileDescriptor::SYNTAX_PROTO3;
+}
+
+}  // namespace
+
+// Maps the JSON names and the proto names of a type's fields to the fields,
+// with the precedence TypeInfo::FindField() gives them: a JSON name wins over
+// a proto name, and an earlier field over a later one.
+//
+// The names are placed with a seed chosen so that no two of them share a
+// slot, so a lookup is a single probe and one string comparison.
+class MessageObjectWriter::NameTable {
+ public:
+  explicit NameTable(const Descriptor* descriptor) : seed_(0), mask_(0) {
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      Add(descriptor->field(i)->json_name(), descriptor->field(i));
+    }
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      Add(descriptor->field(i)->name(), descriptor->field(i));
+    }
+    Build();
+  }
+
+  const FieldDescriptor* Find(StringPiece name) const {
+    if (entries_.empty()) return nullptr;
+    int index = slots_[Hash(seed_, name) & mask_];
+    if (index < 0 || entries_[index].name != name) return nullptr;
+    return entries_[index].field;
+  }
+
+ private:
+  struct Entry {
+    StringPiece name;
+    const FieldDescriptor* field;
+  };
+
+  static uint32 Hash(uint32 seed, StringPiece name) {
+    // FNV-1a, with the seed folded into the offset basis.
+    uint32 hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : name) {
+      hash ^= static_cast<uint8>(c);
+      hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+  }
+
+  void Add(StringPiece name, const FieldDescriptor* field) {
+    for (const Entry& entry : entries_) {
+      if (entry.name == name) return;
+    }
+    entries_.push_back({name, field});
+  }
+
+  // Finds a seed and a power-of-two table size with no collisions, growing
+  // the table whenever a batch of seeds fails.
+  void Build() {
+    if (entries_.empty()) return;
+    static const int kSeedsPerSize = 16;
+    uint32 size = 1;
+    while (size < 2 * entries_.size()) size <<= 1;
+    for (uint32 attempt = 0;; ++attempt) {
+      if (attempt > 0 && attempt % kSeedsPerSize == 0) size <<= 1;
+      slots_.assign(size, -1);
+      bool collision = false;
+      for (int i = 0; i < static_cast<int>(entries_.size()) && !collision;
+           ++i) {
+        int& slot = slots_[Hash(attempt, entries_[i].name) & (size - 1)];
+        collision = slot >= 0;
+        slot = i;
+      }
+      if (!collision) {
+        seed_ = attempt;
+        mask_ = size - 1;
+        return;
+      }
+    }
+  }
+
+  std::vector<Entry> entries_;
+  std::vector<int> slots_;
+  uint32 seed_;
+  uint32 mask_;
+};
+
+// Stores converted values into a singular field, appends them to a repeated
+// field, or sets a map entry's value.
+class MessageObjectWriter::ValueSink {
+ public:
+  ValueSink(Message* message, const FieldDescriptor* field)
+      : message_(message),
+        reflection_(message->GetReflection()),
+        field_(field),
+        map_value_(nullptr) {}
+  explicit ValueSink(MapValueRef* map_value)
+      : message_(nullptr),
+        reflection_(nullptr),
+        field_(nullptr),
+        map_value_(map_value) {}
+
+  void SetInt32(int32 value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetInt32Value(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddInt32(message_, field_, value);
+    } else {
+      reflection_->SetInt32(message_, field_, value);
+    }
+  }
+  void SetInt64(int64 value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetInt64Value(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddInt64(message_, field_, value);
+    } else {
+      reflection_->SetInt64(message_, field_, value);
+    }
+  }
+  void SetUInt32(uint32 value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetUInt32Value(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddUInt32(message_, field_, value);
+    } else {
+      reflection_->SetUInt32(message_, field_, value);
+    }
+  }
+  void SetUInt64(uint64 value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetUInt64Value(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddUInt64(message_, field_, value);
+    } else {
+      reflection_->SetUInt64(message_, field_, value);
+    }
+  }
+  void SetDouble(double value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetDoubleValue(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddDouble(message_, field_, value);
+    } else {
+      reflection_->SetDouble(message_, field_, value);
+    }
+  }
+  void SetFloat(float value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetFloatValue(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddFloat(message_, field_, value);
+    } else {
+      reflection_->SetFloat(message_, field_, value);
+    }
+  }
+  void SetBool(bool value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetBoolValue(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddBool(message_, field_, value);
+    } else {
+      reflection_->SetBool(message_, field_, value);
+    }
+  }
+  void SetEnum(int value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetEnumValue(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddEnumValue(message_, field_, value);
+    } else {
+      reflection_->SetEnumValue(message_, field_, value);
+    }
+  }
+  void SetString(std::string value) {
+    if (map_value_ != nullptr) {
+      map_value_->SetStringValue(value);
+    } else if (field_->is_repeated()) {
+      reflection_->AddString(message_, field_, std::move(value));
+    } else {
+      reflection_->SetString(message_, field_, std::move(value));
+    }
+  }
+
+ private:
+  Message* message_;
+  const Reflection* reflection_;
+  const FieldDescriptor* field_;
+  MapValueRef* map_value_;
+};
+
+MessageObjectWriter::MessageObjectWriter(Message* message)
+    : message_(message),
+      ignore_unknown_fields_(false),
+      case_insensitive_enum_parsing_(false),
+      failed_(false),
+      done_(false),
+      skip_depth_(0) {}
+
+MessageObjectWriter::~MessageObjectWriter() {}
+
+const MessageObjectWriter::NameTable& MessageObjectWriter::GetTable(
+    const Descriptor* descriptor) {
+  const NameTable* table = FindPtrOrNull(tables_, descriptor);
+  if (table != nullptr) return *table;
+
+  if (descriptor->file()->pool() == DescriptorPool::generated_pool()) {
+    // Generated descriptors live for the whole process, so their tables are
+    // shared between writers.
+    static ::google::protobuf::internal::WrappedMutex mu;
+    static auto* shared =
+        ::google::protobuf::internal::OnShutdownDelete(
+            new std::unordered_map<const Descriptor*,
+                                   std::unique_ptr<const NameTable>>());
+    ::google::protobuf::internal::MutexLock lock(&mu);
+    std::unique_ptr<const NameTable>& entry = (*shared)[descriptor];
+    if (entry == nullptr) entry.reset(new NameTable(descriptor));
+    table = entry.get();
+  } else {
+    owned_tables_.emplace_back(new NameTable(descriptor));
+    table = owned_tables_.back().get();
+  }
+  tables_[descriptor] = table;
+  return *table;
+}
+
+void MessageObjectWriter::PushMessage(Message* message) {
+  const Descriptor* descriptor = message->GetDescriptor();
+  Frame frame;
+  frame.kind = Frame::MESSAGE;
+  frame.message = message;
+  frame.field = nullptr;
+  frame.table = &GetTable(descriptor);
+  frame.oneofs_taken.resize(descriptor->oneof_decl_count());
+  stack_.push_back(std::move(frame));
+}
+
+MessageObjectWriter* MessageObjectWriter::StartObject(StringPiece name) {
+  if (failed_) return this;
+  if (skip_depth_ > 0) {
+    ++skip_depth_;
+    return this;
+  }
+
+  if (stack_.empty()) {
+    if (done_ || !name.empty() || IsSpecialType(message_->GetDescriptor())) {
+      Fail();
+    } else {
+      PushMessage(message_);
+    }
+    return this;
+  }
+
+  Frame& top = stack_.back();
+  Message* message = top.message;
+  const Reflection* reflection = message->GetReflection();
+  const FieldDescriptor* field = nullptr;
+  switch (top.kind) {
+    case Frame::MESSAGE: {
+      field = LookupField(name, true);
+      if (field == nullptr) return this;
+      if (field->is_map()) {
+        Frame frame;
+        frame.kind = Frame::MAP;
+        frame.message = message;
+        frame.field = field;
+        frame.table = nullptr;
+        stack_.push_back(std::move(frame));
+        return this;
+      }
+      if (field->type() != FieldDescriptor::TYPE_MESSAGE ||
+          IsSpecialType(field->message_type()) || !TakeOneof(field)) {
+        Fail();
+        return this;
+      }
+      PushMessage(field->is_repeated() ? reflection->AddMessage(message, field)
+                                       : reflection->MutableMessage(message,
+                                                                    field));
+      return this;
+    }
+    case Frame::LIST: {
+      field = top.field;
+      if (field->type() != FieldDescriptor::TYPE_MESSAGE ||
+          IsSpecialType(field->message_type())) {
+        Fail();
+        return this;
+      }
+      PushMessage(reflection->AddMessage(message, field));
+      return this;
+    }
+    case Frame::MAP: {
+      const FieldDescriptor* value_field =
+          top.field->message_type()->map_value();
+      MapValueRef value;
+      if (value_field->type() != FieldDescriptor::TYPE_MESSAGE ||
+          IsSpecialType(value_field->message_type()) ||
+          !InsertMapEntry(message, top.field, name, &value)) {
+        Fail();
+        return this;
+      }
+      PushMessage(value.MutableMessageValue());
+      return this;
+    }
+  }
+  return this;
+}
+
+MessageObjectWriter* MessageObjectWriter::EndObject() {
+  if (failed_) return this;
+  if (skip_depth_ > 0) {
+    --skip_depth_;
+    return this;
+  }
+  if (stack_.empty() || stack_.back().kind == Frame::LIST) {
+    Fail();
+    return this;
+  }
+  stack_.pop_back();
+  if (stack_.empty()) done_ = true;
+  return this;
+}
+
+MessageObjectWriter* MessageObjectWriter::StartList(StringPiece name) {
+  if (failed_) return this;
+  if (skip_depth_ > 0) {
+    ++skip_depth_;
+    return this;
+  }
+  // Lists of lists and lists of map entries are flattened or rejected by
+  // ProtoStreamObjectWriter in ways not worth repeating here.
+  if (stack_.empty() || stack_.back().kind != Frame::MESSAGE) {
+    Fail();
+    return this;
+  }
+  const FieldDescriptor* field = LookupField(name, true);
+  if (field == nullptr) return this;
+  if (!field->is_repeated() || field->is_map()) {
+    Fail();
+    return this;
+  }
+  Frame frame;
+  frame.kind = Frame::LIST;
+  frame.message = stack_.back().message;
+  frame.field = field;
+  frame.table = nullptr;
+  stack_.push_back(std::move(frame));
+  return this;
+}
+
+MessageObjectWriter* MessageObjectWriter::EndList() {
+  if (failed_) return this;
+  if (skip_depth_ > 0) {
+    --skip_depth_;
+    return this;
+  }
+  if (stack_.empty() || stack_.back().kind != Frame::LIST) {
+    Fail();
+    return this;
+  }
+  stack_.pop_back();
+  return this;
+}
+
+MessageObjectWriter* MessageObjectWriter::RenderDataPiece(
+    StringPiece name, const DataPiece& data) {
+  if (failed_ || skip_depth_ > 0) return this;
+  if (stack_.empty()) {
+    Fail();
+    return this;
+  }
+
+  Frame& top = stack_.back();
+  bool is_null = data.type() == DataPiece::TYPE_NULL;
+  bool skipped = false;
+  switch (top.kind) {
+    case Frame::MESSAGE: {
+      const FieldDescriptor* field = LookupField(name, false);
+      if (field == nullptr) return this;
+      // A null leaves the field untouched and does not claim its oneof.
+      if (is_null && !AcceptsNull(field)) return this;
+      if (is_null || field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE ||
+          !TakeOneof(field)) {
+        Fail();
+        return this;
+      }
+      ValueSink sink(top.message, field);
+      if (!StoreValue(field, data, &sink, &skipped)) Fail();
+      return this;
+    }
+    case Frame::LIST: {
+      const FieldDescriptor* field = top.field;
+      if (is_null && !AcceptsNull(field)) return this;
+      if (is_null || field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        Fail();
+        return this;
+      }
+      ValueSink sink(top.message, field);
+      if (!StoreValue(field, data, &sink, &skipped)) Fail();
+      return this;
+    }
+    case Frame::MAP: {
+      // Null and ignored enum values still produce an entry with a default
+      // value in the binary round trip; leave those to it.
+      const FieldDescriptor* value_field =
+          top.field->message_type()->map_value();
+      MapValueRef value;
+      if (is_null ||
+          value_field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE ||
+          !InsertMapEntry(top.message, top.field, name, &value)) {
+        Fail();
+        return this;
+      }
+      ValueSink sink(&value);
+      if (!StoreValue(value_field, data, &sink, &skipped) || skipped) Fail();
+      return this;
+    }
+  }
+  return this;
+}
+
+const FieldDescriptor* MessageObjectWriter::LookupField(StringPiece name,
+                                                        bool is_object) {
+  const FieldDescriptor* field = nullptr;
+  // An empty name only occurs inside lists, where ProtoWriter hands out the
+  // enclosing field again.
+  if (!name.empty()) field = stack_.back().table->Find(name);
+  if (field == nullptr) {
+    if (!ignore_unknown_fields_ || name.empty()) {
+      Fail();
+    } else if (is_object) {
+      ++skip_depth_;
+    }
+    return nullptr;
+  }
+  if (field->type() == FieldDescriptor::TYPE_GROUP) {
+    Fail();
+    return nullptr;
+  }
+  return field;
+}
+
+bool MessageObjectWriter::TakeOneof(const FieldDescriptor* field) {
+  const OneofDescriptor* oneof = field->containing_oneof();
+  if (oneof == nullptr) return true;
+  std::vector<bool>& taken = stack_.back().oneofs_taken;
+  if (taken[oneof->index()]) return false;
+  taken[oneof->index()] = true;
+  return true;
+}
+
+bool MessageObjectWriter::StoreValue(const FieldDescriptor* field,
+                                     const DataPiece& data, ValueSink* sink,
+                                     bool* skipped) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_SINT32:
+    case FieldDescriptor::TYPE_SFIXED32: {
+      util::StatusOr<int32> value = data.ToInt32();
+      if (!value.ok()) return false;
+      sink->SetInt32(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_INT64:
+    case FieldDescriptor::TYPE_SINT64:
+    case FieldDescriptor::TYPE_SFIXED64: {
+      util::StatusOr<int64> value = data.ToInt64();
+      if (!value.ok()) return false;
+      sink->SetInt64(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_FIXED32: {
+      util::StatusOr<uint32> value = data.ToUint32();
+      if (!value.ok()) return false;
+      sink->SetUInt32(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_UINT64:
+    case FieldDescriptor::TYPE_FIXED64: {
+      util::StatusOr<uint64> value = data.ToUint64();
+      if (!value.ok()) return false;
+      sink->SetUInt64(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_DOUBLE: {
+      util::StatusOr<double> value = data.ToDouble();
+      if (!value.ok()) return false;
+      sink->SetDouble(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_FLOAT: {
+      util::StatusOr<float> value = data.ToFloat();
+      if (!value.ok()) return false;
+      sink->SetFloat(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_BOOL: {
+      util::StatusOr<bool> value = data.ToBool();
+      if (!value.ok()) return false;
+      sink->SetBool(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_STRING: {
+      util::StatusOr<std::string> value = data.ToString();
+      if (!value.ok() || IsInvalidString(field, value.value())) return false;
+      sink->SetString(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_BYTES: {
+      util::StatusOr<std::string> value = data.ToBytes();
+      if (!value.ok()) return false;
+      sink->SetString(value.value());
+      return true;
+    }
+    case FieldDescriptor::TYPE_ENUM: {
+      // Same order of attempts as DataPiece::ToEnum().
+      const EnumDescriptor* enum_type = field->enum_type();
+      if (data.type() != DataPiece::TYPE_STRING) {
+        util::StatusOr<int32> number = data.ToInt32();
+        if (!number.ok() ||
+            (!IsOpenEnum(field) &&
+             enum_type->FindValueByNumber(number.value()) == nullptr)) {
+          return false;
+        }
+        sink->SetEnum(number.value());
+        return true;
+      }
+      std::string enum_name(data.str());
+      const EnumValueDescriptor* value = enum_type->FindValueByName(enum_name);
+      if (value == nullptr) {
+        util::StatusOr<int32> number = data.ToInt32();
+        if (number.ok()) value = enum_type->FindValueByNumber(number.value());
+      }
+      if (value == nullptr && case_insensitive_enum_parsing_) {
+        for (std::string::iterator it = enum_name.begin();
+             it != enum_name.end(); ++it) {
+          *it = *it == '-' ? '_' : ascii_toupper(*it);
+        }
+        value = enum_type->FindValueByName(enum_name);
+      }
+      if (value == nullptr) {
+        *skipped = ignore_unknown_fields_;
+        return ignore_unknown_fields_;
+      }
+      sink->SetEnum(value->number());
+      return true;
+    }
+    default:  // TYPE_GROUP, TYPE_MESSAGE.
+      return false;
+  }
+}
+
+bool MessageObjectWriter::InsertMapEntry(Message* message,
+                                         const FieldDescriptor* field,
+                                         StringPiece key, MapValueRef* value) {
+  const FieldDescriptor* key_field = field->message_type()->map_key();
+  DataPiece data(key, use_strict_base64_decoding());
+  MapKey map_key;
+  switch (key_field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32: {
+      util::StatusOr<int32> converted = data.ToInt32();
+      if (!converted.ok()) return false;
+      map_key.SetInt32Value(converted.value());
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_INT64: {
+      util::StatusOr<int64> converted = data.ToInt64();
+      if (!converted.ok()) return false;
+      map_key.SetInt64Value(converted.value());
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_UINT32: {
+      util::StatusOr<uint32> converted = data.ToUint32();
+      if (!converted.ok()) return false;
+      map_key.SetUInt32Value(converted.value());
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_UINT64: {
+      util::StatusOr<uint64> converted = data.ToUint64();
+      if (!converted.ok()) return false;
+      map_key.SetUInt64Value(converted.value());
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_BOOL: {
+      util::StatusOr<bool> converted = data.ToBool();
+      if (!converted.ok()) return false;
+      map_key.SetBoolValue(converted.value());
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string converted(key);
+      if (IsInvalidString(key_field, converted)) return false;
+      map_key.SetStringValue(std::move(converted));
+      break;
+    }
+    default:
+      return false;
+  }
+  // A key seen before means either a duplicate within one object, which is
+  // an error, or a second occurrence of the map field, where the last entry
+  // wins; neither is handled here.
+  return message->GetReflection()->InsertOrLookupMapValue(message, field,
+                                                          map_key, value);
+}
+
+}  // namespace converter
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
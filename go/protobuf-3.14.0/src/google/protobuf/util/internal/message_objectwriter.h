@@ -0,0 +1,225 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTWRITER_H__
+#define GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTWRITER_H__
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/util/internal/datapiece.h>
+#include <google/protobuf/util/internal/object_writer.h>
+#include <google/protobuf/stubs/strutil.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace converter {
+
+// An ObjectWriter that fills an in-memory Message through reflection.
+//
+// It accepts the events JsonStreamParser produces for a JSON object and
+// stores them straight into |message|, allocating sub-messages on the
+// message's arena, instead of transcoding to the binary format with
+// ProtoStreamObjectWriter and parsing the bytes back.
+//
+// The writer only handles the input it can store exactly as the binary round
+// trip would. Anything else -- well-known types, nulls with a meaning, map
+// entries that repeat a key, open questions about unknown enum numbers, and
+// every kind of malformed input -- marks the writer as failed and the rest of
+// the input is ignored. Callers must then discard |message| and take the
+// ProtoStreamObjectWriter path, which also produces the error messages.
+//
+// Sample usage:
+//   MessageObjectWriter writer(message);
+//   JsonStreamParser parser(&writer);
+//   if (parser.Parse(json).ok() && parser.FinishParse().ok() &&
+//       !writer.failed() && message->IsInitialized()) {
+//     ...
+//   }
+class PROTOBUF_EXPORT MessageObjectWriter : public ObjectWriter {
+ public:
+  explicit MessageObjectWriter(Message* message);
+  ~MessageObjectWriter() override;
+
+  // ObjectWriter methods.
+  MessageObjectWriter* StartObject(StringPiece name) override;
+  MessageObjectWriter* EndObject() override;
+  MessageObjectWriter* StartList(StringPiece name) override;
+  MessageObjectWriter* EndList() override;
+  MessageObjectWriter* RenderBool(StringPiece name, bool value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderInt32(StringPiece name, int32 value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderUint32(StringPiece name, uint32 value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderInt64(StringPiece name, int64 value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderUint64(StringPiece name, uint64 value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderDouble(StringPiece name, double value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderFloat(StringPiece name, float value) override {
+    return RenderDataPiece(name, DataPiece(value));
+  }
+  MessageObjectWriter* RenderString(StringPiece name,
+                                    StringPiece value) override {
+    return RenderDataPiece(name,
+                           DataPiece(value, use_strict_base64_decoding()));
+  }
+  MessageObjectWriter* RenderBytes(StringPiece name,
+                                   StringPiece value) override {
+    return RenderDataPiece(
+        name, DataPiece(value, false, use_strict_base64_decoding()));
+  }
+  MessageObjectWriter* RenderNull(StringPiece name) override {
+    return RenderDataPiece(name, DataPiece::NullData());
+  }
+
+  // Sets whether fields missing from the message type are skipped rather
+  // than treated as an error. As in ProtoStreamObjectWriter, this also skips
+  // enum names the enum type does not define.
+  void set_ignore_unknown_fields(bool value) {
+    ignore_unknown_fields_ = value;
+  }
+
+  // Sets whether enum names are also matched after upper-casing them and
+  // replacing '-' with '_'.
+  void set_case_insensitive_enum_parsing(bool value) {
+    case_insensitive_enum_parsing_ = value;
+  }
+
+  // Returns true if some input could not be stored exactly.
+  bool failed() const { return failed_; }
+
+  // Returns true once the root object has been closed.
+  bool done() override { return done_; }
+
+ private:
+  class NameTable;
+  class ValueSink;
+
+  // An open object or list.
+  struct Frame {
+    enum Kind {
+      MESSAGE,  // An object filling |message|.
+      LIST,     // A list of values for the repeated |field| of |message|.
+      MAP,      // An object of entries for the map |field| of |message|.
+    };
+
+    Kind kind;
+    Message* message;
+    const FieldDescriptor* field;
+    // Field lookup table of a MESSAGE frame's message type.
+    const NameTable* table;
+    // Oneofs of a MESSAGE frame that already have a value, by oneof index.
+    std::vector<bool> oneofs_taken;
+  };
+
+  // Returns the field lookup table for the given type, building it on first
+  // use.
+  const NameTable& GetTable(const Descriptor* descriptor);
+
+  MessageObjectWriter* RenderDataPiece(StringPiece name,
+                                       const DataPiece& data);
+
+  // Looks up |name| in the message of the innermost frame. Returns nullptr
+  // and either fails or starts skipping when there is no such field.
+  const FieldDescriptor* LookupField(StringPiece name, bool is_object);
+
+  // Records that a member of |field|'s oneof is set in the innermost frame.
+  // Returns false if another value for the oneof was already seen there.
+  bool TakeOneof(const FieldDescriptor* field);
+
+  // Converts |data| to the type of |field| and stores it into |sink|.
+  // Returns false if the value cannot be stored exactly. Sets |*skipped| when
+  // an unknown enum name is ignored instead.
+  bool StoreValue(const FieldDescriptor* field, const DataPiece& data,
+                  ValueSink* sink, bool* skipped);
+
+  // Inserts the entry for |key| into the map |field| of |message|. Returns
+  // false if the key does not convert or is already present.
+  bool InsertMapEntry(Message* message, const FieldDescriptor* field,
+                      StringPiece key, MapValueRef* value);
+
+  // Pushes a frame for filling |message|.
+  void PushMessage(Message* message);
+
+  void Fail() { failed_ = true; }
+
+  // Root message to fill.
+  Message* message_;
+
+  // Whether to skip unknown fields and enum names.
+  bool ignore_unknown_fields_;
+
+  // Whether to normalize enum names that do not match exactly.
+  bool case_insensitive_enum_parsing_;
+
+  // Set once input could not be stored; everything after it is ignored.
+  bool failed_;
+
+  // Set once the root object is closed.
+  bool done_;
+
+  // Number of nested objects and lists being skipped as unknown fields.
+  int skip_depth_;
+
+  // Open objects and lists, innermost last.
+  std::vector<Frame> stack_;
+
+  // Tables already looked up by this writer. Tables for generated types are
+  // shared process-wide; the others are owned by |owned_tables_|.
+  std::unordered_map<const Descriptor*, const NameTable*> tables_;
+  std::vector<std::unique_ptr<NameTable>> owned_tables_;
+
+  GOOGLE_DISALLOW_IMPLICIT_CONSTRUCTORS(MessageObjectWriter);
+};
+
+}  // namespace converter
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_UTIL_CONVERTER_MESSAGE_OBJECTWRITER_H__
@@ -75,6 +75,12 @@ class PROTOBUF_EXPORT ProtoStreamObjectSource : public ObjectSource {
                           TypeResolver* type_resolver,
                           const google::protobuf::Type& type);
 
+  // Like above, but looks types up in |typeinfo|, which must outlive the
+  // source.
+  ProtoStreamObjectSource(io::CodedInputStream* stream,
+                          const TypeInfo* typeinfo,
+                          const google::protobuf::Type& type);
+
   ~ProtoStreamObjectSource() override;
 
   util::Status NamedWriteTo(StringPiece name,
@@ -164,9 +170,6 @@ class PROTOBUF_EXPORT ProtoStreamObjectSource : public ObjectSource {
   io::CodedInputStream* stream() const { return stream_; }
 
  private:
-  ProtoStreamObjectSource(io::CodedInputStream* stream,
-                          const TypeInfo* typeinfo,
-                          const google::protobuf::Type& type);
   // Function that renders a well known type with a modified behavior.
   typedef util::Status (*TypeRenderer)(const ProtoStreamObjectSource*,
                                          const google::protobuf::Type&,
@@ -140,6 +140,13 @@ class PROTOBUF_EXPORT ProtoStreamObjectWriter : public ProtoWriter {
                           strings::ByteSink* output, ErrorListener* listener,
                           const ProtoStreamObjectWriter::Options& options =
                               ProtoStreamObjectWriter::Options::Defaults());
+
+  // Like above, but looks types up in |typeinfo|, which must outlive the
+  // writer. Does not take ownership of any parameter passed in.
+  ProtoStreamObjectWriter(const TypeInfo* typeinfo,
+                          const google::protobuf::Type& type,
+                          strings::ByteSink* output, ErrorListener* listener,
+                          const ProtoStreamObjectWriter::Options& options);
   ~ProtoStreamObjectWriter() override;
 
   // ObjectWriter methods.
@@ -342,11 +349,6 @@ class PROTOBUF_EXPORT ProtoStreamObjectWriter : public ProtoWriter {
                           const google::protobuf::Type& type,
                           strings::ByteSink* output, ErrorListener* listener);
 
-  ProtoStreamObjectWriter(const TypeInfo* typeinfo,
-                          const google::protobuf::Type& type,
-                          strings::ByteSink* output, ErrorListener* listener,
-                          const ProtoStreamObjectWriter::Options& options);
-
   // Returns true if the field is a map.
   inline bool IsMap(const google::protobuf::Field& field);
 
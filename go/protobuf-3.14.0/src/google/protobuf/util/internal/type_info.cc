@@ -35,6 +35,7 @@
 
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/type.pb.h>
+#include <google/protobuf/stubs/mutex.h>
 #include <google/protobuf/util/internal/utility.h>
 #include <google/protobuf/stubs/status.h>
 #include <google/protobuf/stubs/strutil.h>
@@ -48,11 +49,14 @@ namespace util {
 namespace converter {
 
 namespace {
-// A TypeInfo that looks up information provided by a TypeResolver.
+// A TypeInfo that looks up information provided by a TypeResolver. Takes
+// ownership of |mu|; if it is non-null, every lookup holds it, so the caches
+// may be shared between threads.
 class TypeInfoForTypeResolver : public TypeInfo {
  public:
-  explicit TypeInfoForTypeResolver(TypeResolver* type_resolver)
-      : type_resolver_(type_resolver) {}
+  TypeInfoForTypeResolver(TypeResolver* type_resolver,
+                          ::google::protobuf::internal::WrappedMutex* mu)
+      : type_resolver_(type_resolver), mu_(mu) {}
 
   virtual ~TypeInfoForTypeResolver() {
     DeleteCachedTypes(&cached_types_);
@@ -61,32 +65,20 @@ class TypeInfoForTypeResolver : public TypeInfo {
 
   util::StatusOr<const google::protobuf::Type*> ResolveTypeUrl(
       StringPiece type_url) const override {
-    std::map<StringPiece, StatusOrType>::iterator it =
-        cached_types_.find(type_url);
-    if (it != cached_types_.end()) {
-      return it->second;
-    }
-    // Stores the string value so it can be referenced using StringPiece in the
-    // cached_types_ map.
-    const std::string& string_type_url =
-        *string_storage_.insert(std::string(type_url)).first;
-    std::unique_ptr<google::protobuf::Type> type(new google::protobuf::Type());
-    util::Status status =
-        type_resolver_->ResolveMessageType(string_type_url, type.get());
-    StatusOrType result =
-        status.ok() ? StatusOrType(type.release()) : StatusOrType(status);
-    cached_types_[string_type_url] = result;
-    return result;
+    ::google::protobuf::internal::MutexLockMaybe lock(mu_.get());
+    return ResolveTypeUrlLocked(type_url);
   }
 
   const google::protobuf::Type* GetTypeByTypeUrl(
       StringPiece type_url) const override {
-    StatusOrType result = ResolveTypeUrl(type_url);
+    ::google::protobuf::internal::MutexLockMaybe lock(mu_.get());
+    StatusOrType result = ResolveTypeUrlLocked(type_url);
     return result.ok() ? result.value() : NULL;
   }
 
   const google::protobuf::Enum* GetEnumByTypeUrl(
       StringPiece type_url) const override {
+    ::google::protobuf::internal::MutexLockMaybe lock(mu_.get());
     std::map<StringPiece, StatusOrEnum>::iterator it =
         cached_enums_.find(type_url);
     if (it != cached_enums_.end()) {
@@ -109,6 +101,7 @@ class TypeInfoForTypeResolver : public TypeInfo {
   const google::protobuf::Field* FindField(
       const google::protobuf::Type* type,
       StringPiece camel_case_name) const override {
+    ::google::protobuf::internal::MutexLockMaybe lock(mu_.get());
     std::map<const google::protobuf::Type*, CamelCaseNameTable>::const_iterator
         it = indexed_types_.find(type);
     const CamelCaseNameTable& camel_case_name_table =
@@ -129,6 +122,25 @@ class TypeInfoForTypeResolver : public TypeInfo {
   typedef util::StatusOr<const google::protobuf::Enum*> StatusOrEnum;
   typedef std::map<StringPiece, StringPiece> CamelCaseNameTable;
 
+  StatusOrType ResolveTypeUrlLocked(StringPiece type_url) const {
+    std::map<StringPiece, StatusOrType>::iterator it =
+        cached_types_.find(type_url);
+    if (it != cached_types_.end()) {
+      return it->second;
+    }
+    // Stores the string value so it can be referenced using StringPiece in the
+    // cached_types_ map.
+    const std::string& string_type_url =
+        *string_storage_.insert(std::string(type_url)).first;
+    std::unique_ptr<google::protobuf::Type> type(new google::protobuf::Type());
+    util::Status status =
+        type_resolver_->ResolveMessageType(string_type_url, type.get());
+    StatusOrType result =
+        status.ok() ? StatusOrType(type.release()) : StatusOrType(status);
+    cached_types_[string_type_url] = result;
+    return result;
+  }
+
   template <typename T>
   static void DeleteCachedTypes(std::map<StringPiece, T>* cached_types) {
     for (typename std::map<StringPiece, T>::iterator it =
@@ -160,6 +172,9 @@ class TypeInfoForTypeResolver : public TypeInfo {
 
   TypeResolver* type_resolver_;
 
+  // Guards the caches below when the TypeInfo is shared; may be null.
+  std::unique_ptr<::google::protobuf::internal::WrappedMutex> mu_;
+
   // Stores string values that will be referenced by StringPieces in
   // cached_types_, cached_enums_.
   mutable std::set<std::string> string_storage_;
@@ -173,7 +188,12 @@ class TypeInfoForTypeResolver : public TypeInfo {
 }  // namespace
 
 TypeInfo* TypeInfo::NewTypeInfo(TypeResolver* type_resolver) {
-  return new TypeInfoForTypeResolver(type_resolver);
+  return new TypeInfoForTypeResolver(type_resolver, nullptr);
+}
+
+TypeInfo* TypeInfo::NewThreadSafeTypeInfo(TypeResolver* type_resolver) {
+  return new TypeInfoForTypeResolver(
+      type_resolver, new ::google::protobuf::internal::WrappedMutex());
 }
 
 }  // namespace converter
@@ -46,7 +46,8 @@ namespace protobuf {
 namespace util {
 namespace converter {
 // Internal helper class for type resolving. Note that this class is not
-// thread-safe and should only be accessed in one thread.
+// thread-safe and should only be accessed in one thread, unless created with
+// NewThreadSafeTypeInfo().
 class PROTOBUF_EXPORT TypeInfo {
  public:
   TypeInfo() {}
@@ -83,6 +84,12 @@ class PROTOBUF_EXPORT TypeInfo {
   // TypeResolver. Caller takes ownership of the returned pointer.
   static TypeInfo* NewTypeInfo(TypeResolver* type_resolver);
 
+  // Like NewTypeInfo(), but lookups are serialized so that one instance, and
+  // the types it has resolved, can be shared by several threads. The
+  // TypeResolver must be thread-safe itself. Caller takes ownership of the
+  // returned pointer.
+  static TypeInfo* NewThreadSafeTypeInfo(TypeResolver* type_resolver);
+
  private:
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(TypeInfo);
 };
@@ -173,6 +173,12 @@ bool IsMessageSetWireFormat(const google::protobuf::Type& type);
 PROTOBUF_EXPORT std::string DoubleAsString(double value);
 PROTOBUF_EXPORT std::string FloatAsString(float value);
 
+// Formats nanos as the fractional seconds of a Timestamp or Duration, e.g.
+// ".500" or ".000000123". Zero nanos format as "" (or ".000" when
+// with_trailing_zeros is set).
+PROTOBUF_EXPORT std::string FormatNanos(uint32 nanos,
+                                        bool with_trailing_zeros);
+
 // Convert from int32, int64, uint32, uint64, double or float to string.
 template <typename T>
 std::string ValueAsString(T value) {
@@ -38,8 +38,11 @@
 #include <google/protobuf/util/internal/error_listener.h>
 #include <google/protobuf/util/internal/json_objectwriter.h>
 #include <google/protobuf/util/internal/json_stream_parser.h>
+#include <google/protobuf/util/internal/message_objectsource.h>
+#include <google/protobuf/util/internal/message_objectwriter.h>
 #include <google/protobuf/util/internal/protostream_objectsource.h>
 #include <google/protobuf/util/internal/protostream_objectwriter.h>
+#include <google/protobuf/util/internal/type_info.h>
 #include <google/protobuf/util/type_resolver.h>
 #include <google/protobuf/util/type_resolver_util.h>
 #include <google/protobuf/stubs/bytestream.h>
@@ -81,15 +84,18 @@ void ZeroCopyStreamByteSink::Append(const char* bytes, size_t len) {
 }
 }  // namespace internal
 
-util::Status BinaryToJsonStream(TypeResolver* resolver,
-                                  const std::string& type_url,
-                                  io::ZeroCopyInputStream* binary_input,
-                                  io::ZeroCopyOutputStream* json_output,
-                                  const JsonPrintOptions& options) {
+namespace {
+// BinaryToJsonStream(), looking types up in |typeinfo|.
+util::Status BinaryToJsonStreamWithTypeInfo(
+    const converter::TypeInfo* typeinfo, const std::string& type_url,
+    io::ZeroCopyInputStream* binary_input,
+    io::ZeroCopyOutputStream* json_output, const JsonPrintOptions& options) {
   io::CodedInputStream in_stream(binary_input);
-  google::protobuf::Type type;
-  RETURN_IF_ERROR(resolver->ResolveMessageType(type_url, &type));
-  converter::ProtoStreamObjectSource proto_source(&in_stream, resolver, type);
+  util::StatusOr<const google::protobuf::Type*> resolved =
+      typeinfo->ResolveTypeUrl(type_url);
+  RETURN_IF_ERROR(resolved.status());
+  const google::protobuf::Type& type = *resolved.value();
+  converter::ProtoStreamObjectSource proto_source(&in_stream, typeinfo, type);
   proto_source.set_use_ints_for_enums(options.always_print_enums_as_ints);
   proto_source.set_preserve_proto_field_names(
       options.preserve_proto_field_names);
@@ -97,7 +103,7 @@ util::Status BinaryToJsonStream(TypeResolver* resolver,
   converter::JsonObjectWriter json_writer(options.add_whitespace ? " " : "",
                                           &out_stream);
   if (options.always_print_primitive_fields) {
-    converter::DefaultValueObjectWriter default_value_writer(resolver, type,
+    converter::DefaultValueObjectWriter default_value_writer(typeinfo, type,
                                                              &json_writer);
     default_value_writer.set_preserve_proto_field_names(
         options.preserve_proto_field_names);
@@ -108,6 +114,18 @@ util::Status BinaryToJsonStream(TypeResolver* resolver,
     return proto_source.WriteTo(&json_writer);
   }
 }
+}  // namespace
+
+util::Status BinaryToJsonStream(TypeResolver* resolver,
+                                  const std::string& type_url,
+                                  io::ZeroCopyInputStream* binary_input,
+                                  io::ZeroCopyOutputStream* json_output,
+                                  const JsonPrintOptions& options) {
+  std::unique_ptr<converter::TypeInfo> typeinfo(
+      converter::TypeInfo::NewTypeInfo(resolver));
+  return BinaryToJsonStreamWithTypeInfo(typeinfo.get(), type_url,
+                                        binary_input, json_output, options);
+}
 
 util::Status BinaryToJsonString(TypeResolver* resolver,
                                   const std::string& type_url,
@@ -170,15 +188,17 @@ class StatusErrorListener : public converter::ErrorListener {
 
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(StatusErrorListener);
 };
-}  // namespace
 
-util::Status JsonToBinaryStream(TypeResolver* resolver,
-                                  const std::string& type_url,
-                                  io::ZeroCopyInputStream* json_input,
-                                  io::ZeroCopyOutputStream* binary_output,
-                                  const JsonParseOptions& options) {
-  google::protobuf::Type type;
-  RETURN_IF_ERROR(resolver->ResolveMessageType(type_url, &type));
+// JsonToBinaryStream(), looking types up in |typeinfo|.
+util::Status JsonToBinaryStreamWithTypeInfo(
+    const converter::TypeInfo* typeinfo, const std::string& type_url,
+    io::ZeroCopyInputStream* json_input,
+    io::ZeroCopyOutputStream* binary_output,
+    const JsonParseOptions& options) {
+  util::StatusOr<const google::protobuf::Type*> resolved =
+      typeinfo->ResolveTypeUrl(type_url);
+  RETURN_IF_ERROR(resolved.status());
+  const google::protobuf::Type& type = *resolved.value();
   internal::ZeroCopyStreamByteSink sink(binary_output);
   StatusErrorListener listener;
   converter::ProtoStreamObjectWriter::Options proto_writer_options;
@@ -188,7 +208,7 @@ util::Status JsonToBinaryStream(TypeResolver* resolver,
   proto_writer_options.case_insensitive_enum_parsing =
       options.case_insensitive_enum_parsing;
   converter::ProtoStreamObjectWriter proto_writer(
-      resolver, type, &sink, &listener, proto_writer_options);
+      typeinfo, type, &sink, &listener, proto_writer_options);
 
   converter::JsonStreamParser parser(&proto_writer);
   const void* buffer;
@@ -202,6 +222,18 @@ util::Status JsonToBinaryStream(TypeResolver* resolver,
 
   return listener.GetStatus();
 }
+}  // namespace
+
+util::Status JsonToBinaryStream(TypeResolver* resolver,
+                                  const std::string& type_url,
+                                  io::ZeroCopyInputStream* json_input,
+                                  io::ZeroCopyOutputStream* binary_output,
+                                  const JsonParseOptions& options) {
+  std::unique_ptr<converter::TypeInfo> typeinfo(
+      converter::TypeInfo::NewTypeInfo(resolver));
+  return JsonToBinaryStreamWithTypeInfo(typeinfo.get(), type_url, json_input,
+                                        binary_output, options);
+}
 
 util::Status JsonToBinaryString(TypeResolver* resolver,
                                   const std::string& type_url,
@@ -217,6 +249,7 @@ util::Status JsonToBinaryString(TypeResolver* resolver,
 namespace {
 const char* kTypeUrlPrefix = "type.googleapis.com";
 TypeResolver* generated_type_resolver_ = NULL;
+converter::TypeInfo* generated_type_info_ = NULL;
 PROTOBUF_NAMESPACE_ID::internal::once_flag generated_type_resolver_init_;
 
 std::string GetTypeUrl(const Message& message) {
@@ -224,55 +257,151 @@ std::string GetTypeUrl(const Message& message) {
          message.GetDescriptor()->full_name();
 }
 
-void DeleteGeneratedTypeResolver() { delete generated_type_resolver_; }
+void DeleteGeneratedTypeResolver() {
+  delete generated_type_info_;
+  delete generated_type_resolver_;
+}
 
 void InitGeneratedTypeResolver() {
   generated_type_resolver_ = NewTypeResolverForDescriptorPool(
       kTypeUrlPrefix, DescriptorPool::generated_pool());
+  generated_type_info_ =
+      converter::TypeInfo::NewThreadSafeTypeInfo(generated_type_resolver_);
   ::google::protobuf::internal::OnShutdown(&DeleteGeneratedTypeResolver);
 }
 
-TypeResolver* GetGeneratedTypeResolver() {
+// Returns the process-wide TypeInfo for the generated pool. Types resolved
+// through it, and their field name tables, are kept for later conversions.
+const converter::TypeInfo* GetGeneratedTypeInfo() {
   PROTOBUF_NAMESPACE_ID::internal::call_once(generated_type_resolver_init_,
                                              InitGeneratedTypeResolver);
-  return generated_type_resolver_;
+  return generated_type_info_;
 }
+
+// Type information for the pool of a message. Messages of other pools get a
+// TypeInfo for the duration of one call, as the pool might not outlive a
+// cache.
+class PoolTypeInfo {
+ public:
+  explicit PoolTypeInfo(const Message& message) {
+    const DescriptorPool* pool = message.GetDescriptor()->file()->pool();
+    if (pool == DescriptorPool::generated_pool()) {
+      typeinfo_ = GetGeneratedTypeInfo();
+    } else {
+      resolver_.reset(NewTypeResolverForDescriptorPool(kTypeUrlPrefix, pool));
+      owned_typeinfo_.reset(converter::TypeInfo::NewTypeInfo(resolver_.get()));
+      typeinfo_ = owned_typeinfo_.get();
+    }
+  }
+
+  const converter::TypeInfo* get() const { return typeinfo_; }
+
+ private:
+  std::unique_ptr<TypeResolver> resolver_;
+  std::unique_ptr<converter::TypeInfo> owned_typeinfo_;
+  const converter::TypeInfo* typeinfo_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(PoolTypeInfo);
+};
 }  // namespace
 
+util::Status MessageToJsonStream(const Message& message,
+                                   io::ZeroCopyOutputStream* json_output,
+                                   const JsonPrintOptions& options) {
+  converter::MessageObjectSource message_source(message);
+  message_source.set_use_ints_for_enums(options.always_print_enums_as_ints);
+  message_source.set_preserve_proto_field_names(
+      options.preserve_proto_field_names);
+  io::CodedOutputStream out_stream(json_output);
+  converter::JsonObjectWriter json_writer(options.add_whitespace ? " " : "",
+                                          &out_stream);
+  if (!options.always_print_primitive_fields) {
+    return message_source.WriteTo(&json_writer);
+  }
+
+  // DefaultValueObjectWriter works from google.protobuf.Type, so this mode
+  // still needs type information.
+  PoolTypeInfo typeinfo(message);
+  util::StatusOr<const google::protobuf::Type*> type =
+      typeinfo.get()->ResolveTypeUrl(GetTypeUrl(message));
+  RETURN_IF_ERROR(type.status());
+  converter::DefaultValueObjectWriter default_value_writer(
+      typeinfo.get(), *type.value(), &json_writer);
+  default_value_writer.set_preserve_proto_field_names(
+      options.preserve_proto_field_names);
+  default_value_writer.set_print_enums_as_ints(
+      options.always_print_enums_as_ints);
+  return message_source.WriteTo(&default_value_writer);
+}
+
 util::Status MessageToJsonString(const Message& message, std::string* output,
                                    const JsonOptions& options) {
-  const DescriptorPool* pool = message.GetDescriptor()->file()->pool();
-  TypeResolver* resolver =
-      pool == DescriptorPool::generated_pool()
-          ? GetGeneratedTypeResolver()
-          : NewTypeResolverForDescriptorPool(kTypeUrlPrefix, pool);
-  util::Status result =
-      BinaryToJsonString(resolver, GetTypeUrl(message),
-                         message.SerializeAsString(), output, options);
-  if (pool != DescriptorPool::generated_pool()) {
-    delete resolver;
+  const size_t original_size = output->size();
+  util::Status result;
+  {
+    io::StringOutputStream output_stream(output);
+    result = MessageToJsonStream(message, &output_stream, options);
   }
-  return result;
+  if (result.ok()) {
+    return result;
+  }
+
+  // Discard any partial output and go through the binary transcoder, which
+  // handles group fields and reports errors the way it always has.
+  output->resize(original_size);
+  PoolTypeInfo typeinfo(message);
+  const std::string binary = message.SerializeAsString();
+  io::ArrayInputStream input_stream(binary.data(), binary.size());
+  io::StringOutputStream output_stream(output);
+  return BinaryToJsonStreamWithTypeInfo(typeinfo.get(), GetTypeUrl(message),
+                                        &input_stream, &output_stream,
+                                        options);
+}
+
+namespace {
+// Parses |input| straight into a fresh message and swaps it into |message|.
+// Returns false, leaving |message| untouched, if the input needs anything
+// MessageObjectWriter leaves to the binary transcoder, including every error.
+bool JsonStringToMessageDirect(StringPiece input, Message* message,
+                               const JsonParseOptions& options) {
+  Message* scratch = message->New(message->GetArena());
+  std::unique_ptr<Message> owned(message->GetArena() == nullptr ? scratch
+                                                                : nullptr);
+  converter::MessageObjectWriter writer(scratch);
+  writer.set_ignore_unknown_fields(options.ignore_unknown_fields);
+  writer.set_case_insensitive_enum_parsing(
+      options.case_insensitive_enum_parsing);
+  converter::JsonStreamParser parser(&writer);
+  if (!parser.Parse(input).ok() || !parser.FinishParse().ok() ||
+      writer.failed() || !writer.done() || !scratch->IsInitialized()) {
+    return false;
+  }
+  message->GetReflection()->Swap(message, scratch);
+  return true;
 }
+}  // namespace
 
 util::Status JsonStringToMessage(StringPiece input, Message* message,
                                    const JsonParseOptions& options) {
-  const DescriptorPool* pool = message->GetDescriptor()->file()->pool();
-  TypeResolver* resolver =
-      pool == DescriptorPool::generated_pool()
-          ? GetGeneratedTypeResolver()
-          : NewTypeResolverForDescriptorPool(kTypeUrlPrefix, pool);
+  if (JsonStringToMessageDirect(input, message, options)) {
+    return util::Status();
+  }
+  PoolTypeInfo typeinfo(*message);
   std::string binary;
-  util::Status result = JsonToBinaryString(resolver, GetTypeUrl(*message),
-                                             input, &binary, options);
+  util::Status result;
+  {
+    io::ArrayInputStream input_stream(input.data(), input.size());
+    io::StringOutputStream output_stream(&binary);
+    result = JsonToBinaryStreamWithTypeInfo(typeinfo.get(),
+                                            GetTypeUrl(*message),
+                                            &input_stream, &output_stream,
+                                            options);
+  }
   if (result.ok() && !message->ParseFromString(binary)) {
     result =
         util::Status(util::error::INVALID_ARGUMENT,
                        "JSON transcoder produced invalid protobuf output.");
   }
-  if (pool != DescriptorPool::generated_pool()) {
-    delete resolver;
-  }
   return result;
 }
 
@@ -90,8 +90,9 @@ struct JsonPrintOptions {
 typedef JsonPrintOptions JsonOptions;
 
 // Converts from protobuf message to JSON and appends it to |output|. This is a
-// simple wrapper of BinaryToJsonString(). It will use the DescriptorPool of the
-// passed-in message to resolve Any types.
+// simple wrapper of MessageToJsonStream(), falling back to BinaryToJsonString()
+// if the message can't be rendered directly. It will use the DescriptorPool of
+// the passed-in message to resolve Any types.
 PROTOBUF_EXPORT util::Status MessageToJsonString(const Message& message,
                                                    std::string* output,
                                                    const JsonOptions& options);
@@ -101,9 +102,22 @@ inline util::Status MessageToJsonString(const Message& message,
   return MessageToJsonString(message, output, JsonOptions());
 }
 
-// Converts from JSON to protobuf message. This is a simple wrapper of
-// JsonStringToBinary(). It will use the DescriptorPool of the passed-in
-// message to resolve Any types.
+// Converts from protobuf message to JSON and writes it to |json_output|. The
+// message is read through reflection, without serializing it to binary
+// first. Group fields are not supported and fail with UNIMPLEMENTED.
+PROTOBUF_EXPORT util::Status MessageToJsonStream(
+    const Message& message, io::ZeroCopyOutputStream* json_output,
+    const JsonPrintOptions& options);
+
+inline util::Status MessageToJsonStream(
+    const Message& message, io::ZeroCopyOutputStream* json_output) {
+  return MessageToJsonStream(message, json_output, JsonPrintOptions());
+}
+
+// Converts from JSON to protobuf message. The message is filled directly
+// through reflection when the input allows it, otherwise this is a simple
+// wrapper of JsonStringToBinary(); both give the same result. It will use the
+// DescriptorPool of the passed-in message to resolve Any types.
 PROTOBUF_EXPORT util::Status JsonStringToMessage(
     StringPiece input, Message* message, const JsonParseOptions& options);
 
@@ -32,11 +32,16 @@
 
 #include <list>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor_database.h>
 #include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/util/internal/json_stream_parser.h>
+#include <google/protobuf/util/internal/message_objectwriter.h>
 #include <google/protobuf/util/internal/testdata/maps.pb.h>
 #include <google/protobuf/util/json_format.pb.h>
 #include <google/protobuf/util/json_format_proto3.pb.h>
@@ -55,7 +60,10 @@ using proto3::TestAny;
 using proto3::TestEnumValue;
 using proto3::TestMap;
 using proto3::TestMessage;
+using proto3::TestNestedMap;
 using proto3::TestOneof;
+using proto3::TestStruct;
+using proto3::TestWrapper;
 using proto_util_converter::testing::MapIn;
 
 // As functions defined in json_util.h are just thin wrappers around the
@@ -82,6 +90,68 @@ class JsonUtilTest : public ::testing::Test {
     return FromJson(json, message, JsonParseOptions());
   }
 
+  // Checks that MessageToJsonStream() renders |message| exactly like the
+  // binary transcoder does, for every combination of print options.
+  void ExpectStreamMatchesBinary(const Message& message) {
+    std::unique_ptr<TypeResolver> resolver(NewTypeResolverForDescriptorPool(
+        "type.googleapis.com", message.GetDescriptor()->file()->pool()));
+    const std::string type_url =
+        "type.googleapis.com/" + message.GetDescriptor()->full_name();
+    for (int i = 0; i < 16; ++i) {
+      JsonPrintOptions options;
+      options.add_whitespace = i & 1;
+      options.always_print_primitive_fields = i & 2;
+      options.always_print_enums_as_ints = i & 4;
+      options.preserve_proto_field_names = i & 8;
+      std::string expected;
+      ASSERT_TRUE(BinaryToJsonString(resolver.get(), type_url,
+                                     message.SerializeAsString(), &expected,
+                                     options)
+                      .ok());
+      std::string actual;
+      {
+        io::StringOutputStream output_stream(&actual);
+        ASSERT_TRUE(MessageToJsonStream(message, &output_stream, options).ok());
+      }
+      EXPECT_EQ(expected, actual) << "options: " << i;
+    }
+  }
+
+  // Parses |json| with MessageObjectWriter alone and returns whether it could
+  // fill |message| without the binary transcoder.
+  bool ParsesDirectly(const std::string& json, Message* message,
+                      const JsonParseOptions& options = JsonParseOptions()) {
+    converter::MessageObjectWriter writer(message);
+    writer.set_ignore_unknown_fields(options.ignore_unknown_fields);
+    writer.set_case_insensitive_enum_parsing(
+        options.case_insensitive_enum_parsing);
+    converter::JsonStreamParser parser(&writer);
+    return parser.Parse(json).ok() && parser.FinishParse().ok() &&
+           !writer.failed() && writer.done();
+  }
+
+  // Checks that JsonStringToMessage() gives the same result as transcoding
+  // |json| to binary and parsing that.
+  void ExpectParseMatchesBinary(
+      const std::string& json, const Message& prototype,
+      const JsonParseOptions& options = JsonParseOptions()) {
+    std::unique_ptr<TypeResolver> resolver(NewTypeResolverForDescriptorPool(
+        "type.googleapis.com", prototype.GetDescriptor()->file()->pool()));
+    const std::string type_url =
+        "type.googleapis.com/" + prototype.GetDescriptor()->full_name();
+    std::string binary;
+    std::unique_ptr<Message> expected(prototype.New());
+    bool expected_ok =
+        JsonToBinaryString(resolver.get(), type_url, json, &binary, options)
+            .ok() &&
+        expected->ParseFromString(binary);
+    std::unique_ptr<Message> actual(prototype.New());
+    EXPECT_EQ(expected_ok, FromJson(json, actual.get(), options)) << json;
+    if (expected_ok) {
+      EXPECT_EQ(expected->DebugString(), actual->DebugString()) << json;
+    }
+  }
+
   std::unique_ptr<TypeResolver> resolver_;
 };
 
@@ -636,6 +706,334 @@ TEST_F(JsonUtilTest, TestWrongJsonInput) {
             util::error::INVALID_ARGUMENT);
 }
 
+TEST_F(JsonUtilTest, StreamMatchesBinaryForScalarsAndLists) {
+  TestMessage m;
+  ASSERT_TRUE(FromJson(
+      "{\"boolValue\":true,\"int32Value\":-12,\"int64Value\":\"-34\","
+      "\"uint32Value\":56,\"uint64Value\":\"78\",\"floatValue\":1.5,"
+      "\"doubleValue\":-2.25,\"stringValue\":\"</script>\","
+      "\"bytesValue\":\"AQID\",\"enumValue\":\"BAR\","
+      "\"messageValue\":{\"value\":7},"
+      "\"repeatedBoolValue\":[true,false],"
+      "\"repeatedInt32Value\":[1,-2,3],"
+      "\"repeatedUint64Value\":[\"18446744073709551615\"],"
+      "\"repeatedDoubleValue\":[0.5,\"NaN\",\"-Infinity\"],"
+      "\"repeatedStringValue\":[\"a\",\"\"],"
+      "\"repeatedEnumValue\":[\"FOO\",\"BAR\"],"
+      "\"repeatedMessageValue\":[{},{\"value\":40}]}",
+      &m));
+  // Unknown values of an open enum are printed as integers.
+  m.add_repeated_enum_value(static_cast<proto3::EnumType>(42));
+  ExpectStreamMatchesBinary(m);
+  ExpectStreamMatchesBinary(TestMessage());
+
+  TestOneof oneof;
+  oneof.set_oneof_null_value(NULL_VALUE);
+  ExpectStreamMatchesBinary(oneof);
+  oneof.mutable_oneof_message_value();
+  ExpectStreamMatchesBinary(oneof);
+}
+
+TEST_F(JsonUtilTest, StreamMatchesBinaryForMaps) {
+  TestNestedMap m;
+  (*m.mutable_bool_map())[true] = 1;
+  (*m.mutable_int32_map())[-5] = 2;
+  (*m.mutable_int64_map())[1234567890123LL] = 3;
+  (*m.mutable_uint32_map())[7] = 4;
+  (*m.mutable_uint64_map())[0] = 5;
+  (*m.mutable_string_map())[""] = 6;
+  (*(*m.mutable_map_map())["nested"].mutable_string_map())["x"] = 0;
+  m.mutable_map_map()->insert({"empty", TestNestedMap()});
+  ExpectStreamMatchesBinary(m);
+}
+
+TEST_F(JsonUtilTest, StreamMatchesBinaryForWellKnownTypes) {
+  TestWrapper wrapper;
+  ASSERT_TRUE(FromJson(
+      "{\"boolValue\":false,\"int32Value\":0,\"int64Value\":\"5\","
+      "\"floatValue\":1.25,\"stringValue\":\"s\",\"bytesValue\":\"AA==\","
+      "\"repeatedInt32Value\":[1,0]}",
+      &wrapper));
+  ExpectStreamMatchesBinary(wrapper);
+
+  TestStruct test_struct;
+  ASSERT_TRUE(FromJson(
+      "{\"value\":{\"a\":null,\"b\":1.5,\"c\":\"x\",\"d\":true,"
+      "\"e\":{\"f\":[]},\"g\":[1,[2],{}]},"
+      "\"repeatedValue\":[{},{\"k\":[]}]}",
+      &test_struct));
+  ExpectStreamMatchesBinary(test_struct);
+
+  TestAny any;
+  ASSERT_TRUE(FromJson(
+      "{\"value\":{\"@type\":\"type.googleapis.com/proto3.TestMessage\","
+      "\"int32Value\":5,\"messageValue\":{\"value\":1}},"
+      "\"repeatedValue\":[{\"@type\":"
+      "\"type.googleapis.com/google.protobuf.Timestamp\","
+      "\"value\":\"1970-01-01T00:00:01.500Z\"},"
+      "{\"@type\":\"type.googleapis.com/google.protobuf.Duration\","
+      "\"value\":\"-0.010s\"},"
+      "{\"@type\":\"type.googleapis.com/google.protobuf.FieldMask\","
+      "\"value\":\"fooBar,baz.quxQuux\"},"
+      "{\"@type\":\"type.googleapis.com/google.protobuf.Any\","
+      "\"value\":{\"@type\":\"type.googleapis.com/google.protobuf.Value\","
+      "\"value\":[1,\"two\"]}},"
+      "{\"@type\":\"type.googleapis.com/proto3.TestMessage\"},"
+      "{}]}",
+      &any));
+  ExpectStreamMatchesBinary(any);
+}
+
+TEST_F(JsonUtilTest, StreamMatchesBinaryForDynamicMessage) {
+  DescriptorPoolDatabase database(*DescriptorPool::generated_pool());
+  DescriptorPool pool(&database);
+  DynamicMessageFactory factory;
+  std::unique_ptr<Message> message(
+      factory.GetPrototype(pool.FindMessageTypeByName("proto3.TestAny"))
+          ->New());
+  ASSERT_TRUE(FromJson(
+      "{\"value\":{\"@type\":\"type.googleapis.com/proto3.TestMap\","
+      "\"stringMap\":{\"a\":1}},"
+      "\"repeatedValue\":[{\"@type\":"
+      "\"type.googleapis.com/google.protobuf.Struct\","
+      "\"value\":{\"b\":[null]}}]}",
+      message.get()));
+  ExpectStreamMatchesBinary(*message);
+}
+
+TEST_F(JsonUtilTest, StreamReportsErrors) {
+  proto3::TestDuration m;
+  m.mutable_value()->set_seconds(-1);
+  m.mutable_value()->set_nanos(5);
+  std::string output;
+  io::StringOutputStream output_stream(&output);
+  util::Status status = MessageToJsonStream(m, &output_stream);
+  EXPECT_EQ(util::error::INTERNAL, status.code());
+  EXPECT_EQ(
+      "Duration nanos is non-negative, but seconds is negative for field: "
+      "value",
+      status.message());
+
+  // MessageToJsonString() reports the same error as the binary transcoder.
+  std::string json;
+  EXPECT_EQ(status, MessageToJsonString(m, &json));
+
+  TestAny any;
+  any.mutable_value()->set_type_url("type.googleapis.com/proto3.Unknown");
+  any.mutable_value()->set_value("\x08\x01");
+  status = MessageToJsonStream(any, &output_stream);
+  EXPECT_EQ(util::error::INTERNAL, status.code());
+  EXPECT_EQ("Invalid type URL, unknown type: proto3.Unknown",
+            status.message());
+  EXPECT_EQ(status, MessageToJsonString(any, &json));
+}
+
+TEST_F(JsonUtilTest, GroupsFallBackToBinaryTranscoder) {
+  protobuf_unittest::TestFlagsAndStrings m;
+  m.set_a(1);
+  m.add_repeatedgroup()->set_f("x");
+  std::string output;
+  {
+    io::StringOutputStream output_stream(&output);
+    EXPECT_EQ(util::error::UNIMPLEMENTED,
+              MessageToJsonStream(m, &output_stream).code());
+  }
+
+  std::unique_ptr<TypeResolver> resolver(NewTypeResolverForDescriptorPool(
+      "type.googleapis.com", DescriptorPool::generated_pool()));
+  std::string expected = "prefix";
+  util::Status expected_status = BinaryToJsonString(
+      resolver.get(),
+      "type.googleapis.com/protobuf_unittest.TestFlagsAndStrings",
+      m.SerializeAsString(), &expected);
+  std::string json = "prefix";
+  EXPECT_EQ(expected_status, MessageToJsonString(m, &json));
+  EXPECT_EQ(expected, json);
+}
+
+TEST_F(JsonUtilTest, DirectParseMatchesBinary) {
+  const char* kInputs[] = {
+      "{}",
+      "{\"boolValue\":true,\"int32Value\":-12,\"int64Value\":\"-34\","
+      "\"uint32Value\":56,\"uint64Value\":\"78\",\"floatValue\":1.5,"
+      "\"doubleValue\":-2.25,\"stringValue\":\"</script>\","
+      "\"bytesValue\":\"AQID\",\"enumValue\":\"BAR\","
+      "\"messageValue\":{\"value\":7},"
+      "\"repeatedBoolValue\":[true,false],"
+      "\"repeatedInt32Value\":[1,-2,3],"
+      "\"repeatedUint64Value\":[\"18446744073709551615\"],"
+      "\"repeatedDoubleValue\":[0.5,\"NaN\",\"-Infinity\"],"
+      "\"repeatedStringValue\":[\"a\",\"\"],"
+      "\"repeatedEnumValue\":[\"FOO\",\"BAR\"],"
+      "\"repeatedMessageValue\":[{},{\"value\":40}]}",
+      // Proto names, numbers in strings and enums as numbers.
+      "{\"int32_value\":\"12\",\"int64Value\":1e3,\"enumValue\":1,"
+      "\"repeatedEnumValue\":[\"BAR\",7]}",
+      // A single value for a repeated field is appended.
+      "{\"repeatedInt32Value\":5,\"repeatedInt32Value\":[6],"
+      "\"repeatedMessageValue\":{\"value\":1}}",
+      // Repeated singular fields: scalars are replaced, messages merged.
+      "{\"int32Value\":1,\"int32Value\":2,\"messageValue\":{\"value\":1},"
+      "\"messageValue\":{}}",
+      // Nulls are ignored.
+      "{\"stringValue\":null,\"messageValue\":null,"
+      "\"repeatedStringValue\":[\"a\",null]}",
+  };
+  for (const char* json : kInputs) {
+    TestMessage m;
+    EXPECT_TRUE(ParsesDirectly(json, &m)) << json;
+    ExpectParseMatchesBinary(json, TestMessage());
+  }
+}
+
+TEST_F(JsonUtilTest, DirectParseMatchesBinaryForMapsAndOneofs) {
+  const char* kMaps =
+      "{\"boolMap\":{\"true\":1},\"int32Map\":{\"-5\":2},"
+      "\"uint64Map\":{\"18446744073709551615\":3},"
+      "\"stringMap\":{\"a\":4,\"b\":5},"
+      "\"mapMap\":{\"x\":{\"int32Map\":{\"1\":6}},\"y\":{}}}";
+  TestNestedMap map;
+  EXPECT_TRUE(ParsesDirectly(kMaps, &map));
+  ExpectParseMatchesBinary(kMaps, TestNestedMap());
+
+  const char* kOneofs[] = {
+      "{\"oneofStringValue\":\"s\"}",
+      "{\"oneofMessageValue\":{\"value\":3}}",
+      "{\"oneofEnumValue\":\"BAR\"}",
+      "{\"oneofInt32Value\":null,\"oneofBytesValue\":\"AQID\"}",
+  };
+  for (const char* json : kOneofs) {
+    TestOneof m;
+    EXPECT_TRUE(ParsesDirectly(json, &m)) << json;
+    ExpectParseMatchesBinary(json, TestOneof());
+  }
+}
+
+TEST_F(JsonUtilTest, DirectParseUnknownFieldsAndEnums) {
+  JsonParseOptions options;
+  options.ignore_unknown_fields = true;
+  const char* kUnknown =
+      "{\"unknown\":{\"a\":[1,{\"b\":null}]},\"unknownList\":[[1]],"
+      "\"int32Value\":3,\"enumValue\":\"NOPE\","
+      "\"repeatedEnumValue\":[\"NOPE\",\"BAR\"]}";
+  TestMessage m;
+  EXPECT_TRUE(ParsesDirectly(kUnknown, &m, options));
+  ExpectParseMatchesBinary(kUnknown, TestMessage(), options);
+
+  options.case_insensitive_enum_parsing = true;
+  const char* kLowerCase = "{\"enumValue\":\"bar\"}";
+  m.Clear();
+  EXPECT_TRUE(ParsesDirectly(kLowerCase, &m, options));
+  EXPECT_EQ(BAR, m.enum_value());
+  ExpectParseMatchesBinary(kLowerCase, TestMessage(), options);
+
+  const char* kProto2 = "{\"a\":\"WARNING\",\"b\":1}";
+  protobuf_unittest::TestNumbers numbers;
+  EXPECT_TRUE(ParsesDirectly(kProto2, &numbers));
+  ExpectParseMatchesBinary(kProto2, numbers);
+}
+
+TEST_F(JsonUtilTest, DirectParseFallsBackToBinaryTranscoder) {
+  proto3::TestTimestamp timestamp;
+  TestWrapper wrapper;
+  TestStruct value;
+  TestMap map;
+  protobuf_unittest::TestNumbers numbers;
+  struct {
+    Message* prototype;
+    const char* json;
+  } kCases[] = {
+      {&timestamp, "{\"value\":\"1970-01-01T00:00:00Z\"}"},
+      {&wrapper, "{\"int32Value\":5}"},
+      {&value, "{\"value\":{\"a\":[1,null]}}"},
+      // The last map entry for a key wins across occurrences of the field.
+      {&map, "{\"int32Map\":{\"1\":2},\"int32Map\":{\"1\":3}}"},
+      {&map, "{\"int32Map\":{\"1\":null}}"},
+      // Unknown numbers of a closed enum go to the unknown fields.
+      {&numbers, "{\"a\":5}"},
+      // Errors.
+      {&map, "{\"int32Map\":{\"1\":2,\"1\":3}}"},
+      {&map, "{\"stringMap\":[]}"},
+  };
+  for (const auto& c : kCases) {
+    std::unique_ptr<Message> m(c.prototype->New());
+    EXPECT_FALSE(ParsesDirectly(c.json, m.get())) << c.json;
+    ExpectParseMatchesBinary(c.json, *c.prototype);
+  }
+
+  const char* kErrors[] = {
+      "{\"oneofInt32Value\":1,\"oneofStringValue\":\"a\"}",
+      "{\"oneofInt32Value\":2147483648}",
+      "{\"unknownName\":0}",
+      "{\"oneofInt32Value\":",
+      "[1]",
+      "\"a\"",
+  };
+  for (const char* json : kErrors) {
+    TestOneof m;
+    EXPECT_FALSE(ParsesDirectly(json, &m)) << json;
+    ExpectParseMatchesBinary(json, TestOneof());
+  }
+
+  // Missing required fields and groups.
+  protobuf_unittest::TestLargeInt large_int;
+  EXPECT_FALSE(FromJson("{\"a\":\"1\"}", &large_int));
+  protobuf_unittest::TestFlagsAndStrings flags;
+  EXPECT_FALSE(ParsesDirectly("{\"A\":1,\"repeatedgroup\":[{\"f\":\"x\"}]}",
+                              &flags));
+}
+
+TEST_F(JsonUtilTest, DirectParseReplacesContentsOnArena) {
+  Arena arena;
+  TestMessage* m = Arena::CreateMessage<TestMessage>(&arena);
+  m->set_int32_value(9);
+  ASSERT_TRUE(FromJson("{\"messageValue\":{\"value\":2}}", m));
+  EXPECT_EQ(0, m->int32_value());
+  EXPECT_EQ(2, m->message_value().value());
+  EXPECT_EQ(&arena, m->message_value().GetArena());
+
+  // A failed parse leaves the message alone.
+  EXPECT_FALSE(FromJson("{\"int32Value\":\"x\"}", m));
+  EXPECT_EQ(2, m->message_value().value());
+}
+
+TEST_F(JsonUtilTest, ConcurrentConversionsShareTypeInfo) {
+  // always_print_primitive_fields and groups both go through the cached
+  // type information of the generated pool.
+  TestMessage m;
+  m.set_int32_value(7);
+  m.add_repeated_message_value()->set_value(3);
+  JsonPrintOptions options;
+  options.always_print_primitive_fields = true;
+  const std::string expected = ToJson(m, options);
+  protobuf_unittest::TestFlagsAndStrings group_message;
+  group_message.set_a(1);
+  group_message.add_repeatedgroup()->set_f("x");
+  const std::string expected_group = ToJson(group_message, JsonPrintOptions());
+  protobuf_unittest::TestFlagsAndStrings expected_parsed;
+  ASSERT_TRUE(FromJson(expected_group, &expected_parsed));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 50; ++j) {
+        std::string json;
+        EXPECT_TRUE(MessageToJsonString(m, &json, options).ok());
+        EXPECT_EQ(expected, json);
+        json.clear();
+        EXPECT_TRUE(MessageToJsonString(group_message, &json).ok());
+        EXPECT_EQ(expected_group, json);
+        protobuf_unittest::TestFlagsAndStrings parsed;
+        EXPECT_TRUE(FromJson(expected_group, &parsed));
+        EXPECT_EQ(expected_parsed.DebugString(), parsed.DebugString());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
 TEST_F(JsonUtilTest, HtmlEscape) {
   TestMessage m;
   m.set_string_value("</script>");
@@ -35,8 +35,11 @@
 #include <google/protobuf/util/message_differencer.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 
 #include <google/protobuf/stubs/logging.h>
@@ -98,6 +101,32 @@ class NumDiffsReporter : public google::protobuf::util::MessageDifferencer::Repo
   int32 num_diffs_;
 };
 
+namespace {
+
+// Fingerprint of a message none of whose fields contribute to it.
+const uint64 kEmptyFingerprint = 0;
+
+// 64-bit variant of boost::hash_combine.
+inline uint64 CombineFingerprints(uint64 seed, uint64 value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+inline uint64 FingerprintDouble(double value) {
+  // -0.0 == 0.0, and the default comparator treats NaNs either as all equal
+  // or as different from everything, so one fingerprint for each is enough.
+  if (value == 0) return 0;
+  if (std::isnan(value)) return 1;
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline uint64 FingerprintString(const std::string& value) {
+  return std::hash<std::string>()(value);
+}
+
+}  // namespace
+
 // When comparing a repeated field as map, MultipleFieldMapKeyComparator can
 // be used to specify multiple fields as key for key comparison.
 // Two elements of a repeated field will be regarded as having the same key
@@ -133,7 +162,39 @@ class MessageDifferencer::MultipleFieldsMapKeyComparator
     return true;
   }
 
+  // Fingerprint of the key fields of "message", consistent with IsMatch().
+  uint64 Fingerprint(const Message& message) const {
+    uint64 fingerprint = kEmptyFingerprint;
+    for (const auto& path : key_field_paths_) {
+      fingerprint = CombineFingerprints(fingerprint,
+                                        FingerprintInternal(message, path, 0));
+    }
+    return fingerprint;
+  }
+
+  const std::vector<std::vector<const FieldDescriptor*> >& key_field_paths()
+      const {
+    return key_field_paths_;
+  }
+
  private:
+  uint64 FingerprintInternal(
+      const Message& message,
+      const std::vector<const FieldDescriptor*>& key_field_path,
+      int path_index) const {
+    const FieldDescriptor* field = key_field_path[path_index];
+    if (path_index == key_field_path.size() - 1) {
+      // Repeated keys are compared with their own repeated field settings.
+      if (field->is_repeated()) return kEmptyFingerprint;
+      return message_differencer_->FingerprintFieldValue(message, field, -1);
+    }
+    const Reflection* reflection = message.GetReflection();
+    if (!reflection->HasField(message, field)) return kEmptyFingerprint;
+    return CombineFingerprints(
+        1, FingerprintInternal(reflection->GetMessage(message, field),
+                               key_field_path, path_index + 1));
+  }
+
   bool IsMatchInternal(
       const Message& message1, const Message& message2,
       const std::vector<SpecificField>& parent_fields,
@@ -179,6 +240,133 @@ class MessageDifferencer::MultipleFieldsMapKeyComparator
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MultipleFieldsMapKeyComparator);
 };
 
+class MessageDifferencer::RecordingReporter
+    : public MessageDifferencer::Reporter {
+ public:
+  enum Kind {
+    ADDED,
+    DELETED,
+    MODIFIED,
+    MOVED,
+    MATCHED,
+    IGNORED,
+    UNKNOWN_FIELD_IGNORED,
+  };
+
+  struct Report {
+    Kind kind;
+    const Message* message1;
+    const Message* message2;
+    std::vector<SpecificField> field_path;
+  };
+
+  RecordingReporter() : output_(nullptr) {}
+
+  // Reports are appended to "output" until the next call.
+  void set_output(std::vector<Report>* output) { output_ = output; }
+
+  static void Replay(const std::vector<Report>& reports, Reporter* reporter) {
+    for (const Report& report : reports) {
+      const Message& message1 = *report.message1;
+      const Message& message2 = *report.message2;
+      switch (report.kind) {
+        case ADDED:
+          reporter->ReportAdded(message1, message2, report.field_path);
+          break;
+        case DELETED:
+          reporter->ReportDeleted(message1, message2, report.field_path);
+          break;
+        case MODIFIED:
+          reporter->ReportModified(message1, message2, report.field_path);
+          break;
+        case MOVED:
+          reporter->ReportMoved(message1, message2, report.field_path);
+          break;
+        case MATCHED:
+          reporter->ReportMatched(message1, message2, report.field_path);
+          break;
+        case IGNORED:
+          reporter->ReportIgnored(message1, message2, report.field_path);
+          break;
+        case UNKNOWN_FIELD_IGNORED:
+          reporter->ReportUnknownFieldIgnored(message1, message2,
+                                              report.field_path);
+          break;
+      }
+    }
+  }
+
+  void ReportAdded(const Message& message1, const Message& message2,
+                   const std::vector<SpecificField>& field_path) override {
+    Record(ADDED, message1, message2, field_path);
+  }
+  void ReportDeleted(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Record(DELETED, message1, message2, field_path);
+  }
+  void ReportModified(const Message& message1, const Message& message2,
+                      const std::vector<SpecificField>& field_path) override {
+    Record(MODIFIED, message1, message2, field_path);
+  }
+  void ReportMoved(const Message& message1, const Message& message2,
+                   const std::vector<SpecificField>& field_path) override {
+    Record(MOVED, message1, message2, field_path);
+  }
+  void ReportMatched(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Record(MATCHED, message1, message2, field_path);
+  }
+  void ReportIgnored(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Record(IGNORED, message1, message2, field_path);
+  }
+  void ReportUnknownFieldIgnored(
+      const Message& message1, const Message& message2,
+      const std::vector<SpecificField>& field_path) override {
+    Record(UNKNOWN_FIELD_IGNORED, message1, message2, field_path);
+  }
+
+ private:
+  void Record(Kind kind, const Message& message1, const Message& message2,
+              const std::vector<SpecificField>& field_path) {
+    output_->push_back(Report{kind, &message1, &message2, field_path});
+  }
+
+  std::vector<Report>* output_;
+};
+
+struct MessageDifferencer::ParallelComparison {
+  ParallelComparison(const FieldDescriptor* field, int index1, int index2)
+      : field(field), index1(index1), index2(index2), same(false) {}
+
+  const FieldDescriptor* field;
+  int index1;
+  int index2;
+  bool same;
+  std::vector<RecordingReporter::Report> reports;
+  std::shared_ptr<MessageDifferencer> worker;
+};
+
+namespace {
+
+// Largest number of shards CompareFieldValuesInParallel splits work into.
+const int kMaxParallelShards = 64;
+
+// A rough measure of the work needed to compare "message": the number of
+// values set directly in it, counting each element of repeated fields.
+int64 CountValues(const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  int64 count = 0;
+  for (const FieldDescriptor* field : fields) {
+    count += field->is_repeated() ? reflection->FieldSize(message, field) : 1;
+  }
+  return count;
+}
+
+}  // namespace
+
 // Preserve the order when treating repeated field as SMART_LIST. The current
 // implementation is to find the longest matching sequence from the first
 // element. The optimal solution requires to use //util/diff/lcs.h, which is
@@ -272,14 +460,18 @@ MessageDifferencer::MessageDifferencer()
       report_ignores_(true),
       output_string_(nullptr),
       match_indices_for_smart_list_callback_(
-          MatchIndicesPostProcessorForSmartList) {}
+          MatchIndicesPostProcessorForSmartList),
+      parallel_min_elements_(0),
+      parallel_worker_(false) {}
 
 MessageDifferencer::~MessageDifferencer() {
   for (MapKeyComparator* comparator : owned_key_comparators_) {
     delete comparator;
   }
-  for (IgnoreCriteria* criteria : ignore_criteria_) {
-    delete criteria;
+  if (!parallel_worker_) {
+    for (IgnoreCriteria* criteria : ignore_criteria_) {
+      delete criteria;
+    }
   }
 }
 
@@ -313,6 +505,12 @@ MessageDifferencer::repeated_field_comparison() {
   return repeated_field_comparison_;
 }
 
+void MessageDifferencer::set_parallel_for(
+    const ParallelForFunction& parallel_for, int min_elements) {
+  parallel_for_ = parallel_for;
+  parallel_min_elements_ = min_elements;
+}
+
 void MessageDifferencer::CheckRepeatedFieldComparisons(
     const FieldDescriptor* field,
     const RepeatedFieldComparison& new_comparison) {
@@ -565,7 +763,12 @@ bool MessageDifferencer::Compare(const Message& message1,
       if (data1->GetDescriptor() != data2->GetDescriptor()) {
         return false;
       }
-      return Compare(*data1, *data2, parent_fields);
+      const bool result = Compare(*data1, *data2, parent_fields);
+      if (parallel_worker_ && reporter_ != nullptr) {
+        unpacked_any_payloads_.push_back(std::move(data1));
+        unpacked_any_payloads_.push_back(std::move(data2));
+      }
+      return result;
     }
   }
   const Reflection* reflection1 = message1.GetReflection();
@@ -715,6 +918,44 @@ bool MessageDifferencer::CompareWithFieldsInternal(
   const Reflection* reflection1 = message1.GetReflection();
   const Reflection* reflection2 = message2.GetReflection();
 
+  // Singular sub-messages present on both sides are compared up front on
+  // parallel_for_ when there is enough work in them, and their results and
+  // reports are consumed in field order below.
+  std::vector<ParallelComparison> parallel_comparisons;
+  if (CanCompareInParallel()) {
+    int64 num_values = 0;
+    for (int i = 0, j = 0;
+         message1_fields[i] != nullptr && message2_fields[j] != nullptr;) {
+      const FieldDescriptor* field1 = message1_fields[i];
+      const FieldDescriptor* field2 = message2_fields[j];
+      if (FieldBefore(field1, field2)) {
+        ++i;
+        continue;
+      }
+      if (FieldBefore(field2, field1)) {
+        ++j;
+        continue;
+      }
+      if (!field1->is_repeated() &&
+          field1->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          !IsIgnored(message1, message2, field1, *parent_fields)) {
+        parallel_comparisons.emplace_back(field1, -1, -1);
+        num_values += CountValues(reflection1->GetMessage(message1, field1)) +
+                      CountValues(reflection2->GetMessage(message2, field1));
+      }
+      ++i;
+      ++j;
+    }
+    if (parallel_comparisons.size() < 2 ||
+        num_values < 2 * parallel_min_elements_) {
+      parallel_comparisons.clear();
+    } else {
+      CompareFieldValuesInParallel(message1, message2, *parent_fields,
+                                   &parallel_comparisons);
+    }
+  }
+  int next_parallel_comparison = 0;
+
   while (true) {
     const FieldDescriptor* field1 = message1_fields[field_index1];
     const FieldDescriptor* field2 = message2_fields[field_index2];
@@ -841,8 +1082,14 @@ bool MessageDifferencer::CompareWithFieldsInternal(
         isDifferent = true;
       }
     } else {
-      fieldDifferent = !CompareFieldValueUsingParentFields(
-          message1, message2, field1, -1, -1, parent_fields);
+      if (next_parallel_comparison < parallel_comparisons.size() &&
+          parallel_comparisons[next_parallel_comparison].field == field1) {
+        fieldDifferent = !ReplayParallelComparison(
+            parallel_comparisons[next_parallel_comparison++]);
+      } else {
+        fieldDifferent = !CompareFieldValueUsingParentFields(
+            message1, message2, field1, -1, -1, parent_fields);
+      }
 
       // If we have found differences, either report them or terminate if
       // no reporter is present.
@@ -914,6 +1161,254 @@ bool MessageDifferencer::IsMatch(
   return match;
 }
 
+DefaultFieldComparator* MessageDifferencer::GetDefaultFieldComparator() {
+  if (field_comparator_ == nullptr) return &default_field_comparator_;
+#if PROTOBUF_RTTI
+  // Inherit class from DefaultFieldComparator can not get the benefit
+  // because DefaultFieldComparator::Compare() method might be overwrote.
+  if (typeid(*field_comparator_) == typeid(default_field_comparator_)) {
+    return static_cast<DefaultFieldComparator*>(field_comparator_);
+  }
+#endif
+  return nullptr;
+}
+
+bool MessageDifferencer::CanCompareInParallel() {
+  if (!parallel_for_) return false;
+  // Key comparators supplied by the caller may call back into this
+  // differencer, which workers cannot share.
+  for (const auto& entry : map_field_key_comparator_) {
+    if (std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                  entry.second) == owned_key_comparators_.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MessageDifferencer::InitParallelWorker(MessageDifferencer* parent) {
+  parallel_worker_ = true;
+  field_comparator_ = parent->field_comparator_ != nullptr
+                          ? parent->field_comparator_
+                          : &parent->default_field_comparator_;
+  message_field_comparison_ = parent->message_field_comparison_;
+  scope_ = parent->scope_;
+  repeated_field_comparison_ = parent->repeated_field_comparison_;
+  repeated_field_comparisons_ = parent->repeated_field_comparisons_;
+  for (const auto& entry : parent->map_field_key_comparator_) {
+    MapKeyComparator* key_comparator = new MultipleFieldsMapKeyComparator(
+        this, static_cast<const MultipleFieldsMapKeyComparator*>(entry.second)
+                  ->key_field_paths());
+    owned_key_comparators_.push_back(key_comparator);
+    map_field_key_comparator_[entry.first] = key_comparator;
+  }
+  ignore_criteria_ = parent->ignore_criteria_;
+  ignored_fields_ = parent->ignored_fields_;
+  report_matches_ = parent->report_matches_;
+  report_moves_ = parent->report_moves_;
+  report_ignores_ = parent->report_ignores_;
+  match_indices_for_smart_list_callback_ =
+      parent->match_indices_for_smart_list_callback_;
+}
+
+void MessageDifferencer::CompareFieldValuesInParallel(
+    const Message& message1, const Message& message2,
+    const std::vector<SpecificField>& parent_fields,
+    std::vector<ParallelComparison>* comparisons) {
+  const int num_comparisons = comparisons->size();
+  const int num_shards = std::min(num_comparisons, kMaxParallelShards);
+  parallel_for_(num_shards, [&](int shard) {
+    // The buffered reports may refer to Any payloads the worker unpacked, so
+    // it is kept alive along with them.
+    std::shared_ptr<MessageDifferencer> worker(new MessageDifferencer);
+    worker->InitParallelWorker(this);
+    RecordingReporter recorder;
+    if (reporter_ != nullptr) worker->reporter_ = &recorder;
+    std::vector<SpecificField> worker_parent_fields(parent_fields);
+    const int begin = static_cast<int64>(num_comparisons) * shard / num_shards;
+    const int end =
+        static_cast<int64>(num_comparisons) * (shard + 1) / num_shards;
+    for (int i = begin; i < end; ++i) {
+      ParallelComparison& comparison = (*comparisons)[i];
+      recorder.set_output(&comparison.reports);
+      comparison.same = worker->CompareFieldValueUsingParentFields(
+          message1, message2, comparison.field, comparison.index1,
+          comparison.index2, &worker_parent_fields);
+      comparison.worker = worker;
+    }
+    worker->reporter_ = nullptr;
+  });
+}
+
+bool MessageDifferencer::ReplayParallelComparison(
+    const ParallelComparison& comparison) {
+  if (reporter_ != nullptr) {
+    RecordingReporter::Replay(comparison.reports, reporter_);
+  }
+  return comparison.same;
+}
+
+bool MessageDifferencer::CanFingerprintElements(
+    const MapKeyComparator* key_comparator) {
+  if (GetDefaultFieldComparator() == nullptr || !ignore_criteria_.empty()) {
+    return false;
+  }
+  // Only the key comparators created by this differencer are known to compare
+  // the fields FingerprintElement() looks at.
+  return key_comparator == nullptr ||
+         key_comparator == &map_entry_key_comparator_ ||
+         std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                   key_comparator) != owned_key_comparators_.end();
+}
+
+uint64 MessageDifferencer::FingerprintElement(
+    const Message& message, const FieldDescriptor* repeated_field,
+    const MapKeyComparator* key_comparator, int index) {
+  if (key_comparator == nullptr ||
+      repeated_field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    return FingerprintFieldValue(message, repeated_field, index);
+  }
+  const Message& element =
+      message.GetReflection()->GetRepeatedMessage(message, repeated_field,
+                                                  index);
+  if (key_comparator == &map_entry_key_comparator_) {
+    const FieldDescriptor* key = element.GetDescriptor()->FindFieldByNumber(1);
+    if (ignored_fields_.find(key) != ignored_fields_.end()) {
+      // The entries are then compared as a whole.
+      return FingerprintMessage(element);
+    }
+    return FingerprintFieldValue(element, key, -1);
+  }
+  return static_cast<const MultipleFieldsMapKeyComparator*>(key_comparator)
+      ->Fingerprint(element);
+}
+
+uint64 MessageDifferencer::FingerprintMessage(const Message& message) {
+  uint64 fingerprint = kEmptyFingerprint;
+  // Any payloads are compared unpacked; their serialized bytes may differ.
+  if (message.GetDescriptor()->full_name() == internal::kAnyFullTypeName) {
+    return fingerprint;
+  }
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    if (ignored_fields_.find(field) != ignored_fields_.end()) continue;
+    uint64 value;
+    if (field->is_repeated()) {
+      if (GetMapKeyComparator(field) != nullptr || IsTreatedAsSet(field) ||
+          IsTreatedAsSmartSet(field) || IsTreatedAsSmartList(field)) {
+        continue;
+      }
+      const int size = reflection->FieldSize(message, field);
+      value = size;
+      for (int i = 0; i < size; i++) {
+        value = CombineFingerprints(value,
+                                    FingerprintFieldValue(message, field, i));
+      }
+    } else {
+      value = FingerprintFieldValue(message, field, -1);
+      if (message_field_comparison_ == EQUIVALENT) {
+        // A field set to its default value is equivalent to an unset one, so
+        // it must not contribute either.
+        uint64 default_value = kEmptyFingerprint;
+        switch (field->cpp_type()) {
+          case FieldDescriptor::CPPTYPE_INT32:
+            default_value = field->default_value_int32();
+            break;
+          case FieldDescriptor::CPPTYPE_INT64:
+            default_value = field->default_value_int64();
+            break;
+          case FieldDescriptor::CPPTYPE_UINT32:
+            default_value = field->default_value_uint32();
+            break;
+          case FieldDescriptor::CPPTYPE_UINT64:
+            default_value = field->default_value_uint64();
+            break;
+          case FieldDescriptor::CPPTYPE_BOOL:
+            default_value = field->default_value_bool();
+            break;
+          case FieldDescriptor::CPPTYPE_ENUM:
+            default_value = field->default_value_enum()->number();
+            break;
+          case FieldDescriptor::CPPTYPE_FLOAT:
+          case FieldDescriptor::CPPTYPE_DOUBLE:
+            default_value =
+                GetDefaultFieldComparator()->float_comparison() ==
+                        DefaultFieldComparator::EXACT
+                    ? FingerprintDouble(
+                          field->cpp_type() == FieldDescriptor::CPPTYPE_FLOAT
+                              ? field->default_value_float()
+                              : field->default_value_double())
+                    : kEmptyFingerprint;
+            break;
+          case FieldDescriptor::CPPTYPE_STRING:
+            default_value = FingerprintString(field->default_value_string());
+            break;
+          case FieldDescriptor::CPPTYPE_MESSAGE:
+            default_value = kEmptyFingerprint;
+            break;
+        }
+        if (value == default_value) continue;
+      }
+    }
+    fingerprint = CombineFingerprints(
+        fingerprint, CombineFingerprints(field->number(), value));
+  }
+  return fingerprint;
+}
+
+uint64 MessageDifferencer::FingerprintFieldValue(const Message& message,
+                                                 const FieldDescriptor* field,
+                                                 int index) {
+  const Reflection* reflection = message.GetReflection();
+  switch (field->cpp_type()) {
+#define FINGERPRINT_VALUE(CPPTYPE, METHOD)                           \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                           \
+    return static_cast<uint64>(                                      \
+        index < 0 ? reflection->Get##METHOD(message, field)          \
+                  : reflection->GetRepeated##METHOD(message, field, index));
+    FINGERPRINT_VALUE(INT32, Int32);
+    FINGERPRINT_VALUE(INT64, Int64);
+    FINGERPRINT_VALUE(UINT32, UInt32);
+    FINGERPRINT_VALUE(UINT64, UInt64);
+    FINGERPRINT_VALUE(BOOL, Bool);
+    FINGERPRINT_VALUE(ENUM, EnumValue);
+#undef FINGERPRINT_VALUE
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_DOUBLE: {
+      // Approximate comparison is not transitive; leave floats out.
+      if (GetDefaultFieldComparator()->float_comparison() !=
+          DefaultFieldComparator::EXACT) {
+        return kEmptyFingerprint;
+      }
+      double value;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_FLOAT) {
+        value = index < 0
+                    ? reflection->GetFloat(message, field)
+                    : reflection->GetRepeatedFloat(message, field, index);
+      } else {
+        value = index < 0
+                    ? reflection->GetDouble(message, field)
+                    : reflection->GetRepeatedDouble(message, field, index);
+      }
+      return FingerprintDouble(value);
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      return FingerprintString(
+          index < 0 ? reflection->GetStringReference(message, field, &scratch)
+                    : reflection->GetRepeatedStringReference(message, field,
+                                                             index, &scratch));
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return FingerprintMessage(
+          index < 0 ? reflection->GetMessage(message, field)
+                    : reflection->GetRepeatedMessage(message, field, index));
+  }
+  return kEmptyFingerprint;
+}
+
 bool MessageDifferencer::CompareMapFieldByMapReflection(
     const Message& message1, const Message& message2,
     const FieldDescriptor* map_field, std::vector<SpecificField>* parent_fields,
@@ -1006,17 +1501,7 @@ bool MessageDifferencer::CompareRepeatedField(
           map_field_key_comparator_.end() &&
       // Users didn't set repeated field comparison
       repeated_field_comparison_ == AS_LIST) {
-    DefaultFieldComparator* map_field_comparator =
-        field_comparator_ ? nullptr : &default_field_comparator_;
-#if PROTOBUF_RTTI
-    // Inherit class from DefaultFieldComparator can not get the benefit
-    // because DefaultFieldComparator::Compare() method might be overwrote.
-    if (field_comparator_ &&
-        typeid(*field_comparator_) == typeid(default_field_comparator_)) {
-      map_field_comparator =
-          static_cast<DefaultFieldComparator*>(field_comparator_);
-    }
-#endif
+    DefaultFieldComparator* map_field_comparator = GetDefaultFieldComparator();
     if (map_field_comparator) {
       const FieldDescriptor* key_des =
           repeated_field->message_type()->map_key();
@@ -1079,6 +1564,25 @@ bool MessageDifferencer::CompareRepeatedField(
     }
   }
 
+  // Paired elements of large repeated message fields are compared up front on
+  // parallel_for_, and their results and reports consumed in order below.
+  std::vector<ParallelComparison> parallel_comparisons;
+  if (repeated_field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+      CanCompareInParallel()) {
+    for (int i = 0; i < count1; i++) {
+      const int index2 = simple_list ? i : match_list1[i];
+      if (index2 < 0 || index2 >= count2) continue;
+      parallel_comparisons.emplace_back(repeated_field, i, index2);
+    }
+    if (parallel_comparisons.size() < parallel_min_elements_) {
+      parallel_comparisons.clear();
+    } else {
+      CompareFieldValuesInParallel(message1, message2, *parent_fields,
+                                   &parallel_comparisons);
+    }
+  }
+  int next_parallel_comparison = 0;
+
   bool fieldDifferent = false;
   SpecificField specific_field;
   specific_field.field = repeated_field;
@@ -1125,9 +1629,13 @@ bool MessageDifferencer::CompareRepeatedField(
       next_unmatched_index = match_list1[i] + 1;
     }
 
-    const bool result = CompareFieldValueUsingParentFields(
-        message1, message2, repeated_field, i, specific_field.new_index,
-        parent_fields);
+    const bool result =
+        next_parallel_comparison < parallel_comparisons.size()
+            ? ReplayParallelComparison(
+                  parallel_comparisons[next_parallel_comparison++])
+            : CompareFieldValueUsingParentFields(
+                  message1, message2, repeated_field, i,
+                  specific_field.new_index, parent_fields);
 
     // If we have found differences, either report them or terminate if
     // no reporter is present. Note that ReportModified, ReportMoved, and
@@ -1761,67 +2269,116 @@ bool MessageDifferencer::MatchRepeatedFieldIndices(
         }
       }
     }
-    for (int i = start_offset; i < count1; ++i) {
-      // Indicates any matched elements for this repeated field.
-      bool match = false;
-      int matched_j = -1;
-
+    if (!is_treated_as_smart_set && count1 - start_offset > 1 &&
+        count2 - start_offset > 1 && CanFingerprintElements(key_comparator)) {
+      // Bucket the remaining elements of message2 by fingerprint, so that each
+      // element of message1 is only compared against the elements whose
+      // fingerprints are equal to its own.  Elements with other fingerprints
+      // cannot match, and buckets keep their indices in ascending order, so
+      // this finds the same matching as the exhaustive loop below.
+      struct Bucket {
+        std::vector<int> indices;
+        int first_unmatched = 0;
+      };
+      std::unordered_map<uint64, Bucket> buckets;
       for (int j = start_offset; j < count2; j++) {
-        if (match_list2->at(j) != -1) {
-          if (!is_treated_as_smart_set || num_diffs_list1[i] == 0 ||
-              num_diffs_list1[match_list2->at(j)] == 0) {
-            continue;
+        buckets[FingerprintElement(message2, repeated_field, key_comparator, j)]
+            .indices.push_back(j);
+      }
+      for (int i = start_offset; i < count1; ++i) {
+        int matched_j = -1;
+        auto it = buckets.find(
+            FingerprintElement(message1, repeated_field, key_comparator, i));
+        if (it != buckets.end()) {
+          Bucket& bucket = it->second;
+          while (bucket.first_unmatched < bucket.indices.size() &&
+                 match_list2->at(bucket.indices[bucket.first_unmatched]) !=
+                     -1) {
+            bucket.first_unmatched++;
+          }
+          for (int k = bucket.first_unmatched; k < bucket.indices.size();
+               k++) {
+            int j = bucket.indices[k];
+            if (match_list2->at(j) == -1 &&
+                IsMatch(repeated_field, key_comparator, &message1, &message2,
+                        parent_fields, nullptr, i, j)) {
+              matched_j = j;
+              break;
+            }
           }
         }
-
-        if (is_treated_as_smart_set) {
-          num_diffs_reporter.Reset();
-          match = IsMatch(repeated_field, key_comparator, &message1, &message2,
-                          parent_fields, &num_diffs_reporter, i, j);
+        if (matched_j != -1) {
+          match_list1->at(i) = matched_j;
+          match_list2->at(matched_j) = i;
         } else {
-          match = IsMatch(repeated_field, key_comparator, &message1, &message2,
-                          parent_fields, nullptr, i, j);
+          if (reporter == nullptr) return false;
+          success = false;
         }
+      }
+    } else {
+      for (int i = start_offset; i < count1; ++i) {
+        // Indicates any matched elements for this repeated field.
+        bool match = false;
+        int matched_j = -1;
+
+        for (int j = start_offset; j < count2; j++) {
+          if (match_list2->at(j) != -1) {
+            if (!is_treated_as_smart_set || num_diffs_list1[i] == 0 ||
+                num_diffs_list1[match_list2->at(j)] == 0) {
+              continue;
+            }
+          }
 
-        if (is_treated_as_smart_set) {
-          if (match) {
-            num_diffs_list1[i] = 0;
-          } else if (repeated_field->cpp_type() ==
-                     FieldDescriptor::CPPTYPE_MESSAGE) {
-            // Replace with the one with fewer diffs.
-            const int32 num_diffs = num_diffs_reporter.GetNumDiffs();
-            if (num_diffs < num_diffs_list1[i]) {
-              // If j has been already matched to some element, ensure the
-              // current num_diffs is smaller.
-              if (match_list2->at(j) == -1 ||
-                  num_diffs < num_diffs_list1[match_list2->at(j)]) {
-                num_diffs_list1[i] = num_diffs;
-                match = true;
+          if (is_treated_as_smart_set) {
+            num_diffs_reporter.Reset();
+            match = IsMatch(repeated_field, key_comparator, &message1,
+                            &message2, parent_fields, &num_diffs_reporter, i,
+                            j);
+          } else {
+            match = IsMatch(repeated_field, key_comparator, &message1,
+                            &message2, parent_fields, nullptr, i, j);
+          }
+
+          if (is_treated_as_smart_set) {
+            if (match) {
+              num_diffs_list1[i] = 0;
+            } else if (repeated_field->cpp_type() ==
+                       FieldDescriptor::CPPTYPE_MESSAGE) {
+              // Replace with the one with fewer diffs.
+              const int32 num_diffs = num_diffs_reporter.GetNumDiffs();
+              if (num_diffs < num_diffs_list1[i]) {
+                // If j has been already matched to some element, ensure the
+                // current num_diffs is smaller.
+                if (match_list2->at(j) == -1 ||
+                    num_diffs < num_diffs_list1[match_list2->at(j)]) {
+                  num_diffs_list1[i] = num_diffs;
+                  match = true;
+                }
               }
             }
           }
-        }
 
-        if (match) {
-          matched_j = j;
-          if (!is_treated_as_smart_set || num_diffs_list1[i] == 0) {
-            break;
+          if (match) {
+            matched_j = j;
+            if (!is_treated_as_smart_set || num_diffs_list1[i] == 0) {
+              break;
+            }
           }
         }
-      }
 
-      match = (matched_j != -1);
-      if (match) {
-        if (is_treated_as_smart_set && match_list2->at(matched_j) != -1) {
-          // This is to revert the previously matched index in list2.
-          match_list1->at(match_list2->at(matched_j)) = -1;
-          match = false;
+        match = (matched_j != -1);
+        if (match) {
+          if (is_treated_as_smart_set && match_list2->at(matched_j) != -1) {
+            // This is to revert the previously matched index in list2.
+            match_list1->at(match_list2->at(matched_j)) = -1;
+            match = false;
+          }
+          match_list1->at(i) = matched_j;
+          match_list2->at(matched_j) = i;
         }
-        match_list1->at(i) = matched_j;
-        match_list2->at(matched_j) = i;
+        if (!match && reporter == nullptr) return false;
+        success = success && match;
       }
-      if (!match && reporter == nullptr) return false;
-      success = success && match;
     }
   }
 
@@ -52,6 +52,7 @@
 #include <google/protobuf/message.h>     // Message
 #include <google/protobuf/unknown_field_set.h>
 #include <google/protobuf/util/field_comparator.h>
+#include <google/protobuf/util/parallel_parse.h>
 
 // Always include as last one, otherwise it can break compilation
 #include <google/protobuf/port_def.inc>
@@ -576,6 +577,22 @@ class PROTOBUF_EXPORT MessageDifferencer {
   // Returns the current repeated field comparison used by this differencer.
   RepeatedFieldComparison repeated_field_comparison();
 
+  // Compares large repeated message fields and sibling sub-messages
+  // concurrently through "parallel_for" (see util/parallel_parse.h). The
+  // paired elements of a repeated message field are split into shards when
+  // there are at least "min_elements" of them, and so are the singular
+  // sub-message fields of a message when together they directly hold at least
+  // "min_elements" values. Each shard is compared by a worker copy of this
+  // differencer that buffers what it reports; the buffered reports are then
+  // passed on to the Reporter in the order a sequential comparison produces
+  // them, so the results do not change. Shards do not split further.
+  //
+  // A custom FieldComparator or IgnoreCriteria must be safe to call from
+  // several threads at once. Comparison stays sequential while a
+  // MapKeyComparator passed to TreatAsMapUsingKeyComparator is in use.
+  void set_parallel_for(const ParallelForFunction& parallel_for,
+                        int min_elements = 64);
+
   // Compares the two specified messages, returning true if they are the same,
   // false otherwise. If this method returns false, any changes between the
   // two messages will be reported if a Reporter was specified via
@@ -694,6 +711,13 @@ class PROTOBUF_EXPORT MessageDifferencer {
   // class is declared as a nested class of MessageDifferencer.
   class MultipleFieldsMapKeyComparator;
 
+  // Buffers the reports of a worker differencer; see set_parallel_for().
+  class RecordingReporter;
+
+  // A field value comparison (as by CompareFieldValueUsingParentFields) done
+  // by CompareFieldValuesInParallel, with its result and buffered reports.
+  struct ParallelComparison;
+
   // A MapKeyComparator for use with map_entries.
   class PROTOBUF_EXPORT MapEntryKeyComparator : public MapKeyComparator {
    public:
@@ -798,6 +822,45 @@ class PROTOBUF_EXPORT MessageDifferencer {
                const std::vector<SpecificField>& parent_fields,
                Reporter* reporter, int index1, int index2);
 
+  // Returns the DefaultFieldComparator values are compared with, or NULL if
+  // a custom FieldComparator is in use.
+  DefaultFieldComparator* GetDefaultFieldComparator();
+
+  // Returns true if parallel_for_ is set and the settings can be copied to
+  // worker differencers.
+  bool CanCompareInParallel();
+
+  // Makes this differencer a worker of "parent", comparing with its settings.
+  void InitParallelWorker(MessageDifferencer* parent);
+
+  // Runs "comparisons" on worker differencers through parallel_for_.
+  void CompareFieldValuesInParallel(
+      const Message& message1, const Message& message2,
+      const std::vector<SpecificField>& parent_fields,
+      std::vector<ParallelComparison>* comparisons);
+
+  // Passes the buffered reports of "comparison" on to reporter_ and returns
+  // its result.
+  bool ReplayParallelComparison(const ParallelComparison& comparison);
+
+  // Returns true if elements of the repeated field can be bucketed by
+  // FingerprintElement() before matching, i.e. if no custom FieldComparator,
+  // IgnoreCriteria or MapKeyComparator can make two elements match in ways
+  // the fingerprint does not see.
+  bool CanFingerprintElements(const MapKeyComparator* key_comparator);
+
+  // Fingerprints of values such that two values that IsMatch() (or compare
+  // equal under the current settings) always have the same fingerprint.
+  // Anything whose equality the fingerprint cannot follow exactly, such as
+  // approximately compared floats, set-like repeated fields or Any payloads,
+  // is left out of it.
+  uint64 FingerprintElement(const Message& message,
+                            const FieldDescriptor* repeated_field,
+                            const MapKeyComparator* key_comparator, int index);
+  uint64 FingerprintMessage(const Message& message);
+  uint64 FingerprintFieldValue(const Message& message,
+                               const FieldDescriptor* field, int index);
+
   // Returns true when this repeated field has been configured to be treated
   // as a Set / SmartSet / SmartList.
   bool IsTreatedAsSet(const FieldDescriptor* field);
@@ -905,6 +968,14 @@ class PROTOBUF_EXPORT MessageDifferencer {
       match_indices_for_smart_list_callback_;
 
   std::unique_ptr<DynamicMessageFactory> dynamic_message_factory_;
+
+  ParallelForFunction parallel_for_;
+  int parallel_min_elements_;
+  // True for the worker differencers of set_parallel_for(). Workers share the
+  // IgnoreCriteria of their parent, and keep the Any payloads they unpack
+  // alive for the reports they buffered.
+  bool parallel_worker_;
+  std::vector<std::unique_ptr<Message>> unpacked_any_payloads_;
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessageDifferencer);
 };
 
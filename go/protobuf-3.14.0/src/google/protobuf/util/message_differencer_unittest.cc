@@ -35,8 +35,10 @@
 // TODO(ksroka): Move some of these tests to field_comparator_test.cc.
 
 #include <algorithm>
+#include <functional>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <google/protobuf/stubs/strutil.h>
@@ -1572,6 +1574,141 @@ TEST(MessageDifferencerTest, RepeatedFieldSetTest_Partial) {
   EXPECT_TRUE(differencer.Compare(msg1, msg2));
 }
 
+TEST(MessageDifferencerTest, RepeatedFieldSetTest_Large) {
+  // Large enough that comparing every pair of elements would be noticeably
+  // slow.
+  const int kSize = 20000;
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  for (int i = 0; i < kSize; ++i) {
+    protobuf_unittest::TestField* field = msg1.add_rm();
+    field->set_a(i);
+    field->set_b(i % 7);
+    field->add_rc(i);
+    msg1.add_rv(i % 100);
+  }
+  for (int i = kSize - 1; i >= 0; --i) {
+    *msg2.add_rm() = msg1.rm(i);
+    msg2.add_rv(msg1.rv(i));
+  }
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "rm"));
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "rv"));
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  // msg2.rm(10000) is msg1.rm(9999).
+  msg2.mutable_rm(kSize / 2)->set_b(100);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  std::string diff_report;
+  differencer.set_report_moves(false);
+  differencer.ReportDifferencesToString(&diff_report);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_EQ(
+      "added: rm[10000]: { rc: 9999 a: 9999 b: 100 }\n"
+      "deleted: rm[9999]: { rc: 9999 a: 9999 b: 3 }\n",
+      diff_report);
+}
+
+TEST(MessageDifferencerTest, RepeatedFieldSetTest_EquivalentDefaults) {
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  // message msg1: {
+  //   rm { a: 0 m { c: 0 } }
+  //   rm { b: 1 }
+  // }
+  protobuf_unittest::TestField* field = msg1.add_rm();
+  field->set_a(0);
+  field->mutable_m()->set_c(0);
+  msg1.add_rm()->set_b(1);
+  // message msg2: {
+  //   rm { b: 1 }
+  //   rm {}
+  // }
+  msg2.add_rm()->set_b(1);
+  msg2.add_rm();
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "rm"));
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  differencer.set_message_field_comparison(
+      util::MessageDifferencer::EQUIVALENT);
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, RepeatedFieldSetTest_NestedSet) {
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  // message msg1: {
+  //   item { a: 1 ra: 1 ra: 2 }
+  //   item { a: 2 }
+  // }
+  protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+  item->set_a(1);
+  item->add_ra(1);
+  item->add_ra(2);
+  msg1.add_item()->set_a(2);
+  // message msg2: {
+  //   item { a: 2 }
+  //   item { a: 1 ra: 2 ra: 1 }
+  // }
+  msg2.add_item()->set_a(2);
+  item = msg2.add_item();
+  item->set_a(1);
+  item->add_ra(2);
+  item->add_ra(1);
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "item"));
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "item.ra"));
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, RepeatedFieldSetTest_Floats) {
+  unittest::TestAllTypes msg1, msg2;
+  msg1.add_repeated_double(0.0);
+  msg1.add_repeated_double(1.5);
+  msg1.add_repeated_double(2.5);
+  msg2.add_repeated_double(2.5);
+  msg2.add_repeated_double(-0.0);
+  msg2.add_repeated_double(1.5);
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "repeated_double"));
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  msg2.set_repeated_double(0, 2.5 + 1e-15);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  differencer.set_float_comparison(util::MessageDifferencer::APPROXIMATE);
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, RepeatedFieldMapTest_Large) {
+  const int kSize = 20000;
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  for (int i = 0; i < kSize; ++i) {
+    protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+    item->set_a(i / 2);
+    item->set_b(StrCat(i % 2));
+    item->add_ra(i);
+  }
+  for (int i = kSize - 1; i >= 0; --i) {
+    *msg2.add_item() = msg1.item(i);
+  }
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsMapWithMultipleFieldsAsKey(
+      GetFieldDescriptor(msg1, "item"),
+      {GetFieldDescriptor(msg1, "item.a"), GetFieldDescriptor(msg1, "item.b")});
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  msg2.mutable_item(0)->set_ra(0, 0);
+  std::string diff_report;
+  differencer.set_report_moves(false);
+  differencer.ReportDifferencesToString(&diff_report);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_EQ("modified: item[19999].ra[0] -> item[0].ra[0]: 19999 -> 0\n",
+            diff_report);
+}
+
 TEST(MessageDifferencerTest, RepeatedFieldMapTest_MultipleFieldsAsKey) {
   protobuf_unittest::TestDiffMessage msg1;
   protobuf_unittest::TestDiffMessage msg2;
@@ -3728,6 +3865,134 @@ TEST(Anytest, TreatAsSet_DifferentType) {
   EXPECT_TRUE(message_differencer.Compare(m1, m2));
 }
 
+void ThreadParallelFor(int n, const std::function<void(int)>& fn) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n; i++) threads.emplace_back(fn, i);
+  for (auto& thread : threads) thread.join();
+}
+
+// Returns the report of comparing msg1 and msg2 with the differencer's
+// settings, checking that comparing them in parallel reports the same.
+std::string ReportSequentialAndParallel(util::MessageDifferencer* differencer,
+                                        const Message& msg1,
+                                        const Message& msg2,
+                                        int min_elements) {
+  std::string sequential_report;
+  differencer->set_parallel_for(nullptr);
+  differencer->ReportDifferencesToString(&sequential_report);
+  const bool sequential_result = differencer->Compare(msg1, msg2);
+
+  std::string parallel_report;
+  differencer->set_parallel_for(ThreadParallelFor, min_elements);
+  differencer->ReportDifferencesToString(&parallel_report);
+  EXPECT_EQ(sequential_result, differencer->Compare(msg1, msg2));
+  EXPECT_EQ(sequential_report, parallel_report);
+
+  differencer->ReportDifferencesTo(nullptr);
+  EXPECT_EQ(sequential_result, differencer->Compare(msg1, msg2));
+  return sequential_report;
+}
+
+TEST(ParallelMessageDifferencerTest, RepeatedField) {
+  const int kSize = 1000;
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  for (int i = 0; i < kSize; ++i) {
+    protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+    item->set_a(i);
+    item->add_ra(i);
+    item->mutable_m()->set_c(i);
+    item->add_rm()->mutable_m()->set_a(i);
+  }
+  msg2 = msg1;
+  msg2.mutable_item(10)->set_ra(0, -1);
+  msg2.mutable_item(500)->mutable_m()->set_c(-1);
+  msg2.mutable_item(900)->clear_m();
+  msg2.mutable_item(999)->add_rm()->set_b(1);
+  msg2.add_item()->set_a(kSize);
+
+  util::MessageDifferencer differencer;
+  const std::string list_report =
+      ReportSequentialAndParallel(&differencer, msg1, msg2, 100);
+  EXPECT_EQ(
+      "modified: item[10].ra[0]: 10 -> -1\n"
+      "modified: item[500].m.c: 500 -> -1\n"
+      "deleted: item[900].m: { c: 900 }\n"
+      "added: item[999].rm[1]: { b: 1 }\n"
+      "added: item[1000]: { a: 1000 }\n",
+      list_report);
+
+  differencer.set_report_matches(true);
+  ReportSequentialAndParallel(&differencer, msg1, msg2, 100);
+  differencer.set_report_matches(false);
+
+  differencer.TreatAsMap(GetFieldDescriptor(msg1, "item"),
+                         GetFieldDescriptor(msg1, "item.a"));
+  std::reverse(msg2.mutable_item()->begin(), msg2.mutable_item()->end());
+  ReportSequentialAndParallel(&differencer, msg1, msg2, 100);
+
+  // Too few elements to be worth splitting up.
+  EXPECT_EQ(list_report.empty(), ReportSequentialAndParallel(
+                                     &differencer, msg1, msg2, kSize * 2)
+                                     .empty());
+}
+
+TEST(ParallelMessageDifferencerTest, RepeatedFieldAsSet) {
+  const int kSize = 1000;
+  protobuf_unittest::TestDiffMessage msg1, msg2;
+  for (int i = 0; i < kSize; ++i) {
+    protobuf_unittest::TestField* field = msg1.add_rm();
+    field->set_a(i);
+    field->add_rc(i);
+  }
+  for (int i = kSize - 1; i >= 0; --i) {
+    *msg2.add_rm() = msg1.rm(i);
+  }
+  msg2.mutable_rm(0)->set_b(1);
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsSet(GetFieldDescriptor(msg1, "rm"));
+  differencer.set_report_moves(false);
+  EXPECT_EQ(
+      "added: rm[0]: { rc: 999 a: 999 b: 1 }\n"
+      "deleted: rm[999]: { rc: 999 a: 999 }\n",
+      ReportSequentialAndParallel(&differencer, msg1, msg2, 100));
+  differencer.set_report_matches(true);
+  ReportSequentialAndParallel(&differencer, msg1, msg2, 100);
+}
+
+TEST(ParallelMessageDifferencerTest, SiblingMessages) {
+  unittest::TestAllTypes msg1, msg2;
+  TestUtil::SetAllFields(&msg1);
+  TestUtil::SetAllFields(&msg2);
+  msg2.mutable_optional_nested_message()->set_bb(1);
+  msg2.mutable_optional_import_message()->clear_d();
+
+  util::MessageDifferencer differencer;
+  differencer.IgnoreField(GetFieldDescriptor(msg1, "optional_lazy_message"));
+  EXPECT_EQ(
+      "modified: optional_nested_message.bb: 118 -> 1\n"
+      "deleted: optional_import_message.d: 120\n"
+      "ignored: optional_lazy_message\n",
+      ReportSequentialAndParallel(&differencer, msg1, msg2, 1));
+  differencer.set_report_matches(true);
+  ReportSequentialAndParallel(&differencer, msg1, msg2, 1);
+}
+
+TEST(ParallelMessageDifferencerTest, Any) {
+  protobuf_unittest::TestAny m1, m2;
+  for (int i = 0; i < 100; ++i) {
+    protobuf_unittest::TestField value;
+    value.set_a(i);
+    m1.add_repeated_any_value()->PackFrom(value);
+    if (i == 50) value.set_a(-1);
+    m2.add_repeated_any_value()->PackFrom(value);
+  }
+
+  util::MessageDifferencer differencer;
+  EXPECT_EQ("modified: repeated_any_value[50].a: 50 -> -1\n",
+            ReportSequentialAndParallel(&differencer, m1, m2, 10));
+}
+
 
 }  // namespace
 }  // namespace protobuf
@@ -0,0 +1,141 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/parallel_parse.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+// Elements are handed to |parallel_for| in batches of at least this many
+// bytes, so that small elements don't cost a task each.
+static const int kMinBytesPerBatch = 64 << 10;
+
+struct ElementSpan {
+  int offset;
+  int size;
+};
+
+// Splits |data| into the elements of |field| and everything else. Returns
+// false if the input is malformed.
+bool ScanElements(StringPiece data, const FieldDescriptor* field,
+                  std::vector<ElementSpan>* elements, std::string* rest) {
+  const uint32 element_tag = internal::WireFormatLite::MakeTag(
+      field->number(), internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                             static_cast<int>(data.size()));
+  while (true) {
+    int start = input.CurrentPosition();
+    uint32 tag = input.ReadTag();
+    if (tag == 0) return input.ConsumedEntireMessage();
+    if (tag == element_tag) {
+      uint32 size;
+      if (!input.ReadVarint32(&size)) return false;
+      ElementSpan span = {input.CurrentPosition(), static_cast<int>(size)};
+      if (!input.Skip(size)) return false;
+      elements->push_back(span);
+    } else {
+      if (!internal::WireFormatLite::SkipField(&input, tag)) return false;
+      rest->append(data.data() + start, input.CurrentPosition() - start);
+    }
+  }
+}
+
+}  // namespace
+
+bool ParsePartialWithParallelRepeatedField(
+    StringPiece data, const FieldDescriptor* field,
+    const ParallelForFunction& parallel_for, Message* message) {
+  GOOGLE_CHECK(field->is_repeated() &&
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+        field->containing_type() == message->GetDescriptor())
+      << field->full_name() << " is not a repeated message field of "
+      << message->GetDescriptor()->full_name();
+
+  std::vector<ElementSpan> spans;
+  std::string rest;
+  if (!ScanElements(data, field, &spans, &rest)) return false;
+  if (!message->ParsePartialFromString(rest)) return false;
+  if (spans.empty()) return true;
+
+  // Elements are created on the calling thread, since adding to a repeated
+  // field isn't thread-safe; only their contents are parsed concurrently.
+  const Reflection* reflection = message->GetReflection();
+  std::vector<Message*> elements;
+  elements.reserve(spans.size());
+  for (size_t i = 0; i < spans.size(); i++) {
+    elements.push_back(reflection->AddMessage(message, field));
+  }
+
+  // Batch boundaries, as indices into |spans|.
+  std::vector<int> batches(1, 0);
+  int batch_bytes = 0;
+  for (size_t i = 0; i < spans.size(); i++) {
+    batch_bytes += spans[i].size;
+    if (batch_bytes >= kMinBytesPerBatch || i + 1 == spans.size()) {
+      batches.push_back(static_cast<int>(i + 1));
+      batch_bytes = 0;
+    }
+  }
+
+  std::atomic<bool> ok(true);
+  parallel_for(static_cast<int>(batches.size()) - 1, [&](int batch) {
+    for (int i = batches[batch]; i < batches[batch + 1]; i++) {
+      if (!ok.load(std::memory_order_relaxed)) return;
+      if (!elements[i]->ParsePartialFromArray(data.data() + spans[i].offset,
+                                              spans[i].size)) {
+        ok.store(false, std::memory_order_relaxed);
+      }
+    }
+  });
+  return ok.load();
+}
+
+bool ParseWithParallelRepeatedField(StringPiece data,
+                                    const FieldDescriptor* field,
+                                    const ParallelForFunction& parallel_for,
+                                    Message* message) {
+  return ParsePartialWithParallelRepeatedField(data, field, parallel_for,
+                                               message) &&
+         message->IsInitialized();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,85 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Parsing of messages with a large repeated message field, where the
+// elements of that field are parsed concurrently.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
+#define GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
+
+#include <functional>
+
+#include <google/protobuf/stubs/stringpiece.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Runs fn(0), fn(1), ..., fn(n - 1), possibly concurrently, and returns once
+// all of the calls have finished. This is how the caller supplies threads;
+// it is typically a thin wrapper around a thread pool.
+typedef std::function<void(int n, const std::function<void(int)>& fn)>
+    ParallelForFunction;
+
+// Parses the serialized message in |data| into |message|, as
+// message->ParseFromArray() would, but parses the elements of the repeated
+// message field |field| concurrently.
+//
+// The input is first scanned for the boundaries of the elements of |field|,
+// which is cheap since every element is length-delimited. The remaining
+// fields are parsed into |message| on the calling thread. The elements are
+// then added to |message| and parsed in batches through |parallel_for|. If
+// |message| is on an arena, each worker thread allocates the contents of its
+// elements from its own block of that arena, so the arena need not be
+// synchronized beyond what Arena already does.
+//
+// |field| must be a repeated message field of |message|'s type. Returns false
+// if the input is malformed or, for the non-partial variant, if the result is
+// missing required fields.
+bool PROTOBUF_EXPORT ParseWithParallelRepeatedField(
+    StringPiece data, const FieldDescriptor* field,
+    const ParallelForFunction& parallel_for, Message* message);
+
+// Same as above, but does not check that the result is initialized.
+bool PROTOBUF_EXPORT ParsePartialWithParallelRepeatedField(
+    StringPiece data, const FieldDescriptor* field,
+    const ParallelForFunction& parallel_for, Message* message);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
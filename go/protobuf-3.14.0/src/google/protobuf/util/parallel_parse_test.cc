@@ -0,0 +1,125 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/parallel_parse.h>
+
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/arena.h>
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+void ThreadParallelFor(int n, const std::function<void(int)>& fn) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n; i++) threads.emplace_back(fn, i);
+  for (auto& thread : threads) thread.join();
+}
+
+const FieldDescriptor* RepeatedNestedMessageField() {
+  return protobuf_unittest::TestAllTypes::descriptor()->FindFieldByName(
+      "repeated_nested_message");
+}
+
+std::string MakeInput(int num_elements) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  for (int i = 0; i < num_elements; i++) {
+    message.add_repeated_nested_message()->set_bb(i);
+  }
+  return message.SerializeAsString();
+}
+
+TEST(ParallelParseTest, MatchesSerialParse) {
+  const std::string data = MakeInput(50000);
+  protobuf_unittest::TestAllTypes expected;
+  ASSERT_TRUE(expected.ParseFromString(data));
+
+  int batches = 0;
+  protobuf_unittest::TestAllTypes message;
+  ASSERT_TRUE(ParseWithParallelRepeatedField(
+      data, RepeatedNestedMessageField(),
+      [&batches](int n, const std::function<void(int)>& fn) {
+        batches = n;
+        ThreadParallelFor(n, fn);
+      },
+      &message));
+  EXPECT_GT(batches, 1);
+  EXPECT_EQ(expected.SerializeAsString(), message.SerializeAsString());
+}
+
+TEST(ParallelParseTest, OnArena) {
+  const std::string data = MakeInput(50000);
+  Arena arena;
+  auto* message =
+      Arena::CreateMessage<protobuf_unittest::TestAllTypes>(&arena);
+  ASSERT_TRUE(ParseWithParallelRepeatedField(data, RepeatedNestedMessageField(),
+                                             ThreadParallelFor, message));
+  ASSERT_EQ(50002, message->repeated_nested_message_size());
+  EXPECT_EQ(49999, message->repeated_nested_message(50001).bb());
+  EXPECT_EQ(&arena, message->repeated_nested_message(100).GetArena());
+  EXPECT_EQ(101, message->optional_int32());
+  EXPECT_EQ(218, message->repeated_nested_message(0).bb());
+}
+
+TEST(ParallelParseTest, ReplacesExistingContents) {
+  protobuf_unittest::TestAllTypes message;
+  message.add_repeated_nested_message()->set_bb(7);
+  message.set_optional_int32(3);
+  ASSERT_TRUE(ParseWithParallelRepeatedField(std::string(),
+                                             RepeatedNestedMessageField(),
+                                             ThreadParallelFor, &message));
+  EXPECT_EQ(0, message.ByteSizeLong());
+}
+
+TEST(ParallelParseTest, MalformedElement) {
+  std::string data = MakeInput(10);
+  // An element holding a truncated varint.
+  data += "\x82\x03\x02\x08\x80";
+  protobuf_unittest::TestAllTypes message;
+  EXPECT_FALSE(ParseWithParallelRepeatedField(
+      data, RepeatedNestedMessageField(), ThreadParallelFor, &message));
+  // A truncated element.
+  data = MakeInput(10) + "\x82\x03\x05\x08";
+  EXPECT_FALSE(ParseWithParallelRepeatedField(
+      data, RepeatedNestedMessageField(), ThreadParallelFor, &message));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
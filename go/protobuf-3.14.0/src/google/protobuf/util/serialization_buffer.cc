@@ -0,0 +1,87 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/serialization_buffer.h>
+
+#include <google/protobuf/stubs/logging.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+// Enough for typical RPC payloads; larger buffers are released on Clear().
+static const size_t kDefaultMaxRetainedCapacity = 1 << 20;
+}  // namespace
+
+SerializationBuffer::SerializationBuffer()
+    : SerializationBuffer(kDefaultMaxRetainedCapacity) {}
+
+SerializationBuffer::SerializationBuffer(size_t max_retained_capacity)
+    : max_retained_capacity_(max_retained_capacity) {}
+
+bool SerializationBuffer::Serialize(const MessageLite& message) {
+  GOOGLE_DCHECK(message.IsInitialized())
+      << "Can't serialize message of type \"" << message.GetTypeName()
+      << "\" because it is missing required fields: "
+      << message.InitializationErrorString();
+  return SerializePartial(message);
+}
+
+bool SerializationBuffer::SerializePartial(const MessageLite& message) {
+  Clear();
+  return AppendPartial(message);
+}
+
+bool SerializationBuffer::Append(const MessageLite& message) {
+  GOOGLE_DCHECK(message.IsInitialized())
+      << "Can't serialize message of type \"" << message.GetTypeName()
+      << "\" because it is missing required fields: "
+      << message.InitializationErrorString();
+  return AppendPartial(message);
+}
+
+bool SerializationBuffer::AppendPartial(const MessageLite& message) {
+  // AppendPartialToString() resizes the string without zero-filling it, and
+  // only reallocates if the message doesn't fit into the kept storage.
+  return message.AppendPartialToString(&buffer_);
+}
+
+void SerializationBuffer::Clear() {
+  if (buffer_.capacity() > max_retained_capacity_) {
+    std::string().swap(buffer_);
+  } else {
+    buffer_.clear();
+  }
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,98 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A reusable output buffer for serializing many messages, e.g. one
+// response after another in an RPC server.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_SERIALIZATION_BUFFER_H__
+#define GOOGLE_PROTOBUF_UTIL_SERIALIZATION_BUFFER_H__
+
+#include <string>
+
+#include <google/protobuf/stubs/stringpiece.h>
+#include <google/protobuf/message_lite.h>
+
+#include <google/protobuf/port_def.inc>
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Serializes messages into storage that is kept from one call to the next.
+//
+// message.SerializeToString() into a fresh string allocates on every call.
+// A SerializationBuffer grows to the largest message it has seen and then
+// serializes without allocating, as long as the messages don't get bigger.
+// To bound the memory held by an idle buffer, storage larger than
+// max_retained_capacity is released when the buffer is next cleared.
+//
+// The serialized bytes are available through data() until the buffer is
+// modified again, e.g. to pass them to write() or sendmsg(). A buffer is not
+// thread-safe; keep one per thread or per connection.
+class PROTOBUF_EXPORT SerializationBuffer {
+ public:
+  SerializationBuffer();
+  explicit SerializationBuffer(size_t max_retained_capacity);
+
+  // Replaces the contents of the buffer with the serialized message.
+  // Returns false if the message is larger than 2GB. The buffer is empty on
+  // failure.
+  bool Serialize(const MessageLite& message);
+  // Like Serialize(), but allows missing required fields.
+  bool SerializePartial(const MessageLite& message);
+
+  // Appends the serialized message to the contents of the buffer, so that
+  // several messages can be sent at once. Returns false, leaving the
+  // contents unchanged, if the message is larger than 2GB.
+  bool Append(const MessageLite& message);
+  bool AppendPartial(const MessageLite& message);
+
+  // Empties the buffer. The storage is kept, unless it exceeds
+  // max_retained_capacity.
+  void Clear();
+
+  StringPiece data() const { return buffer_; }
+  size_t size() const { return buffer_.size(); }
+  bool empty() const { return buffer_.empty(); }
+
+ private:
+  std::string buffer_;
+  const size_t max_retained_capacity_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(SerializationBuffer);
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include <google/protobuf/port_undef.inc>
+
+#endif  // GOOGLE_PROTOBUF_UTIL_SERIALIZATION_BUFFER_H__
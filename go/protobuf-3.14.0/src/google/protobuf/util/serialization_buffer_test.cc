@@ -0,0 +1,104 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/util/serialization_buffer.h>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(SerializationBufferTest, Serialize) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  SerializationBuffer buffer;
+  EXPECT_TRUE(buffer.empty());
+  ASSERT_TRUE(buffer.Serialize(message));
+  EXPECT_EQ(message.SerializeAsString(), buffer.data());
+  EXPECT_EQ(message.ByteSizeLong(), buffer.size());
+
+  // Serializing again replaces the contents, without reallocating.
+  const char* storage = buffer.data().data();
+  protobuf_unittest::TestAllTypes smaller;
+  smaller.set_optional_int32(5);
+  ASSERT_TRUE(buffer.Serialize(smaller));
+  EXPECT_EQ(smaller.SerializeAsString(), buffer.data());
+  EXPECT_EQ(storage, buffer.data().data());
+}
+
+TEST(SerializationBufferTest, Append) {
+  protobuf_unittest::TestAllTypes message1;
+  message1.set_optional_int32(1);
+  protobuf_unittest::TestAllTypes message2;
+  message2.set_optional_string("two");
+
+  SerializationBuffer buffer;
+  ASSERT_TRUE(buffer.Append(message1));
+  ASSERT_TRUE(buffer.Append(message2));
+  EXPECT_EQ(message1.SerializeAsString() + message2.SerializeAsString(),
+            buffer.data());
+
+  buffer.Clear();
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(SerializationBufferTest, SerializePartial) {
+  protobuf_unittest::TestRequired message;
+  message.set_a(1);
+  SerializationBuffer buffer;
+  ASSERT_TRUE(buffer.SerializePartial(message));
+  EXPECT_EQ(message.SerializePartialAsString(), buffer.data());
+}
+
+TEST(SerializationBufferTest, ReleasesLargeStorage) {
+  protobuf_unittest::TestAllTypes large;
+  large.set_optional_string(std::string(10000, 'x'));
+  protobuf_unittest::TestAllTypes small;
+  small.set_optional_int32(1);
+
+  SerializationBuffer buffer(100);
+  ASSERT_TRUE(buffer.Serialize(large));
+  ASSERT_TRUE(buffer.Serialize(small));
+  EXPECT_EQ(small.SerializeAsString(), buffer.data());
+  protobuf_unittest::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromArray(buffer.data().data(), buffer.size()));
+  EXPECT_EQ(1, parsed.optional_int32());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
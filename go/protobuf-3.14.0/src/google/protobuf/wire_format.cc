@@ -52,6 +52,7 @@
 #include <google/protobuf/map_field_inl.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/message_lite.h>
+#include <google/protobuf/reverse_encoder.h>
 #include <google/protobuf/unknown_field_set.h>
 
 
@@ -194,6 +195,11 @@ bool WireFormat::ReadPackedEnumPreserveUnknowns(io::CodedInputStream* input,
 uint8* WireFormat::InternalSerializeUnknownFieldsToArray(
     const UnknownFieldSet& unknown_fields, uint8* target,
     io::EpsCopyOutputStream* stream) {
+  // Fields kept undecoded by lazy parsing are copied as they are.
+  if (const std::string* raw = unknown_fields.raw_) {
+    return stream->WriteRaw(raw->data(), static_cast<int>(raw->size()),
+                            target);
+  }
   for (int i = 0; i < unknown_fields.field_count(); i++) {
     const UnknownField& field = unknown_fields.field(i);
 
@@ -229,6 +235,42 @@ uint8* WireFormat::InternalSerializeUnknownFieldsToArray(
   return target;
 }
 
+uint8* WireFormat::InternalSerializeUnknownFieldsReverse(
+    const UnknownFieldSet& unknown_fields, uint8* ptr,
+    ReverseEncoder* encoder) {
+  if (const std::string* raw = unknown_fields.raw_) {
+    return encoder->WriteRaw(raw->data(), raw->size(), ptr);
+  }
+  for (int i = unknown_fields.field_count() - 1; i >= 0; i--) {
+    const UnknownField& field = unknown_fields.field(i);
+
+    switch (field.type()) {
+      case UnknownField::TYPE_VARINT:
+        ptr = encoder->WriteUInt64(field.number(), field.varint(), ptr);
+        break;
+      case UnknownField::TYPE_FIXED32:
+        ptr = encoder->WriteFixed32(field.number(), field.fixed32(), ptr);
+        break;
+      case UnknownField::TYPE_FIXED64:
+        ptr = encoder->WriteFixed64(field.number(), field.fixed64(), ptr);
+        break;
+      case UnknownField::TYPE_LENGTH_DELIMITED:
+        ptr = encoder->WriteString(field.number(), field.length_delimited(),
+                                   ptr);
+        break;
+      case UnknownField::TYPE_GROUP:
+        ptr = encoder->WriteTag(field.number(),
+                                WireFormatLite::WIRETYPE_END_GROUP, ptr);
+        ptr = InternalSerializeUnknownFieldsReverse(field.group(), ptr,
+                                                    encoder);
+        ptr = encoder->WriteTag(field.number(),
+                                WireFormatLite::WIRETYPE_START_GROUP, ptr);
+        break;
+    }
+  }
+  return ptr;
+}
+
 uint8* WireFormat::InternalSerializeUnknownMessageSetItemsToArray(
     const UnknownFieldSet& unknown_fields, uint8* target,
     io::EpsCopyOutputStream* stream) {
@@ -267,6 +309,7 @@ uint8* WireFormat::InternalSerializeUnknownMessageSetItemsToArray(
 
 size_t WireFormat::ComputeUnknownFieldsSize(
     const UnknownFieldSet& unknown_fields) {
+  if (const std::string* raw = unknown_fields.raw_) return raw->size();
   size_t size = 0;
   for (int i = 0; i < unknown_fields.field_count(); i++) {
     const UnknownField& field = unknown_fields.field(i);
@@ -59,6 +59,7 @@
 
 namespace google {
 namespace protobuf {
+class DynamicMessage;   // dynamic_message.cc
 class UnknownFieldSet;  // unknown_field_set.h
 }  // namespace protobuf
 }  // namespace google
@@ -186,6 +187,11 @@ class PROTOBUF_EXPORT WireFormat {
   static uint8* InternalSerializeUnknownFieldsToArray(
       const UnknownFieldSet& unknown_fields, uint8* target,
       io::EpsCopyOutputStream* stream);
+  // Writes the unknown fields in front of |ptr| for single-pass
+  // serialization.  Returns the start of the written data.
+  static uint8* InternalSerializeUnknownFieldsReverse(
+      const UnknownFieldSet& unknown_fields, uint8* ptr,
+      ReverseEncoder* encoder);
 
   // Same thing except for messages that have the message_set_wire_format
   // option.
@@ -283,6 +289,10 @@ class PROTOBUF_EXPORT WireFormat {
                                          Operation op, const char* field_name);
 
  private:
+  // DynamicMessage parses most fields itself and hands the rest to
+  // _InternalParseAndMergeField().
+  friend class ::google::protobuf::DynamicMessage;
+
   struct MessageSetParser;
   // Skip a MessageSet field.
   static bool SkipMessageSetField(io::CodedInputStream* input,
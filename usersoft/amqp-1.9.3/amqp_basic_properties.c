@@ -49,6 +49,7 @@
 #endif
 
 #include "amqp_basic_properties.h"
+#include "amqp_envelope.h"
 #include "php_amqp.h"
 #include "amqp_timestamp.h"
 #include "amqp_decimal.h"
@@ -148,6 +149,7 @@ static PHP_METHOD(AMQPBasicProperties, __construct) {
 static PHP_METHOD(AMQPBasicProperties, getContentType) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("content_type");
 }
 /* }}} */
@@ -156,6 +158,7 @@ static PHP_METHOD(AMQPBasicProperties, getContentType) {
 static PHP_METHOD(AMQPBasicProperties, getContentEncoding) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("content_encoding");
 }
 /* }}} */
@@ -164,6 +167,7 @@ static PHP_METHOD(AMQPBasicProperties, getContentEncoding) {
 static PHP_METHOD(AMQPBasicProperties, getHeaders) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("headers");
 }
 /* }}} */
@@ -172,6 +176,7 @@ static PHP_METHOD(AMQPBasicProperties, getHeaders) {
 static PHP_METHOD(AMQPBasicProperties, getDeliveryMode) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("delivery_mode");
 }
 /* }}} */
@@ -180,6 +185,7 @@ static PHP_METHOD(AMQPBasicProperties, getDeliveryMode) {
 static PHP_METHOD(AMQPBasicProperties, getPriority) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("priority");
 }
 /* }}} */
@@ -188,6 +194,7 @@ static PHP_METHOD(AMQPBasicProperties, getPriority) {
 static PHP_METHOD(AMQPBasicProperties, getCorrelationId) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("correlation_id");
 }
 /* }}} */
@@ -196,6 +203,7 @@ static PHP_METHOD(AMQPBasicProperties, getCorrelationId) {
 static PHP_METHOD(AMQPBasicProperties, getReplyTo) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("reply_to");
 }
 /* }}} */
@@ -205,6 +213,7 @@ check amqp envelope */
 static PHP_METHOD(AMQPBasicProperties, getExpiration) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("expiration");
 }
 /* }}} */
@@ -213,6 +222,7 @@ static PHP_METHOD(AMQPBasicProperties, getExpiration) {
 static PHP_METHOD(AMQPBasicProperties, getMessageId) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("message_id");
 }
 /* }}} */
@@ -221,6 +231,7 @@ static PHP_METHOD(AMQPBasicProperties, getMessageId) {
 static PHP_METHOD(AMQPBasicProperties, getTimestamp) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("timestamp");
 }
 /* }}} */
@@ -229,6 +240,7 @@ static PHP_METHOD(AMQPBasicProperties, getTimestamp) {
 static PHP_METHOD(AMQPBasicProperties, getType) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("type");
 }
 /* }}} */
@@ -237,6 +249,7 @@ static PHP_METHOD(AMQPBasicProperties, getType) {
 static PHP_METHOD(AMQPBasicProperties, getUserId) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("user_id");
 }
 /* }}} */
@@ -245,6 +258,7 @@ static PHP_METHOD(AMQPBasicProperties, getUserId) {
 static PHP_METHOD(AMQPBasicProperties, getAppId) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("app_id");
 }
 /* }}} */
@@ -253,6 +267,7 @@ static PHP_METHOD(AMQPBasicProperties, getAppId) {
 static PHP_METHOD(AMQPBasicProperties, getClusterId) {
     PHP5to7_READ_PROP_RV_PARAM_DECL;
     PHP_AMQP_NOPARAMS();
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
     PHP_AMQP_RETURN_THIS_PROP("cluster_id");
 }
 /* }}} */
@@ -95,6 +95,27 @@ void php_amqp_close_channel(amqp_channel_resource *channel_resource, zend_bool c
 	}
 }
 
+/* Give channel back to its connection for reuse when nothing can leak to the next user, close it otherwise */
+void php_amqp_release_channel(amqp_channel_resource *channel_resource TSRMLS_DC)
+{
+	assert(channel_resource != NULL);
+
+	amqp_connection_resource *connection_resource = channel_resource->connection_resource;
+
+	if (connection_resource != NULL
+		&& connection_resource->is_connected
+		&& channel_resource->is_connected
+		&& channel_resource->channel_id > 0
+		&& !channel_resource->is_confirm
+		&& !channel_resource->is_transactional
+		&& !channel_resource->has_deliveries
+		&& php_amqp_connection_resource_park_channel(connection_resource, channel_resource) == SUCCESS) {
+		return;
+	}
+
+	php_amqp_close_channel(channel_resource, 0 TSRMLS_CC);
+}
+
 #if PHP_MAJOR_VERSION >= 7
 
 static void php_amqp_destroy_fci(zend_fcall_info *fci) {
@@ -258,7 +279,7 @@ void amqp_channel_free(PHP5to7_obj_free_zend_object *object TSRMLS_DC)
 	amqp_channel_object *channel = PHP_AMQP_FETCH_CHANNEL(object);
 
 	if (channel->channel_resource != NULL) {
-		php_amqp_close_channel(channel->channel_resource, 0 TSRMLS_CC);
+		php_amqp_release_channel(channel->channel_resource TSRMLS_CC);
 
 		efree(channel->channel_resource);
 		channel->channel_resource = NULL;
@@ -310,6 +331,37 @@ PHP5to7_zend_object_value amqp_channel_ctor(zend_class_entry *ce TSRMLS_DC)
 }
 
 
+/* Set prefetch count on freshly opened or reused channel, unless broker has it already */
+static void php_amqp_channel_apply_qos(amqp_channel_resource *channel_resource, uint16_t prefetch_count TSRMLS_DC)
+{
+	if (channel_resource->prefetch_count == prefetch_count && channel_resource->prefetch_size == 0) {
+		return;
+	}
+
+	amqp_basic_qos(
+		channel_resource->connection_resource->connection_state,
+		channel_resource->channel_id,
+		0,							/* prefetch window size */
+		prefetch_count,				/* prefetch message count */
+		/* NOTE that RabbitMQ has reinterpreted global flag field. See https://www.rabbitmq.com/amqp-0-9-1-reference.html#basic.qos.global for details */
+		0							/* global flag */
+	);
+
+	amqp_rpc_reply_t res = amqp_get_rpc_reply(channel_resource->connection_resource->connection_state);
+
+	if (PHP_AMQP_MAYBE_ERROR(res, channel_resource)) {
+		php_amqp_zend_throw_exception_short(res, amqp_channel_exception_class_entry TSRMLS_CC);
+		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
+		return;
+	}
+
+	channel_resource->prefetch_count = prefetch_count;
+	channel_resource->prefetch_size  = 0;
+
+	php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
+}
+
+
 /* {{{ proto AMQPChannel::__construct(AMQPConnection obj)
  */
 static PHP_METHOD(amqp_channel_class, __construct)
@@ -365,6 +417,14 @@ static PHP_METHOD(amqp_channel_class, __construct)
 	channel->channel_resource = channel_resource;
     channel_resource->parent = channel;
 
+	/* Reuse channel parked by previous AMQPChannel on this connection, it is open already */
+	if (php_amqp_connection_resource_take_idle_channel(connection->connection_resource, channel_resource) == SUCCESS) {
+		channel_resource->is_connected = '\1';
+
+		php_amqp_channel_apply_qos(channel_resource, (uint16_t)PHP_AMQP_READ_THIS_PROP_LONG("prefetch_count") TSRMLS_CC);
+		return;
+	}
+
 	/* Figure out what the next available channel is on this connection */
 	channel_resource->channel_id = php_amqp_connection_resource_get_available_channel_id(connection->connection_resource);
 
@@ -406,24 +466,7 @@ static PHP_METHOD(amqp_channel_class, __construct)
 	channel_resource->is_connected = '\1';
 
 	/* Set the prefetch count: */
-	amqp_basic_qos(
-		channel_resource->connection_resource->connection_state,
-		channel_resource->channel_id,
-		0,							/* prefetch window size */
-		(uint16_t)PHP_AMQP_READ_THIS_PROP_LONG("prefetch_count"),	/* prefetch message count */
-		/* NOTE that RabbitMQ has reinterpreted global flag field. See https://www.rabbitmq.com/amqp-0-9-1-reference.html#basic.qos.global for details */
-		0							/* global flag */
-	);
-
-	amqp_rpc_reply_t res = amqp_get_rpc_reply(channel_resource->connection_resource->connection_state);
-
-	if (PHP_AMQP_MAYBE_ERROR(res, channel_resource)) {
-		php_amqp_zend_throw_exception_short(res, amqp_channel_exception_class_entry TSRMLS_CC);
-		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
-		return;
-	}
-
-	php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
+	php_amqp_channel_apply_qos(channel_resource, (uint16_t)PHP_AMQP_READ_THIS_PROP_LONG("prefetch_count") TSRMLS_CC);
 }
 /* }}} */
 
@@ -509,6 +552,9 @@ static PHP_METHOD(amqp_channel_class, setPrefetchCount)
 			return;
 		}
 
+		channel_resource->prefetch_count = (uint16_t)prefetch_count;
+		channel_resource->prefetch_size  = 0;
+
 		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
 	}
 
@@ -563,6 +609,9 @@ static PHP_METHOD(amqp_channel_class, setPrefetchSize)
 			return;
 		}
 
+		channel_resource->prefetch_count = 0;
+		channel_resource->prefetch_size  = (uint16_t)prefetch_size;
+
 		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
 	}
 
@@ -626,6 +675,9 @@ static PHP_METHOD(amqp_channel_class, qos)
 			return;
 		}
 
+		channel_resource->prefetch_count = (uint16_t)prefetch_count;
+		channel_resource->prefetch_size  = (uint16_t)prefetch_size;
+
 		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
 	}
 
@@ -662,6 +714,8 @@ static PHP_METHOD(amqp_channel_class, startTransaction)
 		return;
 	}
 
+	channel_resource->is_transactional = 1;
+
 	php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
 
 	RETURN_TRUE;
@@ -812,6 +866,8 @@ PHP_METHOD(amqp_channel_class, confirmSelect)
 		return;
 	}
 
+	channel_resource->is_confirm = 1;
+
 	php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
 
 	RETURN_TRUE;
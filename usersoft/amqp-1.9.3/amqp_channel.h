@@ -23,6 +23,7 @@
 extern zend_class_entry *amqp_channel_class_entry;
 
 void php_amqp_close_channel(amqp_channel_resource *channel_resource, zend_bool check_errors TSRMLS_DC);
+void php_amqp_release_channel(amqp_channel_resource *channel_resource TSRMLS_DC);
 
 PHP_MINIT_FUNCTION(amqp_channel);
 
@@ -337,10 +337,21 @@ amqp_channel_t php_amqp_connection_resource_get_available_channel_id(amqp_connec
 		return 0;
 	}
 
-	amqp_channel_t slot;
+	amqp_channel_t slot, idle;
 
 	for (slot = 0; slot < resource->max_slots; slot++) {
-		if (resource->slots[slot] == 0) {
+		if (resource->slots[slot] != 0) {
+			continue;
+		}
+
+		/* Idle channels are still open on the broker, their ids are not free */
+		for (idle = 0; idle < resource->idle_count; idle++) {
+			if (resource->idle_channels[idle].channel_id == slot + 1) {
+				break;
+			}
+		}
+
+		if (idle == resource->idle_count) {
 			return (amqp_channel_t) (slot + 1);
 		}
 	}
@@ -381,6 +392,52 @@ int php_amqp_connection_resource_unregister_channel(amqp_connection_resource *re
 	return SUCCESS;
 }
 
+/* Unregister channel but keep it open on the broker, so that next AMQPChannel on this connection could skip channel.open */
+int php_amqp_connection_resource_park_channel(amqp_connection_resource *resource, amqp_channel_resource *channel_resource)
+{
+	assert(resource != NULL);
+	assert(channel_resource->connection_resource == resource);
+
+	if (resource->idle_count >= PHP_AMQP_MAX_IDLE_CHANNELS) {
+		return FAILURE;
+	}
+
+	amqp_idle_channel *idle = &resource->idle_channels[resource->idle_count++];
+
+	idle->channel_id     = channel_resource->channel_id;
+	idle->prefetch_count = channel_resource->prefetch_count;
+	idle->prefetch_size  = channel_resource->prefetch_size;
+
+	amqp_maybe_release_buffers_on_channel(resource->connection_state, channel_resource->channel_id);
+
+	php_amqp_connection_resource_unregister_channel(resource, channel_resource->channel_id);
+	channel_resource->is_connected = '\0';
+
+	return SUCCESS;
+}
+
+/* Hand the most recently parked channel over to channel_resource, it is already open and has known qos */
+int php_amqp_connection_resource_take_idle_channel(amqp_connection_resource *resource, amqp_channel_resource *channel_resource)
+{
+	assert(resource != NULL);
+
+	if (resource->idle_count == 0) {
+		return FAILURE;
+	}
+
+	amqp_idle_channel *idle = &resource->idle_channels[--resource->idle_count];
+
+	if (php_amqp_connection_resource_register_channel(resource, channel_resource, idle->channel_id) == FAILURE) {
+		return FAILURE;
+	}
+
+	channel_resource->channel_id     = idle->channel_id;
+	channel_resource->prefetch_count = idle->prefetch_count;
+	channel_resource->prefetch_size  = idle->prefetch_size;
+
+	return SUCCESS;
+}
+
 
 /* Creating and destroying resource */
 
@@ -620,9 +677,8 @@ void php_amqp_prepare_for_disconnect(amqp_connection_resource *resource TSRMLS_D
 	}
 
 	if(resource->slots != NULL) {
-		/* NOTE: when we have persistent connection we do not move channels between php requests
-		 *       due to current php-amqp extension limitation in AMQPChannel where __construct == channel.open AMQP method call
-		 *       and __destruct = channel.close AMQP method call
+		/* NOTE: when we have persistent connection channels which are still clean are parked instead of being closed,
+		 *       so AMQPChannel in the next php request on this connection may pick them up without channel.open
 		 */
 
 		/* Clean up old memory allocations which are now invalid (new connection) */
@@ -630,7 +686,11 @@ void php_amqp_prepare_for_disconnect(amqp_connection_resource *resource TSRMLS_D
 
 		for (slot = 0; slot < resource->max_slots; slot++) {
 			if (resource->slots[slot] != 0) {
-				php_amqp_close_channel(resource->slots[slot], 0 TSRMLS_CC);
+				if (resource->is_persistent) {
+					php_amqp_release_channel(resource->slots[slot] TSRMLS_CC);
+				} else {
+					php_amqp_close_channel(resource->slots[slot], 0 TSRMLS_CC);
+				}
 			}
 		}
 	}
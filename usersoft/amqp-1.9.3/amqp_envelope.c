@@ -57,6 +57,71 @@
 zend_class_entry *amqp_envelope_class_entry;
 #define this_ce amqp_envelope_class_entry
 
+zend_object_handlers amqp_envelope_object_handlers;
+
+#define PHP_AMQP_ENVELOPE_PROPERTIES_POOL_SIZE 1024
+
+/* Copy basic properties out of the delivery so they can be turned into zvals later, on first read */
+static int php_amqp_envelope_retain_properties(amqp_envelope_object *envelope, amqp_basic_properties_t *p)
+{
+    amqp_basic_properties_t *retained = &envelope->properties;
+    amqp_pool_t *pool = &envelope->properties_pool;
+
+    *retained = *p;
+
+#define PHP_AMQP_RETAIN_BYTES(flag, field) \
+    if ((p->_flags & (flag)) && p->field.len > 0) { \
+        amqp_pool_alloc_bytes(pool, p->field.len, &retained->field); \
+        if (retained->field.bytes == NULL) { \
+            return FAILURE; \
+        } \
+        memcpy(retained->field.bytes, p->field.bytes, p->field.len); \
+    } else { \
+        retained->field = amqp_empty_bytes; \
+    }
+
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_CONTENT_TYPE_FLAG, content_type);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_CONTENT_ENCODING_FLAG, content_encoding);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_CORRELATION_ID_FLAG, correlation_id);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_REPLY_TO_FLAG, reply_to);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_EXPIRATION_FLAG, expiration);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_MESSAGE_ID_FLAG, message_id);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_TYPE_FLAG, type);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_USER_ID_FLAG, user_id);
+    PHP_AMQP_RETAIN_BYTES(AMQP_BASIC_APP_ID_FLAG, app_id);
+
+#undef PHP_AMQP_RETAIN_BYTES
+
+    if (p->_flags & AMQP_BASIC_HEADERS_FLAG) {
+        if (amqp_table_clone(&p->headers, &retained->headers, pool) != AMQP_STATUS_OK) {
+            return FAILURE;
+        }
+    }
+
+    envelope->properties_pending = 1;
+
+    return SUCCESS;
+}
+
+void php_amqp_envelope_load_properties(zval *obj TSRMLS_DC)
+{
+    if (!instanceof_function(Z_OBJCE_P(obj), this_ce TSRMLS_CC)) {
+        return;
+    }
+
+    amqp_envelope_object *envelope = PHP_AMQP_GET_ENVELOPE(obj);
+
+    if (!envelope->properties_pending) {
+        return;
+    }
+
+    /* Reset first, extracting updates properties and must not get here again */
+    envelope->properties_pending = 0;
+
+    php_amqp_basic_properties_extract(&envelope->properties, obj TSRMLS_CC);
+
+    empty_amqp_pool(&envelope->properties_pool);
+}
 
 void convert_amqp_envelope_to_zval(amqp_envelope_t *amqp_envelope, zval *envelope TSRMLS_DC)
 {
@@ -66,6 +131,7 @@ void convert_amqp_envelope_to_zval(amqp_envelope_t *amqp_envelope, zval *envelop
 
     amqp_basic_properties_t *p = &amqp_envelope->message.properties;
     amqp_message_t *message = &amqp_envelope->message;
+    amqp_envelope_object *envelope_object = PHP_AMQP_GET_ENVELOPE(envelope);
 
     zend_update_property_stringl(this_ce, envelope, ZEND_STRL("body"), (const char *) message->body.bytes, (PHP5to7_param_str_len_type_t) message->body.len TSRMLS_CC);
 
@@ -75,9 +141,92 @@ void convert_amqp_envelope_to_zval(amqp_envelope_t *amqp_envelope, zval *envelop
     zend_update_property_stringl(this_ce, envelope, ZEND_STRL("exchange_name"), (const char *) amqp_envelope->exchange.bytes, (PHP5to7_param_str_len_type_t) amqp_envelope->exchange.len TSRMLS_CC);
     zend_update_property_stringl(this_ce, envelope, ZEND_STRL("routing_key"), (const char *) amqp_envelope->routing_key.bytes, (PHP5to7_param_str_len_type_t) amqp_envelope->routing_key.len TSRMLS_CC);
 
-    php_amqp_basic_properties_extract(p, envelope TSRMLS_CC);
+    /* Most consumers never look at properties and headers, so they are converted to zvals on first read only */
+    if (php_amqp_envelope_retain_properties(envelope_object, p) == FAILURE) {
+        empty_amqp_pool(&envelope_object->properties_pool);
+        php_amqp_basic_properties_extract(p, envelope TSRMLS_CC);
+    }
 }
 
+void amqp_envelope_free(PHP5to7_obj_free_zend_object *object TSRMLS_DC)
+{
+    amqp_envelope_object *envelope = PHP_AMQP_FETCH_ENVELOPE(object);
+
+    empty_amqp_pool(&envelope->properties_pool);
+
+    zend_object_std_dtor(&envelope->zo TSRMLS_CC);
+
+#if PHP_MAJOR_VERSION < 7
+    efree(object);
+#endif
+}
+
+PHP5to7_zend_object_value amqp_envelope_ctor(zend_class_entry *ce TSRMLS_DC)
+{
+    amqp_envelope_object *envelope = PHP5to7_ECALLOC_ENVELOPE_OBJECT(ce);
+
+    zend_object_std_init(&envelope->zo, ce TSRMLS_CC);
+    AMQP_OBJECT_PROPERTIES_INIT(envelope->zo, ce);
+
+    init_amqp_pool(&envelope->properties_pool, PHP_AMQP_ENVELOPE_PROPERTIES_POOL_SIZE);
+
+#if PHP_MAJOR_VERSION >=7
+    envelope->zo.handlers = &amqp_envelope_object_handlers;
+
+    return &envelope->zo;
+#else
+    PHP5to7_zend_object_value new_value;
+
+    new_value.handle = zend_objects_store_put(
+            envelope,
+            NULL,
+            (zend_objects_free_object_storage_t) amqp_envelope_free,
+            NULL TSRMLS_CC
+    );
+
+    new_value.handlers = &amqp_envelope_object_handlers;
+
+    return new_value;
+#endif
+}
+
+/* Properties are materialized before anything may look at the whole property table (var_dump, casts, serialize) */
+static HashTable *amqp_envelope_get_properties(zval *object TSRMLS_DC)
+{
+    php_amqp_envelope_load_properties(object TSRMLS_CC);
+
+    return zend_std_get_properties(object TSRMLS_CC);
+}
+
+#if PHP_MAJOR_VERSION >= 7
+static zend_object *amqp_envelope_clone(zval *object)
+{
+    zend_object *old_object = Z_OBJ_P(object);
+
+    php_amqp_envelope_load_properties(object);
+
+    zend_object *new_object = amqp_envelope_ctor(old_object->ce);
+
+    zend_objects_clone_members(new_object, old_object);
+
+    return new_object;
+}
+#else
+static zend_object_value amqp_envelope_clone(zval *object TSRMLS_DC)
+{
+    zend_object *old_object = zend_objects_get_address(object TSRMLS_CC);
+
+    php_amqp_envelope_load_properties(object TSRMLS_CC);
+
+    zend_object_value new_value = amqp_envelope_ctor(old_object->ce TSRMLS_CC);
+    zend_object *new_object = zend_object_store_get_object_by_handle(new_value.handle TSRMLS_CC);
+
+    zend_objects_clone_members(new_object, new_value, old_object, Z_OBJ_HANDLE_P(object) TSRMLS_CC);
+
+    return new_value;
+}
+#endif
+
 /* {{{ proto AMQPEnvelope::__construct() */
 static PHP_METHOD(amqp_envelope_class, __construct) {
     PHP_AMQP_NOPARAMS();
@@ -157,6 +306,8 @@ static PHP_METHOD(amqp_envelope_class, getHeader) {
         return;
     }
 
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
+
     zval* zv = PHP_AMQP_READ_THIS_PROP_CE("headers", amqp_basic_properties_class_entry);
 	//zval* zv = PHP_AMQP_READ_THIS_PROP("headers");
 
@@ -181,6 +332,8 @@ static PHP_METHOD(amqp_envelope_class, hasHeader) {
         return;
     }
 
+    php_amqp_envelope_load_properties(getThis() TSRMLS_CC);
+
     zval* zv = PHP_AMQP_READ_THIS_PROP_CE("headers", amqp_basic_properties_class_entry);
     //zval* zv = PHP_AMQP_READ_THIS_PROP("headers");
 
@@ -247,6 +400,7 @@ PHP_MINIT_FUNCTION (amqp_envelope) {
     zend_class_entry ce;
 
     INIT_CLASS_ENTRY(ce, "AMQPEnvelope", amqp_envelope_class_functions);
+    ce.create_object = amqp_envelope_ctor;
     this_ce = zend_register_internal_class_ex(&ce, amqp_basic_properties_class_entry PHP5to7_PARENT_CLASS_NAME_C(NULL) TSRMLS_CC);
 
     zend_declare_property_null(this_ce, ZEND_STRL("body"), ZEND_ACC_PRIVATE TSRMLS_CC);
@@ -257,6 +411,16 @@ PHP_MINIT_FUNCTION (amqp_envelope) {
     zend_declare_property_null(this_ce, ZEND_STRL("exchange_name"), ZEND_ACC_PRIVATE TSRMLS_CC);
     zend_declare_property_null(this_ce, ZEND_STRL("routing_key"), ZEND_ACC_PRIVATE TSRMLS_CC);
 
+    memcpy(&amqp_envelope_object_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+
+#if PHP_MAJOR_VERSION >=7
+    amqp_envelope_object_handlers.offset = XtOffsetOf(amqp_envelope_object, zo);
+    amqp_envelope_object_handlers.free_obj = amqp_envelope_free;
+#endif
+
+    amqp_envelope_object_handlers.get_properties = amqp_envelope_get_properties;
+    amqp_envelope_object_handlers.clone_obj = amqp_envelope_clone;
+
     return SUCCESS;
 }
 
@@ -23,6 +23,7 @@
 extern zend_class_entry *amqp_envelope_class_entry;
 
 void convert_amqp_envelope_to_zval(amqp_envelope_t *amqp_envelope, zval *envelope TSRMLS_DC);
+void php_amqp_envelope_load_properties(zval *obj TSRMLS_DC);
 
 PHP_MINIT_FUNCTION(amqp_envelope);
 
@@ -41,8 +41,10 @@
 
 #ifdef PHP_WIN32
 # include "win32/unistd.h"
+# include "win32/time.h"
 #else
 # include <unistd.h>
+# include <sys/time.h>
 #endif
 
 #include "php_amqp.h"
@@ -440,6 +442,9 @@ static PHP_METHOD(amqp_queue_class, get)
 		(AMQP_AUTOACK & flags) ? 1 : 0
 	);
 
+	/* Unacked deliveries stay bound to the channel, it must not be reused */
+	channel_resource->has_deliveries = 1;
+
 	if (PHP_AMQP_MAYBE_ERROR(res, channel_resource)) {
 		php_amqp_zend_throw_exception_short(res, amqp_queue_exception_class_entry TSRMLS_CC);
 		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
@@ -564,6 +569,9 @@ static PHP_METHOD(amqp_queue_class, consume)
 			return;
 		}
 
+		/* Consumer and its unacked deliveries stay bound to the channel, it must not be reused */
+		channel_resource->has_deliveries = 1;
+
 		char *key;
 		key = estrndup((char *) r->consumer_tag.bytes, (uint) r->consumer_tag.len);
 
@@ -749,6 +757,269 @@ static PHP_METHOD(amqp_queue_class, consume)
 /* }}} */
 
 
+/* Receive one delivery for AMQPQueue::consumeBatch(). Returns 1 and fills message when an envelope
+   was read, 0 when tv_ptr expired first and -1 when an exception has been thrown */
+static int php_amqp_queue_consume_one(amqp_channel_resource *channel_resource, amqp_channel_object *channel, struct timeval *tv_ptr, zval *message TSRMLS_DC)
+{
+	PHP5to7_READ_PROP_RV_PARAM_DECL;
+
+	PHP5to7_zval_t *current_queue_zv = NULL;
+	PHP5to7_zval_t current_channel_zv PHP5to7_MAYBE_SET_TO_NULL;
+
+	amqp_channel_resource *current_channel_resource;
+	amqp_envelope_t envelope;
+	zval *consumers;
+
+	while (1) {
+		php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
+
+		amqp_rpc_reply_t res = amqp_consume_message(channel_resource->connection_resource->connection_state, &envelope, tv_ptr, 0);
+
+		if (AMQP_RESPONSE_LIBRARY_EXCEPTION == res.reply_type && AMQP_STATUS_TIMEOUT == res.library_error) {
+			amqp_destroy_envelope(&envelope);
+			return 0;
+		}
+
+		if (PHP_AMQP_MAYBE_ERROR_RECOVERABLE(res, channel_resource)) {
+
+			if (PHP_AMQP_IS_ERROR_RECOVERABLE(res, channel_resource, channel)) {
+				/* In case no message was received, continue the loop */
+				amqp_destroy_envelope(&envelope);
+
+				continue;
+			} else {
+				/* Mark connection resource as closed to prevent sending any further requests */
+				channel_resource->connection_resource->is_connected = '\0';
+
+				/* Close connection with all its channels */
+				php_amqp_disconnect_force(channel_resource->connection_resource TSRMLS_CC);
+			}
+
+			php_amqp_zend_throw_exception_short(res, amqp_queue_exception_class_entry TSRMLS_CC);
+
+			amqp_destroy_envelope(&envelope);
+			return -1;
+		}
+
+		convert_amqp_envelope_to_zval(&envelope, message TSRMLS_CC);
+
+		current_channel_resource = channel_resource->connection_resource->slots[envelope.channel - 1];
+
+		if (!current_channel_resource) {
+			// This should never happen, but just in case
+			php_amqp_zend_throw_exception(res, amqp_queue_exception_class_entry, "Orphaned channel. Please, report a bug.", 0 TSRMLS_CC);
+			amqp_destroy_envelope(&envelope);
+			return -1;
+		}
+
+#if PHP_MAJOR_VERSION >= 7
+		PHP5to7_MAYBE_INIT(current_channel_zv);
+		ZVAL_OBJ(&current_channel_zv, &current_channel_resource->parent->zo);
+#else
+		current_channel_zv = current_channel_resource->parent->this_ptr;
+#endif
+
+		consumers = zend_read_property(amqp_channel_class_entry, PHP5to7_MAYBE_PTR(current_channel_zv), ZEND_STRL("consumers"), 0 PHP5to7_READ_PROP_RV_PARAM_CC TSRMLS_CC);
+
+		if (IS_ARRAY != Z_TYPE_P(consumers)) {
+			zend_throw_exception(amqp_queue_exception_class_entry, "Invalid channel consumers, forgot to call channel constructor?", 0 TSRMLS_CC);
+			amqp_destroy_envelope(&envelope);
+			return -1;
+		}
+
+		char *key;
+		key = estrndup((char *)envelope.consumer_tag.bytes, (uint) envelope.consumer_tag.len);
+
+		if (!PHP5to7_ZEND_HASH_FIND(Z_ARRVAL_P(consumers), key, PHP5to7_ZEND_HASH_STRLEN(envelope.consumer_tag.len), current_queue_zv)) {
+			PHP5to7_zval_t exception PHP5to7_MAYBE_SET_TO_NULL;
+			PHP5to7_MAYBE_INIT(exception);
+			object_init_ex(PHP5to7_MAYBE_PTR(exception), amqp_envelope_exception_class_entry);
+			zend_update_property_string(zend_exception_get_default(TSRMLS_C), PHP5to7_MAYBE_PTR(exception),  ZEND_STRL("message"), "Orphaned envelope" TSRMLS_CC);
+			zend_update_property(amqp_envelope_exception_class_entry, PHP5to7_MAYBE_PTR(exception), ZEND_STRL("envelope"), message TSRMLS_CC);
+
+			zend_throw_exception_object(PHP5to7_MAYBE_PTR(exception) TSRMLS_CC);
+
+			amqp_destroy_envelope(&envelope);
+			efree(key);
+			return -1;
+		}
+
+		efree(key);
+		amqp_destroy_envelope(&envelope);
+
+		return 1;
+	}
+}
+
+
+/* {{{ proto bool AMQPQueue::consumeBatch(int count, int timeout_ms, callback);
+consume messages in batches of up to count envelopes. The first envelope of every batch waits for the
+connection read timeout, further ones for at most timeout_ms in total, and each batch is handed over as
+callback(array envelopes, AMQPQueue queue). The consumer must already be set up with consume().
+*/
+static PHP_METHOD(amqp_queue_class, consumeBatch)
+{
+	PHP5to7_READ_PROP_RV_PARAM_DECL;
+
+	amqp_channel_resource *channel_resource;
+
+	zend_fcall_info fci = empty_fcall_info;
+	zend_fcall_info_cache fci_cache = empty_fcall_info_cache;
+
+	PHP5to7_param_long_type_t count = 0;
+	PHP5to7_param_long_type_t timeout_ms = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "llf",
+							  &count, &timeout_ms,
+							  &fci, &fci_cache) == FAILURE) {
+		return;
+	}
+
+	if (count < 1) {
+		zend_throw_exception(amqp_queue_exception_class_entry, "Parameter 'count' must be greater than zero.", 0 TSRMLS_CC);
+		return;
+	}
+
+	if (timeout_ms < 0) {
+		zend_throw_exception(amqp_queue_exception_class_entry, "Parameter 'timeout_ms' must be greater than or equal to zero.", 0 TSRMLS_CC);
+		return;
+	}
+
+	zval *channel_zv = PHP_AMQP_READ_THIS_PROP("channel");
+
+	amqp_channel_object *channel = PHP_AMQP_GET_CHANNEL(channel_zv);
+
+	channel_resource = PHP_AMQP_GET_CHANNEL_RESOURCE(channel_zv);
+	PHP_AMQP_VERIFY_CHANNEL_RESOURCE(channel_resource, "Could not get channel.");
+
+	struct timeval tv = {0};
+	struct timeval *tv_ptr = &tv;
+
+	double read_timeout = PHP_AMQP_READ_OBJ_PROP_DOUBLE(amqp_connection_class_entry, PHP_AMQP_READ_THIS_PROP("connection"), "read_timeout");
+
+	if (read_timeout > 0) {
+		tv.tv_sec  = (long int) read_timeout;
+		tv.tv_usec = (long int) ((read_timeout - tv.tv_sec) * 1000000);
+	} else {
+		tv_ptr = NULL;
+	}
+
+	while(1) {
+		PHP5to7_zval_t batch PHP5to7_MAYBE_SET_TO_NULL;
+		PHP5to7_zval_t message PHP5to7_MAYBE_SET_TO_NULL;
+
+		struct timeval deadline, now, remaining;
+		PHP5to7_param_long_type_t received = 0;
+		int status;
+
+		PHP5to7_MAYBE_INIT(batch);
+		PHP5to7_ARRAY_INIT(batch);
+
+		/* Block for the first envelope as consume() does */
+		PHP5to7_MAYBE_INIT(message);
+		ZVAL_NULL(PHP5to7_MAYBE_PTR(message));
+		status = php_amqp_queue_consume_one(channel_resource, channel, tv_ptr, PHP5to7_MAYBE_PTR(message) TSRMLS_CC);
+
+		if (status <= 0) {
+			if (status == 0) {
+				zend_throw_exception(amqp_queue_exception_class_entry, "Consumer timeout exceed", 0 TSRMLS_CC);
+			}
+
+			PHP5to7_MAYBE_DESTROY(message);
+			PHP5to7_MAYBE_DESTROY(batch);
+			break;
+		}
+
+		add_next_index_zval(PHP5to7_MAYBE_PTR(batch), PHP5to7_MAYBE_PTR(message));
+		received++;
+
+		/* Then fill the batch with whatever arrives within timeout_ms */
+		gettimeofday(&deadline, NULL);
+		deadline.tv_sec  += (long int) (timeout_ms / 1000);
+		deadline.tv_usec += (long int) ((timeout_ms % 1000) * 1000);
+		if (deadline.tv_usec >= 1000000) {
+			deadline.tv_sec++;
+			deadline.tv_usec -= 1000000;
+		}
+
+		status = 1;
+
+		while (received < count) {
+			gettimeofday(&now, NULL);
+
+			remaining.tv_sec  = deadline.tv_sec - now.tv_sec;
+			remaining.tv_usec = deadline.tv_usec - now.tv_usec;
+			if (remaining.tv_usec < 0) {
+				remaining.tv_sec--;
+				remaining.tv_usec += 1000000;
+			}
+			if (remaining.tv_sec < 0) {
+				/* Still drain deliveries that are already buffered */
+				remaining.tv_sec  = 0;
+				remaining.tv_usec = 0;
+			}
+
+			PHP5to7_MAYBE_INIT(message);
+			ZVAL_NULL(PHP5to7_MAYBE_PTR(message));
+			status = php_amqp_queue_consume_one(channel_resource, channel, &remaining, PHP5to7_MAYBE_PTR(message) TSRMLS_CC);
+
+			if (status <= 0) {
+				PHP5to7_MAYBE_DESTROY(message);
+				break;
+			}
+
+			add_next_index_zval(PHP5to7_MAYBE_PTR(batch), PHP5to7_MAYBE_PTR(message));
+			received++;
+		}
+
+		if (status < 0) {
+			/* Deliveries read so far are lost to the caller, just like in consume() */
+			PHP5to7_MAYBE_DESTROY(batch);
+			break;
+		}
+
+		/* Make the callback */
+		PHP5to7_zval_t params PHP5to7_MAYBE_SET_TO_NULL;
+		PHP5to7_zval_t retval PHP5to7_MAYBE_SET_TO_NULL;
+
+		/* Build the parameter array */
+		PHP5to7_MAYBE_INIT(params);
+		PHP5to7_ARRAY_INIT(params);
+
+		add_index_zval(PHP5to7_MAYBE_PTR(params), 0, PHP5to7_MAYBE_PTR(batch));
+		Z_ADDREF_P(PHP5to7_MAYBE_PTR(batch));
+
+		add_index_zval(PHP5to7_MAYBE_PTR(params), 1, getThis());
+		Z_ADDREF_P(getThis());
+
+		/* Convert everything to be callable */
+		zend_fcall_info_args(&fci, PHP5to7_MAYBE_PTR(params) TSRMLS_CC);
+		/* Initialize the return value pointer */
+
+		PHP5to7_SET_FCI_RETVAL_PTR(fci, PHP5to7_MAYBE_PTR(retval));
+
+		/* Call the function, and track the return value */
+		if (zend_call_function(&fci, &fci_cache TSRMLS_CC) == SUCCESS && PHP5to7_CHECK_FCI_RETVAL_PTR(fci)) {
+			RETVAL_ZVAL(PHP5to7_MAYBE_PTR(retval), 1, 1);
+		}
+
+		/* Clean up our mess */
+		zend_fcall_info_args_clear(&fci, 1);
+		PHP5to7_MAYBE_DESTROY(params);
+		PHP5to7_MAYBE_DESTROY(batch);
+
+		/* Check if user land function wants to bail */
+		if (EG(exception) || PHP5to7_IS_FALSE_P(return_value)) {
+			break;
+		}
+	}
+
+	php_amqp_maybe_release_buffers_on_channel(channel_resource->connection_resource, channel_resource);
+	return;
+}
+/* }}} */
+
+
 /* {{{ proto int AMQPQueue::ack(long deliveryTag, [bit flags=AMQP_NOPARAM]);
 	acknowledge the message
 */
@@ -1183,6 +1454,12 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_amqp_queue_class_consume, ZEND_SEND_BY_VAL, ZEND_
 				ZEND_ARG_INFO(0, consumer_tag)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_amqp_queue_class_consumeBatch, ZEND_SEND_BY_VAL, ZEND_RETURN_VALUE, 3)
+				ZEND_ARG_INFO(0, count)
+				ZEND_ARG_INFO(0, timeout_ms)
+				ZEND_ARG_INFO(0, callback)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_amqp_queue_class_ack, ZEND_SEND_BY_VAL, ZEND_RETURN_VALUE, 1)
 				ZEND_ARG_INFO(0, delivery_tag)
 				ZEND_ARG_INFO(0, flags)
@@ -1244,6 +1521,7 @@ zend_function_entry amqp_queue_class_functions[] = {
 
 		PHP_ME(amqp_queue_class, get,				arginfo_amqp_queue_class_get,				ZEND_ACC_PUBLIC)
 		PHP_ME(amqp_queue_class, consume,			arginfo_amqp_queue_class_consume,			ZEND_ACC_PUBLIC)
+		PHP_ME(amqp_queue_class, consumeBatch,		arginfo_amqp_queue_class_consumeBatch,		ZEND_ACC_PUBLIC)
 		PHP_ME(amqp_queue_class, ack,				arginfo_amqp_queue_class_ack,				ZEND_ACC_PUBLIC)
 		PHP_ME(amqp_queue_class, nack,				arginfo_amqp_queue_class_nack,				ZEND_ACC_PUBLIC)
 		PHP_ME(amqp_queue_class, reject,			arginfo_amqp_queue_class_reject,			ZEND_ACC_PUBLIC)
@@ -65,6 +65,7 @@ typedef zval* PHP5to7_zval_t;
 
 #define PHP5to7_ECALLOC_CONNECTION_OBJECT(ce) (amqp_connection_object*)ecalloc(1, sizeof(amqp_connection_object))
 #define PHP5to7_ECALLOC_CHANNEL_OBJECT(ce) (amqp_channel_object*)ecalloc(1, sizeof(amqp_channel_object))
+#define PHP5to7_ECALLOC_ENVELOPE_OBJECT(ce) (amqp_envelope_object*)ecalloc(1, sizeof(amqp_envelope_object))
 
 #define PHP5to7_CASE_IS_BOOL case IS_BOOL
 
@@ -64,6 +64,7 @@ typedef zval PHP5to7_zval_t;
 
 #define PHP5to7_ECALLOC_CONNECTION_OBJECT(ce) (amqp_connection_object*)ecalloc(1, sizeof(amqp_connection_object) + zend_object_properties_size(ce))
 #define PHP5to7_ECALLOC_CHANNEL_OBJECT(ce) (amqp_channel_object*)ecalloc(1, sizeof(amqp_channel_object) + zend_object_properties_size(ce))
+#define PHP5to7_ECALLOC_ENVELOPE_OBJECT(ce) (amqp_envelope_object*)ecalloc(1, sizeof(amqp_envelope_object) + zend_object_properties_size(ce))
 
 #define PHP5to7_CASE_IS_BOOL case IS_TRUE: case IS_FALSE
 
@@ -39,6 +39,8 @@ typedef struct _amqp_channel_object amqp_channel_object;
 typedef struct _amqp_channel_resource amqp_channel_resource;
 typedef struct _amqp_channel_callbacks amqp_channel_callbacks;
 typedef struct _amqp_callback_bucket amqp_callback_bucket;
+typedef struct _amqp_idle_channel amqp_idle_channel;
+typedef struct _amqp_envelope_object amqp_envelope_object;
 
 #if PHP_MAJOR_VERSION >= 7
 	#include "php7_support.h"
@@ -95,11 +97,27 @@ extern zend_module_entry amqp_module_entry;
 
 #define PHP_AMQP_CONNECTION_RES_NAME "AMQP Connection Resource"
 
+/* How many open channels a connection keeps for reuse once their AMQPChannel objects are gone */
+#define PHP_AMQP_MAX_IDLE_CHANNELS 16
+
 struct _amqp_channel_resource {
 	char is_connected;
 	amqp_channel_t channel_id;
 	amqp_connection_resource *connection_resource;
     amqp_channel_object *parent;
+	/* qos as last applied on the broker side */
+	uint16_t prefetch_count;
+	uint32_t prefetch_size;
+	/* modes and state which make channel unfit for reuse by another AMQPChannel */
+	zend_bool is_confirm;
+	zend_bool is_transactional;
+	zend_bool has_deliveries;
+};
+
+struct _amqp_idle_channel {
+	amqp_channel_t channel_id;
+	uint16_t prefetch_count;
+	uint32_t prefetch_size;
 };
 
 struct _amqp_callback_bucket {
@@ -141,10 +159,28 @@ struct _amqp_connection_resource {
 	amqp_channel_t max_slots;
 	amqp_channel_t used_slots;
 	amqp_channel_resource **slots;
+	amqp_channel_t idle_count;
+	amqp_idle_channel idle_channels[PHP_AMQP_MAX_IDLE_CHANNELS];
 	amqp_connection_state_t connection_state;
 	amqp_socket_t *socket;
 };
 
+/* NOTE: due to how internally PHP works with custom object, zend_object position in structure matters */
+struct _amqp_envelope_object {
+#if PHP_MAJOR_VERSION >= 7
+	/* basic properties copied from the delivery, turned into object properties on first read */
+	zend_bool properties_pending;
+	amqp_basic_properties_t properties;
+	amqp_pool_t properties_pool;
+	zend_object zo;
+#else
+	zend_object zo;
+	zend_bool properties_pending;
+	amqp_basic_properties_t properties;
+	amqp_pool_t properties_pool;
+#endif
+};
+
 struct _amqp_connection_object {
 #if PHP_MAJOR_VERSION >= 7
 	amqp_connection_resource *connection_resource;
@@ -236,18 +272,28 @@ struct _amqp_connection_object {
 		return (amqp_channel_object *)((char *)obj - XtOffsetOf(amqp_channel_object, zo));
 	}
 
+	static inline amqp_envelope_object *php_amqp_envelope_object_fetch(zend_object *obj) {
+		return (amqp_envelope_object *)((char *)obj - XtOffsetOf(amqp_envelope_object, zo));
+	}
+
 	#define PHP_AMQP_GET_CONNECTION(obj) php_amqp_connection_object_fetch(Z_OBJ_P(obj))
 	#define PHP_AMQP_GET_CHANNEL(obj) php_amqp_channel_object_fetch(Z_OBJ_P(obj))
 
 	#define PHP_AMQP_FETCH_CONNECTION(obj) php_amqp_connection_object_fetch(obj)
 	#define PHP_AMQP_FETCH_CHANNEL(obj) php_amqp_channel_object_fetch(obj)
 
+	#define PHP_AMQP_GET_ENVELOPE(obj) php_amqp_envelope_object_fetch(Z_OBJ_P(obj))
+	#define PHP_AMQP_FETCH_ENVELOPE(obj) php_amqp_envelope_object_fetch(obj)
+
 #else
 	#define PHP_AMQP_GET_CONNECTION(obj) (amqp_connection_object *)zend_object_store_get_object((obj) TSRMLS_CC)
 	#define PHP_AMQP_GET_CHANNEL(obj) (amqp_channel_object *)zend_object_store_get_object((obj) TSRMLS_CC)
 
 	#define PHP_AMQP_FETCH_CONNECTION(obj) (amqp_connection_object*)(obj)
 	#define PHP_AMQP_FETCH_CHANNEL(obj) (amqp_channel_object*)(obj)
+
+	#define PHP_AMQP_GET_ENVELOPE(obj) (amqp_envelope_object *)zend_object_store_get_object((obj) TSRMLS_CC)
+	#define PHP_AMQP_FETCH_ENVELOPE(obj) (amqp_envelope_object*)(obj)
 #endif
 
 
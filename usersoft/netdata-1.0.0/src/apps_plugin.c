@@ -574,6 +574,11 @@ struct pid_stat {
 	int *fds;					// array of fds it uses
 	int fds_size;				// the size of the fds array
 
+	int stat_fd;				// /proc/<pid>/stat, kept open across iterations, or -1
+	int statm_fd;				// /proc/<pid>/statm, kept open across iterations, or -1
+	int io_fd;					// /proc/<pid>/io, kept open across iterations, or -1
+	DIR *fds_dir;				// /proc/<pid>/fd, kept open across iterations, or NULL
+
 	int childs;					// number of processes directly referencing this
 	int updated;				// 1 when update
 	int merged;					// 1 when it has been merged to its parent
@@ -586,6 +591,141 @@ struct pid_stat {
 
 long all_pids_count = 0;
 
+// ----------------------------------------------------------------------------
+// kept open /proc/<pid>/ files
+//
+// the stat, statm and io files of each process are opened once and then
+// re-read with pread() on every iteration. Its fd directory is rewinded.
+// This saves the path lookup, the open() and the close() of 4 files per
+// process per iteration.
+// We keep open as many files as the open files limit allows. After that,
+// the files of the remaining processes are opened and closed every time.
+
+#define PROC_PID_FILE_BUFFER 4096
+#define RESERVED_FILE_DESCRIPTORS 100
+
+long kept_open_files = 0;
+long kept_open_files_max = 0;
+
+// 1 for the file descriptors we keep open, so that we do not report them
+char *kept_open_fds = NULL;
+long kept_open_fds_size = 0;
+
+int kept_open_file(int fd)
+{
+	return fd < kept_open_fds_size && kept_open_fds[fd];
+}
+
+// returns 1 if fd may be kept open
+int keep_open_file(int fd)
+{
+	if(kept_open_files >= kept_open_files_max || fd >= kept_open_fds_size) return 0;
+
+	kept_open_fds[fd] = 1;
+	kept_open_files++;
+	return 1;
+}
+
+void release_open_file(int fd)
+{
+	kept_open_fds[fd] = 0;
+	kept_open_files--;
+}
+
+void pid_close_file(int *fd)
+{
+	if(*fd == -1) return;
+
+	release_open_file(*fd);
+	close(*fd);
+	*fd = -1;
+}
+
+void pid_close_files(struct pid_stat *p)
+{
+	pid_close_file(&p->stat_fd);
+	pid_close_file(&p->statm_fd);
+	pid_close_file(&p->io_fd);
+
+	if(p->fds_dir) {
+		release_open_file(dirfd(p->fds_dir));
+		closedir(p->fds_dir);
+		p->fds_dir = NULL;
+	}
+}
+
+// read a /proc/<pid>/ file into buffer
+// returns the number of bytes read, or -1 on error
+ssize_t read_proc_pid_file(struct pid_stat *p, int *fd, const char *name, char *buffer, size_t size)
+{
+	ssize_t r;
+
+	if(*fd != -1) {
+		r = pread(*fd, buffer, size - 1, 0);
+		if(r > 0) goto done;
+
+		// the process exited, but its pid may have been reused
+		// all the files kept open are for the old process
+		pid_close_files(p);
+	}
+
+	char filename[FILENAME_MAX + 1];
+	snprintf(filename, FILENAME_MAX, "%s/proc/%d/%s", host_prefix, p->pid, name);
+
+	int f = open(filename, O_RDONLY);
+	if(f == -1) return -1;
+
+	r = pread(f, buffer, size - 1, 0);
+
+	if(r > 0 && keep_open_file(f)) *fd = f;
+	else close(f);
+
+	if(r <= 0) return -1;
+
+done:
+	buffer[r] = '\0';
+	file_counter++;
+	return r;
+}
+
+// allow as many open files as the hard limit permits
+void set_kept_open_files_max(void)
+{
+	struct rlimit rl;
+
+	if(getrlimit(RLIMIT_NOFILE, &rl) == -1) {
+		error("Cannot get the open files limit. Files of processes will not be kept open.");
+		return;
+	}
+
+	if(rl.rlim_cur < rl.rlim_max) {
+		rlim_t old = rl.rlim_cur;
+		rl.rlim_cur = rl.rlim_max;
+		if(setrlimit(RLIMIT_NOFILE, &rl) == -1) {
+			error("Cannot raise the open files limit from %llu to %llu.", (unsigned long long)old, (unsigned long long)rl.rlim_max);
+			rl.rlim_cur = old;
+		}
+	}
+
+	if(rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur > (rlim_t)(pid_max * 4 + RESERVED_FILE_DESCRIPTORS))
+		kept_open_files_max = pid_max * 4;
+	else if(rl.rlim_cur > RESERVED_FILE_DESCRIPTORS)
+		kept_open_files_max = (long)rl.rlim_cur - RESERVED_FILE_DESCRIPTORS;
+	else
+		kept_open_files_max = 0;
+
+	if(kept_open_files_max) {
+		kept_open_fds_size = kept_open_files_max + RESERVED_FILE_DESCRIPTORS;
+		kept_open_fds = calloc(kept_open_fds_size, sizeof(char));
+		if(!kept_open_fds) {
+			error("Cannot allocate %ld bytes of memory. Files of processes will not be kept open.", kept_open_fds_size);
+			kept_open_files_max = kept_open_fds_size = 0;
+		}
+	}
+
+	if(debug) fprintf(stderr, "apps.plugin: will keep open up to %ld files of processes.\n", kept_open_files_max);
+}
+
 struct pid_stat *get_pid_entry(pid_t pid)
 {
 	if(all_pids[pid]) {
@@ -611,6 +751,11 @@ struct pid_stat *get_pid_entry(pid_t pid)
 	all_pids[pid]->pid = pid;
 	all_pids[pid]->new_entry = 1;
 
+	all_pids[pid]->stat_fd = -1;
+	all_pids[pid]->statm_fd = -1;
+	all_pids[pid]->io_fd = -1;
+	all_pids[pid]->fds_dir = NULL;
+
 	return all_pids[pid];
 }
 
@@ -624,6 +769,8 @@ void del_pid_entry(pid_t pid)
 	if(all_pids[pid]->next) all_pids[pid]->next->prev = all_pids[pid]->prev;
 	if(all_pids[pid]->prev) all_pids[pid]->prev->next = all_pids[pid]->next;
 
+	pid_close_files(all_pids[pid]);
+
 	if(all_pids[pid]->fds) free(all_pids[pid]->fds);
 	free(all_pids[pid]);
 	all_pids[pid] = NULL;
@@ -634,147 +781,99 @@ void del_pid_entry(pid_t pid)
 // update pids from proc
 
 int read_proc_pid_stat(struct pid_stat *p) {
-	char filename[FILENAME_MAX + 1];
-
-	snprintf(filename, FILENAME_MAX, "%s/proc/%d/stat", host_prefix, p->pid);
-
-	ff = procfile_reopen(ff, filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-	if(!ff) return 1;
+	char buffer[PROC_PID_FILE_BUFFER];
 
-	ff = procfile_readall(ff);
-	if(!ff) {
-		// procfile_close(ff);
+	if(read_proc_pid_file(p, &p->stat_fd, "stat", buffer, PROC_PID_FILE_BUFFER) == -1)
 		return 1;
-	}
 
-	file_counter++;
+	// the command is in parenthesis and may have spaces and parenthesis in it
+	char *s = strchr(buffer, '(');
+	char *e = strrchr(buffer, ')');
+	if(!s || !e || e < s) return 1;
 
-	p->comm[0] = '\0';
-	p->comm[MAX_COMPARE_NAME] = '\0';
+	// the spaces of the command are dropped
 	size_t blen = 0;
-
-	char *s = procfile_lineword(ff, 0, 1);
-	if(*s == '(') s++;
-	size_t len = strlen(s);
-	unsigned int i = 0;
-	while(len && s[len - 1] != ')') {
-		if(blen < MAX_COMPARE_NAME) {
-			strncpy(&p->comm[blen], s, MAX_COMPARE_NAME - blen);
-			blen = strlen(p->comm);
-		}
-
-		i++;
-		s = procfile_lineword(ff, 0, 1+i);
-		len = strlen(s);
-	}
-	if(len && s[len - 1] == ')') s[len - 1] = '\0';
-	if(blen < MAX_COMPARE_NAME)
-		strncpy(&p->comm[blen], s, MAX_COMPARE_NAME - blen);
-
-	// p->pid			= atol(procfile_lineword(ff, 0, 0+i));
-	// comm is at 1
-	// p->state			= *(procfile_lineword(ff, 0, 2+i));
-	p->ppid				= (int32_t) atol(procfile_lineword(ff, 0, 3 + i));
-	// p->pgrp			= atol(procfile_lineword(ff, 0, 4+i));
-	// p->session		= atol(procfile_lineword(ff, 0, 5+i));
-	// p->tty_nr		= atol(procfile_lineword(ff, 0, 6+i));
-	// p->tpgid			= atol(procfile_lineword(ff, 0, 7+i));
-	// p->flags			= strtoull(procfile_lineword(ff, 0, 8+i), NULL, 10);
-	p->minflt			= strtoull(procfile_lineword(ff, 0, 9+i), NULL, 10);
-	p->cminflt			= strtoull(procfile_lineword(ff, 0, 10+i), NULL, 10);
-	p->majflt			= strtoull(procfile_lineword(ff, 0, 11+i), NULL, 10);
-	p->cmajflt			= strtoull(procfile_lineword(ff, 0, 12+i), NULL, 10);
-	p->utime			= strtoull(procfile_lineword(ff, 0, 13+i), NULL, 10);
-	p->stime			= strtoull(procfile_lineword(ff, 0, 14+i), NULL, 10);
-	p->cutime			= strtoull(procfile_lineword(ff, 0, 15+i), NULL, 10);
-	p->cstime			= strtoull(procfile_lineword(ff, 0, 16+i), NULL, 10);
-	// p->priority		= strtoull(procfile_lineword(ff, 0, 17+i), NULL, 10);
-	// p->nice			= strtoull(procfile_lineword(ff, 0, 18+i), NULL, 10);
-	p->num_threads		= (int32_t) atol(procfile_lineword(ff, 0, 19 + i));
-	// p->itrealvalue	= strtoull(procfile_lineword(ff, 0, 20+i), NULL, 10);
-	// p->starttime		= strtoull(procfile_lineword(ff, 0, 21+i), NULL, 10);
-	// p->vsize			= strtoull(procfile_lineword(ff, 0, 22+i), NULL, 10);
-	p->rss				= strtoull(procfile_lineword(ff, 0, 23+i), NULL, 10);
-	// p->rsslim		= strtoull(procfile_lineword(ff, 0, 24+i), NULL, 10);
-	// p->starcode		= strtoull(procfile_lineword(ff, 0, 25+i), NULL, 10);
-	// p->endcode		= strtoull(procfile_lineword(ff, 0, 26+i), NULL, 10);
-	// p->startstack	= strtoull(procfile_lineword(ff, 0, 27+i), NULL, 10);
-	// p->kstkesp		= strtoull(procfile_lineword(ff, 0, 28+i), NULL, 10);
-	// p->kstkeip		= strtoull(procfile_lineword(ff, 0, 29+i), NULL, 10);
-	// p->signal		= strtoull(procfile_lineword(ff, 0, 30+i), NULL, 10);
-	// p->blocked		= strtoull(procfile_lineword(ff, 0, 31+i), NULL, 10);
-	// p->sigignore		= strtoull(procfile_lineword(ff, 0, 32+i), NULL, 10);
-	// p->sigcatch		= strtoull(procfile_lineword(ff, 0, 33+i), NULL, 10);
-	// p->wchan			= strtoull(procfile_lineword(ff, 0, 34+i), NULL, 10);
-	// p->nswap			= strtoull(procfile_lineword(ff, 0, 35+i), NULL, 10);
-	// p->cnswap		= strtoull(procfile_lineword(ff, 0, 36+i), NULL, 10);
-	// p->exit_signal	= atol(procfile_lineword(ff, 0, 37+i));
-	// p->processor		= atol(procfile_lineword(ff, 0, 38+i));
-	// p->rt_priority	= strtoul(procfile_lineword(ff, 0, 39+i), NULL, 10);
-	// p->policy		= strtoul(procfile_lineword(ff, 0, 40+i), NULL, 10);
-	// p->delayacct_blkio_ticks		= strtoull(procfile_lineword(ff, 0, 41+i), NULL, 10);
-	// p->guest_time	= strtoull(procfile_lineword(ff, 0, 42+i), NULL, 10);
-	// p->cguest_time	= strtoull(procfile_lineword(ff, 0, 43), NULL, 10);
+	for(s++; s < e && blen < MAX_COMPARE_NAME ; s++)
+		if(!isspace(*s)) p->comm[blen++] = *s;
+	p->comm[blen] = '\0';
+
+	// skip the state
+	s = e + 1;
+	while(isspace(*s)) s++;
+	if(*s) s++;
+
+	// the values are separated by spaces, strtoull() skips them
+	unsigned long long values[22];
+	int i;
+	for(i = 0; i < 22 ; i++) values[i] = strtoull(s, &s, 10);
+
+	// values[0] is the ppid, field (4) in man proc
+	p->ppid				= (int32_t) values[0];
+	// p->pgrp			= values[1];
+	// p->session		= values[2];
+	// p->tty_nr		= values[3];
+	// p->tpgid			= values[4];
+	// p->flags			= values[5];
+	p->minflt			= values[6];
+	p->cminflt			= values[7];
+	p->majflt			= values[8];
+	p->cmajflt			= values[9];
+	p->utime			= values[10];
+	p->stime			= values[11];
+	p->cutime			= values[12];
+	p->cstime			= values[13];
+	// p->priority		= values[14];
+	// p->nice			= values[15];
+	p->num_threads		= (int32_t) values[16];
+	// p->itrealvalue	= values[17];
+	// p->starttime		= values[18];
+	// p->vsize			= values[19];
+	p->rss				= values[20];
 
 	if(debug || (p->target && p->target->debug)) fprintf(stderr, "apps.plugin: VALUES: %s utime=%llu, stime=%llu, cutime=%llu, cstime=%llu, minflt=%llu, majflt=%llu, cminflt=%llu, cmajflt=%llu, threads=%d\n", p->comm, p->utime, p->stime, p->cutime, p->cstime, p->minflt, p->majflt, p->cminflt, p->cmajflt, p->num_threads);
 
-	// procfile_close(ff);
 	return 0;
 }
 
 int read_proc_pid_statm(struct pid_stat *p) {
-	char filename[FILENAME_MAX + 1];
-
-	snprintf(filename, FILENAME_MAX, "%s/proc/%d/statm", host_prefix, p->pid);
+	char buffer[PROC_PID_FILE_BUFFER], *s = buffer;
 
-	ff = procfile_reopen(ff, filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-	if(!ff) return 1;
-
-	ff = procfile_readall(ff);
-	if(!ff) {
-		// procfile_close(ff);
+	if(read_proc_pid_file(p, &p->statm_fd, "statm", buffer, PROC_PID_FILE_BUFFER) == -1)
 		return 1;
-	}
 
-	file_counter++;
-
-	p->statm_size			= strtoull(procfile_lineword(ff, 0, 0), NULL, 10);
-	p->statm_resident		= strtoull(procfile_lineword(ff, 0, 1), NULL, 10);
-	p->statm_share			= strtoull(procfile_lineword(ff, 0, 2), NULL, 10);
-	p->statm_text			= strtoull(procfile_lineword(ff, 0, 3), NULL, 10);
-	p->statm_lib			= strtoull(procfile_lineword(ff, 0, 4), NULL, 10);
-	p->statm_data			= strtoull(procfile_lineword(ff, 0, 5), NULL, 10);
-	p->statm_dirty			= strtoull(procfile_lineword(ff, 0, 6), NULL, 10);
+	p->statm_size			= strtoull(s, &s, 10);
+	p->statm_resident		= strtoull(s, &s, 10);
+	p->statm_share			= strtoull(s, &s, 10);
+	p->statm_text			= strtoull(s, &s, 10);
+	p->statm_lib			= strtoull(s, &s, 10);
+	p->statm_data			= strtoull(s, &s, 10);
+	p->statm_dirty			= strtoull(s, &s, 10);
 
-	// procfile_close(ff);
 	return 0;
 }
 
-int read_proc_pid_io(struct pid_stat *p) {
-	char filename[FILENAME_MAX + 1];
+// returns the value of the next 'name: value' line
+static inline unsigned long long proc_pid_io_value(char **s) {
+	char *colon = strchr(*s, ':');
+	if(!colon) return 0;
 
-	snprintf(filename, FILENAME_MAX, "%s/proc/%d/io", host_prefix, p->pid);
+	return strtoull(colon + 1, s, 10);
+}
 
-	ff = procfile_reopen(ff, filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-	if(!ff) return 1;
+int read_proc_pid_io(struct pid_stat *p) {
+	char buffer[PROC_PID_FILE_BUFFER], *s = buffer;
 
-	ff = procfile_readall(ff);
-	if(!ff) {
-		// procfile_close(ff);
+	if(read_proc_pid_file(p, &p->io_fd, "io", buffer, PROC_PID_FILE_BUFFER) == -1)
 		return 1;
-	}
 
-	file_counter++;
-
-	p->io_logical_bytes_read 		= strtoull(procfile_lineword(ff, 0, 1), NULL, 10);
-	p->io_logical_bytes_written 	= strtoull(procfile_lineword(ff, 1, 1), NULL, 10);
-	p->io_read_calls 				= strtoull(procfile_lineword(ff, 2, 1), NULL, 10);
-	p->io_write_calls 				= strtoull(procfile_lineword(ff, 3, 1), NULL, 10);
-	p->io_storage_bytes_read 		= strtoull(procfile_lineword(ff, 4, 1), NULL, 10);
-	p->io_storage_bytes_written 	= strtoull(procfile_lineword(ff, 5, 1), NULL, 10);
-	p->io_cancelled_write_bytes		= strtoull(procfile_lineword(ff, 6, 1), NULL, 10);
+	p->io_logical_bytes_read 		= proc_pid_io_value(&s);
+	p->io_logical_bytes_written 	= proc_pid_io_value(&s);
+	p->io_read_calls 				= proc_pid_io_value(&s);
+	p->io_write_calls 				= proc_pid_io_value(&s);
+	p->io_storage_bytes_read 		= proc_pid_io_value(&s);
+	p->io_storage_bytes_written 	= proc_pid_io_value(&s);
+	p->io_cancelled_write_bytes		= proc_pid_io_value(&s);
 
-	// procfile_close(ff);
 	return 0;
 }
 
@@ -1044,6 +1143,9 @@ int file_descriptor_find_or_add(const char *name)
 int update_from_proc(void)
 {
 	static long count_errors = 0;
+	static pid_t self = 0;
+
+	if(!self) self = getpid();
 
 	char filename[FILENAME_MAX+1];
 	char dirname[FILENAME_MAX + 1];
@@ -1131,8 +1233,12 @@ int update_from_proc(void)
 		// --------------------------------------------------------------------
 		// /proc/<pid>/fd
 
-		snprintf(filename, FILENAME_MAX, "%s/proc/%s/fd", host_prefix, file->d_name);
-		DIR *fds = opendir(filename);
+		DIR *fds = p->fds_dir;
+		if(fds) rewinddir(fds);
+		else {
+			snprintf(filename, FILENAME_MAX, "%s/proc/%s/fd", host_prefix, file->d_name);
+			fds = opendir(filename);
+		}
 		if(fds) {
 			int c;
 			struct dirent *de;
@@ -1165,10 +1271,13 @@ int update_from_proc(void)
 				if(p->fds[fdid] == 0) {
 					// we don't know this fd, get it
 
-					sprintf(fdname, "%s/proc/%s/fd/%s", host_prefix, file->d_name, de->d_name);
-					ssize_t l = readlink(fdname, linkname, FILENAME_MAX);
+					// do not report the files we keep open
+					if(p->pid == self && kept_open_file(fdid)) continue;
+
+					ssize_t l = readlinkat(dirfd(fds), de->d_name, linkname, FILENAME_MAX);
 					if(l == -1) {
 						if(debug || (p->target && p->target->debug)) {
+							snprintf(fdname, FILENAME_MAX, "%s/proc/%s/fd/%s", host_prefix, file->d_name, de->d_name);
 							if(!count_errors++ || debug || (p->target && p->target->debug))
 								error("Cannot read link %s", fdname);
 						}
@@ -1187,7 +1296,10 @@ int update_from_proc(void)
 				// FIXME: we could compare the inode as returned by readdir direct structure
 				else p->fds[fdid] = -p->fds[fdid];
 			}
-			closedir(fds);
+			if(fds != p->fds_dir) {
+				if(keep_open_file(dirfd(fds))) p->fds_dir = fds;
+				else closedir(fds);
+			}
 
 			// remove all the negative file descriptors
 			for(c = 0 ; c < p->fds_size ; c++) if(p->fds[c] < 0) {
@@ -1964,6 +2076,8 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	set_kept_open_files_max();
+
 	unsigned long long counter = 1;
 	unsigned long long usec = 0, susec = 0;
 	struct timeval last, now;
@@ -0,0 +1,335 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "appconfig.h"
+#include "log.h"
+#include "rrd.h"
+#include "rrd2json.h"
+#include "web_buffer.h"
+#include "main.h"
+#include "backends.h"
+
+volatile int backends_enabled = 0;
+
+static int backend_type = BACKEND_TYPE_GRAPHITE;
+static const char *backend_prefix = "netdata";
+static size_t backend_max_buffered_bytes = BACKEND_DEFAULT_MAX_BUFFERED_BYTES;
+
+// the values formatted by rrdset_done(), not given to the backends thread yet
+static BUFFER *backend_pending = NULL;
+static pthread_mutex_t backend_pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// the values dropped because the buffer was full
+static unsigned long long backend_lost_bytes = 0;
+
+void backends_lock(void)
+{
+	pthread_mutex_lock(&backend_pending_mutex);
+}
+
+void backends_unlock(void)
+{
+	pthread_mutex_unlock(&backend_pending_mutex);
+}
+
+// ----------------------------------------------------------------------------
+// line protocols
+
+// append a name, replacing the characters backends do not accept
+static inline void backend_name(BUFFER *b, const char *s, int keep_dots)
+{
+	buffer_need_bytes(b, strlen(s) + 1);
+
+	char *d = &b->buffer[b->len];
+	for( ; *s ; s++, d++) {
+		if(isalnum(*s) || *s == '-' || *s == '_' || (*s == '.' && keep_dots)) *d = *s;
+		else *d = '_';
+	}
+	*d = '\0';
+
+	b->len = d - b->buffer;
+}
+
+// the caller holds the backends lock
+void backends_store(RRDSET *st, RRDDIM *rd, time_t t, calculated_number value)
+{
+	BUFFER *b = backend_pending;
+
+	// the backends thread is stuck, drop the oldest data
+	if(unlikely(b->len > backend_max_buffered_bytes)) {
+		backend_lost_bytes += b->len;
+		buffer_flush(b);
+	}
+
+	switch(backend_type) {
+		case BACKEND_TYPE_OPENTSDB:
+			// put prefix.chart.dimension timestamp value host=hostname
+			buffer_strcat(b, "put ");
+			backend_name(b, backend_prefix, 1);
+			buffer_strcat(b, ".");
+			backend_name(b, st->id, 1);
+			buffer_strcat(b, ".");
+			backend_name(b, rd->id, 0);
+			buffer_sprintf(b, " %u " CALCULATED_NUMBER_FORMAT " host=", (unsigned int)t, value);
+			backend_name(b, hostname, 1);
+			buffer_strcat(b, "\n");
+			break;
+
+		case BACKEND_TYPE_GRAPHITE:
+		default:
+			// prefix.hostname.chart.dimension value timestamp
+			backend_name(b, backend_prefix, 1);
+			buffer_strcat(b, ".");
+			backend_name(b, hostname, 0);
+			buffer_strcat(b, ".");
+			backend_name(b, st->id, 1);
+			buffer_strcat(b, ".");
+			backend_name(b, rd->id, 0);
+			buffer_sprintf(b, " " CALCULATED_NUMBER_FORMAT " %u\n", value, (unsigned int)t);
+			break;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// the connection
+
+// destination is host or host:port, IPv6 addresses in brackets: [::1]:2003
+static int backend_connect(const char *destination, const char *default_port, int timeout_ms)
+{
+	char buffer[CONFIG_MAX_VALUE + 1];
+	strncpy(buffer, destination, CONFIG_MAX_VALUE);
+	buffer[CONFIG_MAX_VALUE] = '\0';
+
+	char *host = buffer, *port = NULL, *s;
+	if(*host == '[') {
+		host++;
+		s = strchr(host, ']');
+		if(s) {
+			*s++ = '\0';
+			if(*s == ':') port = s + 1;
+		}
+	}
+	else {
+		s = strrchr(host, ':');
+		if(s) {
+			*s = '\0';
+			port = s + 1;
+		}
+	}
+	if(!port || !*port) port = (char *)default_port;
+
+	struct addrinfo hints, *result, *ai;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	int r = getaddrinfo(host, port, &hints, &result);
+	if(r != 0) {
+		error("BACKEND: Cannot resolve '%s' port '%s': %s", host, port, gai_strerror(r));
+		return -1;
+	}
+
+	struct timeval tv;
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+	int sock = -1;
+	for(ai = result; ai ; ai = ai->ai_next) {
+		sock = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+		if(sock == -1) continue;
+
+		// on Linux, the send timeout applies to connect() too
+		if(setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0)
+			error("BACKEND: Cannot set the send timeout of the socket.");
+
+		if(connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) break;
+
+		close(sock);
+		sock = -1;
+	}
+	freeaddrinfo(result);
+
+	if(sock == -1) error("BACKEND: Cannot connect to '%s' port '%s'.", host, port);
+	else info("BACKEND: Connected to '%s' port '%s'.", host, port);
+
+	return sock;
+}
+
+// sends as much of the buffer as possible and removes it from the buffer
+// returns -1 if the connection has to be closed
+static int backend_send(int sock, BUFFER *b, unsigned long long *sent_bytes)
+{
+	size_t sent = 0;
+	int ret = 0;
+
+	while(sent < b->len) {
+		ssize_t bytes = send(sock, &b->buffer[sent], b->len - sent, MSG_NOSIGNAL);
+		if(bytes <= 0) {
+			if(bytes == -1 && errno == EINTR) continue;
+
+			error("BACKEND: Failed to send %zu bytes (sent %zu).", b->len, sent);
+			ret = -1;
+			break;
+		}
+		sent += bytes;
+	}
+
+	*sent_bytes += sent;
+
+	// keep what was not sent, to send it with the next connection
+	if(sent < b->len) memmove(b->buffer, &b->buffer[sent], b->len - sent);
+	b->len -= sent;
+	b->buffer[b->len] = '\0';
+
+	return ret;
+}
+
+// ----------------------------------------------------------------------------
+// the backends thread
+
+static unsigned long long backend_now_usec(void)
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec * 1000000ULL + now.tv_usec;
+}
+
+void *backends_main(void *ptr)
+{
+	if(ptr) { ; }
+
+	info("BACKENDS thread created with task id %d", gettid());
+
+	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
+		error("Cannot set pthread cancel type to DEFERRED.");
+
+	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
+		error("Cannot set pthread cancel state to ENABLE.");
+
+	const char *type = config_get("backend", "type", "graphite");
+	const char *default_port;
+	if(!strcmp(type, "graphite")) {
+		backend_type = BACKEND_TYPE_GRAPHITE;
+		default_port = "2003";
+	}
+	else if(!strcmp(type, "opentsdb")) {
+		backend_type = BACKEND_TYPE_OPENTSDB;
+		default_port = "4242";
+	}
+	else {
+		error("BACKEND: Unknown backend type '%s'. Supported are 'graphite' and 'opentsdb'. Disabling the backend.", type);
+		pthread_exit(NULL);
+		return NULL;
+	}
+
+	const char *destination = config_get("backend", "destination", "localhost");
+	backend_prefix = config_get("backend", "prefix", "netdata");
+
+	int update_every = (int) config_get_number("backend", "update every", BACKEND_DEFAULT_UPDATE_EVERY);
+	if(update_every < 1) update_every = 1;
+
+	int timeout_ms = (int) config_get_number("backend", "timeout ms", BACKEND_DEFAULT_TIMEOUT_MS);
+	if(timeout_ms < 1) timeout_ms = 1;
+
+	long long max_buffered = config_get_number("backend", "max buffered bytes", BACKEND_DEFAULT_MAX_BUFFERED_BYTES);
+	if(max_buffered < 4096) max_buffered = 4096;
+	backend_max_buffered_bytes = (size_t)max_buffered;
+
+	// the data collected by rrdset_done() are swapped with the data
+	// the thread sends, so that collection is never blocked by the network
+	BUFFER *sending = buffer_create(WEB_DATA_LENGTH_INCREASE_STEP);
+	backend_pending = buffer_create(WEB_DATA_LENGTH_INCREASE_STEP);
+	if(!sending || !backend_pending) fatal("BACKEND: Cannot allocate buffers.");
+
+	__sync_synchronize();
+	backends_enabled = 1;
+
+	int sock = -1;
+	unsigned long long sent_bytes, lost_bytes, last_lost_bytes = 0;
+	unsigned long long step = update_every * 1000000ULL;
+	unsigned long long now = backend_now_usec(), next = now - (now % step) + step;
+
+	RRDSET *st = NULL;
+
+	for(;;) {
+		// delay until it is our time to run
+		while((now = backend_now_usec()) < next)
+			usleep((useconds_t)(next - now));
+
+		while(backend_now_usec() > next)
+			next += step;
+
+		if(unlikely(netdata_exit)) break;
+
+		// take the data collected since the last time
+		backends_lock();
+		if(sending->len + backend_pending->len > backend_max_buffered_bytes) {
+			// the backend is not reachable for long, drop the oldest data
+			error("BACKEND: Dropping %zu bytes of data not sent to the backend.", sending->len);
+			backend_lost_bytes += sending->len;
+			buffer_flush(sending);
+		}
+
+		if(!sending->len) {
+			BUFFER *t = sending;
+			sending = backend_pending;
+			backend_pending = t;
+		}
+		else {
+			buffer_need_bytes(sending, backend_pending->len + 1);
+			memcpy(&sending->buffer[sending->len], backend_pending->buffer, backend_pending->len + 1);
+			sending->len += backend_pending->len;
+			buffer_flush(backend_pending);
+		}
+
+		lost_bytes = backend_lost_bytes - last_lost_bytes;
+		last_lost_bytes = backend_lost_bytes;
+		backends_unlock();
+
+		// send them
+		sent_bytes = 0;
+		if(sending->len) {
+			if(sock == -1) sock = backend_connect(destination, default_port, timeout_ms);
+			if(sock != -1 && backend_send(sock, sending, &sent_bytes) == -1) {
+				// it will reconnect and send the rest the next time
+				close(sock);
+				sock = -1;
+			}
+		}
+
+		// --------------------------------------------------------------------
+
+		if(!st) st = rrdset_find("netdata.backend");
+		if(!st) {
+			st = rrdset_create("netdata", "backend", NULL, "backend", NULL, "NetData Backend Data Size", "KB", 130600, update_every, RRDSET_TYPE_LINE);
+
+			rrddim_add(st, "buffered", NULL, 1, 1024, RRDDIM_ABSOLUTE);
+			rrddim_add(st, "sent", NULL, 1, 1024, RRDDIM_ABSOLUTE);
+			rrddim_add(st, "lost", NULL, 1, 1024, RRDDIM_ABSOLUTE);
+		}
+		else rrdset_next(st);
+
+		rrddim_set(st, "buffered", sending->len);
+		rrddim_set(st, "sent", sent_bytes);
+		rrddim_set(st, "lost", lost_bytes);
+		rrdset_done(st);
+	}
+
+	backends_enabled = 0;
+	if(sock != -1) close(sock);
+
+	pthread_exit(NULL);
+	return NULL;
+}
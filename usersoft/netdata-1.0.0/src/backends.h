@@ -0,0 +1,34 @@
+#include <time.h>
+
+#include "rrd.h"
+
+#ifndef NETDATA_BACKENDS_H
+#define NETDATA_BACKENDS_H 1
+
+// ----------------------------------------------------------------------------
+// backends
+//
+// the values stored by rrdset_done() are formatted in a line protocol
+// and buffered. The backends thread sends the buffer to a remote time
+// series database (graphite or opentsdb) over a persistent TCP connection.
+// When the backend is not reachable, the data are kept and sent later,
+// up to a maximum buffer size. Above it, the oldest data are dropped.
+
+#define BACKEND_TYPE_GRAPHITE 1
+#define BACKEND_TYPE_OPENTSDB 2
+
+#define BACKEND_DEFAULT_UPDATE_EVERY 10
+#define BACKEND_DEFAULT_TIMEOUT_MS 5000
+#define BACKEND_DEFAULT_MAX_BUFFERED_BYTES (10 * 1024 * 1024)
+
+// set when rrdset_done() has to give its values to the backend
+extern volatile int backends_enabled;
+
+// rrdset_done() holds the lock while it stores the values of a chart
+extern void backends_lock(void);
+extern void backends_unlock(void);
+extern void backends_store(RRDSET *st, RRDDIM *rd, time_t t, calculated_number value);
+
+extern void *backends_main(void *ptr);
+
+#endif /* NETDATA_BACKENDS_H */
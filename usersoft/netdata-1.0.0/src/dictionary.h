@@ -1,11 +1,10 @@
+#include "hash_index.h"
 #include "web_buffer.h"
 
 #ifndef NETDATA_DICTIONARY_H
 #define NETDATA_DICTIONARY_H 1
 
 typedef struct name_value {
-	avl avl;				// the index - this has to be first!
-
 	uint32_t hash;			// a simple hash to speed up searching
 							// we first compare hashes, and only if the hashes are equal we do string comparisons
 
@@ -17,8 +16,8 @@ typedef struct name_value {
 
 typedef struct dictionary {
 	NAME_VALUE *values;
-	avl_tree values_index;
-	pthread_rwlock_t rwlock;
+	hash_index values_index;	// lookups do not lock
+	pthread_mutex_t mutex;		// serializes changes
 } DICTIONARY;
 
 extern DICTIONARY *dictionary_create(void);
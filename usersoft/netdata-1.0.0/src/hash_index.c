@@ -0,0 +1,176 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+#include "hash_index.h"
+
+// ----------------------------------------------------------------------------
+// tables
+
+static HASH_INDEX_TABLE *hash_index_table_create(uint32_t size) {
+	HASH_INDEX_TABLE *table = calloc(1, sizeof(HASH_INDEX_TABLE) + size * sizeof(HASH_INDEX_ENTRY *));
+	if(!table) fatal("Cannot allocate hash index table of %u buckets.", size);
+
+	table->mask = size - 1;
+	return table;
+}
+
+static HASH_INDEX_ENTRY *hash_index_entry_create(uint32_t hash, const char *key, void *item) {
+	size_t len = strlen(key);
+
+	HASH_INDEX_ENTRY *e = malloc(sizeof(HASH_INDEX_ENTRY) + len + 1);
+	if(!e) fatal("Cannot allocate hash index entry for '%s'.", key);
+
+	e->next = NULL;
+	e->retired = NULL;
+	e->hash = hash;
+	e->item = item;
+	memcpy(e->key, key, len + 1);
+
+	return e;
+}
+
+// copy all entries to a table with double the buckets, then switch readers to it
+// the entries of the old table are left intact for the readers still walking it
+static void hash_index_grow(hash_index *t) {
+	HASH_INDEX_TABLE *old = t->table;
+	HASH_INDEX_TABLE *table = hash_index_table_create((old->mask + 1) * 2);
+
+	uint32_t i;
+	for(i = 0; i <= old->mask ; i++) {
+		HASH_INDEX_ENTRY *e;
+		for(e = old->buckets[i]; e ; e = e->next) {
+			HASH_INDEX_ENTRY *n = hash_index_entry_create(e->hash, e->key, e->item);
+			n->next = table->buckets[n->hash & table->mask];
+			table->buckets[n->hash & table->mask] = n;
+
+			e->retired = t->retired_entries;
+			t->retired_entries = e;
+		}
+	}
+
+	debug(D_DICTIONARY, "Hash index grew from %u to %u buckets, for %zu entries.", old->mask + 1, table->mask + 1, t->entries);
+
+	__sync_synchronize();
+	t->table = table;
+
+	old->retired = t->retired_tables;
+	t->retired_tables = old;
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+void hash_index_init(hash_index *t) {
+	t->table = NULL;
+	t->entries = 0;
+	pthread_mutex_init(&t->mutex, NULL);
+	t->retired_tables = NULL;
+	t->retired_entries = NULL;
+}
+
+void hash_index_destroy(hash_index *t) {
+	pthread_mutex_lock(&t->mutex);
+
+	if(t->table) {
+		uint32_t i;
+		for(i = 0; i <= t->table->mask ; i++) {
+			HASH_INDEX_ENTRY *e = t->table->buckets[i];
+			while(e) {
+				HASH_INDEX_ENTRY *next = e->next;
+				free(e);
+				e = next;
+			}
+		}
+		free(t->table);
+		t->table = NULL;
+	}
+
+	while(t->retired_entries) {
+		HASH_INDEX_ENTRY *e = t->retired_entries;
+		t->retired_entries = e->retired;
+		free(e);
+	}
+
+	while(t->retired_tables) {
+		HASH_INDEX_TABLE *table = t->retired_tables;
+		t->retired_tables = table->retired;
+		free(table);
+	}
+
+	t->entries = 0;
+
+	pthread_mutex_unlock(&t->mutex);
+}
+
+void *hash_index_add(hash_index *t, uint32_t hash, const char *key, void *item) {
+	pthread_mutex_lock(&t->mutex);
+
+	void *found = hash_index_find(t, hash, key);
+	if(unlikely(found)) {
+		pthread_mutex_unlock(&t->mutex);
+		return found;
+	}
+
+	if(unlikely(!t->table))
+		t->table = hash_index_table_create(HASH_INDEX_INITIAL_SIZE);
+
+	else if(unlikely(t->entries > t->table->mask))
+		hash_index_grow(t);
+
+	HASH_INDEX_TABLE *table = t->table;
+	HASH_INDEX_ENTRY *e = hash_index_entry_create(hash, key, item);
+	e->next = table->buckets[hash & table->mask];
+
+	// the entry has to be complete before readers can reach it
+	__sync_synchronize();
+	table->buckets[hash & table->mask] = e;
+	t->entries++;
+
+	pthread_mutex_unlock(&t->mutex);
+	return item;
+}
+
+void *hash_index_del(hash_index *t, uint32_t hash, void *item) {
+	pthread_mutex_lock(&t->mutex);
+
+	HASH_INDEX_TABLE *table = t->table;
+	if(unlikely(!table)) {
+		pthread_mutex_unlock(&t->mutex);
+		return NULL;
+	}
+
+	HASH_INDEX_ENTRY * volatile *prev = &table->buckets[hash & table->mask];
+	HASH_INDEX_ENTRY *e;
+	for(e = *prev; e ; prev = &e->next, e = e->next) {
+		if(e->item == item) {
+			// readers standing on e still find the rest of the chain
+			*prev = e->next;
+
+			e->retired = t->retired_entries;
+			t->retired_entries = e;
+			t->entries--;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&t->mutex);
+	return (e)?item:NULL;
+}
+
+void *hash_index_find(hash_index *t, uint32_t hash, const char *key) {
+	HASH_INDEX_TABLE *table = t->table;
+	if(unlikely(!table)) return NULL;
+
+	HASH_INDEX_ENTRY *e;
+	for(e = table->buckets[hash & table->mask]; e ; e = e->next)
+		if(e->hash == hash && !strcmp(e->key, key))
+			return e->item;
+
+	return NULL;
+}
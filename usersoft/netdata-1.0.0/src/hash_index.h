@@ -0,0 +1,62 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef NETDATA_HASH_INDEX_H
+#define NETDATA_HASH_INDEX_H 1
+
+// ----------------------------------------------------------------------------
+// concurrent hash index
+//
+// indexes items by a string key and its precomputed simple_hash().
+//
+// lookups do not take any lock: writers prepare every change aside and
+// publish it with a single pointer store, so readers always walk a
+// consistent chain (RCU style). Writers are serialized with a mutex.
+//
+// entries removed and tables replaced while growing may still be walked
+// by readers, so they are not freed immediately. They are retired and
+// freed when the index is destroyed. Items are rarely removed and the
+// tables grow by doubling, so this is bounded by the size of the index.
+
+#define HASH_INDEX_INITIAL_SIZE 16 // must be a power of 2
+
+typedef struct hash_index_entry {
+	struct hash_index_entry * volatile next;		// the next entry in the bucket
+	struct hash_index_entry *retired;				// the next retired entry
+
+	uint32_t hash;
+	void *item;
+	char key[];										// a copy of the key, so that lookups never touch the items
+} HASH_INDEX_ENTRY;
+
+typedef struct hash_index_table {
+	uint32_t mask;									// the number of buckets - 1
+	struct hash_index_table *retired;				// the next retired table
+	HASH_INDEX_ENTRY * volatile buckets[];
+} HASH_INDEX_TABLE;
+
+typedef struct hash_index {
+	HASH_INDEX_TABLE * volatile table;				// allocated on the first insert
+
+	size_t entries;
+	pthread_mutex_t mutex;							// serializes writers
+
+	HASH_INDEX_TABLE *retired_tables;
+	HASH_INDEX_ENTRY *retired_entries;
+} hash_index;
+
+#define HASH_INDEX_INITIALIZER { NULL, 0, PTHREAD_MUTEX_INITIALIZER, NULL, NULL }
+
+extern void hash_index_init(hash_index *t);
+extern void hash_index_destroy(hash_index *t);
+
+// returns item, or the item already indexed with the same key
+extern void *hash_index_add(hash_index *t, uint32_t hash, const char *key, void *item);
+
+// returns item, or NULL if it is not indexed with this hash
+extern void *hash_index_del(hash_index *t, uint32_t hash, void *item);
+
+extern void *hash_index_find(hash_index *t, uint32_t hash, const char *key);
+
+#endif /* NETDATA_HASH_INDEX_H */
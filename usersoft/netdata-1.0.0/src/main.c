@@ -33,6 +33,7 @@
 #include "plugin_checks.h"
 #include "plugin_proc.h"
 #include "plugin_nfacct.h"
+#include "backends.h"
 
 #include "main.h"
 
@@ -75,6 +76,7 @@ struct netdata_static_thread static_threads[] = {
 
 	{"plugins.d",	NULL,		NULL,			1, NULL, NULL,	pluginsd_main},
 	{"check",		"plugins",	"checks",		0, NULL, NULL,	checks_main},
+	{"backends",	"backend",	"enabled",		0, NULL, NULL,	backends_main},
 	{"web",			NULL,		NULL,			1, NULL, NULL,	socket_listen_main},
 	{NULL,			NULL,		NULL,			0, NULL, NULL,	NULL}
 };
@@ -139,12 +141,7 @@ void kill_childs()
 {
 	siginfo_t info;
 
-	struct web_client *w;
-	for(w = web_clients; w ; w = w->next) {
-		debug(D_EXIT, "Stopping web client %s", w->client_ip);
-		pthread_cancel(w->thread);
-		pthread_join(w->thread, NULL);
-	}
+	web_server_threads_cancel();
 
 	int i;
 	for (i = 0; static_threads[i].name != NULL ; i++) {
@@ -219,7 +216,9 @@ int main(int argc, char **argv)
 		else if(strcmp(argv[i], "--unittest")  == 0) {
 			rrd_update_every = 1;
 			if(run_all_mockup_tests()) exit(1);
+			if(unit_test_hash_index()) exit(1);
 			if(unit_test_storage()) exit(1);
+			if(unit_test_tiers()) exit(1);
 			fprintf(stderr, "\n\nALL TESTS PASSED\n\n");
 			exit(0);
 		}
@@ -335,6 +334,7 @@ int main(int argc, char **argv)
 		// --------------------------------------------------------------------
 
 		rrd_memory_mode = rrd_memory_mode_id(config_get("global", "memory mode", rrd_memory_mode_name(rrd_memory_mode)));
+		rrd_tiers_init();
 
 		// --------------------------------------------------------------------
 
@@ -2,6 +2,7 @@
 #include <config.h>
 #endif
 #include <pthread.h>
+#include <stdlib.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <strings.h>
@@ -21,11 +22,118 @@ unsigned long long sutime() {
 	return now.tv_sec * 1000000ULL + now.tv_usec;
 }
 
-void *proc_main(void *ptr)
+// ----------------------------------------------------------------------------
+// the proc modules
+//
+// each module is called on every rrd_update_every boundary, on a small pool
+// of worker threads, so that a slow module (e.g. diskstats with many disks)
+// does not delay the timestamps of the others.
+// a module still running when its next boundary comes is not queued again.
+// it skips this boundary and runs on the first one after it finishes, so
+// slow modules adapt their interval to the time they need.
+
+struct proc_module {
+	const char *name;						// the config option enabling it
+	const char *dim;						// its dimension on the plugin charts
+	int (*func)(int update_every, unsigned long long dt);
+
+	int enabled;
+	volatile int running;					// 1 while it is queued or running
+
+	unsigned long long suscheduled;			// the boundary it was queued for
+	unsigned long long sutime;				// when it last started
+	unsigned long long lag;					// how late it started, after its boundary
+	unsigned long long duration;			// how long it ran
+	unsigned long long skipped;				// boundaries skipped while it was still running
+
+	RRDDIM *rd_lag;
+	RRDDIM *rd_duration;
+
+	struct proc_module *next;				// the next module in the queue
+} proc_modules[] = {
+	{ "/sys/kernel/mm/ksm",						"ksm",			do_sys_kernel_mm_ksm },
+	{ "/proc/loadavg",							"loadavg",		do_proc_loadavg },
+	{ "/proc/interrupts",						"interrupts",	do_proc_interrupts },
+	{ "/proc/softirqs",							"softirqs",		do_proc_softirqs },
+	{ "/proc/sys/kernel/random/entropy_avail",	"entropy",		do_proc_sys_kernel_random_entropy_avail },
+	{ "/proc/net/dev",							"net_dev",		do_proc_net_dev },
+	{ "/proc/diskstats",						"diskstats",	do_proc_diskstats },
+	{ "/proc/net/snmp",							"snmp",			do_proc_net_snmp },
+	{ "/proc/net/netstat",						"netstat",		do_proc_net_netstat },
+	{ "/proc/net/stat/conntrack",				"conntrack",	do_proc_net_stat_conntrack },
+	{ "/proc/net/ip_vs/stats",					"ip_vs",		do_proc_net_ip_vs_stats },
+	{ "/proc/stat",								"stat",			do_proc_stat },
+	{ "/proc/meminfo",							"meminfo",		do_proc_meminfo },
+	{ "/proc/vmstat",							"vmstat",		do_proc_vmstat },
+	{ "/proc/net/rpc/nfsd",						"nfsd",			do_proc_net_rpc_nfsd },
+
+	// terminator
+	{ NULL, NULL, NULL }
+};
+
+// ----------------------------------------------------------------------------
+// the workers
+
+struct proc_worker {
+	int id;
+	pthread_t thread;
+
+	// the cpu time of this thread, updated after every module
+	volatile unsigned long long utime;
+	volatile unsigned long long stime;
+};
+
+int proc_threads = PROC_THREADS;
+static struct proc_worker *proc_workers = NULL;
+
+static pthread_mutex_t proc_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t proc_queue_cond = PTHREAD_COND_INITIALIZER;
+static struct proc_module *proc_queue_head = NULL, *proc_queue_tail = NULL;
+
+static void proc_queue_add(struct proc_module *m)
+{
+	pthread_mutex_lock(&proc_queue_mutex);
+
+	m->next = NULL;
+	if(proc_queue_tail) proc_queue_tail->next = m;
+	else proc_queue_head = m;
+	proc_queue_tail = m;
+
+	pthread_cond_signal(&proc_queue_cond);
+	pthread_mutex_unlock(&proc_queue_mutex);
+}
+
+static void proc_queue_unlock(void *ptr)
 {
 	if(ptr) { ; }
+	pthread_mutex_unlock(&proc_queue_mutex);
+}
 
-	info("PROC Plugin thread created with task id %d", gettid());
+// blocks until a module is queued
+static struct proc_module *proc_queue_get(void)
+{
+	struct proc_module *m;
+
+	pthread_mutex_lock(&proc_queue_mutex);
+	pthread_cleanup_push(proc_queue_unlock, NULL);
+
+	while(!proc_queue_head)
+		pthread_cond_wait(&proc_queue_cond, &proc_queue_mutex);
+
+	m = proc_queue_head;
+	proc_queue_head = m->next;
+	if(!proc_queue_head) proc_queue_tail = NULL;
+
+	pthread_cleanup_pop(1);
+	return m;
+}
+
+static void *proc_worker_main(void *ptr)
+{
+	struct proc_worker *wk = ptr;
+	struct rusage thread;
+
+	info("PROC Plugin worker %d thread created with task id %d", wk->id, gettid());
 
 	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
 		error("Cannot set pthread cancel type to DEFERRED.");
@@ -33,190 +141,129 @@ void *proc_main(void *ptr)
 	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
 		error("Cannot set pthread cancel state to ENABLE.");
 
-	struct rusage me, thread;
+	for(;;) {
+		struct proc_module *m = proc_queue_get();
 
-	// disable (by default) various interface that are not needed
-	config_get_boolean("plugin:proc:/proc/net/dev:lo", "enabled", 0);
-	config_get_boolean("plugin:proc:/proc/net/dev:fireqos_monitor", "enabled", 0);
+		debug(D_PROCNETDEV_LOOP, "PROCNETDEV: worker %d calling the module of %s.", wk->id, m->name);
 
-	// when ZERO, attempt to do it
-	int vdo_proc_net_dev 			= !config_get_boolean("plugin:proc", "/proc/net/dev", 1);
-	int vdo_proc_diskstats 			= !config_get_boolean("plugin:proc", "/proc/diskstats", 1);
-	int vdo_proc_net_snmp 			= !config_get_boolean("plugin:proc", "/proc/net/snmp", 1);
-	int vdo_proc_net_netstat 		= !config_get_boolean("plugin:proc", "/proc/net/netstat", 1);
-	int vdo_proc_net_stat_conntrack = !config_get_boolean("plugin:proc", "/proc/net/stat/conntrack", 1);
-	int vdo_proc_net_ip_vs_stats 	= !config_get_boolean("plugin:proc", "/proc/net/ip_vs/stats", 1);
-	int vdo_proc_stat 				= !config_get_boolean("plugin:proc", "/proc/stat", 1);
-	int vdo_proc_meminfo 			= !config_get_boolean("plugin:proc", "/proc/meminfo", 1);
-	int vdo_proc_vmstat 			= !config_get_boolean("plugin:proc", "/proc/vmstat", 1);
-	int vdo_proc_net_rpc_nfsd		= !config_get_boolean("plugin:proc", "/proc/net/rpc/nfsd", 1);
-	int vdo_proc_sys_kernel_random_entropy_avail	= !config_get_boolean("plugin:proc", "/proc/sys/kernel/random/entropy_avail", 1);
-	int vdo_proc_interrupts			= !config_get_boolean("plugin:proc", "/proc/interrupts", 1);
-	int vdo_proc_softirqs			= !config_get_boolean("plugin:proc", "/proc/softirqs", 1);
-	int vdo_proc_loadavg			= !config_get_boolean("plugin:proc", "/proc/loadavg", 1);
-	int vdo_sys_kernel_mm_ksm		= !config_get_boolean("plugin:proc", "/sys/kernel/mm/ksm", 1);
-	int vdo_cpu_netdata 			= !config_get_boolean("plugin:proc", "netdata server resources", 1);
-
-	// keep track of the time each module was called
-	unsigned long long sutime_proc_net_dev = 0ULL;
-	unsigned long long sutime_proc_diskstats = 0ULL;
-	unsigned long long sutime_proc_net_snmp = 0ULL;
-	unsigned long long sutime_proc_net_netstat = 0ULL;
-	unsigned long long sutime_proc_net_stat_conntrack = 0ULL;
-	unsigned long long sutime_proc_net_ip_vs_stats = 0ULL;
-	unsigned long long sutime_proc_stat = 0ULL;
-	unsigned long long sutime_proc_meminfo = 0ULL;
-	unsigned long long sutime_proc_vmstat = 0ULL;
-	unsigned long long sutime_proc_net_rpc_nfsd = 0ULL;
-	unsigned long long sutime_proc_sys_kernel_random_entropy_avail = 0ULL;
-	unsigned long long sutime_proc_interrupts = 0ULL;
-	unsigned long long sutime_proc_softirqs = 0ULL;
-	unsigned long long sutime_proc_loadavg = 0ULL;
-	unsigned long long sutime_sys_kernel_mm_ksm = 0ULL;
+		unsigned long long sunow = sutime();
+		m->lag = (sunow > m->suscheduled)?sunow - m->suscheduled:0ULL;
 
-	// the next time we will run - aligned properly
-	unsigned long long sunext = (time(NULL) - (time(NULL) % rrd_update_every) + rrd_update_every) * 1000000ULL;
-	unsigned long long sunow;
+		// when non-zero, the module does not want to be called again
+		if(m->func(rrd_update_every, (m->sutime > 0)?sunow - m->sutime:0ULL))
+			m->enabled = 0;
 
-	RRDSET *stcpu = NULL, *stcpu_thread = NULL, *stclients = NULL, *streqs = NULL, *stbytes = NULL;
+		m->sutime = sunow;
+		m->duration = sutime() - sunow;
 
-	for(;1;) {
-		if(unlikely(netdata_exit)) break;
+		getrusage(RUSAGE_THREAD, &thread);
+		wk->utime = thread.ru_utime.tv_sec * 1000000ULL + thread.ru_utime.tv_usec;
+		wk->stime = thread.ru_stime.tv_sec * 1000000ULL + thread.ru_stime.tv_usec;
 
-		// delay until it is our time to run
-		while((sunow = sutime()) < sunext)
-			usleep((useconds_t)(sunext - sunow));
+		__sync_synchronize();
+		m->running = 0;
+	}
 
-		// find the next time we need to run
-		while(sutime() > sunext)
-			sunext += rrd_update_every * 1000000ULL;
+	return NULL;
+}
 
-		if(unlikely(netdata_exit)) break;
+static void proc_workers_cancel(void *ptr)
+{
+	int i;
 
-		// BEGIN -- the job to be done
+	if(ptr) { ; }
+	if(!proc_workers) return;
 
-		if(!vdo_sys_kernel_mm_ksm) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_sys_kernel_mm_ksm().");
+	for(i = 0; i < proc_threads ; i++) {
+		debug(D_EXIT, "Stopping proc plugin worker %d", i);
+		pthread_cancel(proc_workers[i].thread);
+		pthread_join(proc_workers[i].thread, NULL);
+	}
 
-			sunow = sutime();
-			vdo_sys_kernel_mm_ksm = do_sys_kernel_mm_ksm(rrd_update_every, (sutime_sys_kernel_mm_ksm > 0)?sunow - sutime_sys_kernel_mm_ksm:0ULL);
-			sutime_sys_kernel_mm_ksm = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	free(proc_workers);
+	proc_workers = NULL;
+}
 
-		if(!vdo_proc_loadavg) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_loadavg().");
-			sunow = sutime();
-			vdo_proc_loadavg = do_proc_loadavg(rrd_update_every, (sutime_proc_loadavg > 0)?sunow - sutime_proc_loadavg:0ULL);
-			sutime_proc_loadavg = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+// ----------------------------------------------------------------------------
+// the scheduler
 
-		if(!vdo_proc_interrupts) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_interrupts().");
-			sunow = sutime();
-			vdo_proc_interrupts = do_proc_interrupts(rrd_update_every, (sutime_proc_interrupts > 0)?sunow - sutime_proc_interrupts:0ULL);
-			sutime_proc_interrupts = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+void *proc_main(void *ptr)
+{
+	if(ptr) { ; }
 
-		if(!vdo_proc_softirqs) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_softirqs().");
-			sunow = sutime();
-			vdo_proc_softirqs = do_proc_softirqs(rrd_update_every, (sutime_proc_softirqs > 0)?sunow - sutime_proc_softirqs:0ULL);
-			sutime_proc_softirqs = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	info("PROC Plugin thread created with task id %d", gettid());
 
-		if(!vdo_proc_sys_kernel_random_entropy_avail) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_sys_kernel_random_entropy_avail().");
-			sunow = sutime();
-			vdo_proc_sys_kernel_random_entropy_avail = do_proc_sys_kernel_random_entropy_avail(rrd_update_every, (sutime_proc_sys_kernel_random_entropy_avail > 0)?sunow - sutime_proc_sys_kernel_random_entropy_avail:0ULL);
-			sutime_proc_sys_kernel_random_entropy_avail = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
+		error("Cannot set pthread cancel type to DEFERRED.");
 
-		if(!vdo_proc_net_dev) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_net_dev().");
-			sunow = sutime();
-			vdo_proc_net_dev = do_proc_net_dev(rrd_update_every, (sutime_proc_net_dev > 0)?sunow - sutime_proc_net_dev:0ULL);
-			sutime_proc_net_dev = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
+		error("Cannot set pthread cancel state to ENABLE.");
 
-		if(!vdo_proc_diskstats) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_diskstats().");
-			sunow = sutime();
-			vdo_proc_diskstats = do_proc_diskstats(rrd_update_every, (sutime_proc_diskstats > 0)?sunow - sutime_proc_diskstats:0ULL);
-			sutime_proc_diskstats = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	struct rusage me, thread;
+	struct proc_module *m;
+	int i, modules = 0;
 
-		if(!vdo_proc_net_snmp) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_net_snmp().");
-			sunow = sutime();
-			vdo_proc_net_snmp = do_proc_net_snmp(rrd_update_every, (sutime_proc_net_snmp > 0)?sunow - sutime_proc_net_snmp:0ULL);
-			sutime_proc_net_snmp = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	// disable (by default) various interface that are not needed
+	config_get_boolean("plugin:proc:/proc/net/dev:lo", "enabled", 0);
+	config_get_boolean("plugin:proc:/proc/net/dev:fireqos_monitor", "enabled", 0);
 
-		if(!vdo_proc_net_netstat) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_net_netstat().");
-			sunow = sutime();
-			vdo_proc_net_netstat = do_proc_net_netstat(rrd_update_every, (sutime_proc_net_netstat > 0)?sunow - sutime_proc_net_netstat:0ULL);
-			sutime_proc_net_netstat = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	for(m = proc_modules; m->name ; m++) {
+		m->enabled = config_get_boolean("plugin:proc", m->name, 1);
+		if(m->enabled) modules++;
+	}
+	int vdo_cpu_netdata = !config_get_boolean("plugin:proc", "netdata server resources", 1);
 
-		if(!vdo_proc_net_stat_conntrack) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_net_stat_conntrack().");
-			sunow = sutime();
-			vdo_proc_net_stat_conntrack	= do_proc_net_stat_conntrack(rrd_update_every, (sutime_proc_net_stat_conntrack > 0)?sunow - sutime_proc_net_stat_conntrack:0ULL);
-			sutime_proc_net_stat_conntrack = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	proc_threads = (int) config_get_number("plugin:proc", "threads", proc_threads);
+	if(proc_threads > modules) proc_threads = modules;
+	if(proc_threads < 1) proc_threads = 1;
 
-		if(!vdo_proc_net_ip_vs_stats) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling vdo_proc_net_ip_vs_stats().");
-			sunow = sutime();
-			vdo_proc_net_ip_vs_stats = do_proc_net_ip_vs_stats(rrd_update_every, (sutime_proc_net_ip_vs_stats > 0)?sunow - sutime_proc_net_ip_vs_stats:0ULL);
-			sutime_proc_net_ip_vs_stats = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	proc_workers = calloc(proc_threads, sizeof(struct proc_worker));
+	if(!proc_workers) fatal("PROC Plugin: Cannot allocate memory for %d workers.", proc_threads);
 
-		if(!vdo_proc_stat) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_stat().");
-			sunow = sutime();
-			vdo_proc_stat = do_proc_stat(rrd_update_every, (sutime_proc_stat > 0)?sunow - sutime_proc_stat:0ULL);
-			sutime_proc_stat = sunow;
-		}
-		if(unlikely(netdata_exit)) break;
+	for(i = 0; i < proc_threads ; i++) {
+		proc_workers[i].id = i;
+		if(pthread_create(&proc_workers[i].thread, NULL, proc_worker_main, &proc_workers[i]) != 0)
+			fatal("PROC Plugin: Cannot create thread for worker %d.", i);
+	}
 
-		if(!vdo_proc_meminfo) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling vdo_proc_meminfo().");
-			sunow = sutime();
-			vdo_proc_meminfo = do_proc_meminfo(rrd_update_every, (sutime_proc_meminfo > 0)?sunow - sutime_proc_meminfo:0ULL);
-			sutime_proc_meminfo = sunow;
-		}
+	pthread_cleanup_push(proc_workers_cancel, NULL);
+
+	// the next time we will run - aligned properly
+	unsigned long long sunext = (time(NULL) - (time(NULL) % rrd_update_every) + rrd_update_every) * 1000000ULL;
+	unsigned long long sunow;
+
+	RRDSET *stcpu = NULL, *stcpu_thread = NULL, *stclients = NULL, *streqs = NULL, *stbytes = NULL, *stlag = NULL, *stduration = NULL;
+
+	for(;1;) {
 		if(unlikely(netdata_exit)) break;
 
-		if(!vdo_proc_vmstat) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling vdo_proc_vmstat().");
-			sunow = sutime();
-			vdo_proc_vmstat = do_proc_vmstat(rrd_update_every, (sutime_proc_vmstat > 0)?sunow - sutime_proc_vmstat:0ULL);
-			sutime_proc_vmstat = sunow;
-		}
+		// delay until it is our time to run
+		while((sunow = sutime()) < sunext)
+			usleep((useconds_t)(sunext - sunow));
+
 		if(unlikely(netdata_exit)) break;
 
-		if(!vdo_proc_net_rpc_nfsd) {
-			debug(D_PROCNETDEV_LOOP, "PROCNETDEV: calling do_proc_net_rpc_nfsd().");
-			sunow = sutime();
-			vdo_proc_net_rpc_nfsd = do_proc_net_rpc_nfsd(rrd_update_every, (sutime_proc_net_rpc_nfsd > 0)?sunow - sutime_proc_net_rpc_nfsd:0ULL);
-			sutime_proc_net_rpc_nfsd = sunow;
+		// BEGIN -- queue the job to be done
+
+		for(m = proc_modules; m->name ; m++) {
+			if(!m->enabled) continue;
+
+			if(m->running) {
+				debug(D_PROCNETDEV_LOOP, "PROCNETDEV: the module of %s is still running, skipping it.", m->name);
+				m->skipped++;
+				continue;
+			}
+
+			m->running = 1;
+			m->suscheduled = sunext;
+			proc_queue_add(m);
 		}
-		if(unlikely(netdata_exit)) break;
 
-		// END -- the job is done
+		// END -- the job is queued
+
+		// find the next time we need to run
+		while(sutime() > sunext)
+			sunext += rrd_update_every * 1000000ULL;
 
 		// --------------------------------------------------------------------
 
@@ -224,6 +271,13 @@ void *proc_main(void *ptr)
 			getrusage(RUSAGE_THREAD, &thread);
 			getrusage(RUSAGE_SELF, &me);
 
+			unsigned long long utime = thread.ru_utime.tv_sec * 1000000ULL + thread.ru_utime.tv_usec;
+			unsigned long long stime = thread.ru_stime.tv_sec * 1000000ULL + thread.ru_stime.tv_usec;
+			for(i = 0; i < proc_threads ; i++) {
+				utime += proc_workers[i].utime;
+				stime += proc_workers[i].stime;
+			}
+
 			if(!stcpu_thread) stcpu_thread = rrdset_find("netdata.plugin_proc_cpu");
 			if(!stcpu_thread) {
 				stcpu_thread = rrdset_create("netdata", "plugin_proc_cpu", NULL, "proc.internal", NULL, "NetData Proc Plugin CPU usage", "milliseconds/s", 131000, rrd_update_every, RRDSET_TYPE_STACKED);
@@ -233,12 +287,42 @@ void *proc_main(void *ptr)
 			}
 			else rrdset_next(stcpu_thread);
 
-			rrddim_set(stcpu_thread, "user"  , thread.ru_utime.tv_sec * 1000000ULL + thread.ru_utime.tv_usec);
-			rrddim_set(stcpu_thread, "system", thread.ru_stime.tv_sec * 1000000ULL + thread.ru_stime.tv_usec);
+			rrddim_set(stcpu_thread, "user"  , utime);
+			rrddim_set(stcpu_thread, "system", stime);
 			rrdset_done(stcpu_thread);
 
 			// ----------------------------------------------------------------
 
+			if(!stlag) stlag = rrdset_find("netdata.plugin_proc_lag");
+			if(!stlag) {
+				stlag = rrdset_create("netdata", "plugin_proc_lag", NULL, "proc.internal", NULL, "NetData Proc Plugin Modules Start Delay", "milliseconds", 131010, rrd_update_every, RRDSET_TYPE_LINE);
+
+				for(m = proc_modules; m->name ; m++)
+					if(m->enabled) m->rd_lag = rrddim_add(stlag, m->dim, NULL, 1, 1000, RRDDIM_ABSOLUTE);
+			}
+			else rrdset_next(stlag);
+
+			for(m = proc_modules; m->name ; m++)
+				if(m->rd_lag && m->enabled) rrddim_set_by_pointer(stlag, m->rd_lag, m->lag);
+			rrdset_done(stlag);
+
+			// ----------------------------------------------------------------
+
+			if(!stduration) stduration = rrdset_find("netdata.plugin_proc_duration");
+			if(!stduration) {
+				stduration = rrdset_create("netdata", "plugin_proc_duration", NULL, "proc.internal", NULL, "NetData Proc Plugin Modules Duration", "milliseconds", 131020, rrd_update_every, RRDSET_TYPE_STACKED);
+
+				for(m = proc_modules; m->name ; m++)
+					if(m->enabled) m->rd_duration = rrddim_add(stduration, m->dim, NULL, 1, 1000, RRDDIM_ABSOLUTE);
+			}
+			else rrdset_next(stduration);
+
+			for(m = proc_modules; m->name ; m++)
+				if(m->rd_duration && m->enabled) rrddim_set_by_pointer(stduration, m->rd_duration, m->duration);
+			rrdset_done(stduration);
+
+			// ----------------------------------------------------------------
+
 			if(!stcpu) stcpu = rrdset_find("netdata.server_cpu");
 			if(!stcpu) {
 				stcpu = rrdset_create("netdata", "server_cpu", NULL, "netdata", NULL, "NetData CPU usage", "milliseconds/s", 130000, rrd_update_every, RRDSET_TYPE_STACKED);
@@ -295,6 +379,8 @@ void *proc_main(void *ptr)
 		}
 	}
 
+	pthread_cleanup_pop(1);
+
 	pthread_exit(NULL);
 	return NULL;
 }
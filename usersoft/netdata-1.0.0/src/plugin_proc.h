@@ -1,6 +1,10 @@
 #ifndef NETDATA_PLUGIN_PROC_H
 #define NETDATA_PLUGIN_PROC_H 1
 
+#define PROC_THREADS 2
+
+extern int proc_threads;
+
 void *proc_main(void *ptr);
 
 extern int do_proc_net_dev(int update_every, unsigned long long dt);
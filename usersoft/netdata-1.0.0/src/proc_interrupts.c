@@ -17,18 +17,42 @@
 #define MAX_INTERRUPT_CPUS 256
 #define MAX_INTERRUPT_NAME 50
 
+struct cpu_interrupt {
+	unsigned long long value;
+	RRDDIM *rd;							// the dimension of this line, on the chart of this core
+};
+
 struct interrupt {
 	int used;
-	char *id;
+	char id[MAX_INTERRUPT_NAME + 1];	// the id of this line, the dimensions below are bound to it
 	char name[MAX_INTERRUPT_NAME + 1];
-	unsigned long long value[MAX_INTERRUPT_CPUS];
+	RRDDIM *rd;							// the dimension of this line, on the system chart
 	unsigned long long total;
+	struct cpu_interrupt cpu[];
 };
 
+// each line has as many cpu entries as the cpus found
+#define interrupt_size(cpus) (sizeof(struct interrupt) + sizeof(struct cpu_interrupt) * (cpus))
+#define irrindex(irrs, line, cpus) ((struct interrupt *)&((char *)(irrs))[(line) * interrupt_size(cpus)])
+
+static inline RRDDIM *interrupt_dimension(RRDSET *st, struct interrupt *irr) {
+	RRDDIM *rd = rrddim_find(st, irr->id);
+	if(unlikely(!rd)) rd = rrddim_add(st, irr->id, irr->name, 1, 1, RRDDIM_INCREMENTAL);
+	return rd;
+}
+
 int do_proc_interrupts(int update_every, unsigned long long dt) {
 	static procfile *ff = NULL;
 	static int cpus = -1, do_per_core = -1;
 
+	// the lines of the previous read, with their dimensions bound
+	// these survive across iterations, so that every value is
+	// stored by pointer, without looking up the dimension by id
+	static struct interrupt *irrs = NULL;
+	static uint32_t irrs_allocated = 0;
+
+	static RRDSET *st_system = NULL, **st_cores = NULL;
+
 	if(dt) {};
 
 	if(do_per_core == -1) do_per_core = config_get_boolean("plugin:proc:/proc/interrupts", "interrupts per core", 1);
@@ -63,48 +87,68 @@ int do_proc_interrupts(int update_every, unsigned long long dt) {
 	}
 
 	// allocate the size we need;
-	struct interrupt irrs[lines];
-	irrs[0].used = 0;
+	if(unlikely(lines > irrs_allocated)) {
+		struct interrupt *new = realloc(irrs, lines * interrupt_size(cpus));
+		if(unlikely(!new)) {
+			error("PLUGIN: PROC_INTERRUPTS: Cannot allocate memory for %u lines of /proc/interrupts", lines);
+			return 1;
+		}
+		irrs = new;
+		memset(irrindex(irrs, irrs_allocated, cpus), 0, (lines - irrs_allocated) * interrupt_size(cpus));
+		irrs_allocated = lines;
+	}
+	irrindex(irrs, 0, cpus)->used = 0;
 
 	// loop through all lines
 	for(l = 1; l < lines ;l++) {
-		struct interrupt *irr = &irrs[l];
+		struct interrupt *irr = irrindex(irrs, l, cpus);
 		irr->used = 0;
 		irr->total = 0;
 
 		words = procfile_linewords(ff, l);
 		if(!words) continue;
 
-		irr->id = procfile_lineword(ff, l, 0);
-		if(!irr->id || !irr->id[0]) continue;
+		char *id = procfile_lineword(ff, l, 0);
+		if(!id || !id[0]) continue;
+
+		int idlen = strlen(id);
+		if(id[idlen - 1] == ':')
+			id[idlen - 1] = '\0';
+
+		// when this line is not the one of the previous read,
+		// its dimensions have to be bound again
+		if(unlikely(strncmp(irr->id, id, MAX_INTERRUPT_NAME) != 0)) {
+			strncpy(irr->id, id, MAX_INTERRUPT_NAME);
+			irr->id[MAX_INTERRUPT_NAME] = '\0';
+
+			if(isdigit(irr->id[0]) && (uint32_t)(cpus + 2) < words) {
+				strncpy(irr->name, procfile_lineword(ff, l, words - 1), MAX_INTERRUPT_NAME);
+				irr->name[MAX_INTERRUPT_NAME] = '\0';
+				int nlen = strlen(irr->name);
+				if(nlen < (MAX_INTERRUPT_NAME-1)) {
+					irr->name[nlen] = '_';
+					strncpy(&irr->name[nlen + 1], irr->id, MAX_INTERRUPT_NAME - nlen);
+					irr->name[MAX_INTERRUPT_NAME] = '\0';
+				}
+			}
+			else {
+				strncpy(irr->name, irr->id, MAX_INTERRUPT_NAME);
+				irr->name[MAX_INTERRUPT_NAME] = '\0';
+			}
 
-		int idlen = strlen(irr->id);
-		if(irr->id[idlen - 1] == ':')
-			irr->id[idlen - 1] = '\0';
+			int c;
+			irr->rd = NULL;
+			for(c = 0; c < cpus ;c++) irr->cpu[c].rd = NULL;
+		}
 
 		int c;
 		for(c = 0; c < cpus ;c++) {
 			if((c + 1) < (int)words)
-				irr->value[c] = strtoull(procfile_lineword(ff, l, (uint32_t)(c + 1)), NULL, 10);
+				irr->cpu[c].value = strtoull(procfile_lineword(ff, l, (uint32_t)(c + 1)), NULL, 10);
 			else
-				irr->value[c] = 0;
-
-			irr->total += irr->value[c];
-		}
+				irr->cpu[c].value = 0;
 
-		if(isdigit(irr->id[0]) && (uint32_t)(cpus + 2) < words) {
-			strncpy(irr->name, procfile_lineword(ff, l, words - 1), MAX_INTERRUPT_NAME);
-			irr->name[MAX_INTERRUPT_NAME] = '\0';
-			int nlen = strlen(irr->name);
-			if(nlen < (MAX_INTERRUPT_NAME-1)) {
-				irr->name[nlen] = '_';
-				strncpy(&irr->name[nlen + 1], irr->id, MAX_INTERRUPT_NAME - nlen);
-				irr->name[MAX_INTERRUPT_NAME] = '\0';
-			}
-		}
-		else {
-			strncpy(irr->name, irr->id, MAX_INTERRUPT_NAME);
-			irr->name[MAX_INTERRUPT_NAME] = '\0';
+			irr->total += irr->cpu[c].value;
 		}
 
 		irr->used = 1;
@@ -114,47 +158,61 @@ int do_proc_interrupts(int update_every, unsigned long long dt) {
 
 	// --------------------------------------------------------------------
 
-	st = rrdset_find_bytype("system", "interrupts");
-	if(!st) {
-		st = rrdset_create("system", "interrupts", NULL, "interrupts", NULL, "System interrupts", "interrupts/s", 1000, update_every, RRDSET_TYPE_STACKED);
+	st = st_system;
+	if(unlikely(!st)) {
+		st = rrdset_find_bytype("system", "interrupts");
+		if(!st) st = rrdset_create("system", "interrupts", NULL, "interrupts", NULL, "System interrupts", "interrupts/s", 1000, update_every, RRDSET_TYPE_STACKED);
+		else rrdset_next(st);
 
-		for(l = 0; l < lines ;l++) {
-			if(!irrs[l].used) continue;
-			rrddim_add(st, irrs[l].id, irrs[l].name, 1, 1, RRDDIM_INCREMENTAL);
-		}
+		st_system = st;
 	}
 	else rrdset_next(st);
 
 	for(l = 0; l < lines ;l++) {
-		if(!irrs[l].used) continue;
-		rrddim_set(st, irrs[l].id, irrs[l].total);
+		struct interrupt *irr = irrindex(irrs, l, cpus);
+		if(!irr->used) continue;
+
+		if(unlikely(!irr->rd)) irr->rd = interrupt_dimension(st, irr);
+		rrddim_set_by_pointer(st, irr->rd, irr->total);
 	}
 	rrdset_done(st);
 
 	if(do_per_core) {
 		int c;
 
+		if(unlikely(!st_cores)) {
+			st_cores = calloc(cpus, sizeof(RRDSET *));
+			if(unlikely(!st_cores)) {
+				error("PLUGIN: PROC_INTERRUPTS: Cannot allocate memory for %d cores", cpus);
+				return 1;
+			}
+		}
+
 		for(c = 0; c < cpus ; c++) {
-			char id[256];
-			snprintf(id, 256, "cpu%d_interrupts", c);
-
-			st = rrdset_find_bytype("cpu", id);
-			if(!st) {
-				char name[256], title[256];
-				snprintf(name, 256, "cpu%d_interrupts", c);
-				snprintf(title, 256, "CPU%d Interrupts", c);
-				st = rrdset_create("cpu", id, name, "interrupts", "cpu.interrupts", title, "interrupts/s", 2000 + c, update_every, RRDSET_TYPE_STACKED);
-
-				for(l = 0; l < lines ;l++) {
-					if(!irrs[l].used) continue;
-					rrddim_add(st, irrs[l].id, irrs[l].name, 1, 1, RRDDIM_INCREMENTAL);
+			st = st_cores[c];
+			if(unlikely(!st)) {
+				char id[256];
+				snprintf(id, 256, "cpu%d_interrupts", c);
+
+				st = rrdset_find_bytype("cpu", id);
+				if(!st) {
+					char name[256], title[256];
+					snprintf(name, 256, "cpu%d_interrupts", c);
+					snprintf(title, 256, "CPU%d Interrupts", c);
+					st = rrdset_create("cpu", id, name, "interrupts", "cpu.interrupts", title, "interrupts/s", 2000 + c, update_every, RRDSET_TYPE_STACKED);
 				}
+				else rrdset_next(st);
+
+				st_cores[c] = st;
 			}
 			else rrdset_next(st);
 
 			for(l = 0; l < lines ;l++) {
-				if(!irrs[l].used) continue;
-				rrddim_set(st, irrs[l].id, irrs[l].value[c]);
+				struct interrupt *irr = irrindex(irrs, l, cpus);
+				if(!irr->used) continue;
+
+				if(unlikely(!irr->cpu[c].rd)) irr->cpu[c].rd = interrupt_dimension(st, irr);
+				rrddim_set_by_pointer(st, irr->cpu[c].rd, irr->cpu[c].value);
 			}
 			rrdset_done(st);
 		}
@@ -39,20 +39,32 @@ size_t procfile_max_allocation = PROCFILE_INCREMENT_BUFFER;
 // An array of words
 
 
-pfwords *pfwords_add(pfwords *fw, char *str) {
+// the words and lines arrays double their capacity when full
+// so that huge files (like /proc/interrupts on many cores) settle quickly
+// the capacity is kept across reads, so after the first read of a file
+// parsing it again does not allocate memory
+
+static pfwords *pfwords_expand(pfwords *fw) {
+	// debug(D_PROCFILE, PF_PREFIX ":	expanding words");
+
+	uint32_t size = (fw->size > PFWORDS_INCREASE_STEP) ? fw->size * 2 : fw->size + PFWORDS_INCREASE_STEP;
+
+	pfwords *new = realloc(fw, sizeof(pfwords) + size * sizeof(char *));
+	if(unlikely(!new)) {
+		error(PF_PREFIX ":	failed to expand words");
+		free(fw);
+		return NULL;
+	}
+	new->size = size;
+	return new;
+}
+
+static inline pfwords *pfwords_add(pfwords *fw, char *str) {
 	// debug(D_PROCFILE, PF_PREFIX ":	adding word No %d: '%s'", fw->len, str);
 
 	if(unlikely(fw->len == fw->size)) {
-		// debug(D_PROCFILE, PF_PREFIX ":	expanding words");
-
-		pfwords *new = realloc(fw, sizeof(pfwords) + (fw->size + PFWORDS_INCREASE_STEP) * sizeof(char *));
-		if(unlikely(!new)) {
-			error(PF_PREFIX ":	failed to expand words");
-			free(fw);
-			return NULL;
-		}
-		fw = new;
-		fw->size += PFWORDS_INCREASE_STEP;
+		fw = pfwords_expand(fw);
+		if(unlikely(!fw)) return NULL;
 	}
 
 	fw->words[fw->len++] = str;
@@ -60,7 +72,7 @@ pfwords *pfwords_add(pfwords *fw, char *str) {
 	return fw;
 }
 
-pfwords *pfwords_new(void) {
+static pfwords *pfwords_new(void) {
 	// debug(D_PROCFILE, PF_PREFIX ":	initializing words");
 
 	uint32_t size = (procfile_adaptive_initial_allocation) ? procfile_max_words : PFWORDS_INCREASE_STEP;
@@ -73,12 +85,12 @@ pfwords *pfwords_new(void) {
 	return new;
 }
 
-void pfwords_reset(pfwords *fw) {
+static void pfwords_reset(pfwords *fw) {
 	// debug(D_PROCFILE, PF_PREFIX ":	reseting words");
 	fw->len = 0;
 }
 
-void pfwords_free(pfwords *fw) {
+static void pfwords_free(pfwords *fw) {
 	// debug(D_PROCFILE, PF_PREFIX ":	freeing words");
 
 	free(fw);
@@ -88,20 +100,27 @@ void pfwords_free(pfwords *fw) {
 // ----------------------------------------------------------------------------
 // An array of lines
 
-pflines *pflines_add(pflines *fl, uint32_t first_word) {
+static pflines *pflines_expand(pflines *fl) {
+	// debug(D_PROCFILE, PF_PREFIX ":	expanding lines");
+
+	uint32_t size = (fl->size > PFLINES_INCREASE_STEP) ? fl->size * 2 : fl->size + PFLINES_INCREASE_STEP;
+
+	pflines *new = realloc(fl, sizeof(pflines) + size * sizeof(ffline));
+	if(unlikely(!new)) {
+		error(PF_PREFIX ":	failed to expand lines");
+		free(fl);
+		return NULL;
+	}
+	new->size = size;
+	return new;
+}
+
+static inline pflines *pflines_add(pflines *fl, uint32_t first_word) {
 	// debug(D_PROCFILE, PF_PREFIX ":	adding line %d at word %d", fl->len, first_word);
 
 	if(unlikely(fl->len == fl->size)) {
-		// debug(D_PROCFILE, PF_PREFIX ":	expanding lines");
-
-		pflines *new = realloc(fl, sizeof(pflines) + (fl->size + PFLINES_INCREASE_STEP) * sizeof(ffline));
-		if(unlikely(!new)) {
-			error(PF_PREFIX ":	failed to expand lines");
-			free(fl);
-			return NULL;
-		}
-		fl = new;
-		fl->size += PFLINES_INCREASE_STEP;
+		fl = pflines_expand(fl);
+		if(unlikely(!fl)) return NULL;
 	}
 
 	fl->lines[fl->len].words = 0;
@@ -110,7 +129,7 @@ pflines *pflines_add(pflines *fl, uint32_t first_word) {
 	return fl;
 }
 
-pflines *pflines_new(void) {
+static pflines *pflines_new(void) {
 	// debug(D_PROCFILE, PF_PREFIX ":	initializing lines");
 
 	uint32_t size = (unlikely(procfile_adaptive_initial_allocation)) ? procfile_max_words : PFLINES_INCREASE_STEP;
@@ -123,13 +142,13 @@ pflines *pflines_new(void) {
 	return new;
 }
 
-void pflines_reset(pflines *fl) {
+static void pflines_reset(pflines *fl) {
 	// debug(D_PROCFILE, PF_PREFIX ":	reseting lines");
 
 	fl->len = 0;
 }
 
-void pflines_free(pflines *fl) {
+static void pflines_free(pflines *fl) {
 	// debug(D_PROCFILE, PF_PREFIX ":	freeing lines");
 
 	free(fl);
@@ -157,56 +176,45 @@ procfile *procfile_parser(procfile *ff) {
 	debug(D_PROCFILE, PF_PREFIX ": Parsing file '%s'", ff->filename);
 
 	char *s = ff->data, *e = ff->data, *t = ff->data;
+	const char *separators = ff->separators;
 	uint32_t l = 0, w = 0;
 	e += ff->len;
 
 	ff->lines = pflines_add(ff->lines, w);
 	if(unlikely(!ff->lines)) goto cleanup;
 
+	// every byte is classified once, in two tight loops:
+	// one over the separators before a word and one over the word itself
 	while(likely(s < e)) {
-		switch(ff->separators[(int)(*s)]) {
-			case PF_CHAR_IS_SEPARATOR:
-				if(likely(s == t)) {
-					// skip all leading white spaces
-					t = ++s;
-					continue;
-				}
-
-				// end of word
-				*s = '\0';
-
-				ff->words = pfwords_add(ff->words, t);
-				if(unlikely(!ff->words)) goto cleanup;
+		// skip all leading white spaces
+		while(likely(s < e && separators[(unsigned char)(*s)] == PF_CHAR_IS_SEPARATOR)) s++;
+		t = s;
 
-				ff->lines->lines[l].words++;
-				w++;
+		// the word
+		while(likely(s < e && separators[(unsigned char)(*s)] == PF_CHAR_IS_WORD)) s++;
+		if(unlikely(s == e)) break;
 
-				t = ++s;
-				continue;
+		// end of word
+		// a newline always ends a word, even an empty one
+		char type = separators[(unsigned char)(*s)];
+		*s = '\0';
 
-			case PF_CHAR_IS_NEWLINE:
-				// end of line
-				*s = '\0';
-
-				ff->words = pfwords_add(ff->words, t);
-				if(unlikely(!ff->words)) goto cleanup;
-
-				ff->lines->lines[l].words++;
-				w++;
-
-				// debug(D_PROCFILE, PF_PREFIX ":	ended line %d with %d words", l, ff->lines->lines[l].words);
+		ff->words = pfwords_add(ff->words, t);
+		if(unlikely(!ff->words)) goto cleanup;
 
-				ff->lines = pflines_add(ff->lines, w);
-				if(unlikely(!ff->lines)) goto cleanup;
-				l++;
+		ff->lines->lines[l].words++;
+		w++;
 
-				t = ++s;
-				continue;
+		if(unlikely(type == PF_CHAR_IS_NEWLINE)) {
+			// end of line
+			// debug(D_PROCFILE, PF_PREFIX ":	ended line %d with %d words", l, ff->lines->lines[l].words);
 
-			default:
-				s++;
-				continue;
+			ff->lines = pflines_add(ff->lines, w);
+			if(unlikely(!ff->lines)) goto cleanup;
+			l++;
 		}
+
+		t = ++s;
 	}
 
 	if(likely(s != t)) {
@@ -312,7 +320,7 @@ static void procfile_set_separators(procfile *ff, const char *separators) {
 	if(unlikely(!separators)) separators = " \t=|";
 	ffs = ff->separators;
 	const char *s = separators;
-	while(likely(*s)) ffs[(int)*s++] = PF_CHAR_IS_SEPARATOR;
+	while(likely(*s)) ffs[(unsigned char)*s++] = PF_CHAR_IS_SEPARATOR;
 }
 
 procfile *procfile_open(const char *filename, const char *separators, uint32_t flags) {
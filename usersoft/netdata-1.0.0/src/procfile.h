@@ -17,7 +17,9 @@
  *     - a lines array, pointing to the first word for each line
  *
  *    This is highly optimized. Both arrays are automatically adjusted to
- *    fit all contents and are updated in a single pass on the data:
+ *    fit all contents and are updated in a single pass on the data.
+ *    They keep their capacity across reads, so after the first read of a
+ *    file, parsing it again does not allocate any memory:
  *     - a raspberry Pi can process 5.000+ files / sec.
  *     - a J1900 celeron processor can process 23.000+ files / sec.
 */
@@ -19,6 +19,7 @@
 #include "appconfig.h"
 
 #include "rrd.h"
+#include "backends.h"
 
 #define RRD_DEFAULT_GAP_INTERPOLATIONS 1
 
@@ -42,87 +43,40 @@ int rrd_memory_mode = RRD_MEMORY_MODE_SAVE;
 // ----------------------------------------------------------------------------
 // RRDSET index
 
-static int rrdset_iterator(avl *a) { if(a) {}; return 0; }
+hash_index rrdset_root_index = HASH_INDEX_INITIALIZER;
 
-static int rrdset_compare(void* a, void* b) {
-	if(((RRDSET *)a)->hash < ((RRDSET *)b)->hash) return -1;
-	else if(((RRDSET *)a)->hash > ((RRDSET *)b)->hash) return 1;
-	else return strcmp(((RRDSET *)a)->id, ((RRDSET *)b)->id);
-}
-
-avl_tree rrdset_root_index = {
-		NULL,
-		rrdset_compare,
-#ifdef AVL_LOCK_WITH_MUTEX
-		PTHREAD_MUTEX_INITIALIZER
-#else
-		PTHREAD_RWLOCK_INITIALIZER
-#endif
-};
-
-#define rrdset_index_add(st) avl_insert(&rrdset_root_index, (avl *)(st))
-#define rrdset_index_del(st) avl_remove(&rrdset_root_index, (avl *)(st))
+#define rrdset_index_add(st) hash_index_add(&rrdset_root_index, (st)->hash, (st)->id, (st))
+#define rrdset_index_del(st) hash_index_del(&rrdset_root_index, (st)->hash, (st))
 
 static RRDSET *rrdset_index_find(const char *id, uint32_t hash) {
-	RRDSET *result = NULL, tmp;
-	strncpy(tmp.id, id, RRD_ID_LENGTH_MAX);
-	tmp.id[RRD_ID_LENGTH_MAX] = '\0';
-	tmp.hash = (hash)?hash:simple_hash(tmp.id);
+	char buf[RRD_ID_LENGTH_MAX + 1];
+	strncpy(buf, id, RRD_ID_LENGTH_MAX);
+	buf[RRD_ID_LENGTH_MAX] = '\0';
 
-	avl_search(&(rrdset_root_index), (avl *)&tmp, rrdset_iterator, (avl **)&result);
-	return result;
+	return hash_index_find(&rrdset_root_index, (hash)?hash:simple_hash(buf), buf);
 }
 
 // ----------------------------------------------------------------------------
 // RRDSET name index
 
-#define rrdset_from_avlname(avlname_ptr) ((RRDSET *)((avlname_ptr) - offsetof(RRDSET, avlname)))
-
-static int rrdset_iterator_name(avl *a) { if(a) {}; return 0; }
-
-static int rrdset_compare_name(void* a, void* b) {
-	RRDSET *A = rrdset_from_avlname(a);
-	RRDSET *B = rrdset_from_avlname(b);
-
-	// fprintf(stderr, "COMPARING: %s with %s\n", A->name, B->name);
-
-	if(A->hash_name < B->hash_name) return -1;
-	else if(A->hash_name > B->hash_name) return 1;
-	else return strcmp(A->name, B->name);
-}
-
-avl_tree rrdset_root_index_name = {
-		NULL,
-		rrdset_compare_name,
-#ifdef AVL_LOCK_WITH_MUTEX
-		PTHREAD_MUTEX_INITIALIZER
-#else
-		PTHREAD_RWLOCK_INITIALIZER
-#endif
-};
+hash_index rrdset_root_index_name = HASH_INDEX_INITIALIZER;
 
 int rrdset_index_add_name(RRDSET *st) {
 	// fprintf(stderr, "ADDING: %s (name: %s)\n", st->id, st->name);
-	return avl_insert(&rrdset_root_index_name, (avl *)(&st->avlname));
+	return hash_index_add(&rrdset_root_index_name, st->hash_name, st->name, st) == st;
 }
 
-#define rrdset_index_del_name(st) avl_remove(&rrdset_root_index_name, (avl *)(&st->avlname))
+#define rrdset_index_del_name(st) hash_index_del(&rrdset_root_index_name, (st)->hash_name, (st))
 
 static RRDSET *rrdset_index_find_name(const char *name, uint32_t hash) {
-	void *result = NULL;
-	RRDSET tmp;
-	tmp.name = name;
-	tmp.hash_name = (hash)?hash:simple_hash(tmp.name);
-
 	// fprintf(stderr, "SEARCHING: %s\n", name);
-	avl_search(&(rrdset_root_index_name), (avl *)(&(tmp.avlname)), rrdset_iterator_name, (avl **)&result);
-	if(result) {
-		RRDSET *st = rrdset_from_avlname(result);
+	RRDSET *st = hash_index_find(&rrdset_root_index_name, (hash)?hash:simple_hash(name), name);
+	if(st) {
 		if(strcmp(st->magic, RRDSET_MAGIC))
 			error("Search for RRDSET %s returned an invalid RRDSET %s (name %s)", name, st->id, st->name);
 
 		// fprintf(stderr, "FOUND: %s\n", name);
-		return rrdset_from_avlname(result);
+		return st;
 	}
 	// fprintf(stderr, "NOT FOUND: %s\n", name);
 	return NULL;
@@ -132,25 +86,15 @@ static RRDSET *rrdset_index_find_name(const char *name, uint32_t hash) {
 // ----------------------------------------------------------------------------
 // RRDDIM index
 
-static int rrddim_iterator(avl *a) { if(a) {}; return 0; }
-
-static int rrddim_compare(void* a, void* b) {
-	if(((RRDDIM *)a)->hash < ((RRDDIM *)b)->hash) return -1;
-	else if(((RRDDIM *)a)->hash > ((RRDDIM *)b)->hash) return 1;
-	else return strcmp(((RRDDIM *)a)->id, ((RRDDIM *)b)->id);
-}
-
-#define rrddim_index_add(st, rd) avl_insert(&((st)->dimensions_index), (avl *)(rd))
-#define rrddim_index_del(st,rd ) avl_remove(&((st)->dimensions_index), (avl *)(rd))
+#define rrddim_index_add(st, rd) hash_index_add(&((st)->dimensions_index), (rd)->hash, (rd)->id, (rd))
+#define rrddim_index_del(st, rd) hash_index_del(&((st)->dimensions_index), (rd)->hash, (rd))
 
 static RRDDIM *rrddim_index_find(RRDSET *st, const char *id, uint32_t hash) {
-	RRDDIM *result = NULL, tmp;
-	strncpy(tmp.id, id, RRD_ID_LENGTH_MAX);
-	tmp.id[RRD_ID_LENGTH_MAX] = '\0';
-	tmp.hash = (hash)?hash:simple_hash(tmp.id);
+	char buf[RRD_ID_LENGTH_MAX + 1];
+	strncpy(buf, id, RRD_ID_LENGTH_MAX);
+	buf[RRD_ID_LENGTH_MAX] = '\0';
 
-	avl_search(&(st->dimensions_index), (avl *)&tmp, rrddim_iterator, (avl **)&result);
-	return result;
+	return hash_index_find(&(st->dimensions_index), (hash)?hash:simple_hash(buf), buf);
 }
 
 // ----------------------------------------------------------------------------
@@ -453,7 +397,7 @@ RRDSET *rrdset_create(const char *type, const char *id, const char *name, const
 	st->gap_when_lost_iterations_above = (int) (
 			config_get_number(st->id, "gap when lost iterations above", RRD_DEFAULT_GAP_INTERPOLATIONS) + 2);
 
-	avl_init(&st->dimensions_index, rrddim_compare);
+	hash_index_init(&st->dimensions_index);
 
 	pthread_rwlock_init(&st->rwlock, NULL);
 	pthread_rwlock_wrlock(&rrdset_root_rwlock);
@@ -545,6 +489,7 @@ RRDDIM *rrddim_add(RRDSET *st, const char *id, const char *name, long multiplier
 		rd->flags = 0x00000000;
 		rd->next = NULL;
 		rd->name = NULL;
+		rd->tiers = NULL;
 	}
 	else {
 		// if we didn't manage to get a mmap'd dimension, just create one
@@ -580,6 +525,8 @@ RRDDIM *rrddim_add(RRDSET *st, const char *id, const char *name, long multiplier
 	rd->entries = st->entries;
 	rd->update_every = st->update_every;
 
+	if(rrd_tiers) rd->tiers = rrd_tiers_create(st->cache_dir, filename, st->update_every);
+
 	// prevent incremental calculation spikes
 	rd->counter = 0;
 
@@ -626,6 +573,9 @@ void rrddim_free(RRDSET *st, RRDDIM *rd)
 
 	rrddim_index_del(st, rd);
 
+	rrd_tiers_free(rd->tiers);
+	rd->tiers = NULL;
+
 	// free(rd->annotations);
 	if(rd->mapped == RRD_MEMORY_MODE_SAVE) {
 		debug(D_RRD_CALLS, "Saving dimension '%s' to '%s'.", rd->name, rd->cache_filename);
@@ -655,7 +605,9 @@ void rrdset_free_all(void)
 		while(st->dimensions)
 			rrddim_free(st, st->dimensions);
 
+		hash_index_destroy(&st->dimensions_index);
 		rrdset_index_del(st);
+		rrdset_index_del_name(st);
 
 		if(st->mapped == RRD_MEMORY_MODE_SAVE) {
 			debug(D_RRD_CALLS, "Saving stats '%s' to '%s'.", st->name, st->cache_filename);
@@ -1096,6 +1048,10 @@ unsigned long long rrdset_done(RRDSET *st)
 	long long iterations = (now_ut - last_ut) / (st->update_every * 1000000ULL);
 	if((now_ut % (st->update_every * 1000000ULL)) == 0) iterations++;
 
+	// the backend gets the values of the chart in one go
+	int backend = backends_enabled;
+	if(unlikely(backend)) backends_lock();
+
 	for( ; likely(next_ut <= now_ut) ; next_ut += st->update_every * 1000000ULL, iterations-- ) {
 #ifdef NETDATA_INTERNAL_CHECKS
 		if(iterations < 0) { error("%s: iterations calculation wrapped! first_ut = %llu, last_ut = %llu, next_ut = %llu, now_ut = %llu", st->name, first_ut, last_ut, next_ut, now_ut); }
@@ -1207,6 +1163,14 @@ unsigned long long rrdset_done(RRDSET *st)
 				rd->values[st->current_entry] = pack_storage_number(0, SN_NOT_EXISTS);
 			}
 
+			if(unlikely(rd->tiers)) {
+				storage_number n = rd->values[st->current_entry];
+				rrd_tiers_store(rd->tiers, st->last_updated.tv_sec, does_storage_number_exist(n), unpack_storage_number(n));
+			}
+
+			if(unlikely(backend && does_storage_number_exist(rd->values[st->current_entry])))
+				backends_store(st, rd, st->last_updated.tv_sec, unpack_storage_number(rd->values[st->current_entry]));
+
 			stored_entries++;
 
 			if(unlikely(st->debug)) {
@@ -1245,6 +1209,8 @@ unsigned long long rrdset_done(RRDSET *st)
 		last_ut = next_ut;
 	}
 
+	if(unlikely(backend)) backends_unlock();
+
 	// align next interpolation to last collection point
 	if(likely(stored_entries || !store_this_entry)) {
 		st->last_updated.tv_sec = st->last_collected_time.tv_sec;
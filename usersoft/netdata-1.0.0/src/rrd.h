@@ -2,8 +2,9 @@
 #include <pthread.h>
 #include <stdint.h>
 
-#include "avl.h"
+#include "hash_index.h"
 #include "storage_number.h"
+#include "rrd_tier.h"
 
 #ifndef NETDATA_RRD_H
 #define NETDATA_RRD_H 1
@@ -86,11 +87,6 @@ extern const char *rrddim_algorithm_name(int chart_type);
 // RRD DIMENSION
 
 struct rrddim {
-	// ------------------------------------------------------------------------
-	// binary indexing structures
-
-	avl avl;										// the binary index - this has to be first member!
-
 	// ------------------------------------------------------------------------
 	// the dimension definition
 
@@ -107,12 +103,12 @@ struct rrddim {
 
 	int mapped;										// if set to non zero, this dimension is mapped to a file
 
+	RRD_TIER *tiers;								// the storage tiers of this dimension (rrd_tiers of them), or NULL
+
 	// ------------------------------------------------------------------------
 	// members for temporary data we need for calculations
 
-	uint32_t hash;									// a simple hash of the id, to speed up searching / indexing
-													// instead of strcmp() every item in the binary index
-													// we first compare the hashes
+	uint32_t hash;									// a simple hash of the id, the key of the dimensions index
 
 	uint32_t flags;
 
@@ -165,12 +161,6 @@ typedef struct rrddim RRDDIM;
 // RRDSET
 
 struct rrdset {
-	// ------------------------------------------------------------------------
-	// binary indexing structures
-
-	avl avl;										// the index, with key the id - this has to be first!
-	avl avlname;									// the index, with key the name
-
 	// ------------------------------------------------------------------------
 	// the set configuration
 
@@ -221,10 +211,8 @@ struct rrdset {
 	unsigned long counter;							// the number of times we added values to this rrd
 	unsigned long counter_done;						// the number of times we added values to this rrd
 
-	uint32_t hash;									// a simple hash on the id, to speed up searching
-													// we first compare hashes, and only if the hashes are equal we do string comparisons
-
-	uint32_t hash_name;								// a simple hash on the name
+	uint32_t hash;									// a simple hash on the id, the key of the charts index
+	uint32_t hash_name;								// a simple hash on the name, the key of the charts name index
 
 	unsigned long long usec_since_last_update;		// the time in microseconds since the last collection of data
 
@@ -246,7 +234,7 @@ struct rrdset {
 	// ------------------------------------------------------------------------
 	// the dimensions
 
-	avl_tree dimensions_index;						// the root of the dimensions index
+	hash_index dimensions_index;					// the dimensions, indexed by id
 	RRDDIM *dimensions;								// the actual data for every dimension
 };
 typedef struct rrdset RRDSET;
@@ -5,9 +5,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <math.h>
 
 #include "log.h"
 #include "common.h"
+#include "appconfig.h"
 #include "rrd2json.h"
 
 #define HOSTNAME_MAX 1024
@@ -1206,6 +1208,179 @@ cleanup:
 	return NULL;
 }
 
+// group the values of slots 'from' down to 'to' (the newest first)
+// this is the inner loop of all queries, so the grouping method is
+// checked once per run of values, not once per value
+static inline void rrdr_group_values(storage_number *values, long from, long to, int group_method, calculated_number *group_value, long *group_count, uint8_t *group_options)
+{
+	calculated_number sum = *group_value;
+	long i, count = *group_count;
+	int non_zero = 0, reset = 0;
+
+	switch(group_method) {
+		case GROUP_MAX:
+			for(i = from; i >= to ; i--) {
+				storage_number n = values[i];
+				if(unlikely(!does_storage_number_exist(n))) continue;
+
+				calculated_number value = storage_number_unpack(n);
+				non_zero |= (value != 0.0);
+				reset |= did_storage_number_reset(n);
+
+				if(unlikely(fabsl(value) > fabsl(sum))) sum = value;
+				count++;
+			}
+			break;
+
+		default:
+		case GROUP_SUM:
+		case GROUP_AVERAGE:
+			for(i = from; i >= to ; i--) {
+				storage_number n = values[i];
+				if(unlikely(!does_storage_number_exist(n))) continue;
+
+				calculated_number value = storage_number_unpack(n);
+				non_zero |= (value != 0.0);
+				reset |= did_storage_number_reset(n);
+
+				sum += value;
+				count++;
+			}
+			break;
+	}
+
+	*group_value = sum;
+	*group_count = count;
+	if(non_zero) *group_options |= RRDR_NONZERO;
+	if(reset) *group_options |= RRDR_RESET;
+}
+
+// answer a query from the storage tiers
+// returns NULL when the round robin database should answer it
+static RRDR *rrd2rrdr_tier(RRDSET *st, long points, long long after, long long before, int group_method, int absolute_period_requested)
+{
+	time_t tier_first_t = 0;
+	time_t last_entry_t = rrdset_last_entry_t(st);
+
+	if(before > last_entry_t) before = last_entry_t;
+	if(after > before) return NULL;
+
+	int tier = rrdset_tier_for_query(st, (time_t)after, (time_t)before, &tier_first_t);
+	if(tier < 0) return NULL;
+
+	time_t dt = st->dimensions->tiers[tier].update_every;
+	if(after < tier_first_t) after = tier_first_t;
+
+	long available_points = (before - after) / dt;
+	if(available_points <= 0) return NULL;
+
+	if(points < 0) points = -points;
+	if(points > available_points) points = available_points;
+	if(points == 0) points = available_points;
+
+	long group = available_points / points;
+	if(group <= 0) group = 1;
+	if(available_points % points > points / 2) group++;
+
+	time_t after_new = after - (after % (group * dt));
+	time_t before_new = before - (before % (group * dt));
+	long rows = (before_new - after_new) / dt / group;
+	if(rows <= 0) return NULL;
+
+	// the tier points we need, oldest first
+	long count = rows * group;
+	time_t first_t = before_new - (count - 1) * dt;
+
+	double *values = malloc(count * sizeof(double));
+	if(unlikely(!values)) {
+		error("Cannot allocate memory for %ld storage tier points.", count);
+		return NULL;
+	}
+
+	RRDR *r = rrdr_create(st, rows);
+	if(!r) {
+		free(values);
+		return NULL;
+	}
+	if(!r->d) {
+		free(values);
+		return r;
+	}
+
+	if(absolute_period_requested == 1)
+		r->result_options |= RRDR_RESULT_OPTION_ABSOLUTE;
+	else
+		r->result_options |= RRDR_RESULT_OPTION_RELATIVE;
+
+	r->group = group * st->dimensions->tiers[tier].group;
+	r->update_every = group * dt;
+
+	long i, j, c;
+	for(i = 0; i < rows ; i++)
+		r->t[i] = before_new - i * group * dt;
+
+	RRDDIM *rd;
+	for(rd = st->dimensions, c = 0 ; rd && c < r->d ; rd = rd->next, c++) {
+		for(j = 0; j < count ; j++) values[j] = NAN;
+		rrd_tier_fetch(&rd->tiers[tier], first_t, before_new, values);
+
+		// the rows are newest first, values are oldest first
+		for(i = 0; i < rows ; i++) {
+			calculated_number *cn = &r->v[i * r->d];
+			uint8_t *co = &r->o[i * r->d];
+			calculated_number sum = 0;
+			long added = 0;
+
+			co[c] = 0;
+
+			for(j = count - (i + 1) * group; j < count - i * group ; j++) {
+				if(isnan(values[j])) continue;
+
+				calculated_number value = values[j];
+				if(likely(value != 0.0)) {
+					co[c] |= RRDR_NONZERO;
+					r->od[c] |= RRDR_NONZERO;
+				}
+
+				switch(group_method) {
+					case GROUP_MAX:
+						if(unlikely(!added || fabsl(value) > fabsl(sum)))
+							sum = value;
+						break;
+
+					default:
+					case GROUP_SUM:
+					case GROUP_AVERAGE:
+						sum += value;
+						break;
+				}
+				added++;
+			}
+
+			if(unlikely(!added)) {
+				cn[c] = 0.0;
+				co[c] |= RRDR_EMPTY;
+			}
+			else if(group_method == GROUP_AVERAGE)
+				cn[c] = sum / added;
+			else
+				cn[c] = sum;
+
+			if(cn[c] < r->min) r->min = cn[c];
+			if(cn[c] > r->max) r->max = cn[c];
+		}
+	}
+
+	free(values);
+
+	r->rows = rows;
+	r->c = 0;
+	r->before = r->t[0];
+	r->after = r->t[rows - 1];
+
+	return r;
+}
+
 RRDR *rrd2rrdr(RRDSET *st, long points, long long after, long long before, int group_method)
 {
 	int debug = st->debug;
@@ -1234,6 +1409,12 @@ RRDR *rrd2rrdr(RRDSET *st, long points, long long after, long long before, int g
 	if(absolute_period_requested == -1)
 		absolute_period_requested = 1;
 
+	// older than our round robin database? the storage tiers may have it
+	if(unlikely(rrd_tiers && after < first_entry_t)) {
+		RRDR *r = rrd2rrdr_tier(st, points, after, before, group_method, absolute_period_requested);
+		if(r) return r;
+	}
+
 	// make sure they are within our timeframe
 	if(before > last_entry_t) before = last_entry_t;
 	if(before < first_entry_t) before = first_entry_t;
@@ -1358,28 +1539,16 @@ RRDR *rrd2rrdr(RRDSET *st, long points, long long after, long long before, int g
 
 
 	// -------------------------------------------------------------------------
-	// temp arrays for keeping values per dimension
-
-	calculated_number 	group_values[dimensions]; // keep sums when grouping
-	long 				group_counts[dimensions]; // keep the number of values added to group_values
-	uint8_t 			group_options[dimensions];
-	uint8_t				found_non_zero[dimensions];
-
+	// find the rows we will generate
+	// every row groups 'group' consecutive slots, we keep the newest of them
 
-	// initialize them
-	RRDDIM *rd;
-	long c;
-	for( rd = st->dimensions, c = 0 ; rd && c < dimensions ; rd = rd->next, c++) {
-		group_values[c] = 0;
-		group_counts[c] = 0;
-		group_options[c] = 0;
-		found_non_zero[c] = 0;
+	long *row_slots = malloc(r->n * sizeof(long));
+	if(unlikely(!row_slots)) {
+		error("Cannot allocate memory for %ld rows of chart %s", r->n, st->id);
+		rrdr_free(r);
+		return NULL;
 	}
 
-
-	// -------------------------------------------------------------------------
-	// the main loop
-
 	time_t 	now = rrdset_slot2time(st, start_at_slot),
 			dt = st->update_every,
 			group_start_t = 0;
@@ -1402,7 +1571,7 @@ RRDR *rrd2rrdr(RRDSET *st, long points, long long after, long long before, int g
 
 	//info("RRD2RRDR(): %s: STARTING", st->id);
 
-	long slot = start_at_slot, counter = 0, stop_now = 0, added = 0, group_count = 0, add_this = 0;
+	long slot = start_at_slot, counter = 0, stop_now = 0, added = 0, group_count = 0, group_start_slot = 0;
 	for(; !stop_now ; now -= dt, slot--, counter++) {
 		if(unlikely(slot < 0)) slot = st->entries - 1;
 		if(unlikely(slot == stop_at_slot)) stop_now = counter;
@@ -1424,95 +1593,81 @@ RRDR *rrd2rrdr(RRDSET *st, long points, long long after, long long before, int g
 
 		if(unlikely(group_count == 0)) {
 			group_start_t = now;
+			group_start_slot = slot;
 		}
 		group_count++;
 
 		if(unlikely(group_count == group)) {
 			if(unlikely(added >= points)) break;
-			add_this = 1;
-		}
-
-		// do the calculations
-		for(rd = st->dimensions, c = 0 ; rd && c < dimensions ; rd = rd->next, c++) {
-			storage_number n = rd->values[slot];
-			if(unlikely(!does_storage_number_exist(n))) continue;
-
-			group_counts[c]++;
-
-			calculated_number value = unpack_storage_number(n);
-			if(likely(value != 0.0)) {
-				group_options[c] |= RRDR_NONZERO;
-				found_non_zero[c] = 1;
-			}
-
-			if(unlikely(did_storage_number_reset(n)))
-				group_options[c] |= RRDR_RESET;
+			if(unlikely(!rrdr_line_init(r, group_start_t))) break;
 
-			switch(group_method) {
-				case GROUP_MAX:
-					if(unlikely(abs(value) > abs(group_values[c])))
-						group_values[c] = value;
-					break;
+			row_slots[r->c] = group_start_slot;
+			r->after = now;
 
-				default:
-				case GROUP_SUM:
-				case GROUP_AVERAGE:
-					group_values[c] += value;
-					break;
-			}
+			added++;
+			group_count = 0;
 		}
+	}
 
-		// added it
-		if(unlikely(add_this)) {
-			if(unlikely(!rrdr_line_init(r, group_start_t))) break;
 
-			r->after = now;
+	// -------------------------------------------------------------------------
+	// group the values of each dimension
+	// one dimension at a time, so that we walk its values sequentially
 
-			calculated_number *cn = rrdr_line_values(r);
-			uint8_t *co = rrdr_line_options(r);
+	RRDDIM *rd;
+	long c, rows = r->c + 1;
+	for(rd = st->dimensions, c = 0 ; rd && c < dimensions ; rd = rd->next, c++) {
+		long i;
 
-			for(rd = st->dimensions, c = 0 ; rd && c < dimensions ; rd = rd->next, c++) {
+		for(i = 0; i < rows ; i++) {
+			calculated_number value = 0;
+			long count = 0;
+			uint8_t options = 0;
 
-				// update the dimension options
-				if(likely(found_non_zero[c])) r->od[c] |= RRDR_NONZERO;
+			long first = row_slots[i], last = first - group + 1;
+			if(likely(last >= 0))
+				rrdr_group_values(rd->values, first, last, group_method, &value, &count, &options);
+			else {
+				// the group wraps around the round robin database
+				rrdr_group_values(rd->values, first, 0, group_method, &value, &count, &options);
+				rrdr_group_values(rd->values, st->entries - 1, st->entries + last, group_method, &value, &count, &options);
+			}
 
-				// store the specific point options
-				co[c] = group_options[c];
+			calculated_number *cn = &r->v[i * r->d];
+			uint8_t *co = &r->o[i * r->d];
 
-				// store the value
-				if(unlikely(group_counts[c] == 0)) {
-					cn[c] = 0.0;
-					co[c] |= RRDR_EMPTY;
-				}
-				else if(unlikely(group_method == GROUP_AVERAGE)) {
-					cn[c] = group_values[c] / group_counts[c];
-				}
-				else {
-					cn[c] = group_values[c];
-				}
+			// update the dimension options
+			if(options & RRDR_NONZERO) r->od[c] |= RRDR_NONZERO;
 
-				if(cn[c] < r->min) r->min = cn[c];
-				if(cn[c] > r->max) r->max = cn[c];
+			// store the specific point options
+			co[c] = options;
 
-				// reset them for the next loop
-				group_values[c] = 0;
-				group_counts[c] = 0;
-				group_options[c] = 0;
+			// store the value
+			if(unlikely(count == 0)) {
+				cn[c] = 0.0;
+				co[c] |= RRDR_EMPTY;
+			}
+			else if(unlikely(group_method == GROUP_AVERAGE)) {
+				cn[c] = value / count;
+			}
+			else {
+				cn[c] = value;
 			}
 
-			added++;
-			group_count = 0;
-			add_this = 0;
+			if(cn[c] < r->min) r->min = cn[c];
+			if(cn[c] > r->max) r->max = cn[c];
 		}
 	}
 
+	free(row_slots);
+
 	rrdr_done(r);
 	//info("RRD2RRDR(): %s: END %ld loops made, %ld points generated", st->id, counter, rrdr_rows(r));
 	//error("SHIFT: %s: wanted %ld points, got %ld", st->id, points, rrdr_rows(r));
 	return r;
 }
 
-int rrd2format(RRDSET *st, BUFFER *wb, BUFFER *dimensions, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, time_t *latest_timestamp)
+static int rrd2format_query(RRDSET *st, BUFFER *wb, BUFFER *dimensions, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, time_t *latest_timestamp)
 {
 	RRDR *r = rrd2rrdr(st, points, after, before, group_method);
 	if(!r) {
@@ -1520,6 +1675,12 @@ int rrd2format(RRDSET *st, BUFFER *wb, BUFFER *dimensions, uint32_t format, long
 		return 500;
 	}
 
+	// the caller has all the points up to 'after', send only the newer ones
+	if((options & RRDR_OPTION_NEWER) && after > st->update_every * st->entries) {
+		while(rrdr_rows(r) > 0 && r->t[rrdr_rows(r) - 1] <= after) r->rows--;
+		if(rrdr_rows(r) > 0) r->after = r->t[rrdr_rows(r) - 1];
+	}
+
 	if(r->result_options & RRDR_RESULT_OPTION_RELATIVE)
 		wb->options |= WB_CONTENT_NO_CACHEABLE;
 	else if(r->result_options & RRDR_RESULT_OPTION_ABSOLUTE)
@@ -1686,6 +1847,187 @@ int rrd2format(RRDSET *st, BUFFER *wb, BUFFER *dimensions, uint32_t format, long
 	return 200;
 }
 
+// ----------------------------------------------------------------------------
+// query results cache
+
+// 1. many dashboards ask for the same chart, with the same parameters, every second
+// 2. the result of a query can only change when the chart collects new values
+// 3. so we keep the output of recent queries, keyed by the chart, its last
+//    collection and the query parameters, and copy it to the next requests
+
+#define RRDR_CACHE_ENTRIES 128
+#define RRDR_CACHE_MAX_OUTPUT (512 * 1024)
+
+typedef struct rrdr_cache_entry {
+	RRDSET *st;
+	unsigned long counter_done;
+	time_t last_updated;
+
+	uint32_t format;
+	long points;
+	long long after;
+	long long before;
+	int group_method;
+	uint32_t options;
+	char *dimensions;
+
+	uint8_t contenttype;
+	uint8_t wb_options;
+	time_t latest_timestamp;
+	BUFFER *output;
+} RRDR_CACHE_ENTRY;
+
+static pthread_mutex_t rrdr_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static RRDR_CACHE_ENTRY *rrdr_cache = NULL;
+static long rrdr_cache_entries = -1;
+
+static RRDR_CACHE_ENTRY *rrdr_cache_slot(RRDSET *st, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, const char *dims)
+{
+	if(unlikely(rrdr_cache_entries == -1)) {
+		rrdr_cache_entries = config_get_number("global", "api query cache entries", RRDR_CACHE_ENTRIES);
+		if(rrdr_cache_entries < 0) rrdr_cache_entries = 0;
+
+		if(rrdr_cache_entries) {
+			rrdr_cache = calloc(rrdr_cache_entries, sizeof(RRDR_CACHE_ENTRY));
+			if(!rrdr_cache) {
+				error("Cannot allocate memory for %ld query cache entries. Query caching is disabled.", rrdr_cache_entries);
+				rrdr_cache_entries = 0;
+			}
+		}
+	}
+
+	if(unlikely(!rrdr_cache_entries)) return NULL;
+
+	uint32_t hash = simple_hash(st->id);
+	hash = hash * 31 + format;
+	hash = hash * 31 + (uint32_t)points;
+	hash = hash * 31 + (uint32_t)after;
+	hash = hash * 31 + (uint32_t)before;
+	hash = hash * 31 + (uint32_t)group_method;
+	hash = hash * 31 + options;
+	if(dims) hash = hash * 31 + simple_hash(dims);
+
+	return &rrdr_cache[hash % rrdr_cache_entries];
+}
+
+static inline int rrdr_cache_entry_matches(RRDR_CACHE_ENTRY *e, RRDSET *st, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, const char *dims)
+{
+	return e->output
+		&& e->st == st
+		&& e->counter_done == st->counter_done
+		&& e->last_updated == st->last_updated.tv_sec
+		&& e->format == format
+		&& e->points == points
+		&& e->after == after
+		&& e->before == before
+		&& e->group_method == group_method
+		&& e->options == options
+		&& ((!e->dimensions && !dims) || (e->dimensions && dims && !strcmp(e->dimensions, dims)));
+}
+
+// append the cached output of this query to wb - returns 1 on a hit
+static int rrdr_cache_get(RRDSET *st, BUFFER *wb, const char *dims, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, time_t *latest_timestamp)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&rrdr_cache_mutex);
+
+	RRDR_CACHE_ENTRY *e = rrdr_cache_slot(st, format, points, after, before, group_method, options, dims);
+	if(e && rrdr_cache_entry_matches(e, st, format, points, after, before, group_method, options, dims)) {
+		buffer_need_bytes(wb, e->output->len + 1);
+		memcpy(&wb->buffer[wb->len], e->output->buffer, e->output->len);
+		wb->len += e->output->len;
+		wb->buffer[wb->len] = '\0';
+
+		wb->contenttype = e->contenttype;
+		wb->options |= e->wb_options;
+		if(latest_timestamp && e->latest_timestamp) *latest_timestamp = e->latest_timestamp;
+
+		ret = 1;
+	}
+
+	pthread_mutex_unlock(&rrdr_cache_mutex);
+
+	return ret;
+}
+
+// save the output of this query, found in wb after 'start'
+static void rrdr_cache_put(RRDSET *st, BUFFER *wb, size_t start, const char *dims, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, unsigned long counter_done, time_t last_updated, time_t latest_timestamp)
+{
+	size_t len = wb->len - start;
+	if(unlikely(len > RRDR_CACHE_MAX_OUTPUT)) return;
+
+	// the chart collected new values while we were querying it
+	if(unlikely(counter_done != st->counter_done)) return;
+
+	pthread_mutex_lock(&rrdr_cache_mutex);
+
+	RRDR_CACHE_ENTRY *e = rrdr_cache_slot(st, format, points, after, before, group_method, options, dims);
+	if(!e) goto cleanup;
+
+	if(!e->output) {
+		e->output = buffer_create(len + 1);
+		if(!e->output) goto cleanup;
+	}
+	else buffer_flush(e->output);
+
+	if(e->dimensions) {
+		free(e->dimensions);
+		e->dimensions = NULL;
+	}
+
+	if(dims) {
+		e->dimensions = strdup(dims);
+		if(!e->dimensions) {
+			// invalidate the entry
+			e->st = NULL;
+			goto cleanup;
+		}
+	}
+
+	buffer_need_bytes(e->output, len + 1);
+	memcpy(e->output->buffer, &wb->buffer[start], len);
+	e->output->len = len;
+	e->output->buffer[len] = '\0';
+
+	e->st = st;
+	e->counter_done = counter_done;
+	e->last_updated = last_updated;
+	e->format = format;
+	e->points = points;
+	e->after = after;
+	e->before = before;
+	e->group_method = group_method;
+	e->options = options;
+	e->contenttype = wb->contenttype;
+	e->wb_options = wb->options & (WB_CONTENT_CACHEABLE | WB_CONTENT_NO_CACHEABLE);
+	e->latest_timestamp = latest_timestamp;
+
+cleanup:
+	pthread_mutex_unlock(&rrdr_cache_mutex);
+}
+
+int rrd2format(RRDSET *st, BUFFER *wb, BUFFER *dimensions, uint32_t format, long points, long long after, long long before, int group_method, uint32_t options, time_t *latest_timestamp)
+{
+	const char *dims = (dimensions)?buffer_tostring(dimensions):NULL;
+
+	if(rrdr_cache_get(st, wb, dims, format, points, after, before, group_method, options, latest_timestamp))
+		return 200;
+
+	unsigned long counter_done = st->counter_done;
+	time_t last_updated = st->last_updated.tv_sec;
+	time_t latest = 0;
+	size_t start = wb->len;
+
+	int ret = rrd2format_query(st, wb, dimensions, format, points, after, before, group_method, options, &latest);
+	if(latest_timestamp && latest) *latest_timestamp = latest;
+
+	if(ret == 200)
+		rrdr_cache_put(st, wb, start, dims, format, points, after, before, group_method, options, counter_done, last_updated, latest);
+
+	return ret;
+}
+
 time_t rrd_stats_json(int type, RRDSET *st, BUFFER *wb, long points, long group, int group_method, time_t after, time_t before, int only_non_zero)
 {
 	int c;
@@ -51,6 +51,7 @@ extern char *hostname;
 #define RRDR_OPTION_JSON_WRAP		0x00000200 // wrap the response in a JSON header with info about the result
 #define RRDR_OPTION_LABEL_QUOTES 	0x00000400 // in CSV output, wrap header labels in double quotes
 #define RRDR_OPTION_PERCENTAGE		0x00000800 // give values as percentage of total
+#define RRDR_OPTION_NEWER			0x00001000 // with an absolute after, send only the points newer than after
 
 extern void rrd_stats_api_v1_chart(RRDSET *st, BUFFER *wb);
 extern void rrd_stats_api_v1_charts(BUFFER *wb);
@@ -0,0 +1,473 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "log.h"
+#include "appconfig.h"
+
+#include "rrd.h"
+#include "rrd_tier.h"
+
+int rrd_tiers = 0;
+
+// the group of each tier is relative to the previous tier
+static int rrd_tier_group[RRD_TIERS_MAX] = { 1, 60, 60 };
+static long rrd_tier_history[RRD_TIERS_MAX] = { RRD_TIER_DEFAULT_HISTORY, 86400 * 30, 86400 * 365 };
+
+#define RRD_TIER_PAGE_DATA_BITS ((RRD_TIER_PAGE_SIZE - sizeof(struct rrd_tier_page)) * 8)
+
+// the most bits a point can take: 4 + 32 for the timestamp, 2 + 5 + 6 + 64 for the value
+#define RRD_TIER_POINT_MAX_BITS 113
+
+#define RRD_TIER_NO_WINDOW 255
+
+void rrd_tiers_init(void)
+{
+	char varname[CONFIG_MAX_NAME + 1];
+	int i;
+
+	rrd_tiers = (int) config_get_number("global", "storage tiers", rrd_tiers);
+	if(rrd_tiers < 0) rrd_tiers = 0;
+	if(rrd_tiers > RRD_TIERS_MAX) rrd_tiers = config_set_number("global", "storage tiers", RRD_TIERS_MAX);
+
+	for(i = 0; i < rrd_tiers ; i++) {
+		snprintf(varname, CONFIG_MAX_NAME, "storage tier %d group", i);
+		rrd_tier_group[i] = (int) config_get_number("global", varname, rrd_tier_group[i]);
+		if(rrd_tier_group[i] < 1) rrd_tier_group[i] = config_set_number("global", varname, 1);
+
+		snprintf(varname, CONFIG_MAX_NAME, "storage tier %d history", i);
+		rrd_tier_history[i] = config_get_number("global", varname, rrd_tier_history[i]);
+		if(rrd_tier_history[i] < 60) rrd_tier_history[i] = config_set_number("global", varname, 60);
+	}
+}
+
+// ----------------------------------------------------------------------------
+// bit streams
+
+static inline void rrd_tier_write_bits(uint8_t *data, uint32_t *pos, uint64_t value, int bits)
+{
+	while(bits > 0) {
+		int avail = 8 - (*pos & 7);
+		int n = (bits < avail) ? bits : avail;
+		uint8_t chunk = (uint8_t)((value >> (bits - n)) & ((1U << n) - 1));
+
+		data[*pos >> 3] |= (uint8_t)(chunk << (avail - n));
+		*pos += n;
+		bits -= n;
+	}
+}
+
+static inline uint64_t rrd_tier_read_bits(const uint8_t *data, uint32_t *pos, int bits)
+{
+	uint64_t value = 0;
+
+	while(bits > 0) {
+		int avail = 8 - (*pos & 7);
+		int n = (bits < avail) ? bits : avail;
+		uint8_t chunk = (uint8_t)((data[*pos >> 3] >> (avail - n)) & ((1U << n) - 1));
+
+		value = (value << n) | chunk;
+		*pos += n;
+		bits -= n;
+	}
+
+	return value;
+}
+
+static inline uint64_t rrd_tier_double2bits(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static inline double rrd_tier_bits2double(uint64_t bits)
+{
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// ----------------------------------------------------------------------------
+// writing pages
+
+static struct rrd_tier_page *rrd_tier_page_open(RRD_TIER *tier, time_t t)
+{
+	uint64_t sequence = tier->last_sequence + 1;
+	struct rrd_tier_page *page = (struct rrd_tier_page *)&tier->mem[(sequence % tier->pages) * RRD_TIER_PAGE_SIZE];
+
+	// invalidate the page first, readers may be decoding it
+	page->magic = 0;
+	__sync_synchronize();
+
+	memset(page, 0, RRD_TIER_PAGE_SIZE);
+	page->update_every = (uint32_t)tier->update_every;
+	page->sequence = sequence;
+	page->first_t = t;
+	page->last_t = t;
+	__sync_synchronize();
+
+	page->magic = RRD_TIER_PAGE_MAGIC;
+
+	tier->last_sequence = sequence;
+	tier->page = page;
+	tier->last_delta = tier->update_every;
+	tier->leading = RRD_TIER_NO_WINDOW;
+	tier->trailing = 0;
+
+	return page;
+}
+
+static void rrd_tier_append(RRD_TIER *tier, time_t t, double value)
+{
+	struct rrd_tier_page *page = tier->page;
+
+	// time cannot go backwards in a tier
+	if(unlikely(t <= tier->last_t)) return;
+
+	if(unlikely(!page || page->bits + RRD_TIER_POINT_MAX_BITS > RRD_TIER_PAGE_DATA_BITS))
+		page = rrd_tier_page_open(tier, t);
+
+	uint32_t pos = page->bits;
+	uint64_t bits = rrd_tier_double2bits(value);
+
+	if(unlikely(!page->points)) {
+		rrd_tier_write_bits(page->data, &pos, bits, 64);
+	}
+	else {
+		// the timestamp, as a delta-of-delta
+		time_t delta = t - tier->last_t;
+		long long dod = (long long)delta - (long long)tier->last_delta;
+
+		if(likely(dod == 0))
+			rrd_tier_write_bits(page->data, &pos, 0x0, 1);
+		else if(dod >= -63 && dod <= 64) {
+			rrd_tier_write_bits(page->data, &pos, 0x2, 2);
+			rrd_tier_write_bits(page->data, &pos, (uint64_t)(dod + 63), 7);
+		}
+		else if(dod >= -255 && dod <= 256) {
+			rrd_tier_write_bits(page->data, &pos, 0x6, 3);
+			rrd_tier_write_bits(page->data, &pos, (uint64_t)(dod + 255), 9);
+		}
+		else if(dod >= -2047 && dod <= 2048) {
+			rrd_tier_write_bits(page->data, &pos, 0xe, 4);
+			rrd_tier_write_bits(page->data, &pos, (uint64_t)(dod + 2047), 12);
+		}
+		else {
+			rrd_tier_write_bits(page->data, &pos, 0xf, 4);
+			rrd_tier_write_bits(page->data, &pos, (uint64_t)(uint32_t)(int32_t)dod, 32);
+		}
+		tier->last_delta = delta;
+
+		// the value, as the XOR with the previous one
+		uint64_t xor = bits ^ tier->last_value;
+		if(likely(xor == 0))
+			rrd_tier_write_bits(page->data, &pos, 0x0, 1);
+		else {
+			int leading = __builtin_clzll(xor);
+			int trailing = __builtin_ctzll(xor);
+			if(leading > 31) leading = 31;
+
+			if(tier->leading != RRD_TIER_NO_WINDOW && leading >= tier->leading && trailing >= tier->trailing) {
+				// it fits in the window of the previous value
+				rrd_tier_write_bits(page->data, &pos, 0x2, 2);
+				rrd_tier_write_bits(page->data, &pos, xor >> tier->trailing, 64 - tier->leading - tier->trailing);
+			}
+			else {
+				int length = 64 - leading - trailing;
+
+				rrd_tier_write_bits(page->data, &pos, 0x3, 2);
+				rrd_tier_write_bits(page->data, &pos, (uint64_t)leading, 5);
+				rrd_tier_write_bits(page->data, &pos, (uint64_t)(length - 1), 6);
+				rrd_tier_write_bits(page->data, &pos, xor >> trailing, length);
+
+				tier->leading = (uint8_t)leading;
+				tier->trailing = (uint8_t)trailing;
+			}
+		}
+	}
+
+	tier->last_t = t;
+	tier->last_value = bits;
+
+	// readers use the header to find how many points they can decode
+	__sync_synchronize();
+	page->bits = pos;
+	page->last_t = t;
+	page->points++;
+}
+
+void rrd_tiers_store(RRD_TIER *tiers, time_t t, int exists, calculated_number value)
+{
+	int i;
+
+	for(i = 0; i < rrd_tiers ; i++) {
+		RRD_TIER *tier = &tiers[i];
+
+		if(likely(tier->group == 1)) {
+			rrd_tier_append(tier, t, (exists) ? (double)value : NAN);
+			continue;
+		}
+
+		// the point of this tier that includes t
+		time_t end_t = t - (t % tier->update_every);
+		if(end_t != t) end_t += tier->update_every;
+
+		if(unlikely(tier->group_end_t && tier->group_end_t != end_t)) {
+			// we missed the last point of the previous group
+			rrd_tier_append(tier, tier->group_end_t, (tier->group_count) ? (double)(tier->group_sum / tier->group_count) : NAN);
+			tier->group_sum = 0;
+			tier->group_count = 0;
+		}
+
+		tier->group_end_t = end_t;
+		if(likely(exists)) {
+			tier->group_sum += value;
+			tier->group_count++;
+		}
+
+		if(end_t == t) {
+			rrd_tier_append(tier, end_t, (tier->group_count) ? (double)(tier->group_sum / tier->group_count) : NAN);
+			tier->group_end_t = 0;
+			tier->group_sum = 0;
+			tier->group_count = 0;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// reading pages
+
+static inline struct rrd_tier_page *rrd_tier_page_get(RRD_TIER *tier, uint64_t sequence)
+{
+	struct rrd_tier_page *page = (struct rrd_tier_page *)&tier->mem[(sequence % tier->pages) * RRD_TIER_PAGE_SIZE];
+
+	if(unlikely(page->magic != RRD_TIER_PAGE_MAGIC
+			|| page->sequence != sequence
+			|| page->update_every != (uint32_t)tier->update_every
+			|| !page->points))
+		return NULL;
+
+	return page;
+}
+
+static inline uint64_t rrd_tier_first_sequence(RRD_TIER *tier)
+{
+	// the oldest page may be recycled any moment, so we skip it
+	return (tier->last_sequence + 2 > (uint64_t)tier->pages) ? tier->last_sequence + 2 - tier->pages : 1;
+}
+
+time_t rrd_tier_first_t(RRD_TIER *tier)
+{
+	uint64_t sequence;
+
+	for(sequence = rrd_tier_first_sequence(tier); sequence <= tier->last_sequence ; sequence++) {
+		struct rrd_tier_page *page = rrd_tier_page_get(tier, sequence);
+		if(page) return (time_t)page->first_t;
+	}
+
+	return 0;
+}
+
+// decode the points between after and before (inclusive)
+// values[(t - after) / update_every] is set for every point found
+long rrd_tier_fetch(RRD_TIER *tier, time_t after, time_t before, double *values)
+{
+	uint64_t sequence;
+	long found = 0;
+
+	for(sequence = rrd_tier_first_sequence(tier); sequence <= tier->last_sequence ; sequence++) {
+		struct rrd_tier_page *page = rrd_tier_page_get(tier, sequence);
+		if(!page || page->last_t < after || page->first_t > before) continue;
+
+		uint32_t points = page->points, i;
+		__sync_synchronize();
+
+		uint32_t pos = 0;
+		uint64_t bits = rrd_tier_read_bits(page->data, &pos, 64);
+		time_t t = (time_t)page->first_t, delta = tier->update_every;
+		int leading = 0, trailing = 0;
+
+		for(i = 0; i < points ; i++) {
+			if(likely(i)) {
+				long long dod;
+
+				if(!rrd_tier_read_bits(page->data, &pos, 1)) dod = 0;
+				else if(!rrd_tier_read_bits(page->data, &pos, 1)) dod = (long long)rrd_tier_read_bits(page->data, &pos, 7) - 63;
+				else if(!rrd_tier_read_bits(page->data, &pos, 1)) dod = (long long)rrd_tier_read_bits(page->data, &pos, 9) - 255;
+				else if(!rrd_tier_read_bits(page->data, &pos, 1)) dod = (long long)rrd_tier_read_bits(page->data, &pos, 12) - 2047;
+				else dod = (int32_t)(uint32_t)rrd_tier_read_bits(page->data, &pos, 32);
+
+				delta += dod;
+				t += delta;
+
+				if(rrd_tier_read_bits(page->data, &pos, 1)) {
+					if(rrd_tier_read_bits(page->data, &pos, 1)) {
+						leading = (int)rrd_tier_read_bits(page->data, &pos, 5);
+						int length = (int)rrd_tier_read_bits(page->data, &pos, 6) + 1;
+						trailing = 64 - leading - length;
+					}
+					bits ^= rrd_tier_read_bits(page->data, &pos, 64 - leading - trailing) << trailing;
+				}
+			}
+
+			if(t > before) break;
+			if(t < after) continue;
+
+			values[(t - after) / tier->update_every] = rrd_tier_bits2double(bits);
+			found++;
+		}
+
+		// the page has been recycled while we were decoding it
+		__sync_synchronize();
+		if(unlikely(page->sequence != sequence || page->magic != RRD_TIER_PAGE_MAGIC)) {
+			debug(D_RRD_STATS, "Storage tier page %llu of '%s' was recycled while being read.", (unsigned long long)sequence, tier->filename);
+			continue;
+		}
+	}
+
+	return found;
+}
+
+// find the best tier to answer a query for st
+// returns -1 when the tiers have no older data than the round robin database
+int rrdset_tier_for_query(RRDSET *st, time_t after, time_t before, time_t *first_t)
+{
+	int i, best = -1, coarsest = -1;
+	time_t best_first_t = 0, coarsest_first_t = 0;
+
+	for(i = 0; i < rrd_tiers ; i++) {
+		time_t tier_first_t = 0;
+		RRDDIM *rd;
+
+		for(rd = st->dimensions; rd ; rd = rd->next) {
+			if(unlikely(!rd->tiers)) return -1;
+
+			time_t t = rrd_tier_first_t(&rd->tiers[i]);
+			if(t && (!tier_first_t || t < tier_first_t)) tier_first_t = t;
+		}
+
+		if(!tier_first_t) continue;
+
+		coarsest = i;
+		coarsest_first_t = tier_first_t;
+
+		// skip the tiers that would decode too many points for this period
+		time_t from = (tier_first_t > after) ? tier_first_t : after;
+		if((before - from) / st->dimensions->tiers[i].update_every > RRD_TIER_QUERY_POINTS_MAX) continue;
+
+		if(best == -1 || tier_first_t < best_first_t) {
+			best = i;
+			best_first_t = tier_first_t;
+		}
+
+		// the finest tier that has all the data we need
+		if(tier_first_t <= after) break;
+	}
+
+	if(best == -1) {
+		best = coarsest;
+		best_first_t = coarsest_first_t;
+	}
+
+	if(best == -1 || best_first_t >= rrdset_first_entry_t(st)) return -1;
+
+	if(first_t) *first_t = best_first_t;
+	return best;
+}
+
+// ----------------------------------------------------------------------------
+// creating and freeing tiers
+
+RRD_TIER *rrd_tiers_create(const char *cache_dir, const char *filename, int update_every)
+{
+	if(!rrd_tiers) return NULL;
+
+	RRD_TIER *tiers = calloc(rrd_tiers, sizeof(RRD_TIER));
+	if(!tiers) {
+		error("Cannot allocate memory for the storage tiers of '%s/%s'.", cache_dir, filename);
+		return NULL;
+	}
+
+	int i, group = 1;
+	for(i = 0; i < rrd_tiers ; i++) {
+		RRD_TIER *tier = &tiers[i];
+
+		group *= rrd_tier_group[i];
+		tier->group = group;
+		tier->update_every = update_every * group;
+		tier->pages = rrd_tier_history[i] / tier->update_every / RRD_TIER_PAGE_POINTS_EXPECTED + 3;
+		tier->memsize = (size_t)tier->pages * RRD_TIER_PAGE_SIZE;
+		tier->leading = RRD_TIER_NO_WINDOW;
+		snprintf(tier->filename, FILENAME_MAX, "%s/%s.tier%d", cache_dir, filename, i);
+
+		if(rrd_memory_mode != RRD_MEMORY_MODE_RAM) {
+			// the pages are written as they are filled, even in save mode
+			tier->mem = mymmap(tier->filename, tier->memsize, MAP_SHARED, 0);
+			if(tier->mem == MAP_FAILED) tier->mem = NULL;
+			if(tier->mem) {
+				tier->mapped = RRD_MEMORY_MODE_MAP;
+
+				// queries read a few pages, not all of them
+				if(madvise(tier->mem, tier->memsize, MADV_RANDOM) != 0)
+					error("Cannot advise the kernel about the memory usage of file '%s'.", tier->filename);
+			}
+		}
+
+		if(!tier->mem) {
+			tier->mem = mmap(NULL, tier->memsize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+			if(tier->mem == MAP_FAILED) {
+				error("Cannot allocate %zu bytes for storage tier %d of '%s/%s'.", tier->memsize, i, cache_dir, filename);
+				tier->mem = NULL;
+				rrd_tiers_free(tiers);
+				return NULL;
+			}
+			tier->mapped = RRD_MEMORY_MODE_RAM;
+		}
+
+		// find where we stopped the last time
+		long slot;
+		for(slot = 0; slot < tier->pages ; slot++) {
+			struct rrd_tier_page *page = (struct rrd_tier_page *)&tier->mem[slot * RRD_TIER_PAGE_SIZE];
+			if(page->magic != RRD_TIER_PAGE_MAGIC) continue;
+
+			if(page->update_every != (uint32_t)tier->update_every || page->sequence % tier->pages != (uint64_t)slot) {
+				errno = 0;
+				error("File %s has a page for a different update frequency or ring size. Ignoring it.", tier->filename);
+				page->magic = 0;
+				continue;
+			}
+
+			if(page->sequence > tier->last_sequence) tier->last_sequence = page->sequence;
+		}
+
+		if(tier->last_sequence) {
+			struct rrd_tier_page *page = rrd_tier_page_get(tier, tier->last_sequence);
+			if(page) tier->last_t = (time_t)page->last_t;
+			info("Loaded %llu pages of storage tier %d from %s.", (unsigned long long)((tier->last_sequence < (uint64_t)tier->pages) ? tier->last_sequence : (uint64_t)tier->pages), i, tier->filename);
+		}
+
+		// we always continue on a new page
+		tier->page = NULL;
+	}
+
+	return tiers;
+}
+
+void rrd_tiers_free(RRD_TIER *tiers)
+{
+	int i;
+
+	if(!tiers) return;
+
+	for(i = 0; i < rrd_tiers ; i++)
+		if(tiers[i].mem) munmap(tiers[i].mem, tiers[i].memsize);
+
+	free(tiers);
+}
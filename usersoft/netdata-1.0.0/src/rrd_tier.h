@@ -0,0 +1,94 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "storage_number.h"
+
+#ifndef NETDATA_RRD_TIER_H
+#define NETDATA_RRD_TIER_H 1
+
+// ----------------------------------------------------------------------------
+// storage tiers
+//
+// the round robin database of each dimension keeps the latest values in RAM.
+// storage tiers keep a much longer history next to it: every tier stores the
+// values of a dimension (tier 0), or their averages over longer periods
+// (tiers 1+), compressed in pages of RRD_TIER_PAGE_SIZE bytes.
+//
+// a page is compressed with the Gorilla encoding: timestamps as
+// delta-of-delta and values as the XOR of their binary representation
+// with the previous value. Regularly collected metrics cost 1 bit per
+// timestamp and a few bits per value.
+//
+// the pages of each tier form a ring, memory mapped to a file in the
+// cache directory of the chart. The kernel page cache keeps the recently
+// used pages in memory.
+
+#define RRD_TIERS_MAX 3
+
+#define RRD_TIER_PAGE_SIZE 4096
+#define RRD_TIER_PAGE_MAGIC 0x4e445450 // "NDTP"
+
+// used to size the ring of pages for the requested history
+// the actual history depends on how well the values compress
+#define RRD_TIER_PAGE_POINTS_EXPECTED 1024
+
+// the maximum number of tier points a query will decode per dimension
+// longer periods are answered from coarser tiers
+#define RRD_TIER_QUERY_POINTS_MAX 86400
+
+#define RRD_TIER_DEFAULT_HISTORY (86400 * 7)
+
+extern int rrd_tiers;
+
+struct rrd_tier_page {
+	uint32_t magic;									// RRD_TIER_PAGE_MAGIC when the page is valid
+	uint32_t update_every;							// the seconds between points of this tier
+	uint64_t sequence;								// the sequence of the page in the ring
+	int64_t first_t;								// the timestamp of the first point in the page
+	int64_t last_t;									// the timestamp of the last point in the page
+	uint32_t points;								// the number of points in the page
+	uint32_t bits;									// the number of bits used in data
+	uint8_t data[];									// the compressed points
+};
+
+typedef struct rrd_tier {
+	int update_every;								// the seconds between points of this tier
+	int group;										// how many collected points make a point of this tier
+
+	int mapped;										// the memory mode of the pages
+	long pages;										// the number of pages in the ring
+	size_t memsize;									// the memory of the ring
+	uint8_t *mem;									// the ring of pages
+	char filename[FILENAME_MAX + 1];				// the file the ring is mapped to
+
+	uint64_t last_sequence;							// the sequence of the page we write to
+	struct rrd_tier_page *page;						// the page we write to
+
+	// the compression state of the page we write to
+	time_t last_t;
+	time_t last_delta;
+	uint64_t last_value;
+	uint8_t leading;
+	uint8_t trailing;
+
+	// the points collected for the next point of this tier
+	time_t group_end_t;
+	calculated_number group_sum;
+	long group_count;
+} RRD_TIER;
+
+struct rrdset;
+
+extern void rrd_tiers_init(void);
+
+extern RRD_TIER *rrd_tiers_create(const char *cache_dir, const char *filename, int update_every);
+extern void rrd_tiers_free(RRD_TIER *tiers);
+extern void rrd_tiers_store(RRD_TIER *tiers, time_t t, int exists, calculated_number value);
+
+extern time_t rrd_tier_first_t(RRD_TIER *tier);
+extern long rrd_tier_fetch(RRD_TIER *tier, time_t after, time_t before, double *values);
+
+extern int rrdset_tier_for_query(struct rrdset *st, time_t after, time_t before, time_t *first_t);
+
+#endif /* NETDATA_RRD_TIER_H */
@@ -84,39 +84,21 @@ storage_number pack_storage_number(calculated_number value, uint32_t flags)
 	return r;
 }
 
+// bit 31 = 0:divide, 1:multiply
+// bit 30, 29, 28 = (multiplier or divider) 0-7
+const calculated_number storage_number_multipliers[16] = {
+	1, 1, 1, 1, 1, 1, 1, 1,
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+const calculated_number storage_number_dividers[16] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+	1, 1, 1, 1, 1, 1, 1, 1
+};
+
 calculated_number unpack_storage_number(storage_number value)
 {
-	if(!value) return 0;
-
-	int sign = 0, exp = 0;
-
-	value ^= get_storage_number_flags(value);
-
-	if(value & (1 << 31)) {
-		sign = 1;
-		value ^= 1 << 31;
-	}
-
-	if(value & (1 << 30)) {
-		exp = 1;
-		value ^= 1 << 30;
-	}
-
-	int mul = value >> 27;
-	value ^= mul << 27;
-
-	calculated_number n = value;
-
-	// fprintf(stderr, "UNPACK: %08X, sign = %d, exp = %d, mul = %d, n = " CALCULATED_NUMBER_FORMAT "\n", value, sign, exp, mul, n);
-
-	while(mul > 0) {
-		if(exp) n *= 10;
-		else n /= 10;
-		mul--;
-	}
-
-	if(sign) n = -n;
-	return n;
+	return storage_number_unpack(value);
 }
 
 #ifdef ENVIRONMENT32
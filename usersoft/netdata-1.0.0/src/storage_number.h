@@ -1,6 +1,8 @@
 #ifndef NETDATA_STORAGE_NUMBER_H
 #define NETDATA_STORAGE_NUMBER_H
 
+#include <stdint.h>
+
 typedef long double calculated_number;
 #define CALCULATED_NUMBER_FORMAT "%0.7Lf"
 //typedef long long calculated_number;
@@ -38,6 +40,20 @@ typedef uint32_t ustorage_number;
 storage_number pack_storage_number(calculated_number value, uint32_t flags);
 calculated_number unpack_storage_number(storage_number value);
 
+// the multiplier and the divider of a packed number, indexed by its bits 31 to 28
+extern const calculated_number storage_number_multipliers[16];
+extern const calculated_number storage_number_dividers[16];
+
+// the inline version of unpack_storage_number(), for loops over many numbers
+static inline calculated_number storage_number_unpack(storage_number value)
+{
+	ustorage_number v = (ustorage_number)value;
+	int m = (v >> 27) & 0x0f;
+
+	calculated_number n = (calculated_number)(v & 0x00ffffff) * storage_number_multipliers[m] / storage_number_dividers[m];
+	return (v & (1U << 31)) ? -n : n;
+}
+
 int print_calculated_number(char *str, calculated_number value);
 
 #define STORAGE_NUMBER_POSITIVE_MAX 167772150000000.0
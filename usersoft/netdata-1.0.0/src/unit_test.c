@@ -5,10 +5,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
+#include <math.h>
 
 #include "common.h"
 #include "storage_number.h"
 #include "rrd.h"
+#include "hash_index.h"
 #include "log.h"
 #include "web_buffer.h"
 
@@ -242,6 +244,180 @@ int unit_test_storage()
 }
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// storage tiers
+
+static calculated_number unit_test_tiers_value(long i)
+{
+	if(i % 1000 < 500) return (calculated_number)(i % 7);
+	if(i % 1000 < 800) return (calculated_number)i * 1.5;
+	return (calculated_number)((i * 7919) % 104729) / 13.0;
+}
+
+int unit_test_tiers()
+{
+	int old_memory_mode = rrd_memory_mode, old_tiers = rrd_tiers;
+	long i, points = 200000, errors = 0;
+	time_t start_t = 1000000000;
+
+	rrd_memory_mode = RRD_MEMORY_MODE_RAM;
+	rrd_tiers = 2;
+
+	RRD_TIER *tiers = rrd_tiers_create("/tmp", "unittest", 1);
+	if(!tiers) {
+		fprintf(stderr, "Cannot create storage tiers.\n");
+		rrd_memory_mode = old_memory_mode;
+		rrd_tiers = old_tiers;
+		return 1;
+	}
+
+	// every 97th point is missing, every 10000th point comes after a gap
+	for(i = 0; i < points ; i++) {
+		time_t t = start_t + i + (i / 10000) * 30;
+		rrd_tiers_store(tiers, t, (i % 97) != 0, unit_test_tiers_value(i));
+	}
+
+	time_t last_t = start_t + points - 1 + ((points - 1) / 10000) * 30;
+	if(rrd_tier_first_t(&tiers[0]) != start_t) {
+		fprintf(stderr, "Storage tier 0 starts at %ld, expected %ld.\n", (long)rrd_tier_first_t(&tiers[0]), (long)start_t);
+		errors++;
+	}
+
+	long count = last_t - start_t + 1;
+	double *values = malloc(count * sizeof(double));
+	for(i = 0; i < count ; i++) values[i] = -1;
+
+	long found = rrd_tier_fetch(&tiers[0], start_t, last_t, values);
+	if(found != points) {
+		fprintf(stderr, "Storage tier 0 returned %ld points, expected %ld.\n", found, points);
+		errors++;
+	}
+
+	for(i = 0; i < points && errors < 10 ; i++) {
+		long slot = i + (i / 10000) * 30;
+		if(i % 97 == 0) {
+			if(!isnan(values[slot])) {
+				fprintf(stderr, "Storage tier 0 point %ld should be empty.\n", i);
+				errors++;
+			}
+		}
+		else if(values[slot] != (double)unit_test_tiers_value(i)) {
+			fprintf(stderr, "Storage tier 0 point %ld is %f, expected %f.\n", i, values[slot], (double)unit_test_tiers_value(i));
+			errors++;
+		}
+	}
+
+	// tier 1 keeps the average of every minute
+	time_t t;
+	for(t = start_t - (start_t % 60) + 60; t + 60 <= start_t + 10000 && errors < 10 ; t += 60) {
+		double v = -1, sum = 0;
+		long n = 0;
+
+		for(i = t - 59 - start_t; i <= t - start_t ; i++) {
+			if(i < 0 || i % 97 == 0) continue;
+			sum += (double)unit_test_tiers_value(i);
+			n++;
+		}
+
+		rrd_tier_fetch(&tiers[1], t, t, &v);
+		if(n && fabs(v - sum / n) > 0.000001) {
+			fprintf(stderr, "Storage tier 1 point at %ld is %f, expected %f.\n", (long)t, v, sum / n);
+			errors++;
+		}
+	}
+
+	fprintf(stderr, "Storage tiers: %ld points in %llu pages of %d bytes (%0.2f bytes per point).\n"
+			, points
+			, (unsigned long long)tiers[0].last_sequence
+			, RRD_TIER_PAGE_SIZE
+			, (double)(tiers[0].last_sequence * RRD_TIER_PAGE_SIZE) / (double)points
+			);
+
+	free(values);
+	rrd_tiers_free(tiers);
+
+	rrd_memory_mode = old_memory_mode;
+	rrd_tiers = old_tiers;
+
+	return (errors)?1:0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// hash index
+
+#define UNIT_TEST_HASH_INDEX_KEYS 100000
+
+static hash_index unit_test_index = HASH_INDEX_INITIALIZER;
+static char unit_test_index_keys[UNIT_TEST_HASH_INDEX_KEYS][20];
+static volatile long unit_test_index_added = 0;
+
+// a lookup must find every key added before it started, while the index grows
+static void *unit_test_hash_index_reader(void *ptr)
+{
+	long *errors = ptr, i;
+
+	while(unit_test_index_added < UNIT_TEST_HASH_INDEX_KEYS) {
+		long added = unit_test_index_added;
+		for(i = added - 1; i >= 0 && i >= added - 1000 ; i--) {
+			if(hash_index_find(&unit_test_index, simple_hash(unit_test_index_keys[i]), unit_test_index_keys[i]) != unit_test_index_keys[i])
+				(*errors)++;
+		}
+	}
+
+	return NULL;
+}
+
+int unit_test_hash_index()
+{
+	long i, errors = 0, reader_errors = 0;
+	pthread_t reader;
+
+	for(i = 0; i < UNIT_TEST_HASH_INDEX_KEYS ; i++)
+		snprintf(unit_test_index_keys[i], 20, "key%ld", i);
+
+	if(pthread_create(&reader, NULL, unit_test_hash_index_reader, &reader_errors)) {
+		fprintf(stderr, "Cannot create hash index reader thread.\n");
+		return 1;
+	}
+
+	for(i = 0; i < UNIT_TEST_HASH_INDEX_KEYS ; i++) {
+		if(hash_index_add(&unit_test_index, simple_hash(unit_test_index_keys[i]), unit_test_index_keys[i], unit_test_index_keys[i]) != unit_test_index_keys[i])
+			errors++;
+
+		__sync_synchronize();
+		unit_test_index_added = i + 1;
+	}
+
+	pthread_join(reader, NULL);
+
+	// adding a key again returns the item already indexed
+	char *dup = strdup(unit_test_index_keys[10]);
+	if(hash_index_add(&unit_test_index, simple_hash(dup), dup, dup) != unit_test_index_keys[10])
+		errors++;
+	free(dup);
+
+	for(i = 0; i < UNIT_TEST_HASH_INDEX_KEYS ; i += 2)
+		if(hash_index_del(&unit_test_index, simple_hash(unit_test_index_keys[i]), unit_test_index_keys[i]) != unit_test_index_keys[i])
+			errors++;
+
+	for(i = 0; i < UNIT_TEST_HASH_INDEX_KEYS ; i++) {
+		void *found = hash_index_find(&unit_test_index, simple_hash(unit_test_index_keys[i]), unit_test_index_keys[i]);
+		if(found != ((i % 2)?unit_test_index_keys[i]:NULL))
+			errors++;
+	}
+
+	fprintf(stderr, "Hash index: %zu entries in %u buckets, %ld errors, %ld concurrent lookup errors.\n"
+			, unit_test_index.entries
+			, unit_test_index.table->mask + 1
+			, errors
+			, reader_errors
+			);
+
+	hash_index_destroy(&unit_test_index);
+
+	return (errors || reader_errors)?1:0;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 struct feed_values {
@@ -2,6 +2,8 @@
 #define NETDATA_UNIT_TEST_H 1
 
 extern int unit_test_storage(void);
+extern int unit_test_tiers(void);
+extern int unit_test_hash_index(void);
 extern int unit_test(long delay, long shift);
 extern int run_all_mockup_tests(void);
 
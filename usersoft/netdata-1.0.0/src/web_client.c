@@ -15,6 +15,7 @@
 #include <malloc.h>
 #include <pwd.h>
 #include <ctype.h>
+#include <sys/sendfile.h>
 
 #include "common.h"
 #include "log.h"
@@ -36,20 +37,138 @@ int web_enable_gzip = 1;
 
 extern int netdata_exit;
 
-struct web_client *web_clients = NULL;
 unsigned long long web_clients_count = 0;
 
+// closed clients are kept here (with their buffers) to be reused by new connections
+#define WEB_CLIENTS_FREE_LIST_MAX 100
+#define WEB_CLIENTS_FREE_LIST_MAX_DATA_SIZE (INITIAL_WEB_DATA_LENGTH * 16)
+static struct web_client *web_clients_free_list = NULL;
+static int web_clients_free_list_count = 0;
+static pthread_mutex_t web_clients_free_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct web_client *web_client_get_from_free_list(void)
+{
+	struct web_client *w;
+
+	pthread_mutex_lock(&web_clients_free_list_mutex);
+	w = web_clients_free_list;
+	if(w) {
+		web_clients_free_list = w->next;
+		web_clients_free_list_count--;
+	}
+	pthread_mutex_unlock(&web_clients_free_list_mutex);
+
+	if(w) {
+		BUFFER *header_output = w->response.header_output;
+		BUFFER *header = w->response.header;
+		BUFFER *data = w->response.data;
+
+		memset(w, 0, sizeof(struct web_client));
+
+		w->response.header_output = header_output;
+		w->response.header = header;
+		w->response.data = data;
+	}
+
+	return w;
+}
+
+static int web_client_add_to_free_list(struct web_client *w)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&web_clients_free_list_mutex);
+	if(web_clients_free_list_count < WEB_CLIENTS_FREE_LIST_MAX) {
+		w->prev = NULL;
+		w->next = web_clients_free_list;
+		web_clients_free_list = w;
+		web_clients_free_list_count++;
+		ret = 1;
+	}
+	pthread_mutex_unlock(&web_clients_free_list_mutex);
+
+	return ret;
+}
+
+#ifdef NETDATA_WITH_ZLIB
+// compression streams are kept here to be reused by the next compressed responses
+// deflateInit2() allocates about 256KB per stream, deflateReset() just clears it
+#define WEB_CLIENT_ZSTREAMS_FREE_LIST_MAX 16
+struct web_client_zstream {
+	z_stream zstream;				// must be the first member
+	struct web_client_zstream *next;
+};
+static struct web_client_zstream *web_client_zstreams_free_list = NULL;
+static int web_client_zstreams_free_list_count = 0;
+static pthread_mutex_t web_client_zstreams_free_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static z_stream *web_client_zstream_get(void)
+{
+	struct web_client_zstream *z;
+
+	pthread_mutex_lock(&web_client_zstreams_free_list_mutex);
+	z = web_client_zstreams_free_list;
+	if(z) {
+		web_client_zstreams_free_list = z->next;
+		web_client_zstreams_free_list_count--;
+	}
+	pthread_mutex_unlock(&web_client_zstreams_free_list_mutex);
+
+	if(z) {
+		if(deflateReset(&z->zstream) == Z_OK) return &z->zstream;
+
+		deflateEnd(&z->zstream);
+		free(z);
+	}
+
+	z = calloc(1, sizeof(struct web_client_zstream));
+	if(!z) return NULL;
+
+	z->zstream.zalloc = Z_NULL;
+	z->zstream.zfree = Z_NULL;
+	z->zstream.opaque = Z_NULL;
+
+	// Select GZIP compression: windowbits = 15 + 16 = 31
+	if(deflateInit2(&z->zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		free(z);
+		return NULL;
+	}
+
+	return &z->zstream;
+}
+
+static void web_client_zstream_release(z_stream *zstream)
+{
+	struct web_client_zstream *z = (struct web_client_zstream *)zstream;
+
+	pthread_mutex_lock(&web_client_zstreams_free_list_mutex);
+	if(web_client_zstreams_free_list_count < WEB_CLIENT_ZSTREAMS_FREE_LIST_MAX) {
+		z->next = web_client_zstreams_free_list;
+		web_client_zstreams_free_list = z;
+		web_client_zstreams_free_list_count++;
+		z = NULL;
+	}
+	pthread_mutex_unlock(&web_client_zstreams_free_list_mutex);
+
+	if(z) {
+		deflateEnd(&z->zstream);
+		free(z);
+	}
+}
+#endif // NETDATA_WITH_ZLIB
+
 struct web_client *web_client_create(int listener)
 {
 	struct web_client *w;
 
-	w = calloc(1, sizeof(struct web_client));
+	w = web_client_get_from_free_list();
+	if(!w) w = calloc(1, sizeof(struct web_client));
 	if(!w) {
 		error("Cannot allocate new web_client memory.");
 		return NULL;
 	}
 
-	w->id = ++web_clients_count;
+	w->id = __sync_add_and_fetch(&web_clients_count, 1);
 	w->mode = WEB_CLIENT_MODE_NORMAL;
 
 	{
@@ -62,6 +181,9 @@ struct web_client *web_client_create(int listener)
 		w->ifd = accept(listener, sadr, &addrlen);
 		if (w->ifd == -1) {
 			error("%llu: Cannot accept new incoming connection.", w->id);
+			if(w->response.data) buffer_free(w->response.data);
+			if(w->response.header) buffer_free(w->response.header);
+			if(w->response.header_output) buffer_free(w->response.header_output);
 			free(w);
 			return NULL;
 		}
@@ -98,6 +220,9 @@ struct web_client *web_client_create(int listener)
 		if(setsockopt(w->ifd, SOL_SOCKET, SO_KEEPALIVE, (char *) &flag, sizeof(int)) != 0) error("%llu: Cannot set SO_KEEPALIVE on socket.", w->id);
 	}
 
+	// a reused client has its buffers already
+	if(w->response.data) goto ready;
+
 	w->response.data = buffer_create(INITIAL_WEB_DATA_LENGTH);
 	if(unlikely(!w->response.data)) {
 		// no need for error log - web_buffer_create already logged the error
@@ -125,13 +250,11 @@ struct web_client *web_client_create(int listener)
 		return NULL;
 	}
 
+ready:
 	w->wait_receive = 1;
+	w->last_activity = time(NULL);
 
-	if(web_clients) web_clients->prev = w;
-	w->next = web_clients;
-	web_clients = w;
-
-	global_statistics.connected_clients++;
+	__sync_add_and_fetch(&global_statistics.connected_clients, 1);
 
 	return(w);
 }
@@ -144,7 +267,7 @@ void web_client_reset(struct web_client *w)
 	long sent = (w->mode == WEB_CLIENT_MODE_FILECOPY)?w->response.rlen:w->response.data->len;
 
 #ifdef NETDATA_WITH_ZLIB
-	if(likely(w->response.zoutput)) sent = (long)w->response.zstream.total_out;
+	if(likely(w->response.zoutput)) sent = (long)w->response.zstream->total_out;
 #endif
 
 	long size = (w->mode == WEB_CLIENT_MODE_FILECOPY)?w->response.rlen:w->response.data->len;
@@ -169,6 +292,14 @@ void web_client_reset(struct web_client *w)
 		w->ifd = w->ofd;
 	}
 
+	if(unlikely(w->response.use_sendfile)) {
+		int flags = fcntl(w->ofd, F_GETFL);
+		if(flags == -1 || fcntl(w->ofd, F_SETFL, flags & ~O_NONBLOCK) == -1)
+			error("%llu: Cannot restore the blocking mode of the socket.", w->id);
+
+		w->response.use_sendfile = 0;
+	}
+
 	w->last_url[0] = '\0';
 
 	w->mode = WEB_CLIENT_MODE_NORMAL;
@@ -183,45 +314,40 @@ void web_client_reset(struct web_client *w)
 	w->wait_receive = 1;
 	w->wait_send = 0;
 
+	w->response.zaccepted = 0;
 	w->response.zoutput = 0;
 
 	// if we had enabled compression, release it
 #ifdef NETDATA_WITH_ZLIB
 	if(w->response.zinitialized) {
 		debug(D_DEFLATE, "%llu: Reseting compression.", w->id);
-		deflateEnd(&w->response.zstream);
+		web_client_zstream_release(w->response.zstream);
+		w->response.zstream = NULL;
 		w->response.zsent = 0;
 		w->response.zhave = 0;
-		w->response.zstream.avail_in = 0;
-		w->response.zstream.avail_out = 0;
-		w->response.zstream.total_in = 0;
-		w->response.zstream.total_out = 0;
 		w->response.zinitialized = 0;
 	}
 #endif // NETDATA_WITH_ZLIB
 }
 
-struct web_client *web_client_free(struct web_client *w)
+// the client should already be reset and removed from its web server worker
+void web_client_free(struct web_client *w)
 {
-	struct web_client *n = w->next;
-
 	debug(D_WEB_CLIENT_ACCESS, "%llu: Closing web client from %s port %s.", w->id, w->client_ip, w->client_port);
 
-	if(w->prev)	w->prev->next = w->next;
-	if(w->next) w->next->prev = w->prev;
+	close(w->ifd);
+	if(w->ofd != w->ifd) close(w->ofd);
+
+	__sync_sub_and_fetch(&global_statistics.connected_clients, 1);
 
-	if(w == web_clients) web_clients = w->next;
+	// keep it, with its buffers, for the next connection
+	// unless a big response left a big buffer behind
+	if(w->response.data->size <= WEB_CLIENTS_FREE_LIST_MAX_DATA_SIZE && web_client_add_to_free_list(w)) return;
 
 	if(w->response.header_output) buffer_free(w->response.header_output);
 	if(w->response.header) buffer_free(w->response.header);
 	if(w->response.data) buffer_free(w->response.data);
-	close(w->ifd);
-	if(w->ofd != w->ifd) close(w->ofd);
 	free(w);
-
-	global_statistics.connected_clients--;
-
-	return(n);
 }
 
 uid_t web_files_uid(void)
@@ -310,6 +436,25 @@ int mysendfile(struct web_client *w, char *filename)
 		return 403;
 	}
 
+	// a precompressed copy of the file, not older than it, is sent as it is
+	int precompressed = 0;
+	{
+		char gzfilename[FILENAME_MAX + 1];
+		struct stat gzstat;
+
+		snprintf(gzfilename, FILENAME_MAX, "%s.gz", webfilename);
+		if(lstat(gzfilename, &gzstat) == 0 && (gzstat.st_mode & S_IFMT) == S_IFREG && gzstat.st_uid == web_files_uid() && gzstat.st_mtime >= stat.st_mtime) {
+			buffer_strcat(w->response.header, "Vary: Accept-Encoding\r\n");
+
+			if(w->response.zaccepted) {
+				debug(D_WEB_CLIENT, "%llu: Sending the precompressed file '%s'.", w->id, gzfilename);
+				strcpy(webfilename, gzfilename);
+				stat = gzstat;
+				precompressed = 1;
+			}
+		}
+	}
+
 	// open the file
 	w->ifd = open(webfilename, O_NONBLOCK, O_RDONLY);
 	if(w->ifd == -1) {
@@ -352,6 +497,13 @@ int mysendfile(struct web_client *w, char *filename)
 
 	debug(D_WEB_CLIENT_ACCESS, "%llu: Sending file '%s' (%ld bytes, ifd %d, ofd %d).", w->id, webfilename, stat.st_size, w->ifd, w->ofd);
 
+	if(precompressed) {
+		buffer_strcat(w->response.header, "Content-Encoding: gzip\r\n");
+
+		// do not compress it again
+		w->response.zaccepted = 0;
+	}
+
 	w->mode = WEB_CLIENT_MODE_FILECOPY;
 	w->wait_receive = 1;
 	w->wait_send = 0;
@@ -375,39 +527,51 @@ void web_client_enable_deflate(struct web_client *w) {
 		return;
 	}
 
-	w->response.zstream.zalloc = Z_NULL;
-	w->response.zstream.zfree = Z_NULL;
-	w->response.zstream.opaque = Z_NULL;
-
-	w->response.zstream.next_in = (Bytef *)w->response.data->buffer;
-	w->response.zstream.avail_in = 0;
-	w->response.zstream.total_in = 0;
-
-	w->response.zstream.next_out = w->response.zbuffer;
-	w->response.zstream.avail_out = 0;
-	w->response.zstream.total_out = 0;
-
-	w->response.zstream.zalloc = Z_NULL;
-	w->response.zstream.zfree = Z_NULL;
-	w->response.zstream.opaque = Z_NULL;
-
-//	if(deflateInit(&w->response.zstream, Z_DEFAULT_COMPRESSION) != Z_OK) {
-//		error("%llu: Failed to initialize zlib. Proceeding without compression.", w->id);
-//		return;
-//	}
-
-	// Select GZIP compression: windowbits = 15 + 16 = 31
-	if(deflateInit2(&w->response.zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+	w->response.zstream = web_client_zstream_get();
+	if(!w->response.zstream) {
 		error("%llu: Failed to initialize zlib. Proceeding without compression.", w->id);
 		return;
 	}
 
+	w->response.zstream->next_in = (Bytef *)w->response.data->buffer;
+	w->response.zstream->avail_in = 0;
+	w->response.zstream->total_in = 0;
+
+	w->response.zstream->next_out = w->response.zbuffer;
+	w->response.zstream->avail_out = 0;
+	w->response.zstream->total_out = 0;
+
 	w->response.zsent = 0;
+	w->response.zhave = 0;
 	w->response.zoutput = 1;
 	w->response.zinitialized = 1;
 
 	debug(D_DEFLATE, "%llu: Initialized compression.", w->id);
 }
+
+// small responses are not worth the CPU, and compressed formats do not shrink
+static int web_client_response_compressible(struct web_client *w)
+{
+	switch(w->response.data->contenttype) {
+		case CT_IMAGE_PNG:
+		case CT_IMAGE_JPG:
+		case CT_IMAGE_GIF:
+		case CT_APPLICATION_FONT_WOFF:
+		case CT_APPLICATION_FONT_WOFF2:
+			return 0;
+
+		default:
+			break;
+	}
+
+	if(w->mode == WEB_CLIENT_MODE_FILECOPY)
+		return w->response.rlen >= WEB_CLIENT_ZLIB_MIN_SIZE;
+
+	if(w->mode == WEB_CLIENT_MODE_NORMAL)
+		return w->response.data->len >= WEB_CLIENT_ZLIB_MIN_SIZE;
+
+	return 0;
+}
 #endif // NETDATA_WITH_ZLIB
 
 uint32_t web_client_api_request_v1_data_options(char *o)
@@ -440,6 +604,8 @@ uint32_t web_client_api_request_v1_data_options(char *o)
 			ret |= RRDR_OPTION_GOOGLE_JSON;
 		else if(!strcmp(tok, "percentage"))
 			ret |= RRDR_OPTION_PERCENTAGE;
+		else if(!strcmp(tok, "newer"))
+			ret |= RRDR_OPTION_NEWER;
 	}
 
 	return ret;
@@ -983,7 +1149,6 @@ cleanup:
 void web_client_process(struct web_client *w) {
 	int code = 500;
 	ssize_t bytes;
-	int enable_gzip = 0;
 
 	w->wait_receive = 0;
 
@@ -1003,7 +1168,7 @@ void web_client_process(struct web_client *w) {
 #ifdef NETDATA_WITH_ZLIB
 		// check if the client accepts deflate
 		if(web_enable_gzip && strstr(w->response.data->buffer, "gzip"))
-			enable_gzip = 1;
+			w->response.zaccepted = 1;
 #endif // NETDATA_WITH_ZLIB
 
 		int datasource_type = DATASOURCE_DATATABLE_JSONP;
@@ -1047,11 +1212,6 @@ void web_client_process(struct web_client *w) {
 			buffer_strcat(w->response.data, "OK");
 		}
 		else if(url) {
-#ifdef NETDATA_WITH_ZLIB
-			if(enable_gzip)
-				web_client_enable_deflate(w);
-#endif
-
 			strncpy(w->last_url, url, URL_MAX);
 			w->last_url[URL_MAX] = '\0';
 
@@ -1212,6 +1372,11 @@ void web_client_process(struct web_client *w) {
 	w->response.sent = 0;
 	w->response.code = code;
 
+#ifdef NETDATA_WITH_ZLIB
+	if(w->response.zaccepted && web_client_response_compressible(w))
+		web_client_enable_deflate(w);
+#endif
+
 	// prepare the HTTP response header
 	debug(D_WEB_CLIENT, "%llu: Generating HTTP header with response %d.", w->id, code);
 
@@ -1436,16 +1601,18 @@ void web_client_process(struct web_client *w) {
 				debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending data file of %d bytes to client.", w->id, w->response.rlen);
 				w->wait_receive = 1;
 
-				/*
-				// utilize the kernel sendfile() for copying the file to the socket.
-				// this block of code can be commented, without anything missing.
-				// when it is commented, the program will copy the data using async I/O.
-				{
-					long len = sendfile(w->ofd, w->ifd, NULL, w->response.data->rbytes);
-					if(len != w->response.data->rbytes) error("%llu: sendfile() should copy %ld bytes, but copied %ld. Falling back to manual copy.", w->id, w->response.data->rbytes, len);
-					else web_client_reset(w);
+				// when the file is sent as it is, the kernel copies it to the socket.
+				// sendfile() must not block the web server worker, so the socket
+				// is non-blocking until the response is sent.
+				if(!w->response.zoutput) {
+					int flags = fcntl(w->ofd, F_GETFL);
+					if(flags != -1 && fcntl(w->ofd, F_SETFL, flags | O_NONBLOCK) != -1) {
+						w->response.use_sendfile = 1;
+						w->wait_receive = 0;
+						w->wait_send = 1;
+					}
+					else error("%llu: Cannot make the socket non-blocking. Copying the file with read().", w->id);
 				}
-				*/
 			}
 			else
 				debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending an unknown amount of bytes to client.", w->id);
@@ -1505,9 +1672,9 @@ long web_client_send_deflate(struct web_client *w)
 	// when using compression,
 	// w->response.sent is the amount of bytes passed through compression
 
-	debug(D_DEFLATE, "%llu: web_client_send_deflate(): w->response.data->len = %d, w->response.sent = %d, w->response.zhave = %d, w->response.zsent = %d, w->response.zstream.avail_in = %d, w->response.zstream.avail_out = %d, w->response.zstream.total_in = %d, w->response.zstream.total_out = %d.", w->id, w->response.data->len, w->response.sent, w->response.zhave, w->response.zsent, w->response.zstream.avail_in, w->response.zstream.avail_out, w->response.zstream.total_in, w->response.zstream.total_out);
+	debug(D_DEFLATE, "%llu: web_client_send_deflate(): w->response.data->len = %d, w->response.sent = %d, w->response.zhave = %d, w->response.zsent = %d, w->response.zstream->avail_in = %d, w->response.zstream->avail_out = %d, w->response.zstream->total_in = %d, w->response.zstream->total_out = %d.", w->id, w->response.data->len, w->response.sent, w->response.zhave, w->response.zsent, w->response.zstream->avail_in, w->response.zstream->avail_out, w->response.zstream->total_in, w->response.zstream->total_out);
 
-	if(w->response.data->len - w->response.sent == 0 && w->response.zstream.avail_in == 0 && w->response.zhave == w->response.zsent && w->response.zstream.avail_out != 0) {
+	if(w->response.data->len - w->response.sent == 0 && w->response.zstream->avail_in == 0 && w->response.zhave == w->response.zsent && w->response.zstream->avail_out != 0) {
 		// there is nothing to send
 
 		debug(D_WEB_CLIENT, "%llu: Out of output data.", w->id);
@@ -1545,21 +1712,21 @@ long web_client_send_deflate(struct web_client *w)
 		// close the previous open chunk
 		if(w->response.sent != 0) t += web_client_send_chunk_close(w);
 
-		debug(D_DEFLATE, "%llu: Compressing %d new bytes starting from %d (and %d left behind).", w->id, (w->response.data->len - w->response.sent), w->response.sent, w->response.zstream.avail_in);
+		debug(D_DEFLATE, "%llu: Compressing %d new bytes starting from %d (and %d left behind).", w->id, (w->response.data->len - w->response.sent), w->response.sent, w->response.zstream->avail_in);
 
 		// give the compressor all the data not passed through the compressor yet
 		if(w->response.data->len > w->response.sent) {
 #ifdef NETDATA_INTERNAL_CHECKS
-			if((long)w->response.sent - (long)w->response.zstream.avail_in < 0)
+			if((long)w->response.sent - (long)w->response.zstream->avail_in < 0)
 				error("internal error: avail_in is corrupted.");
 #endif
-			w->response.zstream.next_in = (Bytef *)&w->response.data->buffer[w->response.sent - w->response.zstream.avail_in];
-			w->response.zstream.avail_in += (uInt) (w->response.data->len - w->response.sent);
+			w->response.zstream->next_in = (Bytef *)&w->response.data->buffer[w->response.sent - w->response.zstream->avail_in];
+			w->response.zstream->avail_in += (uInt) (w->response.data->len - w->response.sent);
 		}
 
 		// reset the compressor output buffer
-		w->response.zstream.next_out = w->response.zbuffer;
-		w->response.zstream.avail_out = ZLIB_CHUNK;
+		w->response.zstream->next_out = w->response.zbuffer;
+		w->response.zstream->avail_out = ZLIB_CHUNK;
 
 		// ask for FINISH if we have all the input
 		int flush = Z_SYNC_FLUSH;
@@ -1573,13 +1740,13 @@ long web_client_send_deflate(struct web_client *w)
 		}
 
 		// compress
-		if(deflate(&w->response.zstream, flush) == Z_STREAM_ERROR) {
+		if(deflate(w->response.zstream, flush) == Z_STREAM_ERROR) {
 			error("%llu: Compression failed. Closing down client.", w->id);
 			web_client_reset(w);
 			return(-1);
 		}
 
-		w->response.zhave = ZLIB_CHUNK - w->response.zstream.avail_out;
+		w->response.zhave = ZLIB_CHUNK - w->response.zstream->avail_out;
 		w->response.zsent = 0;
 
 		// keep track of the bytes passed through the compressor
@@ -1606,8 +1773,47 @@ long web_client_send_deflate(struct web_client *w)
 }
 #endif // NETDATA_WITH_ZLIB
 
+long web_client_sendfile(struct web_client *w)
+{
+	if(unlikely(w->response.sent >= w->response.rlen)) {
+		// there is nothing to send
+
+		debug(D_WEB_CLIENT, "%llu: Out of output data.", w->id);
+
+		if(unlikely(w->keepalive == 0)) {
+			debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %ld bytes sent.", w->id, w->response.sent);
+			errno = 0;
+			return(-1);
+		}
+
+		web_client_reset(w);
+		debug(D_WEB_CLIENT, "%llu: Done sending all data on socket. Waiting for next request on the same socket.", w->id);
+		return(0);
+	}
+
+	off_t offset = (off_t)w->response.sent;
+	ssize_t bytes = sendfile(w->ofd, w->ifd, &offset, w->response.rlen - w->response.sent);
+	if(likely(bytes > 0)) {
+		w->response.sent += bytes;
+		debug(D_WEB_CLIENT, "%llu: Sent %d bytes with sendfile().", w->id, bytes);
+	}
+	else if(likely(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+		debug(D_WEB_CLIENT, "%llu: Did not send any bytes to the client.", w->id);
+		bytes = 0;
+	}
+	else {
+		// the file got shorter, or the client is gone
+		debug(D_WEB_CLIENT, "%llu: Failed to send file to client.", w->id);
+		bytes = -1;
+	}
+
+	return(bytes);
+}
+
 long web_client_send(struct web_client *w)
 {
+	if(unlikely(w->response.use_sendfile)) return web_client_sendfile(w);
+
 #ifdef NETDATA_WITH_ZLIB
 	if(likely(w->response.zoutput)) return web_client_send_deflate(w);
 #endif // NETDATA_WITH_ZLIB
@@ -1702,113 +1908,58 @@ long web_client_receive(struct web_client *w)
 
 
 // --------------------------------------------------------------------------------------
-// the thread of a single client
+// async I/O of a single client, called by the web server worker that owns it
 
-// 1. waits for input and output, using async I/O
+// 1. it receives requests and sends responses, when the socket is ready for them
 // 2. it processes HTTP requests
 // 3. it generates HTTP responses
 // 4. it copies data from input to output if mode is FILECOPY
 
-void *web_client_main(void *ptr)
+// files cannot be watched by epoll - they are always ready for reading
+int web_client_file_input_pending(struct web_client *w)
 {
-	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
-		error("Cannot set pthread cancel type to DEFERRED.");
-
-	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
-		error("Cannot set pthread cancel state to ENABLE.");
-
-	struct timeval tv;
-	struct web_client *w = ptr;
-	int retval;
-	fd_set ifds, ofds, efds;
-	int fdmax = 0;
-
-	log_access("%llu: %s port %s connected on thread task id %d", w->id, w->client_ip, w->client_port, gettid());
-
-	for(;;) {
-		FD_ZERO (&ifds);
-		FD_ZERO (&ofds);
-		FD_ZERO (&efds);
-
-		FD_SET(w->ifd, &efds);
-
-		if(w->ifd != w->ofd)
-			FD_SET(w->ofd, &efds);
+	return (w->mode == WEB_CLIENT_MODE_FILECOPY && w->wait_receive && w->ifd != w->ofd);
+}
 
-		if (w->wait_receive) {
-			FD_SET(w->ifd, &ifds);
-			if(w->ifd > fdmax) fdmax = w->ifd;
-		}
+// returns -1 when the client has to be disconnected
+int web_client_handle_io(struct web_client *w, int can_receive, int can_send)
+{
+	if(web_client_file_input_pending(w)) can_receive = 1;
 
-		if (w->wait_send) {
-			FD_SET(w->ofd, &ofds);
-			if(w->ofd > fdmax) fdmax = w->ofd;
+	if(w->wait_send && can_send) {
+		long bytes;
+		if((bytes = web_client_send(w)) < 0) {
+			debug(D_WEB_CLIENT, "%llu: Cannot send data to client. Closing client.", w->id);
+			errno = 0;
+			return -1;
 		}
 
-		tv.tv_sec = web_client_timeout;
-		tv.tv_usec = 0;
-
-		debug(D_WEB_CLIENT, "%llu: Waiting socket async I/O for %s %s", w->id, w->wait_receive?"INPUT":"", w->wait_send?"OUTPUT":"");
-		retval = select(fdmax+1, &ifds, &ofds, &efds, &tv);
-
-		if(retval == -1) {
-			debug(D_WEB_CLIENT_ACCESS, "%llu: LISTENER: select() failed.", w->id);
-			continue;
-		}
-		else if(!retval) {
-			// timeout
-			debug(D_WEB_CLIENT_ACCESS, "%llu: LISTENER: timeout.", w->id);
-			break;
-		}
+		if(bytes > 0) w->last_activity = time(NULL);
 
-		if(FD_ISSET(w->ifd, &efds)) {
-			debug(D_WEB_CLIENT_ACCESS, "%llu: Received error on input socket.", w->id);
-			break;
-		}
+		global_statistics_lock();
+		global_statistics.bytes_sent += bytes;
+		global_statistics_unlock();
+	}
 
-		if(FD_ISSET(w->ofd, &efds)) {
-			debug(D_WEB_CLIENT_ACCESS, "%llu: Received error on output socket.", w->id);
-			break;
+	if(w->wait_receive && can_receive) {
+		long bytes;
+		if((bytes = web_client_receive(w)) < 0) {
+			debug(D_WEB_CLIENT, "%llu: Cannot receive data from client. Closing client.", w->id);
+			errno = 0;
+			return -1;
 		}
 
-		if(w->wait_send && FD_ISSET(w->ofd, &ofds)) {
-			long bytes;
-			if((bytes = web_client_send(w)) < 0) {
-				debug(D_WEB_CLIENT, "%llu: Cannot send data to client. Closing client.", w->id);
-				errno = 0;
-				break;
-			}
+		if(bytes > 0) w->last_activity = time(NULL);
 
-			global_statistics_lock();
-			global_statistics.bytes_sent += bytes;
-			global_statistics_unlock();
+		if(w->mode == WEB_CLIENT_MODE_NORMAL) {
+			debug(D_WEB_CLIENT, "%llu: Attempting to process received data (%ld bytes).", w->id, bytes);
+			web_client_process(w);
 		}
 
-		if(w->wait_receive && FD_ISSET(w->ifd, &ifds)) {
-			long bytes;
-			if((bytes = web_client_receive(w)) < 0) {
-				debug(D_WEB_CLIENT, "%llu: Cannot receive data from client. Closing client.", w->id);
-				errno = 0;
-				break;
-			}
-
-			if(w->mode == WEB_CLIENT_MODE_NORMAL) {
-				debug(D_WEB_CLIENT, "%llu: Attempting to process received data (%ld bytes).", w->id, bytes);
-				// info("%llu: Attempting to process received data (%ld bytes).", w->id, bytes);
-				web_client_process(w);
-			}
-
-			global_statistics_lock();
-			global_statistics.bytes_received += bytes;
-			global_statistics_unlock();
-		}
+		global_statistics_lock();
+		global_statistics.bytes_received += bytes;
+		global_statistics_unlock();
 	}
 
-	log_access("%llu: %s port %s disconnected from thread task id %d", w->id, w->client_ip, w->client_port, gettid());
-	debug(D_WEB_CLIENT, "%llu: done...", w->id);
-
-	web_client_reset(w);
-	w->obsolete = 1;
-
-	return NULL;
+	return 0;
 }
@@ -25,6 +25,7 @@ extern int web_enable_gzip;
 
 #define URL_MAX 8192
 #define ZLIB_CHUNK 	16384
+#define WEB_CLIENT_ZLIB_MIN_SIZE 1024	// smaller responses are sent uncompressed
 #define HTTP_RESPONSE_HEADER_SIZE 4096
 
 struct response {
@@ -37,9 +38,12 @@ struct response {
 	size_t rlen;					// if non-zero, the excepted size of ifd (input)
 	size_t sent;					// current data length sent to output
 
+	int use_sendfile;				// if set to 1, web_client_send() will copy the file with sendfile()
+
+	int zaccepted;					// if set to 1, the client accepts gzip encoded responses
 	int zoutput;					// if set to 1, web_client_send() will send compressed data
 #ifdef NETDATA_WITH_ZLIB
-	z_stream zstream;				// zlib stream for sending compressed output to client
+	z_stream *zstream;				// zlib stream for sending compressed output to client
 	Bytef zbuffer[ZLIB_CHUNK];		// temporary buffer for storing compressed output
 	long zsent;						// the compressed bytes we have sent to the client
 	long zhave;						// the compressed bytes that we have to send
@@ -63,8 +67,9 @@ struct web_client {
 
 	struct sockaddr_storage clientaddr;
 
-	pthread_t thread;				// the thread servicing this client
-	int obsolete;					// if set to 1, the listener will remove this client
+	int obsolete;					// if set to 1, the web server worker will remove this client
+	time_t last_activity;			// the last time we received or sent data, for disconnecting idle clients
+	uint32_t events;				// the epoll events the web server worker is waiting for
 
 	int ifd;
 	int ofd;
@@ -74,17 +79,17 @@ struct web_client {
 	int wait_receive;
 	int wait_send;
 
-	struct web_client *prev;
+	struct web_client *prev;		// the list of clients of a web server worker
 	struct web_client *next;
 };
 
-extern struct web_client *web_clients;
-
 extern uid_t web_files_uid(void);
 
 extern struct web_client *web_client_create(int listener);
-extern struct web_client *web_client_free(struct web_client *w);
+extern void web_client_reset(struct web_client *w);
+extern void web_client_free(struct web_client *w);
 
-extern void *web_client_main(void *ptr);
+extern int web_client_file_input_pending(struct web_client *w);
+extern int web_client_handle_io(struct web_client *w, int can_receive, int can_send);
 
 #endif
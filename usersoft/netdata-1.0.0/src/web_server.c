@@ -13,6 +13,7 @@
 #include <fcntl.h>
 #include <netinet/tcp.h>
 #include <malloc.h>
+#include <sys/epoll.h>
 
 #include "common.h"
 #include "log.h"
@@ -38,11 +39,7 @@ static void log_allocations(void)
 
 	mi = mallinfo();
 	if(mi.uordblks > mem) {
-		int clients = 0;
-		struct web_client *w;
-		for(w = web_clients; w ; w = w->next) clients++;
-
-		info("Allocated memory increased from %d to %d (increased by %d bytes). There are %d web clients connected.", mem, mi.uordblks, mi.uordblks - mem, clients);
+		info("Allocated memory increased from %d to %d (increased by %d bytes). There are %llu web clients connected.", mem, mi.uordblks, mi.uordblks - mem, global_statistics.connected_clients);
 		mem = mi.uordblks;
 	}
 }
@@ -125,13 +122,180 @@ int create_listen_socket6(int port, int listen_backlog)
 }
 
 
+// --------------------------------------------------------------------------------------
+// the web server workers
+
+// 1. each worker owns a set of web clients and watches their sockets with its own epoll
+// 2. it serves the clients with async I/O (this keeps keep-alive clients cheap)
+// 3. it disconnects idle clients and returns closed ones to the web client free list
+
+#define WEB_SERVER_WORKER_MAX_EVENTS 100
+
+struct web_server_worker {
+	int id;
+	pthread_t thread;
+	int efd;						// the epoll of this worker
+
+	pthread_mutex_t mutex;			// the listener adds clients while the worker runs
+	struct web_client *clients;
+	int clients_count;
+};
+
+int web_server_threads = WEB_SERVER_THREADS;
+static struct web_server_worker *web_server_workers = NULL;
+
+static void web_server_worker_add_client(struct web_server_worker *wk, struct web_client *w)
+{
+	struct epoll_event ev;
+
+	pthread_mutex_lock(&wk->mutex);
+	w->prev = NULL;
+	w->next = wk->clients;
+	if(wk->clients) wk->clients->prev = w;
+	wk->clients = w;
+	wk->clients_count++;
+	pthread_mutex_unlock(&wk->mutex);
+
+	w->events = EPOLLIN;
+
+	ev.events = w->events;
+	ev.data.ptr = w;
+	if(epoll_ctl(wk->efd, EPOLL_CTL_ADD, w->ifd, &ev) == -1) {
+		error("%llu: Cannot add web client socket to the epoll of web server worker %d.", w->id, wk->id);
+		w->obsolete = 1;
+	}
+}
+
+static struct web_client *web_server_worker_remove_client(struct web_server_worker *wk, struct web_client *w)
+{
+	struct web_client *n = w->next;
+
+	epoll_ctl(wk->efd, EPOLL_CTL_DEL, w->ofd, NULL);
+
+	pthread_mutex_lock(&wk->mutex);
+	if(w->prev) w->prev->next = w->next;
+	if(w->next) w->next->prev = w->prev;
+	if(w == wk->clients) wk->clients = w->next;
+	wk->clients_count--;
+	pthread_mutex_unlock(&wk->mutex);
+
+	log_access("%llu: %s port %s disconnected from web server worker %d", w->id, w->client_ip, w->client_port, wk->id);
+
+	web_client_reset(w);
+	web_client_free(w);
+	log_allocations();
+
+	return n;
+}
+
+static void web_server_worker_update_events(struct web_server_worker *wk, struct web_client *w)
+{
+	uint32_t events = 0;
+
+	if(w->wait_receive && w->ifd == w->ofd) events |= EPOLLIN;
+	if(w->wait_send) events |= EPOLLOUT;
+
+	// the file being copied is read whenever the socket accepts more output
+	if(web_client_file_input_pending(w)) events |= EPOLLOUT;
+
+	if(events == w->events) return;
+
+	struct epoll_event ev;
+	ev.events = events;
+	ev.data.ptr = w;
+	if(epoll_ctl(wk->efd, EPOLL_CTL_MOD, w->ofd, &ev) == -1) {
+		error("%llu: Cannot update the epoll events of web client socket.", w->id);
+		w->obsolete = 1;
+	}
+
+	w->events = events;
+}
+
+static void *web_server_worker_main(void *ptr)
+{
+	struct web_server_worker *wk = ptr;
+	struct epoll_event events[WEB_SERVER_WORKER_MAX_EVENTS];
+	struct web_client *w;
+	time_t last_cleanup = 0;
+	int i, n;
+
+	info("WEB SERVER worker %d thread created with task id %d", wk->id, gettid());
+
+	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
+		error("Cannot set pthread cancel type to DEFERRED.");
+
+	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
+		error("Cannot set pthread cancel state to ENABLE.");
+
+	for(;;) {
+		n = epoll_wait(wk->efd, events, WEB_SERVER_WORKER_MAX_EVENTS, 1000);
+		if(n == -1) {
+			if(errno != EINTR) error("WEB SERVER worker %d: epoll_wait() failed.", wk->id);
+			n = 0;
+		}
+
+		for(i = 0; i < n ; i++) {
+			w = events[i].data.ptr;
+			if(w->obsolete) continue;
+
+			if(events[i].events & (EPOLLERR | EPOLLHUP)) {
+				debug(D_WEB_CLIENT_ACCESS, "%llu: Received error on socket.", w->id);
+				w->obsolete = 1;
+				continue;
+			}
+
+			if(web_client_handle_io(w, events[i].events & EPOLLIN, events[i].events & EPOLLOUT) < 0) {
+				w->obsolete = 1;
+				continue;
+			}
+
+			web_server_worker_update_events(wk, w);
+		}
+
+		// disconnect closed and idle clients
+		time_t now = time(NULL);
+		if(n == 0 || now != last_cleanup) {
+			last_cleanup = now;
+
+			pthread_mutex_lock(&wk->mutex);
+			w = wk->clients;
+			pthread_mutex_unlock(&wk->mutex);
+
+			while(w) {
+				if(!w->obsolete && now - w->last_activity >= web_client_timeout) {
+					debug(D_WEB_CLIENT_ACCESS, "%llu: LISTENER: timeout.", w->id);
+					w->obsolete = 1;
+				}
+
+				if(w->obsolete) w = web_server_worker_remove_client(wk, w);
+				else w = w->next;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+void web_server_threads_cancel(void)
+{
+	int i;
+
+	if(!web_server_workers) return;
+
+	for(i = 0; i < web_server_threads ; i++) {
+		debug(D_EXIT, "Stopping web server worker %d", i);
+		pthread_cancel(web_server_workers[i].thread);
+		pthread_join(web_server_workers[i].thread, NULL);
+	}
+}
+
+
 // --------------------------------------------------------------------------------------
 // the main socket listener
 
 // 1. it accepts new incoming requests on our port
-// 2. creates a new web_client for each connection received
-// 3. spawns a new pthread to serve the client (this is optimal for keep-alive clients)
-// 4. cleans up old web_clients that their pthreads have been exited
+// 2. creates (or reuses) a web_client for each connection received
+// 3. hands it over to the web server worker with the fewest clients
 
 void *socket_listen_main(void *ptr)
 {
@@ -140,10 +304,7 @@ void *socket_listen_main(void *ptr)
 	info("WEB SERVER thread created with task id %d", gettid());
 
 	struct web_client *w;
-	struct timeval tv;
-	int retval;
-
-	if(ptr) { ; }
+	int i;
 
 	if(pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL) != 0)
 		error("Cannot set pthread cancel type to DEFERRED.");
@@ -153,66 +314,43 @@ void *socket_listen_main(void *ptr)
 
 	web_client_timeout = (int) config_get_number("global", "disconnect idle web clients after seconds", DEFAULT_DISCONNECT_IDLE_WEB_CLIENTS_AFTER_SECONDS);
 	web_enable_gzip = config_get_boolean("global", "enable web responses gzip compression", web_enable_gzip);
+	web_server_threads = (int) config_get_number("global", "web server threads", web_server_threads);
+	if(web_server_threads < 1) web_server_threads = 1;
 
 	if(listen_fd < 0) fatal("LISTENER: Listen socket is not ready.");
 
-	fd_set ifds, ofds, efds;
-	int fdmax = listen_fd;
+	web_server_workers = calloc(web_server_threads, sizeof(struct web_server_worker));
+	if(!web_server_workers) fatal("LISTENER: Cannot allocate memory for %d web server workers.", web_server_threads);
 
-	FD_ZERO (&ifds);
-	FD_ZERO (&ofds);
-	FD_ZERO (&efds);
+	for(i = 0; i < web_server_threads ; i++) {
+		struct web_server_worker *wk = &web_server_workers[i];
 
-	for(;;) {
-		tv.tv_sec = 0;
-		tv.tv_usec = 200000;
+		wk->id = i;
+		pthread_mutex_init(&wk->mutex, NULL);
 
-		if(listen_fd >= 0) {
-			FD_SET(listen_fd, &ifds);
-			FD_SET(listen_fd, &efds);
-		}
+		wk->efd = epoll_create1(EPOLL_CLOEXEC);
+		if(wk->efd == -1) fatal("LISTENER: Cannot create epoll for web server worker %d.", i);
 
-		// debug(D_WEB_CLIENT, "LISTENER: Waiting...");
-		retval = select(fdmax+1, &ifds, &ofds, &efds, &tv);
+		if(pthread_create(&wk->thread, NULL, web_server_worker_main, wk) != 0)
+			fatal("LISTENER: Cannot create thread for web server worker %d.", i);
+	}
 
-		if(retval == -1) {
-			error("LISTENER: select() failed.");
+	for(;;) {
+		// blocks until a client connects
+		w = web_client_create(listen_fd);
+		if(unlikely(!w)) {
+			// no need for error log - web_client_create already logged the error
 			continue;
 		}
-		else if(retval) {
-			// check for new incoming connections
-			if(FD_ISSET(listen_fd, &ifds)) {
-				w = web_client_create(listen_fd);
-				if(unlikely(!w)) {
-					// no need for error log - web_client_create already logged the error
-					continue;
-				}
 
-				if(pthread_create(&w->thread, NULL, web_client_main, w) != 0) {
-					error("%llu: failed to create new thread for web client.");
-					w->obsolete = 1;
-				}
-				else if(pthread_detach(w->thread) != 0) {
-					error("%llu: Cannot request detach of newly created web client thread.", w->id);
-					w->obsolete = 1;
-				}
-			}
-			else debug(D_WEB_CLIENT, "LISTENER: select() didn't do anything.");
+		struct web_server_worker *wk = &web_server_workers[0];
+		for(i = 1; i < web_server_threads ; i++)
+			if(web_server_workers[i].clients_count < wk->clients_count)
+				wk = &web_server_workers[i];
 
-		}
-		//else {
-		//	debug(D_WEB_CLIENT, "LISTENER: select() timeout.");
-		//}
-
-		// cleanup unused clients
-		for(w = web_clients; w ; w = w?w->next:NULL) {
-			if(w->obsolete) {
-				debug(D_WEB_CLIENT, "%llu: Removing client.", w->id);
-				// pthread_join(w->thread,  NULL);
-				w = web_client_free(w);
-				log_allocations();
-			}
-		}
+		log_access("%llu: %s port %s connected on web server worker %d", w->id, w->client_ip, w->client_port, wk->id);
+
+		web_server_worker_add_client(wk, w);
 	}
 
 	error("LISTENER: exit!");
@@ -222,4 +360,3 @@ void *socket_listen_main(void *ptr)
 
 	return NULL;
 }
-
@@ -8,6 +8,7 @@
 
 #define LISTEN_PORT 19999
 #define LISTEN_BACKLOG 100
+#define WEB_SERVER_THREADS 2
 
 extern int listen_backlog;
 extern int listen_fd;
@@ -16,5 +17,8 @@ extern int listen_port;
 extern int create_listen_socket4(int port, int listen_backlog);
 extern int create_listen_socket6(int port, int listen_backlog);
 extern void *socket_listen_main(void *ptr);
+extern void web_server_threads_cancel(void);
+
+extern int web_server_threads;
 
 #endif /* NETDATA_WEB_SERVER_H */
@@ -30,6 +30,8 @@ struct php_unserialize_data {
 	void *first_dtor;
 	void *last_dtor;
 	HashTable *allowed_classes;
+	HashTable *classes;
+	HashTable *keys;
 };
 
 PHPAPI php_unserialize_data_t php_var_unserialize_init() {
@@ -63,6 +65,10 @@ PHPAPI HashTable *php_var_unserialize_get_allowed_classes(php_unserialize_data_t
 	return d->allowed_classes;
 }
 PHPAPI void php_var_unserialize_set_allowed_classes(php_unserialize_data_t d, HashTable *classes) {
+	if (d->classes && d->allowed_classes != classes) {
+		/* the classes looked up so far may not be allowed anymore */
+		zend_hash_clean(d->classes);
+	}
 	d->allowed_classes = classes;
 }
 
@@ -74,6 +80,10 @@ PHPAPI void php_var_unserialize_set_allowed_classes(php_unserialize_data_t d, Ha
 /* VAR_FLAG used in var_dtor entries to signify an entry on which __wakeup should be called */
 #define VAR_WAKEUP_FLAG 1
 
+/* array keys and property names shared between the unserialized values */
+#define VAR_KEYS_MAX 1024
+#define VAR_KEY_MAX_LEN 64
+
 typedef struct {
 	zval *data[VAR_ENTRIES_MAX];
 	zend_long used_slots;
@@ -165,6 +175,51 @@ PHPAPI void var_replace(php_unserialize_data_t *var_hashx, zval *ozval, zval *nz
 	}
 }
 
+static inline zend_class_entry *var_class(php_unserialize_data_t *var_hashx, zend_string *class_name)
+{
+	HashTable *classes = (*var_hashx)->classes;
+
+	if (!classes) {
+		return NULL;
+	}
+	return zend_hash_find_ptr(classes, class_name);
+}
+
+static inline void var_push_class(php_unserialize_data_t *var_hashx, zend_string *class_name, zend_class_entry *ce)
+{
+	HashTable *classes = (*var_hashx)->classes;
+
+	if (!classes) {
+		ALLOC_HASHTABLE(classes);
+		zend_hash_init(classes, 8, NULL, NULL, 0);
+		(*var_hashx)->classes = classes;
+	}
+	zend_hash_add_ptr(classes, class_name, ce);
+}
+
+static inline zend_string *var_key(php_unserialize_data_t *var_hashx, const char *str, size_t len)
+{
+	HashTable *keys = (*var_hashx)->keys;
+	zend_string *key;
+	zval *zv, tmp;
+
+	if (keys && (zv = zend_hash_str_find(keys, str, len)) != NULL) {
+		return zend_string_copy(Z_STR_P(zv));
+	}
+
+	key = zend_string_init(str, len, 0);
+	if (!keys) {
+		ALLOC_HASHTABLE(keys);
+		zend_hash_init(keys, 32, NULL, ZVAL_PTR_DTOR, 0);
+		(*var_hashx)->keys = keys;
+	}
+	if (zend_hash_num_elements(keys) < VAR_KEYS_MAX) {
+		ZVAL_STR_COPY(&tmp, key);
+		zend_hash_add_new(keys, key, &tmp);
+	}
+	return key;
+}
+
 static zval *var_access(php_unserialize_data_t *var_hashx, zend_long id)
 {
 	var_entries *var_hash = (*var_hashx)->first;
@@ -240,6 +295,17 @@ PHPAPI void var_destroy(php_unserialize_data_t *var_hashx)
 	}
 
 	zval_ptr_dtor_nogc(&wakeup_name);
+
+	if ((*var_hashx)->classes) {
+		zend_hash_destroy((*var_hashx)->classes);
+		FREE_HASHTABLE((*var_hashx)->classes);
+		(*var_hashx)->classes = NULL;
+	}
+	if ((*var_hashx)->keys) {
+		zend_hash_destroy((*var_hashx)->keys);
+		FREE_HASHTABLE((*var_hashx)->keys);
+		(*var_hashx)->keys = NULL;
+	}
 }
 
 /* }}} */
@@ -368,6 +434,34 @@ static inline size_t parse_uiv(const unsigned char *p)
 
 static int php_var_unserialize_internal(UNSERIALIZE_PARAMETER);
 
+/* Unserializes an array key or a property name. The short strings are shared
+ * through var_hash, anything else goes through the full unserializer. */
+static zend_always_inline int process_nested_key(zval *key, const unsigned char **p, const unsigned char *max, php_unserialize_data_t *var_hash)
+{
+	const unsigned char *cursor = *p;
+	size_t len = 0;
+
+	if (max - cursor < 4 || cursor[0] != 's' || cursor[1] != ':' || cursor[2] < '0' || cursor[2] > '9') {
+		return php_var_unserialize_internal(key, p, max, NULL);
+	}
+
+	for (cursor += 2; cursor < max && *cursor >= '0' && *cursor <= '9'; cursor++) {
+		len = len * 10 + (size_t)(*cursor - (unsigned char)'0');
+		if (len > VAR_KEY_MAX_LEN) {
+			return php_var_unserialize_internal(key, p, max, NULL);
+		}
+	}
+
+	if (len < 2 || max - cursor < (ptrdiff_t)len + 4
+			|| cursor[0] != ':' || cursor[1] != '"' || cursor[len + 2] != '"' || cursor[len + 3] != ';') {
+		return php_var_unserialize_internal(key, p, max, NULL);
+	}
+
+	ZVAL_STR(key, var_key(var_hash, (const char *)cursor + 2, len));
+	*p = cursor + len + 4;
+	return 1;
+}
+
 static zend_always_inline int process_nested_data(UNSERIALIZE_PARAMETER, HashTable *ht, zend_long elements, int objprops)
 {
 	while (elements-- > 0) {
@@ -376,7 +470,7 @@ static zend_always_inline int process_nested_data(UNSERIALIZE_PARAMETER, HashTab
 
 		ZVAL_UNDEF(&key);
 
-		if (!php_var_unserialize_internal(&key, p, max, NULL)) {
+		if (!process_nested_key(&key, p, max, var_hash)) {
 			zval_ptr_dtor(&key);
 			return 0;
 		}
@@ -413,7 +507,8 @@ numeric_key:
 		} else {
 			if (EXPECTED(Z_TYPE(key) == IS_STRING)) {
 string_key:
-				{
+				/* a public property already in the table needs no mangling */
+				if (Z_STRVAL(key)[0] == '\0' || (old_data = zend_hash_find(ht, Z_STR(key))) == NULL) {
 					zend_property_info *existing_propinfo;
 					zend_string *new_key, *unmangled;
 					const char *unmangled_class = NULL; 
@@ -457,15 +552,17 @@ string_key:
 						zend_string_release(unmangled);
 					}
 
-					if ((old_data = zend_hash_find(ht, Z_STR(key))) != NULL) {
-						if (Z_TYPE_P(old_data) == IS_INDIRECT) {
-							old_data = Z_INDIRECT_P(old_data);
-						}
-						var_push_dtor(var_hash, old_data);
-						data = zend_hash_update_ind(ht, Z_STR(key), &d);
-					} else {
-						data = zend_hash_add_new(ht, Z_STR(key), &d);
+					old_data = zend_hash_find(ht, Z_STR(key));
+				}
+
+				if (old_data != NULL) {
+					if (Z_TYPE_P(old_data) == IS_INDIRECT) {
+						old_data = Z_INDIRECT_P(old_data);
 					}
+					var_push_dtor(var_hash, old_data);
+					data = zend_hash_update_ind(ht, Z_STR(key), &d);
+				} else {
+					data = zend_hash_add_new(ht, Z_STR(key), &d);
 				}
 			} else if (Z_TYPE(key) == IS_LONG) {
 				/* object properties should include no integers */
@@ -1167,6 +1264,11 @@ yy75:
 	class_name = zend_string_init(str, len, 0);
 
 	do {
+		/* Classes met before in this unserialization */
+		if ((ce = var_class(var_hash, class_name)) != NULL) {
+			break;
+		}
+
 		if(!unserialize_allowed_class(class_name, var_hash)) {
 			incomplete_class = 1;
 			ce = PHP_IC_ENTRY;
@@ -1182,6 +1284,7 @@ yy75:
 				zend_string_release(class_name);
 				return 0;
 			}
+			var_push_class(var_hash, class_name, ce);
 			break;
 		}
 		BG(serialize_lock)--;
@@ -1233,6 +1336,8 @@ yy75:
 			php_error_docref(NULL, E_WARNING, "Function %s() hasn't defined the class it was called for", Z_STRVAL(user_func));
 			incomplete_class = 1;
 			ce = PHP_IC_ENTRY;
+		} else {
+			var_push_class(var_hash, class_name, ce);
 		}
 		BG(serialize_lock)--;
 
@@ -114,6 +114,19 @@ static ZEND_INI_MH(OnUpdateGCEnabled) /* {{{ */
 }
 /* }}} */
 
+static ZEND_INI_MH(OnUpdateGCMaxThreshold) /* {{{ */
+{
+	zend_long val = zend_atol(ZSTR_VAL(new_value), ZSTR_LEN(new_value));
+
+	if (val <= 0 || val > UINT32_MAX) {
+		return FAILURE;
+	}
+	gc_set_max_threshold((uint32_t)val);
+
+	return SUCCESS;
+}
+/* }}} */
+
 static ZEND_INI_DISP(zend_gc_enabled_displayer_cb) /* {{{ */
 {
 	if (gc_enabled()) {
@@ -169,6 +182,7 @@ ZEND_INI_BEGIN()
 	ZEND_INI_ENTRY("error_reporting",				NULL,		ZEND_INI_ALL,		OnUpdateErrorReporting)
 	STD_ZEND_INI_ENTRY("zend.assertions",				"1",    ZEND_INI_ALL,       OnUpdateAssertions,           assertions,   zend_executor_globals,  executor_globals)
 	ZEND_INI_ENTRY3_EX("zend.enable_gc",				"1",	ZEND_INI_ALL,		OnUpdateGCEnabled, NULL, NULL, NULL, zend_gc_enabled_displayer_cb)
+	ZEND_INI_ENTRY("zend.gc_max_threshold",		"1000000000",	ZEND_INI_ALL,		OnUpdateGCMaxThreshold)
  	STD_ZEND_INI_BOOLEAN("zend.multibyte", "0", ZEND_INI_PERDIR, OnUpdateBool, multibyte,      zend_compiler_globals, compiler_globals)
  	ZEND_INI_ENTRY("zend.script_encoding",			NULL,		ZEND_INI_ALL,		OnUpdateScriptEncoding)
  	STD_ZEND_INI_BOOLEAN("zend.detect_unicode",			"1",	ZEND_INI_ALL,		OnUpdateBool, detect_unicode, zend_compiler_globals, compiler_globals)
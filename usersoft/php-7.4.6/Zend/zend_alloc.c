@@ -196,6 +196,8 @@ typedef struct  _zend_mm_chunk     zend_mm_chunk;
 typedef struct  _zend_mm_huge_list zend_mm_huge_list;
 
 int zend_mm_use_huge_pages = 0;
+static int zend_mm_keep_chunks = 0;
+static uint32_t zend_mm_sample_every = 0;
 
 /*
  * Memory is retrieved from OS by chunks of fixed size 2MB.
@@ -262,6 +264,9 @@ struct _zend_mm_heap {
 	double             avg_chunks_count;		/* average number of chunks allocated per request */
 	int                last_chunks_delete_boundary; /* numer of chunks after last deletion */
 	int                last_chunks_delete_count;    /* number of deletion over the last boundary */
+	uint32_t           sample_countdown[ZEND_MM_SAMPLE_KINDS];
+	uint32_t           samples_count;           /* samples taken in current request */
+	zend_mm_sample    *samples;                 /* ring of ZEND_MM_MAX_SAMPLES */
 #if ZEND_MM_CUSTOM
 	union {
 		struct {
@@ -462,7 +467,8 @@ static void *zend_mm_mmap(size_t size)
 	void *ptr;
 
 #ifdef MAP_HUGETLB
-	if (zend_mm_use_huge_pages && size == ZEND_MM_CHUNK_SIZE) {
+	/* USE_ZEND_ALLOC_HUGE_PAGES=2 relies on transparent huge pages only */
+	if (zend_mm_use_huge_pages == 1 && size == ZEND_MM_CHUNK_SIZE) {
 		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
 		if (ptr != MAP_FAILED) {
 			return ptr;
@@ -1043,14 +1049,99 @@ static zend_always_inline void *zend_mm_alloc_large_ex(zend_mm_heap *heap, size_
 	return ptr;
 }
 
+/************/
+/* Sampling */
+/************/
+
+/* Only the slow paths are sampled (small bins getting a new page run, large
+ * and huge blocks), so the cost is zero for small allocations served from a
+ * free list and a counter decrement otherwise. */
+#define ZEND_MM_SAMPLE(heap, kind, size) do { \
+		if (UNEXPECTED(zend_mm_sample_every)) { \
+			zend_mm_sample_tick(heap, kind, size); \
+		} \
+	} while (0)
+
+static zend_never_inline void zend_mm_sample_tick(zend_mm_heap *heap, uint32_t kind, size_t size)
+{
+	zend_execute_data *ex;
+	zend_mm_sample *sample;
+	uint32_t n = 0;
+
+	if (heap->sample_countdown[kind] > 1) {
+		heap->sample_countdown[kind]--;
+		return;
+	}
+	heap->sample_countdown[kind] = zend_mm_sample_every;
+
+	if (!heap->samples) {
+		heap->samples = malloc(sizeof(zend_mm_sample) * ZEND_MM_MAX_SAMPLES);
+		if (!heap->samples) {
+			return;
+		}
+	}
+	sample = &heap->samples[heap->samples_count % ZEND_MM_MAX_SAMPLES];
+	heap->samples_count++;
+	sample->size = size;
+	sample->kind = kind;
+
+	for (ex = EG(current_execute_data); ex && n < ZEND_MM_SAMPLE_FRAMES; ex = ex->prev_execute_data) {
+		zend_mm_sample_frame *frame;
+
+		if (!ex->func) {
+			continue;
+		}
+		frame = &sample->frames[n++];
+		frame->function_name = ex->func->common.function_name;
+		frame->class_name = ex->func->common.scope ? ex->func->common.scope->name : NULL;
+		if (ZEND_USER_CODE(ex->func->common.type)) {
+			frame->filename = ex->func->op_array.filename;
+			frame->lineno = ex->opline ? ex->opline->lineno : 0;
+		} else {
+			frame->filename = NULL;
+			frame->lineno = 0;
+		}
+	}
+	sample->frames_count = n;
+}
+
+static void zend_mm_reset_samples(zend_mm_heap *heap, int full)
+{
+	memset(heap->sample_countdown, 0, sizeof(heap->sample_countdown));
+	heap->samples_count = 0;
+	if (full && heap->samples) {
+		free(heap->samples);
+		heap->samples = NULL;
+	}
+}
+
+ZEND_API uint32_t zend_mm_sample_rate(void)
+{
+	return zend_mm_sample_every;
+}
+
+ZEND_API const zend_mm_sample *zend_mm_get_samples(zend_mm_heap *heap, uint32_t *count)
+{
+#if ZEND_MM_CUSTOM
+	if (heap->use_custom_heap) {
+		*count = 0;
+		return NULL;
+	}
+#endif
+	*count = MIN(heap->samples_count, ZEND_MM_MAX_SAMPLES);
+	return heap->samples;
+}
+
 #if ZEND_DEBUG
 static zend_never_inline void *zend_mm_alloc_large(zend_mm_heap *heap, size_t size ZEND_FILE_LINE_DC ZEND_FILE_LINE_ORIG_DC)
 {
+	ZEND_MM_SAMPLE(heap, ZEND_MM_SAMPLE_LARGE, size);
 	return zend_mm_alloc_large_ex(heap, size ZEND_FILE_LINE_RELAY_CC ZEND_FILE_LINE_ORIG_RELAY_CC);
 }
 #else
 static zend_never_inline void *zend_mm_alloc_large(zend_mm_heap *heap, size_t size ZEND_FILE_LINE_DC ZEND_FILE_LINE_ORIG_DC)
 {
+	ZEND_MM_SAMPLE(heap, ZEND_MM_SAMPLE_LARGE, size);
 	return zend_mm_alloc_large_ex(heap, size ZEND_FILE_LINE_RELAY_CC ZEND_FILE_LINE_ORIG_RELAY_CC);
 }
 #endif
@@ -1061,6 +1152,7 @@ static zend_always_inline void zend_mm_delete_chunk(zend_mm_heap *heap, zend_mm_
 	chunk->prev->next = chunk->next;
 	heap->chunks_count--;
 	if (heap->chunks_count + heap->cached_chunks_count < heap->avg_chunks_count + 0.1
+	 || heap->cached_chunks_count < zend_mm_keep_chunks
 	 || (heap->chunks_count == heap->last_chunks_delete_boundary
 	  && heap->last_chunks_delete_count >= 4)) {
 		/* delay deletion */
@@ -1190,6 +1282,7 @@ static zend_never_inline void *zend_mm_alloc_small_slow(zend_mm_heap *heap, uint
 	zend_mm_bin *bin;
 	zend_mm_free_slot *p, *end;
 
+	ZEND_MM_SAMPLE(heap, ZEND_MM_SAMPLE_SMALL, bin_data_size[bin_num]);
 #if ZEND_DEBUG
 	bin = (zend_mm_bin*)zend_mm_alloc_pages(heap, bin_pages[bin_num], bin_data_size[bin_num] ZEND_FILE_LINE_RELAY_CC ZEND_FILE_LINE_ORIG_RELAY_CC);
 #else
@@ -1765,6 +1858,7 @@ static void *zend_mm_alloc_huge(zend_mm_heap *heap, size_t size ZEND_FILE_LINE_D
 		zend_error_noreturn(E_ERROR, "Possible integer overflow in memory allocation (%zu + %zu)", size, alignment);
 	}
 
+	ZEND_MM_SAMPLE(heap, ZEND_MM_SAMPLE_HUGE, size);
 #if ZEND_MM_LIMIT
 	if (UNEXPECTED(new_size > heap->limit - heap->real_size)) {
 		if (zend_mm_gc(heap) && new_size <= heap->limit - heap->real_size) {
@@ -1871,6 +1965,9 @@ static zend_mm_heap *zend_mm_init(void)
 	heap->avg_chunks_count = 1.0;
 	heap->last_chunks_delete_boundary = 0;
 	heap->last_chunks_delete_count = 0;
+	memset(heap->sample_countdown, 0, sizeof(heap->sample_countdown));
+	heap->samples_count = 0;
+	heap->samples = NULL;
 #if ZEND_MM_STAT || ZEND_MM_LIMIT
 	heap->real_size = ZEND_MM_CHUNK_SIZE;
 #endif
@@ -1893,6 +1990,33 @@ static zend_mm_heap *zend_mm_init(void)
 	return heap;
 }
 
+/* Fill the chunk cache up to USE_ZEND_ALLOC_KEEP_CHUNKS and touch every page,
+ * so the first requests of a worker don't pay for page faults (and, with huge
+ * pages, get their chunks backed on the node of the worker that calls this). */
+ZEND_API void zend_mm_prefault(zend_mm_heap *heap)
+{
+	zend_mm_chunk *chunk;
+	size_t offset;
+
+#if ZEND_MM_CUSTOM
+	if (heap->use_custom_heap) {
+		return;
+	}
+#endif
+	while (heap->cached_chunks_count < zend_mm_keep_chunks) {
+		chunk = (zend_mm_chunk*)zend_mm_chunk_alloc(heap, ZEND_MM_CHUNK_SIZE, ZEND_MM_CHUNK_SIZE);
+		if (UNEXPECTED(chunk == NULL)) {
+			break;
+		}
+		for (offset = 0; offset < ZEND_MM_CHUNK_SIZE; offset += REAL_PAGE_SIZE) {
+			((volatile char*)chunk)[offset] = 0;
+		}
+		chunk->next = heap->cached_chunks;
+		heap->cached_chunks = chunk;
+		heap->cached_chunks_count++;
+	}
+}
+
 ZEND_API size_t zend_mm_gc(zend_mm_heap *heap)
 {
 	zend_mm_free_slot *p, **q;
@@ -2260,6 +2384,8 @@ void zend_mm_shutdown(zend_mm_heap *heap, int full, int silent)
 		heap->cached_chunks_count++;
 	}
 
+	zend_mm_reset_samples(heap, full);
+
 	if (full) {
 		/* free all cached chunks */
 		while (heap->cached_chunks) {
@@ -2273,6 +2399,7 @@ void zend_mm_shutdown(zend_mm_heap *heap, int full, int silent)
 		/* free some cached chunks to keep average count */
 		heap->avg_chunks_count = (heap->avg_chunks_count + (double)heap->peak_chunks_count) / 2.0;
 		while ((double)heap->cached_chunks_count + 0.9 > heap->avg_chunks_count &&
+		       heap->cached_chunks_count > zend_mm_keep_chunks &&
 		       heap->cached_chunks) {
 			p = heap->cached_chunks;
 			heap->cached_chunks = p->next;
@@ -2761,7 +2888,15 @@ static void alloc_globals_ctor(zend_alloc_globals *alloc_globals)
 
 	tmp = getenv("USE_ZEND_ALLOC_HUGE_PAGES");
 	if (tmp && zend_atoi(tmp, 0)) {
-		zend_mm_use_huge_pages = 1;
+		zend_mm_use_huge_pages = zend_atoi(tmp, 0) == 2 ? 2 : 1;
+	}
+	tmp = getenv("USE_ZEND_ALLOC_KEEP_CHUNKS");
+	if (tmp && zend_atoi(tmp, 0) > 0) {
+		zend_mm_keep_chunks = zend_atoi(tmp, 0);
+	}
+	tmp = getenv("USE_ZEND_ALLOC_SAMPLE");
+	if (tmp && zend_atoi(tmp, 0) > 0) {
+		zend_mm_sample_every = (uint32_t)zend_atoi(tmp, 0);
 	}
 	alloc_globals->mm_heap = zend_mm_init();
 }
@@ -2923,6 +3058,9 @@ ZEND_API zend_mm_heap *zend_mm_startup_ex(const zend_mm_handlers *handlers, void
 	heap->avg_chunks_count = 1.0;
 	heap->last_chunks_delete_boundary = 0;
 	heap->last_chunks_delete_count = 0;
+	memset(heap->sample_countdown, 0, sizeof(heap->sample_countdown));
+	heap->samples_count = 0;
+	heap->samples = NULL;
 #if ZEND_MM_STAT || ZEND_MM_LIMIT
 	heap->real_size = ZEND_MM_CHUNK_SIZE;
 #endif
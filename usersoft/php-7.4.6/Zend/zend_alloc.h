@@ -269,6 +269,33 @@ ZEND_API zend_mm_heap *zend_mm_set_heap(zend_mm_heap *new_heap);
 ZEND_API zend_mm_heap *zend_mm_get_heap(void);
 
 ZEND_API size_t zend_mm_gc(zend_mm_heap *heap);
+ZEND_API void zend_mm_prefault(zend_mm_heap *heap);
+
+/* Allocation sampling (USE_ZEND_ALLOC_SAMPLE=<N>) */
+#define ZEND_MM_SAMPLE_SMALL      0 /* a new page run for a small bin */
+#define ZEND_MM_SAMPLE_LARGE      1
+#define ZEND_MM_SAMPLE_HUGE       2
+#define ZEND_MM_SAMPLE_KINDS      3
+
+#define ZEND_MM_SAMPLE_FRAMES     8
+#define ZEND_MM_MAX_SAMPLES       256
+
+typedef struct _zend_mm_sample_frame {
+	zend_string *function_name;
+	zend_string *class_name;
+	zend_string *filename;
+	uint32_t     lineno;
+} zend_mm_sample_frame;
+
+typedef struct _zend_mm_sample {
+	size_t               size;
+	uint32_t             kind;
+	uint32_t             frames_count;
+	zend_mm_sample_frame frames[ZEND_MM_SAMPLE_FRAMES];
+} zend_mm_sample;
+
+ZEND_API uint32_t zend_mm_sample_rate(void);
+ZEND_API const zend_mm_sample *zend_mm_get_samples(zend_mm_heap *heap, uint32_t *count);
 
 #define ZEND_MM_CUSTOM_HEAP_NONE  0
 #define ZEND_MM_CUSTOM_HEAP_STD   1
@@ -432,12 +432,15 @@ ZEND_FUNCTION(gc_status)
 
 	zend_gc_get_status(&status);
 
-	array_init_size(return_value, 3);
+	array_init_size(return_value, 7);
 
 	add_assoc_long_ex(return_value, "runs", sizeof("runs")-1, (long)status.runs);
 	add_assoc_long_ex(return_value, "collected", sizeof("collected")-1, (long)status.collected);
 	add_assoc_long_ex(return_value, "threshold", sizeof("threshold")-1, (long)status.threshold);
 	add_assoc_long_ex(return_value, "roots", sizeof("roots")-1, (long)status.num_roots);
+	add_assoc_double_ex(return_value, "collector_time", sizeof("collector_time")-1, (double)status.collector_time / 1000000000.0);
+	add_assoc_double_ex(return_value, "last_pause", sizeof("last_pause")-1, (double)status.last_pause / 1000000000.0);
+	add_assoc_double_ex(return_value, "max_pause", sizeof("max_pause")-1, (double)status.max_pause / 1000000000.0);
 }
 /* }}} */
 
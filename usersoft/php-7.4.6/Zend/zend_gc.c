@@ -69,6 +69,13 @@
 #include "zend.h"
 #include "zend_API.h"
 
+#ifdef ZEND_WIN32
+# include <windows.h>
+#else
+# include <time.h>
+# include <sys/time.h>
+#endif
+
 #ifndef GC_BENCH
 # define GC_BENCH 0
 #endif
@@ -223,6 +230,10 @@ typedef struct _zend_gc_globals {
 	uint32_t gc_runs;
 	uint32_t collected;
 
+	uint64_t collector_time;            /* total time spent collecting (ns) */
+	uint64_t last_pause;                /* duration of the last run (ns)    */
+	uint64_t max_pause;                 /* longest run so far (ns)          */
+
 #if GC_BENCH
 	uint32_t root_buf_length;
 	uint32_t root_buf_peak;
@@ -242,6 +253,11 @@ static size_t gc_globals_offset;
 static zend_gc_globals gc_globals;
 #endif
 
+/* Upper bound for the adaptive threshold, i.e. the largest number of roots
+ * a single automatic collection has to walk. Process wide and only changed
+ * through zend.gc_max_threshold. */
+static uint32_t gc_threshold_max = GC_THRESHOLD_MAX;
+
 #if GC_BENCH
 # define GC_BENCH_INC(counter) GC_G(counter)++
 # define GC_BENCH_DEC(counter) GC_G(counter)--
@@ -442,6 +458,9 @@ static void gc_globals_ctor_ex(zend_gc_globals *gc_globals)
 
 	gc_globals->gc_runs = 0;
 	gc_globals->collected = 0;
+	gc_globals->collector_time = 0;
+	gc_globals->last_pause = 0;
+	gc_globals->max_pause = 0;
 
 #if GC_BENCH
 	gc_globals->root_buf_length = 0;
@@ -481,6 +500,9 @@ void gc_reset(void)
 
 		GC_G(gc_runs) = 0;
 		GC_G(collected) = 0;
+		GC_G(collector_time) = 0;
+		GC_G(last_pause) = 0;
+		GC_G(max_pause) = 0;
 
 #if GC_BENCH
 		GC_G(root_buf_length) = 0;
@@ -501,7 +523,7 @@ ZEND_API zend_bool gc_enable(zend_bool enable)
 		GC_G(buf) = (gc_root_buffer*) pemalloc(sizeof(gc_root_buffer) * GC_DEFAULT_BUF_SIZE, 1);
 		GC_G(buf)[0].ref = NULL;
 		GC_G(buf_size) = GC_DEFAULT_BUF_SIZE;
-		GC_G(gc_threshold) = GC_THRESHOLD_DEFAULT + GC_FIRST_ROOT;
+		GC_G(gc_threshold) = MIN(GC_THRESHOLD_DEFAULT, gc_threshold_max) + GC_FIRST_ROOT;
 		gc_reset();
 	}
 	return old_enabled;
@@ -512,6 +534,19 @@ ZEND_API zend_bool gc_enabled(void)
 	return GC_G(gc_enabled);
 }
 
+ZEND_API void gc_set_max_threshold(uint32_t max_threshold)
+{
+	if (max_threshold < GC_THRESHOLD_TRIGGER) {
+		max_threshold = GC_THRESHOLD_TRIGGER;
+	} else if (max_threshold > GC_THRESHOLD_MAX) {
+		max_threshold = GC_THRESHOLD_MAX;
+	}
+	gc_threshold_max = max_threshold;
+	if (GC_G(buf) && GC_G(gc_threshold) > max_threshold + GC_FIRST_ROOT) {
+		GC_G(gc_threshold) = max_threshold + GC_FIRST_ROOT;
+	}
+}
+
 ZEND_API zend_bool gc_protect(zend_bool protect)
 {
 	zend_bool old_protected = GC_G(gc_protected);
@@ -558,10 +593,10 @@ static void gc_adjust_threshold(int count)
 	 * by a fixed step */
 	if (count < GC_THRESHOLD_TRIGGER) {
 		/* increase */
-		if (GC_G(gc_threshold) < GC_THRESHOLD_MAX) {
+		if (GC_G(gc_threshold) < gc_threshold_max) {
 			new_threshold = GC_G(gc_threshold) + GC_THRESHOLD_STEP;
-			if (new_threshold > GC_THRESHOLD_MAX) {
-				new_threshold = GC_THRESHOLD_MAX;
+			if (new_threshold > gc_threshold_max) {
+				new_threshold = gc_threshold_max;
 			}
 			if (new_threshold > GC_G(buf_size)) {
 				gc_grow_root_buffer();
@@ -1426,6 +1461,46 @@ tail_call:
 	} while (0);
 }
 
+/* Monotonic clock in nanoseconds, used for the pause statistics only */
+static uint64_t gc_time(void)
+{
+#ifdef ZEND_WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (!freq.QuadPart) {
+		QueryPerformanceFrequency(&freq);
+	}
+	QueryPerformanceCounter(&now);
+	return (uint64_t)((double)now.QuadPart * 1000000000.0 / (double)freq.QuadPart);
+#else
+# if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+# endif
+	{
+		struct timeval tv;
+
+		gettimeofday(&tv, NULL);
+		return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+	}
+#endif
+}
+
+static void gc_record_pause(uint64_t start)
+{
+	uint64_t pause = gc_time() - start;
+
+	GC_G(last_pause) = pause;
+	GC_G(collector_time) += pause;
+	if (pause > GC_G(max_pause)) {
+		GC_G(max_pause) = pause;
+	}
+}
+
 ZEND_API int zend_gc_collect_cycles(void)
 {
 	int count = 0;
@@ -1435,6 +1510,7 @@ ZEND_API int zend_gc_collect_cycles(void)
 		zend_refcounted *p;
 		uint32_t gc_flags = 0;
 		uint32_t idx, end;
+		uint64_t start;
 		gc_stack stack;
 
 		stack.prev = NULL;
@@ -1444,6 +1520,8 @@ ZEND_API int zend_gc_collect_cycles(void)
 			return 0;
 		}
 
+		start = gc_time();
+
 		GC_TRACE("Collecting cycles");
 		GC_G(gc_runs)++;
 		GC_G(gc_active) = 1;
@@ -1462,6 +1540,7 @@ ZEND_API int zend_gc_collect_cycles(void)
 			/* nothing to free */
 			GC_TRACE("Nothing to free");
 			GC_G(gc_active) = 0;
+			gc_record_pause(start);
 			return 0;
 		}
 
@@ -1602,6 +1681,7 @@ ZEND_API int zend_gc_collect_cycles(void)
 		GC_TRACE("Collection finished");
 		GC_G(collected) += count;
 		GC_G(gc_active) = 0;
+		gc_record_pause(start);
 	}
 
 	gc_compact();
@@ -1615,6 +1695,9 @@ ZEND_API void zend_gc_get_status(zend_gc_status *status)
 	status->collected = GC_G(collected);
 	status->threshold = GC_G(gc_threshold);
 	status->num_roots = GC_G(num_roots);
+	status->collector_time = GC_G(collector_time);
+	status->last_pause = GC_G(last_pause);
+	status->max_pause = GC_G(max_pause);
 }
 
 #ifdef ZTS
@@ -27,6 +27,9 @@ typedef struct _zend_gc_status {
 	uint32_t collected;
 	uint32_t threshold;
 	uint32_t num_roots;
+	uint64_t collector_time;	/* nanoseconds */
+	uint64_t last_pause;
+	uint64_t max_pause;
 } zend_gc_status;
 
 ZEND_API extern int (*gc_collect_cycles)(void);
@@ -38,6 +41,9 @@ ZEND_API void ZEND_FASTCALL gc_remove_from_buffer(zend_refcounted *ref);
 ZEND_API zend_bool gc_enable(zend_bool enable);
 ZEND_API zend_bool gc_enabled(void);
 
+/* cap the adaptive collection threshold, bounding the work done per run */
+ZEND_API void gc_set_max_threshold(uint32_t max_threshold);
+
 /* enable/disable possible root additions */
 ZEND_API zend_bool gc_protect(zend_bool protect);
 ZEND_API zend_bool gc_protected(void);
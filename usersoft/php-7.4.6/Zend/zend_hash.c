@@ -2678,6 +2678,144 @@ ZEND_API zval* ZEND_FASTCALL zend_hash_minmax(const HashTable *ht, compare_func_
 	return &res->val;
 }
 
+/* Appends the elements of a packed array to a packed array, unwrapping
+ * references that nothing else points to (like array_merge() does). */
+ZEND_API void ZEND_FASTCALL zend_hash_packed_append(HashTable *target, HashTable *source)
+{
+	uint32_t idx, count;
+	Bucket *p, *end, *q;
+
+	IS_CONSISTENT(source);
+	IS_CONSISTENT(target);
+	HT_ASSERT_RC1(target);
+	ZEND_ASSERT(HT_FLAGS(source) & HASH_FLAG_PACKED);
+
+	count = source->nNumOfElements;
+	if (count == 0) {
+		return;
+	}
+	zend_hash_extend(target, target->nNumUsed + count, 1);
+
+	idx = target->nNumUsed;
+	q = target->arData + idx;
+	p = source->arData;
+	end = p + source->nNumUsed;
+	if (HT_IS_WITHOUT_HOLES(source)) {
+		/* no IS_UNDEF checks needed, the copy is a straight run */
+		for (; p != end; p++, q++) {
+			zval *zv = &p->val;
+
+			if (Z_REFCOUNTED_P(zv)) {
+				if (UNEXPECTED(Z_ISREF_P(zv)) && Z_REFCOUNT_P(zv) == 1) {
+					zv = Z_REFVAL_P(zv);
+					Z_TRY_ADDREF_P(zv);
+				} else {
+					Z_ADDREF_P(zv);
+				}
+			}
+			ZVAL_COPY_VALUE(&q->val, zv);
+			q->h = idx++;
+			q->key = NULL;
+		}
+	} else {
+		for (; p != end; p++) {
+			zval *zv = &p->val;
+
+			if (UNEXPECTED(Z_TYPE_P(zv) == IS_UNDEF)) {
+				continue;
+			}
+			if (UNEXPECTED(Z_ISREF_P(zv)) && Z_REFCOUNT_P(zv) == 1) {
+				zv = Z_REFVAL_P(zv);
+			}
+			Z_TRY_ADDREF_P(zv);
+			ZVAL_COPY_VALUE(&q->val, zv);
+			q->h = idx++;
+			q->key = NULL;
+			q++;
+		}
+	}
+	target->nNumUsed = idx;
+	target->nNumOfElements += count;
+	target->nNextFreeElement = idx;
+}
+
+/* Strict searches over packed arrays: return the index of the first element
+ * identical to the needle (looking through references) or HT_INVALID_IDX. */
+ZEND_API uint32_t ZEND_FASTCALL zend_hash_packed_search_long(const HashTable *ht, zend_long lval)
+{
+	Bucket *p = ht->arData;
+	Bucket *end = p + ht->nNumUsed;
+
+	IS_CONSISTENT(ht);
+	ZEND_ASSERT(HT_FLAGS(ht) & HASH_FLAG_PACKED);
+
+#if defined(__SSE2__) && SIZEOF_ZEND_LONG == 8
+	{
+		/* value and type_info of a zval compared at once, u2 is ignored */
+		const __m128i needle = _mm_set_epi32(0, IS_LONG, (int)((zend_ulong)lval >> 32), (int)(zend_ulong)lval);
+
+		for (; p + 2 <= end; p += 2) {
+			int m0 = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&p[0].val), needle));
+			int m1 = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&p[1].val), needle));
+
+			if ((m0 & 0x0fff) == 0x0fff) {
+				return p - ht->arData;
+			} else if (UNEXPECTED(Z_TYPE(p[0].val) == IS_REFERENCE)
+			 && Z_TYPE_P(Z_REFVAL(p[0].val)) == IS_LONG && Z_LVAL_P(Z_REFVAL(p[0].val)) == lval) {
+				return p - ht->arData;
+			}
+			if ((m1 & 0x0fff) == 0x0fff) {
+				return p + 1 - ht->arData;
+			} else if (UNEXPECTED(Z_TYPE(p[1].val) == IS_REFERENCE)
+			 && Z_TYPE_P(Z_REFVAL(p[1].val)) == IS_LONG && Z_LVAL_P(Z_REFVAL(p[1].val)) == lval) {
+				return p + 1 - ht->arData;
+			}
+		}
+	}
+#endif
+	for (; p != end; p++) {
+		zval *zv = &p->val;
+
+		ZVAL_DEREF(zv);
+		if (Z_TYPE_P(zv) == IS_LONG && Z_LVAL_P(zv) == lval) {
+			return p - ht->arData;
+		}
+	}
+	return HT_INVALID_IDX;
+}
+
+ZEND_API uint32_t ZEND_FASTCALL zend_hash_packed_search_str(const HashTable *ht, zend_string *str)
+{
+	Bucket *p = ht->arData;
+	Bucket *end = p + ht->nNumUsed;
+	size_t len = ZSTR_LEN(str);
+	zend_ulong h = ZSTR_H(str);
+
+	IS_CONSISTENT(ht);
+	ZEND_ASSERT(HT_FLAGS(ht) & HASH_FLAG_PACKED);
+
+	for (; p != end; p++) {
+		zval *zv = &p->val;
+		zend_string *s;
+
+		ZVAL_DEREF(zv);
+		if (Z_TYPE_P(zv) != IS_STRING) {
+			continue;
+		}
+		s = Z_STR_P(zv);
+		if (s == str) {
+			return p - ht->arData;
+		}
+		/* a known hash that differs rules the string out without touching its bytes */
+		if (ZSTR_LEN(s) == len
+		 && (!h || !ZSTR_H(s) || ZSTR_H(s) == h)
+		 && memcmp(ZSTR_VAL(s), ZSTR_VAL(str), len) == 0) {
+			return p - ht->arData;
+		}
+	}
+	return HT_INVALID_IDX;
+}
+
 ZEND_API int ZEND_FASTCALL _zend_handle_numeric_str_ex(const char *key, size_t length, zend_ulong *idx)
 {
 	register const char *tmp = key;
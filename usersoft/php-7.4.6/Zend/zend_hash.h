@@ -267,6 +267,11 @@ ZEND_API void  zend_hash_bucket_packed_swap(Bucket *p, Bucket *q);
 ZEND_API int   zend_hash_compare(HashTable *ht1, HashTable *ht2, compare_func_t compar, zend_bool ordered);
 ZEND_API int   ZEND_FASTCALL zend_hash_sort_ex(HashTable *ht, sort_func_t sort_func, compare_func_t compare_func, zend_bool renumber);
 ZEND_API zval* ZEND_FASTCALL zend_hash_minmax(const HashTable *ht, compare_func_t compar, uint32_t flag);
+ZEND_API void  ZEND_FASTCALL zend_hash_packed_append(HashTable *target, HashTable *source);
+
+/* Strict value search in packed arrays */
+ZEND_API uint32_t ZEND_FASTCALL zend_hash_packed_search_long(const HashTable *ht, zend_long lval);
+ZEND_API uint32_t ZEND_FASTCALL zend_hash_packed_search_str(const HashTable *ht, zend_string *str);
 
 #define zend_hash_sort(ht, compare_func, renumber) \
 	zend_hash_sort_ex(ht, zend_sort, compare_func, renumber)
@@ -304,6 +304,14 @@ CWD_API char *virtual_getcwd(char *buf, size_t size) /* {{{ */
 }
 /* }}} */
 
+static const realpath_cache_shared_handlers *realpath_cache_shared = NULL;
+
+CWD_API void realpath_cache_set_shared_handlers(const realpath_cache_shared_handlers *handlers) /* {{{ */
+{
+	realpath_cache_shared = handlers;
+}
+/* }}} */
+
 #ifdef ZEND_WIN32
 static inline zend_ulong realpath_cache_key(const char *path, size_t path_len) /* {{{ */
 {
@@ -367,6 +375,10 @@ CWD_API void realpath_cache_del(const char *path, size_t path_len) /* {{{ */
 	zend_ulong n = key % (sizeof(CWDG(realpath_cache)) / sizeof(CWDG(realpath_cache)[0]));
 	realpath_cache_bucket **bucket = &CWDG(realpath_cache)[n];
 
+	if (realpath_cache_shared) {
+		realpath_cache_shared->del(path, path_len);
+	}
+
 	while (*bucket != NULL) {
 		if (key == (*bucket)->key && path_len == (*bucket)->path_len &&
 					memcmp(path, (*bucket)->path, path_len) == 0) {
@@ -593,6 +605,28 @@ static size_t tsrm_realpath_r(char *path, size_t start, size_t len, int *ll, tim
 					return bucket->realpath_len;
 				}
 			}
+			if (realpath_cache_shared && CWDG(realpath_cache_ttl)) {
+				size_t realpath_len;
+				int realpath_is_dir;
+				time_t expires;
+
+				tmp = do_alloca(len+1, use_heap);
+				memcpy(tmp, path, len+1);
+				if (realpath_cache_shared->find(tmp, len, *t, path, &realpath_len, &realpath_is_dir, &expires) == SUCCESS) {
+					/* keep it locally until the shared entry expires */
+					realpath_cache_add(tmp, len, path, realpath_len, realpath_is_dir, expires - CWDG(realpath_cache_ttl));
+					free_alloca(tmp, use_heap);
+					if (is_dir && !realpath_is_dir) {
+						/* not a directory */
+						return (size_t)-1;
+					}
+					if (link_is_dir) {
+						*link_is_dir = realpath_is_dir;
+					}
+					return realpath_len;
+				}
+				free_alloca(tmp, use_heap);
+			}
 		}
 
 #ifdef ZEND_WIN32
@@ -972,6 +1006,9 @@ retry:
 		if (save && start && CWDG(realpath_cache_size_limit)) {
 			/* save absolute path in the cache */
 			realpath_cache_add(tmp, len, path, j, directory, *t);
+			if (realpath_cache_shared && CWDG(realpath_cache_ttl)) {
+				realpath_cache_shared->add(tmp, len, path, j, directory, *t + CWDG(realpath_cache_ttl));
+			}
 		}
 
 		free_alloca(tmp, use_heap);
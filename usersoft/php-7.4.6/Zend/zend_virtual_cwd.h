@@ -243,6 +243,19 @@ CWD_API zend_long realpath_cache_size(void);
 CWD_API zend_long realpath_cache_max_buckets(void);
 CWD_API realpath_cache_bucket** realpath_cache_get_buckets(void);
 
+/* A second level realpath cache shared by the processes of a pool, asked when
+ * the process cache misses and filled with what the process resolves. Entries
+ * expire with realpath_cache_ttl, so it is not used when the TTL is 0. */
+typedef struct _realpath_cache_shared_handlers {
+	/* on success, copies the resolved path to realpath (MAXPATHLEN bytes) */
+	int  (*find)(const char *path, size_t path_len, time_t t, char *realpath, size_t *realpath_len, int *is_dir, time_t *expires);
+	void (*add)(const char *path, size_t path_len, const char *realpath, size_t realpath_len, int is_dir, time_t expires);
+	void (*del)(const char *path, size_t path_len);
+} realpath_cache_shared_handlers;
+
+/* NULL uninstalls the handlers */
+CWD_API void realpath_cache_set_shared_handlers(const realpath_cache_shared_handlers *handlers);
+
 #ifdef CWD_EXPORTS
 extern void virtual_cwd_main_cwd_init(uint8_t);
 #endif
@@ -9,6 +9,7 @@ if test "$PHP_JSON" != "no"; then
 
 PHP_NEW_EXTENSION(json,
 	  json.c \
+	  json_decoder.c \
 	  json_encoder.c \
 	  json_parser.tab.c \
 	  json_scanner.c,
@@ -29,6 +29,7 @@
 #include "php_json.h"
 #include "php_json_encoder.h"
 #include "php_json_parser.h"
+#include "php_json_decoder.h"
 #include <zend_exceptions.h>
 
 static PHP_MINFO_FUNCTION(json);
@@ -84,6 +85,13 @@ static const zend_function_entry json_serializable_interface[] = {
 };
 /* }}} */
 
+/* {{{ PHP_INI */
+PHP_INI_BEGIN()
+	STD_PHP_INI_ENTRY("json.key_cache_size", "256", PHP_INI_SYSTEM, OnUpdateLong, key_cache_size, zend_json_globals, json_globals)
+	STD_PHP_INI_BOOLEAN("json.key_cache_persistent", "0", PHP_INI_SYSTEM, OnUpdateBool, key_cache_persistent, zend_json_globals, json_globals)
+PHP_INI_END()
+/* }}} */
+
 /* Register constant for options and errors */
 #define PHP_JSON_REGISTER_CONSTANT(_name, _value) \
 	REGISTER_LONG_CONSTANT(_name,  _value, CONST_CS | CONST_PERSISTENT);
@@ -93,6 +101,8 @@ static PHP_MINIT_FUNCTION(json)
 {
 	zend_class_entry ce;
 
+	REGISTER_INI_ENTRIES();
+
 	INIT_CLASS_ENTRY(ce, "JsonSerializable", json_serializable_interface);
 	php_json_serializable_ce = zend_register_internal_interface(&ce);
 
@@ -149,6 +159,41 @@ static PHP_GINIT_FUNCTION(json)
 	json_globals->encoder_depth = 0;
 	json_globals->error_code = 0;
 	json_globals->encode_max_depth = PHP_JSON_PARSER_DEFAULT_DEPTH;
+	json_globals->key_cache = NULL;
+	json_globals->key_cache_mask = 0;
+}
+/* }}} */
+
+/* {{{ PHP_GSHUTDOWN_FUNCTION
+*/
+static PHP_GSHUTDOWN_FUNCTION(json)
+{
+	if (json_globals->key_cache && json_globals->key_cache_persistent) {
+		php_json_key_cache_free(json_globals->key_cache, json_globals->key_cache_mask, 1);
+		json_globals->key_cache = NULL;
+	}
+}
+/* }}} */
+
+/* {{{ MSHUTDOWN */
+static PHP_MSHUTDOWN_FUNCTION(json)
+{
+	UNREGISTER_INI_ENTRIES();
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ post deactivate
+ * The request key cache goes after the executor has destroyed every array
+ * that may use its keys */
+static ZEND_MODULE_POST_ZEND_DEACTIVATE_D(json)
+{
+	if (JSON_G(key_cache) && !JSON_G(key_cache_persistent)) {
+		php_json_key_cache_free(JSON_G(key_cache), JSON_G(key_cache_mask), 0);
+		JSON_G(key_cache) = NULL;
+	}
+	return SUCCESS;
 }
 /* }}} */
 
@@ -160,15 +205,15 @@ zend_module_entry json_module_entry = {
 	"json",
 	json_functions,
 	PHP_MINIT(json),
-	NULL,
+	PHP_MSHUTDOWN(json),
 	NULL,
 	NULL,
 	PHP_MINFO(json),
 	PHP_JSON_VERSION,
 	PHP_MODULE_GLOBALS(json),
 	PHP_GINIT(json),
-	NULL,
-	NULL,
+	PHP_GSHUTDOWN(json),
+	ZEND_MODULE_POST_ZEND_DEACTIVATE_N(json),
 	STANDARD_MODULE_PROPERTIES_EX
 };
 /* }}} */
@@ -187,6 +232,8 @@ static PHP_MINFO_FUNCTION(json)
 	php_info_print_table_start();
 	php_info_print_table_row(2, "json support", "enabled");
 	php_info_print_table_end();
+
+	DISPLAY_INI_ENTRIES();
 }
 /* }}} */
 
@@ -246,6 +293,14 @@ PHP_JSON_API int php_json_decode_ex(zval *return_value, char *str, size_t str_le
 {
 	php_json_parser parser;
 
+	/* well-formed input decoded to arrays takes the single pass decoder,
+	 * errors are reported by the parser */
+	if ((options & PHP_JSON_OBJECT_AS_ARRAY)
+			&& !(options & (PHP_JSON_INVALID_UTF8_IGNORE | PHP_JSON_INVALID_UTF8_SUBSTITUTE))
+			&& php_json_decode_fast(return_value, str, str_len, (int)options, (int)depth) == SUCCESS) {
+		return SUCCESS;
+	}
+
 	php_json_parser_init(&parser, return_value, str, str_len, (int)options, (int)depth);
 
 	if (php_json_yyparse(&parser)) {
@@ -0,0 +1,746 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) The PHP Group                                          |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  +----------------------------------------------------------------------+
+*/
+
+/* Single pass decoder for json_decode() with JSON_OBJECT_AS_ARRAY.
+ *
+ * It accepts only well-formed input that decodes without any of the
+ * INVALID_UTF8 options. Everything else (syntax and depth errors included)
+ * makes it return FAILURE with nothing left allocated, and the caller runs
+ * the bison parser which reports the exact error. Values of the open
+ * containers are collected on a stack, so every array is created with its
+ * final size once the closing bracket is seen. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "zend_smart_str.h"
+#include "php_json.h"
+#include "php_json_decoder.h"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# include "Zend/zend_bitset.h"
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# include "Zend/zend_bitset.h"
+#endif
+
+#define PHP_JSON_INT_MAX_LENGTH (MAX_LENGTH_OF_LONG - 1)
+
+#define PHP_JSON_DECODER_STACK_SIZE 64
+#define PHP_JSON_DECODER_KEY_CACHE_SIZE 64
+
+#define PHP_JSON_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+typedef struct _php_json_decoder {
+	const unsigned char *cursor;
+	const unsigned char *limit;
+	int options;
+	int max_depth;
+	zval *stack;        /* members of the open containers, keys and values alternate in objects */
+	uint32_t top;
+	uint32_t size;
+	smart_str buf;      /* unescaped string */
+	zend_string *keys[PHP_JSON_DECODER_KEY_CACHE_SIZE];   /* keys of this decode */
+	zval stack_static[PHP_JSON_DECODER_STACK_SIZE];
+} php_json_decoder;
+
+static int php_json_decoder_value(php_json_decoder *d, zval *zv, int depth);
+
+static zend_always_inline void php_json_decoder_ws(php_json_decoder *d)
+{
+	const unsigned char *p = d->cursor;
+
+	while (p < d->limit && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+		p++;
+	}
+	d->cursor = p;
+}
+
+static zend_always_inline void php_json_decoder_push(php_json_decoder *d, zval *zv)
+{
+	if (UNEXPECTED(d->top == d->size)) {
+		if (d->stack == d->stack_static) {
+			d->stack = safe_emalloc(d->size, 2 * sizeof(zval), 0);
+			memcpy(d->stack, d->stack_static, d->size * sizeof(zval));
+		} else {
+			d->stack = safe_erealloc(d->stack, d->size, 2 * sizeof(zval), 0);
+		}
+		d->size *= 2;
+	}
+	ZVAL_COPY_VALUE(&d->stack[d->top++], zv);
+}
+
+/* {{{ php_json_decoder_string_scan
+ * First quote, backslash, control character or byte >= 0x80 */
+static zend_always_inline const unsigned char *php_json_decoder_string_scan(
+		const unsigned char *p, const unsigned char *limit)
+{
+#if defined(__SSE2__)
+	while (limit - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) p);
+		__m128i m = _mm_or_si128(
+			/* signed compare, catches the bytes >= 0x80 too */
+			_mm_cmplt_epi8(v, _mm_set1_epi8(' ')),
+			_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+		uint32_t mask = _mm_movemask_epi8(m);
+
+		if (mask) {
+			return p + zend_ulong_ntz(mask);
+		}
+		p += 16;
+	}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	while (limit - p >= 16) {
+		uint8x16_t v = vld1q_u8(p);
+		uint8x16_t m = vorrq_u8(
+			vorrq_u8(
+				vcltq_u8(v, vdupq_n_u8(' ')),
+				vcgeq_u8(v, vdupq_n_u8(0x80))),
+			vorrq_u8(
+				vceqq_u8(v, vdupq_n_u8('"')),
+				vceqq_u8(v, vdupq_n_u8('\\'))));
+
+		if (vmaxvq_u8(m)) {
+			/* narrow to 4 bits per byte */
+			uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+			return p + (zend_ulong_ntz(mask) >> 2);
+		}
+		p += 16;
+	}
+#endif
+	while (p < limit && *p != '"' && *p != '\\' && *p >= ' ' && *p < 0x80) {
+		p++;
+	}
+	return p;
+}
+/* }}} */
+
+/* {{{ php_json_decoder_utf8_len
+ * Length of the UTF-8 sequence at p or 0 if it is invalid, the same ranges as the scanner */
+static int php_json_decoder_utf8_len(const unsigned char *p, const unsigned char *limit)
+{
+	size_t avail = limit - p;
+	unsigned char c = p[0];
+
+	if (c >= 0xC2 && c <= 0xDF) {
+		if (avail >= 2 && (p[1] & 0xC0) == 0x80) {
+			return 2;
+		}
+	} else if (c >= 0xE0 && c <= 0xEF) {
+		if (avail >= 3 && (p[2] & 0xC0) == 0x80) {
+			if (c == 0xE0 ? (p[1] >= 0xA0 && p[1] <= 0xBF)
+					: c == 0xED ? (p[1] >= 0x80 && p[1] <= 0x9F)
+					: (p[1] & 0xC0) == 0x80) {
+				return 3;
+			}
+		}
+	} else if (c >= 0xF0 && c <= 0xF4) {
+		if (avail >= 4 && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80) {
+			if (c == 0xF0 ? (p[1] >= 0x90 && p[1] <= 0xBF)
+					: c == 0xF4 ? (p[1] >= 0x80 && p[1] <= 0x8F)
+					: (p[1] & 0xC0) == 0x80) {
+				return 4;
+			}
+		}
+	}
+	return 0;
+}
+/* }}} */
+
+static int php_json_decoder_hex4(const unsigned char *p, unsigned int *code)
+{
+	int i;
+	unsigned int c = 0;
+
+	for (i = 0; i < 4; i++) {
+		unsigned char h = p[i];
+
+		if (h >= '0' && h <= '9') {
+			c = (c << 4) | (h - '0');
+		} else if (h >= 'a' && h <= 'f') {
+			c = (c << 4) | (h - ('a' - 10));
+		} else if (h >= 'A' && h <= 'F') {
+			c = (c << 4) | (h - ('A' - 10));
+		} else {
+			return FAILURE;
+		}
+	}
+	*code = c;
+	return SUCCESS;
+}
+
+/* {{{ php_json_decoder_escape
+ * Appends the character of the escape at p to the buffer and returns the
+ * position after it, NULL for invalid escapes and unpaired surrogates */
+static const unsigned char *php_json_decoder_escape(php_json_decoder *d, const unsigned char *p)
+{
+	size_t avail = d->limit - p;
+	unsigned int code, low;
+	char utf8[4];
+
+	if (avail < 2) {
+		return NULL;
+	}
+	switch (p[1]) {
+		case '"':
+		case '\\':
+		case '/':
+			smart_str_appendc(&d->buf, p[1]);
+			return p + 2;
+		case 'b':
+			smart_str_appendc(&d->buf, '\b');
+			return p + 2;
+		case 'f':
+			smart_str_appendc(&d->buf, '\f');
+			return p + 2;
+		case 'n':
+			smart_str_appendc(&d->buf, '\n');
+			return p + 2;
+		case 'r':
+			smart_str_appendc(&d->buf, '\r');
+			return p + 2;
+		case 't':
+			smart_str_appendc(&d->buf, '\t');
+			return p + 2;
+		case 'u':
+			break;
+		default:
+			return NULL;
+	}
+
+	if (avail < 6 || php_json_decoder_hex4(p + 2, &code) == FAILURE) {
+		return NULL;
+	}
+	if (code < 0x80) {
+		smart_str_appendc(&d->buf, (char) code);
+		return p + 6;
+	}
+	if (code < 0x800) {
+		utf8[0] = (char) (0xc0 | (code >> 6));
+		utf8[1] = (char) (0x80 | (code & 0x3f));
+		smart_str_appendl(&d->buf, utf8, 2);
+		return p + 6;
+	}
+	if (code < 0xd800 || code > 0xdfff) {
+		utf8[0] = (char) (0xe0 | (code >> 12));
+		utf8[1] = (char) (0x80 | ((code >> 6) & 0x3f));
+		utf8[2] = (char) (0x80 | (code & 0x3f));
+		smart_str_appendl(&d->buf, utf8, 3);
+		return p + 6;
+	}
+	/* a high surrogate must be followed by a low one */
+	if (code > 0xdbff || avail < 12 || p[6] != '\\' || p[7] != 'u'
+			|| php_json_decoder_hex4(p + 8, &low) == FAILURE || low < 0xdc00 || low > 0xdfff) {
+		return NULL;
+	}
+	code = ((code & 0x3ff) << 10) + (low & 0x3ff) + 0x10000;
+	utf8[0] = (char) (0xf0 | (code >> 18));
+	utf8[1] = (char) (0x80 | ((code >> 12) & 0x3f));
+	utf8[2] = (char) (0x80 | ((code >> 6) & 0x3f));
+	utf8[3] = (char) (0x80 | (code & 0x3f));
+	smart_str_appendl(&d->buf, utf8, 4);
+	return p + 12;
+}
+/* }}} */
+
+/* {{{ php_json_decoder_string
+ * The cursor is after the opening quote. Strings without escapes point
+ * into the input, the others into the buffer. */
+static int php_json_decoder_string(php_json_decoder *d, const char **str, size_t *len)
+{
+	const unsigned char *p = d->cursor, *start = p, *seg = p;
+	zend_bool escaped = 0;
+
+	while (1) {
+		p = php_json_decoder_string_scan(p, d->limit);
+		if (UNEXPECTED(p == d->limit)) {
+			return FAILURE;
+		}
+		if (EXPECTED(*p == '"')) {
+			break;
+		}
+		if (*p == '\\') {
+			if (!escaped) {
+				escaped = 1;
+				if (d->buf.s) {
+					ZSTR_LEN(d->buf.s) = 0;
+				}
+			}
+			smart_str_appendl(&d->buf, (const char *) seg, p - seg);
+			p = php_json_decoder_escape(d, p);
+			if (p == NULL) {
+				return FAILURE;
+			}
+			seg = p;
+		} else if (*p < ' ') {
+			return FAILURE;
+		} else {
+			int n = php_json_decoder_utf8_len(p, d->limit);
+
+			if (n == 0) {
+				return FAILURE;
+			}
+			p += n;
+		}
+	}
+
+	if (escaped) {
+		smart_str_appendl(&d->buf, (const char *) seg, p - seg);
+		*str = ZSTR_VAL(d->buf.s);
+		*len = ZSTR_LEN(d->buf.s);
+	} else {
+		*str = (const char *) start;
+		*len = p - start;
+	}
+	d->cursor = p + 1;
+	return SUCCESS;
+}
+/* }}} */
+
+/* Slot of a key in the caches: cheaper than the zend_hash hash, which is
+ * computed once when the string is first inserted */
+static zend_always_inline uint32_t php_json_decoder_key_slot(const char *str, size_t len)
+{
+	uint64_t head = 0, tail = 0, x;
+
+	if (len >= 8) {
+		memcpy(&head, str, 8);
+		memcpy(&tail, str + len - 8, 8);
+	} else {
+		memcpy(&head, str, len);
+	}
+	x = (head ^ (tail * 0x9e3779b97f4a7c15ULL)) + len;
+	x ^= x >> 29;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	return (uint32_t) (x ^ (x >> 32));
+}
+
+/* {{{ php_json_key_cache_get
+ * Key kept across decodes in JSON_G(key_cache), NULL when not cached.
+ * The strings are flagged interned, so nothing is refcounted and they are
+ * never freed while an array may use them: they live until the end of the
+ * request, or of the process with json.key_cache_persistent. A used slot
+ * is therefore never replaced. */
+static zend_string *php_json_key_cache_get(const char *str, size_t len, uint32_t h)
+{
+	zend_string **slot, *key;
+
+	if (UNEXPECTED(!JSON_G(key_cache))) {
+		zend_long size = JSON_G(key_cache_size);
+		uint32_t slots = 1;
+
+		if (size <= 0) {
+			return NULL;
+		}
+		if (size > PHP_JSON_KEY_CACHE_MAX_SIZE) {
+			size = PHP_JSON_KEY_CACHE_MAX_SIZE;
+		}
+		while (slots < size) {
+			slots <<= 1;
+		}
+		JSON_G(key_cache) = pecalloc(slots, sizeof(zend_string *), JSON_G(key_cache_persistent));
+		JSON_G(key_cache_mask) = slots - 1;
+	}
+
+	slot = &JSON_G(key_cache)[h & JSON_G(key_cache_mask)];
+	key = *slot;
+	if (key) {
+		return ZSTR_LEN(key) == len && memcmp(ZSTR_VAL(key), str, len) == 0 ? key : NULL;
+	}
+	if (len > PHP_JSON_KEY_CACHE_MAX_LENGTH) {
+		return NULL;
+	}
+	key = zend_string_init(str, len, JSON_G(key_cache_persistent));
+	zend_string_hash_val(key);
+	GC_ADD_FLAGS(key, IS_STR_INTERNED);
+	*slot = key;
+
+	return key;
+}
+/* }}} */
+
+void php_json_key_cache_free(zend_string **cache, uint32_t mask, int persistent) /* {{{ */
+{
+	uint32_t i;
+
+	for (i = 0; i <= mask; i++) {
+		if (cache[i]) {
+			pefree(cache[i], persistent);
+		}
+	}
+	pefree(cache, persistent);
+}
+/* }}} */
+
+/* {{{ php_json_decoder_key
+ * Numeric keys become integers as in zend_symtable_update(), the others come
+ * from the key cache or are shared within one decode */
+static void php_json_decoder_key(php_json_decoder *d, zval *zv, const char *str, size_t len)
+{
+	zend_ulong idx;
+	zend_string *key, **slot;
+	uint32_t h;
+
+	if (len <= 1) {
+		if (len && PHP_JSON_IS_DIGIT(*str)) {
+			ZVAL_LONG(zv, *str - '0');
+		} else {
+			ZVAL_INTERNED_STR(zv, len ? ZSTR_CHAR((zend_uchar) *str) : ZSTR_EMPTY_ALLOC());
+		}
+		return;
+	}
+	if (ZEND_HANDLE_NUMERIC_STR(str, len, idx)) {
+		ZVAL_LONG(zv, idx);
+		return;
+	}
+
+	h = php_json_decoder_key_slot(str, len);
+	key = php_json_key_cache_get(str, len, h);
+	if (key) {
+		ZVAL_INTERNED_STR(zv, key);
+		return;
+	}
+
+	slot = &d->keys[h & (PHP_JSON_DECODER_KEY_CACHE_SIZE - 1)];
+	key = *slot;
+	if (key && ZSTR_LEN(key) == len && memcmp(ZSTR_VAL(key), str, len) == 0) {
+		ZVAL_STR_COPY(zv, key);
+		return;
+	}
+	if (key) {
+		zend_string_release_ex(key, 0);
+	}
+	key = zend_string_init(str, len, 0);
+	*slot = key;
+	ZVAL_STR_COPY(zv, key);
+}
+/* }}} */
+
+static int php_json_decoder_number(php_json_decoder *d, zval *zv)
+{
+	const unsigned char *start = d->cursor, *p = start, *limit = d->limit;
+	zend_bool negative = 0, is_double = 0, bigint = 0;
+	size_t digits;
+
+	if (*p == '-') {
+		negative = 1;
+		p++;
+	}
+	if (p < limit && *p == '0') {
+		p++;
+		/* "01" is two tokens for the scanner */
+		if (p < limit && PHP_JSON_IS_DIGIT(*p)) {
+			return FAILURE;
+		}
+	} else if (p < limit && *p >= '1' && *p <= '9') {
+		do {
+			p++;
+		} while (p < limit && PHP_JSON_IS_DIGIT(*p));
+	} else {
+		return FAILURE;
+	}
+	digits = p - start - negative;
+
+	if (p < limit && *p == '.') {
+		p++;
+		if (p == limit || !PHP_JSON_IS_DIGIT(*p)) {
+			return FAILURE;
+		}
+		do {
+			p++;
+		} while (p < limit && PHP_JSON_IS_DIGIT(*p));
+		is_double = 1;
+	}
+	if (p < limit && (*p == 'e' || *p == 'E')) {
+		p++;
+		if (p < limit && (*p == '+' || *p == '-')) {
+			p++;
+		}
+		if (p == limit || !PHP_JSON_IS_DIGIT(*p)) {
+			return FAILURE;
+		}
+		do {
+			p++;
+		} while (p < limit && PHP_JSON_IS_DIGIT(*p));
+		is_double = 1;
+	}
+	d->cursor = p;
+
+	if (is_double) {
+		ZVAL_DOUBLE(zv, zend_strtod((const char *) start, NULL));
+		return SUCCESS;
+	}
+
+	if (digits >= PHP_JSON_INT_MAX_LENGTH) {
+		if (digits == PHP_JSON_INT_MAX_LENGTH) {
+			int cmp = strncmp((const char *) (start + negative), LONG_MIN_DIGITS, PHP_JSON_INT_MAX_LENGTH);
+			if (!(cmp < 0 || (cmp == 0 && negative))) {
+				bigint = 1;
+			}
+		} else {
+			bigint = 1;
+		}
+	}
+	if (!bigint) {
+		if (digits < PHP_JSON_INT_MAX_LENGTH) {
+			const unsigned char *q;
+			zend_long lval = 0;
+
+			for (q = start + negative; q < p; q++) {
+				lval = lval * 10 + (*q - '0');
+			}
+			ZVAL_LONG(zv, negative ? -lval : lval);
+		} else {
+			ZVAL_LONG(zv, ZEND_STRTOL((const char *) start, NULL, 10));
+		}
+	} else if (d->options & PHP_JSON_BIGINT_AS_STRING) {
+		ZVAL_STRINGL(zv, (const char *) start, p - start);
+	} else {
+		ZVAL_DOUBLE(zv, zend_strtod((const char *) start, NULL));
+	}
+	return SUCCESS;
+}
+
+static int php_json_decoder_array(php_json_decoder *d, zval *zv, int depth)
+{
+	uint32_t base = d->top, i;
+	HashTable *ht;
+	zval val;
+
+	if ((d->max_depth && depth >= d->max_depth) || depth > PHP_JSON_DECODER_MAX_NESTING) {
+		return FAILURE;
+	}
+	d->cursor++;
+	php_json_decoder_ws(d);
+	if (d->cursor < d->limit && *d->cursor == ']') {
+		d->cursor++;
+		ZVAL_EMPTY_ARRAY(zv);
+		return SUCCESS;
+	}
+
+	while (1) {
+		if (php_json_decoder_value(d, &val, depth + 1) == FAILURE) {
+			return FAILURE;
+		}
+		php_json_decoder_push(d, &val);
+		php_json_decoder_ws(d);
+		if (d->cursor == d->limit) {
+			return FAILURE;
+		}
+		if (*d->cursor == ',') {
+			d->cursor++;
+			php_json_decoder_ws(d);
+		} else if (*d->cursor == ']') {
+			d->cursor++;
+			break;
+		} else {
+			return FAILURE;
+		}
+	}
+
+	array_init_size(zv, d->top - base);
+	ht = Z_ARRVAL_P(zv);
+	zend_hash_real_init_packed(ht);
+	ZEND_HASH_FILL_PACKED(ht) {
+		for (i = base; i < d->top; i++) {
+			ZEND_HASH_FILL_ADD(&d->stack[i]);
+		}
+	} ZEND_HASH_FILL_END();
+	d->top = base;
+
+	return SUCCESS;
+}
+
+static int php_json_decoder_object(php_json_decoder *d, zval *zv, int depth)
+{
+	uint32_t base = d->top, i;
+	HashTable *ht;
+	const char *str;
+	size_t len;
+	zval val;
+
+	if ((d->max_depth && depth >= d->max_depth) || depth > PHP_JSON_DECODER_MAX_NESTING) {
+		return FAILURE;
+	}
+	d->cursor++;
+	php_json_decoder_ws(d);
+	if (d->cursor < d->limit && *d->cursor == '}') {
+		d->cursor++;
+		ZVAL_EMPTY_ARRAY(zv);
+		return SUCCESS;
+	}
+
+	while (1) {
+		if (d->cursor == d->limit || *d->cursor != '"') {
+			return FAILURE;
+		}
+		d->cursor++;
+		if (php_json_decoder_string(d, &str, &len) == FAILURE) {
+			return FAILURE;
+		}
+		php_json_decoder_key(d, &val, str, len);
+		php_json_decoder_push(d, &val);
+
+		php_json_decoder_ws(d);
+		if (d->cursor == d->limit || *d->cursor != ':') {
+			return FAILURE;
+		}
+		d->cursor++;
+		php_json_decoder_ws(d);
+		if (php_json_decoder_value(d, &val, depth + 1) == FAILURE) {
+			return FAILURE;
+		}
+		php_json_decoder_push(d, &val);
+
+		php_json_decoder_ws(d);
+		if (d->cursor == d->limit) {
+			return FAILURE;
+		}
+		if (*d->cursor == ',') {
+			d->cursor++;
+			php_json_decoder_ws(d);
+		} else if (*d->cursor == '}') {
+			d->cursor++;
+			break;
+		} else {
+			return FAILURE;
+		}
+	}
+
+	/* the first insert decides between packed and hash, as in zend_symtable_update() */
+	array_init_size(zv, (d->top - base) / 2);
+	ht = Z_ARRVAL_P(zv);
+	for (i = base; i < d->top; i += 2) {
+		zval *key = &d->stack[i];
+
+		if (Z_TYPE_P(key) == IS_LONG) {
+			zend_hash_index_update(ht, Z_LVAL_P(key), &d->stack[i + 1]);
+		} else {
+			zend_hash_update(ht, Z_STR_P(key), &d->stack[i + 1]);
+			zend_string_release_ex(Z_STR_P(key), 0);
+		}
+	}
+	d->top = base;
+
+	return SUCCESS;
+}
+
+static int php_json_decoder_value(php_json_decoder *d, zval *zv, int depth)
+{
+	const unsigned char *p = d->cursor;
+	size_t avail = d->limit - p;
+	const char *str;
+	size_t len;
+
+	if (avail == 0) {
+		return FAILURE;
+	}
+	switch (*p) {
+		case '{':
+			return php_json_decoder_object(d, zv, depth);
+		case '[':
+			return php_json_decoder_array(d, zv, depth);
+		case '"':
+			d->cursor++;
+			if (php_json_decoder_string(d, &str, &len) == FAILURE) {
+				return FAILURE;
+			}
+			if (len <= 1) {
+				ZVAL_INTERNED_STR(zv, len ? ZSTR_CHAR((zend_uchar) *str) : ZSTR_EMPTY_ALLOC());
+			} else {
+				ZVAL_STRINGL(zv, str, len);
+			}
+			return SUCCESS;
+		case 'n':
+			if (avail >= 4 && memcmp(p, "null", 4) == 0) {
+				d->cursor += 4;
+				ZVAL_NULL(zv);
+				return SUCCESS;
+			}
+			return FAILURE;
+		case 't':
+			if (avail >= 4 && memcmp(p, "true", 4) == 0) {
+				d->cursor += 4;
+				ZVAL_TRUE(zv);
+				return SUCCESS;
+			}
+			return FAILURE;
+		case 'f':
+			if (avail >= 5 && memcmp(p, "false", 5) == 0) {
+				d->cursor += 5;
+				ZVAL_FALSE(zv);
+				return SUCCESS;
+			}
+			return FAILURE;
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return php_json_decoder_number(d, zv);
+		default:
+			return FAILURE;
+	}
+}
+
+int php_json_decode_fast(zval *return_value, const char *str, size_t str_len, int options, int max_depth) /* {{{ */
+{
+	php_json_decoder d;
+	int status;
+	uint32_t i;
+
+	d.cursor = (const unsigned char *) str;
+	d.limit = d.cursor + str_len;
+	d.options = options;
+	d.max_depth = max_depth;
+	d.stack = d.stack_static;
+	d.top = 0;
+	d.size = PHP_JSON_DECODER_STACK_SIZE;
+	memset(&d.buf, 0, sizeof(d.buf));
+	memset(d.keys, 0, sizeof(d.keys));
+
+	php_json_decoder_ws(&d);
+	status = php_json_decoder_value(&d, return_value, 1);
+	if (status == SUCCESS) {
+		php_json_decoder_ws(&d);
+		if (d.cursor != d.limit) {
+			zval_ptr_dtor_nogc(return_value);
+			status = FAILURE;
+		}
+	}
+
+	if (status == FAILURE) {
+		for (i = 0; i < d.top; i++) {
+			zval_ptr_dtor_nogc(&d.stack[i]);
+		}
+	}
+	if (d.stack != d.stack_static) {
+		efree(d.stack);
+	}
+	smart_str_free(&d.buf);
+	for (i = 0; i < PHP_JSON_DECODER_KEY_CACHE_SIZE; i++) {
+		if (d.keys[i]) {
+			zend_string_release_ex(d.keys[i], 0);
+		}
+	}
+
+	return status;
+}
+/* }}} */
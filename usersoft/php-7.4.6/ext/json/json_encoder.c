@@ -36,6 +36,166 @@ static int php_json_escape_string(
 		smart_str *buf,	const char *s, size_t len,
 		int options, php_json_encoder *encoder);
 
+/* {{{ php_json_escape_safe_len
+ * Length of the leading run of bytes that are copied as they are: printable
+ * ASCII except the characters flagged in the charmap of php_json_escape_string.
+ * Only whole blocks are scanned, the tail is left to the scalar loop. */
+#if defined(__SSE2__)
+# if ZEND_INTRIN_AVX2_NATIVE || ZEND_INTRIN_AVX2_RESOLVER
+#  include <immintrin.h>
+# else
+#  include <emmintrin.h>
+# endif
+# include "Zend/zend_bitset.h"
+# define PHP_JSON_ESCAPE_SIMD 1
+
+/* '&' and '\'' as well as '<' and '>' differ in one bit, so they share a compare */
+# define PHP_JSON_UNSAFE_MASK_SSE2(v) \
+	_mm_or_si128( \
+		_mm_or_si128( \
+			/* signed compare, catches the bytes >= 0x80 too */ \
+			_mm_cmplt_epi8(v, _mm_set1_epi8(' ')), \
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))), \
+		_mm_or_si128( \
+			_mm_or_si128( \
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')), \
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('/'))), \
+			_mm_or_si128( \
+				_mm_cmpeq_epi8(_mm_or_si128(v, _mm_set1_epi8(0x01)), _mm_set1_epi8('\'')), \
+				_mm_cmpeq_epi8(_mm_or_si128(v, _mm_set1_epi8(0x02)), _mm_set1_epi8('>')))))
+
+static size_t php_json_escape_safe_len_sse2(const char *s, size_t len)
+{
+	size_t pos = 0;
+
+	while (len - pos >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + pos));
+		uint32_t mask = _mm_movemask_epi8(PHP_JSON_UNSAFE_MASK_SSE2(v));
+
+		if (mask) {
+			return pos + zend_ulong_ntz(mask);
+		}
+		pos += 16;
+	}
+	return pos;
+}
+
+# if ZEND_INTRIN_AVX2_NATIVE || ZEND_INTRIN_AVX2_RESOLVER
+#  if ZEND_INTRIN_AVX2_RESOLVER && defined(HAVE_FUNC_ATTRIBUTE_TARGET)
+static size_t php_json_escape_safe_len_avx2(const char *s, size_t len) __attribute__((target("avx2")));
+#  endif
+static size_t php_json_escape_safe_len_avx2(const char *s, size_t len)
+{
+	size_t pos = 0;
+
+	while (len - pos >= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(s + pos));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpgt_epi8(_mm256_set1_epi8(' '), v),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))),
+			_mm256_or_si256(
+				_mm256_or_si256(
+					_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')),
+					_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))),
+				_mm256_or_si256(
+					_mm256_cmpeq_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x01)), _mm256_set1_epi8('\'')),
+					_mm256_cmpeq_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x02)), _mm256_set1_epi8('>')))));
+		uint32_t mask = _mm256_movemask_epi8(m);
+
+		if (mask) {
+			return pos + zend_ulong_ntz(mask);
+		}
+		pos += 32;
+	}
+	if (len - pos >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + pos));
+		uint32_t mask = _mm_movemask_epi8(PHP_JSON_UNSAFE_MASK_SSE2(v));
+
+		if (mask) {
+			return pos + zend_ulong_ntz(mask);
+		}
+		pos += 16;
+	}
+	return pos;
+}
+# endif
+
+# if ZEND_INTRIN_AVX2_NATIVE
+#  define php_json_escape_safe_len php_json_escape_safe_len_avx2
+# elif ZEND_INTRIN_AVX2_FUNC_PROTO
+#  include "Zend/zend_cpuinfo.h"
+
+static size_t php_json_escape_safe_len(const char *s, size_t len) __attribute__((ifunc("resolve_json_escape_safe_len")));
+
+ZEND_NO_SANITIZE_ADDRESS
+ZEND_ATTRIBUTE_UNUSED /* clang mistakenly warns about this */
+static void *resolve_json_escape_safe_len() {
+	if (zend_cpu_supports_avx2()) {
+		return php_json_escape_safe_len_avx2;
+	}
+	return php_json_escape_safe_len_sse2;
+}
+# elif ZEND_INTRIN_AVX2_FUNC_PTR
+#  include "Zend/zend_cpuinfo.h"
+
+static size_t php_json_escape_safe_len_resolve(const char *s, size_t len);
+
+/* resolved on the first call, every thread stores the same value */
+static size_t (*php_json_escape_safe_len_ptr)(const char *s, size_t len) = php_json_escape_safe_len_resolve;
+
+static size_t php_json_escape_safe_len_resolve(const char *s, size_t len)
+{
+	if (zend_cpu_supports_avx2()) {
+		php_json_escape_safe_len_ptr = php_json_escape_safe_len_avx2;
+	} else {
+		php_json_escape_safe_len_ptr = php_json_escape_safe_len_sse2;
+	}
+	return php_json_escape_safe_len_ptr(s, len);
+}
+
+#  define php_json_escape_safe_len(s, len) php_json_escape_safe_len_ptr(s, len)
+# else
+#  define php_json_escape_safe_len php_json_escape_safe_len_sse2
+# endif
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# include "Zend/zend_bitset.h"
+# define PHP_JSON_ESCAPE_SIMD 1
+
+static size_t php_json_escape_safe_len(const char *s, size_t len)
+{
+	size_t pos = 0;
+
+	while (len - pos >= 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(s + pos));
+		uint8x16_t m = vorrq_u8(
+			vorrq_u8(
+				vorrq_u8(
+					vcltq_u8(v, vdupq_n_u8(' ')),
+					vcgeq_u8(v, vdupq_n_u8(0x80))),
+				vceqq_u8(v, vdupq_n_u8('"'))),
+			vorrq_u8(
+				vorrq_u8(
+					vceqq_u8(v, vdupq_n_u8('\\')),
+					vceqq_u8(v, vdupq_n_u8('/'))),
+				vorrq_u8(
+					vceqq_u8(vorrq_u8(v, vdupq_n_u8(0x01)), vdupq_n_u8('\'')),
+					vceqq_u8(vorrq_u8(v, vdupq_n_u8(0x02)), vdupq_n_u8('>')))));
+
+		if (vmaxvq_u8(m)) {
+			/* narrow to 4 bits per byte */
+			uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+			return pos + (zend_ulong_ntz(mask) >> 2);
+		}
+		pos += 16;
+	}
+	return pos;
+}
+#endif
+/* }}} */
+
 static int php_json_determine_array_type(zval *val) /* {{{ */
 {
 	int i;
@@ -297,6 +457,21 @@ static int php_json_escape_string(
 			0xffffffff, 0x500080c4, 0x10000000, 0x00000000,
 			0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
 
+#ifdef PHP_JSON_ESCAPE_SIMD
+		if (len >= 16) {
+			size_t safe = php_json_escape_safe_len(s + pos, len);
+
+			if (safe) {
+				pos += safe;
+				len -= safe;
+				if (len == 0) {
+					smart_str_appendl(buf, s, pos);
+					break;
+				}
+			}
+		}
+
+#endif
 		us = (unsigned char)s[pos];
 		if (EXPECTED(!ZEND_BIT_TEST(charmap, us))) {
 			pos++;
@@ -89,6 +89,10 @@ ZEND_BEGIN_MODULE_GLOBALS(json)
 	int encoder_depth;
 	int encode_max_depth;
 	php_json_error_code error_code;
+	zend_long key_cache_size;
+	zend_bool key_cache_persistent;
+	zend_string **key_cache;
+	uint32_t key_cache_mask;
 ZEND_END_MODULE_GLOBALS(json)
 
 PHP_JSON_API ZEND_EXTERN_MODULE_GLOBALS(json)
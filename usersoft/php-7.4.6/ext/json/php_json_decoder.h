@@ -0,0 +1,35 @@
+/*
+  +----------------------------------------------------------------------+
+  | PHP Version 7                                                        |
+  +----------------------------------------------------------------------+
+  | Copyright (c) The PHP Group                                          |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 3.01 of the PHP license,      |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.php.net/license/3_01.txt                                  |
+  | If you did not receive a copy of the PHP license and are unable to   |
+  | obtain it through the world-wide-web, please send a note to          |
+  | license@php.net so we can mail you a copy immediately.               |
+  +----------------------------------------------------------------------+
+  +----------------------------------------------------------------------+
+*/
+
+#ifndef PHP_JSON_DECODER_H
+#define	PHP_JSON_DECODER_H
+
+#include "php.h"
+#include "php_json.h"
+
+/* containers nested deeper than this are left to the parser */
+#define PHP_JSON_DECODER_MAX_NESTING 1024
+
+/* longer object keys are not kept in the key cache */
+#define PHP_JSON_KEY_CACHE_MAX_LENGTH 64
+#define PHP_JSON_KEY_CACHE_MAX_SIZE (1 << 16)
+
+int php_json_decode_fast(zval *return_value, const char *str, size_t str_len, int options, int max_depth);
+
+void php_json_key_cache_free(zend_string **cache, uint32_t mask, int persistent);
+
+#endif	/* PHP_JSON_DECODER_H */
@@ -295,6 +295,15 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_class_mysqli_multi_query, 0, 0, 1)
 	ZEND_ARG_INFO(0, query)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_mysqli_pipeline_query, 0, 0, 2)
+	MYSQLI_ZEND_ARG_OBJ_INFO_LINK()
+	ZEND_ARG_INFO(0, queries)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_mysqli_pipeline_query, 0, 0, 1)
+	ZEND_ARG_INFO(0, queries)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_mysqli_real_query, 0, 0, 1)
 	ZEND_ARG_INFO(0, query)
 ZEND_END_ARG_INFO()
@@ -467,6 +476,8 @@ const zend_function_entry mysqli_functions[] = {
 	PHP_FE(mysqli_options, 								arginfo_mysqli_options)
 	PHP_FE(mysqli_ping,									arginfo_mysqli_only_link)
 #if defined(MYSQLI_USE_MYSQLND)
+	PHP_FE(mysqli_pipeline_query,						arginfo_mysqli_pipeline_query)
+	PHP_FE(mysqli_pipeline_reap,						arginfo_mysqli_only_link)
 	PHP_FE(mysqli_poll,									arginfo_mysqli_poll)
 #endif
 	PHP_FE(mysqli_prepare,								arginfo_mysqli_prepare)
@@ -567,6 +578,8 @@ const zend_function_entry mysqli_link_methods[] = {
 	PHP_FALIAS(options, mysqli_options, arginfo_class_mysqli_options)
 	PHP_FALIAS(ping, mysqli_ping, arginfo_mysqli_no_params)
 #if defined(MYSQLI_USE_MYSQLND)
+	PHP_FALIAS(pipeline_query, mysqli_pipeline_query, arginfo_class_mysqli_pipeline_query)
+	PHP_FALIAS(pipeline_reap, mysqli_pipeline_reap, arginfo_mysqli_no_params)
 	ZEND_FENTRY(poll, ZEND_FN(mysqli_poll), arginfo_mysqli_poll, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 #endif
 	PHP_FALIAS(prepare, mysqli_prepare, arginfo_class_mysqli_prepare)
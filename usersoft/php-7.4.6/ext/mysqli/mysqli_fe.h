@@ -77,6 +77,8 @@ PHP_FUNCTION(mysqli_num_fields);
 PHP_FUNCTION(mysqli_num_rows);
 PHP_FUNCTION(mysqli_options);
 PHP_FUNCTION(mysqli_ping);
+PHP_FUNCTION(mysqli_pipeline_query);
+PHP_FUNCTION(mysqli_pipeline_reap);
 PHP_FUNCTION(mysqli_poll);
 PHP_FUNCTION(mysqli_prepare);
 PHP_FUNCTION(mysqli_query);
@@ -940,6 +940,91 @@ PHP_FUNCTION(mysqli_reap_async_query)
 }
 /* }}} */
 
+/* {{{ proto bool mysqli_pipeline_query(object link, mixed queries)
+   Send one or more queries without waiting for their results */
+PHP_FUNCTION(mysqli_pipeline_query)
+{
+	MY_MYSQL		*mysql;
+	zval			*mysql_link;
+	zval			*queries, *query;
+
+	if (zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Oz", &mysql_link, mysqli_link_class_entry, &queries) == FAILURE) {
+		return;
+	}
+
+	MYSQLI_FETCH_RESOURCE_CONN(mysql, mysql_link, MYSQLI_STATUS_VALID);
+
+	MYSQLI_DISABLE_MQ;
+
+	if (Z_TYPE_P(queries) != IS_ARRAY) {
+		if (!try_convert_to_string(queries)) {
+			return;
+		}
+		if (!Z_STRLEN_P(queries)) {
+			php_error_docref(NULL, E_WARNING, "Empty query");
+			RETURN_FALSE;
+		}
+		if (FAIL == mysqlnd_pipeline_query(mysql->mysql, Z_STRVAL_P(queries), Z_STRLEN_P(queries))) {
+			MYSQLI_REPORT_MYSQL_ERROR(mysql->mysql);
+			RETURN_FALSE;
+		}
+		RETURN_TRUE;
+	}
+
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(queries), query) {
+		zend_string *tmp_query;
+		zend_string *str = zval_get_tmp_string(query, &tmp_query);
+		enum_func_status ret;
+
+		if (!ZSTR_LEN(str)) {
+			zend_tmp_string_release(tmp_query);
+			php_error_docref(NULL, E_WARNING, "Empty query");
+			RETURN_FALSE;
+		}
+		ret = mysqlnd_pipeline_query(mysql->mysql, ZSTR_VAL(str), ZSTR_LEN(str));
+		zend_tmp_string_release(tmp_query);
+		if (FAIL == ret) {
+			MYSQLI_REPORT_MYSQL_ERROR(mysql->mysql);
+			RETURN_FALSE;
+		}
+	} ZEND_HASH_FOREACH_END();
+
+	RETURN_TRUE;
+}
+/* }}} */
+
+/* {{{ proto mixed mysqli_pipeline_reap(object link)
+   Read the result of the oldest pipelined query */
+PHP_FUNCTION(mysqli_pipeline_reap)
+{
+	MY_MYSQL		*mysql;
+	zval			*mysql_link;
+	MYSQLI_RESOURCE		*mysqli_resource;
+	MYSQL_RES 			*result = NULL;
+
+	if (zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &mysql_link, mysqli_link_class_entry) == FAILURE) {
+		return;
+	}
+
+	MYSQLI_FETCH_RESOURCE_CONN(mysql, mysql_link, MYSQLI_STATUS_VALID);
+
+	if (FAIL == mysqlnd_pipeline_reap(mysql->mysql, &result)) {
+		MYSQLI_REPORT_MYSQL_ERROR(mysql->mysql);
+		RETURN_FALSE;
+	}
+
+	if (!result) {
+		/* no result set - not a SELECT */
+		RETURN_TRUE;
+	}
+
+	mysqli_resource = (MYSQLI_RESOURCE *)ecalloc (1, sizeof(MYSQLI_RESOURCE));
+	mysqli_resource->ptr = (void *)result;
+	mysqli_resource->status = MYSQLI_STATUS_VALID;
+	MYSQLI_RETURN_RESOURCE(mysqli_resource, mysqli_result_class_entry);
+}
+/* }}} */
+
 /* {{{ proto object mysqli_stmt_get_result(object link) U
    Buffer result set on client */
 PHP_FUNCTION(mysqli_stmt_get_result)
@@ -116,6 +116,9 @@ PHPAPI void mysqlnd_debug(const char *mode);
 #define mysqlnd_query(conn, query_str, query_len)		((conn)->data)->m->query((conn)->data, (query_str), (query_len))
 #define mysqlnd_async_query(conn, query_str, query_len)	((conn)->data)->m->send_query((conn)->data, (query_str), (query_len), MYSQLND_SEND_QUERY_EXPLICIT, NULL, NULL)
 #define mysqlnd_reap_async_query(conn)					((conn)->data)->m->reap_query((conn)->data, MYSQLND_REAP_RESULT_EXPLICIT)
+#define mysqlnd_pipeline_query(conn, query_str, query_len)	((conn)->data)->m->pipeline_query((conn)->data, (query_str), (query_len))
+#define mysqlnd_pipeline_reap(conn, result)				((conn)->data)->m->pipeline_reap((conn)->data, (result), MYSQLND_STORE_NO_COPY)
+#define mysqlnd_pipeline_pending(conn)					((conn)->data)->pipeline_pending
 #define mysqlnd_unbuffered_skip_result(result)			(result)->m.skip_result((result))
 
 PHPAPI enum_func_status mysqlnd_poll(MYSQLND **r_array, MYSQLND **e_array, MYSQLND ***dont_poll, long sec, long usec, int * desc_num);
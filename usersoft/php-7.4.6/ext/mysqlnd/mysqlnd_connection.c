@@ -917,6 +917,112 @@ MYSQLND_METHOD(mysqlnd_conn_data, reap_query)(MYSQLND_CONN_DATA * conn, enum_mys
 /* }}} */
 
 
+/* {{{ mysqlnd_conn_data::pipeline_query */
+/*
+  Send a query without waiting for the results of the queries sent before it.
+  The server executes them in order and queues the responses, which are read
+  back, in order, with pipeline_reap(). Meanwhile the connection stays in
+  CONN_QUERY_SENT, so any other command fails with "out of sync".
+  The responses are only read back by pipeline_reap(), so keep pipelines
+  short: a deep pipeline of large results can fill the socket buffers in
+  both directions.
+*/
+static enum_func_status
+MYSQLND_METHOD(mysqlnd_conn_data, pipeline_query)(MYSQLND_CONN_DATA * const conn, const char * const query, const size_t query_len)
+{
+	const size_t this_func = STRUCT_OFFSET(MYSQLND_CLASS_METHODS_TYPE(mysqlnd_conn_data), pipeline_query);
+	enum_func_status ret = FAIL;
+	DBG_ENTER("mysqlnd_conn_data::pipeline_query");
+	DBG_INF_FMT("conn=%llu query=%s pending=%u", conn->thread_id, query, conn->pipeline_pending);
+
+	if (PASS == conn->m->local_tx_start(conn, this_func)) {
+		const MYSQLND_CSTRING query_string = {query, query_len};
+		const enum_mysqlnd_connection_state state = GET_CONNECTION_STATE(&conn->state);
+
+		if (state == CONN_READY) {
+			/* nothing in flight, whatever was counted is stale */
+			conn->pipeline_pending = 0;
+		} else if (state == CONN_QUERY_SENT && conn->pipeline_pending) {
+			/* queue behind the queries in flight */
+			SET_CONNECTION_STATE(&conn->state, CONN_READY);
+		}
+
+		ret = conn->command->query(conn, query_string);
+		if (PASS == ret) {
+			conn->pipeline_pending++;
+			MYSQLND_INC_CONN_STATISTIC(conn->stats, STAT_PIPELINED_QUERIES);
+		} else if (GET_CONNECTION_STATE(&conn->state) == CONN_READY && conn->pipeline_pending) {
+			SET_CONNECTION_STATE(&conn->state, CONN_QUERY_SENT);
+		}
+
+		conn->m->local_tx_end(conn, this_func, ret);
+	}
+	DBG_RETURN(ret);
+}
+/* }}} */
+
+
+/* {{{ mysqlnd_conn_data::pipeline_reap */
+/*
+  Read the response of the oldest pipelined query. A result set is buffered
+  and returned in *result, *result stays NULL for statements without one.
+  Only the first result of a multi-result statement (CALL, multi-query) is
+  returned, the following ones are read and freed so the pipeline stays in
+  sync.
+*/
+static enum_func_status
+MYSQLND_METHOD(mysqlnd_conn_data, pipeline_reap)(MYSQLND_CONN_DATA * const conn, MYSQLND_RES ** result, const unsigned int flags)
+{
+	const size_t this_func = STRUCT_OFFSET(MYSQLND_CLASS_METHODS_TYPE(mysqlnd_conn_data), pipeline_reap);
+	enum_func_status ret = FAIL;
+	DBG_ENTER("mysqlnd_conn_data::pipeline_reap");
+	DBG_INF_FMT("conn=%llu pending=%u", conn->thread_id, conn->pipeline_pending);
+
+	*result = NULL;
+	if (PASS == conn->m->local_tx_start(conn, this_func)) {
+		do {
+			if (!conn->pipeline_pending || GET_CONNECTION_STATE(&conn->state) != CONN_QUERY_SENT) {
+				SET_CLIENT_ERROR(conn->error_info, CR_COMMANDS_OUT_OF_SYNC, UNKNOWN_SQLSTATE, mysqlnd_out_of_sync);
+				DBG_ERR("Command out of sync");
+				break;
+			}
+			conn->pipeline_pending--;
+
+			ret = conn->m->query_read_result_set_header(conn, NULL);
+			if (PASS == ret && GET_CONNECTION_STATE(&conn->state) == CONN_FETCHING_DATA) {
+				if (!(*result = conn->m->store_result(conn, flags))) {
+					ret = FAIL;
+				}
+			} else if (PASS == ret && conn->last_query_type == QUERY_UPSERT && UPSERT_STATUS_GET_AFFECTED_ROWS(conn->upsert_status)) {
+				MYSQLND_INC_CONN_STATISTIC_W_VALUE(conn->stats, STAT_ROWS_AFFECTED_NORMAL, UPSERT_STATUS_GET_AFFECTED_ROWS(conn->upsert_status));
+			}
+
+			while (GET_CONNECTION_STATE(&conn->state) == CONN_NEXT_RESULT_PENDING) {
+				if (FAIL == conn->m->query_read_result_set_header(conn, NULL)) {
+					break;
+				}
+				if (GET_CONNECTION_STATE(&conn->state) == CONN_FETCHING_DATA) {
+					MYSQLND_RES * extra = conn->m->store_result(conn, flags);
+					if (extra) {
+						extra->m.free_result(extra, TRUE);
+					}
+				}
+			}
+
+			if (GET_CONNECTION_STATE(&conn->state) == CONN_QUIT_SENT) {
+				conn->pipeline_pending = 0;
+			} else if (conn->pipeline_pending) {
+				/* the next responses are still on the wire */
+				SET_CONNECTION_STATE(&conn->state, CONN_QUERY_SENT);
+			}
+		} while (0);
+		conn->m->local_tx_end(conn, this_func, ret);
+	}
+	DBG_RETURN(ret);
+}
+/* }}} */
+
+
 /* {{{ mysqlnd_conn_data::list_method */
 MYSQLND_RES *
 MYSQLND_METHOD(mysqlnd_conn_data, list_method)(MYSQLND_CONN_DATA * conn, const char * const query, const char * const achtung_wild, const char * const par1)
@@ -2387,7 +2493,10 @@ MYSQLND_CLASS_METHODS_START(mysqlnd_conn_data)
 	MYSQLND_METHOD(mysqlnd_conn_data, negotiate_client_api_capabilities),
 	MYSQLND_METHOD(mysqlnd_conn_data, get_client_api_capabilities),
 
-	MYSQLND_METHOD(mysqlnd_conn_data, get_scheme)
+	MYSQLND_METHOD(mysqlnd_conn_data, get_scheme),
+
+	MYSQLND_METHOD(mysqlnd_conn_data, pipeline_query),
+	MYSQLND_METHOD(mysqlnd_conn_data, pipeline_reap)
 MYSQLND_CLASS_METHODS_END;
 
 
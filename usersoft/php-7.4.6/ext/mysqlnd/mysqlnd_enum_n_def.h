@@ -609,6 +609,7 @@ typedef enum mysqlnd_collected_stats
 	STAT_COM_DAEMON,
 	STAT_BYTES_RECEIVED_PURE_DATA_TEXT,
 	STAT_BYTES_RECEIVED_PURE_DATA_PS,
+	STAT_PIPELINED_QUERIES,
 	STAT_LAST /* Should be always the last */
 } enum_mysqlnd_collected_stats;
 
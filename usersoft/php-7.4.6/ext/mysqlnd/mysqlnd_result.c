@@ -29,6 +29,30 @@
 #include "mysqlnd_debug.h"
 #include "mysqlnd_ext_plugin.h"
 
+/* {{{ mysqlnd_result_buffered_zval_share_row */
+/*
+  Buffered zval sets keep every decoded row until the result is freed. Result
+  sets commonly repeat a column value from one row to the next (ENUMs, status
+  columns, sorted or grouped keys), so a freshly decoded string that matches
+  the previous row is dropped and the previous row's string is shared instead.
+*/
+static void
+mysqlnd_result_buffered_zval_share_row(zval * row, const zval * const prev_row, const unsigned int field_count)
+{
+	unsigned int i;
+	for (i = 0; i < field_count; ++i) {
+		if (Z_TYPE(row[i]) == IS_STRING && Z_TYPE(prev_row[i]) == IS_STRING
+			&& Z_STR(row[i]) != Z_STR(prev_row[i])
+			&& zend_string_equal_content(Z_STR(row[i]), Z_STR(prev_row[i])))
+		{
+			zval_ptr_dtor_str(&row[i]);
+			ZVAL_COPY(&row[i], &prev_row[i]);
+		}
+	}
+}
+/* }}} */
+
+
 /* {{{ mysqlnd_result_buffered_zval::initialize_result_set_rest */
 static enum_func_status
 MYSQLND_METHOD(mysqlnd_result_buffered_zval, initialize_result_set_rest)(MYSQLND_RES_BUFFERED * const result,
@@ -62,6 +86,9 @@ MYSQLND_METHOD(mysqlnd_result_buffered_zval, initialize_result_set_rest)(MYSQLND
 				ret = FAIL;
 				break;
 			}
+			if (current_row_num && !Z_ISUNDEF(data_cursor[-(int)field_count])) {
+				mysqlnd_result_buffered_zval_share_row(data_cursor, data_cursor - field_count, field_count);
+			}
 			++result->initialized_rows;
 			for (i = 0; i < field_count; ++i) {
 				/*
@@ -990,6 +1017,9 @@ MYSQLND_METHOD(mysqlnd_result_buffered, fetch_row_c)(MYSQLND_RES * result, void
 				if (rc != PASS) {
 					DBG_RETURN(FAIL);
 				}
+				if (row_num && !Z_ISUNDEF(current_row[-(int)field_count])) {
+					mysqlnd_result_buffered_zval_share_row(current_row, current_row - field_count, field_count);
+				}
 				++set->initialized_rows;
 				for (i = 0; i < field_count; ++i) {
 					/*
@@ -1080,6 +1110,9 @@ MYSQLND_METHOD(mysqlnd_result_buffered_zval, fetch_row)(MYSQLND_RES * result, vo
 			if (rc != PASS) {
 				DBG_RETURN(FAIL);
 			}
+			if (row_num && !Z_ISUNDEF(current_row[-(int)field_count])) {
+				mysqlnd_result_buffered_zval_share_row(current_row, current_row - field_count, field_count);
+			}
 			++set->initialized_rows;
 			for (i = 0; i < field_count; ++i) {
 				/*
@@ -1741,6 +1774,10 @@ MYSQLND_METHOD(mysqlnd_res, fetch_into)(MYSQLND_RES * result, const unsigned int
 		array_size *= 2;
 	}
 	array_init_size(return_value, array_size);
+	if ((flags & (MYSQLND_FETCH_NUM|MYSQLND_FETCH_ASSOC)) == MYSQLND_FETCH_NUM) {
+		/* Columns are added in order 0..n-1, a packed array avoids the hash part */
+		zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+	}
 	if (FAIL == result->m.fetch_row(result, (void *)return_value, flags, &fetched_anything)) {
 		php_error_docref(NULL, E_WARNING, "Error while reading a row");
 		zend_array_destroy(Z_ARR_P(return_value));
@@ -190,7 +190,8 @@ const MYSQLND_STRING mysqlnd_stats_values_names[STAT_LAST] =
 	{ MYSQLND_STR_W_LEN("com_stmt_fetch") },
 	{ MYSQLND_STR_W_LEN("com_deamon") },
 	{ MYSQLND_STR_W_LEN("bytes_received_real_data_normal") },
-	{ MYSQLND_STR_W_LEN("bytes_received_real_data_ps") }
+	{ MYSQLND_STR_W_LEN("bytes_received_real_data_ps") },
+	{ MYSQLND_STR_W_LEN("pipelined_queries") }
 };
 /* }}} */
 
@@ -530,6 +530,9 @@ typedef size_t				(*func_mysqlnd_conn_data__get_client_api_capabilities)(const M
 
 typedef MYSQLND_STRING		(*func_mysqlnd_conn_data__get_scheme)(MYSQLND_CONN_DATA * conn, MYSQLND_CSTRING hostname, MYSQLND_CSTRING *socket_or_pipe, unsigned int port, zend_bool * unix_socket, zend_bool * named_pipe);
 
+typedef enum_func_status	(*func_mysqlnd_conn_data__pipeline_query)(MYSQLND_CONN_DATA * const conn, const char * const query, const size_t query_len);
+typedef enum_func_status	(*func_mysqlnd_conn_data__pipeline_reap)(MYSQLND_CONN_DATA * const conn, MYSQLND_RES ** result, const unsigned int flags);
+
 
 
 MYSQLND_CLASS_METHODS_TYPE(mysqlnd_conn_data)
@@ -620,6 +623,9 @@ MYSQLND_CLASS_METHODS_TYPE(mysqlnd_conn_data)
 	func_mysqlnd_conn_data__get_client_api_capabilities get_client_api_capabilities;
 
 	func_mysqlnd_conn_data__get_scheme get_scheme;
+
+	func_mysqlnd_conn_data__pipeline_query pipeline_query;
+	func_mysqlnd_conn_data__pipeline_reap pipeline_reap;
 };
 
 
@@ -952,6 +958,8 @@ struct st_mysqlnd_connection_data
 	enum_mysqlnd_query_type		last_query_type;
 	/* Temporary storage between query and (use|store)_result() call */
 	MYSQLND_RES						*current_result;
+	/* Queries sent with pipeline_query() whose result has not been reaped yet */
+	unsigned int	pipeline_pending;
 
 	/*
 	  How many result sets reference this connection.
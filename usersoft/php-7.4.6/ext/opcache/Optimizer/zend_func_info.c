@@ -537,6 +537,7 @@ static const func_info_t func_infos[] = {
 	F1("print_r",                      MAY_BE_TRUE | MAY_BE_STRING),
 	F0("memory_get_usage",             MAY_BE_FALSE | MAY_BE_LONG),
 	F0("memory_get_peak_usage",        MAY_BE_FALSE | MAY_BE_LONG),
+	F1("memory_get_alloc_samples",     MAY_BE_NULL | MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_LONG | MAY_BE_ARRAY_OF_ARRAY),
 	F0("register_shutdown_function",   MAY_BE_NULL | MAY_BE_FALSE),
 	F0("register_tick_function",       MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_TRUE),
 	F0("unregister_tick_function",     MAY_BE_NULL),
@@ -968,6 +969,8 @@ static const func_info_t func_infos[] = {
 	F0("mysqli_stmt_execute",					MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_TRUE),
 	F0("mysqli_poll",							MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_LONG),
 	F1("mysqli_reap_async_query",				MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_TRUE | MAY_BE_OBJECT),
+	F0("mysqli_pipeline_query",					MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_TRUE),
+	F1("mysqli_pipeline_reap",					MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_TRUE | MAY_BE_OBJECT),
 	F1("mysqli_stmt_get_result",				MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_OBJECT),
 	F1("mysqli_get_warnings",					MAY_BE_NULL | MAY_BE_FALSE | MAY_BE_OBJECT),
 	F1("mysqli_stmt_error_list",				MAY_BE_NULL | MAY_BE_ARRAY | MAY_BE_ARRAY_KEY_LONG | MAY_BE_ARRAY_OF_ARRAY),
@@ -310,9 +310,256 @@ static inline int accel_restart_is_active(void)
 	return 0;
 }
 
+#ifdef ACCEL_LOCKLESS_READERS
+/* With opcache.lockless_readers every process owns a slot in SHM and marks
+ * it active instead of taking a fcntl() read lock on the lock file. With
+ * hundreds of processes those locks all land on one inode lock list, which
+ * makes every request start and end contend in the kernel. Restarts scan the
+ * slots, and slots of processes that died are taken over. */
+static int accel_reader_pid_is_dead(pid_t pid)
+{
+	return kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+static zend_accel_reader_slot *accel_reader_slot(void)
+{
+	zend_accel_reader_slot *slot = ZCG(reader_slot);
+	pid_t pid = getpid();
+	int pass, i;
+
+	/* after fork() the slot of the parent is inherited, don't share it */
+	if (EXPECTED(slot != NULL) && EXPECTED(slot->pid == pid)) {
+		return slot;
+	}
+	ZCG(reader_slot) = NULL;
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < ACCEL_MAX_READER_SLOTS; i++) {
+			pid_t owner;
+
+			slot = &ZCSG(reader_slots)[i];
+			owner = slot->pid;
+			/* free slots first, dead owners (one kill() each) only if none is left */
+			if (owner == 0 || (pass == 1 && accel_reader_pid_is_dead(owner))) {
+				if (__sync_bool_compare_and_swap(&slot->pid, owner, pid)) {
+					slot->active = 0;
+					ZCG(reader_slot) = slot;
+					return slot;
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+static int accel_readers_are_inactive(void)
+{
+	int i;
+
+	__sync_synchronize();
+	for (i = 0; i < ACCEL_MAX_READER_SLOTS; i++) {
+		zend_accel_reader_slot *slot = &ZCSG(reader_slots)[i];
+		pid_t owner = slot->pid;
+
+		if (owner && slot->active) {
+			if (!accel_reader_pid_is_dead(owner)) {
+				return 0;
+			}
+			slot->active = 0;
+		}
+	}
+	return 1;
+}
+#endif
+
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+/* With opcache.shared_realpath_cache_entries the paths resolved by one process
+ * are kept in SHM for the others, behind their own realpath cache. Otherwise
+ * every process resolves each path again, one lstat() per path component,
+ * when it starts and whenever its realpath_cache_ttl expires. opcache_reset()
+ * drops all the entries by moving to a new generation.
+ *
+ * Entries are updated without a lock: a writer makes the sequence number odd
+ * with a CAS, rewrites the entry and makes it even again. Readers compare the
+ * sequence number before and after copying an entry. */
+static zend_always_inline zend_accel_realpath_entry *accel_realpath_cache_set(zend_ulong hash)
+{
+	return &ZCSG(realpath_cache)[hash & ZCSG(realpath_cache_mask) & ~(zend_ulong)(ACCEL_REALPATH_WAYS - 1)];
+}
+
+static int accel_realpath_cache_find(const char *path, size_t path_len, time_t t, char *realpath, size_t *realpath_len, int *is_dir, time_t *expires)
+{
+	zend_accel_realpath_entry *entry;
+	zend_ulong hash;
+	uint32_t generation, i;
+
+	if (path_len > ACCEL_REALPATH_MAX_LEN) {
+		return FAILURE;
+	}
+	hash = zend_inline_hash_func(path, path_len);
+	generation = ZCSG(realpath_generation);
+	entry = accel_realpath_cache_set(hash);
+	for (i = 0; i < ACCEL_REALPATH_WAYS; i++, entry++) {
+		char buf[ACCEL_REALPATH_MAX_LEN + 1];
+		uint32_t seq = entry->seq;
+		size_t len;
+		int dir;
+		time_t exp;
+
+		if (seq & 1) {
+			continue;
+		}
+		__sync_synchronize();
+		if (entry->hash != hash
+		 || entry->path_len != path_len
+		 || entry->generation != generation
+		 || entry->root_hash != ZCG(root_hash)
+		 || entry->expires < t
+		 || memcmp(entry->path, path, path_len) != 0) {
+			continue;
+		}
+		len = entry->realpath_len;
+		if (len > ACCEL_REALPATH_MAX_LEN) {
+			continue;
+		}
+		memcpy(buf, entry->realpath, len);
+		dir = entry->is_dir;
+		exp = entry->expires;
+		__sync_synchronize();
+		if (entry->seq != seq) {
+			continue;
+		}
+		memcpy(realpath, buf, len);
+		realpath[len] = '\0';
+		*realpath_len = len;
+		*is_dir = dir;
+		*expires = exp;
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+static zend_accel_realpath_entry *accel_realpath_cache_lock(zend_accel_realpath_entry *entry, uint32_t *seq)
+{
+	*seq = entry->seq;
+	/* another process is rewriting it, leave it alone */
+	if ((*seq & 1) || !__sync_bool_compare_and_swap(&entry->seq, *seq, *seq + 1)) {
+		return NULL;
+	}
+	return entry;
+}
+
+static void accel_realpath_cache_unlock(zend_accel_realpath_entry *entry, uint32_t seq)
+{
+	__sync_synchronize();
+	entry->seq = seq + 2;
+}
+
+static void accel_realpath_cache_add(const char *path, size_t path_len, const char *realpath, size_t realpath_len, int is_dir, time_t expires)
+{
+	zend_accel_realpath_entry *entry, *victim = NULL;
+	zend_ulong hash;
+	uint32_t generation, seq, i;
+
+	if (path_len > ACCEL_REALPATH_MAX_LEN || realpath_len > ACCEL_REALPATH_MAX_LEN) {
+		return;
+	}
+	hash = zend_inline_hash_func(path, path_len);
+	generation = ZCSG(realpath_generation);
+	entry = accel_realpath_cache_set(hash);
+	/* reuse the entry of the same path, or evict the stale or oldest one */
+	for (i = 0; i < ACCEL_REALPATH_WAYS; i++, entry++) {
+		if (entry->hash == hash && entry->path_len == path_len) {
+			victim = entry;
+			break;
+		}
+		if (!victim
+		 || (victim->generation == generation
+		  && (entry->generation != generation || entry->expires < victim->expires))) {
+			victim = entry;
+		}
+	}
+	if (!accel_realpath_cache_lock(victim, &seq)) {
+		return;
+	}
+	victim->generation = generation;
+	victim->hash = hash;
+	victim->root_hash = ZCG(root_hash);
+	victim->expires = expires;
+	victim->path_len = path_len;
+	victim->realpath_len = realpath_len;
+	victim->is_dir = is_dir > 0;
+	memcpy(victim->path, path, path_len);
+	memcpy(victim->realpath, realpath, realpath_len);
+	accel_realpath_cache_unlock(victim, seq);
+}
+
+static void accel_realpath_cache_del(const char *path, size_t path_len)
+{
+	zend_accel_realpath_entry *entry;
+	zend_ulong hash;
+	uint32_t seq, i;
+
+	if (path_len > ACCEL_REALPATH_MAX_LEN) {
+		return;
+	}
+	hash = zend_inline_hash_func(path, path_len);
+	entry = accel_realpath_cache_set(hash);
+	for (i = 0; i < ACCEL_REALPATH_WAYS; i++, entry++) {
+		if (entry->hash == hash && entry->path_len == path_len
+		 && accel_realpath_cache_lock(entry, &seq)) {
+			entry->hash = 0;
+			entry->path_len = 0;
+			accel_realpath_cache_unlock(entry, seq);
+		}
+	}
+}
+
+static const realpath_cache_shared_handlers accel_realpath_handlers = {
+	accel_realpath_cache_find,
+	accel_realpath_cache_add,
+	accel_realpath_cache_del
+};
+
+static void accel_realpath_cache_init(void)
+{
+	zend_long entries = ZCG(accel_directives).shared_realpath_cache_entries;
+	uint32_t size = ACCEL_REALPATH_WAYS;
+
+	ZCSG(realpath_cache) = NULL;
+	if (entries <= 0) {
+		return;
+	}
+	/* must be a power of two */
+	while (size < entries && size < (1u << 30) / sizeof(zend_accel_realpath_entry)) {
+		size <<= 1;
+	}
+	ZCSG(realpath_cache) = zend_shared_alloc(size * sizeof(zend_accel_realpath_entry));
+	if (!ZCSG(realpath_cache)) {
+		zend_accel_error(ACCEL_LOG_WARNING, "Not enough shared memory for opcache.shared_realpath_cache_entries, the shared realpath cache is disabled");
+		return;
+	}
+	memset(ZCSG(realpath_cache), 0, size * sizeof(zend_accel_realpath_entry));
+	ZCSG(realpath_cache_mask) = size - 1;
+	ZCSG(realpath_generation) = 1;
+}
+#endif
+
 /* Creates a read lock for SHM access */
 static inline int accel_activate_add(void)
 {
+#ifdef ACCEL_LOCKLESS_READERS
+	/* slots live in SHM, which opcache.protect_memory keeps read-only */
+	if (ZCG(accel_directives).lockless_readers && !ZCG(accel_directives).protect_memory) {
+		zend_accel_reader_slot *slot = accel_reader_slot();
+
+		if (EXPECTED(slot != NULL)) {
+			slot->active = 1;
+			/* the mark has to be visible before any SHM read */
+			__sync_synchronize();
+			return SUCCESS;
+		}
+	}
+#endif
 #ifdef ZEND_WIN32
 	SHM_UNPROTECT();
 	INCREMENT(mem_usage);
@@ -336,6 +583,15 @@ static inline int accel_activate_add(void)
 /* Releases a lock for SHM access */
 static inline void accel_deactivate_sub(void)
 {
+#ifdef ACCEL_LOCKLESS_READERS
+	zend_accel_reader_slot *slot = ZCG(reader_slot);
+
+	if (slot && slot->active && slot->pid == getpid()) {
+		__sync_synchronize();
+		slot->active = 0;
+		return;
+	}
+#endif
 #ifdef ZEND_WIN32
 	if (ZCG(counted)) {
 		SHM_UNPROTECT();
@@ -359,6 +615,14 @@ static inline void accel_deactivate_sub(void)
 
 static inline void accel_unlock_all(void)
 {
+#ifdef ACCEL_LOCKLESS_READERS
+	zend_accel_reader_slot *slot = ZCG(reader_slot);
+
+	if (slot && slot->pid == getpid()) {
+		__sync_synchronize();
+		slot->active = 0;
+	}
+#endif
 #ifdef ZEND_WIN32
 	accel_deactivate_sub();
 #else
@@ -834,6 +1098,27 @@ static inline int accel_is_inactive(void)
 #else
 	struct flock mem_usage_check;
 
+#ifdef ACCEL_LOCKLESS_READERS
+	if (!accel_readers_are_inactive()) {
+		if (ZCG(accel_directives).force_restart_timeout
+			&& ZCSG(force_restart_time)
+			&& time(NULL) >= ZCSG(force_restart_time)) {
+			int i;
+
+			for (i = 0; i < ACCEL_MAX_READER_SLOTS; i++) {
+				zend_accel_reader_slot *slot = &ZCSG(reader_slots)[i];
+				pid_t owner = slot->pid;
+
+				if (owner && slot->active && owner != getpid()) {
+					zend_accel_error(ACCEL_LOG_WARNING, "Forced restart at %ld (after " ZEND_LONG_FMT " seconds), killing reader %d", (long)time(NULL), ZCG(accel_directives).force_restart_timeout, owner);
+					kill(owner, SIGKILL);
+				}
+			}
+		}
+		return FAILURE;
+	}
+#endif
+
 	mem_usage_check.l_type = F_WRLCK;
 	mem_usage_check.l_whence = SEEK_SET;
 	mem_usage_check.l_start = 1;
@@ -2439,6 +2724,9 @@ int accel_activate(INIT_FUNC_ARGS)
 				zend_map_ptr_reset();
 				zend_reset_cache_vars();
 				zend_accel_hash_clean(&ZCSG(hash));
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+				ZCSG(realpath_generation)++;
+#endif
 
 				if (ZCG(accel_directives).interned_strings_buffer) {
 					accel_interned_strings_restore_state();
@@ -2587,6 +2875,9 @@ static int zend_accel_init_shm(void)
 	ZSMMG(app_shared_globals) = accel_shared_globals;
 
 	zend_accel_hash_init(&ZCSG(hash), ZCG(accel_directives).max_accelerated_files);
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+	accel_realpath_cache_init();
+#endif
 
 	if (ZCG(accel_directives).interned_strings_buffer) {
 		uint32_t hash_size;
@@ -2964,6 +3255,13 @@ static int accel_post_startup(void)
 		zend_shared_alloc_save_state();
 		zend_shared_alloc_unlock();
 
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+		/* entries live in SHM, which opcache.protect_memory keeps read-only */
+		if (ZCSG(realpath_cache) && !ZCG(accel_directives).protect_memory) {
+			realpath_cache_set_shared_handlers(&accel_realpath_handlers);
+		}
+#endif
+
 		SHM_PROTECT();
 	} else if (!ZCG(accel_directives).file_cache) {
 		accel_startup_ok = 0;
@@ -3061,6 +3359,10 @@ void accel_shutdown(void)
 
 	_file_cache_only = file_cache_only;
 
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+	realpath_cache_set_shared_handlers(NULL);
+#endif
+
 	accel_reset_pcre_cache();
 
 #ifdef ZTS
@@ -4242,6 +4544,93 @@ static void preload_load(void)
 	}
 }
 
+/* Literal patterns of these functions are compiled (and JIT-ed) by the
+ * process that preloads, so that forked workers inherit the compiled code
+ * instead of each of them compiling it on first use. */
+static zend_bool preload_is_pcre_function(zend_string *lcname)
+{
+	return zend_string_equals_literal(lcname, "preg_match")
+		|| zend_string_equals_literal(lcname, "preg_match_all")
+		|| zend_string_equals_literal(lcname, "preg_replace")
+		|| zend_string_equals_literal(lcname, "preg_replace_callback")
+		|| zend_string_equals_literal(lcname, "preg_filter")
+		|| zend_string_equals_literal(lcname, "preg_split")
+		|| zend_string_equals_literal(lcname, "preg_grep");
+}
+
+static void preload_pin_regex(zval *pattern)
+{
+	if (Z_TYPE_P(pattern) == IS_STRING) {
+		pcre_pin_compiled_regex_cache(Z_STR_P(pattern));
+	} else if (Z_TYPE_P(pattern) == IS_ARRAY) {
+		zval *zv;
+
+		ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(pattern), zv) {
+			if (Z_TYPE_P(zv) == IS_STRING) {
+				pcre_pin_compiled_regex_cache(Z_STR_P(zv));
+			}
+		} ZEND_HASH_FOREACH_END();
+	}
+}
+
+static void preload_pin_op_array_regexes(zend_op_array *op_array)
+{
+	zend_op *opline = op_array->opcodes;
+	zend_op *end = opline + op_array->last;
+
+	for (; opline + 1 < end; opline++) {
+		zend_string *lcname;
+		zend_op *send = opline + 1;
+
+		switch (opline->opcode) {
+			case ZEND_INIT_FCALL:
+				lcname = Z_STR_P(RT_CONSTANT(opline, opline->op2));
+				break;
+			case ZEND_INIT_FCALL_BY_NAME:
+				lcname = Z_STR_P(RT_CONSTANT(opline, opline->op2) + 1);
+				break;
+			case ZEND_INIT_NS_FCALL_BY_NAME:
+				lcname = Z_STR_P(RT_CONSTANT(opline, opline->op2) + 2);
+				break;
+			default:
+				continue;
+		}
+		if ((send->opcode == ZEND_SEND_VAL || send->opcode == ZEND_SEND_VAL_EX)
+		 && send->op1_type == IS_CONST
+		 && send->op2.num == 1
+		 && preload_is_pcre_function(lcname)) {
+			preload_pin_regex(RT_CONSTANT(send, send->op1));
+		}
+	}
+}
+
+static void preload_pin_regexes(void)
+{
+	zend_script *script = &ZCSG(preload_script)->script;
+	zend_op_array *op_array;
+	zend_class_entry *ce;
+	int orig_error_reporting;
+
+	/* Broken patterns are reported when (and if) they are used at run-time */
+	orig_error_reporting = EG(error_reporting);
+	EG(error_reporting) = 0;
+
+	ZEND_HASH_FOREACH_PTR(&script->function_table, op_array) {
+		preload_pin_op_array_regexes(op_array);
+	} ZEND_HASH_FOREACH_END();
+
+	ZEND_HASH_FOREACH_PTR(&script->class_table, ce) {
+		ZEND_HASH_FOREACH_PTR(&ce->function_table, op_array) {
+			if (op_array->type == ZEND_USER_FUNCTION
+			 && op_array->scope == ce) {
+				preload_pin_op_array_regexes(op_array);
+			}
+		} ZEND_HASH_FOREACH_END();
+	} ZEND_HASH_FOREACH_END();
+
+	EG(error_reporting) = orig_error_reporting;
+}
+
 static int preload_autoload(zend_string *filename)
 {
 	zend_persistent_script *persistent_script;
@@ -4311,6 +4700,61 @@ static int preload_autoload(zend_string *filename)
 	return ret;
 }
 
+/* Compiles every script listed in opcache.preload_profile (one path per line,
+ * as opcache_get_preload_profile() returns them) that the preload script
+ * didn't load itself. preload_link() takes care of the order classes end up
+ * being linked in, so the list only has to name the files. */
+static void preload_apply_profile(const char *profile)
+{
+	php_stream *stream;
+	char line[MAXPATHLEN + 2];
+	uint32_t orig_compiler_options = CG(compiler_options);
+
+	stream = php_stream_open_wrapper((char *) profile, "rb", REPORT_ERRORS, NULL);
+	if (!stream) {
+		return;
+	}
+
+	CG(compiler_options) |= ZEND_COMPILE_WITHOUT_EXECUTION;
+	while (php_stream_gets(stream, line, sizeof(line))) {
+		size_t len = strlen(line);
+		zend_file_handle file_handle;
+		zend_op_array *op_array;
+		zend_string *path;
+
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+			line[--len] = '\0';
+		}
+		if (len == 0 || line[0] == '#') {
+			continue;
+		}
+
+		path = zend_resolve_path(line, len);
+		if (!path) {
+			zend_accel_error(ACCEL_LOG_WARNING, "Preload profile: can't resolve \"%s\"", line);
+			continue;
+		}
+		if (zend_hash_exists(&EG(included_files), path)
+		 || zend_hash_exists(preload_scripts, path)) {
+			zend_string_release(path);
+			continue;
+		}
+
+		zend_stream_init_filename(&file_handle, ZSTR_VAL(path));
+		op_array = persistent_compile_file(&file_handle, ZEND_INCLUDE);
+		zend_hash_add_empty_element(&EG(included_files), path);
+		if (op_array) {
+			destroy_op_array(op_array);
+			efree_size(op_array, sizeof(zend_op_array));
+		}
+		zend_destroy_file_handle(&file_handle);
+		zend_string_release(path);
+	}
+	CG(compiler_options) = orig_compiler_options;
+
+	php_stream_close(stream);
+}
+
 static int accel_preload(const char *config)
 {
 	zend_file_handle file_handle;
@@ -4363,6 +4807,12 @@ static int accel_preload(const char *config)
 			ret = FAILURE;
 		}
 
+		if (ret == SUCCESS
+		 && ZCG(accel_directives).preload_profile
+		 && *ZCG(accel_directives).preload_profile) {
+			preload_apply_profile(ZCG(accel_directives).preload_profile);
+		}
+
 		if (ret == SUCCESS) {
 			preload_ensure_classes_loadable();
 		}
@@ -4581,6 +5031,7 @@ static int accel_preload(const char *config)
 		ZEND_ASSERT(ZCSG(preload_script)->arena_size == 0);
 
 		preload_load();
+		preload_pin_regexes();
 
 		/* Store individual scripts with unlinked classes */
 		HANDLE_BLOCK_INTERRUPTIONS();
@@ -4647,6 +5098,10 @@ static int accel_finish_startup(void)
 		return SUCCESS;
 	}
 
+	if (ZCG(accel_directives).file_cache && ZCG(accel_directives).file_cache_warmup) {
+		zend_file_cache_warmup();
+	}
+
 	if (ZCG(accel_directives).preload && *ZCG(accel_directives).preload) {
 #ifdef ZEND_WIN32
 		zend_accel_error(ACCEL_LOG_ERROR, "Preloading is not supported on Windows");
@@ -178,6 +178,9 @@ typedef struct _zend_accel_directives {
 	char          *file_cache;
 	zend_bool      file_cache_only;
 	zend_bool      file_cache_consistency_checks;
+	zend_bool      file_cache_warmup;
+	zend_bool      lockless_readers;
+	zend_long      shared_realpath_cache_entries;
 #if ENABLE_FILE_CACHE_FALLBACK
 	zend_bool      file_cache_fallback;
 #endif
@@ -185,6 +188,7 @@ typedef struct _zend_accel_directives {
 	zend_bool      huge_code_pages;
 #endif
 	char *preload;
+	char *preload_profile;
 #ifndef ZEND_WIN32
 	char *preload_user;
 #endif
@@ -193,8 +197,44 @@ typedef struct _zend_accel_directives {
 #endif
 } zend_accel_directives;
 
+#if !defined(ZEND_WIN32) && !defined(ZTS)
+# define ACCEL_LOCKLESS_READERS 1
+# define ACCEL_MAX_READER_SLOTS 1024
+
+/* Per process replacement of the SHM read lock, see accel_activate_add() */
+typedef struct _zend_accel_reader_slot {
+	pid_t             pid;     /* owner, claimed with a CAS */
+	volatile uint32_t active;  /* written only by the owner */
+} zend_accel_reader_slot;
+#endif
+
+#ifndef ZEND_WIN32
+# define ACCEL_SHARED_REALPATH_CACHE 1
+# define ACCEL_REALPATH_MAX_LEN 255 /* longer paths are only cached per process */
+# define ACCEL_REALPATH_WAYS 4      /* entries a path may be stored in */
+
+/* Entry of the realpath cache shared by all processes, see
+ * accel_realpath_cache_find(). Readers copy it without a lock, an entry
+ * that changed meanwhile is simply a miss. */
+typedef struct _zend_accel_realpath_entry {
+	volatile uint32_t seq;         /* odd while a process rewrites the entry */
+	uint32_t          generation;  /* entries older than the last restart are stale */
+	zend_ulong        hash;
+	zend_ulong        root_hash;   /* paths resolved in another chroot() differ */
+	time_t            expires;
+	uint16_t          path_len;
+	uint16_t          realpath_len;
+	zend_bool         is_dir;
+	char              path[ACCEL_REALPATH_MAX_LEN + 1];
+	char              realpath[ACCEL_REALPATH_MAX_LEN + 1];
+} zend_accel_realpath_entry;
+#endif
+
 typedef struct _zend_accel_globals {
 	int                     counted;   /* the process uses shared memory */
+#ifdef ACCEL_LOCKLESS_READERS
+	zend_accel_reader_slot *reader_slot;
+#endif
 	zend_bool               enabled;
 	zend_bool               locked;    /* thread obtained exclusive lock */
 	zend_bool               accelerator_enabled; /* accelerator enabled for current request */
@@ -263,6 +303,14 @@ typedef struct _zend_accel_shared_globals {
 	LONGLONG   restart_in;
 #endif
 	zend_bool       restart_in_progress;
+#ifdef ACCEL_LOCKLESS_READERS
+	zend_accel_reader_slot reader_slots[ACCEL_MAX_READER_SLOTS];
+#endif
+#ifdef ACCEL_SHARED_REALPATH_CACHE
+	zend_accel_realpath_entry *realpath_cache;  /* NULL when disabled */
+	uint32_t                   realpath_cache_mask;
+	volatile uint32_t          realpath_generation;
+#endif
 
 	/* Preloading */
 	zend_persistent_script *preload_script;
@@ -136,6 +136,12 @@ zend_accel_hash_entry* zend_accel_hash_update(zend_accel_hash *accel_hash, const
 	entry->key = key;
 	entry->key_length = key_length;
 	entry->next = accel_hash->hash_table[index];
+	/* lookups walk the chains without a lock, publish only a complete entry */
+#ifdef ZEND_WIN32
+	MemoryBarrier();
+#elif defined(__GNUC__)
+	__sync_synchronize();
+#endif
 	accel_hash->hash_table[index] = entry;
 	return entry;
 }
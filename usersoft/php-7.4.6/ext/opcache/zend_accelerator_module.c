@@ -61,6 +61,10 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_opcache_is_script_cached, 0, 0, 1)
 	ZEND_ARG_INFO(0, script)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_opcache_get_preload_profile, 0, 0, 0)
+	ZEND_ARG_INFO(0, min_hits)
+ZEND_END_ARG_INFO()
+
 /* User functions */
 static ZEND_FUNCTION(opcache_reset);
 static ZEND_FUNCTION(opcache_invalidate);
@@ -70,6 +74,7 @@ static ZEND_FUNCTION(opcache_is_script_cached);
 static ZEND_FUNCTION(opcache_get_status);
 static ZEND_FUNCTION(opcache_compile_file);
 static ZEND_FUNCTION(opcache_get_configuration);
+static ZEND_FUNCTION(opcache_get_preload_profile);
 
 static const zend_function_entry accel_functions[] = {
 	/* User functions */
@@ -80,6 +85,7 @@ static const zend_function_entry accel_functions[] = {
 	/* Private functions */
 	ZEND_FE(opcache_get_configuration,		arginfo_opcache_none)
 	ZEND_FE(opcache_get_status,				arginfo_opcache_get_status)
+	ZEND_FE(opcache_get_preload_profile,	arginfo_opcache_get_preload_profile)
 	ZEND_FE_END
 };
 
@@ -289,6 +295,8 @@ ZEND_INI_BEGIN()
 	STD_PHP_INI_ENTRY("opcache.max_wasted_percentage" , "5"   , PHP_INI_SYSTEM, OnUpdateMaxWastedPercentage,	 accel_directives.max_wasted_percentage,     zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.consistency_checks"    , "0"   , PHP_INI_ALL   , OnUpdateLong,	             accel_directives.consistency_checks,        zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.force_restart_timeout" , "180" , PHP_INI_SYSTEM, OnUpdateLong,	             accel_directives.force_restart_timeout,     zend_accel_globals, accel_globals)
+	STD_PHP_INI_ENTRY("opcache.lockless_readers"      , "1"   , PHP_INI_SYSTEM, OnUpdateBool,	             accel_directives.lockless_readers,          zend_accel_globals, accel_globals)
+	STD_PHP_INI_ENTRY("opcache.shared_realpath_cache_entries", "0", PHP_INI_SYSTEM, OnUpdateLong,	     accel_directives.shared_realpath_cache_entries, zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.revalidate_freq"       , "2"   , PHP_INI_ALL   , OnUpdateLong,	             accel_directives.revalidate_freq,           zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.file_update_protection", "2"   , PHP_INI_ALL   , OnUpdateLong,                accel_directives.file_update_protection,    zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.preferred_memory_model", ""    , PHP_INI_SYSTEM, OnUpdateStringUnempty,       accel_directives.memory_model,              zend_accel_globals, accel_globals)
@@ -314,6 +322,7 @@ ZEND_INI_BEGIN()
 	STD_PHP_INI_ENTRY("opcache.file_cache"                    , NULL  , PHP_INI_SYSTEM, OnUpdateFileCache, accel_directives.file_cache,                    zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.file_cache_only"               , "0"   , PHP_INI_SYSTEM, OnUpdateBool,	   accel_directives.file_cache_only,               zend_accel_globals, accel_globals)
 	STD_PHP_INI_ENTRY("opcache.file_cache_consistency_checks" , "1"   , PHP_INI_SYSTEM, OnUpdateBool,	   accel_directives.file_cache_consistency_checks, zend_accel_globals, accel_globals)
+	STD_PHP_INI_ENTRY("opcache.file_cache_warmup"             , "0"   , PHP_INI_SYSTEM, OnUpdateBool,	   accel_directives.file_cache_warmup,             zend_accel_globals, accel_globals)
 #if ENABLE_FILE_CACHE_FALLBACK
 	STD_PHP_INI_ENTRY("opcache.file_cache_fallback"           , "1"   , PHP_INI_SYSTEM, OnUpdateBool,	   accel_directives.file_cache_fallback,           zend_accel_globals, accel_globals)
 #endif
@@ -321,6 +330,7 @@ ZEND_INI_BEGIN()
 	STD_PHP_INI_BOOLEAN("opcache.huge_code_pages"             , "0"   , PHP_INI_SYSTEM, OnUpdateBool,      accel_directives.huge_code_pages,               zend_accel_globals, accel_globals)
 #endif
 	STD_PHP_INI_ENTRY("opcache.preload"                       , ""    , PHP_INI_SYSTEM, OnUpdateStringUnempty,    accel_directives.preload,                zend_accel_globals, accel_globals)
+	STD_PHP_INI_ENTRY("opcache.preload_profile"               , ""    , PHP_INI_SYSTEM, OnUpdateStringUnempty,    accel_directives.preload_profile,        zend_accel_globals, accel_globals)
 #ifndef ZEND_WIN32
 	STD_PHP_INI_ENTRY("opcache.preload_user"                  , ""    , PHP_INI_SYSTEM, OnUpdateStringUnempty,    accel_directives.preload_user,           zend_accel_globals, accel_globals)
 #endif
@@ -576,6 +586,67 @@ static int accelerator_get_scripts(zval *return_value)
 	return 1;
 }
 
+static int accelerator_compare_script_hits(const void *a, const void *b)
+{
+	zend_long ha = Z_LVAL(((Bucket *)a)->val), hb = Z_LVAL(((Bucket *)b)->val);
+
+	return ha < hb ? 1 : (ha > hb ? -1 : 0);
+}
+
+/* {{{ proto array opcache_get_preload_profile([int min_hits])
+   Returns the cached scripts with at least min_hits hits, most used first, as opcache.preload_profile expects them */
+static ZEND_FUNCTION(opcache_get_preload_profile)
+{
+	zend_long min_hits = 1;
+	zend_accel_hash_entry *cache_entry;
+	zend_string *filename;
+	uint32_t i;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l", &min_hits) == FAILURE) {
+		return;
+	}
+
+	if (!validate_api_restriction()) {
+		RETURN_FALSE;
+	}
+
+	if (!ZCG(accelerator_enabled) || accelerator_shm_read_lock() != SUCCESS) {
+		RETURN_FALSE;
+	}
+
+	array_init(return_value);
+	for (i = 0; i < ZCSG(hash).max_num_entries; i++) {
+		for (cache_entry = ZCSG(hash).hash_table[i]; cache_entry; cache_entry = cache_entry->next) {
+			zend_persistent_script *script;
+
+			if (cache_entry->indirect) continue;
+
+			script = (zend_persistent_script *)cache_entry->data;
+			if ((zend_long)script->dynamic_members.hits >= min_hits) {
+				zval hits;
+
+				ZVAL_LONG(&hits, (zend_long)script->dynamic_members.hits);
+				zend_hash_update(Z_ARRVAL_P(return_value), script->script.filename, &hits);
+			}
+		}
+	}
+	accelerator_shm_read_unlock();
+
+	zend_hash_sort(Z_ARRVAL_P(return_value), accelerator_compare_script_hits, 0);
+	/* keep only the names, in order */
+	{
+		zval list;
+
+		array_init_size(&list, zend_hash_num_elements(Z_ARRVAL_P(return_value)));
+		ZEND_HASH_FOREACH_STR_KEY(Z_ARRVAL_P(return_value), filename) {
+			add_next_index_str(&list, zend_string_copy(filename));
+		} ZEND_HASH_FOREACH_END();
+		zval_ptr_dtor(return_value);
+		ZVAL_COPY_VALUE(return_value, &list);
+	}
+}
+/* }}} */
+
 /* {{{ proto array accelerator_get_status([bool fetch_scripts])
    Obtain statistics information regarding code acceleration */
 static ZEND_FUNCTION(opcache_get_status)
@@ -743,6 +814,8 @@ static ZEND_FUNCTION(opcache_get_configuration)
 	add_assoc_double(&directives, "opcache.max_wasted_percentage",  ZCG(accel_directives).max_wasted_percentage);
 	add_assoc_long(&directives, 	 "opcache.consistency_checks",     ZCG(accel_directives).consistency_checks);
 	add_assoc_long(&directives, 	 "opcache.force_restart_timeout",  ZCG(accel_directives).force_restart_timeout);
+	add_assoc_bool(&directives, 	 "opcache.lockless_readers",       ZCG(accel_directives).lockless_readers);
+	add_assoc_long(&directives, 	 "opcache.shared_realpath_cache_entries", ZCG(accel_directives).shared_realpath_cache_entries);
 	add_assoc_long(&directives, 	 "opcache.revalidate_freq",        ZCG(accel_directives).revalidate_freq);
 	add_assoc_string(&directives, "opcache.preferred_memory_model", STRING_NOT_NULL(ZCG(accel_directives).memory_model));
 	add_assoc_string(&directives, "opcache.blacklist_filename",     STRING_NOT_NULL(ZCG(accel_directives).user_blacklist_filename));
@@ -763,6 +836,7 @@ static ZEND_FUNCTION(opcache_get_configuration)
 	add_assoc_string(&directives, "opcache.file_cache",                    ZCG(accel_directives).file_cache ? ZCG(accel_directives).file_cache : "");
 	add_assoc_bool(&directives,   "opcache.file_cache_only",               ZCG(accel_directives).file_cache_only);
 	add_assoc_bool(&directives,   "opcache.file_cache_consistency_checks", ZCG(accel_directives).file_cache_consistency_checks);
+	add_assoc_bool(&directives,   "opcache.file_cache_warmup",             ZCG(accel_directives).file_cache_warmup);
 #if ENABLE_FILE_CACHE_FALLBACK
 	add_assoc_bool(&directives,   "opcache.file_cache_fallback",           ZCG(accel_directives).file_cache_fallback);
 #endif
@@ -774,6 +848,7 @@ static ZEND_FUNCTION(opcache_get_configuration)
 	add_assoc_bool(&directives,   "opcache.huge_code_pages",         ZCG(accel_directives).huge_code_pages);
 #endif
 	add_assoc_string(&directives, "opcache.preload", STRING_NOT_NULL(ZCG(accel_directives).preload));
+	add_assoc_string(&directives, "opcache.preload_profile", STRING_NOT_NULL(ZCG(accel_directives).preload_profile));
 #ifndef ZEND_WIN32
 	add_assoc_string(&directives, "opcache.preload_user", STRING_NOT_NULL(ZCG(accel_directives).preload_user));
 #endif
@@ -49,6 +49,14 @@
 # include <sys/file.h>
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+#ifdef HAVE_DIRENT_H
+# include <dirent.h>
+#endif
+
 #if __has_feature(memory_sanitizer)
 # include <sanitizer/msan_interface.h>
 #endif
@@ -1518,6 +1526,11 @@ zend_persistent_script *zend_file_cache_script_load(zend_file_handle *file_handl
 	int cache_it = 1;
 	unsigned int actual_checksum;
 	int ok;
+#ifdef HAVE_SYS_MMAN_H
+	void *map = MAP_FAILED;
+	size_t map_size = 0;
+	zend_stat_t st;
+#endif
 
 	if (!full_path) {
 		return NULL;
@@ -1576,22 +1589,37 @@ zend_persistent_script *zend_file_cache_script_load(zend_file_handle *file_handl
 	}
 
 	checkpoint = zend_arena_checkpoint(CG(arena));
+#ifdef HAVE_SYS_MMAN_H
+	/* When the script is going to SHM, map the file and copy it there straight
+	 * from the page cache instead of reading it into process memory first */
+	map_size = sizeof(info) + info.mem_size + info.str_size;
+	if (!file_cache_only
+	 && zend_fstat(fd, &st) == 0
+	 && (size_t)st.st_size >= map_size) {
+		map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	}
+	if (map != MAP_FAILED) {
+		mem = (char*)map + sizeof(info);
+	} else
+#endif
+	{
 #if defined(__AVX__) || defined(__SSE2__)
-	/* Align to 64-byte boundary */
-	mem = zend_arena_alloc(&CG(arena), info.mem_size + info.str_size + 64);
-	mem = (void*)(((zend_uintptr_t)mem + 63L) & ~63L);
+		/* Align to 64-byte boundary */
+		mem = zend_arena_alloc(&CG(arena), info.mem_size + info.str_size + 64);
+		mem = (void*)(((zend_uintptr_t)mem + 63L) & ~63L);
 #else
-	mem = zend_arena_alloc(&CG(arena), info.mem_size + info.str_size);
+		mem = zend_arena_alloc(&CG(arena), info.mem_size + info.str_size);
 #endif
 
-	if (read(fd, mem, info.mem_size + info.str_size) != (ssize_t)(info.mem_size + info.str_size)) {
-		zend_accel_error(ACCEL_LOG_WARNING, "opcache cannot read from file '%s' (mem)\n", filename);
-		zend_file_cache_flock(fd, LOCK_UN);
-		close(fd);
-		zend_file_cache_unlink(filename);
-		zend_arena_release(&CG(arena), checkpoint);
-		efree(filename);
-		return NULL;
+		if (read(fd, mem, info.mem_size + info.str_size) != (ssize_t)(info.mem_size + info.str_size)) {
+			zend_accel_error(ACCEL_LOG_WARNING, "opcache cannot read from file '%s' (mem)\n", filename);
+			zend_file_cache_flock(fd, LOCK_UN);
+			close(fd);
+			zend_file_cache_unlink(filename);
+			zend_arena_release(&CG(arena), checkpoint);
+			efree(filename);
+			return NULL;
+		}
 	}
 	if (zend_file_cache_flock(fd, LOCK_UN) != 0) {
 		zend_accel_error(ACCEL_LOG_WARNING, "opcache cannot unlock file '%s'\n", filename);
@@ -1603,6 +1631,11 @@ zend_persistent_script *zend_file_cache_script_load(zend_file_handle *file_handl
 	    (actual_checksum = zend_adler32(ADLER32_INIT, mem, info.mem_size + info.str_size)) != info.checksum) {
 		zend_accel_error(ACCEL_LOG_WARNING, "corrupted file '%s' excepted checksum: 0x%08x actual checksum: 0x%08x\n", filename, info.checksum, actual_checksum);
 		zend_file_cache_unlink(filename);
+#ifdef HAVE_SYS_MMAN_H
+		if (map != MAP_FAILED) {
+			munmap(map, map_size);
+		}
+#endif
 		zend_arena_release(&CG(arena), checkpoint);
 		efree(filename);
 		return NULL;
@@ -1654,6 +1687,17 @@ zend_persistent_script *zend_file_cache_script_load(zend_file_handle *file_handl
 		zend_map_ptr_extend(ZCSG(map_ptr_last));
 	} else {
 use_process_mem:
+#ifdef HAVE_SYS_MMAN_H
+		if (map != MAP_FAILED) {
+			/* the script outlives the mapping, unserialize a copy in process memory */
+			buf = zend_arena_alloc(&CG(arena), info.mem_size + info.str_size + 64);
+			buf = (void*)(((zend_uintptr_t)buf + 63L) & ~63L);
+			memcpy(buf, mem, info.mem_size + info.str_size);
+			munmap(map, map_size);
+			map = MAP_FAILED;
+			mem = buf;
+		}
+#endif
 		buf = mem;
 		cache_it = 0;
 	}
@@ -1678,6 +1722,12 @@ use_process_mem:
 			return NULL;
 		}
 	}
+#ifdef HAVE_SYS_MMAN_H
+	if (map != MAP_FAILED) {
+		/* strings were interned into SHM, nothing points into the file any more */
+		munmap(map, map_size);
+	}
+#endif
 
 	script->corrupted = 0;
 
@@ -1707,3 +1757,76 @@ void zend_file_cache_invalidate(zend_string *full_path)
 	zend_file_cache_unlink(filename);
 	efree(filename);
 }
+
+#ifdef HAVE_DIRENT_H
+static void zend_file_cache_warmup_dir(char *path, size_t root_len, size_t len)
+{
+	DIR *dir;
+	struct dirent *entry;
+
+	dir = opendir(path);
+	if (!dir) {
+		return;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		size_t name_len = strlen(entry->d_name);
+		zend_stat_t st;
+
+		if (entry->d_name[0] == '.' || len + 1 + name_len >= MAXPATHLEN) {
+			continue;
+		}
+		path[len] = '/';
+		memcpy(path + len + 1, entry->d_name, name_len + 1);
+		if (zend_stat(path, &st) != 0) {
+			continue;
+		}
+		if (S_ISDIR(st.st_mode)) {
+			zend_file_cache_warmup_dir(path, root_len, len + 1 + name_len);
+		} else if (S_ISREG(st.st_mode)
+		 && name_len > sizeof(SUFFIX) - 1
+		 && memcmp(entry->d_name + name_len - (sizeof(SUFFIX) - 1), SUFFIX, sizeof(SUFFIX) - 1) == 0) {
+			/* the cache file path is <file_cache>/<system_id><script path>.bin */
+			zend_file_handle file_handle;
+			size_t script_len = len + 1 + name_len - (sizeof(SUFFIX) - 1) - root_len;
+
+			zend_stream_init_filename(&file_handle, NULL);
+			file_handle.opened_path = zend_string_init(path + root_len, script_len, 0);
+			file_handle.filename = ZSTR_VAL(file_handle.opened_path);
+			zend_file_cache_script_load(&file_handle);
+			zend_string_release_ex(file_handle.opened_path, 0);
+		}
+	}
+	closedir(dir);
+	path[len] = '\0';
+}
+#endif
+
+/* Loads every script of the file cache into SHM. Called once at startup, so
+ * processes forked afterwards (e.g. FPM children) find the scripts already
+ * unserialized instead of each loading them on first use. */
+void zend_file_cache_warmup(void)
+{
+#ifdef HAVE_DIRENT_H
+	char path[MAXPATHLEN];
+	size_t len = strlen(ZCG(accel_directives).file_cache);
+	zend_arena *orig_arena = CG(arena);
+
+	if (file_cache_only || len + 33 >= MAXPATHLEN) {
+		return;
+	}
+	memcpy(path, ZCG(accel_directives).file_cache, len);
+	path[len] = '/';
+	memcpy(path + len + 1, accel_system_id, 32);
+	len += 33;
+	path[len] = '\0';
+
+	CG(arena) = zend_arena_create(64 * 1024);
+	ZCG(request_time) = time(NULL);
+	zend_file_cache_warmup_dir(path, len, len);
+	if (ZCG(counted)) {
+		accelerator_shm_read_unlock();
+	}
+	zend_arena_destroy(CG(arena));
+	CG(arena) = orig_arena;
+#endif
+}
@@ -889,6 +889,26 @@ PHPAPI pcre_cache_entry* pcre_get_compiled_regex_cache(zend_string *regex)
 }
 /* }}} */
 
+/* {{{ pcre_pin_compiled_regex_cache
+ */
+PHPAPI pcre_cache_entry* pcre_pin_compiled_regex_cache(zend_string *regex)
+{
+	pcre_cache_entry *pce;
+
+	/* A per-request cache is dropped at RSHUTDOWN, there is nothing to pin */
+	if (PCRE_G(per_request_cache)) {
+		return NULL;
+	}
+
+	pce = pcre_get_compiled_regex_cache(regex);
+	if (pce) {
+		/* The reference is never released, so pcre_clean_cache() skips the entry */
+		pce->refcount++;
+	}
+	return pce;
+}
+/* }}} */
+
 /* {{{ pcre_get_compiled_regex
  */
 PHPAPI pcre2_code *pcre_get_compiled_regex(zend_string *regex, uint32_t *capture_count)
@@ -0,0 +1,491 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 7                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) The PHP Group                                          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+ */
+
+#include "php.h"
+#include "php_session.h"
+#include "mod_shm.h"
+
+#ifdef HAVE_PS_SHM
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+
+#ifndef MAP_ANON
+# define MAP_ANON MAP_ANONYMOUS
+#endif
+
+/**************************************************************************
+ * Shared memory save handler.
+ *
+ * The store is a fixed array of session.shm_slots slots, each
+ * session.shm_slot_size bytes large, in an anonymous shared mapping created
+ * at MINIT. Forked workers (FPM children, prefork Apache) inherit it, so all
+ * of them see the same sessions without touching the file system.
+ *
+ * A session lives in one of PS_SHM_PROBE slots following its home slot
+ * (hash of the session ID). Every slot carries a sequence counter that is
+ * odd while a writer owns it: readers copy the data without taking any lock
+ * and retry when the counter moved. Writers lock single slots only, and
+ * inserts of new IDs are serialized per home slot. Unlike mod_files, a
+ * session is not locked for the whole request, concurrent requests of one
+ * session never wait for each other; the last write wins.
+ *
+ * Locks are owned by a pid, a lock whose owner died is taken over (and a
+ * slot written by a dead process dropped as it may be torn).
+ **************************************************************************/
+
+#define PS_SHM_KEY_MAX	256		/* session IDs are shorter than this */
+#define PS_SHM_PROBE	16		/* slots searched starting at the home slot */
+#define PS_SHM_SPIN		1024	/* yields before checking whether a lock owner died */
+#define PS_SHM_ALIGN	64
+
+typedef struct {
+	volatile uint32_t seq;		/* odd while a writer owns the slot */
+	volatile pid_t writer;		/* owner of an odd seq, 0 right after acquiring */
+	volatile pid_t bucket;		/* inserts of keys with this home slot */
+	uint32_t hv;
+	uint32_t keylen;			/* 0 for an unused slot */
+	time_t mtime;
+	size_t datalen;
+	char key[PS_SHM_KEY_MAX];
+	char data[1];
+} ps_shm_slot;
+
+typedef struct {
+	char *base;
+	size_t size;
+	uint32_t slots;
+	size_t slot_size;
+	size_t data_max;
+} ps_shm;
+
+static ps_shm *ps_shm_instance = NULL;
+
+#define PS_SHM_DATA ps_shm *data = PS_GET_MOD_DATA()
+#define PS_SHM_SLOT(data, i) ((ps_shm_slot *) ((data)->base + (size_t)(i) * (data)->slot_size))
+
+const ps_module ps_mod_shm = {
+	PS_MOD_UPDATE_TIMESTAMP(shm)
+};
+
+static inline uint32_t ps_shm_hash(const zend_string *key)
+{
+	return (uint32_t) zend_inline_hash_func(ZSTR_VAL(key), ZSTR_LEN(key));
+}
+
+static inline int ps_shm_owner_gone(pid_t pid)
+{
+	return pid && kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+static void ps_shm_slot_unlock(ps_shm_slot *slot)
+{
+	slot->writer = 0;
+	__sync_synchronize();
+	__sync_fetch_and_add(&slot->seq, 1);
+}
+
+static void ps_shm_slot_recover(ps_shm_slot *slot)
+{
+	pid_t writer = slot->writer;
+
+	if (ps_shm_owner_gone(writer)
+	 && __sync_bool_compare_and_swap(&slot->writer, writer, getpid())) {
+		/* The writer died in the middle of an update */
+		slot->keylen = 0;
+		ps_shm_slot_unlock(slot);
+	}
+}
+
+static void ps_shm_slot_lock(ps_shm_slot *slot)
+{
+	uint32_t spins = 0;
+
+	while (1) {
+		uint32_t seq = slot->seq;
+
+		if (!(seq & 1) && __sync_bool_compare_and_swap(&slot->seq, seq, seq + 1)) {
+			slot->writer = getpid();
+			return;
+		}
+		if (++spins % PS_SHM_SPIN == 0) {
+			ps_shm_slot_recover(slot);
+		}
+		sched_yield();
+	}
+}
+
+static void ps_shm_bucket_lock(ps_shm_slot *home)
+{
+	pid_t self = getpid();
+	uint32_t spins = 0;
+
+	while (!__sync_bool_compare_and_swap(&home->bucket, 0, self)) {
+		if (++spins % PS_SHM_SPIN == 0) {
+			pid_t owner = home->bucket;
+
+			if (ps_shm_owner_gone(owner)
+			 && __sync_bool_compare_and_swap(&home->bucket, owner, self)) {
+				return;
+			}
+		}
+		sched_yield();
+	}
+}
+
+static void ps_shm_bucket_unlock(ps_shm_slot *home)
+{
+	__sync_synchronize();
+	home->bucket = 0;
+}
+
+/* Only valid while the slot is locked */
+static inline int ps_shm_slot_holds(const ps_shm_slot *slot, uint32_t hv, const zend_string *key)
+{
+	return slot->keylen == ZSTR_LEN(key)
+		&& slot->hv == hv
+		&& !memcmp(slot->key, ZSTR_VAL(key), ZSTR_LEN(key));
+}
+
+/* Lock-free check whether the slot holds key (modified at or after limit),
+   copies its data to *val when val is not NULL */
+static int ps_shm_slot_fetch(ps_shm *data, ps_shm_slot *slot, uint32_t hv, const zend_string *key, time_t limit, zend_string **val)
+{
+	uint32_t spins = 0;
+
+	while (1) {
+		uint32_t seq = slot->seq;
+		zend_string *copy = NULL;
+		int match;
+
+		if (seq & 1) {
+			if (++spins % PS_SHM_SPIN == 0) {
+				ps_shm_slot_recover(slot);
+			}
+			sched_yield();
+			continue;
+		}
+		__sync_synchronize();
+
+		match = ps_shm_slot_holds(slot, hv, key) && slot->mtime >= limit;
+		if (match && val) {
+			copy = zend_string_init(slot->data, MIN(slot->datalen, data->data_max), 0);
+		}
+
+		__sync_synchronize();
+		if (slot->seq == seq) {
+			if (val && match) {
+				*val = copy;
+			}
+			return match;
+		}
+		if (copy) {
+			zend_string_release_ex(copy, 0);
+		}
+	}
+}
+
+static ps_shm_slot *ps_shm_find(ps_shm *data, uint32_t hv, const zend_string *key, time_t limit, zend_string **val)
+{
+	uint32_t i;
+
+	for (i = 0; i < PS_SHM_PROBE; i++) {
+		ps_shm_slot *slot = PS_SHM_SLOT(data, (hv + i) % data->slots);
+
+		if (ps_shm_slot_fetch(data, slot, hv, key, limit, val)) {
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+static int ps_shm_key_exists(ps_shm *data, const zend_string *key)
+{
+	if (!key || ZSTR_LEN(key) >= PS_SHM_KEY_MAX) {
+		return FAILURE;
+	}
+	if (ps_shm_find(data, ps_shm_hash(key), key, time(NULL) - PS(gc_maxlifetime), NULL)) {
+		return SUCCESS;
+	}
+	return FAILURE;
+}
+
+PHP_MINIT_FUNCTION(ps_shm)
+{
+	zend_long slots = PS(shm_slots);
+	size_t slot_size;
+	void *base;
+
+	if (slots <= 0) {
+		return SUCCESS;
+	}
+	if (slots < PS_SHM_PROBE) {
+		slots = PS_SHM_PROBE;
+	}
+	slot_size = MAX((size_t) PS(shm_slot_size), XtOffsetOf(ps_shm_slot, data) + 1024);
+	slot_size = ZEND_MM_ALIGNED_SIZE_EX(slot_size, PS_SHM_ALIGN);
+	if ((zend_ulong) slots > (zend_ulong) (SIZE_MAX / slot_size) || slots > UINT32_MAX) {
+		php_error_docref(NULL, E_WARNING, "session.shm_slots * session.shm_slot_size is too large");
+		return FAILURE;
+	}
+
+	base = mmap(NULL, (size_t) slots * slot_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+	if (base == MAP_FAILED) {
+		php_error_docref(NULL, E_WARNING, "Cannot map " ZEND_ULONG_FMT " bytes of shared memory for sessions: %s (%d)",
+			(zend_ulong) slots * slot_size, strerror(errno), errno);
+		return FAILURE;
+	}
+
+	ps_shm_instance = calloc(1, sizeof(*ps_shm_instance));
+	if (!ps_shm_instance) {
+		munmap(base, (size_t) slots * slot_size);
+		return FAILURE;
+	}
+	ps_shm_instance->base = base;
+	ps_shm_instance->size = (size_t) slots * slot_size;
+	ps_shm_instance->slots = (uint32_t) slots;
+	ps_shm_instance->slot_size = slot_size;
+	ps_shm_instance->data_max = slot_size - XtOffsetOf(ps_shm_slot, data);
+
+	php_session_register_module(&ps_mod_shm);
+	return SUCCESS;
+}
+
+PHP_MSHUTDOWN_FUNCTION(ps_shm)
+{
+	if (ps_shm_instance) {
+		munmap(ps_shm_instance->base, ps_shm_instance->size);
+		free(ps_shm_instance);
+		ps_shm_instance = NULL;
+	}
+	return SUCCESS;
+}
+
+PS_OPEN_FUNC(shm)
+{
+	if (!ps_shm_instance) {
+		return FAILURE;
+	}
+	PS_SET_MOD_DATA(ps_shm_instance);
+
+	return SUCCESS;
+}
+
+PS_CLOSE_FUNC(shm)
+{
+	PS_SET_MOD_DATA(NULL);
+
+	return SUCCESS;
+}
+
+PS_READ_FUNC(shm)
+{
+	PS_SHM_DATA;
+
+	if (ZSTR_LEN(key) >= PS_SHM_KEY_MAX
+	 || !ps_shm_find(data, ps_shm_hash(key), key, time(NULL) - maxlifetime, val)) {
+		*val = ZSTR_EMPTY_ALLOC();
+	}
+
+	return SUCCESS;
+}
+
+PS_WRITE_FUNC(shm)
+{
+	PS_SHM_DATA;
+	ps_shm_slot *home, *slot;
+	uint32_t hv, i;
+	time_t now, limit;
+
+	if (ZSTR_LEN(key) >= PS_SHM_KEY_MAX) {
+		php_error_docref(NULL, E_WARNING, "Session ID is too long for the shared memory storage");
+		return FAILURE;
+	}
+	if (ZSTR_LEN(val) > data->data_max) {
+		php_error_docref(NULL, E_WARNING, "Session data of %zu bytes does not fit into session.shm_slot_size", ZSTR_LEN(val));
+		return FAILURE;
+	}
+
+	hv = ps_shm_hash(key);
+	home = PS_SHM_SLOT(data, hv % data->slots);
+	time(&now);
+	limit = now - maxlifetime;
+
+	/* No other process can insert this key meanwhile, but gc and inserts of
+	   other keys may still take the slot away */
+	ps_shm_bucket_lock(home);
+	while (1) {
+		slot = ps_shm_find(data, hv, key, 0, NULL);
+		if (slot) {
+			ps_shm_slot_lock(slot);
+			if (ps_shm_slot_holds(slot, hv, key)) {
+				break;
+			}
+			ps_shm_slot_unlock(slot);
+			continue;
+		}
+
+		for (i = 0; i < PS_SHM_PROBE; i++) {
+			slot = PS_SHM_SLOT(data, (hv + i) % data->slots);
+			if (slot->keylen && slot->mtime >= limit) {
+				continue;
+			}
+			ps_shm_slot_lock(slot);
+			if (!slot->keylen || slot->mtime < limit) {
+				break;
+			}
+			ps_shm_slot_unlock(slot);
+		}
+		if (i == PS_SHM_PROBE) {
+			ps_shm_bucket_unlock(home);
+			php_error_docref(NULL, E_WARNING, "Shared memory session storage is full, increase session.shm_slots");
+			return FAILURE;
+		}
+		slot->hv = hv;
+		slot->keylen = ZSTR_LEN(key);
+		memcpy(slot->key, ZSTR_VAL(key), ZSTR_LEN(key));
+		break;
+	}
+
+	memcpy(slot->data, ZSTR_VAL(val), ZSTR_LEN(val));
+	slot->datalen = ZSTR_LEN(val);
+	slot->mtime = now;
+	ps_shm_slot_unlock(slot);
+	ps_shm_bucket_unlock(home);
+
+	return SUCCESS;
+}
+
+PS_DESTROY_FUNC(shm)
+{
+	PS_SHM_DATA;
+	ps_shm_slot *home, *slot;
+	uint32_t hv;
+
+	if (ZSTR_LEN(key) >= PS_SHM_KEY_MAX) {
+		return SUCCESS;
+	}
+
+	hv = ps_shm_hash(key);
+	home = PS_SHM_SLOT(data, hv % data->slots);
+
+	ps_shm_bucket_lock(home);
+	slot = ps_shm_find(data, hv, key, 0, NULL);
+	if (slot) {
+		ps_shm_slot_lock(slot);
+		if (ps_shm_slot_holds(slot, hv, key)) {
+			slot->keylen = 0;
+		}
+		ps_shm_slot_unlock(slot);
+	}
+	ps_shm_bucket_unlock(home);
+
+	return SUCCESS;
+}
+
+PS_GC_FUNC(shm)
+{
+	PS_SHM_DATA;
+	time_t limit = time(NULL) - maxlifetime;
+	uint32_t i;
+
+	*nrdels = 0;
+
+	for (i = 0; i < data->slots; i++) {
+		ps_shm_slot *slot = PS_SHM_SLOT(data, i);
+
+		if (!slot->keylen || slot->mtime >= limit) {
+			continue;
+		}
+		ps_shm_slot_lock(slot);
+		if (slot->keylen && slot->mtime < limit) {
+			slot->keylen = 0;
+			(*nrdels)++;
+		}
+		ps_shm_slot_unlock(slot);
+	}
+
+	return *nrdels;
+}
+
+PS_CREATE_SID_FUNC(shm)
+{
+	zend_string *sid;
+	int maxfail = 3;
+	PS_SHM_DATA;
+
+	do {
+		sid = php_session_create_id((void **)&data);
+		if (!sid) {
+			if (--maxfail < 0) {
+				return NULL;
+			} else {
+				continue;
+			}
+		}
+		/* Check collision */
+		if (data && ps_shm_key_exists(data, sid) == SUCCESS) {
+			zend_string_release_ex(sid, 0);
+			sid = NULL;
+			if (--maxfail < 0) {
+				return NULL;
+			}
+		}
+	} while(!sid);
+
+	return sid;
+}
+
+PS_VALIDATE_SID_FUNC(shm)
+{
+	PS_SHM_DATA;
+
+	return ps_shm_key_exists(data, key);
+}
+
+/* Called instead of write when the data did not change (session.lazy_write),
+   only the timestamp is refreshed and nothing is copied */
+PS_UPDATE_TIMESTAMP_FUNC(shm)
+{
+	PS_SHM_DATA;
+	ps_shm_slot *slot;
+	uint32_t hv;
+
+	if (ZSTR_LEN(key) >= PS_SHM_KEY_MAX) {
+		return FAILURE;
+	}
+
+	hv = ps_shm_hash(key);
+	slot = ps_shm_find(data, hv, key, 0, NULL);
+	if (slot) {
+		ps_shm_slot_lock(slot);
+		if (ps_shm_slot_holds(slot, hv, key)) {
+			slot->mtime = time(NULL);
+			ps_shm_slot_unlock(slot);
+			return SUCCESS;
+		}
+		ps_shm_slot_unlock(slot);
+	}
+
+	/* Reclaimed by gc in the meantime */
+	return ps_write_shm(mod_data, key, val, maxlifetime);
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 7                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) The PHP Group                                          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+ */
+
+#ifndef MOD_SHM_H
+#define MOD_SHM_H
+
+/* The store is an anonymous shared mapping created at MINIT and inherited
+   by forked workers, slots are guarded with GCC atomic builtins. */
+#if !defined(PHP_WIN32) && defined(__GNUC__)
+# define HAVE_PS_SHM 1
+#endif
+
+#ifdef HAVE_PS_SHM
+
+#include "php_session.h"
+
+PHP_MINIT_FUNCTION(ps_shm);
+PHP_MSHUTDOWN_FUNCTION(ps_shm);
+
+extern const ps_module ps_mod_shm;
+#define ps_shm_ptr &ps_mod_shm
+
+PS_FUNCS_UPDATE_TIMESTAMP(shm);
+
+#endif
+#endif
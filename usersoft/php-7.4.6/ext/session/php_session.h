@@ -203,6 +203,8 @@ typedef struct _php_ps_globals {
 	zend_bool in_save_handler; /* state if session is in save handler or not */
 	zend_bool set_handler;     /* state if session module i setting handler or not */
 	zend_string *session_vars; /* serialized original session data */
+	zend_long shm_slots;       /* session.shm_slots */
+	zend_long shm_slot_size;   /* session.shm_slot_size */
 } php_ps_globals;
 
 typedef php_ps_globals zend_ps_globals;
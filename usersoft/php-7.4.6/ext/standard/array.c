@@ -1556,6 +1556,21 @@ static inline void php_search_array(INTERNAL_FUNCTION_PARAMETERS, int behavior)
 		Z_PARAM_BOOL(strict)
 	ZEND_PARSE_PARAMETERS_END();
 
+	if (strict && (HT_FLAGS(Z_ARRVAL_P(array)) & HASH_FLAG_PACKED)
+	 && (Z_TYPE_P(value) == IS_LONG || Z_TYPE_P(value) == IS_STRING)) {
+		uint32_t idx = Z_TYPE_P(value) == IS_LONG
+			? zend_hash_packed_search_long(Z_ARRVAL_P(array), Z_LVAL_P(value))
+			: zend_hash_packed_search_str(Z_ARRVAL_P(array), Z_STR_P(value));
+
+		if (idx == HT_INVALID_IDX) {
+			RETURN_FALSE;
+		} else if (behavior == 0) {
+			RETURN_TRUE;
+		} else {
+			RETURN_LONG(idx);
+		}
+	}
+
 	if (strict) {
 		if (Z_TYPE_P(value) == IS_LONG) {
 			ZEND_HASH_FOREACH_KEY_VAL_IND(Z_ARRVAL_P(array), num_idx, str_idx, entry) {
@@ -3656,17 +3671,7 @@ PHPAPI int php_array_merge(HashTable *dest, HashTable *src) /* {{{ */
 	zend_string *string_key;
 
 	if ((HT_FLAGS(dest) & HASH_FLAG_PACKED) && (HT_FLAGS(src) & HASH_FLAG_PACKED)) {
-		zend_hash_extend(dest, zend_hash_num_elements(dest) + zend_hash_num_elements(src), 1);
-		ZEND_HASH_FILL_PACKED(dest) {
-			ZEND_HASH_FOREACH_VAL(src, src_entry) {
-				if (UNEXPECTED(Z_ISREF_P(src_entry)) &&
-					UNEXPECTED(Z_REFCOUNT_P(src_entry) == 1)) {
-					src_entry = Z_REFVAL_P(src_entry);
-				}
-				Z_TRY_ADDREF_P(src_entry);
-				ZEND_HASH_FILL_ADD(src_entry);
-			} ZEND_HASH_FOREACH_END();
-		} ZEND_HASH_FILL_END();
+		zend_hash_packed_append(dest, src);
 	} else {
 		ZEND_HASH_FOREACH_STR_KEY_VAL(src, string_key, src_entry) {
 			if (UNEXPECTED(Z_ISREF_P(src_entry) &&
@@ -3794,6 +3799,19 @@ static zend_always_inline void php_array_replace_wrapper(INTERNAL_FUNCTION_PARAM
 }
 /* }}} */
 
+static zend_always_inline zend_bool php_array_string_keys_only(HashTable *ht) /* {{{ */
+{
+	zend_string *string_key;
+
+	ZEND_HASH_FOREACH_STR_KEY(ht, string_key) {
+		if (!string_key) {
+			return 0;
+		}
+	} ZEND_HASH_FOREACH_END();
+	return 1;
+}
+/* }}} */
+
 static zend_always_inline void php_array_merge_wrapper(INTERNAL_FUNCTION_PARAMETERS, int recursive) /* {{{ */
 {
 	zval *args = NULL;
@@ -3835,20 +3853,9 @@ static zend_always_inline void php_array_merge_wrapper(INTERNAL_FUNCTION_PARAMET
 					ZVAL_COPY(return_value, ret);
 					return;
 				}
-			} else {
-				zend_bool copy = 1;
-				zend_string *string_key;
-
-				ZEND_HASH_FOREACH_STR_KEY(Z_ARRVAL_P(ret), string_key) {
-					if (!string_key) {
-						copy = 0;
-						break;
-					}
-				} ZEND_HASH_FOREACH_END();
-				if (copy) {
-					ZVAL_COPY(return_value, ret);
-					return;
-				}
+			} else if (php_array_string_keys_only(Z_ARRVAL_P(ret))) {
+				ZVAL_COPY(return_value, ret);
+				return;
 			}
 		}
 	}
@@ -3856,22 +3863,24 @@ static zend_always_inline void php_array_merge_wrapper(INTERNAL_FUNCTION_PARAMET
 	arg = args;
 	src  = Z_ARRVAL_P(arg);
 	/* copy first array */
-	array_init_size(return_value, count);
-	dest = Z_ARRVAL_P(return_value);
-	if (HT_FLAGS(src) & HASH_FLAG_PACKED) {
+	if (!(HT_FLAGS(src) & HASH_FLAG_PACKED) && php_array_string_keys_only(src)) {
+		/* Nothing gets renumbered, so the table is duplicated as a whole:
+		 * a single memcpy() for immutable (opcache'd) arrays, nested arrays
+		 * stay shared until they are written to */
+		ZVAL_ARR(return_value, zend_array_dup(src));
+		dest = Z_ARRVAL_P(return_value);
+		/* integer keys of later arrays are numbered from 0 */
+		dest->nNextFreeElement = 0;
+		zend_hash_extend(dest, count, 0);
+	} else if (HT_FLAGS(src) & HASH_FLAG_PACKED) {
+		array_init_size(return_value, count);
+		dest = Z_ARRVAL_P(return_value);
 		zend_hash_real_init_packed(dest);
-		ZEND_HASH_FILL_PACKED(dest) {
-			ZEND_HASH_FOREACH_VAL(src, src_entry) {
-				if (UNEXPECTED(Z_ISREF_P(src_entry) &&
-					Z_REFCOUNT_P(src_entry) == 1)) {
-					src_entry = Z_REFVAL_P(src_entry);
-				}
-				Z_TRY_ADDREF_P(src_entry);
-				ZEND_HASH_FILL_ADD(src_entry);
-			} ZEND_HASH_FOREACH_END();
-		} ZEND_HASH_FILL_END();
+		zend_hash_packed_append(dest, src);
 	} else {
 		zend_string *string_key;
+		array_init_size(return_value, count);
+		dest = Z_ARRVAL_P(return_value);
 		zend_hash_real_init_mixed(dest);
 		ZEND_HASH_FOREACH_STR_KEY_VAL(src, string_key, src_entry) {
 			if (UNEXPECTED(Z_ISREF_P(src_entry) &&
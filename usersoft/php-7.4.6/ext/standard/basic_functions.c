@@ -2688,6 +2688,9 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO_EX(arginfo_memory_get_peak_usage, 0, 0, 0)
 	ZEND_ARG_INFO(0, real_usage)
 ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO(arginfo_memory_get_alloc_samples, 0)
+ZEND_END_ARG_INFO()
 /* }}} */
 /* {{{ versioning.c */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_version_compare, 0, 0, 2)
@@ -3030,6 +3033,7 @@ static const zend_function_entry basic_functions[] = { /* {{{ */
 	PHP_FE(print_r,															arginfo_print_r)
 	PHP_FE(memory_get_usage,												arginfo_memory_get_usage)
 	PHP_FE(memory_get_peak_usage,											arginfo_memory_get_peak_usage)
+	PHP_FE(memory_get_alloc_samples,										arginfo_memory_get_alloc_samples)
 
 	PHP_FE(register_shutdown_function,										arginfo_register_shutdown_function)
 	PHP_FE(register_tick_function,											arginfo_register_tick_function)
@@ -1332,6 +1332,49 @@ PHP_FUNCTION(memory_get_peak_usage) {
 }
 /* }}} */
 
+/* {{{ proto array memory_get_alloc_samples(void)
+   Returns the allocations sampled in this request (see USE_ZEND_ALLOC_SAMPLE) */
+PHP_FUNCTION(memory_get_alloc_samples) {
+	static const char *kinds[] = {"small", "large", "huge"};
+	const zend_mm_sample *samples;
+	uint32_t count, i, j;
+
+	ZEND_PARSE_PARAMETERS_NONE();
+
+	samples = zend_mm_get_samples(zend_mm_get_heap(), &count);
+	array_init_size(return_value, count);
+	for (i = 0; i < count; i++) {
+		const zend_mm_sample *sample = &samples[i];
+		zval entry, trace;
+
+		array_init(&entry);
+		add_assoc_long(&entry, "size", sample->size);
+		add_assoc_string(&entry, "kind", (char *) kinds[sample->kind]);
+
+		array_init_size(&trace, sample->frames_count);
+		for (j = 0; j < sample->frames_count; j++) {
+			const zend_mm_sample_frame *frame = &sample->frames[j];
+			zval tmp;
+
+			array_init(&tmp);
+			if (frame->function_name) {
+				add_assoc_str(&tmp, "function", zend_string_copy(frame->function_name));
+			}
+			if (frame->class_name) {
+				add_assoc_str(&tmp, "class", zend_string_copy(frame->class_name));
+			}
+			if (frame->filename) {
+				add_assoc_str(&tmp, "file", zend_string_copy(frame->filename));
+				add_assoc_long(&tmp, "line", frame->lineno);
+			}
+			add_next_index_zval(&trace, &tmp);
+		}
+		add_assoc_zval(&entry, "trace", &trace);
+		add_next_index_zval(return_value, &entry);
+	}
+}
+/* }}} */
+
 PHP_INI_BEGIN()
 	STD_PHP_INI_ENTRY("unserialize_max_depth", "4096", PHP_INI_ALL, OnUpdateLong, unserialize_max_depth, php_basic_globals, basic_globals)
 PHP_INI_END()
@@ -67,6 +67,7 @@ static int is_impersonate = 0;
 # include <unistd.h>
 # include <fcntl.h>
 # include <sys/socket.h>
+# include <sys/uio.h>
 # include <sys/un.h>
 # include <netinet/in.h>
 # include <netinet/tcp.h>
@@ -219,6 +220,8 @@ struct _fcgi_request {
 	int            ended;
 	int            in_len;
 	int            in_pad;
+	int            in_hdr_ready;
+	fcgi_header    in_hdr;
 
 	fcgi_header   *out_hdr;
 
@@ -887,6 +890,7 @@ fcgi_request *fcgi_init_request(int listen_socket, void(*on_accept)(), void(*on_
 	/*
 	req->in_len = 0;
 	req->in_pad = 0;
+	req->in_hdr_ready = 0;
 
 	req->out_hdr = NULL;
 
@@ -993,6 +997,62 @@ static inline ssize_t safe_read(fcgi_request *req, const void *buf, size_t count
 	return n;
 }
 
+#ifndef _WIN32
+static inline ssize_t safe_writev(fcgi_request *req, struct iovec *iov, int iovcnt)
+{
+	ssize_t ret;
+	size_t  n = 0;
+
+	while (iovcnt > 0) {
+		errno = 0;
+		ret = writev(req->fd, iov, iovcnt);
+		if (ret > 0) {
+			n += ret;
+			while (iovcnt > 0 && (size_t)ret >= iov->iov_len) {
+				ret -= iov->iov_len;
+				iov++;
+				iovcnt--;
+			}
+			if (iovcnt > 0) {
+				iov->iov_base = (char*)iov->iov_base + ret;
+				iov->iov_len -= ret;
+			}
+		} else if (ret <= 0 && errno != 0 && errno != EINTR) {
+			return ret;
+		}
+	}
+	return n;
+}
+
+static inline ssize_t safe_readv(fcgi_request *req, struct iovec *iov, int iovcnt)
+{
+	ssize_t ret;
+	size_t  n = 0;
+
+	while (iovcnt > 0) {
+		errno = 0;
+		ret = readv(req->fd, iov, iovcnt);
+		if (ret > 0) {
+			n += ret;
+			while (iovcnt > 0 && (size_t)ret >= iov->iov_len) {
+				ret -= iov->iov_len;
+				iov++;
+				iovcnt--;
+			}
+			if (iovcnt > 0) {
+				iov->iov_base = (char*)iov->iov_base + ret;
+				iov->iov_len -= ret;
+			}
+		} else if (ret == 0 && errno == 0) {
+			return n;
+		} else if (ret <= 0 && errno != 0 && errno != EINTR) {
+			return ret;
+		}
+	}
+	return n;
+}
+#endif
+
 static inline int fcgi_make_header(fcgi_header *hdr, fcgi_request_type type, int req_id, int len)
 {
 	int pad = ((len + 7) & ~7) - len;
@@ -1052,6 +1112,7 @@ static int fcgi_read_request(fcgi_request *req)
 	req->keep = 0;
 	req->ended = 0;
 	req->in_len = 0;
+	req->in_hdr_ready = 0;
 	req->out_hdr = NULL;
 	req->out_pos = req->out_buf;
 
@@ -1223,8 +1284,15 @@ int fcgi_read(fcgi_request *req, char *str, int len)
 	rest = len;
 	while (rest > 0) {
 		if (req->in_len == 0) {
-			if (safe_read(req, &hdr, sizeof(fcgi_header)) != sizeof(fcgi_header) ||
-			    hdr.version < FCGI_VERSION_1 ||
+			if (req->in_hdr_ready) {
+				/* already read along with the previous record */
+				hdr = req->in_hdr;
+				req->in_hdr_ready = 0;
+			} else if (safe_read(req, &hdr, sizeof(fcgi_header)) != sizeof(fcgi_header)) {
+				req->keep = 0;
+				return 0;
+			}
+			if (hdr.version < FCGI_VERSION_1 ||
 			    hdr.type != FCGI_STDIN) {
 				req->keep = 0;
 				return 0;
@@ -1236,6 +1304,41 @@ int fcgi_read(fcgi_request *req, char *str, int len)
 			}
 		}
 
+#ifndef _WIN32
+		if (req->in_len <= rest) {
+			/* The end of the record fits into the caller buffer: read it, its
+			 * padding and the header of the next record (there is always one,
+			 * at least the empty one closing the stream) with one readv(). */
+			struct iovec iov[3];
+			int want = req->in_len + req->in_pad + (int)sizeof(fcgi_header);
+
+			iov[0].iov_base = str;
+			iov[0].iov_len = req->in_len;
+			iov[1].iov_base = buf;
+			iov[1].iov_len = req->in_pad;
+			iov[2].iov_base = &req->in_hdr;
+			iov[2].iov_len = sizeof(fcgi_header);
+
+			ret = (int)safe_readv(req, iov, 3);
+			if (ret < 0) {
+				req->keep = 0;
+				return ret;
+			} else if (ret != want) {
+				/* short stream, hand over the payload we got */
+				req->keep = 0;
+				ret = MIN(ret, req->in_len);
+				req->in_len -= ret;
+				return n + ret;
+			}
+			rest -= req->in_len;
+			n += req->in_len;
+			str += req->in_len;
+			req->in_len = 0;
+			req->in_hdr_ready = 1;
+			continue;
+		}
+#endif
+
 		if (req->in_len >= rest) {
 			ret = (int)safe_read(req, str, rest);
 		} else {
@@ -1538,9 +1641,65 @@ int fcgi_flush(fcgi_request *req, int end)
 	return 1;
 }
 
+#ifndef _WIN32
+/* records sent per writev(), each one is a header and a payload iovec */
+#define FCGI_WRITEV_RECORDS 32
+
+/* Send a large payload without copying it into out_buf: the pending output,
+ * the record headers and the payload slices go out with writev(). The
+ * unaligned tail (less than 8 bytes) is kept in out_buf, so no record needs
+ * padding. */
+static int fcgi_writev_records(fcgi_request *req, fcgi_request_type type, const char *str, int len)
+{
+	fcgi_header  hdr[FCGI_WRITEV_RECORDS];
+	struct iovec iov[FCGI_WRITEV_RECORDS * 2 + 1];
+	int          rest = len & 7;
+	int          pos = 0;
+
+	close_packet(req);
+	len -= rest;
+	while (pos < len) {
+		int    cnt = 0;
+		int    i;
+		size_t total = 0;
+
+		if (req->out_pos != req->out_buf) {
+			iov[cnt].iov_base = req->out_buf;
+			iov[cnt].iov_len = req->out_pos - req->out_buf;
+			total += iov[cnt++].iov_len;
+		}
+		for (i = 0; i < FCGI_WRITEV_RECORDS && pos < len; i++) {
+			int chunk = MIN(len - pos, 0xfff8);
+
+			fcgi_make_header(&hdr[i], type, req->id, chunk);
+			iov[cnt].iov_base = &hdr[i];
+			iov[cnt].iov_len = sizeof(fcgi_header);
+			total += iov[cnt++].iov_len;
+			iov[cnt].iov_base = (char*)str + pos;
+			iov[cnt].iov_len = chunk;
+			total += iov[cnt++].iov_len;
+			pos += chunk;
+		}
+
+		req->out_pos = req->out_buf;
+		if (safe_writev(req, iov, cnt) != (ssize_t)total) {
+			req->keep = 0;
+			return 0;
+		}
+	}
+
+	if (rest) {
+		open_packet(req, type);
+		memcpy(req->out_pos, str + len, rest);
+		req->out_pos += rest;
+	}
+	return 1;
+}
+#endif
+
 int fcgi_write(fcgi_request *req, fcgi_request_type type, const char *str, int len)
 {
-	int limit, rest;
+	int limit;
 
 	if (len <= 0) {
 		return 0;
@@ -1551,7 +1710,7 @@ int fcgi_write(fcgi_request *req, fcgi_request_type type, const char *str, int l
 	}
 #if 0
 	/* Unoptimized, but clear version */
-	rest = len;
+	int rest = len;
 	while (rest > 0) {
 		limit = sizeof(req->out_buf) - (req->out_pos - req->out_buf);
 
@@ -1609,8 +1768,14 @@ int fcgi_write(fcgi_request *req, fcgi_request_type type, const char *str, int l
 			req->out_pos += len - limit;
 		}
 	} else {
+#ifndef _WIN32
+		if (!fcgi_writev_records(req, type, str, len)) {
+			return -1;
+		}
+#else
 		int pos = 0;
 		int pad;
+		int rest;
 
 		close_packet(req);
 		while ((len - pos) > 0xffff) {
@@ -1645,6 +1810,7 @@ int fcgi_write(fcgi_request *req, fcgi_request_type type, const char *str, int l
 			memcpy(req->out_pos, str + len - rest,  rest);
 			req->out_pos += rest;
 		}
+#endif
 	}
 #endif
 	return len;
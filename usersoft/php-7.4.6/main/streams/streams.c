@@ -1463,6 +1463,7 @@ PHPAPI zend_string *_php_stream_copy_to_mem(php_stream *src, size_t maxlen, int
 	size_t len = 0, max_len;
 	int step = CHUNK_SIZE;
 	int min_room = CHUNK_SIZE / 4;
+	int unbuffered = 0;
 	php_stream_statbuf ssbuf;
 	zend_string *result;
 
@@ -1474,6 +1475,16 @@ PHPAPI zend_string *_php_stream_copy_to_mem(php_stream *src, size_t maxlen, int
 		maxlen = 0;
 	}
 
+	/* Plain files without read filters are read straight into the result
+	 * instead of being copied through the read buffer chunk_size bytes at a
+	 * time; anything already buffered is drained first by php_stream_read() */
+	if (!src->readfilters.head
+	 && !(src->flags & PHP_STREAM_FLAG_NO_BUFFER)
+	 && php_stream_is(src, PHP_STREAM_IS_STDIO)) {
+		src->flags |= PHP_STREAM_FLAG_NO_BUFFER;
+		unbuffered = 1;
+	}
+
 	if (maxlen > 0) {
 		result = zend_string_alloc(maxlen, persistent);
 		ptr = ZSTR_VAL(result);
@@ -1486,6 +1497,9 @@ PHPAPI zend_string *_php_stream_copy_to_mem(php_stream *src, size_t maxlen, int
 			len += ret;
 			ptr += ret;
 		}
+		if (unbuffered) {
+			src->flags &= ~PHP_STREAM_FLAG_NO_BUFFER;
+		}
 		if (len) {
 			ZSTR_LEN(result) = len;
 			ZSTR_VAL(result)[len] = '\0';
@@ -1506,9 +1520,10 @@ PHPAPI zend_string *_php_stream_copy_to_mem(php_stream *src, size_t maxlen, int
 	 * result may be inaccurate, as the filter may inflate or deflate the
 	 * number of bytes that we can read.  In order to avoid an upsize followed
 	 * by a downsize of the buffer, overestimate by the step size (which is
-	 * 2K).  */
+	 * 2K).  An unfiltered plain file is read in one go, min_room spare bytes
+	 * are enough to see EOF without growing the buffer. */
 	if (php_stream_stat(src, &ssbuf) == 0 && ssbuf.sb.st_size > 0) {
-		max_len = ssbuf.sb.st_size + step;
+		max_len = ssbuf.sb.st_size + (unbuffered ? min_room + 1 : step);
 	} else {
 		max_len = step;
 	}
@@ -1527,6 +1542,9 @@ PHPAPI zend_string *_php_stream_copy_to_mem(php_stream *src, size_t maxlen, int
 			ptr += ret;
 		}
 	}
+	if (unbuffered) {
+		src->flags &= ~PHP_STREAM_FLAG_NO_BUFFER;
+	}
 	if (len) {
 		result = zend_string_truncate(result, len, persistent);
 		ZSTR_VAL(result)[len] = '\0';
@@ -51,6 +51,71 @@ PHPAPI int php_stream_xport_unregister(const char *protocol)
 		if (local_err) { zend_string_release_ex(local_err, 0); local_err = NULL; } \
 	}
 
+/* {{{ persistent connection pool
+ * With the "socket" context option "persistent_pool_size" > 1 a persistent
+ * ID stands for up to that many connections instead of one: slot 0 uses the
+ * ID itself, slot N the ID with "#N" appended. A slot is busy while its
+ * stream is in use by the current request; idle slots are checked for
+ * liveness (a zero timeout poll and a MSG_PEEK recv for sockets) before
+ * they are handed out, dead ones are closed and their slot reused. */
+static int php_stream_xport_pool_busy(php_stream *stream)
+{
+	zend_resource *regentry;
+
+	ZEND_HASH_FOREACH_PTR(&EG(regular_list), regentry) {
+		if (regentry->ptr == stream) {
+			return 1;
+		}
+	} ZEND_HASH_FOREACH_END();
+	return 0;
+}
+
+static php_stream *php_stream_xport_pool_acquire(const char *persistent_id, zend_long pool_size, char **free_id)
+{
+	zend_long slot;
+
+	*free_id = NULL;
+	for (slot = 0; slot < pool_size; slot++) {
+		php_stream *stream = NULL;
+		zend_resource *le;
+		char *id;
+
+		if (slot == 0) {
+			id = estrdup(persistent_id);
+		} else {
+			spprintf(&id, 0, "%s#" ZEND_LONG_FMT, persistent_id, slot);
+		}
+
+		le = zend_hash_str_find_ptr(&EG(persistent_list), id, strlen(id));
+		if (le && (le->type != php_file_le_pstream() || php_stream_xport_pool_busy((php_stream *) le->ptr))) {
+			efree(id);
+			continue;
+		}
+
+		if (le && php_stream_from_persistent_id(id, &stream) == PHP_STREAM_PERSISTENT_SUCCESS) {
+			if (PHP_STREAM_OPTION_RETURN_OK == php_stream_set_option(stream, PHP_STREAM_OPTION_CHECK_LIVENESS, 0, NULL)) {
+				if (*free_id) {
+					efree(*free_id);
+					*free_id = NULL;
+				}
+				efree(id);
+				return stream;
+			}
+			/* dead - kill it, the slot is free now */
+			php_stream_pclose(stream);
+		}
+
+		if (*free_id) {
+			efree(id);
+		} else {
+			*free_id = id;
+		}
+	}
+
+	return NULL;
+}
+/* }}} */
+
 PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, int options,
 		int flags, const char *persistent_id,
 		struct timeval *timeout,
@@ -66,6 +131,7 @@ PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, in
 	int failed = 0;
 	zend_string *error_text = NULL;
 	struct timeval default_timeout = { 0, 0 };
+	char *pool_id = NULL;
 
 	default_timeout.tv_sec = FG(default_socket_timeout);
 
@@ -75,7 +141,22 @@ PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, in
 
 	/* check for a cached persistent socket */
 	if (persistent_id) {
-		switch(php_stream_from_persistent_id(persistent_id, &stream)) {
+		zval *zpool;
+		zend_long pool_size = 1;
+
+		if (context && (zpool = php_stream_context_get_option(context, "socket", "persistent_pool_size")) != NULL) {
+			pool_size = zval_get_long(zpool);
+		}
+
+		if (pool_size > 1 && (flags & STREAM_XPORT_SERVER) == 0) {
+			stream = php_stream_xport_pool_acquire(persistent_id, pool_size, &pool_id);
+			if (stream) {
+				return stream;
+			}
+			/* a free slot of the pool, or NULL when all of them are busy in
+			 * this request: the caller gets a private connection then */
+			persistent_id = pool_id;
+		} else switch(php_stream_from_persistent_id(persistent_id, &stream)) {
 			case PHP_STREAM_PERSISTENT_SUCCESS:
 				/* use a 0 second timeout when checking if the socket
 				 * has already died */
@@ -119,6 +200,9 @@ PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, in
 			ERR_REPORT(error_string, "Unable to find the socket transport \"%s\" - did you forget to enable it when you configured PHP?",
 					wrapper_name);
 
+			if (pool_id) {
+				efree(pool_id);
+			}
 			return NULL;
 		}
 	}
@@ -126,6 +210,9 @@ PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, in
 	if (factory == NULL) {
 		/* should never happen */
 		php_error_docref(NULL, E_WARNING, "Could not find a factory !?");
+		if (pool_id) {
+			efree(pool_id);
+		}
 		return NULL;
 	}
 
@@ -183,6 +270,10 @@ PHPAPI php_stream *_php_stream_xport_create(const char *name, size_t namelen, in
 		stream = NULL;
 	}
 
+	if (pool_id) {
+		efree(pool_id);
+	}
+
 	return stream;
 }
 
@@ -145,15 +145,20 @@ static struct fpm_child_s *fpm_child_find(pid_t pid) /* {{{ */
 }
 /* }}} */
 
-static void fpm_child_init(struct fpm_worker_pool_s *wp) /* {{{ */
+static void fpm_child_init(struct fpm_worker_pool_s *wp, int shard) /* {{{ */
 {
 	fpm_globals.max_requests = wp->config->pm_max_requests;
-	fpm_globals.listening_socket = dup(wp->listening_socket);
+	if (wp->listening_sockets_count > 1) {
+		fpm_globals.listening_socket = dup(wp->listening_sockets[shard]);
+	} else {
+		fpm_globals.listening_socket = dup(wp->listening_socket);
+	}
 
 	if (0 > fpm_stdio_init_child(wp)  ||
 	    0 > fpm_log_init_child(wp)    ||
 	    0 > fpm_status_init_child(wp) ||
 	    0 > fpm_unix_init_child(wp)   ||
+	    0 > fpm_unix_set_shard_affinity(wp, shard) ||
 	    0 > fpm_signals_init_child()  ||
 	    0 > fpm_env_init_child(wp)    ||
 	    0 > fpm_php_init_child(wp)) {
@@ -358,6 +363,41 @@ static void fpm_child_resources_use(struct fpm_child_s *child) /* {{{ */
 }
 /* }}} */
 
+void fpm_children_count_shards(struct fpm_worker_pool_s *wp, int *shard_children) /* {{{ */
+{
+	struct fpm_child_s *child;
+
+	memset(shard_children, 0, sizeof(int) * MAX(wp->listening_sockets_count, 1));
+
+	for (child = wp->children; child; child = child->next) {
+		/* children being stopped do not accept anymore */
+		if (!child->idle_kill) {
+			shard_children[child->shard]++;
+		}
+	}
+}
+/* }}} */
+
+static int fpm_child_pick_shard(struct fpm_worker_pool_s *wp) /* {{{ */
+{
+	int shard_children[FPM_MAX_LISTEN_SHARDS];
+	int i, shard = 0;
+
+	if (wp->listening_sockets_count <= 1) {
+		return 0;
+	}
+
+	/* the new child goes to the shard with the fewest children */
+	fpm_children_count_shards(wp, shard_children);
+	for (i = 1; i < wp->listening_sockets_count; i++) {
+		if (shard_children[i] < shard_children[shard]) {
+			shard = i;
+		}
+	}
+	return shard;
+}
+/* }}} */
+
 static void fpm_parent_resources_use(struct fpm_child_s *child) /* {{{ */
 {
 	fpm_stdio_parent_use_pipes(child);
@@ -370,9 +410,10 @@ int fpm_children_make(struct fpm_worker_pool_s *wp, int in_event_loop, int nb_to
 	pid_t pid;
 	struct fpm_child_s *child;
 	int max;
+	int shard;
 	static int warned = 0;
 
-	if (wp->config->pm == PM_STYLE_DYNAMIC) {
+	if (wp->config->pm == PM_STYLE_DYNAMIC || wp->config->pm == PM_STYLE_ADAPTIVE) {
 		if (!in_event_loop) { /* starting */
 			max = wp->config->pm_start_servers;
 		} else {
@@ -403,6 +444,7 @@ int fpm_children_make(struct fpm_worker_pool_s *wp, int in_event_loop, int nb_to
 		if (!child) {
 			return 2;
 		}
+		shard = child->shard = fpm_child_pick_shard(wp);
 
 		zlog(ZLOG_DEBUG, "blocking signals before child birth");
 		if (0 > fpm_signals_child_block()) {
@@ -416,7 +458,7 @@ int fpm_children_make(struct fpm_worker_pool_s *wp, int in_event_loop, int nb_to
 			case 0 :
 				fpm_child_resources_use(child);
 				fpm_globals.is_child = 1;
-				fpm_child_init(wp);
+				fpm_child_init(wp, shard);
 				return 0;
 
 			case -1 :
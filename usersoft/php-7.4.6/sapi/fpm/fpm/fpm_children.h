@@ -15,6 +15,7 @@ int fpm_children_free(struct fpm_child_s *child);
 void fpm_children_bury();
 int fpm_children_init_main();
 int fpm_children_make(struct fpm_worker_pool_s *wp, int in_event_loop, int nb_to_spawn, int is_debug);
+void fpm_children_count_shards(struct fpm_worker_pool_s *wp, int *shard_children);
 
 struct fpm_child_s;
 
@@ -30,6 +31,7 @@ struct fpm_child_s {
 	int idle_kill;
 	pid_t pid;
 	int scoreboard_i;
+	int shard;
 	struct zlog_stream *log_stream;
 };
 
@@ -129,6 +129,8 @@ static struct ini_value_parser_s ini_fpm_pool_options[] = {
 	{ "listen.group",              &fpm_conf_set_string,      WPO(listen_group) },
 	{ "listen.mode",               &fpm_conf_set_string,      WPO(listen_mode) },
 	{ "listen.allowed_clients",    &fpm_conf_set_string,      WPO(listen_allowed_clients) },
+	{ "listen.reuseport",          &fpm_conf_set_integer,     WPO(listen_reuseport) },
+	{ "listen.reuseport_affinity", &fpm_conf_set_boolean,     WPO(listen_reuseport_affinity) },
 	{ "process.priority",          &fpm_conf_set_integer,     WPO(process_priority) },
 	{ "process.dumpable",          &fpm_conf_set_boolean,     WPO(process_dumpable) },
 	{ "pm",                        &fpm_conf_set_pm,          WPO(pm) },
@@ -138,6 +140,8 @@ static struct ini_value_parser_s ini_fpm_pool_options[] = {
 	{ "pm.max_spare_servers",      &fpm_conf_set_integer,     WPO(pm_max_spare_servers) },
 	{ "pm.process_idle_timeout",   &fpm_conf_set_time,        WPO(pm_process_idle_timeout) },
 	{ "pm.max_requests",           &fpm_conf_set_integer,     WPO(pm_max_requests) },
+	{ "pm.target_utilization",     &fpm_conf_set_integer,     WPO(pm_target_utilization) },
+	{ "pm.warmup_script",          &fpm_conf_set_string,      WPO(pm_warmup_script) },
 	{ "pm.status_path",            &fpm_conf_set_string,      WPO(pm_status_path) },
 	{ "ping.path",                 &fpm_conf_set_string,      WPO(ping_path) },
 	{ "ping.response",             &fpm_conf_set_string,      WPO(ping_response) },
@@ -537,8 +541,10 @@ static char *fpm_conf_set_pm(zval *value, void **config, intptr_t offset) /* {{{
 		c->pm = PM_STYLE_DYNAMIC;
 	} else if (!strcasecmp(val, "ondemand")) {
 		c->pm = PM_STYLE_ONDEMAND;
+	} else if (!strcasecmp(val, "adaptive")) {
+		c->pm = PM_STYLE_ADAPTIVE;
 	} else {
-		return "invalid process manager (static, dynamic or ondemand)";
+		return "invalid process manager (static, dynamic, ondemand or adaptive)";
 	}
 	return NULL;
 }
@@ -614,6 +620,7 @@ static void *fpm_worker_pool_config_alloc() /* {{{ */
 	memset(wp->config, 0, sizeof(struct fpm_worker_pool_config_s));
 	wp->config->listen_backlog = FPM_BACKLOG_DEFAULT;
 	wp->config->pm_process_idle_timeout = 10; /* 10s by default */
+	wp->config->pm_target_utilization = 70; /* 70% by default */
 	wp->config->process_priority = 64; /* 64 means unset */
 	wp->config->process_dumpable = 0;
 	wp->config->clear_env = 1;
@@ -650,6 +657,7 @@ int fpm_worker_pool_config_free(struct fpm_worker_pool_config_s *wpc) /* {{{ */
 	free(wpc->listen_group);
 	free(wpc->listen_mode);
 	free(wpc->listen_allowed_clients);
+	free(wpc->pm_warmup_script);
 	free(wpc->pm_status_path);
 	free(wpc->ping_path);
 	free(wpc->ping_response);
@@ -791,8 +799,8 @@ static int fpm_conf_process_all_pools() /* {{{ */
 		}
 
 		/* pm */
-		if (wp->config->pm != PM_STYLE_STATIC && wp->config->pm != PM_STYLE_DYNAMIC && wp->config->pm != PM_STYLE_ONDEMAND) {
-			zlog(ZLOG_ALERT, "[pool %s] the process manager is missing (static, dynamic or ondemand)", wp->config->name);
+		if (wp->config->pm != PM_STYLE_STATIC && wp->config->pm != PM_STYLE_DYNAMIC && wp->config->pm != PM_STYLE_ONDEMAND && wp->config->pm != PM_STYLE_ADAPTIVE) {
+			zlog(ZLOG_ALERT, "[pool %s] the process manager is missing (static, dynamic, ondemand or adaptive)", wp->config->name);
 			return -1;
 		}
 
@@ -857,6 +865,77 @@ static int fpm_conf_process_all_pools() /* {{{ */
 			config->pm_start_servers = 0;
 			config->pm_min_spare_servers = 0;
 			config->pm_max_spare_servers = 0;
+		} else if (wp->config->pm == PM_STYLE_ADAPTIVE) {
+			struct fpm_worker_pool_config_s *config = wp->config;
+
+			if (config->pm_target_utilization < 1 || config->pm_target_utilization > 100) {
+				zlog(ZLOG_ALERT, "[pool %s] pm.target_utilization(%d) must be included into [1,100]", wp->config->name, config->pm_target_utilization);
+				return -1;
+			}
+
+			if (config->pm_min_spare_servers < 0 || config->pm_min_spare_servers > config->pm_max_children) {
+				zlog(ZLOG_ALERT, "[pool %s] pm.min_spare_servers(%d) must be a positive value not greater than pm.max_children(%d)", wp->config->name, config->pm_min_spare_servers, config->pm_max_children);
+				return -1;
+			}
+
+			if (config->pm_process_idle_timeout < 1) {
+				zlog(ZLOG_ALERT, "[pool %s] pm.process_idle_timeout(%ds) must be greater than 0s", wp->config->name, config->pm_process_idle_timeout);
+				return -1;
+			}
+
+			if (config->pm_start_servers <= 0) {
+				config->pm_start_servers = MAX(config->pm_min_spare_servers, 1);
+				zlog(ZLOG_NOTICE, "[pool %s] pm.start_servers is not set. It's been set to %d.", wp->config->name, config->pm_start_servers);
+			} else if (config->pm_start_servers > config->pm_max_children) {
+				zlog(ZLOG_ALERT, "[pool %s] pm.start_servers(%d) must not be greater than pm.max_children(%d)", wp->config->name, config->pm_start_servers, config->pm_max_children);
+				return -1;
+			}
+
+			/* the adaptive pm never uses an upper spare bound, the target utilization drives scale down */
+			config->pm_max_spare_servers = 0;
+		}
+
+		/* listen.reuseport */
+		if (wp->config->listen_reuseport) {
+#ifdef SO_REUSEPORT
+			struct fpm_worker_pool_config_s *config = wp->config;
+
+			if (config->listen_reuseport < 0 || config->listen_reuseport > FPM_MAX_LISTEN_SHARDS) {
+				zlog(ZLOG_ALERT, "[pool %s] listen.reuseport(%d) must be included into [0,%d]", config->name, config->listen_reuseport, FPM_MAX_LISTEN_SHARDS);
+				return -1;
+			}
+
+			if (wp->listen_address_domain != FPM_AF_INET) {
+				zlog(ZLOG_ALERT, "[pool %s] listen.reuseport can only be used with a TCP listen address", config->name);
+				return -1;
+			}
+
+			if (config->pm == PM_STYLE_ONDEMAND) {
+				zlog(ZLOG_ALERT, "[pool %s] listen.reuseport cannot be used with the ondemand process manager", config->name);
+				return -1;
+			}
+
+			/* every shard needs at least one child from the start */
+			if ((config->pm == PM_STYLE_STATIC ? config->pm_max_children : config->pm_start_servers) < config->listen_reuseport) {
+				zlog(ZLOG_ALERT, "[pool %s] listen.reuseport(%d) must not be greater than the number of children started (%d)", config->name, config->listen_reuseport, config->pm == PM_STYLE_STATIC ? config->pm_max_children : config->pm_start_servers);
+				return -1;
+			}
+#else
+			zlog(ZLOG_WARNING, "[pool %s] listen.reuseport is not supported on your system", wp->config->name);
+			wp->config->listen_reuseport = 0;
+#endif
+		}
+
+		if (wp->config->listen_reuseport_affinity && wp->config->listen_reuseport < 2) {
+			zlog(ZLOG_WARNING, "[pool %s] listen.reuseport_affinity is only used with listen.reuseport set to 2 or more", wp->config->name);
+		}
+
+		/* pm.warmup_script */
+		if (wp->config->pm_warmup_script && *wp->config->pm_warmup_script) {
+			if (wp->config->pm != PM_STYLE_ADAPTIVE) {
+				zlog(ZLOG_WARNING, "[pool %s] pm.warmup_script is only used by the adaptive process manager", wp->config->name);
+			}
+			fpm_evaluate_full_path(&wp->config->pm_warmup_script, wp, NULL, 0);
 		}
 
 		/* status */
@@ -1653,6 +1732,8 @@ static void fpm_conf_dump() /* {{{ */
 		zlog(ZLOG_NOTICE, "\tlisten.group = %s",               STR2STR(wp->config->listen_group));
 		zlog(ZLOG_NOTICE, "\tlisten.mode = %s",                STR2STR(wp->config->listen_mode));
 		zlog(ZLOG_NOTICE, "\tlisten.allowed_clients = %s",     STR2STR(wp->config->listen_allowed_clients));
+		zlog(ZLOG_NOTICE, "\tlisten.reuseport = %d",           wp->config->listen_reuseport);
+		zlog(ZLOG_NOTICE, "\tlisten.reuseport_affinity = %s",  BOOL2STR(wp->config->listen_reuseport_affinity));
 		if (wp->config->process_priority == 64) {
 			zlog(ZLOG_NOTICE, "\tprocess.priority = undefined");
 		} else {
@@ -1666,6 +1747,8 @@ static void fpm_conf_dump() /* {{{ */
 		zlog(ZLOG_NOTICE, "\tpm.max_spare_servers = %d",       wp->config->pm_max_spare_servers);
 		zlog(ZLOG_NOTICE, "\tpm.process_idle_timeout = %d",    wp->config->pm_process_idle_timeout);
 		zlog(ZLOG_NOTICE, "\tpm.max_requests = %d",            wp->config->pm_max_requests);
+		zlog(ZLOG_NOTICE, "\tpm.target_utilization = %d%%",    wp->config->pm_target_utilization);
+		zlog(ZLOG_NOTICE, "\tpm.warmup_script = %s",           STR2STR(wp->config->pm_warmup_script));
 		zlog(ZLOG_NOTICE, "\tpm.status_path = %s",             STR2STR(wp->config->pm_status_path));
 		zlog(ZLOG_NOTICE, "\tping.path = %s",                  STR2STR(wp->config->ping_path));
 		zlog(ZLOG_NOTICE, "\tping.response = %s",              STR2STR(wp->config->ping_response));
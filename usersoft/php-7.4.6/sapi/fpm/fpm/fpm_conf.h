@@ -6,7 +6,7 @@
 #include <stdint.h>
 #include "php.h"
 
-#define PM2STR(a) (a == PM_STYLE_STATIC ? "static" : (a == PM_STYLE_DYNAMIC ? "dynamic" : "ondemand"))
+#define PM2STR(a) (a == PM_STYLE_STATIC ? "static" : (a == PM_STYLE_DYNAMIC ? "dynamic" : (a == PM_STYLE_ADAPTIVE ? "adaptive" : "ondemand")))
 
 #define FPM_CONF_MAX_PONG_LENGTH 64
 
@@ -63,6 +63,8 @@ struct fpm_worker_pool_config_s {
 	char *listen_group;
 	char *listen_mode;
 	char *listen_allowed_clients;
+	int listen_reuseport;
+	int listen_reuseport_affinity;
 	int process_priority;
 	int process_dumpable;
 	int pm;
@@ -72,6 +74,8 @@ struct fpm_worker_pool_config_s {
 	int pm_max_spare_servers;
 	int pm_process_idle_timeout;
 	int pm_max_requests;
+	int pm_target_utilization;
+	char *pm_warmup_script;
 	char *pm_status_path;
 	char *ping_path;
 	char *ping_response;
@@ -112,7 +116,8 @@ struct ini_value_parser_s {
 enum {
 	PM_STYLE_STATIC = 1,
 	PM_STYLE_DYNAMIC = 2,
-	PM_STYLE_ONDEMAND = 3
+	PM_STYLE_ONDEMAND = 3,
+	PM_STYLE_ADAPTIVE = 4
 };
 
 int fpm_conf_init_main(int test_conf, int force_daemon);
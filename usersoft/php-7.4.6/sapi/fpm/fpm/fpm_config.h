@@ -70,6 +70,12 @@
 # define HAVE_FPM_TRACE 0
 #endif
 
+#if defined(__linux__)
+# define HAVE_FPM_CPU_AFFINITY 1
+#else
+# define HAVE_FPM_CPU_AFFINITY 0
+#endif
+
 #if defined(HAVE_LQ_TCP_INFO) || defined(HAVE_LQ_SO_LISTENQ)
 # define HAVE_FPM_LQ 1
 #else
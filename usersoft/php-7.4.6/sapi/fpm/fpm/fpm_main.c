@@ -1355,6 +1355,50 @@ static fcgi_request *fpm_init_request(int listen_fd) /* {{{ */ {
 }
 /* }}} */
 
+/* {{{ fpm_run_warmup_script
+ *
+ * Execute pm.warmup_script once in a freshly forked child, before its first
+ * accept(), to fill opcache, the realpath cache and the allocator while the
+ * master still counts the child as starting. The request has not been
+ * accepted, so output and fastcgi logging are discarded.
+ */
+static void fpm_run_warmup_script(fcgi_request *request, char *path)
+{
+	zend_file_handle file_handle;
+	zend_bool fcgi_logging = CGIG(fcgi_logging);
+
+	SG(server_context) = (void *) request;
+	SG(request_info).path_translated = estrdup(path);
+	CGIG(fcgi_logging) = 0;
+
+	if (UNEXPECTED(php_request_startup() == FAILURE)) {
+		zlog(ZLOG_WARNING, "Unable to start the warmup request for %s", path);
+		efree(SG(request_info).path_translated);
+		SG(request_info).path_translated = NULL;
+		CGIG(fcgi_logging) = fcgi_logging;
+		SG(server_context) = NULL;
+		return;
+	}
+	SG(headers_sent) = 1;
+	SG(request_info).no_headers = 1;
+	php_output_start_default();
+
+	zend_try {
+		zend_stream_init_filename(&file_handle, path);
+		php_execute_script(&file_handle);
+	} zend_end_try();
+
+	php_output_discard_all();
+	efree(SG(request_info).path_translated);
+	SG(request_info).path_translated = NULL;
+
+	php_request_shutdown((void *) 0);
+
+	CGIG(fcgi_logging) = fcgi_logging;
+	SG(server_context) = NULL;
+}
+/* }}} */
+
 static void fastcgi_ini_parser(zval *arg1, zval *arg2, zval *arg3, int callback_type, void *arg) /* {{{ */
 {
 	int *mode = (int *)arg;
@@ -1867,6 +1911,10 @@ consult the installation file that came with this distribution, or visit \n\
 	request = fpm_init_request(fcgi_fd);
 
 	zend_first_try {
+		if (fpm_php_warmup_script()) {
+			fpm_run_warmup_script(request, fpm_php_warmup_script());
+		}
+
 		while (EXPECTED(fcgi_accept_request(request) >= 0)) {
 			char *primary_script = NULL;
 			request_body_fd = -1;
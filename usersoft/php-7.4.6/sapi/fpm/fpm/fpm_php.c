@@ -20,6 +20,7 @@
 #include "zlog.h"
 
 static char **limit_extensions = NULL;
+static char *warmup_script = NULL;
 
 static int fpm_php_zend_ini_alter_master(char *name, int name_length, char *new_value, int new_value_length, int mode, int stage) /* {{{ */
 {
@@ -230,10 +231,22 @@ int fpm_php_init_child(struct fpm_worker_pool_s *wp) /* {{{ */
 		limit_extensions = wp->limit_extensions;
 		wp->limit_extensions = NULL;
 	}
+
+	if (wp->config->pm == PM_STYLE_ADAPTIVE && wp->config->pm_warmup_script && *wp->config->pm_warmup_script) {
+		warmup_script = wp->config->pm_warmup_script;
+	}
+
+	zend_mm_prefault(zend_mm_get_heap());
 	return 0;
 }
 /* }}} */
 
+char *fpm_php_warmup_script(void) /* {{{ */
+{
+	return warmup_script;
+}
+/* }}} */
+
 int fpm_php_limit_extensions(char *path) /* {{{ */
 {
 	char **p;
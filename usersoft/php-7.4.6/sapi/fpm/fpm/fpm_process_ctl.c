@@ -6,6 +6,7 @@
 #include <signal.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "fpm.h"
 #include "fpm_clock.h"
@@ -320,17 +321,26 @@ static void fpm_pctl_perform_idle_server_maintenance(struct timeval *now) /* {{{
 		int idle = 0;
 		int active = 0;
 		int children_to_fork;
+		int shard_children[FPM_MAX_LISTEN_SHARDS];
 		unsigned cur_lq = 0;
 
 		if (wp->config == NULL) continue;
 
+		/* adaptive pools have their own faster heartbeat */
+		if (wp->config->pm == PM_STYLE_ADAPTIVE) continue;
+
+		fpm_children_count_shards(wp, shard_children);
+
 		for (child = wp->children; child; child = child->next) {
 			if (fpm_request_is_idle(child)) {
-				if (last_idle_child == NULL) {
-					last_idle_child = child;
-				} else {
-					if (timercmp(&child->started, &last_idle_child->started, <)) {
+				/* never stop the last child of a listen.reuseport shard */
+				if (wp->listening_sockets_count <= 1 || shard_children[child->shard] > 1) {
+					if (last_idle_child == NULL) {
 						last_idle_child = child;
+					} else {
+						if (timercmp(&child->started, &last_idle_child->started, <)) {
+							last_idle_child = child;
+						}
 					}
 				}
 				idle++;
@@ -341,7 +351,7 @@ static void fpm_pctl_perform_idle_server_maintenance(struct timeval *now) /* {{{
 
 		/* update status structure for all PMs */
 		if (wp->listen_address_domain == FPM_AF_INET) {
-			if (0 > fpm_socket_get_listening_queue(wp->listening_socket, &cur_lq, NULL)) {
+			if (0 > fpm_sockets_get_pool_listening_queue(wp, &cur_lq)) {
 				cur_lq = 0;
 #if 0
 			} else {
@@ -441,6 +451,163 @@ static void fpm_pctl_perform_idle_server_maintenance(struct timeval *now) /* {{{
 }
 /* }}} */
 
+/*
+ * The adaptive process manager sizes the pool from the demand instead of the
+ * number of idle children. The demand is the largest of:
+ *   - the busy children plus the requests waiting in the listening queue
+ *   - the arrival rate times the mean request duration (Little's law)
+ * and the pool is grown so that this demand only uses pm.target_utilization
+ * percent of the children, plus pm.min_spare_servers. Children which have not
+ * accepted their first request yet (still running pm.warmup_script) count as
+ * capacity, so a burst does not fork twice. Scaling down only happens after
+ * the pool has been oversized for pm.process_idle_timeout.
+ */
+static void fpm_pctl_perform_adaptive_server_maintenance(struct timeval *now) /* {{{ */
+{
+	struct fpm_worker_pool_s *wp;
+
+	for (wp = fpm_worker_all_pools; wp; wp = wp->next) {
+		struct fpm_child_s *child;
+		struct fpm_child_s *last_idle_child = NULL;
+		struct fpm_worker_pool_config_s *config = wp->config;
+		struct timeval elapsed;
+		int idle = 0;
+		int active = 0;
+		int warming = 0;
+		int quitting = 0;
+		int running;
+		int needed;
+		int children_to_fork;
+		int samples = 0;
+		int shard_children[FPM_MAX_LISTEN_SHARDS];
+		double latency = 0;
+		double demand;
+		unsigned cur_lq = 0;
+		unsigned long int requests;
+
+		if (config == NULL || config->pm != PM_STYLE_ADAPTIVE) continue;
+
+		fpm_children_count_shards(wp, shard_children);
+
+		for (child = wp->children; child; child = child->next) {
+			struct fpm_scoreboard_proc_s *proc;
+
+			if (child->idle_kill) {
+				quitting++;
+				continue;
+			}
+
+			/* no need in atomicity here */
+			proc = fpm_scoreboard_proc_get(wp->scoreboard, child->scoreboard_i);
+			if (!proc || !proc->request_stage) {
+				/* not accepting yet: forking or running the warmup script */
+				warming++;
+				continue;
+			}
+
+			if (proc->request_stage == FPM_REQUEST_ACCEPTING) {
+				/* never stop the last child of a listen.reuseport shard */
+				if ((wp->listening_sockets_count <= 1 || shard_children[child->shard] > 1) &&
+						(last_idle_child == NULL || timercmp(&child->started, &last_idle_child->started, <))) {
+					last_idle_child = child;
+				}
+				idle++;
+				if (proc->requests) {
+					latency += proc->duration.tv_sec + proc->duration.tv_usec / 1000000.0;
+					samples++;
+				}
+			} else {
+				/* the running request lasts at least that long */
+				timersub(now, &proc->accepted, &elapsed);
+				latency += elapsed.tv_sec + elapsed.tv_usec / 1000000.0;
+				samples++;
+				active++;
+			}
+		}
+
+		if (wp->listen_address_domain == FPM_AF_INET) {
+			if (0 > fpm_sockets_get_pool_listening_queue(wp, &cur_lq)) {
+				cur_lq = 0;
+			}
+		}
+		fpm_scoreboard_update(idle, active + warming, cur_lq, -1, -1, -1, 0, FPM_SCOREBOARD_ACTION_SET, wp->scoreboard);
+
+		/* update the arrival rate and latency averages */
+		requests = wp->scoreboard->requests;
+		if (timerisset(&wp->adaptive_tick)) {
+			timersub(now, &wp->adaptive_tick, &elapsed);
+			if (elapsed.tv_sec || elapsed.tv_usec) {
+				double rate = (requests - wp->adaptive_requests) / (elapsed.tv_sec + elapsed.tv_usec / 1000000.0);
+
+				wp->adaptive_rate += FPM_ADAPTIVE_SMOOTHING * (rate - wp->adaptive_rate);
+			}
+		}
+		if (samples) {
+			wp->adaptive_latency += FPM_ADAPTIVE_SMOOTHING * (latency / samples - wp->adaptive_latency);
+		}
+		wp->adaptive_tick = *now;
+		wp->adaptive_requests = requests;
+
+		demand = MAX((double) (active + cur_lq), wp->adaptive_rate * wp->adaptive_latency);
+		needed = (int) ceil(demand * 100 / config->pm_target_utilization) + config->pm_min_spare_servers;
+		needed = MAX(needed, config->pm_start_servers);
+		needed = MIN(needed, config->pm_max_children);
+		running = wp->running_children - quitting;
+
+		zlog(ZLOG_DEBUG, "[pool %s] currently %d active children, %d spare children, %d warming children, %u queued requests, %.1f req/s, %.3fs latency: %d children needed", config->name, active, idle, warming, cur_lq, wp->adaptive_rate, wp->adaptive_latency, needed);
+
+		if (running < needed) {
+			timerclear(&wp->adaptive_idle_since);
+
+			if (wp->running_children >= config->pm_max_children) {
+				if (!wp->warn_max_children) {
+					fpm_scoreboard_update(0, 0, 0, 0, 0, 1, 0, FPM_SCOREBOARD_ACTION_INC, wp->scoreboard);
+					zlog(ZLOG_WARNING, "[pool %s] server reached pm.max_children setting (%d), consider raising it", config->name, config->pm_max_children);
+					wp->warn_max_children = 1;
+				}
+				continue;
+			}
+			wp->warn_max_children = 0;
+
+			children_to_fork = MIN(needed - running, FPM_MAX_SPAWN_RATE);
+			children_to_fork = MIN(children_to_fork, config->pm_max_children - wp->running_children);
+
+			fpm_children_make(wp, 1, children_to_fork, 1);
+
+			/* if it's a child, stop here without creating the next event
+			 * this event is reserved to the master process
+			 */
+			if (fpm_globals.is_child) {
+				return;
+			}
+
+			zlog(ZLOG_DEBUG, "[pool %s] %d child(ren) have been created ahead of demand", config->name, children_to_fork);
+			continue;
+		}
+
+		if (running == needed || idle <= config->pm_min_spare_servers || !last_idle_child) {
+			timerclear(&wp->adaptive_idle_since);
+			continue;
+		}
+
+		/* oversized: wait for pm.process_idle_timeout before shrinking */
+		if (!timerisset(&wp->adaptive_idle_since)) {
+			wp->adaptive_idle_since = *now;
+			continue;
+		}
+		if (now->tv_sec - wp->adaptive_idle_since.tv_sec < config->pm_process_idle_timeout) {
+			continue;
+		}
+
+		last_idle_child->idle_kill = 1;
+		fpm_pctl_kill(last_idle_child->pid, FPM_PCTL_QUIT);
+
+		/* then shrink by one child per second while still oversized */
+		wp->adaptive_idle_since.tv_sec = now->tv_sec - config->pm_process_idle_timeout + 1;
+	}
+}
+/* }}} */
+
 void fpm_pctl_heartbeat(struct fpm_event_s *ev, short which, void *arg) /* {{{ */
 {
 	static struct fpm_event_s heartbeat;
@@ -496,6 +663,35 @@ void fpm_pctl_perform_idle_server_maintenance_heartbeat(struct fpm_event_s *ev,
 }
 /* }}} */
 
+void fpm_pctl_perform_adaptive_server_maintenance_heartbeat(struct fpm_event_s *ev, short which, void *arg) /* {{{ */
+{
+	static struct fpm_event_s heartbeat;
+	struct fpm_worker_pool_s *wp;
+	struct timeval now;
+
+	if (fpm_globals.parent_pid != getpid()) {
+		return; /* sanity check */
+	}
+
+	if (which == FPM_EV_TIMEOUT) {
+		fpm_clock_get(&now);
+		if (fpm_pctl_can_spawn_children()) {
+			fpm_pctl_perform_adaptive_server_maintenance(&now);
+		}
+		return;
+	}
+
+	/* first call without setting which to initialize the timer, only if a pool needs it */
+	for (wp = fpm_worker_all_pools; wp; wp = wp->next) {
+		if (wp->config && wp->config->pm == PM_STYLE_ADAPTIVE) {
+			fpm_event_set_timer(&heartbeat, FPM_EV_PERSIST, &fpm_pctl_perform_adaptive_server_maintenance_heartbeat, NULL);
+			fpm_event_add(&heartbeat, FPM_ADAPTIVE_SERVER_MAINTENANCE_HEARTBEAT);
+			return;
+		}
+	}
+}
+/* }}} */
+
 void fpm_pctl_on_socket_accept(struct fpm_event_s *ev, short which, void *arg) /* {{{ */
 {
 	struct fpm_worker_pool_s *wp = (struct fpm_worker_pool_s *)arg;
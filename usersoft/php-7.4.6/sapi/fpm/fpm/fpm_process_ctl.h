@@ -9,6 +9,10 @@
 #define FPM_MAX_SPAWN_RATE (32)
 /* 1s (in ms) heartbeat for idle server maintenance */
 #define FPM_IDLE_SERVER_MAINTENANCE_HEARTBEAT (1000)
+/* 100ms (in ms) heartbeat for adaptive server maintenance */
+#define FPM_ADAPTIVE_SERVER_MAINTENANCE_HEARTBEAT (100)
+/* weight of the last sample in the adaptive rate and latency averages */
+#define FPM_ADAPTIVE_SMOOTHING (0.25)
 /* a minimum of 130ms heartbeat for pctl */
 #define FPM_PCTL_MIN_HEARTBEAT (130)
 
@@ -21,6 +25,7 @@ int fpm_pctl_kill(pid_t pid, int how);
 void fpm_pctl_kill_all(int signo);
 void fpm_pctl_heartbeat(struct fpm_event_s *ev, short which, void *arg);
 void fpm_pctl_perform_idle_server_maintenance_heartbeat(struct fpm_event_s *ev, short which, void *arg);
+void fpm_pctl_perform_adaptive_server_maintenance_heartbeat(struct fpm_event_s *ev, short which, void *arg);
 void fpm_pctl_on_socket_accept(struct fpm_event_s *ev, short which, void *arg);
 int fpm_pctl_child_exited();
 int fpm_pctl_init_main();
@@ -176,7 +176,9 @@ void fpm_request_end(void) /* {{{ */
 	struct tms cpu;
 #endif
 	size_t memory = zend_memory_peak_usage(1);
+	uint32_t alloc_samples;
 
+	zend_mm_get_samples(zend_mm_get_heap(), &alloc_samples);
 	fpm_clock_get(&now);
 #ifdef HAVE_TIMES
 	times(&cpu);
@@ -198,6 +200,7 @@ void fpm_request_end(void) /* {{{ */
 	proc->last_request_cpu.tms_cstime = cpu.tms_cstime - proc->cpu_accepted.tms_cstime;
 #endif
 	proc->memory = memory;
+	proc->alloc_samples = alloc_samples;
 	fpm_scoreboard_proc_release(proc);
 }
 /* }}} */
@@ -42,6 +42,7 @@ struct fpm_scoreboard_proc_s {
 	struct timeval last_request_cpu_duration;
 #endif
 	size_t memory;
+	unsigned int alloc_samples;
 };
 
 struct fpm_scoreboard_s {
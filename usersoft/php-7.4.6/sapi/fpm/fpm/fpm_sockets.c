@@ -37,6 +37,9 @@ struct listening_socket_s {
 
 static struct fpm_array_s sockets_list;
 
+/* listen.reuseport shard being opened, used to tell apart sockets on the same address */
+static int listening_shard = 0;
+
 enum { FPM_GET_USE_SOCKET = 1, FPM_STORE_SOCKET = 2, FPM_STORE_USE_SOCKET = 3 };
 
 static void fpm_sockets_cleanup(int which, void *arg) /* {{{ */
@@ -121,9 +124,12 @@ static int fpm_sockets_hash_op(int sock, struct sockaddr *sa, char *key, int typ
 	if (key == NULL) {
 		switch (type) {
 			case FPM_AF_INET : {
-				key = alloca(INET6_ADDRSTRLEN+10);
+				key = alloca(INET6_ADDRSTRLEN+20);
 				inet_ntop(sa->sa_family, fpm_get_in_addr(sa), key, INET6_ADDRSTRLEN);
 				sprintf(key+strlen(key), ":%d", fpm_get_in_port(sa));
+				if (listening_shard) {
+					sprintf(key+strlen(key), "#%d", listening_shard);
+				}
 				break;
 			}
 
@@ -198,6 +204,14 @@ static int fpm_sockets_new_listening_socket(struct fpm_worker_pool_s *wp, struct
 		zlog(ZLOG_WARNING, "failed to change socket attribute");
 	}
 
+#ifdef SO_REUSEPORT
+	if (wp->config->listen_reuseport > 1 && 0 > setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &flags, sizeof(flags))) {
+		zlog(ZLOG_SYSERROR, "failed to set SO_REUSEPORT on the listening socket for address '%s'", wp->config->listen_address);
+		close(sock);
+		return -1;
+	}
+#endif
+
 	if (wp->listen_address_domain == FPM_AF_UNIX) {
 		if (fpm_socket_unix_test_connect((struct sockaddr_un *)sa, socklen) == 0) {
 			zlog(ZLOG_ERROR, "Another FPM instance seems to already listen on %s", ((struct sockaddr_un *) sa)->sun_path);
@@ -369,6 +383,40 @@ static int fpm_socket_af_unix_listening_socket(struct fpm_worker_pool_s *wp) /*
 }
 /* }}} */
 
+/*
+ * listen.reuseport: open the other sockets bound to the same address, the
+ * kernel spreads the incoming connections between them and each child only
+ * accepts on the one of its shard.
+ */
+static int fpm_socket_af_inet_listening_shards(struct fpm_worker_pool_s *wp) /* {{{ */
+{
+	int i;
+
+	wp->listening_sockets = malloc(sizeof(int) * wp->config->listen_reuseport);
+	if (!wp->listening_sockets) {
+		zlog(ZLOG_SYSERROR, "[pool %s] unable to allocate the listen.reuseport sockets", wp->config->name);
+		return -1;
+	}
+
+	wp->listening_sockets[0] = wp->listening_socket;
+	wp->listening_sockets_count = 1;
+
+	for (i = 1; i < wp->config->listen_reuseport; i++) {
+		listening_shard = i;
+		wp->listening_sockets[i] = fpm_socket_af_inet_listening_socket(wp);
+		listening_shard = 0;
+
+		if (wp->listening_sockets[i] == -1) {
+			return -1;
+		}
+		wp->listening_sockets_count++;
+	}
+
+	zlog(ZLOG_DEBUG, "[pool %s] %d SO_REUSEPORT sockets are listening on '%s'", wp->config->name, wp->listening_sockets_count, wp->config->listen_address);
+	return 0;
+}
+/* }}} */
+
 int fpm_sockets_init_main() /* {{{ */
 {
 	unsigned i, lq_len;
@@ -431,6 +479,11 @@ int fpm_sockets_init_main() /* {{{ */
 		switch (wp->listen_address_domain) {
 			case FPM_AF_INET :
 				wp->listening_socket = fpm_socket_af_inet_listening_socket(wp);
+				if (wp->listening_socket != -1 && wp->config->listen_reuseport > 1) {
+					if (0 > fpm_socket_af_inet_listening_shards(wp)) {
+						return -1;
+					}
+				}
 				break;
 
 			case FPM_AF_UNIX :
@@ -474,6 +527,26 @@ int fpm_sockets_init_main() /* {{{ */
 }
 /* }}} */
 
+int fpm_sockets_get_pool_listening_queue(struct fpm_worker_pool_s *wp, unsigned *cur_lq) /* {{{ */
+{
+	unsigned lq;
+	int i;
+
+	if (wp->listening_sockets_count <= 1) {
+		return fpm_socket_get_listening_queue(wp->listening_socket, cur_lq, NULL);
+	}
+
+	*cur_lq = 0;
+	for (i = 0; i < wp->listening_sockets_count; i++) {
+		if (0 > fpm_socket_get_listening_queue(wp->listening_sockets[i], &lq, NULL)) {
+			return -1;
+		}
+		*cur_lq += lq;
+	}
+	return 0;
+}
+/* }}} */
+
 #if HAVE_FPM_LQ
 
 #ifdef HAVE_LQ_TCP_INFO
@@ -23,9 +23,13 @@
 #define FPM_ENV_SOCKET_SET_MAX 256
 #define FPM_ENV_SOCKET_SET_SIZE 128
 
+/* maximum number of listen.reuseport sockets per pool */
+#define FPM_MAX_LISTEN_SHARDS 64
+
 enum fpm_address_domain fpm_sockets_domain_from_address(char *addr);
 int fpm_sockets_init_main();
 int fpm_socket_get_listening_queue(int sock, unsigned *cur_lq, unsigned *max_lq);
+int fpm_sockets_get_pool_listening_queue(struct fpm_worker_pool_s *wp, unsigned *cur_lq);
 int fpm_socket_unix_test_connect(struct sockaddr_un *sock, size_t socklen);
 
 
@@ -134,6 +134,7 @@ int fpm_status_export_to_zval(zval *status)
 		add_assoc_double(&fpm_proc_stat, "last-request-cpu", procs[i].request_stage == FPM_REQUEST_ACCEPTING ? cpu : 0.);
 #endif
 		add_assoc_long(&fpm_proc_stat, "last-request-memory", procs[i].request_stage == FPM_REQUEST_ACCEPTING ? procs[i].memory : 0);
+		add_assoc_long(&fpm_proc_stat, "last-request-alloc-samples", procs[i].request_stage == FPM_REQUEST_ACCEPTING ? procs[i].alloc_samples : 0);
 		add_next_index_zval(&fpm_proc_stats, &fpm_proc_stat);
 	}
 	add_assoc_zval(status, "procs", &fpm_proc_stats);
@@ -279,6 +280,7 @@ int fpm_status_handle_request(void) /* {{{ */
 						"<th>last request cpu</th>"
 #endif
 						"<th>last request memory</th>"
+						"<th>last request alloc samples</th>"
 					"</tr>\n";
 
 				full_syntax =
@@ -298,6 +300,7 @@ int fpm_status_handle_request(void) /* {{{ */
 						"<td>%.2f</td>"
 #endif
 						"<td>%zu</td>"
+						"<td>%u</td>"
 					"</tr>\n";
 
 				full_post = "</table></body></html>";
@@ -350,6 +353,7 @@ int fpm_status_handle_request(void) /* {{{ */
 							"<last-request-cpu>%.2f</last-request-cpu>"
 #endif
 							"<last-request-memory>%zu</last-request-memory>"
+							"<last-request-alloc-samples>%u</last-request-alloc-samples>"
 						"</process>\n"
 					;
 					full_post = "</processes>\n</status>";
@@ -400,7 +404,8 @@ int fpm_status_handle_request(void) /* {{{ */
 #ifdef HAVE_FPM_LQ
 					"\"last request cpu\":%.2f,"
 #endif
-					"\"last request memory\":%zu"
+					"\"last request memory\":%zu,"
+					"\"last request alloc samples\":%u"
 					"}";
 
 				full_post = "]}";
@@ -447,7 +452,8 @@ int fpm_status_handle_request(void) /* {{{ */
 #ifdef HAVE_FPM_LQ
 						"last request cpu:     %.2f\n"
 #endif
-						"last request memory:  %zu\n";
+						"last request memory:  %zu\n"
+						"last request alloc samples: %u\n";
 				}
 		}
 
@@ -554,7 +560,8 @@ int fpm_status_handle_request(void) /* {{{ */
 #ifdef HAVE_FPM_LQ
 					proc.request_stage == FPM_REQUEST_ACCEPTING ? cpu : 0.,
 #endif
-					proc.request_stage == FPM_REQUEST_ACCEPTING ? proc.memory : 0);
+					proc.request_stage == FPM_REQUEST_ACCEPTING ? proc.memory : 0,
+					proc.request_stage == FPM_REQUEST_ACCEPTING ? proc.alloc_samples : 0);
 				PUTS(buffer);
 				efree(buffer);
 
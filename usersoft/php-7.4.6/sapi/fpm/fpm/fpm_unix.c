@@ -10,6 +10,9 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <grp.h>
+#if HAVE_FPM_CPU_AFFINITY
+#include <sched.h>
+#endif
 
 #ifdef HAVE_PRCTL
 #include <sys/prctl.h>
@@ -332,6 +335,35 @@ static int fpm_unix_conf_wp(struct fpm_worker_pool_s *wp) /* {{{ */
 }
 /* }}} */
 
+int fpm_unix_set_shard_affinity(struct fpm_worker_pool_s *wp, int shard) /* {{{ */
+{
+#if HAVE_FPM_CPU_AFFINITY
+	cpu_set_t cpus;
+	long ncpus, i;
+
+	if (!wp->config->listen_reuseport_affinity || wp->listening_sockets_count <= 1) {
+		return 0;
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpus <= 0) {
+		return 0;
+	}
+
+	/* shard s runs on CPUs s, s + shards, s + 2 * shards, ... */
+	CPU_ZERO(&cpus);
+	for (i = shard % ncpus; i < ncpus && i < CPU_SETSIZE; i += wp->listening_sockets_count) {
+		CPU_SET(i, &cpus);
+	}
+
+	if (0 > sched_setaffinity(0, sizeof(cpus), &cpus)) {
+		zlog(ZLOG_SYSERROR, "[pool %s] failed to bind the child to the CPUs of listen.reuseport shard %d", wp->config->name, shard);
+	}
+#endif
+	return 0;
+}
+/* }}} */
+
 int fpm_unix_init_child(struct fpm_worker_pool_s *wp) /* {{{ */
 {
 	int is_root = !geteuid();
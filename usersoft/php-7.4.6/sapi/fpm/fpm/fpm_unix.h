@@ -10,6 +10,7 @@ int fpm_unix_set_socket_premissions(struct fpm_worker_pool_s *wp, const char *pa
 int fpm_unix_free_socket_premissions(struct fpm_worker_pool_s *wp);
 
 int fpm_unix_init_child(struct fpm_worker_pool_s *wp);
+int fpm_unix_set_shard_affinity(struct fpm_worker_pool_s *wp, int shard);
 int fpm_unix_init_main();
 
 extern size_t fpm_pagesize;
@@ -40,6 +40,9 @@ void fpm_worker_pool_free(struct fpm_worker_pool_s *wp) /* {{{ */
 	if (wp->limit_extensions) {
 		fpm_worker_pool_free_limit_extensions(wp->limit_extensions);
 	}
+	if (wp->listening_sockets) {
+		free(wp->listening_sockets);
+	}
 	fpm_unix_free_socket_premissions(wp);
 	free(wp);
 }
@@ -3,6 +3,8 @@
 #ifndef FPM_WORKER_POOL_H
 #define FPM_WORKER_POOL_H 1
 
+#include <sys/time.h>
+
 #include "fpm_conf.h"
 #include "fpm_shm.h"
 
@@ -22,6 +24,8 @@ struct fpm_worker_pool_s {
 	char *user, *home;									/* for setting env USER and HOME */
 	enum fpm_address_domain listen_address_domain;
 	int listening_socket;
+	int *listening_sockets;								/* listen.reuseport shards, [0] is listening_socket */
+	int listening_sockets_count;
 	int set_uid, set_gid;								/* config uid and gid */
 	int socket_uid, socket_gid, socket_mode;
 
@@ -41,6 +45,13 @@ struct fpm_worker_pool_s {
 	struct fpm_event_s *ondemand_event;
 	int socket_event_set;
 
+	/* for adaptive PM */
+	struct timeval adaptive_tick;						/* last time the pool has been sampled */
+	unsigned long int adaptive_requests;				/* scoreboard requests counter at adaptive_tick */
+	double adaptive_rate;								/* smoothed arrival rate (requests per second) */
+	double adaptive_latency;							/* smoothed request duration (seconds) */
+	struct timeval adaptive_idle_since;					/* since when the pool has more children than needed */
+
 #ifdef HAVE_FPM_ACL
 	void *socket_acl;
 #endif
@@ -758,6 +758,16 @@ typedef enum {
 	AMQP_DELIVERY_PERSISTENT = 2 /**< Persistent message */
 } amqp_delivery_mode_enum;
 
+/**
+ * Socket events a connection waits for, as returned by amqp_get_io_events()
+ *
+ * \since v0.8.0
+ */
+typedef enum {
+  AMQP_IO_WANT_READ = 1,   /**< Data from the broker is expected */
+  AMQP_IO_WANT_WRITE = 2   /**< Output is pending, see amqp_flush_pending() */
+} amqp_io_event_enum;
+
 AMQP_END_DECLS
 
 #include <amqp_framing.h>
@@ -1042,6 +1052,68 @@ int
 AMQP_CALL amqp_get_sockfd(amqp_connection_state_t state);
 
 
+/**
+ * Make frame writes on the connection non-blocking
+ *
+ * For driving a connection from an event loop (epoll, kqueue, a coroutine
+ * scheduler...). Once enabled, every function that sends frames, e.g.
+ * amqp_basic_publish() or amqp_basic_ack(), writes what the socket accepts
+ * right away and keeps the rest in a pending buffer instead of waiting for
+ * the socket to become writable. amqp_get_io_events() reports
+ * AMQP_IO_WANT_WRITE while output is pending, amqp_flush_pending() should be
+ * called whenever the socket is writable.
+ *
+ * Incoming frames are read without blocking by passing a zero timeout to
+ * amqp_simple_wait_frame_noblock() when the socket is readable:
+ * AMQP_STATUS_TIMEOUT means that no complete frame is available yet, a
+ * partially received frame is kept and completed by the next call. Note that
+ * amqp_consume_message() given a zero timeout only returns immediately if no
+ * delivery has started, it waits for the rest of one that has.
+ *
+ * Functions performing a synchronous RPC (amqp_login(), amqp_channel_open(),
+ * amqp_queue_declare()...) still wait for their reply.
+ *
+ * \param [in] state the connection object
+ * \param [in] nonblocking true to enable, false to go back to blocking
+ *              writes (output still pending is written first by the next
+ *              blocking write)
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+void
+AMQP_CALL amqp_set_nonblocking(amqp_connection_state_t state,
+                               amqp_boolean_t nonblocking);
+
+/**
+ * Write as much pending output as the socket accepts without blocking
+ *
+ * \param [in] state the connection object
+ * \return AMQP_STATUS_OK on success (some output may still be pending, see
+ *         amqp_get_io_events()), an amqp_status_enum value on a socket error.
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+int
+AMQP_CALL amqp_flush_pending(amqp_connection_state_t state);
+
+/**
+ * Socket events the connection needs to make progress
+ *
+ * Meant to be combined with amqp_get_sockfd() to register the connection
+ * with an event loop.
+ *
+ * \param [in] state the connection object
+ * \return a combination of amqp_io_event_enum flags, 0 if there is no socket
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+int
+AMQP_CALL amqp_get_io_events(amqp_connection_state_t state);
+
+
 /**
  * Deprecated, use amqp_tcp_socket_new() or amqp_ssl_socket_new()
  *
@@ -1910,6 +1982,167 @@ AMQP_CALL amqp_basic_publish(amqp_connection_state_t state, amqp_channel_t chann
                              struct amqp_basic_properties_t_ const *properties,
                              amqp_bytes_t body);
 
+/**
+ * A message to be published with amqp_basic_publish_batch()
+ *
+ * The fields have the same meaning as the corresponding parameters of
+ * amqp_basic_publish(). properties may be NULL.
+ *
+ * \since v0.8.0
+ */
+typedef struct amqp_publish_message_t_ {
+  amqp_bytes_t exchange;                              /**< exchange */
+  amqp_bytes_t routing_key;                           /**< routing key */
+  amqp_boolean_t mandatory;                           /**< mandatory flag */
+  amqp_boolean_t immediate;                           /**< immediate flag */
+  struct amqp_basic_properties_t_ const *properties;  /**< message properties */
+  amqp_bytes_t body;                                  /**< message body */
+} amqp_publish_message_t;
+
+/**
+ * Publish several messages to the broker
+ *
+ * Encodes the basic.publish method, content header and body frames of every
+ * message back to back into a single buffer owned by the connection and
+ * writes it to the socket in as few send calls as possible (one per 128KB of
+ * encoded frames), instead of one send per frame as amqp_basic_publish()
+ * does. This is useful for producers publishing many small messages.
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier, all messages are published on it
+ * \param [in] messages the messages to publish
+ * \param [in] count the number of entries in messages
+ * \return AMQP_STATUS_OK on success, amqp_status_enum value on failure. The
+ *         possible error values are the same as for amqp_basic_publish(). If
+ *         a message cannot be encoded (e.g., AMQP_STATUS_TABLE_TOO_BIG) the
+ *         messages preceding it are still sent and the rest are not.
+ *
+ * Note: this function does heartbeat processing
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+int
+AMQP_CALL amqp_basic_publish_batch(amqp_connection_state_t state,
+                                   amqp_channel_t channel,
+                                   amqp_publish_message_t const *messages,
+                                   size_t count);
+
+/**
+ * Called by the publisher confirm tracker for each confirmed message
+ *
+ * \param [in] arg the callback_arg given to amqp_confirm_select_tracked()
+ * \param [in] channel the channel the message was published on
+ * \param [in] delivery_tag the delivery tag of the message, the n-th message
+ *              published on the channel since confirm.select has tag n
+ * \param [in] ack true if the broker acked the message, false if it nacked it
+ *
+ * \since v0.8.0
+ */
+typedef void (*amqp_confirm_callback_t)(void *arg, amqp_channel_t channel,
+                                        uint64_t delivery_tag,
+                                        amqp_boolean_t ack);
+
+/**
+ * Put a channel in confirm mode and track publisher confirms on it
+ *
+ * Sends confirm.select and from then on numbers the messages published on
+ * the channel with amqp_basic_publish() and amqp_basic_publish_batch(), the
+ * same way the broker does. basic.ack and basic.nack frames for the channel,
+ * including ones with the multiple flag set, are matched to the outstanding
+ * messages and reported through callback once per message, in whatever
+ * order the broker confirms them.
+ *
+ * Confirms are processed by amqp_confirm_poll() and amqp_confirm_wait(), and
+ * by the publish functions themselves once max_in_flight messages are
+ * unconfirmed: publishing then blocks until the broker confirms the oldest
+ * one. Other frames read meanwhile are queued as usual.
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier
+ * \param [in] max_in_flight the maximum number of unconfirmed messages,
+ *              must not be 0
+ * \param [in] callback the function called for every confirmed message
+ * \param [in] callback_arg passed to callback
+ * \return the reply to confirm.select, see amqp_get_rpc_reply()
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+amqp_rpc_reply_t
+AMQP_CALL amqp_confirm_select_tracked(amqp_connection_state_t state,
+                                      amqp_channel_t channel,
+                                      size_t max_in_flight,
+                                      amqp_confirm_callback_t callback,
+                                      void *callback_arg);
+
+/**
+ * Process the publisher confirms that have already arrived
+ *
+ * Dispatches the basic.ack and basic.nack frames received so far on a
+ * channel tracked with amqp_confirm_select_tracked() without waiting for
+ * more.
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier
+ * \return AMQP_STATUS_OK on success, AMQP_STATUS_INVALID_PARAMETER if the
+ *         channel is not tracked, AMQP_STATUS_UNEXPECTED_STATE if the channel
+ *         or connection is being closed by the broker (the close method is
+ *         left queued for amqp_simple_wait_frame()), or another
+ *         amqp_status_enum value on a connection error.
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+int
+AMQP_CALL amqp_confirm_poll(amqp_connection_state_t state,
+                            amqp_channel_t channel);
+
+/**
+ * Wait until every message published on a tracked channel is confirmed
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier
+ * \param [in] timeout how long to wait, NULL waits forever
+ * \return AMQP_STATUS_OK once nothing is outstanding, AMQP_STATUS_TIMEOUT if
+ *         the timeout expired first, otherwise as amqp_confirm_poll()
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+int
+AMQP_CALL amqp_confirm_wait(amqp_connection_state_t state,
+                            amqp_channel_t channel,
+                            struct timeval *timeout);
+
+/**
+ * Delivery tag of the last message published on a tracked channel
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier
+ * \return the tag, 0 if nothing was published or the channel is not tracked
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+uint64_t
+AMQP_CALL amqp_confirm_last_tag(amqp_connection_state_t state,
+                                amqp_channel_t channel);
+
+/**
+ * Number of unconfirmed messages on a tracked channel
+ *
+ * \param [in] state the connection object
+ * \param [in] channel the channel identifier
+ * \return the number of messages awaiting a confirm
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+size_t
+AMQP_CALL amqp_confirm_in_flight(amqp_connection_state_t state,
+                                 amqp_channel_t channel);
+
 /**
  * Closes an channel
  *
@@ -2260,6 +2493,85 @@ AMQP_PUBLIC_FUNCTION
 void
 AMQP_CALL amqp_destroy_envelope(amqp_envelope_t *envelope);
 
+/**
+ * Wait for and consume a message without copying it out of the connection
+ *
+ * Behaves like amqp_consume_message(), except that nothing is duplicated:
+ * the consumer tag, exchange, routing key and properties of the returned
+ * envelope point into the memory pool of the channel the message was
+ * delivered on, which also holds the received frames. A body that arrived in
+ * a single body frame points at that frame's payload, a body spread over
+ * several frames is assembled in the same pool.
+ *
+ * The envelope stays valid until the buffers of its channel are released,
+ * either with amqp_release_envelope() or with amqp_maybe_release_buffers()
+ * and friends. It must not be passed to amqp_destroy_envelope().
+ *
+ * \param [in,out] state the connection object
+ * \param [in,out] envelope a pointer to a amqp_envelope_t object. Caller
+ *                 should call #amqp_release_envelope() when it is done using
+ *                 the fields in the envelope object.
+ * \param [in] timeout a timeout to wait for a message delivery. Passing in
+ *             NULL will result in blocking behavior.
+ * \param [in] flags pass in 0. Currently unused.
+ * \returns a amqp_rpc_reply_t object, see amqp_consume_message()
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+amqp_rpc_reply_t
+AMQP_CALL amqp_consume_message_pooled(amqp_connection_state_t state,
+                                      amqp_envelope_t *envelope,
+                                      struct timeval *timeout, int flags);
+
+/**
+ * Consume every delivery that is already available, without copying them
+ *
+ * Waits for a first delivery like amqp_consume_message_pooled(), then keeps
+ * decoding deliveries out of the frames already received, stopping at max
+ * deliveries or when the next frame has not arrived yet. With a high
+ * prefetch count this returns many messages per recv() and poll() call.
+ *
+ * All returned envelopes follow the rules of amqp_consume_message_pooled(),
+ * each must be released with amqp_release_envelope() (or all at once with
+ * amqp_maybe_release_buffers()).
+ *
+ * \param [in,out] state the connection object
+ * \param [out] envelopes an array of at least max envelopes to fill in
+ * \param [in] max the number of entries in envelopes, must not be 0
+ * \param [out] count the number of envelopes filled in
+ * \param [in] timeout a timeout to wait for the first delivery. Passing in
+ *             NULL will result in blocking behavior.
+ * \param [in] flags pass in 0. Currently unused.
+ * \returns a amqp_rpc_reply_t object, see amqp_consume_message(). If an error
+ *          occurs after the first delivery it is returned too, and the *count
+ *          envelopes read before it are still valid.
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+amqp_rpc_reply_t
+AMQP_CALL amqp_consume_messages_pooled(amqp_connection_state_t state,
+                                       amqp_envelope_t *envelopes, size_t max,
+                                       size_t *count, struct timeval *timeout,
+                                       int flags);
+
+/**
+ * Releases an envelope returned by amqp_consume_message_pooled()
+ *
+ * Recycles the memory pool of the envelope's channel if no other frames are
+ * queued on it, and clears the envelope.
+ *
+ * \param [in] state the connection object
+ * \param [in] envelope
+ *
+ * \since v0.8.0
+ */
+AMQP_PUBLIC_FUNCTION
+void
+AMQP_CALL amqp_release_envelope(amqp_connection_state_t state,
+                                amqp_envelope_t *envelope);
+
 
 /**
  * Parameters used to connect to the RabbitMQ broker
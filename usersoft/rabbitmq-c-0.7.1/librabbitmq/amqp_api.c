@@ -175,6 +175,26 @@ const amqp_array_t amqp_empty_array = { 0, NULL };
    ? (replytype *) state->most_recent_api_result.reply.decoded\
    : NULL)
 
+static int amqp_publish_check_heartbeat(amqp_connection_state_t state)
+{
+  int res;
+
+  /* TODO(alanxz): this heartbeat check is happening in the wrong place, it
+   * should really be done in amqp_try_send/writev */
+  res = amqp_time_has_past(state->next_recv_heartbeat);
+  if (AMQP_STATUS_TIMER_FAILURE == res) {
+    return res;
+  } else if (AMQP_STATUS_TIMEOUT == res) {
+    res = amqp_try_recv(state);
+    if (AMQP_STATUS_TIMEOUT == res) {
+      return AMQP_STATUS_HEARTBEAT_TIMEOUT;
+    } else if (AMQP_STATUS_OK != res) {
+      return res;
+    }
+  }
+  return AMQP_STATUS_OK;
+}
+
 int amqp_basic_publish(amqp_connection_state_t state,
                        amqp_channel_t channel,
                        amqp_bytes_t exchange,
@@ -191,6 +211,7 @@ int amqp_basic_publish(amqp_connection_state_t state,
 
   amqp_basic_publish_t m;
   amqp_basic_properties_t default_properties;
+  amqp_confirm_tracker_t *tracker;
 
   m.exchange = exchange;
   m.routing_key = routing_key;
@@ -198,16 +219,15 @@ int amqp_basic_publish(amqp_connection_state_t state,
   m.immediate = immediate;
   m.ticket = 0;
 
-  /* TODO(alanxz): this heartbeat check is happening in the wrong place, it
-   * should really be done in amqp_try_send/writev */
-  res = amqp_time_has_past(state->next_recv_heartbeat);
-  if (AMQP_STATUS_TIMER_FAILURE == res) {
+  res = amqp_publish_check_heartbeat(state);
+  if (AMQP_STATUS_OK != res) {
     return res;
-  } else if (AMQP_STATUS_TIMEOUT == res) {
-    res = amqp_try_recv(state);
-    if (AMQP_STATUS_TIMEOUT == res) {
-      return AMQP_STATUS_HEARTBEAT_TIMEOUT;
-    } else if (AMQP_STATUS_OK != res) {
+  }
+
+  tracker = amqp_get_confirm_tracker(state, channel);
+  if (NULL != tracker) {
+    res = amqp_confirm_reserve(state, tracker);
+    if (AMQP_STATUS_OK != res) {
       return res;
     }
   }
@@ -261,9 +281,402 @@ int amqp_basic_publish(amqp_connection_state_t state,
     }
   }
 
+  if (NULL != tracker) {
+    tracker->next_tag++;
+  }
+
+  return AMQP_STATUS_OK;
+}
+
+/* Frames are written once this much has been queued by
+ * amqp_basic_publish_batch() */
+#define AMQP_PUBLISH_BATCH_FLUSH_SIZE 131072
+
+static int amqp_batch_publish_message(amqp_connection_state_t state,
+                                      amqp_channel_t channel,
+                                      amqp_publish_message_t const *message)
+{
+  amqp_frame_t f;
+  size_t body_offset;
+  size_t usable_body_payload_size = state->frame_max - (HEADER_SIZE + FOOTER_SIZE);
+  int res;
+
+  amqp_basic_publish_t m;
+  amqp_basic_properties_t default_properties;
+
+  m.exchange = message->exchange;
+  m.routing_key = message->routing_key;
+  m.mandatory = message->mandatory;
+  m.immediate = message->immediate;
+  m.ticket = 0;
+
+  f.frame_type = AMQP_FRAME_METHOD;
+  f.channel = channel;
+  f.payload.method.id = AMQP_BASIC_PUBLISH_METHOD;
+  f.payload.method.decoded = &m;
+
+  res = amqp_batch_frame(state, &f);
+  if (res < 0) {
+    return res;
+  }
+
+  if (message->properties == NULL) {
+    memset(&default_properties, 0, sizeof(default_properties));
+  }
+
+  f.frame_type = AMQP_FRAME_HEADER;
+  f.channel = channel;
+  f.payload.properties.class_id = AMQP_BASIC_CLASS;
+  f.payload.properties.body_size = message->body.len;
+  f.payload.properties.decoded = message->properties ?
+      (void *) message->properties : (void *) &default_properties;
+
+  res = amqp_batch_frame(state, &f);
+  if (res < 0) {
+    return res;
+  }
+
+  body_offset = 0;
+  while (body_offset < message->body.len) {
+    size_t remaining = message->body.len - body_offset;
+
+    f.frame_type = AMQP_FRAME_BODY;
+    f.channel = channel;
+    f.payload.body_fragment.bytes = amqp_offset(message->body.bytes, body_offset);
+    if (remaining >= usable_body_payload_size) {
+      f.payload.body_fragment.len = usable_body_payload_size;
+    } else {
+      f.payload.body_fragment.len = remaining;
+    }
+
+    body_offset += f.payload.body_fragment.len;
+    res = amqp_batch_frame(state, &f);
+    if (res < 0) {
+      return res;
+    }
+  }
+
+  return AMQP_STATUS_OK;
+}
+
+int amqp_basic_publish_batch(amqp_connection_state_t state,
+                             amqp_channel_t channel,
+                             amqp_publish_message_t const *messages,
+                             size_t count)
+{
+  size_t i;
+  int res;
+  amqp_confirm_tracker_t *tracker;
+
+  res = amqp_publish_check_heartbeat(state);
+  if (AMQP_STATUS_OK != res) {
+    return res;
+  }
+
+  tracker = amqp_get_confirm_tracker(state, channel);
+
+  state->batch_len = 0;
+  for (i = 0; i < count; i++) {
+    size_t message_start = state->batch_len;
+
+    if (NULL != tracker &&
+        tracker->next_tag - tracker->oldest_tag >= tracker->max_in_flight) {
+      /* the confirms we are about to wait for may be for messages that are
+       * still sitting in the batch */
+      res = amqp_batch_flush(state, AMQP_SF_NONE);
+      if (res < 0) {
+        return res;
+      }
+      res = amqp_confirm_reserve(state, tracker);
+      if (AMQP_STATUS_OK != res) {
+        return res;
+      }
+      message_start = 0;
+    }
+
+    res = amqp_batch_publish_message(state, channel, &messages[i]);
+    if (res < 0) {
+      /* drop the partially encoded message, but still send the ones before
+       * it */
+      state->batch_len = message_start;
+      amqp_batch_flush(state, AMQP_SF_NONE);
+      return res;
+    }
+    if (NULL != tracker) {
+      tracker->next_tag++;
+    }
+
+    if (state->batch_len >= AMQP_PUBLISH_BATCH_FLUSH_SIZE) {
+      res = amqp_batch_flush(state, i + 1 < count ? AMQP_SF_MORE : AMQP_SF_NONE);
+      if (res < 0) {
+        return res;
+      }
+    }
+  }
+
+  return amqp_batch_flush(state, AMQP_SF_NONE);
+}
+
+amqp_confirm_tracker_t *amqp_get_confirm_tracker(amqp_connection_state_t state,
+                                                 amqp_channel_t channel)
+{
+  amqp_confirm_tracker_t *tracker;
+
+  for (tracker = state->confirm_trackers; NULL != tracker;
+       tracker = tracker->next) {
+    if (channel == tracker->channel) {
+      return tracker;
+    }
+  }
+  return NULL;
+}
+
+void amqp_confirm_tracker_free(amqp_confirm_tracker_t *tracker)
+{
+  free(tracker->confirmed);
+  free(tracker);
+}
+
+static void amqp_remove_confirm_tracker(amqp_connection_state_t state,
+                                        amqp_channel_t channel)
+{
+  amqp_confirm_tracker_t **link;
+
+  for (link = &state->confirm_trackers; NULL != *link; link = &(*link)->next) {
+    if (channel == (*link)->channel) {
+      amqp_confirm_tracker_t *tracker = *link;
+      *link = tracker->next;
+      amqp_confirm_tracker_free(tracker);
+      return;
+    }
+  }
+}
+
+static void amqp_confirm_one(amqp_confirm_tracker_t *tracker, uint64_t tag,
+                             amqp_boolean_t ack)
+{
+  unsigned char *flag = &tracker->confirmed[tag % tracker->max_in_flight];
+
+  if (tag < tracker->oldest_tag || tag >= tracker->next_tag || *flag) {
+    return;
+  }
+  *flag = 1;
+  tracker->callback(tracker->callback_arg, tracker->channel, tag, ack);
+}
+
+/* Returns 1 if frame was a confirm for this tracker and has been handled */
+static int amqp_confirm_dispatch(amqp_confirm_tracker_t *tracker,
+                                 amqp_frame_t *frame)
+{
+  uint64_t tag;
+  amqp_boolean_t multiple;
+  amqp_boolean_t ack;
+
+  if (AMQP_FRAME_METHOD != frame->frame_type ||
+      tracker->channel != frame->channel) {
+    return 0;
+  }
+
+  switch (frame->payload.method.id) {
+    case AMQP_BASIC_ACK_METHOD: {
+      amqp_basic_ack_t *m = frame->payload.method.decoded;
+      tag = m->delivery_tag;
+      multiple = m->multiple;
+      ack = 1;
+      break;
+    }
+    case AMQP_BASIC_NACK_METHOD: {
+      amqp_basic_nack_t *m = frame->payload.method.decoded;
+      tag = m->delivery_tag;
+      multiple = m->multiple;
+      ack = 0;
+      break;
+    }
+    default:
+      return 0;
+  }
+
+  if (multiple) {
+    uint64_t t;
+    for (t = tracker->oldest_tag; t <= tag && t < tracker->next_tag; t++) {
+      amqp_confirm_one(tracker, t, ack);
+    }
+  } else {
+    amqp_confirm_one(tracker, tag, ack);
+  }
+
+  /* slide the window past everything confirmed */
+  while (tracker->oldest_tag < tracker->next_tag &&
+         tracker->confirmed[tracker->oldest_tag % tracker->max_in_flight]) {
+    tracker->confirmed[tracker->oldest_tag % tracker->max_in_flight] = 0;
+    tracker->oldest_tag++;
+  }
+  return 1;
+}
+
+static int amqp_is_close_frame(amqp_confirm_tracker_t *tracker,
+                               amqp_frame_t *frame)
+{
+  return AMQP_FRAME_METHOD == frame->frame_type &&
+         ((AMQP_CHANNEL_CLOSE_METHOD == frame->payload.method.id &&
+           tracker->channel == frame->channel) ||
+          AMQP_CONNECTION_CLOSE_METHOD == frame->payload.method.id);
+}
+
+/*
+ * Handle confirms until at most max_outstanding messages are unconfirmed,
+ * waiting up to timeout for them. Confirms queued by earlier reads are taken
+ * out of the frame queue, any other frame read is appended to it.
+ */
+static int amqp_confirm_process(amqp_connection_state_t state,
+                                amqp_confirm_tracker_t *tracker,
+                                size_t max_outstanding,
+                                struct timeval *timeout)
+{
+  amqp_link_t **link = &state->first_queued_frame;
+  amqp_link_t *prev = NULL;
+  amqp_frame_t frame;
+  int res;
+
+  while (NULL != *link) {
+    amqp_link_t *cur = *link;
+
+    if (amqp_confirm_dispatch(tracker, cur->data)) {
+      *link = cur->next;
+      if (state->last_queued_frame == cur) {
+        state->last_queued_frame = prev;
+      }
+    } else {
+      if (amqp_is_close_frame(tracker, cur->data)) {
+        return AMQP_STATUS_UNEXPECTED_STATE;
+      }
+      prev = cur;
+      link = &cur->next;
+    }
+  }
+
+  while (tracker->next_tag - tracker->oldest_tag > max_outstanding) {
+    res = amqp_wait_frame_unqueued(state, &frame, timeout);
+    if (AMQP_STATUS_OK != res) {
+      return res;
+    }
+    if (amqp_confirm_dispatch(tracker, &frame)) {
+      continue;
+    }
+    res = amqp_queue_frame(state, &frame);
+    if (AMQP_STATUS_OK != res) {
+      return res;
+    }
+    if (amqp_is_close_frame(tracker, &frame)) {
+      return AMQP_STATUS_UNEXPECTED_STATE;
+    }
+  }
   return AMQP_STATUS_OK;
 }
 
+int amqp_confirm_reserve(amqp_connection_state_t state,
+                         amqp_confirm_tracker_t *tracker)
+{
+  if (tracker->next_tag - tracker->oldest_tag < tracker->max_in_flight) {
+    return AMQP_STATUS_OK;
+  }
+  return amqp_confirm_process(state, tracker, tracker->max_in_flight - 1, NULL);
+}
+
+amqp_rpc_reply_t amqp_confirm_select_tracked(amqp_connection_state_t state,
+                                             amqp_channel_t channel,
+                                             size_t max_in_flight,
+                                             amqp_confirm_callback_t callback,
+                                             void *callback_arg)
+{
+  amqp_confirm_tracker_t *tracker;
+  amqp_rpc_reply_t ret;
+
+  memset(&ret, 0, sizeof(amqp_rpc_reply_t));
+  ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+
+  if (0 == max_in_flight || NULL == callback) {
+    ret.library_error = AMQP_STATUS_INVALID_PARAMETER;
+    return ret;
+  }
+
+  tracker = calloc(1, sizeof(amqp_confirm_tracker_t));
+  if (NULL == tracker) {
+    ret.library_error = AMQP_STATUS_NO_MEMORY;
+    return ret;
+  }
+  tracker->confirmed = calloc(max_in_flight, 1);
+  if (NULL == tracker->confirmed) {
+    free(tracker);
+    ret.library_error = AMQP_STATUS_NO_MEMORY;
+    return ret;
+  }
+
+  if (NULL == amqp_confirm_select(state, channel)) {
+    amqp_confirm_tracker_free(tracker);
+    return amqp_get_rpc_reply(state);
+  }
+
+  /* the broker numbers deliveries on the channel from 1 */
+  tracker->channel = channel;
+  tracker->next_tag = 1;
+  tracker->oldest_tag = 1;
+  tracker->max_in_flight = max_in_flight;
+  tracker->callback = callback;
+  tracker->callback_arg = callback_arg;
+
+  amqp_remove_confirm_tracker(state, channel);
+  tracker->next = state->confirm_trackers;
+  state->confirm_trackers = tracker;
+
+  return amqp_get_rpc_reply(state);
+}
+
+int amqp_confirm_poll(amqp_connection_state_t state, amqp_channel_t channel)
+{
+  struct timeval immediate = { 0, 0 };
+  amqp_confirm_tracker_t *tracker = amqp_get_confirm_tracker(state, channel);
+  int res;
+
+  if (NULL == tracker) {
+    return AMQP_STATUS_INVALID_PARAMETER;
+  }
+
+  /* read until nothing more is available */
+  res = amqp_confirm_process(state, tracker, 0, &immediate);
+  if (AMQP_STATUS_TIMEOUT == res) {
+    return AMQP_STATUS_OK;
+  }
+  return res;
+}
+
+int amqp_confirm_wait(amqp_connection_state_t state, amqp_channel_t channel,
+                      struct timeval *timeout)
+{
+  amqp_confirm_tracker_t *tracker = amqp_get_confirm_tracker(state, channel);
+
+  if (NULL == tracker) {
+    return AMQP_STATUS_INVALID_PARAMETER;
+  }
+  return amqp_confirm_process(state, tracker, 0, timeout);
+}
+
+uint64_t amqp_confirm_last_tag(amqp_connection_state_t state,
+                               amqp_channel_t channel)
+{
+  amqp_confirm_tracker_t *tracker = amqp_get_confirm_tracker(state, channel);
+
+  return NULL == tracker ? 0 : tracker->next_tag - 1;
+}
+
+size_t amqp_confirm_in_flight(amqp_connection_state_t state,
+                              amqp_channel_t channel)
+{
+  amqp_confirm_tracker_t *tracker = amqp_get_confirm_tracker(state, channel);
+
+  return NULL == tracker ? 0 : (size_t)(tracker->next_tag - tracker->oldest_tag);
+}
+
 amqp_rpc_reply_t amqp_channel_close(amqp_connection_state_t state,
                                     amqp_channel_t channel,
                                     int code)
@@ -278,6 +691,8 @@ amqp_rpc_reply_t amqp_channel_close(amqp_connection_state_t state,
   req.class_id = 0;
   req.method_id = 0;
 
+  amqp_remove_confirm_tracker(state, channel);
+
   return amqp_simple_rpc(state, channel, AMQP_CHANNEL_CLOSE_METHOD,
                          replies, &req);
 }
@@ -56,10 +56,6 @@
 #define AMQP_INITIAL_FRAME_POOL_PAGE_SIZE 65536
 #endif
 
-#ifndef AMQP_INITIAL_INBOUND_SOCK_BUFFER_SIZE
-#define AMQP_INITIAL_INBOUND_SOCK_BUFFER_SIZE 131072
-#endif
-
 
 #define ENFORCE_STATE(statevec, statenum)                                                 \
   {                                                                                       \
@@ -206,7 +202,15 @@ int amqp_destroy_connection(amqp_connection_state_t state)
       }
     }
 
+    while (NULL != state->confirm_trackers) {
+      amqp_confirm_tracker_t *tracker = state->confirm_trackers;
+      state->confirm_trackers = tracker->next;
+      amqp_confirm_tracker_free(tracker);
+    }
+
     free(state->outbound_buffer.bytes);
+    free(state->batch_buffer.bytes);
+    free(state->pending_out.bytes);
     free(state->sock_inbound_buffer.bytes);
     amqp_socket_delete(state->socket);
     empty_amqp_pool(&state->properties_pool);
@@ -537,20 +541,88 @@ int amqp_send_frame(amqp_connection_state_t state,
   return amqp_send_frame_inner(state, frame, AMQP_SF_NONE);
 }
 
-int amqp_send_frame_inner(amqp_connection_state_t state,
-                          const amqp_frame_t *frame, int flags) {
+static int amqp_append_pending(amqp_connection_state_t state,
+                               amqp_bytes_t data) {
+  size_t needed;
+
+  if (state->pending_out_offset > 0) {
+    memmove(state->pending_out.bytes,
+            amqp_offset(state->pending_out.bytes, state->pending_out_offset),
+            state->pending_out_len);
+    state->pending_out_offset = 0;
+  }
+
+  needed = state->pending_out_len + data.len;
+  if (needed > state->pending_out.len) {
+    size_t newlen = state->pending_out.len ? state->pending_out.len : 4096;
+    void *newbuf;
+
+    while (newlen < needed) {
+      newlen *= 2;
+    }
+    newbuf = realloc(state->pending_out.bytes, newlen);
+    if (NULL == newbuf) {
+      return AMQP_STATUS_NO_MEMORY;
+    }
+    state->pending_out.bytes = newbuf;
+    state->pending_out.len = newlen;
+  }
+
+  memcpy(amqp_offset(state->pending_out.bytes, state->pending_out_len),
+         data.bytes, data.len);
+  state->pending_out_len += data.len;
+  return AMQP_STATUS_OK;
+}
+
+static int amqp_send_encoded_nonblocking(amqp_connection_state_t state,
+                                         amqp_bytes_t encoded, int flags) {
+  int res;
+
+  /* bytes still pending have to go out first */
+  if (0 == state->pending_out_len) {
+    ssize_t sent = amqp_try_send(state, encoded.bytes, encoded.len,
+                                 amqp_time_immediate(), flags);
+    if (0 > sent) {
+      return (int)sent;
+    }
+    encoded.bytes = (uint8_t*)encoded.bytes + sent;
+    encoded.len -= sent;
+  }
+
+  if (encoded.len > 0) {
+    res = amqp_append_pending(state, encoded);
+    if (AMQP_STATUS_OK != res) {
+      return res;
+    }
+  }
+
+  return amqp_time_s_from_now(&state->next_send_heartbeat,
+                              amqp_heartbeat_send(state));
+}
+
+static int amqp_send_encoded(amqp_connection_state_t state,
+                             amqp_bytes_t encoded, int flags) {
   int res;
   ssize_t sent;
-  amqp_bytes_t encoded;
 
-  /* TODO: if the AMQP_SF_MORE socket optimization can be shown to work
-   * correctly, then this could be un-done so that body-frames are sent as 3
-   * send calls, getting rid of the copy of the body content, some testing
-   * would need to be done to see if this would actually a win for performance.
-   * */
-  res = amqp_frame_to_bytes(frame, state->outbound_buffer, &encoded);
-  if (AMQP_STATUS_OK != res) {
-    return res;
+  if (state->nonblocking) {
+    return amqp_send_encoded_nonblocking(state, encoded, flags);
+  }
+
+  if (state->pending_out_len > 0) {
+    /* left over from non-blocking mode, it goes out before anything else */
+    amqp_bytes_t pending;
+
+    pending.bytes = amqp_offset(state->pending_out.bytes,
+                                state->pending_out_offset);
+    pending.len = state->pending_out_len;
+    state->pending_out_offset = 0;
+    state->pending_out_len = 0;
+
+    res = amqp_send_encoded(state, pending, AMQP_SF_MORE);
+    if (AMQP_STATUS_OK != res) {
+      return res;
+    }
   }
 
 start_send:
@@ -581,6 +653,121 @@ start_send:
   return res;
 }
 
+int amqp_send_frame_inner(amqp_connection_state_t state,
+                          const amqp_frame_t *frame, int flags) {
+  int res;
+  amqp_bytes_t encoded;
+
+  /* TODO: if the AMQP_SF_MORE socket optimization can be shown to work
+   * correctly, then this could be un-done so that body-frames are sent as 3
+   * send calls, getting rid of the copy of the body content, some testing
+   * would need to be done to see if this would actually a win for performance.
+   * */
+  res = amqp_frame_to_bytes(frame, state->outbound_buffer, &encoded);
+  if (AMQP_STATUS_OK != res) {
+    return res;
+  }
+
+  return amqp_send_encoded(state, encoded, flags);
+}
+
+int amqp_batch_frame(amqp_connection_state_t state,
+                     const amqp_frame_t *frame) {
+  int res;
+  amqp_bytes_t slot;
+  amqp_bytes_t encoded;
+  size_t needed = state->batch_len + state->frame_max;
+
+  /* Every frame fits in frame_max, so make room for a whole one before
+   * encoding it in place */
+  if (needed > state->batch_buffer.len) {
+    size_t newlen = state->batch_buffer.len ? state->batch_buffer.len : 4096;
+    void *newbuf;
+
+    while (newlen < needed) {
+      newlen *= 2;
+    }
+    newbuf = realloc(state->batch_buffer.bytes, newlen);
+    if (NULL == newbuf) {
+      return AMQP_STATUS_NO_MEMORY;
+    }
+    state->batch_buffer.bytes = newbuf;
+    state->batch_buffer.len = newlen;
+  }
+
+  slot.bytes = amqp_offset(state->batch_buffer.bytes, state->batch_len);
+  slot.len = state->frame_max;
+  res = amqp_frame_to_bytes(frame, slot, &encoded);
+  if (AMQP_STATUS_OK != res) {
+    return res;
+  }
+
+  state->batch_len += encoded.len;
+  return AMQP_STATUS_OK;
+}
+
+int amqp_batch_flush(amqp_connection_state_t state, int flags) {
+  amqp_bytes_t encoded;
+
+  if (0 == state->batch_len) {
+    return AMQP_STATUS_OK;
+  }
+
+  encoded.bytes = state->batch_buffer.bytes;
+  encoded.len = state->batch_len;
+  state->batch_len = 0;
+
+  return amqp_send_encoded(state, encoded, flags);
+}
+
+void amqp_set_nonblocking(amqp_connection_state_t state,
+                          amqp_boolean_t nonblocking) {
+  state->nonblocking = nonblocking;
+}
+
+int amqp_flush_pending(amqp_connection_state_t state) {
+  return amqp_flush_pending_until(state, amqp_time_immediate());
+}
+
+int amqp_flush_pending_until(amqp_connection_state_t state,
+                             amqp_time_t deadline) {
+  ssize_t sent;
+
+  if (0 == state->pending_out_len) {
+    return AMQP_STATUS_OK;
+  }
+
+  sent = amqp_try_send(state,
+                       amqp_offset(state->pending_out.bytes,
+                                   state->pending_out_offset),
+                       state->pending_out_len, deadline, AMQP_SF_NONE);
+  if (0 > sent) {
+    return (int)sent;
+  }
+
+  state->pending_out_len -= sent;
+  if (0 == state->pending_out_len) {
+    state->pending_out_offset = 0;
+  } else {
+    state->pending_out_offset += sent;
+  }
+  return AMQP_STATUS_OK;
+}
+
+int amqp_get_io_events(amqp_connection_state_t state) {
+  int events = 0;
+
+  if (-1 == amqp_get_sockfd(state)) {
+    return 0;
+  }
+
+  events |= AMQP_IO_WANT_READ;
+  if (state->pending_out_len > 0) {
+    events |= AMQP_IO_WANT_WRITE;
+  }
+  return events;
+}
+
 amqp_table_t *
 amqp_get_server_properties(amqp_connection_state_t state)
 {
@@ -139,9 +139,14 @@ int amqp_bytes_malloc_dup_failed(amqp_bytes_t bytes) {
   return 0;
 }
 
-amqp_rpc_reply_t
-amqp_consume_message(amqp_connection_state_t state, amqp_envelope_t *envelope,
-                     struct timeval *timeout, AMQP_UNUSED int flags)
+static amqp_rpc_reply_t
+amqp_read_message_inner(amqp_connection_state_t state, amqp_channel_t channel,
+                        amqp_message_t *message, amqp_boolean_t pooled);
+
+static amqp_rpc_reply_t
+amqp_consume_message_inner(amqp_connection_state_t state,
+                           amqp_envelope_t *envelope,
+                           struct timeval *timeout, amqp_boolean_t pooled)
 {
   int res;
   amqp_frame_t frame;
@@ -169,21 +174,30 @@ amqp_consume_message(amqp_connection_state_t state, amqp_envelope_t *envelope,
   delivery_method = frame.payload.method.decoded;
 
   envelope->channel = frame.channel;
-  envelope->consumer_tag = amqp_bytes_malloc_dup(delivery_method->consumer_tag);
   envelope->delivery_tag = delivery_method->delivery_tag;
   envelope->redelivered = delivery_method->redelivered;
-  envelope->exchange = amqp_bytes_malloc_dup(delivery_method->exchange);
-  envelope->routing_key = amqp_bytes_malloc_dup(delivery_method->routing_key);
 
-  if (amqp_bytes_malloc_dup_failed(envelope->consumer_tag) ||
-      amqp_bytes_malloc_dup_failed(envelope->exchange) ||
-      amqp_bytes_malloc_dup_failed(envelope->routing_key)) {
-    ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
-    ret.library_error = AMQP_STATUS_NO_MEMORY;
-    goto error_out2;
+  if (pooled) {
+    /* the decoded method lives in the channel pool, as will the rest */
+    envelope->consumer_tag = delivery_method->consumer_tag;
+    envelope->exchange = delivery_method->exchange;
+    envelope->routing_key = delivery_method->routing_key;
+  } else {
+    envelope->consumer_tag = amqp_bytes_malloc_dup(delivery_method->consumer_tag);
+    envelope->exchange = amqp_bytes_malloc_dup(delivery_method->exchange);
+    envelope->routing_key = amqp_bytes_malloc_dup(delivery_method->routing_key);
+
+    if (amqp_bytes_malloc_dup_failed(envelope->consumer_tag) ||
+        amqp_bytes_malloc_dup_failed(envelope->exchange) ||
+        amqp_bytes_malloc_dup_failed(envelope->routing_key)) {
+      ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+      ret.library_error = AMQP_STATUS_NO_MEMORY;
+      goto error_out2;
+    }
   }
 
-  ret = amqp_read_message(state, envelope->channel, &envelope->message, 0);
+  ret = amqp_read_message_inner(state, envelope->channel, &envelope->message,
+                                pooled);
   if (AMQP_RESPONSE_NORMAL != ret.reply_type) {
     goto error_out2;
   }
@@ -192,17 +206,94 @@ amqp_consume_message(amqp_connection_state_t state, amqp_envelope_t *envelope,
   return ret;
 
 error_out2:
-  amqp_bytes_free(envelope->routing_key);
-  amqp_bytes_free(envelope->exchange);
-  amqp_bytes_free(envelope->consumer_tag);
+  if (!pooled) {
+    amqp_bytes_free(envelope->routing_key);
+    amqp_bytes_free(envelope->exchange);
+    amqp_bytes_free(envelope->consumer_tag);
+  }
 error_out1:
   return ret;
 }
 
+amqp_rpc_reply_t
+amqp_consume_message(amqp_connection_state_t state, amqp_envelope_t *envelope,
+                     struct timeval *timeout, AMQP_UNUSED int flags)
+{
+  return amqp_consume_message_inner(state, envelope, timeout, 0);
+}
+
+amqp_rpc_reply_t
+amqp_consume_message_pooled(amqp_connection_state_t state,
+                            amqp_envelope_t *envelope,
+                            struct timeval *timeout, AMQP_UNUSED int flags)
+{
+  return amqp_consume_message_inner(state, envelope, timeout, 1);
+}
+
+amqp_rpc_reply_t
+amqp_consume_messages_pooled(amqp_connection_state_t state,
+                             amqp_envelope_t *envelopes, size_t max,
+                             size_t *count, struct timeval *timeout,
+                             AMQP_UNUSED int flags)
+{
+  amqp_rpc_reply_t ret;
+
+  *count = 0;
+  if (0 == max) {
+    memset(&ret, 0, sizeof(amqp_rpc_reply_t));
+    ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+    ret.library_error = AMQP_STATUS_INVALID_PARAMETER;
+    return ret;
+  }
+
+  ret = amqp_consume_message_inner(state, &envelopes[0], timeout, 1);
+  if (AMQP_RESPONSE_NORMAL != ret.reply_type) {
+    return ret;
+  }
+  *count = 1;
+
+  /* Keep going for as long as frames that already arrived remain, without
+   * waiting on the socket for new ones */
+  while (*count < max &&
+         (amqp_frames_enqueued(state) || amqp_data_in_buffer(state))) {
+    struct timeval immediate = { 0, 0 };
+    amqp_rpc_reply_t next;
+
+    next = amqp_consume_message_inner(state, &envelopes[*count], &immediate, 1);
+    if (AMQP_RESPONSE_NORMAL != next.reply_type) {
+      /* a timeout (only part of the next delivery is here) or some other
+       * frame that was put back just end the batch */
+      if (AMQP_RESPONSE_LIBRARY_EXCEPTION != next.reply_type ||
+          (AMQP_STATUS_TIMEOUT != next.library_error &&
+           AMQP_STATUS_UNEXPECTED_STATE != next.library_error)) {
+        ret = next;
+      }
+      break;
+    }
+    (*count)++;
+  }
+
+  return ret;
+}
+
+void amqp_release_envelope(amqp_connection_state_t state,
+                           amqp_envelope_t *envelope)
+{
+  amqp_maybe_release_buffers_on_channel(state, envelope->channel);
+  memset(envelope, 0, sizeof(amqp_envelope_t));
+}
+
 amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state,
                                    amqp_channel_t channel,
                                    amqp_message_t *message,
                                    AMQP_UNUSED int flags)
+{
+  return amqp_read_message_inner(state, channel, message, 0);
+}
+
+static amqp_rpc_reply_t
+amqp_read_message_inner(amqp_connection_state_t state, amqp_channel_t channel,
+                        amqp_message_t *message, amqp_boolean_t pooled)
 {
   amqp_frame_t frame;
   amqp_rpc_reply_t ret;
@@ -239,14 +330,19 @@ amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state,
     goto error_out1;
   }
 
-  init_amqp_pool(&message->pool, 4096);
-  res = amqp_basic_properties_clone(frame.payload.properties.decoded,
-                                    &message->properties, &message->pool);
+  if (pooled) {
+    message->properties =
+        *(amqp_basic_properties_t *)frame.payload.properties.decoded;
+  } else {
+    init_amqp_pool(&message->pool, 4096);
+    res = amqp_basic_properties_clone(frame.payload.properties.decoded,
+                                      &message->properties, &message->pool);
 
-  if (AMQP_STATUS_OK != res) {
-    ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
-    ret.library_error = res;
-    goto error_out3;
+    if (AMQP_STATUS_OK != res) {
+      ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+      ret.library_error = res;
+      goto error_out3;
+    }
   }
 
   if (0 == frame.payload.properties.body_size) {
@@ -257,11 +353,18 @@ amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state,
       ret.library_error = AMQP_STATUS_NO_MEMORY;
       goto error_out1;
     }
-    message->body = amqp_bytes_malloc((size_t)frame.payload.properties.body_size);
-    if (NULL == message->body.bytes) {
-      ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
-      ret.library_error = AMQP_STATUS_NO_MEMORY;
-      goto error_out1;
+    if (pooled) {
+      /* Allocated when the first body frame turns out not to hold the whole
+       * body */
+      message->body.len = (size_t)frame.payload.properties.body_size;
+      message->body.bytes = NULL;
+    } else {
+      message->body = amqp_bytes_malloc((size_t)frame.payload.properties.body_size);
+      if (NULL == message->body.bytes) {
+        ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+        ret.library_error = AMQP_STATUS_NO_MEMORY;
+        goto error_out1;
+      }
     }
   }
 
@@ -295,6 +398,30 @@ amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state,
       goto error_out2;
     }
 
+    if (NULL == message->body.bytes) {
+      amqp_pool_t *channel_pool;
+
+      if (frame.payload.body_fragment.len == message->body.len) {
+        /* single body frame, hand out the frame buffer itself */
+        message->body.bytes = frame.payload.body_fragment.bytes;
+        break;
+      }
+
+      channel_pool = amqp_get_or_create_channel_pool(state, channel);
+      if (NULL == channel_pool) {
+        ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+        ret.library_error = AMQP_STATUS_NO_MEMORY;
+        goto error_out2;
+      }
+      amqp_pool_alloc_bytes(channel_pool, message->body.len, &message->body);
+      if (NULL == message->body.bytes) {
+        ret.reply_type = AMQP_RESPONSE_LIBRARY_EXCEPTION;
+        ret.library_error = AMQP_STATUS_NO_MEMORY;
+        goto error_out2;
+      }
+      body_read_ptr = message->body.bytes;
+    }
+
     memcpy(body_read_ptr, frame.payload.body_fragment.bytes, frame.payload.body_fragment.len);
 
     body_read += frame.payload.body_fragment.len;
@@ -305,9 +432,13 @@ amqp_rpc_reply_t amqp_read_message(amqp_connection_state_t state,
   return ret;
 
 error_out2:
-  amqp_bytes_free(message->body);
+  if (!pooled) {
+    amqp_bytes_free(message->body);
+  }
 error_out3:
-  empty_amqp_pool(&message->pool);
+  if (!pooled) {
+    empty_amqp_pool(&message->pool);
+  }
 error_out1:
   return ret;
 }
@@ -56,6 +56,31 @@ uint32_t amqp_version_number(void)
   return AMQP_VERSION;
 }
 
+/* Pages kept by recycle_amqp_pool(), the rest are freed */
+#ifndef AMQP_POOL_MAX_RETAINED_PAGES
+#define AMQP_POOL_MAX_RETAINED_PAGES 16
+#endif
+
+/* Large blocks kept by recycle_amqp_pool() for reuse, as long as they are no
+ * bigger than AMQP_POOL_MAX_CACHED_LARGE_PAGES pages */
+#ifndef AMQP_POOL_MAX_CACHED_LARGE_BLOCKS
+#define AMQP_POOL_MAX_CACHED_LARGE_BLOCKS 4
+#endif
+#ifndef AMQP_POOL_MAX_CACHED_LARGE_PAGES
+#define AMQP_POOL_MAX_CACHED_LARGE_PAGES 16
+#endif
+
+/* Large blocks start with their size and whether the pool hands them out
+ * right now, padded to keep the allocation 16-byte aligned like malloc()
+ * would. Keeping this out of amqp_pool_t leaves the public struct as is. */
+typedef union amqp_large_block_header_t_ {
+  struct {
+    size_t size;
+    int in_use;
+  } block;
+  char pad[16];
+} amqp_large_block_header_t;
+
 void init_amqp_pool(amqp_pool_t *pool, size_t pagesize)
 {
   pool->pagesize = pagesize ? pagesize : 4096;
@@ -85,9 +110,42 @@ static void empty_blocklist(amqp_pool_blocklist_t *x)
   x->blocklist = NULL;
 }
 
+static void trim_blocklist(amqp_pool_blocklist_t *x, int keep)
+{
+  int i;
+
+  for (i = keep; i < x->num_blocks; i++) {
+    free(x->blocklist[i]);
+  }
+  if (keep < x->num_blocks) {
+    x->num_blocks = keep;
+  }
+}
+
 void recycle_amqp_pool(amqp_pool_t *pool)
 {
-  empty_blocklist(&pool->large_blocks);
+  amqp_pool_blocklist_t *large = &pool->large_blocks;
+  size_t max_cached = AMQP_POOL_MAX_CACHED_LARGE_PAGES * pool->pagesize;
+  int cached = 0;
+  int i;
+
+  /* keep a few reasonably sized large blocks at the front of the list */
+  for (i = 0; i < large->num_blocks; i++) {
+    amqp_large_block_header_t *header = large->blocklist[i];
+
+    if (cached < AMQP_POOL_MAX_CACHED_LARGE_BLOCKS && header->block.size <= max_cached) {
+      header->block.in_use = 0;
+      large->blocklist[i] = large->blocklist[cached];
+      large->blocklist[cached] = header;
+      cached++;
+    }
+  }
+  trim_blocklist(large, cached);
+  if (0 == large->num_blocks) {
+    empty_blocklist(large);
+  }
+
+  trim_blocklist(&pool->pages, AMQP_POOL_MAX_RETAINED_PAGES);
   pool->next_page = 0;
   pool->alloc_block = NULL;
   pool->alloc_used = 0;
@@ -95,8 +153,11 @@ void recycle_amqp_pool(amqp_pool_t *pool)
 
 void empty_amqp_pool(amqp_pool_t *pool)
 {
-  recycle_amqp_pool(pool);
+  empty_blocklist(&pool->large_blocks);
   empty_blocklist(&pool->pages);
+  pool->next_page = 0;
+  pool->alloc_block = NULL;
+  pool->alloc_used = 0;
 }
 
 /* Returns 1 on success, 0 on failure */
@@ -122,6 +183,36 @@ static int record_pool_block(amqp_pool_blocklist_t *x, void *block)
   return 1;
 }
 
+static void *pool_alloc_large(amqp_pool_t *pool, size_t amount)
+{
+  amqp_pool_blocklist_t *large = &pool->large_blocks;
+  amqp_large_block_header_t *header;
+  int i;
+
+  /* reuse a kept block that is big enough without wasting more than half,
+   * recycle_amqp_pool() puts the kept blocks at the front of the list */
+  for (i = 0; i < large->num_blocks; i++) {
+    header = large->blocklist[i];
+    if (!header->block.in_use && header->block.size >= amount &&
+        header->block.size / 2 <= amount) {
+      header->block.in_use = 1;
+      return header + 1;
+    }
+  }
+
+  header = calloc(1, sizeof(amqp_large_block_header_t) + amount);
+  if (header == NULL) {
+    return NULL;
+  }
+  header->block.size = amount;
+  header->block.in_use = 1;
+  if (!record_pool_block(large, header)) {
+    free(header);
+    return NULL;
+  }
+  return header + 1;
+}
+
 void *amqp_pool_alloc(amqp_pool_t *pool, size_t amount)
 {
   if (amount == 0) {
@@ -131,14 +222,7 @@ void *amqp_pool_alloc(amqp_pool_t *pool, size_t amount)
   amount = (amount + 7) & (~7); /* round up to nearest 8-byte boundary */
 
   if (amount > pool->pagesize) {
-    void *result = calloc(1, amount);
-    if (result == NULL) {
-      return NULL;
-    }
-    if (!record_pool_block(&pool->large_blocks, result)) {
-      return NULL;
-    }
-    return result;
+    return pool_alloc_large(pool, amount);
   }
 
   if (pool->alloc_block != NULL) {
@@ -213,6 +297,10 @@ amqp_pool_t *amqp_get_or_create_channel_pool(amqp_connection_state_t state, amqp
   amqp_pool_table_entry_t *entry;
   size_t index = channel % POOL_TABLE_SIZE;
 
+  if (channel < POOL_DIRECT_SIZE && NULL != state->pool_direct[channel]) {
+    return &state->pool_direct[channel]->pool;
+  }
+
   entry = state->pool_table[index];
 
   for ( ; NULL != entry; entry = entry->next) {
@@ -229,6 +317,9 @@ amqp_pool_t *amqp_get_or_create_channel_pool(amqp_connection_state_t state, amqp
   entry->channel = channel;
   entry->next = state->pool_table[index];
   state->pool_table[index] = entry;
+  if (channel < POOL_DIRECT_SIZE) {
+    state->pool_direct[channel] = entry;
+  }
 
   init_amqp_pool(&entry->pool, state->frame_max);
 
@@ -240,6 +331,11 @@ amqp_pool_t *amqp_get_channel_pool(amqp_connection_state_t state, amqp_channel_t
   amqp_pool_table_entry_t *entry;
   size_t index = channel % POOL_TABLE_SIZE;
 
+  if (channel < POOL_DIRECT_SIZE) {
+    entry = state->pool_direct[channel];
+    return NULL == entry ? NULL : &entry->pool;
+  }
+
   entry = state->pool_table[index];
 
   for ( ; NULL != entry; entry = entry->next) {
@@ -65,6 +65,14 @@ static pthread_mutex_t openssl_init_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t *amqp_openssl_lockarray = NULL;
 #endif /* ENABLE_THREAD_SAFETY */
 
+/* Writes flagged AMQP_SF_MORE are gathered up to the largest TLS record, so
+ * that a publish goes out as one record instead of one per frame */
+#define AMQP_SSL_WRITE_BUFFER_SIZE 16384
+
+/* Input buffer of the TLS connection, read-ahead fills it with as many
+ * records as the socket has in one read */
+#define AMQP_SSL_READ_BUFFER_SIZE (64 * 1024)
+
 struct amqp_ssl_socket_t {
   const struct amqp_socket_class_t *klass;
   SSL_CTX *ctx;
@@ -72,15 +80,19 @@ struct amqp_ssl_socket_t {
   SSL *ssl;
   amqp_boolean_t verify;
   int internal_error;
+  SSL_SESSION *session;   /* resumed by the next open */
+  char *wbuf;             /* allocated on the first gathered write */
+  size_t wbuf_len;
+  /* bytes at the end of wbuf the caller passed to a send that failed; it
+   * passes them again on the retry */
+  size_t wbuf_unreported;
+  /* a write of the caller's buffer failed, the retry has to bypass wbuf */
+  amqp_boolean_t write_direct;
 };
 
-static ssize_t amqp_ssl_socket_send(void *base, const void *buf, size_t len,
-                                    AMQP_UNUSED int flags) {
-  struct amqp_ssl_socket_t *self = (struct amqp_ssl_socket_t *)base;
+static ssize_t amqp_ssl_socket_write(struct amqp_ssl_socket_t *self,
+                                     const void *buf, size_t len) {
   ssize_t res;
-  if (-1 == self->sockfd) {
-    return AMQP_STATUS_SOCKET_CLOSED;
-  }
 
   ERR_clear_error();
   self->internal_error = 0;
@@ -113,6 +125,54 @@ static ssize_t amqp_ssl_socket_send(void *base, const void *buf, size_t len,
   return res;
 }
 
+static ssize_t amqp_ssl_socket_send(void *base, const void *buf, size_t len,
+                                    int flags) {
+  struct amqp_ssl_socket_t *self = (struct amqp_ssl_socket_t *)base;
+  size_t accepted;
+  ssize_t res;
+  if (-1 == self->sockfd) {
+    return AMQP_STATUS_SOCKET_CLOSED;
+  }
+
+  if (self->wbuf_unreported) {
+    /* retry of a failed write, the start of buf is already in wbuf */
+    accepted = self->wbuf_unreported;
+  } else {
+    if (self->write_direct ||
+        (0 == self->wbuf_len &&
+         (!(flags & AMQP_SF_MORE) || len >= AMQP_SSL_WRITE_BUFFER_SIZE))) {
+      res = amqp_ssl_socket_write(self, buf, len);
+      self->write_direct = 0 > res;
+      return res;
+    }
+    if (!self->wbuf) {
+      self->wbuf = malloc(AMQP_SSL_WRITE_BUFFER_SIZE);
+      if (!self->wbuf) {
+        return AMQP_STATUS_NO_MEMORY;
+      }
+    }
+    accepted = AMQP_SSL_WRITE_BUFFER_SIZE - self->wbuf_len;
+    if (accepted > len) {
+      accepted = len;
+    }
+    memcpy(self->wbuf + self->wbuf_len, buf, accepted);
+    self->wbuf_len += accepted;
+    if (flags & AMQP_SF_MORE && self->wbuf_len < AMQP_SSL_WRITE_BUFFER_SIZE) {
+      return accepted;
+    }
+  }
+
+  /* OpenSSL wants the same bytes again after a failed SSL_write() */
+  res = amqp_ssl_socket_write(self, self->wbuf, self->wbuf_len);
+  if (0 > res) {
+    self->wbuf_unreported = accepted;
+    return res;
+  }
+  self->wbuf_len = 0;
+  self->wbuf_unreported = 0;
+  return accepted;
+}
+
 static ssize_t
 amqp_ssl_socket_recv(void *base,
                      void *buf,
@@ -253,6 +313,18 @@ error:
   goto exit;
 }
 
+static void
+amqp_ssl_socket_save_session(struct amqp_ssl_socket_t *self)
+{
+  SSL_SESSION *session = SSL_get1_session(self->ssl);
+  if (session) {
+    if (self->session) {
+      SSL_SESSION_free(self->session);
+    }
+    self->session = session;
+  }
+}
+
 static int
 amqp_ssl_socket_open(void *base, const char *host, int port, struct timeval *timeout)
 {
@@ -292,6 +364,16 @@ amqp_ssl_socket_open(void *base, const char *host, int port, struct timeval *tim
     goto error_out2;
   }
 
+  /* Resume the session of the previous connection, which saves a round trip
+   * and the key exchange. The broker falls back to a full handshake if it
+   * does not know the session anymore */
+  if (self->session) {
+    SSL_set_session(self->ssl, self->session);
+  }
+  self->wbuf_len = 0;
+  self->wbuf_unreported = 0;
+  self->write_direct = 0;
+
 start_connect:
   status = SSL_connect(self->ssl);
   if (status != 1) {
@@ -327,6 +409,8 @@ start_connect:
     }
   }
 
+  amqp_ssl_socket_save_session(self);
+
   self->internal_error = 0;
   status = AMQP_STATUS_OK;
 
@@ -354,6 +438,9 @@ amqp_ssl_socket_close(void *base)
     return AMQP_STATUS_SOCKET_CLOSED;
   }
 
+  /* TLS 1.3 sends session tickets after the handshake, take the latest */
+  amqp_ssl_socket_save_session(self);
+
 start_shutdown:
   res = SSL_shutdown(self->ssl);
   if (0 == res) {
@@ -399,7 +486,11 @@ amqp_ssl_socket_delete(void *base)
   if (self) {
     amqp_ssl_socket_close(self);
 
+    if (self->session) {
+      SSL_SESSION_free(self->session);
+    }
     SSL_CTX_free(self->ctx);
+    free(self->wbuf);
     free(self);
   }
   destroy_openssl();
@@ -436,6 +527,12 @@ amqp_ssl_socket_new(amqp_connection_state_t state)
   if (!self->ctx) {
     goto error;
   }
+  /* pending output may move in memory between retries of a write */
+  SSL_CTX_set_mode(self->ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  SSL_CTX_set_read_ahead(self->ctx, 1);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  SSL_CTX_set_default_read_buffer_len(self->ctx, AMQP_SSL_READ_BUFFER_SIZE);
+#endif
 
   amqp_set_socket(state, (amqp_socket_t *)self);
 
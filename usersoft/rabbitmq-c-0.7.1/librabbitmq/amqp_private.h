@@ -143,14 +143,44 @@ typedef struct amqp_link_t_ {
 
 #define POOL_TABLE_SIZE 16
 
+/* Pools of channels below this are also indexed directly by channel number */
+#define POOL_DIRECT_SIZE 64
+
+/* The socket read buffer starts at the initial size, doubles while reads
+ * keep filling it up to the max size, and shrinks back after a run of
+ * mostly empty reads */
+#ifndef AMQP_INITIAL_INBOUND_SOCK_BUFFER_SIZE
+#define AMQP_INITIAL_INBOUND_SOCK_BUFFER_SIZE 131072
+#endif
+
+#ifndef AMQP_MAX_INBOUND_SOCK_BUFFER_SIZE
+#define AMQP_MAX_INBOUND_SOCK_BUFFER_SIZE 2097152
+#endif
+
 typedef struct amqp_pool_table_entry_t_ {
   struct amqp_pool_table_entry_t_ *next;
   amqp_pool_t pool;
   amqp_channel_t channel;
 } amqp_pool_table_entry_t;
 
+/* Publisher confirm bookkeeping for one channel, see
+ * amqp_confirm_select_tracked() */
+typedef struct amqp_confirm_tracker_t_ {
+  struct amqp_confirm_tracker_t_ *next;
+  amqp_channel_t channel;
+
+  uint64_t next_tag;            /* delivery tag of the next publish */
+  uint64_t oldest_tag;          /* oldest tag not confirmed yet */
+  size_t max_in_flight;
+  unsigned char *confirmed;     /* ring of max_in_flight flags, by tag */
+
+  amqp_confirm_callback_t callback;
+  void *callback_arg;
+} amqp_confirm_tracker_t;
+
 struct amqp_connection_state_t_ {
   amqp_pool_table_entry_t *pool_table[POOL_TABLE_SIZE];
+  amqp_pool_table_entry_t *pool_direct[POOL_DIRECT_SIZE];
 
   amqp_connection_state_enum state;
 
@@ -175,11 +205,24 @@ struct amqp_connection_state_t_ {
 
   amqp_bytes_t outbound_buffer;
 
+  /* frames queued by amqp_batch_frame(), written by amqp_batch_flush() */
+  amqp_bytes_t batch_buffer;
+  size_t batch_len;
+
+  /* With nonblocking set, whatever the socket does not take right away is
+   * kept in pending_out (pending_out.len is its capacity) and written by
+   * amqp_flush_pending() */
+  amqp_boolean_t nonblocking;
+  amqp_bytes_t pending_out;
+  size_t pending_out_offset;
+  size_t pending_out_len;
+
   amqp_socket_t *socket;
 
   amqp_bytes_t sock_inbound_buffer;
   size_t sock_inbound_offset;
   size_t sock_inbound_limit;
+  int sock_inbound_small_reads;
 
   amqp_link_t *first_queued_frame;
   amqp_link_t *last_queued_frame;
@@ -189,6 +232,8 @@ struct amqp_connection_state_t_ {
   amqp_table_t server_properties;
   amqp_table_t client_properties;
   amqp_pool_t properties_pool;
+
+  amqp_confirm_tracker_t *confirm_trackers;
 };
 
 amqp_pool_t *amqp_get_or_create_channel_pool(amqp_connection_state_t connection, amqp_channel_t channel);
@@ -371,4 +416,21 @@ int amqp_bytes_equal(amqp_bytes_t r, amqp_bytes_t l);
 
 int amqp_send_frame_inner(amqp_connection_state_t state,
                           const amqp_frame_t *frame, int flags);
+
+int amqp_flush_pending_until(amqp_connection_state_t state,
+                             amqp_time_t deadline);
+
+int amqp_wait_frame_unqueued(amqp_connection_state_t state,
+                             amqp_frame_t *decoded_frame,
+                             struct timeval *timeout);
+
+amqp_confirm_tracker_t *amqp_get_confirm_tracker(amqp_connection_state_t state,
+                                                 amqp_channel_t channel);
+void amqp_confirm_tracker_free(amqp_confirm_tracker_t *tracker);
+int amqp_confirm_reserve(amqp_connection_state_t state,
+                         amqp_confirm_tracker_t *tracker);
+
+int amqp_batch_frame(amqp_connection_state_t state,
+                     const amqp_frame_t *frame);
+int amqp_batch_flush(amqp_connection_state_t state, int flags);
 #endif
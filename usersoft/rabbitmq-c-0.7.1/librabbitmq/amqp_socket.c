@@ -693,10 +693,57 @@ static int consume_one_frame(amqp_connection_state_t state, amqp_frame_t *decode
 }
 
 
+/* Number of consecutive reads using less than a quarter of the socket buffer
+ * after which it is halved */
+#define AMQP_INBOUND_SOCK_BUFFER_SHRINK_READS 16
+
+/*
+ * Size the socket read buffer after the last read. Only called once
+ * everything in the buffer has been consumed, frames are copied out of it
+ * so it can be moved freely.
+ */
+static void resize_inbound_buffer(amqp_connection_state_t state)
+{
+  size_t newlen = state->sock_inbound_buffer.len;
+  void *newbuf;
+
+  if (state->sock_inbound_limit == state->sock_inbound_buffer.len) {
+    state->sock_inbound_small_reads = 0;
+    if (newlen < AMQP_MAX_INBOUND_SOCK_BUFFER_SIZE) {
+      newlen *= 2;
+    }
+  } else if (state->sock_inbound_limit < state->sock_inbound_buffer.len / 4) {
+    if (++state->sock_inbound_small_reads >= AMQP_INBOUND_SOCK_BUFFER_SHRINK_READS) {
+      state->sock_inbound_small_reads = 0;
+      if (newlen > AMQP_INITIAL_INBOUND_SOCK_BUFFER_SIZE) {
+        newlen /= 2;
+      }
+    }
+  } else {
+    state->sock_inbound_small_reads = 0;
+  }
+
+  /* so that a recv that times out is not mistaken for a full read next time */
+  state->sock_inbound_offset = 0;
+  state->sock_inbound_limit = 0;
+
+  if (newlen == state->sock_inbound_buffer.len) {
+    return;
+  }
+  /* a failed realloc leaves the current buffer in place, which still works */
+  newbuf = realloc(state->sock_inbound_buffer.bytes, newlen);
+  if (NULL != newbuf) {
+    state->sock_inbound_buffer.bytes = newbuf;
+    state->sock_inbound_buffer.len = newlen;
+  }
+}
+
 static int recv_with_timeout(amqp_connection_state_t state, amqp_time_t timeout) {
   ssize_t res;
   int fd;
 
+  resize_inbound_buffer(state);
+
 start_recv:
   res = amqp_socket_recv(state->socket, state->sock_inbound_buffer.bytes,
                          state->sock_inbound_buffer.len, 0);
@@ -831,6 +878,13 @@ beginrecv:
                                amqp_time_first(state->next_recv_heartbeat,
                                                state->next_send_heartbeat));
 
+    /* a reply cannot come before the request left, so write out what
+     * non-blocking mode left pending, waiting no longer than for the reply */
+    res = amqp_flush_pending_until(state, deadline);
+    if (AMQP_STATUS_OK != res) {
+      return res;
+    }
+
     /* TODO this needs to wait for a _frame_ and not anything written from the
      * socket */
     res = recv_with_timeout(state, deadline);
@@ -956,6 +1010,13 @@ int amqp_simple_wait_frame_on_channel(amqp_connection_state_t state,
   }
 }
 
+int amqp_wait_frame_unqueued(amqp_connection_state_t state,
+                             amqp_frame_t *decoded_frame,
+                             struct timeval *timeout)
+{
+  return wait_frame_inner(state, decoded_frame, timeout);
+}
+
 int amqp_simple_wait_frame(amqp_connection_state_t state,
                            amqp_frame_t *decoded_frame)
 {
@@ -46,9 +46,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define INITIAL_ARRAY_SIZE 16
-#define INITIAL_TABLE_SIZE 16
-
 static int amqp_decode_field_value(amqp_bytes_t encoded,
                                    amqp_pool_t *pool,
                                    amqp_field_value_t *entry,
@@ -60,6 +57,68 @@ static int amqp_encode_field_value(amqp_bytes_t encoded,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Step over one field value without decoding it. Used to count the entries of
+ * a table or array up front, so that they can be decoded straight into a
+ * single pool allocation.
+ */
+static int amqp_skip_field_value(amqp_bytes_t encoded, size_t *offset)
+{
+  uint8_t kind;
+  uint32_t len;
+  size_t size;
+
+  if (!amqp_decode_8(encoded, offset, &kind)) {
+    return 0;
+  }
+
+  switch (kind) {
+  case AMQP_FIELD_KIND_BOOLEAN:
+  case AMQP_FIELD_KIND_I8:
+  case AMQP_FIELD_KIND_U8:
+    size = 1;
+    break;
+  case AMQP_FIELD_KIND_I16:
+  case AMQP_FIELD_KIND_U16:
+    size = 2;
+    break;
+  case AMQP_FIELD_KIND_I32:
+  case AMQP_FIELD_KIND_U32:
+  case AMQP_FIELD_KIND_F32:
+    size = 4;
+    break;
+  case AMQP_FIELD_KIND_DECIMAL:
+    size = 5;
+    break;
+  case AMQP_FIELD_KIND_I64:
+  case AMQP_FIELD_KIND_U64:
+  case AMQP_FIELD_KIND_F64:
+  case AMQP_FIELD_KIND_TIMESTAMP:
+    size = 8;
+    break;
+  case AMQP_FIELD_KIND_UTF8:
+  case AMQP_FIELD_KIND_BYTES:
+  case AMQP_FIELD_KIND_ARRAY:
+  case AMQP_FIELD_KIND_TABLE:
+    if (!amqp_decode_32(encoded, offset, &len)) {
+      return 0;
+    }
+    size = len;
+    break;
+  case AMQP_FIELD_KIND_VOID:
+    size = 0;
+    break;
+  default:
+    return 0;
+  }
+
+  if (size > encoded.len - *offset) {
+    return 0;
+  }
+  *offset += size;
+  return 1;
+}
+
 static int amqp_decode_array(amqp_bytes_t encoded,
                              amqp_pool_t *pool,
                              amqp_array_t *output,
@@ -67,57 +126,42 @@ static int amqp_decode_array(amqp_bytes_t encoded,
 {
   uint32_t arraysize;
   int num_entries = 0;
-  int allocated_entries = INITIAL_ARRAY_SIZE;
+  int count = 0;
   amqp_field_value_t *entries;
   size_t limit;
+  size_t o;
   int res;
 
   if (!amqp_decode_32(encoded, offset, &arraysize)) {
     return AMQP_STATUS_BAD_AMQP_DATA;
   }
 
-  entries = malloc(allocated_entries * sizeof(amqp_field_value_t));
-  if (entries == NULL) {
-    return AMQP_STATUS_NO_MEMORY;
-  }
-
   limit = *offset + arraysize;
-  while (*offset < limit) {
-    if (num_entries >= allocated_entries) {
-      void *newentries;
-      allocated_entries = allocated_entries * 2;
-      newentries = realloc(entries, allocated_entries * sizeof(amqp_field_value_t));
-      res = AMQP_STATUS_NO_MEMORY;
-      if (newentries == NULL) {
-        goto out;
-      }
-
-      entries = newentries;
+  for (o = *offset; o < limit; count++) {
+    if (!amqp_skip_field_value(encoded, &o)) {
+      return AMQP_STATUS_BAD_AMQP_DATA;
     }
+  }
 
+  entries = amqp_pool_alloc(pool, count * sizeof(amqp_field_value_t));
+  /* NULL is legitimate if we requested a zero-length block. */
+  if (entries == NULL && count > 0) {
+    return AMQP_STATUS_NO_MEMORY;
+  }
+
+  while (*offset < limit && num_entries < count) {
     res = amqp_decode_field_value(encoded, pool, &entries[num_entries],
                                   offset);
     if (res < 0) {
-      goto out;
+      return res;
     }
 
     num_entries++;
   }
 
   output->num_entries = num_entries;
-  output->entries = amqp_pool_alloc(pool, num_entries * sizeof(amqp_field_value_t));
-  res = AMQP_STATUS_NO_MEMORY;
-  /* NULL is legitimate if we requested a zero-length block. */
-  if (output->entries == NULL && num_entries > 0) {
-    goto out;
-  }
-
-  memcpy(output->entries, entries, num_entries * sizeof(amqp_field_value_t));
-  res = 0;
-
-out:
-  free(entries);
-  return res;
+  output->entries = entries;
+  return AMQP_STATUS_OK;
 }
 
 int amqp_decode_table(amqp_bytes_t encoded,
@@ -127,69 +171,59 @@ int amqp_decode_table(amqp_bytes_t encoded,
 {
   uint32_t tablesize;
   int num_entries = 0;
+  int count = 0;
   amqp_table_entry_t *entries;
-  int allocated_entries = INITIAL_TABLE_SIZE;
   size_t limit;
+  size_t o;
   int res;
 
   if (!amqp_decode_32(encoded, offset, &tablesize)) {
     return AMQP_STATUS_BAD_AMQP_DATA;
   }
 
-  entries = malloc(allocated_entries * sizeof(amqp_table_entry_t));
-  if (entries == NULL) {
-    return AMQP_STATUS_NO_MEMORY;
-  }
-
   limit = *offset + tablesize;
-  while (*offset < limit) {
+  for (o = *offset; o < limit; count++) {
     uint8_t keylen;
 
-    res = AMQP_STATUS_BAD_AMQP_DATA;
-    if (!amqp_decode_8(encoded, offset, &keylen)) {
-      goto out;
+    if (!amqp_decode_8(encoded, &o, &keylen) ||
+        keylen > encoded.len - o) {
+      return AMQP_STATUS_BAD_AMQP_DATA;
     }
+    o += keylen;
+    if (!amqp_skip_field_value(encoded, &o)) {
+      return AMQP_STATUS_BAD_AMQP_DATA;
+    }
+  }
 
-    if (num_entries >= allocated_entries) {
-      void *newentries;
-      allocated_entries = allocated_entries * 2;
-      newentries = realloc(entries, allocated_entries * sizeof(amqp_table_entry_t));
-      res = AMQP_STATUS_NO_MEMORY;
-      if (newentries == NULL) {
-        goto out;
-      }
+  entries = amqp_pool_alloc(pool, count * sizeof(amqp_table_entry_t));
+  /* NULL is legitimate if we requested a zero-length block. */
+  if (entries == NULL && count > 0) {
+    return AMQP_STATUS_NO_MEMORY;
+  }
+
+  while (*offset < limit && num_entries < count) {
+    uint8_t keylen;
 
-      entries = newentries;
+    if (!amqp_decode_8(encoded, offset, &keylen)) {
+      return AMQP_STATUS_BAD_AMQP_DATA;
     }
 
-    res = AMQP_STATUS_BAD_AMQP_DATA;
     if (!amqp_decode_bytes(encoded, offset, &entries[num_entries].key, keylen)) {
-      goto out;
+      return AMQP_STATUS_BAD_AMQP_DATA;
     }
 
     res = amqp_decode_field_value(encoded, pool, &entries[num_entries].value,
                                   offset);
     if (res < 0) {
-      goto out;
+      return res;
     }
 
     num_entries++;
   }
 
   output->num_entries = num_entries;
-  output->entries = amqp_pool_alloc(pool, num_entries * sizeof(amqp_table_entry_t));
-  res = AMQP_STATUS_NO_MEMORY;
-  /* NULL is legitimate if we requested a zero-length block. */
-  if (output->entries == NULL && num_entries > 0) {
-    goto out;
-  }
-
-  memcpy(output->entries, entries, num_entries * sizeof(amqp_table_entry_t));
-  res = AMQP_STATUS_OK;
-
-out:
-  free(entries);
-  return res;
+  output->entries = entries;
+  return AMQP_STATUS_OK;
 }
 
 static int amqp_decode_field_value(amqp_bytes_t encoded,
@@ -69,15 +69,15 @@ PHP_ARG_ENABLE(coroutine, whether to enable coroutine,
 PHP_ARG_ENABLE(asan, whether to enable asan,
 [  --enable-asan      Enable asan], no, no)
 
-PHP_ARG_ENABLE(picohttpparser, enable picohttpparser support,
-[  --enable-picohttpparser     Experimental: Do you have picohttpparser?], no, no)
-
 PHP_ARG_WITH(swoole, swoole support,
 [  --with-swoole           With swoole support])
 
 PHP_ARG_ENABLE(timewheel, enable timewheel support,
 [  --enable-timewheel     Experimental: Enable timewheel heartbeat?], no, no)
 
+PHP_ARG_ENABLE(io_uring, enable io_uring reactor,
+[  --enable-io-uring     Experimental: Use io_uring reactor (linux 5.11+)?], no, no)
+
 AC_DEFUN([SWOOLE_HAVE_PHP_EXT], [
     extname=$1
     haveext=$[PHP_]translit($1,a-z_-,A-Z__)
@@ -187,6 +187,26 @@ AC_DEFUN([AC_SWOOLE_HAVE_LINUX_AIO],
     ])
 ])
 
+AC_DEFUN([AC_SWOOLE_HAVE_IO_URING],
+[
+    AC_MSG_CHECKING([for io_uring])
+    AC_TRY_COMPILE(
+    [
+        #include <sys/syscall.h>
+        #include <linux/io_uring.h>
+    ], [
+        struct io_uring_params params;
+        struct io_uring_getevents_arg arg;
+        int flags = IORING_ENTER_EXT_ARG | IORING_FEAT_EXT_ARG;
+        syscall(__NR_io_uring_setup, 1, &params);
+    ], [
+        AC_DEFINE([HAVE_IO_URING], 1, [have io_uring?])
+        AC_MSG_RESULT([yes])
+    ], [
+        AC_MSG_RESULT([no])
+    ])
+])
+
 AC_MSG_CHECKING([if compiling with clang])
 AC_COMPILE_IFELSE([
     AC_LANG_PROGRAM([], [[
@@ -251,6 +271,11 @@ if test "$PHP_SWOOLE" != "no"; then
         AC_DEFINE(SW_USE_TIMEWHEEL, 1, [enable timewheel support])
     fi
 
+    if test "$PHP_IO_URING" = "yes"; then
+        AC_DEFINE(SW_USE_IO_URING, 1, [enable io_uring reactor])
+        AC_SWOOLE_HAVE_IO_URING
+    fi
+
     AC_SWOOLE_CPU_AFFINITY
     AC_SWOOLE_HAVE_REUSEPORT
 	AC_SWOOLE_HAVE_FUTEX
@@ -360,6 +385,11 @@ if test "$PHP_SWOOLE" != "no"; then
         PHP_ADD_LIBRARY(z, 1, SWOOLE_SHARED_LIBADD)
     ])
 
+    AC_CHECK_LIB(brotlienc, BrotliEncoderCompress, [
+        AC_DEFINE(SW_HAVE_BROTLI, 1, [have brotli])
+        PHP_ADD_LIBRARY(brotlienc, 1, SWOOLE_SHARED_LIBADD)
+    ])
+
     swoole_source_file="swoole.c \
         swoole_server.c \
         swoole_server_port.c \
@@ -412,6 +442,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/memory/RingBuffer.c \
         src/memory/FixedPool.c \
         src/memory/Malloc.c \
+        src/memory/SlabPool.c \
         src/memory/Table.c \
         src/memory/Buffer.c \
         src/factory/Factory.c \
@@ -421,6 +452,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/reactor/ReactorSelect.c \
         src/reactor/ReactorPoll.c \
         src/reactor/ReactorEpoll.c \
+        src/reactor/ReactorIOUring.c \
         src/reactor/ReactorKqueue.c \
         src/pipe/PipeBase.c \
         src/pipe/PipeEventfd.c \
@@ -449,6 +481,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/os/base.c \
         src/os/linux_aio.c \
         src/os/msg_queue.c \
+        src/os/numa.c \
         src/os/sendfile.c \
         src/os/signal.c \
         src/os/timer.c \
@@ -471,11 +504,6 @@ if test "$PHP_SWOOLE" != "no"; then
 
 	swoole_source_file="$swoole_source_file thirdparty/multipart_parser.c"
 
-    if test "$PHP_PICOHTTPPARSER" = "yes"; then
-        AC_DEFINE(SW_USE_PICOHTTPPARSER, 1, [enable picohttpparser support])
-        swoole_source_file="$swoole_source_file thirdparty/picohttpparser/picohttpparser.c"
-    fi
-
     PHP_NEW_EXTENSION(swoole, $swoole_source_file, $ext_shared)
 
     PHP_ADD_INCLUDE([$ext_srcdir])
@@ -483,11 +511,6 @@ if test "$PHP_SWOOLE" != "no"; then
 
     PHP_INSTALL_HEADERS([ext/swoole], [*.h config.h include/*.h])
 
-    if test "$PHP_PICOHTTPPARSER" = "yes"; then
-        PHP_ADD_INCLUDE([$ext_srcdir/thirdparty/picohttpparser])
-        PHP_ADD_BUILD_DIR($ext_builddir/thirdparty/picohttpparser)
-    fi
-
     PHP_ADD_BUILD_DIR($ext_builddir/src/core)
     PHP_ADD_BUILD_DIR($ext_builddir/src/memory)
     PHP_ADD_BUILD_DIR($ext_builddir/src/factory)
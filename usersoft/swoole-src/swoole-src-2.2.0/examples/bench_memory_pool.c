@@ -0,0 +1,162 @@
+/**
+ * cmake .
+ * make bench_memory_pool
+ * ./bin/bench_memory_pool [process_num] [rounds]
+ *
+ * every process runs rounds of: alloc 16 slices of 16~512 bytes, free them in order.
+ * A pool that runs out of space counts the failed allocations instead of stopping.
+ * FixedPool and RingBuffer have no locking of their own, their users (Table, Channel)
+ * hold a lock around them, so the benchmark does the same with a shared mutex.
+ */
+#include "swoole.h"
+
+#define BENCH_BATCH     16
+#define BENCH_MAX_SIZE  512
+
+typedef struct
+{
+    const char *name;
+    swMemoryPool *pool;
+    swLock *lock;
+    int no_free;
+    int round_div;
+} bench_pool;
+
+static void bench_run(bench_pool *bp, int process_num, int rounds);
+
+//alloc() returning NULL, counted across the processes
+static sw_atomic_t *alloc_failures;
+
+int main(int argc, char **argv)
+{
+    int process_num = argc > 1 ? atoi(argv[1]) : 4;
+    int rounds = argc > 2 ? atoi(argv[2]) : 100000;
+    swLock *lock = sw_shm_malloc(sizeof(swLock));
+    alloc_failures = sw_shm_calloc(1, sizeof(sw_atomic_t));
+
+    if (process_num <= 0 || rounds <= 0 || lock == NULL || alloc_failures == NULL || swMutex_create(lock, 1) < 0)
+    {
+        printf("usage: %s [process_num] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    size_t pool_size = (size_t) process_num * BENCH_BATCH * BENCH_MAX_SIZE * 8;
+    //MemoryGlobal pages added after fork() are private to one process, so it gets a single big page
+    size_t global_size = (size_t) process_num * (rounds / 100 + 1) * BENCH_BATCH * BENCH_MAX_SIZE + 4096;
+    bench_pool pools[] =
+    {
+        { "Malloc(process)", swMalloc_new(), NULL, 0, 1 },
+        { "FixedPool+lock", swFixedPool_new(process_num * BENCH_BATCH * 2, BENCH_MAX_SIZE, 1), lock, 0, 1 },
+        { "RingBuffer+lock", swRingBuffer_new(pool_size * 16, 1), lock, 0, 1 },
+        //alloc only, it never gives memory back
+        { "MemoryGlobal", swMemoryGlobal_new(global_size, 1), NULL, 1, 100 },
+        { "SlabPool", swSlabPool_new(pool_size + process_num * (1 << SW_SLAB_PAGE_SHIFT) * 8, 1), NULL, 0, 1 },
+    };
+
+    int i;
+    printf("%-18s %12s %10s %10s\n", "pool", "ops/sec", "ms", "failures");
+    for (i = 0; i < sizeof(pools) / sizeof(pools[0]); i++)
+    {
+        if (pools[i].pool == NULL)
+        {
+            printf("%-18s create failed\n", pools[i].name);
+            continue;
+        }
+        bench_run(&pools[i], process_num, rounds / pools[i].round_div);
+    }
+    return 0;
+}
+
+static void bench_worker(bench_pool *bp, int rounds, int seed)
+{
+    void *slices[BENCH_BATCH];
+    swMemoryPool *pool = bp->pool;
+    int i, j;
+
+    srand(seed);
+    for (i = 0; i < rounds; i++)
+    {
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            uint32_t size = 16 + rand() % (BENCH_MAX_SIZE - 16 + 1);
+            if (bp->lock)
+            {
+                bp->lock->lock(bp->lock);
+            }
+            slices[j] = pool->alloc(pool, size);
+            if (bp->lock)
+            {
+                bp->lock->unlock(bp->lock);
+            }
+            if (slices[j] == NULL)
+            {
+                sw_atomic_fetch_add(alloc_failures, 1);
+                continue;
+            }
+            *(uint32_t *) slices[j] = size;
+        }
+        if (bp->no_free)
+        {
+            continue;
+        }
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            if (slices[j] == NULL)
+            {
+                continue;
+            }
+            if (bp->lock)
+            {
+                bp->lock->lock(bp->lock);
+            }
+            pool->free(pool, slices[j]);
+            if (bp->lock)
+            {
+                bp->lock->unlock(bp->lock);
+            }
+        }
+    }
+}
+
+static void bench_run(bench_pool *bp, int process_num, int rounds)
+{
+    int i, status, failed = 0;
+    pid_t pid;
+    struct timeval start, end;
+
+    *alloc_failures = 0;
+    fflush(stdout);
+    gettimeofday(&start, NULL);
+    for (i = 0; i < process_num; i++)
+    {
+        pid = fork();
+        if (pid < 0)
+        {
+            swSysError("fork() failed.");
+            exit(1);
+        }
+        else if (pid == 0)
+        {
+            bench_worker(bp, rounds, i + 1);
+            exit(0);
+        }
+    }
+    for (i = 0; i < process_num; i++)
+    {
+        if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            failed = 1;
+        }
+    }
+    gettimeofday(&end, NULL);
+    if (failed)
+    {
+        printf("%-18s worker failed\n", bp->name);
+        return;
+    }
+
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+    //alloc and free each count as one operation
+    double ops = (double) process_num * rounds * BENCH_BATCH * (bp->no_free ? 1 : 2);
+    printf("%-18s %12.0f %10.1f %10d\n", bp->name, ops / (ms / 1000), ms, (int) *alloc_failures);
+}
@@ -64,6 +64,13 @@ int swConnection_onSendfile(swConnection *conn, swBuffer_trunk *chunk);
 void swConnection_sendfile_destructor(swBuffer_trunk *chunk);
 char* swConnection_get_ip(swConnection *conn);
 int swConnection_get_port(swConnection *conn);
+swConnection_ext* swConnection_get_ext(swConnection *conn);
+void swConnection_free_ext(swConnection *conn);
+#ifdef HAVE_MSG_ZEROCOPY
+int swConnection_zerocopy_reap(swConnection *conn);
+int swConnection_zerocopy_onError(swReactor *reactor, swConnection *conn);
+void swConnection_zerocopy_free(swConnection *conn);
+#endif
 
 #ifdef SW_USE_OPENSSL
 enum swSSLState
@@ -107,16 +114,59 @@ typedef struct
     uint32_t session_tickets :1;
     uint32_t stapling :1;
     uint32_t stapling_verify :1;
+    /**
+     * kernel TLS, SSL_sendfile() works when the kernel takes over the encryption
+     */
+    uint32_t ktls :1;
     char *ciphers;
     char *ecdh_curve;
-    char *session_cache;
     char *dhparam;
+    /**
+     * number of sessions kept in the shared memory cache, 0 disables it
+     */
+    uint32_t session_cache_size;
+    uint32_t session_timeout;
+    uint32_t ticket_key_lifetime;
 } swSSL_config;
 
+typedef struct
+{
+    uchar name[16];
+    uchar hmac_key[16];
+    uchar aes_key[16];
+} swSSL_ticket_key;
+
+typedef struct
+{
+    uint8_t id_length;
+    uchar id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    uint16_t length;
+    time_t expire;
+    uchar data[SW_SSL_SESSION_MAX_SIZE];
+} swSSL_session;
+
+/**
+ * shared by the reactor threads and all processes of the server, allocated before fork
+ */
+typedef struct
+{
+    swLock lock;
+    uint32_t size;
+    uint32_t ticket_key_lifetime;
+    time_t ticket_key_time;
+    /**
+     * ticket_keys[0] encrypts new tickets, ticket_keys[1] still decrypts the tickets issued before the last rotation
+     */
+    swSSL_ticket_key ticket_keys[2];
+    swSSL_session sessions[0];
+} swSSL_session_cache;
+
 void swSSL_init(void);
 void swSSL_init_thread_safety();
 int swSSL_server_set_cipher(SSL_CTX* ssl_context, swSSL_config *cfg);
 void swSSL_server_http_advise(SSL_CTX* ssl_context, swSSL_config *cfg);
+int swSSL_server_set_session_cache(SSL_CTX* ssl_context, swSSL_config *cfg);
+void swSSL_rotate_ticket_keys(SSL_CTX* ssl_context, int force);
 SSL_CTX* swSSL_get_context(swSSL_option *option);
 void swSSL_free_context(SSL_CTX* ssl_context);
 int swSSL_create(swConnection *conn, SSL_CTX* ssl_context, int flags);
@@ -253,6 +303,18 @@ static sw_inline int swConnection_error(int err)
 	}
 }
 
+/**
+ * the kernel may still read from chunks sent with MSG_ZEROCOPY
+ */
+static sw_inline int swConnection_zerocopy_pending(swConnection *conn)
+{
+#ifdef HAVE_MSG_ZEROCOPY
+    return conn->ext && conn->ext->zerocopy_next != conn->ext->zerocopy_done;
+#else
+    return 0;
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif
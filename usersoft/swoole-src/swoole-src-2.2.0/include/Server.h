@@ -73,6 +73,7 @@ enum swIPCType
     SW_IPC_UNIXSOCK = 1,
     SW_IPC_MSGQUEUE = 2,
     SW_IPC_SOCKET   = 3,
+    SW_IPC_SHMQUEUE = 4,
 };
 
 enum swTaskIPCMode
@@ -81,6 +82,7 @@ enum swTaskIPCMode
     SW_TASK_IPC_MSGQUEUE    = 2,
     SW_TASK_IPC_PREEMPTIVE  = 3,
     SW_TASK_IPC_STREAM      = 4,
+    SW_TASK_IPC_SHMQUEUE    = 5,
 };
 
 enum swCloseType
@@ -115,6 +117,7 @@ enum swTaskType
     SW_TASK_CALLBACK   = 8,  //callback
     SW_TASK_WAITALL    = 16, //for taskWaitAll
     SW_TASK_COROUTINE  = 32, //coroutine
+    SW_TASK_BATCH      = 64, //several tasks in one message
 };
 
 typedef struct _swUdpFd
@@ -134,6 +137,11 @@ typedef struct _swReactorThread
 #endif
     swLock lock;
     int notify_pipe;
+    /**
+     * eventfd of the worker response rings, ring_notified is set while a wakeup is pending
+     */
+    swPipe ring_notify;
+    sw_atomic_t ring_notified;
 } swReactorThread;
 
 typedef struct _swListenPort
@@ -206,6 +214,10 @@ typedef struct _swListenPort
      * open tcp nopush option(for sendfile)
      */
     uint32_t open_tcp_nopush :1;
+    /**
+     * send large responses with MSG_ZEROCOPY
+     */
+    uint32_t send_zerocopy :1;
     /**
      * open tcp keepalive
      */
@@ -414,6 +426,10 @@ struct _swServer
      * oepn cpu affinity setting
      */
     uint32_t open_cpu_affinity :1;
+    /**
+     * group reactor threads and workers per NUMA node
+     */
+    uint32_t numa_affinity :1;
     /**
      * Udisable notice when use SW_DISPATCH_ROUND and SW_DISPATCH_QUEUE
      */
@@ -430,6 +446,10 @@ struct _swServer
      * handle static files
      */
     uint32_t enable_static_handler :1;
+    /**
+     * serve the .br/.gz sibling of a static file when the client accepts it
+     */
+    uint32_t static_handler_precompressed :1;
     /**
      * enable onConnect/onClose event when use dispatch_mode=1/3
      */
@@ -450,6 +470,10 @@ struct _swServer
      * yield coroutine when the output buffer is full
      */
     uint32_t send_yield :1;
+    /**
+     * per worker latency histograms
+     */
+    uint32_t latency_stats :1;
 
     /**
      *  heartbeat check time
@@ -457,8 +481,18 @@ struct _swServer
     uint16_t heartbeat_idle_time;
     uint16_t heartbeat_check_interval;
 
+    /**
+     * prometheus text endpoint of the latency histograms, 0 means off
+     */
+    char *stats_host;
+    uint16_t stats_port;
+
     int *cpu_affinity_available;
     int cpu_affinity_available_num;
+    /**
+     * NUMA nodes in use, 0 when numa_affinity is off or the machine has a single node
+     */
+    uint16_t numa_node_num;
     
     double send_timeout;
 
@@ -470,6 +504,12 @@ struct _swServer
     uint32_t buffer_output_size;
     uint32_t buffer_input_size;
 
+    /**
+     * worker responses go through a shared memory ring per worker and reactor thread instead of the pipes
+     */
+    uint32_t ipc_ring_size;
+    swRingChannel **response_rings;
+
     void *ptr2;
     void *private_data_3;
 
@@ -499,12 +539,21 @@ struct _swServer
      * temporary directory for HTTP uploaded file.
      */
     char *upload_tmp_dir;
+    /**
+     * response bodies shorter than this are not compressed
+     */
+    uint32_t http_compression_min_length;
 
     /**
      * http static file directory
      */
     char *document_root;
     uint16_t document_root_len;
+    /**
+     * static files up to this size are kept in memory by each reactor, 0 disables the cache
+     */
+    uint32_t static_handler_cache_size;
+    uint32_t static_handler_cache_expire;
 
     /**
      * master process pid
@@ -587,6 +636,10 @@ typedef struct _swPackage
 typedef struct
 {
     int length;
+    /**
+     * in SwooleG.task_shm_pool when set, mapped at the same address in every process
+     */
+    void *shm_data;
     char tmpfile[SW_TASK_TMPDIR_SIZE + sizeof(SW_TASK_TMP_FILE)];
 } swPackage_task;
 
@@ -703,6 +756,9 @@ void swServer_store_listen_socket(swServer *serv);
 int swServer_get_manager_pid(swServer *serv);
 int swServer_get_socket(swServer *serv, int port);
 int swServer_worker_init(swServer *serv, swWorker *worker);
+#ifdef HAVE_CPU_AFFINITY
+int swServer_numa_cpu_set(swServer *serv, int id, cpu_set_t *set);
+#endif
 swString** swServer_create_worker_buffer(swServer *serv);
 int swServer_create_task_worker(swServer *serv);
 void swServer_close_listen_port(swServer *serv);
@@ -715,6 +771,7 @@ int swTaskWorker_onFinish(swReactor *reactor, swEvent *event);
 void swTaskWorker_onStart(swProcessPool *pool, int worker_id);
 void swTaskWorker_onStop(swProcessPool *pool, int worker_id);
 int swTaskWorker_large_pack(swEventData *task, void *data, int data_len);
+int swTaskWorker_batch_dispatch(swString *batch, int blocking);
 int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags);
 
 #define swTask_type(task)                  ((task)->info.from_fd)
@@ -724,15 +781,22 @@ static sw_inline swString* swTaskWorker_large_unpack(swEventData *task_result)
     swPackage_task _pkg;
     memcpy(&_pkg, task_result->data, sizeof(_pkg));
 
-    int tmp_file_fd = open(_pkg.tmpfile, O_RDONLY);
-    if (tmp_file_fd < 0)
+    if (SwooleG.module_stack->size < _pkg.length && swString_extend_align(SwooleG.module_stack, _pkg.length) < 0)
     {
-        swSysError("open(%s) failed.", _pkg.tmpfile);
         return NULL;
     }
-    if (SwooleG.module_stack->size < _pkg.length && swString_extend_align(SwooleG.module_stack, _pkg.length) < 0)
+    if (_pkg.shm_data)
     {
-        close(tmp_file_fd);
+        memcpy(SwooleG.module_stack->str, _pkg.shm_data, _pkg.length);
+        SwooleG.task_shm_pool->free(SwooleG.task_shm_pool, _pkg.shm_data);
+        SwooleG.module_stack->length = _pkg.length;
+        return SwooleG.module_stack;
+    }
+
+    int tmp_file_fd = open(_pkg.tmpfile, O_RDONLY);
+    if (tmp_file_fd < 0)
+    {
+        swSysError("open(%s) failed.", _pkg.tmpfile);
         return NULL;
     }
     if (swoole_sync_readfile(tmp_file_fd, SwooleG.module_stack->str, _pkg.length) < 0)
@@ -756,6 +820,19 @@ static sw_inline swString* swTaskWorker_large_unpack(swEventData *task_result)
 //使用connection_list[0]表示最大的FD
 #define swServer_set_maxfd(serv,maxfd) (serv->connection_list[SW_SERVER_MAX_FD_INDEX].fd=maxfd)
 #define swServer_get_maxfd(serv) (serv->connection_list[SW_SERVER_MAX_FD_INDEX].fd)
+
+/**
+ * In base mode every worker polls the same listen sockets. Without SO_REUSEPORT, register them exclusively
+ * so that a new connection wakes up one worker instead of all of them.
+ */
+static sw_inline int swServer_listen_fdtype(swServer *serv)
+{
+    if (serv->factory_mode == SW_MODE_SINGLE && !SwooleG.reuse_port)
+    {
+        return SW_FD_LISTEN | SW_EVENT_READ | SW_EVENT_EXCLUSIVE;
+    }
+    return SW_FD_LISTEN;
+}
 //使用connection_list[1]表示最小的FD
 #define swServer_set_minfd(serv,maxfd) (serv->connection_list[SW_SERVER_MIN_FD_INDEX].fd=maxfd)
 #define swServer_get_minfd(serv) (serv->connection_list[SW_SERVER_MIN_FD_INDEX].fd)
@@ -809,6 +886,47 @@ static sw_inline swWorker* swServer_get_worker(swServer *serv, uint16_t worker_i
     return NULL;
 }
 
+/**
+ * events which carry client data, counted in swWorker.dispatch_count
+ */
+static sw_inline int swServer_is_request_event(int type)
+{
+    switch (type)
+    {
+    case SW_EVENT_TCP:
+    case SW_EVENT_PACKAGE:
+    case SW_EVENT_PACKAGE_END:
+    case SW_EVENT_UDP:
+    case SW_EVENT_UDP6:
+    case SW_EVENT_UNIX_DGRAM:
+        return SW_TRUE;
+    default:
+        return SW_FALSE;
+    }
+}
+
+/**
+ * reactor thread r and worker w are on NUMA node r % numa_node_num and w % numa_node_num
+ */
+static sw_inline int swServer_numa_local(swServer *serv)
+{
+    return serv->numa_node_num > 1 && SwooleTG.type == SW_THREAD_REACTOR;
+}
+
+static sw_inline uint32_t swServer_numa_worker_count(swServer *serv)
+{
+    uint32_t node = SwooleTG.id % serv->numa_node_num;
+    return (serv->worker_num - node + serv->numa_node_num - 1) / serv->numa_node_num;
+}
+
+/**
+ * the index-th worker on the node of the calling reactor thread
+ */
+static sw_inline int swServer_numa_worker(swServer *serv, uint32_t index)
+{
+    return (index % swServer_numa_worker_count(serv)) * serv->numa_node_num + SwooleTG.id % serv->numa_node_num;
+}
+
 static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventData *data)
 {
     uint32_t key;
@@ -817,11 +935,19 @@ static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventDat
     if (serv->dispatch_mode == SW_DISPATCH_ROUND)
     {
         key = sw_atomic_fetch_add(&serv->worker_round_id, 1);
+        if (swServer_numa_local(serv))
+        {
+            return swServer_numa_worker(serv, key);
+        }
     }
-    //Using the FD touch access to hash
+    //Using the FD touch access to hash, a fd always stays on the same reactor thread
     else if (serv->dispatch_mode == SW_DISPATCH_FDMOD)
     {
         key = fd;
+        if (swServer_numa_local(serv))
+        {
+            return swServer_numa_worker(serv, key);
+        }
     }
     //Using the IP touch access to hash
     else if (serv->dispatch_mode == SW_DISPATCH_IPMOD)
@@ -864,6 +990,24 @@ static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventDat
     {
         return serv->dispatch_func(serv, swServer_connection_get(serv, fd), data);
     }
+    //the less loaded of two sampled workers
+    else if (serv->dispatch_mode == SW_DISPATCH_LEAST_LOADED)
+    {
+        uint32_t worker_num = swServer_numa_local(serv) ? swServer_numa_worker_count(serv) : serv->worker_num;
+        if (worker_num == 1)
+        {
+            return swServer_numa_local(serv) ? swServer_numa_worker(serv, 0) : 0;
+        }
+        uint32_t r = sw_atomic_fetch_add(&serv->worker_round_id, 1) * 2654435761u;
+        uint32_t a = r % worker_num;
+        uint32_t b = (a + 1 + (r >> 16) % (worker_num - 1)) % worker_num;
+        if (swServer_numa_local(serv))
+        {
+            a = swServer_numa_worker(serv, a);
+            b = swServer_numa_worker(serv, b);
+        }
+        return serv->workers[b].dispatch_count < serv->workers[a].dispatch_count ? b : a;
+    }
     //Preemptive distribution
     else
     {
@@ -872,6 +1016,10 @@ static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventDat
         for (i = 0; i < serv->worker_num + 1; i++)
         {
             key = sw_atomic_fetch_add(&serv->worker_round_id, 1) % serv->worker_num;
+            if (swServer_numa_local(serv))
+            {
+                key = swServer_numa_worker(serv, key);
+            }
             if (serv->workers[key].status == SW_WORKER_IDLE)
             {
                 found = 1;
@@ -990,6 +1138,7 @@ static sw_inline int swWorker_get_send_pipe(swServer *serv, int session_id, int
 }
 
 int swReactorThread_create(swServer *serv);
+int swReactorThread_create_rings(swServer *serv);
 int swReactorThread_start(swServer *serv, swReactor *main_reactor_ptr);
 void swReactorThread_set_protocol(swServer *serv, swReactor *reactor);
 void swReactorThread_free(swServer *serv);
@@ -998,6 +1147,7 @@ int swReactorThread_onClose(swReactor *reactor, swEvent *event);
 int swReactorThread_dispatch(swConnection *conn, char *data, uint32_t length);
 int swReactorThread_send(swSendData *_send);
 int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id);
+void swServer_stats_prometheus(swServer *serv, swString *buffer);
 
 int swReactorProcess_create(swServer *serv);
 int swReactorProcess_start(swServer *serv);
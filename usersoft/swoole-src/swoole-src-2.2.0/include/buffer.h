@@ -34,6 +34,10 @@ typedef struct _swBuffer_trunk
     uint32_t type;
     uint32_t length;
     uint32_t offset;
+    /**
+     * id of the last MSG_ZEROCOPY send from this chunk
+     */
+    uint32_t zerocopy_id;
     union
     {
         void *ptr;
@@ -44,6 +48,7 @@ typedef struct _swBuffer_trunk
         } data;
     } store;
     uint32_t size;
+    uint32_t zerocopy;
     void (*destroy)(struct _swBuffer_trunk *chunk);
     struct _swBuffer_trunk *next;
 } swBuffer_trunk;
@@ -52,6 +57,10 @@ typedef struct _swBuffer
 {
     int fd;
     uint8_t trunk_num; //trunk数量
+    /**
+     * small writes are appended to the tail chunk, only for stream sockets
+     */
+    uint8_t coalesce;
     uint16_t trunk_size;
     uint32_t length;
     swBuffer_trunk *head;
@@ -64,6 +73,7 @@ typedef struct _swBuffer
 swBuffer* swBuffer_new(int trunk_size);
 swBuffer_trunk *swBuffer_new_trunk(swBuffer *buffer, uint32_t type, uint32_t size);
 void swBuffer_pop_trunk(swBuffer *buffer, swBuffer_trunk *trunk);
+void swBuffer_free_trunk(swBuffer_trunk *trunk);
 int swBuffer_append(swBuffer *buffer, void *data, uint32_t size);
 
 void swBuffer_debug(swBuffer *buffer, int print_data);
@@ -64,7 +64,43 @@ typedef struct _swHttpRequest
 
 } swHttpRequest;
 
+enum swHttpHeaderId
+{
+    SW_HTTP_HEADER_UNKNOWN = 0,
+    SW_HTTP_HEADER_COOKIE,
+    SW_HTTP_HEADER_UPGRADE,
+    SW_HTTP_HEADER_CONNECTION,
+    SW_HTTP_HEADER_CONTENT_TYPE,
+    SW_HTTP_HEADER_CONTENT_LENGTH,
+    SW_HTTP_HEADER_TRANSFER_ENCODING,
+    SW_HTTP_HEADER_ACCEPT_ENCODING,
+};
+
+typedef struct
+{
+    const char *name;
+    const char *value;
+    uint32_t name_len;
+    uint32_t value_len;
+    uint8_t id;
+} swHttpHeader;
+
+/**
+ * request line and headers of a complete request head, all pointers refer to the parsed buffer
+ */
+typedef struct
+{
+    uint8_t method;
+    uint8_t minor_version;
+    const char *path;
+    uint32_t path_len;
+    uint32_t num_headers;
+    swHttpHeader headers[SW_HTTP_FAST_PARSE_HEADER_NUM];
+} swHttpRequestHead;
+
 int swHttp_get_method(const char *method_str, int method_len);
+int swHttp_get_header_id(const char *name, int name_len);
+int swHttpRequest_parse_head(const char *buf, size_t length, swHttpRequestHead *head);
 const char* swHttp_get_method_string(int method);
 int swHttpRequest_get_protocol(swHttpRequest *request);
 int swHttpRequest_get_content_length(swHttpRequest *request);
@@ -124,6 +124,14 @@ typedef unsigned long ulong_t;
 #define CLOCK_REALTIME 0
 #endif
 
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define HAVE_MSG_ZEROCOPY 1
+#endif
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define HAVE_MMSG 1
+#endif
+
 #if !defined(__GNUC__) || __GNUC__ < 3
 #define __builtin_expect(x, expected_value) (x)
 #endif
@@ -242,9 +250,11 @@ enum swFd_type
     SW_FD_WRITE           = 7, //fd can write
     SW_FD_TIMER           = 8, //timer fd
     SW_FD_AIO             = 9, //linux native aio
+    SW_FD_RING            = 10, //worker response ring
     SW_FD_SIGNAL          = 11, //signalfd
     SW_FD_DNS_RESOLVER    = 12, //dns resolver
     SW_FD_INOTIFY         = 13, //server socket
+    SW_FD_AIO_THREAD      = 14, //aio thread pool
     SW_FD_USER            = 15, //SW_FD_USER or SW_FD_USER+n: for custom event
     SW_FD_STREAM_CLIENT   = 16, //swClient stream
     SW_FD_DGRAM_CLIENT    = 17, //swClient dgram
@@ -263,6 +273,10 @@ enum swEvent_type
     SW_EVENT_WRITE = 1u << 10,
     SW_EVENT_ERROR = 1u << 11,
     SW_EVENT_ONCE = 1u << 12,
+    /**
+     * wake up only one of the reactors waiting on this fd (EPOLLEXCLUSIVE)
+     */
+    SW_EVENT_EXCLUSIVE = 1u << 13,
 };
 
 enum swPipe_type
@@ -275,6 +289,14 @@ enum swGlobal_hook_type
 {
     SW_GLOBAL_HOOK_BEFORE_SERVER_START,
     SW_GLOBAL_HOOK_BEFORE_CLIENT_START,
+    /**
+     * coroutine switches, for profilers which keep a call stack per coroutine.
+     * The argument is a pointer to the int cid of the coroutine.
+     */
+    SW_GLOBAL_HOOK_ON_CORO_CREATE,
+    SW_GLOBAL_HOOK_ON_CORO_RESUME,
+    SW_GLOBAL_HOOK_ON_CORO_YIELD,
+    SW_GLOBAL_HOOK_ON_CORO_CLOSE,
 };
 
 //-------------------------------------------------------------------------------
@@ -317,6 +339,7 @@ enum swFactory_dispatch_mode
     SW_DISPATCH_UIDMOD   = 5,
     SW_DISPATCH_USERFUNC = 6,
     SW_DISPATCH_STREAM   = 7,
+    SW_DISPATCH_LEAST_LOADED = 8,
 };
 
 enum swWorker_status
@@ -475,6 +498,40 @@ typedef struct
     socklen_t len;
 } swSocketAddress;
 
+/**
+ * cold per-connection state, allocated on first use by swConnection_get_ext()
+ * and released when the reactor closes the socket.
+ */
+typedef struct _swConnection_ext
+{
+    /**
+     * unfinished websocket data frame
+     */
+    swString *websocket_buffer;
+
+#ifdef HAVE_MSG_ZEROCOPY
+    /**
+     * id of the next MSG_ZEROCOPY send. ids below zerocopy_done are completed,
+     * bit n of zerocopy_mask is set when id zerocopy_done + n is completed.
+     */
+    uint32_t zerocopy_next;
+    uint32_t zerocopy_done;
+    uint64_t zerocopy_mask;
+    /**
+     * sent chunks which the kernel may still read from
+     */
+    struct _swBuffer_trunk *zerocopy_head;
+    struct _swBuffer_trunk *zerocopy_tail;
+#endif
+
+} swConnection_ext;
+
+/**
+ * the fields touched on every event come first and fit in the first cache lines,
+ * the socket address and the ssl state follow, rarely used state lives in ext.
+ * The flags stay byte-sized: the reactor threads and the heartbeat thread write
+ * different flags of the same connection concurrently.
+ */
 typedef struct _swConnection
 {
     /**
@@ -541,6 +598,14 @@ typedef struct _swConnection
     //--------------------------------------------------------------
     uint8_t close_notify;
     uint8_t close_force;
+    /**
+     * SO_ZEROCOPY is enabled, large chunks are sent with MSG_ZEROCOPY
+     */
+    uint8_t zerocopy;
+    /**
+     * upgarde websocket
+     */
+    uint8_t websocket_status;
     //--------------------------------------------------------------
     /**
      * ReactorThread id
@@ -553,14 +618,14 @@ typedef struct _swConnection
     uint16_t close_errno;
 
     /**
-     * from which socket fd
+     * event worker that sent last (worker_id + 1, 0 if none), receives the watermark events
      */
-    sw_atomic_t from_fd;
+    uint16_t send_worker_id;
 
     /**
-     * socket address
+     * from which socket fd
      */
-    swSocketAddress info;
+    sw_atomic_t from_fd;
 
     /**
      * link any thing, for kernel, do not use with application.
@@ -582,6 +647,11 @@ typedef struct _swConnection
      */
     swString *recv_buffer;
 
+    /**
+     * rarely used state, NULL until needed
+     */
+    swConnection_ext *ext;
+
     /**
      * connect time(seconds)
      */
@@ -592,10 +662,6 @@ typedef struct _swConnection
      */
     time_t last_time;
 
-#ifdef SW_USE_TIMEWHEEL
-    uint16_t timewheel_index;
-#endif
-
     /**
      * bind uid
      */
@@ -606,22 +672,33 @@ typedef struct _swConnection
      */
     int buffer_size;
 
-    /**
-     * upgarde websocket
-     */
-    uint8_t websocket_status;
+    sw_atomic_t lock;
+
+#ifdef SW_USE_OPENSSL
+    uint32_t ssl_state;
+    SSL *ssl;
+#endif
 
     /**
-     * unfinished data frame
+     * socket address
      */
-    swString *websocket_buffer;
+    swSocketAddress info;
 
 #ifdef SW_USE_OPENSSL
-    SSL *ssl;
-    uint32_t ssl_state;
+    /**
+     * written by the worker process which handles the connection
+     */
     swString ssl_client_cert;
 #endif
-    sw_atomic_t lock;
+
+#ifdef SW_USE_TIMEWHEEL
+    uint16_t timewheel_index;
+    /**
+     * list of the timewheel slot
+     */
+    struct _swConnection *timewheel_prev;
+    struct _swConnection *timewheel_next;
+#endif
 
 #ifdef SW_DEBUG
     size_t total_recv_bytes;
@@ -732,6 +809,10 @@ typedef struct _swDataHead
     uint8_t type;
     uint8_t flags;
     uint16_t from_fd;
+    /**
+     * dispatch time (microseconds, wraps around), only set with latency_stats
+     */
+    uint32_t time;
 } swDataHead;
 
 typedef struct _swEvent
@@ -786,8 +867,16 @@ typedef struct
 {
     uint16_t current;
     uint16_t size;
-    swHashMap **wheel;
-
+    /**
+     * head of the connection list of each slot
+     */
+    struct _swConnection **wheel;
+#ifdef SW_DEBUG
+    /**
+     * fd => connection of each slot, checked against the lists
+     */
+    swHashMap **sets;
+#endif
 } swTimeWheel;
 
 typedef void * (*swThreadStartFunc)(void *);
@@ -1053,6 +1142,11 @@ swMemoryPool *swRingBuffer_new(uint32_t size, uint8_t shared);
  */
 swMemoryPool* swMemoryGlobal_new(uint32_t pagesize, uint8_t shared);
 
+/**
+ * SlabPool, power-of-two size classes up to SW_SLAB_PAGE_SIZE with per-thread caches
+ */
+swMemoryPool* swSlabPool_new(size_t size, uint8_t shared);
+
 void swFixedPool_debug(swMemoryPool *pool);
 
 /**
@@ -1063,6 +1157,7 @@ void sw_shm_free(void *ptr);
 void* sw_shm_calloc(size_t num, size_t _size);
 int sw_shm_protect(void *addr, int flags);
 void* sw_shm_realloc(void *ptr, size_t new_size);
+int sw_shm_bind_node(void *ptr, int node);
 #ifdef HAVE_RWLOCK
 int swRWLock_create(swLock *lock, int use_in_process);
 #endif
@@ -1299,8 +1394,20 @@ void swoole_init(void);
 void swoole_clean(void);
 void swoole_update_time(void);
 double swoole_microtime(void);
+
+static sw_inline uint64_t swoole_monotonic_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 void swoole_rtrim(char *str, int len);
 void swoole_redirect_stdout(int new_fd);
+#if defined(HAVE_CPU_AFFINITY) && defined(__linux__)
+int swoole_numa_node_num(void);
+int swoole_numa_node_cpus(int node, cpu_set_t *set);
+int swoole_numa_bind(void *addr, size_t size, int node);
+#endif
 int swoole_shell_exec(char *command, pid_t *pid);
 SW_API int swoole_add_function(const char *name, void* func);
 SW_API void* swoole_get_function(char *name, uint32_t length);
@@ -1348,6 +1455,8 @@ int swSocket_set_buffer_size(int fd, int buffer_size);
 int swSocket_udp_sendto(int server_sock, char *dst_ip, int dst_port, char *data, uint32_t len);
 int swSocket_udp_sendto6(int server_sock, char *dst_ip, int dst_port, char *data, uint32_t len);
 int swSocket_unix_sendto(int server_sock, char *dst_path, char *data, uint32_t len);
+int swSocket_udp_sendto_multi(int server_sock, int ipv6, char *dst_ip, int dst_port, struct iovec *packets, int n);
+int swSocket_sendto_multi(int fd, struct iovec *packets, int n, struct sockaddr *__addr, socklen_t __addr_len);
 int swSocket_sendfile_sync(int sock, char *filename, off_t offset, size_t length, double timeout);
 int swSocket_write_blocking(int __fd, void *__data, int __len);
 int swSocket_recv_blocking(int fd, void *__data, size_t __len, int flags);
@@ -1410,6 +1519,22 @@ typedef struct _swDefer_callback
     void *data;
 } swDefer_callback;
 
+//------------------Histogram--------------------
+/**
+ * log-linear buckets (4 per power of 2) of microseconds, lives in shared memory and is written without lock
+ */
+#define SW_HISTOGRAM_BUCKETS   128
+
+typedef struct _swHistogram
+{
+    sw_atomic_t count[SW_HISTOGRAM_BUCKETS];
+    sw_atomic_ulong_t sum;
+} swHistogram;
+
+void swHistogram_record(swHistogram *h, uint64_t usec);
+uint64_t swHistogram_bucket_max(int index);
+uint64_t swHistogram_percentile(swHistogram *h, double percent, uint64_t *total);
+
 struct _swReactor
 {
     void *object;
@@ -1450,6 +1575,12 @@ struct _swReactor
 
     uint32_t max_socket;
 
+    /**
+     * time spent in wait() and in handling one round of events, NULL means off
+     */
+    swHistogram *wait_histogram;
+    swHistogram *loop_histogram;
+
 #ifdef SW_USE_MALLOC_TRIM
     time_t last_malloc_trim_time;
 #endif
@@ -1551,12 +1682,24 @@ struct _swWorker
      * tasking num
      */
     sw_atomic_t tasking_num;
+    /**
+     * requests dispatched to this worker and not yet handled, for SW_DISPATCH_LEAST_LOADED
+     */
+    sw_atomic_t dispatch_count;
 
     time_t start_time;
     time_t request_time;
 
     long request_count;
 
+    /**
+     * latency_stats: handling time, time in the pipe, reactor wait and reactor round
+     */
+    swHistogram request_histogram;
+    swHistogram queue_histogram;
+    swHistogram wait_histogram;
+    swHistogram loop_histogram;
+
 	/**
 	 * worker id
 	 */
@@ -1584,6 +1727,18 @@ typedef struct
     swString *response_buffer;
 } swStreamInfo;
 
+/**
+ * per-worker task queue in shared memory, idle workers steal from the others
+ */
+typedef struct _swProcessPool_queue
+{
+    swLock lock;
+    uint32_t head;
+    uint32_t tail;
+    sw_atomic_t num;
+    swEventData slots[SW_TASK_QUEUE_SIZE];
+} swProcessPool_queue;
+
 struct _swProcessPool
 {
     /**
@@ -1615,6 +1770,11 @@ struct _swProcessPool
      */
     uint8_t use_socket;
 
+    /**
+     * use shared memory queues IPC
+     */
+    uint8_t use_shmqueue;
+
     char *packet_buffer;
     uint32_t max_packet_size;
 
@@ -1645,6 +1805,8 @@ struct _swProcessPool
     swReactor *reactor;
     swMsgQueue *queue;
     swStreamInfo *stream;
+    swProcessPool_queue *shm_queues;
+    swPipe *shm_notify;
 
     void *ptr;
     void *ptr2;
@@ -1683,7 +1845,7 @@ static sw_inline int swReactor_event_error(int fdtype)
 
 static sw_inline int swReactor_fdtype(int fdtype)
 {
-    return fdtype & (~SW_EVENT_READ) & (~SW_EVENT_WRITE) & (~SW_EVENT_ERROR);
+    return fdtype & (~SW_EVENT_READ) & (~SW_EVENT_WRITE) & (~SW_EVENT_ERROR) & (~SW_EVENT_EXCLUSIVE);
 }
 
 static sw_inline int swReactor_events(int fdtype)
@@ -1806,6 +1968,7 @@ static sw_inline swReactor_handle swReactor_getHandle(swReactor *reactor, int ev
 }
 
 int swReactorEpoll_create(swReactor *reactor, int max_event_num);
+int swReactorIOUring_create(swReactor *reactor, int max_event_num);
 int swReactorPoll_create(swReactor *reactor, int max_event_num);
 int swReactorKqueue_create(swReactor *reactor, int max_event_num);
 int swReactorSelect_create(swReactor *reactor);
@@ -1822,6 +1985,7 @@ pid_t swProcessPool_spawn(swWorker *worker);
 int swProcessPool_dispatch(swProcessPool *pool, swEventData *data, int *worker_id);
 int swProcessPool_response(swProcessPool *pool, char *data, int length);
 int swProcessPool_dispatch_blocking(swProcessPool *pool, swEventData *data, int *dst_worker_id);
+int swProcessPool_queue_push(swProcessPool *pool, int worker_index, swEventData *data, int blocking);
 int swProcessPool_add_worker(swProcessPool *pool, swWorker *worker);
 int swProcessPool_del_worker(swProcessPool *pool, swWorker *worker);
 
@@ -1873,6 +2037,55 @@ int swChannel_notify(swChannel *object);
 void swChannel_free(swChannel *object);
 void swChannel_print(swChannel *);
 
+/**
+ * lock-free channel for exactly one producer and one consumer, the consumer reads items in place
+ */
+typedef struct _swRingChannel
+{
+    /**
+     * head is only written by the consumer and tail only by the producer,
+     * keep them on different cache lines
+     */
+    sw_atomic_t head;
+    char _pad0[64 - sizeof(sw_atomic_t)];
+    sw_atomic_t tail;
+    char _pad1[64 - sizeof(sw_atomic_t)];
+    uint32_t size;
+    int flag;
+    char mem[0];
+} swRingChannel;
+
+swRingChannel* swRingChannel_new(size_t size, int flag);
+int swRingChannel_push(swRingChannel *object, void *in, int data_length);
+void* swRingChannel_front(swRingChannel *object, int *data_length);
+void swRingChannel_pop(swRingChannel *object);
+void swRingChannel_free(swRingChannel *object);
+
+/**
+ * lock-free bounded channel for any number of producers and consumers (Vyukov),
+ * an item takes one or more fixed size cells, each cell carries its own sequence number
+ */
+typedef struct _swMpmcChannel
+{
+    sw_atomic_ulong_t head;
+    char _pad0[64 - sizeof(sw_atomic_ulong_t)];
+    sw_atomic_ulong_t tail;
+    char _pad1[64 - sizeof(sw_atomic_ulong_t)];
+    sw_atomic_long_t num;
+    sw_atomic_long_t bytes;
+    uint32_t cell_num;
+    uint32_t cell_size;
+    int flag;
+    char mem[0];
+} swMpmcChannel;
+
+swMpmcChannel* swMpmcChannel_new(size_t size, uint32_t cell_size, int flag);
+int swMpmcChannel_push(swMpmcChannel *object, void *in, int data_length);
+int swMpmcChannel_pop(swMpmcChannel *object, void *out, int buffer_length);
+int swMpmcChannel_push_batch(swMpmcChannel *object, void **in, int *lengths, int n);
+int swMpmcChannel_pop_batch(swMpmcChannel *object, void *out, int buffer_length, int *lengths, int n);
+void swMpmcChannel_free(swMpmcChannel *object);
+
 /*----------------------------LinkedList-------------------------------*/
 swLinkedList* swLinkedList_new(uint8_t type, swDestructor dtor);
 int swLinkedList_append(swLinkedList *ll, void *data);
@@ -1946,6 +2159,12 @@ typedef void (*swTimerCallback)(swTimer *, swTimer_node *);
 struct _swTimer_node
 {
     swHeap_node *heap_node;
+    /**
+     * timing wheel: list of the slot the node is in
+     */
+    struct _swTimer_node *prev;
+    struct _swTimer_node *next;
+    struct _swTimer_node **slot;
     void *data;
     swTimerCallback callback;
     int64_t exec_msec;
@@ -1962,10 +2181,32 @@ enum swTimer_type
     SW_TIMER_TYPE_PHP,
 };
 
+/**
+ * hierarchical timing wheel, 1ms ticks: level 0 holds the next 256ms,
+ * each level above covers 256 times the span of the one below
+ */
+#define SW_TIMER_WHEEL_LEVELS      4
+#define SW_TIMER_WHEEL_BITS        8
+#define SW_TIMER_WHEEL_SLOTS       (1 << SW_TIMER_WHEEL_BITS)
+#define SW_TIMER_WHEEL_MASK        (SW_TIMER_WHEEL_SLOTS - 1)
+
+typedef struct
+{
+    /**
+     * last tick processed, in msec relative to the timer basetime
+     */
+    int64_t current;
+    swTimer_node *slots[SW_TIMER_WHEEL_LEVELS][SW_TIMER_WHEEL_SLOTS];
+} swTimerWheel;
+
 struct _swTimer
 {
     /*--------------timerfd & signal timer--------------*/
     swHeap *heap;
+    /**
+     * replaces the heap when SwooleG.use_timer_wheel is set before the timer starts
+     */
+    swTimerWheel *wheel;
     swHashMap *map;
     int num;
     int use_pipe;
@@ -2105,6 +2346,11 @@ typedef struct
      */
     uint8_t use_timer_pipe :1;
 
+    /**
+     * keep timers in a timing wheel instead of the min-heap
+     */
+    uint8_t use_timer_wheel :1;
+
     int error;
     int process_type;
     pid_t pid;
@@ -2134,6 +2380,12 @@ typedef struct
     uint16_t task_tmpdir_len;
     uint8_t task_ipc_mode;
     uint16_t task_max_request;
+    /**
+     * large task payloads are passed through this shared ring instead of tmp files
+     */
+    uint32_t task_shm_size;
+    swMemoryPool *task_shm_pool;
+    swLock *task_shm_lock;
 
     uint16_t cpu_num;
 
@@ -2156,6 +2408,7 @@ typedef struct
     swEventData *task_result;
 
     pthread_t heartbeat_pidt;
+    pthread_t stats_pidt;
 
     char *dns_server_v4;
     char *dns_server_v6;
@@ -30,14 +30,39 @@ typedef struct _swTableRow
 #else
     pthread_mutex_t lock;
 #endif
+    /**
+     * seqlock of the collision list starting at this row,
+     * odd while a writer holds the lock
+     */
+    sw_atomic_t version;
+    /**
+     * lock-free column updates in flight on the collision list,
+     * writers that move or free rows wait for them to finish
+     */
+    sw_atomic_t pinned;
     /**
      * 1:used, 0:empty
      */
     uint8_t active;
     /**
-     * next slot
+     * set on access, cleared by the eviction sweep
+     */
+    uint8_t referenced;
+    /**
+     * unix time the row expires at, 0: never
      */
-    struct _swTableRow *next;
+    uint32_t expire;
+    union
+    {
+        /**
+         * next slot
+         */
+        struct _swTableRow *next;
+        /**
+         * probing engine: mixed hash of the key, so it can move without rehashing
+         */
+        uint64_t hash;
+    };
     /**
      * Hash Key
      */
@@ -52,6 +77,44 @@ typedef struct
     swTableRow *row;
 } swTable_iterator;
 
+/**
+ * probing engine: slot fingerprints below SW_TABLE_SLOT_USED mark free or reserved slots
+ */
+#define SW_TABLE_BUCKET_SLOTS      16
+#define SW_TABLE_SLOT_EMPTY        0
+#define SW_TABLE_SLOT_DELETED      1
+#define SW_TABLE_SLOT_BUSY         2
+#define SW_TABLE_SLOT_USED         3
+#define SW_TABLE_MAX_SEGMENTS      32
+
+/**
+ * one cache line of fingerprints for the slots of a bucket
+ */
+typedef struct
+{
+    volatile uint16_t fingerprint[SW_TABLE_BUCKET_SLOTS];
+    /**
+     * 1 once the keys whose home is this bucket have moved to the next segment
+     */
+    sw_atomic_t moved;
+} __attribute__((aligned(64))) swTableBucket;
+
+/**
+ * open-addressing table of one capacity, the keys whose home is a bucket are guarded
+ * by the lock and version of the first row of that bucket
+ */
+typedef struct
+{
+    uint32_t bucket_num;
+    uint32_t mask;
+    /**
+     * slots taken since the segment was activated, tombstones included
+     */
+    sw_atomic_t used;
+    swTableBucket *buckets;
+    char *rows;
+} swTableSegment;
+
 typedef struct
 {
     swHashMap *columns;
@@ -74,6 +137,23 @@ typedef struct
     swTable_iterator *iterator;
 
     void *memory;
+
+    /**
+     * probing engine, used when max_size is set: the table grows by doubling up to max_size,
+     * moving the keys of the current segment to the next one bucket by bucket
+     */
+    uint32_t max_size;
+    /**
+     * evict rows with the CLOCK algorithm when the table is full
+     */
+    uint8_t evict;
+    sw_atomic_t clock_hand;
+    swTableSegment *current;
+    swTableSegment *next;
+    sw_atomic_t migrate_index;
+    sw_atomic_t moved_num;
+    uint8_t segment_num;
+    swTableSegment segments[SW_TABLE_MAX_SEGMENTS];
 } swTable;
 
 typedef struct
@@ -115,6 +195,8 @@ void swTable_free(swTable *table);
 int swTableColumn_add(swTable *table, char *name, int len, int type, int size);
 swTableRow* swTableRow_set(swTable *table, char *key, int keylen, swTableRow **rowlock);
 swTableRow* swTableRow_get(swTable *table, char *key, int keylen, swTableRow **rowlock);
+int swTableRow_get_copy(swTable *table, char *key, int keylen, swTableRow *copy);
+swTableRow* swTableRow_pin(swTable *table, char *key, int keylen, swTableRow **rowlock);
 
 void swTable_iterator_rewind(swTable *table);
 swTableRow* swTable_iterator_current(swTable *table);
@@ -133,10 +215,14 @@ static sw_inline void swTableRow_lock(swTableRow *row)
 #else
     pthread_mutex_lock(&row->lock);
 #endif
+    row->version++;
+    sw_atomic_memory_barrier();
 }
 
 static sw_inline void swTableRow_unlock(swTableRow *row)
 {
+    sw_atomic_memory_barrier();
+    row->version++;
 #if SW_TABLE_USE_SPINLOCK
     sw_spinlock_release(&row->lock);
 #else
@@ -144,6 +230,146 @@ static sw_inline void swTableRow_unlock(swTableRow *row)
 #endif
 }
 
+static sw_inline int swTableRow_trylock(swTableRow *row)
+{
+#if SW_TABLE_USE_SPINLOCK
+    if (row->lock != 0 || !sw_atomic_cmp_set(&row->lock, 0, 1))
+    {
+        return SW_ERR;
+    }
+#else
+    if (pthread_mutex_trylock(&row->lock) != 0)
+    {
+        return SW_ERR;
+    }
+#endif
+    row->version++;
+    sw_atomic_memory_barrier();
+    return SW_OK;
+}
+
+static sw_inline int swTableRow_expired(swTableRow *row)
+{
+    return row->expire && row->expire <= (uint32_t) time(NULL);
+}
+
+/**
+ * expired rows read as missing, the access marks the row for the eviction sweep
+ */
+static sw_inline int swTableRow_touch(swTableRow *row)
+{
+    if (swTableRow_expired(row))
+    {
+        return SW_ERR;
+    }
+    if (!row->referenced)
+    {
+        row->referenced = 1;
+    }
+    return SW_OK;
+}
+
+static sw_inline void swTableRow_unpin(swTableRow *row)
+{
+    sw_atomic_fetch_sub(&row->pinned, 1);
+}
+
+/**
+ * called with the lock held, before a row of the collision list is moved or freed
+ */
+static sw_inline void swTableRow_wait_unpinned(swTableRow *row)
+{
+    while (row->pinned)
+    {
+        sw_atomic_cpu_pause();
+    }
+}
+
+/**
+ * number columns can be updated with atomic instructions when they are naturally aligned
+ */
+static sw_inline int swTableColumn_atomic(swTableRow *row, swTableColumn *col)
+{
+    return col->type != SW_TABLE_STRING && ((uintptr_t) (row->data + col->index) & (col->size - 1)) == 0;
+}
+
+static sw_inline int64_t swTableRow_atomic_add_long(swTableRow *row, swTableColumn *col, int64_t value)
+{
+    void *ptr = row->data + col->index;
+
+    switch(col->type)
+    {
+    case SW_TABLE_INT8:
+        return __atomic_add_fetch((int8_t *) ptr, (int8_t) value, __ATOMIC_SEQ_CST);
+    case SW_TABLE_INT16:
+        return __atomic_add_fetch((int16_t *) ptr, (int16_t) value, __ATOMIC_SEQ_CST);
+    case SW_TABLE_INT32:
+        return __atomic_add_fetch((int32_t *) ptr, (int32_t) value, __ATOMIC_SEQ_CST);
+    default:
+        return __atomic_add_fetch((int64_t *) ptr, value, __ATOMIC_SEQ_CST);
+    }
+}
+
+static sw_inline int swTableRow_atomic_cas_long(swTableRow *row, swTableColumn *col, int64_t expected, int64_t value)
+{
+    void *ptr = row->data + col->index;
+    int8_t _i8 = expected;
+    int16_t _i16 = expected;
+    int32_t _i32 = expected;
+
+    switch(col->type)
+    {
+    case SW_TABLE_INT8:
+        return __atomic_compare_exchange_n((int8_t *) ptr, &_i8, (int8_t) value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    case SW_TABLE_INT16:
+        return __atomic_compare_exchange_n((int16_t *) ptr, &_i16, (int16_t) value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    case SW_TABLE_INT32:
+        return __atomic_compare_exchange_n((int32_t *) ptr, &_i32, (int32_t) value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    default:
+        return __atomic_compare_exchange_n((int64_t *) ptr, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * doubles have no atomic add, retry a CAS on the bits until no other writer got in between
+ */
+static sw_inline double swTableRow_atomic_add_double(swTableRow *row, swTableColumn *col, double value)
+{
+    uint64_t *ptr = (uint64_t *) (row->data + col->index);
+    uint64_t old_bits = __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+    uint64_t new_bits;
+    double dval;
+
+    do
+    {
+        memcpy(&dval, &old_bits, sizeof(dval));
+        dval += value;
+        memcpy(&new_bits, &dval, sizeof(dval));
+    } while (!__atomic_compare_exchange_n(ptr, &old_bits, new_bits, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    return dval;
+}
+
+static sw_inline int swTableRow_atomic_cas_double(swTableRow *row, swTableColumn *col, double expected, double value)
+{
+    uint64_t *ptr = (uint64_t *) (row->data + col->index);
+    uint64_t old_bits = __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+    uint64_t new_bits;
+    double dval;
+
+    memcpy(&new_bits, &value, sizeof(value));
+    do
+    {
+        memcpy(&dval, &old_bits, sizeof(dval));
+        if (dval != expected)
+        {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(ptr, &old_bits, new_bits, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    return 1;
+}
+
 typedef uint32_t swTable_string_length_t;
 
 static sw_inline void swTableRow_set_value(swTableRow *row, swTableColumn * col, void *value, int vlen)
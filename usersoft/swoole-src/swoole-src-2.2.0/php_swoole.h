@@ -402,6 +402,13 @@ void swoole_msgqueue_init(int module_number TSRMLS_DC);
 #if PHP_MAJOR_VERSION == 7
 void swoole_channel_coro_init(int module_number TSRMLS_DC);
 void swoole_serialize_init(int module_number TSRMLS_DC);
+
+extern zend_class_entry *swoole_channel_coro_class_entry_ptr;
+void php_swoole_channel_coro_pop(zval *object, zval *return_value);
+int php_swoole_channel_coro_try_pop(zval *object, zval *zdata);
+int php_swoole_channel_coro_try_push(zval *object, zval *zdata);
+int php_swoole_channel_coro_consumer_num(zval *object);
+void php_swoole_channel_coro_close(zval *object);
 #endif
 
 int php_swoole_process_start(swWorker *process, zval *object TSRMLS_DC);
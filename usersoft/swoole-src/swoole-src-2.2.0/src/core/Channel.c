@@ -210,6 +210,402 @@ int swChannel_pop(swChannel *object, void *out, int buffer_length)
     return n;
 }
 
+typedef struct _swRingChannel_item
+{
+    uint32_t length;
+    uint32_t wrap;
+    char data[0];
+} swRingChannel_item;
+
+#define swRingChannel_item_size(len)   ((sizeof(swRingChannel_item) + (len) + 7) & ~7)
+
+swRingChannel* swRingChannel_new(size_t size, int flag)
+{
+    swRingChannel *object;
+    uint32_t real_size = 4096;
+
+    //power of 2, so that the offset is a mask of the position
+    while (real_size < size)
+    {
+        real_size <<= 1;
+    }
+    if (flag & SW_CHAN_SHM)
+    {
+        object = sw_shm_malloc(sizeof(swRingChannel) + real_size);
+    }
+    else
+    {
+        object = sw_malloc(sizeof(swRingChannel) + real_size);
+    }
+    if (object == NULL)
+    {
+        swWarn("malloc(%d) failed.", real_size);
+        return NULL;
+    }
+    bzero(object, sizeof(swRingChannel));
+    object->size = real_size;
+    object->flag = flag;
+    return object;
+}
+
+/**
+ * [producer] return SW_ERR if there is no space
+ */
+int swRingChannel_push(swRingChannel *object, void *in, int data_length)
+{
+    uint32_t tail = object->tail;
+    uint32_t offset = tail & (object->size - 1);
+    uint32_t remain = object->size - offset;
+    uint32_t msize = swRingChannel_item_size(data_length);
+    uint32_t need = msize;
+
+    //items are never split, skip the end of the memory
+    if (remain < msize)
+    {
+        need += remain;
+    }
+    if (object->size - (tail - object->head) < need)
+    {
+        return SW_ERR;
+    }
+
+    swRingChannel_item *item = (swRingChannel_item *) (object->mem + offset);
+    if (remain < msize)
+    {
+        item->wrap = 1;
+        tail += remain;
+        item = (swRingChannel_item *) object->mem;
+    }
+    item->wrap = 0;
+    item->length = data_length;
+    memcpy(item->data, in, data_length);
+
+    //publish the item after its content
+    sw_atomic_memory_barrier();
+    object->tail = tail + msize;
+    return SW_OK;
+}
+
+/**
+ * [consumer] the oldest item, NULL if the channel is empty
+ */
+void* swRingChannel_front(swRingChannel *object, int *data_length)
+{
+    uint32_t head = object->head;
+    if (head == object->tail)
+    {
+        return NULL;
+    }
+    sw_atomic_memory_barrier();
+
+    swRingChannel_item *item = (swRingChannel_item *) (object->mem + (head & (object->size - 1)));
+    if (item->wrap)
+    {
+        head += object->size - (head & (object->size - 1));
+        object->head = head;
+        item = (swRingChannel_item *) object->mem;
+    }
+    *data_length = item->length;
+    return item->data;
+}
+
+/**
+ * [consumer] release the item returned by swRingChannel_front
+ */
+void swRingChannel_pop(swRingChannel *object)
+{
+    uint32_t head = object->head;
+    swRingChannel_item *item = (swRingChannel_item *) (object->mem + (head & (object->size - 1)));
+
+    //the producer must not overwrite the item before we are done with it
+    sw_atomic_memory_barrier();
+    object->head = head + swRingChannel_item_size(item->length);
+}
+
+void swRingChannel_free(swRingChannel *object)
+{
+    if (object->flag & SW_CHAN_SHM)
+    {
+        sw_shm_free(object);
+    }
+    else
+    {
+        sw_free(object);
+    }
+}
+
+typedef struct _swMpmcChannel_cell
+{
+    sw_atomic_ulong_t sequence;
+    /**
+     * only valid in the first cell of an item
+     */
+    uint32_t length;
+    uint32_t num;
+    char data[0];
+} swMpmcChannel_cell;
+
+#define swMpmcChannel_cell(object, pos)    ((swMpmcChannel_cell *) (object->mem + ((pos) & (object->cell_num - 1)) * object->cell_size))
+#define swMpmcChannel_cell_data_size(object)    (object->cell_size - sizeof(swMpmcChannel_cell))
+
+static sw_inline uint32_t swMpmcChannel_cells(swMpmcChannel *object, int data_length)
+{
+    uint32_t size = swMpmcChannel_cell_data_size(object);
+    return data_length <= size ? 1 : (data_length + size - 1) / size;
+}
+
+swMpmcChannel* swMpmcChannel_new(size_t size, uint32_t cell_size, int flag)
+{
+    swMpmcChannel *object;
+    uint32_t cell_num = 64;
+    uint32_t i;
+
+    cell_size = (cell_size + 7) & ~7;
+    if (cell_size < sizeof(swMpmcChannel_cell) + 8)
+    {
+        cell_size = sizeof(swMpmcChannel_cell) + 8;
+    }
+    //power of 2, so that the cell index is a mask of the position
+    while ((size_t) cell_num * cell_size < size)
+    {
+        cell_num <<= 1;
+    }
+
+    size_t mem_size = sizeof(swMpmcChannel) + (size_t) cell_num * cell_size;
+    if (flag & SW_CHAN_SHM)
+    {
+        object = sw_shm_malloc(mem_size);
+    }
+    else
+    {
+        object = sw_malloc(mem_size);
+    }
+    if (object == NULL)
+    {
+        swWarn("malloc(%ld) failed.", (long) mem_size);
+        return NULL;
+    }
+    bzero(object, sizeof(swMpmcChannel));
+    object->cell_num = cell_num;
+    object->cell_size = cell_size;
+    object->flag = flag;
+
+    for (i = 0; i < cell_num; i++)
+    {
+        swMpmcChannel_cell(object, i)->sequence = i;
+    }
+    return object;
+}
+
+/**
+ * [producer] push the first items that fit in one reservation, return the number of items pushed
+ */
+int swMpmcChannel_push_batch(swMpmcChannel *object, void **in, int *lengths, int n)
+{
+    swMpmcChannel_cell *cell;
+    unsigned long pos;
+    uint32_t cells, k, j;
+    long diff = 0;
+    int count, i;
+    long bytes = 0;
+
+    while (1)
+    {
+        pos = object->tail;
+        cells = 0;
+        count = 0;
+        while (count < n)
+        {
+            k = swMpmcChannel_cells(object, lengths[count]);
+            if (k > object->cell_num)
+            {
+                break;
+            }
+            //the cells are free in this round when sequence == position
+            for (j = 0; j < k; j++)
+            {
+                cell = swMpmcChannel_cell(object, pos + cells + j);
+                diff = (long) (cell->sequence - (pos + cells + j));
+                if (diff != 0)
+                {
+                    goto _reserve;
+                }
+            }
+            cells += k;
+            count++;
+        }
+        _reserve:
+        if (count == 0)
+        {
+            //another producer took the cell, retry with the new tail
+            if (diff > 0)
+            {
+                continue;
+            }
+            return 0;
+        }
+        if (sw_atomic_cmp_set(&object->tail, pos, pos + cells))
+        {
+            break;
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        uint32_t size = swMpmcChannel_cell_data_size(object);
+        uint32_t offset = 0;
+        swMpmcChannel_cell *first = swMpmcChannel_cell(object, pos);
+
+        k = swMpmcChannel_cells(object, lengths[i]);
+        for (j = 0; j < k; j++)
+        {
+            uint32_t n_copy = lengths[i] - offset < size ? lengths[i] - offset : size;
+            memcpy(swMpmcChannel_cell(object, pos + j)->data, (char *) in[i] + offset, n_copy);
+            offset += n_copy;
+        }
+        first->length = lengths[i];
+        first->num = k;
+        bytes += lengths[i];
+
+        //publish the first cell last, consumers only check the first one
+        sw_atomic_memory_barrier();
+        for (j = k - 1; j > 0; j--)
+        {
+            swMpmcChannel_cell(object, pos + j)->sequence = pos + j + 1;
+        }
+        if (k > 1)
+        {
+            sw_atomic_memory_barrier();
+        }
+        first->sequence = pos + 1;
+        pos += k;
+    }
+
+    sw_atomic_fetch_add(&object->num, count);
+    sw_atomic_fetch_add(&object->bytes, bytes);
+    return count;
+}
+
+/**
+ * [consumer] pop up to n items into out back to back, lengths[i] is the length of the i-th item,
+ * return the number of items
+ */
+int swMpmcChannel_pop_batch(swMpmcChannel *object, void *out, int buffer_length, int *lengths, int n)
+{
+    swMpmcChannel_cell *cell;
+    unsigned long pos;
+    uint32_t cells, k, j;
+    long diff = 0;
+    long bytes;
+    int count, i;
+
+    while (1)
+    {
+        pos = object->head;
+        cells = 0;
+        count = 0;
+        bytes = 0;
+        while (count < n)
+        {
+            cell = swMpmcChannel_cell(object, pos + cells);
+            diff = (long) (cell->sequence - (pos + cells + 1));
+            if (diff != 0)
+            {
+                break;
+            }
+            sw_atomic_memory_barrier();
+            k = cell->num;
+            //stale read, the head has moved
+            if (k == 0 || k > object->cell_num)
+            {
+                diff = 1;
+                break;
+            }
+            if (bytes + cell->length > buffer_length)
+            {
+                break;
+            }
+            lengths[count++] = cell->length;
+            bytes += cell->length;
+            cells += k;
+        }
+        if (count == 0)
+        {
+            //another consumer took the item, retry with the new head
+            if (diff > 0 && pos != object->head)
+            {
+                continue;
+            }
+            return 0;
+        }
+        if (sw_atomic_cmp_set(&object->head, pos, pos + cells))
+        {
+            break;
+        }
+    }
+
+    char *p = out;
+    for (i = 0; i < count; i++)
+    {
+        uint32_t size = swMpmcChannel_cell_data_size(object);
+        uint32_t offset = 0;
+
+        k = swMpmcChannel_cells(object, lengths[i]);
+        for (j = 0; j < k; j++)
+        {
+            uint32_t n_copy = lengths[i] - offset < size ? lengths[i] - offset : size;
+            memcpy(p + offset, swMpmcChannel_cell(object, pos + j)->data, n_copy);
+            offset += n_copy;
+        }
+        p += lengths[i];
+
+        //the producer of the next round must not overwrite the cells before we are done with them
+        sw_atomic_memory_barrier();
+        for (j = 0; j < k; j++)
+        {
+            swMpmcChannel_cell(object, pos + j)->sequence = pos + j + object->cell_num;
+        }
+        pos += k;
+    }
+
+    sw_atomic_fetch_sub(&object->num, count);
+    sw_atomic_fetch_sub(&object->bytes, bytes);
+    return count;
+}
+
+/**
+ * [producer] return SW_ERR if there is no space
+ */
+int swMpmcChannel_push(swMpmcChannel *object, void *in, int data_length)
+{
+    return swMpmcChannel_push_batch(object, &in, &data_length, 1) == 1 ? SW_OK : SW_ERR;
+}
+
+/**
+ * [consumer] return the length of the item, SW_ERR if the channel is empty
+ */
+int swMpmcChannel_pop(swMpmcChannel *object, void *out, int buffer_length)
+{
+    int length;
+    if (swMpmcChannel_pop_batch(object, out, buffer_length, &length, 1) == 1)
+    {
+        return length;
+    }
+    return SW_ERR;
+}
+
+void swMpmcChannel_free(swMpmcChannel *object)
+{
+    if (object->flag & SW_CHAN_SHM)
+    {
+        sw_shm_free(object);
+    }
+    else
+    {
+        sw_free(object);
+    }
+}
+
 void swChannel_print(swChannel *chan)
 {
     printf("swChannel\n{\n"
@@ -95,6 +95,8 @@ void swoole_init(void)
         exit(3);
     }
 
+    SwooleG.task_shm_size = SW_TASK_SHM_SIZE;
+
     if (!SwooleG.task_tmpdir)
     {
         SwooleG.task_tmpdir = sw_strndup(SW_TASK_TMP_FILE, sizeof(SW_TASK_TMP_FILE));
@@ -484,6 +486,73 @@ double swoole_microtime(void)
     return (double) t.tv_sec + ((double) t.tv_usec / 1000000);
 }
 
+/**
+ * 0-7 are exact, then 4 buckets for each power of 2
+ */
+static sw_inline int swHistogram_index(uint64_t usec)
+{
+    if (usec < 8)
+    {
+        return usec;
+    }
+    int msb = 63 - __builtin_clzll(usec);
+    int index = 8 + (msb - 3) * 4 + ((usec >> (msb - 2)) & 3);
+    return index < SW_HISTOGRAM_BUCKETS ? index : SW_HISTOGRAM_BUCKETS - 1;
+}
+
+void swHistogram_record(swHistogram *h, uint64_t usec)
+{
+    sw_atomic_fetch_add(&h->count[swHistogram_index(usec)], 1);
+    sw_atomic_fetch_add(&h->sum, usec);
+}
+
+/**
+ * the largest value counted in the bucket
+ */
+uint64_t swHistogram_bucket_max(int index)
+{
+    if (index < 8)
+    {
+        return index;
+    }
+    int msb = (index - 8) / 4 + 3;
+    int sub = (index - 8) % 4;
+    return (((uint64_t) (4 + sub + 1)) << (msb - 2)) - 1;
+}
+
+/**
+ * upper bound of the value below which percent% of the samples fall
+ */
+uint64_t swHistogram_percentile(swHistogram *h, double percent, uint64_t *total)
+{
+    uint64_t n = 0, count = 0;
+    int i;
+
+    for (i = 0; i < SW_HISTOGRAM_BUCKETS; i++)
+    {
+        n += h->count[i];
+    }
+    if (total)
+    {
+        *total = n;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t) (n * percent / 100);
+    for (i = 0; i < SW_HISTOGRAM_BUCKETS; i++)
+    {
+        count += h->count[i];
+        if (count > rank || count == n)
+        {
+            return swHistogram_bucket_max(i);
+        }
+    }
+    return swHistogram_bucket_max(SW_HISTOGRAM_BUCKETS - 1);
+}
+
 void swoole_rtrim(char *str, int len)
 {
     int i;
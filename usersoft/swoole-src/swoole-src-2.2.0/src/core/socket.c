@@ -18,6 +18,7 @@
 
 #include <sys/stat.h>
 #include <poll.h>
+#include <netinet/udp.h>
 
 int swSocket_sendfile_sync(int sock, char *filename, off_t offset, size_t length, double timeout)
 {
@@ -264,6 +265,177 @@ int swSocket_unix_sendto(int server_sock, char *dst_path, char *data, uint32_t l
     return swSocket_sendto_blocking(server_sock, data, len, 0, (struct sockaddr *) &addr, sizeof(addr));
 }
 
+int swSocket_udp_sendto_multi(int server_sock, int ipv6, char *dst_ip, int dst_port, struct iovec *packets, int n)
+{
+    union
+    {
+        struct sockaddr_in v4;
+        struct sockaddr_in6 v6;
+    } addr;
+    socklen_t addr_len;
+
+    bzero(&addr, sizeof(addr));
+    if (ipv6)
+    {
+        if (inet_pton(AF_INET6, dst_ip, &addr.v6.sin6_addr) <= 0)
+        {
+            swWarn("ip[%s] is invalid.", dst_ip);
+            return SW_ERR;
+        }
+        addr.v6.sin6_port = (uint16_t) htons(dst_port);
+        addr.v6.sin6_family = AF_INET6;
+        addr_len = sizeof(addr.v6);
+    }
+    else
+    {
+        if (inet_aton(dst_ip, &addr.v4.sin_addr) == 0)
+        {
+            swWarn("ip[%s] is invalid.", dst_ip);
+            return SW_ERR;
+        }
+        addr.v4.sin_family = AF_INET;
+        addr.v4.sin_port = htons(dst_port);
+        addr_len = sizeof(addr.v4);
+    }
+    return swSocket_sendto_multi(server_sock, packets, n, (struct sockaddr *) &addr, addr_len);
+}
+
+#ifdef UDP_SEGMENT
+static int swSocket_gso_disabled = 0;
+
+/**
+ * equal sized datagrams (the last one may be shorter) are handed to the kernel as one UDP_SEGMENT send
+ */
+static int swSocket_sendto_gso(int fd, struct iovec *packets, int n, struct sockaddr *__addr, socklen_t __addr_len)
+{
+    int i;
+    size_t total = 0;
+    uint16_t segment_size = packets[0].iov_len;
+
+    if (swSocket_gso_disabled || n < 2 || n > SW_UDP_SEND_BATCH || __addr->sa_family == AF_UNIX)
+    {
+        return SW_ERR;
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (packets[i].iov_len > segment_size || (i < n - 1 && packets[i].iov_len != segment_size))
+        {
+            return SW_ERR;
+        }
+        total += packets[i].iov_len;
+    }
+    if (total > SW_UDP_GSO_MAX_SIZE)
+    {
+        return SW_ERR;
+    }
+
+    char control[CMSG_SPACE(sizeof(uint16_t))];
+    struct msghdr msg;
+    struct cmsghdr *cm;
+
+    bzero(&msg, sizeof(msg));
+    bzero(control, sizeof(control));
+    msg.msg_name = __addr;
+    msg.msg_namelen = __addr_len;
+    msg.msg_iov = packets;
+    msg.msg_iovlen = n;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    memcpy(CMSG_DATA(cm), &segment_size, sizeof(segment_size));
+
+    while (1)
+    {
+        if (sendmsg(fd, &msg, 0) >= 0)
+        {
+            return n;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno == EAGAIN)
+        {
+            swSocket_wait(fd, 1000, SW_EVENT_WRITE);
+            continue;
+        }
+        //the kernel or the device does not support UDP GSO
+        else if (errno == ENOPROTOOPT || errno == EINVAL || errno == EIO || errno == EOPNOTSUPP)
+        {
+            swSocket_gso_disabled = 1;
+        }
+        return SW_ERR;
+    }
+}
+#endif
+
+/**
+ * send a burst of datagrams to one address, return the number of datagrams sent
+ */
+int swSocket_sendto_multi(int fd, struct iovec *packets, int n, struct sockaddr *__addr, socklen_t __addr_len)
+{
+    int sent = 0;
+    int ret;
+
+#ifdef UDP_SEGMENT
+    ret = swSocket_sendto_gso(fd, packets, n, __addr, __addr_len);
+    if (ret > 0)
+    {
+        return ret;
+    }
+#endif
+
+#ifdef HAVE_MMSG
+    struct mmsghdr msgs[SW_UDP_SEND_BATCH];
+    int i, batch;
+
+    while (sent < n)
+    {
+        batch = n - sent > SW_UDP_SEND_BATCH ? SW_UDP_SEND_BATCH : n - sent;
+        bzero(msgs, sizeof(struct mmsghdr) * batch);
+        for (i = 0; i < batch; i++)
+        {
+            msgs[i].msg_hdr.msg_name = __addr;
+            msgs[i].msg_hdr.msg_namelen = __addr_len;
+            msgs[i].msg_hdr.msg_iov = &packets[sent + i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        ret = sendmmsg(fd, msgs, batch, 0);
+        if (ret > 0)
+        {
+            sent += ret;
+        }
+        else if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (ret < 0 && errno == EAGAIN)
+        {
+            swSocket_wait(fd, 1000, SW_EVENT_WRITE);
+        }
+        else
+        {
+            break;
+        }
+    }
+#else
+    for (; sent < n; sent++)
+    {
+        ret = swSocket_sendto_blocking(fd, packets[sent].iov_base, packets[sent].iov_len, 0, __addr, __addr_len);
+        if (ret < 0)
+        {
+            break;
+        }
+    }
+#endif
+
+    return sent == 0 && n > 0 ? SW_ERR : sent;
+}
+
 int swSocket_sendto_blocking(int fd, void *__buf, size_t __n, int flag, struct sockaddr *__addr, socklen_t __addr_len)
 {
     int n = 0;
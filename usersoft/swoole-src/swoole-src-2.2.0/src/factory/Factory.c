@@ -63,6 +63,8 @@ int swFactory_dispatch(swFactory *factory, swDispatchData *task)
         task->data.info.fd = conn->session_id;
         task->data.info.from_fd = conn->from_fd;
     }
+    //handled in place, there is no queueing time
+    task->data.info.time = 0;
     return swWorker_onTask(factory, &task->data);
 }
 
@@ -82,6 +82,12 @@ static int swFactoryProcess_start(swFactory *factory)
 
     serv->reactor_pipe_num = serv->worker_num / serv->reactor_num;
 
+    //the rings and their eventfd must be shared with the worker processes
+    if (serv->ipc_ring_size > 0 && swReactorThread_create_rings(serv) < 0)
+    {
+        return SW_ERR;
+    }
+
     //必须先启动manager进程组，否则会带线程fork
     if (swManager_start(factory) < 0)
     {
@@ -107,6 +113,19 @@ static int swFactoryProcess_notify(swFactory *factory, swDataHead *ev)
     memcpy(&sw_notify_data._send, ev, sizeof(swDataHead));
     sw_notify_data._send.len = 0;
     sw_notify_data.target_worker_id = -1;
+    /**
+     * the producer has to see the watermark events whatever the dispatch_mode is,
+     * it may be suspended in send() waiting for the buffer to drain
+     */
+    if (ev->type == SW_EVENT_BUFFER_FULL || ev->type == SW_EVENT_BUFFER_EMPTY)
+    {
+        swServer *serv = factory->ptr;
+        swConnection *conn = swServer_connection_get(serv, ev->fd);
+        if (conn && conn->send_worker_id > 0 && conn->send_worker_id <= serv->worker_num)
+        {
+            sw_notify_data.target_worker_id = conn->send_worker_id - 1;
+        }
+    }
     return factory->dispatch(factory, (swDispatchData *) &sw_notify_data);
 }
 
@@ -173,7 +192,27 @@ static int swFactoryProcess_dispatch(swFactory *factory, swDispatchData *task)
         task->data.info.from_fd = conn->from_fd;
     }
 
-    return swReactorThread_send2worker((void *) &(task->data), send_len, target_worker_id);
+    if (serv->latency_stats)
+    {
+        task->data.info.time = (uint32_t) swoole_monotonic_usec();
+    }
+
+    //counted before the send, the worker may finish it first
+    sw_atomic_t *dispatch_count = NULL;
+    if (serv->dispatch_mode == SW_DISPATCH_LEAST_LOADED && swServer_is_request_event(task->data.info.type))
+    {
+        dispatch_count = &serv->workers[target_worker_id].dispatch_count;
+        sw_atomic_fetch_add(dispatch_count, 1);
+    }
+    if (swReactorThread_send2worker((void *) &(task->data), send_len, target_worker_id) < 0)
+    {
+        if (dispatch_count)
+        {
+            sw_atomic_fetch_sub(dispatch_count, 1);
+        }
+        return SW_ERR;
+    }
+    return SW_OK;
 }
 
 /**
@@ -205,9 +244,22 @@ static int swFactoryProcess_finish(swFactory *factory, swSendData *resp)
         swoole_error_log(SW_LOG_NOTICE, SW_ERROR_SESSION_CLOSED, "send %d byte failed, because connection[fd=%d] is closed.", _len, session_id);
         return SW_ERR;
     }
-    else if (conn->overflow)
+
+    if (SwooleWG.id < serv->worker_num && resp->info.type != SW_EVENT_CLOSE)
     {
-        swoole_error_log(SW_LOG_WARNING, SW_ERROR_OUTPUT_BUFFER_OVERFLOW, "send failed, connection[fd=%d] output buffer has been overflowed.", session_id);
+        conn->send_worker_id = SwooleWG.id + 1;
+    }
+
+    if (conn->overflow && resp->info.type != SW_EVENT_CLOSE)
+    {
+        if (serv->send_yield)
+        {
+            SwooleG.error = SW_ERROR_OUTPUT_BUFFER_OVERFLOW;
+        }
+        else
+        {
+            swoole_error_log(SW_LOG_WARNING, SW_ERROR_OUTPUT_BUFFER_OVERFLOW, "send failed, connection[fd=%d] output buffer has been overflowed.", session_id);
+        }
         return SW_ERR;
     }
 
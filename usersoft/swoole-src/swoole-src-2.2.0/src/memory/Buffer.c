@@ -35,12 +35,103 @@ swBuffer* swBuffer_new(int trunk_size)
     return buffer;
 }
 
+/**
+ * per-thread free lists of chunk structs and data blocks, data blocks are grouped in power-of-two size classes.
+ * memory freed by another thread goes to that thread's pool, each list is capped so bursts go back to the allocator.
+ */
+static __thread struct
+{
+    swBuffer_trunk *trunks;
+    uint32_t trunk_num;
+    struct
+    {
+        void *head;
+        uint32_t num;
+    } blocks[SW_BUFFER_POOL_CLASS_NUM];
+} swBuffer_pool;
+
+static sw_inline int swBuffer_pool_class(uint32_t size)
+{
+    int index = 0;
+    uint32_t class_size = SW_BUFFER_POOL_MIN_SIZE;
+
+    while (class_size < size)
+    {
+        class_size <<= 1;
+        index++;
+    }
+    return index < SW_BUFFER_POOL_CLASS_NUM ? index : -1;
+}
+
+static void* swBuffer_pool_alloc(uint32_t *size)
+{
+    int index = swBuffer_pool_class(*size);
+    if (index < 0)
+    {
+        return sw_malloc(*size);
+    }
+    *size = SW_BUFFER_POOL_MIN_SIZE << index;
+    void *block = swBuffer_pool.blocks[index].head;
+    if (block)
+    {
+        swBuffer_pool.blocks[index].head = *(void **) block;
+        swBuffer_pool.blocks[index].num--;
+        return block;
+    }
+    return sw_malloc(*size);
+}
+
+static void swBuffer_pool_free(void *block, uint32_t size)
+{
+    int index = swBuffer_pool_class(size);
+    //high watermark, give the memory back to the allocator
+    if (index < 0 || (swBuffer_pool.blocks[index].num + 1) * size > SW_BUFFER_POOL_MAX_FREE)
+    {
+        sw_free(block);
+        return;
+    }
+    *(void **) block = swBuffer_pool.blocks[index].head;
+    swBuffer_pool.blocks[index].head = block;
+    swBuffer_pool.blocks[index].num++;
+}
+
+static sw_inline swBuffer_trunk* swBuffer_pool_alloc_trunk(void)
+{
+    swBuffer_trunk *chunk = swBuffer_pool.trunks;
+    if (chunk)
+    {
+        swBuffer_pool.trunks = chunk->next;
+        swBuffer_pool.trunk_num--;
+        return chunk;
+    }
+    return sw_malloc(sizeof(swBuffer_trunk));
+}
+
+/**
+ * release the data and the chunk struct, the destroy callback is not called
+ */
+static void swBuffer_release_trunk(swBuffer_trunk *chunk)
+{
+    if (chunk->type == SW_CHUNK_DATA && chunk->store.ptr)
+    {
+        swBuffer_pool_free(chunk->store.ptr, chunk->size);
+    }
+    if (swBuffer_pool.trunk_num >= SW_BUFFER_POOL_MAX_TRUNKS)
+    {
+        sw_free(chunk);
+        return;
+    }
+    chunk->next = swBuffer_pool.trunks;
+    swBuffer_pool.trunks = chunk;
+    swBuffer_pool.trunk_num++;
+}
+
 /**
  * create new trunk
  */
 swBuffer_trunk *swBuffer_new_trunk(swBuffer *buffer, uint32_t type, uint32_t size)
 {
-    swBuffer_trunk *chunk = sw_malloc(sizeof(swBuffer_trunk));
+    swBuffer_trunk *chunk = swBuffer_pool_alloc_trunk();
     if (chunk == NULL)
     {
         swWarn("malloc for trunk failed. Error: %s[%d]", strerror(errno), errno);
@@ -52,11 +143,11 @@ swBuffer_trunk *swBuffer_new_trunk(swBuffer *buffer, uint32_t type, uint32_t siz
     //require alloc memory
     if (type == SW_CHUNK_DATA && size > 0)
     {
-        void *buf = sw_malloc(size);
+        void *buf = swBuffer_pool_alloc(&size);
         if (buf == NULL)
         {
             swWarn("malloc(%d) for data failed. Error: %s[%d]", size, strerror(errno), errno);
-            sw_free(chunk);
+            swBuffer_release_trunk(chunk);
             return NULL;
         }
         chunk->size = size;
@@ -79,6 +170,18 @@ swBuffer_trunk *swBuffer_new_trunk(swBuffer *buffer, uint32_t type, uint32_t siz
     return chunk;
 }
 
+/**
+ * free a chunk which is no longer linked in a buffer
+ */
+void swBuffer_free_trunk(swBuffer_trunk *chunk)
+{
+    if (chunk->destroy)
+    {
+        chunk->destroy(chunk);
+    }
+    swBuffer_release_trunk(chunk);
+}
+
 /**
  * pop the head chunk
  */
@@ -97,15 +200,7 @@ void swBuffer_pop_trunk(swBuffer *buffer, swBuffer_trunk *chunk)
         buffer->length -= chunk->length;
         buffer->trunk_num--;
     }
-    if (chunk->type == SW_CHUNK_DATA)
-    {
-        sw_free(chunk->store.ptr);
-    }
-    if (chunk->destroy)
-    {
-        chunk->destroy(chunk);
-    }
-    sw_free(chunk);
+    swBuffer_free_trunk(chunk);
 }
 
 /**
@@ -113,17 +208,13 @@ void swBuffer_pop_trunk(swBuffer *buffer, swBuffer_trunk *chunk)
  */
 int swBuffer_free(swBuffer *buffer)
 {
-    volatile swBuffer_trunk *chunk = buffer->head;
-    void * *will_free_trunk;  //free the point
+    swBuffer_trunk *chunk = buffer->head;
+    swBuffer_trunk *next;
     while (chunk != NULL)
     {
-        if (chunk->type == SW_CHUNK_DATA)
-        {
-            sw_free(chunk->store.ptr);
-        }
-        will_free_trunk = (void *) chunk;
-        chunk = chunk->next;
-        sw_free(will_free_trunk);
+        next = chunk->next;
+        swBuffer_release_trunk(chunk);
+        chunk = next;
     }
     sw_free(buffer);
     return SW_OK;
@@ -134,7 +225,25 @@ int swBuffer_free(swBuffer *buffer)
  */
 int swBuffer_append(swBuffer *buffer, void *data, uint32_t size)
 {
-    swBuffer_trunk *chunk = swBuffer_new_trunk(buffer, SW_CHUNK_DATA, size);
+    swBuffer_trunk *chunk = buffer->tail;
+
+    //coalesce small writes into the tail chunk
+    if (buffer->coalesce && size <= SW_BUFFER_COALESCE_SIZE)
+    {
+        if (chunk && chunk->type == SW_CHUNK_DATA && !chunk->zerocopy && chunk->size - chunk->length >= size)
+        {
+            memcpy(chunk->store.ptr + chunk->length, data, size);
+            chunk->length += size;
+            buffer->length += size;
+            return SW_OK;
+        }
+        //leave room for the next small writes
+        chunk = swBuffer_new_trunk(buffer, SW_CHUNK_DATA, SW_BUFFER_SIZE_STD);
+    }
+    else
+    {
+        chunk = swBuffer_new_trunk(buffer, SW_CHUNK_DATA, size);
+    }
     if (chunk == NULL)
     {
         return SW_ERR;
@@ -60,6 +60,19 @@ int sw_shm_protect(void *addr, int flags)
     return mprotect(object, object->size, flags);
 }
 
+/**
+ * move the pages to a NUMA node, for memory written mostly by the threads/processes of that node
+ */
+int sw_shm_bind_node(void *ptr, int node)
+{
+#if defined(HAVE_CPU_AFFINITY) && defined(__linux__)
+    swShareMemory *object = ptr - sizeof(swShareMemory);
+    return swoole_numa_bind(object->mem, object->size, node);
+#else
+    return SW_ERR;
+#endif
+}
+
 void sw_shm_free(void *ptr)
 {
     swShareMemory *object = ptr - sizeof(swShareMemory);
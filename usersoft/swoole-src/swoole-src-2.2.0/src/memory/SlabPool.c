@@ -0,0 +1,327 @@
+/*
+  +----------------------------------------------------------------------+
+  | Swoole                                                               |
+  +----------------------------------------------------------------------+
+  | This source file is subject to version 2.0 of the Apache license,    |
+  | that is bundled with this package in the file LICENSE, and is        |
+  | available through the world-wide-web at the following url:           |
+  | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+  | If you did not receive a copy of the Apache2.0 license and are unable|
+  | to obtain it through the world-wide-web, please send a note to       |
+  | license@swoole.com so we can mail you a copy immediately.            |
+  +----------------------------------------------------------------------+
+  | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+  +----------------------------------------------------------------------+
+*/
+
+#include "swoole.h"
+
+/**
+ * size classes are powers of two, from 16 bytes to one page
+ */
+#define SW_SLAB_MIN_SHIFT     4
+#define SW_SLAB_CLASS_NUM     (SW_SLAB_PAGE_SHIFT - SW_SLAB_MIN_SHIFT + 1)
+#define SW_SLAB_PAGE_SIZE     (1 << SW_SLAB_PAGE_SHIFT)
+
+typedef struct _swSlabPool_slice
+{
+    struct _swSlabPool_slice *next;
+} swSlabPool_slice;
+
+typedef struct _swSlabPool
+{
+    swLock lock;
+    uint8_t shared;
+    uint32_t id;
+    uint32_t page_num;
+    uint32_t page_used;
+    void *memory;
+    swSlabPool_slice *free_list[SW_SLAB_CLASS_NUM];
+    /**
+     * size class of each carved page
+     */
+    uint8_t page_class[0];
+} swSlabPool;
+
+/**
+ * Per thread (and so per process) cache of free slices, refilled and flushed
+ * in batches of SW_SLAB_CACHE_SIZE / 2 to take the pool lock once per batch.
+ */
+typedef struct _swSlabPool_cache
+{
+    swSlabPool *object;
+    uint32_t id;
+    uint32_t generation;
+    uint16_t num[SW_SLAB_CLASS_NUM];
+    void *slices[SW_SLAB_CLASS_NUM][SW_SLAB_CACHE_SIZE];
+} swSlabPool_cache;
+
+static void* swSlabPool_alloc(swMemoryPool *pool, uint32_t size);
+static void swSlabPool_free(swMemoryPool *pool, void *ptr);
+static void swSlabPool_destroy(swMemoryPool *pool);
+
+static __thread swSlabPool_cache *swSlabPool_caches[SW_SLAB_CACHE_POOL_NUM];
+static sw_atomic_t swSlabPool_last_id = 0;
+/**
+ * bumped in the child after fork(), a forked cache still lists the slices
+ * the parent holds, so it must be dropped instead of used
+ */
+static uint32_t swSlabPool_generation = 0;
+static pthread_once_t swSlabPool_atfork_once = PTHREAD_ONCE_INIT;
+
+static void swSlabPool_atfork_child(void)
+{
+    swSlabPool_generation++;
+}
+
+static void swSlabPool_atfork_init(void)
+{
+    pthread_atfork(NULL, NULL, swSlabPool_atfork_child);
+}
+
+/**
+ * create new SlabPool, general purpose alloc/free of up to one page (SW_SLAB_PAGE_SIZE)
+ */
+swMemoryPool* swSlabPool_new(size_t size, uint8_t shared)
+{
+    uint32_t page_num = size / SW_SLAB_PAGE_SIZE;
+    if (page_num == 0)
+    {
+        swWarn("the size of SlabPool must be at least %d bytes.", SW_SLAB_PAGE_SIZE);
+        return NULL;
+    }
+
+    size_t header_size = sizeof(swMemoryPool) + sizeof(swSlabPool) + page_num;
+    size_t alloc_size = header_size + (size_t) page_num * SW_SLAB_PAGE_SIZE + SW_SLAB_PAGE_SIZE;
+    void *memory = (shared == 1) ? sw_shm_malloc(alloc_size) : sw_malloc(alloc_size);
+    if (memory == NULL)
+    {
+        swSysError("malloc(%ld) failed.", (long) alloc_size);
+        return NULL;
+    }
+
+    swMemoryPool *pool = memory;
+    swSlabPool *object = memory + sizeof(swMemoryPool);
+    bzero(object, sizeof(swSlabPool) + page_num);
+
+    object->shared = shared;
+    object->page_num = page_num;
+    object->id = sw_atomic_fetch_add(&swSlabPool_last_id, 1) + 1;
+    //pages are page-aligned, a slice never crosses a page
+    object->memory = (void *) (((uintptr_t) memory + header_size + SW_SLAB_PAGE_SIZE - 1) & ~((uintptr_t) SW_SLAB_PAGE_SIZE - 1));
+
+    if (swMutex_create(&object->lock, shared) < 0)
+    {
+        if (shared)
+        {
+            sw_shm_free(memory);
+        }
+        else
+        {
+            sw_free(memory);
+        }
+        return NULL;
+    }
+
+    pool->object = object;
+    pool->alloc = swSlabPool_alloc;
+    pool->free = swSlabPool_free;
+    pool->destroy = swSlabPool_destroy;
+
+    pthread_once(&swSlabPool_atfork_once, swSlabPool_atfork_init);
+
+    return pool;
+}
+
+static sw_inline int swSlabPool_get_class(uint32_t size)
+{
+    int i = SW_SLAB_MIN_SHIFT;
+    while ((1U << i) < size)
+    {
+        i++;
+    }
+    return i - SW_SLAB_MIN_SHIFT;
+}
+
+/**
+ * split a fresh page into slices of the class, the caller holds the lock
+ */
+static int swSlabPool_carve(swSlabPool *object, int class_id)
+{
+    if (object->page_used >= object->page_num)
+    {
+        return SW_ERR;
+    }
+
+    uint32_t slice_size = 1U << (class_id + SW_SLAB_MIN_SHIFT);
+    char *page = object->memory + (size_t) object->page_used * SW_SLAB_PAGE_SIZE;
+    char *cur;
+    swSlabPool_slice *slice;
+
+    object->page_class[object->page_used++] = class_id;
+
+    for (cur = page + SW_SLAB_PAGE_SIZE - slice_size; cur >= page; cur -= slice_size)
+    {
+        slice = (swSlabPool_slice *) cur;
+        slice->next = object->free_list[class_id];
+        object->free_list[class_id] = slice;
+    }
+    return SW_OK;
+}
+
+static swSlabPool_cache* swSlabPool_get_cache(swSlabPool *object)
+{
+    int i;
+    swSlabPool_cache *cache;
+    swSlabPool_cache **empty = NULL;
+
+    for (i = 0; i < SW_SLAB_CACHE_POOL_NUM; i++)
+    {
+        cache = swSlabPool_caches[i];
+        if (cache == NULL)
+        {
+            if (empty == NULL)
+            {
+                empty = &swSlabPool_caches[i];
+            }
+            continue;
+        }
+        if (cache->generation != swSlabPool_generation)
+        {
+            //inherited through fork(), the slices belong to the parent
+            cache->object = NULL;
+            cache->generation = swSlabPool_generation;
+        }
+        if (cache->object == object)
+        {
+            if (cache->id == object->id)
+            {
+                return cache;
+            }
+            //a destroyed pool at the same address
+            cache->object = NULL;
+        }
+        if (cache->object == NULL && empty == NULL)
+        {
+            empty = &swSlabPool_caches[i];
+        }
+    }
+
+    if (empty == NULL)
+    {
+        return NULL;
+    }
+    if (*empty == NULL)
+    {
+        *empty = sw_malloc(sizeof(swSlabPool_cache));
+        if (*empty == NULL)
+        {
+            return NULL;
+        }
+    }
+    cache = *empty;
+    bzero(cache->num, sizeof(cache->num));
+    cache->object = object;
+    cache->id = object->id;
+    cache->generation = swSlabPool_generation;
+    return cache;
+}
+
+static void* swSlabPool_alloc(swMemoryPool *pool, uint32_t size)
+{
+    swSlabPool *object = pool->object;
+    swSlabPool_slice *slice;
+
+    if (size > SW_SLAB_PAGE_SIZE)
+    {
+        swWarn("failed to alloc %d bytes, exceed the maximum size[%d].", size, SW_SLAB_PAGE_SIZE);
+        return NULL;
+    }
+
+    int class_id = swSlabPool_get_class(size);
+    swSlabPool_cache *cache = swSlabPool_get_cache(object);
+
+    if (cache && cache->num[class_id] > 0)
+    {
+        return cache->slices[class_id][--cache->num[class_id]];
+    }
+
+    object->lock.lock(&object->lock);
+    if (object->free_list[class_id] == NULL && swSlabPool_carve(object, class_id) < 0)
+    {
+        object->lock.unlock(&object->lock);
+        return NULL;
+    }
+    slice = object->free_list[class_id];
+    object->free_list[class_id] = slice->next;
+    //refill the cache while holding the lock
+    if (cache)
+    {
+        while (cache->num[class_id] < SW_SLAB_CACHE_SIZE / 2 && object->free_list[class_id])
+        {
+            cache->slices[class_id][cache->num[class_id]++] = object->free_list[class_id];
+            object->free_list[class_id] = object->free_list[class_id]->next;
+        }
+    }
+    object->lock.unlock(&object->lock);
+
+    return slice;
+}
+
+static void swSlabPool_free(swMemoryPool *pool, void *ptr)
+{
+    swSlabPool *object = pool->object;
+    size_t offset = (char *) ptr - (char *) object->memory;
+    uint32_t page_index = offset / SW_SLAB_PAGE_SIZE;
+
+    if ((char *) ptr < (char *) object->memory || page_index >= object->page_used)
+    {
+        swWarn("invalid pointer %p, not allocated from this pool.", ptr);
+        return;
+    }
+
+    int class_id = object->page_class[page_index];
+    swSlabPool_cache *cache = swSlabPool_get_cache(object);
+    swSlabPool_slice *slice;
+
+    if (cache && cache->num[class_id] < SW_SLAB_CACHE_SIZE)
+    {
+        cache->slices[class_id][cache->num[class_id]++] = ptr;
+        return;
+    }
+
+    object->lock.lock(&object->lock);
+    slice = ptr;
+    slice->next = object->free_list[class_id];
+    object->free_list[class_id] = slice;
+    //flush half of the full cache
+    if (cache)
+    {
+        while (cache->num[class_id] > SW_SLAB_CACHE_SIZE / 2)
+        {
+            slice = cache->slices[class_id][--cache->num[class_id]];
+            slice->next = object->free_list[class_id];
+            object->free_list[class_id] = slice;
+        }
+    }
+    object->lock.unlock(&object->lock);
+}
+
+static void swSlabPool_destroy(swMemoryPool *pool)
+{
+    swSlabPool *object = pool->object;
+    swSlabPool_cache *cache = swSlabPool_get_cache(object);
+    if (cache)
+    {
+        cache->object = NULL;
+    }
+    object->lock.free(&object->lock);
+    if (object->shared)
+    {
+        sw_shm_free(pool);
+    }
+    else
+    {
+        sw_free(pool);
+    }
+}
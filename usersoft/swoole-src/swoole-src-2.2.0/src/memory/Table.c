@@ -17,6 +17,8 @@
 #include "swoole.h"
 #include "table.h"
 
+#include <stddef.h>
+
 //#define SW_TABLE_DEBUG 1
 #define SW_TABLE_USE_PHP_HASH
 
@@ -26,7 +28,15 @@ static int insert_count = 0;
 static int conflict_max_level = 0;
 #endif
 
+/**
+ * buckets of the old segment moved by each set() while the table grows
+ */
+#define SW_TABLE_MIGRATE_STEP      2
+#define SW_TABLE_ALIGN(size)       (((size) + 63) & ~((size_t) 63))
+
 static void swTableColumn_free(swTableColumn *col);
+static int swTable_probe_create(swTable *table);
+static size_t swTable_probe_memory_size(swTable *table);
 
 static void swTableColumn_free(swTableColumn *col)
 {
@@ -84,6 +94,9 @@ swTable* swTable_new(uint32_t rows_size, float conflict_proportion)
     table->size = rows_size;
     table->mask = rows_size - 1;
     table->conflict_proportion = conflict_proportion;
+    table->max_size = 0;
+    table->evict = 0;
+    table->clock_hand = 0;
 
     bzero(table->iterator, sizeof(swTable_iterator));
     table->memory = NULL;
@@ -149,6 +162,11 @@ int swTableColumn_add(swTable *table, char *name, int len, int type, int size)
 
 size_t swTable_get_memory_size(swTable *table)
 {
+    if (table->max_size)
+    {
+        return swTable_probe_memory_size(table);
+    }
+
     /**
      * table size + conflict size
      */
@@ -179,6 +197,11 @@ size_t swTable_get_memory_size(swTable *table)
 
 int swTable_create(swTable *table)
 {
+    if (table->max_size)
+    {
+        return swTable_probe_create(table);
+    }
+
     size_t memory_size = swTable_get_memory_size(table);
     size_t row_memory_size = sizeof(swTableRow) + table->item_size;
 
@@ -247,6 +270,687 @@ static sw_inline swTableRow* swTable_hash(swTable *table, char *key, int keylen)
     return table->rows[index];
 }
 
+/**
+ * remove a row from the collision list of head, the caller holds the lock of head
+ * and has waited for the pins
+ */
+static void swTable_remove_row(swTable *table, swTableRow *head, swTableRow *prev, swTableRow *row)
+{
+    if (row == head && row->next == NULL)
+    {
+        //keep the lock and version of the root row
+        bzero(&row->active, sizeof(swTableRow) - offsetof(swTableRow, active) + table->item_size);
+    }
+    else
+    {
+        //when the deleting element is root, we should move the first element's data to root,
+        //and remove the element from the collision list.
+        if (row == head)
+        {
+            row = head->next;
+            head->next = row->next;
+            memcpy(head->key, row->key, SW_TABLE_KEY_SIZE);
+            memcpy(head->data, row->data, table->item_size);
+            head->referenced = row->referenced;
+            head->expire = row->expire;
+        }
+        else
+        {
+            prev->next = row->next;
+        }
+        table->lock.lock(&table->lock);
+        bzero(row, sizeof(swTableRow) + table->item_size);
+        table->pool->free(table->pool, row);
+        table->lock.unlock(&table->lock);
+    }
+    sw_atomic_fetch_sub(&(table->row_num), 1);
+}
+
+/**
+ * CLOCK sweep over the collision lists when the pool of conflict rows is exhausted:
+ * the first expired row, or row not accessed since the hand last passed, is removed,
+ * the rows before it lose their referenced bit.
+ * Lists locked by other writers are skipped, so a full table never deadlocks on eviction.
+ */
+static int swTable_evict(swTable *table, swTableRow *self)
+{
+    uint32_t n;
+
+    for (n = 0; n < table->size * 2; n++)
+    {
+        swTableRow *head = table->rows[sw_atomic_fetch_add(&table->clock_hand, 1) & table->mask];
+        //only the rows of collision lists come from the pool
+        if (head == self || head->next == NULL || swTableRow_trylock(head) < 0)
+        {
+            continue;
+        }
+        if (head->next == NULL)
+        {
+            swTableRow_unlock(head);
+            continue;
+        }
+
+        swTableRow *row;
+        swTableRow *prev = NULL;
+        for (row = head; row; prev = row, row = row->next)
+        {
+            if (row->referenced && !swTableRow_expired(row))
+            {
+                row->referenced = 0;
+                continue;
+            }
+            swTableRow_wait_unpinned(head);
+            swTable_remove_row(table, head, prev, row);
+            break;
+        }
+        swTableRow_unlock(head);
+        if (row)
+        {
+            return SW_OK;
+        }
+    }
+    return SW_ERR;
+}
+
+/**
+ * set() on an expired row starts it over, the caller holds the lock
+ */
+static sw_inline void swTable_reuse_expired(swTable *table, swTableRow *row)
+{
+    if (swTableRow_expired(row))
+    {
+        bzero(row->data, table->item_size);
+        row->expire = 0;
+    }
+    row->referenced = 1;
+}
+
+/**
+ * Probing engine
+ * ----------------------------------------------------------------------------
+ * The table is a chain of segments of doubling capacity, all carved out of one
+ * shared memory region at create time: a shared mapping can not be grown once the
+ * workers have forked, so the address space for max_size rows is reserved up front
+ * and only the pages that get written are backed by memory.
+ * A key lives in its home bucket of the current segment or in the first buckets
+ * after it. When the current segment is 3/4 full the next one is activated and
+ * every set() moves a few buckets to it, the keys of a moved bucket live in the
+ * next segment.
+ */
+static sw_inline uint64_t swTable_probe_hash(char *key, int keylen)
+{
+#ifdef SW_TABLE_USE_PHP_HASH
+    uint64_t hashv = swoole_hash_php(key, keylen);
+#else
+    uint64_t hashv = swoole_hash_austin(key, keylen);
+#endif
+    return hashv * 0x9E3779B97F4A7C15ULL;
+}
+
+static sw_inline uint16_t swTable_probe_fingerprint(uint64_t hash)
+{
+    uint16_t fp = hash >> 48;
+    return fp < SW_TABLE_SLOT_USED ? fp + SW_TABLE_SLOT_USED : fp;
+}
+
+static sw_inline uint32_t swTable_probe_home(swTableSegment *seg, uint64_t hash)
+{
+    return (uint32_t) (hash >> 16) & seg->mask;
+}
+
+static sw_inline swTableRow* swTableSegment_row(swTable *table, swTableSegment *seg, uint32_t bucket, int slot)
+{
+    size_t index = (size_t) bucket * SW_TABLE_BUCKET_SLOTS + slot;
+    return (swTableRow *) (seg->rows + index * (sizeof(swTableRow) + table->item_size));
+}
+
+static sw_inline int swTable_probe_equal(swTableRow *row, char *key, int keylen)
+{
+    return memcmp(row->key, key, keylen) == 0 && (keylen == SW_TABLE_KEY_SIZE || row->key[keylen] == '\0');
+}
+
+static size_t swTable_probe_max_size(swTable *table)
+{
+    size_t max_size = table->size;
+    while (max_size < table->max_size && max_size < 0x80000000)
+    {
+        max_size <<= 1;
+    }
+    return max_size;
+}
+
+static size_t swTable_probe_memory_size(swTable *table)
+{
+    size_t row_memory_size = sizeof(swTableRow) + table->item_size;
+    size_t max_size = swTable_probe_max_size(table);
+    size_t memory_size = 64;
+    size_t n;
+
+    for (n = table->size; n <= max_size; n <<= 1)
+    {
+        memory_size += (n / SW_TABLE_BUCKET_SLOTS) * sizeof(swTableBucket);
+        memory_size += SW_TABLE_ALIGN(n * row_memory_size);
+    }
+    return memory_size;
+}
+
+static void swTableSegment_activate(swTable *table, swTableSegment *seg)
+{
+#if SW_TABLE_USE_SPINLOCK == 0
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutexattr_setrobust_np(&attr, PTHREAD_MUTEX_ROBUST_NP);
+
+    uint32_t i;
+    int j;
+    for (i = 0; i < seg->bucket_num; i++)
+    {
+        for (j = 0; j < SW_TABLE_BUCKET_SLOTS; j++)
+        {
+            pthread_mutex_init(&swTableSegment_row(table, seg, i, j)->lock, &attr);
+        }
+    }
+#endif
+}
+
+static int swTable_probe_create(swTable *table)
+{
+    size_t row_memory_size = sizeof(swTableRow) + table->item_size;
+    size_t max_size = swTable_probe_max_size(table);
+    size_t memory_size = swTable_get_memory_size(table);
+
+    /**
+     * fresh anonymous pages are zero: every slot starts empty
+     */
+    void *memory = sw_shm_malloc(memory_size);
+    if (memory == NULL)
+    {
+        return SW_ERR;
+    }
+
+    table->memory_size = memory_size;
+    table->memory = memory;
+    table->rows = NULL;
+    table->pool = NULL;
+
+    char *p = (char *) SW_TABLE_ALIGN((uintptr_t) memory);
+    size_t n;
+
+    table->segment_num = 0;
+    for (n = table->size; n <= max_size; n <<= 1)
+    {
+        swTableSegment *seg = &table->segments[table->segment_num++];
+        seg->bucket_num = n / SW_TABLE_BUCKET_SLOTS;
+        seg->mask = seg->bucket_num - 1;
+        seg->used = 0;
+        seg->buckets = (swTableBucket *) p;
+        p += seg->bucket_num * sizeof(swTableBucket);
+        seg->rows = p;
+        p += SW_TABLE_ALIGN(n * row_memory_size);
+    }
+
+    table->current = &table->segments[0];
+    table->next = NULL;
+    table->migrate_index = 0;
+    table->moved_num = 0;
+    swTableSegment_activate(table, table->current);
+
+    return SW_OK;
+}
+
+static swTableRow* swTableSegment_find(swTable *table, swTableSegment *seg, uint64_t hash, char *key, int keylen)
+{
+    uint16_t fp = swTable_probe_fingerprint(hash);
+    uint32_t bucket = swTable_probe_home(seg, hash);
+    uint32_t n;
+    int i;
+
+    for (n = 0; n < seg->bucket_num; n++, bucket = (bucket + 1) & seg->mask)
+    {
+        volatile uint16_t *fingerprint = seg->buckets[bucket].fingerprint;
+        for (i = 0; i < SW_TABLE_BUCKET_SLOTS; i++)
+        {
+            if (fingerprint[i] == SW_TABLE_SLOT_EMPTY)
+            {
+                return NULL;
+            }
+            else if (fingerprint[i] == fp)
+            {
+                swTableRow *row = swTableSegment_row(table, seg, bucket, i);
+                if (row->hash == hash && swTable_probe_equal(row, key, keylen))
+                {
+                    return row;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * the caller holds the lock of the home bucket, slots are claimed with CAS because
+ * keys of other home buckets probe through the same slots
+ */
+static swTableRow* swTableSegment_insert(swTable *table, swTableSegment *seg, uint64_t hash, char *key, int keylen)
+{
+    uint32_t bucket = swTable_probe_home(seg, hash);
+    uint32_t n;
+    int i;
+
+    for (n = 0; n < seg->bucket_num; n++, bucket = (bucket + 1) & seg->mask)
+    {
+        volatile uint16_t *fingerprint = seg->buckets[bucket].fingerprint;
+        for (i = 0; i < SW_TABLE_BUCKET_SLOTS; i++)
+        {
+            uint16_t fp = fingerprint[i];
+            if (fp != SW_TABLE_SLOT_EMPTY && fp != SW_TABLE_SLOT_DELETED)
+            {
+                continue;
+            }
+            if (!sw_atomic_cmp_set(&fingerprint[i], fp, SW_TABLE_SLOT_BUSY))
+            {
+                continue;
+            }
+            if (fp == SW_TABLE_SLOT_EMPTY)
+            {
+                sw_atomic_fetch_add(&seg->used, 1);
+            }
+
+            swTableRow *row = swTableSegment_row(table, seg, bucket, i);
+            memcpy(row->key, key, keylen);
+            if (keylen < SW_TABLE_KEY_SIZE)
+            {
+                row->key[keylen] = '\0';
+            }
+            row->hash = hash;
+            row->active = 1;
+            sw_atomic_memory_barrier();
+            fingerprint[i] = swTable_probe_fingerprint(hash);
+            return row;
+        }
+    }
+    return NULL;
+}
+
+static void swTableSegment_remove(swTable *table, swTableSegment *seg, swTableRow *row)
+{
+    size_t index = ((char *) row - seg->rows) / (sizeof(swTableRow) + table->item_size);
+    seg->buckets[index / SW_TABLE_BUCKET_SLOTS].fingerprint[index % SW_TABLE_BUCKET_SLOTS] = SW_TABLE_SLOT_DELETED;
+    //keep the lock and version, the first row of a bucket guards the whole bucket
+    bzero(&row->active, sizeof(swTableRow) - offsetof(swTableRow, active) + table->item_size);
+}
+
+/**
+ * move the keys whose home is the given bucket to the next segment,
+ * the caller holds the lock of the bucket
+ */
+static void swTable_move_bucket(swTable *table, swTableSegment *seg, uint32_t home)
+{
+    swTableSegment *next = seg + 1;
+    uint32_t bucket = home;
+    uint32_t n;
+    int i;
+
+    swTableRow_wait_unpinned(swTableSegment_row(table, seg, home, 0));
+
+    for (n = 0; n < seg->bucket_num; n++, bucket = (bucket + 1) & seg->mask)
+    {
+        volatile uint16_t *fingerprint = seg->buckets[bucket].fingerprint;
+        for (i = 0; i < SW_TABLE_BUCKET_SLOTS; i++)
+        {
+            if (fingerprint[i] == SW_TABLE_SLOT_EMPTY)
+            {
+                goto moved;
+            }
+            else if (fingerprint[i] < SW_TABLE_SLOT_USED)
+            {
+                continue;
+            }
+
+            swTableRow *row = swTableSegment_row(table, seg, bucket, i);
+            if (swTable_probe_home(seg, row->hash) != home)
+            {
+                continue;
+            }
+
+            swTableRow *lock = swTableSegment_row(table, next, swTable_probe_home(next, row->hash), 0);
+            swTableRow_lock(lock);
+            swTableRow *new_row = swTableSegment_insert(table, next, row->hash, row->key, SW_TABLE_KEY_SIZE);
+            if (new_row)
+            {
+                memcpy(new_row->data, row->data, table->item_size);
+            }
+            swTableRow_unlock(lock);
+
+            if (!new_row)
+            {
+                swWarn("no free slot in the next segment, key [%s] is dropped.", row->key);
+                sw_atomic_fetch_sub(&table->row_num, 1);
+            }
+            swTableSegment_remove(table, seg, row);
+        }
+    }
+
+    moved:
+    sw_atomic_memory_barrier();
+    seg->buckets[home].moved = 1;
+
+    if (sw_atomic_add_fetch(&table->moved_num, 1) == seg->bucket_num)
+    {
+        table->lock.lock(&table->lock);
+        table->current = next;
+        table->next = NULL;
+        table->lock.unlock(&table->lock);
+    }
+}
+
+/**
+ * lock the home bucket of the key in the segment that holds it
+ */
+static swTableRow* swTable_probe_lock(swTable *table, uint64_t hash, swTableSegment **segment)
+{
+    swTableSegment *seg = table->current;
+
+    for (;;)
+    {
+        uint32_t home = swTable_probe_home(seg, hash);
+        swTableRow *lock = swTableSegment_row(table, seg, home, 0);
+        swTableRow_lock(lock);
+        if (!seg->buckets[home].moved)
+        {
+            if (table->next != seg + 1)
+            {
+                *segment = seg;
+                return lock;
+            }
+            swTable_move_bucket(table, seg, home);
+        }
+        swTableRow_unlock(lock);
+        seg++;
+    }
+}
+
+/**
+ * start growing when the current segment is 3/4 full, and move a few buckets while it grows
+ */
+static void swTable_probe_grow(swTable *table)
+{
+    swTableSegment *seg = table->current;
+
+    if (table->next == NULL)
+    {
+        if (seg + 1 >= table->segments + table->segment_num
+                || (uint64_t) seg->used * 4 < (uint64_t) seg->bucket_num * SW_TABLE_BUCKET_SLOTS * 3)
+        {
+            return;
+        }
+        table->lock.lock(&table->lock);
+        if (table->next == NULL && table->current == seg)
+        {
+            swTableSegment_activate(table, seg + 1);
+            table->migrate_index = 0;
+            table->moved_num = 0;
+            sw_atomic_memory_barrier();
+            table->next = seg + 1;
+        }
+        table->lock.unlock(&table->lock);
+    }
+
+    int i;
+    for (i = 0; i < SW_TABLE_MIGRATE_STEP; i++)
+    {
+        uint32_t home = sw_atomic_fetch_add(&table->migrate_index, 1);
+        swTableSegment *next = table->next;
+        if (next == NULL)
+        {
+            return;
+        }
+        seg = next - 1;
+        if (home >= seg->bucket_num)
+        {
+            return;
+        }
+        swTableRow *lock = swTableSegment_row(table, seg, home, 0);
+        swTableRow_lock(lock);
+        if (!seg->buckets[home].moved)
+        {
+            swTable_move_bucket(table, seg, home);
+        }
+        swTableRow_unlock(lock);
+    }
+}
+
+/**
+ * CLOCK sweep over the slots of a full segment: expired rows and rows not accessed since
+ * the hand last passed are removed, the others lose their referenced bit.
+ * The home buckets are only tried, a writer holding one keeps its rows.
+ */
+static int swTable_probe_evict(swTable *table, swTableSegment *seg, swTableRow *self)
+{
+    uint32_t slot_num = seg->bucket_num * SW_TABLE_BUCKET_SLOTS;
+    uint32_t n;
+
+    for (n = 0; n < slot_num * 2; n++)
+    {
+        uint32_t index = sw_atomic_fetch_add(&table->clock_hand, 1) & (slot_num - 1);
+        uint32_t bucket = index / SW_TABLE_BUCKET_SLOTS;
+        int i = index % SW_TABLE_BUCKET_SLOTS;
+
+        if (seg->buckets[bucket].fingerprint[i] < SW_TABLE_SLOT_USED)
+        {
+            continue;
+        }
+        swTableRow *row = swTableSegment_row(table, seg, bucket, i);
+        swTableRow *lock = swTableSegment_row(table, seg, swTable_probe_home(seg, row->hash), 0);
+        if (lock != self && swTableRow_trylock(lock) < 0)
+        {
+            continue;
+        }
+        //the slot may have changed before the lock was taken
+        int evicted = 0;
+        if (seg->buckets[bucket].fingerprint[i] >= SW_TABLE_SLOT_USED
+                && swTableSegment_row(table, seg, swTable_probe_home(seg, row->hash), 0) == lock)
+        {
+            if (row->referenced && !swTableRow_expired(row))
+            {
+                row->referenced = 0;
+            }
+            else
+            {
+                swTableRow_wait_unpinned(lock);
+                swTableSegment_remove(table, seg, row);
+                sw_atomic_fetch_sub(&(table->row_num), 1);
+                evicted = 1;
+            }
+        }
+        if (lock != self)
+        {
+            swTableRow_unlock(lock);
+        }
+        if (evicted)
+        {
+            return SW_OK;
+        }
+    }
+    return SW_ERR;
+}
+
+static swTableRow* swTable_probe_get(swTable *table, char *key, int keylen, swTableRow** rowlock)
+{
+    uint64_t hash = swTable_probe_hash(key, keylen);
+    swTableSegment *seg;
+
+    *rowlock = swTable_probe_lock(table, hash, &seg);
+    swTableRow *row = swTableSegment_find(table, seg, hash, key, keylen);
+    if (row && swTableRow_touch(row) < 0)
+    {
+        return NULL;
+    }
+    return row;
+}
+
+static int swTable_probe_get_copy(swTable *table, char *key, int keylen, swTableRow *copy)
+{
+    uint64_t hash = swTable_probe_hash(key, keylen);
+    swTableSegment *seg = table->current;
+    swTableRow *row;
+    uint32_t version;
+
+    for (;;)
+    {
+        uint32_t home = swTable_probe_home(seg, hash);
+        swTableRow *lock = swTableSegment_row(table, seg, home, 0);
+
+        version = lock->version;
+        if (version & 1)
+        {
+            sw_atomic_cpu_pause();
+            continue;
+        }
+        sw_atomic_memory_barrier();
+
+        if (seg->buckets[home].moved)
+        {
+            seg++;
+            continue;
+        }
+        row = swTableSegment_find(table, seg, hash, key, keylen);
+        if (row && swTableRow_touch(row) < 0)
+        {
+            row = NULL;
+        }
+        if (row && copy)
+        {
+            memcpy(copy, row, sizeof(swTableRow) + table->item_size);
+        }
+
+        sw_atomic_memory_barrier();
+        if (lock->version == version)
+        {
+            return row ? SW_OK : SW_ERR;
+        }
+    }
+}
+
+static swTableRow* swTable_probe_pin(swTable *table, char *key, int keylen, swTableRow **rowlock)
+{
+    uint64_t hash = swTable_probe_hash(key, keylen);
+    swTableSegment *seg = table->current;
+
+    for (;;)
+    {
+        uint32_t home = swTable_probe_home(seg, hash);
+        swTableRow *lock = swTableSegment_row(table, seg, home, 0);
+
+        sw_atomic_fetch_add(&lock->pinned, 1);
+        if (lock->version & 1)
+        {
+            swTableRow_unpin(lock);
+            return NULL;
+        }
+        if (seg->buckets[home].moved)
+        {
+            swTableRow_unpin(lock);
+            seg++;
+            continue;
+        }
+        swTableRow *row = swTableSegment_find(table, seg, hash, key, keylen);
+        if (row == NULL || swTableRow_touch(row) < 0)
+        {
+            swTableRow_unpin(lock);
+            return NULL;
+        }
+        *rowlock = lock;
+        return row;
+    }
+}
+
+static swTableRow* swTable_probe_set(swTable *table, char *key, int keylen, swTableRow **rowlock)
+{
+    swTable_probe_grow(table);
+
+    uint64_t hash = swTable_probe_hash(key, keylen);
+    swTableSegment *seg;
+
+    *rowlock = swTable_probe_lock(table, hash, &seg);
+    swTableRow *row = swTableSegment_find(table, seg, hash, key, keylen);
+    if (row)
+    {
+        swTable_reuse_expired(table, row);
+        return row;
+    }
+    for (;;)
+    {
+        row = swTableSegment_insert(table, seg, hash, key, keylen);
+        if (row)
+        {
+            row->referenced = 1;
+            sw_atomic_fetch_add(&(table->row_num), 1);
+            return row;
+        }
+        if (!table->evict || table->next || swTable_probe_evict(table, seg, *rowlock) < 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+static int swTable_probe_del(swTable *table, char *key, int keylen)
+{
+    uint64_t hash = swTable_probe_hash(key, keylen);
+    swTableSegment *seg;
+
+    swTableRow *lock = swTable_probe_lock(table, hash, &seg);
+    swTableRow *row = swTableSegment_find(table, seg, hash, key, keylen);
+    if (row == NULL)
+    {
+        swTableRow_unlock(lock);
+        return SW_ERR;
+    }
+    swTableRow_wait_unpinned(lock);
+    swTableSegment_remove(table, seg, row);
+    sw_atomic_fetch_sub(&(table->row_num), 1);
+    swTableRow_unlock(lock);
+
+    return SW_OK;
+}
+
+/**
+ * iterator: collision_index is the segment, absolute_index the slot in it
+ */
+static void swTable_probe_iterator_forward(swTable *table)
+{
+    swTable_iterator *iterator = table->iterator;
+    swTableSegment *current = table->current;
+    uint32_t first = current - table->segments;
+    uint32_t last = table->next ? first + 1 : first;
+
+    if (iterator->collision_index < first)
+    {
+        iterator->collision_index = first;
+        iterator->absolute_index = 0;
+    }
+    for (; iterator->collision_index <= last; iterator->collision_index++, iterator->absolute_index = 0)
+    {
+        swTableSegment *seg = &table->segments[iterator->collision_index];
+        uint32_t slot_num = seg->bucket_num * SW_TABLE_BUCKET_SLOTS;
+        for (; iterator->absolute_index < slot_num; iterator->absolute_index++)
+        {
+            uint32_t bucket = iterator->absolute_index / SW_TABLE_BUCKET_SLOTS;
+            int i = iterator->absolute_index % SW_TABLE_BUCKET_SLOTS;
+            if (seg->buckets[bucket].fingerprint[i] >= SW_TABLE_SLOT_USED)
+            {
+                iterator->row = swTableSegment_row(table, seg, bucket, i);
+                iterator->absolute_index++;
+                return;
+            }
+        }
+    }
+    iterator->row = NULL;
+}
+
 void swTable_iterator_rewind(swTable *table)
 {
     bzero(table->iterator, sizeof(swTable_iterator));
@@ -263,7 +967,7 @@ swTableRow* swTable_iterator_current(swTable *table)
     return table->iterator->row;
 }
 
-void swTable_iterator_forward(swTable *table)
+static void swTable_chain_iterator_forward(swTable *table)
 {
     for (; table->iterator->absolute_index < table->size; table->iterator->absolute_index++)
     {
@@ -301,12 +1005,31 @@ void swTable_iterator_forward(swTable *table)
     table->iterator->row = NULL;
 }
 
+void swTable_iterator_forward(swTable *table)
+{
+    do
+    {
+        if (table->max_size)
+        {
+            swTable_probe_iterator_forward(table);
+        }
+        else
+        {
+            swTable_chain_iterator_forward(table);
+        }
+    } while (table->iterator->row && swTableRow_expired(table->iterator->row));
+}
+
 swTableRow* swTableRow_get(swTable *table, char *key, int keylen, swTableRow** rowlock)
 {
     if (keylen > SW_TABLE_KEY_SIZE)
     {
         keylen = SW_TABLE_KEY_SIZE;
     }
+    if (table->max_size)
+    {
+        return swTable_probe_get(table, key, keylen, rowlock);
+    }
 
     swTableRow *row = swTable_hash(table, key, keylen);
     *rowlock = row;
@@ -316,7 +1039,7 @@ swTableRow* swTableRow_get(swTable *table, char *key, int keylen, swTableRow** r
     {
         if (strncmp(row->key, key, keylen) == 0)
         {
-            if (!row->active)
+            if (!row->active || swTableRow_touch(row) < 0)
             {
                 row = NULL;
             }
@@ -336,12 +1059,126 @@ swTableRow* swTableRow_get(swTable *table, char *key, int keylen, swTableRow** r
     return row;
 }
 
+/**
+ * Lock-free read: copy the row to the caller's buffer, which holds sizeof(swTableRow) + item_size
+ * bytes, or only check that the key exists if copy is NULL.
+ * Writers bump the version of the first row in the collision list while holding its lock,
+ * so the copy is retried until that version is even and unchanged across the read.
+ */
+int swTableRow_get_copy(swTable *table, char *key, int keylen, swTableRow *copy)
+{
+    if (keylen > SW_TABLE_KEY_SIZE)
+    {
+        keylen = SW_TABLE_KEY_SIZE;
+    }
+    if (table->max_size)
+    {
+        return swTable_probe_get_copy(table, key, keylen, copy);
+    }
+
+    swTableRow *head = swTable_hash(table, key, keylen);
+    swTableRow *row;
+    uint32_t version;
+    size_t n;
+
+    for (;;)
+    {
+        version = head->version;
+        if (version & 1)
+        {
+            sw_atomic_cpu_pause();
+            continue;
+        }
+        sw_atomic_memory_barrier();
+
+        /**
+         * rows unlinked by a writer stay inside the table memory, so the walk is safe,
+         * but its length is bounded in case it runs into a recycled row.
+         */
+        row = head;
+        for (n = 0; row && n <= table->size; n++)
+        {
+            if (strncmp(row->key, key, keylen) == 0)
+            {
+                break;
+            }
+            row = row->next;
+        }
+        if (row && (!row->active || swTableRow_touch(row) < 0))
+        {
+            row = NULL;
+        }
+        if (row && copy)
+        {
+            memcpy(copy, row, sizeof(swTableRow) + table->item_size);
+        }
+
+        sw_atomic_memory_barrier();
+        if (head->version == version)
+        {
+            break;
+        }
+    }
+
+    return row ? SW_OK : SW_ERR;
+}
+
+/**
+ * Find the row for a lock-free column update, or return NULL if it does not exist or a writer
+ * holds the lock, then the caller takes the locked path.
+ * The pin is taken before the version is read and writers wait for pins after bumping it,
+ * so a writer either sees the pin or the pin sees the writer.
+ */
+swTableRow* swTableRow_pin(swTable *table, char *key, int keylen, swTableRow **rowlock)
+{
+    if (keylen > SW_TABLE_KEY_SIZE)
+    {
+        keylen = SW_TABLE_KEY_SIZE;
+    }
+    if (table->max_size)
+    {
+        return swTable_probe_pin(table, key, keylen, rowlock);
+    }
+
+    swTableRow *head = swTable_hash(table, key, keylen);
+    swTableRow *row;
+    size_t n;
+
+    sw_atomic_fetch_add(&head->pinned, 1);
+    if (head->version & 1)
+    {
+        swTableRow_unpin(head);
+        return NULL;
+    }
+
+    row = head;
+    for (n = 0; row && n <= table->size; n++)
+    {
+        if (strncmp(row->key, key, keylen) == 0)
+        {
+            break;
+        }
+        row = row->next;
+    }
+    if (row == NULL || !row->active || swTableRow_touch(row) < 0)
+    {
+        swTableRow_unpin(head);
+        return NULL;
+    }
+    *rowlock = head;
+    return row;
+}
+
 swTableRow* swTableRow_set(swTable *table, char *key, int keylen, swTableRow **rowlock)
 {
     if (keylen > SW_TABLE_KEY_SIZE)
     {
         keylen = SW_TABLE_KEY_SIZE;
     }
+    if (table->max_size)
+    {
+        return swTable_probe_set(table, key, keylen, rowlock);
+    }
 
     swTableRow *row = swTable_hash(table, key, keylen);
     *rowlock = row;
@@ -357,6 +1194,7 @@ swTableRow* swTableRow_set(swTable *table, char *key, int keylen, swTableRow **r
         {
             if (strncmp(row->key, key, keylen) == 0)
             {
+                swTable_reuse_expired(table, row);
                 break;
             }
             else if (row->next == NULL)
@@ -376,7 +1214,11 @@ swTableRow* swTableRow_set(swTable *table, char *key, int keylen, swTableRow **r
 
                 if (!new_row)
                 {
-                    return NULL;
+                    if (!table->evict || swTable_evict(table, *rowlock) < 0)
+                    {
+                        return NULL;
+                    }
+                    continue;
                 }
                 //add row_num
                 bzero(new_row, sizeof(swTableRow));
@@ -404,6 +1246,7 @@ swTableRow* swTableRow_set(swTable *table, char *key, int keylen, swTableRow **r
 
     memcpy(row->key, key, keylen);
     row->active = 1;
+    row->referenced = 1;
     return row;
 }
 
@@ -413,6 +1256,10 @@ int swTableRow_del(swTable *table, char *key, int keylen)
     {
         keylen = SW_TABLE_KEY_SIZE;
     }
+    if (table->max_size)
+    {
+        return swTable_probe_del(table, key, keylen);
+    }
 
     swTableRow *row = swTable_hash(table, key, keylen);
     //no exists
@@ -422,61 +1269,28 @@ int swTableRow_del(swTable *table, char *key, int keylen)
     }
 
     swTableRow_lock(row);
-    if (row->next == NULL)
-    {
-        if (strncmp(row->key, key, keylen) == 0)
-        {
-            bzero(row, sizeof(swTableRow) + table->item_size);
-            goto delete_element;
-        }
-        else
-        {
-            goto not_exists;
-        }
-    }
-    else
-    {
-        swTableRow *tmp = row;
-        swTableRow *prev = NULL;
+    swTableRow_wait_unpinned(row);
 
-        while (tmp)
-        {
-            if ((strncmp(tmp->key, key, keylen) == 0))
-            {
-                break;
-            }
-            prev = tmp;
-            tmp = tmp->next;
-        }
+    swTableRow *tmp = row;
+    swTableRow *prev = NULL;
 
-        if (tmp == NULL)
+    while (tmp)
+    {
+        if ((strncmp(tmp->key, key, keylen) == 0))
         {
-            not_exists:
-            swTableRow_unlock(row);
-            return SW_ERR;
+            break;
         }
+        prev = tmp;
+        tmp = tmp->next;
+    }
 
-        //when the deleting element is root, we should move the first element's data to root,
-        //and remove the element from the collision list.
-        if (tmp == row)
-        {
-            tmp = tmp->next;
-            row->next = tmp->next;
-            memcpy(row->key, tmp->key, strlen(tmp->key));
-            memcpy(row->data, tmp->data, table->item_size);
-        }
-        if (prev)
-        {
-            prev->next = tmp->next;
-        }
-        table->lock.lock(&table->lock);
-        bzero(tmp, sizeof(swTableRow) + table->item_size);
-        table->pool->free(table->pool, tmp);
-        table->lock.unlock(&table->lock);
+    if (tmp == NULL || !tmp->active)
+    {
+        swTableRow_unlock(row);
+        return SW_ERR;
     }
 
-    delete_element:
-    sw_atomic_fetch_sub(&(table->row_num), 1);
+    swTable_remove_row(table, row, prev, tmp);
     swTableRow_unlock(row);
 
     return SW_OK;
@@ -21,6 +21,12 @@
 
 #include <sys/stat.h>
 
+#ifdef HAVE_MSG_ZEROCOPY
+#include <linux/errqueue.h>
+
+static void swConnection_zerocopy_hold(swConnection *conn, swBuffer *buffer, swBuffer_trunk *chunk);
+#endif
+
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL        0
 #endif
@@ -126,6 +132,10 @@ int swConnection_onSendfile(swConnection *conn, swBuffer_trunk *chunk)
 int swConnection_buffer_send(swConnection *conn)
 {
     int ret, sendn;
+    int flags = 0;
+#ifdef HAVE_MSG_ZEROCOPY
+    swConnection_ext *ext = NULL;
+#endif
 
     swBuffer *buffer = conn->out_buffer;
     swBuffer_trunk *trunk = swBuffer_get_trunk(buffer);
@@ -137,7 +147,31 @@ int swConnection_buffer_send(swConnection *conn)
         return SW_OK;
     }
 
-    ret = swConnection_send(conn, trunk->store.ptr + trunk->offset, sendn, 0);
+#ifdef HAVE_MSG_ZEROCOPY
+    if (conn->zerocopy && sendn >= SW_ZEROCOPY_MIN_SIZE && (ext = swConnection_get_ext(conn)) != NULL
+            && ext->zerocopy_next - ext->zerocopy_done < SW_ZEROCOPY_MAX_PENDING)
+    {
+        flags = MSG_ZEROCOPY;
+    }
+    do_send:
+#endif
+    ret = swConnection_send(conn, trunk->store.ptr + trunk->offset, sendn, flags);
+#ifdef HAVE_MSG_ZEROCOPY
+    if (flags == MSG_ZEROCOPY)
+    {
+        if (ret >= 0)
+        {
+            trunk->zerocopy = 1;
+            trunk->zerocopy_id = ext->zerocopy_next++;
+        }
+        //socket option memory is exhausted, copy the data this time
+        else if (errno == ENOBUFS)
+        {
+            flags = 0;
+            goto do_send;
+        }
+    }
+#endif
     if (ret < 0)
     {
         switch (swConnection_error(errno))
@@ -160,6 +194,13 @@ int swConnection_buffer_send(swConnection *conn)
     //trunk full send
     else if (ret == sendn || sendn == 0)
     {
+#ifdef HAVE_MSG_ZEROCOPY
+        if (trunk->zerocopy)
+        {
+            swConnection_zerocopy_hold(conn, buffer, trunk);
+            return SW_OK;
+        }
+#endif
         swBuffer_pop_trunk(buffer, trunk);
     }
     else
@@ -169,6 +210,191 @@ int swConnection_buffer_send(swConnection *conn)
     return SW_OK;
 }
 
+#ifdef HAVE_MSG_ZEROCOPY
+/**
+ * move a chunk sent with MSG_ZEROCOPY from the output buffer to the list waiting for completion
+ */
+static void swConnection_zerocopy_hold(swConnection *conn, swBuffer *buffer, swBuffer_trunk *chunk)
+{
+    swConnection_ext *ext = conn->ext;
+
+    if (chunk->next == NULL)
+    {
+        buffer->head = NULL;
+        buffer->tail = NULL;
+        buffer->length = 0;
+        buffer->trunk_num = 0;
+    }
+    else
+    {
+        buffer->head = chunk->next;
+        buffer->length -= chunk->length;
+        buffer->trunk_num--;
+    }
+    chunk->next = NULL;
+    if (ext->zerocopy_tail)
+    {
+        ext->zerocopy_tail->next = chunk;
+    }
+    else
+    {
+        ext->zerocopy_head = chunk;
+    }
+    ext->zerocopy_tail = chunk;
+}
+
+/**
+ * read MSG_ZEROCOPY completions from the error queue and free the chunks the kernel is done with.
+ * return the number of notifications.
+ */
+int swConnection_zerocopy_reap(swConnection *conn)
+{
+    char control[128];
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    struct sock_extended_err *serr;
+    swBuffer_trunk *chunk;
+    swConnection_ext *ext = conn->ext;
+    uint32_t i, count, offset;
+    int n = 0;
+
+    while (1)
+    {
+        bzero(&msg, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(conn->fd, &msg, MSG_ERRQUEUE) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            else if (errno == EAGAIN)
+            {
+                break;
+            }
+            return SW_ERR;
+        }
+
+        for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                    && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+            serr = (struct sock_extended_err *) CMSG_DATA(cm);
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+            //sends [ee_info, ee_data] are completed, they may arrive out of order
+            count = serr->ee_data - serr->ee_info + 1;
+            for (i = 0; i < count; i++)
+            {
+                offset = serr->ee_info + i - ext->zerocopy_done;
+                if (offset < SW_ZEROCOPY_MAX_PENDING)
+                {
+                    ext->zerocopy_mask |= (1ULL << offset);
+                }
+            }
+            n++;
+        }
+    }
+
+    while (ext->zerocopy_mask & 1)
+    {
+        ext->zerocopy_mask >>= 1;
+        ext->zerocopy_done++;
+    }
+
+    while ((chunk = ext->zerocopy_head) != NULL && (int32_t) (chunk->zerocopy_id - ext->zerocopy_done) < 0)
+    {
+        ext->zerocopy_head = chunk->next;
+        swBuffer_free_trunk(chunk);
+    }
+    if (ext->zerocopy_head == NULL)
+    {
+        ext->zerocopy_tail = NULL;
+    }
+    return n;
+}
+
+/**
+ * completions on the error queue wake up the reactor with an error event.
+ * return SW_OK if the event only carried completions and the connection must not be closed.
+ */
+int swConnection_zerocopy_onError(swReactor *reactor, swConnection *conn)
+{
+    if (!swConnection_zerocopy_pending(conn) || swConnection_zerocopy_reap(conn) <= 0)
+    {
+        return SW_ERR;
+    }
+    //a close chunk is waiting for the last completions
+    if (!swConnection_zerocopy_pending(conn) && !swBuffer_empty(conn->out_buffer))
+    {
+        reactor->set(reactor, conn->fd, conn->fdtype | SW_EVENT_READ | SW_EVENT_WRITE);
+    }
+    return SW_OK;
+}
+
+/**
+ * the connection is being closed before all completions arrived. The kernel may still read the chunks,
+ * so reset the connection to drop the queued data before the memory can be reused.
+ */
+void swConnection_zerocopy_free(swConnection *conn)
+{
+    swBuffer_trunk *chunk;
+    swConnection_ext *ext = conn->ext;
+
+    if (swConnection_zerocopy_pending(conn))
+    {
+        struct linger linger = {1, 0};
+        if (setsockopt(conn->fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)) < 0)
+        {
+            swSysError("setsockopt(SO_LINGER) failed.");
+        }
+    }
+    while ((chunk = ext->zerocopy_head) != NULL)
+    {
+        ext->zerocopy_head = chunk->next;
+        swBuffer_free_trunk(chunk);
+    }
+    ext->zerocopy_tail = NULL;
+}
+#endif
+
+swConnection_ext* swConnection_get_ext(swConnection *conn)
+{
+    if (conn->ext == NULL)
+    {
+        conn->ext = sw_calloc(1, sizeof(swConnection_ext));
+        if (conn->ext == NULL)
+        {
+            swWarn("calloc(%d) failed.", (int ) sizeof(swConnection_ext));
+        }
+    }
+    return conn->ext;
+}
+
+void swConnection_free_ext(swConnection *conn)
+{
+    swConnection_ext *ext = conn->ext;
+#ifdef HAVE_MSG_ZEROCOPY
+    if (ext->zerocopy_head)
+    {
+        swConnection_zerocopy_free(conn);
+    }
+#endif
+    if (ext->websocket_buffer)
+    {
+        swString_free(ext->websocket_buffer);
+    }
+    sw_free(ext);
+    conn->ext = NULL;
+}
+
 swString* swConnection_get_string_buffer(swConnection *conn)
 {
     swString *buffer = conn->object;
@@ -240,6 +466,7 @@ int swConnection_sendfile(swConnection *conn, char *filename, off_t offset, size
         {
             return SW_ERR;
         }
+        conn->out_buffer->coalesce = 1;
     }
 
     swBuffer_trunk error_chunk;
@@ -18,7 +18,7 @@
 #include "Client.h"
 
 #define SW_DNS_SERVER_CONF         "/etc/resolv.conf"
-#define SW_DNS_SERVER_NUM          2
+#define SW_DNS_SERVER_NUM          3
 
 enum swDNS_type
 {
@@ -37,10 +37,39 @@ enum swDNS_error
 typedef struct
 {
     void (*callback)(char *domain, swDNSResolver_result *result, void *data);
-    char *domain;
     void *data;
+} swDNS_lookup_waiter;
+
+/**
+ * one query in flight per domain, later lookups of the same name wait on it
+ */
+typedef struct
+{
+    char *domain;
+    int domain_len;
+    /**
+     * query id sent to each nameserver tried so far
+     */
+    uint16_t id[SW_DNS_SERVER_NUM];
+    uint8_t server_index;
+    swTimer_node *timer;
+    swLinkedList *waiters;
 } swDNS_lookup_request;
 
+typedef struct
+{
+    swDNSResolver_result result;
+    time_t expire;
+} swDNS_cache;
+
+typedef struct
+{
+    void (*callback)(char *domain, swDNSResolver_result *result, void *data);
+    void *data;
+    char *domain;
+    swDNSResolver_result result;
+} swDNS_cache_hit;
+
 typedef struct
 {
     uint8_t num;
@@ -82,49 +111,143 @@ typedef struct rr_flags
 } RR_FLAGS;
 
 static uint16_t swoole_dns_request_id = 1;
-static swClient *resolver_socket = NULL;
+static swClient *resolver_socket[SW_DNS_SERVER_NUM];
 static swHashMap *request_map = NULL;
+static swHashMap *cache_map = NULL;
+
+static char *dns_server[SW_DNS_SERVER_NUM];
+static int dns_server_num = 0;
 
 static int domain_encode(char *src, int n, char *dest);
 static void domain_decode(char *str);
 static int swDNSResolver_get_server();
 static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event);
+static int swDNSResolver_send(swDNS_lookup_request *request);
+static void swDNSResolver_onTimeout(swTimer *timer, swTimer_node *tnode);
+static void swDNSResolver_finish(swDNS_lookup_request *request, swDNSResolver_result *result, uint32_t ttl);
 
+/**
+ * dns_server_v4 (set by the user or the first nameserver) is always tried first,
+ * the other nameservers of resolv.conf are used as fallbacks
+ */
 static int swDNSResolver_get_server()
 {
     FILE *fp;
     char line[100];
-    char buf[16] = {0};
+    char *buf;
+
+    if (SwooleG.dns_server_v4)
+    {
+        dns_server[dns_server_num++] = SwooleG.dns_server_v4;
+    }
 
     if ((fp = fopen(SW_DNS_SERVER_CONF, "rt")) == NULL)
     {
+        if (dns_server_num > 0)
+        {
+            return SW_OK;
+        }
         swWarn("fopen("SW_DNS_SERVER_CONF") failed. Error: %s[%d]", strerror(errno), errno);
         return SW_ERR;
     }
 
-    while (fgets(line, 100, fp))
+    while (fgets(line, sizeof(line), fp) && dns_server_num < SW_DNS_SERVER_NUM)
     {
-        if (strncmp(line, "nameserver", 10) == 0)
+        if (strncmp(line, "nameserver", 10) != 0)
         {
-            strcpy(buf, strtok(line, " "));
-            strcpy(buf, strtok(NULL, "\n"));
-            break;
+            continue;
         }
+        strtok(line, " \t");
+        buf = strtok(NULL, " \t\r\n");
+        if (buf == NULL || strlen(buf) >= 32)
+        {
+            continue;
+        }
+        if (dns_server_num > 0 && strcmp(dns_server[0], buf) == 0)
+        {
+            continue;
+        }
+        dns_server[dns_server_num++] = sw_strdup(buf);
     }
     fclose(fp);
 
-    if (strlen(buf) == 0)
+    if (dns_server_num == 0)
     {
-        SwooleG.dns_server_v4 = sw_strdup(SW_DNS_DEFAULT_SERVER);
+        dns_server[dns_server_num++] = sw_strdup(SW_DNS_DEFAULT_SERVER);
     }
-    else
+    if (SwooleG.dns_server_v4 == NULL)
     {
-        SwooleG.dns_server_v4 = sw_strdup(buf);
+        SwooleG.dns_server_v4 = dns_server[0];
     }
 
     return SW_OK;
 }
 
+static void swDNSResolver_cache_free(void *data)
+{
+    sw_free(data);
+}
+
+static void swDNSResolver_cache_add(char *domain, int domain_len, swDNSResolver_result *result, uint32_t ttl)
+{
+    if (ttl > SW_DNS_CACHE_TTL_MAX)
+    {
+        ttl = SW_DNS_CACHE_TTL_MAX;
+    }
+    if (cache_map && swHashMap_count(cache_map) >= SW_DNS_CACHE_SIZE)
+    {
+        swHashMap_free(cache_map);
+        cache_map = NULL;
+    }
+    if (cache_map == NULL)
+    {
+        cache_map = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, swDNSResolver_cache_free);
+        if (cache_map == NULL)
+        {
+            return;
+        }
+    }
+
+    swDNS_cache *cache = swHashMap_find(cache_map, domain, domain_len);
+    if (cache == NULL)
+    {
+        cache = sw_malloc(sizeof(swDNS_cache));
+        if (cache == NULL)
+        {
+            return;
+        }
+        swHashMap_add(cache_map, domain, domain_len, cache);
+    }
+    memcpy(&cache->result, result, sizeof(cache->result));
+    cache->expire = time(NULL) + ttl;
+}
+
+static swDNS_cache* swDNSResolver_cache_find(char *domain, int domain_len)
+{
+    if (cache_map == NULL)
+    {
+        return NULL;
+    }
+    swDNS_cache *cache = swHashMap_find(cache_map, domain, domain_len);
+    if (cache && cache->expire <= time(NULL))
+    {
+        swHashMap_del(cache_map, domain, domain_len);
+        return NULL;
+    }
+    return cache;
+}
+
+/**
+ * answers from the cache are still delivered from the event loop, callers yield after the request
+ */
+static void swDNSResolver_cache_onDefer(void *data)
+{
+    swDNS_cache_hit *hit = data;
+    hit->callback(hit->domain, &hit->result, hit->data);
+    sw_free(hit->domain);
+    sw_free(hit);
+}
+
 static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
 {
     swDNSResolver_header *header = NULL;
@@ -134,6 +257,7 @@ static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
     char packet[SW_CLIENT_BUFFER_SIZE];
     uchar rdata[10][254];
     uint32_t type[10];
+    uint32_t ttl[10];
 
     char *temp;
     uint16_t steps;
@@ -194,6 +318,7 @@ static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
         /* Parsing the RR flags of the RR */
         rrflags = (RR_FLAGS *) &packet[steps];
         steps = steps + sizeof(RR_FLAGS) - 2;
+        ttl[i] = ntohl(rrflags->ttl);
 
         /* Parsing the IPv4 address in the RR */
         if (ntohs(rrflags->type) == 1)
@@ -231,18 +356,30 @@ static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
         steps = steps + ntohs(rrflags->rdlength);
     }
 
-    char key[1024];
     int request_id = ntohs(header->id);
-    int key_len = snprintf(key, sizeof(key), "%s-%d", _domain_name, request_id);
-    swDNS_lookup_request *request = swHashMap_find(request_map, key, key_len);
+    swDNS_lookup_request *request = swHashMap_find(request_map, _domain_name, strlen(_domain_name));
     if (request == NULL)
     {
         swWarn("bad response, request_id=%d.", request_id);
         return SW_OK;
     }
+    //a late answer from a nameserver that was already given up on is as good as any
+    for (i = 0; i <= request->server_index; i++)
+    {
+        if (request->id[i] == request_id)
+        {
+            break;
+        }
+    }
+    if (i > request->server_index)
+    {
+        swWarn("bad response, request_id=%d.", request_id);
+        return SW_OK;
+    }
 
     swDNSResolver_result result;
     bzero(&result, sizeof(result));
+    uint32_t min_ttl = SW_DNS_CACHE_TTL_MAX;
 
     for (i = 0; i < ancount; ++i)
     {
@@ -250,6 +387,10 @@ static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
         {
             continue;
         }
+        if (ttl[i] < min_ttl)
+        {
+            min_ttl = ttl[i];
+        }
         j = result.num;
         result.num++;
         result.hosts[j].length = sprintf(result.hosts[j].address, "%d.%d.%d.%d", rdata[i][0], rdata[i][1], rdata[i][2], rdata[i][3]);
@@ -259,33 +400,122 @@ static int swDNSResolver_onReceive(swReactor *reactor, swEvent *event)
         }
     }
 
-    request->callback(request->domain, &result, request->data);
-    swHashMap_del(request_map, key, key_len);
+    swDNSResolver_finish(request, &result, min_ttl);
+    return SW_OK;
+}
+
+/**
+ * hand the result to every waiter, the request is unlinked first so callbacks may look the name up again
+ */
+static void swDNSResolver_finish(swDNS_lookup_request *request, swDNSResolver_result *result, uint32_t ttl)
+{
+    swDNS_lookup_waiter *waiter;
+
+    swHashMap_del(request_map, request->domain, request->domain_len);
+    if (request->timer)
+    {
+        swTimer_del(&SwooleG.timer, request->timer);
+        request->timer = NULL;
+    }
+    if (result->num > 0 && ttl > 0)
+    {
+        swDNSResolver_cache_add(request->domain, request->domain_len, result, ttl);
+    }
+
+    while ((waiter = swLinkedList_shift(request->waiters)))
+    {
+        waiter->callback(request->domain, result, waiter->data);
+        sw_free(waiter);
+    }
+    swLinkedList_free(request->waiters);
     sw_free(request->domain);
     sw_free(request);
+}
 
-    return SW_OK;
+static void swDNSResolver_onTimeout(swTimer *timer, swTimer_node *tnode)
+{
+    swDNS_lookup_request *request = tnode->data;
+    request->timer = NULL;
+
+    while (request->server_index + 1 < dns_server_num)
+    {
+        request->server_index++;
+        if (swDNSResolver_send(request) == SW_OK)
+        {
+            return;
+        }
+    }
+
+    swDNSResolver_result result;
+    bzero(&result, sizeof(result));
+    swoole_error_log(SW_LOG_WARNING, SW_ERROR_DNSLOOKUP_RESOLVE_FAILED, "dns lookup of %s timed out.", request->domain);
+    swDNSResolver_finish(request, &result, 0);
 }
 
-int swDNSResolver_request(char *domain, void (*callback)(char *, swDNSResolver_result *, void *), void *data)
+static swClient* swDNSResolver_get_socket(int index)
+{
+    if (resolver_socket[index])
+    {
+        return resolver_socket[index];
+    }
+
+    swClient *cli = sw_malloc(sizeof(swClient));
+    if (cli == NULL)
+    {
+        swWarn("malloc failed.");
+        return NULL;
+    }
+    if (swClient_create(cli, SW_SOCK_UDP, 0) < 0)
+    {
+        sw_free(cli);
+        return NULL;
+    }
+    char *_port;
+    int dns_server_port = SW_DNS_SERVER_PORT;
+    char dns_server_host[32];
+    strcpy(dns_server_host, dns_server[index]);
+    if ((_port = strchr(dns_server[index], ':')))
+    {
+        dns_server_port = atoi(_port + 1);
+        dns_server_host[_port - dns_server[index]] = '\0';
+    }
+    if (cli->connect(cli, dns_server_host, dns_server_port, 1, 0) < 0)
+    {
+        do_close: cli->close(cli);
+        swClient_free(cli);
+        sw_free(cli);
+        return NULL;
+    }
+    SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_DNS_RESOLVER, swDNSResolver_onReceive);
+    if (SwooleG.main_reactor->add(SwooleG.main_reactor, cli->socket->fd, SW_FD_DNS_RESOLVER))
+    {
+        goto do_close;
+    }
+    resolver_socket[index] = cli;
+    return cli;
+}
+
+/**
+ * send the query to dns_server[request->server_index] with a fresh id and arm the retry timer
+ */
+static int swDNSResolver_send(swDNS_lookup_request *request)
 {
     char *_domain_name;
     Q_FLAGS *qflags = NULL;
     char packet[SW_BUFFER_SIZE_STD];
-    char key[1024];
     swDNSResolver_header *header = NULL;
     int steps = 0;
 
-    if (SwooleG.dns_server_v4 == NULL)
+    swClient *cli = swDNSResolver_get_socket(request->server_index);
+    if (cli == NULL)
     {
-        if (swDNSResolver_get_server() < 0)
-        {
-            return SW_ERR;
-        }
+        return SW_ERR;
     }
 
+    request->id[request->server_index] = swoole_dns_request_id++;
+
     header = (swDNSResolver_header *) packet;
-    header->id = htons(swoole_dns_request_id);
+    header->id = htons(request->id[request->server_index]);
     header->qr = 0;
     header->opcode = 0;
     header->aa = 0;
@@ -302,131 +532,178 @@ int swDNSResolver_request(char *domain, void (*callback)(char *, swDNSResolver_r
     steps = sizeof(swDNSResolver_header);
 
     _domain_name = &packet[steps];
-
-    int len = strlen(domain);
-    if (len >= sizeof(key))
+    if (domain_encode(request->domain, request->domain_len, _domain_name) < 0)
     {
-        swWarn("domain name is too long.");
+        swWarn("invalid domain[%s].", request->domain);
         return SW_ERR;
     }
+    steps += (strlen((const char *) _domain_name) + 1);
 
-    int key_len = snprintf(key, sizeof(key), "%s-%d", domain, swoole_dns_request_id);
-    if (!request_map)
-    {
-        request_map = swHashMap_new(128, NULL);
-    }
-    else if (swHashMap_find(request_map, key, key_len))
-    {
-        swoole_error_log(SW_LOG_WARNING, SW_ERROR_DNSLOOKUP_DUPLICATE_REQUEST, "duplicate request.");
-        return SW_ERR;
-    }
+    qflags = (Q_FLAGS *) &packet[steps];
+    qflags->qtype = htons(SW_DNS_A_RECORD);
+    qflags->qclass = htons(0x0001);
+    steps += sizeof(Q_FLAGS);
 
-    swDNS_lookup_request *request = sw_malloc(sizeof(swDNS_lookup_request));
-    if (request == NULL)
+    if (cli->send(cli, (char *) packet, steps, 0) < 0)
     {
-        swWarn("malloc(%d) failed.", (int ) sizeof(swDNS_lookup_request));
         return SW_ERR;
     }
-    request->domain = sw_strndup(domain, len + 1);
-    if (request->domain == NULL)
+
+    if (SwooleG.timer.fd == 0)
     {
-        swWarn("strdup(%d) failed.", len + 1);
-        sw_free(request);
-        return SW_ERR;
+        swTimer_init(SW_DNS_SERVER_TIMEOUT);
     }
-    request->data = data;
-    request->callback = callback;
+    request->timer = SwooleG.timer.add(&SwooleG.timer, SW_DNS_SERVER_TIMEOUT, 0, request, swDNSResolver_onTimeout);
+    return SW_OK;
+}
 
-    if (domain_encode(request->domain, len, _domain_name) < 0)
+int swDNSResolver_request(char *domain, void (*callback)(char *, swDNSResolver_result *, void *), void *data)
+{
+    int len = strlen(domain);
+    if (len >= 1024)
     {
-        swWarn("invalid domain[%s].", domain);
-        sw_free(request->domain);
-        sw_free(request);
+        swWarn("domain name is too long.");
         return SW_ERR;
     }
 
-    steps += (strlen((const char *) _domain_name) + 1);
-
-    qflags = (Q_FLAGS *) &packet[steps];
-    qflags->qtype = htons(SW_DNS_A_RECORD);
-    qflags->qclass = htons(0x0001);
-    steps += sizeof(Q_FLAGS);
-
-    if (resolver_socket == NULL)
+    swDNS_cache *cache = swDNSResolver_cache_find(domain, len);
+    if (cache)
     {
-        resolver_socket = sw_malloc(sizeof(swClient));
-        if (resolver_socket == NULL)
+        swDNS_cache_hit *hit = sw_malloc(sizeof(swDNS_cache_hit));
+        if (hit == NULL)
         {
-            sw_free(request->domain);
-            sw_free(request);
-            swWarn("malloc failed.");
+            swWarn("malloc(%d) failed.", (int ) sizeof(swDNS_cache_hit));
             return SW_ERR;
         }
-        if (swClient_create(resolver_socket, SW_SOCK_UDP, 0) < 0)
+        hit->domain = sw_strndup(domain, len + 1);
+        if (hit->domain == NULL)
         {
-            sw_free(resolver_socket);
-            sw_free(request->domain);
-            sw_free(request);
+            sw_free(hit);
             return SW_ERR;
         }
-        char *_port;
-        int dns_server_port = SW_DNS_SERVER_PORT;
-        char dns_server_host[32];
-        strcpy(dns_server_host, SwooleG.dns_server_v4);
-        if ((_port = strchr(SwooleG.dns_server_v4, ':')))
+        hit->callback = callback;
+        hit->data = data;
+        memcpy(&hit->result, &cache->result, sizeof(hit->result));
+        if (SwooleG.main_reactor->defer(SwooleG.main_reactor, swDNSResolver_cache_onDefer, hit) < 0)
         {
-            dns_server_port = atoi(_port + 1);
-            dns_server_host[_port - SwooleG.dns_server_v4] = '\0';
+            sw_free(hit->domain);
+            sw_free(hit);
+            return SW_ERR;
         }
-        if (resolver_socket->connect(resolver_socket, dns_server_host, dns_server_port, 1, 0) < 0)
+        return SW_OK;
+    }
+
+    if (dns_server_num == 0)
+    {
+        if (swDNSResolver_get_server() < 0)
         {
-            do_close: resolver_socket->close(resolver_socket);
-            swClient_free(resolver_socket);
-            sw_free(resolver_socket);
-            sw_free(request->domain);
-            sw_free(request);
-            resolver_socket = NULL;
             return SW_ERR;
         }
-        SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_DNS_RESOLVER, swDNSResolver_onReceive);
-        if (SwooleG.main_reactor->add(SwooleG.main_reactor, resolver_socket->socket->fd, SW_FD_DNS_RESOLVER))
+    }
+
+    if (!request_map)
+    {
+        request_map = swHashMap_new(128, NULL);
+    }
+
+    swDNS_lookup_waiter *waiter = sw_malloc(sizeof(swDNS_lookup_waiter));
+    if (waiter == NULL)
+    {
+        swWarn("malloc(%d) failed.", (int ) sizeof(swDNS_lookup_waiter));
+        return SW_ERR;
+    }
+    waiter->callback = callback;
+    waiter->data = data;
+
+    //the same name is already being resolved, wait for that answer
+    swDNS_lookup_request *request = swHashMap_find(request_map, domain, len);
+    if (request)
+    {
+        if (swLinkedList_append(request->waiters, waiter) < 0)
         {
-            goto do_close;
+            sw_free(waiter);
+            return SW_ERR;
         }
+        return SW_OK;
     }
 
-    if (resolver_socket->send(resolver_socket, (char *) packet, steps, 0) < 0)
+    request = sw_malloc(sizeof(swDNS_lookup_request));
+    if (request == NULL)
     {
-        goto do_close;
+        swWarn("malloc(%d) failed.", (int ) sizeof(swDNS_lookup_request));
+        sw_free(waiter);
+        return SW_ERR;
+    }
+    bzero(request, sizeof(swDNS_lookup_request));
+    request->domain = sw_strndup(domain, len + 1);
+    if (request->domain == NULL)
+    {
+        swWarn("strdup(%d) failed.", len + 1);
+        goto _free;
+    }
+    request->domain_len = len;
+    request->waiters = swLinkedList_new(0, NULL);
+    if (request->waiters == NULL)
+    {
+        goto _free;
+    }
+    swLinkedList_append(request->waiters, waiter);
+
+    while (swDNSResolver_send(request) < 0)
+    {
+        if (request->server_index + 1 >= dns_server_num)
+        {
+            goto _free;
+        }
+        request->server_index++;
     }
 
-    swHashMap_add(request_map, key, key_len, request);
-    swoole_dns_request_id++;
+    swHashMap_add(request_map, request->domain, request->domain_len, request);
     return SW_OK;
+
+    _free:
+    if (request->waiters)
+    {
+        swLinkedList_free(request->waiters);
+    }
+    if (request->domain)
+    {
+        sw_free(request->domain);
+    }
+    sw_free(request);
+    sw_free(waiter);
+    return SW_ERR;
 }
 
 int swDNSResolver_free()
 {
-    if (resolver_socket == NULL)
+    int i;
+
+    if (SwooleG.main_reactor == NULL)
     {
         return SW_ERR;
     }
-    if (SwooleG.main_reactor == NULL)
+    if (request_map && swHashMap_count(request_map) > 0)
     {
         return SW_ERR;
     }
-    if (swHashMap_count(request_map) > 0)
+    for (i = 0; i < SW_DNS_SERVER_NUM; i++)
     {
-        return SW_ERR;
+        if (resolver_socket[i] == NULL)
+        {
+            continue;
+        }
+        SwooleG.main_reactor->del(SwooleG.main_reactor, resolver_socket[i]->socket->fd);
+        resolver_socket[i]->close(resolver_socket[i]);
+        swClient_free(resolver_socket[i]);
+        sw_free(resolver_socket[i]);
+        resolver_socket[i] = NULL;
+    }
+    if (request_map)
+    {
+        swHashMap_free(request_map);
+        request_map = NULL;
     }
-
-    SwooleG.main_reactor->del(SwooleG.main_reactor, resolver_socket->socket->fd);
-    resolver_socket->close(resolver_socket);
-    swClient_free(resolver_socket);
-    sw_free(resolver_socket);
-    resolver_socket = NULL;
-    swHashMap_free(request_map);
-    request_map = NULL;
 
     return SW_OK;
 }
@@ -95,6 +95,11 @@ int swPort_enable_ssl_encrypt(swListenPort *ls)
         swWarn("swSSL_server_set_cipher() error.");
         return SW_ERR;
     }
+    if (swSSL_server_set_session_cache(ls->ssl_context, &ls->ssl_config) < 0)
+    {
+        swWarn("swSSL_server_set_session_cache() error.");
+        return SW_ERR;
+    }
     return SW_OK;
 }
 #endif
@@ -588,6 +593,138 @@ void swPort_free(swListenPort *port)
 #define PATH_MAX 4096
 #endif
 
+typedef struct
+{
+    time_t checked;
+    time_t mtime;
+    off_t size;
+    uint8_t exists;
+    char *content;
+} swHttpStaticFile;
+
+/**
+ * per reactor, revalidated with stat() once every static_handler_cache_expire seconds
+ */
+static __thread swHashMap *static_cache = NULL;
+static __thread swString *static_buffer = NULL;
+
+static void swPort_http_static_free(void *data)
+{
+    swHttpStaticFile *file = data;
+    if (file->content)
+    {
+        sw_free(file->content);
+    }
+    sw_free(file);
+}
+
+static int swPort_http_static_stat(char *filename, swHttpStaticFile *file)
+{
+    struct stat file_stat;
+    if (lstat(filename, &file_stat) < 0 || (file_stat.st_mode & S_IFMT) != S_IFREG)
+    {
+        file->exists = 0;
+        return SW_ERR;
+    }
+    file->exists = 1;
+    file->size = file_stat.st_size;
+#ifdef __MACH__
+    file->mtime = file_stat.st_mtimespec.tv_sec;
+#else
+    file->mtime = file_stat.st_mtim.tv_sec;
+#endif
+    return SW_OK;
+}
+
+static void swPort_http_static_load(char *filename, swHttpStaticFile *file)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    char *content = sw_malloc(file->size + 1);
+    if (content && swoole_sync_readfile(fd, content, file->size) == file->size)
+    {
+        file->content = content;
+    }
+    else if (content)
+    {
+        sw_free(content);
+    }
+    close(fd);
+}
+
+/**
+ * without the cache every lookup is a lstat(), the result is only valid until the next call
+ */
+static swHttpStaticFile* swPort_http_static_get(swServer *serv, char *filename, int length)
+{
+    static __thread swHttpStaticFile uncached;
+
+    if (serv->static_handler_cache_size == 0)
+    {
+        swPort_http_static_stat(filename, &uncached);
+        uncached.content = NULL;
+        return &uncached;
+    }
+
+    if (static_cache && swHashMap_count(static_cache) >= SW_HTTP_STATIC_CACHE_NUM)
+    {
+        swHashMap_free(static_cache);
+        static_cache = NULL;
+    }
+    if (static_cache == NULL)
+    {
+        static_cache = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, swPort_http_static_free);
+        if (static_cache == NULL)
+        {
+            swPort_http_static_stat(filename, &uncached);
+            uncached.content = NULL;
+            return &uncached;
+        }
+    }
+
+    swHttpStaticFile *file = swHashMap_find(static_cache, filename, length);
+    if (file == NULL)
+    {
+        file = sw_malloc(sizeof(swHttpStaticFile));
+        if (file == NULL)
+        {
+            swPort_http_static_stat(filename, &uncached);
+            uncached.content = NULL;
+            return &uncached;
+        }
+        bzero(file, sizeof(swHttpStaticFile));
+        swPort_http_static_stat(filename, file);
+        file->checked = SwooleGS->now;
+        if (swHashMap_add(static_cache, filename, length, file) < 0)
+        {
+            uncached = *file;
+            sw_free(file);
+            return &uncached;
+        }
+    }
+    else if (SwooleGS->now - file->checked >= serv->static_handler_cache_expire)
+    {
+        time_t mtime = file->mtime;
+        off_t size = file->size;
+        swPort_http_static_stat(filename, file);
+        file->checked = SwooleGS->now;
+        if (file->content && (!file->exists || file->mtime != mtime || file->size != size))
+        {
+            sw_free(file->content);
+            file->content = NULL;
+        }
+    }
+
+    if (file->exists && file->content == NULL && file->size <= serv->static_handler_cache_size)
+    {
+        swPort_http_static_load(filename, file);
+    }
+    return file;
+}
+
 int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
 {
     swServer *serv = SwooleG.serv;
@@ -606,19 +743,21 @@ int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
     memcpy(p, serv->document_root, serv->document_root_len);
     p += serv->document_root_len;
     uint32_t n = params ? params - url : request->url_length;
+    if (serv->document_root_len + n + sizeof(".br") > sizeof(buffer.filename))
+    {
+        return SW_FALSE;
+    }
     memcpy(p, url, n);
     p += n;
     *p = 0;
 
-    struct stat file_stat;
-    if (lstat(buffer.filename, &file_stat) < 0)
-    {
-        return SW_FALSE;
-    }
-    if ((file_stat.st_mode & S_IFMT) != S_IFREG)
+    int filename_length = p - buffer.filename;
+    swHttpStaticFile *file = swPort_http_static_get(serv, buffer.filename, filename_length);
+    if (!file->exists)
     {
         return SW_FALSE;
     }
+    char *mime_type = swoole_get_mimetype(buffer.filename);
 
     char header_buffer[1024];
     swSendData response;
@@ -626,60 +765,85 @@ int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
 
     response.info.type = SW_EVENT_TCP;
 
-    p = request->buffer->str + request->url_offset + request->url_length + 10;
     char *pe = request->buffer->str + request->header_length;
+    p = memchr(url + request->url_length, '\n', pe - url - request->url_length);
+    p = p ? p + 1 : pe;
 
     char *date_if_modified_since = NULL;
     int length_if_modified_since = 0;
+    char *accept_encoding = NULL;
+    int length_accept_encoding = 0;
 
-    int state = 0;
-    for (; p < pe; p++)
+    //one header per line, p is at the start of a line
+    char *eol;
+    for (; p < pe; p = eol + 2)
     {
-        switch(state)
+        eol = memchr(p, '\r', pe - p);
+        if (eol == NULL)
         {
-        case 0:
-            if (strncasecmp(p, SW_STRL("If-Modified-Since") - 1) == 0)
+            break;
+        }
+        if (eol - p > sizeof("If-Modified-Since") && strncasecmp(p, SW_STRL("If-Modified-Since:") - 1) == 0)
+        {
+            date_if_modified_since = p + sizeof("If-Modified-Since");
+            while (date_if_modified_since < eol && isspace(*date_if_modified_since))
             {
-                p += sizeof("If-Modified-Since");
-                state = 1;
+                date_if_modified_since++;
             }
-            break;
-        case 1:
-            if (!isspace(*p))
+            length_if_modified_since = eol - date_if_modified_since;
+        }
+        else if (eol - p > sizeof("Accept-Encoding") && strncasecmp(p, SW_STRL("Accept-Encoding:") - 1) == 0)
+        {
+            accept_encoding = p + sizeof("Accept-Encoding");
+            length_accept_encoding = eol - accept_encoding;
+        }
+    }
+
+    /**
+     * precompressed sibling, Content-Type still comes from the requested name
+     */
+    char *content_encoding = "";
+    if (serv->static_handler_precompressed && accept_encoding)
+    {
+        swHttpStaticFile *encoded;
+        if (swoole_strnpos(accept_encoding, length_accept_encoding, SW_STRL("br") - 1) >= 0)
+        {
+            memcpy(buffer.filename + filename_length, ".br", sizeof(".br"));
+            encoded = swPort_http_static_get(serv, buffer.filename, filename_length + sizeof(".br") - 1);
+            if (encoded->exists)
             {
-                date_if_modified_since = p;
-                state = 2;
+                file = encoded;
+                content_encoding = "Content-Encoding: br\r\n";
+                goto send_file;
             }
-            break;
-        case 2:
-            if (strncasecmp(p, SW_STRL("\r\n") - 1) == 0)
+        }
+        if (swoole_strnpos(accept_encoding, length_accept_encoding, SW_STRL("gzip") - 1) >= 0)
+        {
+            memcpy(buffer.filename + filename_length, ".gz", sizeof(".gz"));
+            encoded = swPort_http_static_get(serv, buffer.filename, filename_length + sizeof(".gz") - 1);
+            if (encoded->exists)
             {
-                length_if_modified_since = p - date_if_modified_since;
-                goto check_modify_date;
+                file = encoded;
+                content_encoding = "Content-Encoding: gzip\r\n";
+                goto send_file;
             }
-            break;
-        default:
-            break;
         }
+        buffer.filename[filename_length] = 0;
     }
 
+    send_file:
+    ;
+    char *vary = serv->static_handler_precompressed ? "Vary: Accept-Encoding\r\n" : "";
     char date_[64];
-    struct tm *tm1;
-
-    check_modify_date: tm1 = gmtime(&SwooleGS->now);
+    struct tm *tm1 = gmtime(&SwooleGS->now);
     strftime(date_, sizeof(date_), "%a, %d %b %Y %H:%M:%S %Z", tm1);
 
     char date_last_modified[64];
-#ifdef __MACH__
-    time_t file_mtime = file_stat.st_mtimespec.tv_sec;
-#else
-    time_t file_mtime = file_stat.st_mtim.tv_sec;
-#endif
-
+    time_t file_mtime = file->mtime;
     struct tm *tm2 = gmtime(&file_mtime);
     strftime(date_last_modified, sizeof(date_last_modified), "%a, %d %b %Y %H:%M:%S %Z", tm2);
 
-    if (state == 2)
+    if (date_if_modified_since && length_if_modified_since < 64)
     {
         struct tm tm3;
         char date_tmp[64];
@@ -711,7 +875,8 @@ int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
                     "Connection: Keep-Alive\r\n"
                     "Date: %s\r\n"
                     "Last-Modified: %s\r\n"
-                    "Server: %s\r\n\r\n", date_, date_last_modified,
+                    "%s"
+                    "Server: %s\r\n\r\n", date_, date_last_modified, vary,
                     SW_HTTP_SERVER_SOFTWARE);
             response.data = header_buffer;
             swReactorThread_send(&response);
@@ -724,15 +889,38 @@ int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
             "Connection: Keep-Alive\r\n"
             "Content-Length: %ld\r\n"
             "Content-Type: %s\r\n"
+            "%s%s"
             "Date: %s\r\n"
             "Last-Modified: %s\r\n"
-            "Server: %s\r\n\r\n", (long) file_stat.st_size, swoole_get_mimetype(buffer.filename),
+            "Server: %s\r\n\r\n", (long) file->size, mime_type,
+            content_encoding, vary,
             date_,
             date_last_modified,
             SW_HTTP_SERVER_SOFTWARE);
 
     response.data = header_buffer;
 
+    //cached: header and content in a single write
+    if (file->content)
+    {
+        if (static_buffer == NULL)
+        {
+            static_buffer = swString_new(SW_BUFFER_SIZE_STD);
+        }
+        if (static_buffer)
+        {
+            swString_clear(static_buffer);
+            if (swString_append_ptr(static_buffer, header_buffer, response.length) == SW_OK
+                    && swString_append_ptr(static_buffer, file->content, file->size) == SW_OK)
+            {
+                response.data = static_buffer->str;
+                response.length = response.info.len = static_buffer->length;
+                swReactorThread_send(&response);
+                return SW_TRUE;
+            }
+        }
+    }
+
 #ifdef HAVE_TCP_NOPUSH
     if (conn->tcp_nopush == 0)
     {
@@ -746,7 +934,7 @@ int swPort_http_static_handler(swHttpRequest *request, swConnection *conn)
     swReactorThread_send(&response);
 
     buffer.offset = 0;
-    buffer.length = file_stat.st_size;
+    buffer.length = file->size;
 
     response.info.type = SW_EVENT_SENDFILE;
     response.length = response.info.len = sizeof(swSendFile_request) + buffer.length + 1;
@@ -18,6 +18,8 @@
 #include "Server.h"
 #include "Client.h"
 
+#include <poll.h>
+
 /**
  * call onTask
  */
@@ -29,6 +31,11 @@ static int swProcessPool_worker_loop_ex(swProcessPool *pool, swWorker *worker);
 
 static void swProcessPool_free(swProcessPool *pool);
 
+static int swProcessPool_queue_create(swProcessPool *pool);
+static int swProcessPool_queue_wait(swProcessPool *pool);
+static void swProcessPool_queue_pop(swProcessPool *pool, swWorker *worker, swEventData *out);
+static void swProcessPool_queue_release(swProcessPool *pool, uint64_t count);
+
 /**
  * Process manager
  */
@@ -74,6 +81,14 @@ int swProcessPool_create(swProcessPool *pool, int worker_num, int max_request, k
         }
         bzero(pool->stream, sizeof(swStreamInfo));
     }
+    else if (ipc_mode == SW_IPC_SHMQUEUE)
+    {
+        pool->use_shmqueue = 1;
+        if (swProcessPool_queue_create(pool) < 0)
+        {
+            return SW_ERR;
+        }
+    }
     else if (ipc_mode == SW_IPC_UNIXSOCK)
     {
         pool->pipes = sw_calloc(worker_num, sizeof(swPipe));
@@ -405,6 +420,7 @@ static int swProcessPool_worker_loop(swProcessPool *pool, swWorker *worker)
 
     int n = 0, ret;
     int task_n, worker_task_always = 0;
+    int shm_pending = 0;
 
     if (pool->max_request < 1)
     {
@@ -452,6 +468,28 @@ static int swProcessPool_worker_loop(swProcessPool *pool, swWorker *worker)
                 break;
             }
         }
+        else if (pool->use_shmqueue)
+        {
+            if (shm_pending == 0)
+            {
+                n = swProcessPool_queue_wait(pool);
+                if (n == 0)
+                {
+                    continue;
+                }
+                else if (n < 0 && errno != EINTR)
+                {
+                    swSysError("[Worker#%d] wait for task queue failed.", worker->id);
+                    break;
+                }
+                shm_pending = n;
+            }
+            if (shm_pending > 0)
+            {
+                swProcessPool_queue_pop(pool, worker, &out.buf);
+                shm_pending--;
+            }
+        }
         else if (pool->use_socket)
         {
             int fd = accept(pool->stream->socket, NULL, NULL);
@@ -529,6 +567,13 @@ static int swProcessPool_worker_loop(swProcessPool *pool, swWorker *worker)
             task_n--;
         }
     }
+    /**
+     * hand the claimed but unprocessed tasks back to the other workers
+     */
+    if (shm_pending > 0)
+    {
+        swProcessPool_queue_release(pool, shm_pending);
+    }
     return SW_OK;
 }
 
@@ -801,6 +846,21 @@ static void swProcessPool_free(swProcessPool *pool)
         swMsgQueue_free(pool->queue);
     }
 
+    if (pool->shm_notify)
+    {
+        pool->shm_notify->close(pool->shm_notify);
+        sw_free(pool->shm_notify);
+    }
+
+    if (pool->shm_queues)
+    {
+        for (i = 0; i < pool->worker_num; i++)
+        {
+            pool->shm_queues[i].lock.free(&pool->shm_queues[i].lock);
+        }
+        sw_shm_free(pool->shm_queues);
+    }
+
     if (pool->stream)
     {
         if (pool->stream->socket)
@@ -825,3 +885,179 @@ static void swProcessPool_free(swProcessPool *pool)
     }
 }
 
+
+/**
+ * One queue per worker plus a shared eventfd counting the queued tasks.
+ * A worker claims tokens from the counter, then pops its own queue first and
+ * steals from the longest backlog when its own queue is empty.
+ */
+static int swProcessPool_queue_create(swProcessPool *pool)
+{
+    int i;
+
+    pool->shm_queues = sw_shm_calloc(pool->worker_num, sizeof(swProcessPool_queue));
+    if (pool->shm_queues == NULL)
+    {
+        swSysError("sw_shm_calloc(%ld) failed.", (long) (pool->worker_num * sizeof(swProcessPool_queue)));
+        return SW_ERR;
+    }
+    for (i = 0; i < pool->worker_num; i++)
+    {
+        if (swMutex_create(&pool->shm_queues[i].lock, 1) < 0)
+        {
+            return SW_ERR;
+        }
+    }
+
+    pool->shm_notify = sw_malloc(sizeof(swPipe));
+    if (pool->shm_notify == NULL)
+    {
+        swSysError("malloc[2] failed.");
+        return SW_ERR;
+    }
+    if (swPipeEventfd_create(pool->shm_notify, 0, 0, 0) < 0)
+    {
+        sw_free(pool->shm_notify);
+        pool->shm_notify = NULL;
+        return SW_ERR;
+    }
+    return SW_OK;
+}
+
+static sw_inline swProcessPool_queue* swProcessPool_queue_select(swProcessPool *pool, int worker_index)
+{
+    int i;
+    swProcessPool_queue *queue = &pool->shm_queues[worker_index];
+    if (queue->num < SW_TASK_QUEUE_SIZE)
+    {
+        return queue;
+    }
+    //the target is backlogged, use the shortest queue
+    queue = NULL;
+    for (i = 0; i < pool->worker_num; i++)
+    {
+        if (pool->shm_queues[i].num < SW_TASK_QUEUE_SIZE && (queue == NULL || pool->shm_queues[i].num < queue->num))
+        {
+            queue = &pool->shm_queues[i];
+        }
+    }
+    return queue;
+}
+
+int swProcessPool_queue_push(swProcessPool *pool, int worker_index, swEventData *data, int blocking)
+{
+    swProcessPool_queue *queue;
+    uint64_t flag = 1;
+    int fd = pool->shm_notify->getFd(pool->shm_notify, 1);
+
+    if (worker_index < 0 || worker_index >= pool->worker_num)
+    {
+        worker_index = 0;
+    }
+
+    while (1)
+    {
+        queue = swProcessPool_queue_select(pool, worker_index);
+        if (queue == NULL)
+        {
+            if (!blocking)
+            {
+                SwooleG.error = SW_ERROR_QUEUE_FULL;
+                errno = EAGAIN;
+                return SW_ERR;
+            }
+            usleep(1000);
+            continue;
+        }
+        queue->lock.lock(&queue->lock);
+        if (queue->num < SW_TASK_QUEUE_SIZE)
+        {
+            memcpy(&queue->slots[queue->tail], data, sizeof(data->info) + data->info.len);
+            queue->tail = (queue->tail + 1) % SW_TASK_QUEUE_SIZE;
+            sw_atomic_fetch_add(&queue->num, 1);
+            queue->lock.unlock(&queue->lock);
+            break;
+        }
+        queue->lock.unlock(&queue->lock);
+    }
+
+    while (write(fd, &flag, sizeof(flag)) < 0 && errno == EINTR);
+    return SW_OK;
+}
+
+/**
+ * Claim a share of the queued tasks: at most SW_TASK_QUEUE_BATCH and never more than
+ * an even split between the workers, so a batch does not starve idle processes.
+ */
+static int swProcessPool_queue_wait(swProcessPool *pool)
+{
+    uint64_t count, batch;
+    struct pollfd event;
+
+    event.fd = pool->shm_notify->getFd(pool->shm_notify, 0);
+    event.events = POLLIN;
+    event.revents = 0;
+
+    if (poll(&event, 1, -1) < 0)
+    {
+        return SW_ERR;
+    }
+    if (read(event.fd, &count, sizeof(count)) < 0)
+    {
+        return errno == EAGAIN ? 0 : SW_ERR;
+    }
+
+    batch = (count + pool->worker_num - 1) / pool->worker_num;
+    if (batch > SW_TASK_QUEUE_BATCH)
+    {
+        batch = SW_TASK_QUEUE_BATCH;
+    }
+    if (count > batch)
+    {
+        swProcessPool_queue_release(pool, count - batch);
+    }
+    return (int) batch;
+}
+
+static void swProcessPool_queue_release(swProcessPool *pool, uint64_t count)
+{
+    int fd = pool->shm_notify->getFd(pool->shm_notify, 1);
+    while (write(fd, &count, sizeof(count)) < 0 && errno == EINTR);
+}
+
+/**
+ * every claimed token is backed by a queued task, so this always finds one
+ */
+static void swProcessPool_queue_pop(swProcessPool *pool, swWorker *worker, swEventData *out)
+{
+    int i;
+    swProcessPool_queue *own = &pool->shm_queues[worker->id - pool->start_id];
+    swProcessPool_queue *queue = own;
+    swEventData *task;
+
+    while (1)
+    {
+        if (queue->num == 0)
+        {
+            for (i = 0; i < pool->worker_num; i++)
+            {
+                if (pool->shm_queues[i].num > queue->num)
+                {
+                    queue = &pool->shm_queues[i];
+                }
+            }
+        }
+        queue->lock.lock(&queue->lock);
+        if (queue->num > 0)
+        {
+            task = &queue->slots[queue->head];
+            memcpy(out, task, sizeof(task->info) + task->info.len);
+            queue->head = (queue->head + 1) % SW_TASK_QUEUE_SIZE;
+            sw_atomic_fetch_sub(&queue->num, 1);
+            queue->lock.unlock(&queue->lock);
+            return;
+        }
+        queue->lock.unlock(&queue->lock);
+        queue = own;
+    }
+}
@@ -283,9 +283,9 @@ static int swReactorProcess_loop(swProcessPool *pool, swWorker *worker)
 
     LL_FOREACH(serv->listen_list, ls)
     {
-        fdtype = swSocket_is_dgram(ls->type) ? SW_FD_UDP : SW_FD_LISTEN;
+        fdtype = swSocket_is_dgram(ls->type) ? SW_FD_UDP : swServer_listen_fdtype(serv);
 #ifdef HAVE_REUSEPORT
-        if (fdtype == SW_FD_LISTEN && SwooleG.reuse_port)
+        if (swReactor_fdtype(fdtype) == SW_FD_LISTEN && SwooleG.reuse_port)
         {
             if (swReactorProcess_reuse_port(ls) < 0)
             {
@@ -416,6 +416,12 @@ int swReactorProcess_onClose(swReactor *reactor, swEvent *event)
     {
         return SW_ERR;
     }
+#ifdef HAVE_MSG_ZEROCOPY
+    if (conn->zerocopy && swConnection_zerocopy_onError(reactor, conn) == SW_OK)
+    {
+        return SW_OK;
+    }
+#endif
     if (reactor->del(reactor, fd) == 0)
     {
         return swServer_tcp_notify(serv, conn, SW_EVENT_CLOSE);
@@ -22,6 +22,7 @@
 static int swReactorThread_loop(swThreadParam *param);
 static int swReactorThread_onPipeWrite(swReactor *reactor, swEvent *ev);
 static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev);
+static int swReactorThread_onRingReceive(swReactor *reactor, swEvent *ev);
 
 static int swReactorThread_onRead(swReactor *reactor, swEvent *ev);
 static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev);
@@ -152,6 +153,119 @@ static void swReactorThread_onStreamResponse(swStream *stream, char *data, uint3
 /**
  * for udp
  */
+#ifdef HAVE_MMSG
+/**
+ * datagrams read by one recvmmsg() call
+ */
+static __thread struct
+{
+    struct mmsghdr msgs[SW_UDP_RECV_BATCH];
+    struct iovec iov[SW_UDP_RECV_BATCH];
+    swSocketAddress addrs[SW_UDP_RECV_BATCH];
+    char *buffer;
+} swReactorThread_udp;
+#endif
+
+static int swReactorThread_dispatch_packet(swFactory *factory, swDispatchData *task, int socket_type, swSocketAddress *info, char *packet, int length)
+{
+    swDgramPacket pkt;
+    pkt.length = length;
+
+    //IPv4
+    if (socket_type == SW_SOCK_UDP)
+    {
+        pkt.port = ntohs(info->addr.inet_v4.sin_port);
+        pkt.addr.v4.s_addr = info->addr.inet_v4.sin_addr.s_addr;
+        task->data.info.fd = pkt.addr.v4.s_addr;
+    }
+    //IPv6
+    else if (socket_type == SW_SOCK_UDP6)
+    {
+        pkt.port = ntohs(info->addr.inet_v6.sin6_port);
+        memcpy(&pkt.addr.v6, &info->addr.inet_v6.sin6_addr, sizeof(info->addr.inet_v6.sin6_addr));
+        memcpy(&task->data.info.fd, &info->addr.inet_v6.sin6_addr, sizeof(task->data.info.fd));
+    }
+    //Unix Dgram
+    else
+    {
+        pkt.addr.un.path_length = strlen(info->addr.un.sun_path) + 1;
+        pkt.length += pkt.addr.un.path_length;
+        pkt.port = 0;
+        memcpy(&task->data.info.fd, info->addr.un.sun_path + pkt.addr.un.path_length - 6, sizeof(task->data.info.fd));
+    }
+
+    task->target_worker_id = -1;
+    uint32_t header_size = sizeof(pkt);
+
+    //dgram header
+    memcpy(task->data.data, &pkt, sizeof(pkt));
+    //unix dgram
+    if (socket_type == SW_SOCK_UNIX_DGRAM)
+    {
+        header_size += pkt.addr.un.path_length;
+        memcpy(task->data.data + sizeof(pkt), info->addr.un.sun_path, pkt.addr.un.path_length);
+    }
+    //dgram body
+    if (pkt.length > SW_BUFFER_SIZE - sizeof(pkt))
+    {
+        task->data.info.len = SW_BUFFER_SIZE;
+    }
+    else
+    {
+        task->data.info.len = pkt.length + sizeof(pkt);
+    }
+    //dispatch packet header
+    memcpy(task->data.data + header_size, packet, task->data.info.len - header_size);
+
+    uint32_t send_n = pkt.length + header_size;
+    if (socket_type == SW_SOCK_UNIX_DGRAM)
+    {
+        send_n -= pkt.addr.un.path_length;
+    }
+    uint32_t offset = 0;
+
+    /**
+     * lock target
+     */
+    SwooleTG.factory_lock_target = 1;
+
+    if (factory->dispatch(factory, task) < 0)
+    {
+        return SW_ERR;
+    }
+
+    send_n -= task->data.info.len;
+    if (send_n == 0)
+    {
+        /**
+         * unlock
+         */
+        SwooleTG.factory_target_worker = -1;
+        SwooleTG.factory_lock_target = 0;
+        return SW_OK;
+    }
+
+    offset = SW_BUFFER_SIZE - header_size;
+    while (send_n > 0)
+    {
+        task->data.info.len = send_n > SW_BUFFER_SIZE ? SW_BUFFER_SIZE : send_n;
+        memcpy(task->data.data, packet + offset, task->data.info.len);
+        send_n -= task->data.info.len;
+        offset += task->data.info.len;
+
+        if (factory->dispatch(factory, task) < 0)
+        {
+            break;
+        }
+    }
+    /**
+     * unlock
+     */
+    SwooleTG.factory_target_worker = -1;
+    SwooleTG.factory_lock_target = 0;
+    return SW_OK;
+}
+
 static int swReactorThread_onPackage(swReactor *reactor, swEvent *event)
 {
     int fd = event->fd;
@@ -160,11 +274,8 @@ static int swReactorThread_onPackage(swReactor *reactor, swEvent *event)
     swServer *serv = SwooleG.serv;
     swConnection *server_sock = &serv->connection_list[fd];
     swDispatchData task;
-    swSocketAddress info;
-    swDgramPacket pkt;
     swFactory *factory = &serv->factory;
 
-    info.len = sizeof(info.addr);
     bzero(&task.data.info, sizeof(task.data.info));
     task.data.info.from_fd = fd;
     task.data.info.from_id = SwooleTG.id;
@@ -184,118 +295,81 @@ static int swReactorThread_onPackage(swReactor *reactor, swEvent *event)
         break;
     }
 
-    char packet[SW_BUFFER_SIZE_UDP];
-    do_recvfrom:
-    ret = recvfrom(fd, packet, SW_BUFFER_SIZE_UDP, 0, (struct sockaddr *) &info.addr, &info.len);
-
-    if (ret > 0)
+#ifdef HAVE_MMSG
+    int i;
+    if (swReactorThread_udp.buffer == NULL)
     {
-        pkt.length = ret;
-
-        //IPv4
-        if (socket_type == SW_SOCK_UDP)
+        swReactorThread_udp.buffer = sw_malloc(SW_UDP_RECV_BATCH * SW_BUFFER_SIZE_UDP);
+        if (swReactorThread_udp.buffer == NULL)
         {
-            pkt.port = ntohs(info.addr.inet_v4.sin_port);
-            pkt.addr.v4.s_addr = info.addr.inet_v4.sin_addr.s_addr;
-            task.data.info.fd = pkt.addr.v4.s_addr;
-        }
-        //IPv6
-        else if (socket_type == SW_SOCK_UDP6)
-        {
-            pkt.port = ntohs(info.addr.inet_v6.sin6_port);
-            memcpy(&pkt.addr.v6, &info.addr.inet_v6.sin6_addr, sizeof(info.addr.inet_v6.sin6_addr));
-            memcpy(&task.data.info.fd, &info.addr.inet_v6.sin6_addr, sizeof(task.data.info.fd));
+            swWarn("malloc(%d) failed.", SW_UDP_RECV_BATCH * SW_BUFFER_SIZE_UDP);
+            return SW_ERR;
         }
-        //Unix Dgram
-        else
+        for (i = 0; i < SW_UDP_RECV_BATCH; i++)
         {
-            pkt.addr.un.path_length = strlen(info.addr.un.sun_path) + 1;
-            pkt.length += pkt.addr.un.path_length;
-            pkt.port = 0;
-            memcpy(&task.data.info.fd, info.addr.un.sun_path + pkt.addr.un.path_length - 6, sizeof(task.data.info.fd));
+            swReactorThread_udp.iov[i].iov_base = swReactorThread_udp.buffer + i * SW_BUFFER_SIZE_UDP;
+            swReactorThread_udp.iov[i].iov_len = SW_BUFFER_SIZE_UDP;
+            swReactorThread_udp.msgs[i].msg_hdr.msg_iov = &swReactorThread_udp.iov[i];
+            swReactorThread_udp.msgs[i].msg_hdr.msg_iovlen = 1;
+            swReactorThread_udp.msgs[i].msg_hdr.msg_name = &swReactorThread_udp.addrs[i].addr;
         }
+    }
 
-        task.target_worker_id = -1;
-        uint32_t header_size = sizeof(pkt);
-
-        //dgram header
-        memcpy(task.data.data, &pkt, sizeof(pkt));
-        //unix dgram
-        if (socket_type == SW_SOCK_UNIX_DGRAM)
+    while (1)
+    {
+        for (i = 0; i < SW_UDP_RECV_BATCH; i++)
         {
-            header_size += pkt.addr.un.path_length;
-            memcpy(task.data.data + sizeof(pkt), info.addr.un.sun_path, pkt.addr.un.path_length);
+            swReactorThread_udp.msgs[i].msg_hdr.msg_namelen = sizeof(swReactorThread_udp.addrs[i].addr);
         }
-        //dgram body
-        if (pkt.length > SW_BUFFER_SIZE - sizeof(pkt))
+        ret = recvmmsg(fd, swReactorThread_udp.msgs, SW_UDP_RECV_BATCH, 0, NULL);
+        if (ret <= 0)
         {
-            task.data.info.len = SW_BUFFER_SIZE;
+            break;
         }
-        else
+        for (i = 0; i < ret; i++)
         {
-            task.data.info.len = pkt.length + sizeof(pkt);
+            if (swReactorThread_udp.msgs[i].msg_len == 0)
+            {
+                continue;
+            }
+            if (swReactorThread_dispatch_packet(factory, &task, socket_type, &swReactorThread_udp.addrs[i],
+                    swReactorThread_udp.iov[i].iov_base, swReactorThread_udp.msgs[i].msg_len) < 0)
+            {
+                return SW_ERR;
+            }
         }
-        //dispatch packet header
-        memcpy(task.data.data + header_size, packet, task.data.info.len - header_size);
-
-        uint32_t send_n = pkt.length + header_size;
-        if (socket_type == SW_SOCK_UNIX_DGRAM)
+        //the socket queue is drained
+        if (ret < SW_UDP_RECV_BATCH)
         {
-            send_n -= pkt.addr.un.path_length;
+            return SW_OK;
         }
-        uint32_t offset = 0;
-
-        /**
-         * lock target
-         */
-        SwooleTG.factory_lock_target = 1;
+    }
+#else
+    swSocketAddress info;
+    char packet[SW_BUFFER_SIZE_UDP];
 
-        if (factory->dispatch(factory, &task) < 0)
+    while (1)
+    {
+        info.len = sizeof(info.addr);
+        ret = recvfrom(fd, packet, SW_BUFFER_SIZE_UDP, 0, (struct sockaddr *) &info.addr, &info.len);
+        if (ret <= 0)
         {
-            return SW_ERR;
+            break;
         }
-
-        send_n -= task.data.info.len;
-        if (send_n == 0)
+        if (swReactorThread_dispatch_packet(factory, &task, socket_type, &info, packet, ret) < 0)
         {
-            /**
-             * unlock
-             */
-            SwooleTG.factory_target_worker = -1;
-            SwooleTG.factory_lock_target = 0;
-            goto do_recvfrom;
+            return SW_ERR;
         }
+    }
+#endif
 
-        offset = SW_BUFFER_SIZE - header_size;
-        while (send_n > 0)
-        {
-            task.data.info.len = send_n > SW_BUFFER_SIZE ? SW_BUFFER_SIZE : send_n;
-            memcpy(task.data.data, packet + offset, task.data.info.len);
-            send_n -= task.data.info.len;
-            offset += task.data.info.len;
-
-            if (factory->dispatch(factory, &task) < 0)
-            {
-                break;
-            }
-        }
-        /**
-         * unlock
-         */
-        SwooleTG.factory_target_worker = -1;
-        SwooleTG.factory_lock_target = 0;
-        goto do_recvfrom;
+    if (errno == EAGAIN)
+    {
+        return SW_OK;
     }
     else
     {
-        if (errno == EAGAIN)
-        {
-            return SW_OK;
-        }
-        else
-        {
-            swSysError("recvfrom(%d) failed.", fd);
-        }
+        swSysError("recvfrom(%d) failed.", fd);
     }
     return ret;
 }
@@ -426,6 +500,12 @@ int swReactorThread_onClose(swReactor *reactor, swEvent *event)
     {
         return SW_ERR;
     }
+#ifdef HAVE_MSG_ZEROCOPY
+    else if (conn->zerocopy && swConnection_zerocopy_onError(reactor, conn) == SW_OK)
+    {
+        return SW_OK;
+    }
+#endif
     else if (serv->disable_notify)
     {
         swReactorThread_close(reactor, fd);
@@ -441,6 +521,71 @@ int swReactorThread_onClose(swReactor *reactor, swEvent *event)
     }
 }
 
+/**
+ * dispatch one response of the worker process
+ */
+static int swReactorThread_onResponse(swReactor *reactor, swEventData *resp)
+{
+    swSendData _send;
+    swPackage_response pkg_resp;
+    swWorker *worker;
+
+    memcpy(&_send.info, &resp->info, sizeof(resp->info));
+    //pipe data
+    if (_send.info.from_fd == SW_RESPONSE_SMALL)
+    {
+        _send.data = resp->data;
+        _send.length = resp->info.len;
+        swReactorThread_send(&_send);
+    }
+    //use send shm
+    else if (_send.info.from_fd == SW_RESPONSE_SHM)
+    {
+        memcpy(&pkg_resp, resp->data, sizeof(pkg_resp));
+        worker = swServer_get_worker(SwooleG.serv, pkg_resp.worker_id);
+
+        _send.data = worker->send_shm;
+        _send.length = pkg_resp.length;
+
+#if 0
+        struct
+        {
+            uint32_t worker;
+            uint32_t index;
+            uint32_t serid;
+        } pkg_header;
+
+        memcpy(&pkg_header, _send.data + 4, sizeof(pkg_header));
+        swWarn("fd=%d, worker=%d, index=%d, serid=%d", _send.info.fd, pkg_header.worker, pkg_header.index, pkg_header.serid);
+#endif
+        swReactorThread_send(&_send);
+        worker->lock.unlock(&worker->lock);
+    }
+    //use tmp file
+    else if (_send.info.from_fd == SW_RESPONSE_TMPFILE)
+    {
+        swString *data = swTaskWorker_large_unpack(resp);
+        if (data == NULL)
+        {
+            return SW_ERR;
+        }
+        _send.data = data->str;
+        _send.length = data->length;
+        swReactorThread_send(&_send);
+    }
+    //reactor thread exit
+    else if (_send.info.from_fd == SW_RESPONSE_EXIT)
+    {
+        reactor->running = 0;
+    }
+    //will never be here
+    else
+    {
+        abort();
+    }
+    return SW_OK;
+}
+
 /**
  * receive data from worker process pipe
  */
@@ -448,10 +593,6 @@ static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev)
 {
     int n;
     swEventData resp;
-    swSendData _send;
-
-    swPackage_response pkg_resp;
-    swWorker *worker;
 
 #ifdef SW_REACTOR_RECV_AGAIN
     while (1)
@@ -460,60 +601,14 @@ static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev)
         n = read(ev->fd, &resp, sizeof(resp));
         if (n > 0)
         {
-            memcpy(&_send.info, &resp.info, sizeof(resp.info));
-            //pipe data
-            if (_send.info.from_fd == SW_RESPONSE_SMALL)
-            {
-                _send.data = resp.data;
-                _send.length = resp.info.len;
-                swReactorThread_send(&_send);
-            }
-            //use send shm
-            else if (_send.info.from_fd == SW_RESPONSE_SHM)
-            {
-                memcpy(&pkg_resp, resp.data, sizeof(pkg_resp));
-                worker = swServer_get_worker(SwooleG.serv, pkg_resp.worker_id);
-
-                _send.data = worker->send_shm;
-                _send.length = pkg_resp.length;
-
-#if 0
-                struct
-                {
-                    uint32_t worker;
-                    uint32_t index;
-                    uint32_t serid;
-                } pkg_header;
-
-                memcpy(&pkg_header, _send.data + 4, sizeof(pkg_header));
-                swWarn("fd=%d, worker=%d, index=%d, serid=%d", _send.info.fd, pkg_header.worker, pkg_header.index, pkg_header.serid);
-#endif
-                swReactorThread_send(&_send);
-                worker->lock.unlock(&worker->lock);
-            }
-            //use tmp file
-            else if (_send.info.from_fd == SW_RESPONSE_TMPFILE)
+            if (swReactorThread_onResponse(reactor, &resp) < 0)
             {
-                swString *data = swTaskWorker_large_unpack(&resp);
-                if (data == NULL)
-                {
-                    return SW_ERR;
-                }
-                _send.data = data->str;
-                _send.length = data->length;
-                swReactorThread_send(&_send);
+                return SW_ERR;
             }
-            //reactor thread exit
-            else if (_send.info.from_fd == SW_RESPONSE_EXIT)
+            if (!reactor->running)
             {
-                reactor->running = 0;
                 return SW_OK;
             }
-            //will never be here
-            else
-            {
-                abort();
-            }
         }
         else if (errno == EAGAIN)
         {
@@ -529,6 +624,82 @@ static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev)
     return SW_OK;
 }
 
+/**
+ * drain the response rings of all workers, one wakeup covers every pending response
+ */
+static int swReactorThread_onRingReceive(swReactor *reactor, swEvent *ev)
+{
+    swServer *serv = reactor->ptr;
+    swReactorThread *thread = swServer_get_thread(serv, reactor->id);
+    swRingChannel *ring;
+    swEventData *resp;
+    uint64_t flag;
+    int i, len;
+
+    if (thread->ring_notify.read(&thread->ring_notify, &flag, sizeof(flag)) < 0 && errno != EAGAIN)
+    {
+        swSysError("read(ring_notify) failed.");
+    }
+    //workers pushing after this point will notify again
+    thread->ring_notified = 0;
+    sw_atomic_memory_barrier();
+
+    for (i = 0; i < serv->worker_num; i++)
+    {
+        ring = serv->response_rings[i * serv->reactor_num + reactor->id];
+        while ((resp = swRingChannel_front(ring, &len)) != NULL)
+        {
+            swReactorThread_onResponse(reactor, resp);
+            swRingChannel_pop(ring);
+        }
+    }
+    return SW_OK;
+}
+
+/**
+ * one ring per worker and reactor thread, so every ring has a single producer and a single consumer
+ */
+int swReactorThread_create_rings(swServer *serv)
+{
+    int i, n = serv->worker_num * serv->reactor_num;
+    size_t size = serv->ipc_ring_size;
+
+    if (size < sizeof(swEventData) * 2)
+    {
+        size = sizeof(swEventData) * 2;
+    }
+    serv->response_rings = SwooleG.memory_pool->alloc(SwooleG.memory_pool, n * sizeof(swRingChannel *));
+    if (serv->response_rings == NULL)
+    {
+        swWarn("malloc[response_rings] failed.");
+        return SW_ERR;
+    }
+    for (i = 0; i < n; i++)
+    {
+        serv->response_rings[i] = swRingChannel_new(size, SW_CHAN_SHM);
+        if (serv->response_rings[i] == NULL)
+        {
+            swWarn("swRingChannel_new(%ld) failed.", (long) size);
+            return SW_ERR;
+        }
+        //on the node of the reactor thread, the same as its workers with numa_affinity
+        if (serv->numa_node_num > 1)
+        {
+            sw_shm_bind_node(serv->response_rings[i], (i % serv->reactor_num) % serv->numa_node_num);
+        }
+    }
+    for (i = 0; i < serv->reactor_num; i++)
+    {
+        swReactorThread *thread = swServer_get_thread(serv, i);
+        if (swPipeNotify_auto(&thread->ring_notify, 0, 0) < 0)
+        {
+            return SW_ERR;
+        }
+        thread->ring_notified = 0;
+    }
+    return SW_OK;
+}
+
 int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id)
 {
     swServer *serv = SwooleG.serv;
@@ -668,7 +839,7 @@ int swReactorThread_send(swSendData *_send)
         /**
          * close connection.
          */
-        if (_send->info.type == SW_EVENT_CLOSE)
+        if (_send->info.type == SW_EVENT_CLOSE && !swConnection_zerocopy_pending(conn))
         {
             close_fd:
             reactor->close(reactor, fd);
@@ -676,7 +847,7 @@ int swReactorThread_send(swSendData *_send)
         }
 #ifdef SW_REACTOR_SYNC_SEND
         //Direct send
-        if (_send->info.type != SW_EVENT_SENDFILE)
+        if (_send->info.type != SW_EVENT_SENDFILE && _send->info.type != SW_EVENT_CLOSE)
         {
             if (!conn->direct_send)
             {
@@ -720,6 +891,7 @@ int swReactorThread_send(swSendData *_send)
                 {
                     return SW_ERR;
                 }
+                conn->out_buffer->coalesce = 1;
             }
         }
     }
@@ -758,10 +930,6 @@ int swReactorThread_send(swSendData *_send)
                 swoole_error_log(SW_LOG_WARNING, SW_ERROR_OUTPUT_BUFFER_OVERFLOW, "connection#%d output buffer overflow.", fd);
             }
             conn->overflow = 1;
-            if (serv->onBufferEmpty && serv->onBufferFull == NULL)
-            {
-                conn->high_watermark = 1;
-            }
         }
 
         int _length = _send_length;
@@ -777,10 +945,18 @@ int swReactorThread_send(swSendData *_send)
             _length -= _n;
         }
 
+        /**
+         * an overflow counts as crossing the high watermark, otherwise a send_yield coroutine
+         * would never get the BUFFER_EMPTY event when the watermark is above buffer_output_size
+         */
         swListenPort *port = swServer_get_port(serv, fd);
-        if (serv->onBufferFull && conn->high_watermark == 0 && conn->out_buffer->length >= port->buffer_high_watermark)
+        if (conn->high_watermark == 0 && (serv->onBufferFull || serv->onBufferEmpty)
+                && (conn->out_buffer->length >= port->buffer_high_watermark || conn->overflow))
         {
-            swServer_tcp_notify(serv, conn, SW_EVENT_BUFFER_FULL);
+            if (serv->onBufferFull)
+            {
+                swServer_tcp_notify(serv, conn, SW_EVENT_BUFFER_FULL);
+            }
             conn->high_watermark = 1;
         }
     }
@@ -1015,6 +1191,11 @@ static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev)
         chunk = swBuffer_get_trunk(conn->out_buffer);
         if (chunk->type == SW_CHUNK_CLOSE)
         {
+            //wait for the MSG_ZEROCOPY completions, see swConnection_zerocopy_onError
+            if (swConnection_zerocopy_pending(conn))
+            {
+                return reactor->set(reactor, fd, SW_FD_TCP | SW_EVENT_READ);
+            }
             close_fd: reactor->close(reactor, fd);
             return SW_OK;
         }
@@ -1206,7 +1387,15 @@ static int swReactorThread_loop(swThreadParam *param)
 
 #ifdef HAVE_CPU_AFFINITY
     //cpu affinity setting
-    if (serv->open_cpu_affinity)
+    if (serv->numa_node_num > 1)
+    {
+        cpu_set_t cpu_set;
+        if (swServer_numa_cpu_set(serv, reactor_id, &cpu_set) == SW_OK && 0 != pthread_setaffinity_np(thread_id, sizeof(cpu_set), &cpu_set))
+        {
+            swSysError("pthread_setaffinity_np() failed.");
+        }
+    }
+    else if (serv->open_cpu_affinity)
     {
         cpu_set_t cpu_set;
         CPU_ZERO(&cpu_set);
@@ -1249,6 +1438,12 @@ static int swReactorThread_loop(swThreadParam *param)
     reactor->setHandle(reactor, SW_FD_PIPE | SW_EVENT_READ, swReactorThread_onPipeReceive);
     reactor->setHandle(reactor, SW_FD_PIPE | SW_EVENT_WRITE, swReactorThread_onPipeWrite);
 
+    if (serv->response_rings)
+    {
+        reactor->setHandle(reactor, SW_FD_RING | SW_EVENT_READ, swReactorThread_onRingReceive);
+        reactor->add(reactor, thread->ring_notify.getFd(&thread->ring_notify, 0), SW_FD_RING);
+    }
+
     //listen UDP
     if (serv->have_udp_sock == 1)
     {
@@ -1549,6 +1744,19 @@ void swReactorThread_free(swServer *serv)
 #ifdef SW_USE_RINGBUFFER
         thread->buffer_input->destroy(thread->buffer_input);
 #endif
+        if (serv->response_rings)
+        {
+            thread->ring_notify.close(&thread->ring_notify);
+        }
+    }
+
+    if (serv->response_rings)
+    {
+        for (i = 0; i < serv->worker_num * serv->reactor_num; i++)
+        {
+            swRingChannel_free(serv->response_rings[i]);
+        }
+        serv->response_rings = NULL;
     }
 }
 
@@ -54,7 +54,13 @@ static void swHeartbeatThread_start(swServer *serv);
 static void swHeartbeatThread_loop(swThreadParam *param);
 #endif
 
+static void swStatsThread_start(swServer *serv);
+static void swStatsThread_loop(swThreadParam *param);
+
 static swConnection* swServer_connection_new(swServer *serv, swListenPort *ls, int fd, int from_fd, int reactor_id);
+#ifdef SW_USE_OPENSSL
+static void swServer_rotate_ticket_keys(void *data);
+#endif
 
 swServerG SwooleG;
 swServerGS *SwooleGS;
@@ -91,7 +97,7 @@ void swServer_enable_accept(swReactor *reactor)
         {
             continue;
         }
-        reactor->add(reactor, ls->sock, SW_FD_LISTEN);
+        reactor->add(reactor, ls->sock, swServer_listen_fdtype(SwooleG.serv));
     }
 }
 
@@ -233,7 +239,8 @@ static int swServer_start_check(swServer *serv)
     //disable notice when use SW_DISPATCH_ROUND and SW_DISPATCH_QUEUE
     if (serv->factory_mode == SW_MODE_PROCESS)
     {
-        if (serv->dispatch_mode == SW_DISPATCH_ROUND || serv->dispatch_mode == SW_DISPATCH_QUEUE)
+        if (serv->dispatch_mode == SW_DISPATCH_ROUND || serv->dispatch_mode == SW_DISPATCH_QUEUE
+                || serv->dispatch_mode == SW_DISPATCH_LEAST_LOADED)
         {
             if (!serv->enable_unsafe_event)
             {
@@ -271,6 +278,21 @@ static int swServer_start_check(swServer *serv)
     {
         serv->reactor_num = serv->worker_num;
     }
+#if defined(HAVE_CPU_AFFINITY) && defined(__linux__)
+    serv->numa_node_num = 0;
+    if (serv->numa_affinity)
+    {
+        int node_num = swoole_numa_node_num();
+        if (node_num > 1 && serv->factory_mode == SW_MODE_PROCESS && serv->reactor_num >= node_num && serv->worker_num >= node_num)
+        {
+            serv->numa_node_num = node_num;
+        }
+        else if (node_num > 1)
+        {
+            swWarn("numa_affinity needs the process mode and at least %d reactor threads and workers.", node_num);
+        }
+    }
+#endif
     if (SwooleG.max_sockets > 0 && serv->max_connection > SwooleG.max_sockets)
     {
         swWarn("serv->max_connection is exceed the maximum value[%d].", SwooleG.max_sockets);
@@ -365,6 +387,14 @@ static int swServer_start_proxy(swServer *serv)
     }
 #endif
 
+    /**
+     * prometheus endpoint
+     */
+    if (serv->latency_stats && serv->stats_port > 0)
+    {
+        swStatsThread_start(serv);
+    }
+
     /**
      * master thread loop
      */
@@ -508,6 +538,10 @@ int swServer_create_task_worker(swServer *serv)
     {
         ipc_mode = SW_IPC_SOCKET;
     }
+    else if (SwooleG.task_ipc_mode == SW_TASK_IPC_SHMQUEUE)
+    {
+        ipc_mode = SW_IPC_SHMQUEUE;
+    }
     else
     {
         ipc_mode = SW_IPC_UNIXSOCK;
@@ -530,10 +564,52 @@ int swServer_create_task_worker(swServer *serv)
     return SW_OK;
 }
 
+#ifdef HAVE_CPU_AFFINITY
+/**
+ * the id-th reactor thread or worker runs on NUMA node id % numa_node_num,
+ * on one cpu of the node with open_cpu_affinity, otherwise on any of them
+ */
+int swServer_numa_cpu_set(swServer *serv, int id, cpu_set_t *set)
+{
+#ifdef __linux__
+    int i, j = 0;
+    int n = swoole_numa_node_cpus(id % serv->numa_node_num, set);
+    if (n <= 0)
+    {
+        return SW_ERR;
+    }
+    if (serv->open_cpu_affinity)
+    {
+        int k = (id / serv->numa_node_num) % n;
+        for (i = 0; i < CPU_SETSIZE; i++)
+        {
+            if (CPU_ISSET(i, set) && j++ == k)
+            {
+                CPU_ZERO(set);
+                CPU_SET(i, set);
+                break;
+            }
+        }
+    }
+    return SW_OK;
+#else
+    return SW_ERR;
+#endif
+}
+#endif
+
 int swServer_worker_init(swServer *serv, swWorker *worker)
 {
 #ifdef HAVE_CPU_AFFINITY
-    if (serv->open_cpu_affinity)
+    if (serv->numa_node_num > 1)
+    {
+        cpu_set_t cpu_set;
+        if (swServer_numa_cpu_set(serv, SwooleWG.id, &cpu_set) == SW_OK && sched_setaffinity(getpid(), sizeof(cpu_set), &cpu_set) < 0)
+        {
+            swSysError("sched_setaffinity() failed.");
+        }
+    }
+    else if (serv->open_cpu_affinity)
     {
         cpu_set_t cpu_set;
         CPU_ZERO(&cpu_set);
@@ -694,6 +770,28 @@ int swServer_start(swServer *serv)
     serv->sendfile = swServer_tcp_sendfile;
     serv->close = swServer_tcp_close;
 
+#ifdef SW_USE_OPENSSL
+    /**
+     * the manager rotates the shared session ticket keys
+     */
+    swListenPort *ls;
+    LL_FOREACH(serv->listen_list, ls)
+    {
+        if (ls->ssl && ls->ssl_config.session_tickets)
+        {
+            if (serv->manager_alarm == 0)
+            {
+                serv->manager_alarm = 1;
+            }
+            if (swServer_add_hook(serv, SW_SERVER_HOOK_MANAGER_TIMER, swServer_rotate_ticket_keys, 1) < 0)
+            {
+                return SW_ERR;
+            }
+            break;
+        }
+    }
+#endif
+
     serv->workers = SwooleG.memory_pool->alloc(SwooleG.memory_pool, serv->worker_num * sizeof(swWorker));
     if (serv->workers == NULL)
     {
@@ -810,6 +908,8 @@ void swServer_init(swServer *serv)
     //http server
     serv->http_parse_post = 1;
     serv->upload_tmp_dir = sw_strdup("/tmp");
+    serv->http_compression_min_length = SW_HTTP_COMPRESS_MIN_LENGTH;
+    serv->static_handler_cache_expire = SW_HTTP_STATIC_CACHE_EXPIRE;
 
     //heartbeat check
     serv->heartbeat_idle_time = SW_HEARTBEAT_IDLE;
@@ -887,6 +987,17 @@ int swServer_free(swServer *serv)
             swSysError("pthread_join(%ld) failed.", (ulong_t )SwooleG.heartbeat_pidt);
         }
     }
+    if (SwooleG.stats_pidt)
+    {
+        if (pthread_cancel(SwooleG.stats_pidt) < 0)
+        {
+            swSysError("pthread_cancel(%ld) failed.", (ulong_t )SwooleG.stats_pidt);
+        }
+        if (pthread_join(SwooleG.stats_pidt, NULL) < 0)
+        {
+            swSysError("pthread_join(%ld) failed.", (ulong_t )SwooleG.stats_pidt);
+        }
+    }
     if (serv->factory_mode == SW_MODE_SINGLE)
     {
         swTraceLog(SW_TRACE_SERVER, "terminate task workers.");
@@ -1225,6 +1336,21 @@ int swServer_add_worker(swServer *serv, swWorker *worker)
     return worker->id;
 }
 
+#ifdef SW_USE_OPENSSL
+static void swServer_rotate_ticket_keys(void *data)
+{
+    swServer *serv = (swServer *) data;
+    swListenPort *ls;
+    LL_FOREACH(serv->listen_list, ls)
+    {
+        if (ls->ssl && ls->ssl_context)
+        {
+            swSSL_rotate_ticket_keys(ls->ssl_context, 0);
+        }
+    }
+}
+#endif
+
 SW_API int swServer_add_hook(swServer *serv, enum swServer_hook_type type, swCallback func, int push_back)
 {
     if (serv->hooks[type] == NULL)
@@ -1726,6 +1852,21 @@ static swConnection* swServer_connection_new(swServer *serv, swListenPort *ls, i
         connection->tcp_nodelay = 1;
     }
 
+#ifdef HAVE_MSG_ZEROCOPY
+    if (ls->send_zerocopy && !ls->ssl)
+    {
+        int sockopt = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &sockopt, sizeof(sockopt)) < 0)
+        {
+            swSysError("setsockopt(SO_ZEROCOPY) failed.");
+        }
+        else
+        {
+            connection->zerocopy = 1;
+        }
+    }
+#endif
+
     //socket recv buffer size
     if (ls->kernel_socket_recv_buffer_size > 0)
     {
@@ -1846,3 +1987,128 @@ void swServer_set_callback_onClose(swServer *serv, void (*callback)(swServer *,
     onClose_callback = callback;
     serv->onClose = swServer_scalar_onClose_callback;
 }
+
+static void swServer_stats_histogram(swString *buffer, char *name, swWorker *worker, swHistogram *h)
+{
+    char line[256];
+    uint64_t count = 0;
+    int i, n;
+
+    for (i = 0; i < SW_HISTOGRAM_BUCKETS; i++)
+    {
+        count += h->count[i];
+        //one bucket per power of 2
+        if (i != 7 && (i < 8 || (i - 8) % 4 != 3))
+        {
+            continue;
+        }
+        n = snprintf(line, sizeof(line), "swoole_%s_microseconds_bucket{worker=\"%d\",le=\"%lu\"} %lu\n", name, worker->id,
+                (ulong_t) swHistogram_bucket_max(i), (ulong_t) count);
+        swString_append_ptr(buffer, line, n);
+    }
+    n = snprintf(line, sizeof(line), "swoole_%s_microseconds_bucket{worker=\"%d\",le=\"+Inf\"} %lu\n"
+            "swoole_%s_microseconds_sum{worker=\"%d\"} %lu\n"
+            "swoole_%s_microseconds_count{worker=\"%d\"} %lu\n", name, worker->id, (ulong_t) count, name, worker->id,
+            (ulong_t) h->sum, name, worker->id, (ulong_t) count);
+    swString_append_ptr(buffer, line, n);
+}
+
+/**
+ * the latency histograms of the event workers in the prometheus text format
+ */
+void swServer_stats_prometheus(swServer *serv, swString *buffer)
+{
+    static char *names[] = { "request_latency", "queue_latency", "reactor_wait", "reactor_loop" };
+    char line[256];
+    int i, j, n;
+
+    for (j = 0; j < 4; j++)
+    {
+        n = snprintf(line, sizeof(line), "# TYPE swoole_%s_microseconds histogram\n", names[j]);
+        swString_append_ptr(buffer, line, n);
+        for (i = 0; i < serv->worker_num; i++)
+        {
+            swWorker *worker = swServer_get_worker(serv, i);
+            swHistogram *h = j == 0 ? &worker->request_histogram :
+                    j == 1 ? &worker->queue_histogram : j == 2 ? &worker->wait_histogram : &worker->loop_histogram;
+            swServer_stats_histogram(buffer, names[j], worker, h);
+        }
+    }
+}
+
+static void swStatsThread_start(swServer *serv)
+{
+    swThreadParam *param;
+    pthread_t thread_id;
+    char *host = serv->stats_host ? serv->stats_host : "127.0.0.1";
+
+    int sock = swSocket_create_server(SW_SOCK_TCP, host, serv->stats_port, SW_BACKLOG);
+    if (sock < 0)
+    {
+        swWarn("failed to listen on stats port %s:%d.", host, serv->stats_port);
+        return;
+    }
+    param = SwooleG.memory_pool->alloc(SwooleG.memory_pool, sizeof(swThreadParam));
+    if (param == NULL)
+    {
+        close(sock);
+        return;
+    }
+    param->object = serv;
+    param->pti = sock;
+
+    if (pthread_create(&thread_id, NULL, (void * (*)(void *)) swStatsThread_loop, (void *) param) < 0)
+    {
+        swWarn("pthread_create[stats] failed.");
+        close(sock);
+        return;
+    }
+    SwooleG.stats_pidt = thread_id;
+}
+
+/**
+ * every request gets the metrics, the connection is closed after the response
+ */
+static void swStatsThread_loop(swThreadParam *param)
+{
+    swSignal_none();
+
+    swServer *serv = param->object;
+    int sock = param->pti;
+    char request[SW_BUFFER_SIZE_STD];
+    char header[256];
+    int fd, n;
+
+    swString *buffer = swString_new(SW_BUFFER_SIZE_BIG);
+    if (buffer == NULL)
+    {
+        return;
+    }
+
+    while (SwooleG.running)
+    {
+        fd = accept(sock, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            swSysError("accept() failed.");
+            break;
+        }
+        swSocket_set_timeout(fd, 1);
+        if (recv(fd, request, sizeof(request), 0) > 0)
+        {
+            swString_clear(buffer);
+            swServer_stats_prometheus(serv, buffer);
+            n = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                    "Content-Length: %ld\r\nConnection: close\r\n\r\n", (long) buffer->length);
+            swSocket_write_blocking(fd, header, n);
+            swSocket_write_blocking(fd, buffer->str, buffer->length);
+        }
+        close(fd);
+    }
+    swString_free(buffer);
+    close(sock);
+}
@@ -20,6 +20,8 @@
 static swEventData *current_task;
 
 static void swTaskWorker_signal_init(void);
+static void swTaskWorker_shm_init(void);
+static int swTaskWorker_batch_execute(swServer *serv, swEventData *batch);
 
 void swTaskWorker_init(swProcessPool *pool)
 {
@@ -31,6 +33,8 @@ void swTaskWorker_init(swProcessPool *pool)
     pool->start_id = SwooleG.serv->worker_num;
     pool->run_worker_num = SwooleG.task_worker_num;
 
+    swTaskWorker_shm_init();
+
     if (SwooleG.task_ipc_mode == SW_TASK_IPC_PREEMPTIVE)
     {
         pool->dispatch_mode = SW_DISPATCH_QUEUE;
@@ -64,6 +68,10 @@ int swTaskWorker_onTask(swProcessPool *pool, swEventData *task)
     {
         serv->onPipeMessage(serv, task);
     }
+    else if (swTask_type(task) & SW_TASK_BATCH)
+    {
+        ret = swTaskWorker_batch_execute(serv, task);
+    }
     else
     {
         ret = serv->onTask(serv, task);
@@ -72,11 +80,146 @@ int swTaskWorker_onTask(swProcessPool *pool, swEventData *task)
     return ret;
 }
 
+/**
+ * a batch is a sequence of packed tasks [swDataHead, data], each one gets its own onTask and finish
+ */
+static int swTaskWorker_batch_execute(swServer *serv, swEventData *batch)
+{
+    static swString *buffer = NULL;
+    swEventData task;
+
+    if (buffer == NULL)
+    {
+        buffer = swString_new(SW_BUFFER_SIZE_BIG);
+        if (buffer == NULL)
+        {
+            return SW_ERR;
+        }
+    }
+    swString_clear(buffer);
+
+    //copied out, the tasks may unpack their own large data into module_stack
+    if (swTask_type(batch) & SW_TASK_TMPFILE)
+    {
+        swString *data = swTaskWorker_large_unpack(batch);
+        if (data == NULL || swString_append(buffer, data) < 0)
+        {
+            return SW_ERR;
+        }
+    }
+    else if (swString_append_ptr(buffer, batch->data, batch->info.len) < 0)
+    {
+        return SW_ERR;
+    }
+
+    size_t offset = 0;
+    while (offset + sizeof(swDataHead) <= buffer->length)
+    {
+        memcpy(&task.info, buffer->str + offset, sizeof(swDataHead));
+        if (task.info.len > sizeof(task.data) || offset + sizeof(swDataHead) + task.info.len > buffer->length)
+        {
+            swWarn("invalid task batch.");
+            break;
+        }
+        memcpy(task.data, buffer->str + offset + sizeof(swDataHead), task.info.len);
+        offset += sizeof(swDataHead) + task.info.len;
+
+        current_task = &task;
+        serv->onTask(serv, &task);
+    }
+    current_task = batch;
+    return SW_OK;
+}
+
+/**
+ * send the packed tasks of a batch to one task worker in a single message
+ */
+int swTaskWorker_batch_dispatch(swString *batch, int blocking)
+{
+    swEventData buf;
+    int dst_worker_id = -1;
+
+    buf.info.type = SW_EVENT_TASK;
+    buf.info.fd = 0;
+    buf.info.from_id = SwooleWG.id;
+    swTask_type(&buf) = SW_TASK_BATCH;
+
+    if (batch->length >= SW_IPC_MAX_SIZE - sizeof(buf.info))
+    {
+        if (swTaskWorker_large_pack(&buf, batch->str, batch->length) < 0)
+        {
+            swWarn("large task pack failed()");
+            return SW_ERR;
+        }
+    }
+    else
+    {
+        memcpy(buf.data, batch->str, batch->length);
+        buf.info.len = batch->length;
+    }
+
+    if (blocking)
+    {
+        return swProcessPool_dispatch_blocking(&SwooleGS->task_workers, &buf, &dst_worker_id);
+    }
+    else
+    {
+        return swProcessPool_dispatch(&SwooleGS->task_workers, &buf, &dst_worker_id);
+    }
+}
+
+/**
+ * the ring must exist before fork, its memory is shared by the master, workers and task workers
+ */
+static void swTaskWorker_shm_init(void)
+{
+    if (SwooleG.task_shm_size == 0 || SwooleG.task_shm_pool)
+    {
+        return;
+    }
+    swLock *lock = SwooleG.memory_pool->alloc(SwooleG.memory_pool, sizeof(swLock));
+    if (lock == NULL || swMutex_create(lock, 1) < 0)
+    {
+        swWarn("create task shm lock failed.");
+        return;
+    }
+    SwooleG.task_shm_pool = swRingBuffer_new(SwooleG.task_shm_size, 1);
+    if (SwooleG.task_shm_pool == NULL)
+    {
+        return;
+    }
+    SwooleG.task_shm_lock = lock;
+}
+
+static void* swTaskWorker_shm_alloc(uint32_t size)
+{
+    if (SwooleG.task_shm_pool == NULL || size > SwooleG.task_shm_size / 2)
+    {
+        return NULL;
+    }
+    SwooleG.task_shm_lock->lock(SwooleG.task_shm_lock);
+    void *ptr = SwooleG.task_shm_pool->alloc(SwooleG.task_shm_pool, size);
+    SwooleG.task_shm_lock->unlock(SwooleG.task_shm_lock);
+    return ptr;
+}
+
 int swTaskWorker_large_pack(swEventData *task, void *data, int data_len)
 {
     swPackage_task pkg;
     bzero(&pkg, sizeof(pkg));
 
+    //no file system I/O while the ring has room, tmp file when it is full
+    pkg.shm_data = swTaskWorker_shm_alloc(data_len);
+    if (pkg.shm_data)
+    {
+        memcpy(pkg.shm_data, data, data_len);
+        task->info.len = sizeof(swPackage_task);
+        swTask_type(task) |= SW_TASK_TMPFILE;
+        pkg.length = data_len;
+        memcpy(task->data, &pkg, sizeof(swPackage_task));
+        return SW_OK;
+    }
+
     memcpy(pkg.tmpfile, SwooleG.task_tmpdir, SwooleG.task_tmpdir_len);
 
     //create temp file
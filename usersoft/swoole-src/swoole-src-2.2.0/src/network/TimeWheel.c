@@ -18,9 +18,58 @@
 
 #ifdef SW_USE_TIMEWHEEL
 
+/**
+ * a connection is in a slot when it has a predecessor or heads the list,
+ * forward() leaves the connections it unlinks with an index past the wheel
+ */
+static sw_inline int swTimeWheel_linked(swTimeWheel *tw, swConnection *conn)
+{
+    return conn->timewheel_index < tw->size && (conn->timewheel_prev || tw->wheel[conn->timewheel_index] == conn);
+}
+
+static sw_inline void swTimeWheel_link(swTimeWheel *tw, swConnection *conn, uint16_t index)
+{
+    conn->timewheel_index = index;
+    conn->timewheel_prev = NULL;
+    conn->timewheel_next = tw->wheel[index];
+    if (conn->timewheel_next)
+    {
+        conn->timewheel_next->timewheel_prev = conn;
+    }
+    tw->wheel[index] = conn;
+#ifdef SW_DEBUG
+    swHashMap_add_int(tw->sets[index], conn->fd, conn);
+#endif
+}
+
+static sw_inline void swTimeWheel_unlink(swTimeWheel *tw, swConnection *conn)
+{
+    if (!swTimeWheel_linked(tw, conn))
+    {
+        return;
+    }
+    if (conn->timewheel_prev)
+    {
+        conn->timewheel_prev->timewheel_next = conn->timewheel_next;
+    }
+    else
+    {
+        tw->wheel[conn->timewheel_index] = conn->timewheel_next;
+    }
+    if (conn->timewheel_next)
+    {
+        conn->timewheel_next->timewheel_prev = conn->timewheel_prev;
+    }
+#ifdef SW_DEBUG
+    swHashMap_del_int(tw->sets[conn->timewheel_index], conn->fd);
+#endif
+    conn->timewheel_prev = NULL;
+    conn->timewheel_next = NULL;
+}
+
 swTimeWheel* swTimeWheel_new(uint16_t size)
 {
-    swTimeWheel *tw = sw_malloc(sizeof(swTimeWheel));
+    swTimeWheel *tw = sw_calloc(1, sizeof(swTimeWheel));
     if (!tw)
     {
         swWarn("malloc(%ld) failed.", sizeof(swTimeWheel));
@@ -29,59 +78,80 @@ swTimeWheel* swTimeWheel_new(uint16_t size)
 
     tw->size = size;
     tw->current = 0;
-    tw->wheel = sw_calloc(size, sizeof(void*));
+    tw->wheel = sw_calloc(size, sizeof(swConnection *));
     if (tw->wheel == NULL)
     {
-        swWarn("malloc(%ld) failed.", sizeof(void*) * size);
+        swWarn("malloc(%ld) failed.", sizeof(swConnection *) * size);
         sw_free(tw);
         return NULL;
     }
 
+#ifdef SW_DEBUG
+    tw->sets = sw_calloc(size, sizeof(swHashMap *));
+    if (tw->sets == NULL)
+    {
+        swWarn("malloc(%ld) failed.", sizeof(swHashMap *) * size);
+        swTimeWheel_free(tw);
+        return NULL;
+    }
     int i;
     for (i = 0; i < size; i++)
     {
-        tw->wheel[i] = swHashMap_new(16, NULL);
-        if (tw->wheel[i] == NULL)
+        tw->sets[i] = swHashMap_new(16, NULL);
+        if (tw->sets[i] == NULL)
         {
             swTimeWheel_free(tw);
             return NULL;
         }
     }
+#endif
     return tw;
 }
 
 void swTimeWheel_free(swTimeWheel *tw)
 {
-    int i;
-    for (i = 0; i < tw->size; i++)
+#ifdef SW_DEBUG
+    if (tw->sets)
     {
-        if (tw->wheel[i] != NULL)
+        int i;
+        for (i = 0; i < tw->size; i++)
         {
-            swHashMap_free(tw->wheel[i]);
-            tw->wheel[i] = NULL;
+            if (tw->sets[i] != NULL)
+            {
+                swHashMap_free(tw->sets[i]);
+            }
         }
+        sw_free(tw->sets);
     }
+#endif
     sw_free(tw->wheel);
     sw_free(tw);
 }
 
 void swTimeWheel_forward(swTimeWheel *tw, swReactor *reactor)
 {
-    swHashMap *set = tw->wheel[tw->current];
+    uint16_t index = tw->current;
     tw->current = tw->current == tw->size - 1 ? 0 : tw->current + 1;
 
     swTraceLog(SW_TRACE_REACTOR, "current=%d.", tw->current);
 
+#ifdef SW_DEBUG
+    uint32_t count = 0;
+    uint32_t expected = swHashMap_count(tw->sets[index]);
+#endif
+
     swConnection *conn;
-    uint64_t fd;
+    int fd;
 
-    while (1)
+    //closing a connection unlinks it, so always take the head of the list
+    while ((conn = tw->wheel[index]))
     {
-        conn = swHashMap_each_int(set, &fd);
-        if (conn == NULL)
-        {
-            break;
-        }
+        swTimeWheel_unlink(tw, conn);
+        conn->timewheel_index = tw->size;
+        fd = conn->fd;
+#ifdef SW_DEBUG
+        count++;
+#endif
 
         conn->close_force = 1;
         conn->close_notify = 1;
@@ -91,22 +161,26 @@ void swTimeWheel_forward(swTimeWheel *tw, swReactor *reactor)
         //notify to reactor thread
         if (conn->removed)
         {
-            reactor->close(reactor, (int) fd);
+            reactor->close(reactor, fd);
         }
         else
         {
             reactor->set(reactor, fd, SW_FD_TCP | SW_EVENT_WRITE);
         }
     }
+
+#ifdef SW_DEBUG
+    if (count != expected)
+    {
+        swWarn("timewheel slot %d: %d connections in the list, %d in the set.", index, count, expected);
+    }
+#endif
 }
 
 void swTimeWheel_add(swTimeWheel *tw, swConnection *conn)
 {
-    uint16_t index = tw->current == 0 ? tw->size - 1 : tw->current - 1;
-    swHashMap *new_set = tw->wheel[index];
-    swHashMap_add_int(new_set, conn->fd, conn);
-
-    conn->timewheel_index = index;
+    uint16_t index = swTimeWheel_new_index(tw);
+    swTimeWheel_link(tw, conn, index);
 
     swTraceLog(SW_TRACE_REACTOR, "current=%d, fd=%d, index=%d.", tw->current, conn->fd, index);
 }
@@ -114,21 +188,16 @@ void swTimeWheel_add(swTimeWheel *tw, swConnection *conn)
 void swTimeWheel_update(swTimeWheel *tw, swConnection *conn)
 {
     uint16_t new_index = swTimeWheel_new_index(tw);
-    swHashMap *new_set = tw->wheel[new_index];
-    swHashMap_add_int(new_set, conn->fd, conn);
-
-    swHashMap *old_set = tw->wheel[conn->timewheel_index];
-    swHashMap_del_int(old_set, conn->fd);
 
-    swTraceLog(SW_TRACE_REACTOR, "current=%d, fd=%d, old_index=%d, new_index=%d.", tw->current, conn->fd, new_index, conn->timewheel_index);
+    swTraceLog(SW_TRACE_REACTOR, "current=%d, fd=%d, old_index=%d, new_index=%d.", tw->current, conn->fd, conn->timewheel_index, new_index);
 
-    conn->timewheel_index = new_index;
+    swTimeWheel_unlink(tw, conn);
+    swTimeWheel_link(tw, conn, new_index);
 }
 
 void swTimeWheel_remove(swTimeWheel *tw, swConnection *conn)
 {
-    swHashMap *set = tw->wheel[conn->timewheel_index];
-    swHashMap_del_int(set, conn->fd);
+    swTimeWheel_unlink(tw, conn);
     swTraceLog(SW_TRACE_REACTOR, "current=%d, fd=%d.", tw->current, conn->fd);
 }
 
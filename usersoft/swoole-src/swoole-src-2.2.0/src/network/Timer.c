@@ -19,6 +19,9 @@
 static int swReactorTimer_init(long msec);
 static int swReactorTimer_set(swTimer *timer, long exec_msec);
 static swTimer_node* swTimer_add(swTimer *timer, int _msec, int interval, void *data, swTimerCallback callback);
+static void swTimerWheel_add(swTimerWheel *wheel, swTimer_node *tnode);
+static void swTimerWheel_remove(swTimer_node *tnode);
+static int swTimerWheel_select(swTimer *timer, int64_t now_msec);
 
 int swTimer_now(struct timeval *time)
 {
@@ -61,17 +64,34 @@ int swTimer_init(long msec)
     }
 
 
-    SwooleG.timer.heap = swHeap_new(1024, SW_MIN_HEAP);
-    if (!SwooleG.timer.heap)
+    if (SwooleG.use_timer_wheel)
     {
-        return SW_ERR;
+        SwooleG.timer.wheel = sw_calloc(1, sizeof(swTimerWheel));
+        if (!SwooleG.timer.wheel)
+        {
+            swSysError("calloc(%ld) failed.", sizeof(swTimerWheel));
+            return SW_ERR;
+        }
+    }
+    else
+    {
+        SwooleG.timer.heap = swHeap_new(1024, SW_MIN_HEAP);
+        if (!SwooleG.timer.heap)
+        {
+            return SW_ERR;
+        }
     }
 
     SwooleG.timer.map = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, NULL);
     if (!SwooleG.timer.map)
     {
-        swHeap_free(SwooleG.timer.heap);
-        SwooleG.timer.heap = NULL;
+        if (SwooleG.timer.heap)
+        {
+            swHeap_free(SwooleG.timer.heap);
+            SwooleG.timer.heap = NULL;
+        }
+        sw_free(SwooleG.timer.wheel);
+        SwooleG.timer.wheel = NULL;
         return SW_ERR;
     }
 
@@ -98,6 +118,10 @@ void swTimer_free(swTimer *timer)
     {
         swHeap_free(timer->heap);
     }
+    if (timer->wheel)
+    {
+        sw_free(timer->wheel);
+    }
 }
 
 static int swReactorTimer_init(long exec_msec)
@@ -152,11 +176,19 @@ static swTimer_node* swTimer_add(swTimer *timer, int _msec, int interval, void *
     }
     timer->num++;
 
-    tnode->heap_node = swHeap_push(timer->heap, tnode->exec_msec, tnode);
-    if (tnode->heap_node == NULL)
+    if (timer->wheel)
     {
-        sw_free(tnode);
-        return NULL;
+        tnode->heap_node = NULL;
+        swTimerWheel_add(timer->wheel, tnode);
+    }
+    else
+    {
+        tnode->heap_node = swHeap_push(timer->heap, tnode->exec_msec, tnode);
+        if (tnode->heap_node == NULL)
+        {
+            sw_free(tnode);
+            return NULL;
+        }
     }
     swHashMap_add_int(timer->map, tnode->id, tnode);
     return tnode;
@@ -177,7 +209,11 @@ int swTimer_del(swTimer *timer, swTimer_node *tnode)
     {
         return SW_ERR;
     }
-    if (tnode->heap_node)
+    if (timer->wheel)
+    {
+        swTimerWheel_remove(tnode);
+    }
+    else if (tnode->heap_node)
     {
         //remove from min-heap
         swHeap_remove(timer->heap, tnode->heap_node);
@@ -196,6 +232,11 @@ int swTimer_select(swTimer *timer)
         return SW_ERR;
     }
 
+    if (timer->wheel)
+    {
+        return swTimerWheel_select(timer, now_msec);
+    }
+
     swTimer_node *tnode = NULL;
     swHeap_node *tmp;
     long timer_id;
@@ -243,3 +284,175 @@ int swTimer_select(swTimer *timer)
     }
     return SW_OK;
 }
+
+static void swTimerWheel_link(swTimer_node **slot, swTimer_node *tnode)
+{
+    tnode->slot = slot;
+    tnode->prev = NULL;
+    tnode->next = *slot;
+    if (*slot)
+    {
+        (*slot)->prev = tnode;
+    }
+    *slot = tnode;
+}
+
+static void swTimerWheel_add(swTimerWheel *wheel, swTimer_node *tnode)
+{
+    int64_t expires = tnode->exec_msec;
+    int64_t delta = expires - wheel->current;
+    int level;
+
+    //the current tick has been processed already
+    if (delta <= 0)
+    {
+        expires = wheel->current + 1;
+        delta = 1;
+    }
+    else if (delta >= (int64_t) 1 << (SW_TIMER_WHEEL_BITS * SW_TIMER_WHEEL_LEVELS))
+    {
+        //beyond the last level: park in its farthest slot, the cascade puts it back
+        delta = ((int64_t) 1 << (SW_TIMER_WHEEL_BITS * SW_TIMER_WHEEL_LEVELS)) - 1;
+        expires = wheel->current + delta;
+    }
+
+    for (level = 0; level < SW_TIMER_WHEEL_LEVELS - 1; level++)
+    {
+        if (delta < (int64_t) 1 << (SW_TIMER_WHEEL_BITS * (level + 1)))
+        {
+            break;
+        }
+    }
+
+    swTimerWheel_link(&wheel->slots[level][(expires >> (SW_TIMER_WHEEL_BITS * level)) & SW_TIMER_WHEEL_MASK], tnode);
+}
+
+static void swTimerWheel_remove(swTimer_node *tnode)
+{
+    if (tnode->prev)
+    {
+        tnode->prev->next = tnode->next;
+    }
+    else
+    {
+        *tnode->slot = tnode->next;
+    }
+    if (tnode->next)
+    {
+        tnode->next->prev = tnode->prev;
+    }
+    tnode->prev = tnode->next = NULL;
+    tnode->slot = NULL;
+}
+
+/**
+ * move the nodes of a slot to the lower levels, once the wheel reaches the span the slot covers,
+ * the nodes due at this tick go to the level-0 slot that is processed next
+ */
+static void swTimerWheel_cascade(swTimerWheel *wheel, int level)
+{
+    swTimer_node **slot = &wheel->slots[level][(wheel->current >> (SW_TIMER_WHEEL_BITS * level)) & SW_TIMER_WHEEL_MASK];
+    swTimer_node *tnode = *slot;
+    *slot = NULL;
+
+    while (tnode)
+    {
+        swTimer_node *next = tnode->next;
+        if (tnode->exec_msec <= wheel->current)
+        {
+            swTimerWheel_link(&wheel->slots[0][wheel->current & SW_TIMER_WHEEL_MASK], tnode);
+        }
+        else
+        {
+            swTimerWheel_add(wheel, tnode);
+        }
+        tnode = next;
+    }
+}
+
+/**
+ * msec until the next level-0 slot that holds nodes, or until the next cascade
+ */
+static int64_t swTimerWheel_next_msec(swTimerWheel *wheel)
+{
+    int64_t i;
+    for (i = 1; i <= SW_TIMER_WHEEL_SLOTS; i++)
+    {
+        int64_t tick = wheel->current + i;
+        if (wheel->slots[0][tick & SW_TIMER_WHEEL_MASK])
+        {
+            return i;
+        }
+        if ((tick & SW_TIMER_WHEEL_MASK) == 0)
+        {
+            return i;
+        }
+    }
+    return SW_TIMER_WHEEL_SLOTS;
+}
+
+static int swTimerWheel_select(swTimer *timer, int64_t now_msec)
+{
+    swTimerWheel *wheel = timer->wheel;
+    swTimer_node *tnode;
+    swTimer_node **slot;
+    long timer_id;
+    int level;
+
+    if (timer->num == 0)
+    {
+        wheel->current = now_msec;
+    }
+
+    while (wheel->current < now_msec)
+    {
+        wheel->current++;
+        for (level = 1; level < SW_TIMER_WHEEL_LEVELS; level++)
+        {
+            if ((wheel->current & (((int64_t) 1 << (SW_TIMER_WHEEL_BITS * level)) - 1)) != 0)
+            {
+                break;
+            }
+            swTimerWheel_cascade(wheel, level);
+        }
+
+        slot = &wheel->slots[0][wheel->current & SW_TIMER_WHEEL_MASK];
+        while ((tnode = *slot))
+        {
+            swTimerWheel_remove(tnode);
+
+            timer_id = timer->_current_id = tnode->id;
+            if (!tnode->remove)
+            {
+                tnode->callback(timer, tnode);
+            }
+            timer->_current_id = -1;
+
+            //persistent timer
+            if (tnode->interval > 0 && !tnode->remove)
+            {
+                while (tnode->exec_msec <= now_msec)
+                {
+                    tnode->exec_msec += tnode->interval;
+                }
+                swTimerWheel_add(wheel, tnode);
+                continue;
+            }
+
+            timer->num--;
+            swHashMap_del_int(timer->map, timer_id);
+            sw_free(tnode);
+        }
+    }
+
+    if (timer->num == 0)
+    {
+        timer->_next_msec = -1;
+        timer->set(timer, -1);
+    }
+    else
+    {
+        timer->set(timer, swTimerWheel_next_msec(wheel));
+    }
+    return SW_OK;
+}
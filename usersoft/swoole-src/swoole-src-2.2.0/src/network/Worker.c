@@ -293,6 +293,16 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
     //worker busy
     worker->status = SW_WORKER_BUSY;
 
+    uint64_t start_time = 0;
+    if (serv->latency_stats && swServer_is_request_event(task->info.type))
+    {
+        start_time = swoole_monotonic_usec();
+        if (task->info.time)
+        {
+            swHistogram_record(&worker->queue_histogram, (uint32_t) ((uint32_t) start_time - task->info.time));
+        }
+    }
+
     switch (task->info.type)
     {
     //no buffer
@@ -421,8 +431,18 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
         break;
     }
 
+    if (start_time)
+    {
+        swHistogram_record(&worker->request_histogram, swoole_monotonic_usec() - start_time);
+    }
+
     //worker idle
     worker->status = SW_WORKER_IDLE;
+    if (serv->dispatch_mode == SW_DISPATCH_LEAST_LOADED && serv->factory_mode == SW_MODE_PROCESS
+            && swServer_is_request_event(task->info.type))
+    {
+        sw_atomic_fetch_sub(&worker->dispatch_count, 1);
+    }
 
     //maximum number of requests, process will exit.
     if (!SwooleWG.run_always && worker->request_count >= SwooleWG.max_request)
@@ -741,6 +761,11 @@ int swWorker_loop(swFactory *factory, int worker_id)
 
     swSetNonBlock(pipe_worker);
     SwooleG.main_reactor->ptr = serv;
+    if (serv->latency_stats)
+    {
+        SwooleG.main_reactor->wait_histogram = &worker->wait_histogram;
+        SwooleG.main_reactor->loop_histogram = &worker->loop_histogram;
+    }
     SwooleG.main_reactor->add(SwooleG.main_reactor, pipe_worker, SW_FD_PIPE | SW_EVENT_READ);
     SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_PIPE, swWorker_onPipeReceive);
     SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_WRITE, swReactor_onWrite);
@@ -790,10 +815,44 @@ int swWorker_loop(swFactory *factory, int worker_id)
 /**
  * Send data to ReactorThread
  */
+/**
+ * push the response to the ring of the reactor thread, wake it up unless a wakeup is already pending
+ */
+static int swWorker_send2ring(swServer *serv, swEventData *ev_data, size_t sendn)
+{
+    uint16_t reactor_id = ev_data->info.from_id;
+    swRingChannel *ring = serv->response_rings[SwooleWG.id * serv->reactor_num + reactor_id];
+    swReactorThread *thread = swServer_get_thread(serv, reactor_id);
+    uint64_t flag = 1;
+
+    while (swRingChannel_push(ring, ev_data, sendn) < 0)
+    {
+        //ring is full, the reactor thread is busy sending
+        swYield();
+    }
+    sw_atomic_memory_barrier();
+    if (thread->ring_notified == 0 && sw_atomic_cmp_set(&thread->ring_notified, 0, 1))
+    {
+        if (thread->ring_notify.write(&thread->ring_notify, &flag, sizeof(flag)) < 0)
+        {
+            swSysError("write(ring_notify) failed.");
+            return SW_ERR;
+        }
+    }
+    return sendn;
+}
+
 int swWorker_send2reactor(swEventData *ev_data, size_t sendn, int session_id)
 {
     int ret;
     swServer *serv = SwooleG.serv;
+
+    //task workers and user processes keep using the pipes
+    if (serv->response_rings && SwooleWG.id < serv->worker_num)
+    {
+        return swWorker_send2ring(serv, ev_data, sendn);
+    }
+
     int _pipe_fd = swWorker_get_send_pipe(serv, session_id, ev_data->info.from_id);
 
     if (SwooleG.main_reactor)
@@ -872,6 +931,12 @@ int swWorker_send2worker(swWorker *dst_worker, void *buf, int n, int flag)
         return swMsgQueue_push(dst_worker->pool->queue, (swQueue_data *) &msg, n);
     }
 
+    //shared memory queues, the destination is only a hint as another worker may steal the task
+    if (dst_worker->pool->use_shmqueue)
+    {
+        return swProcessPool_queue_push(dst_worker->pool, dst_worker->id - dst_worker->pool->start_id, buf, !(flag & SW_PIPE_NONBLOCK));
+    }
+
     if ((flag & SW_PIPE_NONBLOCK) && SwooleG.main_reactor)
     {
         return SwooleG.main_reactor->write(SwooleG.main_reactor, pipefd, buf, n);
@@ -38,9 +38,13 @@ static void swAio_handler_stream_get_line(swAio_event *event);
 static void swAio_handler_read_file(swAio_event *event);
 static void swAio_handler_write_file(swAio_event *event);
 
+static int swAioBase_thread_start(void);
+
 static swThreadPool swAioBase_thread_pool;
+static swPipe swAioBase_pipe;
 static int swAioBase_pipe_read;
 static int swAioBase_pipe_write;
+static uint8_t swAioBase_running;
 
 int swAio_init(void)
 {
@@ -79,6 +83,11 @@ void swAio_free(void)
         return;
     }
     SwooleAIO.destroy();
+    //the thread pool also serves the buffered requests in linux aio mode
+    if (swAioBase_running)
+    {
+        swAioBase_destroy();
+    }
     SwooleAIO.init = 0;
 }
 
@@ -168,9 +177,13 @@ static int swAioBase_onFinish(swReactor *reactor, swEvent *event)
     return SW_OK;
 }
 
-int swAioBase_init(int max_aio_events)
+/**
+ * the thread pool runs buffered file I/O, dns lookups and coroutine file operations.
+ * It is started on demand in every aio mode, linux aio only handles the O_DIRECT read/write.
+ */
+static int swAioBase_thread_start(void)
 {
-    if (swPipeBase_create(&swoole_aio_pipe, 0) < 0)
+    if (swPipeBase_create(&swAioBase_pipe, 0) < 0)
     {
         return SW_ERR;
     }
@@ -190,8 +203,8 @@ int swAioBase_init(int max_aio_events)
 
     swAioBase_thread_pool.onTask = swAioBase_thread_onTask;
 
-    swAioBase_pipe_read = swoole_aio_pipe.getFd(&swoole_aio_pipe, 0);
-    swAioBase_pipe_write = swoole_aio_pipe.getFd(&swoole_aio_pipe, 1);
+    swAioBase_pipe_read = swAioBase_pipe.getFd(&swAioBase_pipe, 0);
+    swAioBase_pipe_write = swAioBase_pipe.getFd(&swAioBase_pipe, 1);
 
     SwooleAIO.handlers[SW_AIO_READ] = swAio_handler_read;
     SwooleAIO.handlers[SW_AIO_WRITE] = swAio_handler_write;
@@ -201,13 +214,23 @@ int swAioBase_init(int max_aio_events)
     SwooleAIO.handlers[SW_AIO_READ_FILE] = swAio_handler_read_file;
     SwooleAIO.handlers[SW_AIO_WRITE_FILE] = swAio_handler_write_file;
 
-    SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_AIO, swAioBase_onFinish);
-    SwooleG.main_reactor->add(SwooleG.main_reactor, swAioBase_pipe_read, SW_FD_AIO);
+    SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_AIO_THREAD, swAioBase_onFinish);
+    SwooleG.main_reactor->add(SwooleG.main_reactor, swAioBase_pipe_read, SW_FD_AIO_THREAD);
 
     if (swThreadPool_run(&swAioBase_thread_pool) < 0)
     {
         return SW_ERR;
     }
+    swAioBase_running = 1;
+    return SW_OK;
+}
+
+int swAioBase_init(int max_aio_events)
+{
+    if (swAioBase_thread_start() < 0)
+    {
+        return SW_ERR;
+    }
 
     SwooleAIO.destroy = swAioBase_destroy;
     SwooleAIO.read = swAioBase_read;
@@ -560,7 +583,7 @@ static int swAioBase_thread_onTask(swThreadPool *pool, void *task, int task_len)
             }
             else
             {
-                swSysError("sendto swoole_aio_pipe_write failed.");
+                swSysError("sendto swAioBase_pipe_write failed.");
             }
         }
         break;
@@ -598,6 +621,11 @@ static int swAioBase_write(int fd, void *inbuf, size_t size, off_t offset)
 
 int swAio_dns_lookup(void *hostname, void *ip_addr, size_t size)
 {
+    if (!swAioBase_running && swAioBase_thread_start() < 0)
+    {
+        return SW_ERR;
+    }
+
     swAio_event *aio_ev = (swAio_event *) sw_malloc(sizeof(swAio_event));
     if (aio_ev == NULL)
     {
@@ -629,6 +657,10 @@ int swAio_dispatch(swAio_event *_event)
     {
         swAio_init();
     }
+    if (!swAioBase_running && swAioBase_thread_start() < 0)
+    {
+        return SW_ERR;
+    }
 
     _event->task_id = SwooleAIO.current_id++;
 
@@ -681,10 +713,15 @@ static int swAioBase_read(int fd, void *inbuf, size_t size, off_t offset)
 
 void swAioBase_destroy()
 {
+    if (!swAioBase_running)
+    {
+        return;
+    }
+    swAioBase_running = 0;
     swThreadPool_free(&swAioBase_thread_pool);
     if (SwooleG.main_reactor)
     {
         SwooleG.main_reactor->del(SwooleG.main_reactor, swAioBase_pipe_read);
     }
-    swoole_aio_pipe.close(&swoole_aio_pipe);
+    swAioBase_pipe.close(&swAioBase_pipe);
 }
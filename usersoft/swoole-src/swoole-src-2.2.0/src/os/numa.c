@@ -0,0 +1,122 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | Copyright (c) 2012-2018 The Swoole Group                             |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+
+#if defined(HAVE_CPU_AFFINITY) && defined(__linux__)
+
+#include <sys/syscall.h>
+
+/**
+ * the topology comes from sysfs and memory is bound with the raw mbind syscall, no libnuma
+ */
+#define SW_NUMA_SYSFS          "/sys/devices/system/node"
+#define SW_MPOL_PREFERRED      1
+#define SW_MPOL_MF_MOVE        (1 << 1)
+
+int swoole_numa_node_num(void)
+{
+    char path[64];
+    int n = 0;
+
+    while (n < SW_NUMA_MAX_NODE)
+    {
+        snprintf(path, sizeof(path), SW_NUMA_SYSFS "/node%d", n);
+        if (access(path, F_OK) < 0)
+        {
+            break;
+        }
+        n++;
+    }
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * parse nodeN/cpulist, e.g. "0-7,16-23"
+ */
+int swoole_numa_node_cpus(int node, cpu_set_t *set)
+{
+    char path[64];
+    char buf[1024];
+    char *p, *end;
+    long first, last, i;
+    int count = 0;
+
+    CPU_ZERO(set);
+    snprintf(path, sizeof(path), SW_NUMA_SYSFS "/node%d/cpulist", node);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return SW_ERR;
+    }
+    int n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+    {
+        return SW_ERR;
+    }
+    buf[n] = 0;
+
+    p = buf;
+    while (*p && *p != '\n')
+    {
+        first = strtol(p, &end, 10);
+        if (end == p)
+        {
+            break;
+        }
+        last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (i = first; i <= last && i < CPU_SETSIZE; i++)
+        {
+            CPU_SET(i, set);
+            count++;
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+    }
+    return count;
+}
+
+/**
+ * prefer the node for the pages of [addr, addr + size), pages already touched are migrated
+ */
+int swoole_numa_bind(void *addr, size_t size, int node)
+{
+    unsigned long mask = 1UL << node;
+    long pagesize = getpagesize();
+    uintptr_t start = (uintptr_t) addr & ~((uintptr_t) pagesize - 1);
+
+    size += (uintptr_t) addr - start;
+    if (syscall(SYS_mbind, (void *) start, size, SW_MPOL_PREFERRED, &mask, sizeof(mask) * 8, SW_MPOL_MF_MOVE) < 0)
+    {
+        swSysError("mbind(%p, %ld, node=%d) failed.", addr, (long) size, node);
+        return SW_ERR;
+    }
+    return SW_OK;
+}
+
+#endif
@@ -20,6 +20,10 @@
 #include <assert.h>
 #include <stddef.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 static const char *method_strings[] =
 {
     "DELETE", "GET", "HEAD", "POST", "PUT", "PATCH", "CONNECT", "OPTIONS", "TRACE", "COPY", "LOCK", "MKCOL", "MOVE",
@@ -300,3 +304,209 @@ int swHttpRequest_get_header_length(swHttpRequest *request)
     }
     return SW_ERR;
 }
+
+/**
+ * known headers have distinct lengths, so the length alone selects the only candidate
+ */
+int swHttp_get_header_id(const char *name, int name_len)
+{
+    switch (name_len)
+    {
+    case 6:
+        return strncasecmp(name, "cookie", 6) == 0 ? SW_HTTP_HEADER_COOKIE : SW_HTTP_HEADER_UNKNOWN;
+    case 7:
+        return strncasecmp(name, "upgrade", 7) == 0 ? SW_HTTP_HEADER_UPGRADE : SW_HTTP_HEADER_UNKNOWN;
+    case 10:
+        return strncasecmp(name, "connection", 10) == 0 ? SW_HTTP_HEADER_CONNECTION : SW_HTTP_HEADER_UNKNOWN;
+    case 12:
+        return strncasecmp(name, "content-type", 12) == 0 ? SW_HTTP_HEADER_CONTENT_TYPE : SW_HTTP_HEADER_UNKNOWN;
+    case 14:
+        return strncasecmp(name, "content-length", 14) == 0 ? SW_HTTP_HEADER_CONTENT_LENGTH : SW_HTTP_HEADER_UNKNOWN;
+    case 15:
+        return strncasecmp(name, "accept-encoding", 15) == 0 ? SW_HTTP_HEADER_ACCEPT_ENCODING : SW_HTTP_HEADER_UNKNOWN;
+    case 17:
+        return strncasecmp(name, "transfer-encoding", 17) == 0 ? SW_HTTP_HEADER_TRANSFER_ENCODING : SW_HTTP_HEADER_UNKNOWN;
+    default:
+        return SW_HTTP_HEADER_UNKNOWN;
+    }
+}
+
+/**
+ * find the first control character (except HT) or DEL, 16 bytes at a time
+ */
+static sw_inline const char* swHttp_find_ctl(const char *p, const char *pe)
+{
+#ifdef __SSE2__
+    const __m128i ctl_max = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    while (pe - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl_max), v);
+        ctl = _mm_andnot_si128(_mm_cmpeq_epi8(v, tab), ctl);
+        ctl = _mm_or_si128(ctl, _mm_cmpeq_epi8(v, del));
+        int mask = _mm_movemask_epi8(ctl);
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    for (; p < pe; p++)
+    {
+        if (((uchar) *p < 0x20 && *p != '\t') || *p == 0x7f)
+        {
+            return p;
+        }
+    }
+    return pe;
+}
+
+/**
+ * returns the end of the line at p (pointing at CR), or NULL if the line is not terminated by CRLF
+ */
+static sw_inline const char* swHttp_get_line(const char *p, const char *pe)
+{
+    const char *eol = swHttp_find_ctl(p, pe);
+    if (eol + 1 >= pe || eol[0] != '\r' || eol[1] != '\n')
+    {
+        return NULL;
+    }
+    return eol;
+}
+
+static sw_inline int swHttp_get_fast_method(const char *m, int len)
+{
+    switch (len)
+    {
+    case 3:
+        if (memcmp(m, "GET", 3) == 0)
+        {
+            return HTTP_GET;
+        }
+        if (memcmp(m, "PUT", 3) == 0)
+        {
+            return HTTP_PUT;
+        }
+        break;
+    case 4:
+        if (memcmp(m, "POST", 4) == 0)
+        {
+            return HTTP_POST;
+        }
+        if (memcmp(m, "HEAD", 4) == 0)
+        {
+            return HTTP_HEAD;
+        }
+        break;
+    case 5:
+        if (memcmp(m, "PATCH", 5) == 0)
+        {
+            return HTTP_PATCH;
+        }
+        break;
+    case 6:
+        if (memcmp(m, "DELETE", 6) == 0)
+        {
+            return HTTP_DELETE;
+        }
+        break;
+    case 7:
+        if (memcmp(m, "OPTIONS", 7) == 0)
+        {
+            return HTTP_OPTIONS;
+        }
+        break;
+    default:
+        break;
+    }
+    return SW_ERR;
+}
+
+/**
+ * Parse a complete HTTP/1.x request head in one pass.
+ * Only the common shape is accepted: a known method, an origin-form path and no folded headers.
+ * Returns the length of the head including the empty line, or SW_ERR so the caller can fall back to the full parser.
+ */
+int swHttpRequest_parse_head(const char *buf, size_t length, swHttpRequestHead *head)
+{
+    const char *p = buf;
+    const char *pe = buf + length;
+    const char *eol, *sp, *colon, *value;
+    int method;
+
+    //request line
+    if ((eol = swHttp_get_line(p, pe)) == NULL)
+    {
+        return SW_ERR;
+    }
+    if ((sp = memchr(p, ' ', eol - p)) == NULL || (method = swHttp_get_fast_method(p, sp - p)) < 0)
+    {
+        return SW_ERR;
+    }
+    head->method = method;
+    head->path = ++sp;
+    if (*sp != '/' || (sp = memchr(sp, ' ', eol - sp)) == NULL)
+    {
+        return SW_ERR;
+    }
+    head->path_len = sp - head->path;
+    sp++;
+    if (eol - sp != sizeof("HTTP/1.1") - 1 || memcmp(sp, "HTTP/1.", 7) != 0 || (sp[7] != '0' && sp[7] != '1'))
+    {
+        return SW_ERR;
+    }
+    head->minor_version = sp[7] - '0';
+    p = eol + 2;
+
+    head->num_headers = 0;
+    while (1)
+    {
+        if (pe - p < 2)
+        {
+            return SW_ERR;
+        }
+        if (p[0] == '\r' && p[1] == '\n')
+        {
+            return p + 2 - buf;
+        }
+        //obs-fold
+        if (*p == ' ' || *p == '\t' || head->num_headers == SW_HTTP_FAST_PARSE_HEADER_NUM)
+        {
+            return SW_ERR;
+        }
+        if ((eol = swHttp_get_line(p, pe)) == NULL)
+        {
+            return SW_ERR;
+        }
+        colon = memchr(p, ':', eol - p);
+        if (colon == NULL || colon == p || colon[-1] == ' ' || colon[-1] == '\t')
+        {
+            return SW_ERR;
+        }
+
+        swHttpHeader *header = &head->headers[head->num_headers++];
+        header->name = p;
+        header->name_len = colon - p;
+        header->id = swHttp_get_header_id(p, colon - p);
+
+        value = colon + 1;
+        while (value < eol && (*value == ' ' || *value == '\t'))
+        {
+            value++;
+        }
+        sp = eol;
+        while (sp > value && (sp[-1] == ' ' || sp[-1] == '\t'))
+        {
+            sp--;
+        }
+        header->value = value;
+        header->value_len = sp - value;
+
+        p = eol + 2;
+    }
+    return SW_ERR;
+}
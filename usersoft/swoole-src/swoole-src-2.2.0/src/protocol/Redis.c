@@ -20,19 +20,64 @@
 #include "redis.h"
 #include "Connection.h"
 
-typedef struct
+/**
+ * return the length of the command at p, 0 if it is not received completely
+ */
+static int swRedis_command_length(char *p, char *pe)
 {
-    uint8_t state;
-
-    int n_lines_total;
-    int n_lines_received;
-
-    int n_bytes_total;
-    int n_bytes_received;
+    char *start = p;
+    int n_lines, length, i;
 
-    int offset;
+    if (*p != '*')
+    {
+        return SW_ERR;
+    }
+    if (memchr(p, '\n', pe - p) == NULL)
+    {
+        return 0;
+    }
+    if ((p = swRedis_get_number(p, &n_lines)) == NULL)
+    {
+        return SW_ERR;
+    }
 
-} swRedis_request;
+    for (i = 0; i < n_lines; i++)
+    {
+        if (p >= pe || memchr(p, '\n', pe - p) == NULL)
+        {
+            return 0;
+        }
+        switch (*p)
+        {
+        case '$':
+            if ((p = swRedis_get_number(p, &length)) == NULL)
+            {
+                return SW_ERR;
+            }
+            //nil
+            if (length < 0)
+            {
+                break;
+            }
+            if (pe - p < length + SW_CRLF_LEN)
+            {
+                return 0;
+            }
+            p += length + SW_CRLF_LEN;
+            break;
+        //integer
+        case ':':
+            if ((p = swRedis_get_number(p, &length)) == NULL)
+            {
+                return SW_ERR;
+            }
+            break;
+        default:
+            return SW_ERR;
+        }
+    }
+    return p - start;
+}
 
 int swRedis_recv(swProtocol *protocol, swConnection *conn, swString *buffer)
 {
@@ -40,19 +85,7 @@ int swRedis_recv(swProtocol *protocol, swConnection *conn, swString *buffer)
     int ret;
     char *buf_ptr;
     size_t buf_size;
-
-    swRedis_request *request;
-
-    if (conn->object == NULL)
-    {
-        request = sw_malloc(sizeof(swRedis_request));
-        bzero(request, sizeof(swRedis_request));
-        conn->object = request;
-    }
-    else
-    {
-        request = (swRedis_request *) conn->object;
-    }
+    size_t length;
 
     recv_data: buf_ptr = buffer->str + buffer->length;
     buf_size = buffer->size - buffer->length;
@@ -80,103 +113,65 @@ int swRedis_recv(swProtocol *protocol, swConnection *conn, swString *buffer)
     {
         buffer->length += n;
 
-        if (strncmp(buffer->str + buffer->length - SW_CRLF_LEN, SW_CRLF, SW_CRLF_LEN) != 0)
+        p = buffer->str;
+        pe = p + buffer->length;
+
+        while (p < pe)
         {
-            if (buffer->size < protocol->package_max_length)
+            ret = swRedis_command_length(p, pe);
+            if (ret < 0)
             {
-                uint32_t extend_size = swoole_size_align(buffer->size * 2, SwooleG.pagesize);
-                if (extend_size > protocol->package_max_length)
-                {
-                    extend_size = protocol->package_max_length;
-                }
-                if (swString_extend(buffer, extend_size) < 0)
-                {
-                    return SW_ERR;
-                }
+                swWarn("redis protocol error.");
+                return SW_ERR;
             }
-            else if (buffer->length == buffer->size)
+            else if (ret == 0)
             {
-                package_too_big:
-                swWarn("Package is too big. package_length=%ld.", buffer->length);
-                return SW_ERR;
+                break;
             }
-            goto recv_data;
+            p += ret;
         }
 
-        p = buffer->str;
-        pe = p + buffer->length;
-
-        do
+        /**
+         * the clients pipeline many commands in one packet,
+         * all the complete commands are dispatched together
+         */
+        length = p - buffer->str;
+        if (length > 0)
         {
-            switch(request->state)
+            if (protocol->onPackage(conn, buffer->str, length) < 0)
             {
-            case SW_REDIS_RECEIVE_TOTAL_LINE:
-                if (*p == '*' && (p = swRedis_get_number(p, &ret)))
-                {
-                    request->n_lines_total = ret;
-                    request->state = SW_REDIS_RECEIVE_LENGTH;
-                    break;
-                }
-                /* no break */
-
-            case SW_REDIS_RECEIVE_LENGTH:
-                if (*p == '$' && (p = swRedis_get_number(p, &ret)))
-                {
-                    if (ret < 0)
-                    {
-                        break;
-                    }
-                    if (ret + (p - buffer->str) > protocol->package_max_length)
-                    {
-                        goto package_too_big;
-                    }
-                    request->n_bytes_total = ret;
-                    request->state = SW_REDIS_RECEIVE_STRING;
-                    break;
-                }
-                //integer
-                else if (*p == ':' && (p = swRedis_get_number(p, &ret)))
-                {
-                    break;
-                }
-                /* no break */
-
-            case SW_REDIS_RECEIVE_STRING:
-                if (pe - p < request->n_bytes_total - request->n_bytes_received)
-                {
-                    request->n_bytes_received += pe - p;
-                    return SW_OK;
-                }
-                else
-                {
-                    p += request->n_bytes_total + SW_CRLF_LEN;
-                    request->n_bytes_total = 0;
-                    request->n_lines_received++;
-                    request->state = SW_REDIS_RECEIVE_LENGTH;
-
-                    if (request->n_lines_received == request->n_lines_total)
-                    {
-                        if (protocol->onPackage(conn, buffer->str, buffer->length) < 0)
-                        {
-                            return SW_ERR;
-                        }
-                        if (conn->removed)
-                        {
-                            return SW_OK;
-                        }
-                        swString_clear(buffer);
-                        bzero(request, sizeof(swRedis_request));
-                        return SW_OK;
-                    }
-                }
-                break;
+                return SW_ERR;
+            }
+            if (conn->removed)
+            {
+                return SW_OK;
+            }
+            //keep the incomplete command
+            buffer->length -= length;
+            if (buffer->length > 0)
+            {
+                memmove(buffer->str, buffer->str + length, buffer->length);
+            }
+        }
 
-            default:
-                goto failed;
+        if (buffer->length == buffer->size)
+        {
+            if (buffer->size >= protocol->package_max_length)
+            {
+                swWarn("Package is too big. package_length=%ld.", buffer->length);
+                return SW_ERR;
+            }
+            uint32_t extend_size = swoole_size_align(buffer->size * 2, SwooleG.pagesize);
+            if (extend_size > protocol->package_max_length)
+            {
+                extend_size = protocol->package_max_length;
+            }
+            if (swString_extend(buffer, extend_size) < 0)
+            {
+                return SW_ERR;
             }
-        } while(p < pe);
+            goto recv_data;
+        }
+        return SW_OK;
     }
-    failed:
-    swWarn("redis protocol error.");
-    return SW_ERR;
 }
@@ -16,15 +16,26 @@
 
 #include "swoole.h"
 #include "Connection.h"
+#include "hash.h"
 
 #ifdef SW_USE_OPENSSL
 
 #include <openssl/crypto.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
+#include <openssl/rand.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+//HMAC_Init_ex() is deprecated, session ticket keys go through EVP_MAC
+typedef EVP_MAC_CTX swSSL_ticket_hmac_ctx;
+#else
+typedef HMAC_CTX swSSL_ticket_hmac_ctx;
+#endif
 
 static int openssl_init = 0;
 static pthread_mutex_t *lock_array;
+static int swSSL_session_cache_index = -1;
 
 static const SSL_METHOD *swSSL_get_method(int method);
 static int swSSL_verify_callback(int ok, X509_STORE_CTX *x509_store);
@@ -47,6 +58,16 @@ static int swSSL_alpn_advertised(SSL *ssl, const uchar **out, uchar *outlen, con
 
 static void swSSL_lock_callback(int mode, int type, char *file, int line);
 
+static int swSSL_session_new(SSL *ssl, SSL_SESSION *session);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static SSL_SESSION* swSSL_session_get(SSL *ssl, const uchar *id, int length, int *copy);
+#else
+static SSL_SESSION* swSSL_session_get(SSL *ssl, uchar *id, int length, int *copy);
+#endif
+static void swSSL_session_remove(SSL_CTX *ssl_context, SSL_SESSION *session);
+static sw_inline void swSSL_connection_error(swConnection *conn);
+static int swSSL_ticket_key_callback(SSL *ssl, uchar *name, uchar *iv, EVP_CIPHER_CTX *ectx, swSSL_ticket_hmac_ctx *hctx, int enc);
+
 static const SSL_METHOD *swSSL_get_method(int method)
 {
     switch (method)
@@ -207,7 +228,18 @@ int swSSL_server_set_cipher(SSL_CTX* ssl_context, swSSL_config *cfg)
 #ifndef TLS1_2_VERSION
     return SW_OK;
 #endif
-    SSL_CTX_set_read_ahead(ssl_context, 1);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    if (cfg->ktls)
+    {
+        //the kernel reads the records itself, read ahead would keep them in user space
+        SSL_CTX_set_options(ssl_context, SSL_OP_ENABLE_KTLS);
+    }
+    else
+#endif
+    {
+        SSL_CTX_set_read_ahead(ssl_context, 1);
+    }
 
     if (strlen(cfg->ciphers) > 0)
     {
@@ -243,6 +275,229 @@ int swSSL_server_set_cipher(SSL_CTX* ssl_context, swSSL_config *cfg)
     return SW_OK;
 }
 
+static sw_inline swSSL_session* swSSL_session_slot(swSSL_session_cache *cache, const uchar *id, int length)
+{
+    return &cache->sessions[swoole_hash_php((char *) id, length) % cache->size];
+}
+
+static int swSSL_session_new(SSL *ssl, SSL_SESSION *session)
+{
+    swSSL_session_cache *cache = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), swSSL_session_cache_index);
+    uchar buf[SW_SSL_SESSION_MAX_SIZE];
+    uchar *p = buf;
+    uint32_t id_length;
+    const uchar *id = SSL_SESSION_get_id(session, &id_length);
+
+    int length = i2d_SSL_SESSION(session, NULL);
+    if (length <= 0 || length > SW_SSL_SESSION_MAX_SIZE || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH)
+    {
+        return 0;
+    }
+    i2d_SSL_SESSION(session, &p);
+
+    swSSL_session *slot = swSSL_session_slot(cache, id, id_length);
+    cache->lock.lock(&cache->lock);
+    slot->id_length = id_length;
+    memcpy(slot->id, id, id_length);
+    slot->length = length;
+    slot->expire = time(NULL) + SSL_SESSION_get_timeout(session);
+    memcpy(slot->data, buf, length);
+    cache->lock.unlock(&cache->lock);
+
+    //the session is not referenced by the cache
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static SSL_SESSION* swSSL_session_get(SSL *ssl, const uchar *id, int length, int *copy)
+#else
+static SSL_SESSION* swSSL_session_get(SSL *ssl, uchar *id, int length, int *copy)
+#endif
+{
+    swSSL_session_cache *cache = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), swSSL_session_cache_index);
+    uchar buf[SW_SSL_SESSION_MAX_SIZE];
+    const uchar *p = buf;
+    int n = 0;
+
+    *copy = 0;
+    swSSL_session *slot = swSSL_session_slot(cache, id, length);
+    cache->lock.lock(&cache->lock);
+    if (slot->id_length == length && memcmp(slot->id, id, length) == 0 && slot->expire > time(NULL))
+    {
+        n = slot->length;
+        memcpy(buf, slot->data, n);
+    }
+    cache->lock.unlock(&cache->lock);
+
+    return n > 0 ? d2i_SSL_SESSION(NULL, &p, n) : NULL;
+}
+
+static void swSSL_session_remove(SSL_CTX *ssl_context, SSL_SESSION *session)
+{
+    swSSL_session_cache *cache = SSL_CTX_get_ex_data(ssl_context, swSSL_session_cache_index);
+    uint32_t id_length;
+    const uchar *id = SSL_SESSION_get_id(session, &id_length);
+
+    swSSL_session *slot = swSSL_session_slot(cache, id, id_length);
+    cache->lock.lock(&cache->lock);
+    if (slot->id_length == id_length && memcmp(slot->id, id, id_length) == 0)
+    {
+        slot->id_length = 0;
+    }
+    cache->lock.unlock(&cache->lock);
+}
+
+/**
+ * the cache lock must be held
+ */
+static void swSSL_ticket_key_generate(swSSL_session_cache *cache)
+{
+    memcpy(&cache->ticket_keys[1], &cache->ticket_keys[0], sizeof(swSSL_ticket_key));
+    if (RAND_bytes((uchar *) &cache->ticket_keys[0], sizeof(swSSL_ticket_key)) != 1)
+    {
+        swWarn("RAND_bytes() failed.");
+    }
+    cache->ticket_key_time = time(NULL);
+}
+
+/**
+ * called by the manager process, the ticket callback only rotates an overdue key when no manager is running
+ */
+void swSSL_rotate_ticket_keys(SSL_CTX* ssl_context, int force)
+{
+    swSSL_session_cache *cache = SSL_CTX_get_ex_data(ssl_context, swSSL_session_cache_index);
+    if (cache == NULL || cache->ticket_key_lifetime == 0)
+    {
+        return;
+    }
+    cache->lock.lock(&cache->lock);
+    if (force || time(NULL) - cache->ticket_key_time >= cache->ticket_key_lifetime)
+    {
+        swSSL_ticket_key_generate(cache);
+    }
+    cache->lock.unlock(&cache->lock);
+}
+
+static int swSSL_ticket_key_callback(SSL *ssl, uchar *name, uchar *iv, EVP_CIPHER_CTX *ectx, swSSL_ticket_hmac_ctx *hctx, int enc)
+{
+    swSSL_session_cache *cache = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), swSSL_session_cache_index);
+    swSSL_ticket_key key;
+    int i, ret = 1;
+
+    cache->lock.lock(&cache->lock);
+    if (time(NULL) - cache->ticket_key_time >= 2 * cache->ticket_key_lifetime)
+    {
+        swSSL_ticket_key_generate(cache);
+    }
+    if (enc)
+    {
+        memcpy(&key, &cache->ticket_keys[0], sizeof(key));
+    }
+    else
+    {
+        for (i = 0; i < 2; i++)
+        {
+            if (memcmp(name, cache->ticket_keys[i].name, sizeof(key.name)) == 0)
+            {
+                memcpy(&key, &cache->ticket_keys[i], sizeof(key));
+                //issued with the previous key, renew the ticket
+                ret = i == 0 ? 1 : 2;
+                break;
+            }
+        }
+        if (i == 2)
+        {
+            ret = 0;
+        }
+    }
+    cache->lock.unlock(&cache->lock);
+
+    if (ret == 0)
+    {
+        return 0;
+    }
+    if (enc)
+    {
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_128_cbc())) != 1)
+        {
+            return -1;
+        }
+        memcpy(name, key.name, sizeof(key.name));
+        EVP_EncryptInit_ex(ectx, EVP_aes_128_cbc(), NULL, key.aes_key, iv);
+    }
+    else
+    {
+        EVP_DecryptInit_ex(ectx, EVP_aes_128_cbc(), NULL, key.aes_key, iv);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *) "SHA256", 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_init(hctx, key.hmac_key, sizeof(key.hmac_key), params) != 1)
+    {
+        return -1;
+    }
+#else
+    HMAC_Init_ex(hctx, key.hmac_key, sizeof(key.hmac_key), EVP_sha256(), NULL);
+#endif
+    return ret;
+}
+
+/**
+ * sessions and session ticket keys in shared memory, so a client can resume on any reactor thread or worker
+ */
+int swSSL_server_set_session_cache(SSL_CTX* ssl_context, swSSL_config *cfg)
+{
+    if (cfg->session_cache_size == 0 && !cfg->session_tickets)
+    {
+        return SW_OK;
+    }
+    if (swSSL_session_cache_index < 0)
+    {
+        swSSL_session_cache_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+    }
+
+    uint32_t size = cfg->session_cache_size;
+    swSSL_session_cache *cache = sw_shm_calloc(1, sizeof(swSSL_session_cache) + sizeof(swSSL_session) * size);
+    if (cache == NULL)
+    {
+        swWarn("sw_shm_calloc(%ld) failed.", (long) (sizeof(swSSL_session_cache) + sizeof(swSSL_session) * size));
+        return SW_ERR;
+    }
+    if (swMutex_create(&cache->lock, 1) < 0)
+    {
+        swWarn("create mutex lock error.");
+        sw_shm_free(cache);
+        return SW_ERR;
+    }
+    cache->size = size;
+    SSL_CTX_set_ex_data(ssl_context, swSSL_session_cache_index, cache);
+
+    if (size > 0)
+    {
+        SSL_CTX_set_session_id_context(ssl_context, (const uchar *) "swoole", strlen("swoole"));
+        SSL_CTX_set_session_cache_mode(ssl_context, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_set_timeout(ssl_context, cfg->session_timeout > 0 ? cfg->session_timeout : SW_SSL_SESSION_TIMEOUT);
+        SSL_CTX_sess_set_new_cb(ssl_context, swSSL_session_new);
+        SSL_CTX_sess_set_get_cb(ssl_context, swSSL_session_get);
+        SSL_CTX_sess_set_remove_cb(ssl_context, swSSL_session_remove);
+    }
+
+    if (cfg->session_tickets)
+    {
+        cache->ticket_key_lifetime = cfg->ticket_key_lifetime > 0 ? cfg->ticket_key_lifetime : SW_SSL_TICKET_KEY_LIFETIME;
+        swSSL_ticket_key_generate(cache);
+        //both keys are valid after the first generation
+        swSSL_ticket_key_generate(cache);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(ssl_context, swSSL_ticket_key_callback);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(ssl_context, swSSL_ticket_key_callback);
+#endif
+    }
+    return SW_OK;
+}
+
 static int swSSL_passwd_callback(char *buf, int num, int verify, void *data)
 {
     swSSL_option *option = (swSSL_option *) data;
@@ -730,6 +985,33 @@ int swSSL_connect(swConnection *conn)
 
 int swSSL_sendfile(swConnection *conn, int fd, off_t *offset, size_t size)
 {
+#ifdef SSL_OP_ENABLE_KTLS
+    //the kernel encrypts the records, the file is not copied to user space
+    if (BIO_get_ktls_send(SSL_get_wbio(conn->ssl)))
+    {
+        ossl_ssize_t n = SSL_sendfile(conn->ssl, fd, *offset, size, 0);
+        if (n < 0)
+        {
+            switch (SSL_get_error(conn->ssl, n))
+            {
+            case SSL_ERROR_WANT_WRITE:
+                conn->ssl_want_write = 1;
+                errno = EAGAIN;
+                break;
+            case SSL_ERROR_SSL:
+                swSSL_connection_error(conn);
+                errno = SW_ERROR_SSL_BAD_CLIENT;
+                break;
+            default:
+                break;
+            }
+            return SW_ERR;
+        }
+        *offset += n;
+        return n;
+    }
+#endif
+
     char buf[SW_BUFFER_SIZE_BIG];
     int readn = size > sizeof(buf) ? sizeof(buf) : size;
 
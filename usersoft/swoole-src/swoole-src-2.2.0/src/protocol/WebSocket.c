@@ -21,6 +21,10 @@
 
 #include <sys/time.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /*  The following is websocket data frame:
  +-+-+-+-+-------+-+-------------+-------------------------------+
  0                   1                   2                   3   |
@@ -91,6 +95,38 @@ int swWebSocket_get_package_length(swProtocol *protocol, swConnection *conn, cha
     return header_length + payload_length;
 }
 
+/**
+ * the 4 byte key repeats, so it is applied 16 (SSE2) or 8 bytes at a time
+ */
+void swWebSocket_mask(char *data, size_t length, const char *mask_key)
+{
+    size_t i = 0;
+    uint32_t key32;
+    memcpy(&key32, mask_key, SW_WEBSOCKET_MASK_LEN);
+
+#ifdef __SSE2__
+    const __m128i key128 = _mm_set1_epi32(key32);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        _mm_storeu_si128((__m128i *) (data + i), _mm_xor_si128(v, key128));
+    }
+#endif
+
+    uint64_t key64 = ((uint64_t) key32 << 32) | key32;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t v;
+        memcpy(&v, data + i, sizeof(v));
+        v ^= key64;
+        memcpy(data + i, &v, sizeof(v));
+    }
+    for (; i < length; i++)
+    {
+        data[i] ^= mask_key[i % SW_WEBSOCKET_MASK_LEN];
+    }
+}
+
 void swWebSocket_encode(swString *buffer, char *data, size_t length, char opcode, int finish, int mask)
 {
     int pos = 0;
@@ -135,14 +171,9 @@ void swWebSocket_encode(swString *buffer, char *data, size_t length, char opcode
             char *_mask_data = SW_WEBSOCKET_MASK_DATA;
             swString_append_ptr(buffer, _mask_data, SW_WEBSOCKET_MASK_LEN);
 
-            char *_data = buffer->str + buffer->length;
+            size_t offset = buffer->length;
             swString_append_ptr(buffer, data, length);
-
-            int i;
-            for (i = 0; i < length; i++)
-            {
-                _data[i] ^= _mask_data[i % SW_WEBSOCKET_MASK_LEN];
-            }
+            swWebSocket_mask(buffer->str + offset, length, _mask_data);
         }
         else
         {
@@ -179,11 +210,7 @@ void swWebSocket_decode(swWebSocket_frame *frame, swString *data)
         memcpy(mask_key, data->str + header_length, SW_WEBSOCKET_MASK_LEN);
         header_length += SW_WEBSOCKET_MASK_LEN;
         buf = data->str + header_length;
-        int i;
-        for (i = 0; i < payload_length; i++)
-        {
-            buf[i] ^= mask_key[i % SW_WEBSOCKET_MASK_LEN];
-        }
+        swWebSocket_mask(buf, payload_length, mask_key);
     }
     frame->payload_length = payload_length;
     frame->header_length = header_length;
@@ -226,7 +253,7 @@ int swWebSocket_dispatch_frame(swConnection *conn, char *data, uint32_t length)
     switch (ws.header.OPCODE)
     {
     case WEBSOCKET_OPCODE_CONTINUATION_FRAME:
-        frame_buffer = conn->websocket_buffer;
+        frame_buffer = conn->ext ? conn->ext->websocket_buffer : NULL;
         if (frame_buffer == NULL)
         {
             swWarn("bad frame[opcode=0]. remote_addr=%s:%d.", swConnection_get_ip(conn), swConnection_get_port(conn));
@@ -248,7 +275,7 @@ int swWebSocket_dispatch_frame(swConnection *conn, char *data, uint32_t length)
         {
             swReactorThread_dispatch(conn, frame_buffer->str, frame_buffer->length);
             swString_free(frame_buffer);
-            conn->websocket_buffer = NULL;
+            conn->ext->websocket_buffer = NULL;
         }
         break;
 
@@ -259,12 +286,17 @@ int swWebSocket_dispatch_frame(swConnection *conn, char *data, uint32_t length)
         data[offset + 1] = ws.header.OPCODE;
         if (!ws.header.FIN)
         {
-            if (conn->websocket_buffer)
+            swConnection_ext *ext = swConnection_get_ext(conn);
+            if (ext == NULL)
+            {
+                return SW_ERR;
+            }
+            if (ext->websocket_buffer)
             {
                 swWarn("merging incomplete frame, bad request. remote_addr=%s:%d.", swConnection_get_ip(conn), swConnection_get_port(conn));
                 return SW_ERR;
             }
-            conn->websocket_buffer = swString_dup(data + offset, length - offset);
+            ext->websocket_buffer = swString_dup(data + offset, length - offset);
         }
         else
         {
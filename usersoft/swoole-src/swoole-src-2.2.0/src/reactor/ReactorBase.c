@@ -42,7 +42,14 @@ int swReactor_create(swReactor *reactor, int max_event)
     int ret;
     bzero(reactor, sizeof(swReactor));
 
-#ifdef HAVE_EPOLL
+#if defined(SW_USE_IO_URING) && defined(HAVE_IO_URING)
+    //fall back to epoll if the kernel refuses io_uring
+    ret = swReactorIOUring_create(reactor, max_event);
+    if (ret < 0)
+    {
+        ret = swReactorEpoll_create(reactor, max_event);
+    }
+#elif defined(HAVE_EPOLL)
     ret = swReactorEpoll_create(reactor, max_event);
 #elif defined(HAVE_KQUEUE)
     ret = swReactorKqueue_create(reactor, max_event);
@@ -241,6 +248,10 @@ static void swReactor_onBegin(swReactor *reactor)
 int swReactor_close(swReactor *reactor, int fd)
 {
     swConnection *socket = swReactor_get(reactor, fd);
+    if (socket->ext)
+    {
+        swConnection_free_ext(socket);
+    }
     if (socket->out_buffer)
     {
         swBuffer_free(socket->out_buffer);
@@ -249,10 +260,6 @@ int swReactor_close(swReactor *reactor, int fd)
     {
         swBuffer_free(socket->in_buffer);
     }
-    if (socket->websocket_buffer)
-    {
-        swString_free(socket->websocket_buffer);
-    }
     bzero(socket, sizeof(swConnection));
     socket->removed = 1;
     swTraceLog(SW_TRACE_CLOSE, "fd=%d.", fd);
@@ -397,6 +404,12 @@ int swReactor_onWrite(swReactor *reactor, swEvent *ev)
         chunk = swBuffer_get_trunk(buffer);
         if (chunk->type == SW_CHUNK_CLOSE)
         {
+            //wait for the MSG_ZEROCOPY completions, see swConnection_zerocopy_onError
+            if (swConnection_zerocopy_pending(socket))
+            {
+                socket->events &= (~SW_EVENT_WRITE);
+                return reactor->set(reactor, fd, socket->fdtype | socket->events);
+            }
             close_fd:
             reactor->close(reactor, ev->fd);
             return SW_OK;
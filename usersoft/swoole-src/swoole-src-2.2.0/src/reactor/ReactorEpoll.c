@@ -27,6 +27,10 @@
 #define EPOLLONESHOT (1u << 30)
 #endif
 
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
 typedef struct swReactorEpoll_s swReactorEpoll;
 
 typedef struct _swFd
@@ -57,6 +61,10 @@ static sw_inline int swReactorEpoll_event_set(int fdtype)
         //flag |= (EPOLLRDHUP);
         flag |= (EPOLLRDHUP | EPOLLHUP | EPOLLERR);
     }
+    if (fdtype & SW_EVENT_EXCLUSIVE)
+    {
+        flag |= EPOLLEXCLUSIVE;
+    }
     return flag;
 }
 
@@ -64,6 +72,11 @@ struct swReactorEpoll_s
 {
     int epfd;
     struct epoll_event *events;
+    /**
+     * current epoll_wait() batch size, grows while the batch keeps filling up and shrinks when it stays mostly empty
+     */
+    int batch;
+    int idle_rounds;
 };
 
 int swReactorEpoll_create(swReactor *reactor, int max_event_num)
@@ -78,6 +91,7 @@ int swReactorEpoll_create(swReactor *reactor, int max_event_num)
     bzero(reactor_object, sizeof(swReactorEpoll));
     reactor->object = reactor_object;
     reactor->max_event_num = max_event_num;
+    reactor_object->batch = max_event_num < SW_REACTOR_MINEVENTS ? max_event_num : SW_REACTOR_MINEVENTS;
 
     reactor_object->events = sw_calloc(max_event_num, sizeof(struct epoll_event));
 
@@ -118,6 +132,7 @@ static int swReactorEpoll_add(swReactor *reactor, int fd, int fdtype)
     swReactorEpoll *object = reactor->object;
     struct epoll_event e;
     swFd fd_;
+    int ret;
     bzero(&e, sizeof(struct epoll_event));
 
     fd_.fd = fd;
@@ -127,7 +142,14 @@ static int swReactorEpoll_add(swReactor *reactor, int fd, int fdtype)
     swReactor_add(reactor, fd, fdtype);
 
     memcpy(&(e.data.u64), &fd_, sizeof(fd_));
-    if (epoll_ctl(object->epfd, EPOLL_CTL_ADD, fd, &e) < 0)
+    ret = epoll_ctl(object->epfd, EPOLL_CTL_ADD, fd, &e);
+    //kernel without EPOLLEXCLUSIVE support, fall back to a shared wait queue
+    if (ret < 0 && errno == EINVAL && (e.events & EPOLLEXCLUSIVE))
+    {
+        e.events &= ~EPOLLEXCLUSIVE;
+        ret = epoll_ctl(object->epfd, EPOLL_CTL_ADD, fd, &e);
+    }
+    if (ret < 0)
     {
         swSysError("add events[fd=%d#%d, type=%d, events=%d] failed.", fd, reactor->id, fd_.fdtype, e.events);
         swReactor_del(reactor, fd);
@@ -164,7 +186,8 @@ static int swReactorEpoll_set(swReactor *reactor, int fd, int fdtype)
     int ret;
 
     bzero(&e, sizeof(struct epoll_event));
-    e.events = swReactorEpoll_event_set(fdtype);
+    //EPOLLEXCLUSIVE is only allowed with EPOLL_CTL_ADD
+    e.events = swReactorEpoll_event_set(fdtype) & ~EPOLLEXCLUSIVE;
 
     if (e.events & EPOLLOUT)
     {
@@ -193,10 +216,12 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
     swReactorEpoll *object = reactor->object;
     swReactor_handle handle;
     int i, n, ret, msec;
+    uint64_t wait_start = 0, loop_start = 0;
 
     int reactor_id = reactor->id;
     int epoll_fd = object->epfd;
     int max_event_num = reactor->max_event_num;
+    int min_event_num = max_event_num < SW_REACTOR_MINEVENTS ? max_event_num : SW_REACTOR_MINEVENTS;
     struct epoll_event *events = object->events;
 
     if (reactor->timeout_msec == 0)
@@ -220,7 +245,16 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
             reactor->onBegin(reactor);
         }
         msec = reactor->timeout_msec;
-        n = epoll_wait(epoll_fd, events, max_event_num, msec);
+        if (reactor->wait_histogram)
+        {
+            wait_start = swoole_monotonic_usec();
+        }
+        n = epoll_wait(epoll_fd, events, object->batch, msec);
+        if (reactor->wait_histogram)
+        {
+            loop_start = swoole_monotonic_usec();
+            swHistogram_record(reactor->wait_histogram, loop_start - wait_start);
+        }
         if (n < 0)
         {
             if (swReactor_error(reactor) < 0)
@@ -241,6 +275,27 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
             }
             continue;
         }
+        /**
+         * a full batch means more events are pending, so fetch more at once next time.
+         * shrink back only after the batch has stayed mostly empty for a while.
+         */
+        if (n == object->batch && object->batch < max_event_num)
+        {
+            object->batch = object->batch * 2 > max_event_num ? max_event_num : object->batch * 2;
+            object->idle_rounds = 0;
+        }
+        else if (n < object->batch / 4 && object->batch > min_event_num)
+        {
+            if (++object->idle_rounds >= SW_REACTOR_SHRINK_ROUNDS)
+            {
+                object->batch /= 2;
+                object->idle_rounds = 0;
+            }
+        }
+        else
+        {
+            object->idle_rounds = 0;
+        }
         for (i = 0; i < n; i++)
         {
             event.fd = events[i].data.u64;
@@ -293,6 +348,10 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
         {
             reactor->onFinish(reactor);
         }
+        if (reactor->loop_histogram)
+        {
+            swHistogram_record(reactor->loop_histogram, swoole_monotonic_usec() - loop_start);
+        }
         if (reactor->once)
         {
             break;
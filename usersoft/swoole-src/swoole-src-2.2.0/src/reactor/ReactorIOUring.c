@@ -0,0 +1,589 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+
+#if defined(SW_USE_IO_URING) && defined(HAVE_IO_URING)
+
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#ifndef POLLRDHUP
+#define POLLRDHUP   0x2000
+#endif
+
+/**
+ * io_uring reactor
+ *
+ * Readiness is watched with one-shot IORING_OP_POLL_ADD requests, so the handlers keep their
+ * non-blocking read/write code. Every add/set/del and every re-arm only queues an SQE; all of them
+ * are submitted by the same io_uring_enter() that waits for completions, which costs one syscall
+ * per loop instead of one epoll_ctl() per change plus epoll_wait().
+ *
+ * user_data of a poll request is (seq << 32 | fd). seq is bumped whenever the registration of
+ * the fd changes, so completions of cancelled or replaced requests are recognized and dropped.
+ */
+#define SW_IO_URING_REMOVE_TAG   ((uint64_t) -1)
+
+#define swIOUring_load_acquire(p)       __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define swIOUring_store_release(p, v)   __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+typedef struct _swIOUringFd
+{
+    uint32_t seq;
+    uint32_t events;
+    uint8_t armed;
+} swIOUringFd;
+
+typedef struct _swReactorIOUring
+{
+    int ring_fd;
+
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    uint32_t *sq_array;
+    struct io_uring_sqe *sqes;
+
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+
+    swIOUringFd *fds;
+    uint32_t fd_num;
+
+    struct io_uring_cqe *events;
+} swReactorIOUring;
+
+static int swReactorIOUring_add(swReactor *reactor, int fd, int fdtype);
+static int swReactorIOUring_set(swReactor *reactor, int fd, int fdtype);
+static int swReactorIOUring_del(swReactor *reactor, int fd);
+static int swReactorIOUring_wait(swReactor *reactor, struct timeval *timeo);
+static void swReactorIOUring_free(swReactor *reactor);
+
+static sw_inline int io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static sw_inline int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static sw_inline uint32_t swReactorIOUring_event_set(int fdtype)
+{
+    uint32_t flag = 0;
+    if (swReactor_event_read(fdtype))
+    {
+        flag |= POLLIN;
+    }
+    if (swReactor_event_write(fdtype))
+    {
+        flag |= POLLOUT;
+    }
+    if (swReactor_event_error(fdtype))
+    {
+        flag |= (POLLRDHUP | POLLHUP | POLLERR);
+    }
+    return flag;
+}
+
+static sw_inline uint32_t swReactorIOUring_pending(swReactorIOUring *object)
+{
+    return *object->sq_tail - swIOUring_load_acquire(object->sq_head);
+}
+
+static struct io_uring_sqe* swReactorIOUring_get_sqe(swReactorIOUring *object)
+{
+    uint32_t tail = *object->sq_tail;
+    //submission queue is full, flush it without waiting
+    if (swReactorIOUring_pending(object) >= object->sq_entries)
+    {
+        if (io_uring_enter(object->ring_fd, swReactorIOUring_pending(object), 0, 0, NULL, 0) < 0)
+        {
+            swSysError("io_uring_enter() failed.");
+            return NULL;
+        }
+    }
+    struct io_uring_sqe *sqe = &object->sqes[tail & object->sq_mask];
+    bzero(sqe, sizeof(struct io_uring_sqe));
+    object->sq_array[tail & object->sq_mask] = tail & object->sq_mask;
+    return sqe;
+}
+
+static sw_inline void swReactorIOUring_commit_sqe(swReactorIOUring *object)
+{
+    swIOUring_store_release(object->sq_tail, *object->sq_tail + 1);
+}
+
+static int swReactorIOUring_poll_add(swReactorIOUring *object, int fd)
+{
+    swIOUringFd *info = &object->fds[fd];
+    struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+    if (sqe == NULL)
+    {
+        return SW_ERR;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = info->events;
+    sqe->user_data = ((uint64_t) info->seq << 32) | (uint32_t) fd;
+    swReactorIOUring_commit_sqe(object);
+    info->armed = 1;
+    return SW_OK;
+}
+
+static int swReactorIOUring_poll_remove(swReactorIOUring *object, int fd)
+{
+    swIOUringFd *info = &object->fds[fd];
+    if (info->armed)
+    {
+        struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+        if (sqe == NULL)
+        {
+            return SW_ERR;
+        }
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = ((uint64_t) info->seq << 32) | (uint32_t) fd;
+        sqe->user_data = SW_IO_URING_REMOVE_TAG;
+        swReactorIOUring_commit_sqe(object);
+        info->armed = 0;
+    }
+    //completions of the old request are stale from now on
+    info->seq++;
+    return SW_OK;
+}
+
+static int swReactorIOUring_fd_extend(swReactorIOUring *object, int fd)
+{
+    if ((uint32_t) fd < object->fd_num)
+    {
+        return SW_OK;
+    }
+    uint32_t fd_num = object->fd_num;
+    while (fd_num <= (uint32_t) fd)
+    {
+        fd_num *= 2;
+    }
+    swIOUringFd *fds = sw_realloc(object->fds, fd_num * sizeof(swIOUringFd));
+    if (fds == NULL)
+    {
+        swWarn("realloc(%u) failed.", fd_num);
+        return SW_ERR;
+    }
+    bzero(fds + object->fd_num, (fd_num - object->fd_num) * sizeof(swIOUringFd));
+    object->fds = fds;
+    object->fd_num = fd_num;
+    return SW_OK;
+}
+
+int swReactorIOUring_create(swReactor *reactor, int max_event_num)
+{
+    struct io_uring_params params;
+    void *ptr;
+
+    swReactorIOUring *object = sw_malloc(sizeof(swReactorIOUring));
+    if (object == NULL)
+    {
+        swWarn("malloc[0] failed.");
+        return SW_ERR;
+    }
+    bzero(object, sizeof(swReactorIOUring));
+
+    bzero(&params, sizeof(params));
+    object->ring_fd = io_uring_setup(max_event_num, &params);
+    if (object->ring_fd < 0)
+    {
+        swWarn("io_uring_setup() failed. Error: %s[%d]", strerror(errno), errno);
+        sw_free(object);
+        return SW_ERR;
+    }
+    //the wait loop needs io_uring_enter() with a timeout (linux 5.11)
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        swWarn("io_uring of this kernel is too old.");
+        close(object->ring_fd);
+        sw_free(object);
+        return SW_ERR;
+    }
+
+    object->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    object->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (object->cq_ring_size > object->sq_ring_size)
+        {
+            object->sq_ring_size = object->cq_ring_size;
+        }
+        object->cq_ring_size = object->sq_ring_size;
+    }
+
+    object->sq_ring = mmap(NULL, object->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, object->ring_fd, IORING_OFF_SQ_RING);
+    if (object->sq_ring == MAP_FAILED)
+    {
+        swSysError("mmap(IORING_OFF_SQ_RING) failed.");
+        goto _error;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        object->cq_ring = object->sq_ring;
+    }
+    else
+    {
+        object->cq_ring = mmap(NULL, object->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, object->ring_fd, IORING_OFF_CQ_RING);
+        if (object->cq_ring == MAP_FAILED)
+        {
+            swSysError("mmap(IORING_OFF_CQ_RING) failed.");
+            object->cq_ring = NULL;
+            goto _error;
+        }
+    }
+    object->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    object->sqes = mmap(NULL, object->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, object->ring_fd, IORING_OFF_SQES);
+    if (object->sqes == MAP_FAILED)
+    {
+        swSysError("mmap(IORING_OFF_SQES) failed.");
+        object->sqes = NULL;
+        goto _error;
+    }
+
+    ptr = object->sq_ring;
+    object->sq_head = ptr + params.sq_off.head;
+    object->sq_tail = ptr + params.sq_off.tail;
+    object->sq_mask = *(uint32_t *) (ptr + params.sq_off.ring_mask);
+    object->sq_entries = *(uint32_t *) (ptr + params.sq_off.ring_entries);
+    object->sq_array = ptr + params.sq_off.array;
+
+    ptr = object->cq_ring;
+    object->cq_head = ptr + params.cq_off.head;
+    object->cq_tail = ptr + params.cq_off.tail;
+    object->cq_mask = *(uint32_t *) (ptr + params.cq_off.ring_mask);
+    object->cqes = ptr + params.cq_off.cqes;
+
+    object->fd_num = 1024;
+    object->fds = sw_calloc(object->fd_num, sizeof(swIOUringFd));
+    object->events = sw_calloc(max_event_num, sizeof(struct io_uring_cqe));
+    if (object->fds == NULL || object->events == NULL)
+    {
+        swWarn("malloc[1] failed.");
+        goto _error;
+    }
+
+    reactor->object = object;
+    reactor->max_event_num = max_event_num;
+
+    reactor->add = swReactorIOUring_add;
+    reactor->set = swReactorIOUring_set;
+    reactor->del = swReactorIOUring_del;
+    reactor->wait = swReactorIOUring_wait;
+    reactor->free = swReactorIOUring_free;
+
+    return SW_OK;
+
+    _error:
+    reactor->object = object;
+    swReactorIOUring_free(reactor);
+    reactor->object = NULL;
+    return SW_ERR;
+}
+
+static void swReactorIOUring_free(swReactor *reactor)
+{
+    swReactorIOUring *object = reactor->object;
+    if (object->sqes)
+    {
+        munmap(object->sqes, object->sqes_size);
+    }
+    if (object->cq_ring && object->cq_ring != object->sq_ring)
+    {
+        munmap(object->cq_ring, object->cq_ring_size);
+    }
+    if (object->sq_ring && object->sq_ring != MAP_FAILED)
+    {
+        munmap(object->sq_ring, object->sq_ring_size);
+    }
+    close(object->ring_fd);
+    if (object->fds)
+    {
+        sw_free(object->fds);
+    }
+    if (object->events)
+    {
+        sw_free(object->events);
+    }
+    sw_free(object);
+}
+
+static int swReactorIOUring_add(swReactor *reactor, int fd, int fdtype)
+{
+    swReactorIOUring *object = reactor->object;
+
+    if (swReactorIOUring_fd_extend(object, fd) < 0)
+    {
+        return SW_ERR;
+    }
+    swIOUringFd *info = &object->fds[fd];
+    if (info->armed)
+    {
+        swWarn("fd#%d is already added to reactor#%d.", fd, reactor->id);
+        return SW_ERR;
+    }
+
+    swReactor_add(reactor, fd, fdtype);
+
+    info->seq++;
+    info->events = swReactorIOUring_event_set(fdtype);
+    if (swReactorIOUring_poll_add(object, fd) < 0)
+    {
+        swReactor_del(reactor, fd);
+        return SW_ERR;
+    }
+
+    swTraceLog(SW_TRACE_EVENT, "add event[reactor_id=%d, fd=%d, events=%d]", reactor->id, fd, swReactor_events(fdtype));
+    reactor->event_num++;
+
+    return SW_OK;
+}
+
+static int swReactorIOUring_del(swReactor *reactor, int fd)
+{
+    swReactorIOUring *object = reactor->object;
+
+    if ((uint32_t) fd >= object->fd_num || swReactorIOUring_poll_remove(object, fd) < 0)
+    {
+        swWarn("remove fd[%d#%d] failed.", fd, reactor->id);
+        return SW_ERR;
+    }
+    object->fds[fd].events = 0;
+
+    swTraceLog(SW_TRACE_REACTOR, "remove event[reactor_id=%d|fd=%d]", reactor->id, fd);
+    reactor->event_num = reactor->event_num <= 0 ? 0 : reactor->event_num - 1;
+    swReactor_del(reactor, fd);
+
+    return SW_OK;
+}
+
+static int swReactorIOUring_set(swReactor *reactor, int fd, int fdtype)
+{
+    swReactorIOUring *object = reactor->object;
+
+    if ((uint32_t) fd >= object->fd_num)
+    {
+        swWarn("reactor#%d->set(fd=%d) failed, fd is not added.", reactor->id, fd);
+        return SW_ERR;
+    }
+    if (swReactorIOUring_poll_remove(object, fd) < 0)
+    {
+        return SW_ERR;
+    }
+    object->fds[fd].events = swReactorIOUring_event_set(fdtype);
+    if (swReactorIOUring_poll_add(object, fd) < 0)
+    {
+        return SW_ERR;
+    }
+
+    swTraceLog(SW_TRACE_EVENT, "set event[reactor_id=%d, fd=%d, events=%d]", reactor->id, fd, swReactor_events(fdtype));
+    swReactor_set(reactor, fd, fdtype);
+    return SW_OK;
+}
+
+static int swReactorIOUring_wait(swReactor *reactor, struct timeval *timeo)
+{
+    swEvent event;
+    swReactorIOUring *object = reactor->object;
+    swReactor_handle handle;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    struct io_uring_cqe *events = object->events;
+    swIOUringFd *info;
+    uint32_t head, tail, revents, seq;
+    int i, n, ret, msec, timedout;
+
+    int reactor_id = reactor->id;
+    int max_event_num = reactor->max_event_num;
+
+    if (reactor->timeout_msec == 0)
+    {
+        if (timeo == NULL)
+        {
+            reactor->timeout_msec = -1;
+        }
+        else
+        {
+            reactor->timeout_msec = timeo->tv_sec * 1000 + timeo->tv_usec / 1000;
+        }
+    }
+
+    reactor->start = 1;
+
+    while (reactor->running > 0)
+    {
+        if (reactor->onBegin != NULL)
+        {
+            reactor->onBegin(reactor);
+        }
+        msec = reactor->timeout_msec;
+
+        bzero(&arg, sizeof(arg));
+        if (msec >= 0)
+        {
+            ts.tv_sec = msec / 1000;
+            ts.tv_nsec = (msec % 1000) * 1000 * 1000;
+            arg.ts = (uint64_t) (uintptr_t) &ts;
+        }
+
+        timedout = 0;
+        head = *object->cq_head;
+        if (head == swIOUring_load_acquire(object->cq_tail))
+        {
+            //submit the queued changes and wait in one syscall
+            ret = io_uring_enter(object->ring_fd, swReactorIOUring_pending(object), 1,
+                    IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+            if (ret < 0 && errno == ETIME)
+            {
+                timedout = 1;
+            }
+            //completion queue overflowed, reap what is there first
+            else if (ret < 0 && (errno == EBUSY || errno == EAGAIN))
+            {
+                ret = 0;
+            }
+            else if (ret < 0)
+            {
+                if (swReactor_error(reactor) < 0)
+                {
+                    swWarn("[Reactor#%d] io_uring_enter failed. Error: %s[%d]", reactor_id, strerror(errno), errno);
+                    return SW_ERR;
+                }
+                else
+                {
+                    continue;
+                }
+            }
+        }
+
+        n = 0;
+        tail = swIOUring_load_acquire(object->cq_tail);
+        while (head != tail && n < max_event_num)
+        {
+            struct io_uring_cqe *cqe = &object->cqes[head & object->cq_mask];
+            head++;
+            if (cqe->user_data != SW_IO_URING_REMOVE_TAG)
+            {
+                events[n++] = *cqe;
+            }
+        }
+        swIOUring_store_release(object->cq_head, head);
+
+        if (n == 0)
+        {
+            if (timedout && reactor->onTimeout != NULL)
+            {
+                reactor->onTimeout(reactor);
+            }
+            continue;
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            event.fd = (uint32_t) events[i].user_data;
+            seq = events[i].user_data >> 32;
+            if ((uint32_t) event.fd >= object->fd_num)
+            {
+                continue;
+            }
+            info = &object->fds[event.fd];
+            //cancelled or replaced request
+            if (info->seq != seq || !info->armed)
+            {
+                continue;
+            }
+            info->armed = 0;
+            if (events[i].res < 0)
+            {
+                swWarn("[Reactor#%d] poll fd#%d failed. Error: %s[%d]", reactor_id, event.fd, strerror(-events[i].res), -events[i].res);
+                continue;
+            }
+            revents = events[i].res;
+
+            event.from_id = reactor_id;
+            event.socket = swReactor_get(reactor, event.fd);
+            event.type = event.socket->fdtype;
+
+            //read
+            if ((revents & POLLIN) && !event.socket->removed)
+            {
+                handle = swReactor_getHandle(reactor, SW_EVENT_READ, event.type);
+                ret = handle(reactor, &event);
+                if (ret < 0)
+                {
+                    swSysError("POLLIN handle failed. fd=%d.", event.fd);
+                }
+            }
+            //write
+            if ((revents & POLLOUT) && !event.socket->removed)
+            {
+                handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event.type);
+                ret = handle(reactor, &event);
+                if (ret < 0)
+                {
+                    swSysError("POLLOUT handle failed. fd=%d.", event.fd);
+                }
+            }
+            //error
+            if ((revents & (POLLRDHUP | POLLERR | POLLHUP)) && !event.socket->removed
+                    && !(revents & POLLIN) && !(revents & POLLOUT))
+            {
+                handle = swReactor_getHandle(reactor, SW_EVENT_ERROR, event.type);
+                ret = handle(reactor, &event);
+                if (ret < 0)
+                {
+                    swSysError("POLLERR handle failed. fd=%d.", event.fd);
+                }
+            }
+            //one-shot request: re-arm unless the handler removed or changed the fd
+            info = &object->fds[event.fd];
+            if (!event.socket->removed && info->seq == seq && !info->armed)
+            {
+                swReactorIOUring_poll_add(object, event.fd);
+            }
+        }
+
+        if (reactor->onFinish != NULL)
+        {
+            reactor->onFinish(reactor);
+        }
+        if (reactor->once)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+#endif
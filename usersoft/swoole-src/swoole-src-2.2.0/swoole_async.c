@@ -1050,6 +1050,18 @@ PHP_FUNCTION(swoole_async_set)
         convert_to_boolean(v);
         SwooleG.socket_dontwait = Z_BVAL_P(v);
     }
+    if (php_swoole_array_get_value(vht, "timer_wheel", v))
+    {
+        convert_to_boolean(v);
+        if (SwooleG.timer.map)
+        {
+            swoole_php_fatal_error(E_WARNING, "timer_wheel must be set before the first timer is added.");
+        }
+        else
+        {
+            SwooleG.use_timer_wheel = Z_BVAL_P(v);
+        }
+    }
     if (php_swoole_array_get_value(vht, "dns_lookup_random", v))
     {
         convert_to_boolean(v);
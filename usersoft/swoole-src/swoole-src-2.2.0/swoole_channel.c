@@ -71,7 +71,7 @@ static PHP_METHOD(swoole_channel, __construct)
         size = SW_BUFFER_SIZE_STD;
     }
 
-    swChannel *chan = swChannel_new(size, SW_BUFFER_SIZE_STD, SW_CHAN_LOCK | SW_CHAN_SHM);
+    swMpmcChannel *chan = swMpmcChannel_new(size, SW_CHANNEL_CELL_SIZE, SW_CHAN_SHM);
     if (chan == NULL)
     {
         zend_throw_exception(swoole_exception_class_entry_ptr, "failed to create channel.", SW_ERROR_MALLOC_FAIL TSRMLS_CC);
@@ -87,7 +87,7 @@ static PHP_METHOD(swoole_channel, __destruct)
 
 static PHP_METHOD(swoole_channel, push)
 {
-    swChannel *chan = swoole_get_object(getThis());
+    swMpmcChannel *chan = swoole_get_object(getThis());
     zval *zdata;
 
     if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &zdata) == FAILURE)
@@ -100,15 +100,15 @@ static PHP_METHOD(swoole_channel, push)
     {
         RETURN_FALSE;
     }
-    SW_CHECK_RETURN(swChannel_push(chan, &buf, sizeof(buf.info) + buf.info.len));
+    SW_CHECK_RETURN(swMpmcChannel_push(chan, &buf, sizeof(buf.info) + buf.info.len));
 }
 
 static PHP_METHOD(swoole_channel, pop)
 {
-    swChannel *chan = swoole_get_object(getThis());
+    swMpmcChannel *chan = swoole_get_object(getThis());
     swEventData buf;
 
-    int n = swChannel_pop(chan, &buf, sizeof(buf));
+    int n = swMpmcChannel_pop(chan, &buf, sizeof(buf));
     if (n < 0)
     {
         RETURN_FALSE;
@@ -126,7 +126,7 @@ static PHP_METHOD(swoole_channel, pop)
 
 static PHP_METHOD(swoole_channel, stats)
 {
-    swChannel *chan = swoole_get_object(getThis());
+    swMpmcChannel *chan = swoole_get_object(getThis());
     array_init(return_value);
 
     sw_add_assoc_long_ex(return_value, ZEND_STRS("queue_num"), chan->num);
@@ -62,12 +62,20 @@ typedef struct _channel_node
 {
     php_context context;
     channel_selector *selector;
+    /**
+     * popMany() waiter
+     */
+    swTimer_node *timer;
+    swLinkedList *list;
+    swLinkedList_node *list_node;
+    zend_bool many;
 } channel_node;
 
 static PHP_METHOD(swoole_channel_coro, __construct);
 static PHP_METHOD(swoole_channel_coro, __destruct);
 static PHP_METHOD(swoole_channel_coro, push);
 static PHP_METHOD(swoole_channel_coro, pop);
+static PHP_METHOD(swoole_channel_coro, popMany);
 static PHP_METHOD(swoole_channel_coro, close);
 static PHP_METHOD(swoole_channel_coro, stats);
 static PHP_METHOD(swoole_channel_coro, length);
@@ -76,7 +84,7 @@ static PHP_METHOD(swoole_channel_coro, isFull);
 static PHP_METHOD(swoole_channel_coro, select);
 
 static zend_class_entry swoole_channel_coro_ce;
-static zend_class_entry *swoole_channel_coro_class_entry_ptr;
+zend_class_entry *swoole_channel_coro_class_entry_ptr;
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_channel_coro_construct, 0, 0, 1)
     ZEND_ARG_INFO(0, size)
@@ -86,6 +94,11 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_channel_coro_push, 0, 0, 1)
     ZEND_ARG_INFO(0, data)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_channel_coro_popMany, 0, 0, 1)
+    ZEND_ARG_INFO(0, n)
+    ZEND_ARG_INFO(0, timeout)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_channel_coro_select, 0, 0, 3)
     ZEND_ARG_ARRAY_INFO(1, read_list, 1)
     ZEND_ARG_ARRAY_INFO(1, write_list, 1)
@@ -101,6 +114,7 @@ static const zend_function_entry swoole_channel_coro_methods[] =
     PHP_ME(swoole_channel_coro, __destruct, arginfo_swoole_void, ZEND_ACC_PUBLIC | ZEND_ACC_DTOR)
     PHP_ME(swoole_channel_coro, push, arginfo_swoole_channel_coro_push, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_channel_coro, pop, arginfo_swoole_void, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_channel_coro, popMany, arginfo_swoole_channel_coro_popMany, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_channel_coro, isEmpty, arginfo_swoole_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_channel_coro, isFull, arginfo_swoole_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_channel_coro, close, arginfo_swoole_void, ZEND_ACC_PUBLIC)
@@ -191,7 +205,20 @@ static int channel_onNotify(swReactor *reactor, swEvent *event)
 
 static void channel_notify(channel_node *next)
 {
+    if (next->timer)
+    {
+        swTimer_del(&SwooleG.timer, next->timer);
+        next->timer = NULL;
+    }
     swLinkedList_append(SwooleWG.coro_timeout_list, next);
+    /**
+     * inside the event loop the waiter is resumed by coro_handle_timeout() at the end of this round,
+     * the eventfd is only needed to wake up a reactor that is not polling yet
+     */
+    if (SwooleG.main_reactor && SwooleG.main_reactor->start)
+    {
+        return;
+    }
     if (!swReactor_handle_isset(SwooleG.main_reactor, PHP_SWOOLE_FD_CHAN_PIPE))
     {
         swReactor_setHandle(SwooleG.main_reactor, PHP_SWOOLE_FD_CHAN_PIPE, channel_onNotify);
@@ -212,6 +239,7 @@ static void swoole_channel_onResume(php_context *ctx)
     channel_node *node = (channel_node *) ctx;
     zval *zdata = &ctx->coro_params;
     zval *retval = NULL;
+    zval items;
 
     if (node->selector)
     {
@@ -264,6 +292,12 @@ static void swoole_channel_onResume(php_context *ctx)
         ZVAL_BOOL(zdata, 1);
         efree(selector);
     }
+    else if (node->many && Z_TYPE_P(zdata) != IS_FALSE)
+    {
+        array_init(&items);
+        add_next_index_zval(&items, zdata);
+        zdata = &items;
+    }
 
     int ret = coro_resume(ctx, zdata, &retval);
     if (ret == CORO_END && retval)
@@ -529,18 +563,19 @@ static PHP_METHOD(swoole_channel_coro, push)
     }
 }
 
-static PHP_METHOD(swoole_channel_coro, pop)
+/**
+ * pop into return_value, the current coroutine yields while the channel is empty
+ */
+void php_swoole_channel_coro_pop(zval *object, zval *return_value)
 {
-    coro_check(TSRMLS_C);
-
     int ret;
-    swChannel *chan = swoole_get_object(getThis());
+    swChannel *chan = swoole_get_object(object);
     zval zdata;
 
-    channel_coro_property *property = swoole_get_property(getThis(), CHANNEL_CORO_PROPERTY_INDEX);
+    channel_coro_property *property = swoole_get_property(object, CHANNEL_CORO_PROPERTY_INDEX);
     if (chan == NULL)
     {
-        ret = swoole_channel_try_resume_producer(getThis(), property, &zdata);
+        ret = swoole_channel_try_resume_producer(object, property, &zdata);
         if (ret == 0)
         {
             RETURN_ZVAL(&zdata, 0, NULL);
@@ -556,20 +591,154 @@ static PHP_METHOD(swoole_channel_coro, pop)
     }
     else
     {
-        try_resume_producer_defer(getThis(), property, chan);
+        try_resume_producer_defer(object, property, chan);
         RETURN_ZVAL(&zdata, 0, NULL);
     }
 }
 
-static PHP_METHOD(swoole_channel_coro, close)
+/**
+ * non-blocking pop of a buffered channel
+ */
+int php_swoole_channel_coro_try_pop(zval *object, zval *zdata)
 {
-    channel_coro_property *property = swoole_get_property(getThis(), CHANNEL_CORO_PROPERTY_INDEX);
+    swChannel *chan = swoole_get_object(object);
+    if (chan == NULL || swChannel_out(chan, zdata, sizeof(zval)) < 0)
+    {
+        return SW_ERR;
+    }
+    try_resume_producer_defer(object, swoole_get_property(object, CHANNEL_CORO_PROPERTY_INDEX), chan);
+    return SW_OK;
+}
+
+/**
+ * non-blocking push, hands the data to a waiting consumer first
+ */
+int php_swoole_channel_coro_try_push(zval *object, zval *zdata)
+{
+    swChannel *chan = swoole_get_object(object);
+    channel_coro_property *property = swoole_get_property(object, CHANNEL_CORO_PROPERTY_INDEX);
+
     if (property->closed)
     {
-        RETURN_TRUE;
+        return SW_ERR;
+    }
+    if ((chan == NULL || swChannel_empty(chan)) && swoole_channel_try_resume_consumer(object, property, zdata) == 0)
+    {
+        return SW_OK;
+    }
+    if (chan == NULL || swChannel_full(chan))
+    {
+        return SW_ERR;
+    }
+    if (swChannel_in(chan, zdata, sizeof(zval)) < 0)
+    {
+        return SW_ERR;
+    }
+    Z_TRY_ADDREF_P(zdata);
+    return SW_OK;
+}
+
+int php_swoole_channel_coro_consumer_num(zval *object)
+{
+    channel_coro_property *property = swoole_get_property(object, CHANNEL_CORO_PROPERTY_INDEX);
+    return property->consumer_list->num;
+}
+
+void php_swoole_channel_coro_close(zval *object)
+{
+    channel_coro_property *property = swoole_get_property(object, CHANNEL_CORO_PROPERTY_INDEX);
+    if (!property->closed)
+    {
+        property->closed = 1;
+        swoole_channel_try_resume_all(object, property);
+    }
+}
+
+static PHP_METHOD(swoole_channel_coro, pop)
+{
+    coro_check(TSRMLS_C);
+    php_swoole_channel_coro_pop(getThis(), return_value);
+}
+
+static void channel_popMany_onTimeout(swTimer *timer, swTimer_node *tnode)
+{
+    channel_node *node = tnode->data;
+    zval *retval = NULL;
+    zval result;
+
+    node->timer = NULL;
+    swLinkedList_remove_node(node->list, node->list_node);
+    ZVAL_FALSE(&result);
+    int ret = coro_resume(&node->context, &result, &retval);
+    if (ret == CORO_END && retval)
+    {
+        sw_zval_ptr_dtor(&retval);
+    }
+    efree(node);
+}
+
+/**
+ * take up to n buffered items at once, yield only when the channel is empty
+ */
+static PHP_METHOD(swoole_channel_coro, popMany)
+{
+    coro_check(TSRMLS_C);
+
+    long n;
+    double timeout = -1;
+    zval zdata;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|d", &n, &timeout) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+    if (n <= 0)
+    {
+        swoole_php_fatal_error(E_WARNING, "n must be greater than 0.");
+        RETURN_FALSE;
+    }
+
+    swChannel *chan = swoole_get_object(getThis());
+    channel_coro_property *property = swoole_get_property(getThis(), CHANNEL_CORO_PROPERTY_INDEX);
+
+    array_init(return_value);
+    while (chan && n > 0 && swChannel_out(chan, &zdata, sizeof(zdata)) >= 0)
+    {
+        add_next_index_zval(return_value, &zdata);
+        try_resume_producer_defer(getThis(), property, chan);
+        n--;
+    }
+    if (zend_hash_num_elements(Z_ARRVAL_P(return_value)) > 0)
+    {
+        return;
+    }
+    zval_ptr_dtor(return_value);
+
+    if (property->closed || timeout == 0)
+    {
+        RETURN_FALSE;
+    }
+
+    channel_node *node = emalloc(sizeof(channel_node));
+    memset(node, 0, sizeof(channel_node));
+    node->many = 1;
+    node->list = property->consumer_list;
+    swLinkedList_append(node->list, node);
+    node->list_node = node->list->tail;
+    if (timeout > 0)
+    {
+        int ms = (int) (timeout * 1000);
+        php_swoole_check_reactor();
+        php_swoole_check_timer(ms);
+        node->timer = SwooleG.timer.add(&SwooleG.timer, ms, 0, node, channel_popMany_onTimeout);
     }
-    property->closed = 1;
-    swoole_channel_try_resume_all(getThis(), property);
+    coro_save(&node->context);
+    coro_yield();
+}
+
+static PHP_METHOD(swoole_channel_coro, close)
+{
+    php_swoole_channel_coro_close(getThis());
     RETURN_TRUE;
 }
 
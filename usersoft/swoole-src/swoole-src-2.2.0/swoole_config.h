@@ -91,7 +91,15 @@
 
 #define SW_BUFFER_SIZE_STD         8192
 #define SW_BUFFER_SIZE_BIG         65536
+/**
+ * MSG_ZEROCOPY only pays off for large sends, and at most SW_ZEROCOPY_MAX_PENDING sends may wait for completion
+ */
+#define SW_ZEROCOPY_MIN_SIZE       16384
+#define SW_ZEROCOPY_MAX_PENDING    64
 #define SW_BUFFER_SIZE_UDP         65536
+#define SW_UDP_RECV_BATCH          32     //datagrams read by one recvmmsg()
+#define SW_UDP_SEND_BATCH          64     //datagrams sent by one sendmmsg(), also the UDP_SEGMENT limit
+#define SW_UDP_GSO_MAX_SIZE        65507
 #define SW_SENDFILE_CHUNK_SIZE     65536
 
 #define SW_SENDFILE_MAXLEN         4194304
@@ -138,6 +146,11 @@
 #define SW_REACTOR_TIMEO_USEC            0
 #define SW_REACTOR_SCHEDULE              2
 #define SW_REACTOR_MAXEVENTS             4096
+/**
+ * epoll_wait() starts with this batch size and doubles it up to SW_REACTOR_MAXEVENTS while the batch keeps filling up
+ */
+#define SW_REACTOR_MINEVENTS             64
+#define SW_REACTOR_SHRINK_ROUNDS         64
 #define SW_REACTOR_USE_SESSION
 #define SW_SESSION_LIST_SIZE             (1024*1024)
 
@@ -169,6 +182,7 @@
 #define SW_RINGBUFFER_COLLECT_N          100   //collect max_count
 #define SW_RINGBUFFER_FREE_N_MAX         4     //when free_n > MAX, execute collect
 #define SW_RINGBUFFER_WARNING            100
+#define SW_CHANNEL_CELL_SIZE             128   //Swoole\Channel, an item takes ceil(len / (cell - 16)) cells
 //#define SW_RINGBUFFER_DEBUG
 
 #define SW_RELOAD_AFTER_SECONDS_N        10
@@ -180,6 +194,15 @@
 #define SW_BUFFER_OUTPUT_SIZE            (1024*1024*2)
 #define SW_BUFFER_INPUT_SIZE             (1024*1024*2)
 #define SW_BUFFER_MIN_SIZE               65536
+
+/**
+ * output buffer chunk pool, size classes from 256 bytes to 64K
+ */
+#define SW_BUFFER_POOL_MIN_SIZE          256
+#define SW_BUFFER_POOL_CLASS_NUM         9
+#define SW_BUFFER_POOL_MAX_FREE          (1024*1024)  //cached bytes per size class and thread
+#define SW_BUFFER_POOL_MAX_TRUNKS        4096
+#define SW_BUFFER_COALESCE_SIZE          1024  //writes up to this size are merged into the tail chunk
 #define SW_PIPE_BUFFER_SIZE              (1024*1024*32)
 
 #define SW_MEMORY_POOL_SLAB_PAGE         10     //内存池的页数
@@ -206,9 +229,18 @@
 
 #define SW_TASK_TMP_FILE                 "/tmp/swoole.task.XXXXXX"
 #define SW_TASK_TMPDIR_SIZE              128
+#define SW_TASK_SHM_SIZE                 (64 * 1024 * 1024)  //shared ring for large task payloads, 0 uses tmp files only
+#define SW_TASK_QUEUE_SIZE               64    //slots per task worker in the shared-memory queue
+#define SW_TASK_QUEUE_BATCH              8     //max tasks a worker claims per wakeup
 
 #define SW_FILE_CHUNK_SIZE               65536
 
+#define SW_SLAB_PAGE_SHIFT               16    //SlabPool page size 64K, also the largest slice
+#define SW_SLAB_CACHE_SIZE               32    //free slices cached per size class and thread
+#define SW_SLAB_CACHE_POOL_NUM           4     //SlabPools a thread keeps a cache for
+
+#define SW_NUMA_MAX_NODE                 64
+
 #define SW_TABLE_CONFLICT_PROPORTION     0.2 //20%
 #define SW_TABLE_KEY_SIZE                64
 //#define SW_TABLE_USE_PHP_HASH
@@ -220,6 +252,9 @@
 #define SW_SSL_ECDH_CURVE                "secp384r1"
 #define SW_SSL_NPN_ADVERTISE             "\x08http/1.1"
 #define SW_SSL_HTTP2_NPN_ADVERTISE       "\x02h2"
+#define SW_SSL_SESSION_MAX_SIZE          2048  //larger sessions are not put in the shared cache
+#define SW_SSL_SESSION_TIMEOUT           300
+#define SW_SSL_TICKET_KEY_LIFETIME       3600
 
 #define SW_SPINLOCK_LOOP_N               1024
 
@@ -233,6 +268,9 @@
 #define SW_DNS_HOST_BUFFER_SIZE          16
 #define SW_DNS_SERVER_PORT               53
 #define SW_DNS_DEFAULT_SERVER            "8.8.8.8"
+#define SW_DNS_SERVER_TIMEOUT            2000   //ms, then retry the next nameserver
+#define SW_DNS_CACHE_TTL_MAX             300    //seconds
+#define SW_DNS_CACHE_SIZE                1024
 
 //#define SW_HTTP_CLIENT_ENABLE
 
@@ -246,7 +284,12 @@
 #define SW_HTTP_HEADER_KEY_SIZE          128
 #define SW_HTTP_HEADER_VALUE_SIZE        4096
 #define SW_HTTP_HEADER_BUFFER_SIZE       128
+#define SW_HTTP_FAST_PARSE_HEADER_NUM    64
+#define SW_HTTP_STATIC_CACHE_EXPIRE      5      //seconds between stat() of a cached static file
+#define SW_HTTP_STATIC_CACHE_NUM         1024
 #define SW_HTTP_COMPRESS_GZIP
+#define SW_HTTP_COMPRESS_MIN_LENGTH      20     //smaller bodies are sent uncompressed
+#define SW_HTTP_COMPRESS_STREAM_POOL     16     //idle deflate streams kept by each worker
 #define SW_HTTP_UPLOAD_TMPDIR_SIZE       256
 #define SW_HTTP_DATE_FORMAT              "D, d M Y H:i:s T"
 #define SW_HTTP_RFC1123_DATE_GMT         "%a, %d %b %Y %T GMT"
@@ -260,9 +303,13 @@
 #define SW_HTTP2_MAX_FRAME_SIZE          ((1u << 14))
 #define SW_HTTP2_MAX_WINDOW              ((1u << 31) - 1)
 #define SW_HTTP2_DEFAULT_WINDOW          65535
+#define SW_HTTP2_HEADER_TABLE_SIZE       4096
+#define SW_HTTP2_SEND_BUFFER_SIZE        65536  //frames of a connection are flushed together once per event loop
 
 #define SW_HTTP_CLIENT_USERAGENT         "swoole-http-client"
 #define SW_HTTP_CLIENT_BOUNDARY_PREKEY   "----SwooleBoundary"
+#define SW_HTTP_CLIENT_POOL_MAX          32
+#define SW_HTTP_CLIENT_POOL_IDLE_TIMEOUT 60
 #define SW_HTTP_FORM_DATA_FORMAT_STRING  "--%*s\r\nContent-Disposition: form-data; name=\"%*s\"\r\n\r\n"
 #define SW_HTTP_FORM_DATA_FORMAT_FILE    "--%*s\r\nContent-Disposition: form-data; name=\"%*s\"; filename=\"%*s\"\r\nContent-Type: %*s\r\n\r\n"
 
@@ -274,6 +321,8 @@
 #define SW_MYSQL_QUERY_INIT_SIZE         8192
 #define SW_MYSQL_DEFAULT_PORT            3306
 #define SW_MYSQL_CONNECT_TIMEOUT         1.0
+#define SW_MYSQL_POOL_MAX                64
+#define SW_MYSQL_FETCH_BATCH             100
 #define SW_MYSQL_DEFAULT_CHARSET         33  //0x21, utf8_general_ci
 
 #define SW_REDIS_CONNECT_TIMEOUT         1.0
@@ -29,11 +29,31 @@ coro_global COROG;
 static int alloc_cidmap();
 static void free_cidmap(int cid);
 
+static sw_inline void coro_call_hook(enum swGlobal_hook_type type, coro_task *task)
+{
+    if (unlikely(SwooleG.hooks[type] != NULL))
+    {
+        swoole_call_hook(type, &task->cid);
+    }
+}
+
 #if PHP_MAJOR_VERSION >= 7 && PHP_MINOR_VERSION >= 2
 static inline void sw_vm_stack_init(void)
 {
     uint32_t size = COROG.stack_size;
-    zend_vm_stack page = (zend_vm_stack) emalloc(size);
+    zend_vm_stack page = COROG.stack_pool;
+
+    if (page)
+    {
+        COROG.stack_pool = page->prev;
+        COROG.stack_pool_num--;
+        COROG.stack_reused++;
+    }
+    else
+    {
+        page = (zend_vm_stack) emalloc(size);
+        COROG.stack_allocated++;
+    }
 
     page->top = ZEND_VM_STACK_ELEMENTS(page);
     page->end = (zval*) ((char*) page + size);
@@ -44,8 +64,56 @@ static inline void sw_vm_stack_init(void)
     EG(vm_stack_top) = EG(vm_stack)->top;
     EG(vm_stack_end) = EG(vm_stack)->end;
 }
+
+/**
+ * free the pages added by zend_vm_stack_extend, keep the first page in the pool
+ */
+static inline void sw_vm_stack_destroy(void)
+{
+    zend_vm_stack page = EG(vm_stack);
+    zend_vm_stack prev;
+
+    if (page->prev)
+    {
+        COROG.stack_extended++;
+        while (page->prev)
+        {
+            prev = page->prev;
+            efree(page);
+            page = prev;
+        }
+    }
+    if (COROG.stack_pool_num < COROG.stack_pool_max && (char *) page->end - (char *) page == COROG.stack_size)
+    {
+        page->prev = COROG.stack_pool;
+        COROG.stack_pool = page;
+        COROG.stack_pool_num++;
+    }
+    else
+    {
+        efree(page);
+    }
+}
+
+void coro_stack_pool_clear()
+{
+    zend_vm_stack page;
+    while (COROG.stack_pool)
+    {
+        page = COROG.stack_pool;
+        COROG.stack_pool = page->prev;
+        efree(page);
+    }
+    COROG.stack_pool_num = 0;
+}
 #else
 #define sw_vm_stack_init zend_vm_stack_init
+#define sw_vm_stack_destroy() efree(EG(vm_stack))
+
+void coro_stack_pool_clear()
+{
+
+}
 #endif
 
 int coro_init(TSRMLS_D)
@@ -67,6 +135,10 @@ int coro_init(TSRMLS_D)
     {
         COROG.stack_size = DEFAULT_STACK_SIZE;
     }
+    if (COROG.stack_pool_max == 0)
+    {
+        COROG.stack_pool_max = DEFAULT_STACK_POOL_MAX;
+    }
     COROG.require = 0;
     swReactorCheckPoint = emalloc(sizeof(jmp_buf));
     SwooleWG.coro_timeout_list = swLinkedList_new(1, NULL);
@@ -214,6 +286,7 @@ int sw_coro_create(zend_fcall_info_cache *fci_cache, zval **argv, int argc, zval
     COROG.current_coro->post_callback = post_callback;
     COROG.current_coro->post_callback_params = params;
     COROG.require = 1;
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_CREATE, COROG.current_coro);
     if (!setjmp(*swReactorCheckPoint))
     {
         zend_execute_ex(execute_data TSRMLS_CC);
@@ -284,6 +357,7 @@ int sw_coro_create(zend_fcall_info_cache *fci_cache, zval **argv, int argc, zval
     COROG.current_coro->post_callback = post_callback;
     COROG.current_coro->post_callback_params = params;
     COROG.require = 1;
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_CREATE, COROG.current_coro);
 
     int coro_status;
     if (!setjmp(*swReactorCheckPoint))
@@ -305,6 +379,7 @@ int sw_coro_create(zend_fcall_info_cache *fci_cache, zval **argv, int argc, zval
 #if PHP_MAJOR_VERSION < 7
 sw_inline void coro_close(TSRMLS_D)
 {
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_CLOSE, COROG.current_coro);
     if (COROG.current_coro->post_callback)
     {
         COROG.current_coro->post_callback(COROG.current_coro->post_callback_params);
@@ -359,13 +434,14 @@ sw_inline void coro_close(TSRMLS_D)
 sw_inline void coro_close(TSRMLS_D)
 {
     swTraceLog(SW_TRACE_COROUTINE, "Close coroutine id %d", COROG.current_coro->cid);
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_CLOSE, COROG.current_coro);
     if (COROG.current_coro->function)
     {
         sw_zval_free(COROG.current_coro->function);
         COROG.current_coro->function = NULL;
     }
     free_cidmap(COROG.current_coro->cid);
-    efree(EG(vm_stack));
+    sw_vm_stack_destroy();
     efree(COROG.allocated_return_value_ptr);
     EG(vm_stack) = COROG.origin_vm_stack;
     EG(vm_stack_top) = COROG.origin_vm_stack_top;
@@ -416,6 +492,7 @@ sw_inline php_context *sw_coro_save(zval *return_value, php_context *sw_current_
 int sw_coro_resume(php_context *sw_current_context, zval *retval, zval **coro_retval)
 {
     TSRMLS_FETCH_FROM_CTX(sw_thread_ctx ? sw_thread_ctx : NULL);
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_RESUME, SWCC(current_task));
     //free unused return value
     zval *saved_return_value = sw_current_context->current_coro_return_value_ptr;
     zend_bool unused = sw_current_context->current_execute_data->opline->result_type & EXT_TYPE_UNUSED;
@@ -472,8 +549,65 @@ int sw_coro_resume(php_context *sw_current_context, zval *retval, zval **coro_re
     return coro_status;
 }
 #else
+/**
+ * When zend_execute_ex is overridden, by a profiler or a debugger, the user
+ * functions called by ZEND_DO_FCALL run in a nested zend_execute_ex, flagged
+ * with ZEND_CALL_TOP, which returns to the C code of the caller. A yield
+ * discards these C frames, so a resumed function returns here instead: the
+ * call is finished the way ZEND_DO_FCALL does it and the caller continues.
+ */
+static void sw_coro_execute(zend_execute_data *execute_data)
+{
+    zend_execute_data *call, *caller;
+
+    while (1)
+    {
+        // zend_execute_ex returns when this frame returns
+        for (call = execute_data; !(ZEND_CALL_INFO(call) & ZEND_CALL_TOP); call = call->prev_execute_data);
+
+        zend_execute_ex(execute_data);
+
+        // the coroutine function returned
+        caller = call->prev_execute_data;
+        if (caller == NULL)
+        {
+            return;
+        }
+        // the C code of internal functions and includes cannot be continued
+        if (!caller->func || !ZEND_USER_CODE(caller->func->type) || caller->opline->opcode != ZEND_DO_FCALL)
+        {
+            swoole_php_fatal_error(E_WARNING, "cannot resume the caller of a coroutine function, it is not called from PHP code.");
+            return;
+        }
+
+        if (ZEND_CALL_INFO(call) & ZEND_CALL_RELEASE_THIS)
+        {
+            zval_ptr_dtor(&(call->This));
+        }
+        zend_vm_stack_free_call_frame(call);
+
+        EG(current_execute_data) = caller;
+        if (unlikely(EG(exception) != NULL))
+        {
+            // rethrow in the caller, as zend_rethrow_exception()
+            if (caller->opline->opcode != ZEND_HANDLE_EXCEPTION)
+            {
+                EG(opline_before_exception) = caller->opline;
+                caller->opline = EG(exception_op);
+            }
+        }
+        else
+        {
+            caller->opline++;
+        }
+        execute_data = caller;
+    }
+}
+
 int sw_coro_resume(php_context *sw_current_context, zval *retval, zval *coro_retval)
 {
+    coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_RESUME, SWCC(current_task));
+
     EG(vm_stack) = SWCC(current_vm_stack);
     EG(vm_stack_top) = SWCC(current_vm_stack_top);
     EG(vm_stack_end) = SWCC(current_vm_stack_end);
@@ -503,7 +637,7 @@ int sw_coro_resume(php_context *sw_current_context, zval *retval, zval *coro_ret
     if (!setjmp(*swReactorCheckPoint))
     {
         //coro exit
-        zend_execute_ex(EG(current_execute_data) TSRMLS_CC);
+        sw_coro_execute(EG(current_execute_data));
         coro_close(TSRMLS_C);
         coro_status = CORO_END;
     }
@@ -538,6 +672,10 @@ int sw_coro_resume_parent(php_context *sw_current_context, zval *retval, zval *c
 void coro_yield()
 {
     SWOOLE_GET_TSRMLS;
+    if (COROG.current_coro)
+    {
+        coro_call_hook(SW_GLOBAL_HOOK_ON_CORO_YIELD, COROG.current_coro);
+    }
 #if PHP_MAJOR_VERSION >= 7
     EG(vm_stack) = COROG.origin_vm_stack;
     EG(vm_stack_top) = COROG.origin_vm_stack_top;
@@ -551,6 +689,7 @@ void coro_yield()
 
 void coro_destroy(TSRMLS_D)
 {
+    coro_stack_pool_clear();
     if (COROG.chan_pipe)
     {
         COROG.chan_pipe->close(COROG.chan_pipe);
@@ -570,11 +709,12 @@ void coro_handle_timeout()
     swTimer_node *tnode = NULL;
     if (timeout_list != NULL && timeout_list->num > 0)
     {
-        php_context *cxt = (php_context *) swLinkedList_pop(timeout_list);
+        //resume in the order of notification, channel waiters rely on it
+        php_context *cxt = (php_context *) swLinkedList_shift(timeout_list);
         while (cxt != NULL)
         {
             cxt->onTimeout(cxt);
-            cxt = (php_context *) swLinkedList_pop(timeout_list);
+            cxt = (php_context *) swLinkedList_shift(timeout_list);
         }
     }
 
@@ -26,6 +26,7 @@
 
 #define DEFAULT_MAX_CORO_NUM 3000
 #define DEFAULT_STACK_SIZE   8192
+#define DEFAULT_STACK_POOL_MAX 128
 #define MAX_CORO_NUM_LIMIT   0x80000
 
 #define CORO_END 0
@@ -83,6 +84,18 @@ typedef struct _coro_global
     uint32_t coro_num;
     uint32_t max_coro_num;
     uint32_t stack_size;
+    /**
+     * vm stacks of finished coroutines, kept for the next one
+     */
+    zend_vm_stack stack_pool;
+    uint32_t stack_pool_num;
+    uint32_t stack_pool_max;
+    /**
+     * stack metrics, stack_extended counts the coroutines which outgrew stack_size
+     */
+    uint64_t stack_allocated;
+    uint64_t stack_reused;
+    uint64_t stack_extended;
     zend_vm_stack origin_vm_stack;
 #if PHP_MAJOR_VERSION >= 7
     zval *origin_vm_stack_top;
@@ -152,6 +165,7 @@ int sw_coro_resume(php_context *sw_current_context, zval *retval, zval **coro_re
 
 void coro_check(TSRMLS_D);
 void coro_close(TSRMLS_D);
+void coro_stack_pool_clear();
 int php_swoole_add_timer_coro(int ms, int cli_fd, long *timeout_id, void* param, swLinkedList_node **node TSRMLS_DC);
 int php_swoole_clear_timer_coro(long id TSRMLS_DC);
 
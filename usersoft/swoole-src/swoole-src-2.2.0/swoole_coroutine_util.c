@@ -101,6 +101,7 @@ static PHP_METHOD(swoole_coroutine_util, suspend);
 static PHP_METHOD(swoole_coroutine_util, cli_wait);
 static PHP_METHOD(swoole_coroutine_util, resume);
 static PHP_METHOD(swoole_coroutine_util, getuid);
+static PHP_METHOD(swoole_coroutine_util, stats);
 static PHP_METHOD(swoole_coroutine_util, sleep);
 static PHP_METHOD(swoole_coroutine_util, fread);
 static PHP_METHOD(swoole_coroutine_util, fgets);
@@ -126,6 +127,7 @@ static const zend_function_entry swoole_coroutine_util_methods[] =
     PHP_ME(swoole_coroutine_util, suspend, arginfo_swoole_coroutine_suspend, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(swoole_coroutine_util, resume, arginfo_swoole_coroutine_resume, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(swoole_coroutine_util, getuid, arginfo_swoole_coroutine_void, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(swoole_coroutine_util, stats, arginfo_swoole_coroutine_void, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(swoole_coroutine_util, sleep, arginfo_swoole_coroutine_sleep, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(swoole_coroutine_util, fread, arginfo_swoole_coroutine_fread, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(swoole_coroutine_util, fgets, arginfo_swoole_coroutine_fgets, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -624,8 +626,22 @@ static PHP_METHOD(swoole_coroutine_util, set)
     if (php_swoole_array_get_value(vht, "stack_size", v))
     {
         convert_to_long(v);
+        if (COROG.stack_size != (uint32_t) Z_LVAL_P(v))
+        {
+            //pooled stacks have the old size
+            coro_stack_pool_clear();
+        }
         COROG.stack_size = (uint32_t) Z_LVAL_P(v);
     }
+    if (php_swoole_array_get_value(vht, "stack_pool_max", v))
+    {
+        convert_to_long(v);
+        COROG.stack_pool_max = Z_LVAL_P(v) < 0 ? 0 : (uint32_t) Z_LVAL_P(v);
+        if (COROG.stack_pool_num > COROG.stack_pool_max)
+        {
+            coro_stack_pool_clear();
+        }
+    }
     if (php_swoole_array_get_value(vht, "log_level", v))
     {
         convert_to_long(v);
@@ -770,6 +786,18 @@ static PHP_METHOD(swoole_coroutine_util, getuid)
     RETURN_LONG(COROG.current_coro->cid);
 }
 
+static PHP_METHOD(swoole_coroutine_util, stats)
+{
+    array_init(return_value);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("coroutine_num"), COROG.coro_num);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_size"), COROG.stack_size);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_pool_num"), COROG.stack_pool_num);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_pool_max"), COROG.stack_pool_max);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_allocated"), COROG.stack_allocated);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_reused"), COROG.stack_reused);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("stack_extended"), COROG.stack_extended);
+}
+
 static void php_coroutine_sleep_timeout(swTimer *timer, swTimer_node *tnode)
 {
     zval *retval = NULL;
@@ -1028,12 +1056,7 @@ static PHP_METHOD(swoole_coroutine_util, fread)
     ev.fd = fd;
     ev.offset = _seek;
 
-    if (!SwooleAIO.init)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        php_swoole_check_reactor();
-        swAio_init();
-    }
+    php_swoole_check_aio();
 
     swTrace("fd=%d, offset=%ld, length=%ld", fd, ev.offset, ev.nbytes);
 
@@ -1098,12 +1121,7 @@ static PHP_METHOD(swoole_coroutine_util, fgets)
     ev.offset = stream->readpos;
     ev.req = (void *) (long) stream->writepos;
 
-    if (!SwooleAIO.init)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        php_swoole_check_reactor();
-        swAio_init();
-    }
+    php_swoole_check_aio();
 
     swTrace("fd=%d, offset=%ld, length=%ld", fd, ev.offset, ev.nbytes);
 
@@ -1173,11 +1191,6 @@ static PHP_METHOD(swoole_coroutine_util, fwrite)
     ev.fd = fd;
     ev.offset = _seek;
 
-    if (SwooleAIO.mode == SW_AIO_LINUX)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        SwooleAIO.init = 0;
-    }
     php_swoole_check_aio();
 
     swTrace("fd=%d, offset=%ld, length=%ld", fd, ev.offset, ev.nbytes);
@@ -1224,12 +1237,7 @@ static PHP_METHOD(swoole_coroutine_util, readFile)
     ev.callback = aio_onReadFileCompleted;
     ev.req = estrndup(filename, l_filename);
 
-    if (!SwooleAIO.init)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        php_swoole_check_reactor();
-        swAio_init();
-    }
+    php_swoole_check_aio();
 
     swTrace("readFile(%s)", filename);
 
@@ -1294,12 +1302,7 @@ static PHP_METHOD(swoole_coroutine_util, writeFile)
         ev.flags |= O_TRUNC;
     }
 
-    if (!SwooleAIO.init)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        php_swoole_check_reactor();
-        swAio_init();
-    }
+    php_swoole_check_aio();
 
     swTrace("writeFile(%s, %ld)", filename, ev.nbytes);
 
@@ -1460,11 +1463,6 @@ static PHP_METHOD(swoole_coroutine_util, gethostbyname)
     ev.object = sw_current_context;
     ev.callback = coro_dns_onResolveCompleted;
 
-    if (SwooleAIO.mode == SW_AIO_LINUX)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        SwooleAIO.init = 0;
-    }
     php_swoole_check_aio();
 
     if (swAio_dispatch(&ev) < 0)
@@ -1539,11 +1537,6 @@ static PHP_METHOD(swoole_coroutine_util, getaddrinfo)
         req->result = ecalloc(SW_DNS_HOST_BUFFER_SIZE, sizeof(struct sockaddr_in6));
     }
 
-    if (SwooleAIO.mode == SW_AIO_LINUX)
-    {
-        SwooleAIO.mode = SW_AIO_BASE;
-        SwooleAIO.init = 0;
-    }
     php_swoole_check_aio();
 
     if (swAio_dispatch(&ev) < 0)
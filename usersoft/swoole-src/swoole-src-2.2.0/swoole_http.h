@@ -105,6 +105,15 @@ typedef struct
     uint32_t request_read :1;
     uint32_t current_header_name_allocated :1;
     uint32_t content_sender_initialized :1;
+    uint32_t accept_brotli :1;
+    uint32_t compress_brotli :1;
+
+#ifdef SW_HAVE_ZLIB
+    /**
+     * deflate stream of a chunked response, kept between write() calls
+     */
+    struct _http_zstream *zstream;
+#endif
 
 #ifdef SW_USE_HTTP2
     uint8_t priority;
@@ -137,10 +146,15 @@ typedef struct _swoole_http_client
 #ifdef SW_USE_HTTP2
     uint32_t init :1;
     swHashMap *streams;
-    nghttp2_hd_inflater *deflater;
+    nghttp2_hd_deflater *deflater;
     nghttp2_hd_inflater *inflater;
     uint32_t window_size;
     uint32_t remote_window_size;
+    /**
+     * frames waiting for the deferred flush at the end of the event loop
+     */
+    swString *send_buffer;
+    uint32_t send_deferred :1;
 #endif
 
 } swoole_http_client;
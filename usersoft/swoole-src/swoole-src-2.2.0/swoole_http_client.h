@@ -94,6 +94,11 @@ typedef struct
      * for websocket
      */
     swLinkedList *message_queue;
+    /**
+     * idle keep-alive connections kept per host, 0 to disable the pool
+     */
+    uint32_t pool_max;
+    uint32_t pool_idle_timeout;
 #endif
 
 } http_client_property;
@@ -31,6 +31,17 @@ enum http_client_property
 
 static swString *http_client_buffer;
 
+typedef struct
+{
+    swClient *cli;
+    time_t expire;
+} http_client_coro_idle;
+
+/**
+ * idle keep-alive connections of this worker, host:port:ssl => swLinkedList, the most recently used at the tail
+ */
+static swHashMap *http_client_coro_pool;
+
 static void http_client_coro_onReceive(swClient *cli, char *data, uint32_t length);
 static void http_client_coro_onConnect(swClient *cli);
 static void http_client_coro_onClose(swClient *cli);
@@ -44,6 +55,9 @@ static int http_client_coro_execute(zval *zobject, char *uri, zend_size_t uri_le
 static void http_client_coro_onTimeout(swTimer *timer, swTimer_node *tnode);
 static void http_client_coro_onSendTimeout(swTimer *timer, swTimer_node *tnode);
 
+static swClient* http_client_coro_pool_get(zval *zobject, http_client *http TSRMLS_DC);
+static int http_client_coro_pool_put(zval *zobject, http_client *http TSRMLS_DC);
+
 static const php_http_parser_settings http_parser_settings =
 {
     NULL,
@@ -284,19 +298,44 @@ static int http_client_coro_execute(zval *zobject, char *uri, zend_size_t uri_le
         return SW_OK;
     }
 
-    swClient *cli = php_swoole_client_new(zobject, http->host, http->host_len, http->port);
-    if (cli == NULL)
-    {
-        return SW_ERR;
-    }
-    http->cli = cli;
-
     zval *ztmp;
-    HashTable *vht;
+    HashTable *vht = NULL;
     zval *zset = sw_zend_read_property(swoole_http_client_coro_class_entry_ptr, zobject, ZEND_STRL("setting"), 1 TSRMLS_CC);
     if (zset && !ZVAL_IS_NULL(zset))
     {
         vht = Z_ARRVAL_P(zset);
+        if (php_swoole_array_get_value(vht, "pool_max", ztmp))
+        {
+            convert_to_long(ztmp);
+            hcc->pool_max = Z_LVAL_P(ztmp) < 0 ? 0 : (uint32_t) Z_LVAL_P(ztmp);
+        }
+        if (php_swoole_array_get_value(vht, "pool_idle_timeout", ztmp))
+        {
+            convert_to_long(ztmp);
+            hcc->pool_idle_timeout = Z_LVAL_P(ztmp) < 0 ? 0 : (uint32_t) Z_LVAL_P(ztmp);
+        }
+    }
+
+    swClient *cli = NULL;
+    //proxied connections are not pooled
+    if (hcc->pool_max > 0 && (vht == NULL || (!php_swoole_array_get_value(vht, "http_proxy_host", ztmp)
+            && !php_swoole_array_get_value(vht, "socks5_host", ztmp))))
+    {
+        cli = http_client_coro_pool_get(zobject, http TSRMLS_CC);
+    }
+    zend_bool reused = cli != NULL;
+    if (!reused)
+    {
+        cli = php_swoole_client_new(zobject, http->host, http->host_len, http->port);
+        if (cli == NULL)
+        {
+            return SW_ERR;
+        }
+    }
+    http->cli = cli;
+
+    if (vht)
+    {
         /**
          * timeout
          */
@@ -313,8 +352,11 @@ static int http_client_coro_execute(zval *zobject, char *uri, zend_size_t uri_le
             convert_to_boolean(ztmp);
             http->keep_alive = (int) Z_LVAL_P(ztmp);
         }
-        //client settings
-        php_swoole_client_check_setting(http->cli, zset TSRMLS_CC);
+        //client settings, a pooled connection keeps the ones it was created with
+        if (!reused)
+        {
+            php_swoole_client_check_setting(http->cli, zset TSRMLS_CC);
+        }
 
         if (http->cli->http_proxy)
         {
@@ -333,7 +375,7 @@ static int http_client_coro_execute(zval *zobject, char *uri, zend_size_t uri_le
         }
     }
 
-    if (cli->socket->active == 1)
+    if (!reused && cli->socket->active == 1)
     {
         swoole_php_fatal_error(E_WARNING, "swoole_http_client is already connected.");
         return SW_ERR;
@@ -351,11 +393,156 @@ static int http_client_coro_execute(zval *zobject, char *uri, zend_size_t uri_le
     cli->onError = http_client_coro_onError;
     cli->onBufferEmpty = http_client_onBufferEmpty;
 
+    if (reused)
+    {
+        swTraceLog(SW_TRACE_HTTP_CLIENT, "reuse pooled connection, object handle=%d, fd=%d", sw_get_object_handle(zobject), cli->socket->fd);
+        if (cli->reactor->add(cli->reactor, cli->socket->fd, cli->reactor_fdtype | SW_EVENT_READ) < 0)
+        {
+            cli->socket->active = 0;
+            return SW_ERR;
+        }
+        zend_update_property_long(swoole_http_client_coro_class_entry_ptr, zobject, ZEND_STRL("sock"), cli->socket->fd TSRMLS_CC);
+        zend_update_property_bool(swoole_http_client_coro_class_entry_ptr, zobject, ZEND_STRL("connected"), 1 TSRMLS_CC);
+        http_client_coro_send_http_request(zobject TSRMLS_CC);
+        return SW_OK;
+    }
+
     swTraceLog(SW_TRACE_HTTP_CLIENT, "connect to server, object handle=%d, fd=%d", sw_get_object_handle(zobject), cli->socket->fd);
 
     return cli->connect(cli, http->host, http->port, http->timeout, 0);
 }
 
+static int http_client_coro_pool_key(zval *zobject, http_client *http, char *key TSRMLS_DC)
+{
+    zval *ztype = sw_zend_read_property(swoole_http_client_coro_class_entry_ptr, zobject, ZEND_STRL("type"), 0 TSRMLS_CC);
+    int ssl = (Z_LVAL_P(ztype) & SW_SOCK_SSL) ? 1 : 0;
+    return snprintf(key, SW_LONG_CONNECTION_KEY_LEN, "%.*s:%ld:%d", (int) http->host_len, http->host, http->port, ssl);
+}
+
+static void http_client_coro_pool_free(swClient *cli)
+{
+    //no onClose callback, the connection belongs to no object
+    cli->socket->active = 0;
+    swClient_free(cli);
+    sw_free(cli->server_str);
+    efree(cli);
+}
+
+static swClient* http_client_coro_pool_get(zval *zobject, http_client *http TSRMLS_DC)
+{
+    char key[SW_LONG_CONNECTION_KEY_LEN];
+    http_client_coro_idle *idle;
+    swClient *cli;
+    char c;
+    int n;
+
+    if (!http_client_coro_pool)
+    {
+        return NULL;
+    }
+    int key_len = http_client_coro_pool_key(zobject, http, key TSRMLS_CC);
+    swLinkedList *list = swHashMap_find(http_client_coro_pool, key, key_len);
+    if (!list)
+    {
+        return NULL;
+    }
+
+    time_t now = time(NULL);
+    while ((idle = swLinkedList_pop(list)))
+    {
+        cli = idle->cli;
+        if (idle->expire < now)
+        {
+            efree(idle);
+            http_client_coro_pool_free(cli);
+            continue;
+        }
+        efree(idle);
+        //closed by the server or unexpected data while idle
+        n = recv(cli->socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && swConnection_error(errno) != SW_WAIT) || n > 0)
+        {
+            http_client_coro_pool_free(cli);
+            continue;
+        }
+        if (cli->buffer)
+        {
+            swString_clear(cli->buffer);
+        }
+        cli->reuse_count++;
+        return cli;
+    }
+    return NULL;
+}
+
+static int http_client_coro_pool_put(zval *zobject, http_client *http TSRMLS_DC)
+{
+    char key[SW_LONG_CONNECTION_KEY_LEN];
+    swClient *cli = http->cli;
+    http_client_property *hcc = swoole_get_property(zobject, http_client_coro_property_request);
+
+    if (hcc->pool_max == 0 || !http->keep_alive || http->upgrade || http->state != HTTP_CLIENT_STATE_READY
+            || hcc->defer_status == HTTP_CLIENT_STATE_DEFER_WAIT || !cli->socket->active || cli->socket->closed
+            || cli->http_proxy || cli->socks5_proxy || !php_http_should_keep_alive(&http->parser))
+    {
+        return SW_ERR;
+    }
+
+    if (!http_client_coro_pool)
+    {
+        http_client_coro_pool = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, NULL);
+        if (!http_client_coro_pool)
+        {
+            return SW_ERR;
+        }
+    }
+    int key_len = http_client_coro_pool_key(zobject, http, key TSRMLS_CC);
+    swLinkedList *list = swHashMap_find(http_client_coro_pool, key, key_len);
+    if (!list)
+    {
+        list = swLinkedList_new(0, NULL);
+        if (!list || swHashMap_add(http_client_coro_pool, key, key_len, list) < 0)
+        {
+            return SW_ERR;
+        }
+    }
+    //drop the least recently used one
+    while (list->num >= hcc->pool_max)
+    {
+        http_client_coro_idle *oldest = swLinkedList_shift(list);
+        http_client_coro_pool_free(oldest->cli);
+        efree(oldest);
+    }
+
+    http_client_coro_idle *idle = emalloc(sizeof(http_client_coro_idle));
+    idle->cli = cli;
+    idle->expire = time(NULL) + hcc->pool_idle_timeout;
+    if (swLinkedList_append(list, idle) < 0)
+    {
+        efree(idle);
+        return SW_ERR;
+    }
+
+    //detach from the object, the socket is not watched while idle
+    if (!cli->socket->removed)
+    {
+        cli->reactor->del(cli->reactor, cli->socket->fd);
+    }
+    if (cli->timer)
+    {
+        swTimer_del(&SwooleG.timer, cli->timer);
+        cli->timer = NULL;
+    }
+    cli->object = NULL;
+    http->cli = NULL;
+    http_client_free(zobject TSRMLS_CC);
+    swoole_set_object(zobject, NULL);
+    zend_update_property_bool(swoole_http_client_coro_class_entry_ptr, zobject, ZEND_STRL("connected"), 0 TSRMLS_CC);
+
+    swTraceLog(SW_TRACE_HTTP_CLIENT, "put into pool, object handle=%d, fd=%d", sw_get_object_handle(zobject), cli->socket->fd);
+    return SW_OK;
+}
+
 static void http_client_coro_onTimeout(swTimer *timer, swTimer_node *tnode)
 {
 #if PHP_MAJOR_VERSION < 7
@@ -1305,6 +1492,8 @@ static PHP_METHOD(swoole_http_client_coro, __construct)
     hcc = (http_client_property*) emalloc(sizeof(http_client_property));
     bzero(hcc, sizeof(http_client_property));
     hcc->defer_status = HTTP_CLIENT_STATE_DEFER_INIT;
+    hcc->pool_max = SW_HTTP_CLIENT_POOL_MAX;
+    hcc->pool_idle_timeout = SW_HTTP_CLIENT_POOL_IDLE_TIMEOUT;
    // hcc->defer_chunk_status = 0;
     swoole_set_property(getThis(), 0, hcc);
 
@@ -1682,6 +1871,10 @@ static PHP_METHOD(swoole_http_client_coro, close)
         http_client_free(getThis() TSRMLS_CC);
         RETURN_FALSE;
     }
+    if (http_client_coro_pool_put(getThis(), http TSRMLS_CC) == SW_OK)
+    {
+        RETURN_TRUE;
+    }
 
     int ret = SW_OK;
     cli->released = 1;
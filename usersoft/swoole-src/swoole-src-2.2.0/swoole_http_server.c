@@ -44,15 +44,26 @@
 #include "http2.h"
 #endif
 
-#ifdef SW_USE_PICOHTTPPARSER
-#include "thirdparty/picohttpparser/picohttpparser.h"
-#endif
-
 static swArray *http_client_array;
 
 swString *swoole_http_buffer;
 #ifdef SW_HAVE_ZLIB
 swString *swoole_zlib_buffer;
+
+typedef struct _http_zstream
+{
+    z_stream stream;
+    int level;
+} http_zstream;
+
+/**
+ * deflateInit2() allocates ~256KB of state, finished streams are reset and reused by the next response
+ */
+static http_zstream *http_zstream_pool[SW_HTTP_COMPRESS_STREAM_POOL];
+static int http_zstream_pool_num = 0;
+#endif
+#ifdef SW_HAVE_BROTLI
+#include <brotli/encode.h>
 #endif
 swString *swoole_http_form_data_buffer;
 
@@ -96,6 +107,14 @@ static int http_request_on_header_field(php_http_parser *parser, const char *at,
 static int http_request_on_header_value(php_http_parser *parser, const char *at, size_t length);
 static int http_request_on_headers_complete(php_http_parser *parser);
 static int http_request_message_complete(php_http_parser *parser);
+static void http_request_on_content_type(http_context *ctx, const char *at, size_t length TSRMLS_DC);
+
+static sw_inline void http_request_on_accept_encoding(http_context *ctx, const char *at, size_t length)
+{
+#ifdef SW_HAVE_BROTLI
+    ctx->accept_brotli = swoole_strnpos((char *) at, length, SW_STRL("br") - 1) >= 0;
+#endif
+}
 
 static int multipart_body_on_header_field(multipart_parser* p, const char *at, size_t length);
 static int multipart_body_on_header_value(multipart_parser* p, const char *at, size_t length);
@@ -171,77 +190,380 @@ static inline char* http_trim_double_quote(char *ptr, int *len)
     return tmp;
 }
 
-#ifdef SW_USE_PICOHTTPPARSER
-enum flags
+#if PHP_MAJOR_VERSION >= 7
+/**
+ * header, cookie and get of requests taken by the fast path are built from the raw
+ * request on first access, their property slots stay IS_UNDEF until then so that
+ * the VM's cached property fetch falls back to the object handlers
+ */
+enum http_request_lazy_property
 {
-    F_CONNECTION_KEEP_ALIVE = 1 << 1,
-    F_CONNECTION_CLOSE = 1 << 2,
+    HTTP_REQUEST_LAZY_HEADER,
+    HTTP_REQUEST_LAZY_COOKIE,
+    HTTP_REQUEST_LAZY_GET,
 };
 
-static inline long http_fast_parse(php_http_parser *parser, char *data, size_t length)
+typedef struct
 {
-    http_context *ctx = parser->data;
-    const char *method;
-    size_t method_len;
-    int minor_version;
-    struct phr_header headers[64];
-    size_t num_headers = sizeof(headers) / sizeof(headers[0]);
-    const char *path;
-    size_t path_len;
-
-    int n = phr_parse_request(data, length, &method, &method_len, &path, &path_len, &minor_version, headers, &num_headers, 0);
-    if (n < 0)
+    uint32_t header_offset;
+    uint32_t header_length;
+    uint32_t cookie_offset;
+    uint32_t cookie_length;
+    uint32_t query_offset;
+    uint32_t query_length;
+    uint8_t header :1;
+    uint8_t cookie :1;
+    uint8_t get :1;
+} http_request_lazy;
+
+static zend_object_handlers swoole_http_request_handlers;
+static uint32_t http_request_lazy_property_offset[3];
+
+static void http_request_lazy_build(zval *zobject, http_request_lazy *lazy, int type)
+{
+    zval *zdata = swoole_get_property(zobject, 0);
+    zval *zproperty = OBJ_PROP(Z_OBJ_P(zobject), http_request_lazy_property_offset[type]);
+
+    if (zdata == NULL)
+    {
+        lazy->header = lazy->cookie = lazy->get = 0;
+        if (Z_TYPE_P(zproperty) == IS_UNDEF)
+        {
+            ZVAL_NULL(zproperty);
+        }
+        return;
+    }
+    char *data = Z_STRVAL_P(zdata);
+
+    switch (type)
+    {
+    case HTTP_REQUEST_LAZY_HEADER:
+    {
+        lazy->header = 0;
+        if (Z_TYPE_P(zproperty) != IS_UNDEF)
+        {
+            return;
+        }
+        array_init(zproperty);
+
+        char *p = data + lazy->header_offset;
+        char *pe = p + lazy->header_length;
+        char *eol, *colon, *value, *value_end;
+        while (p < pe)
+        {
+            eol = memchr(p, '\r', pe - p);
+            colon = memchr(p, ':', eol - p);
+            if (swHttp_get_header_id(p, colon - p) != SW_HTTP_HEADER_COOKIE)
+            {
+                value = colon + 1;
+                while (value < eol && (*value == ' ' || *value == '\t'))
+                {
+                    value++;
+                }
+                value_end = eol;
+                while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+                {
+                    value_end--;
+                }
+                char *header_name = zend_str_tolower_dup(p, colon - p);
+                sw_add_assoc_stringl_ex(zproperty, header_name, colon - p + 1, value, value_end - value, 1);
+                efree(header_name);
+            }
+            p = eol + 2;
+        }
+        break;
+    }
+    case HTTP_REQUEST_LAZY_COOKIE:
+        lazy->cookie = 0;
+        if (Z_TYPE_P(zproperty) != IS_UNDEF)
+        {
+            return;
+        }
+        if (lazy->cookie_length >= SW_HTTP_COOKIE_VALLEN)
+        {
+            swWarn("cookie is too large.");
+            ZVAL_NULL(zproperty);
+            return;
+        }
+        array_init(zproperty);
+        http_parse_cookie(zproperty, data + lazy->cookie_offset, lazy->cookie_length);
+        break;
+    case HTTP_REQUEST_LAZY_GET:
+        lazy->get = 0;
+        if (Z_TYPE_P(zproperty) != IS_UNDEF)
+        {
+            return;
+        }
+        array_init(zproperty);
+        //no need free, will free by treat_data
+        sapi_module.treat_data(PARSE_STRING, estrndup(data + lazy->query_offset, lazy->query_length), zproperty);
+        break;
+    default:
+        break;
+    }
+}
+
+static sw_inline void http_request_lazy_fetch(zval *zobject, zval *member)
+{
+    http_request_lazy *lazy = swoole_get_property(zobject, 1);
+    if (!lazy || !(lazy->header || lazy->cookie || lazy->get) || Z_TYPE_P(member) != IS_STRING)
+    {
+        return;
+    }
+    if (lazy->header && zend_string_equals_literal(Z_STR_P(member), "header"))
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_HEADER);
+    }
+    else if (lazy->cookie && zend_string_equals_literal(Z_STR_P(member), "cookie"))
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_COOKIE);
+    }
+    else if (lazy->get && zend_string_equals_literal(Z_STR_P(member), "get"))
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_GET);
+    }
+}
+
+static void http_request_lazy_fetch_all(zval *zobject)
+{
+    http_request_lazy *lazy = swoole_get_property(zobject, 1);
+    if (!lazy)
+    {
+        return;
+    }
+    if (lazy->header)
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_HEADER);
+    }
+    if (lazy->cookie)
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_COOKIE);
+    }
+    if (lazy->get)
+    {
+        http_request_lazy_build(zobject, lazy, HTTP_REQUEST_LAZY_GET);
+    }
+}
+
+static zval* swoole_http_request_read_property(zval *object, zval *member, int type, void **cache_slot, zval *rv)
+{
+    http_request_lazy_fetch(object, member);
+    return zend_get_std_object_handlers()->read_property(object, member, type, cache_slot, rv);
+}
+
+static zval* swoole_http_request_get_property_ptr_ptr(zval *object, zval *member, int type, void **cache_slot)
+{
+    http_request_lazy_fetch(object, member);
+    return zend_get_std_object_handlers()->get_property_ptr_ptr(object, member, type, cache_slot);
+}
+
+static int swoole_http_request_has_property(zval *object, zval *member, int has_set_exists, void **cache_slot)
+{
+    http_request_lazy_fetch(object, member);
+    return zend_get_std_object_handlers()->has_property(object, member, has_set_exists, cache_slot);
+}
+
+static HashTable* swoole_http_request_get_properties(zval *object)
+{
+    http_request_lazy_fetch_all(object);
+    return zend_get_std_object_handlers()->get_properties(object);
+}
+
+/**
+ * the collector must not build the lazy arrays, walk the property slots as they are
+ */
+static HashTable* swoole_http_request_get_gc(zval *object, zval **table, int *n)
+{
+    zend_object *zobj = Z_OBJ_P(object);
+    if (zobj->properties)
+    {
+        *table = NULL;
+        *n = 0;
+        if (UNEXPECTED(GC_REFCOUNT(zobj->properties) > 1) && EXPECTED(!(GC_FLAGS(zobj->properties) & IS_ARRAY_IMMUTABLE)))
+        {
+            GC_REFCOUNT(zobj->properties)--;
+            zobj->properties = zend_array_dup(zobj->properties);
+        }
+        return zobj->properties;
+    }
+    *table = zobj->properties_table;
+    *n = zobj->ce->default_properties_count;
+    return NULL;
+}
+
+static zend_object* swoole_http_request_clone_obj(zval *object)
+{
+    http_request_lazy_fetch_all(object);
+    return zend_get_std_object_handlers()->clone_obj(object);
+}
+#endif
+
+/**
+ * same bits as the flags of php_http_parser.c, read by php_http_should_keep_alive()
+ */
+#define HTTP_F_CONNECTION_KEEP_ALIVE   (1 << 1)
+#define HTTP_F_CONNECTION_CLOSE        (1 << 2)
+
+/**
+ * Fast path for plain requests: the head is split by swHttpRequest_parse_head() and
+ * fed to the same callbacks php_http_parser would call.
+ * Returns SW_ERR before any callback ran when the request needs the full parser
+ * (chunked body, upgrade, absolute uri, fragment, folded headers ...).
+ */
+static long http_fast_parse(php_http_parser *parser, char *data, size_t length)
+{
+    swHttpRequestHead head;
+    size_t content_length = 0;
+    int i;
+
+    long n = swHttpRequest_parse_head(data, length, &head);
+    if (n < 0 || memchr(head.path, '#', head.path_len))
     {
         return SW_ERR;
     }
 
-    char *p = memchr(path, '?', path_len);
+    parser->flags = 0;
+    for (i = 0; i < head.num_headers; i++)
+    {
+        swHttpHeader *header = &head.headers[i];
+        switch (header->id)
+        {
+        case SW_HTTP_HEADER_UPGRADE:
+        case SW_HTTP_HEADER_TRANSFER_ENCODING:
+            return SW_ERR;
+        case SW_HTTP_HEADER_CONTENT_LENGTH:
+        {
+            int j;
+            if (header->value_len == 0 || header->value_len > 10)
+            {
+                return SW_ERR;
+            }
+            content_length = 0;
+            for (j = 0; j < header->value_len; j++)
+            {
+                if (header->value[j] < '0' || header->value[j] > '9')
+                {
+                    return SW_ERR;
+                }
+                content_length = content_length * 10 + (header->value[j] - '0');
+            }
+            break;
+        }
+        case SW_HTTP_HEADER_CONNECTION:
+            if (header->value_len == sizeof("keep-alive") - 1 && strncasecmp(header->value, "keep-alive", header->value_len) == 0)
+            {
+                parser->flags |= HTTP_F_CONNECTION_KEEP_ALIVE;
+            }
+            else if (header->value_len == sizeof("close") - 1 && strncasecmp(header->value, "close", header->value_len) == 0)
+            {
+                parser->flags |= HTTP_F_CONNECTION_CLOSE;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    //swHttpMethod starts at 1, php_http_method at 0
+    parser->method = head.method - 1;
+    parser->http_major = 1;
+    parser->http_minor = head.minor_version;
+
+    char *p = memchr(head.path, '?', head.path_len);
+#if PHP_MAJOR_VERSION >= 7
+    http_context *ctx = parser->data;
+    http_request_lazy *lazy = ecalloc(1, sizeof(http_request_lazy));
+    zend_object *zobj = Z_OBJ_P(ctx->request.zobject);
+
     if (p)
     {
-        http_request_on_path(parser, path, p - path);
-        http_request_on_query_string(parser, p + 1, path + path_len - p - 1);
+        http_request_on_path(parser, head.path, p - head.path);
+        lazy->query_offset = p + 1 - data;
+        lazy->query_length = head.path + head.path_len - p - 1;
+        sw_add_assoc_stringl_ex(ctx->request.zserver, ZEND_STRS("query_string"), p + 1, lazy->query_length, 1);
+        lazy->get = 1;
+        ZVAL_UNDEF(OBJ_PROP(zobj, http_request_lazy_property_offset[HTTP_REQUEST_LAZY_GET]));
     }
     else
     {
-        http_request_on_path(parser, path, path_len);
+        http_request_on_path(parser, head.path, head.path_len);
     }
 
-    int i;
-    for (i = 0; i < num_headers; i++)
+    for (i = 0; i < head.num_headers; i++)
     {
-        if (strncasecmp(headers[i].name, "Connection", headers[i].name_len) == 0
-                && strncasecmp(headers[i].value, "keep-alive", headers[i].value_len) == 0)
+        if (head.headers[i].id == SW_HTTP_HEADER_CONTENT_TYPE)
         {
-            parser->flags |= F_CONNECTION_KEEP_ALIVE;
+            http_request_on_content_type(ctx, head.headers[i].value, head.headers[i].value_len);
         }
-        else
+        else if (head.headers[i].id == SW_HTTP_HEADER_ACCEPT_ENCODING)
         {
-            parser->flags |= F_CONNECTION_CLOSE;
+            http_request_on_accept_encoding(ctx, head.headers[i].value, head.headers[i].value_len);
         }
-        if (http_request_on_header_field(parser, headers[i].name, headers[i].name_len) < 0)
+        else if (head.headers[i].id == SW_HTTP_HEADER_COOKIE)
         {
-            return SW_ERR;
+            lazy->cookie_offset = head.headers[i].value - data;
+            lazy->cookie_length = head.headers[i].value_len;
+            if (!lazy->cookie)
+            {
+                lazy->cookie = 1;
+                ZVAL_UNDEF(OBJ_PROP(zobj, http_request_lazy_property_offset[HTTP_REQUEST_LAZY_COOKIE]));
+            }
         }
-        if (http_request_on_header_value(parser, headers[i].value, headers[i].value_len) < 0)
+    }
+    if (head.num_headers > 0)
+    {
+        lazy->header_offset = head.headers[0].name - data;
+        lazy->header_length = n - 2 - lazy->header_offset;
+    }
+    //the empty array of swoole_http_context_new() is rebuilt on first access
+    zval *zheader = OBJ_PROP(zobj, http_request_lazy_property_offset[HTTP_REQUEST_LAZY_HEADER]);
+    zval_ptr_dtor(zheader);
+    ZVAL_UNDEF(zheader);
+    ctx->request.zheader = NULL;
+    lazy->header = 1;
+    swoole_set_property(ctx->request.zobject, 1, lazy);
+#else
+    if (p)
+    {
+        http_request_on_path(parser, head.path, p - head.path);
+        http_request_on_query_string(parser, p + 1, head.path + head.path_len - p - 1);
+    }
+    else
+    {
+        http_request_on_path(parser, head.path, head.path_len);
+    }
+
+    for (i = 0; i < head.num_headers; i++)
+    {
+        http_request_on_header_field(parser, head.headers[i].name, head.headers[i].name_len);
+        if (http_request_on_header_value(parser, head.headers[i].value, head.headers[i].value_len) < 0)
         {
-            return SW_ERR;
+            return n;
         }
     }
-    parser->method = swHttp_get_method(method, method_len) - 1;
-    parser->http_major = 1;
-    parser->http_minor = minor_version;
-    ctx->request.version = 100 + minor_version;
-    if (n < length)
+#endif
+    http_request_on_headers_complete(parser);
+
+    size_t to_read = MIN(length - n, content_length);
+    if (to_read > 0)
     {
-        http_request_on_body(parser, data + n, length - n);
+        http_request_on_body(parser, data + n, to_read);
     }
-    http_request_on_headers_complete(parser);
-    return SW_OK;
+    if (to_read == content_length)
+    {
+        http_request_message_complete(parser);
+    }
+    return n + to_read;
 }
-#endif
 
 #ifdef SW_HAVE_ZLIB
 static int http_response_compress(swString *body, int level);
+static int http_response_compress_stream(http_zstream *zs, char *data, size_t length, int flush);
+static http_zstream* http_zstream_get(int level);
+static void http_zstream_release(http_zstream *zs);
+#ifdef SW_HAVE_BROTLI
+static int http_response_compress_brotli(swString *body, int level);
+#endif
 voidpf php_zlib_alloc(voidpf opaque, uInt items, uInt size);
 void php_zlib_free(voidpf opaque, voidpf address);
 #endif
@@ -611,19 +933,59 @@ static void http_parse_cookie(zval *array, const char *at, size_t length)
     }
 }
 
+static void http_request_on_content_type(http_context *ctx, const char *at, size_t length TSRMLS_DC)
+{
+    int method = ctx->parser.method;
+    if (method != PHP_HTTP_POST && method != PHP_HTTP_PUT && method != PHP_HTTP_DELETE && method != PHP_HTTP_PATCH)
+    {
+        return;
+    }
+    if (http_strncasecmp("application/x-www-form-urlencoded", at, length))
+    {
+        ctx->request.post_form_urlencoded = 1;
+    }
+    else if (http_strncasecmp("multipart/form-data", at, length))
+    {
+        size_t offset = sizeof("multipart/form-data;") - 1;
+
+        while (at[offset] == ' ')
+        {
+            offset += 1;
+        }
+
+        offset += sizeof("boundary=") - 1;
+
+        int boundary_len = length - offset;
+        char *boundary_str = (char *) at + length - boundary_len;
+
+        if (boundary_len <= 0)
+        {
+            swWarn("invalid multipart/form-data body.", ctx->fd);
+            return;
+        }
+        if (boundary_len >= 2 && boundary_str[0] == '"' && *(boundary_str + boundary_len - 1) == '"')
+        {
+            boundary_str++;
+            boundary_len -= 2;
+        }
+
+        swoole_http_parse_form_data(ctx, boundary_str, boundary_len TSRMLS_CC);
+    }
+}
+
 static int http_request_on_header_value(php_http_parser *parser, const char *at, size_t length)
 {
 #if PHP_MAJOR_VERSION < 7
     TSRMLS_FETCH_FROM_CTX(sw_thread_ctx ? sw_thread_ctx : NULL);
 #endif
 
-    size_t offset = 0;
     http_context *ctx = parser->data;
     zval *zrequest_object = ctx->request.zobject;
     size_t header_len = ctx->current_header_name_len;
     char *header_name = zend_str_tolower_dup(ctx->current_header_name, header_len);
+    int header_id = swHttp_get_header_id(header_name, header_len);
 
-    if (strncmp(header_name, "cookie", header_len) == 0)
+    if (header_id == SW_HTTP_HEADER_COOKIE)
     {
         zval *zcookie;
         if (length >= SW_HTTP_COOKIE_VALLEN)
@@ -637,7 +999,7 @@ static int http_request_on_header_value(php_http_parser *parser, const char *at,
         }
         goto free_memory;
     }
-    else if (SwooleG.serv->listen_list->open_websocket_protocol && strncmp(header_name, "upgrade", header_len) == 0 && strncasecmp(at, "websocket", length) == 0)
+    else if (header_id == SW_HTTP_HEADER_UPGRADE && SwooleG.serv->listen_list->open_websocket_protocol && strncasecmp(at, "websocket", length) == 0)
     {
         swConnection *conn = swWorker_get_connection(SwooleG.serv, ctx->fd);
         if (!conn)
@@ -647,42 +1009,13 @@ static int http_request_on_header_value(php_http_parser *parser, const char *at,
         }
         conn->websocket_status = WEBSOCKET_STATUS_CONNECTION;
     }
-    else if (parser->method == PHP_HTTP_POST || parser->method == PHP_HTTP_PUT || parser->method == PHP_HTTP_DELETE || parser->method == PHP_HTTP_PATCH)
+    else if (header_id == SW_HTTP_HEADER_CONTENT_TYPE)
     {
-        if (strncmp(header_name, "content-type", header_len) == 0)
-        {
-            if (http_strncasecmp("application/x-www-form-urlencoded", at, length))
-            {
-                ctx->request.post_form_urlencoded = 1;
-            }
-            else if (http_strncasecmp("multipart/form-data", at, length))
-            {
-                offset = sizeof("multipart/form-data;") - 1;
-
-                while (at[offset] == ' ')
-                {
-                    offset += 1;
-                }
-
-                offset += sizeof("boundary=") - 1;
-
-                int boundary_len = length - offset;
-                char *boundary_str = (char *) at + length - boundary_len;
-
-                if (boundary_len <= 0)
-                {
-                    swWarn("invalid multipart/form-data body.", ctx->fd);
-                    return 0;
-                }
-                if (boundary_len >= 2 && boundary_str[0] == '"' && *(boundary_str + boundary_len - 1) == '"')
-                {
-                    boundary_str++;
-                    boundary_len -= 2;
-                }
-
-                swoole_http_parse_form_data(ctx, boundary_str, boundary_len TSRMLS_CC);
-            }
-        }
+        http_request_on_content_type(ctx, at, length TSRMLS_CC);
+    }
+    else if (header_id == SW_HTTP_HEADER_ACCEPT_ENCODING)
+    {
+        http_request_on_accept_encoding(ctx, at, length);
     }
 
     zval *header = ctx->request.zheader;
@@ -1101,12 +1434,12 @@ static int http_onReceive(swServer *serv, swEventData *req)
 
     swTrace("httpRequest %d bytes:\n---------------------------------------\n%s\n", (int)Z_STRLEN_P(zdata), Z_STRVAL_P(zdata));
 
-#ifdef SW_USE_PICOHTTPPARSER
-    long n = http_fast_parse(parser, Z_STRVAL_P(zdata), Z_STRLEN_P(zdata));
-#else
     php_http_parser_init(parser, PHP_HTTP_REQUEST);
-    long n = php_http_parser_execute(parser, &http_parser_settings, Z_STRVAL_P(zdata), Z_STRLEN_P(zdata));
-#endif
+    long n = http_fast_parse(parser, Z_STRVAL_P(zdata), Z_STRLEN_P(zdata));
+    if (n < 0)
+    {
+        n = php_http_parser_execute(parser, &http_parser_settings, Z_STRVAL_P(zdata), Z_STRLEN_P(zdata));
+    }
 
     if (n < 0)
     {
@@ -1322,6 +1655,24 @@ void swoole_http_server_init(int module_number TSRMLS_DC)
     zend_declare_property_null(swoole_http_request_class_entry_ptr, SW_STRL("files")-1, ZEND_ACC_PUBLIC TSRMLS_CC);
     zend_declare_property_null(swoole_http_request_class_entry_ptr, SW_STRL("post")-1, ZEND_ACC_PUBLIC TSRMLS_CC);
     zend_declare_property_null(swoole_http_request_class_entry_ptr, SW_STRL("tmpfiles")-1, ZEND_ACC_PUBLIC TSRMLS_CC);
+
+#if PHP_MAJOR_VERSION >= 7
+    memcpy(&swoole_http_request_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    swoole_http_request_handlers.read_property = swoole_http_request_read_property;
+    swoole_http_request_handlers.get_property_ptr_ptr = swoole_http_request_get_property_ptr_ptr;
+    swoole_http_request_handlers.has_property = swoole_http_request_has_property;
+    swoole_http_request_handlers.get_properties = swoole_http_request_get_properties;
+    swoole_http_request_handlers.clone_obj = swoole_http_request_clone_obj;
+    swoole_http_request_handlers.get_gc = swoole_http_request_get_gc;
+
+    zend_property_info *property_info;
+    property_info = zend_hash_str_find_ptr(&swoole_http_request_class_entry_ptr->properties_info, ZEND_STRL("header"));
+    http_request_lazy_property_offset[HTTP_REQUEST_LAZY_HEADER] = property_info->offset;
+    property_info = zend_hash_str_find_ptr(&swoole_http_request_class_entry_ptr->properties_info, ZEND_STRL("cookie"));
+    http_request_lazy_property_offset[HTTP_REQUEST_LAZY_COOKIE] = property_info->offset;
+    property_info = zend_hash_str_find_ptr(&swoole_http_request_class_entry_ptr->properties_info, ZEND_STRL("get"));
+    http_request_lazy_property_offset[HTTP_REQUEST_LAZY_GET] = property_info->offset;
+#endif
 }
 
 static PHP_METHOD(swoole_http_server, on)
@@ -1411,6 +1762,9 @@ http_context* swoole_http_context_new(swoole_http_client* client TSRMLS_DC)
 #endif
     ctx->request.zobject = zrequest_object;
     object_init_ex(zrequest_object, swoole_http_request_class_entry_ptr);
+#if PHP_MAJOR_VERSION >= 7
+    Z_OBJ_P(zrequest_object)->handlers = &swoole_http_request_handlers;
+#endif
     swoole_set_object(zrequest_object, ctx);
 
     zval *zresponse_object;
@@ -1446,6 +1800,12 @@ http_context* swoole_http_context_new(swoole_http_client* client TSRMLS_DC)
 void swoole_http_context_free(http_context *ctx TSRMLS_DC)
 {
     swoole_set_object(ctx->response.zobject, NULL);
+#ifdef SW_HAVE_ZLIB
+    if (ctx->zstream)
+    {
+        http_zstream_release(ctx->zstream);
+    }
+#endif
     http_request *req = &ctx->request;
     if (req->path)
     {
@@ -1758,6 +2118,14 @@ static PHP_METHOD(swoole_http_request, __destruct)
         sw_zval_free(zdata);
         swoole_set_property(getThis(), 0, NULL);
     }
+#if PHP_MAJOR_VERSION >= 7
+    http_request_lazy *lazy = swoole_get_property(getThis(), 1);
+    if (lazy)
+    {
+        efree(lazy);
+        swoole_set_property(getThis(), 1, NULL);
+    }
+#endif
     swoole_set_object(getThis(), NULL);
 }
 
@@ -1819,7 +2187,15 @@ static PHP_METHOD(swoole_http_response, write)
 #ifdef SW_HAVE_ZLIB
     if (ctx->gzip_enable)
     {
-        http_response_compress(&http_body, ctx->gzip_level);
+        //one deflate stream for the whole response, every chunk ends on a sync flush point
+        if (!ctx->zstream)
+        {
+            ctx->zstream = http_zstream_get(ctx->gzip_level);
+        }
+        if (!ctx->zstream || http_response_compress_stream(ctx->zstream, http_body.str, http_body.length, Z_SYNC_FLUSH) < 0)
+        {
+            RETURN_FALSE;
+        }
 
         hex_string = swoole_dec2hex(swoole_zlib_buffer->length, 16);
         hex_len = strlen(hex_string);
@@ -1881,19 +2257,46 @@ static http_context* http_get_context(zval *object, int check_end TSRMLS_DC)
     return ctx;
 }
 
+/**
+ * "Date: ...\r\n" only changes once a second, SwooleGS->now is advanced by the master timer
+ */
+static char http_date_header[64];
+static int http_date_header_length = 0;
+static time_t http_date_header_time = 0;
+
+static sw_inline void http_append_date_header(swString *response TSRMLS_DC)
+{
+    if (http_date_header_length == 0 || http_date_header_time != SwooleGS->now)
+    {
+        char *date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), SwooleGS->now, 0 TSRMLS_CC);
+        http_date_header_length = snprintf(http_date_header, sizeof(http_date_header), "Date: %s\r\n", date_str);
+        efree(date_str);
+        http_date_header_time = SwooleGS->now;
+    }
+    swString_append_ptr(response, http_date_header, http_date_header_length);
+}
+
 static void http_build_header(http_context *ctx, zval *object, swString *response, int body_length TSRMLS_DC)
 {
     assert(ctx->send_header == 0);
 
-    char buf[SW_HTTP_HEADER_MAX_SIZE];
+    char buf[32];
     int n;
-    char *date_str;
 
     /**
      * http status line
      */
-    n = snprintf(buf, sizeof(buf), "HTTP/1.1 %s\r\n", http_status_message(ctx->response.status));
-    swString_append_ptr(response, buf, n);
+    if (ctx->response.status == 200)
+    {
+        swString_append_ptr(response, ZEND_STRL("HTTP/1.1 200 OK\r\n"));
+    }
+    else
+    {
+        char *status_message = http_status_message(ctx->response.status);
+        swString_append_ptr(response, ZEND_STRL("HTTP/1.1 "));
+        swString_append_ptr(response, status_message, strlen(status_message));
+        swString_append_ptr(response, ZEND_STRL("\r\n"));
+    }
 
     /**
      * http header
@@ -1930,8 +2333,10 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
             {
                 flag |= HTTP_RESPONSE_CONTENT_TYPE;
             }
-            n = snprintf(buf, sizeof(buf), "%*s: %*s\r\n", keylen - 1, key, Z_STRLEN_P(value), Z_STRVAL_P(value));
-            swString_append_ptr(response, buf, n);
+            swString_append_ptr(response, key, keylen);
+            swString_append_ptr(response, ZEND_STRL(": "));
+            swString_append_ptr(response, Z_STRVAL_P(value), Z_STRLEN_P(value));
+            swString_append_ptr(response, ZEND_STRL("\r\n"));
         }
         SW_HASHTABLE_FOREACH_END();
         (void)type;
@@ -1964,29 +2369,20 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
         }
         if (!(flag & HTTP_RESPONSE_DATE))
         {
-            date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), SwooleGS->now, 0 TSRMLS_CC);
-            n = snprintf(buf, sizeof(buf), "Date: %s\r\n", date_str);
-            swString_append_ptr(response, buf, n);
-            efree(date_str);
+            http_append_date_header(response TSRMLS_CC);
         }
     }
     else
     {
-        //Server
-        swString_append_ptr(response, ZEND_STRL("Server: "SW_HTTP_SERVER_SOFTWARE"\r\nContent-Type: text/html\r\n"));
         if (ctx->keepalive)
         {
-            swString_append_ptr(response, ZEND_STRL("Connection: keep-alive\r\n"));
+            swString_append_ptr(response, ZEND_STRL("Server: "SW_HTTP_SERVER_SOFTWARE"\r\nContent-Type: text/html\r\nConnection: keep-alive\r\n"));
         }
         else
         {
-            swString_append_ptr(response, ZEND_STRL("Connection: close\r\n"));
+            swString_append_ptr(response, ZEND_STRL("Server: "SW_HTTP_SERVER_SOFTWARE"\r\nContent-Type: text/html\r\nConnection: close\r\n"));
         }
-        //Date
-        date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), SwooleGS->now, 0 TSRMLS_CC);
-        n = snprintf(buf, sizeof(buf), "Date: %s\r\n", date_str);
-        efree(date_str);
-        swString_append_ptr(response, buf, n);
+        http_append_date_header(response TSRMLS_CC);
     }
     /**
      * Http chunk
@@ -2006,8 +2402,10 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
             body_length = swoole_zlib_buffer->length;
         }
 #endif
-        n = snprintf(buf, sizeof(buf), "Content-Length: %d\r\n", body_length);
+        swString_append_ptr(response, ZEND_STRL("Content-Length: "));
+        n = swoole_itoa(buf, body_length);
         swString_append_ptr(response, buf, n);
+        swString_append_ptr(response, ZEND_STRL("\r\n"));
     }
     //http cookies
     if (ctx->response.zcookie)
@@ -2028,6 +2426,14 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
     //http compress
     if (ctx->gzip_enable)
     {
+#ifdef SW_HAVE_BROTLI
+        swString_append_ptr(response, SW_STRL("Vary: Accept-Encoding\r\n") - 1);
+        if (ctx->compress_brotli)
+        {
+            swString_append_ptr(response, SW_STRL("Content-Encoding: br\r\n") - 1);
+        }
+        else
+#endif
 #ifdef SW_HTTP_COMPRESS_GZIP
         swString_append_ptr(response, SW_STRL("Content-Encoding: gzip\r\n") - 1);
 #else
@@ -2049,22 +2455,28 @@ void php_zlib_free(voidpf opaque, voidpf address)
     efree((void*)address);
 }
 
-static int http_response_compress(swString *body, int level)
+static http_zstream* http_zstream_get(int level)
 {
-    assert(level > 0 || level < 10);
-
-    size_t memory_size = ((size_t) ((double) body->length * (double) 1.015)) + 10 + 8 + 4 + 1;
-
-    if (memory_size > swoole_zlib_buffer->size)
+    http_zstream *zs;
+    if (http_zstream_pool_num > 0)
     {
-        if (swString_extend(swoole_zlib_buffer, memory_size) < 0)
+        zs = http_zstream_pool[--http_zstream_pool_num];
+        if (zs->level != level)
         {
-            return SW_ERR;
+            //no input since deflateReset(), nothing is flushed
+            deflateParams(&zs->stream, level, Z_DEFAULT_STRATEGY);
+            zs->level = level;
         }
+        return zs;
     }
 
-    z_stream zstream;
-    memset(&zstream, 0, sizeof(zstream));
+    zs = sw_malloc(sizeof(http_zstream));
+    if (!zs)
+    {
+        return NULL;
+    }
+    //outlives the request, so zlib's own allocator instead of emalloc
+    memset(zs, 0, sizeof(http_zstream));
 
     //deflate: -0xf, gzip: 0x1f
 #ifdef SW_HTTP_COMPRESS_GZIP
@@ -2073,33 +2485,118 @@ static int http_response_compress(swString *body, int level)
     int encoding =  -0xf;
 #endif
 
-    int status;
-    zstream.zalloc = php_zlib_alloc;
-    zstream.zfree = php_zlib_free;
+    if (Z_OK != deflateInit2(&zs->stream, level, Z_DEFLATED, encoding, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY))
+    {
+        swWarn("deflateInit2() failed.");
+        sw_free(zs);
+        return NULL;
+    }
+    zs->level = level;
+    return zs;
+}
 
-    if (Z_OK == deflateInit2(&zstream, level, Z_DEFLATED, encoding, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY))
+static void http_zstream_release(http_zstream *zs)
+{
+    if (http_zstream_pool_num < SW_HTTP_COMPRESS_STREAM_POOL && deflateReset(&zs->stream) == Z_OK)
     {
-        zstream.next_in = (Bytef *) body->str;
-        zstream.next_out = (Bytef *) swoole_zlib_buffer->str;
-        zstream.avail_in = body->length;
-        zstream.avail_out = swoole_zlib_buffer->size;
+        http_zstream_pool[http_zstream_pool_num++] = zs;
+    }
+    else
+    {
+        deflateEnd(&zs->stream);
+        sw_free(zs);
+    }
+}
 
-        status = deflate(&zstream, Z_FINISH);
-        deflateEnd(&zstream);
+/**
+ * compress into swoole_zlib_buffer, flush is Z_SYNC_FLUSH for a chunk or Z_FINISH for the end of the stream
+ */
+static int http_response_compress_stream(http_zstream *zs, char *data, size_t length, int flush)
+{
+    z_stream *zstream = &zs->stream;
+    size_t memory_size = deflateBound(zstream, length) + 16;
 
-        if (Z_STREAM_END == status)
+    if (memory_size > swoole_zlib_buffer->size)
+    {
+        if (swString_extend(swoole_zlib_buffer, memory_size) < 0)
+        {
+            return SW_ERR;
+        }
+    }
+    swoole_zlib_buffer->length = 0;
+
+    zstream->next_in = (Bytef *) data;
+    zstream->avail_in = length;
+
+    int status;
+    while (1)
+    {
+        zstream->next_out = (Bytef *) swoole_zlib_buffer->str + swoole_zlib_buffer->length;
+        zstream->avail_out = swoole_zlib_buffer->size - swoole_zlib_buffer->length;
+
+        status = deflate(zstream, flush);
+        swoole_zlib_buffer->length = swoole_zlib_buffer->size - zstream->avail_out;
+
+        if (status == Z_STREAM_END)
         {
-            swoole_zlib_buffer->length = zstream.total_out;
             return SW_OK;
         }
+        if (status != Z_OK && status != Z_BUF_ERROR)
+        {
+            swWarn("deflate() failed, Error: %d.", status);
+            return SW_ERR;
+        }
+        if (zstream->avail_out > 0)
+        {
+            return SW_OK;
+        }
+        if (swString_extend(swoole_zlib_buffer, swoole_zlib_buffer->size * 2) < 0)
+        {
+            return SW_ERR;
+        }
     }
-    else
+}
+
+static int http_response_compress(swString *body, int level)
+{
+    http_zstream *zs = http_zstream_get(level);
+    if (!zs)
     {
-        swWarn("deflateInit2() failed.");
+        return SW_ERR;
+    }
+    int ret = http_response_compress_stream(zs, body->str, body->length, Z_FINISH);
+    http_zstream_release(zs);
+    return ret;
+}
+
+#ifdef SW_HAVE_BROTLI
+static int http_response_compress_brotli(swString *body, int level)
+{
+    size_t memory_size = BrotliEncoderMaxCompressedSize(body->length);
+    if (memory_size == 0)
+    {
+        return SW_ERR;
+    }
+    if (memory_size > swoole_zlib_buffer->size)
+    {
+        if (swString_extend(swoole_zlib_buffer, memory_size) < 0)
+        {
+            return SW_ERR;
+        }
+    }
+
+    size_t output_size = swoole_zlib_buffer->size;
+    if (!BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, body->length, (uint8_t *) body->str,
+            &output_size, (uint8_t *) swoole_zlib_buffer->str))
+    {
+        swWarn("BrotliEncoderCompress() failed.");
+        return SW_ERR;
     }
-    return SW_ERR;
+    swoole_zlib_buffer->length = output_size;
+    return SW_OK;
 }
 #endif
+#endif
 
 static PHP_METHOD(swoole_http_response, initHeader)
 {
@@ -2175,7 +2672,30 @@ static PHP_METHOD(swoole_http_response, end)
 
     if (ctx->chunk)
     {
-        ret = swServer_tcp_send(SwooleG.serv, ctx->fd, SW_STRL("0\r\n\r\n") - 1);
+#ifdef SW_HAVE_ZLIB
+        //the gzip trailer goes out with the last chunk
+        if (ctx->zstream)
+        {
+            swString_clear(swoole_http_buffer);
+            if (http_response_compress_stream(ctx->zstream, NULL, 0, Z_FINISH) == SW_OK && swoole_zlib_buffer->length > 0)
+            {
+                char *hex_string = swoole_dec2hex(swoole_zlib_buffer->length, 16);
+                swString_append_ptr(swoole_http_buffer, hex_string, strlen(hex_string));
+                swString_append_ptr(swoole_http_buffer, SW_STRL("\r\n") - 1);
+                swString_append(swoole_http_buffer, swoole_zlib_buffer);
+                swString_append_ptr(swoole_http_buffer, SW_STRL("\r\n") - 1);
+                sw_free(hex_string);
+            }
+            swString_append_ptr(swoole_http_buffer, SW_STRL("0\r\n\r\n") - 1);
+            http_zstream_release(ctx->zstream);
+            ctx->zstream = NULL;
+            ret = swServer_tcp_send(SwooleG.serv, ctx->fd, swoole_http_buffer->str, swoole_http_buffer->length);
+        }
+        else
+#endif
+        {
+            ret = swServer_tcp_send(SwooleG.serv, ctx->fd, SW_STRL("0\r\n\r\n") - 1);
+        }
         if (ret < 0)
         {
             RETURN_FALSE;
@@ -2189,11 +2709,17 @@ static PHP_METHOD(swoole_http_response, end)
 #ifdef SW_HAVE_ZLIB
         if (ctx->gzip_enable)
         {
-            if (http_body.length > 0)
+            if (http_body.length == 0 || http_body.length < SwooleG.serv->http_compression_min_length)
             {
-                http_response_compress(&http_body, ctx->gzip_level);
+                ctx->gzip_enable = 0;
             }
-            else
+#ifdef SW_HAVE_BROTLI
+            else if (ctx->accept_brotli && http_response_compress_brotli(&http_body, ctx->gzip_level) == SW_OK)
+            {
+                ctx->compress_brotli = 1;
+            }
+#endif
+            else if (http_response_compress(&http_body, ctx->gzip_level) < 0)
             {
                 ctx->gzip_enable = 0;
             }
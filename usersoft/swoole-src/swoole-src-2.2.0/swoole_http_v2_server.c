@@ -27,11 +27,102 @@ static sw_inline void http2_add_header(nghttp2_nv *headers, char *k, int kl, cha
     headers->namelen = kl;
     headers->value = (uchar*) v;
     headers->valuelen = vl;
+    headers->flags = NGHTTP2_NV_FLAG_NONE;
+}
+
+/**
+ * one encoder per connection, the peer's decoder keeps the dynamic table between header blocks
+ */
+static nghttp2_hd_deflater* http2_get_deflater(swoole_http_client *client)
+{
+    if (!client->deflater)
+    {
+        int ret = nghttp2_hd_deflate_new(&client->deflater, SW_HTTP2_HEADER_TABLE_SIZE);
+        if (ret != 0)
+        {
+            swWarn("nghttp2_hd_deflate_new() failed with error: %s.", nghttp2_strerror(ret));
+            client->deflater = NULL;
+        }
+    }
+    return client->deflater;
+}
+
+static ssize_t http2_deflate_headers(swoole_http_client *client, uchar *buffer, size_t size, nghttp2_nv *nv, int n)
+{
+    nghttp2_hd_deflater *deflater = http2_get_deflater(client);
+    if (!deflater)
+    {
+        return SW_ERR;
+    }
+    if (nghttp2_hd_deflate_bound(deflater, nv, n) > size)
+    {
+        swWarn("http2 header block is too large.");
+        return SW_ERR;
+    }
+    ssize_t rv = nghttp2_hd_deflate_hd(deflater, buffer, size, nv, n);
+    if (rv < 0)
+    {
+        swWarn("nghttp2_hd_deflate_hd() failed with error: %s.", nghttp2_strerror((int ) rv));
+        return SW_ERR;
+    }
+    return rv;
+}
+
+static void http2_flush(void *data)
+{
+    swoole_http_client *client = data;
+    client->send_deferred = 0;
+    if (client->send_buffer && client->send_buffer->length > 0)
+    {
+        swServer_tcp_send(SwooleG.serv, client->fd, client->send_buffer->str, client->send_buffer->length);
+        swString_clear(client->send_buffer);
+    }
+}
+
+/**
+ * responses of many streams finishing in the same event loop go out in a single write
+ */
+static int http2_send(swoole_http_client *client, char *data, size_t length)
+{
+    swReactor *reactor = SwooleG.main_reactor;
+    if (!reactor)
+    {
+        return swServer_tcp_send(SwooleG.serv, client->fd, data, length);
+    }
+    if (!client->send_buffer)
+    {
+        client->send_buffer = swString_new(SW_HTTP2_SEND_BUFFER_SIZE);
+        if (!client->send_buffer)
+        {
+            return swServer_tcp_send(SwooleG.serv, client->fd, data, length);
+        }
+    }
+    if (client->send_buffer->length + length > SW_HTTP2_SEND_BUFFER_SIZE)
+    {
+        http2_flush(client);
+        if (length > SW_HTTP2_SEND_BUFFER_SIZE)
+        {
+            return swServer_tcp_send(SwooleG.serv, client->fd, data, length);
+        }
+    }
+    if (swString_append_ptr(client->send_buffer, data, length) < 0)
+    {
+        return SW_ERR;
+    }
+    if (!client->send_deferred)
+    {
+        if (reactor->defer(reactor, http2_flush, client) < 0)
+        {
+            http2_flush(client);
+            return SW_OK;
+        }
+        client->send_deferred = 1;
+    }
+    return SW_OK;
 }
 
 static int http_build_trailer(http_context *ctx, uchar *buffer TSRMLS_DC)
 {
-    int ret;
     nghttp2_nv nv[128];
     int index = 0;
 
@@ -55,35 +146,7 @@ static int http_build_trailer(http_context *ctx, uchar *buffer TSRMLS_DC)
         SW_HASHTABLE_FOREACH_END();
     }
 
-    ssize_t rv;
-    size_t buflen;
-    size_t i;
-    size_t sum = 0;
-
-    nghttp2_hd_deflater *deflater;
-    ret = nghttp2_hd_deflate_new(&deflater, 4096);
-    if (ret != 0)
-    {
-        swoole_php_error(E_WARNING, "nghttp2_hd_deflate_init failed with error: %s\n", nghttp2_strerror(ret));
-        return SW_ERR;
-    }
-
-    for (i = 0; i < index; ++i)
-    {
-        sum += nv[i].namelen + nv[i].valuelen;
-    }
-
-    buflen = nghttp2_hd_deflate_bound(deflater, nv, index);
-    rv = nghttp2_hd_deflate_hd(deflater, (uchar *) buffer, buflen, nv, index);
-    if (rv < 0)
-    {
-        swoole_php_error(E_WARNING, "nghttp2_hd_deflate_hd() failed with error: %s\n", nghttp2_strerror((int ) rv));
-        return SW_ERR;
-    }
-
-    nghttp2_hd_deflate_del(deflater);
-
-    return rv;
+    return http2_deflate_headers(ctx->client, buffer, SW_HTTP_HEADER_MAX_SIZE, nv, index);
 }
 
 static sw_inline void http2_onRequest(http_context *ctx, int server_fd TSRMLS_DC)
@@ -250,39 +313,13 @@ static int http2_build_header(http_context *ctx, uchar *buffer, int body_length
     }
     ctx->send_header = 1;
 
-    ssize_t rv;
-    size_t buflen;
-    size_t i;
-    size_t sum = 0;
-
-    nghttp2_hd_deflater *deflater;
-    ret = nghttp2_hd_deflate_new(&deflater, 4096);
-    if (ret != 0)
-    {
-        swoole_php_error(E_WARNING, "nghttp2_hd_deflate_init failed with error: %s\n", nghttp2_strerror(ret));
-        return SW_ERR;
-    }
-
-    for (i = 0; i < index; ++i)
-    {
-        sum += nv[i].namelen + nv[i].valuelen;
-    }
-
-    buflen = nghttp2_hd_deflate_bound(deflater, nv, index);
-    rv = nghttp2_hd_deflate_hd(deflater, (uchar *) buffer, buflen, nv, index);
-    if (rv < 0)
-    {
-        swoole_php_error(E_WARNING, "nghttp2_hd_deflate_hd() failed with error: %s\n", nghttp2_strerror((int ) rv));
-        return SW_ERR;
-    }
+    ssize_t rv = http2_deflate_headers(ctx->client, buffer, SW_HTTP_HEADER_MAX_SIZE, nv, index);
 
     if (date_str)
     {
         efree(date_str);
     }
 
-    nghttp2_hd_deflate_del(deflater);
-
     return rv;
 }
 
@@ -297,6 +334,10 @@ int swoole_http2_do_response(http_context *ctx, swString *body)
     int ret;
 
     ret = http2_build_header(ctx, (uchar *) header_buffer, body->length TSRMLS_CC);
+    if (ret < 0)
+    {
+        return SW_ERR;
+    }
     swString_clear(swoole_http_buffer);
 
     /**
@@ -334,19 +375,7 @@ int swoole_http2_do_response(http_context *ctx, swString *body)
         flag = SW_HTTP2_FLAG_NONE;
     }
 
-    ret = swServer_tcp_send(SwooleG.serv, ctx->fd, swoole_http_buffer->str, swoole_http_buffer->length);
-    if (ret < 0)
-    {
-        ctx->send_header = 0;
-        return SW_ERR;
-    }
-
-    ctx->send_header = 1;
-    if (trailer == NULL && body->length == 0)
-    {
-        goto _end;
-    }
-
+    //HEADERS, DATA and the trailer HEADERS are written together
     char *p = body->str;
     size_t l = body->length;
     size_t send_n;
@@ -354,7 +383,6 @@ int swoole_http2_do_response(http_context *ctx, swString *body)
     while (l > 0)
     {
         int _send_flag;
-        swString_clear(swoole_http_buffer);
         if (l > SW_HTTP2_MAX_FRAME_SIZE)
         {
             send_n = SW_HTTP2_MAX_FRAME_SIZE;
@@ -368,35 +396,32 @@ int swoole_http2_do_response(http_context *ctx, swString *body)
         swHttp2_set_frame_header(frame_header, SW_HTTP2_TYPE_DATA, send_n, _send_flag, ctx->stream_id);
         swString_append_ptr(swoole_http_buffer, frame_header, 9);
         swString_append_ptr(swoole_http_buffer, p, send_n);
-
-        if (swServer_tcp_send(SwooleG.serv, ctx->fd, swoole_http_buffer->str, swoole_http_buffer->length) < 0)
-        {
-            return SW_ERR;
-        }
-        else
-        {
-            l -= send_n;
-            p += send_n;
-        }
+        l -= send_n;
+        p += send_n;
     }
 
     if (trailer)
     {
-        swString_clear(swoole_http_buffer);
         memset(header_buffer, 0, sizeof(header_buffer));
         ret = http_build_trailer(ctx, (uchar *) header_buffer TSRMLS_CC);
+        if (ret < 0)
+        {
+            return SW_ERR;
+        }
         swHttp2_set_frame_header(frame_header, SW_HTTP2_TYPE_HEADERS, ret,
                 SW_HTTP2_FLAG_END_HEADERS | SW_HTTP2_FLAG_END_STREAM, ctx->stream_id);
         swString_append_ptr(swoole_http_buffer, frame_header, 9);
         swString_append_ptr(swoole_http_buffer, header_buffer, ret);
+    }
 
-        if (swServer_tcp_send(SwooleG.serv, ctx->fd, swoole_http_buffer->str, swoole_http_buffer->length) < 0)
-        {
-            return SW_ERR;
-        }
+    if (http2_send(client, swoole_http_buffer->str, swoole_http_buffer->length) < 0)
+    {
+        ctx->send_header = 0;
+        return SW_ERR;
     }
+    ctx->send_header = 1;
 
-    _end: if (body->length > 0)
+    if (body->length > 0)
     {
         client->window_size -= body->length;    // TODO:flow control?
     }
@@ -720,6 +745,16 @@ void swoole_http2_free(swoole_http_client *client)
         nghttp2_hd_inflate_del(client->inflater);
         client->inflater = NULL;
     }
+    if (client->deflater)
+    {
+        nghttp2_hd_deflate_del(client->deflater);
+        client->deflater = NULL;
+    }
+    //a pending flush finds the buffer empty, the slot may already belong to a new connection
+    if (client->send_buffer)
+    {
+        swString_clear(client->send_buffer);
+    }
 
     client->init = 0;
     client->remote_window_size = SW_HTTP2_DEFAULT_WINDOW;
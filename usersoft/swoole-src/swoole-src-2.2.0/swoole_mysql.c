@@ -656,7 +656,7 @@ static int mysql_parse_prepare_result(mysql_client *client, char *buf, size_t n_
         return SW_ERR;
     }
 
-    mysql_statement *stmt = emalloc(sizeof(mysql_statement));
+    mysql_statement *stmt = ecalloc(1, sizeof(mysql_statement));
     stmt->id = mysql_uint4korr(buf);
     buf += 4;
     stmt->field_count = mysql_uint2korr(buf);
@@ -1201,6 +1201,13 @@ static sw_inline int mysql_read_rows(mysql_client *client)
         buffer += client->response.packet_length;
         n_buf -= client->response.packet_length;
         client->buffer->offset += client->response.packet_length + 4;
+
+        //batch is full, wait for the rows to be fetched
+        if (client->fetch_batch && ++client->response.batch_rows >= client->fetch_batch)
+        {
+            client->response.batch_ready = 1;
+            return SW_ERR;
+        }
     }
 
     return SW_ERR;
@@ -248,6 +248,12 @@ typedef struct
     uint16_t unreaded_param_count;
     struct _mysql_client *client;
     zval *object;
+    /**
+     * key and position in the statement cache of the connection
+     */
+    char *sql;
+    uint16_t sql_length;
+    swLinkedList_node *lru_node;
 } mysql_statement;
 
 typedef struct
@@ -269,6 +275,11 @@ typedef struct
     ulong_t affected_rows;
     ulong_t insert_id;
     zval *result_array;
+    /**
+     * rows decoded into result_array since the last batch was handed out
+     */
+    uint32_t batch_rows;
+    uint8_t batch_ready;
 } mysql_response_t;
 
 typedef struct _mysql_client
@@ -279,6 +290,28 @@ typedef struct _mysql_client
     mysql_io_status iowait;
     zval *result;
     int cid;
+    /**
+     * connection pool, pool_connecting is set while the pool waits for the handshake
+     */
+    void *pool;
+    uint8_t pool_connecting;
+    time_t idle_since;
+    /**
+     * prepared statements by sql text, least recently used at the head of stmt_lru
+     */
+    uint32_t stmt_cache_size;
+    swHashMap *stmt_cache;
+    swLinkedList *stmt_lru;
+    char *prepare_sql;
+    uint16_t prepare_sql_length;
+    /**
+     * fetch mode, rows are handed to fetch() in batches while the result set is read
+     */
+    zend_bool fetch_mode;
+    uint8_t fetching;
+    uint8_t fetch_paused;
+    uint8_t fetch_eof;
+    zval *fetch_result;
 #endif
     uint8_t state;
     uint8_t handshake;
@@ -292,6 +325,10 @@ typedef struct _mysql_client
     uint32_t transaction :1;
     uint32_t connected :1;
     uint32_t strict;
+    /**
+     * stop decoding rows after this many, 0 to read the whole result set
+     */
+    uint32_t fetch_batch;
 
     mysql_connector connector;
     mysql_statement *statement;
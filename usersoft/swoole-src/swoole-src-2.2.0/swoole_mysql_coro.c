@@ -41,6 +41,7 @@ static PHP_METHOD(swoole_mysql_coro, rollback);
 static PHP_METHOD(swoole_mysql_coro, prepare);
 static PHP_METHOD(swoole_mysql_coro, setDefer);
 static PHP_METHOD(swoole_mysql_coro, getDefer);
+static PHP_METHOD(swoole_mysql_coro, fetch);
 static PHP_METHOD(swoole_mysql_coro, close);
 
 static PHP_METHOD(swoole_mysql_coro_statement, __destruct);
@@ -96,6 +97,72 @@ static zend_class_entry *swoole_mysql_coro_exception_class_entry_ptr;
 static zend_class_entry swoole_mysql_coro_statement_ce;
 static zend_class_entry *swoole_mysql_coro_statement_class_entry_ptr;
 
+#if PHP_MAJOR_VERSION >= 7
+static PHP_METHOD(swoole_mysql_coro_pool, __construct);
+static PHP_METHOD(swoole_mysql_coro_pool, __destruct);
+static PHP_METHOD(swoole_mysql_coro_pool, get);
+static PHP_METHOD(swoole_mysql_coro_pool, put);
+static PHP_METHOD(swoole_mysql_coro_pool, close);
+static PHP_METHOD(swoole_mysql_coro_pool, stats);
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_mysql_coro_pool_construct, 0, 0, 1)
+    ZEND_ARG_ARRAY_INFO(0, server_config, 0)
+    ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_mysql_coro_pool_put, 0, 0, 1)
+    ZEND_ARG_INFO(0, connection)
+ZEND_END_ARG_INFO()
+
+typedef struct
+{
+    zval config;
+    /**
+     * idle connections, coroutines wait on it when all connections are in use
+     */
+    zval channel;
+    uint32_t count;
+    uint32_t max;
+    uint32_t min;
+    uint32_t max_idle;
+    double idle_timeout;
+    uint8_t closed;
+    uint8_t destroyed;
+    /**
+     * connections still pointing to the pool, it is freed after the last one
+     */
+    uint32_t refcount;
+    uint64_t created;
+    uint64_t reused;
+} mysql_coro_pool;
+
+static void swoole_mysql_coro_pool_release(mysql_client *client)
+{
+    mysql_coro_pool *pool = client->pool;
+
+    client->pool = NULL;
+    pool->count--;
+    if (--pool->refcount == 0 && pool->destroyed)
+    {
+        efree(pool);
+    }
+}
+
+static zend_class_entry swoole_mysql_coro_pool_ce;
+static zend_class_entry *swoole_mysql_coro_pool_class_entry_ptr;
+
+static const zend_function_entry swoole_mysql_coro_pool_methods[] =
+{
+    PHP_ME(swoole_mysql_coro_pool, __construct, arginfo_swoole_mysql_coro_pool_construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+    PHP_ME(swoole_mysql_coro_pool, __destruct, arginfo_swoole_void, ZEND_ACC_PUBLIC | ZEND_ACC_DTOR)
+    PHP_ME(swoole_mysql_coro_pool, get, arginfo_swoole_void, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_mysql_coro_pool, put, arginfo_swoole_mysql_coro_pool_put, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_mysql_coro_pool, close, arginfo_swoole_void, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_mysql_coro_pool, stats, arginfo_swoole_void, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+#endif
+
 static const zend_function_entry swoole_mysql_coro_methods[] =
 {
     PHP_ME(swoole_mysql_coro, __construct, arginfo_swoole_void, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
@@ -112,6 +179,7 @@ static const zend_function_entry swoole_mysql_coro_methods[] =
     PHP_ME(swoole_mysql_coro, prepare, arginfo_swoole_mysql_coro_prepare, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_mysql_coro, setDefer, arginfo_swoole_mysql_coro_setDefer, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_mysql_coro, getDefer, arginfo_swoole_void, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_mysql_coro, fetch, arginfo_swoole_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_mysql_coro, close, arginfo_swoole_void, ZEND_ACC_PUBLIC)
     PHP_FALIAS(__sleep, swoole_unsupport_serialize, NULL)
     PHP_FALIAS(__wakeup, swoole_unsupport_serialize, NULL)
@@ -128,10 +196,15 @@ static const zend_function_entry swoole_mysql_coro_statement_methods[] =
 };
 
 static int swoole_mysql_coro_onRead(swReactor *reactor, swEvent *event);
+static int swoole_mysql_coro_parse_response(mysql_client *client TSRMLS_DC);
+static void swoole_mysql_coro_fetch_pause(mysql_client *client, int pause);
 static int swoole_mysql_coro_onWrite(swReactor *reactor, swEvent *event);
 static int swoole_mysql_coro_onError(swReactor *reactor, swEvent *event);
 static void swoole_mysql_coro_onConnect(mysql_client *client TSRMLS_DC);
 static void swoole_mysql_coro_onTimeout(swTimer *timer, swTimer_node *tnode);
+#if PHP_MAJOR_VERSION >= 7
+static int swoole_mysql_coro_pool_onConnect(mysql_client *client, zval *zobject, zval *result, zval *pool_ref);
+#endif
 
 extern swString *mysql_request_buffer;
 
@@ -149,11 +222,19 @@ void swoole_mysql_coro_init(int module_number TSRMLS_DC)
     swoole_mysql_coro_exception_class_entry_ptr = sw_zend_register_internal_class_ex(&swoole_mysql_coro_exception_ce,
             zend_exception_get_default(TSRMLS_C), NULL TSRMLS_CC);
 
+#if PHP_MAJOR_VERSION >= 7
+    INIT_CLASS_ENTRY(swoole_mysql_coro_pool_ce, "Swoole\\Coroutine\\MySQL\\Pool", swoole_mysql_coro_pool_methods);
+    swoole_mysql_coro_pool_class_entry_ptr = zend_register_internal_class(&swoole_mysql_coro_pool_ce TSRMLS_CC);
+#endif
+
     if (SWOOLE_G(use_shortname))
     {
         sw_zend_register_class_alias("Co\\MySQL", swoole_mysql_coro_class_entry_ptr);
         sw_zend_register_class_alias("Co\\MySQL\\Statement", swoole_mysql_coro_statement_class_entry_ptr);
         sw_zend_register_class_alias("Co\\MySQL\\Exception", swoole_mysql_coro_exception_class_entry_ptr);
+#if PHP_MAJOR_VERSION >= 7
+        sw_zend_register_class_alias("Co\\MySQL\\Pool", swoole_mysql_coro_pool_class_entry_ptr);
+#endif
     }
 
     zend_declare_property_string(swoole_mysql_coro_class_entry_ptr, SW_STRL("serverInfo") - 1, "", ZEND_ACC_PRIVATE TSRMLS_CC);
@@ -199,7 +280,10 @@ static int swoole_mysql_coro_close(zval *this)
     SwooleG.main_reactor->write(SwooleG.main_reactor, client->fd, mysql_request_buffer->str, mysql_request_buffer->length);
 
     zend_update_property_bool(swoole_mysql_coro_class_entry_ptr, this, ZEND_STRL("connected"), 0 TSRMLS_CC);
-    SwooleG.main_reactor->del(SwooleG.main_reactor, client->fd);
+    if (!client->fetch_paused)
+    {
+        SwooleG.main_reactor->del(SwooleG.main_reactor, client->fd);
+    }
 
     swConnection *_socket = swReactor_get(SwooleG.main_reactor, client->fd);
     _socket->object = NULL;
@@ -222,13 +306,50 @@ static int swoole_mysql_coro_close(zval *this)
                 // after connection closed, mysql stmt cache closed too
                 // so we needn't send stmt close command here like pdo.
                 swoole_set_object(stmt->object, NULL);
-                efree(stmt->object);
+#if PHP_MAJOR_VERSION >= 7
+                if (stmt->lru_node)
+                {
+                    //drop the reference held by the statement cache
+                    zval _object = *stmt->object;
+                    efree(stmt->object);
+                    zval_ptr_dtor(&_object);
+                }
+                else
+#endif
+                {
+                    efree(stmt->object);
+                }
+            }
+            if (stmt->sql)
+            {
+                efree(stmt->sql);
             }
             efree(stmt);
             node = node->next;
         }
         swLinkedList_free(client->statement_list);
+        client->statement_list = NULL;
     }
+    if (client->stmt_cache)
+    {
+        swHashMap_free(client->stmt_cache);
+        client->stmt_cache = NULL;
+        swLinkedList_free(client->stmt_lru);
+        client->stmt_lru = NULL;
+    }
+    if (client->prepare_sql)
+    {
+        efree(client->prepare_sql);
+        client->prepare_sql = NULL;
+    }
+    if (client->fetch_result)
+    {
+        sw_zval_free(client->fetch_result);
+        client->fetch_result = NULL;
+    }
+    client->fetching = 0;
+    client->fetch_paused = 0;
+    client->fetch_eof = 0;
 
     client->cli->close(client->cli);
     swClient_free(client->cli);
@@ -254,6 +375,12 @@ static int swoole_mysql_coro_execute(zval *zobject, mysql_client *client, zval *
         return SW_ERR;
     }
 
+    if (client->fetching)
+    {
+        swoole_php_fatal_error(E_WARNING, "mysql client is fetching a result set, cannot send new sql query.");
+        return SW_ERR;
+    }
+
     mysql_statement *statement = swoole_get_object(zobject);
     if (!statement)
     {
@@ -419,6 +546,58 @@ static int swoole_mysql_coro_statement_close(mysql_statement *stmt TSRMLS_DC)
     return SW_OK;
 }
 
+#if PHP_MAJOR_VERSION >= 7
+static void swoole_mysql_coro_statement_cache_del(mysql_client *client, mysql_statement *stmt, int release)
+{
+    swHashMap_del(client->stmt_cache, stmt->sql, stmt->sql_length);
+    swLinkedList_remove_node(client->stmt_lru, stmt->lru_node);
+    stmt->lru_node = NULL;
+    if (release)
+    {
+        //the statement is closed by __destruct once the user drops it too
+        zval _object = *stmt->object;
+        zval_ptr_dtor(&_object);
+    }
+}
+
+static void swoole_mysql_coro_statement_cache_add(mysql_client *client, mysql_statement *stmt)
+{
+    if (client->stmt_cache == NULL)
+    {
+        client->stmt_cache = swHashMap_new(client->stmt_cache_size, NULL);
+        client->stmt_lru = swLinkedList_new(0, NULL);
+    }
+    while (client->stmt_lru->num > 0 && client->stmt_lru->num >= client->stmt_cache_size)
+    {
+        swoole_mysql_coro_statement_cache_del(client, client->stmt_lru->head->data, 1);
+    }
+    if (swHashMap_add(client->stmt_cache, stmt->sql, stmt->sql_length, stmt) < 0)
+    {
+        return;
+    }
+    swLinkedList_append(client->stmt_lru, stmt);
+    stmt->lru_node = client->stmt_lru->tail;
+    Z_TRY_ADDREF_P(stmt->object);
+}
+
+static mysql_statement* swoole_mysql_coro_statement_cache_find(mysql_client *client, char *sql, size_t length)
+{
+    if (client->stmt_cache == NULL || length > 0xffff)
+    {
+        return NULL;
+    }
+    mysql_statement *stmt = swHashMap_find(client->stmt_cache, sql, length);
+    if (stmt)
+    {
+        //move to the tail, the most recently used
+        swLinkedList_remove_node(client->stmt_lru, stmt->lru_node);
+        swLinkedList_append(client->stmt_lru, stmt);
+        stmt->lru_node = client->stmt_lru->tail;
+    }
+    return stmt;
+}
+#endif
+
 static PHP_METHOD(swoole_mysql_coro, __construct)
 {
 	coro_check(TSRMLS_C);
@@ -438,22 +617,19 @@ static PHP_METHOD(swoole_mysql_coro, __construct)
     swoole_set_object(getThis(), client);
 }
 
-static PHP_METHOD(swoole_mysql_coro, connect)
+/**
+ * start connecting zobject, the current coroutine yields until the handshake is done
+ */
+static void swoole_mysql_coro_connect(zval *zobject, zval *server_info, zval *return_value TSRMLS_DC)
 {
-    zval *server_info;
     char buf[2048];
 
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a", &server_info) == FAILURE)
-    {
-        RETURN_FALSE;
-    }
-
     php_swoole_array_separate(server_info);
 
     HashTable *_ht = Z_ARRVAL_P(server_info);
     zval *value;
 
-    mysql_client *client = swoole_get_object(getThis());
+    mysql_client *client = swoole_get_object(zobject);
 
     if (client->cli)
     {
@@ -561,6 +737,35 @@ static PHP_METHOD(swoole_mysql_coro, connect)
     } else{
         connector->strict_type = 0;
     }
+#if PHP_MAJOR_VERSION >= 7
+    if (php_swoole_array_get_value(_ht, "statement_cache_size", value))
+    {
+        convert_to_long(value);
+        client->stmt_cache_size = Z_LVAL_P(value) < 0 ? 0 : (uint32_t) Z_LVAL_P(value);
+    }
+#endif
+    if (php_swoole_array_get_value(_ht, "fetch_mode", value))
+    {
+        convert_to_boolean(value);
+        client->fetch_mode = Z_BVAL_P(value);
+    }
+    if (client->fetch_mode)
+    {
+        client->fetch_batch = SW_MYSQL_FETCH_BATCH;
+        if (php_swoole_array_get_value(_ht, "fetch_batch", value))
+        {
+            convert_to_long(value);
+            if (Z_LVAL_P(value) > 0)
+            {
+                client->fetch_batch = (uint32_t) Z_LVAL_P(value);
+            }
+        }
+        client->defer = 0;
+    }
+    else
+    {
+        client->fetch_batch = 0;
+    }
 
     swClient *cli = emalloc(sizeof(swClient));
     int type = SW_SOCK_TCP;
@@ -621,9 +826,9 @@ static PHP_METHOD(swoole_mysql_coro, connect)
         RETURN_FALSE;
     }
 
-    zend_update_property(swoole_mysql_coro_class_entry_ptr, getThis(), ZEND_STRL("serverInfo"), server_info TSRMLS_CC);
+    zend_update_property(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("serverInfo"), server_info TSRMLS_CC);
     sw_zval_ptr_dtor(&server_info);
-	zend_update_property_long(swoole_mysql_coro_class_entry_ptr, getThis(), ZEND_STRL("sock"), cli->socket->fd TSRMLS_CC);
+	zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("sock"), cli->socket->fd TSRMLS_CC);
 
 	if (!client->buffer)
 	{
@@ -635,7 +840,7 @@ static PHP_METHOD(swoole_mysql_coro, connect)
 		bzero(&client->response, sizeof(client->response));
 	}
     client->fd = cli->socket->fd;
-    client->object = getThis();
+    client->object = zobject;
     client->cli = cli;
     sw_copy_to_stack(client->object, client->_object);
 
@@ -647,18 +852,18 @@ static PHP_METHOD(swoole_mysql_coro, connect)
     _socket->object = client;
     _socket->active = 0;
 
-    php_context *context = swoole_get_property(getThis(), 0);
+    php_context *context = swoole_get_property(zobject, 0);
     if (!context)
     {
         context = emalloc(sizeof(php_context));
-        swoole_set_property(getThis(), 0, context);
+        swoole_set_property(zobject, 0, context);
     }
 	context->state = SW_CORO_CONTEXT_RUNNING;
 	context->onTimeout = NULL;
 #if PHP_MAJOR_VERSION < 7
-	context->coro_params = getThis();
+	context->coro_params = zobject;
 #else
-	context->coro_params = *getThis();
+	context->coro_params = *zobject;
 #endif
 	if (connector->timeout > 0)
 	{
@@ -670,6 +875,17 @@ static PHP_METHOD(swoole_mysql_coro, connect)
     coro_yield();
 }
 
+static PHP_METHOD(swoole_mysql_coro, connect)
+{
+    zval *server_info;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a", &server_info) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+    swoole_mysql_coro_connect(getThis(), server_info, return_value TSRMLS_CC);
+}
+
 static PHP_METHOD(swoole_mysql_coro, query)
 {
     swString sql;
@@ -701,6 +917,12 @@ static PHP_METHOD(swoole_mysql_coro, query)
         RETURN_FALSE;
     }
 
+    if (client->fetching)
+    {
+        swoole_php_fatal_error(E_WARNING, "mysql client is fetching a result set, cannot send new sql query.");
+        RETURN_FALSE;
+    }
+
     if (unlikely(client->cid && client->cid != get_current_cid()))
     {
         swoole_php_fatal_error(E_WARNING, "mysql client has already been bound to another coroutine.");
@@ -892,6 +1114,80 @@ static PHP_METHOD(swoole_mysql_coro, getDefer)
     RETURN_BOOL(client->defer);
 }
 
+static PHP_METHOD(swoole_mysql_coro, fetch)
+{
+    mysql_client *client = swoole_get_object(getThis());
+    if (!client)
+    {
+        swoole_php_fatal_error(E_WARNING, "object is not instanceof swoole_mysql_coro.");
+        RETURN_FALSE;
+    }
+
+    if (!client->fetch_mode)
+    {
+        swoole_php_fatal_error(E_WARNING, "fetch mode is not enabled.");
+        RETURN_FALSE;
+    }
+
+    if (!client->fetching)
+    {
+        RETURN_NULL();
+    }
+
+    if (client->fetch_result)
+    {
+#if PHP_MAJOR_VERSION >= 7
+        zval _result = *client->fetch_result;
+        efree(client->fetch_result);
+        zval *result = &_result;
+#else
+        zval *result = client->fetch_result;
+#endif
+        client->fetch_result = NULL;
+        if (client->fetch_eof)
+        {
+            if (php_swoole_array_length(result) == 0)
+            {
+                client->fetching = 0;
+                sw_zval_ptr_dtor(&result);
+                RETURN_NULL();
+            }
+        }
+        else
+        {
+            //the batch is taken, read the next one while it is being processed
+            swoole_mysql_coro_fetch_pause(client, 0);
+            if (client->buffer->length > client->buffer->offset)
+            {
+                swoole_mysql_coro_parse_response(client TSRMLS_CC);
+            }
+        }
+        RETURN_ZVAL(result, 0, 1);
+    }
+
+    if (client->fetch_eof)
+    {
+        client->fetching = 0;
+        RETURN_NULL();
+    }
+
+    if (!client->cli)
+    {
+        RETURN_FALSE;
+    }
+
+    if (unlikely(client->cid && client->cid != get_current_cid()))
+    {
+        swoole_php_fatal_error(E_WARNING, "mysql client has already been bound to another coroutine.");
+        RETURN_FALSE;
+    }
+
+    client->cid = get_current_cid();
+    php_context *context = swoole_get_property(getThis(), 0);
+    coro_save(context);
+    coro_yield();
+}
+
 static PHP_METHOD(swoole_mysql_coro, setDefer)
 {
     zend_bool defer = 1;
@@ -905,6 +1201,11 @@ static PHP_METHOD(swoole_mysql_coro, setDefer)
     {
         RETURN_BOOL(defer);
     }
+    if (defer && client->fetch_mode)
+    {
+        swoole_php_fatal_error(E_WARNING, "cannot use defer in fetch mode.");
+        RETURN_FALSE;
+    }
     client->defer = defer;
     RETURN_TRUE
 }
@@ -974,6 +1275,17 @@ static PHP_METHOD(swoole_mysql_coro, prepare)
         RETURN_FALSE;
     }
 
+#if PHP_MAJOR_VERSION >= 7
+    if (client->stmt_cache_size > 0 && !client->defer)
+    {
+        mysql_statement *stmt = swoole_mysql_coro_statement_cache_find(client, sql.str, sql.length);
+        if (stmt)
+        {
+            RETURN_ZVAL(stmt->object, 1, 0);
+        }
+    }
+#endif
+
     client->cmd = SW_MYSQL_COM_STMT_PREPARE;
     client->state = SW_MYSQL_STATE_READ_START;
 
@@ -1001,6 +1313,15 @@ static PHP_METHOD(swoole_mysql_coro, prepare)
         RETURN_TRUE;
     }
 
+#if PHP_MAJOR_VERSION >= 7
+    if (client->stmt_cache_size > 0 && sql.length <= 0xffff)
+    {
+        //cache key of the statement in the response
+        client->prepare_sql = estrndup(sql.str, sql.length);
+        client->prepare_sql_length = sql.length;
+    }
+#endif
+
     php_context *context = swoole_get_property(getThis(), 0);
     double timeout = client->connector.timeout;
     if (timeout > 0)
@@ -1068,8 +1389,18 @@ static PHP_METHOD(swoole_mysql_coro_statement, __destruct)
     {
         return;
     }
+#if PHP_MAJOR_VERSION >= 7
+    if (stmt->lru_node)
+    {
+        swoole_mysql_coro_statement_cache_del(stmt->client, stmt, 0);
+    }
+#endif
     swoole_mysql_coro_statement_close(stmt TSRMLS_CC);
     swLinkedList_remove(stmt->client->statement_list, stmt);
+    if (stmt->sql)
+    {
+        efree(stmt->sql);
+    }
     efree(stmt);
 }
 
@@ -1137,6 +1468,12 @@ static PHP_METHOD(swoole_mysql_coro, __destruct)
     {
         swoole_mysql_coro_close(getThis());
     }
+#if PHP_MAJOR_VERSION >= 7
+    if (client->pool)
+    {
+        swoole_mysql_coro_pool_release(client);
+    }
+#endif
     if (client->buffer)
     {
         swString_free(client->buffer);
@@ -1195,6 +1532,10 @@ static int swoole_mysql_coro_onError(swReactor *reactor, swEvent *event)
 	}
     client->suspending = 0;
     client->cid = 0;
+#if PHP_MAJOR_VERSION >= 7
+    zval pool_ref;
+    int pool_release = swoole_mysql_coro_pool_onConnect(client, zobject, result, &pool_ref);
+#endif
 	php_context *sw_current_context = swoole_get_property(zobject, 0);
 	int ret = coro_resume(sw_current_context, result, &retval);
     sw_zval_free(result);
@@ -1203,10 +1544,39 @@ static int swoole_mysql_coro_onError(swReactor *reactor, swEvent *event)
 	{
 		sw_zval_ptr_dtor(&retval);
 	}
+#if PHP_MAJOR_VERSION >= 7
+    if (pool_release)
+    {
+        zval_ptr_dtor(&pool_ref);
+    }
+#endif
 
     return SW_OK;
 }
 
+#if PHP_MAJOR_VERSION >= 7
+/**
+ * the coroutine blocked in Pool::get() gets the connection object instead of true,
+ * returns 1 when the reference held by the pool must be released after resuming
+ */
+static int swoole_mysql_coro_pool_onConnect(mysql_client *client, zval *zobject, zval *result, zval *pool_ref)
+{
+    if (!client->pool_connecting)
+    {
+        return 0;
+    }
+    client->pool_connecting = 0;
+    if (Z_TYPE_P(result) == IS_TRUE)
+    {
+        ZVAL_COPY_VALUE(result, zobject);
+        return 0;
+    }
+    //__destruct gives the slot back to the pool
+    ZVAL_COPY_VALUE(pool_ref, zobject);
+    return 1;
+}
+#endif
+
 static void swoole_mysql_coro_onConnect(mysql_client *client TSRMLS_DC)
 {
     zval *zobject = client->object;
@@ -1244,6 +1614,11 @@ static void swoole_mysql_coro_onConnect(mysql_client *client TSRMLS_DC)
 
     client->cid = 0;
 
+#if PHP_MAJOR_VERSION >= 7
+    zval pool_ref;
+    int pool_release = swoole_mysql_coro_pool_onConnect(client, zobject, result, &pool_ref);
+#endif
+
     php_context *sw_current_context = swoole_get_property(zobject, 0);
     int ret = coro_resume(sw_current_context, result, &retval);
     sw_zval_ptr_dtor(&result);
@@ -1251,6 +1626,12 @@ static void swoole_mysql_coro_onConnect(mysql_client *client TSRMLS_DC)
     {
         sw_zval_ptr_dtor(&retval);
     }
+#if PHP_MAJOR_VERSION >= 7
+    if (pool_release)
+    {
+        zval_ptr_dtor(&pool_ref);
+    }
+#endif
 }
 
 static void swoole_mysql_coro_onTimeout(swTimer *timer, swTimer_node *tnode)
@@ -1297,6 +1678,11 @@ static void swoole_mysql_coro_onTimeout(swTimer *timer, swTimer_node *tnode)
     client->suspending = 0;
     client->cid = 0;
 
+#if PHP_MAJOR_VERSION >= 7
+    zval pool_ref;
+    int pool_release = swoole_mysql_coro_pool_onConnect(client, zobject, result, &pool_ref);
+#endif
+
     int ret = coro_resume(ctx, result, &retval);
 
     if (ret == CORO_END && retval)
@@ -1305,6 +1691,12 @@ static void swoole_mysql_coro_onTimeout(swTimer *timer, swTimer_node *tnode)
     }
 
     sw_zval_free(result);
+#if PHP_MAJOR_VERSION >= 7
+    if (pool_release)
+    {
+        zval_ptr_dtor(&pool_ref);
+    }
+#endif
 }
 
 static int swoole_mysql_coro_onWrite(swReactor *reactor, swEvent *event)
@@ -1417,6 +1809,209 @@ static int swoole_mysql_coro_onHandShake(mysql_client *client TSRMLS_DC)
     return SW_OK;
 }
 
+static void swoole_mysql_coro_fetch_pause(mysql_client *client, int pause)
+{
+    if (pause && !client->fetch_paused)
+    {
+        //stop reading, the server is throttled by the tcp window until the batch is fetched
+        SwooleG.main_reactor->del(SwooleG.main_reactor, client->fd);
+        client->fetch_paused = 1;
+    }
+    else if (!pause && client->fetch_paused)
+    {
+        SwooleG.main_reactor->add(SwooleG.main_reactor, client->fd, PHP_SWOOLE_FD_MYSQL | SW_EVENT_READ);
+        client->fetch_paused = 0;
+    }
+}
+
+static zval* swoole_mysql_coro_fetch_batch(mysql_client *client)
+{
+    zval *batch = client->response.result_array;
+    zval *result_array;
+
+    SW_ALLOC_INIT_ZVAL(result_array);
+    array_init(result_array);
+    client->response.result_array = result_array;
+    client->response.batch_rows = 0;
+    client->response.batch_ready = 0;
+
+    //drop the decoded rows, so the buffer only holds the rows not yet parsed
+    swString *buffer = client->buffer;
+    if (buffer->offset > 0)
+    {
+        buffer->length -= buffer->offset;
+        memmove(buffer->str, buffer->str + buffer->offset, buffer->length);
+        buffer->offset = 0;
+    }
+    return batch;
+}
+
+static void swoole_mysql_coro_fetch_deliver(mysql_client *client, zval *batch, int eof TSRMLS_DC)
+{
+    zval *result = batch;
+    zval *retval = NULL;
+    int ret;
+
+    client->fetch_eof = eof;
+    if (!client->fetching || !client->cid)
+    {
+        //nobody is waiting in fetch(), hold the batch
+        client->fetch_result = batch;
+        if (!eof)
+        {
+            swoole_mysql_coro_fetch_pause(client, 1);
+        }
+        if (client->fetching)
+        {
+            return;
+        }
+        //first batch, query() returns true
+        client->fetching = 1;
+        SW_ALLOC_INIT_ZVAL(result);
+        ZVAL_BOOL(result, 1);
+    }
+    else if (eof && php_swoole_array_length(batch) == 0)
+    {
+        client->fetching = 0;
+        zval_dtor(batch);
+        ZVAL_NULL(batch);
+    }
+
+    client->cid = 0;
+    php_context *context = swoole_get_property(client->object, 0);
+    ret = coro_resume(context, result, &retval);
+    sw_zval_free(result);
+    if (ret == CORO_END && retval)
+    {
+        sw_zval_ptr_dtor(&retval);
+    }
+}
+
+static int swoole_mysql_coro_parse_response(mysql_client *client TSRMLS_DC)
+{
+    zval *zobject = client->object;
+    zval *retval = NULL;
+    zval *result = NULL;
+    int result_set = 0;
+    int ret;
+
+    if (mysql_response(client) < 0)
+    {
+        if (client->response.batch_ready)
+        {
+            swoole_mysql_coro_fetch_deliver(client, swoole_mysql_coro_fetch_batch(client), 0 TSRMLS_CC);
+        }
+        return SW_OK;
+    }
+
+    //remove from eventloop
+    //reactor->del(reactor, event->fd);
+
+    zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("affected_rows"),
+            client->response.affected_rows TSRMLS_CC);
+    zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("insert_id"),
+            client->response.insert_id TSRMLS_CC);
+
+    if (client->cmd == SW_MYSQL_COM_STMT_EXECUTE)
+    {
+        zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
+                ZEND_STRL("affected_rows"), client->response.affected_rows TSRMLS_CC);
+        zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
+                ZEND_STRL("insert_id"), client->response.insert_id TSRMLS_CC);
+    }
+
+    client->state = SW_MYSQL_STATE_QUERY;
+
+    //OK
+    if (client->response.response_type == 0)
+    {
+        SW_ALLOC_INIT_ZVAL(result);
+        if (client->cmd == SW_MYSQL_COM_STMT_PREPARE)
+        {
+            if (client->statement_list == NULL)
+            {
+                client->statement_list = swLinkedList_new(0, NULL);
+            }
+            swLinkedList_append(client->statement_list, client->statement);
+            object_init_ex(result, swoole_mysql_coro_statement_class_entry_ptr);
+            swoole_set_object(result, client->statement);
+            client->statement->object = sw_zval_dup(result);
+#if PHP_MAJOR_VERSION >= 7
+            if (client->prepare_sql)
+            {
+                client->statement->sql = client->prepare_sql;
+                client->statement->sql_length = client->prepare_sql_length;
+                client->prepare_sql = NULL;
+                swoole_mysql_coro_statement_cache_add(client, client->statement);
+            }
+#endif
+        }
+        else
+        {
+            ZVAL_BOOL(result, 1);
+        }
+    }
+    //ERROR
+    else if (client->response.response_type == 255)
+    {
+        SW_ALLOC_INIT_ZVAL(result);
+        ZVAL_BOOL(result, 0);
+
+        zend_update_property_stringl(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("error"),
+                client->response.server_msg, client->response.l_server_msg TSRMLS_CC);
+        zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("errno"),
+                client->response.error_code TSRMLS_CC);
+
+        if (client->cmd == SW_MYSQL_COM_STMT_EXECUTE)
+        {
+            zend_update_property_stringl(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
+                    ZEND_STRL("error"), client->response.server_msg, client->response.l_server_msg TSRMLS_CC);
+            zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
+                    ZEND_STRL("errno"), client->response.error_code TSRMLS_CC);
+        }
+    }
+    //ResultSet
+    else
+    {
+        result = client->response.result_array;
+        result_set = 1;
+    }
+
+    swString_clear(client->buffer);
+    bzero(&client->response, sizeof(client->response));
+    if (client->prepare_sql)
+    {
+        efree(client->prepare_sql);
+        client->prepare_sql = NULL;
+    }
+    if (client->fetch_mode && result_set)
+    {
+        swoole_mysql_coro_fetch_deliver(client, result, 1 TSRMLS_CC);
+        return SW_OK;
+    }
+    if (client->defer && !client->suspending)
+    {
+        client->iowait = SW_MYSQL_CORO_STATUS_DONE;
+        client->result = result;
+        return SW_OK;
+    }
+    client->suspending = 0;
+    client->iowait = SW_MYSQL_CORO_STATUS_READY;
+    client->cid = 0;
+
+    php_context *sw_current_context = swoole_get_property(zobject, 0);
+    ret = coro_resume(sw_current_context, result, &retval);
+    if (result)
+    {
+        sw_zval_free(result);
+    }
+    if (ret == CORO_END && retval)
+    {
+        sw_zval_ptr_dtor(&retval);
+    }
+    return SW_OK;
+}
+
 static int swoole_mysql_coro_onRead(swReactor *reactor, swEvent *event)
 {
 #if PHP_MAJOR_VERSION < 7
@@ -1519,100 +2114,268 @@ static int swoole_mysql_coro_onRead(swReactor *reactor, swEvent *event)
             }
 
             parse_response:
-            if (mysql_response(client) < 0)
-            {
-                return SW_OK;
-            }
+            return swoole_mysql_coro_parse_response(client TSRMLS_CC);
+        }
+    }
+    return SW_OK;
+}
 
-            //remove from eventloop
-            //reactor->del(reactor, event->fd);
+#if PHP_MAJOR_VERSION >= 7
+static int swoole_mysql_coro_pool_check(mysql_coro_pool *pool, mysql_client *client)
+{
+    char c;
 
-            zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("affected_rows"),
-                    client->response.affected_rows TSRMLS_CC);
-            zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("insert_id"),
-                    client->response.insert_id TSRMLS_CC);
+    if (client == NULL || client->cli == NULL || client->state != SW_MYSQL_STATE_QUERY || client->transaction)
+    {
+        return SW_ERR;
+    }
+    //a deferred result was never received
+    if (client->iowait == SW_MYSQL_CORO_STATUS_WAIT || client->iowait == SW_MYSQL_CORO_STATUS_DONE)
+    {
+        return SW_ERR;
+    }
+    if (pool->idle_timeout > 0 && pool->count > pool->min && time(NULL) - client->idle_since > pool->idle_timeout)
+    {
+        return SW_ERR;
+    }
+    //the server has closed the idle connection or sent something unexpected
+    if (recv(client->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) >= 0 || (errno != EAGAIN && errno != EINTR))
+    {
+        return SW_ERR;
+    }
+    return SW_OK;
+}
 
-            if (client->cmd == SW_MYSQL_COM_STMT_EXECUTE)
-            {
-                zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
-                        ZEND_STRL("affected_rows"), client->response.affected_rows TSRMLS_CC);
-                zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
-                        ZEND_STRL("insert_id"), client->response.insert_id TSRMLS_CC);
-            }
+static void swoole_mysql_coro_pool_drop(zval *zconn)
+{
+    mysql_client *client = swoole_get_object(zconn);
+    if (client->cli)
+    {
+        swoole_mysql_coro_close(zconn);
+    }
+    swoole_mysql_coro_pool_release(client);
+}
 
-            client->state = SW_MYSQL_STATE_QUERY;
+static void swoole_mysql_coro_pool_close(mysql_coro_pool *pool)
+{
+    zval zconn;
 
-            //OK
-            if (client->response.response_type == 0)
-            {
-                SW_ALLOC_INIT_ZVAL(result);
-                if (client->cmd == SW_MYSQL_COM_STMT_PREPARE)
-                {
-                    if (client->statement_list == NULL)
-                    {
-                        client->statement_list = swLinkedList_new(0, NULL);
-                    }
-                    swLinkedList_append(client->statement_list, client->statement);
-                    object_init_ex(result, swoole_mysql_coro_statement_class_entry_ptr);
-                    swoole_set_object(result, client->statement);
-                    client->statement->object = sw_zval_dup(result);
-                }
-                else
-                {
-                    ZVAL_BOOL(result, 1);
-                }
-            }
-            //ERROR
-            else if (client->response.response_type == 255)
-            {
-                SW_ALLOC_INIT_ZVAL(result);
-                ZVAL_BOOL(result, 0);
+    pool->closed = 1;
+    while (php_swoole_channel_coro_try_pop(&pool->channel, &zconn) == SW_OK)
+    {
+        if (Z_TYPE(zconn) == IS_OBJECT)
+        {
+            swoole_mysql_coro_pool_drop(&zconn);
+        }
+        zval_ptr_dtor(&zconn);
+    }
+    //the waiting coroutines get false
+    php_swoole_channel_coro_close(&pool->channel);
+}
 
-                zend_update_property_stringl(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("error"),
-                        client->response.server_msg, client->response.l_server_msg TSRMLS_CC);
-                zend_update_property_long(swoole_mysql_coro_class_entry_ptr, zobject, ZEND_STRL("errno"),
-                        client->response.error_code TSRMLS_CC);
+static PHP_METHOD(swoole_mysql_coro_pool, __construct)
+{
+    zval *zconfig;
+    zval *zoptions = NULL;
+    zval *value;
+    zval zcapacity;
+    zval retval;
 
-                if (client->cmd == SW_MYSQL_COM_STMT_EXECUTE)
-                {
-                    zend_update_property_stringl(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
-                            ZEND_STRL("error"), client->response.server_msg, client->response.l_server_msg TSRMLS_CC);
-                    zend_update_property_long(swoole_mysql_coro_statement_class_entry_ptr, client->statement->object,
-                            ZEND_STRL("errno"), client->response.error_code TSRMLS_CC);
-                }
-            }
-            //ResultSet
-            else
-            {
-                result = client->response.result_array;
-            }
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a|a", &zconfig, &zoptions) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
 
-            swString_clear(client->buffer);
-            bzero(&client->response, sizeof(client->response));
-            if (client->defer && !client->suspending)
-            {
-                client->iowait = SW_MYSQL_CORO_STATUS_DONE;
-                client->result = result;
-                return SW_OK;
-            }
-            client->suspending = 0;
-            client->iowait = SW_MYSQL_CORO_STATUS_READY;
-            client->cid = 0;
+    mysql_coro_pool *pool = ecalloc(1, sizeof(mysql_coro_pool));
+    pool->max = SW_MYSQL_POOL_MAX;
 
-            php_context *sw_current_context = swoole_get_property(zobject, 0);
-            ret = coro_resume(sw_current_context, result, &retval);
-            if (result)
-            {
-                sw_zval_free(result);
-            }
-            if (ret == CORO_END && retval)
-            {
-                sw_zval_ptr_dtor(&retval);
-            }
-            return SW_OK;
+    if (zoptions)
+    {
+        php_swoole_array_separate(zoptions);
+        HashTable *vht = Z_ARRVAL_P(zoptions);
+        if (php_swoole_array_get_value(vht, "max", value))
+        {
+            convert_to_long(value);
+            pool->max = Z_LVAL_P(value) > 0 ? (uint32_t) Z_LVAL_P(value) : SW_MYSQL_POOL_MAX;
+        }
+        if (php_swoole_array_get_value(vht, "min", value))
+        {
+            convert_to_long(value);
+            pool->min = Z_LVAL_P(value) > 0 ? (uint32_t) Z_LVAL_P(value) : 0;
+        }
+        if (php_swoole_array_get_value(vht, "max_idle", value))
+        {
+            convert_to_long(value);
+            pool->max_idle = Z_LVAL_P(value) > 0 ? (uint32_t) Z_LVAL_P(value) : 0;
+        }
+        if (php_swoole_array_get_value(vht, "idle_timeout", value))
+        {
+            convert_to_double(value);
+            pool->idle_timeout = Z_DVAL_P(value);
         }
+        sw_zval_ptr_dtor(&zoptions);
     }
-    return SW_OK;
+    if (pool->min > pool->max)
+    {
+        pool->min = pool->max;
+    }
+    if (pool->max_idle == 0 || pool->max_idle > pool->max)
+    {
+        pool->max_idle = pool->max;
+    }
+
+    ZVAL_COPY(&pool->config, zconfig);
+
+    object_init_ex(&pool->channel, swoole_channel_coro_class_entry_ptr);
+    ZVAL_LONG(&zcapacity, pool->max);
+    zend_call_method_with_1_params(&pool->channel, swoole_channel_coro_class_entry_ptr, NULL, "__construct", &retval, &zcapacity);
+    zval_ptr_dtor(&retval);
+
+    swoole_set_object(getThis(), pool);
+}
+
+static PHP_METHOD(swoole_mysql_coro_pool, __destruct)
+{
+    mysql_coro_pool *pool = swoole_get_object(getThis());
+    if (!pool)
+    {
+        return;
+    }
+    if (!pool->closed)
+    {
+        swoole_mysql_coro_pool_close(pool);
+    }
+    zval_ptr_dtor(&pool->channel);
+    zval_ptr_dtor(&pool->config);
+    swoole_set_object(getThis(), NULL);
+    pool->destroyed = 1;
+    if (pool->refcount == 0)
+    {
+        efree(pool);
+    }
+}
+
+static PHP_METHOD(swoole_mysql_coro_pool, get)
+{
+    coro_check(TSRMLS_C);
+
+    mysql_coro_pool *pool = swoole_get_object(getThis());
+    mysql_client *client;
+    zval zconn;
+    zval retval;
+
+    if (!pool || pool->closed)
+    {
+        RETURN_FALSE;
+    }
+
+    while (php_swoole_channel_coro_try_pop(&pool->channel, &zconn) == SW_OK)
+    {
+        if (Z_TYPE(zconn) != IS_OBJECT)
+        {
+            continue;
+        }
+        if (swoole_mysql_coro_pool_check(pool, swoole_get_object(&zconn)) == SW_OK)
+        {
+            pool->reused++;
+            RETURN_ZVAL(&zconn, 0, 0);
+        }
+        swoole_mysql_coro_pool_drop(&zconn);
+        zval_ptr_dtor(&zconn);
+    }
+
+    //all connections are in use, wait for put()
+    if (pool->count >= pool->max)
+    {
+        php_swoole_channel_coro_pop(&pool->channel, return_value);
+        return;
+    }
+
+    object_init_ex(&zconn, swoole_mysql_coro_class_entry_ptr);
+    zend_call_method_with_0_params(&zconn, swoole_mysql_coro_class_entry_ptr, NULL, "__construct", &retval);
+    zval_ptr_dtor(&retval);
+
+    client = swoole_get_object(&zconn);
+    client->pool = pool;
+    client->pool_connecting = 1;
+    pool->refcount++;
+    pool->count++;
+    pool->created++;
+
+    //the coroutine yields, swoole_mysql_coro_onConnect returns the connection
+    swoole_mysql_coro_connect(&zconn, &pool->config, return_value TSRMLS_CC);
+
+    //failed before connecting, __destruct gives the slot back
+    client->pool_connecting = 0;
+    zval_ptr_dtor(&zconn);
+    RETURN_FALSE;
 }
 
+static PHP_METHOD(swoole_mysql_coro_pool, put)
+{
+    zval *zconn;
+    zval zfalse;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "O", &zconn, swoole_mysql_coro_class_entry_ptr) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+
+    mysql_coro_pool *pool = swoole_get_object(getThis());
+    mysql_client *client = swoole_get_object(zconn);
+    if (!pool || !client || client->pool != pool)
+    {
+        swoole_php_fatal_error(E_WARNING, "the connection does not belong to this pool.");
+        RETURN_FALSE;
+    }
+
+    swChannel *chan = swoole_get_object(&pool->channel);
+    client->idle_since = time(NULL);
+
+    if (pool->closed || swoole_mysql_coro_pool_check(pool, client) < 0
+            || (chan->num >= pool->max_idle && pool->count > pool->min)
+            || php_swoole_channel_coro_try_push(&pool->channel, zconn) < 0)
+    {
+        swoole_mysql_coro_pool_drop(zconn);
+        //no connection would be released to the waiting coroutine
+        if (!pool->closed && php_swoole_channel_coro_consumer_num(&pool->channel) > 0)
+        {
+            ZVAL_FALSE(&zfalse);
+            php_swoole_channel_coro_try_push(&pool->channel, &zfalse);
+        }
+    }
+    RETURN_TRUE;
+}
+
+static PHP_METHOD(swoole_mysql_coro_pool, close)
+{
+    mysql_coro_pool *pool = swoole_get_object(getThis());
+    if (!pool || pool->closed)
+    {
+        RETURN_FALSE;
+    }
+    swoole_mysql_coro_pool_close(pool);
+    RETURN_TRUE;
+}
+
+static PHP_METHOD(swoole_mysql_coro_pool, stats)
+{
+    mysql_coro_pool *pool = swoole_get_object(getThis());
+    if (!pool)
+    {
+        RETURN_FALSE;
+    }
+    swChannel *chan = swoole_get_object(&pool->channel);
+
+    array_init(return_value);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("connection_num"), pool->count);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("idle_num"), chan->num);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("waiting_num"), php_swoole_channel_coro_consumer_num(&pool->channel));
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("max"), pool->max);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("min"), pool->min);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("created"), pool->created);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("reused"), pool->reused);
+}
+#endif
+
 #endif
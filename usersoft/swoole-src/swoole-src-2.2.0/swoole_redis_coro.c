@@ -113,6 +113,10 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_coro_request, 0, 0, 1)
     ZEND_ARG_ARRAY_INFO(0, params, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_coro_batch, 0, 0, 1)
+    ZEND_ARG_ARRAY_INFO(0, commands, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_coro_incrByFloat, 0, 0, 2)
     ZEND_ARG_INFO(0, key)
     ZEND_ARG_INFO(0, float_number)
@@ -363,6 +367,10 @@ typedef struct
     zval *pipeline_result;
     zval *defer_result;
     zend_bool serialize;
+    /**
+     * replies are built as zvals by the hiredis reader, see swoole_redis_coro_reply_functions
+     */
+    zend_bool native_reply;
     int cid;
 
     double timeout;
@@ -399,6 +407,8 @@ static int swoole_redis_coro_onWrite(swReactor *reactor, swEvent *event);
 static int swoole_redis_coro_onError(swReactor *reactor, swEvent *event);
 static void swoole_redis_coro_onResult(redisAsyncContext *c, void *r, void *privdata);
 static void swoole_redis_coro_parse_result(swRedisClient *redis, zval* return_value, redisReply* reply TSRMLS_DC);
+static void swoole_redis_coro_reply_init(swRedisClient *redis);
+static void swoole_redis_coro_reply_default(swRedisClient *redis);
 
 static sw_inline void sw_redis_command_empty(INTERNAL_FUNCTION_PARAMETERS, char *cmd, int cmd_len)
 {
@@ -878,6 +888,7 @@ static PHP_METHOD(swoole_redis_coro, subscribe);
 static PHP_METHOD(swoole_redis_coro, pSubscribe);
 static PHP_METHOD(swoole_redis_coro, multi);
 static PHP_METHOD(swoole_redis_coro, exec);
+static PHP_METHOD(swoole_redis_coro, batch);
 static PHP_METHOD(swoole_redis_coro, eval);
 static PHP_METHOD(swoole_redis_coro, evalSha);
 static PHP_METHOD(swoole_redis_coro, script);
@@ -1035,6 +1046,7 @@ static const zend_function_entry swoole_redis_coro_methods[] =
     PHP_ME(swoole_redis_coro, subscribe, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_coro, multi, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_coro, exec, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_redis_coro, batch, arginfo_swoole_redis_coro_batch, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_coro, eval, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_coro, evalSha, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_coro, script, NULL, ZEND_ACC_PUBLIC)
@@ -1209,6 +1221,7 @@ static PHP_METHOD(swoole_redis_coro, connect)
     context->ev.delWrite = swoole_redis_coro_event_DelWrite;
     context->ev.cleanup = swoole_redis_coro_event_Cleanup;
     context->ev.data = redis;
+    swoole_redis_coro_reply_init(redis);
 
     zend_update_property_string(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("host"), host TSRMLS_CC);
     zend_update_property_long(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("port"), port TSRMLS_CC);
@@ -3531,6 +3544,9 @@ static PHP_METHOD(swoole_redis_coro, pSubscribe)
         break;
     }
 
+    //hiredis reads the subscribe replies as redisReply
+    swoole_redis_coro_reply_default(redis);
+
     HashTable *ht_chan = Z_ARRVAL_P(z_arr);
     int argc = 1 + zend_hash_num_elements(ht_chan), i = 0;
     SW_REDIS_COMMAND_ALLOC_ARGV
@@ -3606,6 +3622,9 @@ static PHP_METHOD(swoole_redis_coro, subscribe)
         break;
     }
 
+    //hiredis reads the subscribe replies as redisReply
+    swoole_redis_coro_reply_default(redis);
+
     HashTable *ht_chan = Z_ARRVAL_P(z_arr);
     int argc = 1 + zend_hash_num_elements(ht_chan), i = 0;
     SW_REDIS_COMMAND_ALLOC_ARGV
@@ -3713,6 +3732,118 @@ static PHP_METHOD(swoole_redis_coro, exec)
     coro_yield();
 }
 
+/**
+ * queue all commands before yielding once, hiredis appends them to one output buffer
+ * which is written by a single send, the replies are collected in pipeline mode
+ */
+static PHP_METHOD(swoole_redis_coro, batch)
+{
+    zval *commands;
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a", &commands) == FAILURE)
+    {
+        return;
+    }
+
+    SW_REDIS_COMMAND_CHECK
+
+    if (redis->state == SWOOLE_REDIS_CORO_STATE_MULTI || redis->state == SWOOLE_REDIS_CORO_STATE_PIPELINE)
+    {
+        zend_update_property_long(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errCode"), SW_REDIS_ERR_OTHER TSRMLS_CC);
+        zend_update_property_string(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errMsg"), "redis state mode is multi or pipeline, cann't use batch." TSRMLS_CC);
+        RETURN_FALSE;
+    }
+
+    int n = zend_hash_num_elements(Z_ARRVAL_P(commands));
+    if (n == 0)
+    {
+        array_init(return_value);
+        return;
+    }
+    if (n > 65535)
+    {
+        zend_update_property_long(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errCode"), SW_REDIS_ERR_OTHER TSRMLS_CC);
+        zend_update_property_string(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errMsg"), "too many commands in batch." TSRMLS_CC);
+        RETURN_FALSE;
+    }
+
+    zval *command;
+    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(commands), command)
+        if (Z_TYPE_P(command) != IS_ARRAY || zend_hash_num_elements(Z_ARRVAL_P(command)) == 0)
+        {
+            zend_update_property_long(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errCode"), SW_REDIS_ERR_OTHER TSRMLS_CC);
+            zend_update_property_string(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errMsg"), "each command must be a non-empty array." TSRMLS_CC);
+            RETURN_FALSE;
+        }
+    SW_HASHTABLE_FOREACH_END();
+
+    size_t stack_argvlen[SW_REDIS_COMMAND_BUFFER_SIZE];
+    char *stack_argv[SW_REDIS_COMMAND_BUFFER_SIZE];
+    zend_string *stack_strs[SW_REDIS_COMMAND_BUFFER_SIZE];
+    uint16_t queued = 0;
+    zval *value;
+
+    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(commands), command)
+        int argc = zend_hash_num_elements(Z_ARRVAL_P(command));
+        size_t *argvlen = stack_argvlen;
+        char **argv = stack_argv;
+        zend_string **strs = stack_strs;
+        int i = 0;
+
+        if (argc > SW_REDIS_COMMAND_BUFFER_SIZE)
+        {
+            argvlen = emalloc(sizeof(size_t) * argc);
+            argv = emalloc(sizeof(char*) * argc);
+            strs = emalloc(sizeof(zend_string*) * argc);
+        }
+        //string arguments are referenced, not copied
+        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(command), value)
+            strs[i] = zval_get_string(value);
+            argvlen[i] = strs[i]->len;
+            argv[i] = strs[i]->val;
+            i++;
+        SW_HASHTABLE_FOREACH_END();
+
+        int ret = redisAsyncCommandArgv(redis->context, swoole_redis_coro_onResult, NULL, argc, (const char **) argv, (const size_t *) argvlen);
+        for (i = 0; i < argc; i++)
+        {
+            zend_string_release(strs[i]);
+        }
+        if (argc > SW_REDIS_COMMAND_BUFFER_SIZE)
+        {
+            efree(argvlen);
+            efree(argv);
+            efree(strs);
+        }
+        if (ret < 0)
+        {
+            break;
+        }
+        queued++;
+    SW_HASHTABLE_FOREACH_END();
+
+    if (queued < n)
+    {
+        zend_update_property_long(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errCode"), SW_REDIS_ERR_OTHER TSRMLS_CC);
+        zend_update_property_string(swoole_redis_coro_class_entry_ptr, getThis(), ZEND_STRL("errMsg"), "redisAsyncCommandArgv() failed." TSRMLS_CC);
+        if (queued == 0)
+        {
+            RETURN_FALSE;
+        }
+    }
+
+    redis->state = SWOOLE_REDIS_CORO_STATE_PIPELINE;
+    redis->queued_cmd_count = queued;
+    redis->iowait = SW_REDIS_CORO_STATUS_WAIT;
+    if (redis->defer)
+    {
+        RETURN_TRUE;
+    }
+    redis->cid = get_current_cid();
+    php_context *context = swoole_get_property(getThis(), 0);
+    coro_save(context);
+    coro_yield();
+}
+
 static PHP_METHOD(swoole_redis_coro, request)
 {
     SW_REDIS_COMMAND_CHECK
@@ -3939,6 +4070,156 @@ static PHP_METHOD(swoole_redis_coro, script)
     }
 }
 
+#if PHP_MAJOR_VERSION >= 7
+/**
+ * hiredis reader callbacks, replies are decoded straight into zvals instead of redisReply trees,
+ * nested values live in the slots of the parent array which is sized up front
+ */
+static void* swoole_redis_coro_reply_store(const redisReadTask *task, zval *value)
+{
+    zval *obj;
+    if (task->parent)
+    {
+        obj = zend_hash_index_update(Z_ARRVAL_P((zval *) task->parent->obj), task->idx, value);
+    }
+    else
+    {
+        obj = emalloc(sizeof(zval));
+        ZVAL_COPY_VALUE(obj, value);
+    }
+    return obj;
+}
+
+static void* swoole_redis_coro_reply_string(const redisReadTask *task, char *str, size_t len)
+{
+    swRedisClient *redis = task->privdata;
+    zval value;
+    long l;
+
+    switch (task->type)
+    {
+    case REDIS_REPLY_ERROR:
+        ZVAL_FALSE(&value);
+        zend_update_property_long(swoole_redis_coro_class_entry_ptr, redis->object, ZEND_STRL("errCode"), SW_REDIS_ERR_OTHER);
+        zend_update_property_stringl(swoole_redis_coro_class_entry_ptr, redis->object, ZEND_STRL("errMsg"), str, len);
+        break;
+
+    case REDIS_REPLY_STATUS:
+        if (len == 0)
+        {
+            ZVAL_TRUE(&value);
+            break;
+        }
+        if (strncmp(str, "OK", 2) == 0)
+        {
+            ZVAL_TRUE(&value);
+            break;
+        }
+        if (strncmp(str, "string", 6) == 0) {
+            l = SW_REDIS_STRING;
+        } else if (strncmp(str, "set", 3) == 0){
+            l = SW_REDIS_SET;
+        } else if (strncmp(str, "list", 4) == 0){
+            l = SW_REDIS_LIST;
+        } else if (strncmp(str, "zset", 4) == 0){
+            l = SW_REDIS_ZSET;
+        } else if (strncmp(str, "hash", 4) == 0){
+            l = SW_REDIS_HASH;
+        } else {
+            l = SW_REDIS_NOT_FOUND;
+        }
+        ZVAL_LONG(&value, l);
+        break;
+
+    default:
+        if (redis->serialize)
+        {
+            const unsigned char *p = (const unsigned char *) str;
+            php_unserialize_data_t s_ht;
+            PHP_VAR_UNSERIALIZE_INIT(s_ht);
+            if (!php_var_unserialize(&value, &p, (const unsigned char *) str + len, &s_ht))
+            {
+                ZVAL_STRINGL(&value, str, len);
+            }
+            PHP_VAR_UNSERIALIZE_DESTROY(s_ht);
+        }
+        else
+        {
+            ZVAL_STRINGL(&value, str, len);
+        }
+        break;
+    }
+    return swoole_redis_coro_reply_store(task, &value);
+}
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+static void* swoole_redis_coro_reply_array(const redisReadTask *task, size_t elements)
+#else
+static void* swoole_redis_coro_reply_array(const redisReadTask *task, int elements)
+#endif
+{
+    zval value;
+    array_init_size(&value, elements);
+    zend_hash_real_init(Z_ARRVAL(value), 1);
+    return swoole_redis_coro_reply_store(task, &value);
+}
+
+static void* swoole_redis_coro_reply_integer(const redisReadTask *task, long long integer)
+{
+    zval value;
+    ZVAL_LONG(&value, integer);
+    return swoole_redis_coro_reply_store(task, &value);
+}
+
+static void* swoole_redis_coro_reply_nil(const redisReadTask *task)
+{
+    zval value;
+    ZVAL_NULL(&value);
+    return swoole_redis_coro_reply_store(task, &value);
+}
+
+static void swoole_redis_coro_reply_free(void *reply)
+{
+    zval_ptr_dtor((zval *) reply);
+    efree(reply);
+}
+
+static redisReplyObjectFunctions swoole_redis_coro_reply_functions;
+#endif
+
+static void swoole_redis_coro_reply_init(swRedisClient *redis)
+{
+#if PHP_MAJOR_VERSION >= 7
+    redisReader *reader = redis->context->c.reader;
+    if (!swoole_redis_coro_reply_functions.freeObject)
+    {
+        swoole_redis_coro_reply_functions.createString = swoole_redis_coro_reply_string;
+        swoole_redis_coro_reply_functions.createArray = swoole_redis_coro_reply_array;
+        swoole_redis_coro_reply_functions.createInteger = swoole_redis_coro_reply_integer;
+        swoole_redis_coro_reply_functions.createNil = swoole_redis_coro_reply_nil;
+        swoole_redis_coro_reply_functions.freeObject = swoole_redis_coro_reply_free;
+    }
+    reader->fn = &swoole_redis_coro_reply_functions;
+    reader->privdata = redis;
+    redis->native_reply = 1;
+#endif
+}
+
+static void swoole_redis_coro_reply_default(swRedisClient *redis)
+{
+#if PHP_MAJOR_VERSION >= 7
+    if (redis->native_reply)
+    {
+        //the default functions are private to hiredis, take them from a fresh reader
+        redisReader *reader = redisReaderCreate();
+        redis->context->c.reader->fn = reader->fn;
+        redis->context->c.reader->privdata = NULL;
+        redisReaderFree(reader);
+        redis->native_reply = 0;
+    }
+#endif
+}
+
 static void swoole_redis_coro_parse_result(swRedisClient *redis, zval* return_value, redisReply* reply TSRMLS_DC)
 {
     zval *val;
@@ -4126,7 +4407,18 @@ static void swoole_redis_coro_onResult(redisAsyncContext *c, void *r, void *priv
     }
     else
     {
-        swoole_redis_coro_parse_result(redis, result->value, reply TSRMLS_CC);
+#if PHP_MAJOR_VERSION >= 7
+        if (redis->native_reply)
+        {
+            //take the value, hiredis frees the empty reply after this callback
+            ZVAL_COPY_VALUE(result->value, (zval *) r);
+            ZVAL_NULL((zval *) r);
+        }
+        else
+#endif
+        {
+            swoole_redis_coro_parse_result(redis, result->value, reply TSRMLS_CC);
+        }
 
         switch (redis->state)
         {
@@ -26,6 +26,7 @@ static zend_class_entry swoole_redis_server_ce;
 static zend_class_entry *swoole_redis_server_class_entry_ptr;
 
 static swString *format_buffer;
+static swString *reply_buffer;
 #ifdef SW_COROUTINE
 static struct
 {
@@ -37,6 +38,7 @@ static struct
 
 static PHP_METHOD(swoole_redis_server, start);
 static PHP_METHOD(swoole_redis_server, setHandler);
+static PHP_METHOD(swoole_redis_server, setBatchHandler);
 static PHP_METHOD(swoole_redis_server, format);
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_server_start, 0, 0, 0)
@@ -49,6 +51,10 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_server_setHandler, 0, 0, 2)
     ZEND_ARG_INFO(0, type_of_array_param)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_server_setBatchHandler, 0, 0, 1)
+    ZEND_ARG_INFO(0, callback)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_redis_server_format, 0, 0, 1)
     ZEND_ARG_INFO(0, type)
     ZEND_ARG_INFO(0, value)
@@ -58,6 +64,7 @@ const zend_function_entry swoole_redis_server_methods[] =
 {
     PHP_ME(swoole_redis_server, start, arginfo_swoole_redis_server_start, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_server, setHandler, arginfo_swoole_redis_server_setHandler, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_redis_server, setBatchHandler, arginfo_swoole_redis_server_setBatchHandler, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_redis_server, format, arginfo_swoole_redis_server_format, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_FE_END
 };
@@ -82,173 +89,484 @@ void swoole_redis_server_init(int module_number TSRMLS_DC)
     zend_declare_class_constant_long(swoole_redis_server_class_entry_ptr, SW_STRL("MAP")-1, SW_REDIS_REPLY_MAP TSRMLS_CC);
 }
 
-static int redis_onReceive(swServer *serv, swEventData *req)
+static int redis_format(swString *buffer, long type, zval *value TSRMLS_DC)
 {
-    if (swEventData_is_dgram(req->info.type))
+    char message[256];
+    int length;
+    zval *item;
+
+    if (type == SW_REDIS_REPLY_NIL)
     {
-        return php_swoole_onReceive(serv, req);
+        swString_append_ptr(buffer, SW_REDIS_RETURN_NIL, sizeof(SW_REDIS_RETURN_NIL)-1);
     }
-
-    int fd = req->info.fd;
-    swConnection *conn = swWorker_get_connection(SwooleG.serv, fd);
-    if (!conn)
+    else if (type == SW_REDIS_REPLY_STATUS)
     {
-        swWarn("connection[%d] is closed.", fd);
-        return SW_ERR;
+        if (value)
+        {
+            convert_to_string(value);
+            length = snprintf(message, sizeof(message), "+%*s\r\n", Z_STRLEN_P(value), Z_STRVAL_P(value));
+        }
+        else
+        {
+            length = snprintf(message, sizeof(message), "+%s\r\n", "OK");
+        }
+        swString_append_ptr(buffer, message, length);
+    }
+    else if (type == SW_REDIS_REPLY_ERROR)
+    {
+        if (value)
+        {
+            convert_to_string(value);
+            length = snprintf(message, sizeof(message), "-%*s\r\n", Z_STRLEN_P(value), Z_STRVAL_P(value));
+        }
+        else
+        {
+            length = snprintf(message, sizeof(message), "-%s\r\n", "ERR");
+        }
+        swString_append_ptr(buffer, message, length);
     }
+    else if (type == SW_REDIS_REPLY_INT)
+    {
+        if (!value)
+        {
+            goto no_value;
+        }
 
-    swListenPort *port = serv->connection_list[req->info.from_fd].object;
-    //other server port
-    if (!port->open_redis_protocol)
+        convert_to_long(value);
+        length = snprintf(message, sizeof(message), ":%d\r\n", Z_LVAL_P(value));
+        swString_append_ptr(buffer, message, length);
+    }
+    else if (type == SW_REDIS_REPLY_STRING)
     {
-        return php_swoole_onReceive(serv, req);
+        if (!value)
+        {
+            no_value:
+            swoole_php_fatal_error(E_WARNING, "require more parameters.");
+            return SW_ERR;
+        }
+        convert_to_string(value);
+        if (Z_STRLEN_P(value) > SW_REDIS_MAX_STRING_SIZE || Z_STRLEN_P(value) < 1)
+        {
+            swoole_php_fatal_error(E_WARNING, "invalid string size.");
+            return SW_ERR;
+        }
+        length = snprintf(message, sizeof(message), "$%d\r\n", Z_STRLEN_P(value));
+        swString_append_ptr(buffer, message, length);
+        swString_append_ptr(buffer, Z_STRVAL_P(value), Z_STRLEN_P(value));
+        swString_append_ptr(buffer, SW_CRLF, SW_CRLF_LEN);
     }
+    else if (type == SW_REDIS_REPLY_SET)
+    {
+        if (!value)
+        {
+            goto no_value;
+        }
+        if (Z_TYPE_P(value) != IS_ARRAY)
+        {
+            swoole_php_fatal_error(E_WARNING, "the second parameter should be an array.");
+            return SW_ERR;
+        }
+        length = snprintf(message, sizeof(message), "*%d\r\n", zend_hash_num_elements(Z_ARRVAL_P(value)));
+        swString_append_ptr(buffer, message, length);
 
-    SWOOLE_GET_TSRMLS;
+        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(value), item)
+#if PHP_MAJOR_VERSION >= 7
+            zval _copy;
+            if (Z_TYPE_P(item) != IS_STRING)
+            {
+                _copy = *item;
+                zval_copy_ctor(&_copy);
+                item = &_copy;
+            }
+#endif
+            convert_to_string(item);
+            length = snprintf(message, sizeof(message), "$%d\r\n", Z_STRLEN_P(item));
+            swString_append_ptr(buffer, message, length);
+            swString_append_ptr(buffer, Z_STRVAL_P(item), Z_STRLEN_P(item));
+            swString_append_ptr(buffer, SW_CRLF, SW_CRLF_LEN);
+#if PHP_MAJOR_VERSION >= 7
+            if (item == &_copy)
+            {
+                zval_dtor(item);
+            }
+#endif
+        SW_HASHTABLE_FOREACH_END();
+    }
+    else if (type == SW_REDIS_REPLY_MAP)
+    {
+        if (!value)
+        {
+            goto no_value;
+        }
+        if (Z_TYPE_P(value) != IS_ARRAY)
+        {
+            swoole_php_fatal_error(E_WARNING, "the second parameter should be an array.");
+            return SW_ERR;
+        }
+        length = snprintf(message, sizeof(message), "*%d\r\n", 2 * zend_hash_num_elements(Z_ARRVAL_P(value)));
+        swString_append_ptr(buffer, message, length);
 
-    zval *zdata;
-    SW_MAKE_STD_ZVAL(zdata);
-    php_swoole_get_recv_data(zdata, req, NULL, 0);
-    char *p = Z_STRVAL_P(zdata);
-    char *pe = p + Z_STRLEN_P(zdata);
-    int ret;
-    int length = 0;
+        char *key;
+        uint32_t keylen;
+        int keytype;
 
-    zval *zparams;
-    SW_MAKE_STD_ZVAL(zparams);
-    array_init(zparams);
+        SW_HASHTABLE_FOREACH_START2(Z_ARRVAL_P(value), key, keylen, keytype, item)
+            if (key == NULL || keylen <= 0)
+            {
+                continue;
+            }
+#if PHP_MAJOR_VERSION >= 7
+            zval _copy;
+            if (Z_TYPE_P(item) != IS_STRING)
+            {
+                _copy = *item;
+                zval_copy_ctor(&_copy);
+                item = &_copy;
+            }
+#endif
+            convert_to_string(item);
+            length = snprintf(message, sizeof(message), "$%d\r\n%s\r\n$%d\r\n", keylen, key, Z_STRLEN_P(item));
+            swString_append_ptr(buffer, message, length);
+            swString_append_ptr(buffer, Z_STRVAL_P(item), Z_STRLEN_P(item));
+            swString_append_ptr(buffer, SW_CRLF, SW_CRLF_LEN);
 
-    zval *retval = NULL;
+#if PHP_MAJOR_VERSION >= 7
+            if (item == &_copy)
+            {
+                zval_dtor(item);
+            }
+#endif
+            (void) keytype;
+        SW_HASHTABLE_FOREACH_END();
+    }
+    else
+    {
+        swoole_php_error(E_WARNING, "Unknown type[%ld]", type);
+        return SW_ERR;
+    }
+    return SW_OK;
+}
 
-    int state = SW_REDIS_RECEIVE_TOTAL_LINE;
-    int add_param = 0;
-    char *command = NULL;
-    int command_len = 0;
+/**
+ * a reply of the batch handler is a formatted string, null or a [type, value] pair
+ */
+static void redis_append_reply(swString *buffer, zval *zreply TSRMLS_DC)
+{
+    zval *item;
+    zval *ztype = NULL;
+    zval *zvalue = NULL;
+    size_t offset = buffer->length;
+    int ret;
 
-    do
+    switch (Z_TYPE_P(zreply))
     {
-        switch (state)
-        {
-        case SW_REDIS_RECEIVE_TOTAL_LINE:
-            if (*p == '*' && (p = swRedis_get_number(p, &ret)))
+    case IS_STRING:
+        swString_append_ptr(buffer, Z_STRVAL_P(zreply), Z_STRLEN_P(zreply));
+        return;
+    case IS_NULL:
+        swString_append_ptr(buffer, SW_REDIS_RETURN_NIL, sizeof(SW_REDIS_RETURN_NIL)-1);
+        return;
+    case IS_ARRAY:
+        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(zreply), item)
+            if (ztype == NULL)
             {
-                state = SW_REDIS_RECEIVE_LENGTH;
-                break;
+                ztype = item;
             }
-            /* no break */
+            else if (zvalue == NULL)
+            {
+                zvalue = item;
+            }
+        SW_HASHTABLE_FOREACH_END();
+        if (ztype == NULL || Z_TYPE_P(ztype) != IS_LONG)
+        {
+            break;
+        }
+#if PHP_MAJOR_VERSION >= 7
+        //the reply may be shared, the scalar values are converted on a copy
+        zval _copy;
+        if (zvalue && Z_TYPE_P(zvalue) != IS_ARRAY)
+        {
+            _copy = *zvalue;
+            zval_copy_ctor(&_copy);
+            zvalue = &_copy;
+        }
+#endif
+        ret = redis_format(buffer, Z_LVAL_P(ztype), zvalue TSRMLS_CC);
+#if PHP_MAJOR_VERSION >= 7
+        if (zvalue == &_copy)
+        {
+            zval_dtor(zvalue);
+        }
+#endif
+        if (ret == SW_OK)
+        {
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    //the client expects one reply per command
+    buffer->length = offset;
+    swString_append_ptr(buffer, ZEND_STRL("-ERR invalid reply\r\n"));
+}
 
-        case SW_REDIS_RECEIVE_LENGTH:
-            if (*p == '$' && (p = swRedis_get_number(p, &ret)))
+/**
+ * parse the command at p into zparams, return the start of the next command
+ */
+static char* redis_parse_command(char *p, char *pe, zval *zparams, char **command, int *command_len, int add_command)
+{
+    int n_lines, length, i;
+
+    *command = NULL;
+    *command_len = 0;
+
+    if (*p != '*' || (p = swRedis_get_number(p, &n_lines)) == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < n_lines && p < pe; i++)
+    {
+        switch (*p)
+        {
+        case '$':
+            if ((p = swRedis_get_number(p, &length)) == NULL)
             {
-                if (ret == -1)
-                {
-                    add_next_index_null(zparams);
-                    break;
-                }
-                length = ret;
-                state = SW_REDIS_RECEIVE_STRING;
-                break;
+                return NULL;
             }
-            //integer
-            else if (*p == ':' && (p = swRedis_get_number(p, &ret)))
+            if (length < 0)
             {
-                add_next_index_long(zparams, ret);
+                add_next_index_null(zparams);
                 break;
             }
-            /* no break */
-
-        case SW_REDIS_RECEIVE_STRING:
-            if (add_param == 0)
+            if (*command == NULL)
             {
-                command = p;
-                command_len = length;
-                add_param = 1;
+                *command = p;
+                *command_len = length;
+                if (add_command)
+                {
+                    php_strtolower(p, length);
+                    sw_add_next_index_stringl(zparams, p, length, 1);
+                }
             }
             else
             {
                 sw_add_next_index_stringl(zparams, p, length, 1);
             }
             p += length + SW_CRLF_LEN;
-            state = SW_REDIS_RECEIVE_LENGTH;
             break;
-
-        default:
+        //integer
+        case ':':
+            if ((p = swRedis_get_number(p, &length)) == NULL)
+            {
+                return NULL;
+            }
+            add_next_index_long(zparams, length);
             break;
+        default:
+            return NULL;
         }
-    } while(p < pe);
+    }
 
-    if (command_len >= SW_REDIS_MAX_COMMAND_SIZE)
+    if (*command == NULL)
     {
-        swoole_php_error(E_WARNING, "command is too long.");
-        serv->close(serv, fd, 0);
-        return SW_OK;
+        return NULL;
     }
+    return p;
+}
 
-    char _command[SW_REDIS_MAX_COMMAND_SIZE];
-    command[command_len] = 0;
-    int _command_len = snprintf(_command, sizeof(_command), "_handler_%*s", command_len, command);
-    php_strtolower(_command, _command_len);
-
-    zval *zobject = serv->ptr2;
-    char err_msg[256];
-
-    zval *zfd;
-    SW_MAKE_STD_ZVAL(zfd);
-    ZVAL_LONG(zfd, fd);
-
+static int redis_call_handler(zval *zhandler, zval *zfd, zval *zparams, zval **retval TSRMLS_DC)
+{
 #ifndef SW_COROUTINE
     zval **args[2];
-    zval *zcallback = sw_zend_read_property(swoole_redis_server_class_entry_ptr, zobject, _command, _command_len, 1 TSRMLS_CC);
-    if (!zcallback || ZVAL_IS_NULL(zcallback))
-    {
-        length = snprintf(err_msg, sizeof(err_msg), "-ERR unknown command '%*s'\r\n", command_len, command);
-        swServer_tcp_send(serv, fd, err_msg, length);
-        return SW_OK;
-    }
     args[0] = &zfd;
     args[1] = &zparams;
 
-    if (sw_call_user_function_ex(EG(function_table), NULL, zcallback, &retval, 2, args, 0, NULL TSRMLS_CC) == FAILURE)
+    if (sw_call_user_function_ex(EG(function_table), NULL, zhandler, retval, 2, args, 0, NULL TSRMLS_CC) == FAILURE)
     {
         swoole_php_error(E_WARNING, "command handler error.");
     }
 #else
-    zval *index = sw_zend_read_property(swoole_redis_server_class_entry_ptr, zobject, _command, _command_len, 1 TSRMLS_CC);
-    if (!index || ZVAL_IS_NULL(index))
-    {
-        length = snprintf(err_msg, sizeof(err_msg), "-ERR unknown command '%*s'\r\n", command_len, command);
-        swServer_tcp_send(serv, fd, err_msg, length);
-        return SW_OK;
-    }
     zval *args[2];
     args[0] = zfd;
     args[1] = zparams;
 
-    zend_fcall_info_cache *cache = func_cache_array.array[Z_LVAL_P(index)];
-    if (coro_create(cache, args, 2, &retval, NULL, NULL) != 0)
+    zend_fcall_info_cache *cache = func_cache_array.array[Z_LVAL_P(zhandler)];
+    if (coro_create(cache, args, 2, retval, NULL, NULL) != 0)
     {
-        sw_zval_ptr_dtor(&zfd);
-        sw_zval_ptr_dtor(&zdata);
-        sw_zval_ptr_dtor(&zparams);
-        return SW_OK;
+        return SW_ERR;
     }
 #endif
     if (EG(exception))
     {
         zend_exception_error(EG(exception), E_ERROR TSRMLS_CC);
     }
-    //free the callback return value
-    if (retval != NULL)
+    return SW_OK;
+}
+
+static int redis_onReceive(swServer *serv, swEventData *req)
+{
+    if (swEventData_is_dgram(req->info.type))
+    {
+        return php_swoole_onReceive(serv, req);
+    }
+
+    int fd = req->info.fd;
+    swConnection *conn = swWorker_get_connection(SwooleG.serv, fd);
+    if (!conn)
+    {
+        swWarn("connection[%d] is closed.", fd);
+        return SW_ERR;
+    }
+
+    swListenPort *port = serv->connection_list[req->info.from_fd].object;
+    //other server port
+    if (!port->open_redis_protocol)
     {
-        if (Z_TYPE_P(retval) == IS_STRING)
+        return php_swoole_onReceive(serv, req);
+    }
+
+    SWOOLE_GET_TSRMLS;
+
+    zval *zdata;
+    SW_MAKE_STD_ZVAL(zdata);
+    php_swoole_get_recv_data(zdata, req, NULL, 0);
+    char *p = Z_STRVAL_P(zdata);
+    char *pe = p + Z_STRLEN_P(zdata);
+    int length;
+
+    zval *retval = NULL;
+    zval *zobject = serv->ptr2;
+    char *command = NULL;
+    int command_len = 0;
+    char err_msg[256];
+
+    zval *zfd;
+    SW_MAKE_STD_ZVAL(zfd);
+    ZVAL_LONG(zfd, fd);
+
+    /**
+     * the packet holds all the commands the client has pipelined,
+     * their replies are sent back together with one write
+     */
+    swString_clear(reply_buffer);
+
+    zval *zbatch_handler = sw_zend_read_property(swoole_redis_server_class_entry_ptr, zobject, ZEND_STRL("_batch_handler"), 1 TSRMLS_CC);
+    if (zbatch_handler && !ZVAL_IS_NULL(zbatch_handler))
+    {
+        zval *zcommands;
+        SW_MAKE_STD_ZVAL(zcommands);
+        array_init(zcommands);
+
+        while (p < pe)
+        {
+            zval *zcommand;
+            SW_MAKE_STD_ZVAL(zcommand);
+            array_init(zcommand);
+            p = redis_parse_command(p, pe, zcommand, &command, &command_len, 1);
+            add_next_index_zval(zcommands, zcommand);
+            if (p == NULL)
+            {
+                swoole_php_error(E_WARNING, "redis protocol error.");
+                serv->close(serv, fd, 0);
+                goto free_commands;
+            }
+        }
+
+        if (redis_call_handler(zbatch_handler, zfd, zcommands, &retval TSRMLS_CC) < 0)
+        {
+            goto free_commands;
+        }
+        if (retval != NULL)
+        {
+            if (Z_TYPE_P(retval) == IS_ARRAY)
+            {
+                zval *zreply;
+                SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(retval), zreply)
+                    redis_append_reply(reply_buffer, zreply TSRMLS_CC);
+                SW_HASHTABLE_FOREACH_END();
+            }
+            else if (Z_TYPE_P(retval) == IS_STRING)
+            {
+                swString_append_ptr(reply_buffer, Z_STRVAL_P(retval), Z_STRLEN_P(retval));
+            }
+            sw_zval_ptr_dtor(&retval);
+        }
+        if (reply_buffer->length > 0)
+        {
+            serv->send(serv, fd, reply_buffer->str, reply_buffer->length);
+        }
+
+        free_commands:
+        sw_zval_ptr_dtor(&zcommands);
+        sw_zval_ptr_dtor(&zfd);
+        sw_zval_ptr_dtor(&zdata);
+        return SW_OK;
+    }
+
+    while (p < pe)
+    {
+        zval *zparams;
+        SW_MAKE_STD_ZVAL(zparams);
+        array_init(zparams);
+
+        p = redis_parse_command(p, pe, zparams, &command, &command_len, 0);
+        if (p == NULL)
         {
-            serv->send(serv, fd, Z_STRVAL_P(retval), Z_STRLEN_P(retval));
+            swoole_php_error(E_WARNING, "redis protocol error.");
+            serv->close(serv, fd, 0);
+            swString_clear(reply_buffer);
+            sw_zval_ptr_dtor(&zparams);
+            break;
+        }
+        if (command_len >= SW_REDIS_MAX_COMMAND_SIZE)
+        {
+            swoole_php_error(E_WARNING, "command is too long.");
+            serv->close(serv, fd, 0);
+            swString_clear(reply_buffer);
+            sw_zval_ptr_dtor(&zparams);
+            break;
         }
-        sw_zval_ptr_dtor(&retval);
+
+        char _command[SW_REDIS_MAX_COMMAND_SIZE];
+        int _command_len = snprintf(_command, sizeof(_command), "_handler_%.*s", command_len, command);
+        php_strtolower(_command, _command_len);
+
+        zval *zhandler = sw_zend_read_property(swoole_redis_server_class_entry_ptr, zobject, _command, _command_len, 1 TSRMLS_CC);
+        if (!zhandler || ZVAL_IS_NULL(zhandler))
+        {
+            length = snprintf(err_msg, sizeof(err_msg), "-ERR unknown command '%.*s'\r\n", command_len, command);
+            swString_append_ptr(reply_buffer, err_msg, length);
+            sw_zval_ptr_dtor(&zparams);
+            continue;
+        }
+
+        if (redis_call_handler(zhandler, zfd, zparams, &retval TSRMLS_CC) < 0)
+        {
+            sw_zval_ptr_dtor(&zparams);
+            continue;
+        }
+        //free the callback return value
+        if (retval != NULL)
+        {
+            if (Z_TYPE_P(retval) == IS_STRING)
+            {
+                swString_append_ptr(reply_buffer, Z_STRVAL_P(retval), Z_STRLEN_P(retval));
+            }
+            sw_zval_ptr_dtor(&retval);
+            retval = NULL;
+        }
+        sw_zval_ptr_dtor(&zparams);
+    }
+
+    if (reply_buffer->length > 0)
+    {
+        serv->send(serv, fd, reply_buffer->str, reply_buffer->length);
     }
     sw_zval_ptr_dtor(&zfd);
     sw_zval_ptr_dtor(&zdata);
-    sw_zval_ptr_dtor(&zparams);
     return SW_OK;
 }
 
@@ -274,6 +592,13 @@ static PHP_METHOD(swoole_redis_server, start)
         RETURN_FALSE;
     }
 
+    reply_buffer = swString_new(SW_BUFFER_SIZE_STD);
+    if (!reply_buffer)
+    {
+        swoole_php_fatal_error(E_ERROR, "[2] swString_new(%d) failed.", SW_BUFFER_SIZE_STD);
+        RETURN_FALSE;
+    }
+
     zval *zsetting = sw_zend_read_property(swoole_server_class_entry_ptr, getThis(), ZEND_STRL("setting"), 1 TSRMLS_CC);
     if (zsetting == NULL || ZVAL_IS_NULL(zsetting))
     {
@@ -309,23 +634,8 @@ static PHP_METHOD(swoole_redis_server, start)
     RETURN_TRUE;
 }
 
-static PHP_METHOD(swoole_redis_server, setHandler)
+static int redis_set_handler(zval *zobject, char *name, int name_len, zval *zcallback TSRMLS_DC)
 {
-    char *command;
-    zend_size_t command_len;
-    zval *zcallback;
-
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sz", &command, &command_len, &zcallback) == FAILURE)
-    {
-        return;
-    }
-
-    if (command_len <= 0 || command_len >= SW_REDIS_MAX_COMMAND_SIZE)
-    {
-        swoole_php_fatal_error(E_ERROR, "invalid command.");
-        RETURN_FALSE;
-    }
-
 #ifdef PHP_SWOOLE_CHECK_CALLBACK
     char *func_name = NULL;
 #ifdef SW_COROUTINE
@@ -343,14 +653,11 @@ static PHP_METHOD(swoole_redis_server, setHandler)
     {
         swoole_php_fatal_error(E_ERROR, "function '%s' is not callable", func_name);
         efree(func_name);
-        return;
+        return SW_ERR;
     }
     efree(func_name);
 #endif
 
-    char _command[SW_REDIS_MAX_COMMAND_SIZE];
-    int length = snprintf(_command, sizeof(_command), "_handler_%s", command);
-    php_strtolower(_command, length);
 #ifdef SW_COROUTINE
     int func_cache_index = func_cache_array.count;
     func_cache_array.array[func_cache_index] = func_cache;
@@ -358,184 +665,77 @@ static PHP_METHOD(swoole_redis_server, setHandler)
     if (func_cache_array.count == func_cache_array.size)
     {
         func_cache_array.size *= 2;
-        func_cache_array.array = ecalloc(func_cache_array.size, sizeof(zend_fcall_info_cache *));
+        func_cache_array.array = erealloc(func_cache_array.array, func_cache_array.size * sizeof(zend_fcall_info_cache *));
     }
     sw_zval_add_ref(&zcallback);
-    zend_update_property_long(swoole_redis_server_class_entry_ptr, getThis(), _command, length, func_cache_index TSRMLS_CC);
+    zend_update_property_long(swoole_redis_server_class_entry_ptr, zobject, name, name_len, func_cache_index TSRMLS_CC);
 #else
-    php_strtolower(_command, length);
-    zend_update_property(swoole_redis_server_class_entry_ptr, getThis(), _command, length, zcallback TSRMLS_CC);
+    zend_update_property(swoole_redis_server_class_entry_ptr, zobject, name, name_len, zcallback TSRMLS_CC);
 #endif
-    RETURN_TRUE;
+    return SW_OK;
 }
 
-static PHP_METHOD(swoole_redis_server, format)
+static PHP_METHOD(swoole_redis_server, setHandler)
 {
-    long type;
-    zval *value = NULL;
+    char *command;
+    zend_size_t command_len;
+    zval *zcallback;
 
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|z", &type, &value) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sz", &command, &command_len, &zcallback) == FAILURE)
     {
         return;
     }
 
-    char message[256];
-    int length;
-    zval *item;
-
-    if (type == SW_REDIS_REPLY_NIL)
+    if (command_len <= 0 || command_len >= SW_REDIS_MAX_COMMAND_SIZE)
     {
-        SW_RETURN_STRINGL(SW_REDIS_RETURN_NIL, sizeof(SW_REDIS_RETURN_NIL)-1, 1);
+        swoole_php_fatal_error(E_ERROR, "invalid command.");
+        RETURN_FALSE;
     }
-    else if (type == SW_REDIS_REPLY_STATUS)
+
+    char _command[SW_REDIS_MAX_COMMAND_SIZE];
+    int length = snprintf(_command, sizeof(_command), "_handler_%s", command);
+    php_strtolower(_command, length);
+
+    if (redis_set_handler(getThis(), _command, length, zcallback TSRMLS_CC) < 0)
     {
-        if (value)
-        {
-            convert_to_string(value);
-            length = snprintf(message, sizeof(message), "+%*s\r\n", Z_STRLEN_P(value), Z_STRVAL_P(value));
-        }
-        else
-        {
-            length = snprintf(message, sizeof(message), "+%s\r\n", "OK");
-        }
-        SW_RETURN_STRINGL(message, length, 1);
+        return;
     }
-    else if (type == SW_REDIS_REPLY_ERROR)
+    RETURN_TRUE;
+}
+
+/**
+ * the batch handler is called once per packet with all the pipelined commands
+ */
+static PHP_METHOD(swoole_redis_server, setBatchHandler)
+{
+    zval *zcallback;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &zcallback) == FAILURE)
     {
-        if (value)
-        {
-            convert_to_string(value);
-            length = snprintf(message, sizeof(message), "-%*s\r\n", Z_STRLEN_P(value), Z_STRVAL_P(value));
-        }
-        else
-        {
-            length = snprintf(message, sizeof(message), "-%s\r\n", "ERR");
-        }
-        SW_RETURN_STRINGL(message, length, 1);
+        return;
     }
-    else if (type == SW_REDIS_REPLY_INT)
-    {
-        if (!value)
-        {
-            goto no_value;
-        }
 
-        convert_to_long(value);
-        length = snprintf(message, sizeof(message), ":%d\r\n", Z_LVAL_P(value));
-        SW_RETURN_STRINGL(message, length, 1);
-    }
-    else if (type == SW_REDIS_REPLY_STRING)
+    if (redis_set_handler(getThis(), ZEND_STRL("_batch_handler"), zcallback TSRMLS_CC) < 0)
     {
-        if (!value)
-        {
-            no_value:
-            swoole_php_fatal_error(E_WARNING, "require more parameters.");
-            RETURN_FALSE;
-        }
-        convert_to_string(value);
-        if (Z_STRLEN_P(value) > SW_REDIS_MAX_STRING_SIZE || Z_STRLEN_P(value) < 1)
-        {
-            swoole_php_fatal_error(E_WARNING, "invalid string size.");
-            RETURN_FALSE;
-        }
-        swString_clear(format_buffer);
-        length = snprintf(message, sizeof(message), "$%d\r\n", Z_STRLEN_P(value));
-        swString_append_ptr(format_buffer, message, length);
-        swString_append_ptr(format_buffer, Z_STRVAL_P(value), Z_STRLEN_P(value));
-        swString_append_ptr(format_buffer, SW_CRLF, SW_CRLF_LEN);
-        SW_RETURN_STRINGL(format_buffer->str, format_buffer->length, 1);
+        return;
     }
-    else if (type == SW_REDIS_REPLY_SET)
-    {
-        if (!value)
-        {
-            goto no_value;
-        }
-        if (Z_TYPE_P(value) != IS_ARRAY)
-        {
-            swoole_php_fatal_error(E_WARNING, "the second parameter should be an array.");
-        }
-        swString_clear(format_buffer);
-        length = snprintf(message, sizeof(message), "*%d\r\n", zend_hash_num_elements(Z_ARRVAL_P(value)));
-        swString_append_ptr(format_buffer, message, length);
+    RETURN_TRUE;
+}
 
-        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(value), item)
-#if PHP_MAJOR_VERSION >= 7
-            zval _copy;
-            if (Z_TYPE_P(item) != IS_STRING)
-            {
-                _copy = *item;
-                zval_copy_ctor(&_copy);
-                item = &_copy;
-            }
-#endif
-            convert_to_string(item);
-            length = snprintf(message, sizeof(message), "$%d\r\n", Z_STRLEN_P(item));
-            swString_append_ptr(format_buffer, message, length);
-            swString_append_ptr(format_buffer, Z_STRVAL_P(item), Z_STRLEN_P(item));
-            swString_append_ptr(format_buffer, SW_CRLF, SW_CRLF_LEN);
-#if PHP_MAJOR_VERSION >= 7
-            if (item == &_copy)
-            {
-                zval_dtor(item);
-            }
-#endif
-        SW_HASHTABLE_FOREACH_END();
+static PHP_METHOD(swoole_redis_server, format)
+{
+    long type;
+    zval *value = NULL;
 
-        SW_RETURN_STRINGL(format_buffer->str, format_buffer->length, 1);
-    }
-    else if (type == SW_REDIS_REPLY_MAP)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|z", &type, &value) == FAILURE)
     {
-        if (!value)
-        {
-            goto no_value;
-        }
-        if (Z_TYPE_P(value) != IS_ARRAY)
-        {
-            swoole_php_fatal_error(E_WARNING, "the second parameter should be an array.");
-        }
-        swString_clear(format_buffer);
-        length = snprintf(message, sizeof(message), "*%d\r\n", 2 * zend_hash_num_elements(Z_ARRVAL_P(value)));
-        swString_append_ptr(format_buffer, message, length);
-
-        char *key;
-        uint32_t keylen;
-        int keytype;
-
-        SW_HASHTABLE_FOREACH_START2(Z_ARRVAL_P(value), key, keylen, keytype, item)
-            if (key == NULL || keylen <= 0)
-            {
-                continue;
-            }
-#if PHP_MAJOR_VERSION >= 7
-            zval _copy;
-            if (Z_TYPE_P(item) != IS_STRING)
-            {
-                _copy = *item;
-                zval_copy_ctor(&_copy);
-                item = &_copy;
-            }
-#endif
-            convert_to_string(item);
-            length = snprintf(message, sizeof(message), "$%d\r\n%s\r\n$%d\r\n", keylen, key, Z_STRLEN_P(item));
-            swString_append_ptr(format_buffer, message, length);
-            swString_append_ptr(format_buffer, Z_STRVAL_P(item), Z_STRLEN_P(item));
-            swString_append_ptr(format_buffer, SW_CRLF, SW_CRLF_LEN);
-
-#if PHP_MAJOR_VERSION >= 7
-            if (item == &_copy)
-            {
-                zval_dtor(item);
-            }
-#endif
-            (void) keytype;
-        SW_HASHTABLE_FOREACH_END();
-
-        SW_RETURN_STRINGL(format_buffer->str, format_buffer->length, 1);
+        return;
     }
-    else
+
+    swString_clear(format_buffer);
+    if (redis_format(format_buffer, type, value TSRMLS_CC) < 0)
     {
-        swoole_php_error(E_WARNING, "Unknown type[%ld]", type);
         RETURN_FALSE;
     }
+    SW_RETURN_STRINGL(format_buffer->str, format_buffer->length, 1);
 }
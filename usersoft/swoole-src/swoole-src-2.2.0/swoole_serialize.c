@@ -34,7 +34,7 @@ ZEND_ARG_INFO(0, args)
 ZEND_END_ARG_INFO()
 
 static void swoole_serialize_object(seriaString *buffer, zval *zvalue, size_t start);
-static void swoole_serialize_arr(seriaString *buffer, zend_array *zvalue);
+static void swoole_serialize_arr(seriaString *buffer, zend_array *zvalue, zend_uchar no_key);
 static void* swoole_unserialize_arr(void *buffer, zval *zvalue, uint32_t num, long flag);
 static void* swoole_unserialize_object(void *buffer, zval *return_value, zend_uchar bucket_len, zval *args, long flag);
 
@@ -554,6 +554,120 @@ static CPINLINE swPoolstr* swoole_mini_filter_find(zend_string *zstr)
     }
 }
 
+static swSeriaLayout* swoole_seria_layout_add(struct _swSeriaLayouts *layouts, zend_class_entry *ce, uint32_t num)
+{
+    if (layouts->num >= SERIA_LAYOUT_MAX)
+    {
+        return NULL;
+    }
+    if (layouts->num == layouts->size)
+    {
+        layouts->size = layouts->size ? layouts->size * 2 : 16;
+        layouts->list = (swSeriaLayout*) erealloc(layouts->list, sizeof (swSeriaLayout) * layouts->size);
+    }
+    swSeriaLayout *layout = &layouts->list[layouts->num++];
+    layout->ce = ce;
+    layout->num = 0;
+    layout->keys = num ? (zend_string**) emalloc(sizeof (zend_string*) * num) : NULL;
+    return layout;
+}
+
+static void swoole_seria_layout_clear(struct _swSeriaLayouts *layouts)
+{
+    uint32_t i, j;
+    for (i = 0; i < layouts->num; i++)
+    {
+        for (j = 0; j < layouts->list[i].num; j++)
+        {
+            zend_string_release(layouts->list[i].keys[j]);
+        }
+        if (layouts->list[i].keys)
+        {
+            efree(layouts->list[i].keys);
+        }
+    }
+    if (layouts->list)
+    {
+        efree(layouts->list);
+    }
+    if (layouts->index)
+    {
+        zend_hash_destroy(layouts->index);
+        FREE_HASHTABLE(layouts->index);
+    }
+    memset(layouts, 0, sizeof (struct _swSeriaLayouts));
+}
+
+/*
+ * return the layout id of the property table, -1 means the keys must be written in full,
+ * define is set when the layout is registered by this object and must be written once
+ */
+static int swoole_seria_layout_get(zend_class_entry *ce, zend_array *props, zend_uchar *define)
+{
+    struct _swSeriaLayouts *layouts = &swSeriaG.pack_layouts;
+    swSeriaLayout *layout;
+    zend_string *key;
+    zval *zid, tmp;
+    uint32_t i = 0;
+
+    *define = 0;
+    if (layouts->index == NULL)
+    {
+        ALLOC_HASHTABLE(layouts->index);
+        zend_hash_init(layouts->index, 16, NULL, NULL, 0);
+    }
+
+    zid = zend_hash_index_find(layouts->index, (zend_ulong) (uintptr_t) ce);
+    if (zid)
+    {
+        layout = &layouts->list[Z_LVAL_P(zid)];
+        if (props->nNumOfElements != layout->num)
+        {
+            return -1;
+        }
+        //the same class almost always shares the key strings, so compare the pointer first
+        ZEND_HASH_FOREACH_STR_KEY(props, key)
+        {
+            if (!key || (key != layout->keys[i] && !zend_string_equals(key, layout->keys[i])))
+            {
+                return -1;
+            }
+            i++;
+        }
+        ZEND_HASH_FOREACH_END();
+        return Z_LVAL_P(zid);
+    }
+
+    if (props->nNumOfElements > 0xffff)
+    {
+        return -1;
+    }
+    ZEND_HASH_FOREACH_STR_KEY(props, key)
+    {
+        if (!key || key->len > 0xffff)
+        {
+            return -1;
+        }
+    }
+    ZEND_HASH_FOREACH_END();
+
+    layout = swoole_seria_layout_add(layouts, ce, props->nNumOfElements);
+    if (!layout)
+    {
+        return -1;
+    }
+    ZEND_HASH_FOREACH_STR_KEY(props, key)
+    {
+        layout->keys[layout->num++] = zend_string_copy(key);
+    }
+    ZEND_HASH_FOREACH_END();
+
+    ZVAL_LONG(&tmp, layouts->num - 1);
+    zend_hash_index_add(layouts->index, (zend_ulong) (uintptr_t) ce, &tmp);
+    *define = 1;
+    return layouts->num - 1;
+}
+
 /*
  * arr layout
  * type|key?|bucketlen|buckets
@@ -841,7 +955,7 @@ static void* swoole_unserialize_arr(void *buffer, zval *zvalue, uint32_t nNumOfE
  * arr layout
  * type|key?|bucketlen|buckets
  */
-static void swoole_serialize_arr(seriaString *buffer, zend_array *zvalue)
+static void swoole_serialize_arr(seriaString *buffer, zend_array *zvalue, zend_uchar no_key)
 {
     zval *data;
     zend_string *key;
@@ -856,7 +970,7 @@ static void swoole_serialize_arr(seriaString *buffer, zend_array *zvalue)
         //start point
         size_t p = buffer->offset;
 
-        if (is_pack && zvalue->nNextFreeElement == zvalue->nNumOfElements)
+        if (no_key || (is_pack && zvalue->nNextFreeElement == zvalue->nNumOfElements))
         {
             type.key_type = KEY_TYPE_INDEX;
             type.key_len = 0;
@@ -1003,12 +1117,12 @@ try_again:
                     if (ZEND_HASH_APPLY_PROTECTION(ht))
                     {
                         GC_PROTECT_RECURSION(ht);
-                        swoole_serialize_arr(buffer, ht);
+                        swoole_serialize_arr(buffer, ht, 0);
                         GC_UNPROTECT_RECURSION(ht);
                     }
                     else
                     {
-                        swoole_serialize_arr(buffer, ht);
+                        swoole_serialize_arr(buffer, ht, 0);
                     }
 
                 }
@@ -1091,9 +1205,24 @@ static CPINLINE void swoole_serialize_raw(seriaString *buffer, zval *zvalue)
     swoole_string_cpy(buffer, &zvalue->value, sizeof (zend_value));
 }
 
+static CPINLINE void swoole_serialize_class_name(seriaString *buffer, zend_string *name)
+{
+    if (name->len > 0xffff)
+    {//so long?
+        zend_throw_exception_ex(NULL, 0, "the object name is too long.");
+    }
+    else
+    {
+        SERIA_SET_ENTRY_SHORT(buffer, name->len);
+        swoole_string_cpy(buffer, name->val, name->len);
+    }
+}
+
 /*
  * obj layout
  * type|bucket key|name len| name| buket len |buckets
+ * type|bucket key|0|LAYOUT_DEFINE|name len|name|key num|[key len|key]...|bucket len|buckets without key
+ * type|bucket key|0|LAYOUT_USE|layout id|bucket len|buckets without key
  */
 static void swoole_serialize_object(seriaString *buffer, zval *obj, size_t start)
 {
@@ -1103,18 +1232,43 @@ static void swoole_serialize_object(seriaString *buffer, zval *obj, size_t start
         zend_throw_exception_ex(NULL, 0, "the object %s has cycle ref.", name->val);
         return;
     }
-    if (name->len > 0xffff)
-    {//so long?
-        zend_throw_exception_ex(NULL, 0, "the object name is too long.");
-    }
-    else
+
+    zend_class_entry *ce = Z_OBJ_P(obj)->ce;
+    zend_uchar has_sleep = ce && zend_hash_exists(&ce->function_table, Z_STR(swSeriaG.sleep_fname));
+    if (!has_sleep && name->len <= 0xffff)
     {
-        SERIA_SET_ENTRY_SHORT(buffer, name->len);
-        swoole_string_cpy(buffer, name->val, name->len);
+        zend_array *props = Z_OBJPROP_P(obj);
+        zend_uchar define;
+        int layout_id = swoole_seria_layout_get(ce, props, &define);
+        if (layout_id >= 0)
+        {
+            zend_uchar op = define ? SERIA_LAYOUT_DEFINE : SERIA_LAYOUT_USE;
+            SERIA_SET_ENTRY_SHORT(buffer, 0);
+            SERIA_SET_ENTRY_TYPE(buffer, op);
+            if (define)
+            {
+                swSeriaLayout *layout = &swSeriaG.pack_layouts.list[layout_id];
+                uint32_t i;
+                swoole_serialize_class_name(buffer, name);
+                SERIA_SET_ENTRY_SHORT(buffer, layout->num);
+                for (i = 0; i < layout->num; i++)
+                {
+                    SERIA_SET_ENTRY_SHORT(buffer, layout->keys[i]->len);
+                    swoole_string_cpy(buffer, layout->keys[i]->val, layout->keys[i]->len);
+                }
+            }
+            else
+            {
+                SERIA_SET_ENTRY_SHORT(buffer, layout_id);
+            }
+            seria_array_type(props, buffer, start, buffer->offset);
+            swoole_serialize_arr(buffer, props, 1);
+            return;
+        }
     }
 
-    zend_class_entry *ce = Z_OBJ_P(obj)->ce;
-    if (ce && zend_hash_exists(&ce->function_table, Z_STR(swSeriaG.sleep_fname)))
+    swoole_serialize_class_name(buffer, name);
+    if (has_sleep)
     {
         zval retval;
         if (call_user_function_ex(NULL, obj, &swSeriaG.sleep_fname, &retval, 0, 0, 1, NULL) == SUCCESS)
@@ -1177,7 +1331,7 @@ static void swoole_serialize_object(seriaString *buffer, zval *obj, size_t start
 
                 }
                 seria_array_type(ht, buffer, start, buffer->offset);
-                swoole_serialize_arr(buffer, ht);
+                swoole_serialize_arr(buffer, ht, 0);
                 ZSTR_ALLOCA_FREE(ht_addr, use_heap);
                 zval_dtor(&retval);
                 return;
@@ -1193,7 +1347,7 @@ static void swoole_serialize_object(seriaString *buffer, zval *obj, size_t start
         }
     }
     seria_array_type(Z_OBJPROP_P(obj), buffer, start, buffer->offset);
-    swoole_serialize_arr(buffer, Z_OBJPROP_P(obj));
+    swoole_serialize_arr(buffer, Z_OBJPROP_P(obj), 0);
     //    printf("hash2 %u\n",ce->properties_info.arData[0].key->h);
 }
 
@@ -1251,21 +1405,8 @@ static CPINLINE zend_class_entry* swoole_try_get_ce(zend_string *class_name)
     }
 }
 
-/*
- * obj layout
- * type| key[0|1] |name len| name| buket len |buckets
- */
-static void* swoole_unserialize_object(void *buffer, zval *return_value, zend_uchar bucket_len, zval *args, long flag)
+static CPINLINE zend_class_entry* swoole_unserialize_class(void **buffer, size_t name_len, long flag)
 {
-    zval property;
-    uint32_t arr_num = 0;
-    size_t name_len = *((unsigned short*) buffer);
-    if (!name_len)
-    {
-        php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
-        return NULL;
-    }
-    buffer += 2;
     zend_string *class_name;
     if (flag == UNSERIALIZE_OBJECT_TO_STDCLASS) 
     {
@@ -1273,18 +1414,110 @@ static void* swoole_unserialize_object(void *buffer, zval *return_value, zend_uc
     } 
     else 
     {
-        class_name = swoole_string_init((char*) buffer, name_len);
+        class_name = swoole_string_init((char*) *buffer, name_len);
     }
-    buffer += name_len;
+    *buffer += name_len;
     zend_class_entry *ce = swoole_try_get_ce(class_name);
     swoole_string_release(class_name);
+    return ce;
+}
+
+/*
+ * read the layout written by the first object of a class,
+ * the ids are assigned in the same order as pack() registered them
+ */
+static void* swoole_unserialize_layout(void *buffer, swSeriaLayout **layout, long flag)
+{
+    struct _swSeriaLayouts *layouts = &swSeriaG.unpack_layouts;
+    zend_uchar op = *((zend_uchar*) buffer);
+    buffer += 1;
 
+    if (op == SERIA_LAYOUT_USE)
+    {
+        uint32_t id = *((unsigned short*) buffer);
+        if (id >= layouts->num)
+        {
+            php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
+            return NULL;
+        }
+        *layout = &layouts->list[id];
+        return buffer + 2;
+    }
+    else if (op != SERIA_LAYOUT_DEFINE)
+    {
+        php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
+        return NULL;
+    }
+
+    size_t name_len = *((unsigned short*) buffer);
+    if (!name_len)
+    {
+        php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
+        return NULL;
+    }
+    buffer += 2;
+    zend_class_entry *ce = swoole_unserialize_class(&buffer, name_len, flag);
     if (!ce)
     {
         return NULL;
     }
 
+    uint32_t i, num = *((unsigned short*) buffer);
+    buffer += 2;
+    swSeriaLayout *new_layout = swoole_seria_layout_add(layouts, ce, num);
+    if (!new_layout)
+    {
+        php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
+        return NULL;
+    }
+    for (i = 0; i < num; i++)
+    {
+        size_t key_len = *((unsigned short*) buffer);
+        buffer += 2;
+        new_layout->keys[new_layout->num++] = zend_string_init((char*) buffer, key_len, 0);
+        buffer += key_len;
+    }
+    *layout = new_layout;
+    return buffer;
+}
+
+/*
+ * obj layout
+ * type| key[0|1] |name len| name| buket len |buckets
+ * type| key[0|1] |0|layout op|...| buket len |buckets without key
+ */
+static void* swoole_unserialize_object(void *buffer, zval *return_value, zend_uchar bucket_len, zval *args, long flag)
+{
+    zval property;
+    uint32_t arr_num = 0;
+    swSeriaLayout *layout = NULL;
+    zend_class_entry *ce;
+    size_t name_len = *((unsigned short*) buffer);
+    buffer += 2;
+    if (!name_len)
+    {
+        buffer = swoole_unserialize_layout(buffer, &layout, flag);
+        if (!buffer)
+        {
+            return NULL;
+        }
+        ce = layout->ce;
+    }
+    else
+    {
+        ce = swoole_unserialize_class(&buffer, name_len, flag);
+        if (!ce)
+        {
+            return NULL;
+        }
+    }
+
     buffer = get_array_real_len(buffer, bucket_len, &arr_num);
+    if (layout && arr_num != layout->num)
+    {
+        php_error_docref(NULL TSRMLS_CC, E_NOTICE, "illegal unserialize data");
+        return NULL;
+    }
     buffer = swoole_unserialize_arr(buffer, &property, arr_num, flag);
 
     object_init_ex(return_value, ce);
@@ -1297,6 +1530,10 @@ static void* swoole_unserialize_object(void *buffer, zval *return_value, zend_uc
     {
         const char *prop_name, *tmp;
         size_t prop_len;
+        if (layout)
+        {
+            key = layout->keys[index];
+        }
         if (key)
         {
             zend_unmangle_property_name_ex(key, &tmp, &prop_name, &prop_len);
@@ -1384,9 +1621,10 @@ again:
         case IS_ARRAY:
         {
             seria_array_type(Z_ARRVAL_P(zvalue), buffer, _STR_HEADER_SIZE, _STR_HEADER_SIZE + 1);
-            swoole_serialize_arr(buffer, Z_ARRVAL_P(zvalue));
+            swoole_serialize_arr(buffer, Z_ARRVAL_P(zvalue), 0);
             swoole_string_cpy(buffer, SWOOLE_SERI_EOF, 3);
             swoole_mini_filter_clear();
+            swoole_seria_layout_clear(&swSeriaG.pack_layouts);
             break;
         }
         case IS_REFERENCE:
@@ -1400,6 +1638,7 @@ again:
             swoole_serialize_object(buffer, zvalue, _STR_HEADER_SIZE);
             swoole_string_cpy(buffer, SWOOLE_SERI_EOF, 3);
             swoole_mini_filter_clear();
+            swoole_seria_layout_clear(&swSeriaG.pack_layouts);
             break;
         }
         default:
@@ -1445,7 +1684,7 @@ static CPINLINE int swoole_seria_check_eof(void *buffer, size_t len)
  * return_value is unseria bucket
  * args is for the object ctor (can be NULL)
  */
-PHPAPI int php_swoole_unserialize(void *buffer, size_t len, zval *return_value, zval *object_args, long flag)
+static int swoole_unserialize_dispatch(void *buffer, size_t len, zval *return_value, zval *object_args, long flag)
 {
     SBucketType type = *(SBucketType*) (buffer);
     zend_uchar real_type = type.data_type;
@@ -1506,6 +1745,13 @@ PHPAPI int php_swoole_unserialize(void *buffer, size_t len, zval *return_value,
     return SW_TRUE;
 }
 
+PHPAPI int php_swoole_unserialize(void *buffer, size_t len, zval *return_value, zval *object_args, long flag)
+{
+    int ret = swoole_unserialize_dispatch(buffer, len, return_value, object_args, flag);
+    swoole_seria_layout_clear(&swSeriaG.unpack_layouts);
+    return ret;
+}
+
 static PHP_METHOD(swoole_serialize, pack)
 {
     zval *zvalue;
@@ -48,12 +48,32 @@ struct _swMinFilter
     uint32_t bigger_fillter_size;
 };
 
+/*
+ * the property keys of a class, written once per pack() and then referred to by id
+ */
+typedef struct _swSeriaLayout
+{
+    zend_class_entry *ce;
+    uint32_t num;
+    zend_string **keys;
+} swSeriaLayout;
+
+struct _swSeriaLayouts
+{
+    swSeriaLayout *list;
+    uint32_t num;
+    uint32_t size;
+    HashTable *index; //class entry => layout id, only for pack
+};
+
 struct _swSeriaG
 {
     zval sleep_fname;
     zval weekup_fname;
     zend_uchar pack_string;
     struct _swMinFilter filter;
+    struct _swSeriaLayouts pack_layouts;
+    struct _swSeriaLayouts unpack_layouts;
 };
 
 #pragma pack (4)
@@ -107,6 +127,10 @@ static swPoolstr *bigger_filter = NULL;
 
 #define SW_FAST_PACK                  1
 
+#define SERIA_LAYOUT_MAX              0xffff
+#define SERIA_LAYOUT_DEFINE           1
+#define SERIA_LAYOUT_USE              2
+
 #define UNSERIALIZE_OBJECT_TO_ARRAY          1
 #define UNSERIALIZE_OBJECT_TO_STDCLASS       2
 
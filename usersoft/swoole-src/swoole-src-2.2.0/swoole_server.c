@@ -2335,6 +2335,28 @@ PHP_METHOD(swoole_server, set)
         SwooleG.task_tmpdir = sw_malloc(Z_STRLEN_P(v) + sizeof(SW_TASK_TMP_FILE) + 1);
         SwooleG.task_tmpdir_len = snprintf(SwooleG.task_tmpdir, SW_TASK_TMPDIR_SIZE, "%s/swoole.task.XXXXXX", Z_STRVAL_P(v)) + 1;
     }
+    //shared memory for large task payloads, 0 disables it
+    if (php_swoole_array_get_value(vht, "task_shm_size", v))
+    {
+        convert_to_long(v);
+        SwooleG.task_shm_size = Z_LVAL_P(v) > 0 ? (uint32_t) Z_LVAL_P(v) : 0;
+    }
+    //latency histograms
+    if (php_swoole_array_get_value(vht, "latency_stats", v))
+    {
+        convert_to_boolean(v);
+        serv->latency_stats = Z_BVAL_P(v);
+    }
+    if (php_swoole_array_get_value(vht, "stats_host", v))
+    {
+        convert_to_string(v);
+        serv->stats_host = sw_strndup(Z_STRVAL_P(v), Z_STRLEN_P(v));
+    }
+    if (php_swoole_array_get_value(vht, "stats_port", v))
+    {
+        convert_to_long(v);
+        serv->stats_port = (uint16_t) Z_LVAL_P(v);
+    }
     //task_max_request
     if (php_swoole_array_get_value(vht, "task_max_request", v))
     {
@@ -2387,6 +2409,12 @@ PHP_METHOD(swoole_server, set)
         convert_to_boolean(v);
         serv->open_cpu_affinity = Z_BVAL_P(v);
     }
+    //group reactor threads and workers per NUMA node
+    if (php_swoole_array_get_value(vht, "numa_affinity", v))
+    {
+        convert_to_boolean(v);
+        serv->numa_affinity = Z_BVAL_P(v);
+    }
     //cpu affinity set
     if (php_swoole_array_get_value(vht, "cpu_affinity_ignore", v))
     {
@@ -2428,6 +2456,11 @@ PHP_METHOD(swoole_server, set)
         serv->http_parse_post = Z_BVAL_P(v);
     }
     //temporary directory for HTTP uploaded file.
+    if (php_swoole_array_get_value(vht, "http_compression_min_length", v))
+    {
+        convert_to_long(v);
+        serv->http_compression_min_length = Z_LVAL_P(v) > 0 ? Z_LVAL_P(v) : 0;
+    }
     if (php_swoole_array_get_value(vht, "upload_tmp_dir", v))
     {
         convert_to_string(v);
@@ -2450,6 +2483,21 @@ PHP_METHOD(swoole_server, set)
         convert_to_boolean(v);
         serv->enable_static_handler = Z_BVAL_P(v);
     }
+    if (php_swoole_array_get_value(vht, "static_handler_precompressed", v))
+    {
+        convert_to_boolean(v);
+        serv->static_handler_precompressed = Z_BVAL_P(v);
+    }
+    if (php_swoole_array_get_value(vht, "static_handler_cache_size", v))
+    {
+        convert_to_long(v);
+        serv->static_handler_cache_size = Z_LVAL_P(v) > 0 ? Z_LVAL_P(v) : 0;
+    }
+    if (php_swoole_array_get_value(vht, "static_handler_cache_expire", v))
+    {
+        convert_to_long(v);
+        serv->static_handler_cache_expire = Z_LVAL_P(v) > 0 ? Z_LVAL_P(v) : 0;
+    }
     if (php_swoole_array_get_value(vht, "document_root", v))
     {
         convert_to_string(v);
@@ -2484,6 +2532,14 @@ PHP_METHOD(swoole_server, set)
         convert_to_long(v);
         serv->buffer_output_size = (int) Z_LVAL_P(v);
     }
+    /**
+     * worker response ring size, 0 to use the pipes
+     */
+    if (php_swoole_array_get_value(vht, "ipc_ring_size", v))
+    {
+        convert_to_long(v);
+        serv->ipc_ring_size = Z_LVAL_P(v) < 0 ? 0 : (uint32_t) Z_LVAL_P(v);
+    }
     //message queue key
     if (php_swoole_array_get_value(vht, "message_queue_key", v))
     {
@@ -2840,8 +2896,8 @@ PHP_METHOD(swoole_server, sendto)
     zval *zobject = getThis();
 
     char *ip;
-    char *data;
-    zend_size_t len, ip_len;
+    zval *zdata;
+    zend_size_t ip_len;
 
     zend_long port;
     zend_long server_socket = -1;
@@ -2857,17 +2913,27 @@ PHP_METHOD(swoole_server, sendto)
     ZEND_PARSE_PARAMETERS_START(3, 4)
         Z_PARAM_STRING(ip, ip_len)
         Z_PARAM_LONG(port)
-        Z_PARAM_STRING(data, len)
+        Z_PARAM_ZVAL(zdata)
         Z_PARAM_OPTIONAL
         Z_PARAM_LONG(server_socket)
     ZEND_PARSE_PARAMETERS_END();
 #else
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sls|l", &ip, &ip_len, &port, &data, &len, &server_socket) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "slz|l", &ip, &ip_len, &port, &zdata, &server_socket) == FAILURE)
     {
         return;
     }
 #endif
 
+    char *data = NULL;
+    int len = 0;
+    if (Z_TYPE_P(zdata) == IS_ARRAY)
+    {
+        len = php_swoole_array_length(zdata);
+    }
+    else
+    {
+        len = php_swoole_get_send_data(zdata, &data TSRMLS_CC);
+    }
     if (len <= 0)
     {
         swoole_php_fatal_error(E_WARNING, "data is empty.");
@@ -2898,6 +2964,35 @@ PHP_METHOD(swoole_server, sendto)
     }
 
     int ret;
+    /**
+     * a burst of datagrams to the same address, sent with sendmmsg() or UDP_SEGMENT
+     */
+    if (Z_TYPE_P(zdata) == IS_ARRAY)
+    {
+        int n = 0;
+        zval *value;
+        struct iovec *packets = emalloc(sizeof(struct iovec) * php_swoole_array_length(zdata));
+
+        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(zdata), value)
+            if (SW_Z_TYPE_P(value) != IS_STRING || Z_STRLEN_P(value) == 0)
+            {
+                swoole_php_error(E_WARNING, "datagram must be a non-empty string.");
+                continue;
+            }
+            packets[n].iov_base = Z_STRVAL_P(value);
+            packets[n].iov_len = Z_STRLEN_P(value);
+            n++;
+        SW_HASHTABLE_FOREACH_END();
+
+        ret = n > 0 ? swSocket_udp_sendto_multi(server_socket, ipv6, ip, port, packets, n) : SW_ERR;
+        efree(packets);
+        if (ret < 0)
+        {
+            RETURN_FALSE;
+        }
+        RETURN_LONG(ret);
+    }
+
     if (ipv6)
     {
         ret = swSocket_udp_sendto6(server_socket, ip, port, data, len);
@@ -3083,6 +3178,27 @@ PHP_METHOD(swoole_server, resume)
     SW_CHECK_RETURN(ret);
 }
 
+/**
+ * count, avg and percentiles in microseconds
+ */
+static void php_swoole_server_add_histogram(zval *zworker, char *name, swHistogram *h)
+{
+    zval *zhist;
+    uint64_t count;
+    uint64_t p50 = swHistogram_percentile(h, 50, &count);
+
+    SW_MAKE_STD_ZVAL(zhist);
+    array_init(zhist);
+    add_assoc_long(zhist, "count", count);
+    add_assoc_long(zhist, "avg", count ? h->sum / count : 0);
+    add_assoc_long(zhist, "p50", p50);
+    add_assoc_long(zhist, "p90", swHistogram_percentile(h, 90, NULL));
+    add_assoc_long(zhist, "p99", swHistogram_percentile(h, 99, NULL));
+    add_assoc_long(zhist, "p999", swHistogram_percentile(h, 99.9, NULL));
+    add_assoc_long(zhist, "max", swHistogram_percentile(h, 100, NULL));
+    add_assoc_zval(zworker, name, zhist);
+}
+
 PHP_METHOD(swoole_server, stats)
 {
     if (SwooleGS->start == 0)
@@ -3113,10 +3229,41 @@ PHP_METHOD(swoole_server, stats)
             sw_add_assoc_long_ex(return_value, ZEND_STRS("task_queue_bytes"), queue_bytes);
         }
     }
+    else if (SwooleGS->task_workers.use_shmqueue)
+    {
+        int i, queue_num = 0;
+        for (i = 0; i < SwooleGS->task_workers.worker_num; i++)
+        {
+            queue_num += SwooleGS->task_workers.shm_queues[i].num;
+        }
+        sw_add_assoc_long_ex(return_value, ZEND_STRS("task_queue_num"), queue_num);
+    }
 
 #ifdef SW_COROUTINE
     sw_add_assoc_long_ex(return_value, ZEND_STRS("coroutine_num"), COROG.coro_num);
 #endif
+
+    swServer *serv = SwooleG.serv;
+    if (serv->latency_stats)
+    {
+        zval *latency;
+        SW_MAKE_STD_ZVAL(latency);
+        array_init(latency);
+        int i;
+        for (i = 0; i < serv->worker_num; i++)
+        {
+            swWorker *worker = swServer_get_worker(serv, i);
+            zval *zworker;
+            SW_MAKE_STD_ZVAL(zworker);
+            array_init(zworker);
+            php_swoole_server_add_histogram(zworker, "request", &worker->request_histogram);
+            php_swoole_server_add_histogram(zworker, "queue", &worker->queue_histogram);
+            php_swoole_server_add_histogram(zworker, "reactor_wait", &worker->wait_histogram);
+            php_swoole_server_add_histogram(zworker, "reactor_loop", &worker->loop_histogram);
+            add_index_zval(latency, i, zworker);
+        }
+        add_assoc_zval(return_value, "latency", latency);
+    }
 }
 
 PHP_METHOD(swoole_server, reload)
@@ -3276,11 +3423,107 @@ PHP_METHOD(swoole_server, taskwait)
     RETURN_FALSE;
 }
 
-PHP_METHOD(swoole_server, taskWaitMulti)
+/**
+ * the tasks are spread over at most task_worker_num batches, each batch is one IPC message,
+ * returns the number of dispatched tasks, list[i] is the task id or -1
+ */
+static int php_swoole_task_dispatch_multi(zval *tasks, int flags, int blocking, int *list, zval *result TSRMLS_DC)
 {
+    static swString **batches = NULL;
     swEventData buf;
-    zval *tasks;
     zval *task;
+    int task_id;
+    int i = 0, j, g;
+    int n_task = Z_ARRVAL_P(tasks)->nNumOfElements;
+    int n_batch = MIN(n_task, SwooleG.task_worker_num);
+    int n_dispatched = 0;
+
+    if (batches == NULL)
+    {
+        batches = sw_calloc(SwooleG.task_worker_num, sizeof(swString *));
+        if (batches == NULL)
+        {
+            return 0;
+        }
+    }
+    for (g = 0; g < n_batch; g++)
+    {
+        if (batches[g] == NULL && (batches[g] = swString_new(SW_BUFFER_SIZE_BIG)) == NULL)
+        {
+            return 0;
+        }
+        swString_clear(batches[g]);
+    }
+
+    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(tasks), task)
+        task_id = php_swoole_task_pack(&buf, task TSRMLS_CC);
+        if (task_id < 0)
+        {
+            swoole_php_fatal_error(E_WARNING, "failed to pack task.");
+            add_index_bool(result, i, 0);
+        }
+        else
+        {
+            swTask_type(&buf) |= flags;
+            swString_append_ptr(batches[i % n_batch], (char *) &buf, sizeof(buf.info) + buf.info.len);
+        }
+        list[i] = task_id;
+        i++;
+    SW_HASHTABLE_FOREACH_END();
+
+    for (g = 0; g < n_batch; g++)
+    {
+        int count = 0;
+        for (j = g; j < n_task; j += n_batch)
+        {
+            if (list[j] >= 0)
+            {
+                count++;
+            }
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+
+        int ret;
+        int dst_worker_id = -1;
+        swEventData *single = (swEventData *) batches[g]->str;
+        if (count > 1)
+        {
+            ret = swTaskWorker_batch_dispatch(batches[g], blocking);
+        }
+        else if (blocking)
+        {
+            ret = swProcessPool_dispatch_blocking(&SwooleGS->task_workers, single, &dst_worker_id);
+        }
+        else
+        {
+            ret = swProcessPool_dispatch(&SwooleGS->task_workers, single, &dst_worker_id);
+        }
+
+        if (ret < 0)
+        {
+            swoole_php_fatal_error(E_WARNING, "task dispatch failed. Error: %s[%d]", strerror(errno), errno);
+            for (j = g; j < n_task; j += n_batch)
+            {
+                if (list[j] >= 0)
+                {
+                    list[j] = -1;
+                    add_index_bool(result, j, 0);
+                }
+            }
+            continue;
+        }
+        sw_atomic_fetch_add(&SwooleStats->tasking_num, count);
+        n_dispatched += count;
+    }
+    return n_dispatched;
+}
+
+PHP_METHOD(swoole_server, taskWaitMulti)
+{
+    zval *tasks;
     double timeout = SW_TASKWAIT_TIMEOUT;
 
     if (SwooleGS->start == 0)
@@ -3297,9 +3540,7 @@ PHP_METHOD(swoole_server, taskWaitMulti)
     swServer *serv = swoole_get_object(getThis());
     array_init(return_value);
 
-    int dst_worker_id;
     int task_id;
-    int i = 0;
     int n_task = Z_ARRVAL_P(tasks)->nNumOfElements;
 
     if (n_task >= SW_MAX_CONCURRENT_TASK)
@@ -3334,27 +3575,7 @@ PHP_METHOD(swoole_server, taskWaitMulti)
     int efd = task_notify_pipe->getFd(task_notify_pipe, 0);
     while (read(efd, &notify, sizeof(notify)) > 0);
 
-    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(tasks), task)
-        task_id = php_swoole_task_pack(&buf, task TSRMLS_CC);
-        if (task_id < 0)
-        {
-            swoole_php_fatal_error(E_WARNING, "task pack failed.");
-            goto fail;
-        }
-        swTask_type(&buf) |= SW_TASK_WAITALL;
-        dst_worker_id = -1;
-        if (swProcessPool_dispatch_blocking(&SwooleGS->task_workers, &buf, &dst_worker_id) < 0)
-        {
-            swoole_php_fatal_error(E_WARNING, "taskwait failed. Error: %s[%d]", strerror(errno), errno);
-            task_id = -1;
-            fail:
-            add_index_bool(return_value, i, 0);
-            n_task --;
-        }
-        sw_atomic_fetch_add(&SwooleStats->tasking_num, 1);
-        list_of_id[i] = task_id;
-        i++;
-    SW_HASHTABLE_FOREACH_END();
+    n_task = php_swoole_task_dispatch_multi(tasks, SW_TASK_WAITALL, 1, list_of_id, return_value TSRMLS_CC);
 
     if (n_task == 0)
     {
@@ -3420,9 +3641,7 @@ PHP_METHOD(swoole_server, taskWaitMulti)
 #ifdef SW_COROUTINE
 PHP_METHOD(swoole_server, taskCo)
 {
-    swEventData buf;
     zval *tasks;
-    zval *task;
     double timeout = SW_TASKWAIT_TIMEOUT;
 
     if (SwooleGS->start == 0)
@@ -3437,7 +3656,6 @@ PHP_METHOD(swoole_server, taskCo)
     }
 
     int dst_worker_id = -1;
-    int task_id;
     int i = 0;
     int n_task = Z_ARRVAL_P(tasks)->nNumOfElements;
 
@@ -3469,31 +3687,14 @@ PHP_METHOD(swoole_server, taskCo)
     SW_ALLOC_INIT_ZVAL(result);
     array_init(result);
 
-    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(tasks), task)
-        task_id = php_swoole_task_pack(&buf, task TSRMLS_CC);
-        if (task_id < 0)
-        {
-            swoole_php_fatal_error(E_WARNING, "failed to pack task.");
-            goto fail;
-        }
-        swTask_type(&buf) |= (SW_TASK_NONBLOCK | SW_TASK_COROUTINE);
-        dst_worker_id = -1;
-        sw_atomic_fetch_add(&SwooleStats->tasking_num, 1);
-        if (swProcessPool_dispatch(&SwooleGS->task_workers, &buf, &dst_worker_id) < 0)
-        {
-            sw_atomic_fetch_sub(&SwooleStats->tasking_num, 1);
-            task_id = -1;
-            fail:
-            add_index_bool(result, i, 0);
-            n_task --;
-        }
-        else
+    n_task = php_swoole_task_dispatch_multi(tasks, SW_TASK_NONBLOCK | SW_TASK_COROUTINE, 0, list, result TSRMLS_CC);
+    for (i = 0; i < Z_ARRVAL_P(tasks)->nNumOfElements; i++)
+    {
+        if (list[i] >= 0)
         {
-            swHashMap_add_int(task_coroutine_map, buf.info.fd, task_co);
+            swHashMap_add_int(task_coroutine_map, list[i], task_co);
         }
-        list[i] = task_id;
-        i++;
-    SW_HASHTABLE_FOREACH_END();
+    }
 
     if (n_task == 0)
     {
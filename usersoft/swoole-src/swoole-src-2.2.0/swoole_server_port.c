@@ -196,12 +196,30 @@ static PHP_METHOD(swoole_server_port, set)
         convert_to_long(v);
         port->buffer_low_watermark = (int) Z_LVAL_P(v);
     }
+    if (port->buffer_low_watermark >= port->buffer_high_watermark)
+    {
+        swoole_php_fatal_error(E_WARNING, "buffer_low_watermark must be less than buffer_high_watermark.");
+        port->buffer_low_watermark = 0;
+    }
     //tcp_nodelay
     if (php_swoole_array_get_value(vht, "open_tcp_nodelay", v))
     {
         convert_to_boolean(v);
         port->open_tcp_nodelay = Z_BVAL_P(v);
     }
+    //MSG_ZEROCOPY
+    if (php_swoole_array_get_value(vht, "send_zerocopy", v))
+    {
+        convert_to_boolean(v);
+        port->send_zerocopy = Z_BVAL_P(v);
+#ifndef HAVE_MSG_ZEROCOPY
+        if (port->send_zerocopy)
+        {
+            swoole_php_fatal_error(E_WARNING, "MSG_ZEROCOPY is not supported.");
+            port->send_zerocopy = 0;
+        }
+#endif
+    }
     //tcp_defer_accept
     if (php_swoole_array_get_value(vht, "tcp_defer_accept", v))
     {
@@ -451,11 +469,21 @@ static PHP_METHOD(swoole_server_port, set)
             convert_to_boolean(v);
             port->ssl_config.prefer_server_ciphers = Z_BVAL_P(v);
         }
-        //    if (sw_zend_hash_find(vht, ZEND_STRS("ssl_session_tickets"), (void **) &v) == SUCCESS)
-        //    {
-        //        convert_to_boolean(v);
-        //        port->ssl_config.session_tickets = Z_BVAL_P(v);
-        //    }
+        if (php_swoole_array_get_value(vht, "ssl_session_tickets", v))
+        {
+            convert_to_boolean(v);
+            port->ssl_config.session_tickets = Z_BVAL_P(v);
+        }
+        if (php_swoole_array_get_value(vht, "ssl_ticket_key_lifetime", v))
+        {
+            convert_to_long(v);
+            port->ssl_config.ticket_key_lifetime = (uint32_t) Z_LVAL_P(v);
+        }
+        if (php_swoole_array_get_value(vht, "ssl_ktls", v))
+        {
+            convert_to_boolean(v);
+            port->ssl_config.ktls = Z_BVAL_P(v);
+        }
         //    if (sw_zend_hash_find(vht, ZEND_STRS("ssl_stapling"), (void **) &v) == SUCCESS)
         //    {
         //        convert_to_boolean(v);
@@ -493,11 +521,16 @@ static PHP_METHOD(swoole_server_port, set)
             }
             port->ssl_config.dhparam = sw_strdup(Z_STRVAL_P(v));
         }
-        //    if (sw_zend_hash_find(vht, ZEND_STRS("ssl_session_cache"), (void **) &v) == SUCCESS)
-        //    {
-        //        convert_to_string(v);
-        //        port->ssl_config.session_cache = strdup(Z_STRVAL_P(v));
-        //    }
+        if (php_swoole_array_get_value(vht, "ssl_session_cache", v))
+        {
+            convert_to_long(v);
+            port->ssl_config.session_cache_size = (uint32_t) Z_LVAL_P(v);
+        }
+        if (php_swoole_array_get_value(vht, "ssl_session_timeout", v))
+        {
+            convert_to_long(v);
+            port->ssl_config.session_timeout = (uint32_t) Z_LVAL_P(v);
+        }
         if (swPort_enable_ssl_encrypt(port) < 0)
         {
             swoole_php_fatal_error(E_ERROR, "swPort_enable_ssl_encrypt() failed.");
@@ -34,6 +34,7 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_construct, 0, 0, 1)
     ZEND_ARG_INFO(0, table_size)
     ZEND_ARG_INFO(0, conflict_proportion)
+    ZEND_ARG_INFO(0, max_size)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_column, 0, 0, 2)
@@ -45,6 +46,11 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_set, 0, 0, 2)
     ZEND_ARG_INFO(0, key)
     ZEND_ARG_ARRAY_INFO(0, value, 0)
+    ZEND_ARG_INFO(0, ttl)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_enableEviction, 0, 0, 0)
+    ZEND_ARG_INFO(0, enable)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_get, 0, 0, 1)
@@ -52,6 +58,16 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_get, 0, 0, 1)
     ZEND_ARG_INFO(0, field)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_mset, 0, 0, 1)
+    ZEND_ARG_ARRAY_INFO(0, rows, 0)
+    ZEND_ARG_INFO(0, ttl)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_mget, 0, 0, 1)
+    ZEND_ARG_ARRAY_INFO(0, keys, 0)
+    ZEND_ARG_INFO(0, field)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_exist, 0, 0, 1)
     ZEND_ARG_INFO(0, key)
 ZEND_END_ARG_INFO()
@@ -89,15 +105,26 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_decr, 0, 0, 2)
     ZEND_ARG_INFO(0, decrby)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_table_cas, 0, 0, 4)
+    ZEND_ARG_INFO(0, key)
+    ZEND_ARG_INFO(0, column)
+    ZEND_ARG_INFO(0, expected)
+    ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
 static PHP_METHOD(swoole_table, __construct);
 static PHP_METHOD(swoole_table, column);
 static PHP_METHOD(swoole_table, create);
+static PHP_METHOD(swoole_table, enableEviction);
 static PHP_METHOD(swoole_table, set);
 static PHP_METHOD(swoole_table, get);
+static PHP_METHOD(swoole_table, mset);
+static PHP_METHOD(swoole_table, mget);
 static PHP_METHOD(swoole_table, del);
 static PHP_METHOD(swoole_table, exist);
 static PHP_METHOD(swoole_table, incr);
 static PHP_METHOD(swoole_table, decr);
+static PHP_METHOD(swoole_table, cas);
 static PHP_METHOD(swoole_table, count);
 static PHP_METHOD(swoole_table, destroy);
 static PHP_METHOD(swoole_table, getMemorySize);
@@ -125,14 +152,18 @@ static const zend_function_entry swoole_table_methods[] =
     PHP_ME(swoole_table, __construct, arginfo_swoole_table_construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
     PHP_ME(swoole_table, column,      arginfo_swoole_table_column, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, create,      arginfo_swoole_table_void, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_table, enableEviction, arginfo_swoole_table_enableEviction, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, destroy,     arginfo_swoole_table_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, set,         arginfo_swoole_table_set, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, get,         arginfo_swoole_table_get, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_table, mset,        arginfo_swoole_table_mset, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_table, mget,        arginfo_swoole_table_mget, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, count,       arginfo_swoole_table_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, del,         arginfo_swoole_table_del, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, exist,       arginfo_swoole_table_exist, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, incr,        arginfo_swoole_table_incr, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, decr,        arginfo_swoole_table_decr, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_table, cas,         arginfo_swoole_table_cas, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, getMemorySize,    arginfo_swoole_table_void, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, offsetExists,     arginfo_swoole_table_offsetExists, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_table, offsetGet,        arginfo_swoole_table_offsetGet, ZEND_ACC_PUBLIC)
@@ -160,6 +191,33 @@ static const zend_function_entry swoole_table_row_methods[] =
     PHP_FE_END
 };
 
+/**
+ * per-thread buffer that rows are copied to by lock-free reads
+ */
+static __thread swTableRow *php_swoole_table_row_buffer = NULL;
+static __thread size_t php_swoole_table_row_buffer_size = 0;
+
+static swTableRow* php_swoole_table_row_copy(swTable *table, char *key, int keylen)
+{
+    size_t size = sizeof(swTableRow) + table->item_size;
+    if (size > php_swoole_table_row_buffer_size)
+    {
+        swTableRow *buffer = sw_realloc(php_swoole_table_row_buffer, size);
+        if (buffer == NULL)
+        {
+            swoole_php_fatal_error(E_WARNING, "realloc(%ld) failed.", size);
+            return NULL;
+        }
+        php_swoole_table_row_buffer = buffer;
+        php_swoole_table_row_buffer_size = size;
+    }
+    if (swTableRow_get_copy(table, key, keylen, php_swoole_table_row_buffer) < 0)
+    {
+        return NULL;
+    }
+    return php_swoole_table_row_buffer;
+}
+
 static inline void php_swoole_table_row2array(swTable *table, swTableRow *row, zval *return_value)
 {
     array_init(return_value);
@@ -291,8 +349,9 @@ PHP_METHOD(swoole_table, __construct)
 {
     long table_size;
     double conflict_proportion = SW_TABLE_CONFLICT_PROPORTION;
+    long max_size = 0;
 
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|d", &table_size, &conflict_proportion) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|dl", &table_size, &conflict_proportion, &max_size) == FAILURE)
     {
         RETURN_FALSE;
     }
@@ -303,6 +362,11 @@ PHP_METHOD(swoole_table, __construct)
         zend_throw_exception(swoole_exception_class_entry_ptr, "global memory allocation failure.", SW_ERROR_MALLOC_FAIL TSRMLS_CC);
         RETURN_FALSE;
     }
+    //max_size selects the probing engine, which grows from table_size up to max_size
+    if (max_size > 0)
+    {
+        table->max_size = max_size > 0x80000000 ? 0x80000000 : max_size;
+    }
     swoole_set_object(getThis(), table);
 }
 
@@ -355,30 +419,25 @@ static PHP_METHOD(swoole_table, create)
     RETURN_TRUE;
 }
 
-static PHP_METHOD(swoole_table, destroy)
+/**
+ * when the table is full, set() evicts rows not accessed recently instead of failing
+ */
+static PHP_METHOD(swoole_table, enableEviction)
 {
-    swTable *table = swoole_get_object(getThis());
-    if (!table->memory)
+    zend_bool enable = 1;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|b", &enable) == FAILURE)
     {
-        swoole_php_fatal_error(E_ERROR, "the swoole table does not exist.");
         RETURN_FALSE;
     }
 
-    swTable_free(table);
+    swTable *table = swoole_get_object(getThis());
+    table->evict = enable;
     RETURN_TRUE;
 }
 
-static PHP_METHOD(swoole_table, set)
+static PHP_METHOD(swoole_table, destroy)
 {
-    zval *array;
-    char *key;
-    zend_size_t keylen;
-
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sa", &key, &keylen, &array) == FAILURE)
-    {
-        RETURN_FALSE;
-    }
-
     swTable *table = swoole_get_object(getThis());
     if (!table->memory)
     {
@@ -386,13 +445,19 @@ static PHP_METHOD(swoole_table, set)
         RETURN_FALSE;
     }
 
+    swTable_free(table);
+    RETURN_TRUE;
+}
+
+static int php_swoole_table_set(swTable *table, char *key, zend_size_t keylen, zval *array, long ttl)
+{
     swTableRow *_rowlock = NULL;
     swTableRow *row = swTableRow_set(table, key, keylen, &_rowlock);
     if (!row)
     {
         swTableRow_unlock(_rowlock);
         swoole_php_error(E_WARNING, "unable to allocate memory.");
-        RETURN_FALSE;
+        return SW_ERR;
     }
 
     swTableColumn *col;
@@ -427,8 +492,81 @@ static PHP_METHOD(swoole_table, set)
     }
     (void) ktype;
     SW_HASHTABLE_FOREACH_END();
+    row->expire = ttl > 0 ? time(NULL) + ttl : 0;
     swTableRow_unlock(_rowlock);
-    RETURN_TRUE;
+    return SW_OK;
+}
+
+static PHP_METHOD(swoole_table, set)
+{
+    zval *array;
+    char *key;
+    zend_size_t keylen;
+    long ttl = 0;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sa|l", &key, &keylen, &array, &ttl) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+
+    swTable *table = swoole_get_object(getThis());
+    if (!table->memory)
+    {
+        swoole_php_fatal_error(E_ERROR, "the swoole table does not exist.");
+        RETURN_FALSE;
+    }
+    SW_CHECK_RETURN(php_swoole_table_set(table, key, keylen, array, ttl));
+}
+
+/**
+ * set many rows in one call: array(key => array(column => value))
+ */
+static PHP_METHOD(swoole_table, mset)
+{
+    zval *rows;
+    long ttl = 0;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a|l", &rows, &ttl) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+
+    swTable *table = swoole_get_object(getThis());
+    if (!table->memory)
+    {
+        swoole_php_fatal_error(E_ERROR, "the swoole table does not exist.");
+        RETURN_FALSE;
+    }
+
+    zval *v;
+    char *k;
+    uint32_t klen;
+    int ktype;
+    int ret = SW_OK;
+    HashTable *_ht = Z_ARRVAL_P(rows);
+
+    SW_HASHTABLE_FOREACH_START2(_ht, k, klen, ktype, v)
+    {
+        if (k == NULL)
+        {
+            swoole_php_fatal_error(E_WARNING, "the keys of mset() must be strings.");
+            ret = SW_ERR;
+            continue;
+        }
+        else if (SW_Z_TYPE_P(v) != IS_ARRAY)
+        {
+            swoole_php_fatal_error(E_WARNING, "the value of key[%s] must be an array.", k);
+            ret = SW_ERR;
+            continue;
+        }
+        if (php_swoole_table_set(table, k, klen, v, ttl) < 0)
+        {
+            ret = SW_ERR;
+        }
+    }
+    (void) ktype;
+    SW_HASHTABLE_FOREACH_END();
+    SW_CHECK_RETURN(ret);
 }
 
 static PHP_METHOD(swoole_table, offsetSet)
@@ -436,7 +574,7 @@ static PHP_METHOD(swoole_table, offsetSet)
     ZEND_MN(swoole_table_set)(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 
-static PHP_METHOD(swoole_table, incr)
+static void php_swoole_table_incr(INTERNAL_FUNCTION_PARAMETERS, int decr)
 {
     char *key;
     zend_size_t key_len;
@@ -457,41 +595,73 @@ static PHP_METHOD(swoole_table, incr)
         RETURN_FALSE;
     }
 
-    swTableRow *row = swTableRow_set(table, key, key_len, &_rowlock);
-    if (!row)
-    {
-        swTableRow_unlock(_rowlock);
-        swoole_php_fatal_error(E_WARNING, "unable to allocate memory.");
-        RETURN_FALSE;
-    }
-
     swTableColumn *column;
     column = swTableColumn_get(table, col, col_len);
     if (column == NULL)
     {
-        swTableRow_unlock(_rowlock);
         swoole_php_fatal_error(E_WARNING, "column[%s] does not exist.", col);
         RETURN_FALSE;
     }
     else if (column->type == SW_TABLE_STRING)
     {
-        swTableRow_unlock(_rowlock);
-        swoole_php_fatal_error(E_WARNING, "can't execute 'incr' on a string type column.");
+        swoole_php_fatal_error(E_WARNING, "can't execute '%s' on a string type column.", decr ? "decr" : "incr");
         RETURN_FALSE;
     }
-    else if (column->type == SW_TABLE_FLOAT)
+
+    double dval = 1;
+    int64_t lval = 1;
+    if (incrby)
     {
-        double set_value = 0;
-        memcpy(&set_value, row->data + column->index, sizeof(set_value));
-        if (incrby)
+        if (column->type == SW_TABLE_FLOAT)
         {
             convert_to_double(incrby);
-            set_value += Z_DVAL_P(incrby);
+            dval = Z_DVAL_P(incrby);
         }
         else
         {
-            set_value += 1;
+            convert_to_long(incrby);
+            lval = Z_LVAL_P(incrby);
+        }
+    }
+    if (decr)
+    {
+        dval = -dval;
+        lval = -lval;
+    }
+
+    //existing row: atomic update without the row lock
+    swTableRow *row = swTableRow_pin(table, key, key_len, &_rowlock);
+    if (row)
+    {
+        if (swTableColumn_atomic(row, column))
+        {
+            if (column->type == SW_TABLE_FLOAT)
+            {
+                RETVAL_DOUBLE(swTableRow_atomic_add_double(row, column, dval));
+            }
+            else
+            {
+                RETVAL_LONG(swTableRow_atomic_add_long(row, column, lval));
+            }
+            swTableRow_unpin(_rowlock);
+            return;
         }
+        swTableRow_unpin(_rowlock);
+    }
+
+    row = swTableRow_set(table, key, key_len, &_rowlock);
+    if (!row)
+    {
+        swTableRow_unlock(_rowlock);
+        swoole_php_fatal_error(E_WARNING, "unable to allocate memory.");
+        RETURN_FALSE;
+    }
+
+    if (column->type == SW_TABLE_FLOAT)
+    {
+        double set_value = 0;
+        memcpy(&set_value, row->data + column->index, sizeof(set_value));
+        set_value += dval;
         swTableRow_set_value(row, column, &set_value, 0);
         RETVAL_DOUBLE(set_value);
     }
@@ -499,30 +669,33 @@ static PHP_METHOD(swoole_table, incr)
     {
         int64_t set_value = 0;
         memcpy(&set_value, row->data + column->index, column->size);
-        if (incrby)
-        {
-            convert_to_long(incrby);
-            set_value += Z_LVAL_P(incrby);
-        }
-        else
-        {
-            set_value += 1;
-        }
+        set_value += lval;
         swTableRow_set_value(row, column, &set_value, 0);
         RETVAL_LONG(set_value);
     }
     swTableRow_unlock(_rowlock);
 }
 
+static PHP_METHOD(swoole_table, incr)
+{
+    php_swoole_table_incr(INTERNAL_FUNCTION_PARAM_PASSTHRU, 0);
+}
+
 static PHP_METHOD(swoole_table, decr)
+{
+    php_swoole_table_incr(INTERNAL_FUNCTION_PARAM_PASSTHRU, 1);
+}
+
+static PHP_METHOD(swoole_table, cas)
 {
     char *key;
     zend_size_t key_len;
     char *col;
     zend_size_t col_len;
-    zval *decrby = NULL;
+    zval *expected;
+    zval *value;
 
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ss|z", &key, &key_len, &col, &col_len, &decrby) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sszz", &key, &key_len, &col, &col_len, &expected, &value) == FAILURE)
     {
         RETURN_FALSE;
     }
@@ -535,59 +708,78 @@ static PHP_METHOD(swoole_table, decr)
         RETURN_FALSE;
     }
 
-    swTableRow *row = swTableRow_set(table, key, key_len, &_rowlock);
-    if (!row)
-    {
-        swTableRow_unlock(_rowlock);
-        swoole_php_fatal_error(E_WARNING, "unable to allocate memory.");
-        RETURN_FALSE;
-    }
-
     swTableColumn *column;
     column = swTableColumn_get(table, col, col_len);
     if (column == NULL)
     {
-        swTableRow_unlock(_rowlock);
         swoole_php_fatal_error(E_WARNING, "column[%s] does not exist.", col);
         RETURN_FALSE;
     }
     else if (column->type == SW_TABLE_STRING)
     {
-        swTableRow_unlock(_rowlock);
-        swoole_php_fatal_error(E_WARNING, "can't execute 'decr' on a string type column.");
+        swoole_php_fatal_error(E_WARNING, "can't execute 'cas' on a string type column.");
         RETURN_FALSE;
     }
-    else if (column->type == SW_TABLE_FLOAT)
+
+    if (column->type == SW_TABLE_FLOAT)
     {
-        double set_value = 0;
-        memcpy(&set_value, row->data + column->index, sizeof(set_value));
-        if (decrby)
+        convert_to_double(expected);
+        convert_to_double(value);
+    }
+    else
+    {
+        convert_to_long(expected);
+        convert_to_long(value);
+    }
+
+    swTableRow *row = swTableRow_pin(table, key, key_len, &_rowlock);
+    if (row)
+    {
+        if (swTableColumn_atomic(row, column))
         {
-            convert_to_double(decrby);
-            set_value -= Z_DVAL_P(decrby);
+            if (column->type == SW_TABLE_FLOAT)
+            {
+                RETVAL_BOOL(swTableRow_atomic_cas_double(row, column, Z_DVAL_P(expected), Z_DVAL_P(value)));
+            }
+            else
+            {
+                RETVAL_BOOL(swTableRow_atomic_cas_long(row, column, Z_LVAL_P(expected), Z_LVAL_P(value)));
+            }
+            swTableRow_unpin(_rowlock);
+            return;
         }
-        else
+        swTableRow_unpin(_rowlock);
+    }
+
+    row = swTableRow_get(table, key, key_len, &_rowlock);
+    if (!row)
+    {
+        swTableRow_unlock(_rowlock);
+        RETURN_FALSE;
+    }
+
+    if (column->type == SW_TABLE_FLOAT)
+    {
+        double current = 0;
+        memcpy(&current, row->data + column->index, sizeof(current));
+        RETVAL_BOOL(current == Z_DVAL_P(expected));
+        if (current == Z_DVAL_P(expected))
         {
-            set_value -= 1;
+            swTableRow_set_value(row, column, &Z_DVAL_P(value), 0);
         }
-        swTableRow_set_value(row, column, &set_value, 0);
-        RETVAL_DOUBLE(set_value);
     }
     else
     {
-        int64_t set_value = 0;
-        memcpy(&set_value, row->data + column->index, column->size);
-        if (decrby)
+        //compare the bytes the column stores, like the atomic path does
+        int64_t current = 0;
+        int64_t expected_value = 0;
+        memcpy(&current, row->data + column->index, column->size);
+        memcpy(&expected_value, &Z_LVAL_P(expected), column->size);
+        RETVAL_BOOL(current == expected_value);
+        if (current == expected_value)
         {
-            convert_to_long(decrby);
-            set_value -= Z_LVAL_P(decrby);
+            swTableRow_set_value(row, column, &Z_LVAL_P(value), 0);
         }
-        else
-        {
-            set_value -= 1;
-        }
-        swTableRow_set_value(row, column, &set_value, 0);
-        RETVAL_LONG(set_value);
     }
     swTableRow_unlock(_rowlock);
 }
@@ -605,7 +797,6 @@ static PHP_METHOD(swoole_table, get)
         RETURN_FALSE;
     }
 
-    swTableRow *_rowlock = NULL;
     swTable *table = swoole_get_object(getThis());
     if (!table->memory)
     {
@@ -613,7 +804,7 @@ static PHP_METHOD(swoole_table, get)
         RETURN_FALSE;
     }
 
-    swTableRow *row = swTableRow_get(table, key, keylen, &_rowlock);
+    swTableRow *row = php_swoole_table_row_copy(table, key, keylen);
     if (!row)
     {
         RETVAL_FALSE;
@@ -626,7 +817,74 @@ static PHP_METHOD(swoole_table, get)
     {
         php_swoole_table_row2array(table, row, return_value);
     }
-    swTableRow_unlock(_rowlock);
+}
+
+/**
+ * get many rows in one call, missing keys map to false
+ */
+static PHP_METHOD(swoole_table, mget)
+{
+    zval *keys;
+
+    char *field = NULL;
+    zend_size_t field_len = 0;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a|s", &keys, &field, &field_len) == FAILURE)
+    {
+        RETURN_FALSE;
+    }
+
+    swTable *table = swoole_get_object(getThis());
+    if (!table->memory)
+    {
+        swoole_php_fatal_error(E_ERROR, "the swoole table does not exist.");
+        RETURN_FALSE;
+    }
+
+    array_init(return_value);
+
+    zval *key;
+    zval *value;
+    char *k;
+    int klen;
+    char buf[32];
+    HashTable *_ht = Z_ARRVAL_P(keys);
+
+    SW_HASHTABLE_FOREACH_START(_ht, key)
+    {
+        if (SW_Z_TYPE_P(key) == IS_STRING)
+        {
+            k = Z_STRVAL_P(key);
+            klen = Z_STRLEN_P(key);
+        }
+        else if (SW_Z_TYPE_P(key) == IS_LONG)
+        {
+            klen = snprintf(buf, sizeof(buf), "%ld", (long) Z_LVAL_P(key));
+            k = buf;
+        }
+        else
+        {
+            swoole_php_fatal_error(E_WARNING, "the keys of mget() must be strings or integers.");
+            continue;
+        }
+        SW_MAKE_STD_ZVAL(value);
+
+        swTableRow *row = php_swoole_table_row_copy(table, k, klen);
+        if (!row)
+        {
+            ZVAL_BOOL(value, 0);
+        }
+        else if (field && field_len > 0)
+        {
+            php_swoole_table_get_field_value(table, row, value, field, (uint16_t) field_len);
+        }
+        else
+        {
+            php_swoole_table_row2array(table, row, value);
+        }
+        sw_add_assoc_zval_ex(return_value, k, klen + 1, value);
+    }
+    SW_HASHTABLE_FOREACH_END();
 }
 
 static PHP_METHOD(swoole_table, offsetGet)
@@ -642,7 +900,6 @@ static PHP_METHOD(swoole_table, offsetGet)
         RETURN_FALSE;
     }
 
-    swTableRow *_rowlock = NULL;
     swTable *table = swoole_get_object(getThis());
     if (!table->memory)
     {
@@ -653,7 +910,7 @@ static PHP_METHOD(swoole_table, offsetGet)
     zval *value;
     SW_MAKE_STD_ZVAL(value);
 
-    swTableRow *row = swTableRow_get(table, key, keylen, &_rowlock);
+    swTableRow *row = php_swoole_table_row_copy(table, key, keylen);
     if (!row)
     {
         array_init(value);
@@ -662,7 +919,6 @@ static PHP_METHOD(swoole_table, offsetGet)
     {
         php_swoole_table_row2array(table, row, value);
     }
-    swTableRow_unlock(_rowlock);
 
     object_init_ex(return_value, swoole_table_row_class_entry_ptr);
     zend_update_property(swoole_table_row_class_entry_ptr, return_value, ZEND_STRL("value"), value TSRMLS_CC);
@@ -688,10 +944,7 @@ static PHP_METHOD(swoole_table, exist)
         RETURN_FALSE;
     }
 
-    swTableRow *_rowlock = NULL;
-    swTableRow *row = swTableRow_get(table, key, keylen, &_rowlock);
-    swTableRow_unlock(_rowlock);
-    if (!row)
+    if (swTableRow_get_copy(table, key, keylen, NULL) < 0)
     {
         RETURN_FALSE;
     }
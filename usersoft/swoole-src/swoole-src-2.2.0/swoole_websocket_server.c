@@ -42,6 +42,7 @@ static int websocket_handshake(swListenPort *, http_context *);
 
 static PHP_METHOD(swoole_websocket_server, on);
 static PHP_METHOD(swoole_websocket_server, push);
+static PHP_METHOD(swoole_websocket_server, broadcast);
 static PHP_METHOD(swoole_websocket_server, exist);
 static PHP_METHOD(swoole_websocket_server, isEstablished);
 static PHP_METHOD(swoole_websocket_server, pack);
@@ -59,6 +60,13 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_websocket_server_push, 0, 0, 2)
     ZEND_ARG_INFO(0, finish)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_websocket_server_broadcast, 0, 0, 2)
+    ZEND_ARG_ARRAY_INFO(0, fds, 0)
+    ZEND_ARG_INFO(0, data)
+    ZEND_ARG_INFO(0, opcode)
+    ZEND_ARG_INFO(0, finish)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_websocket_server_pack, 0, 0, 1)
     ZEND_ARG_INFO(0, data)
     ZEND_ARG_INFO(0, opcode)
@@ -82,6 +90,7 @@ const zend_function_entry swoole_websocket_server_methods[] =
 {
     PHP_ME(swoole_websocket_server, on,         arginfo_swoole_websocket_server_on, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_websocket_server, push,       arginfo_swoole_websocket_server_push, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_websocket_server, broadcast,  arginfo_swoole_websocket_server_broadcast, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_websocket_server, exist,      arginfo_swoole_websocket_server_exist, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_websocket_server, isEstablished,      arginfo_swoole_websocket_server_isEstablished, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_websocket_server, pack,       arginfo_swoole_websocket_server_pack, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -488,6 +497,68 @@ static PHP_METHOD(swoole_websocket_server, push)
     }
 }
 
+/**
+ * the frame is encoded once and the same buffer is sent to every established connection,
+ * returns the number of connections it was queued to
+ */
+static PHP_METHOD(swoole_websocket_server, broadcast)
+{
+    zval *zfds;
+    zval *zdata;
+    long opcode = WEBSOCKET_OPCODE_TEXT_FRAME;
+    zend_bool fin = 1;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "az|lb", &zfds, &zdata, &opcode, &fin) == FAILURE)
+    {
+        return;
+    }
+
+    if (opcode > WEBSOCKET_OPCODE_PONG)
+    {
+        swoole_php_fatal_error(E_WARNING, "the maximum value of opcode is 10.");
+        RETURN_FALSE;
+    }
+
+    char *data;
+    int length = php_swoole_get_send_data(zdata, &data TSRMLS_CC);
+
+    if (length < 0)
+    {
+        RETURN_FALSE;
+    }
+
+    swServer *serv = SwooleG.serv;
+    swString_clear(swoole_http_buffer);
+    swWebSocket_encode(swoole_http_buffer, data, length, opcode, (int) fin, 0);
+
+    long n = 0;
+    zval *zfd;
+    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(zfds), zfd)
+    {
+        if (Z_TYPE_P(zfd) != IS_LONG)
+        {
+            continue;
+        }
+        long fd = Z_LVAL_P(zfd);
+        if (fd <= 0)
+        {
+            continue;
+        }
+        swConnection *conn = swWorker_get_connection(serv, fd);
+        if (!conn || conn->websocket_status < WEBSOCKET_STATUS_ACTIVE)
+        {
+            continue;
+        }
+        if (swServer_tcp_send(serv, fd, swoole_http_buffer->str, swoole_http_buffer->length) == SW_OK)
+        {
+            n++;
+        }
+    }
+    SW_HASHTABLE_FOREACH_END();
+
+    RETURN_LONG(n);
+}
+
 static PHP_METHOD(swoole_websocket_server, pack)
 {
     char *data;
@@ -12,5 +12,11 @@ if test "$PHP_XHPROF" != "no"; then
     AC_MSG_RESULT([no])
   fi
 
+  dnl CPU time is read from the perf events task clock on Linux
+  AC_CHECK_HEADERS([linux/perf_event.h])
+
+  dnl the sampling mode takes its samples from a thread
+  PHP_CHECK_FUNC(pthread_create, pthread)
+
   PHP_NEW_EXTENSION(xhprof, xhprof.c, $ext_shared)
 fi
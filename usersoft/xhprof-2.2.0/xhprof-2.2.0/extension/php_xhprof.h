@@ -31,6 +31,28 @@ extern zend_module_entry xhprof_module_entry;
 #include "TSRM.h"
 #endif
 
+/* Sampling mode takes its samples from a thread that interrupts the VM at
+ * every sampling interval, instead of hooking every call. It needs threads
+ * and the VM interrupts of PHP 7.1. Otherwise it checks the time at every
+ * call, like the hierarchical mode. */
+#if defined(HAVE_PTHREAD_CREATE) && !defined(ZEND_WIN32) && PHP_VERSION_ID >= 70100
+#define XHPROF_SAMPLING_THREAD 1
+#include <pthread.h>
+#endif
+
+/* On x86-64, wall time is read from the TSC when it is invariant, see
+ * hp_init_timers(). On Linux, CPU time is read from the task clock page of
+ * perf events, without a system call, when the kernel allows it. */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(ZEND_WIN32) && !defined(__APPLE__)
+#define XHPROF_TSC 1
+#include <stdint.h>
+#endif
+
+#if defined(XHPROF_TSC) && defined(__linux__) && defined(HAVE_LINUX_PERF_EVENT_H)
+#define XHPROF_PERF_CPU_TIME 1
+#include <linux/perf_event.h>
+#endif
+
 
 /**
  * **********************
@@ -43,6 +65,14 @@ extern zend_module_entry xhprof_module_entry;
 
 #define XHPROF_FUNC_HASH_COUNTERS_SIZE   1024
 
+/* Initial number of slots of the function and edge tables of the
+ * hierarchical mode. Must be a power of 2. */
+#define XHPROF_TABLE_INITIAL_SIZE        1024
+
+/* Number of hp_entry_t allocated at once for the profile stack. Each
+ * profiled coroutine has a stack, so a chunk is kept small. */
+#define XHPROF_ENTRY_CHUNK_SIZE          64
+
 /* Fictitious function name to represent top of the call tree. The paranthesis
  * in the name is to ensure we don't conflict with user function names.  */
 #define ROOT_SYMBOL                "main()"
@@ -64,11 +94,28 @@ extern zend_module_entry xhprof_module_entry;
 #define XHPROF_FLAGS_NO_BUILTINS   0x0001         /* do not profile builtins */
 #define XHPROF_FLAGS_CPU           0x0002      /* gather CPU times for funcs */
 #define XHPROF_FLAGS_MEMORY        0x0004   /* gather memory usage for funcs */
+#define XHPROF_FLAGS_MEMORY_ALLOC  0x0008       /* count allocations of funcs */
 
 /* Constants for XHPROF_MODE_SAMPLED        */
 #define XHPROF_DEFAULT_SAMPLING_INTERVAL       100000      /* In microsecs        */
 #define XHPROF_MINIMAL_SAMPLING_INTERVAL          100      /* In microsecs        */
 
+/* Binary output format, see hp_binary_write() */
+#define XHPROF_BINARY_MAGIC        "XHPB"
+#define XHPROF_BINARY_VERSION      3
+
+/* Largest payload of a UDP datagram */
+#define XHPROF_MAX_UDP_PAYLOAD     65507
+
+/* The coroutine switch hooks of swoole, the values of enum
+ * swGlobal_hook_type in its swoole.h. They are only known for this version.
+ * The hooks are passed a pointer to the int id of the coroutine. */
+#define XHPROF_SWOOLE_VERSION           "2.2.0"
+#define XHPROF_SWOOLE_HOOK_CORO_CREATE  2
+#define XHPROF_SWOOLE_HOOK_CORO_RESUME  3
+#define XHPROF_SWOOLE_HOOK_CORO_YIELD   4
+#define XHPROF_SWOOLE_HOOK_CORO_CLOSE   5
+
 /* Constant for ignoring functions, transparent to hierarchical profile */
 #define XHPROF_MAX_IGNORED_FUNCTIONS  256
 
@@ -101,6 +148,8 @@ do {                                                                     \
         (cur_entry)->hash_code = hash_code % XHPROF_FUNC_HASH_COUNTERS_SIZE;  \
         (cur_entry)->name_hprof = symbol;                               \
         (cur_entry)->prev_hprof = (*(entries));                         \
+        (cur_entry)->frame = NULL;                                      \
+        (cur_entry)->swt = 0;                                           \
         /* Call the universal callback */                               \
         hp_mode_common_beginfn((entries), (cur_entry));                 \
         /* Call the mode's beginfn callback */                          \
@@ -156,8 +205,85 @@ typedef struct hp_entry_t {
     zend_ulong              tsc_start;         /* start value for TSC counter  */
     zend_ulong              cpu_start;
     zend_ulong              hash_code;     /* hash_code for the function name  */
+    uint32                  func_id;      /* id of name@rlvl, hierarchical mode */
+    zend_ulong              alloc_count_start;    /* XHPROF_FLAGS_MEMORY_ALLOC */
+    zend_ulong              free_count_start;
+    zend_ulong              alloc_bytes_start;
+    zend_execute_data      *frame;         /* frame of a call of the VM, or NULL */
+    zend_ulong              swt;         /* wall time its coroutine was suspended */
 } hp_entry_t;
 
+/* A function seen in hierarchical mode. Each name and recursion level pair
+ * gets its own id, so that "foo" and "foo@1" are different functions. */
+typedef struct hp_function_t {
+    zend_string            *name;
+    int                     rlvl;
+    zend_ulong              hash;
+    zend_string            *symbol;                  /* "name" or "name@rlvl" */
+} hp_function_t;
+
+/* The counters of a parent==>child pair, summed at every call of the child.
+ * They are converted to the stats_count array only by xhprof_disable(). */
+typedef struct hp_edge_t {
+    uint32                  parent;             /* function id, 0 for none */
+    uint32                  child;
+    zend_long               ct;
+    zend_long               wt;
+    zend_long               cpu;
+    zend_long               mu;
+    zend_long               pmu;
+    zend_long               na;                   /* number of allocations */
+    zend_long               nf;                         /* number of frees */
+    zend_long               aa;                         /* allocated bytes */
+    zend_long               swt;                 /* suspended wall time */
+} hp_edge_t;
+
+/* Open addressing index over a dense array of items, kept in the order they
+ * were added. The slots hold item index + 1, 0 marks an empty slot. */
+typedef struct hp_table_t {
+    void                   *items;
+    uint32                  count;
+    uint32                  size;               /* allocated items */
+    uint32                 *slots;
+    uint32                  mask;               /* number of slots - 1 */
+    zend_bool               persistent;        /* allocated with malloc() */
+} hp_table_t;
+
+/* A profile stack is strictly LIFO, so its entries are taken from chunks
+ * of contiguous entries, like a stack. The chunks are kept for reuse. */
+typedef struct hp_entry_chunk_t {
+    struct hp_entry_chunk_t *prev;                        /* the chunk below */
+    struct hp_entry_chunk_t *next;              /* the chunk above, if any */
+    uint32                   used;
+    hp_entry_t               entries[XHPROF_ENTRY_CHUNK_SIZE];
+} hp_entry_chunk_t;
+
+/* The profile stack of a swoole coroutine, or of the request outside of the
+ * coroutines. It is saved here while the coroutine is suspended, along with
+ * the counters at that time: the time and memory used by the other stacks
+ * meanwhile are taken off its calls when it continues. */
+typedef struct hp_coroutine_t {
+    struct hp_coroutine_t  *prev;     /* the stack it was entered from */
+    zend_long               cid;               /* -1 for the request */
+    hp_entry_t             *entries;
+    hp_entry_chunk_t       *entry_chunk;
+    zend_ulong              suspend_wt;
+    zend_ulong              suspend_cpu;
+    long int                suspend_mu;
+    zend_ulong              suspend_alloc_count;
+    zend_ulong              suspend_free_count;
+    zend_ulong              suspend_alloc_bytes;
+} hp_coroutine_t;
+
+/* The name of a function, resolved once per zend_function. The function name
+ * and scope it was resolved from tell if the zend_function is still the
+ * same one: closures are freed and trampolines are reused for other names. */
+typedef struct hp_function_name_t {
+    zend_string            *function_name;
+    zend_class_entry       *scope;
+    zend_string            *name;                 /* "class::function" or "function" */
+} hp_function_name_t;
+
 typedef struct hp_ignored_functions {
     zend_string **names;
     zend_ulong filter[XHPROF_MAX_IGNORED_FUNCTIONS];
@@ -165,6 +291,21 @@ typedef struct hp_ignored_functions {
 
 typedef zend_string* (*hp_trace_callback) (zend_string *symbol, zend_execute_data *data);
 
+#ifdef XHPROF_SAMPLING_THREAD
+/* Shared by a request and its sampling thread. The thread sets pending and
+ * the VM interrupt flag at every sampling interval. The VM then calls
+ * hp_interrupt_function() at the next safe point, which takes the sample. */
+typedef struct hp_sampler_t {
+    pthread_t               thread;
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    int                     running;         /* cleared to stop the thread */
+    volatile zend_bool      pending;                   /* a sample is due */
+    zend_bool              *vm_interrupt;       /* EG(vm_interrupt) of the request */
+    zend_ulong              interval;                      /* in microsecs */
+} hp_sampler_t;
+#endif
+
 /* Various types for XHPROF callbacks       */
 typedef void (*hp_init_cb)           ();
 typedef void (*hp_exit_cb)           ();
@@ -192,6 +333,12 @@ ZEND_DLEXPORT zend_op_array* hp_compile_file(zend_file_handle *file_handle, int
 static zend_op_array * (*_zend_compile_string) (zval *source_string, char *filename);
 ZEND_DLEXPORT zend_op_array* hp_compile_string(zval *source_string, char *filename);
 
+#ifdef XHPROF_SAMPLING_THREAD
+/* Pointer to the original interrupt function */
+static void (*_zend_interrupt_function) (zend_execute_data *execute_data);
+ZEND_DLEXPORT void hp_interrupt_function(zend_execute_data *execute_data);
+#endif
+
 /**
  * ****************************
  * STATIC FUNCTION DECLARATIONS
@@ -204,19 +351,41 @@ static void hp_stop();
 static void hp_end();
 
 static inline zend_ulong cycle_timer();
+static void hp_init_timers();
 
-static void hp_free_the_free_list();
+static void hp_free_the_entry_chunks();
 static hp_entry_t *hp_fast_alloc_hprof_entry();
 static void hp_fast_free_hprof_entry(hp_entry_t *p);
 
 static void incr_us_interval(struct timeval *start, zend_ulong incr);
 
+static void hp_tables_init();
+static void hp_tables_free();
+static void hp_tables_to_stats_count();
+
+static void hp_alloc_tracking_start();
+static void hp_alloc_tracking_stop();
+
+static void hp_coroutine_hooks_init();
+static void hp_coroutines_start();
+static void hp_coroutines_stop();
+
+static void hp_binary_add();
+static int hp_binary_write();
+static void hp_binary_free();
+
+#ifdef XHPROF_SAMPLING_THREAD
+static void hp_sampler_start();
+static void hp_sampler_stop();
+#endif
+
 static void hp_get_ignored_functions_from_arg(zval *args);
 
 static inline void hp_array_del(zend_string **names);
 
 zend_string *hp_get_trace_callback(zend_string *symbol, zend_execute_data *data);
 void hp_init_trace_callbacks();
+void hp_init_function_names();
 
 double get_timebase_conversion();
 
@@ -245,17 +414,38 @@ ZEND_BEGIN_MODULE_GLOBALS(xhprof)
     /* Indicates if xhprof was ever enabled during this request */
     int              ever_enabled;
 
+    /* Indicates if the execute and compile proxies profile the calls. Not set
+     * when sampling from the sampling thread. */
+    int              profile_calls;
+
     /* Holds all the xhprof statistics */
     zval            stats_count;
 
+    /* Hierarchical mode statistics, until they are put in stats_count */
+    hp_table_t      functions;
+    hp_table_t      edges;
+
     /* Indicates the current xhprof mode or level */
     int              profiler_level;
 
     /* Top of the profile stack */
     hp_entry_t      *entries;
 
-    /* freelist of hp_entry_t chunks for reuse... */
-    hp_entry_t      *entry_free_list;
+    /* chunk of the top of the profile stack, the chunks are kept for reuse */
+    hp_entry_chunk_t *entry_chunk;
+
+    /* chunks given back by the stacks of the coroutines which ended */
+    hp_entry_chunk_t *entry_chunk_spare;
+
+    /* The profile stacks of the swoole coroutines, indexed by coroutine id,
+     * when swoole calls the hooks. Hierarchical mode only. */
+    HashTable       *coroutines;
+    hp_coroutine_t   request_coroutine;
+    hp_coroutine_t  *coroutine;                   /* the running stack */
+    zend_bool        coroutine_stats;       /* the profile has "swt" */
+
+    /* Resolved function names, indexed by zend_function pointer */
+    HashTable       *function_names;
 
     /* Callbacks for various xhprof modes */
     hp_mode_cb       mode_cb;
@@ -269,6 +459,9 @@ ZEND_BEGIN_MODULE_GLOBALS(xhprof)
     zend_long        sampling_interval;
     zend_ulong       sampling_interval_tsc;
     zend_long        sampling_depth;
+#ifdef XHPROF_SAMPLING_THREAD
+    hp_sampler_t    *sampler;
+#endif
     /* XHProf flags */
     uint32 xhprof_flags;
 
@@ -284,8 +477,48 @@ ZEND_BEGIN_MODULE_GLOBALS(xhprof)
 
     double timebase_conversion;
 
+#ifdef XHPROF_TSC
+    /* microseconds per TSC tick for this profiling session, 0 if the TSC
+     * is not used */
+    double tsc_us_per_tick;
+#endif
+
+#ifdef XHPROF_PERF_CPU_TIME
+    /* task clock of the thread, when XHPROF_FLAGS_CPU is set */
+    int perf_cpu_fd;
+    struct perf_event_mmap_page *perf_cpu_page;
+#endif
+
     zend_bool collect_additional_info;
 
+    /* XHPROF_FLAGS_MEMORY_ALLOC: the allocations and frees counted by the
+     * memory manager handlers since the module was loaded */
+    int              alloc_tracking;
+    zend_long        memory_alloc_sampling;
+    zend_ulong       alloc_every;
+    zend_ulong       alloc_tick;
+    zend_ulong       free_tick;
+    zend_ulong       alloc_count;
+    zend_ulong       free_count;
+    zend_ulong       alloc_bytes;
+    zend_mm_heap    *mm_heap;
+    void *         (*_zend_malloc) (size_t size);
+    void           (*_zend_free) (void *ptr);
+    void *         (*_zend_realloc) (void *ptr, size_t size);
+
+    /* Binary output destination, a file or udp://host:port */
+    char *binary_output;
+
+    /* Number of requests aggregated before the binary output is written */
+    zend_long binary_aggregate;
+
+    /* The profiles aggregated since the binary output was last written. They
+     * outlive the requests, so they are allocated with malloc(). */
+    HashTable       *binary_symbols;                        /* symbol => id */
+    hp_table_t       binary_edges;
+    zend_long        binary_requests;
+    uint32           binary_flags;
+
 ZEND_END_MODULE_GLOBALS(xhprof)
 
 PHP_MINIT_FUNCTION(xhprof);
@@ -296,6 +529,7 @@ PHP_MINFO_FUNCTION(xhprof);
 
 PHP_FUNCTION(xhprof_enable);
 PHP_FUNCTION(xhprof_disable);
+PHP_FUNCTION(xhprof_disable_binary);
 PHP_FUNCTION(xhprof_sample_enable);
 PHP_FUNCTION(xhprof_sample_disable);
 
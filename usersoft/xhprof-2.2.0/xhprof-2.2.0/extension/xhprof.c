@@ -24,16 +24,21 @@
 #include "ext/standard/info.h"
 #include "php_xhprof.h"
 #include "zend_extensions.h"
+#include "zend_smart_str.h"
 #ifndef ZEND_WIN32
 # include <sys/time.h>
 # include <sys/resource.h>
 # include <unistd.h>
+# include <sys/socket.h>
+# include <netdb.h>
 #else
 # include "win32/time.h"
 # include "win32/getrusage.h"
 # include "win32/unistd.h"
 #endif
 #include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
 
 #if HAVE_PCRE
 #include "ext/pcre/php_pcre.h"
@@ -48,6 +53,24 @@
 LARGE_INTEGER performance_frequency;
 #endif
 
+#ifdef XHPROF_TSC
+#include <cpuid.h>
+#include <x86intrin.h>
+
+/* The TSC and the monotonic clock at module init. The TSC is calibrated
+ * against the clock when it is first needed, over all the time since. */
+static uint64_t        tsc_calibration_start;
+static struct timespec tsc_calibration_start_time;
+
+/* 0 when not calibrated yet, -1 when the TSC is not invariant */
+static double          tsc_us_per_tick;
+#endif
+
+#ifdef XHPROF_PERF_CPU_TIME
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
 ZEND_DECLARE_MODULE_GLOBALS(xhprof)
 
 /**
@@ -65,6 +88,9 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO(arginfo_xhprof_disable, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO(arginfo_xhprof_disable_binary, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO(arginfo_xhprof_sample_enable, 0)
 ZEND_END_ARG_INFO()
 
@@ -81,15 +107,23 @@ ZEND_END_ARG_INFO()
 zend_function_entry xhprof_functions[] = {
   PHP_FE(xhprof_enable, arginfo_xhprof_enable)
   PHP_FE(xhprof_disable, arginfo_xhprof_disable)
+  PHP_FE(xhprof_disable_binary, arginfo_xhprof_disable_binary)
   PHP_FE(xhprof_sample_enable, arginfo_xhprof_sample_enable)
   PHP_FE(xhprof_sample_disable, arginfo_xhprof_sample_disable)
   {NULL, NULL, NULL}
 };
 
+/* swoole, when loaded, starts first for hp_coroutine_hooks_init() */
+static const zend_module_dep xhprof_deps[] = {
+        ZEND_MOD_OPTIONAL("swoole")
+        ZEND_MOD_END
+};
+
 /* Callback functions for the xhprof extension */
 zend_module_entry xhprof_module_entry = {
 #if ZEND_MODULE_API_NO >= 20010901
-        STANDARD_MODULE_HEADER,
+        STANDARD_MODULE_HEADER_EX, NULL,
+        xhprof_deps,
 #endif
         "xhprof",                        /* Name of the extension */
         xhprof_functions,                /* List of functions exposed */
@@ -114,6 +148,24 @@ PHP_INI_BEGIN()
  */
 PHP_INI_ENTRY("xhprof.output_dir", "", PHP_INI_ALL, NULL)
 
+/* memory_alloc_sampling:
+ * With XHPROF_FLAGS_MEMORY_ALLOC, count only one allocation in this many,
+ * and scale the counts up. 1 counts all of them.
+ */
+STD_PHP_INI_ENTRY("xhprof.memory_alloc_sampling", "1", PHP_INI_ALL, OnUpdateLong, memory_alloc_sampling, zend_xhprof_globals, xhprof_globals)
+
+/* binary_output:
+ * Where xhprof_disable_binary() writes the profiles, a file the profiles
+ * are appended to or udp://host:port.
+ */
+STD_PHP_INI_ENTRY("xhprof.binary_output", "", PHP_INI_ALL, OnUpdateString, binary_output, zend_xhprof_globals, xhprof_globals)
+
+/* binary_aggregate:
+ * Number of requests whose profiles are added up by xhprof_disable_binary()
+ * before they are written. The rest is written at module shutdown.
+ */
+STD_PHP_INI_ENTRY("xhprof.binary_aggregate", "1", PHP_INI_ALL, OnUpdateLong, binary_aggregate, zend_xhprof_globals, xhprof_globals)
+
 /*
  * collect_additional_info
  * Collect mysql_query, curl_exec internal info. The default is 0.
@@ -182,11 +234,49 @@ PHP_FUNCTION(xhprof_disable)
 {
     if (XHPROF_G(enabled)) {
         hp_stop();
+        hp_tables_to_stats_count();
         RETURN_ZVAL(&XHPROF_G(stats_count), 1, 0);
     }
     /* else null is returned */
 }
 
+/**
+ * Stops XHProf from profiling in hierarchical mode and adds the profile to
+ * the binary output, instead of returning it as an array. The profiles are
+ * written to xhprof.binary_output every xhprof.binary_aggregate requests.
+ *
+ * @param  void
+ * @return bool  false if nothing was profiled or the write failed
+ */
+PHP_FUNCTION(xhprof_disable_binary)
+{
+    if (zend_parse_parameters_none() == FAILURE) {
+        return;
+    }
+
+    if (!XHPROF_G(enabled) || XHPROF_G(profiler_level) != XHPROF_MODE_HIERARCHICAL) {
+        RETURN_FALSE;
+    }
+
+    hp_stop();
+
+    if (!XHPROF_G(binary_output) || !*XHPROF_G(binary_output)) {
+        php_error_docref(NULL, E_WARNING, "xhprof.binary_output is not set");
+        RETURN_FALSE;
+    }
+
+    hp_binary_add();
+
+    if (XHPROF_G(binary_requests) >= XHPROF_G(binary_aggregate)) {
+        if (hp_binary_write() == FAILURE) {
+            php_error_docref(NULL, E_WARNING, "Cannot write the profiles to '%s': %s", XHPROF_G(binary_output), strerror(errno));
+            RETURN_FALSE;
+        }
+    }
+
+    RETURN_TRUE;
+}
+
 /**
  * Start XHProf profiling in sampling mode.
  *
@@ -221,6 +311,7 @@ static void php_xhprof_init_globals(zend_xhprof_globals *xhprof_globals)
 {
     xhprof_globals->enabled = 0;
     xhprof_globals->ever_enabled = 0;
+    xhprof_globals->profile_calls = 0;
     xhprof_globals->xhprof_flags = 0;
     xhprof_globals->entries = NULL;
     xhprof_globals->root = NULL;
@@ -228,11 +319,41 @@ static void php_xhprof_init_globals(zend_xhprof_globals *xhprof_globals)
     xhprof_globals->ignored_functions = NULL;
     xhprof_globals->sampling_interval = XHPROF_DEFAULT_SAMPLING_INTERVAL;
     xhprof_globals->sampling_depth = INT_MAX;
+#ifdef XHPROF_TSC
+    xhprof_globals->tsc_us_per_tick = 0;
+#endif
+#ifdef XHPROF_PERF_CPU_TIME
+    xhprof_globals->perf_cpu_fd = -1;
+    xhprof_globals->perf_cpu_page = NULL;
+#endif
+#ifdef XHPROF_SAMPLING_THREAD
+    xhprof_globals->sampler = NULL;
+#endif
 
     ZVAL_UNDEF(&xhprof_globals->stats_count);
-
-    /* no free hp_entry_t structures to start with */
-    xhprof_globals->entry_free_list = NULL;
+    memset(&xhprof_globals->functions, 0, sizeof(hp_table_t));
+    memset(&xhprof_globals->edges, 0, sizeof(hp_table_t));
+
+    /* no hp_entry_t chunks to start with */
+    xhprof_globals->entry_chunk = NULL;
+    xhprof_globals->entry_chunk_spare = NULL;
+    xhprof_globals->coroutines = NULL;
+    xhprof_globals->coroutine = NULL;
+    xhprof_globals->coroutine_stats = 0;
+    xhprof_globals->function_names = NULL;
+
+    xhprof_globals->alloc_tracking = 0;
+    xhprof_globals->memory_alloc_sampling = 1;
+    xhprof_globals->alloc_count = 0;
+    xhprof_globals->free_count = 0;
+    xhprof_globals->alloc_bytes = 0;
+
+    xhprof_globals->binary_output = NULL;
+    xhprof_globals->binary_aggregate = 1;
+    xhprof_globals->binary_symbols = NULL;
+    memset(&xhprof_globals->binary_edges, 0, sizeof(hp_table_t));
+    xhprof_globals->binary_requests = 0;
+    xhprof_globals->binary_flags = 0;
 
     int i;
 
@@ -274,6 +395,15 @@ PHP_MINIT_FUNCTION(xhprof)
     _zend_execute_internal = zend_execute_internal;
     zend_execute_internal = hp_execute_internal;
 
+#ifdef XHPROF_SAMPLING_THREAD
+    /* Take the samples from the interrupt function */
+    _zend_interrupt_function = zend_interrupt_function;
+    zend_interrupt_function = hp_interrupt_function;
+#endif
+
+    /* Keep a profile stack per swoole coroutine */
+    hp_coroutine_hooks_init();
+
 #if defined(DEBUG)
     /* To make it random number generator repeatable to ease testing. */
     srand(0);
@@ -282,6 +412,20 @@ PHP_MINIT_FUNCTION(xhprof)
 #ifdef ZEND_WIN32
     QueryPerformanceFrequency(&performance_frequency); 
 #endif
+
+#ifdef XHPROF_TSC
+    {
+        unsigned int eax, ebx, ecx, edx;
+
+        /* Only an invariant TSC ticks at the same rate in all the power states */
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8))) {
+            clock_gettime(CLOCK_MONOTONIC, &tsc_calibration_start_time);
+            tsc_calibration_start = __rdtsc();
+        } else {
+            tsc_us_per_tick = -1;
+        }
+    }
+#endif
     return SUCCESS;
 }
 
@@ -290,14 +434,23 @@ PHP_MINIT_FUNCTION(xhprof)
  */
 PHP_MSHUTDOWN_FUNCTION(xhprof)
 {
-    /* free any remaining items in the free list */
-    hp_free_the_free_list();
+    /* free the chunks of the profile stack */
+    hp_free_the_entry_chunks();
+
+    /* write the profiles aggregated by the last requests */
+    if (XHPROF_G(binary_requests) && XHPROF_G(binary_output) && *XHPROF_G(binary_output)) {
+        hp_binary_write();
+    }
+    hp_binary_free();
 
     /* Remove proxies, restore the originals */
     zend_execute_ex       = _zend_execute_ex;
     zend_execute_internal = _zend_execute_internal;
     zend_compile_file     = _zend_compile_file;
     zend_compile_string   = _zend_compile_string;
+#ifdef XHPROF_SAMPLING_THREAD
+    zend_interrupt_function = _zend_interrupt_function;
+#endif
 
     UNREGISTER_INI_ENTRIES();
 
@@ -359,6 +512,10 @@ static void hp_register_constants(INIT_FUNC_ARGS)
     REGISTER_LONG_CONSTANT("XHPROF_FLAGS_MEMORY",
                          XHPROF_FLAGS_MEMORY,
                          CONST_CS | CONST_PERSISTENT);
+
+    REGISTER_LONG_CONSTANT("XHPROF_FLAGS_MEMORY_ALLOC",
+                         XHPROF_FLAGS_MEMORY_ALLOC,
+                         CONST_CS | CONST_PERSISTENT);
 }
 
 /**
@@ -494,7 +651,12 @@ void hp_init_profiler_state(int level)
 
     array_init(&XHPROF_G(stats_count));
 
+    /* Init the hierarchical mode tables */
+    hp_tables_free();
+    hp_tables_init();
+
     hp_init_trace_callbacks();
+    hp_init_function_names();
 
     /* Call current mode's init cb */
     XHPROF_G(mode_cb).init_cb();
@@ -517,6 +679,8 @@ void hp_clean_profiler_state()
 
     ZVAL_UNDEF(&XHPROF_G(stats_count));
 
+    hp_tables_free();
+
     XHPROF_G(entries) = NULL;
     XHPROF_G(profiler_level) = 1;
     XHPROF_G(ever_enabled) = 0;
@@ -527,6 +691,12 @@ void hp_clean_profiler_state()
         XHPROF_G(trace_callbacks) = NULL;
     }
 
+    if (XHPROF_G(function_names)) {
+        zend_hash_destroy(XHPROF_G(function_names));
+        FREE_HASHTABLE(XHPROF_G(function_names));
+        XHPROF_G(function_names) = NULL;
+    }
+
     /* Delete the array storing ignored function names */
     hp_ignored_functions_clear(XHPROF_G(ignored_functions));
     XHPROF_G(ignored_functions) = NULL;
@@ -657,10 +827,31 @@ static const char *hp_get_base_filename(const char *filename)
     return filename;
 }
 
+static void hp_free_function_name(zval *val)
+{
+    hp_function_name_t *function_name = Z_PTR_P(val);
+
+    zend_string_release(function_name->name);
+    efree(function_name);
+}
+
+void hp_init_function_names()
+{
+    if (XHPROF_G(function_names)) {
+        return;
+    }
+
+    ALLOC_HASHTABLE(XHPROF_G(function_names));
+    zend_hash_init(XHPROF_G(function_names), 64, NULL, hp_free_function_name, 0);
+}
+
 /**
  * Get the name of the current function. The name is qualified with
  * the class name if the function is in a class.
  *
+ * The name is built once per zend_function and returned with a new
+ * reference afterwards, so that hooking a call does not allocate.
+ *
  * @author kannan, hzhao
  */
 static zend_string *hp_get_function_name(zend_execute_data *execute_data)
@@ -668,6 +859,7 @@ static zend_string *hp_get_function_name(zend_execute_data *execute_data)
     zend_string *ret;
     zend_function *curr_func;
     zend_string *func = NULL;
+    hp_function_name_t *cached = NULL;
 
     if (!execute_data) {
         return NULL;
@@ -682,33 +874,69 @@ static zend_string *hp_get_function_name(zend_execute_data *execute_data)
         return NULL;
     }
 
+    if (XHPROF_G(function_names)) {
+        cached = zend_hash_index_find_ptr(XHPROF_G(function_names), (zend_ulong)(uintptr_t)curr_func);
+
+        if (cached && cached->function_name == func && cached->scope == curr_func->common.scope) {
+            return zend_string_copy(cached->name);
+        }
+    }
+
     if (curr_func->common.scope != NULL) {
         ret = strpprintf(0, "%s::%s", curr_func->common.scope->name->val, ZSTR_VAL(func));
     } else {
         ret = zend_string_init(ZSTR_VAL(func), ZSTR_LEN(func), 0);
     }
 
+    if (XHPROF_G(function_names)) {
+        /* a new function at the address of a freed one, or a trampoline */
+        if (!cached) {
+            cached = emalloc(sizeof(hp_function_name_t));
+            zend_hash_index_add_new_ptr(XHPROF_G(function_names), (zend_ulong)(uintptr_t)curr_func, cached);
+        } else {
+            zend_string_release(cached->name);
+        }
+
+        cached->function_name = func;
+        cached->scope         = curr_func->common.scope;
+        cached->name          = zend_string_copy(ret);
+    }
+
     return ret;
 }
 
 /**
- * Free any items in the free list.
+ * Free the chunks of the profile stack.
  */
-static void hp_free_the_free_list()
+static void hp_free_the_entry_chunks()
 {
-    hp_entry_t *p = XHPROF_G(entry_free_list);
-    hp_entry_t *cur;
+    hp_entry_chunk_t *chunk = XHPROF_G(entry_chunk);
+    hp_entry_chunk_t *next;
+
+    if (chunk) {
+        while (chunk->prev) {
+            chunk = chunk->prev;
+        }
+
+        while (chunk) {
+            next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+    }
 
-    while (p) {
-        cur = p;
-        p = p->prev_hprof;
-        free(cur);
+    for (chunk = XHPROF_G(entry_chunk_spare); chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
     }
+
+    XHPROF_G(entry_chunk) = NULL;
+    XHPROF_G(entry_chunk_spare) = NULL;
 }
 
 /**
- * Fast allocate a hp_entry_t structure. Picks one from the
- * free list if available, else does an actual allocate.
+ * Fast allocate a hp_entry_t structure. Pushes it on the chunk of the
+ * top of the profile stack, moving to the next chunk when it is full.
  *
  * Doesn't bother initializing allocated memory.
  *
@@ -716,32 +944,51 @@ static void hp_free_the_free_list()
  */
 static hp_entry_t *hp_fast_alloc_hprof_entry()
 {
-    hp_entry_t *p;
+    hp_entry_chunk_t *chunk = XHPROF_G(entry_chunk);
 
-    p = XHPROF_G(entry_free_list);
+    if (!chunk || chunk->used == XHPROF_ENTRY_CHUNK_SIZE) {
+        if (chunk && chunk->next) {
+            chunk = chunk->next;
+        } else {
+            hp_entry_chunk_t *next = XHPROF_G(entry_chunk_spare);
 
-    if (p) {
-        XHPROF_G(entry_free_list) = p->prev_hprof;
-        return p;
-    } else {
-        return (hp_entry_t *)malloc(sizeof(hp_entry_t));
+            if (next) {
+                XHPROF_G(entry_chunk_spare) = next->next;
+            } else if (!(next = (hp_entry_chunk_t *)malloc(sizeof(hp_entry_chunk_t)))) {
+                return NULL;
+            }
+
+            next->prev = chunk;
+            next->next = NULL;
+
+            if (chunk) {
+                chunk->next = next;
+            }
+
+            chunk = next;
+        }
+
+        chunk->used = 0;
+        XHPROF_G(entry_chunk) = chunk;
     }
+
+    return &chunk->entries[chunk->used++];
 }
 
 /**
- * Fast free a hp_entry_t structure. Simply returns back
- * the hp_entry_t to a free list and doesn't actually
- * perform the free.
+ * Fast free a hp_entry_t structure. Entries are freed in the reverse
+ * order of their allocation, so this only pops the top of the stack.
  *
  * @author kannan
  */
 static void hp_fast_free_hprof_entry(hp_entry_t *p)
 {
-    /* we use/overload the prev_hprof field in the structure to link entries in
-     * the free list.
-     * */
-    p->prev_hprof = XHPROF_G(entry_free_list);
-    XHPROF_G(entry_free_list) = p;
+    hp_entry_chunk_t *chunk = XHPROF_G(entry_chunk);
+
+    /* the chunk below is full, continue from its end */
+    if (--chunk->used == 0 && chunk->prev) {
+        XHPROF_G(entry_chunk) = chunk->prev;
+    }
 }
 
 /**
@@ -781,220 +1028,1157 @@ void hp_inc_count(zval *counts, char *name, zend_long count)
 }
 
 /**
- * Truncates the given timeval to the nearest slot begin, where
- * the slot size is determined by intr
- *
- * @param  tv       Input timeval to be truncated in place
- * @param  intr     Time interval in microsecs - slot width
- * @return void
- * @author veeve
+ * **********************************
+ * XHPROF HIERARCHICAL MODE TABLES
+ * **********************************
  */
-void hp_trunc_time(struct timeval *tv, zend_ulong intr)
-{
-    zend_ulong time_in_micro;
-
-    /* Convert to microsecs and trunc that first */
-    time_in_micro = (tv->tv_sec * 1000000) + tv->tv_usec;
-    time_in_micro /= intr;
-    time_in_micro *= intr;
 
-    /* Update tv */
-    tv->tv_sec  = (time_in_micro / 1000000);
-    tv->tv_usec = (time_in_micro % 1000000);
+static void hp_table_init(hp_table_t *table, size_t item_size, zend_bool persistent)
+{
+    table->count      = 0;
+    table->size       = XHPROF_TABLE_INITIAL_SIZE / 2;
+    table->items      = pemalloc(table->size * item_size, persistent);
+    table->mask       = XHPROF_TABLE_INITIAL_SIZE - 1;
+    table->slots      = pecalloc(XHPROF_TABLE_INITIAL_SIZE, sizeof(uint32), persistent);
+    table->persistent = persistent;
 }
 
-/**
- * Sample the stack. Add it to the stats_count global.
- *
- * @param  tv            current time
- * @param  entries       func stack as linked list of hp_entry_t
- * @return void
- * @author veeve
- */
-void hp_sample_stack(hp_entry_t  **entries)
+static void hp_table_free(hp_table_t *table)
 {
-    char key[SCRATCH_BUF_LEN];
-    char symbol[SCRATCH_BUF_LEN * 1000];
-
-    /* Build key */
-    snprintf(key, sizeof(key), "%d.%06d", (uint32) XHPROF_G(last_sample_time).tv_sec, (uint32) XHPROF_G(last_sample_time).tv_usec);
-
-    /* Init stats in the global stats_count hashtable */
-    hp_get_function_stack(*entries, XHPROF_G(sampling_depth), symbol, sizeof(symbol));
+    if (table->slots) {
+        pefree(table->items, table->persistent);
+        pefree(table->slots, table->persistent);
+    }
 
-    add_assoc_string(&XHPROF_G(stats_count), key, symbol);
+    memset(table, 0, sizeof(hp_table_t));
 }
 
 /**
- * Checks to see if it is time to sample the stack.
- * Calls hp_sample_stack() if its time.
- *
- * @param  entries        func stack as linked list of hp_entry_t
- * @param  last_sample    time the last sample was taken
- * @param  sampling_intr  sampling interval in microsecs
- * @return void
- * @author veeve
+ * Appends an item and returns its id (index + 1). The caller sets the item
+ * and puts the id in the slot returned by hp_table_slot() afterwards.
+ * Slots are kept at most half full, so probing stays short.
  */
-void hp_sample_check(hp_entry_t **entries)
+static uint32 hp_table_add(hp_table_t *table, size_t item_size)
 {
-    /* Validate input */
-    if (!entries || !(*entries)) {
-        return;
+    if (table->count == table->size) {
+        table->size *= 2;
+        table->items = perealloc(table->items, table->size * item_size, table->persistent);
     }
 
-    /* See if its time to sample.  While loop is to handle a single function
-    * taking a long time and passing several sampling intervals. */
-    while ((cycle_timer() - XHPROF_G(last_sample_tsc)) > XHPROF_G(sampling_interval_tsc)) {
-        /* bump last_sample_tsc */
-        XHPROF_G(last_sample_tsc) += XHPROF_G(sampling_interval_tsc);
-
-        /* bump last_sample_time - HAS TO BE UPDATED BEFORE calling hp_sample_stack */
-        incr_us_interval(&XHPROF_G(last_sample_time), XHPROF_G(sampling_interval));
-
-        /* sample the stack */
-        hp_sample_stack(entries);
-    }
+    return ++table->count;
 }
 
-
-/**
- * ***********************
- * High precision timer related functions.
- * ***********************
- */
-
-static inline zend_ulong cycle_timer()
+static inline uint32 hp_table_slot(hp_table_t *table, zend_ulong hash)
 {
-#if defined(__APPLE__) && defined(__MACH__)
-    return mach_absolute_time() / XHPROF_G(timebase_conversion);
-#elif defined(ZEND_WIN32)
-    LARGE_INTEGER lt = {0};
-    QueryPerformanceCounter(&lt);
-    lt.QuadPart *= 1000000;
-    lt.QuadPart /= performance_frequency.QuadPart;
-    return lt.QuadPart;
-#else
-    struct timespec s;
-    clock_gettime(CLOCK_MONOTONIC, &s);
+    uint32 i;
 
-    return s.tv_sec * 1000 * 1000 + s.tv_nsec / 1000;
-#endif
+    for (i = hash & table->mask; table->slots[i]; i = (i + 1) & table->mask);
+
+    return i;
 }
 
 /**
- * Get the current real CPU clock timer
+ * Doubles the slots of a table. hash_fn gives the hash of the item with the
+ * given id.
  */
-static zend_ulong cpu_timer()
+static void hp_table_grow(hp_table_t *table, zend_ulong (*hash_fn)(hp_table_t *table, uint32 id))
 {
-#if defined(CLOCK_PROCESS_CPUTIME_ID)
-    struct timespec s;
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &s);
+    uint32 id;
 
-    return s.tv_sec * 1000 * 1000 + s.tv_nsec / 1000;
-#else
-    struct rusage ru;
-    getrusage(RUSAGE_SELF, &ru);
+    pefree(table->slots, table->persistent);
+    table->mask  = (table->mask << 1) | 1;
+    table->slots = pecalloc(table->mask + 1, sizeof(uint32), table->persistent);
 
-    return (ru.ru_utime.tv_sec  + ru.ru_stime.tv_sec ) * 1000 * 1000 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
-#endif
+    for (id = 1; id <= table->count; id++) {
+        table->slots[hp_table_slot(table, hash_fn(table, id))] = id;
+    }
 }
 
-/**
- * Incr time with the given microseconds.
- */
-static void incr_us_interval(struct timeval *start, zend_ulong incr)
+static zend_ulong hp_function_hash(hp_table_t *table, uint32 id)
 {
-    incr += (start->tv_sec * 1000000 + start->tv_usec);
-    start->tv_sec  = incr / 1000000;
-    start->tv_usec = incr % 1000000;
+    return ((hp_function_t *)table->items)[id - 1].hash;
 }
 
-/**
- * ***************************
- * XHPROF DUMMY CALLBACKS
- * ***************************
- */
-void hp_mode_dummy_init_cb()
+static inline zend_ulong hp_edge_hash_ids(uint32 parent, uint32 child)
 {
-
+    return (((zend_ulong)parent << 16) ^ child) * 2654435761U;
 }
 
-void hp_mode_dummy_exit_cb()
+static zend_ulong hp_edge_hash(hp_table_t *table, uint32 id)
 {
+    hp_edge_t *edge = &((hp_edge_t *)table->items)[id - 1];
 
+    return hp_edge_hash_ids(edge->parent, edge->child);
 }
 
-void hp_mode_dummy_beginfn_cb(hp_entry_t **entries, hp_entry_t *current)
+static void hp_tables_init()
 {
-
+    hp_table_init(&XHPROF_G(functions), sizeof(hp_function_t), 0);
+    hp_table_init(&XHPROF_G(edges), sizeof(hp_edge_t), 0);
 }
 
-void hp_mode_dummy_endfn_cb(hp_entry_t **entries)
+static void hp_tables_free()
 {
+    hp_function_t *functions = XHPROF_G(functions).items;
+    uint32 i;
 
-}
+    for (i = 0; i < XHPROF_G(functions).count; i++) {
+        zend_string_release(functions[i].name);
+        zend_string_release(functions[i].symbol);
+    }
 
+    hp_table_free(&XHPROF_G(functions));
+    hp_table_free(&XHPROF_G(edges));
+}
 
 /**
- * ****************************
- * XHPROF COMMON CALLBACKS
- * ****************************
- */
-/**
- * XHPROF universal begin function.
- * This function is called for all modes before the
- * mode's specific begin_function callback is called.
- *
- * @param  hp_entry_t **entries  linked list (stack)
- *                                  of hprof entries
- * @param  hp_entry_t  *current  hprof entry for the current fn
- * @return void
- * @author kannan, veeve
+ * Returns the id of the function of the entry. The name and the recursion
+ * level are interned the first time they are seen, so that the end function
+ * callback only deals with ids.
  */
-void hp_mode_common_beginfn(hp_entry_t **entries, hp_entry_t *current)
+static uint32 hp_get_function_id(hp_entry_t *entry)
 {
-    hp_entry_t *p;
+    hp_table_t    *table = &XHPROF_G(functions);
+    hp_function_t *function;
+    zend_ulong     hash = ZSTR_HASH(entry->name_hprof) + entry->rlvl_hprof;
+    uint32         i, id;
 
-    /* This symbol's recursive level */
-    int recurse_level = 0;
+    for (i = hash & table->mask; (id = table->slots[i]); i = (i + 1) & table->mask) {
+        function = &((hp_function_t *)table->items)[id - 1];
 
-    if (XHPROF_G(func_hash_counters[current->hash_code]) > 0) {
-        /* Find this symbols recurse level */
-        for (p = (*entries); p; p = p->prev_hprof) {
-            if (zend_string_equals(current->name_hprof, p->name_hprof)) {
-                recurse_level = (p->rlvl_hprof) + 1;
-                break;
-            }
+        if (function->hash == hash && function->rlvl == entry->rlvl_hprof
+                && zend_string_equals(function->name, entry->name_hprof)) {
+            return id;
         }
     }
 
-    XHPROF_G(func_hash_counters[current->hash_code])++;
+    id = hp_table_add(table, sizeof(hp_function_t));
+    function = &((hp_function_t *)table->items)[id - 1];
+    function->name = zend_string_copy(entry->name_hprof);
+    function->rlvl = entry->rlvl_hprof;
+    function->hash = hash;
 
-    /* Init current function's recurse level */
-    current->rlvl_hprof = recurse_level;
+    if (entry->rlvl_hprof) {
+        function->symbol = strpprintf(0, "%s@%d", ZSTR_VAL(entry->name_hprof), entry->rlvl_hprof);
+    } else {
+        function->symbol = zend_string_copy(entry->name_hprof);
+    }
+
+    if ((table->count << 1) > table->mask) {
+        hp_table_grow(table, hp_function_hash);
+    } else {
+        table->slots[i] = id;
+    }
+
+    return id;
 }
 
 /**
- * *********************************
- * XHPROF INIT MODULE CALLBACKS
- * *********************************
- */
-/**
- * XHPROF_MODE_SAMPLED's init callback
- *
- * @author veeve
+ * Returns the counters of the parent==>child pair, adding them zeroed the
+ * first time the pair is seen.
  */
-void hp_mode_sampled_init_cb()
+static hp_edge_t *hp_get_edge(hp_table_t *table, uint32 parent, uint32 child)
 {
-    /* Init the last_sample in tsc */
-    XHPROF_G(last_sample_tsc) = cycle_timer();
+    hp_edge_t  *edge;
+    uint32      i, id;
 
-    /* Find the microseconds that need to be truncated */
-    gettimeofday(&XHPROF_G(last_sample_time), 0);
-    hp_trunc_time(&XHPROF_G(last_sample_time), XHPROF_G(sampling_interval));
+    for (i = hp_edge_hash_ids(parent, child) & table->mask; (id = table->slots[i]); i = (i + 1) & table->mask) {
+        edge = &((hp_edge_t *)table->items)[id - 1];
+
+        if (edge->child == child && edge->parent == parent) {
+            return edge;
+        }
+    }
+
+    id = hp_table_add(table, sizeof(hp_edge_t));
+    edge = &((hp_edge_t *)table->items)[id - 1];
+    memset(edge, 0, sizeof(hp_edge_t));
+    edge->parent = parent;
+    edge->child  = child;
+
+    if ((table->count << 1) > table->mask) {
+        hp_table_grow(table, hp_edge_hash);
+    } else {
+        table->slots[i] = id;
+    }
+
+    return edge;
+}
+
+/**
+ * Converts the edge counters to the "parent==>child" => counts array
+ * returned by xhprof_disable(), in the order the pairs were first seen.
+ */
+static void hp_tables_to_stats_count()
+{
+    hp_function_t *functions = XHPROF_G(functions).items;
+    hp_edge_t     *edges = XHPROF_G(edges).items;
+    zend_string   *symbol;
+    zval          *counts;
+    uint32         i;
+
+    for (i = 0; i < XHPROF_G(edges).count; i++) {
+        hp_edge_t *edge = &edges[i];
+
+        if (edge->parent) {
+            symbol = strpprintf(0, "%s==>%s", ZSTR_VAL(functions[edge->parent - 1].symbol), ZSTR_VAL(functions[edge->child - 1].symbol));
+        } else {
+            symbol = zend_string_copy(functions[edge->child - 1].symbol);
+        }
+
+        /* Different pairs may print the same, e.g. a function named "a@1"
+         * and "a" at recursion level 1. Their counts are added together. */
+        counts = zend_hash_find(Z_ARRVAL(XHPROF_G(stats_count)), symbol);
+
+        if (counts == NULL) {
+            zval count_val;
+            array_init(&count_val);
+            counts = zend_hash_update(Z_ARRVAL(XHPROF_G(stats_count)), symbol, &count_val);
+        }
+
+        zend_string_release(symbol);
+
+        hp_inc_count(counts, "ct", edge->ct);
+        hp_inc_count(counts, "wt", edge->wt);
+
+        if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_CPU) {
+            hp_inc_count(counts, "cpu", edge->cpu);
+        }
+
+        if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY) {
+            hp_inc_count(counts, "mu",  edge->mu);
+            hp_inc_count(counts, "pmu", edge->pmu);
+        }
+
+        if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY_ALLOC) {
+            hp_inc_count(counts, "mem.na", edge->na);
+            hp_inc_count(counts, "mem.nf", edge->nf);
+            hp_inc_count(counts, "mem.aa", edge->aa);
+        }
+
+        if (XHPROF_G(coroutine_stats)) {
+            hp_inc_count(counts, "swt", edge->swt);
+        }
+    }
+}
+
+/**
+ * *********************************
+ * XHPROF ALLOCATION TRACKING
+ * *********************************
+ */
+
+/* Count one allocation in alloc_every, as alloc_every allocations */
+static zend_always_inline void hp_count_alloc(size_t size)
+{
+    if (++XHPROF_G(alloc_tick) >= XHPROF_G(alloc_every)) {
+        XHPROF_G(alloc_tick) = 0;
+        XHPROF_G(alloc_count) += XHPROF_G(alloc_every);
+        XHPROF_G(alloc_bytes) += size * XHPROF_G(alloc_every);
+    }
+}
+
+static zend_always_inline void hp_count_free()
+{
+    if (++XHPROF_G(free_tick) >= XHPROF_G(alloc_every)) {
+        XHPROF_G(free_tick) = 0;
+        XHPROF_G(free_count) += XHPROF_G(alloc_every);
+    }
+}
+
+/**
+ * Memory manager handlers. They count the call and pass it to the handlers
+ * that were installed before, or to the heap itself.
+ */
+static void *hp_malloc(size_t size)
+{
+    hp_count_alloc(size);
+
+    if (XHPROF_G(_zend_malloc)) {
+        return XHPROF_G(_zend_malloc)(size);
+    }
+
+    return zend_mm_alloc(XHPROF_G(mm_heap), size);
+}
+
+static void hp_free(void *ptr)
+{
+    if (ptr) {
+        hp_count_free();
+    }
+
+    if (XHPROF_G(_zend_free)) {
+        XHPROF_G(_zend_free)(ptr);
+        return;
+    }
+
+    zend_mm_free(XHPROF_G(mm_heap), ptr);
+}
+
+static void *hp_realloc(void *ptr, size_t size)
+{
+    hp_count_alloc(size);
+
+    if (ptr) {
+        hp_count_free();
+    }
+
+    if (XHPROF_G(_zend_realloc)) {
+        return XHPROF_G(_zend_realloc)(ptr, size);
+    }
+
+    return zend_mm_realloc(XHPROF_G(mm_heap), ptr, size);
+}
+
+/**
+ * Installs the memory manager handlers counting the allocations.
+ */
+static void hp_alloc_tracking_start()
+{
+    if (XHPROF_G(alloc_tracking)) {
+        return;
+    }
+
+    XHPROF_G(mm_heap) = zend_mm_get_heap();
+    zend_mm_get_custom_handlers(XHPROF_G(mm_heap), &XHPROF_G(_zend_malloc), &XHPROF_G(_zend_free), &XHPROF_G(_zend_realloc));
+
+    XHPROF_G(alloc_every) = XHPROF_G(memory_alloc_sampling) > 1 ? (zend_ulong)XHPROF_G(memory_alloc_sampling) : 1;
+    XHPROF_G(alloc_tick)  = 0;
+    XHPROF_G(free_tick)   = 0;
+
+    zend_mm_set_custom_handlers(XHPROF_G(mm_heap), hp_malloc, hp_free, hp_realloc);
+    XHPROF_G(alloc_tracking) = 1;
+}
+
+/**
+ * Restores the memory manager handlers installed before.
+ */
+static void hp_alloc_tracking_stop()
+{
+    if (!XHPROF_G(alloc_tracking)) {
+        return;
+    }
+
+    if (XHPROF_G(_zend_malloc) || XHPROF_G(_zend_free) || XHPROF_G(_zend_realloc)) {
+        zend_mm_set_custom_handlers(XHPROF_G(mm_heap), XHPROF_G(_zend_malloc), XHPROF_G(_zend_free), XHPROF_G(_zend_realloc));
+    } else {
+        zend_mm_set_custom_handlers(XHPROF_G(mm_heap), NULL, NULL, NULL);
+    }
+
+    XHPROF_G(alloc_tracking) = 0;
+}
+
+/**
+ * **********************************
+ * XHPROF BINARY OUTPUT
+ * **********************************
+ */
+
+/**
+ * Adds the edges of the hierarchical mode tables to the profiles aggregated
+ * for the binary output. The function ids of the request are mapped to
+ * aggregate ids by their symbols.
+ */
+static void hp_binary_add()
+{
+    hp_function_t *functions = XHPROF_G(functions).items;
+    hp_edge_t     *edges = XHPROF_G(edges).items;
+    hp_edge_t     *aggregate;
+    uint32        *ids;
+    uint32         i;
+    zval          *id, val;
+
+    if (!XHPROF_G(binary_symbols)) {
+        XHPROF_G(binary_symbols) = pemalloc(sizeof(HashTable), 1);
+        zend_hash_init(XHPROF_G(binary_symbols), 64, NULL, NULL, 1);
+        hp_table_init(&XHPROF_G(binary_edges), sizeof(hp_edge_t), 1);
+    }
+
+    /* ids[0] stays 0, the parent of main() */
+    ids = emalloc((XHPROF_G(functions).count + 1) * sizeof(uint32));
+    ids[0] = 0;
+
+    for (i = 0; i < XHPROF_G(functions).count; i++) {
+        id = zend_hash_find(XHPROF_G(binary_symbols), functions[i].symbol);
+
+        if (!id) {
+            zend_string *symbol = zend_string_init(ZSTR_VAL(functions[i].symbol), ZSTR_LEN(functions[i].symbol), 1);
+
+            ZVAL_LONG(&val, zend_hash_num_elements(XHPROF_G(binary_symbols)) + 1);
+            id = zend_hash_add_new(XHPROF_G(binary_symbols), symbol, &val);
+            zend_string_release(symbol);
+        }
+
+        ids[i + 1] = (uint32)Z_LVAL_P(id);
+    }
+
+    for (i = 0; i < XHPROF_G(edges).count; i++) {
+        aggregate = hp_get_edge(&XHPROF_G(binary_edges), ids[edges[i].parent], ids[edges[i].child]);
+
+        aggregate->ct  += edges[i].ct;
+        aggregate->wt  += edges[i].wt;
+        aggregate->cpu += edges[i].cpu;
+        aggregate->mu  += edges[i].mu;
+        aggregate->pmu += edges[i].pmu;
+        aggregate->na  += edges[i].na;
+        aggregate->nf  += edges[i].nf;
+        aggregate->aa  += edges[i].aa;
+        aggregate->swt += edges[i].swt;
+    }
+
+    efree(ids);
+
+    XHPROF_G(binary_requests)++;
+    XHPROF_G(binary_flags) |= XHPROF_G(xhprof_flags) & (XHPROF_FLAGS_CPU | XHPROF_FLAGS_MEMORY | XHPROF_FLAGS_MEMORY_ALLOC);
+}
+
+static void hp_binary_free()
+{
+    if (XHPROF_G(binary_symbols)) {
+        zend_hash_destroy(XHPROF_G(binary_symbols));
+        pefree(XHPROF_G(binary_symbols), 1);
+        XHPROF_G(binary_symbols) = NULL;
+    }
+
+    hp_table_free(&XHPROF_G(binary_edges));
+
+    XHPROF_G(binary_requests) = 0;
+    XHPROF_G(binary_flags) = 0;
+}
+
+static inline void hp_binary_append(smart_str *buf, const void *data, size_t len)
+{
+    smart_str_appendl_ex(buf, (const char *)data, len, 1);
+}
+
+#ifndef ZEND_WIN32
+/**
+ * Sends the output in a single datagram to udp://host:port.
+ * IPv6 addresses are in brackets: udp://[::1]:9999
+ */
+static int hp_binary_send_udp(const char *destination, const char *data, size_t len)
+{
+    char             address[256];
+    char            *host = address, *port, *s;
+    struct addrinfo  hints, *result;
+    int              fd, ret = FAILURE;
+
+    if (len > XHPROF_MAX_UDP_PAYLOAD) {
+        errno = EMSGSIZE;
+        return FAILURE;
+    }
+
+    strlcpy(address, destination + sizeof("udp://") - 1, sizeof(address));
+
+    if (*host == '[') {
+        host++;
+        s = strchr(host, ']');
+        if (!s || s[1] != ':') {
+            errno = EINVAL;
+            return FAILURE;
+        }
+        *s = '\0';
+        port = s + 2;
+    } else {
+        s = strrchr(host, ':');
+        if (!s) {
+            errno = EINVAL;
+            return FAILURE;
+        }
+        *s = '\0';
+        port = s + 1;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (getaddrinfo(host, port, &hints, &result) != 0) {
+        errno = EHOSTUNREACH;
+        return FAILURE;
+    }
+
+    fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd != -1) {
+        if (sendto(fd, data, len, 0, result->ai_addr, result->ai_addrlen) == (ssize_t)len) {
+            ret = SUCCESS;
+        }
+        close(fd);
+    }
+
+    freeaddrinfo(result);
+
+    return ret;
+}
+#endif
+
+/**
+ * Appends the output to a file, with a single write() so that the outputs
+ * of concurrent processes do not interleave.
+ */
+static int hp_binary_append_file(const char *destination, const char *data, size_t len)
+{
+    int fd = open(destination, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    int ret = SUCCESS;
+
+    if (fd == -1) {
+        return FAILURE;
+    }
+
+    if (write(fd, data, len) != (ssize_t)len) {
+        ret = FAILURE;
+    }
+
+    close(fd);
+
+    return ret;
+}
+
+/**
+ * Writes the aggregated profiles to xhprof.binary_output and drops them.
+ * It does not allocate request memory, so it can run at module shutdown.
+ *
+ * The output is in host byte order:
+ *   header  "XHPB", uint16 version, uint16 flags, uint32 requests,
+ *           uint32 number of symbols, uint32 number of edges
+ *   symbols for each symbol, its uint32 length and its bytes, without a
+ *           terminating NUL. Symbol ids are their positions, from 1.
+ *   edges   for each parent==>child pair, uint32 parent symbol id (0 for
+ *           the parent of main()), uint32 child symbol id, then int64 ct,
+ *           wt, cpu, mu, pmu, mem.na, mem.nf, mem.aa and swt. cpu is 0
+ *           unless XHPROF_FLAGS_CPU is in the flags, mu and pmu are 0
+ *           unless XHPROF_FLAGS_MEMORY is, the mem.* unless
+ *           XHPROF_FLAGS_MEMORY_ALLOC is. swt is 0 outside of swoole
+ *           coroutines.
+ */
+static int hp_binary_write()
+{
+    smart_str    buf = {0};
+    hp_edge_t   *edges = XHPROF_G(binary_edges).items;
+    zend_string *symbol;
+    uint16_t     u16;
+    uint32_t     u32, i;
+    int64_t      i64[9];
+    int          ret, saved_errno;
+
+    if (!XHPROF_G(binary_symbols)) {
+        return SUCCESS;
+    }
+
+    hp_binary_append(&buf, XHPROF_BINARY_MAGIC, sizeof(XHPROF_BINARY_MAGIC) - 1);
+    u16 = XHPROF_BINARY_VERSION;
+    hp_binary_append(&buf, &u16, sizeof(u16));
+    u16 = (uint16_t)XHPROF_G(binary_flags);
+    hp_binary_append(&buf, &u16, sizeof(u16));
+    u32 = (uint32_t)XHPROF_G(binary_requests);
+    hp_binary_append(&buf, &u32, sizeof(u32));
+    u32 = zend_hash_num_elements(XHPROF_G(binary_symbols));
+    hp_binary_append(&buf, &u32, sizeof(u32));
+    u32 = XHPROF_G(binary_edges).count;
+    hp_binary_append(&buf, &u32, sizeof(u32));
+
+    /* the ids were given in insertion order */
+    ZEND_HASH_FOREACH_STR_KEY(XHPROF_G(binary_symbols), symbol) {
+        u32 = (uint32_t)ZSTR_LEN(symbol);
+        hp_binary_append(&buf, &u32, sizeof(u32));
+        hp_binary_append(&buf, ZSTR_VAL(symbol), ZSTR_LEN(symbol));
+    } ZEND_HASH_FOREACH_END();
+
+    for (i = 0; i < XHPROF_G(binary_edges).count; i++) {
+        u32 = edges[i].parent;
+        hp_binary_append(&buf, &u32, sizeof(u32));
+        u32 = edges[i].child;
+        hp_binary_append(&buf, &u32, sizeof(u32));
+
+        i64[0] = edges[i].ct;
+        i64[1] = edges[i].wt;
+        i64[2] = edges[i].cpu;
+        i64[3] = edges[i].mu;
+        i64[4] = edges[i].pmu;
+        i64[5] = edges[i].na;
+        i64[6] = edges[i].nf;
+        i64[7] = edges[i].aa;
+        i64[8] = edges[i].swt;
+        hp_binary_append(&buf, i64, sizeof(i64));
+    }
+
+#ifndef ZEND_WIN32
+    if (strncmp(XHPROF_G(binary_output), "udp://", sizeof("udp://") - 1) == 0) {
+        ret = hp_binary_send_udp(XHPROF_G(binary_output), ZSTR_VAL(buf.s), ZSTR_LEN(buf.s));
+    } else
+#endif
+    {
+        ret = hp_binary_append_file(XHPROF_G(binary_output), ZSTR_VAL(buf.s), ZSTR_LEN(buf.s));
+    }
+
+    saved_errno = errno;
+    smart_str_free(&buf);
+
+    /* the profiles are dropped even if they could not be written, so that
+     * an unreachable destination does not grow the process */
+    hp_binary_free();
+
+    errno = saved_errno;
+    return ret;
+}
+
+/**
+ * Truncates the given timeval to the nearest slot begin, where
+ * the slot size is determined by intr
+ *
+ * @param  tv       Input timeval to be truncated in place
+ * @param  intr     Time interval in microsecs - slot width
+ * @return void
+ * @author veeve
+ */
+void hp_trunc_time(struct timeval *tv, zend_ulong intr)
+{
+    zend_ulong time_in_micro;
+
+    /* Convert to microsecs and trunc that first */
+    time_in_micro = (tv->tv_sec * 1000000) + tv->tv_usec;
+    time_in_micro /= intr;
+    time_in_micro *= intr;
+
+    /* Update tv */
+    tv->tv_sec  = (time_in_micro / 1000000);
+    tv->tv_usec = (time_in_micro % 1000000);
+}
+
+/**
+ * Sample the stack. Add it to the stats_count global.
+ *
+ * @param  tv            current time
+ * @param  entries       func stack as linked list of hp_entry_t
+ * @return void
+ * @author veeve
+ */
+void hp_sample_stack(hp_entry_t  **entries)
+{
+    char key[SCRATCH_BUF_LEN];
+    char symbol[SCRATCH_BUF_LEN * 1000];
+
+    /* Build key */
+    snprintf(key, sizeof(key), "%d.%06d", (uint32) XHPROF_G(last_sample_time).tv_sec, (uint32) XHPROF_G(last_sample_time).tv_usec);
+
+    /* Init stats in the global stats_count hashtable */
+    hp_get_function_stack(*entries, XHPROF_G(sampling_depth), symbol, sizeof(symbol));
+
+    add_assoc_string(&XHPROF_G(stats_count), key, symbol);
+}
+
+/**
+ * Checks to see if it is time to take a sample, and moves the last sample
+ * time to the next sampling interval if it is.
+ *
+ * @return int  1 if a sample has to be taken
+ * @author veeve
+ */
+static inline int hp_sample_due()
+{
+    if ((cycle_timer() - XHPROF_G(last_sample_tsc)) <= XHPROF_G(sampling_interval_tsc)) {
+        return 0;
+    }
+
+    /* bump last_sample_tsc */
+    XHPROF_G(last_sample_tsc) += XHPROF_G(sampling_interval_tsc);
+
+    /* bump last_sample_time - HAS TO BE UPDATED BEFORE taking the sample */
+    incr_us_interval(&XHPROF_G(last_sample_time), XHPROF_G(sampling_interval));
+
+    return 1;
+}
+
+/**
+ * Checks to see if it is time to sample the stack.
+ * Calls hp_sample_stack() if its time.
+ *
+ * @param  entries        func stack as linked list of hp_entry_t
+ * @return void
+ * @author veeve
+ */
+void hp_sample_check(hp_entry_t **entries)
+{
+    /* Validate input */
+    if (!entries || !(*entries)) {
+        return;
+    }
+
+    /* See if its time to sample.  While loop is to handle a single function
+    * taking a long time and passing several sampling intervals. */
+    while (hp_sample_due()) {
+        /* sample the stack */
+        hp_sample_stack(entries);
+    }
+}
+
+#ifdef XHPROF_SAMPLING_THREAD
+/**
+ * Sample the stack of VM frames. Add it to the stats_count global, in the
+ * same format as hp_sample_stack(): the fictitious main() first, then the
+ * named functions, with their recursion level.
+ *
+ * @param  execute_data  the current frame
+ * @return void
+ */
+static void hp_sample_frames(zend_execute_data *execute_data)
+{
+    char               key[SCRATCH_BUF_LEN];
+    smart_str          symbol = {0};
+    zend_string      **names;
+    zend_execute_data *frame;
+    int                count = 1, first, depth, rlvl, i, j;
+
+    for (frame = execute_data; frame; frame = frame->prev_execute_data) {
+        if (frame->func && frame->func->common.function_name) {
+            count++;
+        }
+    }
+
+    /* names[0] is main(), names[count - 1] is the current function */
+    names = emalloc(count * sizeof(zend_string *));
+    names[0] = zend_string_copy(XHPROF_G(root));
+
+    for (i = count, frame = execute_data; frame; frame = frame->prev_execute_data) {
+        if (frame->func && frame->func->common.function_name) {
+            names[--i] = hp_get_function_name(frame);
+        }
+    }
+
+    /* Keep the sampling_depth innermost functions */
+    depth = count;
+    if (XHPROF_G(sampling_depth) < depth) {
+        depth = XHPROF_G(sampling_depth) > 1 ? (int)XHPROF_G(sampling_depth) : 1;
+    }
+    first = count - depth;
+
+    for (i = first; i < count; i++) {
+        /* the recursion level is the number of callers of the same name */
+        for (rlvl = 0, j = 0; j < i; j++) {
+            if (zend_string_equals(names[i], names[j])) {
+                rlvl++;
+            }
+        }
+
+        if (i > first) {
+            smart_str_appendl(&symbol, "==>", sizeof("==>") - 1);
+        }
+
+        smart_str_append(&symbol, names[i]);
+
+        if (rlvl) {
+            smart_str_appendc(&symbol, '@');
+            smart_str_append_long(&symbol, rlvl);
+        }
+    }
+
+    smart_str_0(&symbol);
+
+    for (i = 0; i < count; i++) {
+        zend_string_release(names[i]);
+    }
+    efree(names);
+
+    /* Build key */
+    snprintf(key, sizeof(key), "%d.%06d", (uint32) XHPROF_G(last_sample_time).tv_sec, (uint32) XHPROF_G(last_sample_time).tv_usec);
+
+    add_assoc_str(&XHPROF_G(stats_count), key, symbol.s);
+}
+
+/**
+ * Incr timespec with the given microseconds.
+ */
+static void incr_ts_interval(struct timespec *ts, zend_ulong incr)
+{
+    ts->tv_nsec += (incr % 1000000) * 1000;
+    ts->tv_sec  += incr / 1000000 + ts->tv_nsec / 1000000000;
+    ts->tv_nsec %= 1000000000;
+}
+
+/**
+ * The sampling thread. Sets the VM interrupt flag of the request at every
+ * sampling interval, until hp_sampler_stop() wakes it up.
+ */
+static void *hp_sampler_main(void *arg)
+{
+    hp_sampler_t    *sampler = arg;
+    struct timeval   now;
+    struct timespec  deadline;
+
+    gettimeofday(&now, NULL);
+    deadline.tv_sec  = now.tv_sec;
+    deadline.tv_nsec = now.tv_usec * 1000;
+    incr_ts_interval(&deadline, sampler->interval);
+
+    pthread_mutex_lock(&sampler->mutex);
+
+    /* other wake ups wait for the same deadline again */
+    while (sampler->running) {
+        if (pthread_cond_timedwait(&sampler->cond, &sampler->mutex, &deadline) == ETIMEDOUT) {
+            sampler->pending = 1;
+            *sampler->vm_interrupt = 1;
+
+            incr_ts_interval(&deadline, sampler->interval);
+        }
+    }
+
+    pthread_mutex_unlock(&sampler->mutex);
+
+    return NULL;
+}
+
+/**
+ * Starts the sampling thread of the request.
+ */
+static void hp_sampler_start()
+{
+    hp_sampler_t *sampler = calloc(1, sizeof(hp_sampler_t));
+    int           ret;
+
+    if (!sampler) {
+        return;
+    }
+
+    pthread_mutex_init(&sampler->mutex, NULL);
+    pthread_cond_init(&sampler->cond, NULL);
+    sampler->running      = 1;
+    sampler->vm_interrupt = (zend_bool *)&EG(vm_interrupt);
+    sampler->interval     = XHPROF_G(sampling_interval);
+
+    if (sampler->interval < XHPROF_MINIMAL_SAMPLING_INTERVAL) {
+        sampler->interval = XHPROF_MINIMAL_SAMPLING_INTERVAL;
+    }
+
+    ret = pthread_create(&sampler->thread, NULL, hp_sampler_main, sampler);
+
+    if (ret != 0) {
+        php_error_docref(NULL, E_WARNING, "Cannot create the sampling thread: %s", strerror(ret));
+        pthread_cond_destroy(&sampler->cond);
+        pthread_mutex_destroy(&sampler->mutex);
+        free(sampler);
+        return;
+    }
+
+    XHPROF_G(sampler) = sampler;
+}
+
+/**
+ * Stops the sampling thread of the request, if it runs.
+ */
+static void hp_sampler_stop()
+{
+    hp_sampler_t *sampler = XHPROF_G(sampler);
+
+    if (!sampler) {
+        return;
+    }
+
+    XHPROF_G(sampler) = NULL;
+
+    pthread_mutex_lock(&sampler->mutex);
+    sampler->running = 0;
+    pthread_cond_signal(&sampler->cond);
+    pthread_mutex_unlock(&sampler->mutex);
+
+    pthread_join(sampler->thread, NULL);
+
+    pthread_cond_destroy(&sampler->cond);
+    pthread_mutex_destroy(&sampler->mutex);
+    free(sampler);
+}
+#endif
+
+
+/**
+ * ***********************
+ * High precision timer related functions.
+ * ***********************
+ */
+
+static inline zend_ulong cycle_timer()
+{
+#if defined(__APPLE__) && defined(__MACH__)
+    return mach_absolute_time() / XHPROF_G(timebase_conversion);
+#elif defined(ZEND_WIN32)
+    LARGE_INTEGER lt = {0};
+    QueryPerformanceCounter(&lt);
+    lt.QuadPart *= 1000000;
+    lt.QuadPart /= performance_frequency.QuadPart;
+    return lt.QuadPart;
+#else
+    struct timespec s;
+
+#ifdef XHPROF_TSC
+    if (XHPROF_G(tsc_us_per_tick) > 0) {
+        return (zend_ulong)(__rdtsc() * XHPROF_G(tsc_us_per_tick));
+    }
+#endif
+
+    clock_gettime(CLOCK_MONOTONIC, &s);
+
+    return s.tv_sec * 1000 * 1000 + s.tv_nsec / 1000;
+#endif
+}
+
+#ifdef XHPROF_PERF_CPU_TIME
+/**
+ * Returns the running time of the task clock in microsecs, which is the
+ * CPU time of the thread. The page is updated by the kernel when the thread
+ * is scheduled. The time since then is computed from the TSC.
+ */
+static inline zend_ulong hp_perf_cpu_timer(volatile struct perf_event_mmap_page *page)
+{
+    uint32_t seq;
+    uint64_t running, cyc, quot, rem;
+
+    do {
+        seq = page->lock;
+        __asm__ __volatile__("" ::: "memory");
+
+        cyc  = __rdtsc();
+        quot = cyc >> page->time_shift;
+        rem  = cyc & (((uint64_t)1 << page->time_shift) - 1);
+
+        running = page->time_running + page->time_offset
+            + quot * page->time_mult + ((rem * page->time_mult) >> page->time_shift);
+
+        __asm__ __volatile__("" ::: "memory");
+    } while (page->lock != seq);
+
+    return running / 1000;
+}
+
+static zend_ulong hp_thread_cpu_timer()
+{
+    struct timespec s;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &s);
+
+    return s.tv_sec * 1000 * 1000 + s.tv_nsec / 1000;
+}
+
+/**
+ * Opens and maps the task clock of the thread. It is used only if the kernel
+ * lets user space read its time, and if it agrees with the thread CPU clock.
+ */
+static void hp_perf_cpu_open()
+{
+    struct perf_event_attr attr;
+    struct perf_event_mmap_page *page;
+    zend_ulong perf_start, perf_end, cpu_start, cpu_end;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_SW_TASK_CLOCK;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    page = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+
+    if (page->cap_user_time) {
+        /* spin for 200us of CPU time on both clocks */
+        perf_start = hp_perf_cpu_timer(page);
+        cpu_start  = hp_thread_cpu_timer();
+
+        do {
+            cpu_end = hp_thread_cpu_timer();
+        } while (cpu_end - cpu_start < 200);
+
+        perf_end = hp_perf_cpu_timer(page);
+
+        if (perf_end - perf_start > (cpu_end - cpu_start) / 2 && perf_end - perf_start < (cpu_end - cpu_start) * 2) {
+            XHPROF_G(perf_cpu_fd)   = fd;
+            XHPROF_G(perf_cpu_page) = page;
+            return;
+        }
+    }
+
+    munmap(page, sysconf(_SC_PAGESIZE));
+    close(fd);
+}
+
+static void hp_perf_cpu_close()
+{
+    if (XHPROF_G(perf_cpu_page)) {
+        munmap(XHPROF_G(perf_cpu_page), sysconf(_SC_PAGESIZE));
+        close(XHPROF_G(perf_cpu_fd));
+
+        XHPROF_G(perf_cpu_page) = NULL;
+        XHPROF_G(perf_cpu_fd)   = -1;
+    }
+}
+#endif
+
+/**
+ * Sets up the timers of a profiling session.
+ *
+ * The TSC is calibrated once per process, against the monotonic clock over
+ * the time since module init, waiting for that time to be at least 1ms.
+ * Every session then uses the same calibration, so its wall times do not
+ * depend on when another thread calibrated.
+ */
+static void hp_init_timers()
+{
+#ifdef XHPROF_TSC
+    if (tsc_us_per_tick == 0) {
+        struct timespec now;
+        uint64_t tsc, elapsed_ns;
+
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            tsc = __rdtsc();
+
+            elapsed_ns = (now.tv_sec - tsc_calibration_start_time.tv_sec) * 1000000000ULL
+                + now.tv_nsec - tsc_calibration_start_time.tv_nsec;
+        } while (elapsed_ns < 1000000);
+
+        tsc_us_per_tick = (elapsed_ns / 1000.0) / (double)(tsc - tsc_calibration_start);
+    }
+
+    XHPROF_G(tsc_us_per_tick) = tsc_us_per_tick > 0 ? tsc_us_per_tick : 0;
+#endif
+
+#ifdef XHPROF_PERF_CPU_TIME
+    if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_CPU) {
+        hp_perf_cpu_open();
+    }
+#endif
+}
+
+/**
+ * Get the current real CPU clock timer
+ */
+static zend_ulong cpu_timer()
+{
+#ifdef XHPROF_PERF_CPU_TIME
+    if (XHPROF_G(perf_cpu_page)) {
+        return hp_perf_cpu_timer(XHPROF_G(perf_cpu_page));
+    }
+
+    return hp_thread_cpu_timer();
+#elif defined(CLOCK_PROCESS_CPUTIME_ID)
+    struct timespec s;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &s);
+
+    return s.tv_sec * 1000 * 1000 + s.tv_nsec / 1000;
+#else
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    return (ru.ru_utime.tv_sec  + ru.ru_stime.tv_sec ) * 1000 * 1000 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+#endif
+}
+
+/**
+ * Incr time with the given microseconds.
+ */
+static void incr_us_interval(struct timeval *start, zend_ulong incr)
+{
+    incr += (start->tv_sec * 1000000 + start->tv_usec);
+    start->tv_sec  = incr / 1000000;
+    start->tv_usec = incr % 1000000;
+}
+
+/**
+ * ***************************
+ * XHPROF DUMMY CALLBACKS
+ * ***************************
+ */
+void hp_mode_dummy_init_cb()
+{
+
+}
+
+void hp_mode_dummy_exit_cb()
+{
+
+}
+
+void hp_mode_dummy_beginfn_cb(hp_entry_t **entries, hp_entry_t *current)
+{
+
+}
+
+void hp_mode_dummy_endfn_cb(hp_entry_t **entries)
+{
+
+}
+
+
+/**
+ * ****************************
+ * XHPROF COMMON CALLBACKS
+ * ****************************
+ */
+/**
+ * XHPROF universal begin function.
+ * This function is called for all modes before the
+ * mode's specific begin_function callback is called.
+ *
+ * @param  hp_entry_t **entries  linked list (stack)
+ *                                  of hprof entries
+ * @param  hp_entry_t  *current  hprof entry for the current fn
+ * @return void
+ * @author kannan, veeve
+ */
+void hp_mode_common_beginfn(hp_entry_t **entries, hp_entry_t *current)
+{
+    hp_entry_t *p;
+
+    /* This symbol's recursive level */
+    int recurse_level = 0;
+
+    if (XHPROF_G(func_hash_counters[current->hash_code]) > 0) {
+        /* Find this symbols recurse level */
+        for (p = (*entries); p; p = p->prev_hprof) {
+            if (zend_string_equals(current->name_hprof, p->name_hprof)) {
+                recurse_level = (p->rlvl_hprof) + 1;
+                break;
+            }
+        }
+    }
+
+    XHPROF_G(func_hash_counters[current->hash_code])++;
+
+    /* Init current function's recurse level */
+    current->rlvl_hprof = recurse_level;
+}
+
+/**
+ * *********************************
+ * XHPROF INIT MODULE CALLBACKS
+ * *********************************
+ */
+/**
+ * XHPROF_MODE_SAMPLED's init callback
+ *
+ * @author veeve
+ */
+void hp_mode_sampled_init_cb()
+{
+    /* Init the last_sample in tsc */
+    XHPROF_G(last_sample_tsc) = cycle_timer();
+
+    /* Find the microseconds that need to be truncated */
+    gettimeofday(&XHPROF_G(last_sample_time), 0);
+    hp_trunc_time(&XHPROF_G(last_sample_time), XHPROF_G(sampling_interval));
 
     /* Convert sampling interval to ticks */
     XHPROF_G(sampling_interval_tsc) = XHPROF_G(sampling_interval);
+
+#ifdef XHPROF_SAMPLING_THREAD
+    hp_sampler_start();
+#endif
 }
 
 
@@ -1011,6 +2195,9 @@ void hp_mode_sampled_init_cb()
  */
 void hp_mode_hier_beginfn_cb(hp_entry_t **entries, hp_entry_t  *current)
 {
+    /* Intern the function name, before we start timing it */
+    current->func_id = hp_get_function_id(current);
+
     /* Get start tsc counter */
     current->tsc_start = cycle_timer();
 
@@ -1024,6 +2211,13 @@ void hp_mode_hier_beginfn_cb(hp_entry_t **entries, hp_entry_t  *current)
         current->mu_start_hprof  = zend_memory_usage(0);
         current->pmu_start_hprof = zend_memory_peak_usage(0);
     }
+
+    /* Get allocation counts */
+    if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY_ALLOC) {
+        current->alloc_count_start = XHPROF_G(alloc_count);
+        current->free_count_start  = XHPROF_G(free_count);
+        current->alloc_bytes_start = XHPROF_G(alloc_bytes);
+    }
 }
 
 
@@ -1053,8 +2247,7 @@ void hp_mode_sampled_beginfn_cb(hp_entry_t **entries, hp_entry_t *current)
 void hp_mode_hier_endfn_cb(hp_entry_t **entries)
 {
     hp_entry_t      *top = (*entries);
-    zval            *counts;
-    char            symbol[SCRATCH_BUF_LEN];
+    hp_edge_t       *edge;
     long int        mu_end;
     long int        pmu_end;
     double          wt, cpu;
@@ -1062,26 +2255,18 @@ void hp_mode_hier_endfn_cb(hp_entry_t **entries)
     /* Get end tsc counter */
     wt = cycle_timer() - top->tsc_start;
 
-    /* Get the stat array */
-    hp_get_function_stack(top, 2, symbol, sizeof(symbol));
-
-    counts = zend_hash_str_find(Z_ARRVAL(XHPROF_G(stats_count)), symbol, strlen(symbol));
-
-    if (counts == NULL) {
-        zval count_val;
-        array_init(&count_val);
-        counts = zend_hash_str_update(Z_ARRVAL(XHPROF_G(stats_count)), symbol, strlen(symbol), &count_val);
-    }
+    /* Get the parent==>child counters */
+    edge = hp_get_edge(&XHPROF_G(edges), top->prev_hprof ? top->prev_hprof->func_id : 0, top->func_id);
 
-    /* Bump stats in the counts hashtable */
-    hp_inc_count(counts, "ct", 1);
-    hp_inc_count(counts, "wt", wt);
+    /* Bump stats in the counters */
+    edge->ct++;
+    edge->wt += (zend_long)wt;
 
     if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_CPU) {
         cpu = cpu_timer() - top->cpu_start;
 
-        /* Bump CPU stats in the counts hashtable */
-        hp_inc_count(counts, "cpu", cpu);
+        /* Bump CPU stats in the counters */
+        edge->cpu += (zend_long)cpu;
     }
 
     if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY) {
@@ -1089,11 +2274,20 @@ void hp_mode_hier_endfn_cb(hp_entry_t **entries)
         mu_end  = zend_memory_usage(0);
         pmu_end = zend_memory_peak_usage(0);
 
-        /* Bump Memory stats in the counts hashtable */
-        hp_inc_count(counts, "mu",  mu_end - top->mu_start_hprof);
-        hp_inc_count(counts, "pmu", pmu_end - top->pmu_start_hprof);
+        /* Bump Memory stats in the counters */
+        edge->mu  += mu_end - top->mu_start_hprof;
+        edge->pmu += pmu_end - top->pmu_start_hprof;
     }
 
+    if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY_ALLOC) {
+        /* Bump allocation stats in the counters */
+        edge->na += XHPROF_G(alloc_count) - top->alloc_count_start;
+        edge->nf += XHPROF_G(free_count)  - top->free_count_start;
+        edge->aa += XHPROF_G(alloc_bytes) - top->alloc_bytes_start;
+    }
+
+    edge->swt += (zend_long)top->swt;
+
     XHPROF_G(func_hash_counters[top->hash_code])--;
 }
 
@@ -1125,7 +2319,7 @@ void hp_mode_sampled_endfn_cb(hp_entry_t **entries)
 
 ZEND_DLEXPORT void hp_execute_ex (zend_execute_data *execute_data)
 {
-    if (!XHPROF_G(enabled)) {
+    if (!XHPROF_G(profile_calls)) {
         _zend_execute_ex(execute_data);
         return;
     }
@@ -1133,6 +2327,21 @@ ZEND_DLEXPORT void hp_execute_ex (zend_execute_data *execute_data)
     zend_string *func;
     int hp_profile_flag = 1;
 
+    /* A resumed coroutine continues a call its yield returned from, swoole
+     * runs it again in place of the discarded C frame. */
+    if (XHPROF_G(entries) && XHPROF_G(entries)->frame == execute_data) {
+        func = XHPROF_G(entries)->name_hprof;
+
+        _zend_execute_ex(execute_data);
+
+        if (XHPROF_G(entries)) {
+            END_PROFILING(&XHPROF_G(entries), hp_profile_flag);
+        }
+
+        zend_string_release(func);
+        return;
+    }
+
     func = hp_get_function_name(execute_data);
 
     if (!func) {
@@ -1144,6 +2353,10 @@ ZEND_DLEXPORT void hp_execute_ex (zend_execute_data *execute_data)
 
     BEGIN_PROFILING(&XHPROF_G(entries), func, hp_profile_flag, real_execute_data);
 
+    if (hp_profile_flag) {
+        XHPROF_G(entries)->frame = execute_data;
+    }
+
     _zend_execute_ex(execute_data);
 
     if (XHPROF_G(entries)) {
@@ -1162,7 +2375,7 @@ ZEND_DLEXPORT void hp_execute_ex (zend_execute_data *execute_data)
 
 ZEND_DLEXPORT void hp_execute_internal(zend_execute_data *execute_data, zval *return_value)
 {
-    if (!XHPROF_G(enabled) || (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_NO_BUILTINS)) {
+    if (!XHPROF_G(profile_calls) || (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_NO_BUILTINS)) {
         execute_internal(execute_data, return_value);
         return;
     }
@@ -1174,6 +2387,10 @@ ZEND_DLEXPORT void hp_execute_internal(zend_execute_data *execute_data, zval *re
 
     if (func) {
         BEGIN_PROFILING(&XHPROF_G(entries), func, hp_profile_flag, execute_data);
+
+        if (hp_profile_flag) {
+            XHPROF_G(entries)->frame = execute_data;
+        }
     }
 
     if (!_zend_execute_internal) {
@@ -1193,6 +2410,30 @@ ZEND_DLEXPORT void hp_execute_internal(zend_execute_data *execute_data, zval *re
 
 }
 
+#ifdef XHPROF_SAMPLING_THREAD
+/**
+ * Proxy for zend_interrupt_function(). Takes the samples the sampling thread
+ * asked for, at a point where the VM frames are consistent.
+ */
+ZEND_DLEXPORT void hp_interrupt_function(zend_execute_data *execute_data)
+{
+    hp_sampler_t *sampler = XHPROF_G(sampler);
+
+    if (sampler && sampler->pending) {
+        sampler->pending = 0;
+
+        /* A long running builtin may have passed several sampling intervals */
+        while (hp_sample_due()) {
+            hp_sample_frames(execute_data);
+        }
+    }
+
+    if (_zend_interrupt_function) {
+        _zend_interrupt_function(execute_data);
+    }
+}
+#endif
+
 /**
  * Proxy for zend_compile_file(). Used to profile PHP compilation time.
  *
@@ -1200,7 +2441,7 @@ ZEND_DLEXPORT void hp_execute_internal(zend_execute_data *execute_data, zval *re
  */
 ZEND_DLEXPORT zend_op_array* hp_compile_file(zend_file_handle *file_handle, int type)
 {
-    if (!XHPROF_G(enabled)) {
+    if (!XHPROF_G(profile_calls)) {
         return _zend_compile_file(file_handle, type);
     }
 
@@ -1228,7 +2469,7 @@ ZEND_DLEXPORT zend_op_array* hp_compile_file(zend_file_handle *file_handle, int
  */
 ZEND_DLEXPORT zend_op_array* hp_compile_string(zval *source_string, char *filename)
 {
-    if (!XHPROF_G(enabled)) {
+    if (!XHPROF_G(profile_calls)) {
         return _zend_compile_string(source_string, filename);
     }
 
@@ -1249,6 +2490,281 @@ ZEND_DLEXPORT zend_op_array* hp_compile_string(zval *source_string, char *filena
     return ret;
 }
 
+/**
+ * ****************************
+ * SWOOLE COROUTINES
+ * ****************************
+ */
+
+/* Set once the hooks are registered with swoole, for the whole process */
+static int hp_coroutine_hooks = 0;
+
+/**
+ * Gives the chunks of the stack of an ended coroutine to the spare chunks.
+ */
+static void hp_coroutine_free_chunks(hp_entry_chunk_t *chunk)
+{
+    hp_entry_chunk_t *next;
+
+    if (!chunk) {
+        return;
+    }
+
+    while (chunk->prev) {
+        chunk = chunk->prev;
+    }
+
+    while (chunk) {
+        next = chunk->next;
+        chunk->next = XHPROF_G(entry_chunk_spare);
+        XHPROF_G(entry_chunk_spare) = chunk;
+        chunk = next;
+    }
+}
+
+static void hp_coroutine_free(zval *val)
+{
+    hp_coroutine_t *coroutine = Z_PTR_P(val);
+
+    hp_coroutine_free_chunks(coroutine->entry_chunk);
+    efree(coroutine);
+}
+
+/**
+ * Saves the running profile stack and continues with the given one. What the
+ * other stacks used meanwhile is taken off its calls: CPU time, memory and
+ * allocations. The wall time is kept, and also counted as suspended.
+ */
+static void hp_coroutine_switch(hp_coroutine_t *to)
+{
+    hp_coroutine_t *from = XHPROF_G(coroutine);
+    hp_entry_t     *entry;
+    zend_ulong      wt, cpu = 0;
+    long int        mu = 0;
+
+    wt = cycle_timer();
+
+    if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_CPU) {
+        cpu = cpu_timer();
+    }
+
+    if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY) {
+        mu = zend_memory_usage(0);
+    }
+
+    from->entries             = XHPROF_G(entries);
+    from->entry_chunk         = XHPROF_G(entry_chunk);
+    from->suspend_wt          = wt;
+    from->suspend_cpu         = cpu;
+    from->suspend_mu          = mu;
+    from->suspend_alloc_count = XHPROF_G(alloc_count);
+    from->suspend_free_count  = XHPROF_G(free_count);
+    from->suspend_alloc_bytes = XHPROF_G(alloc_bytes);
+
+    for (entry = to->entries; entry; entry = entry->prev_hprof) {
+        entry->swt               += wt - to->suspend_wt;
+        entry->cpu_start         += cpu - to->suspend_cpu;
+        entry->mu_start_hprof    += mu - to->suspend_mu;
+        entry->alloc_count_start += XHPROF_G(alloc_count) - to->suspend_alloc_count;
+        entry->free_count_start  += XHPROF_G(free_count) - to->suspend_free_count;
+        entry->alloc_bytes_start += XHPROF_G(alloc_bytes) - to->suspend_alloc_bytes;
+    }
+
+    XHPROF_G(entries)     = to->entries;
+    XHPROF_G(entry_chunk) = to->entry_chunk;
+    XHPROF_G(coroutine)   = to;
+}
+
+/**
+ * Ends the call on top of the running stack, for a proxy which does not
+ * return to it: the yield discarded its C frame. Releases the name for it.
+ */
+static void hp_coroutine_end_call()
+{
+    int          hp_profile_flag = 1;
+    zend_string *func = XHPROF_G(entries)->name_hprof;
+
+    END_PROFILING(&XHPROF_G(entries), hp_profile_flag);
+
+    zend_string_release(func);
+}
+
+/**
+ * Continues with the stack of a coroutine which is created or resumed.
+ */
+static void hp_coroutine_enter(zend_long cid, int resumed)
+{
+    hp_coroutine_t *coroutine;
+
+    if (!XHPROF_G(coroutines)) {
+        return;
+    }
+
+    coroutine = zend_hash_index_find_ptr(XHPROF_G(coroutines), cid);
+
+    if (!coroutine) {
+        coroutine = ecalloc(1, sizeof(hp_coroutine_t));
+        coroutine->cid = cid;
+        zend_hash_index_add_new_ptr(XHPROF_G(coroutines), cid, coroutine);
+    }
+
+    if (coroutine == XHPROF_G(coroutine)) {
+        return;
+    }
+
+    coroutine->prev = XHPROF_G(coroutine);
+    hp_coroutine_switch(coroutine);
+
+    /* It yielded from an internal function, swoole finishes that call and
+     * the PHP code continues, see hp_execute_ex(). */
+    if (resumed) {
+        while (XHPROF_G(entries) && XHPROF_G(entries)->frame && XHPROF_G(entries)->frame->func->type == ZEND_INTERNAL_FUNCTION) {
+            hp_coroutine_end_call();
+        }
+    }
+}
+
+/**
+ * Goes back to the stack a coroutine was entered from, when it yields or
+ * ends. The calls of an ended coroutine have returned, except the ones whose
+ * C frame a yield discarded.
+ */
+static void hp_coroutine_leave(zend_long cid, int closed)
+{
+    hp_coroutine_t *coroutine;
+
+    if (!XHPROF_G(coroutines)) {
+        return;
+    }
+
+    coroutine = XHPROF_G(coroutine);
+
+    /* entered before the profiling started */
+    if (coroutine->cid != cid || !coroutine->prev) {
+        return;
+    }
+
+    if (closed) {
+        while (XHPROF_G(entries)) {
+            hp_coroutine_end_call();
+        }
+    }
+
+    hp_coroutine_switch(coroutine->prev);
+
+    if (closed) {
+        zend_hash_index_del(XHPROF_G(coroutines), cid);
+    }
+}
+
+static void hp_coroutine_create_hook(void *data)
+{
+    hp_coroutine_enter(*(int *)data, 0);
+}
+
+static void hp_coroutine_resume_hook(void *data)
+{
+    hp_coroutine_enter(*(int *)data, 1);
+}
+
+static void hp_coroutine_yield_hook(void *data)
+{
+    hp_coroutine_leave(*(int *)data, 0);
+}
+
+static void hp_coroutine_close_hook(void *data)
+{
+    hp_coroutine_leave(*(int *)data, 1);
+}
+
+/**
+ * Registers the coroutine hooks with swoole, when it is loaded. It starts
+ * before xhprof, see xhprof_deps. Only a shared swoole of the version the
+ * hook types are known for is used.
+ */
+static void hp_coroutine_hooks_init()
+{
+    zend_module_entry *module;
+    int (*add_hook)(int type, void (*func)(void *data), int push_back);
+
+    module = zend_hash_str_find_ptr(&module_registry, "swoole", sizeof("swoole") - 1);
+
+    if (!module || !module->handle || !module->version || strcmp(module->version, XHPROF_SWOOLE_VERSION) != 0) {
+        return;
+    }
+
+    add_hook = (int (*)(int, void (*)(void *), int))DL_FETCH_SYMBOL(module->handle, "swoole_add_hook");
+
+    if (!add_hook) {
+        return;
+    }
+
+    add_hook(XHPROF_SWOOLE_HOOK_CORO_CREATE, hp_coroutine_create_hook, 1);
+    add_hook(XHPROF_SWOOLE_HOOK_CORO_RESUME, hp_coroutine_resume_hook, 1);
+    add_hook(XHPROF_SWOOLE_HOOK_CORO_YIELD, hp_coroutine_yield_hook, 1);
+    add_hook(XHPROF_SWOOLE_HOOK_CORO_CLOSE, hp_coroutine_close_hook, 1);
+
+    hp_coroutine_hooks = 1;
+}
+
+/**
+ * Keeps a profile stack per coroutine, when swoole calls the hooks. The
+ * running stack is the one of the request.
+ */
+static void hp_coroutines_start()
+{
+    XHPROF_G(coroutine_stats) = hp_coroutine_hooks;
+
+    if (!hp_coroutine_hooks) {
+        return;
+    }
+
+    ALLOC_HASHTABLE(XHPROF_G(coroutines));
+    zend_hash_init(XHPROF_G(coroutines), 8, NULL, hp_coroutine_free, 0);
+
+    memset(&XHPROF_G(request_coroutine), 0, sizeof(hp_coroutine_t));
+    XHPROF_G(request_coroutine).cid = -1;
+    XHPROF_G(coroutine) = &XHPROF_G(request_coroutine);
+}
+
+/**
+ * Ends the calls of the coroutines and goes back to the stack of the
+ * request, for hp_stop(). The C frames of the calls of the suspended
+ * coroutines are gone, those of the stacks the running one was entered from
+ * are not and end their calls themselves.
+ */
+static void hp_coroutines_stop()
+{
+    hp_coroutine_t *coroutine, *entered;
+    hp_coroutine_t *running = XHPROF_G(coroutine);
+    int             hp_profile_flag = 1;
+
+    if (!XHPROF_G(coroutines)) {
+        return;
+    }
+
+    ZEND_HASH_FOREACH_PTR(XHPROF_G(coroutines), coroutine) {
+        for (entered = running; entered && entered != coroutine; entered = entered->prev);
+
+        hp_coroutine_switch(coroutine);
+
+        while (XHPROF_G(entries)) {
+            if (entered) {
+                END_PROFILING(&XHPROF_G(entries), hp_profile_flag);
+            } else {
+                hp_coroutine_end_call();
+            }
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    hp_coroutine_switch(&XHPROF_G(request_coroutine));
+
+    zend_hash_destroy(XHPROF_G(coroutines));
+    FREE_HASHTABLE(XHPROF_G(coroutines));
+    XHPROF_G(coroutines) = NULL;
+    XHPROF_G(coroutine)  = NULL;
+}
+
 /**
  * **************************
  * MAIN XHPROF CALLBACKS
@@ -1265,8 +2781,18 @@ static void hp_begin(zend_long level, zend_long xhprof_flags)
     if (!XHPROF_G(enabled)) {
         int hp_profile_flag = 1;
 
-        XHPROF_G(enabled)      = 1;
-        XHPROF_G(xhprof_flags) = (uint32)xhprof_flags;
+        XHPROF_G(enabled)       = 1;
+        XHPROF_G(profile_calls) = 1;
+        XHPROF_G(xhprof_flags)  = (uint32)xhprof_flags;
+
+#if PHP_VERSION_ID < 70300
+        /* Before PHP 7.3, NULL handlers do not turn the custom heap off, so
+         * the allocation handlers could not be removed again */
+        if (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY_ALLOC) {
+            php_error_docref(NULL, E_WARNING, "XHPROF_FLAGS_MEMORY_ALLOC needs PHP 7.3 or later");
+            XHPROF_G(xhprof_flags) &= ~XHPROF_FLAGS_MEMORY_ALLOC;
+        }
+#endif
 
         /* Initialize with the dummy mode first Having these dummy callbacks saves
          * us from checking if any of the callbacks are NULL everywhere. */
@@ -1284,19 +2810,39 @@ static void hp_begin(zend_long level, zend_long xhprof_flags)
                 break;
             case XHPROF_MODE_SAMPLED:
                 XHPROF_G(mode_cb).init_cb     = hp_mode_sampled_init_cb;
+#ifdef XHPROF_SAMPLING_THREAD
+                /* the sampling thread drives the samples, calls are not hooked */
+                XHPROF_G(profile_calls) = 0;
+#else
                 XHPROF_G(mode_cb).begin_fn_cb = hp_mode_sampled_beginfn_cb;
                 XHPROF_G(mode_cb).end_fn_cb   = hp_mode_sampled_endfn_cb;
+#endif
                 break;
         }
 
+        /* the mode callbacks read the timers */
+        hp_init_timers();
+
         /* one time initializations */
         hp_init_profiler_state(level);
 
+        if (level == XHPROF_MODE_HIERARCHICAL && (XHPROF_G(xhprof_flags) & XHPROF_FLAGS_MEMORY_ALLOC)) {
+            hp_alloc_tracking_start();
+        }
+
+        if (level == XHPROF_MODE_HIERARCHICAL) {
+            hp_coroutines_start();
+        } else {
+            XHPROF_G(coroutine_stats) = 0;
+        }
+
         /* start profiling from fictitious main() */
         XHPROF_G(root) = zend_string_init(ROOT_SYMBOL, sizeof(ROOT_SYMBOL) - 1, 0);
 
         /* start profiling from fictitious main() */
-        BEGIN_PROFILING(&XHPROF_G(entries), XHPROF_G(root), hp_profile_flag, NULL);
+        if (XHPROF_G(profile_calls)) {
+            BEGIN_PROFILING(&XHPROF_G(entries), XHPROF_G(root), hp_profile_flag, NULL);
+        }
     }
 }
 
@@ -1327,17 +2873,31 @@ static void hp_stop()
 {
     int hp_profile_flag = 1;
 
+#ifdef XHPROF_SAMPLING_THREAD
+    hp_sampler_stop();
+#endif
+
+    /* End the calls of the coroutines, back to the stack of the request */
+    hp_coroutines_stop();
+
     /* End any unfinished calls */
     while (XHPROF_G(entries)) {
         END_PROFILING(&XHPROF_G(entries), hp_profile_flag);
     }
 
+#ifdef XHPROF_PERF_CPU_TIME
+    hp_perf_cpu_close();
+#endif
+
+    hp_alloc_tracking_stop();
+
     if (XHPROF_G(root)) {
         zend_string_release(XHPROF_G(root));
     }
 
     /* Stop profiling */
-    XHPROF_G(enabled) = 0;
+    XHPROF_G(enabled)       = 0;
+    XHPROF_G(profile_calls) = 0;
 }
 
 